@@ -0,0 +1,47 @@
+// A Turing-machine style sequencer in loop(), with audio at a fixed 48kHz on core 1.
+// Copy ComputerCard.h and ComputerCardArduino.h from PicoSDK/ComputerCard into this folder.
+//
+// Pulse in 1:  clock
+// Main knob:   chance of flipping each bit of the sequence
+// Knob X:      level of audio in 1 to audio out 1
+// CV out 1:    sequence, as a MIDI note (C3 to C5)
+// Pulse out 1: the sequence's top bit, at each clock
+
+#include "ComputerCardArduino.h"
+
+ArduinoCard card;
+
+uint16_t shiftRegister = 0xACE1;
+uint32_t clocks = 0;
+
+// Every sample, on core 1
+void process(ArduinoCard &c) {
+  int32_t level = c.KnobVal(ArduinoCard::X);
+  c.AudioOut1((c.AudioIn1() * level) >> 12);
+  c.LedBrightness(1, uint16_t(abs(c.AudioIn1()) * 2));
+}
+
+void setup() {
+  card.EnableNormalisationProbe();
+  card.SetCallback(process);
+  card.Start();
+}
+
+void setup1() {
+  card.Run();
+}
+
+void loop() {
+  // Every clock since the last pass, none missed however long loop() takes
+  uint32_t n = card.PulseInCount(0);
+  while (clocks != n) {
+    clocks++;
+    bool bit = shiftRegister >> 15;
+    if (int32_t(random(4096)) < card.LatestKnob(ArduinoCard::Main)) bit = !bit;
+    shiftRegister = (shiftRegister << 1) | bit;
+
+    card.HoldCVOutMIDINote(0, 48 + (shiftRegister & 0xFF) * 24 / 255);
+    card.HoldPulseOut(0, bit);
+    card.HoldLed(4, bit ? 4095 : 0);
+  }
+}
@@ -1,7 +1,7 @@
 /*
 ComputerCard  - by Chris Johnson
 
-version 0.2.6  -  2025/07/31
+version 0.3.0  -  unreleased
 
 ComputerCard is a header-only C++ library, providing a class that
 manages the hardware aspects of the Music Thing Modular Workshop
@@ -9,7 +9,7 @@ System Computer.
 
 It aims to present a very simple C++ interface for card programmers 
 to use the jacks, knobs, switch and LEDs, for programs running at
-a fixed 48kHz audio sample rate.
+a fixed audio sample rate of 48kHz (or optionally 24kHz or 96kHz).
 
 See examples/ directory
 */
@@ -18,8 +18,53 @@ See examples/ directory
 #ifndef COMPUTERCARD_H
 #define COMPUTERCARD_H
 
+#include "hardware/dma.h"
+#include "hardware/flash.h"
 #include "hardware/gpio.h"
+#include "hardware/irq.h"
 #include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/structs/xip_ctrl.h"
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+// RunOnCore1 is available if pico_multicore is linked
+#if __has_include("pico/multicore.h")
+#include "pico/multicore.h"
+#define COMPUTERCARD_HAS_MULTICORE 1
+#endif
+
+// Interpolated readers use the SIO interpolators if hardware_interp is linked
+#if __has_include("hardware/interp.h")
+#include "hardware/interp.h"
+#define COMPUTERCARD_HAS_INTERP 1
+#endif
+
+// EnablePulseCapture is available if hardware_pio is linked
+#if __has_include("hardware/pio.h")
+#include "hardware/pio.h"
+#define COMPUTERCARD_HAS_PIO 1
+#endif
+
+// Divider, Slew and ClockTracker use the SIO hardware divider if hardware_divider is linked (RP2040 only)
+#if __has_include("hardware/divider.h") && (!defined(HAS_SIO_DIVIDER) || HAS_SIO_DIVIDER)
+#include "hardware/divider.h"
+#define COMPUTERCARD_HAS_DIVIDER 1
+#endif
+
+// Sequencer is available when compiled as C++20 or later, with coroutines
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define COMPUTERCARD_HAS_COROUTINES 1
+#endif
+
+// RP2350 builds (PICO_PLATFORM=rp2350) run the same code; cards can use its Cortex-M33
+// DSP instructions and FPU through dsp_intrinsics.h, which falls back to plain C on the RP2040
+#if defined(PICO_RP2350) && PICO_RP2350
+#define COMPUTERCARD_RP2350 1
+#endif
 
 #define PULSE_1_RAW_OUT 8
 #define PULSE_2_RAW_OUT 9
@@ -30,6 +75,37 @@ See examples/ directory
 // USB host status pin
 #define USB_HOST_STATUS 20
 
+// Number of audio frames passed to each ProcessBlock call.
+// The default of 1 calls ProcessSample directly from a per-sample interrupt.
+// Larger values (powers of two, e.g. 16, 32, 64) collect this many frames
+// per interrupt, trading latency for lower per-sample overhead.
+// Must be defined identically in every file that includes ComputerCard.h
+#ifndef COMPUTERCARD_BLOCK_SIZE
+#define COMPUTERCARD_BLOCK_SIZE 1
+#endif
+
+// Define COMPUTERCARD_CALIBRATION_CACHE as n to keep a copy of the worked-out CV output
+// calibration in the flash sector n sectors below the top of flash (so 0 is the top sector;
+// it must not be used by anything else). At startup only the EEPROM's CRC is then read, and
+// if it matches the copy's, the copy is used rather than reading and fitting the whole
+// calibration. Otherwise the calibration is read as usual and the copy rewritten, before
+// audio starts.
+
+// Define COMPUTERCARD_TRACE as n (a power of two) to keep the last n events on each core in an
+// SRAM ring, for Trace and TraceWriteJSON. 8 bytes per event; otherwise tracing costs nothing.
+
+// Define COMPUTERCARD_RECORD as n (a power of two, at least 1024) to record the control inputs
+// into an n-byte SRAM ring, for RecordingWrite, and replay with the host backend.
+
+// Define COMPUTERCARD_LINK as n (1 to 4) for EnableAudioLink: n channels of 16-bit audio each way
+// between two Computers over the debug pins.
+
+// Define COMPUTERCARD_SOAK as n to build the card as a soak test: a stress generator drives all
+// its inputs in place of the hardware, the load meter counts calls by length, and every ten
+// seconds the results are saved to the two flash sectors n sectors below the top of flash (which
+// must not be used by anything else), to be shown on the LEDs at the next boot and read with
+// SoakReportWrite. The audio core must run from SRAM, as for FlashStore.
+
 class ComputerCard
 {
 	constexpr static int numLeds = 6;
@@ -46,587 +122,7493 @@ public:
 	enum HardwareVersion_t {Proto1=0x2a, Proto2_Rev1=0x30, Rev1_1=0x0C, Unknown=0xFF};
 	/// USB Power state
 	enum USBPowerState_t {DFP, UFP, Unsupported};
+	/// Audio sample rate, used by Run
+	enum SampleRate_t {SR24kHz = 24000, SR48kHz = 48000, SR96kHz = 96000};
 
-	ComputerCard();
+	/// Number of frames per ProcessBlock call, set by COMPUTERCARD_BLOCK_SIZE
+	constexpr static int blockSize = COMPUTERCARD_BLOCK_SIZE;
+	static_assert(blockSize > 0 && (blockSize & (blockSize - 1)) == 0 && blockSize <= 256,
+				  "COMPUTERCARD_BLOCK_SIZE must be a power of two, at most 256");
 
-	/** \brief Start audio processing.
+	/// Statistics collected by the load meter, see EnableLoadMeter
+	struct LoadStats
+	{
+		uint32_t minCycles;    ///< Shortest ProcessSample/ProcessBlock call, in CPU cycles
+		uint32_t avgCycles;    ///< Average (exponentially-weighted) call length, in CPU cycles
+		uint32_t maxCycles;    ///< Longest call, in CPU cycles
+		uint32_t budgetCycles; ///< CPU cycles available per call (one sample, or one block)
+		uint32_t overruns;     ///< Number of calls that did not finish before the next sample/block was ready
+	};
+
+	/// State of the sample clock sync, see EnableSyncFollow
+	struct SyncStats
+	{
+		bool locked;           ///< The last 16 edges were all within 1/8 sample of their expected time
+		int32_t phaseError;    ///< Last edge's time from the expected, in 1/65536ths of a sample (positive: this card was ahead)
+		int32_t trimPPM;       ///< Sample rate trim, in parts per million (positive: slowed down)
+		uint32_t realigns;     ///< Times SyncFrame has been reset to the leader's count
+	};
+
+	/// State of the audio link, see EnableAudioLink
+	struct LinkStats
+	{
+		bool connected;        ///< Frames are arriving, and LinkIn is playing them
+		uint32_t frames;       ///< Frames received intact
+		uint32_t errors;       ///< Frames lost or corrupted on the way, or not sent in time
+		uint32_t slips;        ///< Frames dropped or missed to keep the latency, as the two sample clocks drift
+		int32_t queued;        ///< Frames waiting behind the one LinkIn is playing, normally the latency
+	};
+
+	/// Result of a latency measurement, see MeasureLatency
+	struct LatencyStats
+	{
+		bool done;             ///< The measurement has finished
+		bool found;            ///< Every step came back on the input
+		bool inverted;         ///< The steps came back inverted
+		int32_t samplesQ8;     ///< Latency, averaged over the steps, in 1/256ths of a sample
+		int32_t spreadQ8;      ///< Largest less smallest latency of the steps, in 1/256ths of a sample
+		uint32_t us;           ///< Latency, in microseconds
+	};
+
+	/// One frame of audio, used by ProcessBlock. audio[0] is Audio 1, audio[1] is Audio 2 (-2048 to 2047)
+	struct alignas(4) Frame
+	{
+		int16_t audio[2];
+	};
 
-        The Run method starts audio processing, calling ProcessSample using an interrupt.
-        Run is a blocking function (it never returns)
-	*/
-	void Run()
+	/// Copy of the inputs for one sample (or block), read by the input functions of ComputerCardT cards
+	struct Inputs
 	{
-		ComputerCard::thisptr = this;
-		AudioWorker();
-	}
+		int32_t knobs[4];
+		int16_t audio[2];
+		int16_t cv[2], cvFast[2];
+		bool pulse[2], lastPulse[2];
+		bool connected[6];
+		Switch switchVal, lastSwitchVal;
+	};
+
+	/// One MIDI message (not sysex), as queued by QueueMIDI and passed to ProcessMIDI
+	struct MIDIEvent
+	{
+		uint32_t sample;  ///< SampleCounter() value of the frame during which the message arrived
+		uint8_t cable;    ///< USB-MIDI cable number
+		uint8_t length;   ///< Number of bytes in data, 1 to 3
+		uint8_t data[3];  ///< Status byte, then data bytes
+	};
 
-	/// Use before Run() to enable Connected/Disconnected detection
-	void EnableNormalisationProbe() {useNormProbe = true;}
-	
-	static ComputerCard *ThisPtr() {return thisptr;}
+	/** \brief Parameter linearly interpolated across one control period, see EnableControlRate
 
-protected:
-	/// Callback, called once per sample at 48kHz
-	virtual void ProcessSample() = 0;
+		Call Set() from ProcessControl with a new target (-32767 to 32767),
+		and Next() once per sample from ProcessSample/ProcessBlock to read
+		a value that ramps to the target by the next ProcessControl call.
+	*/
+	class Smoothed
+	{
+	public:
+		Smoothed(int32_t initial = 0) : value(initial << 16), step(0), remaining(0), target(initial) {}
 
+		/// Set new target value, reached after one control period
+		void Set(int32_t newTarget)
+		{
+			target = newTarget;
+			step = int32_t(((int64_t(newTarget) << 16) - value) >> ComputerCard::controlShift);
+			remaining = 1 << ComputerCard::controlShift;
+		}
 
+		/// Jump immediately to a value, without interpolation
+		void Reset(int32_t newValue)
+		{
+			target = newValue;
+			value = newValue << 16;
+			remaining = 0;
+		}
 
+		/// Advance by one sample and return the interpolated value
+		int32_t __not_in_flash_func(Next)()
+		{
+			if (remaining)
+			{
+				if (--remaining) value += step;
+				else value = target << 16;
+			}
+			return value >> 16;
+		}
 
-	/// Read knob position (returns 0-4095)
-	int32_t __not_in_flash_func(KnobVal)(Knob ind) {return knobs[ind];}
+		/// Return current interpolated value, without advancing
+		int32_t Value() const {return value >> 16;}
 
-	/// Read switch position
-	Switch __not_in_flash_func(SwitchVal)() {return switchVal;}
+		/// Return target value, as given to Set
+		int32_t Target() const {return target;}
 
-	/// Read switch position
-	bool __not_in_flash_func(SwitchChanged)() {return switchVal != lastSwitchVal;}
+	private:
+		int32_t value, step, remaining, target;
+	};
 
+	/** \brief 11-tap half-band lowpass, for resampling by two, as used by EnableSubRate
 
-	/// Set Audio output (values -2048 to 2047)
-	void __not_in_flash_func(AudioOut)(int i, int16_t val)
-	{
-		dacOut[i] = val;
-	}
-	
-	/// Set Audio 1 output (values -2048 to 2047)
-	void __not_in_flash_func(AudioOut1)(int16_t val)
-	{
-		dacOut[0] = val;
-	}
-	
-	/// Set Audio 2 output (values -2048 to 2047)
-	void __not_in_flash_func(AudioOut2)(int16_t val)
+		Decimate takes two samples and returns one at half the rate; Interpolate takes one
+		and returns two at twice the rate. Either way, the filter is flat to within 0.15dB
+		up to 0.15 of the higher rate (7.2kHz at 48kHz), and at least 35dB down from 0.35
+		of it, so cascades of them, one per halving, are clean up to about 0.3 of the
+		lower rate. Half the taps of a half-band filter are zero, and of the rest, all but
+		the centre tap are in one polyphase branch, so each costs three multiplies per
+		sample at the lower rate. Samples are int32_t, of up to 16 bits; the gain is one,
+		and the delay five samples at the higher rate.
+	*/
+	class HalfBand
 	{
-		dacOut[1] = val;
-	}
+	public:
+		HalfBand() {Reset();}
 
-	
-	/// Set CV output (values -2048 to 2047)
-	void __not_in_flash_func(CVOut)(int i, int16_t val)
-	{
-		if (val<-2048) val = -2048;
-		if (val > 2047) val = 2047;
-		cvValue[i] = (2047-val)<<7;
-	}
-	
-	/// Set CV 1 output (values -2048 to 2047)
-	void __not_in_flash_func(CVOut1)(int16_t val)
-	{
-		if (val<-2048) val = -2048;
-		if (val > 2047) val = 2047;
-		cvValue[0] = (2047-val)<<7;
-	}
-	
-	/// Set CV 2 output (values -2048 to 2047)
-	void __not_in_flash_func(CVOut2)(int16_t val)
-	{
-		if (val<-2048) val = -2048;
-		if (val > 2047) val = 2047;
-		cvValue[1] = (2047-val)<<7;
-	}
+		/// Two samples in, oldest first, and one out at half the rate
+		int32_t __not_in_flash_func(Decimate)(int32_t x0, int32_t x1)
+		{
+			for (int i=5; i>0; i--) odd[i] = odd[i-1];
+			odd[0] = x1;
+			int32_t centre = even[1];
+			even[1] = even[0];
+			even[0] = x0;
+			return (Taps(odd) + (centre << 14) + 16384) >> 15;
+		}
 
-		
-	/// Set CV output (values -262144 to 262143)
-	void __not_in_flash_func(CVOutPrecise)(int i, int32_t val)
-	{
-		if (val<-262144) val = -262144;
-		if (val > 262143) val = 262143;
-		cvValue[i] = 262143-val;
-	}
-	
-	/// Set CV 1 output (values -262144 to 262143)
-	void __not_in_flash_func(CVOut1Precise)(int32_t val)
-	{
-		if (val<-262144) val = -262144;
-		if (val > 262143) val = 262143;
-		cvValue[0] = 262143-val;
-	}
-	
-	/// Set CV 2 output (values -262144 to 262143)
-	void __not_in_flash_func(CVOut2Precise)(int32_t val)
-	{
-		if (val<-262144) val = -262144;
-		if (val > 262143) val = 262143;
-		cvValue[1] = 262143-val;
-	}
+		/// One sample in, and two out at twice the rate, oldest first
+		void __not_in_flash_func(Interpolate)(int32_t x, int32_t &y0, int32_t &y1)
+		{
+			for (int i=5; i>0; i--) odd[i] = odd[i-1];
+			odd[0] = x;
+			y0 = (Taps(odd) + 8192) >> 14;
+			y1 = odd[2];
+		}
 
-	/// Set CV 1 output from calibrated MIDI note number (values 0 to 127)
-	void __not_in_flash_func(CVOutMIDINote)(int i, uint8_t noteNum)
-	{
-		cvValue[i] = MIDIToDac(noteNum, i);
-	}
-	
-	/// Set CV 1 output from calibrated MIDI note number (values 0 to 127)
-	void __not_in_flash_func(CVOut1MIDINote)(uint8_t noteNum)
-	{
-		cvValue[0] = MIDIToDac(noteNum, 0);
-	}
-	
-	/// Set CV 2 output from calibrated MIDI note number (values 0 to 127)
-	void __not_in_flash_func(CVOut2MIDINote)(uint8_t noteNum)
-	{
-		cvValue[1] = MIDIToDac(noteNum, 1);
-	}
-	
-	/// Set Pulse output (true = on)
-	void __not_in_flash_func(PulseOut)(int i, bool val)
-	{
-		gpio_put(PULSE_1_RAW_OUT + i, !val);
-	}
-	
-	/// Set Pulse 1 output (true = on)
-	void __not_in_flash_func(PulseOut1)(bool val)
-	{
-		gpio_put(PULSE_1_RAW_OUT, !val);
-	}
-	
-	/// Set Pulse 2 output (true = on)
-	void __not_in_flash_func(PulseOut2)(bool val)
-	{
-		gpio_put(PULSE_2_RAW_OUT, !val);
-	}
-	
-	/// Return audio in (-2048 to 2047)
-	int16_t __not_in_flash_func(AudioIn)(int i){return i?adcInR:adcInL;}
-	
-	/// Return audio in 1 (-2048 to 2047)
-	int16_t __not_in_flash_func(AudioIn1)(){return adcInL;}
+		/// Clear the filter's history
+		void Reset()
+		{
+			for (int i=0; i<6; i++) odd[i] = 0;
+			even[0] = even[1] = 0;
+		}
 
-	/// Return audio in 1 (-2048 to 2047)
-	int16_t __not_in_flash_func(AudioIn2)(){return adcInR;}
+	private:
+		// Non-zero taps either side of the centre (0.5), Q15, summing to a quarter
+		static constexpr int32_t c1 = 9937, c3 = -2173, c5 = 428;
 
-	/// Return CV in (-2048 to 2047)
-	int16_t __not_in_flash_func(CVIn)(int i){return cv[i];}
-	
-	/// Return CV in 1 (-2048 to 2047)
-	int16_t __not_in_flash_func(CVIn1)(){return cv[0];}
+		static int32_t Taps(const int32_t *h) {return c1 * (h[2] + h[3]) + c3 * (h[1] + h[4]) + c5 * (h[0] + h[5]);}
 
-	/// Return CV in 2 (-2048 to 2047)
-	int16_t __not_in_flash_func(CVIn2)(){return cv[1];}
+		int32_t odd[6], even[2];
+	};
 
-	/// Read pulse in
-	bool __not_in_flash_func(PulseIn)(int i){return pulse[i];}
-	/// Return true for one sample on pulse rising edge
-	bool __not_in_flash_func(PulseInRisingEdge)(int i){return pulse[i] && !last_pulse[i];}
-	/// Return true for one sample on pulse falling edge
-	bool __not_in_flash_func(PulseInFallingEdge)(int i){return !pulse[i] && last_pulse[i];}
+	/** \brief Unsigned 32-bit divide, started now and collected later
 
-	/// Read pulse in 1
-	bool __not_in_flash_func(PulseIn1)(){return pulse[0];}
-	/// Return true for one sample on pulse 1 rising edge
-	bool __not_in_flash_func(PulseIn1RisingEdge)(){return pulse[0] && !last_pulse[0];}
-	/// Return true for one sample on pulse 1 falling edge
-	bool __not_in_flash_func(PulseIn1FallingEdge)(){return !pulse[0] && last_pulse[0];}
+		On the RP2040, Start() loads the SIO hardware divider of the calling core and returns
+		immediately; the quotient is ready eight cycles later, so other work can be done before
+		Result() collects it. Divides done in between with the / operator are safe (the SDK's
+		divide routines save and restore an unread result), and if the divider is already busy
+		when Start() is called, the divide is done straight away instead. Start and collect
+		on the same core. If hardware_divider is not linked, the divide is done in software.
+	*/
+	class Divider
+	{
+	public:
+		Divider() : quotient(0), pending(false) {}
 
-	/// Read pulse in 2
-	bool __not_in_flash_func(PulseIn2)(){return pulse[1];}
-	/// Return true for one sample on pulse 2 falling edge
-	bool __not_in_flash_func(PulseIn2FallingEdge)(){return !pulse[1] && last_pulse[1];}
-	/// Return true for one sample on pulse 2 rising edge
-	bool __not_in_flash_func(PulseIn2RisingEdge)(){return pulse[1] && !last_pulse[1];}
+		/// Start calculating num / den (den must not be zero)
+		void __not_in_flash_func(Start)(uint32_t num, uint32_t den)
+		{
+#ifdef COMPUTERCARD_HAS_DIVIDER
+			if (!(sio_hw->div_csr & SIO_DIV_CSR_DIRTY_BITS))
+			{
+				hw_divider_divmod_u32_start(num, den);
+				pending = true;
+				return;
+			}
+#endif
+			quotient = num / den;
+			pending = false;
+		}
 
+		/// Return the quotient of the last Start
+		uint32_t __not_in_flash_func(Result)()
+		{
+#ifdef COMPUTERCARD_HAS_DIVIDER
+			if (pending)
+			{
+				quotient = hw_divider_u32_quotient_wait();
+				pending = false;
+			}
+#endif
+			return quotient;
+		}
 
-	/// Return true if jack connected to input
-	bool __not_in_flash_func(Connected)(Input i){return connected[i];}
-	/// Return true if no jack connected to input
-	bool __not_in_flash_func(Disconnected)(Input i){return !connected[i];}
+	private:
+		uint32_t quotient;
+		bool pending;
+	};
 
+	/** \brief Linear ramp to a target over a given number of samples
 
-	/// Set LED brightness, values 0-4095
-	// Led numbers are:
-	// 0 1
-	// 2 3
-	// 4 5
-	void __not_in_flash_func(LedBrightness)(uint32_t index, uint16_t value)
-	{
-		pwm_set_gpio_level(leds[index], (value*value)>>8);
-	}
-	
-	/// Turn LED on/off
-	void __not_in_flash_func(LedOn)(uint32_t index, bool value = true)
+		Like Smoothed, but each ramp has its own length, e.g. the time since the last clock pulse.
+		SetTarget() starts the divide for the ramp step on the hardware divider, and the
+		following Next() collects it, so setting a new target costs no divide wait.
+		Values are -32767 to 32767.
+	*/
+	class Slew
 	{
-		pwm_set_gpio_level(leds[index], value?65535:0);
-	}
+	public:
+		Slew(int32_t initial = 0) : value(initial << 16), step(0), remaining(0), target(initial), negative(false), stepPending(false) {}
 
-	/// Turn LED off
-	void __not_in_flash_func(LedOff)(uint32_t index)
-	{
-		pwm_set_gpio_level(leds[index], 0);
-	}
+		/// Ramp from the current value to newTarget over the next samples calls to Next()
+		void __not_in_flash_func(SetTarget)(int32_t newTarget, uint32_t samples)
+		{
+			target = newTarget;
+			if (samples == 0)
+			{
+				Reset(newTarget);
+				return;
+			}
+			int64_t diff = (int64_t(newTarget) << 16) - value;
+			negative = diff < 0;
+			div.Start(uint32_t(negative ? -diff : diff), samples);
+			stepPending = true;
+			remaining = samples;
+		}
 
-	// Return power state of USB port
-	USBPowerState_t USBPowerState()
+		/// Jump immediately to a value, without a ramp
+		void Reset(int32_t newValue)
+		{
+			target = newValue;
+			value = newValue << 16;
+			remaining = 0;
+			stepPending = false;
+		}
+
+		/// Advance by one sample and return the ramped value
+		int32_t __not_in_flash_func(Next)()
+		{
+			if (remaining)
+			{
+				if (stepPending)
+				{
+					step = int32_t(div.Result());
+					if (negative) step = -step;
+					stepPending = false;
+				}
+				if (--remaining) value += step;
+				else value = target << 16;
+			}
+			return value >> 16;
+		}
+
+		/// Return current value, without advancing
+		int32_t Value() const {return value >> 16;}
+
+		/// Return target value, as given to SetTarget
+		int32_t Target() const {return target;}
+
+		/// True while a ramp is in progress
+		bool Ramping() const {return remaining != 0;}
+
+	private:
+		Divider div;
+		int32_t value, step;
+		uint32_t remaining;
+		int32_t target;
+		bool negative, stepPending;
+	};
+
+	/** \brief Parameter ramp worked out once per block, and read per sample with a single add
+
+		Give the ramp a target with SetLinear, SetExponential or SetTarget. Then, at the start of
+		each block, call Block(n) to work out the step for the block's n samples, and Next() n
+		times to read them. Next() has no branches or divides; Block() divides by n with a shift
+		when n is a power of two (as blockSize is), or on the hardware divider otherwise.
+		- SetLinear(target): reach target by the end of the next block
+		- SetExponential(target, shift): each block, move 2^-shift of the way to target (a
+		  one-pole filter at the block rate), ramping linearly across the block
+		- SetTarget(target, samples): reach target after samples samples, however many blocks
+		  that spans. A ramp ending part way through a block finishes at the end of that block;
+		  with blocks of one sample, this gives exactly the values of a Slew.
+		Values are -32767 to 32767.
+	*/
+	class Ramp
 	{
-		if (HardwareVersion() != Rev1_1)
-			return Unsupported;
-		else if (gpio_get(USB_HOST_STATUS))
-			return UFP;
-		else
-			return DFP;
-	}
+	public:
+		Ramp(int32_t initial = 0) : value(initial << 16), step(0), overStep(0), remaining(0), target(initial), shift(0), mode(Hold), negative(false), stepPending(false), landing(false) {}
 
-	/// Return hardware version
-	HardwareVersion_t HardwareVersion() {return hw;}
+		/// Ramp from the current value to newTarget over the next block
+		void SetLinear(int32_t newTarget)
+		{
+			Land();
+			target = newTarget;
+			mode = Linear;
+		}
 
-	/// Return ID number unique to flash card
-	uint64_t UniqueCardID()	{return uniqueID;}	
-	
-	void Abort();
+		/// Approach newTarget, by 2^-newShift of the remaining distance each block
+		void SetExponential(int32_t newTarget, int newShift)
+		{
+			Land();
+			target = newTarget;
+			shift = newShift;
+			mode = Exponential;
+		}
 
-	uint16_t CRCencode(const uint8_t *data, int length);
+		/// Ramp from the current value to newTarget over the next samples samples
+		void __not_in_flash_func(SetTarget)(int32_t newTarget, uint32_t samples)
+		{
+			if (samples == 0)
+			{
+				Reset(newTarget);
+				return;
+			}
+			Land();
+			target = newTarget;
+			int64_t diff = (int64_t(newTarget) << 16) - value;
+			negative = diff < 0;
+			div.Start(uint32_t(negative ? -diff : diff), samples);
+			stepPending = true;
+			remaining = samples;
+			mode = Samples;
+		}
 
-private:
-	
-	typedef struct
-	{
-		float m, b;
-		int32_t mi, bi;
-	} CalCoeffs;
+		/// Jump immediately to a value, without a ramp
+		void Reset(int32_t newValue)
+		{
+			target = newValue;
+			value = newValue << 16;
+			step = 0;
+			remaining = 0;
+			mode = Hold;
+			stepPending = false;
+			landing = false;
+		}
 
-	typedef struct
-	{
-		int32_t dacSetting;
-		int8_t voltage;
-	} CalPoint;
+		/// Work out the next n values, to be read with Next()
+		void __not_in_flash_func(Block)(uint32_t n)
+		{
+			Land();
+			step = 0;
+			if (mode == Hold) return;
 
-	static constexpr int calMaxChannels = 2;
-	static constexpr int calMaxPoints = 10;
+			int64_t diff = (int64_t(target) << 16) - value;
+			if (mode == Samples)
+			{
+				if (stepPending)
+				{
+					overStep = int32_t(div.Result());
+					if (negative) overStep = -overStep;
+					stepPending = false;
+				}
+				if (remaining > n)
+				{
+					remaining -= n;
+					step = overStep;
+					return;
+				}
+			}
+			else if (mode == Exponential)
+			{
+				// Until the step gets too small to move
+				step = Divide(diff >> shift, n);
+				if (step > 0 || step < -1) return;
+			}
 
-	static volatile uint32_t cvValue[2];
-	
-	uint8_t numCalibrationPoints[calMaxChannels];
-	CalPoint calibrationTable[calMaxChannels][calMaxPoints];
-	CalCoeffs calCoeffs[calMaxChannels];
+			// Reach the target by the end of this block
+			step = Divide(diff, n);
+			remaining = 0;
+			mode = Hold;
+			landing = true;
+		}
 
-	uint64_t uniqueID;
-	
-	uint8_t ReadByteFromEEPROM(unsigned int eeAddress);
-	int ReadIntFromEEPROM(unsigned int eeAddress);
-	void CalcCalCoeffs(int channel);
-	int ReadEEPROM();
-	uint32_t MIDIToDac(int midiNote, int channel);
-	
-	HardwareVersion_t hw;
-	HardwareVersion_t ProbeHardwareVersion();
-	
-	int16_t dacOut[2];
-	
-	volatile int32_t knobs[4] = { 0, 0, 0, 0 }; // 0-4095
-	volatile bool pulse[2] = { 0, 0 };
-	volatile bool last_pulse[2] = { 0, 0 };
-	volatile int32_t cv[2] = { 0, 0 }; // -2047 - 2048
-	volatile int16_t adcInL = 0x800, adcInR = 0x800;
+		/// Advance by one sample and return the ramped value
+		int32_t Next()
+		{
+			value += step;
+			return value >> 16;
+		}
 
-	volatile uint8_t mxPos = 0; // external multiplexer value
+		/// Return current value, without advancing
+		int32_t Value() const {return value >> 16;}
 
-	volatile int32_t plug_state[6] = {0,0,0,0,0,0};
-	volatile bool connected[6] = {0,0,0,0,0,0};
-	bool useNormProbe;
+		/// Return target value
+		int32_t Target() const {return target;}
 
-	Switch switchVal, lastSwitchVal;
-	
-	volatile uint8_t runADCMode;
+		/// True while a ramp is in progress (including its last block)
+		bool Ramping() const {return mode != Hold || landing;}
 
+	private:
+		enum Mode {Hold, Linear, Exponential, Samples};
 
-// Buffers that DMA reads into / out of
-	uint16_t ADC_Buffer[2][8];
-	uint16_t SPI_Buffer[2][2];
+		// The last block of a ramp can fall short of the target by what the divide dropped
+		void Land()
+		{
+			if (landing)
+			{
+				value = target << 16;
+				landing = false;
+			}
+		}
 
-	uint8_t adc_dma, spi_dma; // DMA ids
+		// diff / n, to within one unit
+		int32_t __not_in_flash_func(Divide)(int64_t diff, uint32_t n)
+		{
+			if ((n & (n - 1)) == 0)
+			{
+				int s = 0;
+				while ((1u << s) < n) s++;
+				return int32_t(diff >> s);
+			}
+			bool neg = diff < 0;
+			div.Start(uint32_t(neg ? -diff : diff), n);
+			int32_t q = int32_t(div.Result());
+			return neg ? -q : q;
+		}
+
+		Divider div;
+		int32_t value, step, overStep;
+		uint32_t remaining;
+		int32_t target;
+		int shift;
+		Mode mode;
+		bool negative, stepPending, landing;
+	};
+
+	/** \brief Measures the period of a clock, e.g. a pulse input, in samples
+
+		Call Tick() once per sample (or Tick(n) once per block of n samples), and Clock() on each
+		rising edge. Period() is the latest interval between edges; SmoothedPeriod() averages
+		out jitter (an interval differing by more than a quarter from the average is taken as a
+		tempo change, and replaces it). Gaps longer than maxPeriodSamples are clamped to maxPeriod.
+		PhaseIncrement() gives the matching oscillator rate, with its divide started on the
+		hardware divider by Clock() and collected when first read.
+	*/
+	class ClockTracker
+	{
+	public:
+		ClockTracker(uint32_t maxPeriodSamples = 1u << 20) : maxPeriod(maxPeriodSamples), since(0), period(0), smoothed8(0), edges(0), inc(0), incPending(false) {}
 
+		/// Advance by n samples
+		void __not_in_flash_func(Tick)(uint32_t n = 1)
+		{
+			since += n;
+			if (since > maxPeriod) since = maxPeriod;
+		}
 
+		/// Register a clock edge, returning the interval since the previous one (0 for the first edge)
+		uint32_t __not_in_flash_func(Clock)()
+		{
+			uint32_t p = since;
+			since = 0;
+			if (edges < 2) edges++;
+			if (edges < 2) return 0;
+			if (p == 0) p = 1;
+			period = p;
+
+			uint32_t p8 = p << 8;
+			uint32_t s8 = smoothed8;
+			uint32_t d8 = (p8 > s8) ? p8 - s8 : s8 - p8;
+			if (smoothed8 == 0 || d8 > (s8 >> 2)) smoothed8 = p8;
+			else smoothed8 = (p8 > s8) ? s8 + (d8 >> smoothShift) : s8 - (d8 >> smoothShift);
+
+			div.Start(0xFFFFFFFFu, SmoothedPeriod());
+			incPending = true;
+			return p;
+		}
 
-	uint8_t dmaPhase = 0;
+		/// True once two edges have been seen, so a period is known
+		bool Valid() const {return edges >= 2;}
+		/// Latest interval between edges, in samples (0 until Valid)
+		uint32_t Period() const {return period;}
+		/// Jitter-smoothed interval between edges, in samples (0 until Valid)
+		uint32_t SmoothedPeriod() const {return (smoothed8 + 128) >> 8;}
+		/// Samples since the last edge (saturating at maxPeriod)
+		uint32_t SinceLastClock() const {return since;}
+
+		/// Phase increment per sample (2^32 per cycle) of one cycle per smoothed period (0 until Valid)
+		uint32_t __not_in_flash_func(PhaseIncrement)()
+		{
+			if (incPending)
+			{
+				inc = div.Result();
+				incPending = false;
+			}
+			return inc;
+		}
 
-	// Convert signed int16 value into data string for DAC output
-	uint16_t __not_in_flash_func(dacval)(int16_t value, uint16_t dacChannel)
+		/// Forget the clock history, e.g. after the clock input is disconnected
+		void Reset()
+		{
+			since = period = smoothed8 = 0;
+			edges = 0;
+			inc = 0;
+			if (incPending) div.Result();
+			incPending = false;
+		}
+
+	private:
+		static constexpr int smoothShift = 3; // one-pole average over ~8 intervals
+		Divider div;
+		uint32_t maxPeriod, since, period, smoothed8;
+		uint8_t edges;
+		uint32_t inc;
+		bool incPending;
+	};
+
+	/** \brief Adaptive integer smoothing of a knob or CV reading, in the style of ResponsiveAnalogRead
+
+		Smoothing is heaviest while the reading is still, and lightens by one step for each
+		doubling of the distance between reading and smoothed value beyond snap, so a moving
+		knob is followed closely without noise on a still one. Once the input settles,
+		Value() sleeps, and only changes again once the input moves more than sleepThreshold.
+		Used for the knobs and CV inputs after EnableAdaptiveSmoothing, and can be used on
+		other control signals too, e.g. audio inputs patched from a CV.
+	*/
+	class AdaptiveSmoother
 	{
-		if (value<-2048) value = -2048;
-		if (value > 2047) value = 2047;
-		return (dacChannel | 0x3000) | (((uint16_t)((value & 0x0FFF) + 0x800)) & 0x0FFF);
-	}
-	uint32_t next_norm_probe();
+	public:
+		/// sleepThreshold and snap are in the units of the readings
+		AdaptiveSmoother(int32_t sleepThreshold = 8, int32_t snap = 8) : sleep(sleepThreshold), snap16(snap << 4), s(0), err(0), value(0), awake(false), started(false) {}
 
-	void BufferFull();
+		void SetSleepThreshold(int32_t sleepThreshold) {sleep = sleepThreshold;}
 
-	void AudioWorker();
-	
-	static void AudioCallback()
-	{
-		thisptr->BufferFull();
-	}
-	static ComputerCard *thisptr;
+		/** \brief Add a reading, returning true if Value() has changed
 
-	// 19-bit CV outputs
-	static void OnCVPWMWrap()
+			maxShift is the smoothing while still, as a one-pole filter coefficient of 2^-maxShift per reading.
+		*/
+		bool __not_in_flash_func(Update)(int32_t x, int maxShift = 7)
+		{
+			int32_t x16 = x << 4;
+			if (!started)
+			{
+				s = x16;
+				started = awake = true;
+			}
+			int32_t d = x16 - s;
+			int32_t ad = d < 0 ? -d : d;
+			int shift = maxShift;
+			for (int32_t t = snap16; ad > t && shift > 0; t <<= 1) shift--;
+			s += shift ? (d + (1 << (shift - 1))) >> shift : d;
+			err += (ad - err) >> 4;
+
+			int32_t v = s >> 4;
+			int32_t dv = v - value;
+			if (dv > sleep || dv < -sleep) awake = true;
+			bool changed = awake && v != value;
+			if (changed) value = v;
+			if (err <= (sleep << 3)) awake = false; // sleep once within half the threshold
+			return changed;
+		}
+
+		/// Smoothed value, which holds still while the input is asleep
+		int32_t Value() const {return value;}
+
+		/// True while the input is moving
+		bool Awake() const {return awake;}
+
+	private:
+		int32_t sleep, snap16;
+		int32_t s, err, value; // s and err have 4 fractional bits
+		bool awake, started;
+	};
+
+	/** \brief MIDI to CV conversion: held notes, pitch bend, glide, 14-bit CCs, MPE and MIDI clock
+
+		Pass each received message to MIDI (e.g. from ProcessMIDI). This only stores state:
+		every message takes constant time, apart from a note off searching the short stack of
+		held notes. Call Update once per block or control period, with the number of samples
+		since the last call. Update applies glide, smooths pressure and timbre, and advances
+		the clock. Then read Pitch(), Gate() and the rest to set outputs, e.g. with
+		CVOutMIDIPitch.
+
+		Notes from all channels share one stack, with last note priority. Pitch bend is per
+		channel, with a range set by SetBendRange or by RPN 0. In MPE mode (SetMPE), channel
+		1 is the manager channel, whose bend applies to every note. The sounding note's own
+		channel adds its bend (48 semitones by default), pressure and timbre (CC 74).
+		CCs 0-31 are 14-bit, with the LSB from CCs 32-63.
+
+		MIDI clock (24 per quarter note) is timed by a ClockTracker, so BeatPhase() moves
+		smoothly between clock messages, at the jitter-smoothed tempo.
+	*/
+	class MIDIToCV
 	{
-		static int32_t error1 = 0, error2 = 0;
+	public:
+		static constexpr unsigned maxHeld = 16;
 
-		pwm_clear_irq(pwm_gpio_to_slice_num(CV_OUT_1)); // clear the interrupt flag
-		uint32_t truncated_cv1_val = (cvValue[0]-error1) & 0xFFFFFF00;
-		error1 += truncated_cv1_val - cvValue[0];
-		pwm_set_gpio_level(CV_OUT_1, (truncated_cv1_val>>8));
-		uint32_t truncated_cv2_val = (cvValue[1]-error2) & 0xFFFFFF00;
-		error2 += truncated_cv2_val - cvValue[1];
-		pwm_set_gpio_level(CV_OUT_2, (truncated_cv2_val>>8));
-	}
+		MIDIToCV() {Reset();}
 
-};
+		/// Release all notes, and return bends, pressure, CCs and clock to their initial state
+		void Reset()
+		{
+			held = 0;
+			for (int c=0; c<16; c++)
+			{
+				bend[c] = 0;
+				pressure[c] = 0;
+				rpn[c] = rpnNull;
+				for (int n=0; n<128; n++) ccMSB[c][n] = 0;
+				for (int n=0; n<32; n++) ccLSB[c][n] = 0;
+			}
+			SetMPE(mpe);
+			pitch = 0;
+			snap = true;
+			started = false;
+			pressureOut = timbreOut = 0;
+			ticks = tickInBeat = 0;
+			running = waitFirstTick = false;
+			clock.Reset();
+		}
 
+		/// Respond only to MIDI channel (0-15), or to all channels if -1 (the default). MPE mode always uses all channels
+		void SetChannel(int channel) {listenChannel = channel;}
 
-#ifndef COMPUTERCARD_NOIMPL
+		/// Range of pitch bend on every channel, in semitones (also set per channel by RPN 0)
+		void SetBendRange(uint8_t semitones)
+		{
+			for (int c=0; c<16; c++) bendRange[c] = semitones;
+		}
 
+		/// MPE mode: channel 1 is the manager channel (bend range 2), channels 2-16 carry one note each (bend range 48)
+		void SetMPE(bool enable)
+		{
+			mpe = enable;
+			SetBendRange(enable ? 48 : 2);
+			if (enable) bendRange[0] = 2;
+		}
 
-#include "hardware/adc.h"
-#include "hardware/clocks.h"
-#include "hardware/dma.h"
-#include "hardware/flash.h"
-#include "hardware/i2c.h"
-#include "hardware/irq.h"
-#include "hardware/spi.h"
+		/** \brief Glide time constant, in samples (0 for none)
 
-// Input normalisation probe pin
-#define NORMALISATION_PROBE 4
+			Pitch moves exponentially towards each new note, covering about two thirds of
+			the way in the given time. If legatoOnly, glide only between overlapping notes.
+		*/
+		void SetGlide(uint32_t samples, bool legatoOnly = false)
+		{
+			glideRate = samples ? 0xFFFFFFFFu / samples : 0;
+			legato = legatoOnly;
+		}
 
-// Mux pins
-#define MX_A 24
-#define MX_B 25
+		/// Handle one MIDI message
+		void __not_in_flash_func(MIDI)(const MIDIEvent &e)
+		{
+			uint8_t status = e.data[0];
+			if (status >= 0xF0)
+			{
+				Realtime(status);
+				return;
+			}
+			uint8_t ch = status & 0x0F;
+			if (!mpe && listenChannel >= 0 && ch != listenChannel) return;
+			uint8_t d1 = e.data[1] & 0x7F, d2 = e.data[2] & 0x7F;
 
-// ADC input pins
-#define AUDIO_L_IN_1 27
-#define AUDIO_R_IN_1 26
-#define MUX_IO_1 28
-#define MUX_IO_2 29
+			switch (status & 0xF0)
+			{
+			case 0x90: // note on with velocity 0 is a note off
+				if (d2) NoteOn(ch, d1, d2);
+				else Remove(ch, d1);
+				break;
 
-#define DAC_CHANNEL_A 0x0000
-#define DAC_CHANNEL_B 0x8000
+			case 0x80:
+				Remove(ch, d1);
+				break;
 
-#define DAC_CS 21
-#define DAC_SCK 18
-#define DAC_TX 19
+			case 0xE0:
+				bend[ch] = int16_t((d1 | (d2 << 7)) - 8192);
+				break;
 
-#define EEPROM_SDA 16
-#define EEPROM_SCL 17
+			case 0xD0:
+				pressure[ch] = uint16_t(d1 << 7);
+				break;
 
-#define PULSE_1_INPUT 2
-#define PULSE_2_INPUT 3
+			case 0xA0: // polyphonic aftertouch, used only for the sounding note
+				if (held && stack[held - 1].note == d1 && stack[held - 1].channel == ch) pressure[ch] = uint16_t(d2 << 7);
+				break;
 
-#define DEBUG_1 0
-#define DEBUG_2 1
+			case 0xB0:
+				ControlChange(ch, d1, d2);
+				break;
 
-#define SPI_PORT spi0
-#define SPI_DREQ DREQ_SPI0_TX
+			default:
+				break;
+			}
+		}
 
+		/// Apply glide and smoothing for n samples, and advance the clock (once per block or control period)
+		void __not_in_flash_func(Update)(uint32_t n)
+		{
+			clock.Tick(n);
 
-#define BOARD_ID_0 7
-#define BOARD_ID_1 6
-#define BOARD_ID_2 5
+			uint8_t ch = Channel();
+			int32_t t = int32_t(Note()) << 16;
+			// Bend of -8192 to 8191 is +-range semitones, in 16.16
+			t += int32_t(bend[ch]) * bendRange[ch] * 8;
+			if (mpe && ch != 0) t += int32_t(bend[0]) * bendRange[0] * 8;
 
-// The ADC (/DMA) run mode, used to stop DMA in a known state before writing to flash
-#define RUN_ADC_MODE_RUNNING 0
-#define RUN_ADC_MODE_REQUEST_ADC_STOP 1
-#define RUN_ADC_MODE_ADC_STOPPED 2
-#define RUN_ADC_MODE_REQUEST_ADC_RESTART 3
+			if (snap || glideRate == 0)
+			{
+				pitch = t;
+				snap = false;
+			}
+			else
+			{
+				uint64_t a = (uint64_t(n) * glideRate) >> 16;
+				int32_t alpha = a > 65536 ? 65536 : int32_t(a);
+				int32_t d = t - pitch;
+				int32_t step = int32_t((int64_t(d) * alpha) >> 16);
+				if (step == 0) step = d; // finish the last fraction
+				pitch += step;
+			}
 
+			int32_t p = pressure[ch], tb = CC(ch, 74);
+			pressureOut += (p - pressureOut) >> 2;
+			timbreOut += (tb - timbreOut) >> 2;
+		}
 
-#define EEPROM_ADDR_ID 0
-#define EEPROM_ADDR_VERSION 2
-#define EEPROM_ADDR_CRC_L 87
-#define EEPROM_ADDR_CRC_H 86
-#define EEPROM_VAL_ID 2001
-#define EEPROM_NUM_BYTES 88
+		/// Current pitch, as a MIDI note number in 16.16 fixed point, including bend and glide
+		int32_t Pitch() const {return pitch;}
+		/// True while any note is held
+		bool Gate() const {return held != 0;}
+		/// True once after each note on, until read
+		bool NoteStarted()
+		{
+			bool s = started;
+			started = false;
+			return s;
+		}
+		/// MIDI note number of the sounding (or last sounded) note
+		uint8_t Note() const {return held ? stack[held - 1].note : lastNote;}
+		/// Velocity (1-127) of the sounding (or last) note
+		uint8_t Velocity() const {return held ? stack[held - 1].velocity : lastVelocity;}
+		/// Channel (0-15) of the sounding (or last) note
+		uint8_t Channel() const {return held ? stack[held - 1].channel : lastChannel;}
+		/// Smoothed channel or polyphonic pressure of the sounding note's channel (0-16383)
+		int32_t Pressure() const {return pressureOut;}
+		/// Smoothed CC 74 (MPE timbre) of the sounding note's channel (0-16383)
+		int32_t Timbre() const {return timbreOut;}
+		/// Pitch bend of a channel (-8192 to 8191)
+		int32_t Bend(uint8_t channel) const {return bend[channel & 0x0F];}
+
+		/// Controller cc on channel (0-15), as 0-16383: 14-bit for CCs 0-31 (LSB from CC 32-63), else the 7-bit value << 7
+		int32_t CC(uint8_t channel, uint8_t cc) const
+		{
+			channel &= 0x0F;
+			cc &= 0x7F;
+			return (ccMSB[channel][cc] << 7) | (cc < 32 ? ccLSB[channel][cc] : 0);
+		}
 
-#define EEPROM_PAGE_ADDRESS 0x50
+		/// True between MIDI start (or continue) and stop
+		bool Running() const {return running;}
+		/// Clock messages since the last MIDI start
+		uint32_t Ticks() const {return ticks;}
+		/// Smoothed interval between clock messages, in samples (0 until two have arrived)
+		uint32_t TickPeriod() const {return clock.SmoothedPeriod();}
 
+		/** \brief Position within the current quarter note, 0 to 2^32-1
 
-// Initialise CV output delta-sigma target to half-way (near 0V)
-volatile uint32_t ComputerCard::cvValue[2] = {262144,262144};
+			Advances by 1/24 at each clock message, and is interpolated between them from the
+			smoothed tick period, stopping at the next tick's position if that tick is late.
+		*/
+		uint32_t __not_in_flash_func(BeatPhase)()
+		{
+			static constexpr uint32_t tickPhase = 178956970; // 2^32 / 24
+			uint32_t frac = 0xFFFFFFFFu;
+			uint32_t inc = clock.PhaseIncrement();
+			if (inc)
+			{
+				uint64_t f = uint64_t(clock.SinceLastClock()) * inc;
+				if (f < 0xFFFFFFFFu) frac = uint32_t(f);
+			}
+			return tickInBeat * tickPhase + uint32_t((uint64_t(frac) * tickPhase) >> 32);
+		}
 
+	private:
+		struct Held
+		{
+			uint8_t note, channel, velocity;
+		};
 
-ComputerCard *ComputerCard::thisptr;
+		static constexpr uint16_t rpnNull = 0x3FFF;
 
-// Return pseudo-random bit for normalisation probe
-uint32_t __not_in_flash_func(ComputerCard::next_norm_probe)()
-{
-	static uint32_t lcg_seed = 1;
-	lcg_seed = 1664525 * lcg_seed + 1013904223;
-	return lcg_seed >> 31;
-}
+		void NoteOn(uint8_t ch, uint8_t note, uint8_t vel)
+		{
+			if (held == 0 && legato) snap = true;
+			Remove(ch, note);
+			if (held == maxHeld) // drop the oldest note
+			{
+				for (unsigned i=1; i<maxHeld; i++) stack[i - 1] = stack[i];
+				held--;
+			}
+			stack[held++] = {note, ch, vel};
+			started = true;
+			if (mpe) pressure[ch] = 0; // each MPE note starts with its channel's pressure reset
+		}
 
-// Main audio core function
-void __not_in_flash_func(ComputerCard::AudioWorker)()
-{
+		void Remove(uint8_t ch, uint8_t note)
+		{
+			for (int i=int(held)-1; i>=0; i--)
+			{
+				if (stack[i].note == note && stack[i].channel == ch)
+				{
+					if (held == 1) // keep the pitch of the last note sounding
+					{
+						lastNote = note;
+						lastChannel = ch;
+						lastVelocity = stack[i].velocity;
+					}
+					for (unsigned j=i+1; j<held; j++) stack[j - 1] = stack[j];
+					held--;
+					return;
+				}
+			}
+		}
 
-	adc_select_input(0);
-	adc_set_round_robin(0b0001111U);
+		void ControlChange(uint8_t ch, uint8_t cc, uint8_t val)
+		{
+			if (cc < 32)
+			{
+				ccMSB[ch][cc] = val;
+				ccLSB[ch][cc] = 0; // a new MSB resets the LSB
+			}
+			else if (cc < 64) ccLSB[ch][cc - 32] = val;
+			else ccMSB[ch][cc] = val;
 
-	// enabled, with DMA request when FIFO contains data, no erro flag, no byte shift
-	adc_fifo_setup(true, true, 1, false, false);
+			switch (cc)
+			{
+			case 101: rpn[ch] = uint16_t((rpn[ch] & 0x7F) | (val << 7)); break;
+			case 100: rpn[ch] = uint16_t((rpn[ch] & 0x3F80) | val); break;
+			case 99: case 98: rpn[ch] = rpnNull; break; // NRPNs are not handled
+			case 6: if (rpn[ch] == 0) bendRange[ch] = val; break; // RPN 0: pitch bend range
+			case 123: // all notes off
+				for (int i=int(held)-1; i>=0; i--) if (stack[i].channel == ch) Remove(ch, stack[i].note);
+				break;
+			default: break;
+			}
+		}
 
+		void Realtime(uint8_t status)
+		{
+			switch (status)
+			{
+			case 0xF8:
+				clock.Clock();
+				if (waitFirstTick) waitFirstTick = false;
+				else if (running)
+				{
+					ticks++;
+					if (++tickInBeat == 24) tickInBeat = 0;
+				}
+				break;
+			case 0xFA: // start: the next clock is the first beat
+				running = true;
+				waitFirstTick = true;
+				ticks = tickInBeat = 0;
+				break;
+			case 0xFB:
+				running = true;
+				break;
+			case 0xFC:
+				running = false;
+				break;
+			default:
+				break;
+			}
+		}
 
-	// ADC clock runs at 48MHz
-	// 48MHz ÷ (124+1) = 384kHz ADC sample rate
-	//                 = 8×48kHz audio sample rate
-	adc_set_clkdiv(124);
+		Held stack[maxHeld];
+		unsigned held;
+		uint8_t lastNote = 60, lastChannel = 0, lastVelocity = 0;
+		int listenChannel = -1;
+		bool mpe = false, legato = false, snap, started;
+
+		int16_t bend[16];
+		uint8_t bendRange[16];
+		uint16_t pressure[16], rpn[16];
+		uint8_t ccMSB[16][128], ccLSB[16][32];
+
+		int32_t pitch;
+		uint32_t glideRate = 0;
+		int32_t pressureOut, timbreOut;
+
+		ClockTracker clock;
+		uint32_t ticks, tickInBeat;
+		bool running, waitFirstTick;
+	};
+
+	ComputerCard();
+
+	/** \brief Start audio processing.
+
+        The Run method starts audio processing, calling ProcessSample using an interrupt,
+        at the given sample rate. Run is a blocking function (it never returns)
+	*/
+	void Run(SampleRate_t rate = SR48kHz)
+	{
+		bootTimes.run = time_us_32();
+		if (StartupDone()) bootTimes.startupDone = bootTimes.run;
+		ComputerCard::thisptr = this;
+		sampleRate = rate;
+#ifdef COMPUTERCARD_SOAK
+		SoakStart();
+#endif
+#ifdef COMPUTERCARD_HAS_MULTICORE
+		if (audioOnCore1)
+		{
+			RunAudioOnCore1();
+			return;
+		}
+#endif
+		AudioWorker();
+	}
+
+	/// Return audio sample rate in Hz, as set by Run
+	int32_t SampleRate() {return sampleRate;}
+
+	/// Times at which startup reached each stage, in µs since reset (as time_us_32), see BootProfile
+	struct BootTimes
+	{
+		uint32_t constructor; // ComputerCard constructor entered, after clock and C runtime setup
+		uint32_t calibrated;  // CV output calibration read
+		uint32_t run;         // Run called, after the card's constructor
+		uint32_t firstSample; // first audio interrupt
+		uint32_t startupDone; // startup tasks (AddStartupTask) finished, 0 until then
+	};
+
+	/// Times at which startup reached each stage, to find what delays the first sample
+	const BootTimes &BootProfile() const {return bootTimes;}
+
+	/** \brief Use before Run() to finish part of the card's setup in the background, once audio is running
+
+		Slow setup, such as clearing a large buffer, can be split into steps and given here
+		(e.g. AddStartupTask(&MyCard::ClearBuffer) in the card's constructor) so that audio
+		starts sooner. fn is called as fn(0), fn(1), ... until it returns false, from the loop
+		in Run that idles between audio interrupts, so it never delays the audio; tasks run
+		one after another, in the order added, up to maxStartupTasks. Until StartupDone,
+		ProcessSample must cope with the setup being unfinished.
+	*/
+	template <class C>
+	void AddStartupTask(bool (C::*fn)(int step))
+	{
+		if (numStartupTasks < maxStartupTasks) startupTasks[numStartupTasks++] = static_cast<StartupTask>(fn);
+	}
+
+	/// True once every task given to AddStartupTask has finished
+	bool StartupDone() const {return nextStartupTask == numStartupTasks;}
+
+	static constexpr int maxStartupTasks = 8;
+
+	/// How the normalisation probe runs, set by EnableNormalisationProbe
+	enum ProbeMode {ProbeContinuous, ProbeBursts, ProbeOnDemand};
+
+	/** \brief Use before Run() to enable Connected/Disconnected detection
+
+		By default the probe runs all the time. With ProbeBursts, it runs for burstSamples
+		every intervalMs, and with ProbeOnDemand, for burstSamples at startup and after each
+		call to ProbeJacks(). Between bursts the probe output is held low, and
+		Connected/Disconnected return the result of the last burst.
+	*/
+	void EnableNormalisationProbe(ProbeMode mode = ProbeContinuous, int32_t intervalMs = 100, int32_t burstSamples = 256)
+	{
+		useNormProbe = true;
+		probeMode = mode;
+		probeIntervalMs = intervalMs;
+		probeBurstSamples = burstSamples;
+	}
+
+	/// Run a burst of the normalisation probe as soon as possible, in ProbeBursts or ProbeOnDemand modes
+	void ProbeJacks() {probeRequested = true;}
+
+	/** \brief Use before Run() to smooth knobs and CV inputs with AdaptiveSmoother, rather than a fixed filter
+
+		Knobs and CV then follow movements more quickly, and hold still (so are not reported
+		by ControlsChanged) until they move more than sleepThreshold (in 0-4095 ADC units).
+	*/
+	void EnableAdaptiveSmoothing(int32_t sleepThreshold = 8)
+	{
+		for (int i=0; i<4; i++) knobSmoother[i].SetSleepThreshold(sleepThreshold);
+		for (int i=0; i<2; i++) cvSmoother[i].SetSleepThreshold(sleepThreshold);
+		useAdaptiveSmoothing = true;
+	}
+
+	/** \brief Use before Run() to set how often each knob and CV input is read
+
+		Each step of the analogue multiplexer reads one knob and one CV input: Main and Y
+		share steps with CV 1, and X and the switch share steps with CV 2. By default the mux
+		cycles through all four, reading each CV input every other step and each knob every
+		fourth. The CV weights set how the steps are shared between CV 1 and CV 2, and the
+		knob weights how each CV input's steps are shared between its two knobs. For example,
+		SetMuxScan(7, 1) reads CV 1 on seven steps in eight. Each input's smoothing is applied
+		per reading, so inputs read more often also follow changes more quickly.
+		An input with a weight of 0 is not read at all (and the switch then reads Down).
+	*/
+	void SetMuxScan(int cv1Weight, int cv2Weight, int mainWeight = 1, int yWeight = 1, int xWeight = 1, int switchWeight = 1)
+	{
+		if (cv1Weight + cv2Weight <= 0) cv1Weight = cv2Weight = 1;
+		if (mainWeight + yWeight <= 0) mainWeight = yWeight = 1;
+		if (xWeight + switchWeight <= 0) xWeight = switchWeight = 1;
+
+		// Share of the steps for each mux state, 0 to 3
+		int32_t w[4] = {cv1Weight * mainWeight * (xWeight + switchWeight), cv2Weight * xWeight * (mainWeight + yWeight),
+						cv1Weight * yWeight * (xWeight + switchWeight), cv2Weight * switchWeight * (mainWeight + yWeight)};
+		int32_t total = w[0] + w[1] + w[2] + w[3];
+
+		// Smooth weighted round-robin, so that each input's readings are spread evenly through the schedule
+		int32_t credit[4] = {0, 0, 0, 0};
+		for (int i=0; i<muxScheduleLen; i++)
+		{
+			int best = 0;
+			for (int m=0; m<4; m++)
+			{
+				credit[m] += w[m];
+				if (credit[m] > credit[best]) best = m;
+			}
+			credit[best] -= total;
+			muxSchedule[i] = best;
+		}
+	}
+
+	/** \brief Use before Run() to read CV inputs at audio rate, for CVInFast
+
+		CVInFast gives each CV input's latest reading, unsmoothed, updated whenever the mux reads
+		it. This sets the mux schedule (replacing any from SetMuxScan) to read the given inputs
+		as often as possible: with both, each is read every other sample (as by default), and
+		with one, it is read on 15 samples in 16, with the other CV input and its two knobs (X
+		and the switch for CV 2, Main and Y for CV 1) read on the 16th.
+	*/
+	void EnableFastCV(bool cv1 = true, bool cv2 = true)
+	{
+		if (cv1 && !cv2) SetMuxScan(15, 1);
+		else if (cv2 && !cv1) SetMuxScan(1, 15);
+		else SetMuxScan(1, 1);
+	}
+
+	/** \brief Use before Run() to remove interference from the mux at the audio inputs
+
+		The mux switches between knobs and CV inputs in step with audio sampling, and the
+		switching leaks into the audio inputs as a pattern repeating with the mux schedule
+		(tones at 12kHz and 24kHz with the default schedule, at 48kHz). With this enabled, the
+		audio inputs' average at each step of the schedule, relative to their average over all
+		steps, is tracked and subtracted, removing the pattern at source with no delay, for a
+		few adds per sample. The averages follow changes (such as knobs moving) with a time
+		constant of 2^shift schedules (2^shift x 16 samples at 48kHz).
+		Per-sample mode only: in block mode the mux steps once per block.
+	*/
+	void EnableMuxCorrection(int shift = 8)
+	{
+		muxCorrectionShift = shift;
+		useMuxCorrection = true;
+	}
+
+	/** \brief Replace the ADC DNL correction table, e.g. with one measured on this unit
+
+		table[x] (4096 entries) is added to ADC code x of the audio and CV inputs, and should be
+		0 at mid-scale (code 2048). The default corrects the wide codes of the RP2040 ADC.
+	*/
+	void SetADCCorrection(const int8_t *table)
+	{
+		memcpy(adcCorrection.v, table, sizeof(adcCorrection.v));
+	}
+
+	/** \brief Use before Run() to set how many ADC conversions of each audio input are made per sample
+
+		The ADC scans its four inputs in turn, so conversions per sample sets the ADC rate:
+		- 1: a single conversion, at half the default ADC rate and DMA traffic, for cards that
+		  use the audio inputs little or not at all
+		- 2: the default, two conversions averaged (1 at 96kHz)
+		- 4: at 24kHz only, four conversions, summed (a first-order CIC decimator) and then
+		  passed through a 3-tap filter correcting the droop of the sum near Nyquist. About 3dB
+		  less noise than the default, and one sample more latency.
+		Values the sample rate cannot support (the ADC tops out at 500kHz) are reduced to
+		the largest that it can.
+	*/
+	void SetAudioOversampling(int conversions)
+	{
+		audioOversampling = conversions;
+	}
+
+	/** \brief Use before Run() to record the audio inputs into a ring of frames, for loopers and delays
+
+		Each frame of audio input, as passed to ProcessBlock (or returned by AudioIn), is
+		written to buffer[CaptureIndex()], wrapping at frames, so a card reads its recent
+		input from the ring rather than copying every sample into a buffer of its own. In
+		block mode, a DMA channel copies each block into the ring while ProcessBlock runs, so
+		recording takes no processor time; the current block is then read from in[]. frames
+		is rounded down to a multiple of blockSize. Without a free DMA channel, Run panics.
+	*/
+	void EnableInputCapture(Frame *buffer, uint32_t frames)
+	{
+		captureFrames = frames - frames % blockSize;
+		captureBuffer = captureFrames ? buffer : nullptr;
+		captureIndex = 0;
+	}
+
+	/// Position in the EnableInputCapture ring of the current frame (or block); the frames before it are the most recent
+	uint32_t __not_in_flash_func(CaptureIndex)() const {return captureIndex;}
+
+	/** \brief Use before Run() to call ProcessControl every period samples
+
+		period is rounded down to a power of two. In block mode, ProcessControl
+		is called at most once per block, so periods shorter than blockSize
+		are rounded up to blockSize.
+	*/
+	void EnableControlRate(int period = 32)
+	{
+		if (period < blockSize) period = blockSize;
+		controlShift = 0;
+		while ((1 << (controlShift + 1)) <= period) controlShift++;
+		controlPeriod = 1 << controlShift;
+		// First call happens before the first ProcessSample/ProcessBlock
+		controlCount = controlPeriod;
+	}
+
+	/** \brief Use before Run() to call ProcessSubRate every factor samples, for parts of a card that run at a lower rate
+
+		factor is 2, 4 or 8 (rounded down to a power of two). The audio inputs are decimated
+		by a cascade of HalfBand filters, one per halving, for SubRateIn, and the outputs
+		given to SubRateOut are interpolated back up by another cascade and added to those of
+		ProcessSample/ProcessBlock. ProcessSubRate runs on the audio interrupt, after
+		ProcessSample/ProcessBlock, with a cost spread over its factor samples; the filters
+		cost three multiplies per channel and halving, at the lower rate of each. Audio through
+		the sub-rate path is delayed by about 10 samples per halving, and band-limited to about
+		0.3 of the sub-rate.
+	*/
+	void EnableSubRate(int factor = 2)
+	{
+		subRateStages = factor >= 8 ? 3 : (factor >= 4 ? 2 : (factor >= 2 ? 1 : 0));
+	}
+
+	/** \brief Use before Run() to drive CV outputs by DMA rather than by the PWM wrap interrupt
+
+		CV output values are dithered once per sample (or block) into a short
+		sequence of PWM levels, which DMA streams into the PWM compare register.
+		This frees core 0 from the ~100kHz CV PWM interrupt.
+	*/
+	void EnableCVOutputDMA() {useCVDMA = true;}
+
+	/// Use before Run() to measure the CPU time taken by ProcessSample/ProcessBlock
+	void EnableLoadMeter() {useLoadMeter = true;}
+
+	/** \brief Use before Run() to pass 16-bit audio outputs from ProcessBlock, noise shaped to the DAC's 12 bits
+
+		ProcessBlock's audio outputs are then -32768 to 32767, rather than -2048 to 2047, and the
+		output stage rounds them to 12 bits with error feedback, so that cards needn't truncate
+		or dither their own. The rounding noise is moved up towards 24kHz (at 48kHz): order 1
+		shapes it by a first difference (rising 6dB/octave), order 2 by a second difference
+		(12dB/octave), for a handful of operations per output sample. Outputs are clipped after rounding.
+		Block mode only (COMPUTERCARD_BLOCK_SIZE > 1).
+	*/
+	void EnableNoiseShaping(int order = 2)
+	{
+		noiseShapingOrder = order < 1 ? 1 : (order > 2 ? 2 : order);
+	}
+
+	/** \brief Use before Run() to timestamp pulse input edges with PIO
+
+		Two PIO state machines time each edge on the pulse inputs to a few processor cycles,
+		rather than to the sample (or block) in which it was read, for PulseInRisingEdgeOffset
+		and PulseInFallingEdgeOffset. Pulses shorter than a sample are also reported by
+		PulseInRisingEdge. Needs hardware_pio linked, and two free state machines and 12
+		instructions of space on one PIO block; otherwise edges are read as before.
+	*/
+	void EnablePulseCapture() {usePulseCapture = true;}
+
+	/** \brief Use before Run() to step the knob/CV mux at a fixed point in each frame, with PIO
+
+		The audio interrupt normally sets the mux address lines itself, so each step lands
+		wherever the interrupt happens to run, and moves with its latency. With this enabled,
+		the interrupt queues the address for a PIO state machine, which sets it one ADC
+		conversion after the frame (or block) ends, timed by a DMA channel chained to the ADC's.
+		Knob and CV readings, and the mux's leakage into the audio inputs (see
+		EnableMuxCorrection), then no longer vary with the interrupt's timing. Needs
+		hardware_pio linked, two free state machines and 7 instructions of space on one PIO
+		block, and a DMA channel; otherwise the interrupt sets the mux as before.
+	*/
+	void EnableMuxSequencer() {useMuxSequencer = true;}
+
+	/** \brief Use before Run() to generate timed pulses with PIO, for PulseOutTrigger and PulseOutBurst
+
+		Two PIO state machines drive the pulse outputs, timing each pulse to the processor
+		cycle rather than to the sample. Needs hardware_pio linked, and two free state
+		machines and 16 instructions of space on one PIO block; otherwise the scheduling
+		functions do nothing.
+	*/
+	void EnablePulseEngine() {usePulseEngine = true;}
+
+	/** \brief Use before Run(), or while running, to lead a group of Computers sharing one sample clock, sending it on pulse output i
+
+		The output goes high every period samples (rounded up to a whole number of blocks, at
+		least two) and low halfway through, timed by this card's sample clock, as a word clock
+		for the pulse inputs of the followers (EnableSyncFollow). The card should then not use
+		the output itself. SyncFrame counts samples alike on every card of the group.
+	*/
+	void EnableSyncLead(int i = 0, int32_t period = 48)
+	{
+		syncMode = SyncOff;
+		syncPin = i ? 1 : 0;
+		syncPeriod = period;
+		SetupSync();
+		syncMode = SyncLead;
+	}
+
+	/** \brief Use before Run(), or while running, to follow the sample clock of a leader (EnableSyncLead) patched to pulse input i
+
+		Each rising edge is compared with SyncFrame. The first, or one more than two samples
+		out, resets SyncFrame to the leader's count (modulo period, which must be the leader's).
+		Otherwise a phase-locked loop, with a bandwidth of about 0.5Hz, trims the ADC clock
+		divider, and so the sample rate, by up to 1000ppm, to keep the edges on multiples of
+		period. The divider's steps of about 30ppm are dithered from one sample (or block) to
+		the next. With EnablePulseCapture, edges are timed to a fraction of a sample; without
+		it, only to the sample (or block), which the phase then wanders within. If the edges
+		stop, the sample rate keeps its last trim until they return. See SyncStatus.
+	*/
+	void EnableSyncFollow(int i = 0, int32_t period = 48)
+	{
+		syncMode = SyncOff;
+		syncPin = i ? 1 : 0;
+		syncPeriod = period;
+		SetupSync();
+		syncMode = SyncFollow;
+	}
+
+	/// SampleCounter, shared by a sync group: the leader's own, and matched to it on followers. Without sync, the same as SampleCounter
+	uint32_t __not_in_flash_func(SyncFrame)() {return callbackFrame + syncOffset;}
+
+	/// With EnableSyncFollow, return the phase-locked loop's state
+	SyncStats SyncStatus()
+	{
+		SyncStats ss;
+		ss.locked = syncGood >= 16;
+		ss.phaseError = syncPhase;
+		ss.trimPPM = int32_t((int64_t(syncTrim) * 1000000) / (int64_t(syncADCInterval) << 24));
+		ss.realigns = syncRealigns;
+		return ss;
+	}
+
+	/** \brief Use before Run() to stream audio to and from another Computer over the debug pins
+
+		With COMPUTERCARD_LINK defined as the number of channels (1 to 4), each ProcessSample or
+		ProcessBlock call sends a frame of LinkOut samples and a LinkControlOut word on DEBUG_1,
+		and plays one received on DEBUG_2 through LinkIn and LinkControlIn. Cross the two cards'
+		DEBUG_1 and DEBUG_2 over, and connect their grounds; both must have the same number of
+		channels and block size.
+
+		The frames are sent as serial words at 12Mbit/s by a PIO state machine, and received by
+		another into an SRAM ring, both by DMA, with a checksum and sequence number. Received
+		frames queue behind the one playing, which is latency frames (samples or blocks) plus
+		one behind the other card's sending, a fixed delay while the two sample clocks are held
+		together (EnableSyncFollow). Otherwise, a frame is dropped or missed every few seconds,
+		counted as a slip. Needs hardware_pio, two free state machines and 14 instructions of
+		space on one PIO block, two DMA channels, and a system clock of at least 96MHz; the debug
+		pins can't then be used otherwise (e.g. with ENABLE_UART_DEBUGGING).
+	*/
+	void EnableAudioLink(int latency = 2)
+	{
+#ifdef COMPUTERCARD_LINK
+		linkLatency = latency < 1 ? 1 : (latency > 4 ? 4 : latency);
+		useAudioLink = true;
+#else
+		(void)latency;
+#endif
+	}
+
+	/// With EnableAudioLink, send val on link channel ch (0 to COMPUTERCARD_LINK - 1); in block mode, for the given frame
+	void __not_in_flash_func(LinkOut)(int ch, int16_t val, int frame = 0)
+	{
+#ifdef COMPUTERCARD_LINK
+		uint32_t &w = linkTxWrite[2 + frame * linkFrameStride + (ch >> 1)];
+		w = (ch & 1) ? (w & 0xFFFFu) | (uint32_t(uint16_t(val)) << 16) : (w & 0xFFFF0000u) | uint16_t(val);
+#else
+		(void)ch; (void)val; (void)frame;
+#endif
+	}
+
+	/// With EnableAudioLink, the sample received on link channel ch; in block mode, for the given frame. Zero while not connected
+	int16_t __not_in_flash_func(LinkIn)(int ch, int frame = 0)
+	{
+#ifdef COMPUTERCARD_LINK
+		if (!linkConnected) return 0;
+		uint32_t w = linkRing[(linkPlaying + 2 + uint32_t(frame * linkFrameStride + (ch >> 1))) & (linkRingWords - 1)];
+		return int16_t((ch & 1) ? (w >> 16) : (w & 0xFFFFu));
+#else
+		(void)ch; (void)frame;
+		return 0;
+#endif
+	}
+
+	/// With EnableAudioLink, send a word of control data along with this sample (or block)
+	void __not_in_flash_func(LinkControlOut)(uint32_t val)
+	{
+#ifdef COMPUTERCARD_LINK
+		linkTxWrite[1] = val;
+#else
+		(void)val;
+#endif
+	}
+
+	/// With EnableAudioLink, the control word received with this sample (or block). Zero while not connected
+	uint32_t __not_in_flash_func(LinkControlIn)()
+	{
+#ifdef COMPUTERCARD_LINK
+		return linkConnected ? linkRing[(linkPlaying + 1) & (linkRingWords - 1)] : 0;
+#else
+		return 0;
+#endif
+	}
+
+	/// With EnableAudioLink, return the link's state
+	LinkStats LinkStatus()
+	{
+		LinkStats ls = {};
+#ifdef COMPUTERCARD_LINK
+		ls.connected = linkConnected;
+		ls.frames = linkFrames;
+		ls.errors = linkErrors;
+		ls.slips = linkSlips;
+		ls.queued = linkQueued;
+#endif
+		return ls;
+	}
+
+	/** \brief Measure the latency from audio output out, through a patch cable, to audio input in
+
+		Takes over audio output out for a quarter of a second (up to a second with the largest
+		blocks), playing eight steps of half full scale, each held for a few blocks. Each step's
+		arrival on audio input in is timed where it crosses half its height, to a fraction of
+		a sample. A first step only measures that height, so a cable through an attenuator or
+		inverter still works. The result, from LatencyStatus, is the time from a sample set by
+		AudioOut (or in ProcessBlock's out) to its return in AudioIn (or in), including the DAC,
+		the ADC, both DMA buffers and the block size, for the current configuration and sample
+		rate. Can be called while running, e.g. from ProcessSample.
+	*/
+	void MeasureLatency(int out = 0, int in = 0)
+	{
+		StartLatency(LatencyLoopback, out, in);
+	}
+
+	/** \brief Measure the latency of audio input in alone, with the normalisation probe
+
+		As MeasureLatency, with nothing patched into audio input in: the steps are set on the
+		normalisation probe by a callback, rather than on an output. The result is the age of
+		a callback's input (the first sample of its block) as it runs, so the output's share
+		of MeasureLatency's result is the difference. Not
+		with EnableNormalisationProbe, which zeroes unpatched inputs; the measurement then
+		finishes at once, with nothing found.
+	*/
+	void MeasureInputLatency(int in = 0)
+	{
+		StartLatency(LatencyProbe, 0, in);
+	}
+
+	/// Return the result of the last MeasureLatency or MeasureInputLatency
+	LatencyStats LatencyStatus()
+	{
+		LatencyStats ls = latencyResult;
+		ls.done = ls.done && latencyMode == LatencyIdle;
+		return ls;
+	}
+
+	/** \brief Use before Run() to play audio on the two pulse outputs, set with PulseAudioOut
+
+		The pulse outputs become 8-bit PWM outputs, with a carrier of the system clock / 256
+		(488kHz at 125MHz), for a smoothing filter or an input that filters enough itself.
+		In block mode, levels for the whole block are streamed out by DMA, one per frame, in
+		step with the audio outputs. PulseOut and EnablePulseEngine then have no effect.
+	*/
+	void EnablePulseAudio() {usePulseAudio = true;}
+
+	/** \brief Use before Run() to drive the LEDs from a frame buffer, refreshed refreshHz times a second
+
+		LedBrightness, LedOn and LedOff then only store the new level, and all six LEDs are
+		updated together, through a gamma table, from the audio interrupt. LedFade and
+		LedMeter animations are worked out at the same rate, rather than in ProcessSample.
+	*/
+	void EnableLedEngine(int32_t refreshHz = 200)
+	{
+		useLedEngine = true;
+		ledRefreshHz = refreshHz < 1 ? 1 : refreshHz;
+	}
+
+	/** \brief Use before Run() to save power on cards that do little work per sample
+
+		Run() lowers the system clock to sysClockKHz (if achievable, otherwise the clock is
+		left unchanged), and sleeps the audio core with WFI between interrupts. The sample
+		rate is unaffected, as the ADC is clocked from the 48MHz USB PLL; the DAC SPI clock
+		is recalculated. The CV output PWM carrier falls in proportion to the system clock
+		(to 23kHz at 48MHz), so EnableCVOutputDMA is recommended alongside.
+		DutyPercent() reports the fraction of time the audio core is awake.
+	*/
+	void EnableLowPower(uint32_t sysClockKHz = 48000) {lowPowerKHz = sysClockKHz;}
+
+	/// With EnableLowPower, return the percentage of time the audio core spent awake (in interrupts) over the last ~1/8 second
+	int32_t DutyPercent() {return dutyPercent;}
+
+	/// Return load meter statistics collected since Run() or the last ResetLoadMeter()
+	LoadStats LoadMeter()
+	{
+		LoadStats ls;
+		ls.minCycles = loadMinCycles;
+		ls.avgCycles = loadAvgCycles8 >> 8;
+		ls.maxCycles = loadMaxCycles;
+		ls.budgetCycles = loadBudgetCycles;
+		ls.overruns = loadOverruns;
+		return ls;
+	}
+
+	/// Return average CPU load of ProcessSample/ProcessBlock, as percentage of time available
+	int32_t LoadPercent()
+	{
+		return loadBudgetCycles ? int32_t(((loadAvgCycles8 >> 8) * 100) / loadBudgetCycles) : 0;
+	}
+
+	/// Return number of deadline overruns since Run() or the last ResetLoadMeter()
+	uint32_t OverrunCount() {return loadOverruns;}
+
+	/// Clear minimum, maximum and overrun count of the load meter
+	void ResetLoadMeter()
+	{
+		loadMinCycles = 0xFFFFFFFF;
+		loadMaxCycles = 0;
+		loadOverruns = 0;
+		qualityOverruns = 0;
+	}
+
+	/** \brief Use before Run() to lower the card's quality when it runs short of time, and raise it again when there is room
+
+		The card offers levels quality levels (e.g. numbers of voices), and reads the one to use
+		from QualityLevel(), from levels - 1 (best, at startup) down to 0 (cheapest). The load
+		meter (turned on by this) is averaged over each windowMs: if any call overran, or the load
+		was above downPercent, the level drops by one; once the load has stayed below upPercent for
+		holdWindows windows in a row, it rises by one.
+	*/
+	void EnableAutoQuality(int32_t levels, int32_t downPercent = 90, int32_t upPercent = 60, int32_t windowMs = 100, int32_t holdWindows = 10)
+	{
+		useLoadMeter = true;
+		qualityLevels = levels < 1 ? 1 : levels;
+		qualityLevel = qualityLevels - 1;
+		qualityDownPercent = downPercent;
+		qualityUpPercent = upPercent < downPercent ? upPercent : downPercent;
+		qualityWindowMs = windowMs < 1 ? 1 : (windowMs > 1000 ? 1000 : windowMs);
+		qualityHold = holdWindows < 1 ? 1 : holdWindows;
+	}
+
+	/// With EnableAutoQuality, the quality level to run at, from levels - 1 (best) down to 0
+	int32_t __not_in_flash_func(QualityLevel)() const {return qualityLevel;}
+
+	/** \brief Events recorded by Trace
+
+		Each is an instant, or the begin or end of a span if or'd with TraceBegin or TraceEnd.
+		Cards' own events are TraceUser and above, up to TraceUser + 31.
+	*/
+	enum TraceEvent : uint8_t
+	{
+		TraceAudio,     ///< Span: audio interrupt (BufferFull/BlockFull)
+		TraceOverrun,   ///< Instant: the next sample or block was ready before the audio interrupt finished (with the load meter)
+		TraceCVPWMWrap, ///< Instant: CV output PWM interrupt; masked by default, as it runs at ~100kHz
+		TraceFlash,     ///< Span: flash erase or program, interrupts disabled; arg = flash offset / 4096
+		TraceUser = 32,
+		TraceBegin = 0x40,
+		TraceEnd = 0x80
+	};
+
+	/// One traced event
+	struct TraceRecord
+	{
+		uint32_t time;  ///< µs since reset (time_us_32)
+		uint8_t event;  ///< TraceEvent, with TraceBegin or TraceEnd
+		uint8_t core;
+		uint16_t arg;
+	};
+
+	/** \brief Record an event, from either core, in or out of interrupts
+
+		With COMPUTERCARD_TRACE defined, ComputerCard traces the audio interrupt, overruns, the CV
+		PWM interrupt and flash writes; cards add their own, e.g. around tud_task():
+
+			Trace(TraceUser | TraceBegin);
+			tud_task();
+			Trace(TraceUser | TraceEnd);
+
+		Each core writes only its own ring, with interrupts briefly disabled, so no locks are needed.
+	*/
+	static void __not_in_flash_func(Trace)(uint8_t event, uint16_t arg = 0)
+	{
+#ifdef COMPUTERCARD_TRACE
+		uint8_t id = event & 0x3F;
+		if (tracePaused || (id < TraceUser && !(traceMask & (1u << id)))) return;
+		uint32_t core = get_core_num();
+		TraceRing &r = traceRings[core];
+		uint32_t ints = save_and_disable_interrupts();
+		TraceRecord &rec = r.records[r.head & (COMPUTERCARD_TRACE - 1)];
+		rec.time = timer_hw->timerawl;
+		rec.event = event;
+		rec.core = uint8_t(core);
+		rec.arg = arg;
+		r.head++;
+		restore_interrupts(ints);
+#else
+		(void)event;
+		(void)arg;
+#endif
+	}
+
+	/// Choose which of ComputerCard's own events are traced, one bit per TraceEvent (default all but TraceCVPWMWrap)
+	static void SetTraceMask(uint32_t mask) {traceMask = mask;}
+
+	/** \brief Copy up to max recorded events into out, oldest first, with both cores merged in time order
+
+		Tracing pauses while the rings are read. Returns the number of events copied.
+	*/
+	static unsigned TraceSnapshot(TraceRecord *out, unsigned max)
+	{
+		unsigned n = 0;
+		TraceForEach([&](const TraceRecord &r) {if (n < max) out[n++] = r;});
+		return n;
+	}
+
+	/** \brief Write the recorded events as Chrome trace event JSON, for chrome://tracing or ui.perfetto.dev
+
+		write(const char *s, int n) is called with each piece, e.g. stdio_usb.out_chars to send
+		the trace over USB serial, to be saved to a .json file and loaded into the viewer. Each
+		core is one thread of the timeline. Tracing pauses while the rings are read.
+	*/
+	template <typename Write>
+	static void TraceWriteJSON(Write write)
+	{
+		static const char *const names[] = {"audio", "overrun", "cv pwm", "flash"};
+		const char header[] = "{\"traceEvents\":[\n";
+		write(header, int(sizeof(header) - 1));
+		bool first = true;
+		TraceForEach([&](const TraceRecord &r) {
+			char line[128];
+			char *p = line;
+			auto put = [&](const char *s) {while (*s) *p++ = *s++;};
+			auto putU = [&](uint32_t v) {
+				char digits[10];
+				int k = 0;
+				do {digits[k++] = char('0' + v % 10); v /= 10;} while (v);
+				while (k) *p++ = digits[--k];
+			};
+			uint8_t id = r.event & 0x3F;
+			if (!first) put(",\n");
+			first = false;
+			put("{\"name\":\"");
+			if (id < sizeof(names) / sizeof(names[0])) put(names[id]);
+			else if (id >= TraceUser) {put("user "); putU(id - TraceUser);}
+			else {put("event "); putU(id);}
+			put("\",\"ph\":\"");
+			put((r.event & TraceBegin) ? "B" : (r.event & TraceEnd) ? "E" : "i\",\"s\":\"t");
+			put("\",\"ts\":");
+			putU(r.time);
+			put(",\"pid\":0,\"tid\":");
+			putU(r.core);
+			put(",\"args\":{\"arg\":");
+			putU(r.arg);
+			put("}}");
+			write(line, int(p - line));
+		});
+		const char footer[] = "\n]}\n";
+		write(footer, int(sizeof(footer) - 1));
+	}
+
+	/** \brief Write the recorded control inputs as text, for the host backend to replay
+
+		With COMPUTERCARD_RECORD defined, each ProcessSample or ProcessBlock call records the
+		knobs, switch, CV and pulse inputs, and which jacks are connected, as the changes since
+		the last call; when the ring is full, the oldest quarter-kilobyte is overwritten. Still
+		controls cost nothing, but ADC noise on a knob or CV can change it every few samples,
+		so EnableAdaptiveSmoothing makes the same ring last much longer.
+
+		write(const char *s, int n) is called with each piece, e.g. stdio_usb.out_chars, to be
+		saved to a file and rendered by the host backend with COMPUTERCARD_REPLAY set to it,
+		along with a recording of the audio inputs, if the card uses them. Recording pauses
+		while the ring is read. Pulse edge times from EnablePulseCapture are not recorded.
+	*/
+	template <typename Write>
+	void RecordingWrite(Write write)
+	{
+#ifdef COMPUTERCARD_RECORD
+		char line[72];
+		char *p = line;
+		auto put = [&](const char *s) {while (*s) *p++ = *s++;};
+		auto putU = [&](uint32_t v) {
+			char digits[10];
+			int k = 0;
+			do {digits[k++] = char('0' + v % 10); v /= 10;} while (v);
+			while (k) *p++ = digits[--k];
+		};
+		put("# ComputerCard control recording, for COMPUTERCARD_REPLAY\nCCREC ");
+		write(line, int(p - line));
+		p = line;
+		putU(uint32_t(sampleRate));
+		put(" ");
+		putU(uint32_t(blockSize));
+		put(" ");
+		putU(callbackFrame + blockSize); // frames played, for the length of the replay
+		put("\n");
+		write(line, int(p - line));
+
+		recordPaused = true;
+		busy_wait_us_32(5); // let a record being written on the other core finish
+		static const char hex[] = "0123456789abcdef";
+		uint32_t first = recordPages > recordNumPages ? recordPages - recordNumPages : 0;
+		for (uint32_t page = first; page < recordPages; page++)
+		{
+			const uint8_t *b = recordRing + (page & (recordNumPages - 1)) * recordPageSize;
+			for (int i=0; i<recordPageSize; i+=32)
+			{
+				p = line;
+				for (int j=0; j<32; j++)
+				{
+					*p++ = hex[b[i + j] >> 4];
+					*p++ = hex[b[i + j] & 15];
+				}
+				*p++ = '\n';
+				write(line, int(p - line));
+			}
+		}
+		recordResync = true;
+		recordPaused = false;
+#else
+		(void)write;
+#endif
+	}
+
+	/// Discard the recorded control inputs, starting the recording again from the next sample or block
+	void RecordingClear()
+	{
+#ifdef COMPUTERCARD_RECORD
+		recordPaused = true;
+		busy_wait_us_32(5);
+		recordPages = 0;
+		recordResync = true;
+		recordPaused = false;
+#endif
+	}
+
+	/// Buckets of SoakStats::histogram: sixteen of 1/16 of the budget each, and a last for calls over budget
+	static constexpr int soakBuckets = 17;
+
+	/// One soak test run, see COMPUTERCARD_SOAK
+	struct SoakStats
+	{
+		uint32_t seconds;       ///< Length of the run, in seconds of audio
+		uint32_t overruns;      ///< Calls that did not finish before the next sample/block was ready
+		uint32_t firstOverrun;  ///< Second of the run at which the first overrun happened
+		uint32_t lastOverrun;   ///< Second of the run at which the last overrun happened
+		uint32_t maxCycles;     ///< Longest ProcessSample/ProcessBlock call, in CPU cycles
+		uint32_t budgetCycles;  ///< CPU cycles available per call
+		uint32_t midiQueued;    ///< MIDI messages queued by the stress generator
+		uint32_t midiDropped;   ///< MIDI messages the stress generator found no room for
+		uint32_t jackChanges;   ///< Jacks plugged or unplugged by the stress generator
+		uint32_t histogram[soakBuckets]; ///< Calls by length, in 1/16ths of budgetCycles
+	};
+
+	/// With COMPUTERCARD_SOAK, the soak test run since Run()
+	SoakStats SoakThisRun()
+	{
+#ifdef COMPUTERCARD_SOAK
+		return soakRecord.run;
+#else
+		return SoakStats{};
+#endif
+	}
+
+	/// With COMPUTERCARD_SOAK, the run before this boot (seconds is 0 if there was none)
+	SoakStats SoakLastRun()
+	{
+#ifdef COMPUTERCARD_SOAK
+		return soakLast;
+#else
+		return SoakStats{};
+#endif
+	}
+
+	/// With COMPUTERCARD_SOAK, the longest run saved (seconds is 0 if there was none)
+	SoakStats SoakLongestRun()
+	{
+#ifdef COMPUTERCARD_SOAK
+		return soakRecord.longest;
+#else
+		return SoakStats{};
+#endif
+	}
+
+	/// With COMPUTERCARD_SOAK, forget the longest run, from the next save
+	void SoakClear()
+	{
+#ifdef COMPUTERCARD_SOAK
+		soakClear = true;
+#endif
+	}
+
+	/** \brief Write the soak test report as text: this run, the last, and the longest
+
+		write(const char *s, int n) is called with each piece, e.g. stdio_usb.out_chars. Each run
+		is reported as its length, overruns, longest call and what the stress generator did,
+		followed by the number of calls in each sixteenth of the time available per call.
+	*/
+	template <typename Write>
+	void SoakReportWrite(Write write)
+	{
+#ifdef COMPUTERCARD_SOAK
+		char line[200];
+		char *p = line;
+		auto put = [&](const char *s) {while (*s) *p++ = *s++;};
+		auto putU = [&](uint32_t v) {
+			char digits[10];
+			int k = 0;
+			do {digits[k++] = char('0' + v % 10); v /= 10;} while (v);
+			while (k) *p++ = digits[--k];
+		};
+		auto run = [&](const char *name, const SoakStats &s) {
+			p = line;
+			put(name);
+			putU(s.seconds);
+			put("s, ");
+			putU(s.overruns);
+			put(" overruns");
+			if (s.overruns)
+			{
+				put(" (");
+				putU(s.firstOverrun);
+				put("s to ");
+				putU(s.lastOverrun);
+				put("s)");
+			}
+			put(", longest call ");
+			putU(s.budgetCycles ? uint32_t((uint64_t(s.maxCycles) * 100) / s.budgetCycles) : 0);
+			put("%, ");
+			putU(s.midiQueued);
+			put(" MIDI (");
+			putU(s.midiDropped);
+			put(" dropped), ");
+			putU(s.jackChanges);
+			put(" jack changes\n");
+			write(line, int(p - line));
+			p = line;
+			put("  load");
+			for (int i=0; i<soakBuckets; i++)
+			{
+				put(i == soakBuckets - 1 ? " | " : " ");
+				putU(s.histogram[i]);
+			}
+			put("\n");
+			write(line, int(p - line));
+		};
+		SoakStats current = soakRecord.run;
+		run("this run: ", current);
+		if (soakLast.seconds) run("last run: ", soakLast);
+		if (soakRecord.longest.seconds) run("longest:  ", soakRecord.longest);
+#else
+		(void)write;
+#endif
+	}
+
+	/** \brief With COMPUTERCARD_SOAK, write the soak test record to flash, when due
+
+		Call regularly from the core that is not running the audio, if the card runs its own
+		loop there with RunOnCore1. Cards that leave core 1 free, or run it with
+		RunCore1Tasks, need not: ComputerCard calls it from there.
+	*/
+	void SoakService()
+	{
+#ifdef COMPUTERCARD_SOAK
+		soakStore.Service();
+#endif
+	}
+
+	/// SRAM and flash cache use, returned by MemoryUsage
+	struct MemoryStats
+	{
+		uint32_t stackUsed[2]; ///< Deepest use of each core's stack since it was painted, in bytes (0 if not painted)
+		uint32_t stackSize[2]; ///< Size of each core's stack, in bytes
+		uint32_t staticBytes;  ///< SRAM below the heap: data, bss, and code when run from SRAM
+		uint32_t heapPeak;     ///< Most heap ever taken from SRAM, in bytes (freed memory stays with malloc)
+		uint32_t heapInUse;    ///< Heap currently allocated
+		uint32_t heapFree;     ///< SRAM still free for the heap to grow into
+		uint32_t xipAccesses;  ///< Flash (XIP) cache accesses since ResetXIPCounters
+		uint32_t xipHits;      ///< Of which were cache hits
+	};
+
+	/** \brief Return stack, heap and XIP cache use, e.g. to print or send as Telemetry channels
+
+		The free part of the constructing core's stack is painted with a pattern by ComputerCard's
+		constructor, and core 1's by RunOnCore1 (or PaintCore1Stack, before launching core 1 another
+		way), so stackUsed is the deepest either has reached since. The heap figures come from
+		mallinfo, so cover every allocation without hooks into malloc (with COMPUTERCARD_NO_HEAP,
+		they are zero, and heapFree is all the SRAM between static data and the stack).
+	*/
+	static MemoryStats MemoryUsage();
+
+	/// Paint core 1's stack, for MemoryUsage. Only call before core 1 is launched
+	static void PaintCore1Stack();
+
+	/// Clear the XIP cache access and hit counters
+	static void ResetXIPCounters() {xip_ctrl_hw->ctr_acc = 0; xip_ctrl_hw->ctr_hit = 0;}
+
+	/// Run-time statistics of one core 1 task, see AddCore1Task
+	struct TaskStats
+	{
+		uint32_t runs;      ///< Number of runs
+		uint32_t totalUs;   ///< Total run time, in µs
+		uint32_t maxUs;     ///< Longest run, in µs
+		uint32_t late;      ///< Runs started more than the task's deadline after they were due
+		uint32_t maxLateUs; ///< Latest start, in µs after due
+	};
+
+	static constexpr int maxCore1Tasks = 8;
+
+	/** \brief Add a task to the core 1 scheduler, started by RunCore1Tasks
+
+		Tasks run to completion, one at a time, on core 1 (or core 0, with EnableAudioOnCore1):
+		USB, UI, flash saves, telemetry and so on, each in its own member function, rather than
+		one hand-written loop. A task is due
+		every periodUs, or always if periodUs is 0. Of the tasks due, the highest priority runs;
+		among equal priorities, the one due longest, so that background tasks take turns. A run
+		is counted late if it starts more than deadlineUs after it was due (by default, one
+		period). A task that falls more than a period behind skips the runs it missed. Each task
+		should do a slice of work and return, so that it does not hold up the others.
+		Returns the task's index, or -1 if there are already maxCore1Tasks.
+	*/
+	template <class C>
+	int AddCore1Task(void (C::*fn)(), uint32_t periodUs, int priority = 0, uint32_t deadlineUs = 0)
+	{
+		if (numCore1Tasks >= maxCore1Tasks) return -1;
+		Core1Task &t = core1Tasks[numCore1Tasks];
+		t.fn = static_cast<Core1TaskFn>(fn);
+		t.period = periodUs;
+		t.deadline = deadlineUs ? deadlineUs : periodUs;
+		t.priority = priority;
+		t.stats = TaskStats();
+		return numCore1Tasks++;
+	}
+
+	/// Statistics of core 1 task i (the index returned by AddCore1Task)
+	TaskStats Core1TaskStats(int i) const {return core1Tasks[i].stats;}
+
+	/// Return index of the first frame of the current ProcessSample/ProcessBlock call, counting from 0 at Run()
+	uint32_t __not_in_flash_func(SampleCounter)() const {return callbackFrame;}
+
+	/** \brief Queue a MIDI message (not sysex) for ProcessMIDI, from the USB core
+
+		The message is stamped with the frame being processed when it arrives (to the nearest
+		sample, also in block mode), and passed to ProcessMIDI by PollMIDIEvents a fixed latency
+		(see SetMIDILatency) later, so that its timing relative to other messages is kept
+		however irregularly the USB loop runs. Call from one core/context only.
+		Returns false if the queue is full or the message is not 1 to 3 bytes long.
+	*/
+	bool QueueMIDI(const uint8_t *msg, int length, uint8_t cable = 0)
+	{
+		if (length < 1 || length > 3) return false;
+#ifdef COMPUTERCARD_SOAK
+		return true; // the stress generator is the only source of MIDI
+#endif
+		MIDIEvent e;
+		e.sample = MIDIArrivalFrame();
+		e.cable = cable;
+		e.length = uint8_t(length);
+		for (int i=0; i<3; i++) e.data[i] = (i < length) ? msg[i] : 0;
+		return midiQueue.Push(e);
+	}
+
+	/** \brief Queue all MIDI messages in a byte stream, e.g. from tud_midi_stream_read/tuh_midi_stream_read
+
+		Messages are split at status bytes, with running status; sysex is skipped.
+		Returns the number of messages queued.
+	*/
+	int QueueMIDIStream(const uint8_t *bytes, int n, uint8_t cable = 0)
+	{
+		int queued = 0;
+		for (int i=0; i<n; i++)
+		{
+			uint8_t b = bytes[i];
+			if (b >= 0xF8) // Real-time messages can appear anywhere, even within sysex
+			{
+				queued += QueueMIDI(&b, 1, cable);
+				continue;
+			}
+			if (b & 0x80)
+			{
+				midiStreamInSysex = (b == 0xF0);
+				midiStreamStatus = (b < 0xF0) ? b : 0; // System common messages cancel running status
+				if (b >= 0xF0)
+				{
+					int len = MIDIMessageLength(b);
+					if (len == 1) queued += QueueMIDI(&b, 1, cable);
+					else if (len > 1 && i + len <= n) queued += QueueMIDI(&bytes[i], len, cable);
+					if (len > 1) i += len - 1;
+					continue;
+				}
+				i++; // first data byte
+			}
+			else if (midiStreamInSysex || !midiStreamStatus)
+			{
+				continue; // sysex data, or data with no status
+			}
+
+			// Channel voice message: running status, then one or two data bytes from bytes[i]
+			int len = MIDIMessageLength(midiStreamStatus);
+			if (i + len - 1 > n) break;
+			uint8_t msg[3] = {midiStreamStatus, (len > 1) ? bytes[i] : uint8_t(0), (len > 2) ? bytes[i+1] : uint8_t(0)};
+			queued += QueueMIDI(msg, len, cable);
+			i += len - 2;
+		}
+		return queued;
+	}
+
+	/** \brief Queue the MIDI messages (not sysex) in n 4-byte USB-MIDI event packets
+
+		For parsing packets in place, e.g. from tuh_midi_rx_packets_cb (see usb_midi_host/)
+		or tud_midi_packet_read. Each packet holds one complete message, with its cable number.
+		Returns the number of messages queued.
+	*/
+	int QueueMIDIPackets(const uint8_t *packets, int n)
+	{
+		int queued = 0;
+		for (int i=0; i<n; i++, packets += 4)
+		{
+			uint8_t cin = packets[0] & 0x0F;
+			if (cin < 0x2 || cin == 0x4 || cin == 0x6 || cin == 0x7) continue; // padding, reserved or sysex
+			if (!(packets[1] & 0x80)) continue;
+			int len = MIDIMessageLength(packets[1]); // 0 for sysex start/end
+			if (len > 0) queued += QueueMIDI(packets + 1, len, packets[0] >> 4);
+		}
+		return queued;
+	}
+
+	/** \brief Use to set the delay (in samples) from a MIDI message arriving to it being passed to ProcessMIDI
+
+		Should be at least the jitter of the USB loop, plus one block in block mode;
+		the default is 1ms plus one block.
+	*/
+	void SetMIDILatency(uint32_t samples) {midiLatency = samples;}
+
+	/** \brief Pass queued MIDI messages that are due by frame sampleIndex to ProcessMIDI
+
+		Call from ProcessSample with SampleCounter(), or from ProcessBlock with
+		SampleCounter() + i before processing frame i.
+	*/
+	void __not_in_flash_func(PollMIDIEvents)(uint32_t sampleIndex)
+	{
+		MIDIEvent e;
+		while (midiQueue.Peek(e) && int32_t(sampleIndex - (e.sample + midiLatency)) >= 0)
+		{
+			midiQueue.Pop(e);
+			ProcessMIDI(e);
+		}
+	}
+	
+	static ComputerCard *ThisPtr() {return thisptr;}
+
+	/** \brief Lock-free single-producer, single-consumer ring buffer
+
+		For passing data between cores, or between ProcessSample and the main loop,
+		without blocking. Exactly one core/context may call Push, and one Pop.
+		Holds up to N items of type T, with N a power of two.
+	*/
+	template <typename T, unsigned N>
+	class Ring
+	{
+		static_assert(N > 0 && (N & (N - 1)) == 0, "Ring size must be a power of two");
+	public:
+		Ring() : head(0), tail(0) {}
+
+		/// Add an item, returning false (and not blocking) if the ring is full
+		bool __not_in_flash_func(Push)(const T &val)
+		{
+			uint32_t h = head;
+			if (h - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) == N) return false;
+			buf[h & (N - 1)] = val;
+			__atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		/// Remove the oldest item into val, returning false if the ring is empty
+		bool __not_in_flash_func(Pop)(T &val)
+		{
+			uint32_t t = tail;
+			if (__atomic_load_n(&head, __ATOMIC_ACQUIRE) == t) return false;
+			val = buf[t & (N - 1)];
+			__atomic_store_n(&tail, t + 1, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		/// Copy the oldest item into val without removing it (consumer only), returning false if the ring is empty
+		bool __not_in_flash_func(Peek)(T &val) const
+		{
+			uint32_t t = tail;
+			if (__atomic_load_n(&head, __ATOMIC_ACQUIRE) == t) return false;
+			val = buf[t & (N - 1)];
+			return true;
+		}
+
+		/// Number of items waiting to be popped
+		unsigned __not_in_flash_func(Size)() const {return __atomic_load_n(&head, __ATOMIC_ACQUIRE) - __atomic_load_n(&tail, __ATOMIC_ACQUIRE);}
+		/// Number of items that can be pushed before the ring is full
+		unsigned __not_in_flash_func(Free)() const {return N - Size();}
+		bool Empty() const {return Size() == 0;}
+		bool Full() const {return Size() == N;}
+
+	private:
+		// Head is only written by the producer and tail only by the consumer.
+		// Consecutive words are in different striped SRAM banks, so the two cores don't contend.
+		uint32_t head;
+		uint32_t tail;
+		T buf[N];
+	};
+
+#ifdef COMPUTERCARD_HAS_COROUTINES
+	/** \brief Timed and clocked sequences written as C++20 coroutines
+
+		A sequence is a card member function returning Sequencer::Task, which waits with
+		co_await Sequencer::Samples(n) (resume n ticks later) or co_await Sequencer::NextClock(ch)
+		(resume at the next Clock(ch) call), rather than a state machine polled every sample:
+
+			Sequencer::Task Ratchet()
+			{
+				while (true)
+				{
+					co_await Sequencer::NextClock();
+					for (int i=0; i<3; i++)
+					{
+						PulseOut1(true);
+						co_await Sequencer::Samples(100);
+						PulseOut1(false);
+						co_await Sequencer::Samples(1900);
+					}
+				}
+			}
+
+		Start it with seq.Start(Ratchet()), e.g. in the card's constructor. This allocates the
+		coroutine's frame, so should not be done from ProcessSample. Then call seq.Tick() each
+		sample (or seq.Tick(n) each block of n frames), and seq.Clock(ch) for each clock. Sleeping
+		sequences are kept in wake order, so Tick costs one comparison until one is due. Tick and
+		Clock resume sequences in whichever context they are called from. A sequence that
+		returns frees its frame there too, so sequences usually loop forever. Needs C++20.
+	*/
+	class Sequencer
+	{
+	public:
+		static constexpr int numClocks = 4;
+
+		struct Task
+		{
+			struct promise_type
+			{
+				Sequencer *seq = nullptr;
+				uint32_t wake = 0;
+				promise_type *next = nullptr;
+
+				Task get_return_object() {return Task{std::coroutine_handle<promise_type>::from_promise(*this)};}
+				std::suspend_always initial_suspend() noexcept {return {};}
+				std::suspend_never final_suspend() noexcept {return {};}
+				void return_void() {}
+				void unhandled_exception() {}
+			};
+			std::coroutine_handle<promise_type> handle;
+		};
+		using Handle = std::coroutine_handle<Task::promise_type>;
+
+		/// Wait n ticks
+		struct Samples
+		{
+			uint32_t n;
+			explicit Samples(uint32_t ticks) : n(ticks) {}
+			bool await_ready() const {return n == 0;}
+			void await_suspend(Handle h) {h.promise().seq->Sleep(h.promise(), n);}
+			void await_resume() {}
+		};
+
+		/// Wait for the next Clock(ch)
+		struct NextClock
+		{
+			int ch;
+			explicit NextClock(int channel = 0) : ch(channel) {}
+			bool await_ready() const {return false;}
+			void await_suspend(Handle h)
+			{
+				Task::promise_type &p = h.promise();
+				p.next = p.seq->clockWaiters[ch];
+				p.seq->clockWaiters[ch] = &p;
+			}
+			void await_resume() {}
+		};
+
+		Sequencer() : now(0), sleepers(nullptr)
+		{
+			for (int i=0; i<numClocks; i++) clockWaiters[i] = nullptr;
+		}
+
+		/// Run a sequence until its first co_await
+		void Start(Task t)
+		{
+			t.handle.promise().seq = this;
+			t.handle.resume();
+		}
+
+		/// Advance time by n ticks, resuming the sequences now due
+		void __not_in_flash_func(Tick)(uint32_t n = 1)
+		{
+			now += n;
+			while (sleepers && int32_t(now - sleepers->wake) >= 0)
+			{
+				Task::promise_type *p = sleepers;
+				sleepers = p->next;
+				Handle::from_promise(*p).resume();
+			}
+		}
+
+		/// Resume the sequences waiting for clock ch
+		void __not_in_flash_func(Clock)(int ch = 0)
+		{
+			Task::promise_type *p = clockWaiters[ch];
+			clockWaiters[ch] = nullptr; // sequences resumed here wait for the next Clock
+			while (p)
+			{
+				Task::promise_type *next = p->next;
+				Handle::from_promise(*p).resume();
+				p = next;
+			}
+		}
+
+		/// Ticks since the sequencer was created
+		uint32_t Now() const {return now;}
+
+	private:
+		// Insert into the wake-ordered list of sleeping sequences
+		void Sleep(Task::promise_type &p, uint32_t n)
+		{
+			p.wake = now + n;
+			Task::promise_type **q = &sleepers;
+			while (*q && int32_t((*q)->wake - p.wake) <= 0) q = &(*q)->next;
+			p.next = *q;
+			*q = &p;
+		}
+
+		uint32_t now;
+		Task::promise_type *sleepers;
+		Task::promise_type *clockWaiters[numClocks];
+	};
+#endif
+
+	/** \brief Streams frames of several 16-bit channels from ProcessSample to a computer, in binary packets
+
+		On the audio core, Set each channel and then call Send() once per sample; every
+		decimation'th frame is queued in a Ring. On the other core, Packet() takes the queued
+		frames and builds one packet for the USB serial port (written to it with e.g.
+		stdio_usb.out_chars, so no line-ending translation is applied). If the queue fills,
+		frames are dropped, and the next packet is flagged. See examples/telemetry.
+
+		Packet layout, little-endian:
+		  0  'C','T'               sync bytes
+		  2  uint8  channels
+		  3  uint8  flags          bit 0: frames were dropped before this packet
+		  4  uint16 sequence       packet counter
+		  6  uint16 frames         number of frames n
+		  8  uint32 frameRate      frames per second (sample rate / decimation)
+		  12 int16  data[n][channels]
+		  then uint16 Fletcher-16 checksum of all bytes from 2 onwards
+	*/
+	template <unsigned Channels, unsigned N = 1024>
+	class Telemetry
+	{
+		static_assert(Channels > 0 && Channels < 256, "Telemetry needs 1 to 255 channels");
+	public:
+		static constexpr unsigned headerBytes = 12;
+
+		/// Bytes in a packet of the given number of frames
+		static constexpr unsigned PacketBytes(unsigned frames) {return headerBytes + frames * Channels * 2 + 2;}
+
+		Telemetry(uint32_t sampleRate = 48000, unsigned decimation = 1) : rate(sampleRate), decim(decimation ? decimation : 1), count(0), dropped(0), droppedSent(0), sequence(0)
+		{
+			for (unsigned c=0; c<Channels; c++) frame.v[c] = 0;
+		}
+
+		/// Set channel ch of the next frame (audio core)
+		void __not_in_flash_func(Set)(unsigned ch, int16_t value) {frame.v[ch] = value;}
+
+		/// Queue the frame (audio core), returning false if it was dropped because the queue is full
+		bool __not_in_flash_func(Send)()
+		{
+			if (++count < decim) return true;
+			count = 0;
+			if (ring.Push(frame)) return true;
+			__atomic_store_n(&dropped, dropped + 1, __ATOMIC_RELEASE);
+			return false;
+		}
+
+		/// Number of frames dropped so far
+		uint32_t Dropped() const {return __atomic_load_n(&dropped, __ATOMIC_ACQUIRE);}
+
+		/// Frames waiting to be sent
+		unsigned Queued() const {return ring.Size();}
+
+		/** \brief Build a packet of up to maxFrames queued frames into out (other core)
+
+			out must hold PacketBytes(maxFrames) bytes. Returns the packet length, or 0 if no frames are queued.
+		*/
+		unsigned Packet(uint8_t *out, unsigned maxFrames)
+		{
+			unsigned n = 0;
+			uint8_t *p = out + headerBytes;
+			Frame f;
+			while (n < maxFrames && n < 65535 && ring.Pop(f))
+			{
+				for (unsigned c=0; c<Channels; c++)
+				{
+					*p++ = uint8_t(f.v[c]);
+					*p++ = uint8_t(uint16_t(f.v[c]) >> 8);
+				}
+				n++;
+			}
+			if (n == 0) return 0;
+
+			uint32_t d = Dropped();
+			uint32_t r = rate / decim;
+			uint8_t header[headerBytes] = {'C', 'T', uint8_t(Channels), uint8_t(d != droppedSent),
+										   uint8_t(sequence), uint8_t(sequence >> 8), uint8_t(n), uint8_t(n >> 8),
+										   uint8_t(r), uint8_t(r >> 8), uint8_t(r >> 16), uint8_t(r >> 24)};
+			for (unsigned i=0; i<headerBytes; i++) out[i] = header[i];
+			droppedSent = d;
+			sequence++;
+
+			// Fletcher-16, reduced every 2048 bytes rather than every byte
+			uint32_t s1 = 0, s2 = 0;
+			unsigned k = 0;
+			for (uint8_t *q = out + 2; q < p; q++)
+			{
+				s1 += *q;
+				s2 += s1;
+				if (++k == 2048)
+				{
+					s1 %= 255;
+					s2 %= 255;
+					k = 0;
+				}
+			}
+			s1 %= 255;
+			s2 %= 255;
+			*p++ = uint8_t(s1);
+			*p++ = uint8_t(s2);
+			return unsigned(p - out);
+		}
+
+	private:
+		struct Frame
+		{
+			int16_t v[Channels];
+		};
+
+		Ring<Frame, N> ring;
+		Frame frame;
+		uint32_t rate;
+		unsigned decim, count;
+		uint32_t dropped;              // written by the audio core only
+		uint32_t droppedSent;          // the rest by the sending core only
+		uint16_t sequence;
+	};
+
+	/** \brief Coalescing, rate-limited MIDI CC output, from the audio core to the USB core
+
+		NumSlots controllers, each given a MIDI channel and CC number with Assign. The audio
+		core only writes each controller's latest value with Set, as often as it likes. The
+		USB core calls Poll, which writes a CC message for each controller whose value has
+		changed since it was last sent, but no more than once per that controller's minimum
+		interval: intermediate values are dropped, and the latest is sent once the interval
+		has passed. Messages are written as one byte stream, so that a single
+		tud_midi_stream_write (or tuh_midi_stream_write) packs them into as few USB packets
+		as possible. Controllers are scanned round-robin, so a small buffer is shared fairly.
+	*/
+	template <unsigned NumSlots>
+	class MIDICCOut
+	{
+		static_assert(NumSlots > 0, "MIDICCOut needs at least one controller");
+	public:
+		MIDICCOut() : next(0)
+		{
+			for (unsigned i=0; i<NumSlots; i++)
+			{
+				Assign(i, 0, i & 0x7F);
+				value[i] = 0;
+			}
+		}
+
+		/// Send slot i as controller ccNum on channel (0-15), at most once per minInterval, in the units of Poll's now
+		void Assign(unsigned i, uint8_t channel, uint8_t ccNum, uint32_t minInterval = 0)
+		{
+			status[i] = 0xB0 | (channel & 0x0F);
+			cc[i] = ccNum & 0x7F;
+			interval[i] = minInterval;
+			sent[i] = unsent;
+			lastSent[i] = 0;
+		}
+
+		/// Set the latest value (0-127) of slot i (audio core)
+		void __not_in_flash_func(Set)(unsigned i, uint8_t v) {value[i] = v & 0x7F;}
+
+		/// Send every controller again on the next Poll, even if unchanged, e.g. when USB connects (USB core)
+		void ResendAll()
+		{
+			for (unsigned i=0; i<NumSlots; i++) sent[i] = unsent;
+		}
+
+		/** \brief Write CC messages for changed controllers to out (USB core)
+
+			now is any increasing time (e.g. time_us_32()), in the units of the intervals given
+			to Assign. Returns the number of bytes written, a multiple of 3 and at most maxBytes.
+		*/
+		unsigned Poll(uint8_t *out, unsigned maxBytes, uint32_t now)
+		{
+			unsigned n = 0;
+			unsigned i = next;
+			for (unsigned k=0; k<NumSlots; k++)
+			{
+				uint8_t v = value[i];
+				if (v != sent[i] && (sent[i] == unsent || now - lastSent[i] >= interval[i]))
+				{
+					if (n + 3 > maxBytes)
+					{
+						next = i; // start here next time
+						return n;
+					}
+					out[n++] = status[i];
+					out[n++] = cc[i];
+					out[n++] = v;
+					sent[i] = v;
+					lastSent[i] = now;
+				}
+				if (++i == NumSlots) i = 0;
+			}
+			return n;
+		}
+
+	private:
+		static constexpr uint8_t unsent = 0xFF;
+
+		volatile uint8_t value[NumSlots];  // written by the audio core only
+		uint8_t status[NumSlots], cc[NumSlots], sent[NumSlots]; // the rest by the USB core only
+		uint32_t interval[NumSlots], lastSent[NumSlots];
+		unsigned next;
+	};
+
+	/** \brief Circular buffer for delay lines and loopers
+
+		Holds the last N items of type T written, to be read back at any delay behind the
+		newest, in samples (0 being the newest) or in 128ths of a sample with linear
+		interpolation. Indices wrap with a mask when N is a power of two, and with a
+		compare and subtract otherwise, so no division is done for any N.
+		Delays must be less than N (less than N-1 samples for interpolated reads).
+		Not for passing data between cores: see Ring for that.
+	*/
+	template <typename T, unsigned N>
+	class RingBuffer
+	{
+		static_assert(N > 1, "RingBuffer needs at least two items");
+		static constexpr bool pow2 = (N & (N - 1)) == 0;
+	public:
+		RingBuffer() : writeInd(0)
+		{
+			for (unsigned i = 0; i < N; i++) buf[i] = 0;
+		}
+
+		/// Add the newest item, overwriting the oldest
+		void __not_in_flash_func(Write)(T val)
+		{
+			buf[writeInd] = val;
+			writeInd = Wrap(writeInd + 1);
+		}
+
+		/// Add n items, oldest first
+		void __not_in_flash_func(WriteBlock)(const T *vals, unsigned n)
+		{
+			for (unsigned i = 0; i < n; i++) Write(vals[i]);
+		}
+
+		/// Item delay samples behind the newest
+		T __not_in_flash_func(Read)(unsigned delay) const
+		{
+			return buf[Behind(delay)];
+		}
+
+		/// Copy out n items, oldest first, the newest being delay samples behind the newest written
+		void __not_in_flash_func(ReadBlock)(T *vals, unsigned n, unsigned delay = 0) const
+		{
+			unsigned ind = Behind(delay + n - 1);
+			for (unsigned i = 0; i < n; i++)
+			{
+				vals[i] = buf[ind];
+				ind = Wrap(ind + 1);
+			}
+		}
+
+		/// Item delay128/128 samples behind the newest, linearly interpolated
+		T __not_in_flash_func(ReadInterp)(uint32_t delay128) const
+		{
+			int32_t r = delay128 & 0x7F;
+			unsigned ind1 = Behind(delay128 >> 7);
+			int32_t fromBuffer1 = buf[ind1];
+			int32_t fromBuffer2 = buf[Older(ind1)];
+			return (fromBuffer2 * r + fromBuffer1 * (128 - r)) >> 7;
+		}
+
+		/// Two interpolated taps at once, as ReadInterp, e.g. for left and right channels
+		void __not_in_flash_func(ReadInterp)(uint32_t delay128A, uint32_t delay128B, T &a, T &b) const
+		{
+			a = ReadInterp(delay128A);
+			b = ReadInterp(delay128B);
+		}
+
+		/// Item at absolute position ind (less than N), e.g. for a loop recorded since Reset
+		T &operator[](unsigned ind) {return buf[ind];}
+		const T &operator[](unsigned ind) const {return buf[ind];}
+
+		/// Position that the next Write will go to
+		unsigned WriteIndex() const {return writeInd;}
+		/// Make the next Write go to position 0, without clearing the contents
+		void Reset() {writeInd = 0;}
+
+	private:
+		static unsigned __not_in_flash_func(Wrap)(unsigned ind)
+		{
+			if (pow2) return ind & (N - 1);
+			return ind >= N ? ind - N : ind;
+		}
+		unsigned __not_in_flash_func(Behind)(unsigned delay) const
+		{
+			if (pow2) return (writeInd - 1 - delay) & (N - 1);
+			return Wrap(writeInd + (N - 1) - delay);
+		}
+		static unsigned __not_in_flash_func(Older)(unsigned ind)
+		{
+			if (pow2) return (ind - 1) & (N - 1);
+			return ind == 0 ? N - 1 : ind - 1;
+		}
+
+		unsigned writeInd;
+		T buf[N];
+	};
+
+	/** \brief Log-structured settings store in the last sectors of flash
+
+		Saves settings (a block of up to MaxBytes) without stopping audio, and without erasing
+		flash for most saves. Each save appends a record, with a sequence number and CRC,
+		to a log spread across NumSectors 4kB sectors at the top of flash (below the top
+		reserveSectors, if given); a sector is only erased when the log moves into it.
+		Load returns the newest record whose CRC is valid, so a save interrupted by a reset
+		or power loss leaves the previous settings in place.
+
+		Save only copies the data to RAM, so can be called from ProcessSample. The flash
+		write is done later by Service, called regularly from the core that is not running
+		the audio, once no Save has been made for quietMs. Service disables interrupts on its
+		own core while it erases or programs flash, but the other core carries on; as flash
+		cannot be read meanwhile, the audio core must be running entirely from SRAM
+		(build with COMPUTERCARD_RUN_FROM_RAM, or the copy_to_ram binary type).
+		Save must be called from one core only; Load is typically called in the card's
+		constructor, before Service is first called.
+	*/
+	template <unsigned MaxBytes, unsigned NumSectors = 4>
+	class FlashStore
+	{
+		static constexpr unsigned SectorBytes = FLASH_SECTOR_SIZE;
+		static constexpr unsigned PageBytes = FLASH_PAGE_SIZE;
+		static_assert(NumSectors >= 2, "FlashStore needs at least two sectors");
+		static_assert(MaxBytes > 0 && 16 + MaxBytes <= SectorBytes, "FlashStore record must fit in one sector");
+	public:
+		FlashStore(unsigned reserveSectors = 0, uint32_t quietMs = 500)
+			: base(PICO_FLASH_SIZE_BYTES - (reserveSectors + NumSectors) * SectorBytes), quietUs(quietMs * 1000) {}
+
+		/// Copy the newest saved record into data, returning false (and leaving data unchanged) if there is none of this size
+		bool Load(void *data, unsigned size)
+		{
+			if (!scanned) Scan();
+			if (!found || RecordHeader(sector, lastPos)->size != size) return false;
+			memcpy(data, FlashPtr(sector * SectorBytes + lastPos + sizeof(Header)), size);
+			return true;
+		}
+
+		/// Copy data (size at most MaxBytes) to be written to flash by Service, once no more saves have been made for the quiet time
+		void __not_in_flash_func(Save)(const void *data, unsigned size)
+		{
+			if (size > MaxBytes) return;
+			__atomic_store_n(&saveSeq, saveSeq + 1, __ATOMIC_RELEASE); // odd while copying
+			memcpy(pending, data, size);
+			pendingSize = size;
+			saveTime = time_us_32();
+			__atomic_store_n(&saveSeq, saveSeq + 1, __ATOMIC_RELEASE);
+		}
+
+		/// True if a Save has not yet been written to flash
+		bool Pending() const {return __atomic_load_n(&saveSeq, __ATOMIC_ACQUIRE) != writtenSeq;}
+
+		/** \brief Do the next step of writing a pending save: erase a sector, or append a record
+
+			Call regularly (e.g. every pass of a USB loop) from the core not running the audio.
+			Returns true if flash was modified.
+		*/
+		bool Service()
+		{
+			if (!scanned) Scan();
+
+			uint32_t seq = __atomic_load_n(&saveSeq, __ATOMIC_ACQUIRE);
+			if ((seq & 1) || seq == writtenSeq) return false; // nothing new, or Save is copying
+			if (time_us_32() - saveTime < quietUs) return false; // settings still changing
+
+			// Copy out the pending data, and check that no Save overlapped the copy
+			unsigned size = pendingSize;
+			memcpy(record + sizeof(Header), pending, size);
+			if (__atomic_load_n(&saveSeq, __ATOMIC_ACQUIRE) != seq) return false;
+
+			// Skip the write if the data are unchanged
+			if (found && RecordHeader(sector, lastPos)->size == size
+				&& memcmp(FlashPtr(sector * SectorBytes + lastPos + sizeof(Header)), record + sizeof(Header), size) == 0)
+			{
+				writtenSeq = seq;
+				return false;
+			}
+
+			// Move to the next sector (and erase it) if the record doesn't fit in this one;
+			// the record itself is written by the next call, to keep each step short
+			unsigned bytes = RecordBytes(size);
+			if (writePos + bytes > SectorBytes)
+			{
+				nextSector = (sector + 1) % NumSectors;
+				if (!nextErased)
+				{
+					Erase(nextSector * SectorBytes);
+					nextErased = true;
+					return true;
+				}
+				sector = nextSector;
+				writePos = 0;
+				nextErased = false;
+			}
+
+			Header *h = reinterpret_cast<Header *>(record);
+			h->magic = Magic;
+			h->seq = ++recordSeq;
+			h->size = size;
+			h->crc = CRC(record + 4, sizeof(Header) - 8, size);
+			memset(record + sizeof(Header) + size, 0xFF, bytes - sizeof(Header) - size);
+			Program(sector * SectorBytes + writePos, record, bytes);
+
+			found = true;
+			lastPos = writePos;
+			writePos += bytes;
+			writtenSeq = seq;
+			return true;
+		}
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t seq;  // increases by one each record
+			uint32_t size; // of data following header
+			uint32_t crc;  // of seq, size and data
+		};
+		static constexpr uint32_t Magic = 0x43435331; // "CCS1"
+
+		static constexpr unsigned RecordBytes(unsigned size) {return (sizeof(Header) + size + PageBytes - 1) & ~(PageBytes - 1);}
+
+		const Header *RecordHeader(unsigned s, unsigned pos) const {return reinterpret_cast<const Header *>(FlashPtr(s * SectorBytes + pos));}
+
+		// CRC-32 of n bytes of header (the seq and size fields), then size bytes of data following the header
+		static uint32_t CRC(const uint8_t *header, unsigned n, unsigned size)
+		{
+			uint32_t crc = 0xFFFFFFFF;
+			for (unsigned i=0; i<n+size; i++)
+			{
+				crc ^= (i < n) ? header[i] : header[i + 4]; // data starts after the crc field
+				for (int b=0; b<8; b++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+			}
+			return ~crc;
+		}
+
+		// Find the newest valid record, and the first erased page after it
+		void Scan()
+		{
+			found = false;
+			for (unsigned s=0; s<NumSectors; s++)
+			{
+				for (unsigned pos=0; pos + sizeof(Header) <= SectorBytes; pos += PageBytes)
+				{
+					const Header *h = RecordHeader(s, pos);
+					if (h->magic != Magic || h->size > MaxBytes || pos + RecordBytes(h->size) > SectorBytes) continue;
+					if (found && int32_t(h->seq - recordSeq) <= 0) continue;
+					if (CRC(reinterpret_cast<const uint8_t *>(h) + 4, sizeof(Header) - 8, h->size) != h->crc) continue;
+					found = true;
+					recordSeq = h->seq;
+					sector = s;
+					lastPos = pos;
+				}
+			}
+
+			if (found)
+			{
+				// Append after the newest record, and after anything else written to the sector (e.g. an interrupted save)
+				writePos = SectorBytes;
+				const uint8_t *p = FlashPtr(sector * SectorBytes);
+				while (writePos > lastPos + RecordBytes(RecordHeader(sector, lastPos)->size))
+				{
+					bool erased = true;
+					for (unsigned i=writePos-PageBytes; i<writePos && erased; i++) erased = (p[i] == 0xFF);
+					if (!erased) break;
+					writePos -= PageBytes;
+				}
+			}
+			else
+			{
+				// No records: the first save erases sector 0
+				sector = NumSectors - 1;
+				writePos = SectorBytes;
+			}
+			scanned = true;
+		}
+
+		const uint8_t *FlashPtr(uint32_t offset) const {return reinterpret_cast<const uint8_t *>(XIP_BASE + base + offset);}
+
+		void Erase(uint32_t offset)
+		{
+			Trace(TraceFlash | TraceBegin, uint16_t((base + offset) >> 12));
+			uint32_t ints = save_and_disable_interrupts();
+			flash_range_erase(base + offset, SectorBytes);
+			restore_interrupts(ints);
+			Trace(TraceFlash | TraceEnd, uint16_t((base + offset) >> 12));
+		}
+
+		void Program(uint32_t offset, const uint8_t *data, unsigned n)
+		{
+			Trace(TraceFlash | TraceBegin, uint16_t((base + offset) >> 12));
+			uint32_t ints = save_and_disable_interrupts();
+			flash_range_program(base + offset, data, n);
+			restore_interrupts(ints);
+			Trace(TraceFlash | TraceEnd, uint16_t((base + offset) >> 12));
+		}
+
+		uint32_t base, quietUs;
+		uint8_t pending[MaxBytes];
+		alignas(4) uint8_t record[(16 + MaxBytes + PageBytes - 1) & ~(PageBytes - 1)];
+		unsigned pendingSize = 0;
+		volatile uint32_t saveTime = 0;
+		uint32_t saveSeq = 0, writtenSeq = 0; // count of Save calls started/finished (x2), and last written
+		uint32_t recordSeq = 0;               // seq of newest record in flash
+		unsigned sector = 0, lastPos = 0, writePos = 0, nextSector = 0;
+		bool scanned = false, found = false, nextErased = false;
+	};
+
+	/** \brief Large fixed-size slots in flash, saved in the background
+
+		For data too big for FlashStore, such as recorded loops: NumSlots slots of up to
+		SlotBytes each, in whole sectors below the top reserveSectors of flash (e.g. below
+		a FlashStore). Save starts saving a buffer in RAM to a slot, and Service, called
+		regularly from the core that is not running the audio, does the writing, erasing
+		one sector or programming one page per call. Each page is only copied from the
+		buffer as it is programmed, so no second copy of the buffer is needed, and the
+		buffer may carry on changing during the save (the slot then holds each page as it
+		was when programmed). The slot's header, with a sequence number and a tag word for
+		the caller's own use, is programmed last, so a save interrupted by a reset or power
+		loss leaves the slot empty rather than half-written.
+
+		Data points to a slot's contents in flash, to be read directly (e.g. to play a slot
+		back at once, while it is copied to RAM), except while Busy. As for FlashStore,
+		the audio core must be running entirely from SRAM while saving.
+	*/
+	template <unsigned SlotBytes, unsigned NumSlots>
+	class FlashSlots
+	{
+		static constexpr unsigned SectorBytes = FLASH_SECTOR_SIZE;
+		static constexpr unsigned PageBytes = FLASH_PAGE_SIZE;
+		static_assert(SlotBytes > 0 && NumSlots > 0, "FlashSlots needs at least one slot");
+	public:
+		/// Sectors taken by each slot: a header page, then the data
+		static constexpr unsigned SlotSectors = (PageBytes + SlotBytes + SectorBytes - 1) / SectorBytes;
+
+		FlashSlots(unsigned reserveSectors = 0)
+			: base(PICO_FLASH_SIZE_BYTES - (reserveSectors + NumSlots * SlotSectors) * SectorBytes) {}
+
+		/// Number of bytes saved in slot, or 0 if it is empty
+		unsigned Size(unsigned slot) const {return Valid(slot) ? SlotHeader(slot)->size : 0;}
+		/// Tag word given to Save for slot
+		uint32_t Tag(unsigned slot) const {return Valid(slot) ? SlotHeader(slot)->tag : 0;}
+		/// Contents of slot, in flash. Not to be read while Busy
+		const uint8_t *Data(unsigned slot) const {return FlashPtr(slot * SlotSectors * SectorBytes + PageBytes);}
+
+		/// The most recently saved slot, or -1 if all are empty
+		int Newest() const
+		{
+			int newest = -1;
+			for (unsigned s=0; s<NumSlots; s++)
+			{
+				if (Valid(s) && (newest < 0 || int32_t(SlotHeader(s)->seq - SlotHeader(newest)->seq) > 0)) newest = s;
+			}
+			return newest;
+		}
+
+		/** \brief Start saving size bytes (at most SlotBytes) of data to slot
+
+			Returns false, doing nothing, if a save is already in progress.
+			data must stay valid until Busy returns false.
+		*/
+		bool Save(unsigned slot, const void *data, unsigned size, uint32_t tag = 0)
+		{
+			if (slot >= NumSlots || size == 0 || size > SlotBytes || Busy()) return false;
+			saveSlot = slot;
+			saveData = static_cast<const uint8_t *>(data);
+			saveSize = size;
+			saveTag = tag;
+			step = 0;
+			__atomic_store_n(&busy, true, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		/// True from Save until the slot has been written
+		bool Busy() const {return __atomic_load_n(&busy, __ATOMIC_ACQUIRE);}
+
+		/** \brief Do the next step of a save in progress: erase a sector, or program a page
+
+			Call regularly from the core not running the audio. Sectors are erased first,
+			starting with the one holding the header, then the data pages are programmed
+			in order, then the header. Returns true if flash was modified.
+		*/
+		bool Service()
+		{
+			if (!Busy()) return false;
+
+			uint32_t slotOffset = saveSlot * SlotSectors * SectorBytes;
+			unsigned sectors = (PageBytes + saveSize + SectorBytes - 1) / SectorBytes;
+			unsigned pages = (saveSize + PageBytes - 1) / PageBytes;
+			if (step < sectors)
+			{
+				Erase(slotOffset + step * SectorBytes);
+			}
+			else if (step < sectors + pages)
+			{
+				unsigned offset = (step - sectors) * PageBytes;
+				unsigned n = saveSize - offset < PageBytes ? saveSize - offset : PageBytes;
+				memcpy(page, saveData + offset, n);
+				memset(page + n, 0xFF, PageBytes - n);
+				Program(slotOffset + PageBytes + offset, page);
+			}
+			else
+			{
+				int newest = Newest();
+				Header *h = reinterpret_cast<Header *>(page);
+				h->magic = Magic;
+				h->seq = newest < 0 ? 1 : SlotHeader(newest)->seq + 1;
+				h->size = saveSize;
+				h->tag = saveTag;
+				h->check = Check(h);
+				memset(page + sizeof(Header), 0xFF, PageBytes - sizeof(Header));
+				Program(slotOffset, page);
+				__atomic_store_n(&busy, false, __ATOMIC_RELEASE);
+			}
+			step++;
+			return true;
+		}
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t seq;   // one more than the newest slot's, at each save
+			uint32_t size;  // of data following the header page
+			uint32_t tag;
+			uint32_t check; // of seq, size and tag
+		};
+		static constexpr uint32_t Magic = 0x4343534C; // "CCSL"
+
+		static uint32_t Check(const Header *h) {return ~(h->seq ^ (h->size * 0x9E3779B1) ^ (h->tag * 0x85EBCA77));}
+
+		const Header *SlotHeader(unsigned slot) const {return reinterpret_cast<const Header *>(FlashPtr(slot * SlotSectors * SectorBytes));}
+
+		bool Valid(unsigned slot) const
+		{
+			if (slot >= NumSlots) return false;
+			const Header *h = SlotHeader(slot);
+			return h->magic == Magic && h->size > 0 && h->size <= SlotBytes && h->check == Check(h);
+		}
+
+		const uint8_t *FlashPtr(uint32_t offset) const {return reinterpret_cast<const uint8_t *>(XIP_BASE + base + offset);}
+
+		void Erase(uint32_t offset)
+		{
+			Trace(TraceFlash | TraceBegin, uint16_t((base + offset) >> 12));
+			uint32_t ints = save_and_disable_interrupts();
+			flash_range_erase(base + offset, SectorBytes);
+			restore_interrupts(ints);
+			Trace(TraceFlash | TraceEnd, uint16_t((base + offset) >> 12));
+		}
+
+		void Program(uint32_t offset, const uint8_t *data)
+		{
+			Trace(TraceFlash | TraceBegin, uint16_t((base + offset) >> 12));
+			uint32_t ints = save_and_disable_interrupts();
+			flash_range_program(base + offset, data, PageBytes);
+			restore_interrupts(ints);
+			Trace(TraceFlash | TraceEnd, uint16_t((base + offset) >> 12));
+		}
+
+		uint32_t base;
+		alignas(4) uint8_t page[PageBytes];
+		const uint8_t *saveData = nullptr;
+		unsigned saveSlot = 0, saveSize = 0, step = 0;
+		uint32_t saveTag = 0;
+		bool busy = false;
+	};
+
+	/** \brief A card's state, restored at power-on and saved to flash in the background
+
+		A card declares the variables and small buffers that make up its state with Add, in
+		its constructor, and then calls Restore, so that it starts (before the first
+		ProcessSample) as it was when last captured. Capture copies the state on the audio
+		core, and Service, called regularly from the other core, writes it to a FlashStore,
+		so a capture costs one copy of the state and the audio never stops for flash.
+
+		The Computer has no warning of power loss, so a snapshot is only as recent as the
+		last capture: cards capture on a gesture of their own, and Update captures once the
+		controls have settled after a change. The snapshot holds a check of the sizes
+		added, and one saved by a build with a different layout of state is not restored.
+		As for FlashStore, the audio core must be running entirely from SRAM while saving.
+	*/
+	template <unsigned MaxBytes, unsigned NumSectors = 4>
+	class Snapshot
+	{
+		static constexpr unsigned MaxRegions = 16;
+		static_assert(MaxBytes + 4 + 16 <= 4096, "Snapshot must fit in one flash sector");
+	public:
+		Snapshot(unsigned reserveSectors = 0, uint32_t idleMs = 2000)
+			: store(reserveSectors, 0), idleUs(idleMs * 1000) {}
+
+		/// Add size bytes at data to the state, in the card's constructor; returns false if there is no room
+		bool Add(void *data, unsigned size)
+		{
+			if (numRegions == MaxRegions || totalBytes + size > MaxBytes) return false;
+			regions[numRegions++] = {static_cast<uint8_t *>(data), size};
+			totalBytes += size;
+			return true;
+		}
+
+		/// Add a variable or array to the state
+		template <typename T>
+		bool Add(T &value) {return Add(&value, sizeof(T));}
+
+		/// Copy the last snapshot saved into the state added, returning false (leaving it unchanged) if there is none of this layout
+		bool Restore()
+		{
+			if (!store.Load(buffer, 4 + totalBytes)) return false;
+			uint32_t check;
+			memcpy(&check, buffer, 4);
+			if (check != Layout()) return false;
+			Unpack();
+			return true;
+		}
+
+		/// Copy the state, to be written to flash by Service
+		void __not_in_flash_func(Capture)()
+		{
+			uint32_t check = Layout();
+			memcpy(buffer, &check, 4);
+			unsigned pos = 4;
+			for (unsigned i=0; i<numRegions; i++)
+			{
+				memcpy(buffer + pos, regions[i].data, regions[i].size);
+				pos += regions[i].size;
+			}
+			store.Save(buffer, pos);
+			changed = false;
+		}
+
+		/** \brief Idle heuristic: call once per sample or block, with whether the card's controls have changed
+
+			Captures the state once the controls have been still for the idle time (the second
+			constructor argument, 2s by default) after a change, so that a settled setting is
+			saved before the power goes, and nothing is written while it is being adjusted.
+		*/
+		void __not_in_flash_func(Update)(bool controlsChanged)
+		{
+			uint32_t now = time_us_32();
+			if (controlsChanged)
+			{
+				changed = true;
+				changeTime = now;
+			}
+			else if (changed && now - changeTime >= idleUs) Capture();
+		}
+
+		/// True from a Capture until it has been written to flash
+		bool Pending() const {return store.Pending();}
+
+		/// Do the next step of writing a capture, as FlashStore::Service; returns true if flash was modified
+		bool Service() {return store.Service();}
+
+	private:
+		struct Region
+		{
+			uint8_t *data;
+			unsigned size;
+		};
+
+		// Sizes of the regions added, so a snapshot from a build with other state isn't restored
+		uint32_t Layout() const
+		{
+			uint32_t h = 0x811C9DC5;
+			for (unsigned i=0; i<numRegions; i++) h = (h ^ regions[i].size) * 0x01000193;
+			return h;
+		}
+
+		void Unpack()
+		{
+			unsigned pos = 4;
+			for (unsigned i=0; i<numRegions; i++)
+			{
+				memcpy(regions[i].data, buffer + pos, regions[i].size);
+				pos += regions[i].size;
+			}
+		}
+
+		FlashStore<MaxBytes + 4, NumSectors> store;
+		Region regions[MaxRegions];
+		unsigned numRegions = 0, totalBytes = 0;
+		uint8_t buffer[MaxBytes + 4];
+		uint32_t idleUs, changeTime = 0;
+		bool changed = false;
+	};
+
+	class SampleStream;
+
+	/** \brief Index of the WAV samples uploaded to the top of flash by examples/sample_upload/generate_sample_uf2.html
+
+		The UF2 generator writes a pre-validated index ahead of the WAV files, giving each
+		file's sample data address, length, sample rate and loop points (from the WAV 'smpl'
+		chunk, or the whole file if it has none). The constructor just checks the index, so
+		there is no walking of RIFF headers through flash at boot, and Get is a single lookup.
+		Samples are 16-bit mono PCM, or, if the generator was asked to compress them, 8-bit
+		u-law (2:1) or 4-bit IMA ADPCM (4:1), given by the index's format word. ADPCM samples
+		are coded in blocks of 256 samples, each starting with a header giving the decoder
+		state, so that any block can be decoded on its own. UF2s from earlier versions of the
+		generator, with no index, give an empty bank and need regenerating.
+
+		The bank also streams sample data into SampleStream voices' SRAM buffers, one block
+		at a time, using the XIP stream FIFO and a DMA channel, so that voices do not stall
+		on XIP cache misses. Each read is started when the previous one finishes, from the
+		DMA_IRQ_1 interrupt, which is claimed by the bank (on the core that constructs it,
+		which must be the audio core); SampleStream voices must be used only from
+		ProcessSample/ProcessBlock. Only one SampleBank can be used at a time.
+	*/
+	class SampleBank
+	{
+	public:
+		enum Format
+		{
+			PCM16 = 0, // 16-bit samples
+			MuLaw = 1, // 8-bit u-law (G.711) samples
+			ADPCM = 2  // IMA ADPCM blocks of 256 samples: the first sample (int16) and step index (uint8, then a zero byte), then 4-bit codes for the other 255 samples, low nibble first
+		};
+		static constexpr unsigned MuLawBlockBytes = 256, ADPCMBlockBytes = 132;
+
+		struct Sample
+		{
+			const void *data;    // in flash
+			uint32_t length;     // in samples
+			uint32_t sampleRate;
+			uint32_t loopStart;  // loop from loopStart up to (but not including) loopEnd
+			uint32_t loopEnd;
+			Format format;
+		};
+
+		SampleBank()
+		{
+			dmaChannel = dma_claim_unused_channel(true);
+
+			// At the same (default) priority as the audio interrupt, so neither interrupts the other
+			instance = this;
+			dma_channel_set_irq1_enabled(dmaChannel, true);
+			irq_set_exclusive_handler(DMA_IRQ_1, SampleBank::OnDMAIRQ);
+			irq_set_enabled(DMA_IRQ_1, true);
+
+			Reload();
+		}
+
+		/** \brief Read the index again, after the samples in flash have been replaced
+
+			For cards that write new samples to flash themselves (examples/usb_sample_upload).
+			No voice may be playing from the bank meanwhile, and flash may only be written
+			once Busy() is false. Can be called from either core. Returns the new Count().
+		*/
+		unsigned Reload()
+		{
+			count = 0;
+			const uint32_t *footer = reinterpret_cast<const uint32_t *>(XIP_BASE + PICO_FLASH_SIZE_BYTES - FLASH_PAGE_SIZE);
+			if (footer[2] != Magic || !InFlash(footer[3], sizeof(Header))) return 0;
+
+			const Header *h = reinterpret_cast<const Header *>(footer[3]);
+			const Entry *e = reinterpret_cast<const Entry *>(h + 1);
+			if (h->magic != Magic || h->count == 0 || h->count > MaxSamples || !InFlash(footer[3], sizeof(Header) + h->count * sizeof(Entry))) return 0;
+			if (h->check != Check(reinterpret_cast<const uint32_t *>(e), h->count * sizeof(Entry) / 4) || h->format > ADPCM) return 0;
+
+			entries = e;
+			format = Format(h->format);
+			count = h->count;
+			return count;
+		}
+
+		/// Number of samples in the bank, 0 if no valid index was found
+		unsigned Count() const {return count;}
+
+		/// True while a block read for a voice is queued or in progress; flash must not be written until it is false
+		bool Busy() const {return __atomic_load_n(&active, __ATOMIC_ACQUIRE) || __atomic_load_n(&queueHead, __ATOMIC_ACQUIRE);}
+
+		/// Sample number i (i < Count())
+		Sample Get(unsigned i) const
+		{
+			const Entry &e = entries[i];
+			return Sample{reinterpret_cast<const void *>(e.address), e.length, e.sampleRate, e.loopStart, e.loopEnd, format};
+		}
+
+	private:
+		friend class SampleStream;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t count;
+			uint32_t check; // of the entries
+			uint32_t format; // for all samples; 0 (16-bit PCM) from generators before compression was added
+		};
+		struct Entry
+		{
+			uint32_t address, length, sampleRate, loopStart, loopEnd;
+		};
+		static constexpr uint32_t Magic = 0x49534343; // "CCSI"
+		static constexpr unsigned MaxSamples = 1024;
+
+		// Bytes of flash taken by length samples in format f, as padded by the generator
+		static uint32_t DataBytes(uint32_t f, uint32_t length)
+		{
+			if (f == MuLaw) return (length + 3) & ~3u;
+			if (f == ADPCM) return ((length + 255) >> 8) * ADPCMBlockBytes;
+			return length * 2;
+		}
+
+		static int16_t __not_in_flash_func(DecodeMuLaw)(uint8_t u)
+		{
+			u = ~u;
+			int32_t t = (((u & 0x0F) << 3) + 0x84) << ((u & 0x70) >> 4);
+			return int16_t((u & 0x80) ? 0x84 - t : t - 0x84);
+		}
+
+		// Decode the 4-bit code in the low bits of nibble, updating the predicted sample and step index
+		static void __not_in_flash_func(DecodeADPCM)(int32_t &pred, int32_t &index, unsigned nibble)
+		{
+			static constexpr int16_t stepTable[89] = {
+				7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+				50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+				337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+				2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+				15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+			static constexpr int8_t indexTable[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+			int32_t step = stepTable[index];
+			int32_t diff = step >> 3;
+			if (nibble & 4) diff += step;
+			if (nibble & 2) diff += step >> 1;
+			if (nibble & 1) diff += step >> 2;
+			pred += (nibble & 8) ? -diff : diff;
+			if (pred > 32767) pred = 32767; else if (pred < -32768) pred = -32768;
+			index += indexTable[nibble & 7];
+			if (index < 0) index = 0; else if (index > 88) index = 88;
+		}
+
+		static uint32_t Check(const uint32_t *w, unsigned n)
+		{
+			uint32_t h = 0x811C9DC5;
+			for (unsigned i=0; i<n; i++) h = (h ^ w[i]) * 0x01000193;
+			return h;
+		}
+
+		static bool InFlash(uint32_t address, uint32_t size)
+		{
+			return address >= XIP_BASE && address < XIP_BASE + PICO_FLASH_SIZE_BYTES && size <= XIP_BASE + PICO_FLASH_SIZE_BYTES - address;
+		}
+
+		void __not_in_flash_func(Queue)(SampleStream *s)
+		{
+			s->nextQueued = nullptr;
+			if (queueTail) queueTail->nextQueued = s; else queueHead = s;
+			queueTail = s;
+			if (!active) StartNext();
+		}
+
+		// Start the next queued block read that is still wanted
+		void __not_in_flash_func(StartNext)()
+		{
+			while (queueHead)
+			{
+				SampleStream *s = queueHead;
+				queueHead = s->nextQueued;
+				if (!queueHead) queueTail = nullptr;
+
+				uint32_t *dst; const uint32_t *src; unsigned words;
+				if (!s->FillSource(dst, src, words)) continue; // voice restarted since queueing
+
+				// Empty the stream FIFO of anything left over, then stream words from flash by DMA
+				while (!(xip_ctrl_hw->stat & XIP_STAT_FIFO_EMPTY_BITS)) (void)xip_ctrl_hw->stream_fifo;
+				xip_ctrl_hw->stream_addr = reinterpret_cast<uint32_t>(src);
+				xip_ctrl_hw->stream_ctr = words;
+				dma_channel_config c = dma_channel_get_default_config(dmaChannel);
+				channel_config_set_read_increment(&c, false);
+				channel_config_set_write_increment(&c, true);
+				channel_config_set_dreq(&c, DREQ_XIP_STREAM);
+				dma_channel_configure(dmaChannel, &c, dst, reinterpret_cast<const void *>(XIP_AUX_BASE), words, true);
+				active = s;
+				return;
+			}
+		}
+
+		// Read finished: hand the block to its voice, and start the next
+		static void __not_in_flash_func(OnDMAIRQ)()
+		{
+			SampleBank *sb = instance;
+			dma_hw->ints1 = 1u << sb->dmaChannel;
+			if (sb->active) sb->active->Filled();
+			sb->active = nullptr;
+			sb->StartNext();
+		}
+
+		static inline SampleBank *instance = nullptr;
+
+		const Entry *entries = nullptr;
+		unsigned count = 0;
+		Format format = PCM16;
+		int dmaChannel = 0;
+		SampleStream *active = nullptr, *queueHead = nullptr, *queueTail = nullptr;
+	};
+
+	/** \brief Sample playback voice, reading from SRAM blocks streamed from flash by a SampleBank
+
+		Holds two blocks of BlockSamples samples: while the play position is in one, the next
+		block to be played (allowing for looping) is read into the other in the background.
+		If the play position gets ahead of the streaming (just after Play, or with many voices
+		at high speed), samples are read directly from flash until the block arrives, so
+		playback is always correct, just slower for those samples.
+
+		The play position is a sample index plus a 24-bit fraction, so that speeds (in 2^24ths
+		of a sample per output sample) are precise enough for pitch-tracked playback.
+
+		Compressed (u-law or IMA ADPCM) blocks are streamed into the end of their SRAM buffer
+		and decoded in place, a few samples ahead of the play position at a time, so the
+		decoding cost is spread evenly over playback rather than falling on one sample.
+	*/
+	class SampleStream
+	{
+	public:
+		static constexpr unsigned BlockSamples = 256;
+
+		SampleStream() {slotBlock[0] = slotBlock[1] = -1;}
+
+		/// Start playing sample i of bank from the beginning, looping between its loop points if loop is true
+		void __not_in_flash_func(Play)(SampleBank &bank, unsigned i, bool loop = false)
+		{
+			if (i >= bank.Count()) {Stop(); return;}
+			b = &bank;
+			s = bank.Get(i);
+			end = loop ? s.loopEnd : s.length;
+			looping = loop && s.loopEnd > s.loopStart;
+			uintptr_t address = reinterpret_cast<uintptr_t>(s.data);
+			skew = (s.format == SampleBank::PCM16) ? (address & 2) >> 1 : 0;
+			// Compressed blocks can only be streamed if word-aligned, as the generator writes them
+			streamed = (s.format == SampleBank::PCM16) || !(address & 3);
+			idx = 0;
+			frac = 0;
+			wrapped = false;
+			playing = s.length > 0;
+			gen++;
+			slotBlock[0] = slotBlock[1] = -1;
+			fastBase = NoBlock;
+			cursor = NoBlock;
+			Prefetch();
+		}
+
+		/// Stop playing: Next then returns 0
+		void Stop() {playing = false;}
+
+		bool Playing() const {return playing;}
+
+		/// True if the last call to Next or Render reached the end of the sample, or the loop end
+		bool Wrapped() const {return wrapped;}
+
+		/// Sample rate of the sample being played
+		uint32_t SampleRate() const {return s.sampleRate;}
+
+		/// Play position, in samples, as a fixed-point number with 8 fractional bits
+		uint32_t Position() const {return (idx << 8) | (frac >> 16);}
+
+		/** \brief Return the sample at the play position, linearly interpolated, then advance
+
+			The position advances by speed/256 samples, so 256 plays at the original pitch
+			if the sample rate is the same as the card's.
+		*/
+		int16_t __not_in_flash_func(Next)(uint32_t speed)
+		{
+			wrapped = false;
+			if (!playing) return 0;
+
+			uint32_t j = idx + 1;
+			if (j >= end) j = looping ? s.loopStart : idx;
+			int32_t r = frac >> 16;
+			int32_t out = (At(idx) * (256 - r) + At(j) * r) >> 8;
+
+			if (Advance(speed << 16)) Prefetch();
+			return int16_t(out);
+		}
+
+		/** \brief Add n samples, interpolated and scaled by a ramped gain, to out
+
+			The position advances by inc/2^24 samples per output sample. The gain starts at
+			gain (0 to 2^31-1, 2^31 being unity) and changes by gainStep each sample.
+			Reads within the decoded part of the current SRAM block take a short path with
+			no block lookup.
+		*/
+		void __not_in_flash_func(Render)(int32_t *out, unsigned n, uint32_t inc, int32_t gain, int32_t gainStep)
+		{
+			wrapped = false;
+			for (unsigned k=0; k<n && playing; k++)
+			{
+				int32_t a, c;
+				uint32_t o = idx - fastBase;
+				if (o < fastLimit)
+				{
+					a = fastBuf[o];
+					c = fastBuf[o + 1];
+				}
+				else
+				{
+					uint32_t j = idx + 1;
+					if (j >= end) j = looping ? s.loopStart : idx;
+					a = At(idx);
+					c = At(j);
+					SetFastBlock();
+				}
+				int32_t v = a + (((c - a) * int32_t(frac >> 10)) >> 14);
+				out[k] += (v * (gain >> 16)) >> 15;
+				gain += gainStep;
+
+				bool w = Advance(inc);
+				wrapped |= w;
+				if (w) Prefetch();
+			}
+			Prefetch();
+		}
+
+	private:
+		friend class SampleBank;
+		static constexpr unsigned BlockShift = 8;
+		static_assert(BlockSamples == 1u << BlockShift, "SampleStream: BlockShift must match BlockSamples");
+		static constexpr uint32_t NoBlock = 0x80000000;
+		static constexpr unsigned BufWords = (BlockSamples + 2) / 2;
+		static_assert(SampleBank::MuLawBlockBytes == BlockSamples && SampleBank::ADPCMBlockBytes == 4 + BlockSamples / 2,
+					  "SampleStream: compressed block sizes must match BlockSamples");
+		// Samples decoded at a time, once the play position reaches the undecoded part of a block
+		static constexpr unsigned DecodeAhead = 16;
+
+		// Move the play position on by inc/2^24 samples. Returns true if it reached the end
+		bool __not_in_flash_func(Advance)(uint32_t inc)
+		{
+			frac += inc & 0x00FFFFFF;
+			idx += (inc >> 24) + (frac >> 24);
+			frac &= 0x00FFFFFF;
+			if (idx < end) return false;
+
+			if (looping)
+			{
+				idx = s.loopStart + (idx - end) % (end - s.loopStart);
+			}
+			else
+			{
+				playing = false;
+			}
+			return true;
+		}
+
+		int32_t __not_in_flash_func(At)(uint32_t i)
+		{
+			int32_t k = i >> BlockShift;
+			unsigned o = i & (BlockSamples - 1);
+			for (unsigned slot=0; slot<2; slot++)
+			{
+				if (slotBlock[slot] != k) continue;
+				if (o >= slotDecoded[slot]) Decode(slot, o + DecodeAhead);
+				return buf[slot][o + skew];
+			}
+			return FromFlash(i);
+		}
+
+		// Sample i read directly from flash
+		int32_t __not_in_flash_func(FromFlash)(uint32_t i)
+		{
+			const uint8_t *data = static_cast<const uint8_t *>(s.data);
+			switch (s.format)
+			{
+			case SampleBank::MuLaw:
+				return SampleBank::DecodeMuLaw(data[i]);
+			case SampleBank::ADPCM:
+			{
+				// Carry on from the last sample read if possible, else from the start of its block
+				if (i == cursor) return cursorPred;
+				if (i + 1 == cursor && (cursor & (BlockSamples - 1))) return cursorPrev;
+				uint32_t k = i >> BlockShift;
+				const uint8_t *block = data + k * SampleBank::ADPCMBlockBytes;
+				if (cursor == NoBlock || (cursor >> BlockShift) != k || i < cursor)
+				{
+					cursor = k << BlockShift;
+					cursorPred = cursorPrev = int16_t(block[0] | (block[1] << 8));
+					cursorIndex = (block[2] > 88) ? 88 : block[2];
+				}
+				while (cursor < i)
+				{
+					unsigned m = cursor & (BlockSamples - 1);
+					cursorPrev = cursorPred;
+					SampleBank::DecodeADPCM(cursorPred, cursorIndex, block[4 + (m >> 1)] >> ((m & 1) << 2));
+					cursor++;
+				}
+				return cursorPred;
+			}
+			default:
+				return static_cast<const int16_t *>(s.data)[i];
+			}
+		}
+
+		// Decode a streamed compressed block in place, up to sample o (or the end of the block)
+		void __not_in_flash_func(Decode)(unsigned slot, unsigned o)
+		{
+			if (o > BlockSamples - 1) o = BlockSamples - 1;
+			int16_t *dst = buf[slot];
+			const uint8_t *raw = reinterpret_cast<const uint8_t *>(buf[slot]) + RawOffset();
+			unsigned n = slotDecoded[slot];
+			if (s.format == SampleBank::MuLaw)
+			{
+				// Sample n overwrites raw bytes before raw[n+1], so is safe to write in order
+				for (; n <= o; n++) dst[n] = SampleBank::DecodeMuLaw(raw[n]);
+			}
+			else
+			{
+				int32_t pred = slotPred[slot], index = slotIndex[slot];
+				if (n == 0)
+				{
+					pred = int16_t(raw[0] | (raw[1] << 8));
+					index = (raw[2] > 88) ? 88 : raw[2];
+					dst[n++] = int16_t(pred);
+				}
+				for (; n <= o; n++)
+				{
+					SampleBank::DecodeADPCM(pred, index, raw[4 + ((n - 1) >> 1)] >> (((n - 1) & 1) << 2));
+					dst[n] = int16_t(pred);
+				}
+				slotPred[slot] = pred;
+				slotIndex[slot] = index;
+			}
+			slotDecoded[slot] = n;
+		}
+
+		// Byte offset in a buffer at which compressed blocks are streamed, ending at the end of the buffer
+		unsigned RawOffset() const
+		{
+			return (BufWords - ((s.format == SampleBank::MuLaw ? SampleBank::MuLawBlockBytes : SampleBank::ADPCMBlockBytes) >> 2)) << 2;
+		}
+
+		// Point the short read path of Render at the block holding the play position, if it is in SRAM
+		void __not_in_flash_func(SetFastBlock)()
+		{
+			int32_t k = idx >> BlockShift;
+			fastBase = NoBlock;
+			for (unsigned slot=0; slot<2; slot++)
+			{
+				if (slotBlock[slot] == k && slotDecoded[slot] > 1)
+				{
+					fastBase = uint32_t(k) << BlockShift;
+					fastBuf = buf[slot] + skew;
+					fastLimit = slotDecoded[slot] - 1;
+					fastSlot = slot;
+				}
+			}
+		}
+
+		// Block to be played after block k, or -1 if none
+		int32_t NextBlock(int32_t k) const
+		{
+			uint32_t next = uint32_t(k + 1) << BlockShift;
+			if (next < end) return k + 1;
+			return looping ? int32_t(s.loopStart >> BlockShift) : -1;
+		}
+
+		// Queue a read of the current block, if not held, or else of the next block
+		void __not_in_flash_func(Prefetch)()
+		{
+			if (fillPending || !playing || !streamed) return;
+			int32_t k = idx >> BlockShift;
+			int32_t want = k;
+			if (slotBlock[0] == k || slotBlock[1] == k)
+			{
+				want = NextBlock(k);
+				if (want < 0 || slotBlock[0] == want || slotBlock[1] == want) return;
+			}
+			fillSlot = (slotBlock[0] == k) ? 1 : 0;
+			fillBlock = want;
+			fillGen = gen;
+			slotBlock[fillSlot] = -1;
+			if (fastBase != NoBlock && fastSlot == fillSlot) fastBase = NoBlock;
+			fillPending = true;
+			b->Queue(this);
+		}
+
+		// Destination, flash source and length in words of the queued read; false if it is no longer wanted
+		bool __not_in_flash_func(FillSource)(uint32_t *&dst, const uint32_t *&src, unsigned &words)
+		{
+			if (fillGen != gen) {fillPending = false; return false;}
+			uintptr_t data = reinterpret_cast<uintptr_t>(s.data);
+			uintptr_t last = data + SampleBank::DataBytes(s.format, s.length);
+			uintptr_t first;
+			if (s.format == SampleBank::PCM16)
+			{
+				// Stream reads whole words, so start at the word holding the block's first sample
+				first = (data + (uint32_t(fillBlock) << (BlockShift + 1))) & ~uintptr_t(3);
+				words = BlockSamples / 2 + skew;
+				dst = reinterpret_cast<uint32_t *>(buf[fillSlot]);
+			}
+			else
+			{
+				unsigned blockBytes = (s.format == SampleBank::MuLaw) ? SampleBank::MuLawBlockBytes : SampleBank::ADPCMBlockBytes;
+				first = data + uint32_t(fillBlock) * blockBytes;
+				words = blockBytes >> 2;
+				dst = reinterpret_cast<uint32_t *>(buf[fillSlot]) + (RawOffset() >> 2);
+			}
+			src = reinterpret_cast<const uint32_t *>(first);
+			unsigned avail = unsigned((last + 3 - first) >> 2);
+			if (words > avail) words = avail;
+			return true;
+		}
+
+		void __not_in_flash_func(Filled)()
+		{
+			if (fillGen == gen)
+			{
+				slotBlock[fillSlot] = fillBlock;
+				slotDecoded[fillSlot] = (s.format == SampleBank::PCM16) ? BlockSamples : 0;
+			}
+			fillPending = false;
+		}
+
+		SampleBank *b = nullptr;
+		SampleBank::Sample s = {};
+		alignas(4) int16_t buf[2][BlockSamples + 2];
+		int32_t slotBlock[2];
+		unsigned slotDecoded[2] = {0, 0};
+		int32_t slotPred[2] = {0, 0}, slotIndex[2] = {0, 0};
+		uint32_t idx = 0, frac = 0, end = 0;
+		uint32_t fastBase = NoBlock, fastLimit = 0;
+		const int16_t *fastBuf = nullptr;
+		uint32_t cursor = NoBlock;
+		int32_t cursorPred = 0, cursorPrev = 0, cursorIndex = 0;
+		uint32_t gen = 0, fillGen = 0;
+		int32_t fillBlock = 0;
+		unsigned fillSlot = 0, fastSlot = 0, skew = 0;
+		bool playing = false, looping = false, wrapped = false, fillPending = false, streamed = false;
+		SampleStream *nextQueued = nullptr;
+	};
+
+	/** \brief Polyphonic, pitch-tracked sampler: a pool of NumVoices SampleStream voices
+
+		Notes are started by NoteOn (or MIDI note on messages, through MIDI) on a free voice,
+		or else by stealing the quietest releasing voice, or the oldest. Each note is pitched
+		relative to the root note (SetRootNote, middle C by default), allowing for the
+		sample's own sample rate, with pitch bend and a global offset in cents applied at
+		each Render. Notes have a linear attack/release envelope, scaled by velocity.
+
+		Render adds a block of all voices to a mix buffer; the pitch and envelope are
+		updated once per block, and ramped across it, so the per-sample cost of each voice
+		is an interpolated read, a gain and a position update.
+	*/
+	template <unsigned NumVoices>
+	class Sampler
+	{
+	public:
+		Sampler(SampleBank &sampleBank, uint32_t outputSampleRate = 48000) : bank(sampleBank), outputRate(outputSampleRate)
+		{
+			for (unsigned v=0; v<NumVoices; v++) voice[v].state = Idle;
+			SetEnvelope(48, 4800);
+		}
+
+		/// Sample played by MIDI notes (also set by MIDI program change)
+		void SetSample(unsigned i) {sample = i;}
+		unsigned CurrentSample() const {return sample;}
+
+		/// MIDI note number at which samples play at their original pitch
+		void SetRootNote(uint8_t note) {rootNote = note;}
+
+		/// Attack and release times, in samples
+		void SetEnvelope(uint32_t attackSamples, uint32_t releaseSamples)
+		{
+			attack = attackSamples ? attackSamples : 1;
+			release = releaseSamples ? releaseSamples : 1;
+		}
+
+		/// If true, notes loop between the sample's loop points until released
+		void SetLoop(bool loop) {looping = loop;}
+
+		/// Range of MIDI pitch bend, in semitones
+		void SetPitchBendRange(int32_t semitones) {bendRange = semitones;}
+
+		/// Offset in cents added to the pitch of all voices, e.g. from a CV input
+		void SetPitchCents(int32_t cents) {pitchCents = cents;}
+
+		/// Start sample i at MIDI note number note, with velocity 1 to 127. Returns the voice used
+		int NoteOn(unsigned i, uint8_t note, uint8_t velocity)
+		{
+			if (i >= bank.Count()) return -1;
+			unsigned v = FreeVoice();
+			Voice &vc = voice[v];
+			vc.stream.Play(bank, i, looping);
+			// Playback increment at the root note, in 2^24ths of a sample
+			vc.rootInc = uint32_t((uint64_t(vc.stream.SampleRate()) << 24) / outputRate);
+			vc.note = note;
+			vc.peak = int32_t(velocity > 127 ? 127 : velocity) * (0x7FFFFFFF / 127);
+			vc.level = 0;
+			vc.step = vc.peak / int32_t(attack) + 1;
+			vc.state = Attack;
+			vc.age = ++ageCounter;
+			return v;
+		}
+
+		/// Release all notes at note number note
+		void NoteOff(uint8_t note)
+		{
+			for (unsigned v=0; v<NumVoices; v++)
+			{
+				if (voice[v].note == note && (voice[v].state == Attack || voice[v].state == Sustain)) StartRelease(voice[v]);
+			}
+		}
+
+		/// Release all playing notes
+		void AllNotesOff()
+		{
+			for (unsigned v=0; v<NumVoices; v++)
+			{
+				if (voice[v].state == Attack || voice[v].state == Sustain) StartRelease(voice[v]);
+			}
+		}
+
+		/// Handle a MIDI message, on any channel: note on/off, pitch bend, program change and all notes off
+		void MIDI(const MIDIEvent &e)
+		{
+			uint8_t status = e.data[0] & 0xF0;
+			if (status == 0x90 && e.data[2] > 0) NoteOn(sample, e.data[1], e.data[2]);
+			else if (status == 0x80 || status == 0x90) NoteOff(e.data[1]);
+			else if (status == 0xE0) bendCents = ((int32_t(e.data[1] | (e.data[2] << 7)) - 8192) * bendRange * 100) >> 13;
+			else if (status == 0xC0) sample = e.data[1];
+			else if (status == 0xB0 && (e.data[1] == 120 || e.data[1] == 123)) AllNotesOff();
+		}
+
+		/// Add the next n samples of all voices (16-bit scale) to mix
+		void __not_in_flash_func(Render)(int32_t *mix, unsigned n)
+		{
+			for (unsigned v=0; v<NumVoices; v++)
+			{
+				Voice &vc = voice[v];
+				if (vc.state == Idle) continue;
+
+				int32_t gain = vc.level;
+				int32_t step = EnvelopeStep(vc, n);
+				int32_t cents = (int32_t(vc.note) - rootNote) * 100 + bendCents + pitchCents;
+				vc.stream.Render(mix, n, Increment(vc.rootInc, cents), gain, step);
+				if (vc.state == Idle) vc.stream.Stop();
+				else if (!vc.stream.Playing()) vc.state = Idle;
+			}
+		}
+
+		/// Number of voices playing
+		unsigned Active() const
+		{
+			unsigned n = 0;
+			for (unsigned v=0; v<NumVoices; v++) n += (voice[v].state != Idle);
+			return n;
+		}
+
+		/// Envelope level of voice v, 0 to 2^31-1
+		int32_t Level(unsigned v) const {return voice[v].state == Idle ? 0 : voice[v].level;}
+
+	private:
+		enum State {Idle, Attack, Sustain, Release};
+		struct Voice
+		{
+			SampleStream stream;
+			uint32_t rootInc, age;
+			int32_t level, peak, step;
+			uint8_t note;
+			State state;
+		};
+
+		void StartRelease(Voice &vc)
+		{
+			vc.state = Release;
+			vc.step = vc.level / int32_t(release) + 1;
+		}
+
+		// Idle voice, or else the quietest releasing voice, or else the oldest
+		unsigned FreeVoice() const
+		{
+			int best = -1;
+			for (unsigned v=0; v<NumVoices; v++)
+			{
+				if (voice[v].state == Idle) return v;
+				if (voice[v].state == Release && (best < 0 || voice[v].level < voice[best].level)) best = v;
+			}
+			if (best >= 0) return best;
+			best = 0;
+			for (unsigned v=1; v<NumVoices; v++)
+			{
+				if (int32_t(voice[v].age - voice[best].age) < 0) best = v;
+			}
+			return best;
+		}
+
+		// Per-sample gain step across the next n samples, updating the level and state for the end of the block
+		int32_t __not_in_flash_func(EnvelopeStep)(Voice &vc, unsigned n)
+		{
+			int32_t step = 0;
+			if (vc.state == Attack)
+			{
+				if (int64_t(vc.level) + int64_t(vc.step) * n >= vc.peak)
+				{
+					step = (vc.peak - vc.level) / int32_t(n);
+					vc.state = Sustain;
+				}
+				else step = vc.step;
+			}
+			else if (vc.state == Release)
+			{
+				if (int64_t(vc.level) - int64_t(vc.step) * n <= 0)
+				{
+					step = -vc.level / int32_t(n);
+					vc.state = Idle; // after this block
+				}
+				else step = -vc.step;
+			}
+			vc.level += step * int32_t(n);
+			return step;
+		}
+
+		// Increment for playing cents above the root note, from the increment at the root note
+		uint32_t __not_in_flash_func(Increment)(uint32_t rootInc, int32_t cents) const
+		{
+			// cents/1200 octaves, as 16.16 fixed point
+			int32_t oct16 = int32_t((int64_t(cents) * 3579139) >> 16);
+			int32_t oct = oct16 >> 16;
+			uint32_t f = oct16 & 0xFFFF;
+			uint32_t t0 = octaveTable[f >> 10], t1 = octaveTable[(f >> 10) + 1];
+			uint32_t ratio = t0 + uint32_t((uint64_t(t1 - t0) * (f & 0x3FF)) >> 10);
+			uint64_t inc = (uint64_t(rootInc) * ratio) >> 30;
+			if (oct >= 0) inc <<= (oct > 8 ? 8 : oct);
+			else inc >>= (-oct > 31 ? 31 : -oct);
+			return inc > 0xFFFFFFFF ? 0xFFFFFFFF : uint32_t(inc);
+		}
+
+		// 2^(i/64) * 2^30, for fractions of an octave
+		static constexpr uint32_t octaveTable[65] = {
+			1073741824, 1085434106, 1097253708, 1109202018, 1121280436, 1133490379, 1145833280, 1158310587,
+			1170923762, 1183674286, 1196563654, 1209593378, 1222764986, 1236080024, 1249540052, 1263146652,
+			1276901417, 1290805962, 1304861917, 1319070932, 1333434672, 1347954824, 1362633090, 1377471191,
+			1392470869, 1407633882, 1422962010, 1438457051, 1454120821, 1469955159, 1485961921, 1502142985,
+			1518500250, 1535035634, 1551751076, 1568648537, 1585730000, 1602997467, 1620452965, 1638098541,
+			1655936265, 1673968228, 1692196547, 1710623359, 1729250827, 1748081133, 1767116489, 1786359126,
+			1805811301, 1825475297, 1845353420, 1865448001, 1885761398, 1906295993, 1927054196, 1948038440,
+			1969251188, 1990694927, 2012372174, 2034285470, 2056437387, 2078830522, 2101467502, 2124350982,
+			2147483648
+		};
+
+		SampleBank &bank;
+		uint32_t outputRate;
+		Voice voice[NumVoices];
+		uint32_t attack = 48, release = 4800, ageCounter = 0;
+		unsigned sample = 0;
+		int32_t bendCents = 0, pitchCents = 0, bendRange = 2;
+		uint8_t rootNote = 60;
+		bool looping = false;
+	};
+
+	/** \brief Linearly-interpolated reader for a power-of-two length int16_t buffer
+
+		Uses the RP2040 SIO interpolators of the calling core: INTERP1 computes the
+		addresses of the two samples either side of the read position, with wraparound,
+		and INTERP0 (in blend mode) interpolates between them. If hardware_interp is not
+		linked, the same calculation is done in software.
+
+		Positions are unsigned fixed-point, with the buffer index above bit FracBits
+		(at least 8) and the fraction below it; only the top 8 bits of the fraction are used.
+
+		The interpolators are reconfigured when a different reader is used, so use readers
+		from only one context on each core (e.g. only within ProcessSample), and not
+		alongside other code that uses the interpolators.
+	*/
+	template <int SizeBits, int FracBits>
+	class InterpReader
+	{
+		static_assert(SizeBits > 0 && FracBits >= 8 && SizeBits + FracBits <= 32, "InterpReader: index and fraction must fit in 32 bits");
+	public:
+		InterpReader(const int16_t *buffer) : buf(buffer) {}
+
+		/// Change the buffer being read, also of length 2^SizeBits
+		void SetBuffer(const int16_t *buffer)
+		{
+			buf = buffer;
+#ifdef COMPUTERCARD_HAS_INTERP
+			ComputerCard::interpOwner[get_core_num()] = nullptr;
+#endif
+		}
+
+		/// Return the interpolated buffer value at a position
+		int32_t __not_in_flash_func(Read)(uint32_t pos)
+		{
+#ifdef COMPUTERCARD_HAS_INTERP
+			if (ComputerCard::interpOwner[get_core_num()] != this) Configure();
+			interp1->accum[0] = pos;
+			interp1->accum[1] = pos + (1u << FracBits);
+			interp0->base[0] = *(const int16_t *)(interp1->peek[0]);
+			interp0->base[1] = *(const int16_t *)(interp1->peek[1]);
+			interp0->accum[1] = pos;
+			return int32_t(interp0->peek[1]);
+#else
+			constexpr uint32_t mask = (1u << SizeBits) - 1;
+			uint32_t index = (pos >> FracBits) & mask;
+			int32_t alpha = (pos >> (FracBits - 8)) & 0xFF;
+			int32_t s1 = buf[index];
+			int32_t s2 = buf[(index + 1) & mask];
+			return s1 + (((s2 - s1) * alpha) >> 8);
+#endif
+		}
+
+	private:
+#ifdef COMPUTERCARD_HAS_INTERP
+		void __not_in_flash_func(Configure)()
+		{
+			// INTERP1 lanes 0 and 1: byte address of sample at (accum >> FracBits) mod 2^SizeBits
+			interp_config addr = interp_default_config();
+			interp_config_set_shift(&addr, FracBits - 1);
+			interp_config_set_mask(&addr, 1, SizeBits);
+			interp_set_config(interp1, 0, &addr);
+			interp_set_config(interp1, 1, &addr);
+			interp1->base[0] = uintptr_t(buf);
+			interp1->base[1] = uintptr_t(buf);
+
+			// INTERP0 blend: lane 1 gives BASE0 + (BASE1 - BASE0) * alpha / 256,
+			// with alpha the top 8 bits of the fraction
+			interp_config blend = interp_default_config();
+			interp_config_set_blend(&blend, true);
+			interp_set_config(interp0, 0, &blend);
+			blend = interp_default_config();
+			interp_config_set_signed(&blend, true);
+			interp_config_set_shift(&blend, FracBits - 8);
+			interp_config_set_mask(&blend, 0, 7);
+			interp_set_config(interp0, 1, &blend);
+
+			ComputerCard::interpOwner[get_core_num()] = this;
+		}
+#endif
+
+		const int16_t *buf;
+	};
+
+	/** \brief Interpolated read from a circular delay line of 2^SizeBits int16_t samples
+
+		Positions are in 1/256ths of a sample. ReadDelayed reads the point a given
+		(fractional) delay before the given write index.
+	*/
+	template <int SizeBits>
+	class InterpDelayReader : public InterpReader<SizeBits, 8>
+	{
+	public:
+		InterpDelayReader(const int16_t *buffer) : InterpReader<SizeBits, 8>(buffer) {}
+
+		/// Return delay line value delay256/256 samples before writeIndex
+		int32_t __not_in_flash_func(ReadDelayed)(uint32_t writeIndex, uint32_t delay256)
+		{
+			return this->Read((writeIndex << 8) - delay256);
+		}
+	};
+
+	/** \brief Wavetable oscillator, reading a table of 2^SizeBits int16_t samples with interpolation
+
+		Phase is a 32-bit unsigned integer, with 2^32 corresponding to one cycle of the table.
+	*/
+	template <int SizeBits>
+	class InterpTableOsc : public InterpReader<SizeBits, 32 - SizeBits>
+	{
+	public:
+		InterpTableOsc(const int16_t *table) : InterpReader<SizeBits, 32 - SizeBits>(table), phase(0), increment(0) {}
+
+		/// Set phase increment per sample (2^32 * frequency / sample rate)
+		void SetIncrement(uint32_t inc) {increment = inc;}
+		/// Set current phase
+		void SetPhase(uint32_t ph) {phase = ph;}
+		uint32_t Phase() const {return phase;}
+
+		/// Return interpolated table value at current phase, then advance phase by one sample
+		int32_t __not_in_flash_func(Next)()
+		{
+			int32_t val = this->Read(phase);
+			phase += increment;
+			return val;
+		}
+
+		/// Write n samples of output to out
+		void __not_in_flash_func(Render)(int16_t *out, int n)
+		{
+			for (int i=0; i<n; i++) out[i] = int16_t(Next());
+		}
+
+	private:
+		uint32_t phase, increment;
+	};
+
+#ifdef COMPUTERCARD_HAS_MULTICORE
+	/** \brief Run a member function of the card on the second RP2040 core
+
+		Typically called from the card's constructor, e.g. RunOnCore1(&MyCard::SlowLoop);
+		The function usually loops forever, exchanging data with ProcessSample through Ring buffers.
+	*/
+	template <class C>
+	void RunOnCore1(void (C::*fn)())
+	{
+		static C *card;
+		static void (C::*method)();
+		card = static_cast<C *>(this);
+		method = fn;
+		RunOnCore1(+[]() { (card->*method)(); });
+	}
+
+	/// Run a function on the second RP2040 core
+	void RunOnCore1(void (*fn)())
+	{
+#ifdef COMPUTERCARD_SOAK
+		soakOwnLoop = true;
+#endif
+		if (audioOnCore1)
+		{
+			// Swapped with the audio, see EnableAudioOnCore1
+			core0Fn = fn;
+			return;
+		}
+		PaintCore1Stack();
+		multicore_launch_core1(fn);
+	}
+
+	/// Start the tasks given to AddCore1Task, on the second RP2040 core
+	void RunCore1Tasks() {RunOnCore1(&ComputerCard::Core1TaskLoop);}
+
+	/** \brief Use before Run() and RunOnCore1 to run the audio engine on core 1, leaving core 0 for USB, flash and UI
+
+		Run then claims the audio interrupts (DMA_IRQ_0, and the CV PWM wrap) on core 1, where
+		ProcessSample or ProcessBlock are called, and the function given to RunOnCore1 (or the
+		tasks of RunCore1Tasks) runs on core 0 instead, so the two swap cores. Interrupts that
+		code enables, such as TinyUSB's, then never delay audio. Core 1's stack is
+		PICO_CORE1_STACK_SIZE (2kB by default), which must hold the callback's locals. Run
+		returns once both the audio (Abort) and the core 0 function have finished.
+	*/
+	void EnableAudioOnCore1() {audioOnCore1 = true;}
+#endif
+
+protected:
+	/// Callback, called once per sample, at 48kHz unless another rate is given to Run
+	virtual void ProcessSample() {}
+
+	/** \brief Callback, called every control period (see EnableControlRate)
+
+		Runs on the audio interrupt, immediately before ProcessSample/ProcessBlock,
+		so it should be used for work that need not happen every sample:
+		reading knobs and CV, and computing parameters, with Smoothed
+		to interpolate them at audio rate.
+	*/
+	virtual void ProcessControl() {}
+
+	/** \brief Callback, called every factor samples (see EnableSubRate)
+
+		Reads the decimated audio inputs with SubRateIn, and writes its audio outputs, to be
+		interpolated back up, with SubRateOut.
+	*/
+	virtual void ProcessSubRate() {}
+
+	/// Audio input i, decimated to the sub-rate, for ProcessSubRate
+	int16_t __not_in_flash_func(SubRateIn)(int i) {return int16_t(subRateIn[i ? 1 : 0]);}
+
+	/// Write audio output i at the sub-rate, from ProcessSubRate (-2048 to 2047)
+	void __not_in_flash_func(SubRateOut)(int i, int16_t val) {subRateOut[i ? 1 : 0] = val;}
+
+	/// Callback, called by PollMIDIEvents for each queued MIDI message when it is due
+	virtual void ProcessMIDI(const MIDIEvent &event) {(void)event;}
+
+	/** \brief Callback, called when the normalisation probe finds a jack plugged into or removed from input i
+
+		Runs on the audio interrupt, before ProcessSample/ProcessBlock.
+	*/
+	virtual void ConnectionChanged(Input i, bool isConnected) {(void)i; (void)isConnected;}
+
+	/** \brief Callback, called once per block of blockSize frames, if COMPUTERCARD_BLOCK_SIZE > 1
+
+		in[] holds the audio inputs for each frame, and the audio outputs for each frame
+		should be written to out[]. Knobs, switch, CV and pulse inputs are updated once per block.
+		The default implementation calls ProcessSample once for each frame.
+	*/
+	virtual void ProcessBlock(const Frame *in, Frame *out, int n)
+	{
+		for (int i=0; i<n; i++)
+		{
+			adcInL = in[i].audio[0];
+			adcInR = in[i].audio[1];
+			ProcessSample();
+			out[i].audio[0] = dacOut[0];
+			out[i].audio[1] = dacOut[1];
+
+			// Edges and switch changes are only reported on the first frame of the block
+			last_pulse[0] = pulse[0];
+			last_pulse[1] = pulse[1];
+			lastSwitchVal = switchVal;
+		}
+	}
+
+
+	/// Read knob position (returns 0-4095)
+	int32_t __not_in_flash_func(KnobVal)(Knob ind) {return knobs[ind];}
+
+	/// Read switch position
+	Switch __not_in_flash_func(SwitchVal)() {return switchVal;}
+
+	/// Read switch position
+	bool __not_in_flash_func(SwitchChanged)() {return switchVal != lastSwitchVal;}
+
+	/// Bits in the mask returned by ControlsChanged
+	enum ControlChange {ChangedMain = 1, ChangedX = 2, ChangedY = 4, ChangedSwitch = 8, ChangedCV1 = 16, ChangedCV2 = 32};
+
+	/** \brief Knobs, switch and CV inputs that have changed since the last call, as ControlChange bits
+
+		Call from ProcessSample, ProcessBlock or ProcessControl, to skip work that depends only
+		on controls that are still. Without EnableAdaptiveSmoothing, ADC noise means knobs and
+		CV are reported as changing nearly all the time.
+	*/
+	uint32_t __not_in_flash_func(ControlsChanged)()
+	{
+		uint32_t c = controlsChanged;
+		controlsChanged = 0;
+		return c;
+	}
+
+	/// True if the given control (a ControlChange bit) has changed since it was last checked, by Changed or ControlsChanged
+	bool __not_in_flash_func(Changed)(ControlChange c)
+	{
+		bool changed = controlsChanged & c;
+		controlsChanged &= ~uint32_t(c);
+		return changed;
+	}
+
+
+	/// Set Audio output (values -2048 to 2047)
+	void __not_in_flash_func(AudioOut)(int i, int16_t val)
+	{
+		dacOut[i] = val;
+	}
+	
+	/// Set Audio 1 output (values -2048 to 2047)
+	void __not_in_flash_func(AudioOut1)(int16_t val)
+	{
+		dacOut[0] = val;
+	}
+	
+	/// Set Audio 2 output (values -2048 to 2047)
+	void __not_in_flash_func(AudioOut2)(int16_t val)
+	{
+		dacOut[1] = val;
+	}
+
+	
+	/// Set CV output (values -2048 to 2047)
+	void __not_in_flash_func(CVOut)(int i, int16_t val)
+	{
+		if (val<-2048) val = -2048;
+		if (val > 2047) val = 2047;
+		cvValue[i] = (2047-val)<<7;
+	}
+	
+	/// Set CV 1 output (values -2048 to 2047)
+	void __not_in_flash_func(CVOut1)(int16_t val)
+	{
+		if (val<-2048) val = -2048;
+		if (val > 2047) val = 2047;
+		cvValue[0] = (2047-val)<<7;
+	}
+	
+	/// Set CV 2 output (values -2048 to 2047)
+	void __not_in_flash_func(CVOut2)(int16_t val)
+	{
+		if (val<-2048) val = -2048;
+		if (val > 2047) val = 2047;
+		cvValue[1] = (2047-val)<<7;
+	}
+
+		
+	/// Set CV output (values -262144 to 262143)
+	void __not_in_flash_func(CVOutPrecise)(int i, int32_t val)
+	{
+		if (val<-262144) val = -262144;
+		if (val > 262143) val = 262143;
+		cvValue[i] = 262143-val;
+	}
+	
+	/// Set CV 1 output (values -262144 to 262143)
+	void __not_in_flash_func(CVOut1Precise)(int32_t val)
+	{
+		if (val<-262144) val = -262144;
+		if (val > 262143) val = 262143;
+		cvValue[0] = 262143-val;
+	}
+	
+	/// Set CV 2 output (values -262144 to 262143)
+	void __not_in_flash_func(CVOut2Precise)(int32_t val)
+	{
+		if (val<-262144) val = -262144;
+		if (val > 262143) val = 262143;
+		cvValue[1] = 262143-val;
+	}
+
+	/// Set CV output from calibrated MIDI note number (values 0 to 127)
+	void __not_in_flash_func(CVOutMIDINote)(int i, uint8_t noteNum)
+	{
+		cvValue[i] = midiDacTable[i][noteNum & 0x7F];
+	}
+	
+	/// Set CV 1 output from calibrated MIDI note number (values 0 to 127)
+	void __not_in_flash_func(CVOut1MIDINote)(uint8_t noteNum)
+	{
+		cvValue[0] = midiDacTable[0][noteNum & 0x7F];
+	}
+	
+	/// Set CV 2 output from calibrated MIDI note number (values 0 to 127)
+	void __not_in_flash_func(CVOut2MIDINote)(uint8_t noteNum)
+	{
+		cvValue[1] = midiDacTable[1][noteNum & 0x7F];
+	}
+
+	/// Set CV output from calibrated MIDI note number (0 to 127), offset by cents (e.g. pitch bend, glide)
+	void __not_in_flash_func(CVOutMIDINoteCents)(int i, uint8_t noteNum, int32_t cents)
+	{
+		cvValue[i] = CVCodeMIDINoteCents(i, noteNum, cents);
+	}
+
+	/// Calibrated CV output code for a MIDI note number (0 to 127) offset by cents, to precompute for CVOutCode
+	uint32_t __not_in_flash_func(CVCodeMIDINoteCents)(int i, uint8_t noteNum, int32_t cents)
+	{
+		int32_t dacValue = int32_t(midiDacTable[i][noteNum & 0x7F]) + ((cents * calCentsSlope[i]) >> 8);
+		if (dacValue > 524287) dacValue = 524287;
+		if (dacValue < 0) dacValue = 0;
+		return dacValue;
+	}
+
+	/// Set CV output from a calibrated MIDI note number in 16.16 fixed point (e.g. MIDIToCV::Pitch), interpolating between notes
+	void __not_in_flash_func(CVOutMIDIPitch)(int i, int32_t pitch)
+	{
+		cvValue[i] = CVCodeMIDIPitch(i, pitch);
+	}
+
+	/// Calibrated CV output code for a MIDI note number (0 to 127) in 16.16 fixed point, to precompute for CVOutCode
+	uint32_t __not_in_flash_func(CVCodeMIDIPitch)(int i, int32_t pitch)
+	{
+		if (pitch <= 0) return midiDacTable[i][0];
+		if (pitch >= (127 << 16)) return midiDacTable[i][127];
+		int n = pitch >> 16;
+		int32_t a = midiDacTable[i][n], b = midiDacTable[i][n + 1];
+		return uint32_t(a + int32_t((int64_t(b - a) * (pitch & 0xFFFF)) >> 16));
+	}
+
+	/// Set CV output from a code returned by CVCodeMIDINoteCents
+	void __not_in_flash_func(CVOutCode)(int i, uint32_t code)
+	{
+		cvValue[i] = code;
+	}
+	
+	/// Set Pulse output (true = on). With EnablePulseEngine, also cancels any pulses scheduled on it
+	void __not_in_flash_func(PulseOut)(int i, bool val)
+	{
+		if (usePulseEngine) SetPulseEngineOutput(i, val);
+		else gpio_put(PULSE_1_RAW_OUT + i, !val);
+	}
+	
+	/// Set Pulse 1 output (true = on)
+	void __not_in_flash_func(PulseOut1)(bool val)
+	{
+		PulseOut(0, val);
+	}
+	
+	/// Set Pulse 2 output (true = on)
+	void __not_in_flash_func(PulseOut2)(bool val)
+	{
+		PulseOut(1, val);
+	}
+
+	/// With EnablePulseAudio, set pulse output i to val (-2048 to 2047), in frame of the block (0 in ProcessSample)
+	void __not_in_flash_func(PulseAudioOut)(int i, int16_t val, int frame = 0)
+	{
+		int32_t v = val < -2048 ? -2048 : (val > 2047 ? 2047 : val);
+		pulseAudioWrite[2*frame + i] = uint16_t((v + 2048) >> 4);
+	}
+
+	/** \brief With EnablePulseEngine, schedule a pulse lengthUs long on pulse output i
+
+		The pulse starts offset/65536 samples after the start of the next sample (or block),
+		so a whole sample later than PulseOut, but without its jitter. Replaces any pulse
+		still scheduled or playing on that output. E.g. for a trigger echoing a
+		PulseInRisingEdge a fixed two samples later, use offset = 65536 - PulseInRisingEdgeOffset(i)
+		with EnablePulseCapture.
+	*/
+	void __not_in_flash_func(PulseOutTrigger)(int i, uint32_t lengthUs, uint32_t offset = 0)
+	{
+		PulseOutBurst(i, 1, lengthUs, lengthUs, offset);
+	}
+
+	/** \brief With EnablePulseEngine, schedule count pulses lengthUs long, one every periodUs, on pulse output i
+
+		For ratchets and other bursts; timed as PulseOutTrigger. There is always a gap of at
+		least a few processor cycles between pulses, whatever periodUs.
+	*/
+	void __not_in_flash_func(PulseOutBurst)(int i, uint32_t count, uint32_t lengthUs, uint32_t periodUs, uint32_t offset = 0)
+	{
+		if (!usePulseEngine || !count) return;
+		ScheduledPulses &p = scheduledPulses[i];
+		p.pending = false;
+		p.count = count;
+		p.length = lengthUs * pulseCyclesPerUs;
+		uint32_t period = periodUs * pulseCyclesPerUs;
+		p.gap = (period > p.length) ? period - p.length : 0;
+		p.delay = uint32_t((uint64_t(offset) * pulseCyclesPerSampleQ8) >> 24);
+		p.pending = true;
+	}
+	
+	/// Return audio in (-2048 to 2047)
+	int16_t __not_in_flash_func(AudioIn)(int i){return i?adcInR:adcInL;}
+	
+	/// Return audio in 1 (-2048 to 2047)
+	int16_t __not_in_flash_func(AudioIn1)(){return adcInL;}
+
+	/// Return audio in 1 (-2048 to 2047)
+	int16_t __not_in_flash_func(AudioIn2)(){return adcInR;}
+
+	/// Return CV in (-2048 to 2047)
+	int16_t __not_in_flash_func(CVIn)(int i){return cv[i];}
+	
+	/// Return CV in 1 (-2048 to 2047)
+	int16_t __not_in_flash_func(CVIn1)(){return cv[0];}
+
+	/// Return CV in 2 (-2048 to 2047)
+	int16_t __not_in_flash_func(CVIn2)(){return cv[1];}
+
+	/** \brief Return CV in, unsmoothed (-2048 to 2047)
+
+		The latest reading of CV input i, updated each time the mux reads it (every other sample
+		by default, or nearly every sample for one input with EnableFastCV), for audio-rate
+		modulation. In block mode, the average over the last block in which it was read.
+	*/
+	int16_t __not_in_flash_func(CVInFast)(int i){return cvFast[i];}
+
+	/// A measured point for SetCVInCalibration: the CVIn value read with a known voltage at the input
+	struct CVInCalPoint
+	{
+		int16_t cvIn;
+		int16_t millivolts;
+	};
+
+	/** \brief Return the pitch at CV input i, for 1V/octave sources, as a MIDI note number in 16.16 fixed point
+
+		0V is middle C (60 << 16). Read from a table of the pitch at every 64th CVIn value,
+		interpolated linearly, so calibrated (by SetCVInCalibration, otherwise nominally
+		±6V over the input range) at the cost of one table lookup, with no floating point.
+		Suits CVOutMIDIPitch, for calibrated pitch tracking from input to output.
+	*/
+	int32_t __not_in_flash_func(CVInPitchQ16)(int i){return CVInPitch(i, cv[i]);}
+
+	/// Return the nearest MIDI note to the pitch at CV input i (see CVInPitchQ16), e.g. for a quantiser
+	int __not_in_flash_func(CVInNote)(int i){return (CVInPitchQ16(i) + 32768) >> 16;}
+
+	/** \brief Calibrate CV input i for CVInPitchQ16 and CVInNote from n measured points
+
+		Each point is the CVIn value read with a known voltage at the input (e.g. a calibrated
+		CVOutMIDINote patched to it), so the table follows the input's own offset, gain and any
+		curvature between points; beyond the end points, it extends the end segments. Points
+		need not be in order. Returns false, leaving the calibration unchanged, for fewer than
+		two points or two at the same CVIn value. Cards keep the points with their own settings,
+		and pass them again at startup.
+	*/
+	bool SetCVInCalibration(int i, const CVInCalPoint *points, int n);
+
+	/// Return CV input i to its nominal calibration, ±6V over the full range of CVIn
+	void ResetCVInCalibration(int i);
+
+	/// Pitch (see CVInPitchQ16) at CV input i, for a given CVIn value
+	int32_t __not_in_flash_func(CVInPitch)(int i, int32_t cvIn)
+	{
+		uint32_t u = uint32_t(cvIn + 2048);
+		int32_t a = cvInPitchTable[i][u >> 6], b = cvInPitchTable[i][(u >> 6) + 1];
+		return a + (((b - a) * int32_t(u & 63)) >> 6);
+	}
+
+	/// Read pulse in
+	bool __not_in_flash_func(PulseIn)(int i){return pulse[i];}
+	/// Return true for one sample on pulse rising edge
+	bool __not_in_flash_func(PulseInRisingEdge)(int i){return pulse[i] && !last_pulse[i];}
+	/// Return true for one sample on pulse falling edge
+	bool __not_in_flash_func(PulseInFallingEdge)(int i){return !pulse[i] && last_pulse[i];}
+
+	/// Read pulse in 1
+	bool __not_in_flash_func(PulseIn1)(){return pulse[0];}
+	/// Return true for one sample on pulse 1 rising edge
+	bool __not_in_flash_func(PulseIn1RisingEdge)(){return pulse[0] && !last_pulse[0];}
+	/// Return true for one sample on pulse 1 falling edge
+	bool __not_in_flash_func(PulseIn1FallingEdge)(){return !pulse[0] && last_pulse[0];}
+
+	/// Read pulse in 2
+	bool __not_in_flash_func(PulseIn2)(){return pulse[1];}
+	/// Return true for one sample on pulse 2 falling edge
+	bool __not_in_flash_func(PulseIn2FallingEdge)(){return !pulse[1] && last_pulse[1];}
+	/// Return true for one sample on pulse 2 rising edge
+	bool __not_in_flash_func(PulseIn2RisingEdge)(){return pulse[1] && !last_pulse[1];}
+
+	/** \brief With EnablePulseCapture, how long before the current sample the last rising edge on pulse input i happened
+
+		In 1/65536ths of a sample, so 0 to 65536 when PulseInRisingEdge(i) is true (in block
+		mode, 0 to blockSize * 65536, back from the end of the block). E.g. a clock follower
+		or hard-synced oscillator can start its new cycle this far in. Zero without
+		EnablePulseCapture.
+	*/
+	uint32_t __not_in_flash_func(PulseInRisingEdgeOffset)(int i){return pulseEdgeOffset[i][0];}
+	/// As PulseInRisingEdgeOffset, for the last falling edge on pulse input i
+	uint32_t __not_in_flash_func(PulseInFallingEdgeOffset)(int i){return pulseEdgeOffset[i][1];}
+
+
+	/// Return true if jack connected to input
+	bool __not_in_flash_func(Connected)(Input i){return connected[i];}
+	/// Return true if no jack connected to input
+	bool __not_in_flash_func(Disconnected)(Input i){return !connected[i];}
+
+
+	/// Set LED brightness, values 0-4095
+	// Led numbers are:
+	// 0 1
+	// 2 3
+	// 4 5
+	void __not_in_flash_func(LedBrightness)(uint32_t index, uint16_t value)
+	{
+		if (useLedEngine) SetLedLevel(index, value);
+		else pwm_set_gpio_level(leds[index], (value*value)>>8);
+	}
+	
+	/// Turn LED on/off
+	void __not_in_flash_func(LedOn)(uint32_t index, bool value = true)
+	{
+		if (useLedEngine) SetLedLevel(index, value ? 4095 : 0);
+		else pwm_set_gpio_level(leds[index], value?65535:0);
+	}
+
+	/// Turn LED off
+	void __not_in_flash_func(LedOff)(uint32_t index)
+	{
+		LedOn(index, false);
+	}
+
+	/** \brief With EnableLedEngine, fade LED index from its current brightness to value (0-4095) over ms milliseconds
+
+		Setting the LED directly, with LedBrightness, LedOn or LedOff, stops the fade.
+	*/
+	void __not_in_flash_func(LedFade)(uint32_t index, uint16_t value, uint32_t ms)
+	{
+		if (!useLedEngine) return;
+		int32_t frames = int32_t((ms * uint32_t(ledRefreshHz)) / 1000);
+		if (frames < 1) frames = 1;
+		ledMeterActive[index & 1] = false;
+		ledFadeTarget[index] = int32_t(value) << 16;
+		ledFadeStep[index] = (ledFadeTarget[index] - ledLevel[index]) / frames;
+		ledFadeFrames[index] = frames;
+	}
+
+	/** \brief With EnableLedEngine, show level (0-4095) on a column of LEDs (0 = left, 1 = right) as a bar graph
+
+		For a VU or CV meter. Can be called as often as every sample: the engine takes the
+		peak level since its last refresh, and lets the bar fall back over about 300ms.
+		Setting an LED in the column directly stops the meter.
+	*/
+	void __not_in_flash_func(LedMeter)(int column, uint16_t level)
+	{
+		if (level > ledMeterPeak[column]) ledMeterPeak[column] = level;
+		ledMeterActive[column] = true;
+	}
+
+	/// Display average (left column) and maximum (right column) load meter values on LEDs, as bar graphs
+	void LedsShowLoad()
+	{
+		if (!loadBudgetCycles) return;
+		// Each column has three LEDs, each covering a third of the available time
+		uint32_t avg = ((loadAvgCycles8 >> 8) * 3 * 4095) / loadBudgetCycles;
+		uint32_t max = (loadMaxCycles * 3 * 4095) / loadBudgetCycles;
+		for (int i=0; i<3; i++)
+		{
+			// Bottom LED first
+			int32_t a = int32_t(avg) - (2-i) * 4095;
+			int32_t m = int32_t(max) - (2-i) * 4095;
+			LedBrightness(2*i, a < 0 ? 0 : (a > 4095 ? 4095 : a));
+			LedBrightness(2*i+1, m < 0 ? 0 : (m > 4095 ? 4095 : m));
+		}
+	}
+
+	// Return power state of USB port
+	USBPowerState_t USBPowerState()
+	{
+		if (HardwareVersion() != Rev1_1)
+			return Unsupported;
+		else if (gpio_get(USB_HOST_STATUS))
+			return UFP;
+		else
+			return DFP;
+	}
+
+	/// Return hardware version
+	HardwareVersion_t HardwareVersion() {return hw;}
+
+	/// Return ID number unique to flash card
+	uint64_t UniqueCardID()	{return uniqueID;}	
+	
+	void Abort();
+
+	/** \brief Stop this card and run card number card of the CardLauncher instead
+
+		May be called from anywhere, including ProcessSample. Numbers past the last card wrap to the first.
+	*/
+	static void SwitchCard(int card);
+
+	/// Number of the card running under CardLauncher (0 otherwise)
+	static int CurrentCard() {return cardIndex;}
+
+	uint16_t CRCencode(const uint8_t *data, int length);
+
+private:
+	
+	typedef struct
+	{
+		float m, b;
+		int32_t mi, bi;
+	} CalCoeffs;
+
+	typedef struct
+	{
+		int32_t dacSetting;
+		int8_t voltage;
+	} CalPoint;
+
+	static constexpr int calMaxChannels = 2;
+	static constexpr int calMaxPoints = 10;
+
+	static volatile uint32_t cvValue[2];
+	
+	uint8_t numCalibrationPoints[calMaxChannels];
+	CalPoint calibrationTable[calMaxChannels][calMaxPoints];
+	CalCoeffs calCoeffs[calMaxChannels];
+
+	// Calibrated CV output value for each MIDI note, and change in CV output value per cent (Q8), built by CalcCalCoeffs
+	uint32_t midiDacTable[calMaxChannels][128];
+	int32_t calCentsSlope[calMaxChannels];
+
+	// Pitch (MIDI note, Q16) at every 64th CVIn value from -2048 to 2048, see CVInPitchQ16
+	int32_t cvInPitchTable[2][65];
+
+	uint64_t uniqueID;
+	
+	uint8_t ReadByteFromEEPROM(unsigned int eeAddress);
+	int ReadIntFromEEPROM(unsigned int eeAddress);
+	void CalcCalCoeffs(int channel);
+	void CalcMIDIDacTable(int channel);
+	int ReadEEPROM();
+
+#ifdef COMPUTERCARD_CALIBRATION_CACHE
+	// Calibration kept in flash, see COMPUTERCARD_CALIBRATION_CACHE, with the CRC of the EEPROM
+	// contents it came from, and its own CRC (CRCencode) of everything following
+	struct CalCache
+	{
+		uint32_t magic;
+		uint16_t eepromCRC, crc;
+		uint8_t numCalibrationPoints[calMaxChannels];
+		CalPoint calibrationTable[calMaxChannels][calMaxPoints];
+		CalCoeffs calCoeffs[calMaxChannels];
+		int32_t calCentsSlope[calMaxChannels];
+	};
+	static_assert(sizeof(CalCache) <= FLASH_PAGE_SIZE, "CalCache must fit in one flash page");
+	static constexpr uint32_t calCacheMagic = 0x43434331; // "CCC1"
+	static constexpr uint32_t calCacheOffset = PICO_FLASH_SIZE_BYTES - (COMPUTERCARD_CALIBRATION_CACHE + 1) * FLASH_SECTOR_SIZE;
+	bool LoadCalibrationCache(uint16_t eepromCRC);
+	void SaveCalibrationCache(uint16_t eepromCRC);
+#endif
+	uint32_t MIDIToDac(int midiNote, int channel);
+	
+	HardwareVersion_t hw;
+	HardwareVersion_t ProbeHardwareVersion();
+	
+	int16_t dacOut[2];
+	
+	volatile int32_t knobs[4] = { 0, 0, 0, 0 }; // 0-4095
+	volatile bool pulse[2] = { 0, 0 };
+	volatile bool last_pulse[2] = { 0, 0 };
+
+	// PIO pulse edge timestamps, see EnablePulseCapture
+	bool usePulseCapture;
+	volatile uint32_t pulseEdgeOffset[2][2] = {{0, 0}, {0, 0}}; // [input][rising, falling], Q16 samples
+#ifdef COMPUTERCARD_HAS_PIO
+	PIO pulseCapturePIO;
+	uint pulseCaptureSM[2], pulseCaptureOffset;
+#endif
+	uint32_t pulseCapturePeriod; // state machine counts (two processor cycles) per sample/block
+	uint32_t pulseCaptureScale;  // samples per count, Q24
+	bool StartPulseCapture(uint32_t frameADCCycles);
+	void StopPulseCapture();
+	void __not_in_flash_func(ReadPulseCapture)();
+
+	// PIO mux sequencing, see EnableMuxSequencer
+	bool useMuxSequencer;
+#ifdef COMPUTERCARD_HAS_PIO
+	PIO muxSeqPIO;
+	uint muxSeqSM[2], muxSeqOffset;  // mux address, frame timer
+	uint muxSeqDMA;
+	uint32_t muxSeqDelay;            // state machine cycles from the end of a frame to the mux step
+#endif
+	bool StartMuxSequencer(uint32_t conversionADCCycles);
+	void StopMuxSequencer();
+	void __not_in_flash_func(SetMuxAddress)(int state);
+
+	// LED frame buffer, see EnableLedEngine. Levels are 0-4095, << 16
+	bool useLedEngine;
+	int32_t ledRefreshHz, ledPeriod, ledCount, ledMeterDecay;
+	int32_t ledLevel[numLeds] = {0, 0, 0, 0, 0, 0};
+	int32_t ledFadeTarget[numLeds], ledFadeStep[numLeds];
+	int32_t ledFadeFrames[numLeds] = {0, 0, 0, 0, 0, 0};
+	uint16_t ledMeterPeak[2] = {0, 0}, ledMeterLevel[2] = {0, 0};
+	bool ledMeterActive[2] = {false, false};
+	void __not_in_flash_func(SetLedLevel)(uint32_t index, uint16_t value)
+	{
+		ledFadeFrames[index] = 0;
+		ledMeterActive[index & 1] = false;
+		ledLevel[index] = int32_t(value) << 16;
+	}
+	void __not_in_flash_func(PollLeds)()
+	{
+		ledCount += blockSize;
+		if (ledCount >= ledPeriod)
+		{
+			ledCount = 0;
+			UpdateLeds();
+		}
+	}
+	void __not_in_flash_func(UpdateLeds)();
+
+	// PIO pulse output generator, see EnablePulseEngine
+	struct ScheduledPulses
+	{
+		uint32_t delay, count, length, gap; // processor cycles, apart from count
+		volatile bool pending;
+	};
+	bool usePulseEngine;
+	ScheduledPulses scheduledPulses[2];
+#ifdef COMPUTERCARD_HAS_PIO
+	PIO pulseEnginePIO;
+	uint pulseEngineSM[2], pulseEngineOffset;
+	static bool ClaimPIO(const pio_program_t *program, PIO &pio, uint sm[2], uint &offset);
+#endif
+	uint32_t pulseCyclesPerUs, pulseCyclesPerSampleQ8;
+	bool StartPulseEngine(uint32_t frameADCCycles);
+	void StopPulseEngine();
+	void __not_in_flash_func(SetPulseEngineOutput)(int i, bool val);
+	void __not_in_flash_func(SendScheduledPulses)();
+
+	// Pulse outputs as PWM audio, see EnablePulseAudio. Pulse 1 and 2 are channels A and B
+	// of one PWM slice, so each frame of pulseAudioBuffer is one compare register word.
+	// In block mode, two chained DMA channels stream the halves, as for spi_block_dma
+	bool usePulseAudio;
+	uint16_t pulseAudioBuffer[2][2*blockSize] __attribute__((aligned(4*blockSize)));
+	uint16_t *pulseAudioWrite;
+	uint8_t pulseAudioDMA[2];
+	uint8_t pulseAudioTimer;
+	void StartPulseAudio(uint32_t frameADCCycles);
+	void StopPulseAudio();
+
+	// Audio link over the debug pins, see EnableAudioLink. Each frame is a header word (0xA5,
+	// sequence number, checksum), the control word, then two channels per word for each sample.
+	// The receiving DMA channel writes into linkRing continuously; linkQueue holds the positions
+	// (counted in words received, ever) of frames checked and waiting to be played
+	bool useAudioLink;
+#ifdef COMPUTERCARD_LINK
+	static_assert(COMPUTERCARD_LINK >= 1 && COMPUTERCARD_LINK <= 4, "COMPUTERCARD_LINK must be 1 to 4 channels");
+	static constexpr int linkFrameStride = (COMPUTERCARD_LINK + 1) / 2;
+	static constexpr int linkFrameWords = 2 + blockSize * linkFrameStride;
+	static constexpr int linkQueueSize = 8;
+	static constexpr int linkRingWords = 8 * linkFrameWords <= 256 ? 256 : 1 << (32 - __builtin_clz(uint32_t(8 * linkFrameWords - 1)));
+	static inline uint32_t linkRing[linkRingWords] __attribute__((aligned(4 * linkRingWords)));
+	uint32_t linkTx[2][linkFrameWords];
+	uint32_t *linkTxWrite;
+	int linkTxPhase, linkLatency;
+	uint32_t linkReceived, linkParsed, linkLastWrite;
+	uint32_t linkQueue[linkQueueSize], linkQueueHead, linkQueueTail;
+	uint32_t linkPlaying;             // position of the frame LinkIn reads
+	int linkIdle;                     // callbacks since the last frame arrived
+	volatile bool linkConnected;
+	uint8_t linkSeqOut, linkSeqIn;
+	volatile uint32_t linkFrames, linkErrors, linkSlips;
+	volatile int32_t linkQueued;
+#endif
+#ifdef COMPUTERCARD_HAS_PIO
+	PIO linkPIO;
+	uint linkSM[2], linkOffset;       // transmit, receive
+#endif
+	uint linkDMA[2];                  // transmit, receive
+	bool StartAudioLink();
+	void StopAudioLink();
+	void __not_in_flash_func(ReceiveLink)();
+	void __not_in_flash_func(SendLink)();
+	uint8_t ClaimFrameTimer(uint32_t wordsPerFrame, uint32_t frameADCCycles);
+
+	// Latency measurement, see MeasureLatency. Each cycle of latencyPeriod frames holds a step
+	// for latencyHold frames from its start, and takes the input's level without it from the
+	// last latencyBaseFrames. Both are whole blocks, so in block mode a cycle starts a callback
+	enum LatencyMode {LatencyIdle, LatencyLoopback, LatencyProbe};
+	static constexpr int latencySteps = 8;
+	static constexpr int32_t latencyHold = ((4 * blockSize + 128 + blockSize - 1) / blockSize) * blockSize;
+	static constexpr int32_t latencyPeriod = 2 * latencyHold + 1024;
+	static constexpr int32_t latencyBaseFrames = 256;
+	static constexpr int16_t latencyStepLevel = 1024;
+	volatile LatencyMode latencyMode;
+	int latencyOut, latencyIn;
+	int32_t latencyCount;             // frame in the current cycle
+	int latencyStep;                  // 0 measures the step's height, 1 to latencySteps are timed
+	int32_t latencyBaseSum, latencyBase, latencyHeight, latencyLast;
+	bool latencySeen;
+	int32_t latencySum, latencyMin, latencyMax;
+	LatencyStats latencyResult;
+	void StartLatency(LatencyMode mode, int out, int in);
+	void __not_in_flash_func(ServiceLatency)(int16_t in, int16_t &out);
+	volatile int32_t cv[2] = { 0, 0 }; // -2047 - 2048
+	volatile int32_t cvFast[2] = { 0, 0 }; // unsmoothed, see CVInFast
+	volatile int16_t adcInL = 0x800, adcInR = 0x800;
+
+	volatile uint8_t mxPos = 0; // external multiplexer value
+
+	volatile int32_t plug_state[6] = {0,0,0,0,0,0};
+	volatile bool connected[6] = {0,0,0,0,0,0};
+	bool useNormProbe;
+
+	// Normalisation probe bursts, and hysteresis on connection changes
+	static constexpr uint8_t probeHysteresis = 2; // probe periods that must agree before a change
+	ProbeMode probeMode;
+	int32_t probeIntervalMs, probeIntervalSamples, probeBurstSamples;
+	int32_t probeTimer, probeLeft;
+	volatile bool probeRequested;
+	bool normProbeActive;
+	uint8_t plugAgree[6] = {0,0,0,0,0,0};
+	bool __not_in_flash_func(NormProbeBurst)(int32_t periodSamples);
+	void __not_in_flash_func(UpdateConnections)(int32_t expected);
+
+	// Adaptive knob/CV smoothing, and controls changed since ControlsChanged was last called
+	bool useAdaptiveSmoothing;
+	AdaptiveSmoother knobSmoother[4], cvSmoother[2];
+	uint32_t controlsChanged;
+
+	// Boot profile, and setup finished in the background by Run's idle loop (see AddStartupTask)
+	BootTimes bootTimes;
+	typedef bool (ComputerCard::*StartupTask)(int step);
+	StartupTask startupTasks[maxStartupTasks];
+	volatile int numStartupTasks, nextStartupTask;
+	int startupStep;
+
+	// Control rate callback, controlPeriod = 0 if disabled
+	int32_t controlPeriod, controlCount;
+	static inline uint8_t controlShift = 0;
+
+	// Sub-rate callback, see EnableSubRate: a decimator and an interpolator per channel and halving
+	int subRateStages, subRatePos;
+	HalfBand subRateDown[2][3], subRateUp[2][3];
+	int32_t subRateHeld[2][3];             // first of each decimator's pair of inputs
+	bool subRateHalf[3];                   // each decimator holds the first of a pair
+	int32_t subRateIn[2], subRateOut[2];
+	int32_t subRateUpBuf[2][8];            // interpolated outputs for the frames until the next call
+	void __not_in_flash_func(ServiceSubRate)(int16_t inL, int16_t inR, int32_t *out);
+
+	void __not_in_flash_func(PollControl)()
+	{
+		if (controlPeriod)
+		{
+			controlCount += blockSize;
+			if (controlCount >= controlPeriod)
+			{
+				controlCount = 0;
+				ProcessControl();
+			}
+		}
+	}
+
+	// MIDI event queue, filled by QueueMIDI and emptied by PollMIDIEvents
+	Ring<MIDIEvent, 64> midiQueue;
+	uint32_t midiLatency;
+	uint8_t midiStreamStatus = 0; // running status, for QueueMIDIStream
+	bool midiStreamInSysex = false;
+
+	// First frame of the current audio callback, and time (us) at which the callback started.
+	// Written by the audio callback; callbackSeq is odd while they are being written
+	volatile uint32_t callbackFrame = 0, callbackTime = 0, callbackSeq = 0;
+	uint32_t nextFrame = 0;
+
+	// Publish frame counter and time at the start of each audio callback
+	void __not_in_flash_func(StartCallback)()
+	{
+		callbackSeq = callbackSeq + 1;
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		callbackFrame = nextFrame;
+		callbackTime = time_us_32();
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		callbackSeq = callbackSeq + 1;
+#ifdef COMPUTERCARD_RECORD
+		RecordInputs(nextFrame);
+#endif
+		if (syncMode) ServiceSync();
+		if (useAudioLink) ReceiveLink();
+		nextFrame += blockSize;
+	}
+
+	// Frame being played now, from the other core: frame at the start of the current callback,
+	// plus the time since then
+	uint32_t MIDIArrivalFrame()
+	{
+		uint32_t seq, frame, start;
+		do
+		{
+			seq = callbackSeq;
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			frame = callbackFrame;
+			start = callbackTime;
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		} while ((seq & 1) || seq != callbackSeq);
+		uint32_t elapsed = ((time_us_32() - start) * uint32_t(sampleRate)) / 1000000u;
+		return frame + ((elapsed < uint32_t(blockSize)) ? elapsed : uint32_t(blockSize) - 1);
+	}
+
+	// Bytes in a MIDI message with the given status byte (0 for sysex and undefined statuses)
+	static int MIDIMessageLength(uint8_t status)
+	{
+		if (status < 0xF0) return ((status & 0xE0) == 0xC0) ? 2 : 3; // program change and channel pressure are 2 bytes
+		switch (status)
+		{
+		case 0xF1: case 0xF3: return 2;
+		case 0xF2: return 3;
+		case 0xF6: case 0xF8: case 0xFA: case 0xFB: case 0xFC: case 0xFE: case 0xFF: return 1;
+		default: return 0;
+		}
+	}
+
+	// Tracer, see Trace
+	static inline volatile bool tracePaused = false;
+	static inline uint32_t traceMask = ~(1u << TraceCVPWMWrap);
+#ifdef COMPUTERCARD_TRACE
+	static_assert(COMPUTERCARD_TRACE > 0 && (COMPUTERCARD_TRACE & (COMPUTERCARD_TRACE - 1)) == 0,
+				  "COMPUTERCARD_TRACE must be a power of two");
+	struct TraceRing
+	{
+		uint32_t head; // count of records written
+		TraceRecord records[COMPUTERCARD_TRACE];
+	};
+	static inline TraceRing traceRings[2];
+#endif
+
+	// Control input recorder, see RecordingWrite. The ring is a sequence of 256-byte pages, the
+	// oldest overwritten first. Each page starts with a key frame: the frame number of the
+	// sample or block (4 bytes), knobs Main, X, Y and CV 1, 2 (2 bytes each) and the digital
+	// inputs (2 bytes), all little-endian. Records of changes follow, each a header byte whose
+	// bits 0-4 flag the knobs and CVs that changed, bit 5 the digital inputs, and bits 6-7 are
+	// the samples (or blocks) since the last record less one, or 3 for a varint of that less 4.
+	// Then a zigzag varint of the change in each knob and CV flagged, and the digital inputs if
+	// flagged. A zero header ends the page. Digital inputs: bits 0-1 the switch, 2-3 the pulse
+	// inputs, 4-5 rising edges that the pulse levels do not show (a pulse latched within a
+	// block), 6-11 jacks connected.
+#ifdef COMPUTERCARD_RECORD
+	static_assert(COMPUTERCARD_RECORD >= 1024 && (COMPUTERCARD_RECORD & (COMPUTERCARD_RECORD - 1)) == 0,
+				  "COMPUTERCARD_RECORD must be a power of two, at least 1024");
+	static constexpr int recordPageSize = 256, recordNumPages = COMPUTERCARD_RECORD / recordPageSize;
+	static constexpr int recordMaxBytes = 18; // header, 5-byte gap, five 2-byte changes, digital inputs
+	static inline uint8_t recordRing[COMPUTERCARD_RECORD];
+	static inline volatile uint32_t recordPages = 0; // pages started, ever
+	static inline volatile bool recordPaused = false, recordResync = true;
+	int recordPos = 0;
+	uint32_t recordTick = 0;
+	int32_t recordAnalog[5] = {};
+	uint32_t recordDigital = 0;
+
+	void __not_in_flash_func(RecordInputs)(uint32_t frame)
+	{
+		if (recordPaused)
+		{
+			recordResync = true;
+			return;
+		}
+		int32_t a[5] = {knobs[0], knobs[1], knobs[2], cv[0], cv[1]};
+		uint32_t d = uint32_t(switchVal);
+		for (int i=0; i<2; i++)
+		{
+			d |= uint32_t(pulse[i]) << (2 + i);
+			if (pulse[i] && !last_pulse[i] && (recordDigital & (4u << i))) d |= 16u << i;
+		}
+		for (int i=0; i<6; i++) d |= uint32_t(connected[i]) << (6 + i);
+
+		uint32_t changed = (d != recordDigital) ? 32 : 0;
+		for (int i=0; i<5; i++) if (a[i] != recordAnalog[i]) changed |= 1u << i;
+		uint32_t tick = frame / blockSize;
+		if (!changed && !recordResync) return;
+
+		if (recordResync || recordPos + recordMaxBytes > recordPageSize)
+		{
+			// New page, starting with a key frame
+			uint8_t *page = recordRing + (recordPages & (recordNumPages - 1)) * recordPageSize;
+			recordPages = recordPages + 1;
+			memset(page, 0, recordPageSize);
+			for (int i=0; i<4; i++) page[i] = uint8_t(frame >> (8 * i));
+			for (int i=0; i<5; i++)
+			{
+				page[4 + 2*i] = uint8_t(a[i]);
+				page[5 + 2*i] = uint8_t(a[i] >> 8);
+			}
+			page[14] = uint8_t(d);
+			page[15] = uint8_t(d >> 8);
+			recordPos = 16;
+			recordResync = false;
+		}
+		else
+		{
+			uint8_t *page = recordRing + ((recordPages - 1) & (recordNumPages - 1)) * recordPageSize;
+			uint8_t *r = page + recordPos;
+			uint32_t gap = tick - recordTick - 1;
+			*r++ = uint8_t(changed | ((gap < 3 ? gap : 3) << 6));
+			if (gap >= 3)
+			{
+				gap -= 3;
+				while (gap >= 128) {*r++ = uint8_t(gap | 128); gap >>= 7;}
+				*r++ = uint8_t(gap);
+			}
+			for (int i=0; i<5; i++)
+			{
+				if (!(changed & (1u << i))) continue;
+				int32_t delta = a[i] - recordAnalog[i];
+				uint32_t z = (uint32_t(delta) << 1) ^ uint32_t(delta >> 31);
+				while (z >= 128) {*r++ = uint8_t(z | 128); z >>= 7;}
+				*r++ = uint8_t(z);
+			}
+			if (changed & 32)
+			{
+				*r++ = uint8_t(d);
+				*r++ = uint8_t(d >> 8);
+			}
+			recordPos = int(r - page);
+		}
+		recordTick = tick;
+		for (int i=0; i<5; i++) recordAnalog[i] = a[i];
+		recordDigital = d;
+	}
+#endif
+
+	// Soak test, see COMPUTERCARD_SOAK. The stress generator picks a new pattern every 2^14
+	// frames (about a third of a second): each knob and CV sweeps, jumps at random every call,
+	// or holds at one end of its range; pulses toggle every call or two, or at random; audio
+	// inputs carry full-scale noise, a square wave at half the sample rate, silence or full-scale
+	// DC; each jack may be plugged or unplugged (reading zero, as with the normalisation probe);
+	// the switch moves; and most patterns queue a MIDI message every call. The generator is the
+	// only source of MIDI, so QueueMIDI calls from the card are ignored.
+#ifdef COMPUTERCARD_SOAK
+	struct SoakRecord
+	{
+		SoakStats run, longest;
+	};
+	FlashStore<sizeof(SoakRecord), 2> soakStore{COMPUTERCARD_SOAK, 0};
+	SoakRecord soakRecord = {};
+	SoakStats soakLast = {};
+	volatile bool soakClear = false;
+	bool soakOwnLoop = false; // the card runs core 1 itself, so calls SoakService
+	uint32_t soakRng = 0x1234567, soakPattern = 0, soakCalls = 0, soakFrames = 0;
+	uint32_t soakJacks = 0x3F; // bit i: jack i plugged in
+	uint32_t soakBucketCycles = 1;
+
+	// Load the last run, show it on the LEDs, and set up this one
+	void SoakStart()
+	{
+		SoakRecord saved;
+		if (soakStore.Load(&saved, sizeof(saved)))
+		{
+			soakLast = saved.run;
+			soakRecord.longest = saved.run.seconds > saved.longest.seconds ? saved.run : saved.longest;
+		}
+		useLoadMeter = true;
+
+		// Longest call of the last run as a bar of LEDs, one per sixth of the time available
+		// (all six if any call overran), flashing if any did, for three seconds
+		if (soakLast.seconds && soakLast.budgetCycles)
+		{
+			uint32_t lit = (soakLast.maxCycles * 6 + soakLast.budgetCycles - 1) / soakLast.budgetCycles;
+			for (int t=0; t<12; t++)
+			{
+				for (int i=0; i<numLeds; i++)
+					pwm_set_gpio_level(leds[i], (uint32_t(i) < lit && !(soakLast.overruns && (t & 1))) ? 65535 : 0);
+				busy_wait_us_32(250000);
+			}
+			for (int i=0; i<numLeds; i++) pwm_set_gpio_level(leds[i], 0);
+		}
+
+#ifdef COMPUTERCARD_HAS_MULTICORE
+		if (!soakOwnLoop) RunOnCore1(+[]() {while (1) thisptr->SoakService();});
+#endif
+	}
+
+	uint32_t __not_in_flash_func(SoakRandom)()
+	{
+		soakRng ^= soakRng << 13;
+		soakRng ^= soakRng >> 17;
+		soakRng ^= soakRng << 5;
+		return soakRng;
+	}
+
+	// Control i (0-4095) in the given mode, at frame f
+	int32_t __not_in_flash_func(SoakControl)(uint32_t mode, int i, uint32_t f)
+	{
+		switch (mode)
+		{
+		case 0:
+		{
+			// Triangle, full range and back in 2^(11 + i) frames
+			int32_t v = int32_t((f << (21 - i)) >> 19);
+			return v < 4096 ? v : 8191 - v;
+		}
+		case 1: return int32_t(SoakRandom() & 4095);
+		case 2: return 0;
+		default: return 4095;
+		}
+	}
+
+	// Drive the control inputs and MIDI for this call, in place of the hardware
+	void __not_in_flash_func(SoakInputs)()
+	{
+		uint32_t f = nextFrame;
+		SoakStats &s = soakRecord.run;
+		if ((f & 16383) == 0)
+		{
+			// Pattern bits 0-9: knobs and CVs, 2 each; 10-11: pulses; 12-13: audio; 14-15: MIDI;
+			// 16-27: jacks, 2 each; 28-29: switch
+			soakPattern = SoakRandom();
+			uint32_t sw = (soakPattern >> 28) & 3;
+			switchVal = sw == 3 ? Down : Switch(sw);
+			for (int i=0; i<6; i++)
+			{
+				if (((soakPattern >> (16 + 2*i)) & 3) == 0)
+				{
+					soakJacks ^= 1u << i;
+					s.jackChanges++;
+				}
+			}
+		}
+		uint32_t p = soakPattern;
+		for (int i=0; i<6; i++) connected[i] = (soakJacks >> i) & 1;
+		for (int i=0; i<3; i++)
+		{
+			int32_t k = SoakControl((p >> (2*i)) & 3, i, f);
+			if (k != knobs[i]) controlsChanged |= ChangedMain << i;
+			knobs[i] = k;
+		}
+		for (int i=0; i<2; i++)
+		{
+			int32_t c = connected[CV1 + i] ? SoakControl((p >> (6 + 2*i)) & 3, 3 + i, f) - 2048 : 0;
+			if (c != cv[i]) controlsChanged |= ChangedCV1 << i;
+			cv[i] = cvFast[i] = c;
+			bool on = (p & (1u << (10 + i))) ? (SoakRandom() & 1) : ((soakCalls >> i) & 1);
+			pulse[i] = connected[Pulse1 + i] && on;
+		}
+		if (switchVal != lastSwitchVal) controlsChanged |= ChangedSwitch;
+		soakCalls++;
+
+		if ((p >> 14) & 3)
+		{
+			static const uint8_t status[8] = {0x80, 0x90, 0x90, 0xB0, 0xB0, 0xD0, 0xE0, 0xF8};
+			uint32_t r = SoakRandom();
+			MIDIEvent e;
+			e.sample = f;
+			e.cable = 0;
+			e.data[0] = status[r & 7];
+			if (e.data[0] < 0xF0) e.data[0] |= uint8_t((r >> 3) & 15);
+			e.data[1] = uint8_t((r >> 8) & 127);
+			e.data[2] = uint8_t((r >> 16) & 127);
+			e.length = uint8_t(MIDIMessageLength(e.data[0]));
+			if (midiQueue.Push(e)) s.midiQueued++;
+			else s.midiDropped++;
+		}
+
+		// Count seconds, and save every 2^19 frames (about ten seconds)
+		soakFrames += blockSize;
+		if (soakFrames >= uint32_t(sampleRate))
+		{
+			soakFrames -= uint32_t(sampleRate);
+			s.seconds++;
+		}
+		if ((f & 0x7FFFF) == 0 && f)
+		{
+			if (soakClear)
+			{
+				soakRecord.longest = SoakStats{};
+				soakClear = false;
+			}
+			soakStore.Save(&soakRecord, sizeof(soakRecord));
+		}
+	}
+
+	// Audio input ch, for frame i of this call
+	int16_t __not_in_flash_func(SoakAudio)(int ch, int i)
+	{
+		if (!connected[Audio1 + ch]) return 0;
+		switch ((soakPattern >> 12) & 3)
+		{
+		case 0: return int16_t(int32_t(SoakRandom() & 4095) - 2048);
+		case 1: return ((nextFrame + uint32_t(i)) & 1) ? 2047 : -2048;
+		case 2: return 0;
+		default: return ch ? 2047 : -2048;
+		}
+	}
+
+	void __not_in_flash_func(SoakLoad)(uint32_t cycles)
+	{
+		SoakStats &s = soakRecord.run;
+		uint32_t b = soakBuckets - 1;
+		if (cycles < s.budgetCycles)
+		{
+			b = cycles / soakBucketCycles;
+			if (b > soakBuckets - 2) b = soakBuckets - 2;
+		}
+		s.histogram[b]++;
+		if (cycles > s.maxCycles) s.maxCycles = cycles;
+	}
+
+	void __not_in_flash_func(SoakOverrun)()
+	{
+		SoakStats &s = soakRecord.run;
+		if (s.overruns++ == 0) s.firstOverrun = s.seconds;
+		s.lastOverrun = s.seconds;
+	}
+#endif
+
+	// Pause tracing, and call f with each recorded event, both cores merged in time order
+	template <typename F>
+	static void TraceForEach(F f)
+	{
+#ifdef COMPUTERCARD_TRACE
+		tracePaused = true;
+		busy_wait_us_32(2); // let a record being written on the other core finish
+		uint32_t pos[2], end[2];
+		for (int c=0; c<2; c++)
+		{
+			end[c] = traceRings[c].head;
+			pos[c] = end[c] > COMPUTERCARD_TRACE ? end[c] - COMPUTERCARD_TRACE : 0;
+		}
+		while (pos[0] != end[0] || pos[1] != end[1])
+		{
+			const TraceRecord *r[2] = {nullptr, nullptr};
+			for (int c=0; c<2; c++)
+			{
+				if (pos[c] != end[c]) r[c] = &traceRings[c].records[pos[c] & (COMPUTERCARD_TRACE - 1)];
+			}
+			// Earlier of the two, comparing times modulo 2^32
+			int c = !r[0] ? 1 : !r[1] ? 0 : (int32_t(r[1]->time - r[0]->time) < 0);
+			f(*r[c]);
+			pos[c]++;
+		}
+		tracePaused = false;
+#else
+		(void)f;
+#endif
+	}
+
+	// Core 1 scheduler, see AddCore1Task
+	typedef void (ComputerCard::*Core1TaskFn)();
+	struct Core1Task
+	{
+		Core1TaskFn fn;
+		uint32_t period, deadline, due;
+		int priority;
+		TaskStats stats;
+	};
+	Core1Task core1Tasks[maxCore1Tasks];
+	int numCore1Tasks = 0;
+
+	void Core1TaskLoop()
+	{
+		uint32_t now = time_us_32();
+		for (int i=0; i<numCore1Tasks; i++) core1Tasks[i].due = now;
+		while (1)
+		{
+			// The highest priority task that is due, and of those, the one due longest
+			now = time_us_32();
+			Core1Task *next = nullptr;
+			for (int i=0; i<numCore1Tasks; i++)
+			{
+				Core1Task &t = core1Tasks[i];
+				if (int32_t(now - t.due) < 0) continue;
+				if (!next || t.priority > next->priority || (t.priority == next->priority && int32_t(t.due - next->due) < 0)) next = &t;
+			}
+			if (!next)
+			{
+#ifdef COMPUTERCARD_SOAK
+				SoakService();
+#endif
+				tight_loop_contents();
+				continue;
+			}
+
+			uint32_t late = now - next->due;
+			(this->*next->fn)();
+			uint32_t end = time_us_32();
+
+			TaskStats &s = next->stats;
+			uint32_t took = end - now;
+			s.runs++;
+			s.totalUs += took;
+			if (took > s.maxUs) s.maxUs = took;
+			if (next->deadline && late > next->deadline) s.late++;
+			if (late > s.maxLateUs) s.maxLateUs = late;
+
+			next->due += next->period;
+			if (int32_t(end - next->due) > int32_t(next->period)) next->due = end; // fell behind: skip the missed runs
+		}
+	}
+
+	// Stack painting, for MemoryUsage
+	static constexpr uint32_t stackPaint = 0x5AC4C0DE;
+	static inline bool stackPainted[2] = {false, false};
+	static void StackBounds(int core, uint32_t *&bottom, uint32_t *&top);
+	static void PaintStack(int core, uint32_t *end);
+
+	// Load meter
+	bool useLoadMeter;
+	volatile uint32_t loadMinCycles, loadMaxCycles, loadAvgCycles8, loadOverruns;
+	uint32_t loadBudgetCycles;
+
+	// Sample clock sync, see EnableSyncLead and EnableSyncFollow
+	enum SyncMode {SyncOff, SyncLead, SyncFollow};
+	SyncMode syncMode;
+	int syncPin;                  // pulse output (leading) or input (following)
+	int32_t syncPeriod;           // samples between edges, a multiple of blockSize
+	uint32_t syncCount;           // SyncFrame modulo syncPeriod
+	volatile uint32_t syncOffset; // SyncFrame less this card's own count
+	uint32_t syncADCInterval;     // untrimmed ADC clock cycles per conversion
+	int32_t syncKp, syncKi;       // loop gains, Q16: Q16 divider LSBs per Q16 sample of phase error
+	int32_t syncMaxTrim;          // 1000ppm, in Q16 divider LSBs
+	int32_t syncIntegral, syncTrim; // Q16 divider LSBs
+	uint32_t syncDither;          // fraction of a divider LSB carried to the next callback, Q16
+	volatile int32_t syncPhase;
+	volatile int32_t syncGood;    // consecutive edges near their expected time, -1 before the first
+	volatile uint32_t syncRealigns;
+	uint32_t syncEdgeAge;         // samples since the last edge
+
+	void SetupSync();
+	void __not_in_flash_func(ServiceSync)();
+
+	// Record the length of one ProcessSample/ProcessBlock call, from SysTick start/end values
+	void __not_in_flash_func(UpdateLoadMeter)(uint32_t start, uint32_t end)
+	{
+		// SysTick is a 24-bit down-counter
+		uint32_t cycles = (start - end) & 0x00FFFFFF;
+		if (cycles < loadMinCycles) loadMinCycles = cycles;
+		if (cycles > loadMaxCycles) loadMaxCycles = cycles;
+		loadAvgCycles8 += cycles - (loadAvgCycles8 >> 8);
+		if (qualityLevels) UpdateQuality(cycles);
+#ifdef COMPUTERCARD_SOAK
+		SoakLoad(cycles);
+#endif
+	}
+
+	// Automatic quality levels, see EnableAutoQuality
+	int32_t qualityLevels, qualityDownPercent, qualityUpPercent, qualityWindowMs, qualityHold;
+	volatile int32_t qualityLevel;
+	uint32_t qualityWindowCalls, qualityCalls, qualityCycles, qualityOverruns;
+	int32_t qualityCalm; // windows in a row below qualityUpPercent
+
+	// Add one call to the window, and at its end, step the quality level
+	void __not_in_flash_func(UpdateQuality)(uint32_t cycles)
+	{
+		qualityCycles += cycles;
+		if (++qualityCalls < qualityWindowCalls) return;
+
+		// Compare cycles / (calls * budget) with the thresholds without dividing
+		uint64_t used = uint64_t(qualityCycles) * 100;
+		uint64_t budget = uint64_t(qualityCalls) * loadBudgetCycles;
+		if (loadOverruns != qualityOverruns || used > budget * uint32_t(qualityDownPercent))
+		{
+			if (qualityLevel > 0) qualityLevel = qualityLevel - 1;
+			qualityCalm = 0;
+		}
+		else if (used < budget * uint32_t(qualityUpPercent))
+		{
+			if (++qualityCalm >= qualityHold && qualityLevel < qualityLevels - 1)
+			{
+				qualityLevel = qualityLevel + 1;
+				qualityCalm = 0;
+			}
+		}
+		else qualityCalm = 0;
+
+		qualityCycles = qualityCalls = 0;
+		qualityOverruns = loadOverruns;
+	}
+
+	// Low power mode: system clock (0 = unchanged), and awake time measured around WFI
+	uint32_t lowPowerKHz;
+	volatile int32_t dutyPercent;
+
+	Switch switchVal, lastSwitchVal;
+	
+	volatile uint8_t runADCMode;
+
+
+// Buffers that DMA reads into / out of
+	// Up to 16 ADC samples per frame
+	uint16_t ADC_Buffer[2][16*blockSize];
+	// Aligned so that, in block mode, each half can be read by a DMA address ring
+	uint16_t SPI_Buffer[2][2*blockSize] __attribute__((aligned(8*blockSize)));
+
+	uint8_t adc_dma, spi_dma; // DMA ids
+
+	// Sample rate configuration, set up by AudioWorker
+	int32_t sampleRate;
+	int adcFrameLen; // ADC samples per frame: 4 conversions of each ADC input per audio conversion, see SetAudioOversampling
+	int audioOversampling; // audio conversions per frame, 1, 2 or 4; set by SetAudioOversampling, limited by AudioWorker
+	int32_t audioCIC[2][2]; // SetAudioOversampling(4): last two sums of four conversions of each audio input, R and L
+	int muxDiv; // frames per external mux step, so that knobs and CV are scanned at the same rate at 96kHz as at 48kHz
+
+	// Audio input ring, see EnableInputCapture
+	Frame *captureBuffer;
+	uint32_t captureFrames;
+	volatile uint32_t captureIndex;
+	uint8_t captureDMA; // block mode
+	int knobSmoothShift, cvSmoothShift; // IIR filter coefficients for knobs and CV
+
+	// Sequence of mux states scanned, set by SetMuxScan
+	static constexpr int muxScheduleLen = 16;
+	uint8_t muxSchedule[muxScheduleLen];
+
+	// Mux interference correction, see EnableMuxCorrection: the audio inputs' average at each
+	// frame of the mux schedule (Q12), and the sum of the averages, for R and L
+	bool useMuxCorrection;
+	int muxCorrectionShift;
+	int32_t muxOffset[2][2*muxScheduleLen];
+	int32_t muxOffsetSum[2];
+	void __not_in_flash_func(CorrectMuxInterference)(int phase);
+
+	// ADC DNL correction, added to each ADC code of the audio and CV inputs, 0 at mid-scale.
+	// In RAM, as it is read every sample. CV inputs also add adcCorrectionMid, the correction at
+	// mid-scale, to keep the offset they have always had
+	struct ADCCorrection
+	{
+		int8_t v[4096];
+	};
+	static ADCCorrection adcCorrection;
+	static constexpr int adcCorrectionMid = 16;
+
+	// The original correction, worked out per sample before the table: 8 codes for each of the
+	// ADC's wide codes below code x, and 4 more at every 511th code
+	static constexpr int OriginalADCCorrection(int x)
+	{
+		int adc512 = x + 512;
+		return ((adc512 % 0x01FF) ? 0 : 4) + ((adc512 >> 10) << 3);
+	}
+	static constexpr ADCCorrection DefaultADCCorrection()
+	{
+		static_assert(OriginalADCCorrection(2048) == adcCorrectionMid, "adcCorrectionMid must be the correction at mid-scale");
+		ADCCorrection c = {};
+		for (int x=0; x<4096; x++) c.v[x] = int8_t(OriginalADCCorrection(x) - adcCorrectionMid);
+		return c;
+	}
+
+	// Audio input from the two ADC samples of it in a frame: corrected, averaged, inverted to
+	// counteract the inverting op-amp input configuration, and clamped to 12 bits
+	static int16_t __not_in_flash_func(AudioFromADC)(uint16_t a, uint16_t b)
+	{
+		int32_t sum = a + adcCorrection.v[a & 0xFFF] + b + adcCorrection.v[b & 0xFFF];
+		int32_t x = -((sum - 0x1000) >> 1);
+		return int16_t(x < -2048 ? -2048 : (x > 2047 ? 2047 : x));
+	}
+
+	// Audio input ch (0 = R, 1 = L) from a frame of ADC samples. With one or two conversions, as
+	// AudioFromADC (one conversion counted twice). With four, the corrected sum of the four (a
+	// first-order CIC decimator) is filtered by (-1, 18, -1)/16 to flatten the sum's droop towards
+	// Nyquist, delaying the input by a frame
+	int16_t __not_in_flash_func(AudioFromFrame)(const uint16_t *frame, int ch)
+	{
+		if (audioOversampling < 4) return AudioFromADC(frame[ch], frame[adcFrameLen-4+ch]);
+		int32_t s = -0x2000;
+		for (int k=ch; k<16; k+=4) s += frame[k] + adcCorrection.v[frame[k] & 0xFFF];
+		int32_t *h = audioCIC[ch];
+		int32_t x = -((18 * h[0] - s - h[1]) >> 6);
+		h[1] = h[0];
+		h[0] = s;
+		return int16_t(x < -2048 ? -2048 : (x > 2047 ? 2047 : x));
+	}
+
+	// Block mode: one SPI DMA per half of SPI_Buffer, chained to each other and paced by a DMA timer
+	uint8_t spi_block_dma[2];
+	uint8_t spi_timer;
+
+	// CV output DMA: PWM levels for both CV outputs, streamed to the PWM compare register.
+	// Two channels, chained to each other, both reading the whole buffer through an address ring
+	constexpr static int cvDitherLength = 8;
+	uint32_t cvDitherBuffer[cvDitherLength] __attribute__((aligned(4*cvDitherLength)));
+	uint8_t cv_dma[2];
+	bool useCVDMA;
+	uint32_t cvDitherError[2];
+	uint8_t cvShift[2]; // bit position of each CV output's level in the PWM slice CC register
+
+	// Spread cvValue[] over the PWM level buffer, with the rounding error carried to the next update
+	void __not_in_flash_func(UpdateCVDither)()
+	{
+		// Order in which the fractional part is distributed across the buffer (bit-reversed, to spread high levels evenly)
+		static const uint8_t rank[cvDitherLength] = {0, 4, 2, 6, 1, 5, 3, 7};
+
+		uint32_t base[2], extra[2];
+		for (int i=0; i<2; i++)
+		{
+			// cvValue is 11-bit PWM level << 8, so the buffer should sum to cvValue * length / 256
+			uint32_t total = cvValue[i] * cvDitherLength + cvDitherError[i];
+			uint32_t n = total >> 8;
+			cvDitherError[i] = total & 0xFF;
+			base[i] = n / cvDitherLength;
+			extra[i] = n % cvDitherLength;
+		}
+
+		for (int k=0; k<cvDitherLength; k++)
+		{
+			uint32_t l0 = base[0] + (rank[k] < extra[0]);
+			uint32_t l1 = base[1] + (rank[k] < extra[1]);
+			cvDitherBuffer[k] = (l0 << cvShift[0]) | (l1 << cvShift[1]);
+		}
+	}
+
+	// Block mode: audio frames passed to ProcessBlock
+	Frame blockIn[blockSize], blockOut[blockSize];
+
+
+	uint8_t dmaPhase = 0;
+
+	// Convert signed int16 value into data string for DAC output
+	uint16_t __not_in_flash_func(dacval)(int16_t value, uint16_t dacChannel)
+	{
+		if (value<-2048) value = -2048;
+		if (value > 2047) value = 2047;
+		return (dacChannel | 0x3000) | (((uint16_t)((value & 0x0FFF) + 0x800)) & 0x0FFF);
+	}
+
+	// Block mode: dacval for a block of outputs at once, interleaved as spi_block_dma streams them
+	static void FormatDACBlock(const Frame *frames, uint16_t *words, int n);
+
+	// Block mode, with EnableNoiseShaping: 16-bit outputs rounded to 12 bits in place, and the
+	// last two rounding errors of each output, fed back into the next sample
+	int noiseShapingOrder;
+	int32_t shapingError[2][2];
+	void ShapeOutputs(Frame *frames, int n);
+	uint32_t next_norm_probe();
+
+	void BufferFull();
+	void BlockFull();
+
+	void AudioWorker();
+
+	// Audio on core 1, see EnableAudioOnCore1
+	bool audioOnCore1;
+	void (*core0Fn)();
+	volatile bool audioRunning;
+	void RunAudioOnCore1();
+	
+	// Body of the per-sample interrupt, with process() running the card for the frame
+	template <typename Process>
+	void ServiceSample(Process process);
+
+	static void AudioCallback()
+	{
+		if (blockSize > 1)
+			thisptr->BlockFull();
+		else
+			thisptr->BufferFull();
+	}
+	static ComputerCard *thisptr;
+
+	// Audio interrupt handler, replaced by ComputerCardT
+	static inline void (*audioHandler)() = AudioCallback;
+
+	// Inputs copied once per sample (or block) for ComputerCardT, by TakeInputSnapshot
+	bool useInputSnapshot = false;
+	Inputs inputs = {};
+	void __not_in_flash_func(TakeInputSnapshot)()
+	{
+		for (int i=0; i<4; i++) inputs.knobs[i] = knobs[i];
+		inputs.audio[0] = adcInL;
+		inputs.audio[1] = adcInR;
+		inputs.cv[0] = cv[0];
+		inputs.cv[1] = cv[1];
+		inputs.cvFast[0] = cvFast[0];
+		inputs.cvFast[1] = cvFast[1];
+		for (int i=0; i<2; i++)
+		{
+			inputs.pulse[i] = pulse[i];
+			inputs.lastPulse[i] = last_pulse[i];
+		}
+		for (int i=0; i<6; i++) inputs.connected[i] = connected[i];
+		inputs.switchVal = switchVal;
+		inputs.lastSwitchVal = lastSwitchVal;
+	}
+
+	template <class Derived> friend class ComputerCardT;
+
+	// CardLauncher state: card running, card asked for by SwitchCard (-1 for none), and switch hold time to move to the next card
+	static inline volatile int cardIndex = 0, cardRequest = -1;
+	static inline uint32_t cardGestureUs = 0;
+	template <class... Cards> friend class CardLauncher;
+
+	// Interpolated reader that last configured the interpolators, on each core
+	static inline const void *interpOwner[2] = {nullptr, nullptr};
+
+	// 19-bit CV outputs
+	static void OnCVPWMWrap()
+	{
+		static int32_t error1 = 0, error2 = 0;
+
+		pwm_clear_irq(pwm_gpio_to_slice_num(CV_OUT_1)); // clear the interrupt flag
+		Trace(TraceCVPWMWrap);
+		uint32_t truncated_cv1_val = (cvValue[0]-error1) & 0xFFFFFF00;
+		error1 += truncated_cv1_val - cvValue[0];
+		pwm_set_gpio_level(CV_OUT_1, (truncated_cv1_val>>8));
+		uint32_t truncated_cv2_val = (cvValue[1]-error2) & 0xFFFFFF00;
+		error2 += truncated_cv2_val - cvValue[1];
+		pwm_set_gpio_level(CV_OUT_2, (truncated_cv2_val>>8));
+	}
+
+};
+
+
+/** \brief ComputerCard with the card's ProcessSample called directly, rather than through a virtual function
+
+	Derive the card from ComputerCardT, naming the card itself, and use it as a ComputerCard:
+
+		class MyCard : public ComputerCardT<MyCard>
+		{
+		public:
+			void ProcessSample() { AudioOut1(AudioIn1()); }
+		};
+
+	The per-sample interrupt calls MyCard::ProcessSample non-virtually, so the compiler can inline
+	it, and the input functions (KnobVal, SwitchVal, AudioIn, CVIn, PulseIn, Connected and so on)
+	read a copy of the inputs taken once per sample, rather than volatile members, so their values
+	can stay in registers. The copy is only updated by the audio interrupt, so code outside the
+	audio callbacks (e.g. a loop in main) should read inputs with ComputerCard::KnobVal etc.
+	ProcessSample must be public (or ComputerCardT<MyCard> a friend).
+	With COMPUTERCARD_BLOCK_SIZE > 1 the copy is taken once per block, and the default ProcessBlock
+	calls ProcessSample non-virtually for each frame.
+*/
+template <class Derived>
+class ComputerCardT : public ComputerCard
+{
+public:
+	/// Start audio processing, as ComputerCard::Run
+	void Run(SampleRate_t rate = SR48kHz)
+	{
+		useInputSnapshot = true;
+		if (blockSize == 1) audioHandler = SampleCallback;
+		ComputerCard::Run(rate);
+	}
+
+protected:
+	/// ProcessSample for each frame, as ComputerCard::ProcessBlock
+	void ProcessBlock(const Frame *in, Frame *out, int n) override
+	{
+		for (int i=0; i<n; i++)
+		{
+			inputs.audio[0] = in[i].audio[0];
+			inputs.audio[1] = in[i].audio[1];
+			static_cast<Derived *>(this)->Derived::ProcessSample();
+			out[i].audio[0] = dacOut[0];
+			out[i].audio[1] = dacOut[1];
+
+			// Edges and switch changes are only reported on the first frame of the block
+			inputs.lastPulse[0] = inputs.pulse[0];
+			inputs.lastPulse[1] = inputs.pulse[1];
+			inputs.lastSwitchVal = inputs.switchVal;
+		}
+	}
+
+	/// \name Inputs, as ComputerCard's, from the copy taken for this sample
+	///@{
+	int32_t KnobVal(Knob ind) {return inputs.knobs[ind];}
+	Switch SwitchVal() {return inputs.switchVal;}
+	bool SwitchChanged() {return inputs.switchVal != inputs.lastSwitchVal;}
+	int16_t AudioIn(int i) {return inputs.audio[i ? 1 : 0];}
+	int16_t AudioIn1() {return inputs.audio[0];}
+	int16_t AudioIn2() {return inputs.audio[1];}
+	int16_t CVIn(int i) {return inputs.cv[i];}
+	int16_t CVIn1() {return inputs.cv[0];}
+	int16_t CVIn2() {return inputs.cv[1];}
+	int16_t CVInFast(int i) {return inputs.cvFast[i];}
+	int32_t CVInPitchQ16(int i) {return CVInPitch(i, inputs.cv[i]);}
+	int CVInNote(int i) {return (CVInPitchQ16(i) + 32768) >> 16;}
+	bool PulseIn(int i) {return inputs.pulse[i];}
+	bool PulseInRisingEdge(int i) {return inputs.pulse[i] && !inputs.lastPulse[i];}
+	bool PulseInFallingEdge(int i) {return !inputs.pulse[i] && inputs.lastPulse[i];}
+	bool PulseIn1() {return inputs.pulse[0];}
+	bool PulseIn1RisingEdge() {return inputs.pulse[0] && !inputs.lastPulse[0];}
+	bool PulseIn1FallingEdge() {return !inputs.pulse[0] && inputs.lastPulse[0];}
+	bool PulseIn2() {return inputs.pulse[1];}
+	bool PulseIn2RisingEdge() {return inputs.pulse[1] && !inputs.lastPulse[1];}
+	bool PulseIn2FallingEdge() {return !inputs.pulse[1] && inputs.lastPulse[1];}
+	bool Connected(Input i) {return inputs.connected[i];}
+	bool Disconnected(Input i) {return !inputs.connected[i];}
+	///@}
+
+private:
+	static void __not_in_flash_func(SampleCallback)()
+	{
+		ComputerCardT *card = static_cast<ComputerCardT *>(thisptr);
+		card->ServiceSample([card]() {
+			card->TakeInputSnapshot();
+			card->PollControl();
+			static_cast<Derived *>(card)->Derived::ProcessSample();
+		});
+	}
+};
+
+
+/** \brief Several cards in one firmware image, switched between at runtime
+
+		int main()
+		{
+			CardLauncher<Reverb, Sequencer, Looper>::Run();
+		}
+
+	Runs the first card. ComputerCard::SwitchCard(n), or holding the switch down for two seconds
+	(which moves to the next card), stops it and runs another in its place. Each card is
+	constructed when it starts and destroyed when it stops, into one buffer the size of the
+	largest card, so the cards' members (delay lines, tables and so on) share the same RAM
+	rather than each taking its own. A card that uses other resources (DMA channels, PIO, flash
+	stores) should release them in its destructor. Core 1 is reset between cards.
+*/
+template <class... Cards>
+class CardLauncher
+{
+	static constexpr size_t Largest()
+	{
+		size_t sizes[] = {sizeof(Cards)...}, largest = 0;
+		for (size_t s : sizes) if (s > largest) largest = s;
+		return largest;
+	}
+
+public:
+	static constexpr int numCards = sizeof...(Cards);
+
+	/// RAM taken by the cards: that of the largest
+	static constexpr size_t storageBytes = Largest();
+
+	/** \brief Run card number first, then each card switched to. Never returns, unless a card calls Abort
+
+		holdMs is the time the switch is held down to move to the next card, or 0 to switch only with SwitchCard.
+	*/
+	static void Run(int first = 0, uint32_t holdMs = 2000, ComputerCard::SampleRate_t rate = ComputerCard::SR48kHz)
+	{
+		static void (*const launch[])(ComputerCard::SampleRate_t) = {&Launch<Cards>...};
+		ComputerCard::cardGestureUs = holdMs * 1000;
+		int card = first;
+		while (card >= 0)
+		{
+			ComputerCard::cardIndex = card;
+			ComputerCard::cardRequest = -1;
+			launch[card](rate);
+			card = ComputerCard::cardRequest;
+			if (card >= numCards) card %= numCards;
+		}
+	}
+
+private:
+	alignas(Cards...) static inline uint8_t storage[storageBytes];
+
+	template <class C>
+	static void Launch(ComputerCard::SampleRate_t rate)
+	{
+		// The last card's interpolated readers may share addresses with this card's
+		ComputerCard::interpOwner[0] = ComputerCard::interpOwner[1] = nullptr;
+		C *card = new (storage) C;
+		card->Run(rate);
+#ifdef COMPUTERCARD_HAS_MULTICORE
+		multicore_reset_core1();
+#endif
+		card->~C();
+	}
+};
+
+
+#ifndef COMPUTERCARD_NOIMPL
+
+
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "pico/stdlib.h" // set_sys_clock_khz, on older SDKs
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "hardware/spi.h"
+#include "hardware/structs/systick.h"
+#ifndef COMPUTERCARD_NO_HEAP
+#include <malloc.h> // mallinfo, for MemoryUsage
+#endif
+
+// Linker script symbols: stacks of both cores, and the heap
+extern "C" char __StackBottom, __StackTop, __StackOneBottom, __StackOneTop, __StackLimit, __end__;
+
+// Input normalisation probe pin
+#define NORMALISATION_PROBE 4
+
+// Mux pins
+#define MX_A 24
+#define MX_B 25
+
+// ADC input pins
+#define AUDIO_L_IN_1 27
+#define AUDIO_R_IN_1 26
+#define MUX_IO_1 28
+#define MUX_IO_2 29
+
+#define DAC_CHANNEL_A 0x0000
+#define DAC_CHANNEL_B 0x8000
+
+#define DAC_CS 21
+#define DAC_SCK 18
+#define DAC_TX 19
+
+#define EEPROM_SDA 16
+#define EEPROM_SCL 17
+
+#define PULSE_1_INPUT 2
+#define PULSE_2_INPUT 3
+
+#define DEBUG_1 0
+#define DEBUG_2 1
+
+#define SPI_PORT spi0
+#define SPI_DREQ DREQ_SPI0_TX
+
+
+#define BOARD_ID_0 7
+#define BOARD_ID_1 6
+#define BOARD_ID_2 5
+
+// The ADC (/DMA) run mode, used to stop DMA in a known state before writing to flash
+#define RUN_ADC_MODE_RUNNING 0
+#define RUN_ADC_MODE_REQUEST_ADC_STOP 1
+#define RUN_ADC_MODE_ADC_STOPPED 2
+#define RUN_ADC_MODE_REQUEST_ADC_RESTART 3
+
+
+#define EEPROM_ADDR_ID 0
+#define EEPROM_ADDR_VERSION 2
+#define EEPROM_ADDR_CRC_L 87
+#define EEPROM_ADDR_CRC_H 86
+#define EEPROM_VAL_ID 2001
+#define EEPROM_NUM_BYTES 88
+
+#define EEPROM_PAGE_ADDRESS 0x50
+
+
+// Initialise CV output delta-sigma target to half-way (near 0V)
+volatile uint32_t ComputerCard::cvValue[2] = {262144,262144};
+
+
+ComputerCard *ComputerCard::thisptr;
+
+ComputerCard::ADCCorrection ComputerCard::adcCorrection = ComputerCard::DefaultADCCorrection();
+
+// Return pseudo-random bit for normalisation probe
+uint32_t __not_in_flash_func(ComputerCard::next_norm_probe)()
+{
+	static uint32_t lcg_seed = 1;
+	lcg_seed = 1664525 * lcg_seed + 1013904223;
+	return lcg_seed >> 31;
+}
+
+// Called at the start of each normalisation probe period, returning whether the probe runs during it
+bool __not_in_flash_func(ComputerCard::NormProbeBurst)(int32_t periodSamples)
+{
+	if (probeMode == ProbeContinuous) return true;
+
+	if (probeMode == ProbeBursts)
+	{
+		probeTimer += periodSamples;
+		if (probeTimer >= probeIntervalSamples)
+		{
+			probeTimer = 0;
+			probeRequested = true;
+		}
+	}
+
+	if (probeLeft <= 0 && probeRequested)
+	{
+		probeRequested = false;
+		probeLeft = probeBurstSamples;
+	}
+	if (probeLeft > 0)
+	{
+		probeLeft -= periodSamples;
+		return true;
+	}
+
+	// Hold the probe still between bursts
+	gpio_put(NORMALISATION_PROBE, 0);
+	return false;
+}
+
+// Update connected[] from the history of probe bits sent (expected) and seen on each input
+void __not_in_flash_func(ComputerCard::UpdateConnections)(int32_t expected)
+{
+	for (int i=0; i<6; i++)
+	{
+		bool c = (expected != plug_state[i]);
+		if (c == connected[i])
+		{
+			plugAgree[i] = 0;
+		}
+		else if (++plugAgree[i] >= probeHysteresis)
+		{
+			plugAgree[i] = 0;
+			connected[i] = c;
+			ConnectionChanged(Input(i), c);
+		}
+	}
+}
+
+// Main audio core function
+void __not_in_flash_func(ComputerCard::AudioWorker)()
+{
+	if (lowPowerKHz && set_sys_clock_khz(lowPowerKHz, false))
+	{
+		// clk_peri follows clk_sys, so the DAC SPI divider must be recalculated
+		spi_set_baudrate(SPI_PORT, 15625000);
+	}
+
+	adc_select_input(0);
+	adc_set_round_robin(0b0001111U);
+
+	// enabled, with DMA request when FIFO contains data, no erro flag, no byte shift
+	adc_fifo_setup(true, true, 1, false, false);
+
+
+	// ADC clock runs at 48MHz
+	// 48MHz ÷ (124+1) = 384kHz ADC sample rate
+	//                 = 8×48kHz audio sample rate
+	// which by default samples each ADC input twice per frame. The ADC cannot exceed 500kHz,
+	// so at 96kHz each input is sampled only once per frame, and four times only at 24kHz.
+	int maxOversampling;
+	if (sampleRate == SR24kHz)
+	{
+		maxOversampling = 4;
+		muxDiv = 1;
+	}
+	else if (sampleRate == SR96kHz)
+	{
+		maxOversampling = 1;
+		muxDiv = 2;
+	}
+	else
+	{
+		sampleRate = SR48kHz;
+		maxOversampling = 2;
+		muxDiv = 1;
+	}
+	if (audioOversampling > maxOversampling) audioOversampling = maxOversampling;
+	else if (audioOversampling == 3) audioOversampling = 2;
+	else if (audioOversampling < 1) audioOversampling = 1;
+	adcFrameLen = 4 * audioOversampling;
+	int adcClockDiv = 48000000 / (sampleRate * adcFrameLen);
+	adc_set_clkdiv(adcClockDiv - 1);
+
+	// Keep knob and CV smoothing time constants the same at all sample rates.
+	// In block mode, the mux advances once per block, so the mux rate scales with the sample rate.
+	int muxRateShift = (sampleRate == SR24kHz) ? -1 : 0;
+	if (blockSize > 1 && sampleRate == SR96kHz) muxRateShift = 1;
+	knobSmoothShift = 7 + muxRateShift;
+	cvSmoothShift = 4 + muxRateShift;
+
+	probeIntervalSamples = probeIntervalMs * (sampleRate / 1000);
+
+	// ADC clock cycles per frame
+	uint32_t frameADCCycles = adcClockDiv * adcFrameLen;
+
+	if (useLoadMeter)
+	{
+		// CPU cycles per sample/block = system clock / frame rate, with frame rate = ADC clock / frameADCCycles
+		loadBudgetCycles = uint32_t((uint64_t(clock_get_hz(clk_sys)) * frameADCCycles * blockSize) / clock_get_hz(clk_adc));
+		loadAvgCycles8 = 0;
+		ResetLoadMeter();
+		qualityWindowCalls = uint32_t(sampleRate * qualityWindowMs / (1000 * blockSize));
+		if (qualityWindowCalls < 1) qualityWindowCalls = 1;
+		qualityCalls = qualityCycles = 0;
+		qualityCalm = 0;
+#ifdef COMPUTERCARD_SOAK
+		soakRecord.run.budgetCycles = loadBudgetCycles;
+		soakBucketCycles = loadBudgetCycles >= 16 ? loadBudgetCycles / 16 : 1;
+#endif
+	}
+
+	if (usePulseCapture) usePulseCapture = StartPulseCapture(frameADCCycles);
+	if (useMuxSequencer) useMuxSequencer = StartMuxSequencer(adcClockDiv);
+	syncADCInterval = uint32_t(adcClockDiv);
+	if (syncMode) SetupSync();
+	if (usePulseAudio) usePulseEngine = false;
+	if (usePulseEngine) usePulseEngine = StartPulseEngine(frameADCCycles);
+	if (useAudioLink) useAudioLink = StartAudioLink();
+
+	if (useLedEngine)
+	{
+		ledPeriod = sampleRate / ledRefreshHz;
+		ledCount = 0;
+		ledMeterDecay = (4095 * 1000) / (300 * ledRefreshHz); // full scale to zero in 300ms
+		if (ledMeterDecay < 1) ledMeterDecay = 1;
+	}
+
+	if (useLoadMeter || lowPowerKHz)
+	{
+		// Run SysTick freely from the processor clock, as a cycle counter
+		systick_hw->csr = 0;
+		systick_hw->rvr = 0x00FFFFFF;
+		systick_hw->cvr = 0;
+		systick_hw->csr = 0x5; // CLKSOURCE = processor clock, ENABLE
+	}
+
+	// Duty measurement: cycles asleep, and in total, over each window of dutyWindow cycles
+	uint32_t dutyWindow = clock_get_hz(clk_sys) >> 3;
+	uint32_t idleCycles = 0, totalCycles = 0, lastTick = systick_hw->cvr;
+
+	// claim and setup DMAs for reading to ADC, and writing to SPI DAC
+	adc_dma = dma_claim_unused_channel(true);
+	spi_dma = dma_claim_unused_channel(true);
+
+	dma_channel_config adc_dmacfg, spi_dmacfg;
+	adc_dmacfg = dma_channel_get_default_config(adc_dma);
+	spi_dmacfg = dma_channel_get_default_config(spi_dma);
+
+	// Reading from ADC into memory buffer, so increment on write, but no increment on read
+	channel_config_set_transfer_data_size(&adc_dmacfg, DMA_SIZE_16);
+	channel_config_set_read_increment(&adc_dmacfg, false);
+	channel_config_set_write_increment(&adc_dmacfg, true);
+
+	// Synchronise ADC DMA the ADC samples
+	channel_config_set_dreq(&adc_dmacfg, DREQ_ADC);
+#ifdef COMPUTERCARD_HAS_PIO
+	// Start the mux sequencer's frame timer as each frame (or block) of ADC samples completes
+	if (useMuxSequencer) channel_config_set_chain_to(&adc_dmacfg, muxSeqDMA);
+#endif
+
+	// Setup DMA for adcFrameLen ADC samples per frame
+	dma_channel_configure(adc_dma, &adc_dmacfg, ADC_Buffer[dmaPhase], &adc_hw->fifo, adcFrameLen*blockSize, true);
+
+	// Turn on IRQ for ADC DMA
+	dma_channel_set_irq0_enabled(adc_dma, true);
+
+	// Call buffer_full ISR when ADC DMA finished
+	irq_set_enabled(DMA_IRQ_0, true);
+	irq_set_exclusive_handler(DMA_IRQ_0, audioHandler);
+
+
+	uint slice_num = pwm_gpio_to_slice_num(CV_OUT_1);
+	if (useCVDMA)
+	{
+		// Stream PWM levels into the CV slice's compare register, one word (both channels) per PWM period
+		cvShift[0] = 16 * pwm_gpio_to_channel(CV_OUT_1);
+		cvShift[1] = 16 * pwm_gpio_to_channel(CV_OUT_2);
+		cvDitherError[0] = cvDitherError[1] = 0;
+		UpdateCVDither();
+
+		cv_dma[0] = dma_claim_unused_channel(true);
+		cv_dma[1] = dma_claim_unused_channel(true);
+
+		// log2 of the size of cvDitherBuffer, in bytes
+		int ringBits = 0;
+		while ((1 << ringBits) < int(sizeof(cvDitherBuffer))) ringBits++;
+
+		for (int i=0; i<2; i++)
+		{
+			dma_channel_config cfg = dma_channel_get_default_config(cv_dma[i]);
+			channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+			channel_config_set_read_increment(&cfg, true);
+			channel_config_set_write_increment(&cfg, false);
+			channel_config_set_dreq(&cfg, pwm_get_dreq(slice_num));
+			channel_config_set_ring(&cfg, false, ringBits);
+			channel_config_set_chain_to(&cfg, cv_dma[1-i]);
+			dma_channel_configure(cv_dma[i], &cfg, &pwm_hw->slice[slice_num].cc, cvDitherBuffer, cvDitherLength, false);
+		}
+		dma_channel_start(cv_dma[0]);
+	}
+	else
+	{
+		// Turn on IRQ for CV output PWM
+		pwm_clear_irq(slice_num);
+		pwm_set_irq_enabled(slice_num, true);
+
+		irq_set_exclusive_handler(PWM_IRQ_WRAP, ComputerCard::OnCVPWMWrap);
+		irq_set_priority(PWM_IRQ_WRAP, 255);
+		irq_set_enabled(PWM_IRQ_WRAP, true);
+	}
+
+	
+	// Set up DMA for SPI
+	spi_dmacfg = dma_channel_get_default_config(spi_dma);
+	channel_config_set_transfer_data_size(&spi_dmacfg, DMA_SIZE_16);
+
+	// SPI DMA timed to SPI TX
+	channel_config_set_dreq(&spi_dmacfg, SPI_DREQ);
+
+	// Set up DMA to transmit 2 samples to SPI
+	dma_channel_configure(spi_dma, &spi_dmacfg, &spi_get_hw(SPI_PORT)->dr, NULL, 2, false);
+
+	if (blockSize > 1)
+	{
+		// In block mode, a whole block of DAC values is written by the CPU at once,
+		// so DAC writes are paced by a DMA timer rather than by the audio interrupt
+
+		// Fill DAC buffers with 0V. (A zero word would instead shut down the DAC channel.)
+		for (int i=0; i<2; i++)
+		{
+			for (int j=0; j<blockSize; j++)
+			{
+				SPI_Buffer[i][2*j] = dacval(0, DAC_CHANNEL_A);
+				SPI_Buffer[i][2*j+1] = dacval(0, DAC_CHANNEL_B);
+			}
+		}
+
+		// Two DAC words per frame
+		spi_timer = ClaimFrameTimer(2, frameADCCycles);
+
+		spi_block_dma[0] = dma_claim_unused_channel(true);
+		spi_block_dma[1] = dma_claim_unused_channel(true);
+
+		// log2 of the size of one half of SPI_Buffer, in bytes
+		int ringBits = 0;
+		while ((1 << ringBits) < int(sizeof(SPI_Buffer[0]))) ringBits++;
+
+		for (int i=0; i<2; i++)
+		{
+			dma_channel_config cfg = dma_channel_get_default_config(spi_block_dma[i]);
+			channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+			channel_config_set_read_increment(&cfg, true);
+			channel_config_set_write_increment(&cfg, false);
+			channel_config_set_dreq(&cfg, dma_get_timer_dreq(spi_timer));
+			// Wrap read address back to the start of this half, ready for the next time it is chained to
+			channel_config_set_ring(&cfg, false, ringBits);
+			channel_config_set_chain_to(&cfg, spi_block_dma[1-i]);
+			dma_channel_configure(spi_block_dma[i], &cfg, &spi_get_hw(SPI_PORT)->dr, SPI_Buffer[i], 2*blockSize, false);
+		}
+
+		// Start DAC output of the first half, in step with ADC input into the first half.
+		// BlockFull then always writes the half that the DAC has just finished with.
+		dma_channel_start(spi_block_dma[dmaPhase]);
+
+		// Copying each block of audio inputs into the capture ring, one word per frame
+		if (captureBuffer)
+		{
+			captureDMA = dma_claim_unused_channel(true);
+			dma_channel_config cfg = dma_channel_get_default_config(captureDMA);
+			channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+			channel_config_set_read_increment(&cfg, true);
+			channel_config_set_write_increment(&cfg, true);
+			dma_channel_configure(captureDMA, &cfg, captureBuffer, blockIn, blockSize, false);
+		}
+	}
+	if (usePulseAudio) StartPulseAudio(frameADCCycles);
+
+	adc_run(true);
+
+	uint32_t gestureStart = 0;
+	while (1)
+	{
+		// Under CardLauncher, holding the switch down moves to the next card
+		if (cardGestureUs)
+		{
+			if (SwitchVal() != Down) gestureStart = 0;
+			else if (!gestureStart) gestureStart = time_us_32() | 1;
+			else if (time_us_32() - gestureStart >= cardGestureUs && cardRequest < 0) SwitchCard(cardIndex + 1);
+		}
+
+		// If ready to restart
+		if (runADCMode == RUN_ADC_MODE_REQUEST_ADC_RESTART)
+		{
+			runADCMode = RUN_ADC_MODE_RUNNING;
+
+			dma_hw->ints0 = 1u << adc_dma; // reset adc interrupt flag
+			dma_channel_set_write_addr(adc_dma, ADC_Buffer[dmaPhase], true); // start writing into new buffer
+			if (blockSize == 1)
+			{
+				dma_channel_set_read_addr(spi_dma, SPI_Buffer[dmaPhase], true); // start reading from new buffer
+			}
+
+			adc_set_round_robin(0);
+			adc_select_input(0);
+			adc_set_round_robin(0b0001111U);
+			adc_run(true);
+		}
+		else if (runADCMode == RUN_ADC_MODE_ADC_STOPPED)
+		{
+			if (useCVDMA)
+			{
+				dma_channel_cleanup(cv_dma[0]);
+				dma_channel_cleanup(cv_dma[1]);
+				dma_channel_unclaim(cv_dma[0]);
+				dma_channel_unclaim(cv_dma[1]);
+			}
+			else
+			{
+				// We can't remove the PWM IRQ from within the ADC IRQ callback, so we do it here instead.
+				irq_set_enabled(PWM_IRQ_WRAP, false);
+				pwm_clear_irq(pwm_gpio_to_slice_num(CV_OUT_1)); // reset CV PWM interrupt flag
+				irq_remove_handler(PWM_IRQ_WRAP, ComputerCard::OnCVPWMWrap);
+			}
+			if (usePulseCapture) StopPulseCapture();
+			if (useMuxSequencer) StopMuxSequencer();
+			if (usePulseEngine) StopPulseEngine();
+			if (usePulseAudio) StopPulseAudio();
+			if (useAudioLink) StopAudioLink();
+
+			// Release the audio DMA channels, so that Run can be called again (as by CardLauncher)
+			dma_channel_unclaim(adc_dma);
+			dma_channel_unclaim(spi_dma);
+			if (blockSize > 1)
+			{
+				dma_channel_unclaim(spi_block_dma[0]);
+				dma_channel_unclaim(spi_block_dma[1]);
+				if (captureBuffer) dma_channel_unclaim(captureDMA);
+			}
+			break;
+		}
+		else if (nextStartupTask < numStartupTasks)
+		{
+			// A step of the card's background setup, see AddStartupTask
+			if (!(this->*startupTasks[nextStartupTask])(startupStep++))
+			{
+				startupStep = 0;
+				if (++nextStartupTask == numStartupTasks) bootTimes.startupDone = time_us_32();
+			}
+		}
+		else if (lowPowerKHz)
+		{
+			// Sleep until the next interrupt. With interrupts masked, WFI still wakes on a
+			// pending interrupt, but its handler runs only after the sleep has been timed.
+			uint32_t irq = save_and_disable_interrupts();
+			uint32_t sleepStart = systick_hw->cvr;
+			__wfi();
+			uint32_t now = systick_hw->cvr;
+			restore_interrupts(irq);
+
+			// SysTick is a 24-bit down-counter; interrupts come far more often than it wraps
+			idleCycles += (sleepStart - now) & 0x00FFFFFF;
+			totalCycles += (lastTick - now) & 0x00FFFFFF;
+			lastTick = now;
+			if (totalCycles >= dutyWindow)
+			{
+				dutyPercent = 100 - int32_t((uint64_t(idleCycles) * 100) / totalCycles);
+				idleCycles = totalCycles = 0;
+			}
+		}
+	}
+}
+
+#ifdef COMPUTERCARD_HAS_MULTICORE
+void ComputerCard::RunAudioOnCore1()
+{
+	// Interrupts are enabled on the core that calls irq_set_enabled, so AudioWorker sets them up on core 1
+	audioRunning = true;
+	PaintCore1Stack();
+	multicore_launch_core1([]() {
+		thisptr->AudioWorker();
+		thisptr->audioRunning = false;
+	});
+	if (core0Fn) core0Fn();
+	while (audioRunning) tight_loop_contents();
+}
+#endif
+
+void ComputerCard::Abort()
+{
+	runADCMode = RUN_ADC_MODE_REQUEST_ADC_STOP;
+}
+
+void ComputerCard::SwitchCard(int card)
+{
+	cardRequest = card;
+	if (thisptr) thisptr->Abort();
+}
+
+// Once every LED engine frame: run animations, and write all LEDs to the PWM
+void __not_in_flash_func(ComputerCard::UpdateLeds)()
+{
+	// LED brightness 0-4095 to PWM level, gamma 2.2, interpolated from 33 points
+	static constexpr uint16_t gamma[33] = {
+		0, 32, 147, 359, 676, 1104, 1648, 2314, 3104, 4022, 5072, 6255, 7574, 9033, 10632, 12375,
+		14263, 16298, 18482, 20816, 23303, 25943, 28739, 31692, 34802, 38072, 41503, 45097, 48853, 52774, 56860, 61114,
+		65535};
+
+	for (int c=0; c<2; c++)
+	{
+		if (!ledMeterActive[c]) continue;
+		int32_t level = ledMeterLevel[c] - ledMeterDecay;
+		if (level < ledMeterPeak[c]) level = ledMeterPeak[c];
+		ledMeterLevel[c] = uint16_t(level < 0 ? 0 : level);
+		ledMeterPeak[c] = 0;
+		// Bottom LED first, each covering a third of the range
+		int32_t v = ledMeterLevel[c] * 3;
+		for (int r=0; r<3; r++)
+		{
+			int32_t a = v - (2-r) * 4095;
+			ledLevel[2*r + c] = (a < 0 ? 0 : (a > 4095 ? 4095 : a)) << 16;
+		}
+	}
+
+	uint32_t pwmLevel[numLeds];
+	for (int i=0; i<numLeds; i++)
+	{
+		if (ledFadeFrames[i])
+		{
+			if (--ledFadeFrames[i]) ledLevel[i] += ledFadeStep[i];
+			else ledLevel[i] = ledFadeTarget[i];
+		}
+		uint32_t v = ledLevel[i] >> 16;
+		if (v >= 4095) pwmLevel[i] = 65535;
+		else
+		{
+			uint32_t a = gamma[v >> 7], b = gamma[(v >> 7) + 1];
+			pwmLevel[i] = a + (((b - a) * (v & 127)) >> 7);
+		}
+	}
+
+	// Each row of LEDs is one PWM slice, left LED on channel A, so one register write per row
+	for (int r=0; r<3; r++)
+	{
+		pwm_hw->slice[pwm_gpio_to_slice_num(leds[2*r])].cc = (pwmLevel[2*r+1] << 16) | pwmLevel[2*r];
+	}
+}
+
+#ifdef COMPUTERCARD_HAS_PIO
+// Load program onto whichever PIO block has room for it and two free state machines
+bool ComputerCard::ClaimPIO(const pio_program_t *program, PIO &pio, uint sm[2], uint &offset)
+{
+	PIO pios[2] = {pio0, pio1};
+	for (int p=0; p<2; p++)
+	{
+		if (!pio_can_add_program(pios[p], program)) continue;
+		int sm0 = pio_claim_unused_sm(pios[p], false);
+		if (sm0 < 0) continue;
+		int sm1 = pio_claim_unused_sm(pios[p], false);
+		if (sm1 < 0)
+		{
+			pio_sm_unclaim(pios[p], sm0);
+			continue;
+		}
+		pio = pios[p];
+		sm[0] = sm0;
+		sm[1] = sm1;
+		offset = pio_add_program(pio, program);
+		return true;
+	}
+	return false;
+}
+
+/*
+PIO program timing pulse input edges, one state machine per input, with the GPIO as JMP
+pin. X counts down once every two cycles, and is reset to zero once per sample/block by
+ReadPulseCapture. At each edge, the count since the reset is pushed to the RX FIFO: as ~X
+(top bit clear) for a falling GPIO edge, which is a rising pulse edge since the inputs
+are inverted, and as X (top bit set) for a rising GPIO edge.
+
+	0: jmp pin 2        ; GPIO high (pulse low): keep counting
+	1: jmp 4            ; GPIO low: rising pulse edge
+	2: jmp x-- 0
+	3: jmp 0
+	4: mov isr, ~x
+	5: push noblock
+	6: jmp pin 9        ; GPIO high: falling pulse edge
+	7: jmp x-- 6
+	8: jmp 6
+	9: mov isr, x
+	10: push noblock
+	11: jmp 0
+*/
+bool ComputerCard::StartPulseCapture(uint32_t frameADCCycles)
+{
+	static uint16_t instructions[12];
+	instructions[0] = pio_encode_jmp_pin(2);
+	instructions[1] = pio_encode_jmp(4);
+	instructions[2] = pio_encode_jmp_x_dec(0);
+	instructions[3] = pio_encode_jmp(0);
+	instructions[4] = pio_encode_mov_not(pio_isr, pio_x);
+	instructions[5] = pio_encode_push(false, false);
+	instructions[6] = pio_encode_jmp_pin(9);
+	instructions[7] = pio_encode_jmp_x_dec(6);
+	instructions[8] = pio_encode_jmp(6);
+	instructions[9] = pio_encode_mov(pio_isr, pio_x);
+	instructions[10] = pio_encode_push(false, false);
+	instructions[11] = pio_encode_jmp(0);
+	pio_program_t program = {};
+	program.instructions = instructions;
+	program.length = 12;
+	program.origin = -1;
+
+	if (!ClaimPIO(&program, pulseCapturePIO, pulseCaptureSM, pulseCaptureOffset)) return false;
+
+	uint32_t mask = 0;
+	for (int i=0; i<2; i++)
+	{
+		uint sm = pulseCaptureSM[i];
+		pio_sm_config c = pio_get_default_sm_config();
+		sm_config_set_wrap(&c, pulseCaptureOffset, pulseCaptureOffset + 11);
+		sm_config_set_jmp_pin(&c, PULSE_1_INPUT + i);
+		sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+		sm_config_set_clkdiv_int_frac(&c, 1, 0);
+		pio_sm_init(pulseCapturePIO, sm, pulseCaptureOffset, &c);
+		pio_sm_exec(pulseCapturePIO, sm, pio_encode_mov(pio_x, pio_null));
+		mask |= 1u << sm;
+	}
+
+	// Counts per sample/block = system clock / (2 * frame rate), with frame rate = ADC clock / frameADCCycles
+	uint64_t sys = clock_get_hz(clk_sys), adc = clock_get_hz(clk_adc);
+	pulseCapturePeriod = uint32_t((sys * frameADCCycles * blockSize) / (2 * adc));
+	pulseCaptureScale = uint32_t(((2 * adc) << 24) / (sys * frameADCCycles));
+	pio_enable_sm_mask_in_sync(pulseCapturePIO, mask);
+	return true;
+}
+
+void ComputerCard::StopPulseCapture()
+{
+	for (int i=0; i<2; i++)
+	{
+		pio_sm_set_enabled(pulseCapturePIO, pulseCaptureSM[i], false);
+		pio_sm_unclaim(pulseCapturePIO, pulseCaptureSM[i]);
+	}
+	pio_program_t program = {};
+	program.length = 12;
+	program.origin = -1;
+	pio_remove_program(pulseCapturePIO, &program, pulseCaptureOffset);
+}
+
+// Read edges timed by the PIO since the last call, and restart the count
+void __not_in_flash_func(ComputerCard::ReadPulseCapture)()
+{
+	for (int i=0; i<2; i++)
+	{
+		uint sm = pulseCaptureSM[i];
+		bool rose = false, fell = false;
+		while (!pio_sm_is_rx_fifo_empty(pulseCapturePIO, sm))
+		{
+			uint32_t w = pio_sm_get(pulseCapturePIO, sm);
+			bool rising = !(w & 0x80000000u);
+			uint32_t count = rising ? w + 1 : -w;
+			// An edge pushed between the last read and the reset belongs at the start of this period
+			if (count > pulseCapturePeriod) count = 0;
+			uint32_t offset = uint32_t((uint64_t(pulseCapturePeriod - count) * pulseCaptureScale) >> 8);
+			if (rising)
+			{
+				pulseEdgeOffset[i][0] = offset;
+				// A rising edge after a falling one, or a pulse too short to be read from the GPIO
+				if (fell || !last_pulse[i]) rose = true;
+			}
+			else
+			{
+				pulseEdgeOffset[i][1] = offset;
+				fell = true;
+			}
+		}
+		pio_sm_exec(pulseCapturePIO, sm, pio_encode_mov(pio_x, pio_null));
+		if (rose)
+		{
+			last_pulse[i] = false;
+			pulse[i] = true;
+		}
+	}
+}
+
+/*
+PIO program generating pulses, one state machine per output, with the GPIO as SET pin.
+Pulse outputs are inverted, so the pin is set low for a pulse. Each schedule is four
+words, all counts of processor cycles: the delay before the first pulse, the number of
+pulses - 1, the gap between pulses, and the pulse length. The small fixed overheads of
+each part are subtracted by SendScheduledPulses.
+
+	0: pull block       ; delay
+	1: mov x, osr
+	2: jmp x-- 2
+	3: pull block       ; count - 1
+	4: mov y, osr
+	5: pull block       ; gap
+	6: mov isr, osr
+	7: pull block       ; length, kept in OSR
+	8: set pins, 0      ; pulse on
+	9: mov x, osr
+	10: jmp x-- 10
+	11: set pins, 1     ; pulse off
+	12: jmp !y 0
+	13: mov x, isr
+	14: jmp x-- 14
+	15: jmp y-- 8
+*/
+bool ComputerCard::StartPulseEngine(uint32_t frameADCCycles)
+{
+	static uint16_t instructions[16];
+	instructions[0] = pio_encode_pull(false, true);
+	instructions[1] = pio_encode_mov(pio_x, pio_osr);
+	instructions[2] = pio_encode_jmp_x_dec(2);
+	instructions[3] = pio_encode_pull(false, true);
+	instructions[4] = pio_encode_mov(pio_y, pio_osr);
+	instructions[5] = pio_encode_pull(false, true);
+	instructions[6] = pio_encode_mov(pio_isr, pio_osr);
+	instructions[7] = pio_encode_pull(false, true);
+	instructions[8] = pio_encode_set(pio_pins, 0);
+	instructions[9] = pio_encode_mov(pio_x, pio_osr);
+	instructions[10] = pio_encode_jmp_x_dec(10);
+	instructions[11] = pio_encode_set(pio_pins, 1);
+	instructions[12] = pio_encode_jmp_not_y(0);
+	instructions[13] = pio_encode_mov(pio_x, pio_isr);
+	instructions[14] = pio_encode_jmp_x_dec(14);
+	instructions[15] = pio_encode_jmp_y_dec(8);
+	pio_program_t program = {};
+	program.instructions = instructions;
+	program.length = 16;
+	program.origin = -1;
+
+	if (!ClaimPIO(&program, pulseEnginePIO, pulseEngineSM, pulseEngineOffset)) return false;
+
+	for (int i=0; i<2; i++)
+	{
+		uint sm = pulseEngineSM[i], pin = PULSE_1_RAW_OUT + i;
+		scheduledPulses[i].pending = false;
+		pio_sm_config c = pio_get_default_sm_config();
+		sm_config_set_wrap(&c, pulseEngineOffset, pulseEngineOffset + 15);
+		sm_config_set_set_pins(&c, pin, 1);
+		sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+		sm_config_set_clkdiv_int_frac(&c, 1, 0);
+		pio_sm_init(pulseEnginePIO, sm, pulseEngineOffset, &c);
+		// Hand the pin over from SIO output low (raw high), as set up in the constructor
+		pio_sm_set_pins_with_mask(pulseEnginePIO, sm, 1u << pin, 1u << pin);
+		pio_sm_set_consecutive_pindirs(pulseEnginePIO, sm, pin, 1, true);
+		pio_gpio_init(pulseEnginePIO, pin);
+		pio_sm_set_enabled(pulseEnginePIO, sm, true);
+	}
+
+	// Cycles per sample = system clock / frame rate, with frame rate = ADC clock / frameADCCycles
+	uint64_t sys = clock_get_hz(clk_sys), adc = clock_get_hz(clk_adc);
+	pulseCyclesPerUs = uint32_t(sys / 1000000);
+	pulseCyclesPerSampleQ8 = uint32_t(((sys * frameADCCycles) << 8) / adc);
+	return true;
+}
+
+void ComputerCard::StopPulseEngine()
+{
+	for (int i=0; i<2; i++)
+	{
+		uint pin = PULSE_1_RAW_OUT + i;
+		pio_sm_set_enabled(pulseEnginePIO, pulseEngineSM[i], false);
+		pio_sm_unclaim(pulseEnginePIO, pulseEngineSM[i]);
+		gpio_put(pin, true);
+		gpio_set_function(pin, GPIO_FUNC_SIO);
+	}
+	pio_program_t program = {};
+	program.length = 16;
+	program.origin = -1;
+	pio_remove_program(pulseEnginePIO, &program, pulseEngineOffset);
+	usePulseEngine = false;
+}
+
+// Stop any pulses on output i, and set it directly
+void __not_in_flash_func(ComputerCard::SetPulseEngineOutput)(int i, bool val)
+{
+	uint sm = pulseEngineSM[i];
+	scheduledPulses[i].pending = false;
+	pio_sm_set_enabled(pulseEnginePIO, sm, false);
+	pio_sm_clear_fifos(pulseEnginePIO, sm);
+	pio_sm_restart(pulseEnginePIO, sm);
+	pio_sm_exec(pulseEnginePIO, sm, pio_encode_jmp(pulseEngineOffset));
+	pio_sm_exec(pulseEnginePIO, sm, pio_encode_set(pio_pins, val ? 0 : 1));
+	pio_sm_set_enabled(pulseEnginePIO, sm, true);
+}
+
+// Start pulses scheduled since the last sample/block, from a fixed point in the interrupt
+void __not_in_flash_func(ComputerCard::SendScheduledPulses)()
+{
+	for (int i=0; i<2; i++)
+	{
+		ScheduledPulses &p = scheduledPulses[i];
+		if (!p.pending) continue;
+		SetPulseEngineOutput(i, false);
+		// Cycles from the first pull to the first pulse, from the end of one pulse to the
+		// start of the next, and from the start of a pulse to its end, beyond the counts
+		uint sm = pulseEngineSM[i];
+		pio_sm_put(pulseEnginePIO, sm, p.delay > 8 ? p.delay - 8 : 0);
+		pio_sm_put(pulseEnginePIO, sm, p.count - 1);
+		pio_sm_put(pulseEnginePIO, sm, p.gap > 5 ? p.gap - 5 : 0);
+		pio_sm_put(pulseEnginePIO, sm, p.length > 3 ? p.length - 3 : 0);
+	}
+}
+
+/*
+PIO program stepping the mux, on two state machines. The first takes each mux address
+from the audio interrupt, and sets it on MX_A and MX_B at the next flag from the second.
+The second is started by a DMA channel chained to the ADC's, which sends it muxSeqDelay as
+each frame (or block) of ADC samples completes, and raises the flag after that many
+cycles. A late interrupt finds the flag already raised, so the address is set at once.
+
+	0: pull block       ; mux address
+	1: wait 1 irq 4
+	2: out pins, 2
+	3: pull block       ; delay
+	4: mov x, osr
+	5: jmp x-- 5
+	6: irq set 4
+*/
+bool ComputerCard::StartMuxSequencer(uint32_t conversionADCCycles)
+{
+	static uint16_t instructions[7];
+	instructions[0] = pio_encode_pull(false, true);
+	instructions[1] = pio_encode_wait_irq(true, false, 4);
+	instructions[2] = pio_encode_out(pio_pins, 2);
+	instructions[3] = pio_encode_pull(false, true);
+	instructions[4] = pio_encode_mov(pio_x, pio_osr);
+	instructions[5] = pio_encode_jmp_x_dec(5);
+	instructions[6] = pio_encode_irq_set(false, 4);
+	pio_program_t program = {};
+	program.instructions = instructions;
+	program.length = 7;
+	program.origin = -1;
+
+	if (!ClaimPIO(&program, muxSeqPIO, muxSeqSM, muxSeqOffset)) return false;
+
+	for (int i=0; i<2; i++)
+	{
+		uint sm = muxSeqSM[i];
+		uint start = muxSeqOffset + (i ? 3 : 0);
+		pio_sm_config c = pio_get_default_sm_config();
+		sm_config_set_wrap(&c, start, muxSeqOffset + (i ? 6 : 2));
+		sm_config_set_out_pins(&c, MX_A, 2);
+		sm_config_set_out_shift(&c, true, false, 32);
+		sm_config_set_clkdiv_int_frac(&c, 1, 0);
+		pio_sm_init(muxSeqPIO, sm, start, &c);
+	}
+
+	// Hand the mux pins over from SIO, at address 0 as set up in the constructor
+	pio_sm_set_pins_with_mask(muxSeqPIO, muxSeqSM[0], 0, 3u << MX_A);
+	pio_sm_set_consecutive_pindirs(muxSeqPIO, muxSeqSM[0], MX_A, 2, true);
+	pio_gpio_init(muxSeqPIO, MX_A);
+	pio_gpio_init(muxSeqPIO, MX_B);
+
+	// One ADC conversion, in system clock cycles, less the timer's three cycles beyond its count
+	uint64_t sys = clock_get_hz(clk_sys), adc = clock_get_hz(clk_adc);
+	muxSeqDelay = uint32_t((sys * conversionADCCycles) / adc) - 3;
+
+	muxSeqDMA = dma_claim_unused_channel(true);
+	dma_channel_config cfg = dma_channel_get_default_config(muxSeqDMA);
+	channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+	channel_config_set_read_increment(&cfg, false);
+	channel_config_set_write_increment(&cfg, false);
+	channel_config_set_dreq(&cfg, pio_get_dreq(muxSeqPIO, muxSeqSM[1], true));
+	dma_channel_configure(muxSeqDMA, &cfg, &muxSeqPIO->txf[muxSeqSM[1]], &muxSeqDelay, 1, false);
+
+	pio_enable_sm_mask_in_sync(muxSeqPIO, (1u << muxSeqSM[0]) | (1u << muxSeqSM[1]));
+	return true;
+}
+
+void ComputerCard::StopMuxSequencer()
+{
+	dma_channel_cleanup(muxSeqDMA);
+	dma_channel_unclaim(muxSeqDMA);
+	for (int i=0; i<2; i++)
+	{
+		pio_sm_set_enabled(muxSeqPIO, muxSeqSM[i], false);
+		pio_sm_unclaim(muxSeqPIO, muxSeqSM[i]);
+	}
+	pio_program_t program = {};
+	program.length = 7;
+	program.origin = -1;
+	pio_remove_program(muxSeqPIO, &program, muxSeqOffset);
+	gpio_put(MX_A, false);
+	gpio_put(MX_B, false);
+	gpio_set_function(MX_A, GPIO_FUNC_SIO);
+	gpio_set_function(MX_B, GPIO_FUNC_SIO);
+	useMuxSequencer = false;
+}
+
+// Set the mux address for the next frame, or queue it for the sequencer
+void __not_in_flash_func(ComputerCard::SetMuxAddress)(int state)
+{
+	if (useMuxSequencer)
+	{
+		pio_sm_put(muxSeqPIO, muxSeqSM[0], uint32_t(state));
+		return;
+	}
+	gpio_put(MX_A, state & 1);
+	gpio_put(MX_B, state & 2);
+}
+#else
+bool ComputerCard::StartPulseCapture(uint32_t) {return false;}
+void ComputerCard::StopPulseCapture() {}
+void ComputerCard::ReadPulseCapture() {}
+bool ComputerCard::StartMuxSequencer(uint32_t) {return false;}
+void ComputerCard::StopMuxSequencer() {}
+void ComputerCard::SetMuxAddress(int state)
+{
+	gpio_put(MX_A, state & 1);
+	gpio_put(MX_B, state & 2);
+}
+bool ComputerCard::StartPulseEngine(uint32_t) {return false;}
+void ComputerCard::StopPulseEngine() {}
+void ComputerCard::SetPulseEngineOutput(int, bool) {}
+void ComputerCard::SendScheduledPulses() {}
+#endif
+
+#if defined(COMPUTERCARD_HAS_PIO) && defined(COMPUTERCARD_LINK)
+/*
+PIO program for the audio link, at 8 state machine cycles per bit: 32-bit words, least
+significant bit first, each between a start bit (low) and a stop bit (high), as a UART.
+One state machine sends on DEBUG_1 from instruction 0, and the other receives on DEBUG_2
+from instruction 6, reading each bit halfway through and dropping words with no stop bit.
+
+	0: set x, 31
+	1: pull block
+	2: set pins, 0 [7]      ; start bit
+	3: out pins, 1
+	4: jmp x-- 3 [6]
+	5: set pins, 1 [7]      ; stop bit, 10 cycles with 0 and 1
+	6: wait 0 pin 0         ; start bit
+	7: set x, 31 [10]       ; to halfway through the first bit
+	8: in pins, 1
+	9: jmp x-- 8 [6]
+	10: jmp pin 13          ; stop bit
+	11: wait 1 pin 0
+	12: jmp 6
+	13: push noblock
+*/
+bool ComputerCard::StartAudioLink()
+{
+	// 12Mbit/s, so a state machine clock of 96MHz, with a tenth of the words spare
+	uint32_t sys = clock_get_hz(clk_sys);
+	if (sys < 96000000) return false;
+	uint64_t bitsPerSecond = uint64_t(linkFrameWords) * uint32_t(sampleRate) * 137 / (4 * blockSize);
+	if (bitsPerSecond * 10 > 12000000ull * 9) return false;
+
+	static uint16_t instructions[14];
+	instructions[0] = pio_encode_set(pio_x, 31);
+	instructions[1] = pio_encode_pull(false, true);
+	instructions[2] = pio_encode_set(pio_pins, 0) | pio_encode_delay(7);
+	instructions[3] = pio_encode_out(pio_pins, 1);
+	instructions[4] = pio_encode_jmp_x_dec(3) | pio_encode_delay(6);
+	instructions[5] = pio_encode_set(pio_pins, 1) | pio_encode_delay(7);
+	instructions[6] = pio_encode_wait_pin(false, 0);
+	instructions[7] = pio_encode_set(pio_x, 31) | pio_encode_delay(10);
+	instructions[8] = pio_encode_in(pio_pins, 1);
+	instructions[9] = pio_encode_jmp_x_dec(8) | pio_encode_delay(6);
+	instructions[10] = pio_encode_jmp_pin(13);
+	instructions[11] = pio_encode_wait_pin(true, 0);
+	instructions[12] = pio_encode_jmp(6);
+	instructions[13] = pio_encode_push(false, false);
+	pio_program_t program = {};
+	program.instructions = instructions;
+	program.length = 14;
+	program.origin = -1;
+
+	if (!ClaimPIO(&program, linkPIO, linkSM, linkOffset)) return false;
+
+	uint32_t divQ8 = uint32_t((uint64_t(sys) << 8) / 96000000u);
+	for (int i=0; i<2; i++)
+	{
+		uint sm = linkSM[i], pin = i ? DEBUG_2 : DEBUG_1;
+		pio_sm_config c = pio_get_default_sm_config();
+		sm_config_set_clkdiv_int_frac(&c, uint16_t(divQ8 >> 8), uint8_t(divQ8 & 0xFF));
+		if (i == 0)
+		{
+			sm_config_set_wrap(&c, linkOffset, linkOffset + 5);
+			sm_config_set_out_pins(&c, pin, 1);
+			sm_config_set_set_pins(&c, pin, 1);
+			sm_config_set_out_shift(&c, true, false, 32);
+			sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+			pio_sm_init(linkPIO, sm, linkOffset, &c);
+			// Idle high
+			pio_sm_set_pins_with_mask(linkPIO, sm, 1u << pin, 1u << pin);
+			pio_sm_set_consecutive_pindirs(linkPIO, sm, pin, 1, true);
+		}
+		else
+		{
+			sm_config_set_wrap(&c, linkOffset + 6, linkOffset + 13);
+			sm_config_set_in_pins(&c, pin);
+			sm_config_set_jmp_pin(&c, pin);
+			sm_config_set_in_shift(&c, true, false, 32);
+			sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+			pio_sm_init(linkPIO, sm, linkOffset + 6, &c);
+			// Held idle with nothing connected
+			pio_sm_set_consecutive_pindirs(linkPIO, sm, pin, 1, false);
+			gpio_pull_up(pin);
+		}
+		pio_gpio_init(linkPIO, pin);
+	}
+
+	for (int i=0; i<2; i++)
+	{
+		for (int j=0; j<linkFrameWords; j++) linkTx[i][j] = 0;
+	}
+	linkTxPhase = 0;
+	linkTxWrite = linkTx[0];
+	linkReceived = linkParsed = linkLastWrite = 0;
+	linkQueueHead = linkQueueTail = 0;
+	linkPlaying = 0;
+	linkIdle = 0;
+	linkConnected = false;
+	linkSeqOut = linkSeqIn = 0;
+	linkFrames = linkErrors = linkSlips = 0;
+	linkQueued = 0;
+
+	// Sending: one frame per callback, started by SendLink
+	linkDMA[0] = dma_claim_unused_channel(true);
+	dma_channel_config cfg = dma_channel_get_default_config(linkDMA[0]);
+	channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+	channel_config_set_read_increment(&cfg, true);
+	channel_config_set_write_increment(&cfg, false);
+	channel_config_set_dreq(&cfg, pio_get_dreq(linkPIO, linkSM[0], true));
+	dma_channel_configure(linkDMA[0], &cfg, &linkPIO->txf[linkSM[0]], linkTx[0], linkFrameWords, false);
+
+	// Receiving: continuously, around linkRing
+	int ringBits = 0;
+	while ((1 << ringBits) < int(sizeof(linkRing))) ringBits++;
+	linkDMA[1] = dma_claim_unused_channel(true);
+	cfg = dma_channel_get_default_config(linkDMA[1]);
+	channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+	channel_config_set_read_increment(&cfg, false);
+	channel_config_set_write_increment(&cfg, true);
+	channel_config_set_ring(&cfg, true, ringBits);
+	channel_config_set_dreq(&cfg, pio_get_dreq(linkPIO, linkSM[1], false));
+	dma_channel_configure(linkDMA[1], &cfg, linkRing, &linkPIO->rxf[linkSM[1]], 0xFFFFFFFFu, true);
+
+	pio_enable_sm_mask_in_sync(linkPIO, (1u << linkSM[0]) | (1u << linkSM[1]));
+	return true;
+}
+
+void ComputerCard::StopAudioLink()
+{
+	for (int i=0; i<2; i++)
+	{
+		pio_sm_set_enabled(linkPIO, linkSM[i], false);
+		pio_sm_unclaim(linkPIO, linkSM[i]);
+		dma_channel_cleanup(linkDMA[i]);
+		dma_channel_unclaim(linkDMA[i]);
+	}
+	pio_program_t program = {};
+	program.length = 14;
+	program.origin = -1;
+	pio_remove_program(linkPIO, &program, linkOffset);
+	for (int i=0; i<2; i++)
+	{
+		// Back to SIO outputs, as set up in the constructor
+		uint pin = i ? DEBUG_2 : DEBUG_1;
+		gpio_disable_pulls(pin);
+		gpio_init(pin);
+		gpio_set_dir(pin, GPIO_OUT);
+	}
+	linkConnected = false;
+}
+
+// Check the frames received since the last callback, and move on to the next to play
+void __not_in_flash_func(ComputerCard::ReceiveLink)()
+{
+	constexpr uint32_t mask = linkRingWords - 1;
+	uint32_t write = (uint32_t(dma_hw->ch[linkDMA[1]].write_addr) - uint32_t(uintptr_t(linkRing))) >> 2;
+	linkReceived += (write - linkLastWrite) & mask;
+	linkLastWrite = write;
+	// Restart the count every few hours
+	if (!dma_channel_is_busy(linkDMA[1])) dma_channel_set_trans_count(linkDMA[1], 0xFFFFFFFFu, true);
+
+	bool arrived = false;
+	while (linkReceived - linkParsed >= uint32_t(linkFrameWords))
+	{
+		uint32_t pos = linkParsed, header = linkRing[pos & mask], sum = 0;
+		if ((header >> 24) == 0xA5)
+		{
+			for (int i=1; i<linkFrameWords; i++)
+			{
+				uint32_t w = linkRing[(pos + uint32_t(i)) & mask];
+				sum += w + (w >> 16);
+			}
+		}
+		if ((header >> 24) != 0xA5 || (sum & 0xFFFF) != (header & 0xFFFF))
+		{
+			// Not the start of an intact frame: look for one a word on. Lost frames are counted from the sequence
+			linkParsed++;
+			continue;
+		}
+		uint8_t seq = uint8_t(header >> 16);
+		if (linkConnected) linkErrors = linkErrors + uint8_t(seq - linkSeqIn);
+		linkSeqIn = uint8_t(seq + 1);
+		linkFrames = linkFrames + 1;
+		if (linkQueueTail - linkQueueHead == uint32_t(linkQueueSize))
+		{
+			linkQueueHead++;
+			linkSlips = linkSlips + 1;
+		}
+		linkQueue[linkQueueTail++ % linkQueueSize] = pos;
+		linkParsed += linkFrameWords;
+		arrived = true;
+	}
+
+	if (arrived) linkIdle = 0;
+	else if (++linkIdle > 8)
+	{
+		// Nothing for several callbacks: disconnected, until latency + 1 frames have arrived again
+		linkIdle = 8;
+		linkConnected = false;
+		linkQueueHead = linkQueueTail;
+	}
+
+	uint32_t queued = linkQueueTail - linkQueueHead;
+	if (!linkConnected && queued > uint32_t(linkLatency)) linkConnected = true;
+	if (linkConnected)
+	{
+		// Frames arrive as fast as they are played, give or take one. More than that
+		// behind, or none, means the other card's sample clock is faster or slower
+		while (queued > uint32_t(linkLatency) + 2)
+		{
+			linkQueueHead++;
+			queued--;
+			linkSlips = linkSlips + 1;
+		}
+		if (queued)
+		{
+			linkPlaying = linkQueue[linkQueueHead++ % linkQueueSize];
+			queued--;
+		}
+		else
+		{
+			// Play the last frame again
+			linkSlips = linkSlips + 1;
+		}
+	}
+	linkQueued = int32_t(queued);
+}
+
+// Send this callback's frame, and start the next from silence and the same control word
+void __not_in_flash_func(ComputerCard::SendLink)()
+{
+	uint32_t *f = linkTx[linkTxPhase];
+	uint32_t sum = 0;
+	for (int i=1; i<linkFrameWords; i++) sum += f[i] + (f[i] >> 16);
+	f[0] = 0xA5000000u | (uint32_t(linkSeqOut) << 16) | (sum & 0xFFFFu);
+	linkSeqOut++;
+	// Still sending the last frame only if the link is too slow; the other card counts this one lost
+	if (!dma_channel_is_busy(linkDMA[0])) dma_channel_transfer_from_buffer_now(linkDMA[0], f, linkFrameWords);
+	linkTxPhase ^= 1;
+	linkTxWrite = linkTx[linkTxPhase];
+	linkTxWrite[1] = f[1];
+	for (int i=2; i<linkFrameWords; i++) linkTxWrite[i] = 0;
+}
+#else
+bool ComputerCard::StartAudioLink() {return false;}
+void ComputerCard::StopAudioLink() {}
+void ComputerCard::ReceiveLink() {}
+void ComputerCard::SendLink() {}
+#endif
+
+void ComputerCard::StartLatency(LatencyMode mode, int out, int in)
+{
+	if (latencyMode == LatencyProbe) gpio_put(NORMALISATION_PROBE, 0);
+	latencyMode = LatencyIdle;
+	latencyResult = LatencyStats{};
+	if (mode == LatencyProbe && useNormProbe)
+	{
+		latencyResult.done = true;
+		return;
+	}
+	latencyOut = out ? 1 : 0;
+	latencyIn = in ? 1 : 0;
+	latencyStep = 0;
+	latencySum = 0;
+	latencyMin = INT32_MAX;
+	latencyMax = INT32_MIN;
+	latencyBaseSum = latencyBase = latencyHeight = latencyLast = 0;
+	latencySeen = false;
+	// A first cycle short of its step, to settle and take the level without it
+	latencyCount = latencyPeriod - 2 * latencyBaseFrames;
+	latencyMode = mode;
+}
+
+// One frame of a latency measurement: in is the measured input's sample, and out the output's,
+// replaced by the steps in loopback mode
+void __not_in_flash_func(ComputerCard::ServiceLatency)(int16_t in, int16_t &out)
+{
+	int32_t c = latencyCount;
+	bool probe = latencyMode == LatencyProbe;
+
+	if (c == 0)
+	{
+		latencyBase = latencyBaseSum / latencyBaseFrames;
+		latencyBaseSum = 0;
+		latencyLast = 0;
+		latencySeen = false;
+		if (probe) gpio_put(NORMALISATION_PROBE, 1);
+	}
+	else if (c == latencyHold && probe) gpio_put(NORMALISATION_PROBE, 0);
+	if (!probe) out = (c < latencyHold) ? latencyStepLevel : 0;
+
+	int32_t dev = in - latencyBase;
+	if (c >= latencyPeriod - latencyBaseFrames) latencyBaseSum += in;
+	else if (c < latencyHold && latencyStep == 0)
+	{
+		// The step's settled height, from its last 32 frames
+		if (c >= latencyHold - 32) latencyHeight += dev;
+	}
+	else if (c < latencyHold && !latencySeen)
+	{
+		// Where the step crosses half its height, between this frame and the last
+		int32_t half = (latencyHeight < 0 ? -latencyHeight : latencyHeight) >> 1;
+		int32_t d = latencyHeight < 0 ? -dev : dev;
+		if (d >= half)
+		{
+			int32_t t = (c - 1) * 256 + ((half - latencyLast) * 256) / (d - latencyLast);
+			latencySum += t;
+			if (t < latencyMin) latencyMin = t;
+			if (t > latencyMax) latencyMax = t;
+			latencySeen = true;
+		}
+		latencyLast = d;
+	}
+
+	if (c == latencyHold && latencyStep == 0)
+	{
+		latencyHeight /= 32;
+		if (latencyHeight > -64 && latencyHeight < 64)
+		{
+			// Nothing came back
+			latencyResult.done = true;
+			latencyMode = LatencyIdle;
+			return;
+		}
+		latencyStep = 1;
+	}
+	else if (c == latencyHold)
+	{
+		if (!latencySeen)
+		{
+			latencyResult.done = true;
+			latencyMode = LatencyIdle;
+			return;
+		}
+		if (++latencyStep > latencySteps)
+		{
+			int32_t avg = latencySum / latencySteps;
+			latencyResult.found = true;
+			latencyResult.inverted = latencyHeight < 0;
+			latencyResult.samplesQ8 = avg;
+			latencyResult.spreadQ8 = latencyMax - latencyMin;
+			latencyResult.us = uint32_t((int64_t(avg) * 1000000) / (int64_t(sampleRate) << 8));
+			latencyResult.done = true;
+			latencyMode = LatencyIdle;
+			if (!probe) out = 0;
+			return;
+		}
+	}
+
+	if (++latencyCount >= latencyPeriod) latencyCount = 0;
+}
+
+// Claim a DMA timer ticking wordsPerFrame times a frame, with frame rate = ADC clock / frameADCCycles.
+// Both clocks are derived from the same crystal, so for typical system clocks
+// (125MHz, 133MHz, 200MHz, ...) the fraction is exact and the two never drift.
+uint8_t ComputerCard::ClaimFrameTimer(uint32_t wordsPerFrame, uint32_t frameADCCycles)
+{
+	uint32_t num = wordsPerFrame * clock_get_hz(clk_adc) / frameADCCycles;
+	uint32_t den = clock_get_hz(clk_sys);
+	uint32_t a = num, b = den;
+	while (b) { uint32_t t = a % b; a = b; b = t; }
+	num /= a;
+	den /= a;
+	while (num > 0xFFFF || den > 0xFFFF)
+	{
+		num >>= 1;
+		den >>= 1;
+	}
+	uint8_t timer = dma_claim_unused_timer(true);
+	dma_timer_set_fraction(timer, num, den);
+	return timer;
+}
+
+void ComputerCard::StartPulseAudio(uint32_t frameADCCycles)
+{
+	uint slice = pwm_gpio_to_slice_num(PULSE_1_RAW_OUT);
+
+	// Start with both outputs low, as in PulseOut(false)
+	for (int i=0; i<2; i++)
+	{
+		for (int j=0; j<2*blockSize; j++) pulseAudioBuffer[i][j] = 0;
+	}
+	pulseAudioWrite = pulseAudioBuffer[0];
+
+	// 8-bit PWM at the full system clock. Both channels inverted, to counteract the inverting output stage
+	pwm_config c = pwm_get_default_config();
+	pwm_config_set_wrap(&c, 255);
+	pwm_config_set_clkdiv_int(&c, 1);
+	pwm_config_set_output_polarity(&c, true, true);
+	pwm_init(slice, &c, false);
+	pwm_hw->slice[slice].cc = 0;
+	gpio_set_function(PULSE_1_RAW_OUT, GPIO_FUNC_PWM);
+	gpio_set_function(PULSE_2_RAW_OUT, GPIO_FUNC_PWM);
+	pwm_set_enabled(slice, true);
+
+	if (blockSize > 1)
+	{
+		// One compare register word per frame
+		pulseAudioTimer = ClaimFrameTimer(1, frameADCCycles);
+
+		pulseAudioDMA[0] = dma_claim_unused_channel(true);
+		pulseAudioDMA[1] = dma_claim_unused_channel(true);
+
+		// log2 of the size of one half of pulseAudioBuffer, in bytes
+		int ringBits = 0;
+		while ((1 << ringBits) < int(sizeof(pulseAudioBuffer[0]))) ringBits++;
+
+		for (int i=0; i<2; i++)
+		{
+			dma_channel_config cfg = dma_channel_get_default_config(pulseAudioDMA[i]);
+			channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+			channel_config_set_read_increment(&cfg, true);
+			channel_config_set_write_increment(&cfg, false);
+			channel_config_set_dreq(&cfg, dma_get_timer_dreq(pulseAudioTimer));
+			channel_config_set_ring(&cfg, false, ringBits);
+			channel_config_set_chain_to(&cfg, pulseAudioDMA[1-i]);
+			dma_channel_configure(pulseAudioDMA[i], &cfg, &pwm_hw->slice[slice].cc, pulseAudioBuffer[i], blockSize, false);
+		}
+
+		// In step with the DAC, as spi_block_dma
+		dma_channel_start(pulseAudioDMA[dmaPhase]);
+	}
+}
+
+void ComputerCard::StopPulseAudio()
+{
+	if (blockSize > 1)
+	{
+		dma_channel_cleanup(pulseAudioDMA[0]);
+		dma_channel_cleanup(pulseAudioDMA[1]);
+		dma_channel_unclaim(pulseAudioDMA[0]);
+		dma_channel_unclaim(pulseAudioDMA[1]);
+		dma_timer_unclaim(pulseAudioTimer);
+	}
+	pwm_set_enabled(pwm_gpio_to_slice_num(PULSE_1_RAW_OUT), false);
+	for (int i=0; i<2; i++)
+	{
+		// Back to SIO, raw high (output low), as set up in the constructor
+		uint pin = PULSE_1_RAW_OUT + i;
+		gpio_put(pin, true);
+		gpio_set_function(pin, GPIO_FUNC_SIO);
+	}
+}
+
+	  
+
+// Subtract the mux's share of the audio inputs for step phase of the mux schedule (see EnableMuxCorrection)
+void __not_in_flash_func(ComputerCard::CorrectMuxInterference)(int phase)
+{
+	// Phases in one pass of the schedule, 16 or 32 (at 96kHz, two frames per mux step)
+	int phaseShift = (muxDiv == 2) ? 5 : 4;
+	for (int ch=0; ch<2; ch++)
+	{
+		int32_t x = ch ? adcInL : adcInR;
+		int32_t d = ((x << 12) - muxOffset[ch][phase]) >> muxCorrectionShift;
+		muxOffset[ch][phase] += d;
+		muxOffsetSum[ch] += d;
+		x -= (muxOffset[ch][phase] - (muxOffsetSum[ch] >> phaseShift)) >> 12;
+		if (ch) adcInL = x;
+		else adcInR = x;
+	}
+}
+
+// Per-audio-sample ISR, called when a frame of ADC samples has been collected from all four inputs
+void __not_in_flash_func(ComputerCard::BufferFull)()
+{
+	ServiceSample([this]() {
+		PollControl();
+		ProcessSample();
+	});
+}
+
+// Inlined into BufferFull, and into ComputerCardT's interrupt, each with its own copy of the statics
+template <typename Process>
+inline __attribute__((always_inline)) void ComputerCard::ServiceSample(Process process)
+{
+	static int startupCounter = 8; // Decreases by 1 each sample, can do startup things when nonzero.
+	static int mux_state = 0;
+	static int mux_pos = 0; // position in muxSchedule
+	static int mux_count = 0;
+	static int norm_probe_count = 0;
+
+	// Internal variables for IIR filters on knobs/cv
+	static volatile int32_t knobssm[4] = { 0, 0, 0, 0 };
+	static volatile int32_t cvsm[2] = { 0, 0 };
+	__attribute__((unused)) static int np = 0, np1 = 0, np2 = 0;
+
+	Trace(TraceAudio | TraceBegin);
+	if (usePulseEngine) SendScheduledPulses();
+
+	adc_select_input(0);
+
+	// Step of the mux schedule during which this frame was sampled
+	int muxPhase = mux_pos * muxDiv + mux_count;
+
+	// The mux steps every muxDiv samples (every other sample at 96kHz).
+	// Knobs and CV are read from the last frame before each step, when the mux has settled.
+	bool muxStep = (++mux_count >= muxDiv);
+	if (muxStep) mux_count = 0;
+
+	// Advance external mux to next state in the schedule.
+	// The normalisation probe measures CV 1 then CV 2 in the last two steps of its period.
+	int next_mux_state = mux_state;
+	if (muxStep)
+	{
+		mux_pos = (mux_pos + 1) & (muxScheduleLen - 1);
+		next_mux_state = muxSchedule[mux_pos];
+		int next_probe_count = (norm_probe_count + 1) & 0xF;
+		if (useNormProbe && normProbeActive && next_probe_count >= 14) next_mux_state = (next_mux_state & 2) | (next_probe_count & 1);
+	}
+	SetMuxAddress(next_mux_state);
+
+	// Set up new writes into next buffer
+	uint8_t cpuPhase = dmaPhase;
+	dmaPhase = 1 - dmaPhase;
+
+	dma_hw->ints0 = 1u << adc_dma; // reset adc interrupt flag
+	dma_channel_set_write_addr(adc_dma, ADC_Buffer[dmaPhase], true); // start writing into new buffer
+	dma_channel_set_read_addr(spi_dma, SPI_Buffer[dmaPhase], true); // start reading from new buffer
+
+	////////////////////////////////////////
+	// Collect various inputs and put them in variables for the DSP
+
+	// Frames hold each ADC input twice (0,1,2,3,0,1,2,3), or once or four times (SetAudioOversampling).
+	// Index of the last sample of ADC input 0, which is the same as the first with one conversion.
+	int second = adcFrameLen - 4;
+
+	// Set CV inputs, with ~240Hz LPF on CV input
+	int cvi = mux_state % 2;
+
+	// Compensation of ADC DNL errors, from the correction table
+	ADC_Buffer[cpuPhase][3] += adcCorrection.v[ADC_Buffer[cpuPhase][3] & 0xFFF] + adcCorrectionMid;
+	
+	if (muxStep)
+	{
+		cvFast[cvi] = 2048 - ADC_Buffer[cpuPhase][3];
+		int32_t last = cv[cvi];
+		if (useAdaptiveSmoothing)
+		{
+			cvSmoother[cvi].Update(ADC_Buffer[cpuPhase][3], cvSmoothShift);
+			cv[cvi] = 2048 - cvSmoother[cvi].Value();
+		}
+		else
+		{
+			cvsm[cvi] = (((1 << cvSmoothShift) - 1) * (cvsm[cvi]) + 16 * ADC_Buffer[cpuPhase][3]) >> cvSmoothShift;
+			cv[cvi] = 2048 - (cvsm[cvi] >> 4);
+		}
+		if (cv[cvi] != last) controlsChanged |= ChangedCV1 << cvi;
+	}
+
+
+	// Set audio inputs, from the samples of them collected
+	adcInR = AudioFromFrame(ADC_Buffer[cpuPhase], 0);
+	adcInL = AudioFromFrame(ADC_Buffer[cpuPhase], 1);
+
+	if (useMuxCorrection) CorrectMuxInterference(muxPhase);
+
+	// Set pulse inputs
+	last_pulse[0] = pulse[0];
+	last_pulse[1] = pulse[1];
+	pulse[0] = !gpio_get(PULSE_1_INPUT);
+	pulse[1] = !gpio_get(PULSE_2_INPUT);
+	if (usePulseCapture) ReadPulseCapture();
+
+	// Set knobs, with ~60Hz LPF
+	if (muxStep)
+	{
+		int knob = mux_state;
+		int32_t last = knobs[knob];
+		if (useAdaptiveSmoothing)
+		{
+			knobSmoother[knob].Update(ADC_Buffer[cpuPhase][second+2], knobSmoothShift);
+			knobs[knob] = knobSmoother[knob].Value();
+		}
+		else
+		{
+			knobssm[knob] = (((1 << knobSmoothShift) - 1) * (knobssm[knob]) + 16 * ADC_Buffer[cpuPhase][second+2]) >> knobSmoothShift;
+			knobs[knob] = knobssm[knob] >> 4;
+		}
+		if (knob < 3 && knobs[knob] != last) controlsChanged |= ChangedMain << knob;
+	}
+
+	// Set switch value
+	switchVal = static_cast<Switch>((knobs[3]>1000) + (knobs[3]>3000));
+	if (switchVal != lastSwitchVal) controlsChanged |= ChangedSwitch;
+	if (startupCounter)
+	{
+		// Don't detect switch changes in first few cycles
+		lastSwitchVal = switchVal;
+		if (startupCounter == 8) bootTimes.firstSample = time_us_32();
+		// Should initialise knob and CV smoothing filters here too
+	}
+	
+	////////////////////////////
+	// Normalisation probe
+
+	// The probe sequence advances with the mux, so runs at the same rate at 96kHz as at 48kHz
+	if (useNormProbe && muxStep && norm_probe_count == 0) normProbeActive = NormProbeBurst(16 * muxDiv);
+	if (useNormProbe && muxStep && normProbeActive)
+	{
+		// Set normalisation probe output value
+		// and update np to the expected history string
+		if (norm_probe_count == 0)
+		{
+			int32_t normprobe = next_norm_probe();
+			gpio_put(NORMALISATION_PROBE, normprobe);
+			np = (np<<1)+(normprobe&0x1);
+		}
+
+		// CV sampled at 24kHz comes in over two successive samples
+		if (norm_probe_count == 14 || norm_probe_count == 15)
+		{
+			plug_state[2+cvi] = (plug_state[2+cvi]<<1)+(ADC_Buffer[cpuPhase][3]<1800);
+		}
+
+		// Audio and pulse measured every sample at 48kHz
+		if (norm_probe_count == 15)
+		{
+			plug_state[Input::Audio1] = (plug_state[Input::Audio1]<<1)+(ADC_Buffer[cpuPhase][second+1]<1800);
+			plug_state[Input::Audio2] = (plug_state[Input::Audio2]<<1)+(ADC_Buffer[cpuPhase][second]<1800);
+			plug_state[Input::Pulse1] = (plug_state[Input::Pulse1]<<1)+(pulse[0]);
+			plug_state[Input::Pulse2] = (plug_state[Input::Pulse2]<<1)+(pulse[1]);
+
+			UpdateConnections(np);
+		}
+	}
+
+	if (useNormProbe)
+	{
+		// Force disconnected values to zero, rather than the normalisation probe garbage
+		if (Disconnected(Input::Audio1)) adcInL = 0;
+		if (Disconnected(Input::Audio2)) adcInR = 0;
+		if (Disconnected(Input::CV1)) cv[0] = cvFast[0] = 0;
+		if (Disconnected(Input::CV2)) cv[1] = cvFast[1] = 0;
+		if (Disconnected(Input::Pulse1)) pulse[0] = 0;
+		if (Disconnected(Input::Pulse2)) pulse[1] = 0;
+	}
+#ifdef COMPUTERCARD_SOAK
+	SoakInputs();
+	adcInL = SoakAudio(0, 0);
+	adcInR = SoakAudio(1, 0);
+#endif
+	if (captureBuffer) captureBuffer[captureIndex] = {{adcInL, adcInR}};
+	
+	////////////////////////////////////////
+	// Run the DSP
+	if (useLoadMeter)
+	{
+		uint32_t start = systick_hw->cvr;
+		StartCallback();
+		process();
+		UpdateLoadMeter(start, systick_hw->cvr);
+	}
+	else
+	{
+		StartCallback();
+		process();
+	}
+	if (captureBuffer && ++captureIndex == captureFrames) captureIndex = 0;
+
+	////////////////////////////////////////
+	// Collect DSP outputs and put them in the DAC SPI buffer
+	// CV/Pulse outputs are done immediately in ProcessSample, unless CV output DMA is enabled
+
+	// Invert dacout to counteract inverting output configuration
+	if (latencyMode != LatencyIdle) ServiceLatency(latencyIn ? adcInR : adcInL, dacOut[latencyOut]);
+	if (subRateStages)
+	{
+		int32_t sub[2];
+		ServiceSubRate(adcInL, adcInR, sub);
+		for (int c=0; c<2; c++)
+		{
+			int32_t v = dacOut[c] + sub[c];
+			sub[c] = v < -2048 ? -2048 : (v > 2047 ? 2047 : v);
+		}
+		SPI_Buffer[cpuPhase][0] = dacval(int16_t(-sub[0]), DAC_CHANNEL_A);
+		SPI_Buffer[cpuPhase][1] = dacval(int16_t(-sub[1]), DAC_CHANNEL_B);
+	}
+	else
+	{
+		SPI_Buffer[cpuPhase][0] = dacval(-dacOut[0], DAC_CHANNEL_A);
+		SPI_Buffer[cpuPhase][1] = dacval(-dacOut[1], DAC_CHANNEL_B);
+	}
+	if (usePulseAudio) pwm_hw->slice[pwm_gpio_to_slice_num(PULSE_1_RAW_OUT)].cc = pulseAudioBuffer[0][0] | (uint32_t(pulseAudioBuffer[0][1]) << 16);
+	if (useAudioLink) SendLink();
 
-	// claim and setup DMAs for reading to ADC, and writing to SPI DAC
-	adc_dma = dma_claim_unused_channel(true);
-	spi_dma = dma_claim_unused_channel(true);
+	if (useCVDMA) UpdateCVDither();
+	if (useLedEngine) PollLeds();
 
-	dma_channel_config adc_dmacfg, spi_dmacfg;
-	adc_dmacfg = dma_channel_get_default_config(adc_dma);
-	spi_dmacfg = dma_channel_get_default_config(spi_dma);
+	mux_state = next_mux_state;
 
-	// Reading from ADC into memory buffer, so increment on write, but no increment on read
-	channel_config_set_transfer_data_size(&adc_dmacfg, DMA_SIZE_16);
-	channel_config_set_read_increment(&adc_dmacfg, false);
-	channel_config_set_write_increment(&adc_dmacfg, true);
+	// If Abort called, stop ADC and DMA
+	if (runADCMode == RUN_ADC_MODE_REQUEST_ADC_STOP)
+	{
+		adc_run(false);
+		adc_set_round_robin(0);
+		adc_select_input(0);
 
-	// Synchronise ADC DMA the ADC samples
-	channel_config_set_dreq(&adc_dmacfg, DREQ_ADC);
+		dma_hw->ints0 = 1u << adc_dma; // reset adc interrupt flag
+		dma_channel_cleanup(adc_dma);
+		dma_channel_cleanup(spi_dma);
+		irq_set_enabled(DMA_IRQ_0, false);
+		irq_remove_handler(DMA_IRQ_0, audioHandler);
 
-	// Setup DMA for 8 ADC samples
-	dma_channel_configure(adc_dma, &adc_dmacfg, ADC_Buffer[dmaPhase], &adc_hw->fifo, 8, true);
 
-	// Turn on IRQ for ADC DMA
-	dma_channel_set_irq0_enabled(adc_dma, true);
+		
+		runADCMode = RUN_ADC_MODE_ADC_STOPPED;
+	}
 
-	// Call buffer_full ISR when ADC DMA finished
-	irq_set_enabled(DMA_IRQ_0, true);
-	irq_set_exclusive_handler(DMA_IRQ_0, ComputerCard::AudioCallback);
+	// If the next ADC buffer is already full, this sample has overrun its deadline
+	if (useLoadMeter && (dma_hw->ints0 & (1u << adc_dma)))
+	{
+		loadOverruns++;
+		Trace(TraceOverrun);
+#ifdef COMPUTERCARD_SOAK
+		SoakOverrun();
+#endif
+	}
 
+	if (muxStep) norm_probe_count = (norm_probe_count + 1) & 0xF;
 
-	// Turn on IRQ for CV output PWM
-	uint slice_num = pwm_gpio_to_slice_num(CV_OUT_1);
-	pwm_clear_irq(slice_num);
-	pwm_set_irq_enabled(slice_num, true);
+	lastSwitchVal = switchVal;
 	
-	irq_set_exclusive_handler(PWM_IRQ_WRAP, ComputerCard::OnCVPWMWrap);
-	irq_set_priority(PWM_IRQ_WRAP, 255);
-	irq_set_enabled(PWM_IRQ_WRAP, true);
+	if (startupCounter) startupCounter--;
+	Trace(TraceAudio | TraceEnd);
+}
 
-	
-	// Set up DMA for SPI
-	spi_dmacfg = dma_channel_get_default_config(spi_dma);
-	channel_config_set_transfer_data_size(&spi_dmacfg, DMA_SIZE_16);
+// Round the sync period to whole blocks, and set the loop gains for a bandwidth of 0.5Hz, damping
+// 0.7. One ADC clock divider LSB moves the phase period / (256 * syncADCInterval) samples per period
+void ComputerCard::SetupSync()
+{
+	syncPeriod = ((syncPeriod + blockSize - 1) / blockSize) * blockSize;
+	if (syncPeriod < 2 * blockSize) syncPeriod = 2 * blockSize;
+	if (syncPeriod > 4096) syncPeriod = 4096;
+	float g = float(syncPeriod) / (256.0f * float(syncADCInterval));
+	float wT = 2.0f * 3.14159265f * 0.5f * float(syncPeriod) / float(sampleRate);
+	syncKp = int32_t(65536.0f * 2.0f * 0.7f * wT / g);
+	syncKi = int32_t(65536.0f * wT * wT / g);
+	syncMaxTrim = int32_t((int64_t(syncADCInterval) << 24) / 1000);
+	syncCount = ~0u; // aligned with SampleCounter by the next ServiceSync
+	syncOffset = 0;
+	syncIntegral = syncTrim = 0;
+	syncDither = 0;
+	syncPhase = 0;
+	syncGood = -1;
+	syncRealigns = 0;
+	syncEdgeAge = 0;
+}
 
-	// SPI DMA timed to SPI TX
-	channel_config_set_dreq(&spi_dmacfg, SPI_DREQ);
+// Once per audio callback: send the word clock, or compare this card's count with the leader's edges
+void __not_in_flash_func(ComputerCard::ServiceSync)()
+{
+	if (syncCount >= uint32_t(syncPeriod)) syncCount = callbackFrame % uint32_t(syncPeriod);
+	if (syncMode == SyncLead)
+	{
+		PulseOut(syncPin, syncCount < uint32_t(syncPeriod / 2));
+	}
+	else if (pulse[syncPin] && !last_pulse[syncPin])
+	{
+		// The leader sends each edge from its callback for a multiple of period, so in step,
+		// the edge comes just after the start of the same sample here: read in the next
+		// callback, it is blockSize samples, less its offset, after the sample in step
+		uint32_t offset = usePulseCapture ? pulseEdgeOffset[syncPin][0] : uint32_t(blockSize) << 16;
+		int32_t half = syncPeriod << 15;
+		int32_t p = int32_t(syncCount << 16) - int32_t(offset);
+		if (p >= half) p -= 2 * half;
+		if (p < -half) p += 2 * half;
+		if (syncGood < 0 || p > (2 << 16) || p < -(2 << 16))
+		{
+			// Out of step: jump to the leader's count, to the nearest sample
+			int32_t shift = (p + 32768) >> 16;
+			syncOffset = syncOffset - uint32_t(shift);
+			syncCount = uint32_t((int32_t(syncCount) - shift % syncPeriod + syncPeriod) % syncPeriod);
+			p -= shift << 16;
+			syncRealigns = syncRealigns + 1;
+			syncGood = 0;
+		}
+		syncPhase = p;
+		int32_t limit = syncMaxTrim;
+		syncIntegral += int32_t((int64_t(p) * syncKi) >> 16);
+		syncIntegral = syncIntegral > limit ? limit : (syncIntegral < -limit ? -limit : syncIntegral);
+		int64_t u = ((int64_t(p) * syncKp) >> 16) + syncIntegral;
+		syncTrim = int32_t(u > limit ? limit : (u < -limit ? -limit : u));
+		if (p < 8192 && p > -8192) {if (syncGood < 16) syncGood = syncGood + 1;}
+		else syncGood = 0;
+		syncEdgeAge = 0;
+	}
+	else if (syncEdgeAge < 0x80000000u)
+	{
+		syncEdgeAge += blockSize;
+		if (syncEdgeAge > 4 * uint32_t(syncPeriod) && syncGood > 0) syncGood = 0;
+	}
 
-	// Set up DMA to transmit 2 samples to SPI
-	dma_channel_configure(spi_dma, &spi_dmacfg, &spi_get_hw(SPI_PORT)->dr, NULL, 2, false);
+	if (syncMode == SyncFollow)
+	{
+		// Whole divider LSBs this callback, dithering the fraction
+		uint32_t acc = syncDither + (uint32_t(syncTrim) & 0xFFFF);
+		syncDither = acc & 0xFFFF;
+		adc_hw->div = ((syncADCInterval - 1) << 8) + uint32_t((syncTrim >> 16) + int32_t(acc >> 16));
+	}
 
-	adc_run(true);
+	syncCount += blockSize;
+	if (syncCount >= uint32_t(syncPeriod)) syncCount -= syncPeriod;
+}
 
-	while (1)
+// Round 16-bit outputs to 12 bits, with the rounding error fed back (order 1: subtract the last
+// error, so the noise is e[n] - e[n-1]; order 2: e[n] - 2e[n-1] + e[n-2]). The errors stay
+// within -7 to 8 whatever the signal, as they're taken before clipping, so the loop is stable
+// Sub-rate processing for one frame: the inputs go down the decimators, ProcessSubRate runs
+// as each sub-rate sample completes, and out is this frame's share of the interpolated outputs
+void __not_in_flash_func(ComputerCard::ServiceSubRate)(int16_t inL, int16_t inR, int32_t *out)
+{
+	int32_t x[2] = {inL, inR};
+	int s = 0;
+	for (; s<subRateStages; s++)
 	{
-		// If ready to restart
-		if (runADCMode == RUN_ADC_MODE_REQUEST_ADC_RESTART)
+		if (!subRateHalf[s])
 		{
-			runADCMode = RUN_ADC_MODE_RUNNING;
+			subRateHeld[0][s] = x[0];
+			subRateHeld[1][s] = x[1];
+			subRateHalf[s] = true;
+			break;
+		}
+		subRateHalf[s] = false;
+		for (int c=0; c<2; c++) x[c] = subRateDown[c][s].Decimate(subRateHeld[c][s], x[c]);
+	}
 
-			dma_hw->ints0 = 1u << adc_dma; // reset adc interrupt flag
-			dma_channel_set_write_addr(adc_dma, ADC_Buffer[dmaPhase], true); // start writing into new buffer
-			dma_channel_set_read_addr(spi_dma, SPI_Buffer[dmaPhase], true); // start reading from new buffer
+	if (s == subRateStages)
+	{
+		subRateIn[0] = x[0];
+		subRateIn[1] = x[1];
+		ProcessSubRate();
 
-			adc_set_round_robin(0);
-			adc_select_input(0);
-			adc_set_round_robin(0b0001111U);
-			adc_run(true);
-		}
-		else if (runADCMode == RUN_ADC_MODE_ADC_STOPPED)
+		// Interpolate each output up, lowest rate first, into the frames until the next call
+		for (int c=0; c<2; c++)
 		{
-			// We can't remove the PWM IRQ from within the ADC IRQ callback, so we do it here instead.
-			irq_set_enabled(PWM_IRQ_WRAP, false);
-			pwm_clear_irq(pwm_gpio_to_slice_num(CV_OUT_1)); // reset CV PWM interrupt flag
-			irq_remove_handler(PWM_IRQ_WRAP, ComputerCard::OnCVPWMWrap);
-			break;
+			int32_t *buf = subRateUpBuf[c];
+			int32_t tmp[8];
+			buf[0] = subRateOut[c];
+			int n = 1;
+			for (int t=subRateStages-1; t>=0; t--)
+			{
+				for (int i=0; i<n; i++) subRateUp[c][t].Interpolate(buf[i], tmp[2*i], tmp[2*i+1]);
+				n *= 2;
+				for (int i=0; i<n; i++) buf[i] = tmp[i];
+			}
 		}
-		   
-
+		subRatePos = 0;
 	}
+
+	out[0] = subRateUpBuf[0][subRatePos];
+	out[1] = subRateUpBuf[1][subRatePos];
+	if (subRatePos < (1 << subRateStages) - 1) subRatePos++;
 }
 
-void ComputerCard::Abort()
+void __not_in_flash_func(ComputerCard::ShapeOutputs)(Frame *frames, int n)
 {
-	runADCMode = RUN_ADC_MODE_REQUEST_ADC_STOP;
+	for (int c=0; c<2; c++)
+	{
+		int32_t e1 = shapingError[c][0], e2 = shapingError[c][1];
+		for (int f=0; f<n; f++)
+		{
+			int32_t v = frames[f].audio[c] - e1;
+			if (noiseShapingOrder == 2) v += e2 - e1;
+			int32_t q = (v + 8) >> 4;
+			e2 = e1;
+			e1 = (q << 4) - v;
+			frames[f].audio[c] = int16_t(q < -2048 ? -2048 : (q > 2047 ? 2047 : q));
+		}
+		shapingError[c][0] = e1;
+		shapingError[c][1] = e2;
+	}
 }
 
-	  
+// DAC words for n frames, channel A then B for each, inverted to counteract the inverting output
+// stage. The same words as dacval, in one pass: after clamping, the control bits and the 0x800
+// offset are a single add
+void __not_in_flash_func(ComputerCard::FormatDACBlock)(const Frame *frames, uint16_t *words, int n)
+{
+	constexpr uint16_t zeroA = DAC_CHANNEL_A | 0x3000 | 0x800, zeroB = DAC_CHANNEL_B | 0x3000 | 0x800;
+	for (int f=0; f<n; f++)
+	{
+		// As dacval's int16_t argument, -(-32768) stays -32768
+		int32_t a = int16_t(-frames[f].audio[0]);
+		int32_t b = int16_t(-frames[f].audio[1]);
+		a = a < -2048 ? -2048 : (a > 2047 ? 2047 : a);
+		b = b < -2048 ? -2048 : (b > 2047 ? 2047 : b);
+		words[2*f] = uint16_t(zeroA + a);
+		words[2*f+1] = uint16_t(zeroB + b);
+	}
+}
 
-// Per-audio-sample ISR, called when two sets of ADC samples have been collected from all four inputs
-void __not_in_flash_func(ComputerCard::BufferFull)()
+// Per-block ISR, used instead of BufferFull when COMPUTERCARD_BLOCK_SIZE > 1.
+// Called when blockSize frames of ADC samples have been collected.
+void __not_in_flash_func(ComputerCard::BlockFull)()
 {
-	static int startupCounter = 8; // Decreases by 1 each sample, can do startup things when nonzero.
+	// log2 of an integer power of two
+	constexpr auto log2i = [](int n) constexpr { int r = 0; while (n > 1) { n >>= 1; r++; } return r; };
+
+	// The mux is advanced once per block. Readings of the mux inputs are averaged
+	// over the second half of the block only, to allow the mux to settle.
+	constexpr int muxFrames = (blockSize > 1) ? blockSize / 2 : 1;
+	constexpr int muxShift = log2i(muxFrames);
+
+	// Each knob is updated every 4 blocks, and each CV every 2 blocks,
+	// so reduce the smoothing to keep roughly the same time constants as per-sample mode
+	int knobBlockShift = (log2i(blockSize) < knobSmoothShift) ? knobSmoothShift - log2i(blockSize) : 0;
+	int cvBlockShift = (log2i(blockSize) < cvSmoothShift) ? cvSmoothShift - log2i(blockSize) : 0;
+
+	// Normalisation probe period, in blocks of bs frames: at least 32 frames, and at least 4 blocks.
+	// Each block is captured during the one before it is processed, so the probe value set at
+	// count 0 is first seen at count 1; both CV inputs are measured in the last two blocks.
+	constexpr auto probeBlocks = [](int bs) constexpr { return (32 / bs > 4) ? 32 / bs : 4; };
+	// Whether, with blocks of bs frames, both CV inputs are measured from blocks captured after
+	// the probe value was set, at least 14 frames after it, as in BufferFull
+	constexpr auto probeSettled = [probeBlocks](int bs) constexpr {
+		int firstCV = probeBlocks(bs) - 2;
+		return firstCV >= 1 && firstCV * bs - 1 >= 14;
+	};
+	static_assert(probeSettled(2) && probeSettled(4) && probeSettled(8) && probeSettled(16) && probeSettled(32)
+				  && probeSettled(64) && probeSettled(128) && probeSettled(256),
+				  "Normalisation probe measures CV inputs before they have settled");
+	constexpr int normProbeBlocks = probeBlocks(blockSize);
+
+	static int startupCounter = 8; // Decreases by 1 each block, can do startup things when nonzero.
 	static int mux_state = 0;
+	static int mux_pos = 0; // position in muxSchedule
 	static int norm_probe_count = 0;
 
 	// Internal variables for IIR filters on knobs/cv
-	static volatile int32_t knobssm[4] = { 0, 0, 0, 0 };
-	static volatile int32_t cvsm[2] = { 0, 0 };
-	__attribute__((unused)) static int np = 0, np1 = 0, np2 = 0;
+	static int32_t knobssm[4] = { 0, 0, 0, 0 };
+	static int32_t cvsm[2] = { 0, 0 };
+	static int32_t np = 0;
+
+	Trace(TraceAudio | TraceBegin);
+	if (usePulseEngine) SendScheduledPulses();
 
 	adc_select_input(0);
 
-	// Advance external mux to next state
-	int next_mux_state = (mux_state + 1) & 0x3;
-	gpio_put(MX_A, next_mux_state & 1);
-	gpio_put(MX_B, next_mux_state & 2);
+	// Advance external mux to next state in the schedule, measuring CV 1 then CV 2 for the normalisation probe
+	mux_pos = (mux_pos + 1) & (muxScheduleLen - 1);
+	int next_mux_state = muxSchedule[mux_pos];
+	int next_probe_count = (norm_probe_count + 1) & (normProbeBlocks - 1);
+	if (useNormProbe && normProbeActive && next_probe_count >= normProbeBlocks - 2) next_mux_state = (next_mux_state & 2) | (next_probe_count & 1);
+	SetMuxAddress(next_mux_state);
 
-	// Set up new writes into next buffer
+	// Set up new writes into next buffer.
+	// The SPI DMAs run continuously, so only the ADC needs restarting.
 	uint8_t cpuPhase = dmaPhase;
 	dmaPhase = 1 - dmaPhase;
 
 	dma_hw->ints0 = 1u << adc_dma; // reset adc interrupt flag
 	dma_channel_set_write_addr(adc_dma, ADC_Buffer[dmaPhase], true); // start writing into new buffer
-	dma_channel_set_read_addr(spi_dma, SPI_Buffer[dmaPhase], true); // start reading from new buffer
+
+	const uint16_t *adcBuf = ADC_Buffer[cpuPhase];
+
+	// Index of the last sample of ADC input 0 in each frame, as in BufferFull
+	const int second = adcFrameLen - 4;
 
 	////////////////////////////////////////
 	// Collect various inputs and put them in variables for the DSP
 
-	// Set CV inputs, with ~240Hz LPF on CV input
-	int cvi = mux_state % 2;
-
-	// Attempted compensation of ADC DNL errors. Not really tested.
-	uint16_t adc512=ADC_Buffer[cpuPhase][3]+512;
-	if (!(adc512 % 0x01FF)) ADC_Buffer[cpuPhase][3] += 4;
-	ADC_Buffer[cpuPhase][3] += (adc512>>10) << 3;
-	
-	cvsm[cvi] = (15 * (cvsm[cvi]) + 16 * ADC_Buffer[cpuPhase][3]) >> 4;
-	cv[cvi] = 2048 - (cvsm[cvi] >> 4);
+	int32_t cvSum = 0, knobSum = 0;
+	for (int f = blockSize - muxFrames; f < blockSize; f++)
+	{
+		// Compensation of ADC DNL errors, as in BufferFull
+		uint16_t cvRaw = adcBuf[adcFrameLen*f+3];
+		cvRaw += adcCorrection.v[cvRaw & 0xFFF] + adcCorrectionMid;
 
+		cvSum += cvRaw;
+		knobSum += adcBuf[adcFrameLen*f+second+2];
+	}
 
-	// Set audio inputs, by averaging the two samples collected.
-	// Invert to counteract inverting op-amp input configuration
-	adcInR = -(((ADC_Buffer[cpuPhase][0] + ADC_Buffer[cpuPhase][4]) - 0x1000) >> 1);
+	// Set CV inputs
+	int cvi = mux_state % 2;
+	cvFast[cvi] = 2048 - (cvSum >> muxShift);
+	int32_t last = cv[cvi];
+	if (useAdaptiveSmoothing)
+	{
+		cvSmoother[cvi].Update(cvSum >> muxShift, cvBlockShift);
+		cv[cvi] = 2048 - cvSmoother[cvi].Value();
+	}
+	else
+	{
+		cvsm[cvi] += (((cvSum << 4) >> muxShift) - cvsm[cvi]) >> cvBlockShift;
+		cv[cvi] = 2048 - (cvsm[cvi] >> 4);
+	}
+	if (cv[cvi] != last) controlsChanged |= ChangedCV1 << cvi;
 
-	adcInL = -(((ADC_Buffer[cpuPhase][1] + ADC_Buffer[cpuPhase][5]) - 0x1000) >> 1);
+	// Set knobs
+	int knob = mux_state;
+	last = knobs[knob];
+	if (useAdaptiveSmoothing)
+	{
+		knobSmoother[knob].Update(knobSum >> muxShift, knobBlockShift);
+		knobs[knob] = knobSmoother[knob].Value();
+	}
+	else
+	{
+		knobssm[knob] += (((knobSum << 4) >> muxShift) - knobssm[knob]) >> knobBlockShift;
+		knobs[knob] = knobssm[knob] >> 4;
+	}
+	if (knob < 3 && knobs[knob] != last) controlsChanged |= ChangedMain << knob;
 
-	// Set pulse inputs
+	// Set pulse inputs.
+	// The GPIO hardware (or PIO, with EnablePulseCapture) latches edges, so a pulse that
+	// starts and ends within one block is still reported, stretched to one block long.
 	last_pulse[0] = pulse[0];
 	last_pulse[1] = pulse[1];
 	pulse[0] = !gpio_get(PULSE_1_INPUT);
 	pulse[1] = !gpio_get(PULSE_2_INPUT);
-
-	// Set knobs, with ~60Hz LPF
-	int knob = mux_state;
-	knobssm[knob] = (127 * (knobssm[knob]) + 16 * ADC_Buffer[cpuPhase][6]) >> 7;
-	knobs[knob] = knobssm[knob] >> 4;
+	if (usePulseCapture) ReadPulseCapture();
+	else for (int i=0; i<2; i++)
+	{
+		uint gpio = PULSE_1_INPUT + i;
+		uint32_t events = (io_bank0_hw->intr[gpio >> 3] >> (4 * (gpio & 7))) & 0xF;
+		gpio_acknowledge_irq(gpio, events);
+		// Pulse inputs are inverted, so a falling GPIO edge is a rising pulse edge
+		if (events & GPIO_IRQ_EDGE_FALL)
+		{
+			last_pulse[i] = false;
+			pulse[i] = true;
+		}
+	}
 
 	// Set switch value
 	switchVal = static_cast<Switch>((knobs[3]>1000) + (knobs[3]>3000));
+	if (switchVal != lastSwitchVal) controlsChanged |= ChangedSwitch;
 	if (startupCounter)
 	{
 		// Don't detect switch changes in first few cycles
 		lastSwitchVal = switchVal;
-		// Should initialise knob and CV smoothing filters here too
+		if (startupCounter == 8) bootTimes.firstSample = time_us_32();
 	}
-	
+
 	////////////////////////////
 	// Normalisation probe
 
-	if (useNormProbe)
+	if (useNormProbe && norm_probe_count == 0) normProbeActive = NormProbeBurst(normProbeBlocks * blockSize);
+	if (useNormProbe && normProbeActive)
 	{
+		const uint16_t *lastFrame = adcBuf + adcFrameLen*(blockSize-1);
+
 		// Set normalisation probe output value
 		// and update np to the expected history string
 		if (norm_probe_count == 0)
@@ -636,46 +7618,108 @@ void __not_in_flash_func(ComputerCard::BufferFull)()
 			np = (np<<1)+(normprobe&0x1);
 		}
 
-		// CV sampled at 24kHz comes in over two successive samples
-		if (norm_probe_count == 14 || norm_probe_count == 15)
+		// Each CV input is measured in one of the last two blocks of the probe period
+		if (norm_probe_count >= normProbeBlocks - 2)
 		{
-			plug_state[2+cvi] = (plug_state[2+cvi]<<1)+(ADC_Buffer[cpuPhase][3]<1800);
+			plug_state[2+cvi] = (plug_state[2+cvi]<<1)+(lastFrame[3]<1800);
 		}
 
-		// Audio and pulse measured every sample at 48kHz
-		if (norm_probe_count == 15)
+		if (norm_probe_count == normProbeBlocks - 1)
 		{
-			plug_state[Input::Audio1] = (plug_state[Input::Audio1]<<1)+(ADC_Buffer[cpuPhase][5]<1800);
-			plug_state[Input::Audio2] = (plug_state[Input::Audio2]<<1)+(ADC_Buffer[cpuPhase][4]<1800);
+			plug_state[Input::Audio1] = (plug_state[Input::Audio1]<<1)+(lastFrame[second+1]<1800);
+			plug_state[Input::Audio2] = (plug_state[Input::Audio2]<<1)+(lastFrame[second]<1800);
 			plug_state[Input::Pulse1] = (plug_state[Input::Pulse1]<<1)+(pulse[0]);
 			plug_state[Input::Pulse2] = (plug_state[Input::Pulse2]<<1)+(pulse[1]);
 
-			for (int i=0; i<6; i++)
-			{
-				connected[i] = (np != plug_state[i]);
-			}
+			UpdateConnections(np);
 		}
-		
+	}
+
+	if (useNormProbe)
+	{
 		// Force disconnected values to zero, rather than the normalisation probe garbage
-		if (Disconnected(Input::Audio1)) adcInL = 0;
-		if (Disconnected(Input::Audio2)) adcInR = 0;
-		if (Disconnected(Input::CV1)) cv[0] = 0;
-		if (Disconnected(Input::CV2)) cv[1] = 0;
+		if (Disconnected(Input::CV1)) cv[0] = cvFast[0] = 0;
+		if (Disconnected(Input::CV2)) cv[1] = cvFast[1] = 0;
 		if (Disconnected(Input::Pulse1)) pulse[0] = 0;
 		if (Disconnected(Input::Pulse2)) pulse[1] = 0;
 	}
-	
+
+	// Set audio inputs, from the samples of them collected in each frame
+	bool zeroL = useNormProbe && Disconnected(Input::Audio1);
+	bool zeroR = useNormProbe && Disconnected(Input::Audio2);
+	for (int f=0; f<blockSize; f++)
+	{
+		const uint16_t *frame = adcBuf + adcFrameLen*f;
+		int16_t l = AudioFromFrame(frame, 1), r = AudioFromFrame(frame, 0);
+		blockIn[f].audio[0] = zeroL ? 0 : l;
+		blockIn[f].audio[1] = zeroR ? 0 : r;
+	}
+#ifdef COMPUTERCARD_SOAK
+	SoakInputs();
+	for (int f=0; f<blockSize; f++)
+	{
+		blockIn[f].audio[0] = SoakAudio(0, f);
+		blockIn[f].audio[1] = SoakAudio(1, f);
+	}
+#endif
+	if (captureBuffer)
+	{
+		dma_channel_set_write_addr(captureDMA, captureBuffer + captureIndex, false);
+		dma_channel_set_read_addr(captureDMA, blockIn, true);
+	}
+
+	if (useInputSnapshot) TakeInputSnapshot();
+
+	// PulseAudioOut writes the half of pulseAudioBuffer that its DMA has just finished with
+	pulseAudioWrite = pulseAudioBuffer[cpuPhase];
+
 	////////////////////////////////////////
 	// Run the DSP
-	ProcessSample();
+	if (useLoadMeter)
+	{
+		uint32_t start = systick_hw->cvr;
+		StartCallback();
+		PollControl();
+		ProcessBlock(blockIn, blockOut, blockSize);
+		UpdateLoadMeter(start, systick_hw->cvr);
+	}
+	else
+	{
+		StartCallback();
+		PollControl();
+		ProcessBlock(blockIn, blockOut, blockSize);
+	}
+	if (captureBuffer && (captureIndex += blockSize) == captureFrames) captureIndex = 0;
 
 	////////////////////////////////////////
 	// Collect DSP outputs and put them in the DAC SPI buffer
-	// CV/Pulse outputs are done immediately in ProcessSample
 
-	// Invert dacout to counteract inverting output configuration
-	SPI_Buffer[cpuPhase][0] = dacval(-dacOut[0], DAC_CHANNEL_A);
-	SPI_Buffer[cpuPhase][1] = dacval(-dacOut[1], DAC_CHANNEL_B);
+	// The whole block, ready for spi_block_dma to stream out
+	if (latencyMode != LatencyIdle)
+	{
+		for (int f=0; f<blockSize && latencyMode != LatencyIdle; f++) ServiceLatency(blockIn[f].audio[latencyIn], blockOut[f].audio[latencyOut]);
+	}
+	if (subRateStages)
+	{
+		// Sub-rate outputs added at 16 bits, with noise shaping
+		int shift = noiseShapingOrder ? 4 : 0;
+		for (int f=0; f<blockSize; f++)
+		{
+			int32_t sub[2];
+			ServiceSubRate(blockIn[f].audio[0], blockIn[f].audio[1], sub);
+			for (int c=0; c<2; c++)
+			{
+				int32_t v = blockOut[f].audio[c] + (sub[c] << shift);
+				blockOut[f].audio[c] = int16_t(v < -32768 ? -32768 : (v > 32767 ? 32767 : v));
+			}
+		}
+	}
+	if (noiseShapingOrder) ShapeOutputs(blockOut, blockSize);
+	FormatDACBlock(blockOut, SPI_Buffer[cpuPhase], blockSize);
+	if (useAudioLink) SendLink();
+
+	if (useCVDMA) UpdateCVDither();
+	if (useLedEngine) PollLeds();
 
 	mux_state = next_mux_state;
 
@@ -689,19 +7733,84 @@ void __not_in_flash_func(ComputerCard::BufferFull)()
 		dma_hw->ints0 = 1u << adc_dma; // reset adc interrupt flag
 		dma_channel_cleanup(adc_dma);
 		dma_channel_cleanup(spi_dma);
+		dma_channel_cleanup(spi_block_dma[0]);
+		dma_channel_cleanup(spi_block_dma[1]);
+		if (captureBuffer) dma_channel_cleanup(captureDMA);
+		dma_timer_unclaim(spi_timer);
 		irq_set_enabled(DMA_IRQ_0, false);
-		irq_remove_handler(DMA_IRQ_0, ComputerCard::AudioCallback);
+		irq_remove_handler(DMA_IRQ_0, audioHandler);
 
-
-		
 		runADCMode = RUN_ADC_MODE_ADC_STOPPED;
 	}
 
-	norm_probe_count = (norm_probe_count + 1) & 0xF;
+	// If the next ADC buffer is already full, this block has overrun its deadline
+	if (useLoadMeter && (dma_hw->ints0 & (1u << adc_dma)))
+	{
+		loadOverruns++;
+		Trace(TraceOverrun);
+#ifdef COMPUTERCARD_SOAK
+		SoakOverrun();
+#endif
+	}
+
+	norm_probe_count = (norm_probe_count + 1) & (normProbeBlocks - 1);
 
 	lastSwitchVal = switchVal;
-	
+
 	if (startupCounter) startupCounter--;
+	Trace(TraceAudio | TraceEnd);
+}
+
+void ComputerCard::StackBounds(int core, uint32_t *&bottom, uint32_t *&top)
+{
+	bottom = reinterpret_cast<uint32_t *>(core ? &__StackOneBottom : &__StackBottom);
+	top = reinterpret_cast<uint32_t *>(core ? &__StackOneTop : &__StackTop);
+}
+
+void ComputerCard::PaintStack(int core, uint32_t *end)
+{
+	uint32_t *bottom, *top;
+	StackBounds(core, bottom, top);
+	for (volatile uint32_t *p = bottom; p < end; p++) *p = stackPaint;
+	stackPainted[core] = true;
+}
+
+void ComputerCard::PaintCore1Stack()
+{
+	uint32_t *bottom, *top;
+	StackBounds(1, bottom, top);
+	PaintStack(1, top);
+}
+
+ComputerCard::MemoryStats ComputerCard::MemoryUsage()
+{
+	MemoryStats m;
+	for (int core=0; core<2; core++)
+	{
+		uint32_t *bottom, *top;
+		StackBounds(core, bottom, top);
+		m.stackSize[core] = uint32_t(top - bottom) * 4;
+		const volatile uint32_t *p = bottom;
+		while (p < top && *p == stackPaint) p++;
+		m.stackUsed[core] = stackPainted[core] ? uint32_t(top - p) * 4 : 0;
+	}
+
+	uintptr_t heapStart = reinterpret_cast<uintptr_t>(&__end__);
+	uintptr_t heapLimit = reinterpret_cast<uintptr_t>(&__StackLimit);
+	m.staticBytes = uint32_t(heapStart - SRAM_BASE);
+#ifdef COMPUTERCARD_NO_HEAP
+	// mallinfo would link in the allocator
+	m.heapPeak = m.heapInUse = 0;
+	m.heapFree = uint32_t(heapLimit - heapStart);
+#else
+	struct mallinfo mi = mallinfo();
+	m.heapPeak = uint32_t(mi.arena);
+	m.heapInUse = uint32_t(mi.uordblks);
+	m.heapFree = heapStart + mi.arena < heapLimit ? uint32_t(heapLimit - heapStart - mi.arena) : 0;
+#endif
+	m.xipAccesses = xip_ctrl_hw->ctr_acc;
+	m.xipHits = xip_ctrl_hw->ctr_hit;
+	return m;
 }
 
 ComputerCard::HardwareVersion_t ComputerCard::ProbeHardwareVersion()
@@ -745,13 +7854,103 @@ ComputerCard::HardwareVersion_t ComputerCard::ProbeHardwareVersion()
 
 ComputerCard::ComputerCard()
 {
+	bootTimes = {};
+	bootTimes.constructor = time_us_32();
+
+	// Paint the free part of the stack this is running on, below this function's own frame
+	uint32_t marker = 0;
+	uint32_t *sp = &marker;
+	for (int core=0; core<2; core++)
+	{
+		uint32_t *bottom, *top;
+		StackBounds(core, bottom, top);
+		if (sp > bottom && sp <= top) PaintStack(core, sp - 16);
+	}
+	numStartupTasks = nextStartupTask = startupStep = 0;
+
 	runADCMode = RUN_ADC_MODE_RUNNING;
+	audioHandler = AudioCallback; // set again by ComputerCardT::Run
 
 	adc_run(false);
 	adc_select_input(0);
 
 
 	useNormProbe = false;
+	probeMode = ProbeContinuous;
+	probeIntervalMs = 100;
+	probeIntervalSamples = probeBurstSamples = 4800;
+	probeTimer = probeLeft = 0;
+	probeRequested = true; // first burst at startup
+	normProbeActive = false;
+	useAdaptiveSmoothing = false;
+	useMuxCorrection = false;
+	muxCorrectionShift = 8;
+	for (int i=0; i<2*muxScheduleLen; i++) muxOffset[0][i] = muxOffset[1][i] = 0;
+	muxOffsetSum[0] = muxOffsetSum[1] = 0;
+	controlsChanged = 0;
+	for (int i=0; i<muxScheduleLen; i++) muxSchedule[i] = i & 0x3;
+	useLoadMeter = false;
+	usePulseCapture = false;
+	useMuxSequencer = false;
+	usePulseEngine = false;
+	syncMode = SyncOff;
+	syncOffset = 0;
+	syncADCInterval = 125;
+	syncTrim = syncPhase = 0;
+	syncGood = -1;
+	syncRealigns = 0;
+	usePulseAudio = false;
+	latencyMode = LatencyIdle;
+	latencyResult = LatencyStats{};
+	useAudioLink = false;
+	captureBuffer = nullptr;
+	captureFrames = 0;
+	captureIndex = 0;
+	audioOnCore1 = false;
+	core0Fn = nullptr;
+	audioRunning = false;
+#ifdef COMPUTERCARD_LINK
+	linkTxWrite = linkTx[0];
+	for (int j=0; j<linkFrameWords; j++) linkTx[0][j] = 0;
+	linkLatency = 2;
+	linkConnected = false;
+	linkFrames = linkErrors = linkSlips = 0;
+	linkQueued = 0;
+#endif
+	pulseAudioWrite = pulseAudioBuffer[0];
+	lowPowerKHz = 0;
+	dutyPercent = 0;
+	useCVDMA = false;
+	useLedEngine = false;
+	noiseShapingOrder = 0;
+	ResetCVInCalibration(0);
+	ResetCVInCalibration(1);
+	shapingError[0][0] = shapingError[0][1] = shapingError[1][0] = shapingError[1][1] = 0;
+	sampleRate = SR48kHz;
+	audioOversampling = 2;
+	audioCIC[0][0] = audioCIC[0][1] = audioCIC[1][0] = audioCIC[1][1] = 0;
+	controlPeriod = 0;
+	subRateStages = 0;
+	subRatePos = 0;
+	for (int i=0; i<3; i++) subRateHalf[i] = false;
+	for (int c=0; c<2; c++)
+	{
+		subRateIn[c] = subRateOut[c] = 0;
+		for (int i=0; i<8; i++) subRateUpBuf[c][i] = 0;
+	}
+	controlCount = 0;
+	midiLatency = 48 + blockSize;
+	loadAvgCycles8 = 0;
+	loadBudgetCycles = 0;
+	qualityLevels = qualityLevel = 0;
+	qualityDownPercent = 90;
+	qualityUpPercent = 60;
+	qualityWindowMs = 100;
+	qualityHold = 10;
+	qualityWindowCalls = 1;
+	qualityCalls = qualityCycles = 0;
+	qualityCalm = 0;
+	ResetLoadMeter();
 	for (int i=0; i<6; i++)
 	{
 		connected[i] = false;
@@ -895,6 +8094,7 @@ ComputerCard::ComputerCard()
 	
 	// Read EEPROM calibration values
 	ReadEEPROM();
+	bootTimes.calibrated = time_us_32();
 
 	// Read unique card ID
 	flash_get_unique_id((uint8_t *) &uniqueID);
@@ -970,10 +8170,25 @@ int ComputerCard::ReadEEPROM()
 	calibrationTable[1][2].voltage = 20; // +2V
 	calibrationTable[1][2].dacSetting = 174400;
 
+	for (int channel = 0; channel < calMaxChannels; channel++)
+	{
+		numCalibrationPoints[channel] = 3;
+		CalcCalCoeffs(channel);
+	}
+
 	if (ReadIntFromEEPROM(EEPROM_ADDR_ID) != EEPROM_VAL_ID)
 	{
 		return 1;
 	}
+
+#ifdef COMPUTERCARD_CALIBRATION_CACHE
+	// The cached calibration holds if it came from EEPROM contents with the same CRC
+	if (LoadCalibrationCache(ReadIntFromEEPROM(EEPROM_ADDR_CRC_H)))
+	{
+		return 0;
+	}
+#endif
+
 	uint8_t buf[EEPROM_NUM_BYTES];
 	for (int i = 0; i < EEPROM_NUM_BYTES; i++)
 	{
@@ -1014,9 +8229,65 @@ int ComputerCard::ReadEEPROM()
 		CalcCalCoeffs(channel);
 	}
 
+#ifdef COMPUTERCARD_CALIBRATION_CACHE
+	SaveCalibrationCache(foundCRC);
+#endif
+
 	return 0;
 }
 
+#ifdef COMPUTERCARD_CALIBRATION_CACHE
+// Use the calibration cached in flash, if it is valid and came from EEPROM contents with CRC eepromCRC
+bool ComputerCard::LoadCalibrationCache(uint16_t eepromCRC)
+{
+	const CalCache *c = reinterpret_cast<const CalCache *>(XIP_BASE + calCacheOffset);
+	if (c->magic != calCacheMagic || c->eepromCRC != eepromCRC) return false;
+	const uint8_t *data = reinterpret_cast<const uint8_t *>(c) + offsetof(CalCache, numCalibrationPoints);
+	if (CRCencode(data, sizeof(CalCache) - offsetof(CalCache, numCalibrationPoints)) != c->crc) return false;
+
+	for (int channel = 0; channel < calMaxChannels; channel++)
+	{
+		if (c->numCalibrationPoints[channel] > calMaxPoints) return false;
+	}
+	memcpy(numCalibrationPoints, c->numCalibrationPoints, sizeof(numCalibrationPoints));
+	memcpy(calibrationTable, c->calibrationTable, sizeof(calibrationTable));
+	memcpy(calCoeffs, c->calCoeffs, sizeof(calCoeffs));
+	memcpy(calCentsSlope, c->calCentsSlope, sizeof(calCentsSlope));
+	for (int channel = 0; channel < calMaxChannels; channel++)
+	{
+		CalcMIDIDacTable(channel);
+	}
+	return true;
+}
+
+// Write the current calibration to the flash cache. Only called from the constructor, before
+// audio (or the other core) is running, so flash can be written without stopping anything
+void ComputerCard::SaveCalibrationCache(uint16_t eepromCRC)
+{
+	alignas(4) uint8_t page[FLASH_PAGE_SIZE];
+	memset(page, 0xFF, sizeof(page));
+	CalCache *c = reinterpret_cast<CalCache *>(page);
+	memset(c, 0, sizeof(CalCache));
+	c->magic = calCacheMagic;
+	c->eepromCRC = eepromCRC;
+	memcpy(c->numCalibrationPoints, numCalibrationPoints, sizeof(numCalibrationPoints));
+	memcpy(c->calibrationTable, calibrationTable, sizeof(calibrationTable));
+	memcpy(c->calCoeffs, calCoeffs, sizeof(calCoeffs));
+	memcpy(c->calCentsSlope, calCentsSlope, sizeof(calCentsSlope));
+	c->crc = CRCencode(page + offsetof(CalCache, numCalibrationPoints), sizeof(CalCache) - offsetof(CalCache, numCalibrationPoints));
+
+	// Skip the write if the cache already holds this
+	if (memcmp(reinterpret_cast<const void *>(XIP_BASE + calCacheOffset), page, sizeof(CalCache)) == 0) return;
+
+	Trace(TraceFlash | TraceBegin, uint16_t(calCacheOffset >> 12));
+	uint32_t ints = save_and_disable_interrupts();
+	flash_range_erase(calCacheOffset, FLASH_SECTOR_SIZE);
+	flash_range_program(calCacheOffset, page, FLASH_PAGE_SIZE);
+	restore_interrupts(ints);
+	Trace(TraceFlash | TraceEnd, uint16_t(calCacheOffset >> 12));
+}
+#endif
+
 void ComputerCard::CalcCalCoeffs(int channel)
 {
 	float sumV = 0.0;
@@ -1048,6 +8319,61 @@ void ComputerCard::CalcCalCoeffs(int channel)
 
 	calCoeffs[channel].mi = int32_t(calCoeffs[channel].m * 1.333333333333333f + 0.5f);
 	calCoeffs[channel].bi = int32_t(calCoeffs[channel].b + 0.5f);
+
+	// Change in CV output value per cent is m / 1200, stored in Q8
+	calCentsSlope[channel] = int32_t(calCoeffs[channel].m * (256.0f / 1200.0f) + (calCoeffs[channel].m < 0 ? -0.5f : 0.5f));
+	CalcMIDIDacTable(channel);
+}
+
+// Nominally ±6V over the 4096 CVIn values, so 12 semitones per 2048/6 values
+void ComputerCard::ResetCVInCalibration(int i)
+{
+	for (int k = 0; k <= 64; k++)
+	{
+		cvInPitchTable[i][k] = (60 << 16) + (k * 64 - 2048) * 2304;
+	}
+}
+
+bool ComputerCard::SetCVInCalibration(int i, const CVInCalPoint *points, int n)
+{
+	if (n < 2 || n > calMaxPoints) return false;
+
+	// Sorted by CVIn value
+	CVInCalPoint p[calMaxPoints];
+	for (int j = 0; j < n; j++)
+	{
+		int k = j;
+		for (; k > 0 && p[k - 1].cvIn > points[j].cvIn; k--) p[k] = p[k - 1];
+		p[k] = points[j];
+	}
+	for (int j = 1; j < n; j++)
+	{
+		if (p[j].cvIn == p[j - 1].cvIn) return false;
+	}
+
+	// Each table entry on the segment between the points either side of it, or the end segment
+	int s = 0;
+	for (int k = 0; k <= 64; k++)
+	{
+		int32_t c = k * 64 - 2048;
+		while (s < n - 2 && c > p[s + 1].cvIn) s++;
+		int64_t dc = p[s + 1].cvIn - p[s].cvIn;
+		int64_t mv = p[s].millivolts * dc + int64_t(p[s + 1].millivolts - p[s].millivolts) * (c - p[s].cvIn);
+		// 12 semitones per volt, in Q16, rounded to nearest
+		int64_t num = mv * (12 << 16), den = 1000 * dc;
+		int64_t pitch = (num >= 0 ? num + den / 2 : num - den / 2) / den;
+		cvInPitchTable[i][k] = int32_t((60 << 16) + pitch);
+	}
+	return true;
+}
+
+// Integer only, so cheap enough to redo from cached coefficients
+void ComputerCard::CalcMIDIDacTable(int channel)
+{
+	for (int note = 0; note < 128; note++)
+	{
+		midiDacTable[channel][note] = MIDIToDac(note, channel);
+	}
 }
 
 
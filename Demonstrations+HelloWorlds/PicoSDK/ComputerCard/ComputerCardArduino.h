@@ -0,0 +1,200 @@
+/*
+ComputerCard for Arduino sketches, with the earlephilhower Arduino-Pico core
+
+For sketches that read the Computer's inputs with analogRead, and write the DAC over SPI and
+the CV outputs with analogWrite, from loop(), so that their timing depends on how long each
+pass of loop() takes. ArduinoCard runs ComputerCard's audio engine instead (ADC and DAC by DMA,
+mux scanning, calibrated CV outputs, normalisation probe) on core 1, started from setup1(),
+and calls the sketch's function there at a fixed sample rate, while loop() carries on with USB,
+MIDI and the rest on core 0.
+
+Copy ComputerCard.h and this file into the sketch's folder. The sketch sets up its options in
+setup() and calls Start; Run, called from setup1(), waits for Start and never returns:
+
+	#include "ComputerCardArduino.h"
+
+	ArduinoCard card;
+
+	// Every sample, on core 1
+	void process(ArduinoCard &c)
+	{
+		c.AudioOut1((c.AudioIn1() * c.KnobVal(ArduinoCard::Main)) >> 12);
+	}
+
+	void setup()
+	{
+		card.EnableNormalisationProbe();
+		card.SetCallback(process);
+		card.Start();
+	}
+
+	void setup1()
+	{
+		card.Run();
+	}
+
+	void loop()
+	{
+		// Core 0: the latest inputs, and outputs held until changed
+		card.HoldLed(0, card.LatestKnob(ArduinoCard::X));
+		delay(10);
+	}
+
+Sketches that stay driven by loop() need no callback: the Latest functions return each input
+as of the last sample, and the Hold functions set outputs that the audio core writes at its next
+sample, in place of analogRead, dacWrite and analogWrite. Their inputs and outputs then no
+longer cost loop() the time of ADC conversions and SPI transfers, though they are still only
+as up to date as loop() is. The callback may write any output itself, which then takes the
+place of its held value until the next Hold call for that output.
+
+Only sample-by-sample processing is supported (COMPUTERCARD_BLOCK_SIZE 1), and as the audio
+already runs on core 1, RunOnCore1 and the core 1 tasks are not available. Flash writes from
+core 0 (EEPROM.commit, LittleFS) pause core 1, and so the audio, while they run.
+*/
+
+#ifndef COMPUTERCARD_ARDUINO_H
+#define COMPUTERCARD_ARDUINO_H
+
+#include "ComputerCard.h"
+
+class ArduinoCard : public ComputerCard
+{
+	static_assert(blockSize == 1, "ArduinoCard calls its callback every sample, so needs COMPUTERCARD_BLOCK_SIZE 1");
+public:
+	/// Function called every sample on the audio core, with the card, whose input and output functions it may use
+	typedef void (*Callback)(ArduinoCard &card);
+
+	/// Use before Start to set the function called every sample
+	void SetCallback(Callback fn) {callback = fn;}
+
+	/// Call at the end of setup(), once the options are set, to let Run start the audio
+	void Start(SampleRate_t rate = SR48kHz)
+	{
+		startRate = rate;
+		__atomic_store_n(&started, true, __ATOMIC_RELEASE);
+	}
+
+	/// Call from setup1(): waits for Start, then runs the audio on core 1. Never returns, unless Abort is called
+	void Run()
+	{
+		while (!__atomic_load_n(&started, __ATOMIC_ACQUIRE)) tight_loop_contents();
+		ComputerCard::Run(startRate);
+	}
+
+	/// \name For the callback: ComputerCard's input and output functions
+	///@{
+	using ComputerCard::KnobVal;
+	using ComputerCard::SwitchVal;
+	using ComputerCard::SwitchChanged;
+	using ComputerCard::AudioIn;
+	using ComputerCard::AudioIn1;
+	using ComputerCard::AudioIn2;
+	using ComputerCard::CVIn;
+	using ComputerCard::CVIn1;
+	using ComputerCard::CVIn2;
+	using ComputerCard::CVInFast;
+	using ComputerCard::PulseIn;
+	using ComputerCard::PulseIn1;
+	using ComputerCard::PulseIn2;
+	using ComputerCard::PulseInRisingEdge;
+	using ComputerCard::PulseInFallingEdge;
+	using ComputerCard::Connected;
+	using ComputerCard::Disconnected;
+	using ComputerCard::AudioOut;
+	using ComputerCard::AudioOut1;
+	using ComputerCard::AudioOut2;
+	using ComputerCard::CVOut;
+	using ComputerCard::CVOut1;
+	using ComputerCard::CVOut2;
+	using ComputerCard::CVOutPrecise;
+	using ComputerCard::CVOutMIDINote;
+	using ComputerCard::PulseOut;
+	using ComputerCard::PulseOut1;
+	using ComputerCard::PulseOut2;
+	using ComputerCard::LedOn;
+	using ComputerCard::LedBrightness;
+	///@}
+
+	/// \name For loop(): inputs as of the latest sample
+	///@{
+	int32_t LatestKnob(Knob k) {return latestKnobs[k];}                     ///< 0-4095
+	Switch LatestSwitch() {return Switch(latestSwitch);}
+	int16_t LatestCVIn(int i) {return int16_t(latestCV[i]);}                  ///< -2048 to 2047, smoothed
+	int16_t LatestAudioIn(int i) {return int16_t(latestAudio[i]);}            ///< -2048 to 2047
+	bool LatestPulseIn(int i) {return (latestDigital >> i) & 1;}
+	bool LatestConnected(Input i) {return (latestDigital >> (2 + i)) & 1;}   ///< with EnableNormalisationProbe
+	/// Rising edges at pulse input i since Run, so that loop() misses none between its passes
+	uint32_t PulseInCount(int i) {return pulseCount[i];}
+	///@}
+
+	/// \name For loop(): outputs, held until changed, written by the audio core at its next sample
+	///@{
+	void HoldAudioOut(int i, int16_t val) {Hold(HeldAudio + i, val);}       ///< -2048 to 2047
+	void HoldCVOut(int i, int16_t val) {Hold(HeldCV + i, val);}             ///< -2048 to 2047
+	void HoldCVOutMIDINote(int i, uint8_t note) {Hold(HeldCV + i, noteFlag | note);}
+	void HoldPulseOut(int i, bool val) {Hold(HeldPulse + i, val);}
+	void HoldLed(int i, uint16_t brightness) {Hold(HeldLed + i, brightness);} ///< 0-4095
+	///@}
+
+protected:
+	void __not_in_flash_func(ProcessSample)() override
+	{
+		// Outputs changed from loop() since the last sample
+		uint32_t changed = __atomic_exchange_n(&heldChanged, 0, __ATOMIC_ACQUIRE);
+		while (changed)
+		{
+			int slot = __builtin_ctz(changed);
+			changed &= changed - 1;
+			int32_t v = held[slot];
+			if (slot < HeldCV) AudioOut(slot - HeldAudio, int16_t(v));
+			else if (slot < HeldPulse)
+			{
+				if (v & noteFlag) CVOutMIDINote(slot - HeldCV, uint8_t(v));
+				else CVOut(slot - HeldCV, int16_t(v));
+			}
+			else if (slot < HeldLed) PulseOut(slot - HeldPulse, v != 0);
+			else LedBrightness(uint32_t(slot - HeldLed), uint16_t(v));
+		}
+
+		if (callback) callback(*this);
+
+		// Inputs for loop()
+		for (int i=0; i<3; i++) latestKnobs[i] = KnobVal(Knob(i));
+		latestSwitch = SwitchVal();
+		uint32_t digital = 0;
+		for (int i=0; i<2; i++)
+		{
+			latestCV[i] = CVIn(i);
+			latestAudio[i] = AudioIn(i);
+			digital |= uint32_t(PulseIn(i)) << i;
+			if (PulseInRisingEdge(i)) pulseCount[i] = pulseCount[i] + 1;
+		}
+		for (int i=0; i<6; i++) digital |= uint32_t(Connected(Input(i))) << (2 + i);
+		latestDigital = digital;
+	}
+
+private:
+	// Slots of held[], and of bits of heldChanged
+	enum {HeldAudio = 0, HeldCV = 2, HeldPulse = 4, HeldLed = 6, numHeld = 12};
+	static constexpr int32_t noteFlag = 0x10000; // held CV is a MIDI note, for CVOutMIDINote
+
+	void Hold(int slot, int32_t val)
+	{
+		held[slot] = val;
+		__atomic_fetch_or(&heldChanged, 1u << slot, __ATOMIC_RELEASE);
+	}
+
+	Callback callback = nullptr;
+	SampleRate_t startRate = SR48kHz;
+	volatile bool started = false;
+
+	volatile int32_t held[numHeld] = {};
+	volatile uint32_t heldChanged = 0;
+
+	volatile int32_t latestKnobs[3] = {}, latestCV[2] = {}, latestAudio[2] = {};
+	volatile int32_t latestSwitch = Middle;
+	volatile uint32_t latestDigital = 0; // bits 0-1: pulse inputs; 2-7: jacks connected
+	volatile uint32_t pulseCount[2] = {};
+};
+
+#endif
@@ -0,0 +1,101 @@
+// C interface to ComputerCard, see computercard_c.h
+
+#include "ComputerCard.h"
+#include "computercard_c.h"
+
+static_assert(sizeof(cc_frame) == sizeof(ComputerCard::Frame), "cc_frame must match ComputerCard::Frame");
+
+namespace {
+
+// The card, passing each sample or block to the C callback, and making the
+// protected ComputerCard functions available to the cc_ functions
+class CCard : public ComputerCard
+{
+public:
+	cc_process_fn process = nullptr;
+	void *ctx = nullptr;
+
+	using ComputerCard::KnobVal;
+	using ComputerCard::SwitchVal;
+	using ComputerCard::SwitchChanged;
+	using ComputerCard::CVIn;
+	using ComputerCard::CVInFast;
+	using ComputerCard::PulseIn;
+	using ComputerCard::PulseInRisingEdge;
+	using ComputerCard::PulseInFallingEdge;
+	using ComputerCard::Connected;
+	using ComputerCard::CVOut;
+	using ComputerCard::CVOutPrecise;
+	using ComputerCard::CVOutMIDINote;
+	using ComputerCard::PulseOut;
+	using ComputerCard::LedBrightness;
+	using ComputerCard::Abort;
+
+protected:
+	void __not_in_flash_func(ProcessSample)() override
+	{
+		cc_frame in = {{AudioIn1(), AudioIn2()}}, out = {{0, 0}};
+		process(&in, &out, 1, ctx);
+		AudioOut1(out.audio[0]);
+		AudioOut2(out.audio[1]);
+	}
+
+	void __not_in_flash_func(ProcessBlock)(const Frame *in, Frame *out, int n) override
+	{
+		process(reinterpret_cast<const cc_frame *>(in), reinterpret_cast<cc_frame *>(out), n, ctx);
+	}
+};
+
+// Constructed on first use, so that the hardware is set up by whichever cc_ function comes first.
+// The inputs and outputs, only used once audio is running, go straight to card
+CCard *card;
+
+CCard &Card()
+{
+	static CCard c;
+	card = &c;
+	return c;
+}
+
+}
+
+extern "C" {
+
+void cc_run(cc_process_fn fn, void *ctx, int32_t sampleRate)
+{
+	CCard &c = Card();
+	c.process = fn;
+	c.ctx = ctx;
+	c.Run(ComputerCard::SampleRate_t(sampleRate));
+}
+
+void cc_abort(void) {Card().Abort();}
+int32_t cc_sample_rate(void) {return Card().SampleRate();}
+int cc_block_size(void) {return ComputerCard::blockSize;}
+
+void cc_enable_normalisation_probe(void) {Card().EnableNormalisationProbe();}
+void cc_enable_mux_correction(int shift) {Card().EnableMuxCorrection(shift);}
+void cc_enable_fast_cv(bool cv1, bool cv2) {Card().EnableFastCV(cv1, cv2);}
+void cc_enable_load_meter(void) {Card().EnableLoadMeter();}
+void cc_set_audio_oversampling(int conversions) {Card().SetAudioOversampling(conversions);}
+
+int32_t __not_in_flash_func(cc_knob)(int knob) {return card->KnobVal(ComputerCard::Knob(knob));}
+int __not_in_flash_func(cc_switch)(void) {return card->SwitchVal();}
+bool __not_in_flash_func(cc_switch_changed)(void) {return card->SwitchChanged();}
+int16_t __not_in_flash_func(cc_cv_in)(int i) {return card->CVIn(i);}
+int16_t __not_in_flash_func(cc_cv_in_fast)(int i) {return card->CVInFast(i);}
+bool __not_in_flash_func(cc_pulse_in)(int i) {return card->PulseIn(i);}
+bool __not_in_flash_func(cc_pulse_in_rising_edge)(int i) {return card->PulseInRisingEdge(i);}
+bool __not_in_flash_func(cc_pulse_in_falling_edge)(int i) {return card->PulseInFallingEdge(i);}
+bool __not_in_flash_func(cc_connected)(int input) {return card->Connected(ComputerCard::Input(input));}
+
+void __not_in_flash_func(cc_cv_out)(int i, int16_t val) {card->CVOut(i, val);}
+void __not_in_flash_func(cc_cv_out_precise)(int i, int32_t val) {card->CVOutPrecise(i, val);}
+void __not_in_flash_func(cc_cv_out_midi_note)(int i, uint8_t note) {card->CVOutMIDINote(i, note);}
+void __not_in_flash_func(cc_pulse_out)(int i, bool val) {card->PulseOut(i, val);}
+void __not_in_flash_func(cc_led_brightness)(int i, uint16_t val) {card->LedBrightness(uint32_t(i), val);}
+
+int32_t cc_load_percent(void) {return Card().LoadPercent();}
+uint32_t cc_overrun_count(void) {return Card().OverrunCount();}
+
+}
@@ -0,0 +1,105 @@
+/*
+C interface to ComputerCard
+
+For cards written in C, so that they share ComputerCard's audio and I/O engine (DMA, mux
+scanning, block mode, calibration, normalisation probe, load meter) rather than keeping their
+own copy of it. Build computercard_c.cpp (C++17) into the card along with its C sources, and
+include this header.
+
+A C card sets up any options, then calls cc_run with a callback, which is called once per
+sample (or per block of COMPUTERCARD_BLOCK_SIZE frames, if that is defined for computercard_c.cpp)
+with the audio inputs, and writes the audio outputs. The other inputs and outputs are read and
+written from the callback by the cc_ functions below, which are those of ComputerCard:
+
+	static void process(const cc_frame *in, cc_frame *out, int n, void *ctx)
+	{
+		int32_t gain = cc_knob(CC_KNOB_MAIN);
+		for (int i=0; i<n; i++)
+		{
+			out[i].audio[0] = (in[i].audio[0] * gain) >> 12;
+			out[i].audio[1] = (in[i].audio[1] * gain) >> 12;
+		}
+	}
+
+	int main()
+	{
+		cc_enable_normalisation_probe();
+		cc_run(process, NULL, CC_SR48KHZ);
+	}
+*/
+
+#ifndef COMPUTERCARD_C_H
+#define COMPUTERCARD_C_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// One frame of audio, as ComputerCard::Frame: audio[0] is Audio 1, audio[1] is Audio 2
+typedef struct
+{
+	int16_t audio[2];
+} cc_frame;
+
+/// Audio callback: n frames of input in, n frames of output to be written to out
+typedef void (*cc_process_fn)(const cc_frame *in, cc_frame *out, int n, void *ctx);
+
+enum {CC_KNOB_MAIN, CC_KNOB_X, CC_KNOB_Y};
+enum {CC_SWITCH_DOWN, CC_SWITCH_MIDDLE, CC_SWITCH_UP};
+enum {CC_AUDIO1, CC_AUDIO2, CC_CV1, CC_CV2, CC_PULSE1, CC_PULSE2};
+enum {CC_SR24KHZ = 24000, CC_SR48KHZ = 48000, CC_SR96KHZ = 96000};
+
+/// Start audio, calling fn(in, out, n, ctx) for each sample or block. Never returns, unless cc_abort is called
+void cc_run(cc_process_fn fn, void *ctx, int32_t sampleRate);
+/// Stop audio, making cc_run return
+void cc_abort(void);
+/// Sample rate in Hz, as given to cc_run
+int32_t cc_sample_rate(void);
+/// Frames per callback: COMPUTERCARD_BLOCK_SIZE, or 1
+int cc_block_size(void);
+
+/// \name Options, to be set before cc_run, as ComputerCard's Enable and Set functions
+///@{
+void cc_enable_normalisation_probe(void);
+void cc_enable_mux_correction(int shift);
+void cc_enable_fast_cv(bool cv1, bool cv2);
+void cc_enable_load_meter(void);
+void cc_set_audio_oversampling(int conversions);
+///@}
+
+/// \name Inputs, from within the callback
+///@{
+int32_t cc_knob(int knob);                  ///< 0-4095
+int cc_switch(void);                        ///< CC_SWITCH_DOWN, CC_SWITCH_MIDDLE or CC_SWITCH_UP
+bool cc_switch_changed(void);
+int16_t cc_cv_in(int i);                    ///< -2048 to 2047, smoothed
+int16_t cc_cv_in_fast(int i);               ///< -2048 to 2047, unsmoothed
+bool cc_pulse_in(int i);
+bool cc_pulse_in_rising_edge(int i);
+bool cc_pulse_in_falling_edge(int i);
+bool cc_connected(int input);               ///< with cc_enable_normalisation_probe
+///@}
+
+/// \name Outputs, from within the callback
+///@{
+void cc_cv_out(int i, int16_t val);         ///< -2048 to 2047
+void cc_cv_out_precise(int i, int32_t val); ///< -262144 to 262143
+void cc_cv_out_midi_note(int i, uint8_t note);
+void cc_pulse_out(int i, bool val);
+void cc_led_brightness(int i, uint16_t val); ///< 0-4095
+///@}
+
+/// \name Instrumentation, with cc_enable_load_meter
+///@{
+int32_t cc_load_percent(void);
+uint32_t cc_overrun_count(void);
+///@}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
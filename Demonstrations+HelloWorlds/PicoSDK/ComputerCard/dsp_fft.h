@@ -0,0 +1,364 @@
+/*
+	Fixed-point FFT and overlap-add spectral processing, header only
+
+	RealFFT<N> transforms N real samples (int16_t) to N/2 + 1 frequency bins and
+	back, in place, for N a power of two from 64 to 4096. The real transform is an
+	N/2-point complex FFT of the even and odd samples as real and imaginary parts,
+	unpicked into the spectrum in one extra pass, so it costs about half as much as a
+	complex FFT of the same length. The complex FFT is decimation in frequency, two
+	radix-2 stages at a time (radix-4 butterflies, three complex multiplies each, none
+	for the first butterfly of each group), with a final twiddle-free radix-2 stage when
+	N/2 is not a power of four.
+
+	Scaling is block floating point: before each stage, values are shifted down only as
+	far as that stage could otherwise overflow, and the shifts are added up into an
+	exponent returned with the spectrum. Quiet input keeps its precision, and loud
+	input cannot wrap. Products are 16 x 16 bits into 32, so none needs a 64-bit
+	multiply on the RP2040. The twiddle factors and bit-reversal table are members,
+	so in SRAM wherever the object is.
+
+	OverlapAdd<N, Hop> runs RealFFT over frames of N samples every Hop samples, with
+	square root Hann windows on analysis and synthesis. Process, called for each audio
+	sample, only copies the input in and the output out. Frames are analysed, changed and
+	resynthesised elsewhere, usually on core 1, with NextFrame and Synthesise, which must
+	keep up with one frame per Hop samples. Latency is N + Hop samples.
+
+	Packed spectrum: bins 1 to N/2 - 1 are (re, im) pairs at [2k] and [2k + 1]; bin 0 (DC)
+	and bin N/2 (Nyquist), both real, are at [0] and [1]. Bin k's value is the packed value
+	times 2^exponent, as an unnormalised DFT of the input.
+*/
+
+#ifndef DSP_FFT_H
+#define DSP_FFT_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "dsp_intrinsics.h"
+
+namespace fxp
+{
+	/// Approximate magnitude of (re, im), max + 3/8 min, within 7%
+	inline int32_t MagnitudeApprox(int32_t re, int32_t im)
+	{
+		if (re < 0) re = -re;
+		if (im < 0) im = -im;
+		return re > im ? re + ((3 * im) >> 3) : im + ((3 * re) >> 3);
+	}
+
+	template <int N>
+	class RealFFT
+	{
+		static_assert((N & (N - 1)) == 0 && N >= 64 && N <= 4096, "N must be a power of two, 64 to 4096");
+		static constexpr int M = N / 2; // points of the complex FFT
+
+	public:
+		static constexpr int log2N = N >= 4096 ? 12 : (N >= 2048 ? 11 : (N >= 1024 ? 10 : (N >= 512 ? 9 : (N >= 256 ? 8 : (N >= 128 ? 7 : 6)))));
+
+		RealFFT()
+		{
+			// e^(-2 pi i k / N), Q15
+			for (int k=0; k<N; k++)
+			{
+				double a = 2.0 * M_PI * k / N;
+				twiddle[2 * k] = int16_t(std::lround(32767.0 * std::cos(a)));
+				twiddle[2 * k + 1] = int16_t(std::lround(-32767.0 * std::sin(a)));
+			}
+			for (int i=0; i<M; i++)
+			{
+				int r = 0;
+				for (int b=1; b<M; b<<=1) r = (r << 1) | ((i & b) ? 1 : 0);
+				bitReverse[i] = uint16_t(r);
+			}
+		}
+
+		/// Transform N samples to a packed spectrum, in place, returning its exponent
+		int Forward(int16_t *x)
+		{
+			int exponent = Complex(x, false);
+
+			// X[k] = E - iT and X[M-k] = conj(E + iT), from Z[k] and Z[M-k], with
+			// E = (Z[k] + conj Z[M-k]) / 2 and T = W^k (Z[k] - conj Z[M-k]) / 2
+			int sh = SplitShift(Bound(x, N));
+			exponent += sh;
+			int32_t re0 = Shr(x[0], sh), im0 = Shr(x[1], sh);
+			x[0] = int16_t(re0 + im0);
+			x[1] = int16_t(re0 - im0);
+			x[M] = int16_t(Shr(x[M], sh));
+			x[M + 1] = int16_t(-Shr(x[M + 1], sh));
+			for (int k=1; k<M/2; k++)
+			{
+				int16_t *a = x + 2 * k, *c = x + 2 * (M - k);
+				int32_t are = Shr(a[0], sh), aim = Shr(a[1], sh), cre = Shr(c[0], sh), cim = Shr(c[1], sh);
+				int32_t ere = are + cre, eim = aim - cim;
+				int32_t ore = are - cre, oim = aim + cim;
+				int32_t wre = twiddle[2 * k], wim = twiddle[2 * k + 1];
+				int32_t tre = (ore * wre - oim * wim + 0x4000) >> 15;
+				int32_t tim = (ore * wim + oim * wre + 0x4000) >> 15;
+				a[0] = int16_t(Half(ere + tim));
+				a[1] = int16_t(Half(eim - tre));
+				c[0] = int16_t(Half(ere - tim));
+				c[1] = int16_t(Half(-(eim + tre)));
+			}
+			return exponent;
+		}
+
+		/// Transform a packed spectrum with the given exponent back to N samples, in place, saturating
+		void Inverse(int16_t *x, int exponent)
+		{
+			// Z[k] = E + conj(W^k) T and Z[M-k] = conj(E - conj(W^k) T), the reverse of Forward
+			int sh = SplitShift(Bound(x, N));
+			exponent += sh;
+			int32_t dc = Shr(x[0], sh), nyquist = Shr(x[1], sh);
+			x[0] = int16_t(Half(dc + nyquist));
+			x[1] = int16_t(Half(dc - nyquist));
+			x[M] = int16_t(Shr(x[M], sh));
+			x[M + 1] = int16_t(-Shr(x[M + 1], sh));
+			for (int k=1; k<M/2; k++)
+			{
+				int16_t *a = x + 2 * k, *c = x + 2 * (M - k);
+				int32_t are = Shr(a[0], sh), aim = Shr(a[1], sh), cre = Shr(c[0], sh), cim = Shr(c[1], sh);
+				int32_t ere = are + cre, eim = aim - cim;
+				// T = -i (conj X[M-k] - X[k])
+				int32_t tre = -cim - aim, tim = are - cre;
+				int32_t wre = twiddle[2 * k], wim = -twiddle[2 * k + 1];
+				int32_t ore = (tre * wre - tim * wim + 0x4000) >> 15;
+				int32_t oim = (tre * wim + tim * wre + 0x4000) >> 15;
+				a[0] = int16_t(Half(ere + ore));
+				a[1] = int16_t(Half(eim + oim));
+				c[0] = int16_t(Half(ere - ore));
+				c[1] = int16_t(Half(oim - eim));
+			}
+
+			// The complex FFT sums M points, so divide by M, as well as applying the exponent
+			int shift = exponent + Complex(x, true) - (log2N - 1);
+			if (shift > 16) shift = 16;
+			if (shift >= 0)
+			{
+				for (int i=0; i<N; i++) x[i] = int16_t(DSP_SSAT(int32_t(x[i]) << shift, 16));
+			}
+			else if (shift > -16)
+			{
+				for (int i=0; i<N; i++) x[i] = int16_t(Shr(x[i], -shift));
+			}
+			else
+			{
+				std::memset(x, 0, sizeof(int16_t) * N);
+			}
+		}
+
+		/// cos and sin of 2 pi k / N, Q15, e.g. for setting a bin's phase
+		int16_t Cos(int k) const {return twiddle[2 * (k & (N - 1))];}
+		int16_t Sin(int k) const {return int16_t(-twiddle[2 * (k & (N - 1)) + 1]);}
+
+	private:
+		// An upper bound (within 1) on the largest absolute value of n values
+		static uint32_t Bound(const int16_t *x, int n)
+		{
+			uint32_t b = 0;
+			for (int i=0; i<n; i++) b |= uint32_t(x[i] ^ (x[i] >> 15)) & 0xFFFF;
+			return b;
+		}
+
+		// x >> sh, rounded to nearest with ties away from zero, so that rounding errors in a
+		// spectrum average out rather than adding up to an error in the first sample
+		static inline int32_t Shr(int32_t x, int sh)
+		{
+			return (x + ((1 << sh) >> 1) + ((x >> 31) & -int32_t(sh > 0))) >> sh;
+		}
+
+		// x / 2, rounded as by Shr
+		static inline int32_t Half(int32_t x) {return (x + 1 + (x >> 31)) >> 1;}
+
+		// The unpicking passes grow values by up to 2.42 times
+		static int SplitShift(uint32_t b) {return b < 11584 ? 0 : (b < 23169 ? 1 : 2);}
+
+		// Radix-4 butterfly of x0 to x3 at p, p + step, p + 2 step and p + 3 step (in int16_t, interleaved)
+		template <bool Inverse, bool Twiddled>
+		static inline void Butterfly(int16_t *p, int step, int sh, const int16_t *w1, const int16_t *w2, const int16_t *w3, uint32_t &bound)
+		{
+			int16_t *p1 = p + step, *p2 = p1 + step, *p3 = p2 + step;
+			int32_t x0r = Shr(p[0], sh), x0i = Shr(p[1], sh), x1r = Shr(p1[0], sh), x1i = Shr(p1[1], sh);
+			int32_t x2r = Shr(p2[0], sh), x2i = Shr(p2[1], sh), x3r = Shr(p3[0], sh), x3i = Shr(p3[1], sh);
+			int32_t s02r = x0r + x2r, s02i = x0i + x2i, d02r = x0r - x2r, d02i = x0i - x2i;
+			int32_t s13r = x1r + x3r, s13i = x1i + x3i, d13r = x1r - x3r, d13i = x1i - x3i;
+
+			int32_t y0r = s02r + s13r, y0i = s02i + s13i;
+			int32_t y1r = s02r - s13r, y1i = s02i - s13i;
+			// (x0 - x2) -/+ i (x1 - x3), for the forward and inverse transforms
+			int32_t y2r = Inverse ? d02r - d13i : d02r + d13i, y2i = Inverse ? d02i + d13r : d02i - d13r;
+			int32_t y3r = Inverse ? d02r + d13i : d02r - d13i, y3i = Inverse ? d02i - d13r : d02i + d13r;
+
+			if (Twiddled)
+			{
+				int32_t t;
+				int32_t c = w2[0], s = Inverse ? -w2[1] : w2[1];
+				t = (y1r * c - y1i * s + 0x4000) >> 15;
+				y1i = (y1r * s + y1i * c + 0x4000) >> 15;
+				y1r = t;
+				c = w1[0]; s = Inverse ? -w1[1] : w1[1];
+				t = (y2r * c - y2i * s + 0x4000) >> 15;
+				y2i = (y2r * s + y2i * c + 0x4000) >> 15;
+				y2r = t;
+				c = w3[0]; s = Inverse ? -w3[1] : w3[1];
+				t = (y3r * c - y3i * s + 0x4000) >> 15;
+				y3i = (y3r * s + y3i * c + 0x4000) >> 15;
+				y3r = t;
+			}
+
+			p[0] = int16_t(y0r); p[1] = int16_t(y0i);
+			p1[0] = int16_t(y1r); p1[1] = int16_t(y1i);
+			p2[0] = int16_t(y2r); p2[1] = int16_t(y2i);
+			p3[0] = int16_t(y3r); p3[1] = int16_t(y3i);
+			bound |= uint32_t((y0r ^ (y0r >> 31)) | (y0i ^ (y0i >> 31)) | (y1r ^ (y1r >> 31)) | (y1i ^ (y1i >> 31))
+				| (y2r ^ (y2r >> 31)) | (y2i ^ (y2i >> 31)) | (y3r ^ (y3r >> 31)) | (y3i ^ (y3i >> 31)));
+		}
+
+		// M-point complex FFT of z (interleaved), unnormalised, in place, in natural order. Returns the exponent
+		int Complex(int16_t *z, bool inverse)
+		{
+			int exponent = 0;
+			uint32_t bound = Bound(z, N);
+			int span = M;
+			for (; span >= 4; span >>= 2)
+			{
+				// A butterfly grows values by up to 4 sqrt(2) times
+				int sh = bound < 5791 ? 0 : (bound < 11583 ? 1 : (bound < 23167 ? 2 : 3));
+				exponent += sh;
+				bound = 0;
+				int q = span >> 2, stride = N / span;
+				for (int g=0; g<M; g+=span)
+				{
+					if (inverse) Butterfly<true, false>(z + 2 * g, 2 * q, sh, nullptr, nullptr, nullptr, bound);
+					else Butterfly<false, false>(z + 2 * g, 2 * q, sh, nullptr, nullptr, nullptr, bound);
+				}
+				for (int j=1; j<q; j++)
+				{
+					const int16_t *w1 = twiddle + 2 * j * stride, *w2 = twiddle + 4 * j * stride, *w3 = twiddle + 6 * j * stride;
+					for (int g=j; g<M; g+=span)
+					{
+						if (inverse) Butterfly<true, true>(z + 2 * g, 2 * q, sh, w1, w2, w3, bound);
+						else Butterfly<false, true>(z + 2 * g, 2 * q, sh, w1, w2, w3, bound);
+					}
+				}
+			}
+			if (span == 2)
+			{
+				int sh = bound < 16383 ? 0 : 1;
+				exponent += sh;
+				for (int i=0; i<2*M; i+=4)
+				{
+					int32_t ar = Shr(z[i], sh), ai = Shr(z[i + 1], sh), br = Shr(z[i + 2], sh), bi = Shr(z[i + 3], sh);
+					z[i] = int16_t(ar + br);
+					z[i + 1] = int16_t(ai + bi);
+					z[i + 2] = int16_t(ar - br);
+					z[i + 3] = int16_t(ai - bi);
+				}
+			}
+
+			uint32_t *pairs = reinterpret_cast<uint32_t *>(z);
+			for (int i=0; i<M; i++)
+			{
+				int r = bitReverse[i];
+				if (r > i)
+				{
+					uint32_t t = pairs[i];
+					pairs[i] = pairs[r];
+					pairs[r] = t;
+				}
+			}
+			return exponent;
+		}
+
+		alignas(4) int16_t twiddle[2 * N];
+		uint16_t bitReverse[M];
+	};
+
+	template <int N, int Hop = N / 4>
+	class OverlapAdd
+	{
+		static_assert(Hop > 0 && Hop <= N / 2 && N % Hop == 0, "Hop must divide N, and be at most N / 2");
+		static constexpr int ringSize = 2 * N;
+
+	public:
+		static constexpr int latency = N + Hop;
+
+		OverlapAdd()
+		{
+			// Square root of a periodic Hann window. Analysis and synthesis windows multiply to a
+			// Hann window, whose overlapped copies sum to N / (2 Hop), so synthesis divides by that
+			for (int i=0; i<N; i++)
+			{
+				double w = std::sin(M_PI * i / N);
+				window[i] = int16_t(std::lround(32767.0 * w));
+				synthesisWindow[i] = int16_t(std::lround(32767.0 * w * 2.0 * Hop / N));
+			}
+		}
+
+		/// Add one input sample, returning one output sample, latency samples behind
+		int16_t Process(int16_t in)
+		{
+			uint32_t pos = inPos;
+			input[pos & (ringSize - 1)] = in;
+			int32_t &o = output[(pos - latency) & (ringSize - 1)];
+			int32_t out = o;
+			o = 0;
+			inPos = pos + 1;
+			return int16_t(DSP_SSAT(out, 16));
+		}
+
+		/** \brief The next frame's spectrum, if its input is complete, otherwise nullptr
+
+			Sets exponent to that of the spectrum (see RealFFT). Change the spectrum and its
+			exponent in place, then call Synthesise. A frame that would be too late to make
+			its output is skipped, and counted by Overruns.
+		*/
+		int16_t *NextFrame(int &exponent)
+		{
+			uint32_t pos = inPos;
+			if (int32_t(pos - frameStart) < N) return nullptr;
+			if (pos - frameStart >= uint32_t(N + Hop))
+			{
+				// Skip to the latest complete frame; the outputs missed are silent
+				uint32_t frames = (pos - frameStart - N) / Hop;
+				frameStart += frames * Hop;
+				overruns = overruns + frames;
+			}
+			for (int i=0; i<N; i++)
+			{
+				frame[i] = int16_t((input[(frameStart + uint32_t(i)) & (ringSize - 1)] * window[i] + 0x4000) >> 15);
+			}
+			exponent = fft.Forward(frame);
+			return frame;
+		}
+
+		/// Resynthesise the frame from NextFrame, with its (possibly changed) spectrum and exponent
+		void Synthesise(int exponent)
+		{
+			fft.Inverse(frame, exponent);
+			for (int i=0; i<N; i++)
+			{
+				output[(frameStart + uint32_t(i)) & (ringSize - 1)] += (frame[i] * synthesisWindow[i] + 0x4000) >> 15;
+			}
+			frameStart += Hop;
+		}
+
+		/// Frames skipped because NextFrame was called too late
+		uint32_t Overruns() const {return overruns;}
+
+		/// The transform, e.g. for its Cos and Sin tables
+		const RealFFT<N> &Transform() const {return fft;}
+
+	private:
+		RealFFT<N> fft;
+		int16_t window[N], synthesisWindow[N];
+		int16_t input[ringSize] = {};
+		int32_t output[ringSize] = {};
+		alignas(4) int16_t frame[N];
+		volatile uint32_t inPos = 0;
+		uint32_t frameStart = 0;  // input position of the frame being processed
+		volatile uint32_t overruns = 0;
+	};
+}
+
+#endif
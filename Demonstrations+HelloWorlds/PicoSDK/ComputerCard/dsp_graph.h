@@ -0,0 +1,277 @@
+/*
+	Signal chains built from dsp_primitives.h at compile time, header only
+
+	Cards had been wiring the same blocks (oscillator, filter, delay, reverb) together by hand
+	in ProcessSample. Here a chain is a type instead:
+
+		using Voice = fxp::graph::Chain<
+			fxp::graph::Sum<fxp::graph::Saw, fxp::graph::White>,
+			fxp::graph::SVF<>,
+			fxp::graph::DryWet<fxp::graph::Allpass<556>>>;
+
+	As the whole topology is known to the compiler, every node's Process is inlined into one
+	function per sample, and ProcessBlock is a single loop over the block, with no virtual
+	calls, no per-node loops and no intermediate buffers. Each node's state is a member of
+	the graph, and node I of a Chain or Sum is reached with Node<I>() to set its parameters.
+
+	Each node also gives its name, its state in bytes and a rough cost in Cortex-M0+ cycles
+	per sample, summed by Chain, Sum and DryWet, so the cost of a graph is known at compile time
+	(static_assert(Voice::cycles < 400)) and Inspect lists it node by node. The cycle counts
+	are estimates for comparing graphs; examples/dsp_benchmark measures the primitives.
+
+	Conventions are those of dsp_primitives.h: audio is Q15 in an int32_t, gains are Q15, and
+	one-pole coefficients are Q16.
+*/
+
+#ifndef DSP_GRAPH_H
+#define DSP_GRAPH_H
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "dsp_primitives.h"
+
+namespace fxp
+{
+namespace graph
+{
+	namespace detail
+	{
+		template <class... Nodes>
+		constexpr uint32_t SumCycles() {return (uint32_t(0) + ... + Nodes::cycles);}
+
+		// Chain, Sum and DryWet, which hold other nodes, say so with isComposite
+		template <class N, class = void> struct IsComposite : std::false_type {};
+		template <class N> struct IsComposite<N, std::void_t<decltype(N::isComposite)>> : std::true_type {};
+	}
+
+	/// Calls row(name, depth, cycles, bytes) for node and, for composite nodes, for each node within it
+	template <class N, class F>
+	void InspectNode(const N &node, F &&row, int depth = 0)
+	{
+		if constexpr (detail::IsComposite<N>::value) node.Inspect(row, depth);
+		else row(N::name, depth, N::cycles, sizeof(N));
+	}
+
+	/// Q15 gain, gain (32768 = 1.0)
+	struct Gain
+	{
+		static constexpr const char *name = "Gain";
+		static constexpr uint32_t cycles = 10;
+		int32_t gain = 32767;
+
+		int32_t Process(int32_t x) {return MulQ15Wide(x, gain);}
+	};
+
+	/// Saturate to the int16_t range
+	struct Saturate
+	{
+		static constexpr const char *name = "Saturate";
+		static constexpr uint32_t cycles = 6;
+
+		int32_t Process(int32_t x) {return Sat16(x);}
+	};
+
+	/// OnePoleLP, with Q16 coefficient b
+	struct LowPass
+	{
+		static constexpr const char *name = "LowPass";
+		static constexpr uint32_t cycles = 16;
+		OnePoleLP lp;
+		uint32_t b = 65535;
+
+		int32_t Process(int32_t x) {return lp.Process(x, b);}
+	};
+
+	/// OnePoleHP, with Q16 coefficient b
+	struct HighPass
+	{
+		static constexpr const char *name = "HighPass";
+		static constexpr uint32_t cycles = 18;
+		OnePoleHP hp;
+		uint32_t b = 200;
+
+		int32_t Process(int32_t x) {return hp.Process(x, b);}
+	};
+
+	/// SVFLowPass, run at the 12-bit audio range it needs for headroom; set coefficients with filter.SetCoeffs
+	template <unsigned Shift = 16>
+	struct SVF
+	{
+		static constexpr const char *name = "SVF";
+		static constexpr uint32_t cycles = 40;
+		SVFLowPass<Shift> filter;
+
+		int32_t Process(int32_t x) {return filter.Process(x >> 4) << 4;}
+	};
+
+	/// Comb of N samples, with its own delay memory
+	template <int N>
+	struct Comb
+	{
+		static constexpr const char *name = "Comb";
+		static constexpr uint32_t cycles = 34;
+		fxp::Comb<N> comb;
+		int16_t mem[N];
+
+		Comb() {comb.Attach(mem);}
+		Comb(const Comb &) = delete;
+
+		int32_t Process(int32_t x) {return comb.Process(x);}
+	};
+
+	/// Allpass of N samples, with its own delay memory
+	template <int N>
+	struct Allpass
+	{
+		static constexpr const char *name = "Allpass";
+		static constexpr uint32_t cycles = 26;
+		fxp::Allpass<N> allpass;
+		int16_t mem[N];
+
+		Allpass() {allpass.Attach(mem);}
+		Allpass(const Allpass &) = delete;
+
+		int32_t Process(int32_t x) {return allpass.Process(x);}
+	};
+
+	/// Sawtooth source, ignoring its input; increment is 2^32 * frequency / sample rate
+	struct Saw
+	{
+		static constexpr const char *name = "Saw";
+		static constexpr uint32_t cycles = 6;
+		uint32_t phase = 0, increment = 0;
+
+		int32_t Process(int32_t)
+		{
+			phase += increment;
+			return int32_t(phase) >> 16;
+		}
+	};
+
+	/// WhiteNoise source, ignoring its input
+	struct White
+	{
+		static constexpr const char *name = "White";
+		static constexpr uint32_t cycles = 12;
+		WhiteNoise noise;
+
+		int32_t Process(int32_t) {return noise.Process();}
+	};
+
+	/// PinkNoise source, ignoring its input
+	template <int Rows = 12>
+	struct Pink
+	{
+		static constexpr const char *name = "Pink";
+		static constexpr uint32_t cycles = 30;
+		PinkNoise<Rows> noise;
+
+		int32_t Process(int32_t) {return noise.Process();}
+	};
+
+	/// Mix of the input (dry) and Node's output (wet), by mix (Q15, 0 dry to 32767 wet)
+	template <class Node>
+	struct DryWet
+	{
+		static constexpr const char *name = "DryWet";
+		static constexpr bool isComposite = true;
+		static constexpr uint32_t cycles = Node::cycles + 14;
+		Node node;
+		int32_t mix = 16384;
+
+		int32_t Process(int32_t x)
+		{
+			int32_t wet = node.Process(x);
+			return x + MulQ15Wide(wet - x, mix);
+		}
+
+		template <class F>
+		void Inspect(F &&row, int depth = 0) const
+		{
+			row(name, depth, cycles, sizeof(*this));
+			InspectNode(node, row, depth + 1);
+		}
+	};
+
+	/// Nodes in series: the output of each is the input of the next
+	template <class... Nodes>
+	class Chain
+	{
+	public:
+		static constexpr const char *name = "Chain";
+		static constexpr bool isComposite = true;
+		static constexpr uint32_t cycles = detail::SumCycles<Nodes...>();
+
+		/// Node I, e.g. to set its parameters
+		template <int I>
+		auto &Node() {return std::get<I>(nodes);}
+
+		int32_t Process(int32_t x) {return Run(x, std::index_sequence_for<Nodes...>());}
+
+		/// n samples in place, in one loop
+		void ProcessBlock(int32_t *x, int n)
+		{
+			for (int i=0; i<n; i++) x[i] = Process(x[i]);
+		}
+
+		template <class F>
+		void Inspect(F &&row, int depth = 0) const
+		{
+			row(name, depth, cycles, sizeof(*this));
+			std::apply([&](const auto &... node) {(InspectNode(node, row, depth + 1), ...);}, nodes);
+		}
+
+	private:
+		std::tuple<Nodes...> nodes;
+
+		template <size_t... I>
+		int32_t Run(int32_t x, std::index_sequence<I...>)
+		{
+			((x = std::get<I>(nodes).Process(x)), ...);
+			return x;
+		}
+	};
+
+	/// Nodes in parallel: each is given the same input, and their outputs are added
+	template <class... Nodes>
+	class Sum
+	{
+	public:
+		static constexpr const char *name = "Sum";
+		static constexpr bool isComposite = true;
+		static constexpr uint32_t cycles = detail::SumCycles<Nodes...>() + 2 * sizeof...(Nodes);
+
+		/// Node I, e.g. to set its parameters
+		template <int I>
+		auto &Node() {return std::get<I>(nodes);}
+
+		int32_t Process(int32_t x) {return Run(x, std::index_sequence_for<Nodes...>());}
+
+		/// n samples in place, in one loop
+		void ProcessBlock(int32_t *x, int n)
+		{
+			for (int i=0; i<n; i++) x[i] = Process(x[i]);
+		}
+
+		template <class F>
+		void Inspect(F &&row, int depth = 0) const
+		{
+			row(name, depth, cycles, sizeof(*this));
+			std::apply([&](const auto &... node) {(InspectNode(node, row, depth + 1), ...);}, nodes);
+		}
+
+	private:
+		std::tuple<Nodes...> nodes;
+
+		template <size_t... I>
+		int32_t Run(int32_t x, std::index_sequence<I...>)
+		{
+			return (int32_t(0) + ... + std::get<I>(nodes).Process(x));
+		}
+	};
+}
+}
+
+#endif
@@ -0,0 +1,148 @@
+/*
+	Fixed-point DSP helpers for cards, in C or C++
+
+	On cores with the Arm DSP extension (the RP2350's Cortex-M33s), each of these is a
+	single SSAT, QADD, QADD16, SMLAD, SMMULR etc. instruction. On the RP2040's
+	Cortex-M0+ (and the RP2350's RISC-V cores, and the host build) the same functions
+	are plain C giving identical results, so cards can use them unconditionally and
+	still build for either chip.
+
+	DSP_HAS_SIMD is 1 where the packed 16-bit instructions exist, and DSP_HAS_FPU is 1
+	where single-precision float arithmetic is done in hardware, for cards that keep
+	both a float and an integer version of an algorithm.
+
+	Defining COMPUTERCARD_REFERENCE selects the plain C versions everywhere, as the reference
+	that faster versions are checked against (see host/regression.cmake).
+
+	Packed arguments (dsp_pack16) hold two signed 16-bit values, the first in the low half.
+*/
+
+#ifndef DSP_INTRINSICS_H
+#define DSP_INTRINSICS_H
+
+#include <stdint.h>
+
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP && !defined(COMPUTERCARD_REFERENCE)
+#include <arm_acle.h>
+#define DSP_HAS_SIMD 1
+#else
+#define DSP_HAS_SIMD 0
+#endif
+
+#if defined(__ARM_FP) && (__ARM_FP & 4)
+#define DSP_HAS_FPU 1
+#else
+#define DSP_HAS_FPU 0
+#endif
+
+static inline int32_t dsp_ssat_c(int32_t x, int bits)
+{
+	int32_t hi = (int32_t)((1u << (bits - 1)) - 1);
+	if (x > hi) return hi;
+	if (x < -hi - 1) return -hi - 1;
+	return x;
+}
+
+/// Saturate x to a signed bits-bit range (bits 1 to 31, a constant), e.g. DSP_SSAT(x, 16) for Q15
+#if defined(__ARM_FEATURE_SAT) && __ARM_FEATURE_SAT && !defined(COMPUTERCARD_REFERENCE)
+#define DSP_SSAT(x, bits) __ssat((x), (bits))
+#else
+#define DSP_SSAT(x, bits) dsp_ssat_c((x), (bits))
+#endif
+
+/// a + b, saturated to the int32_t range
+static inline int32_t dsp_qadd(int32_t a, int32_t b)
+{
+#if DSP_HAS_SIMD
+	return __qadd(a, b);
+#else
+	int64_t s = (int64_t)a + b;
+	if (s > INT32_MAX) return INT32_MAX;
+	if (s < INT32_MIN) return INT32_MIN;
+	return (int32_t)s;
+#endif
+}
+
+/// a - b, saturated to the int32_t range
+static inline int32_t dsp_qsub(int32_t a, int32_t b)
+{
+#if DSP_HAS_SIMD
+	return __qsub(a, b);
+#else
+	int64_t s = (int64_t)a - b;
+	if (s > INT32_MAX) return INT32_MAX;
+	if (s < INT32_MIN) return INT32_MIN;
+	return (int32_t)s;
+#endif
+}
+
+/// Two 16-bit values packed into one word, lo in the low half
+static inline int32_t dsp_pack16(int16_t lo, int16_t hi)
+{
+	return (int32_t)(((uint32_t)(uint16_t)hi << 16) | (uint16_t)lo);
+}
+
+/// Low and high 16-bit values of a packed word
+static inline int16_t dsp_lo16(int32_t x) {return (int16_t)(x & 0xFFFF);}
+static inline int16_t dsp_hi16(int32_t x) {return (int16_t)((uint32_t)x >> 16);}
+
+/// Both halves of a plus both halves of b, each saturated to the int16_t range
+static inline int32_t dsp_qadd16(int32_t a, int32_t b)
+{
+#if DSP_HAS_SIMD
+	return __qadd16(a, b);
+#else
+	return dsp_pack16((int16_t)dsp_ssat_c(dsp_lo16(a) + dsp_lo16(b), 16), (int16_t)dsp_ssat_c(dsp_hi16(a) + dsp_hi16(b), 16));
+#endif
+}
+
+/// Both halves of a minus both halves of b, each saturated to the int16_t range
+static inline int32_t dsp_qsub16(int32_t a, int32_t b)
+{
+#if DSP_HAS_SIMD
+	return __qsub16(a, b);
+#else
+	return dsp_pack16((int16_t)dsp_ssat_c(dsp_lo16(a) - dsp_lo16(b), 16), (int16_t)dsp_ssat_c(dsp_hi16(a) - dsp_hi16(b), 16));
+#endif
+}
+
+/// acc + lo(x)*lo(y) + hi(x)*hi(y): two 16x16 multiply-accumulates, e.g. a stereo gain or two FIR taps
+static inline int32_t dsp_smlad(int32_t x, int32_t y, int32_t acc)
+{
+#if DSP_HAS_SIMD
+	return __smlad(x, y, acc);
+#else
+	// Wraps on overflow, as the instruction does
+	return (int32_t)((uint32_t)acc + (uint32_t)((int32_t)dsp_lo16(x) * dsp_lo16(y)) + (uint32_t)((int32_t)dsp_hi16(x) * dsp_hi16(y)));
+#endif
+}
+
+/// lo(x)*lo(y) + hi(x)*hi(y)
+static inline int32_t dsp_smuad(int32_t x, int32_t y)
+{
+#if DSP_HAS_SIMD
+	return __smuad(x, y);
+#else
+	return dsp_smlad(x, y, 0);
+#endif
+}
+
+/// (a * b) >> 32, rounded: a Q31 multiply, or a 32x32 multiply keeping the top word
+static inline int32_t dsp_smmulr(int32_t a, int32_t b)
+{
+#if DSP_HAS_SIMD
+	int32_t r;
+	__asm__ ("smmulr %0, %1, %2" : "=r" (r) : "r" (a), "r" (b));
+	return r;
+#else
+	return (int32_t)(((int64_t)a * b + 0x80000000ll) >> 32);
+#endif
+}
+
+/// (a * b) >> 15, rounded half up, for Q15 values within the int16_t range (no 64-bit product needed)
+static inline int32_t dsp_mul_q15(int32_t a, int32_t b)
+{
+	return (a * b + 0x4000) >> 15;
+}
+
+#endif
@@ -0,0 +1,222 @@
+/*
+	Pitch tracking of an audio input, fixed point, header only
+
+	PitchTracker estimates the fundamental frequency of a monophonic input with a
+	cut-down YIN: the squared difference between the input and itself delayed by each
+	lag up to the longest period tracked, normalised by its running mean, and the first
+	dip below a threshold within the tracking range taken as the period, refined to a
+	fraction of a sample by a parabola through its neighbours. The result is a MIDI note
+	number in 16.16 fixed point, for ComputerCard::CVOutMIDIPitch, and so calibrated
+	1V/octave CV.
+
+	The audio side, Push or PushBlock (from ProcessSample or ProcessBlock), only
+	averages every Decimation input samples into a ring buffer. Estimate does the rest,
+	on the most recent (Window + longest lag) decimated samples, and is meant to run as
+	a core 1 task (ComputerCard::AddCore1Task), whose statistics then give its run time.
+	Each estimate costs about Window multiply-adds per lag up to the longest period, and
+	stops early once it has found the period, so it is cheapest for high notes; CostMACs
+	gives the worst case for the current range, and Work the count of the last estimate.
+	Latency is the span of audio analysed, LatencySamples, plus the time between
+	estimates: narrowing the range, or a smaller Window or larger Decimation, makes
+	estimates both quicker and sooner, at the cost of low notes and accuracy.
+
+	Audio is in ComputerCard's 12-bit range (-2048 to 2047), as from AudioIn.
+	Push and Estimate may run on different cores.
+*/
+
+#ifndef DSP_PITCH_H
+#define DSP_PITCH_H
+
+#include <cmath>
+#include <cstdint>
+
+namespace fxp
+{
+	/// Pitch tracker, analysing Window decimated samples per lag, with Decimation input samples to each
+	template <int Window = 256, int Decimation = 4>
+	class PitchTracker
+	{
+		static_assert((Window & (Window - 1)) == 0 && Window >= 32 && Window <= 1024, "Window must be a power of two, 32 to 1024");
+		static_assert((Decimation & (Decimation - 1)) == 0 && Decimation <= 16, "Decimation must be a power of two, up to 16");
+
+		static constexpr int ringSize = 4 * Window;
+		static constexpr int decimationShift = Decimation >= 16 ? 4 : (Decimation >= 8 ? 3 : (Decimation >= 4 ? 2 : (Decimation >= 2 ? 1 : 0)));
+		// Squared differences of 12-bit samples are up to 2^24, so Window of them are scaled to fit a uint32_t
+		static constexpr int windowShift = Window >= 1024 ? 10 : (Window >= 512 ? 9 : (Window >= 256 ? 8 : (Window >= 128 ? 7 : (Window >= 64 ? 6 : 5))));
+		static constexpr int diffShift = windowShift > 7 ? windowShift - 7 : 0;
+
+	public:
+		PitchTracker()
+		{
+			for (int i=0; i<=32; i++) log2Table[i] = int32_t(std::lround(65536.0 * std::log2(1.0 + i / 32.0)));
+			SetSampleRate(48000.0f);
+		}
+
+		/// Input sample rate (Hz), setting the default range of 50Hz to 1kHz
+		void SetSampleRate(float fs)
+		{
+			decimatedRate = fs / Decimation;
+			// MIDI note at a period of one decimated sample
+			refPitch = int32_t(std::lround(65536.0 * (69.0 + 12.0 * std::log2(double(decimatedRate) / 440.0))));
+			SetRange(50.0f, 1000.0f);
+		}
+
+		/// Lowest and highest frequencies tracked (Hz). The lowest is limited to (input rate / Decimation) / Window
+		void SetRange(float minHz, float maxHz)
+		{
+			int lo = int(decimatedRate / maxHz), hi = int(decimatedRate / minHz) + 1;
+			minLag = lo < 2 ? 2 : lo;
+			maxLag = hi > Window ? Window : hi;
+			if (maxLag < minLag + 2) maxLag = minLag + 2;
+		}
+
+		/// Largest normalised difference (Q16, 0 to 65536) taken as periodic; lower is stricter. Default 0.2
+		void SetThreshold(int32_t q16) {threshold = uint32_t(q16);}
+
+		/// Smallest RMS level (12-bit) tracked; quieter input is reported as unvoiced
+		void SetMinLevel(int32_t level) {minLevel = uint32_t(level);}
+
+		/// Add one input sample
+		void Push(int32_t x)
+		{
+			accumulator += x;
+			if (++count == Decimation)
+			{
+				ring[writePos & (ringSize - 1)] = int16_t(accumulator >> decimationShift);
+				writePos = writePos + 1;
+				accumulator = 0;
+				count = 0;
+			}
+		}
+
+		/// Add n input samples
+		void PushBlock(const int16_t *x, int n)
+		{
+			for (int i=0; i<n; i++) Push(x[i]);
+		}
+
+		/** \brief Estimate the pitch from the latest input, returning whether it is periodic
+
+			When it is, updates PitchQ16. Otherwise (too quiet, or no period in range
+			below the threshold), PitchQ16 keeps the last pitch found.
+		*/
+		bool Estimate()
+		{
+			// Copy out the latest samples, oldest first. The ring holds twice as many, so
+			// Push can carry on meanwhile without reaching them
+			int length = Window + maxLag;
+			uint32_t end = writePos;
+			for (int i=0; i<length; i++) x[i] = ring[(end - uint32_t(length) + uint32_t(i)) & (ringSize - 1)];
+
+			uint32_t energy = 0;
+			for (int j=0; j<Window; j++) energy += uint32_t(x[j] * x[j]) >> diffShift;
+			work = uint32_t(Window);
+			if ((energy >> (windowShift - diffShift)) < minLevel * minLevel)
+			{
+				voiced = false;
+				return false;
+			}
+
+			// Squared difference at each lag, until the first dip below the threshold in range has bottomed out
+			uint32_t cumulative = 0;
+			int found = -1;
+			for (int tau=1; tau<=maxLag; tau++)
+			{
+				uint32_t d = 0;
+				const int16_t *a = x, *b = x + tau;
+				for (int j=0; j<Window; j++)
+				{
+					int32_t e = a[j] - b[j];
+					d += uint32_t(e * e) >> diffShift;
+				}
+				work += uint32_t(Window);
+				diff[tau] = d;
+				cumulative += d >> windowShift;
+				if (found < 0)
+				{
+					// d / (mean of d so far) < threshold, without a divide
+					if (tau >= minLag && uint64_t(d >> windowShift) * uint32_t(tau) * 65536u < uint64_t(threshold) * cumulative) found = tau;
+				}
+				else if (d >= diff[tau - 1])
+				{
+					break;
+				}
+				else
+				{
+					found = tau;
+				}
+			}
+			if (found < 0)
+			{
+				voiced = false;
+				return false;
+			}
+
+			// Parabola through the minimum and its neighbours, for the period to a fraction of a lag
+			int32_t period = found << 16;
+			if (found < maxLag)
+			{
+				int64_t d0 = diff[found - 1], d1 = diff[found], d2 = diff[found + 1];
+				int64_t den = 2 * (d0 - 2 * d1 + d2);
+				if (den > 0)
+				{
+					int64_t offset = ((d0 - d2) << 16) / den;
+					if (offset > 32768) offset = 32768;
+					if (offset < -32768) offset = -32768;
+					period += int32_t(offset);
+				}
+			}
+
+			pitch = refPitch - 12 * (Log2Q16(uint32_t(period)) - (16 << 16));
+			voiced = true;
+			return true;
+		}
+
+		/// Last pitch found, as a MIDI note number in 16.16 fixed point (e.g. for CVOutMIDIPitch)
+		int32_t PitchQ16() const {return pitch;}
+
+		/// Whether the last Estimate found a pitch
+		bool Voiced() const {return voiced;}
+
+		/// Input samples analysed by each estimate, at the current range
+		int LatencySamples() const {return (Window + maxLag) * Decimation;}
+
+		/// Most multiply-adds an estimate takes, at the current range
+		uint32_t CostMACs() const {return uint32_t(Window) * uint32_t(maxLag + 1);}
+
+		/// Multiply-adds taken by the last estimate
+		uint32_t Work() const {return work;}
+
+		/// log2(x) in 16.16 fixed point, for x > 0, to within 0.0002
+		int32_t Log2Q16(uint32_t v) const
+		{
+			int msb = 31 - __builtin_clz(v);
+			uint32_t m = v << (31 - msb);
+			int i = int(m >> 26) & 31;
+			int32_t r = int32_t((m >> 10) & 0xFFFF);
+			int32_t a = log2Table[i], b = log2Table[i + 1];
+			return (msb << 16) + a + (((b - a) * r) >> 16);
+		}
+
+	private:
+		int16_t ring[ringSize] = {};
+		volatile uint32_t writePos = 0;  // decimated samples written, ever
+		int32_t accumulator = 0;
+		int count = 0;
+
+		int16_t x[2 * Window];           // samples copied out by Estimate
+		uint32_t diff[Window + 1];       // squared difference at each lag
+		int32_t log2Table[33];           // log2(1 + i/32), Q16
+
+		float decimatedRate = 12000.0f;
+		int32_t refPitch = 0;
+		int minLag = 12, maxLag = 241;
+		uint32_t threshold = 13107;
+		uint32_t minLevel = 16;
+		uint32_t work = 0;
+		volatile int32_t pitch = 69 << 16;
+		volatile bool voiced = false;
+	};
+}
+
+#endif
@@ -0,0 +1,126 @@
+/*
+	Post-processing chain for blocks of audio output, fixed point, header only
+
+	Several cards finish their outputs with the same lo-fi stages, each written into its own
+	per-sample loop (the 13_noisebox sample-hold and bit reduction, the 10_twists sample rate
+	and bit reduction). PostFX runs them on a whole block in place, one stage at a time:
+
+		decimate-hold  hold every Nth sample for N samples (SetHold)
+		bit mask       keep the top bits of each sample (SetBits)
+		slew           limit the change per sample (SetSlew)
+		soft clip      cubic saturation to full scale (SetSoftClip)
+		DC block       one-pole highpass (SetDCBlock)
+
+	A card configures the stages once, and ProcessBlock tests each stage once per block, so a
+	stage left at its default, off, costs nothing per sample. State (the held sample, the slew
+	and the highpass) is carried from block to block, so a card needs one PostFX per output.
+
+	Audio is in ComputerCard's 12-bit range (-2048 to 2047), as from AudioIn, in int16_t.
+*/
+
+#ifndef DSP_POSTFX_H
+#define DSP_POSTFX_H
+
+#include <cstdint>
+#include "dsp_primitives.h"
+
+namespace fxp
+{
+	class PostFX
+	{
+	public:
+		/// Hold each Nth sample for N samples, dividing the sample rate by N; 1 is off
+		void SetHold(int n) {holdPeriod = n < 1 ? 1 : n;}
+
+		/// Keep the top bits (1 to 12) of each sample, after saturating it to 12 bits; 12 is off
+		void SetBits(int bits)
+		{
+			if (bits < 1) bits = 1;
+			bitMask = bits >= 12 ? 0 : int16_t(~((1 << (12 - bits)) - 1));
+		}
+
+		/// Change each sample by at most maxStep from the last; 0 is off
+		void SetSlew(int32_t maxStep) {slew = maxStep < 0 ? 0 : maxStep;}
+
+		/// Cubic soft clip, reaching full scale at 1.5 times full scale
+		void SetSoftClip(bool on) {softClip = on;}
+
+		/// Highpass, with Q16 one-pole coefficient b (about 2^16 * 2 pi fc / sample rate); 0 is off
+		void SetDCBlock(uint32_t b) {dcBlock = b;}
+
+		/// n samples in place, through the stages that are on
+		void ProcessBlock(int16_t *x, int n)
+		{
+			if (holdPeriod > 1)
+			{
+				for (int i=0; i<n; i++)
+				{
+					if (holdCounter == 0) held = x[i];
+					x[i] = held;
+					if (++holdCounter >= holdPeriod) holdCounter = 0;
+				}
+			}
+			if (bitMask)
+			{
+				for (int i=0; i<n; i++) x[i] = int16_t(Sat12(x[i]) & bitMask);
+			}
+			if (slew)
+			{
+				int32_t y = last;
+				for (int i=0; i<n; i++)
+				{
+					int32_t d = x[i] - y;
+					if (d > slew) d = slew;
+					else if (d < -slew) d = -slew;
+					y += d;
+					x[i] = int16_t(y);
+				}
+				last = y;
+			}
+			if (softClip)
+			{
+				for (int i=0; i<n; i++) x[i] = int16_t(SoftClip(x[i]));
+			}
+			if (dcBlock)
+			{
+				for (int i=0; i<n; i++) x[i] = int16_t(Sat12((dc.Process(int32_t(x[i]) << 4, dcBlock) + 8) >> 4));
+			}
+		}
+
+		/// One sample, as ProcessBlock
+		int16_t Process(int16_t x)
+		{
+			ProcessBlock(&x, 1);
+			return x;
+		}
+
+		/// Clear the held sample, slew and highpass
+		void Reset()
+		{
+			holdCounter = 0;
+			held = 0;
+			last = 0;
+			dc.Reset();
+		}
+
+	private:
+		int holdPeriod = 1, holdCounter = 0;
+		int16_t held = 0;
+		int16_t bitMask = 0;
+		int32_t slew = 0, last = 0;
+		bool softClip = false;
+		uint32_t dcBlock = 0;
+		OnePoleHP dc;
+
+		// x - x^3 / (3 * 3072^2), flat at 3072, so that 1.5 times full scale reaches 2048
+		static int32_t SoftClip(int32_t x)
+		{
+			if (x > 3072) x = 3072;
+			else if (x < -3072) x = -3072;
+			int32_t x3 = (x * ((x * x) >> 12)) >> 12;
+			return Sat12(x - ((x3 * 2427) >> 12));
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,495 @@
+/*
+	Fixed-point DSP building blocks for cards, header only
+
+	The same few primitives had been written separately by several cards (the noisebox
+	Freeverb, the 20_reverb filters and allpasses, the goldfish highpass, the bumpers
+	SVF), each with its own rounding. Here they share one set of conventions, each has a
+	scalar and a block form, and saturation is a single instruction on the RP2350 (see
+	dsp_intrinsics.h). examples/dsp_benchmark times every primitive, on the device or the
+	host.
+
+	Also white, pink and velvet noise sources (WhiteNoise, PinkNoise, VelvetNoise), in place
+	of the LCGs in several cards.
+
+	Conventions:
+	- Audio is Q15 in an int32_t (a ComputerCard 12-bit sample << 4), unless stated.
+	- Gains are Q15 (32768 = 1.0); one-pole coefficients are Q16 (0 to 65535).
+	- Products are rounded half up, (x + half) >> shift, apart from the filters. These
+	  carry their truncation remainder to the next sample instead, so that a slow filter
+	  has neither a dead band nor a DC offset.
+	- Block forms process n samples in place unless they take a separate output.
+	- No 64-bit products on the RP2040's Cortex-M0+. Where a 32-bit value is multiplied,
+	  it is split into two 32-bit multiplies.
+*/
+
+#ifndef DSP_PRIMITIVES_H
+#define DSP_PRIMITIVES_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "dsp_intrinsics.h"
+
+namespace fxp
+{
+	/// Saturate to the int16_t range
+	inline int32_t Sat16(int32_t x) {return DSP_SSAT(x, 16);}
+
+	/// Saturate to ComputerCard's 12-bit audio and CV range, -2048 to 2047
+	inline int32_t Sat12(int32_t x) {return DSP_SSAT(x, 12);}
+
+	/// Clamp to [lo, hi]
+	inline int32_t Clamp(int32_t x, int32_t lo, int32_t hi)
+	{
+		if (x < lo) return lo;
+		if (x > hi) return hi;
+		return x;
+	}
+
+	/// (a * b) >> 15, rounded, for a and b within the int16_t range: one 32-bit multiply
+	inline int32_t MulQ15(int32_t a, int32_t b) {return (a * b + 0x4000) >> 15;}
+
+	/// (a * b) >> 15, rounded, for any a and b within the int16_t range, whose result fits an int32_t
+	inline int32_t MulQ15Wide(int32_t a, int32_t b)
+	{
+#if DSP_HAS_SIMD
+		return int32_t((int64_t(a) * b + 0x4000) >> 15);
+#else
+		// a = hi * 2^15 + lo, with 0 <= lo < 2^15; exact, as the hi product needs no rounding
+		return (a >> 15) * b + (((a & 0x7FFF) * b + 0x4000) >> 15);
+#endif
+	}
+
+	/// (a * b) >> 16, rounded, for any a, and b from 0 to 65535
+	inline int32_t MulQ16(int32_t a, uint32_t b)
+	{
+		return (a >> 16) * int32_t(b) + int32_t(((uint32_t(a) & 0xFFFF) * b + 0x8000) >> 16);
+	}
+
+	/// Multiply n samples by a Q15 gain
+	inline void ScaleBlock(int32_t *x, int n, int32_t gain)
+	{
+		for (int i=0; i<n; i++) x[i] = MulQ15Wide(x[i], gain);
+	}
+
+	/// Add n samples of src, times a Q15 gain, to dst
+	inline void MixBlock(int32_t *dst, const int32_t *src, int n, int32_t gain)
+	{
+		for (int i=0; i<n; i++) dst[i] += MulQ15Wide(src[i], gain);
+	}
+
+	/// Saturate n samples to the int16_t range
+	inline void Sat16Block(int32_t *x, int n)
+	{
+		for (int i=0; i<n; i++) x[i] = Sat16(x[i]);
+	}
+
+	/// Add n int16_t samples of src to dst, saturating; two at a time with QADD16 on the RP2350
+	inline void AddSat16Block(int16_t *dst, const int16_t *src, int n)
+	{
+		int i = 0;
+#if DSP_HAS_SIMD
+		for (; i+2<=n; i+=2)
+		{
+			int32_t a, b;
+			std::memcpy(&a, dst + i, 4);
+			std::memcpy(&b, src + i, 4);
+			a = dsp_qadd16(a, b);
+			std::memcpy(dst + i, &a, 4);
+		}
+#endif
+		for (; i<n; i++) dst[i] = int16_t(Sat16(dst[i] + src[i]));
+	}
+
+	/** \brief One-pole lowpass, y += (x - y) * b
+
+		b is Q16, 0 to 65535, giving a cutoff of about b * sampleRate / (2 pi 65536) for small b
+		(b = 200 is about 23Hz at 48kHz). The truncation remainder is carried to the next
+		sample, so the output settles exactly on a constant input, however small b is.
+	*/
+	struct OnePoleLP
+	{
+		int32_t y = 0;
+		uint32_t rem = 0;
+
+		int32_t Process(int32_t x, uint32_t b)
+		{
+			int32_t d = x - y;
+			uint32_t lo = (uint32_t(d) & 0xFFFF) * b + rem;
+			y += (d >> 16) * int32_t(b) + int32_t(lo >> 16);
+			rem = lo & 0xFFFF;
+			return y;
+		}
+
+		void ProcessBlock(int32_t *x, int n, uint32_t b)
+		{
+			for (int i=0; i<n; i++) x[i] = Process(x[i], b);
+		}
+
+		void Reset(int32_t value = 0)
+		{
+			y = value;
+			rem = 0;
+		}
+	};
+
+	/// One-pole highpass: the input minus a OnePoleLP, with b as for OnePoleLP (e.g. a DC blocker with small b)
+	struct OnePoleHP
+	{
+		OnePoleLP lp;
+
+		int32_t Process(int32_t x, uint32_t b) {return x - lp.Process(x, b);}
+
+		void ProcessBlock(int32_t *x, int n, uint32_t b)
+		{
+			for (int i=0; i<n; i++) x[i] = Process(x[i], b);
+		}
+
+		void Reset() {lp.Reset();}
+	};
+
+	/// Coefficients for SVFLowPass, scaled by 2^Shift
+	struct SVFCoeffs
+	{
+		int32_t a1, a2, a3;
+	};
+
+	/** \brief Lowpass state-variable filter (Simper/Cytomic trapezoidal form), as used by bumpers
+
+		Stable and well-behaved at all cutoffs and resonances, unlike the Chamberlin SVF.
+		Coefficients are calculated in floating point by Coeffs, so should be worked out
+		outside the audio callback: at startup for a table of cutoffs, or on the other core.
+		The truncation remainders are carried between samples. With Shift = 16, inputs should
+		be within the 12-bit audio range (+-2048) to avoid overflow at high resonance.
+	*/
+	template <unsigned Shift = 16>
+	class SVFLowPass
+	{
+	public:
+		/// Coefficients for cutoff (Hz) and Q (0.5 upwards) at sampleRate
+		static SVFCoeffs Coeffs(float cutoff, float q, float sampleRate = 48000.0f)
+		{
+			float g = tanf(3.14159265f * cutoff / sampleRate);
+			float k = 1.0f / q;
+			float a1 = float(1u << Shift) / (1.0f + g * (g + k));
+			return {int32_t(a1), int32_t(a1 * g), int32_t(a1 * g * g)};
+		}
+
+		void SetCoeffs(const SVFCoeffs &c) {a = c;}
+
+		int32_t Process(int32_t x)
+		{
+			int32_t v3 = x - ic2eq;
+			int32_t v1 = a.a1 * ic1eq + a.a2 * v3 + v1rem;
+			v1rem = v1 & remMask;
+			v1 >>= Shift - 1;
+			int32_t v2 = a.a2 * ic1eq + a.a3 * v3 + v2rem;
+			v2rem = v2 & remMask;
+			v2 >>= Shift - 1;
+			ic1eq = v1 - ic1eq;
+			ic2eq = v2 + ic2eq;
+			return ic2eq;
+		}
+
+		void ProcessBlock(int32_t *x, int n)
+		{
+			for (int i=0; i<n; i++) x[i] = Process(x[i]);
+		}
+
+		void Reset() {ic1eq = ic2eq = v1rem = v2rem = 0;}
+
+	private:
+		static constexpr int32_t remMask = (1 << (Shift - 1)) - 1;
+		SVFCoeffs a = {0, 0, 0};
+		int32_t ic1eq = 0, ic2eq = 0, v1rem = 0, v2rem = 0;
+	};
+
+	/** \brief Freeverb lowpass-feedback comb filter, N samples long, as in the noisebox reverb
+
+		Delay memory (N int16_t, holding Q15 >> 1 for headroom) is supplied by Attach, so
+		that several effects can share one arena. Returns the delayed sample, in Q15.
+	*/
+	template <int N>
+	struct Comb
+	{
+		int16_t *buf = nullptr;
+		int idx = 0;
+		int32_t store = 0;              // Q15 state of the damping lowpass
+		int32_t feedback = 0;           // Q15
+		int32_t damp1 = 0, damp2 = 32767;
+
+		void Attach(int16_t *mem) {buf = mem; Mute();}
+		void Mute()
+		{
+			if (buf) std::memset(buf, 0, N * sizeof(int16_t));
+			idx = 0;
+			store = 0;
+		}
+		void SetFeedback(int32_t fb) {feedback = Clamp(fb, -32768, 32767);}
+		void SetDamp(int32_t d)
+		{
+			damp1 = Clamp(d, 0, 32767);
+			damp2 = 32767 - damp1;
+		}
+
+		int32_t Process(int32_t x)
+		{
+			int32_t y = int32_t(buf[idx]) << 1;
+			store = Sat16(MulQ15Wide(y, damp2) + MulQ15(store, damp1));
+			buf[idx] = int16_t(Sat16(x + MulQ15(store, feedback)) >> 1);
+			if (++idx >= N) idx = 0;
+			return y;
+		}
+
+		/// Add the comb output for n input samples to sum, as in a bank of parallel combs
+		void ProcessBlockAdd(const int32_t *x, int32_t *sum, int n)
+		{
+			for (int i=0; i<n; i++) sum[i] += Process(x[i]);
+		}
+	};
+
+	/// Freeverb allpass, N samples long, with delay memory supplied by Attach as for Comb
+	template <int N>
+	struct Allpass
+	{
+		int16_t *buf = nullptr;
+		int idx = 0;
+		int32_t feedback = 16384;       // Q15, 0.5
+
+		void Attach(int16_t *mem) {buf = mem; Mute();}
+		void Mute()
+		{
+			if (buf) std::memset(buf, 0, N * sizeof(int16_t));
+			idx = 0;
+		}
+		void SetFeedback(int32_t fb) {feedback = Clamp(fb, -32768, 32767);}
+
+		int32_t Process(int32_t x)
+		{
+			int32_t b = int32_t(buf[idx]) << 1;
+			buf[idx] = int16_t(Sat16(x + MulQ15Wide(b, feedback)) >> 1);
+			if (++idx >= N) idx = 0;
+			return Sat16(b - x);
+		}
+
+		void ProcessBlock(int32_t *x, int n)
+		{
+			for (int i=0; i<n; i++) x[i] = Process(x[i]);
+		}
+	};
+
+	/** \brief White noise and random numbers from a xorshift32 generator
+
+		Replaces the per-sample LCGs several cards had, whose low bits repeat with short
+		periods (bit k of an LCG has period 2^(k+1)). Every bit of xorshift32 has the full
+		period of 2^32 - 1, for three shifts and three XORs. The block forms make two Q15
+		samples from each 32-bit draw.
+	*/
+	struct WhiteNoise
+	{
+		uint32_t state = 0x9E3779B9u;
+
+		/// Any seed; zero, which would stick, is replaced
+		void Seed(uint32_t seed) {state = seed ? seed : 0x9E3779B9u;}
+
+		/// Next 32 random bits
+		uint32_t NextU32()
+		{
+			uint32_t x = state;
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			state = x;
+			return x;
+		}
+
+		/// Random 0 to 4095, as the cards' rnd12() functions
+		int32_t Rand12() {return int32_t(NextU32() >> 20);}
+
+		/// Random 0 to n-1, for n up to 65536, without a divide
+		int32_t RandBelow(uint32_t n) {return int32_t(((NextU32() >> 16) * n) >> 16);}
+
+		/// One sample, Q15
+		int32_t Process() {return int32_t(NextU32()) >> 16;}
+
+		/// n samples, Q15, two per draw
+		void ProcessBlock(int32_t *out, int n)
+		{
+			int i = 0;
+			for (; i+2<=n; i+=2)
+			{
+				uint32_t r = NextU32();
+				out[i] = int32_t(r) >> 16;
+				out[i+1] = int16_t(r);
+			}
+			if (i < n) out[i] = Process();
+		}
+
+		/// n samples in the int16_t range, two per draw, e.g. for an int16_t delay line or table
+		void ProcessBlock16(int16_t *out, int n)
+		{
+			int i = 0;
+			for (; i+2<=n; i+=2)
+			{
+				uint32_t r = NextU32();
+				out[i] = int16_t(r >> 16);
+				out[i+1] = int16_t(r);
+			}
+			if (i < n) out[i] = int16_t(NextU32() >> 16);
+		}
+	};
+
+	/** \brief Pink (-3dB/octave) noise, Voss-McCartney
+
+		Rows white-noise values, row k redrawn every 2^(k+1) samples, plus a white value
+		redrawn every sample, summed. Each sample redraws just one row and updates the sum,
+		so the cost is one draw plus a few adds whatever Rows is. The spectrum falls at close
+		to 3dB per octave from about sampleRate / 2^(Rows+1) (6Hz at 48kHz, for 12 rows) up.
+		Each value is Q15 >> 4, so the output peaks at (Rows + 1) * 2048, with an RMS of
+		about 1180 * sqrt(Rows + 1) (Q15).
+	*/
+	template <int Rows = 12>
+	class PinkNoise
+	{
+		static_assert(Rows >= 1 && Rows <= 15, "PinkNoise: 1 to 15 rows");
+	public:
+		PinkNoise() {Seed(0);}
+
+		void Seed(uint32_t seed)
+		{
+			white.Seed(seed);
+			sum = 0;
+			for (int k=0; k<Rows; k++)
+			{
+				row[k] = int32_t(white.NextU32()) >> 20;
+				sum += row[k];
+			}
+			counter = 0;
+		}
+
+		/// One sample, Q15
+		int32_t Process()
+		{
+			uint32_t r = white.NextU32();
+			uint32_t c = ++counter;
+			// Row to redraw: the number of trailing zeros of the counter
+			int k = 0;
+			while (!(c & 1) && k < Rows)
+			{
+				c >>= 1;
+				k++;
+			}
+			if (k < Rows)
+			{
+				int32_t v = int32_t(r) >> 20;
+				sum += v - row[k];
+				row[k] = v;
+			}
+			// The low half of the same draw for the white value
+			return sum + (int32_t(r << 16) >> 20);
+		}
+
+		void ProcessBlock(int32_t *out, int n)
+		{
+			for (int i=0; i<n; i++) out[i] = Process();
+		}
+
+	private:
+		WhiteNoise white;
+		int32_t row[Rows];
+		int32_t sum;
+		uint32_t counter;
+	};
+
+	/** \brief Velvet noise: sparse random impulses of +-amplitude, one in each period
+
+		Each period of Period samples holds a single impulse, at a random position and
+		with a random sign; other samples are zero. Perceptually smooth at a density of
+		about 2000 impulses per second, and as a sparse FIR (a convolution costing one add
+		per impulse) a cheap decorrelator or reverb tail; Impulses gives the impulse
+		positions for such a filter. ProcessBlock costs a clear of the block plus one draw
+		per impulse.
+	*/
+	class VelvetNoise
+	{
+	public:
+		VelvetNoise() {Reset();}
+
+		void Seed(uint32_t seed)
+		{
+			white.Seed(seed);
+			Reset();
+		}
+
+		/// Start a new period now
+		void Reset()
+		{
+			toPeriodEnd = 0;
+			next = NextImpulse(nextSign);
+		}
+
+		/// Impulse spacing in samples (2 to 65536), e.g. sampleRate / density; from the next period
+		void SetPeriod(uint32_t samples) {period = samples < 2 ? 2 : (samples > 65536 ? 65536 : samples);}
+
+		/// Impulse height, Q15
+		void SetAmplitude(int32_t a) {amplitude = a;}
+
+		/// One sample, Q15
+		int32_t Process()
+		{
+			if (next == 0)
+			{
+				int32_t s = nextSign;
+				next = NextImpulse(nextSign);
+				return s * amplitude;
+			}
+			next--;
+			return 0;
+		}
+
+		/// n samples, Q15
+		void ProcessBlock(int32_t *out, int n)
+		{
+			std::memset(out, 0, size_t(n) * sizeof(int32_t));
+			uint32_t i = next;
+			while (i < uint32_t(n))
+			{
+				out[i] = nextSign * amplitude;
+				i += NextImpulse(nextSign) + 1;
+			}
+			next = i - uint32_t(n);
+		}
+
+		/// A fresh sequence of count impulses, as ascending sample offsets and signs (+1 or -1), for a sparse FIR
+		void Impulses(uint32_t *positions, int8_t *signs, int count)
+		{
+			for (int i=0; i<count; i++)
+			{
+				uint32_t r = white.NextU32();
+				positions[i] = uint32_t(i) * period + (((r >> 16) * period) >> 16);
+				signs[i] = (r & 1) ? 1 : -1;
+			}
+		}
+
+	private:
+		// Samples to the following impulse: the rest of this period, then a random point in the next
+		uint32_t NextImpulse(int32_t &sign)
+		{
+			uint32_t r = white.NextU32();
+			uint32_t pos = ((r >> 16) * period) >> 16;
+			uint32_t gap = toPeriodEnd + pos;
+			toPeriodEnd = period - pos - 1;
+			sign = (r & 1) ? 1 : -1;
+			return gap;
+		}
+
+		WhiteNoise white;
+		int32_t amplitude = 32767;
+		uint32_t period = 24;           // samples per impulse (2000 a second at 48kHz)
+		uint32_t next = 0;              // samples before the next impulse
+		uint32_t toPeriodEnd = 0;       // samples after it, to the end of its period
+		int32_t nextSign = 1;
+	};
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include "ComputerCard.h"
+#include <cstdio>
+
+/*
+
+Audio link between two Computers, over the debug pins
+
+CMakeLists.txt builds this example with COMPUTERCARD_LINK=2. Two cards
+running it each send their audio inputs to the other over EnableAudioLink,
+and mix what they receive into their own audio outputs. Cross the two
+cards' DEBUG_1 and DEBUG_2 pins over, and connect their grounds.
+
+Each card's main knob is sent along as the link's control word, and sets
+the brightness of LED 5 on the other card.
+
+The link's latency is fixed while the two sample clocks are held
+together, so the switch also chooses each card's part in a sample clock
+sync (EnableSyncLead, EnableSyncFollow): patch pulse out 1 of the card
+with its switch up at power-on to pulse in 1 of the other. Without this
+patch, the link still works, but a sample is dropped or repeated every
+few seconds as the two clocks drift apart. Once a second, the link's
+state is printed over USB serial.
+
+
+User interface:
+---------------
+
+Knob X:        Level of audio received over the link
+Knob Y:        Level of this card's own audio inputs
+Main knob:     Sent to the other card, as LED 5's brightness
+Switch:        At power-on, up: sample clock leader; middle or down: follower
+Audio in 1/2:  Sent over the link
+Audio out 1/2: Mix of audio in 1/2 and the link's channels 1/2
+Pulse in 1:    Word clock from the leader (follower)
+Pulse out 1:   Word clock to the follower (leader)
+LED 0:         Link connected
+LED 1:         Lit for a second after a frame is lost or slipped
+LED 2:         Sample clock leader
+LED 3:         Sample clock follower, and locked
+LED 5:         Other card's main knob
+
+ */
+
+class AudioLink : public ComputerCard
+{
+	volatile bool started;
+	bool leader, locked;
+	uint32_t lastFaults, faultLedTime;
+
+public:
+	AudioLink()
+	{
+		started = leader = locked = false;
+		lastFaults = 0;
+		faultLedTime = 0;
+		EnableAudioLink();
+		EnablePulseCapture();
+		AddCore1Task(&AudioLink::Report, 1000000, 0);
+		RunCore1Tasks();
+	}
+
+	// Core 1: print the link's state
+	void Report()
+	{
+		LinkStats s = LinkStatus();
+		printf("%s  %lu frames  %lu lost  %lu slipped  %ld queued  sync %s\n",
+			   s.connected ? "connected   " : "disconnected", (unsigned long)s.frames, (unsigned long)s.errors,
+			   (unsigned long)s.slips, (long)s.queued, !started ? "-" : (leader ? "leader" : (SyncStatus().locked ? "locked" : "unlocked")));
+	}
+
+	virtual void ProcessSample()
+	{
+		// The switch is only read once audio is running, so the sync role is chosen 10ms in
+		if (!started && SampleCounter() >= 480)
+		{
+			leader = SwitchVal() == Up;
+			if (leader) EnableSyncLead(0);
+			else EnableSyncFollow(0);
+			started = true;
+		}
+
+		LinkOut(0, AudioIn1());
+		LinkOut(1, AudioIn2());
+		LinkControlOut(uint32_t(KnobVal(Knob::Main)));
+
+		int32_t link = KnobVal(Knob::X), own = KnobVal(Knob::Y);
+		for (int i=0; i<2; i++)
+		{
+			int32_t out = (LinkIn(i) * link + AudioIn(i) * own) >> 12;
+			AudioOut(i, out < -2048 ? -2048 : (out > 2047 ? 2047 : out));
+		}
+
+		// LED 1 for a second after a lost or slipped frame
+		LinkStats s = LinkStatus();
+		if (s.errors + s.slips != lastFaults)
+		{
+			lastFaults = s.errors + s.slips;
+			faultLedTime = 48000;
+		}
+		if (faultLedTime) faultLedTime--;
+
+		LedOn(0, s.connected);
+		LedOn(1, faultLedTime > 0);
+		LedOn(2, started && leader);
+		if ((SampleCounter() & 1023) == 0) locked = started && !leader && SyncStatus().locked;
+		LedOn(3, locked);
+		LedBrightness(5, uint16_t(LinkControlIn() & 4095));
+	}
+};
+
+
+int main()
+{
+	stdio_init_all();
+
+	static AudioLink card;
+	card.Run();
+}
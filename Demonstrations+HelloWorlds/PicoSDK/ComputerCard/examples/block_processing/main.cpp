@@ -0,0 +1,89 @@
+#include "ComputerCard.h"
+
+/*
+
+Block processing example.
+
+CMakeLists.txt builds this example with COMPUTERCARD_BLOCK_SIZE=32, so that
+ProcessBlock is called with 32 frames of audio at a time (1500 times a second),
+rather than ProcessSample being called 48000 times a second.
+
+This removes per-sample interrupt overhead, and lets work that only depends on
+knobs/CV be done once per block, at the cost of 2 blocks (~1.3ms) extra latency.
+Knobs, CV and pulse inputs are only updated once per block.
+
+Outputs are computed at 16 bits, with the gain's fractional bits kept, and
+EnableNoiseShaping has ComputerCard round them to the DAC's 12 bits, moving
+the rounding noise up towards 24kHz, rather than truncating them here.
+
+
+User interface:
+---------------
+
+Main knob:    Gain of the audio passthrough
+Knob X:       Stereo balance
+Audio in 1/2: Audio inputs
+Audio out 1/2: Audio outputs
+Pulse in 1:   Inverts the polarity of both outputs while high
+LEDs:         Peak level of each block, for left and right channels
+
+ */
+
+class BlockProcessing : public ComputerCard
+{
+public:
+	BlockProcessing()
+	{
+		EnableNoiseShaping();
+
+		// Step the knob/CV mux from PIO, at the same point in every block, however long the interrupt takes to start
+		EnableMuxSequencer();
+	}
+
+	virtual void ProcessBlock(const Frame *in, Frame *out, int n)
+	{
+		// Gains depend only on knobs, so calculate once per block (Q12 fixed point)
+		int32_t gain = KnobVal(Knob::Main);
+		int32_t balance = KnobVal(Knob::X);
+		int32_t gainL = (gain * (4095 - balance)) >> 11;
+		int32_t gainR = (gain * balance) >> 11;
+		if (PulseIn1())
+		{
+			gainL = -gainL;
+			gainR = -gainR;
+		}
+
+		int32_t peakL = 0, peakR = 0;
+		for (int i=0; i<n; i++)
+		{
+			// 16-bit outputs, up to twice full scale, so clipped
+			int32_t l = (in[i].audio[0] * gainL) >> 8;
+			int32_t r = (in[i].audio[1] * gainR) >> 8;
+			l = l < -32768 ? -32768 : (l > 32767 ? 32767 : l);
+			r = r < -32768 ? -32768 : (r > 32767 ? 32767 : r);
+			out[i].audio[0] = l;
+			out[i].audio[1] = r;
+
+			if (l < 0) l = -l;
+			if (r < 0) r = -r;
+			if (l > peakL) peakL = l;
+			if (r > peakR) peakR = r;
+		}
+
+		// Simple three-LED level meters
+		for (int i=0; i<3; i++)
+		{
+			int32_t threshold = 1024 << (2*i);
+			LedOn(2*i, peakL > threshold);
+			LedOn(2*i+1, peakR > threshold);
+		}
+	}
+};
+
+
+int main()
+{
+	BlockProcessing bp;
+	bp.Run();
+}
+
@@ -0,0 +1,37 @@
+#include "computercard_c.h"
+
+/// Passthrough, written in C, through the C interface to ComputerCard
+/// Audio inputs to outputs, with gain set by the main knob; CV and pulse inputs to outputs
+/// Also displays switch position and knob values on LEDs
+
+static void process(const cc_frame *in, cc_frame *out, int n, void *ctx)
+{
+	(void)ctx;
+	int32_t gain = cc_knob(CC_KNOB_MAIN);
+	for (int i=0; i<n; i++)
+	{
+		out[i].audio[0] = (int16_t)((in[i].audio[0] * gain) >> 12);
+		out[i].audio[1] = (int16_t)((in[i].audio[1] * gain) >> 12);
+	}
+
+	cc_cv_out(0, cc_cv_in(0));
+	cc_cv_out(1, cc_cv_in(1));
+
+	cc_pulse_out(0, cc_pulse_in(0));
+	cc_pulse_out(1, cc_pulse_in(1));
+
+	// Switch position on LEDs 0, 2, 4, and knob values on LEDs 1, 3, 5
+	int s = cc_switch();
+	cc_led_brightness(4, s == CC_SWITCH_DOWN ? 4095 : 0);
+	cc_led_brightness(2, s == CC_SWITCH_MIDDLE ? 4095 : 0);
+	cc_led_brightness(0, s == CC_SWITCH_UP ? 4095 : 0);
+	cc_led_brightness(1, (uint16_t)cc_knob(CC_KNOB_MAIN));
+	cc_led_brightness(3, (uint16_t)cc_knob(CC_KNOB_X));
+	cc_led_brightness(5, (uint16_t)cc_knob(CC_KNOB_Y));
+}
+
+int main(void)
+{
+	cc_run(process, 0, CC_SR48KHZ);
+	return 0;
+}
@@ -0,0 +1,111 @@
+#include "ComputerCard.h"
+
+/*
+
+Two cards in one firmware image, with CardLauncher
+
+A delay and a looper, each with a second of audio memory (96KB). Run
+separately they would need 192KB of RAM between them; under
+CardLauncher only one is constructed at a time, in the same buffer,
+so together they take 96KB.
+
+Hold the switch down for two seconds to change card. The bottom LED
+shows which card is running.
+
+
+User interface:
+---------------
+
+Switch down (2s): Change card
+Audio in 1:       Input
+Audio out 1/2:    Output
+LED 4/5:          Delay / looper running
+
+Delay:
+Main knob:     Delay time, up to 1s
+Knob X:        Feedback
+Knob Y:        Wet/dry mix
+
+Looper:
+Switch up:     Record (overdubs onto the loop)
+Main knob:     Loop length, up to 1s
+Knob X:        Playback level
+
+ */
+
+static constexpr int bufferSize = 48000;
+
+class Delay : public ComputerCard
+{
+	int16_t buffer[bufferSize];
+	int writePos;
+
+public:
+	Delay()
+	{
+		for (int i=0; i<bufferSize; i++) buffer[i] = 0;
+		writePos = 0;
+	}
+
+	virtual void ProcessSample()
+	{
+		int32_t delay = 1 + ((KnobVal(Knob::Main) * (bufferSize - 1)) >> 12);
+		int readPos = writePos - delay;
+		if (readPos < 0) readPos += bufferSize;
+
+		int32_t in = AudioIn1();
+		int32_t delayed = buffer[readPos];
+		int32_t fed = in + ((delayed * KnobVal(Knob::X)) >> 12);
+		if (fed > 2047) fed = 2047;
+		if (fed < -2048) fed = -2048;
+		buffer[writePos] = int16_t(fed);
+		if (++writePos == bufferSize) writePos = 0;
+
+		int32_t mix = KnobVal(Knob::Y);
+		int32_t out = (in * (4095 - mix) + delayed * mix) >> 12;
+		AudioOut1(out);
+		AudioOut2(out);
+		LedOn(4);
+	}
+};
+
+class Looper : public ComputerCard
+{
+	int16_t buffer[bufferSize];
+	int pos;
+
+public:
+	Looper()
+	{
+		for (int i=0; i<bufferSize; i++) buffer[i] = 0;
+		pos = 0;
+	}
+
+	virtual void ProcessSample()
+	{
+		int length = 480 + ((KnobVal(Knob::Main) * (bufferSize - 480)) >> 12);
+		if (pos >= length) pos = 0;
+
+		int32_t in = AudioIn1();
+		int32_t loop = buffer[pos];
+		if (SwitchVal() == Switch::Up)
+		{
+			int32_t dub = loop + in;
+			if (dub > 2047) dub = 2047;
+			if (dub < -2048) dub = -2048;
+			buffer[pos] = int16_t(dub);
+		}
+		pos++;
+
+		int32_t out = in + ((loop * KnobVal(Knob::X)) >> 12);
+		AudioOut1(out);
+		AudioOut2(out);
+		LedOn(5);
+	}
+};
+
+
+int main()
+{
+	CardLauncher<Delay, Looper>::Run();
+}
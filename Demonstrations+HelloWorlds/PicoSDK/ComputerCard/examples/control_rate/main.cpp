@@ -0,0 +1,75 @@
+#include "ComputerCard.h"
+#include <cmath>
+
+/// Sine oscillator with exponential pitch control, computed at control rate
+
+/// Main knob sets pitch (six octaves upwards from 32Hz), CV 1 adds
+/// approximately 1V/octave, and knob X sets amplitude.
+/// Output on Audio Out 1 and 2.
+
+/// The exponential pitch calculation (exp2f) is too slow to run every
+/// sample alongside other work, so it runs in ProcessControl, called
+/// every 32 samples (1.5kHz). Smoothed interpolates the phase increment
+/// and amplitude between these calls, so there is no zipper noise.
+
+class ControlRate : public ComputerCard
+{
+public:
+	constexpr static unsigned tableSize = 512;
+	int16_t sine[tableSize];
+	constexpr static uint32_t tableMask = tableSize - 1;
+
+	// Sine wave phase (0-2^32 gives 0-2pi phase range)
+	uint32_t phase;
+
+	// Phase increment, in units of 2^16, and amplitude (0-4095)
+	Smoothed increment, amplitude;
+
+	ControlRate()
+	{
+		phase = 0;
+		for (unsigned i=0; i<tableSize; i++)
+		{
+			sine[i] = int16_t(32000*sin(2*i*M_PI/double(tableSize)));
+		}
+
+		EnableControlRate(32);
+	}
+
+	virtual void ProcessControl()
+	{
+		// Knob gives 0-6 octaves, CV gives approximately 1V/octave (CV of 2047 ~= +6V)
+		float octaves = KnobVal(Knob::Main) * (6.0f / 4096.0f) + CVIn1() * (6.0f / 2048.0f);
+		float freq = 32.0f * exp2f(octaves);
+		if (freq > 8000.0f) freq = 8000.0f;
+
+		// Increment = 2^32 * freq / samplerate, stored divided by 2^16
+		increment.Set(int32_t(freq * (65536.0f / 48000.0f)));
+		amplitude.Set(KnobVal(Knob::X));
+	}
+
+	virtual void ProcessSample()
+	{
+		uint32_t index = phase >> 23;
+		int32_t r = (phase & 0x7FFFFF) >> 7;
+
+		int32_t s1 = sine[index];
+		int32_t s2 = sine[(index+1) & tableMask];
+
+		// Interpolated sine, scaled to 12 bits, then by amplitude
+		int32_t out = (s2 * r + s1 * (65536 - r)) >> 20;
+		out = (out * amplitude.Next()) >> 12;
+
+		AudioOut1(out);
+		AudioOut2(out);
+
+		phase += uint32_t(increment.Next()) << 16;
+	}
+};
+
+
+int main()
+{
+	ControlRate cr;
+	cr.Run();
+}
@@ -0,0 +1,104 @@
+#include "ComputerCard.h"
+#include <cmath>
+
+/*
+
+Second-core rendering through a lock-free ring buffer.
+
+Core 1 renders audio using floating-point maths that would be too slow to
+run in ProcessSample, and pushes the samples into a ComputerCard::Ring.
+ProcessSample, on core 0, just pops one sample from the ring each time it
+is called. Neither side ever blocks: if core 1 falls behind, ProcessSample
+repeats the last sample and lights an LED, rather than stalling the audio
+interrupt as multicore_fifo_push_blocking would.
+
+The ring adds latency of up to its length (256 samples, ~5ms) between
+knob changes and the sound, which is fine for this kind of control.
+
+Knob values are passed the other way, from core 0 to core 1, through a
+second, smaller ring.
+
+
+User interface:
+---------------
+
+Main knob:     Frequency
+Knob X:        Wavefolding amount
+Audio out 1/2: Wavefolded sine wave
+LED 0:         Lit while core 1 keeps the ring buffer filled
+LED 1:         Lit if core 1 has ever fallen behind
+
+ */
+
+class Core1Ring : public ComputerCard
+{
+	struct Controls
+	{
+		int32_t freq, fold;
+	};
+
+	Ring<int16_t, 256> audio;    // core 1 -> core 0
+	Ring<Controls, 4> controls;  // core 0 -> core 1
+	int16_t lastSample;
+	bool underrun;
+
+public:
+	Core1Ring()
+	{
+		lastSample = 0;
+		underrun = false;
+		RunOnCore1(&Core1Ring::RenderLoop);
+	}
+
+	// Code for second RP2040 core, blocking
+	void RenderLoop()
+	{
+		float phase = 0.0f, freq = 100.0f, fold = 1.0f;
+
+		while (1)
+		{
+			Controls c;
+			while (controls.Pop(c))
+			{
+				freq = 20.0f * expf(c.freq * 0.0015f);
+				fold = 1.0f + c.fold * 0.002f;
+			}
+
+			// Fill any space in the ring buffer
+			while (!audio.Full())
+			{
+				float y = sinf(fold * sinf(phase));
+				audio.Push(int16_t(y * 2000.0f));
+
+				phase += freq * (float(M_TWOPI) / 48000.0f);
+				if (phase > float(M_TWOPI)) phase -= float(M_TWOPI);
+			}
+		}
+	}
+
+	virtual void ProcessSample()
+	{
+		if (!audio.Pop(lastSample)) underrun = true;
+
+		AudioOut1(lastSample);
+		AudioOut2(lastSample);
+
+		// Ring is almost full if core 1 is keeping up
+		LedOn(0, audio.Size() > 128);
+		LedOn(1, underrun);
+
+		// Pass knob values to core 1, dropping them if it hasn't read the last ones yet
+		Controls c;
+		c.freq = KnobVal(Knob::Main);
+		c.fold = KnobVal(Knob::X);
+		controls.Push(c);
+	}
+};
+
+
+int main()
+{
+	Core1Ring cr;
+	cr.Run();
+}
+
@@ -0,0 +1,118 @@
+#include "ComputerCard.h"
+#include <cmath>
+#include <cstdio>
+
+/*
+
+Several services sharing core 1, through the core 1 task scheduler
+
+Rather than one hand-written loop on core 1, each job is its own task,
+given a period and priority with AddCore1Task:
+
+- Controls (every 1ms, highest priority): reads the knobs into the
+  wavetable's target shape.
+- Wavetable (background): redraws a 256-entry wavetable for that shape,
+  16 entries per run, and swaps it in when complete. Too slow for
+  ProcessSample, and would hold up everything else if done in one go.
+- Report (every second, lowest priority): prints each task's run count,
+  time and lateness over USB serial.
+
+ProcessSample just plays the current wavetable.
+
+
+User interface:
+---------------
+
+Main knob:     Frequency
+Knob X:        Wavetable shape, sine to wavefolded sine
+Audio out 1/2: Wavetable oscillator
+LED 0:         Toggles each time a new wavetable is swapped in
+
+ */
+
+class Core1Tasks : public ComputerCard
+{
+	static constexpr int tableSize = 256;
+	int16_t table[2][tableSize];
+	volatile int playing; // table read by ProcessSample
+	int drawPos;
+	float shape;
+	volatile int32_t knobX;
+	volatile uint32_t swaps;
+	uint32_t phase;
+	int taskControls, taskWavetable, taskReport;
+
+public:
+	Core1Tasks()
+	{
+		for (int i=0; i<tableSize; i++) table[0][i] = table[1][i] = int16_t(2000 * sinf(i * float(M_TWOPI) / tableSize));
+		playing = 0;
+		drawPos = 0;
+		shape = 0.0f;
+		knobX = 0;
+		swaps = 0;
+		phase = 0;
+
+		taskControls = AddCore1Task(&Core1Tasks::Controls, 1000, 2);
+		taskWavetable = AddCore1Task(&Core1Tasks::Wavetable, 0, 1);
+		taskReport = AddCore1Task(&Core1Tasks::Report, 1000000, 0);
+		RunCore1Tasks();
+	}
+
+	void Controls()
+	{
+		shape = knobX * (1.0f / 4095.0f);
+	}
+
+	void Wavetable()
+	{
+		int16_t *t = table[playing ^ 1];
+		float fold = 1.0f + 6.0f * shape;
+		for (int i=0; i<16; i++, drawPos++)
+		{
+			t[drawPos] = int16_t(2000 * sinf(fold * sinf(drawPos * float(M_TWOPI) / tableSize)));
+		}
+		if (drawPos == tableSize)
+		{
+			drawPos = 0;
+			playing = playing ^ 1;
+			swaps = swaps + 1;
+		}
+	}
+
+	void Report()
+	{
+		static const char *const names[] = {"controls", "wavetable", "report"};
+		int ids[] = {taskControls, taskWavetable, taskReport};
+		for (int i=0; i<3; i++)
+		{
+			TaskStats s = Core1TaskStats(ids[i]);
+			printf("%-10s runs %lu  total %luus  max %luus  late %lu  max late %luus\n", names[i],
+				   (unsigned long)s.runs, (unsigned long)s.totalUs, (unsigned long)s.maxUs,
+				   (unsigned long)s.late, (unsigned long)s.maxLateUs);
+		}
+	}
+
+	virtual void ProcessSample()
+	{
+		knobX = KnobVal(Knob::X);
+
+		// Roughly exponential frequency, 20Hz to 2kHz
+		uint32_t increment = 1800000u + uint32_t(KnobVal(Knob::Main)) * uint32_t(KnobVal(Knob::Main)) * 10u;
+		phase += increment;
+		int16_t s = table[playing][phase >> 24];
+		AudioOut1(s);
+		AudioOut2(s);
+
+		LedOn(0, swaps & 1);
+	}
+};
+
+
+int main()
+{
+	stdio_init_all();
+
+	static Core1Tasks card;
+	card.Run();
+}
@@ -0,0 +1,96 @@
+#include "ComputerCard.h"
+
+/*
+
+Clocked sequences written as C++20 coroutines
+
+Each sequence is a member function that reads from top to bottom, waiting
+with co_await for the next clock or for a number of samples, rather than a
+state machine with counters checked every sample. ProcessSample only
+advances the Sequencer by one sample, and passes on clocks; sequences
+that are waiting cost nothing until they are due.
+
+Needs C++20 (set_target_properties(coroutine_sequencer PROPERTIES CXX_STANDARD 20)).
+
+
+User interface:
+---------------
+
+Pulse in 1:    Clock
+Main knob:     Gate length of pulse out 1, 1 to 100ms
+Knob X:        Ratchet spacing of pulse out 2, 5 to 100ms
+CV out 1:      Eight-step pitch sequence, advancing on each clock
+Pulse out 1:   Gate on each clock
+Pulse out 2:   Burst of three triggers on every fourth clock
+LEDs 0-3:      Current step, in binary (0-2), and ratchet bursts (3)
+
+ */
+
+class CoroutineSequencer : public ComputerCard
+{
+	using Task = Sequencer::Task;
+	using Samples = Sequencer::Samples;
+	using NextClock = Sequencer::NextClock;
+
+	Sequencer seq;
+
+	static constexpr int numSteps = 8;
+	static constexpr uint8_t notes[numSteps] = {48, 55, 51, 58, 48, 60, 53, 55};
+
+	// Gate and pitch on every clock
+	Task Steps()
+	{
+		int step = 0;
+		while (true)
+		{
+			co_await NextClock();
+			CVOut1MIDINote(notes[step]);
+			for (int i=0; i<3; i++) LedOn(i, (step >> i) & 1);
+			step = (step + 1) % numSteps;
+
+			PulseOut1(true);
+			co_await Samples(48 + ((KnobVal(Knob::Main) * 4752) >> 12));
+			PulseOut1(false);
+		}
+	}
+
+	// Three triggers on every fourth clock
+	Task Ratchet()
+	{
+		while (true)
+		{
+			for (int i=0; i<4; i++) co_await NextClock();
+			LedOn(3);
+			uint32_t spacing = 240 + ((KnobVal(Knob::X) * 4560) >> 12);
+			for (int i=0; i<3; i++)
+			{
+				PulseOut2(true);
+				co_await Samples(96);
+				PulseOut2(false);
+				co_await Samples(spacing);
+			}
+			LedOff(3);
+		}
+	}
+
+public:
+	CoroutineSequencer()
+	{
+		// Start both sequences, which run until their first co_await
+		seq.Start(Steps());
+		seq.Start(Ratchet());
+	}
+
+	virtual void ProcessSample()
+	{
+		seq.Tick();
+		if (PulseIn1RisingEdge()) seq.Clock();
+	}
+};
+
+
+int main()
+{
+	CoroutineSequencer card;
+	card.Run();
+}
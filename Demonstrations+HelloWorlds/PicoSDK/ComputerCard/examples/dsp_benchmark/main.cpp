@@ -0,0 +1,270 @@
+#include "ComputerCard.h"
+#include "dsp_fft.h"
+#include "dsp_primitives.h"
+#include "pico/multicore.h"
+#include "pico/stdlib.h" // for sleep_ms and printf
+#include <cstdio>
+
+/*
+
+Timing the fixed-point primitives in dsp_primitives.h
+
+Before the card starts, each primitive is run over one second of audio
+(48128 samples, in blocks of 256), timed with time_us_64, and the time
+per sample printed, both in nanoseconds and as a percentage of the 20.8us
+available per sample at 48kHz. The time to refill the block between runs
+is measured separately and subtracted. The results are printed once at
+startup, and then every five seconds over USB serial, for a terminal
+connected after the card has started.
+
+The real FFTs of dsp_fft.h are timed per frame instead, forward and
+inverse, with the share of one core taken by both at every quarter frame
+(75% overlap, as OverlapAdd's default) at 48kHz.
+
+The same file built natively (see host/) times the primitives on the
+computer building it, which is useful for comparing versions of a
+primitive, but not for absolute timings on the Computer.
+
+The card then uses a few of the primitives:
+
+User interface:
+---------------
+
+Main knob:     Lowpass cutoff
+Knob X:        Lowpass resonance
+Audio in 1:    Input, DC blocked with OnePoleHP
+Audio out 1:   Through SVFLowPass
+Audio out 2:   Lowpass output through a Comb and an Allpass
+
+ */
+
+namespace
+{
+	constexpr int blockSize = 256;
+	constexpr int numBlocks = 188; // 48128 samples, about one second
+	constexpr int numSamples = blockSize * numBlocks;
+
+	struct Result
+	{
+		const char *name;
+		uint32_t tenthsNs; // tenths of a nanosecond per sample
+	};
+
+	constexpr int maxResults = 20;
+	Result results[maxResults];
+	int numResults = 0;
+
+	int32_t source[blockSize], work[blockSize], sum[blockSize];
+	int16_t source16[blockSize], work16[blockSize];
+	int16_t combMem[1116], allpassMem[556];
+	volatile int32_t sink;
+
+	// The Q15 multiply used before dsp_primitives.h, with a 64-bit product, for comparison
+	inline int32_t MulQ15Int64(int32_t a, int32_t b)
+	{
+		int64_t p = int64_t(a) * b;
+		int64_t adj = (p >= 0) ? (1ll << 14) : ((1ll << 14) - 1);
+		return int32_t((p + adj) >> 15);
+	}
+
+	// Time fn over numSamples, refilling the work block before each block
+	template <typename F>
+	uint32_t TimeUs(F fn)
+	{
+		uint64_t start = time_us_64();
+		for (int b=0; b<numBlocks; b++)
+		{
+			std::memcpy(work, source, sizeof(work));
+			std::memcpy(work16, source16, sizeof(work16));
+			fn();
+			sink = work[b & (blockSize - 1)] + work16[0];
+		}
+		return uint32_t(time_us_64() - start);
+	}
+
+	uint32_t refillUs = 0;
+
+	struct FFTResult
+	{
+		const char *name;
+		int n;
+		uint32_t forwardTenthsUs, inverseTenthsUs;
+	};
+
+	constexpr int maxFFTResults = 3;
+	FFTResult fftResults[maxFFTResults];
+	int numFFTResults = 0;
+
+	// Time a forward and inverse transform of N full-scale random samples, averaged over 50 runs
+	template <int N>
+	void BenchmarkFFT(const char *name)
+	{
+		static fxp::RealFFT<N> fft;
+		static int16_t frame[N];
+		constexpr int runs = 50;
+		uint32_t forwardUs = 0, inverseUs = 0;
+		for (int r=0; r<runs; r++)
+		{
+			for (int i=0; i<N; i++) frame[i] = source16[(i + r) & (blockSize - 1)];
+			uint64_t t0 = time_us_64();
+			int exponent = fft.Forward(frame);
+			uint64_t t1 = time_us_64();
+			fft.Inverse(frame, exponent);
+			forwardUs += uint32_t(t1 - t0);
+			inverseUs += uint32_t(time_us_64() - t1);
+			sink = frame[r];
+		}
+		if (numFFTResults < maxFFTResults) fftResults[numFFTResults++] = {name, N, forwardUs * 10 / runs, inverseUs * 10 / runs};
+	}
+
+	template <typename F>
+	void Benchmark(const char *name, F fn)
+	{
+		uint32_t us = TimeUs(fn);
+		us = us > refillUs ? us - refillUs : 0;
+		if (numResults < maxResults) results[numResults++] = {name, uint32_t((uint64_t(us) * 10000) / numSamples)};
+	}
+
+	void RunBenchmarks()
+	{
+		uint32_t rng = 1;
+		for (int i=0; i<blockSize; i++)
+		{
+			rng = rng * 1664525 + 1013904223;
+			source[i] = int32_t(rng) >> 20;   // 12-bit
+			source16[i] = int16_t(rng >> 16); // full 16-bit
+		}
+		refillUs = TimeUs([]{});
+
+		Benchmark("Sat16Block", []{fxp::Sat16Block(work, blockSize);});
+		Benchmark("MulQ15 (16-bit a)", []{for (int i=0; i<blockSize; i++) work[i] = fxp::MulQ15(work[i], 23170);});
+		Benchmark("ScaleBlock (MulQ15Wide)", []{fxp::ScaleBlock(work, blockSize, 23170);});
+		Benchmark("Q15 multiply, int64 (old)", []{for (int i=0; i<blockSize; i++) work[i] = MulQ15Int64(work[i], 23170);});
+		Benchmark("MixBlock", []{fxp::MixBlock(sum, work, blockSize, 23170);});
+		Benchmark("AddSat16Block", []{fxp::AddSat16Block(work16, source16, blockSize);});
+
+		static fxp::OnePoleLP lp;
+		Benchmark("OnePoleLP", []{lp.ProcessBlock(work, blockSize, 2000);});
+		static fxp::OnePoleHP hp;
+		Benchmark("OnePoleHP", []{hp.ProcessBlock(work, blockSize, 200);});
+
+		static fxp::SVFLowPass<> svf;
+		svf.SetCoeffs(fxp::SVFLowPass<>::Coeffs(1000.0f, 2.0f));
+		Benchmark("SVFLowPass", []{svf.ProcessBlock(work, blockSize);});
+
+		static fxp::Comb<1116> comb;
+		comb.Attach(combMem);
+		comb.SetFeedback(27000);
+		comb.SetDamp(8000);
+		Benchmark("Comb", []{comb.ProcessBlockAdd(work, sum, blockSize);});
+		static fxp::Allpass<556> ap;
+		ap.Attach(allpassMem);
+		Benchmark("Allpass", []{ap.ProcessBlock(work, blockSize);});
+
+		static uint32_t lcg = 1;
+		Benchmark("LCG noise (old)", []{for (int i=0; i<blockSize; i++) {lcg = lcg * 1664525 + 1013904223; work[i] = int32_t(lcg) >> 16;}});
+		static fxp::WhiteNoise white;
+		Benchmark("WhiteNoise", []{white.ProcessBlock(work, blockSize);});
+		static fxp::PinkNoise<> pink;
+		Benchmark("PinkNoise", []{pink.ProcessBlock(work, blockSize);});
+		static fxp::VelvetNoise velvet;
+		Benchmark("VelvetNoise", []{velvet.ProcessBlock(work, blockSize);});
+
+		BenchmarkFFT<256>("RealFFT<256>");
+		BenchmarkFFT<512>("RealFFT<512>");
+		BenchmarkFFT<1024>("RealFFT<1024>");
+	}
+
+	void PrintResults()
+	{
+		printf("dsp_primitives.h, per sample:\n");
+		for (int i=0; i<numResults; i++)
+		{
+			// 20833ns per sample at 48kHz; percentage in hundredths
+			uint32_t hundredthsPercent = (results[i].tenthsNs * 1000 + 10416) / 20833;
+			printf("  %-28s %5lu.%lu ns  %3lu.%02lu%%\n", results[i].name,
+				   (unsigned long)(results[i].tenthsNs / 10), (unsigned long)(results[i].tenthsNs % 10),
+				   (unsigned long)(hundredthsPercent / 100), (unsigned long)(hundredthsPercent % 100));
+		}
+		printf("dsp_fft.h, per frame (forward, inverse, share of a core at hop N/4):\n");
+		for (int i=0; i<numFFTResults; i++)
+		{
+			const FFTResult &r = fftResults[i];
+			// A hop of N/4 samples lasts N/4 * 20.833us, so hundredths of a percent are tenths of us * 192 / N
+			uint32_t hundredthsPercent = (r.forwardTenthsUs + r.inverseTenthsUs) * 192 / uint32_t(r.n);
+			printf("  %-28s %5lu.%lu us  %5lu.%lu us  %3lu.%02lu%%\n", r.name,
+				   (unsigned long)(r.forwardTenthsUs / 10), (unsigned long)(r.forwardTenthsUs % 10),
+				   (unsigned long)(r.inverseTenthsUs / 10), (unsigned long)(r.inverseTenthsUs % 10),
+				   (unsigned long)(hundredthsPercent / 100), (unsigned long)(hundredthsPercent % 100));
+		}
+	}
+}
+
+
+class DSPBenchmark : public ComputerCard
+{
+	// Lowpass coefficients for 64 cutoffs, a third of an octave apart from 20Hz, at 4 resonances
+	constexpr static int numCutoffs = 64, numQs = 4;
+	fxp::SVFCoeffs coeffs[numQs][numCutoffs];
+
+	fxp::OnePoleHP dcBlock;
+	fxp::SVFLowPass<> lowpass;
+	fxp::Comb<1116> comb;
+	fxp::Allpass<556> allpass;
+
+public:
+	DSPBenchmark()
+	{
+		for (int q=0; q<numQs; q++)
+		{
+			for (int c=0; c<numCutoffs; c++)
+			{
+				coeffs[q][c] = fxp::SVFLowPass<>::Coeffs(20.0f * exp2f(float(c) / 3.0f), 0.7f * float(1 << q));
+			}
+		}
+		comb.Attach(combMem);
+		comb.SetFeedback(26000);
+		comb.SetDamp(10000);
+		allpass.Attach(allpassMem);
+
+		RunOnCore1(&DSPBenchmark::PrintLoop);
+	}
+
+	// Code for second RP2040 core, blocking
+	void PrintLoop()
+	{
+		while (1)
+		{
+			sleep_ms(5000);
+			PrintResults();
+		}
+	}
+
+	virtual void ProcessSample()
+	{
+		int c = KnobVal(Knob::Main) >> 6, q = KnobVal(Knob::X) >> 10;
+		if (c > numCutoffs - 1) c = numCutoffs - 1;
+		lowpass.SetCoeffs(coeffs[q][c]);
+
+		int32_t x = dcBlock.Process(AudioIn1(), 200);
+		int32_t y = lowpass.Process(x);
+		AudioOut1(fxp::Sat12(y));
+
+		// Comb and allpass work in Q15
+		int32_t w = allpass.Process(comb.Process(fxp::Sat16(y << 4)));
+		AudioOut2(fxp::Sat12(w >> 4));
+	}
+};
+
+
+int main()
+{
+	stdio_init_all();
+
+	// Timed before the audio interrupt starts, so that nothing else is running on this core
+	RunBenchmarks();
+	PrintResults();
+
+	DSPBenchmark db;
+	db.Run();
+}
@@ -0,0 +1,82 @@
+#include "ComputerCard.h"
+
+/*
+
+Stereo delay reading its input from EnableInputCapture
+
+CMakeLists.txt builds this example with COMPUTERCARD_BLOCK_SIZE=32. The
+audio inputs are recorded into a ring of 32768 frames (about 0.68s) by
+ComputerCard, with a DMA channel copying each block as it arrives, so the
+card never writes its delay line: it only reads the ring, CaptureIndex()
+frames from the start.
+
+With the switch up, the delay time is held, in frames since the start,
+rather than relative to now, so the taps fall further behind until they
+wrap round: a scrub back through the last 0.68s.
+
+
+User interface:
+---------------
+
+Main knob:     Delay time, 0 to 0.68s
+Knob X:        Dry/wet mix
+Switch:        Up: tap position held
+Audio in 1/2:  Audio inputs
+Audio out 1/2: Delayed audio inputs, mixed with the dry inputs
+LED 0:         Tap position held
+
+ */
+
+class InputCapture : public ComputerCard
+{
+	static constexpr uint32_t ringFrames = 32768;
+	static Frame ring[ringFrames];
+
+	uint32_t heldTap;
+	bool held;
+
+public:
+	InputCapture()
+	{
+		heldTap = 0;
+		held = false;
+		EnableInputCapture(ring, ringFrames);
+	}
+
+	virtual void ProcessBlock(const Frame *in, Frame *out, int n)
+	{
+		uint32_t now = CaptureIndex();
+		uint32_t delay = uint32_t(KnobVal(Knob::Main)) * (ringFrames - blockSize) >> 12;
+		uint32_t tap = (now - delay) & (ringFrames - 1);
+
+		// Hold the tap's position in the ring, rather than its delay
+		if (SwitchVal() == Switch::Up)
+		{
+			if (!held) heldTap = tap;
+			held = true;
+			tap = heldTap;
+		}
+		else held = false;
+
+		int32_t wet = KnobVal(Knob::X), dry = 4095 - wet;
+		for (int i=0; i<n; i++)
+		{
+			// Frames at and after now are this block, still being copied into the ring
+			uint32_t pos = (tap + i) & (ringFrames - 1), ahead = (pos - now) & (ringFrames - 1);
+			const Frame &d = ahead < uint32_t(n) ? in[ahead] : ring[pos];
+			out[i].audio[0] = int16_t((in[i].audio[0] * dry + d.audio[0] * wet) >> 12);
+			out[i].audio[1] = int16_t((in[i].audio[1] * dry + d.audio[1] * wet) >> 12);
+		}
+
+		LedOn(0, held);
+	}
+};
+
+ComputerCard::Frame InputCapture::ring[InputCapture::ringFrames];
+
+
+int main()
+{
+	static InputCapture card;
+	card.Run();
+}
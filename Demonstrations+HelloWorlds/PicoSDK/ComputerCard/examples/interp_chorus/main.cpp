@@ -0,0 +1,72 @@
+#include "ComputerCard.h"
+#include <cmath>
+
+/// Chorus, using the RP2040 hardware interpolators for delay-line and wavetable reads
+
+/// Audio In 1 is written into a circular delay line, which is read at a position
+/// modulated by a sine LFO. Audio Out 1 is the modulated (vibrato) signal, and
+/// Audio Out 2 the mix of dry and modulated signals (chorus).
+/// Main knob sets LFO rate (0.05-5Hz), knob X sets modulation depth,
+/// and knob Y sets the delay time (1-21ms).
+
+/// InterpTableOsc and InterpDelayReader use the interpolators to calculate
+/// the wrapped table addresses and the linear interpolation, which would
+/// otherwise take several shifts, masks and a multiply per read.
+
+class InterpChorus : public ComputerCard
+{
+public:
+	// Delay line of 2^11 = 2048 samples (~43ms)
+	constexpr static int delayBits = 11;
+	int16_t delayLine[1 << delayBits] = {};
+	uint32_t writeIndex;
+
+	// 512-point sine table for LFO
+	constexpr static int sineBits = 9;
+	int16_t sine[1 << sineBits] = {};
+
+	InterpTableOsc<sineBits> lfo;
+	InterpDelayReader<delayBits> delay;
+
+	InterpChorus() : lfo(sine), delay(delayLine)
+	{
+		for (int i=0; i<(1 << sineBits); i++)
+		{
+			sine[i] = int16_t(32000*sin(2*i*M_PI/double(1 << sineBits)));
+		}
+		writeIndex = 0;
+
+		EnableControlRate(32);
+	}
+
+	virtual void ProcessControl()
+	{
+		// LFO rate: 0.05Hz to 5Hz, exponential in knob position
+		float rate = 0.05f * exp2f(KnobVal(Knob::Main) * (6.64f / 4096.0f));
+		lfo.SetIncrement(uint32_t(rate * (4294967296.0f / 48000.0f)));
+	}
+
+	virtual void ProcessSample()
+	{
+		int16_t in = AudioIn1();
+		delayLine[writeIndex & ((1 << delayBits) - 1)] = in;
+
+		// Centre delay 1-21ms (48-1008 samples), modulated by up to +/-31 samples, in 1/256ths of a sample
+		int32_t centre = (48 << 8) + KnobVal(Knob::Y) * 60;
+		int32_t depth = KnobVal(Knob::X) >> 4; // 0-255
+		int32_t delay256 = centre + ((lfo.Next() * depth) >> 10);
+
+		int32_t wet = delay.ReadDelayed(writeIndex, delay256);
+		writeIndex++;
+
+		AudioOut1(wet);
+		AudioOut2((wet + in) >> 1);
+	}
+};
+
+
+int main()
+{
+	InterpChorus ic;
+	ic.Run();
+}
@@ -0,0 +1,385 @@
+#include "ComputerCard.h"
+#include "hardware/structs/systick.h"
+#include "hardware/structs/xip_ctrl.h"
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+#include "pico/stdlib.h" // for sleep_ms and printf
+#include <cstdio>
+#include <cstdlib>
+
+#if __has_include("hardware/xip_cache.h")
+#include "hardware/xip_cache.h"
+#endif
+
+// Kernels from the releases (include paths set in CMakeLists.txt)
+#include "FreeverbInt.hpp"
+#include "StateVariableFilterInt.hpp"
+#include "WaveformOsc.hpp"
+#include "TalkiePCM.h"
+extern "C"
+{
+#include "reverb_dsp.h"
+}
+#include "exp2.h"
+
+/*
+
+Cycle counts for the inner loops of several released cards
+
+A baseline for optimising them: each kernel below is run, as in its card,
+over 48128 samples (blocks of 256), with the block timed in processor
+cycles by SysTick and interrupts disabled. Each is compiled twice from the
+same source: once into SRAM, once left in flash to run through the XIP
+cache. The flash copy is timed with the cache warm, and again with the
+cache flushed before every block, which is roughly what happens when the
+card's other code, or the other core, has evicted it.
+
+Columns, per sample unless stated:
+  SRAM         cycles, code in SRAM
+  flash        cycles, code in flash, cache warm
+  flash cold   cycles, code in flash, cache flushed before each block
+  worst        cycles for the slowest block of the cold flash run
+  misses       XIP cache misses per block in the cold flash run (code and
+               constant tables)
+  load         the cold flash figure as a percentage of one sample period
+               at the current system clock
+  budget       for the 20_reverb algorithms, the cycles per sample their
+               SRAM figure must stay within (reverb_cycle_budget), marked
+               OVER if it doesn't
+
+The table is printed at startup and every five seconds over USB serial.
+
+Kernels:
+  reverb_process       20_reverb, one sample in and both outputs read
+  reverb_process_block 20_reverb, the block form used by the card (plate)
+  reverb room/shimmer/ 20_reverb's other algorithms (reverb_set_algorithm),
+    echo               the same block form
+  CombQ15              13_noisebox, one 1617-sample Freeverb comb
+  WaveformOscillator   13_noisebox, band-limited (PolyBLEP) saw
+  SVF LUT              13_noisebox StateVariableFilterIntLUT, lowpass
+  TalkiePCM            78_Talker, frame decode and LPC lattice every sample
+  Pow2                 the 2^x that 07_bumpers, 14_cvmod and 20_reverb each
+                       had, with its table built with floats at startup
+  exp2_q12             its replacement in exp2.h, shared by those cards
+  exp2_increment       exp2.h, a phase increment at a pitch, as 14_cvmod's
+                       playback heads use it
+
+The 20_reverb functions are declared __not_in_flash_func in reverb_dsp.c,
+so are always in SRAM; only their calling loop moves. With
+COMPUTERCARD_RUN_FROM_RAM, everything is in SRAM and the columns match.
+
+Not included: braids MacroOscillator::Render (10_twists), which needs the
+card's own stmlib build and already times every shape at startup (see
+render_budget.cc), and the Sheep grain update (22_sheep), which is part of
+the card class rather than a separate function.
+
+After the benchmarks, the card runs two of the kernels:
+
+Main knob:     SVF cutoff
+Audio in 1:    SVF input
+Audio out 1:   SVF lowpass output
+Audio out 2:   WaveformOscillator saw, 110Hz
+
+ */
+
+namespace
+{
+	constexpr int blockSize = 256;
+	constexpr int numBlocks = 188; // 48128 samples, about one second
+
+	int16_t in16[blockSize], out16[blockSize];
+	int32_t in12[blockSize], inQ15[blockSize], outL[blockSize], outR[blockSize];
+	int16_t combMem[1617];
+	volatile int32_t sink;
+
+	sreverb *reverb;
+	dsp::CombQ15<1617> comb;
+	WaveformOscillator osc;
+	StateVariableFilterIntLUT svf;
+	TalkiePCM talkie;
+
+	const TalkieWord words[4] = {TALKIE_WORD(sp2_ZERO), TALKIE_WORD(sp2_ONE), TALKIE_WORD(sp2_TWO), TALKIE_WORD(sp2_THREE)};
+	int nextWord = 0;
+
+	void SayNextWord()
+	{
+		talkie.sayPrefetched();
+		talkie.prefetch(words[nextWord]);
+		nextWord = (nextWord + 1) & 3;
+	}
+
+	// The Pow2 the cards had before exp2.h
+	uint32_t pow2_128[128];
+
+	uint32_t Pow2(uint32_t in)
+	{
+		uint32_t oct = in >> 12;
+		uint32_t ind1 = (in & 0xFE0) >> 5;
+		uint32_t val1 = pow2_128[ind1];
+		uint32_t ind2 = (ind1 + 1) & 0x7F;
+		uint32_t val2 = pow2_128[ind2];
+		if (ind2 == 0) val2 <<= 1;
+		uint32_t subsample = in & 0x1F;
+		return (val1*(32-subsample) + val2*subsample) >> (31 - oct);
+	}
+
+	// Each kernel processes the first n samples of the block. KERNEL compiles the body twice, into
+	// SRAM (name##Ram) and into flash (name##Flash); flatten inlines everything the body calls, so
+	// that the whole kernel is in the one place.
+#define KERNEL(name, ...)														\
+	void __attribute__((flatten)) __no_inline_not_in_flash_func(name##Ram)(int n) __VA_ARGS__ \
+	void __attribute__((noinline, flatten)) name##Flash(int n) __VA_ARGS__
+
+	KERNEL(ReverbSample, {
+		for (int i=0; i<n; i++)
+		{
+			reverb_process(reverb, in12[i]);
+			reverb_get_outputs(reverb, &outL[i], &outR[i]);
+		}
+	})
+
+	KERNEL(ReverbBlock, {
+		reverb_process_block(reverb, in12, outL, outR, n);
+	})
+
+	KERNEL(Comb, {
+		for (int i=0; i<n; i++) outL[i] = comb.process(inQ15[i]);
+	})
+
+	KERNEL(Oscillator, {
+		for (int i=0; i<n; i++) out16[i] = osc.nextSample();
+	})
+
+	KERNEL(SVF, {
+		svf.processBlock(in16, out16, n);
+	})
+
+	KERNEL(Talkie, {
+		for (int i=0; i<n; i++)
+		{
+			int16_t energy, pitch, preFilter;
+			talkie.prefetchStep();
+			if (talkie.calculateNextFrame(300, energy, pitch)) SayNextWord();
+			out16[i] = talkie.calculateNextSample(false, 0, preFilter);
+		}
+	})
+
+	// Exponents over 10 octaves, as the cards' knob and CV mappings
+	KERNEL(Pow2Table, {
+		for (int i=0; i<n; i++) outL[i] = Pow2(40960 + in12[i] * 10);
+	})
+
+	KERNEL(Exp2, {
+		for (int i=0; i<n; i++) outL[i] = exp2_q12(40960 + in12[i] * 10);
+	})
+
+	KERNEL(Exp2Increment, {
+		for (int i=0; i<n; i++) outL[i] = exp2_increment(5592, in12[i] * 4);
+	})
+
+#undef KERNEL
+
+	struct Kernel
+	{
+		const char *name;
+		void (*ram)(int);
+		void (*flash)(int);
+		int reverbAlgorithm; // selected before timing, or -1
+	};
+
+	const Kernel kernels[] = {
+		{"reverb_process", ReverbSampleRam, ReverbSampleFlash, REVERB_PLATE},
+		{"reverb_process_block", ReverbBlockRam, ReverbBlockFlash, REVERB_PLATE},
+		{"reverb room", ReverbBlockRam, ReverbBlockFlash, REVERB_ROOM},
+		{"reverb shimmer", ReverbBlockRam, ReverbBlockFlash, REVERB_SHIMMER},
+		{"reverb echo", ReverbBlockRam, ReverbBlockFlash, REVERB_ECHO},
+		{"CombQ15", CombRam, CombFlash, -1},
+		{"WaveformOscillator", OscillatorRam, OscillatorFlash, -1},
+		{"SVF LUT", SVFRam, SVFFlash, -1},
+		{"TalkiePCM", TalkieRam, TalkieFlash, -1},
+		{"Pow2", Pow2TableRam, Pow2TableFlash, -1},
+		{"exp2_q12", Exp2Ram, Exp2Flash, -1},
+		{"exp2_increment", Exp2IncrementRam, Exp2IncrementFlash, -1},
+	};
+	constexpr int numKernels = sizeof(kernels) / sizeof(kernels[0]);
+
+	struct Timing
+	{
+		uint32_t cycles;     // total over all blocks
+		uint32_t worstBlock; // cycles
+		uint32_t misses;     // total XIP cache misses
+	};
+
+	struct Result
+	{
+		Timing ram, flash, cold;
+	};
+	Result results[numKernels];
+
+	void FlushXIPCache()
+	{
+#if __has_include("hardware/xip_cache.h")
+		xip_cache_invalidate_all();
+#else
+		xip_ctrl_hw->flush = 1;
+		(void)xip_ctrl_hw->flush; // read blocks until the flush is complete
+#endif
+	}
+
+	Timing Measure(void (*fn)(int), bool cold)
+	{
+		Timing t = {0, 0, 0};
+		for (int b=0; b<numBlocks; b++)
+		{
+			if (cold) FlushXIPCache();
+			uint32_t irq = save_and_disable_interrupts();
+			// Writing clears the counters
+			xip_ctrl_hw->ctr_hit = 0;
+			xip_ctrl_hw->ctr_acc = 0;
+			uint32_t start = systick_hw->cvr;
+			fn(blockSize);
+			uint32_t elapsed = (start - systick_hw->cvr) & 0x00FFFFFF; // SysTick counts down
+			uint32_t misses = xip_ctrl_hw->ctr_acc - xip_ctrl_hw->ctr_hit;
+			restore_interrupts(irq);
+
+			t.cycles += elapsed;
+			t.misses += misses;
+			if (elapsed > t.worstBlock) t.worstBlock = elapsed;
+			sink = out16[b & (blockSize - 1)] + outL[0] + outR[0];
+		}
+		return t;
+	}
+
+	void Setup()
+	{
+		uint32_t rng = 1;
+		for (int i=0; i<blockSize; i++)
+		{
+			rng = rng * 1664525 + 1013904223;
+			in16[i] = int16_t(int32_t(rng) >> 20); // 12-bit
+			in12[i] = in16[i];
+			inQ15[i] = in16[i] << 4;
+		}
+
+		float f = 67108864; // 2^26
+		for (int i=0; i<128; i++)
+		{
+			pow2_128[i] = f;
+			f *= 1.005429901112803f; // 2^(1/128)
+		}
+
+		reverb = reverb_create();
+
+		comb.attach(combMem);
+		comb.set_feedback_q15(27000);
+		comb.set_damp_q15(8000);
+
+		osc.setSampleRate(48000.0f);
+		osc.setShape(WaveformOscillator::Shape::SawBlep);
+		osc.setFrequencyHz(110.0f);
+		osc.setAmplitudeQ12(4095);
+
+		svf.begin();
+		svf.setCutoffFromKnob(2000);
+
+		talkie.prefetch(words[nextWord++]);
+		SayNextWord();
+	}
+
+	void RunBenchmarks()
+	{
+		// Free-running from the processor clock, as for the ComputerCard load meter
+		systick_hw->csr = 0;
+		systick_hw->rvr = 0x00FFFFFF;
+		systick_hw->cvr = 0;
+		systick_hw->csr = 0x5;
+
+		for (int k=0; k<numKernels; k++)
+		{
+			if (kernels[k].reverbAlgorithm >= 0) reverb_set_algorithm(reverb, kernels[k].reverbAlgorithm);
+			results[k].ram = Measure(kernels[k].ram, false);
+			results[k].flash = Measure(kernels[k].flash, false);
+			results[k].cold = Measure(kernels[k].flash, true);
+		}
+
+		// Leave the shared state as the card expects it
+		reverb_set_algorithm(reverb, REVERB_PLATE);
+		svf.begin();
+	}
+
+	// Cycles per sample, in tenths
+	uint32_t TenthsPerSample(uint32_t cycles)
+	{
+		return uint32_t((uint64_t(cycles) * 10) / (blockSize * numBlocks));
+	}
+
+	void PrintResults()
+	{
+		uint32_t cyclesPerSample = clock_get_hz(clk_sys) / 48000;
+		printf("Kernel cycles per sample, %lu available at %lu MHz:\n",
+			   (unsigned long)cyclesPerSample, (unsigned long)(clock_get_hz(clk_sys) / 1000000));
+		printf("  %-22s %8s %8s %11s %8s %7s %7s %7s\n", "", "SRAM", "flash", "flash cold", "worst", "misses", "load", "budget");
+		for (int k=0; k<numKernels; k++)
+		{
+			const Result &r = results[k];
+			uint32_t ram = TenthsPerSample(r.ram.cycles), flash = TenthsPerSample(r.flash.cycles), cold = TenthsPerSample(r.cold.cycles);
+			uint32_t worst = (r.cold.worstBlock * 10) / blockSize;
+			uint32_t hundredthsPercent = (cold * 1000 + cyclesPerSample * 5) / (cyclesPerSample * 10);
+			printf("  %-22s %6lu.%lu %6lu.%lu %9lu.%lu %6lu.%lu %7lu %3lu.%02lu%%", kernels[k].name,
+				   (unsigned long)(ram / 10), (unsigned long)(ram % 10),
+				   (unsigned long)(flash / 10), (unsigned long)(flash % 10),
+				   (unsigned long)(cold / 10), (unsigned long)(cold % 10),
+				   (unsigned long)(worst / 10), (unsigned long)(worst % 10),
+				   (unsigned long)(r.cold.misses / numBlocks),
+				   (unsigned long)(hundredthsPercent / 100), (unsigned long)(hundredthsPercent % 100));
+			// reverb_process is the plate's per-sample form, with no budget of its own
+			if (kernels[k].reverbAlgorithm >= 0 && kernels[k].ram != ReverbSampleRam)
+			{
+				uint32_t budget = reverb_cycle_budget[kernels[k].reverbAlgorithm];
+				printf(" %7lu%s", (unsigned long)budget, ram > budget * 10 ? " OVER" : "");
+			}
+			printf("\n");
+		}
+	}
+}
+
+
+class KernelBenchmark : public ComputerCard
+{
+public:
+	KernelBenchmark()
+	{
+		RunOnCore1(&KernelBenchmark::PrintLoop);
+	}
+
+	// Code for second RP2040 core, blocking
+	void PrintLoop()
+	{
+		while (1)
+		{
+			sleep_ms(5000);
+			PrintResults();
+		}
+	}
+
+	virtual void ProcessSample()
+	{
+		svf.setCutoffFromKnob(KnobVal(Knob::Main));
+		AudioOut1(svf.process(AudioIn1()));
+		AudioOut2(osc.nextSample());
+	}
+};
+
+
+int main()
+{
+	stdio_init_all();
+
+	// Timed before the audio interrupt starts, so that nothing else is running on this core
+	Setup();
+	RunBenchmarks();
+	PrintResults();
+
+	KernelBenchmark kb;
+	kb.Run();
+}
@@ -0,0 +1,108 @@
+#include "ComputerCard.h"
+#include <cstdio>
+
+/*
+
+Latency meter: measures the card's own input-to-output latency
+
+Patch audio out 1 to audio in 1, leave audio in 2 unpatched, and switch
+down. MeasureLatency then plays steps on audio out 1 and times their
+return on audio in 1; next, MeasureInputLatency times steps from the
+normalisation probe on audio in 2. The results are printed over USB serial:
+the round trip, how old each callback's input is as it runs, and the
+difference, which is the output's share.
+
+The latency depends on the block size and sample rate: change
+COMPUTERCARD_BLOCK_SIZE for this example in CMakeLists.txt, or the rate
+passed to Run, to compare them. Between measurements, audio inputs pass
+through to the outputs.
+
+
+User interface:
+---------------
+
+Switch:        Down (momentary): measure
+Audio in 1:    From audio out 1, for the round trip
+Audio in 2:    Unpatched, for the input's latency
+Audio out 1/2: Audio in 1/2, or steps while measuring
+LED 0:         Measuring
+LED 2:         Round trip found
+LED 3:         Input latency found
+LED 4:         Lit after a failed measurement
+
+ */
+
+class LatencyMeter : public ComputerCard
+{
+	enum Stage {Idle, RoundTrip, Input};
+	Stage stage;
+	LatencyStats roundTrip, input;
+	volatile bool ready;
+
+public:
+	LatencyMeter()
+	{
+		stage = Idle;
+		roundTrip = input = LatencyStats{};
+		ready = false;
+		AddCore1Task(&LatencyMeter::Report, 100000, 0);
+		RunCore1Tasks();
+	}
+
+	// Core 1: print each finished pair of measurements
+	void Report()
+	{
+		if (!ready) return;
+		ready = false;
+		printf("block size %d, %ldHz\n", blockSize, (long)SampleRate());
+		if (roundTrip.found)
+			printf("  round trip  %7.2f samples  %5luus  (spread %.2f%s)\n", double(roundTrip.samplesQ8 * (1.0f / 256.0f)),
+				   (unsigned long)roundTrip.us, double(roundTrip.spreadQ8 * (1.0f / 256.0f)), roundTrip.inverted ? ", inverted" : "");
+		else printf("  round trip  not found: patch audio out 1 to audio in 1\n");
+		if (input.found)
+			printf("  input       %7.2f samples  %5luus\n", double(input.samplesQ8 * (1.0f / 256.0f)), (unsigned long)input.us);
+		else printf("  input       not found: unpatch audio in 2\n");
+		if (roundTrip.found && input.found)
+			printf("  output      %7.2f samples  %5ldus\n", double((roundTrip.samplesQ8 - input.samplesQ8) * (1.0f / 256.0f)),
+				   (long)roundTrip.us - (long)input.us);
+	}
+
+	virtual void ProcessSample()
+	{
+		AudioOut1(AudioIn1());
+		AudioOut2(AudioIn2());
+
+		if (stage == Idle && SwitchChanged() && SwitchVal() == Down)
+		{
+			roundTrip = input = LatencyStats{};
+			MeasureLatency(0, 0);
+			stage = RoundTrip;
+		}
+		else if (stage == RoundTrip && LatencyStatus().done)
+		{
+			roundTrip = LatencyStatus();
+			MeasureInputLatency(1);
+			stage = Input;
+		}
+		else if (stage == Input && LatencyStatus().done)
+		{
+			input = LatencyStatus();
+			stage = Idle;
+			ready = true;
+		}
+
+		LedOn(0, stage != Idle);
+		LedOn(2, roundTrip.found);
+		LedOn(3, input.found);
+		LedOn(4, roundTrip.done && input.done && !(roundTrip.found && input.found));
+	}
+};
+
+
+int main()
+{
+	stdio_init_all();
+
+	static LatencyMeter card;
+	card.Run();
+}
@@ -0,0 +1,142 @@
+#define COMPUTERCARD_TRACE 1024
+#define COMPUTERCARD_RECORD 16384
+#include "ComputerCard.h"
+#include "pico/multicore.h"
+#include "pico/stdio_usb.h"
+#include "pico/stdlib.h" // for sleep_ms and printf
+#include <cstdio>
+#include <cmath>
+
+/*
+
+Load meter example
+
+Demonstrates the built-in load meter, which measures how many CPU cycles
+ProcessSample takes, and counts any deadline overruns (samples where
+ProcessSample took so long that the next sample was already waiting).
+
+A deliberately variable amount of work is done each sample, set by the
+main knob, so that the effect on the load meter can be seen.
+
+
+User interface:
+---------------
+
+Main knob:     Number of sine oscillators summed (amount of work per sample)
+Audio out 1/2: Sum of sine oscillators
+LEDs:          Average load (left column) and maximum load (right column),
+               each LED covering a third of the available time per sample
+Switch down:   Reset maximum and overrun count
+
+Load statistics, and stack, heap and flash cache use, are also printed
+over USB serial, once a second.
+
+Sending 't' over USB serial prints a trace of the last 1024 events on
+each core (audio interrupts, overruns, and the printing of statistics)
+as JSON. Save it to a .json file and open it in ui.perfetto.dev or
+chrome://tracing to see them on a timeline.
+
+Sending 'r' prints the recent history of the knobs, switch and other
+control inputs, recorded in 16kB of SRAM. Saved to a file, the host
+backend replays it into a native build of a card (COMPUTERCARD_REPLAY in
+host/ComputerCard.h), to reproduce exactly what the card was given.
+
+ */
+
+
+class LoadMeterDemo : public ComputerCard
+{
+	constexpr static unsigned tableSize = 512;
+	int16_t sine[tableSize];
+
+	constexpr static int maxOscillators = 64;
+	uint32_t phase[maxOscillators];
+
+public:
+	LoadMeterDemo()
+	{
+		for (unsigned i=0; i<tableSize; i++)
+		{
+			sine[i] = int16_t(2000*sin(2*i*M_PI/double(tableSize)));
+		}
+		for (int i=0; i<maxOscillators; i++)
+		{
+			phase[i] = 0;
+		}
+
+		// Start the second core, with its stack painted to measure its use
+		PaintCore1Stack();
+		multicore_launch_core1(core1);
+	}
+
+	// Boilerplate to call member function as second core
+	static void core1()
+	{
+		((LoadMeterDemo *)ThisPtr())->SlowProcessingCore();
+	}
+
+	// Code for second RP2040 core, blocking
+	void SlowProcessingCore()
+	{
+		uint32_t lastPrint = 0;
+		while (1)
+		{
+			if (time_us_32() - lastPrint >= 1000000)
+			{
+				lastPrint = time_us_32();
+				Trace(TraceUser | TraceBegin);
+				LoadStats ls = LoadMeter();
+				printf("load %ld%%  min %lu  avg %lu  max %lu  budget %lu cycles  overruns %lu\n",
+					   LoadPercent(), ls.minCycles, ls.avgCycles, ls.maxCycles, ls.budgetCycles, ls.overruns);
+				MemoryStats m = MemoryUsage();
+				printf("stack %lu/%lu %lu/%lu  heap peak %lu  free %lu  XIP hits %lu/%lu\n",
+					   m.stackUsed[0], m.stackSize[0], m.stackUsed[1], m.stackSize[1],
+					   m.heapPeak, m.heapFree, m.xipHits, m.xipAccesses);
+				Trace(TraceUser | TraceEnd);
+			}
+
+			int c = getchar_timeout_us(0);
+			if (c == 't')
+			{
+				// Written straight to the USB serial driver, so bytes aren't altered by line-ending translation
+				TraceWriteJSON([](const char *s, int n) {stdio_usb.out_chars(s, n);});
+			}
+			else if (c == 'r')
+			{
+				RecordingWrite([](const char *s, int n) {stdio_usb.out_chars(s, n);});
+			}
+			sleep_ms(10);
+		}
+	}
+
+	virtual void ProcessSample()
+	{
+		int numOscillators = 1 + ((KnobVal(Knob::Main) * maxOscillators) >> 12);
+
+		int32_t out = 0;
+		for (int i=0; i<numOscillators; i++)
+		{
+			out += sine[phase[i] >> 23];
+			phase[i] += 20000000 + i * 1300000;
+		}
+		out /= numOscillators;
+
+		AudioOut1(out);
+		AudioOut2(out);
+
+		if (SwitchVal() == Switch::Down) ResetLoadMeter();
+
+		LedsShowLoad();
+	}
+};
+
+
+int main()
+{
+	stdio_init_all();
+
+	LoadMeterDemo lm;
+	lm.EnableLoadMeter();
+	lm.Run();
+}
+
@@ -15,7 +15,8 @@
    to a USB MIDI Host, such as a laptop/desktop computer.
 
    Audio (the ProcessSample function) is processed on one core of the RP2040,
-   and MIDI is processed on the other core.
+   and MIDI is processed on the other core. With EnableAudioOnCore1, audio
+   runs on core 1, leaving core 0 (and its interrupts) to USB.
 
 
    MIDI messages received:
@@ -25,6 +26,12 @@
    
    MIDI messages sent:
    - Turning the main knob sends MIDI CC 1 (Mod Wheel) messages, on channel 1.
+   - CV in 1 sends MIDI CC 2 (Breath) messages, on channel 1.
+
+   Outgoing CC values are set by ProcessSample in a MIDICCOut, and the MIDI
+   core sends only those that have changed, no more than once per millisecond
+   each, packed together into USB packets. So a fast-moving CV does not flood
+   the USB host with messages, but the latest value always arrives.
 
 
    In this example, most of the jack/LED outputs from MIDI are controlled directly
@@ -102,15 +109,16 @@ public:
 	MIDIDevice()
 	{
 		receivedCC1 = 0;
-		
-		// Start the second core
-		multicore_launch_core1(core1);
-	}
+		EnableAdaptiveSmoothing();
 
-	// Boilerplate static function to call member function as second core
-	static void core1()
-	{
-		((MIDIDevice *)ThisPtr())->USBCore();
+		// Main knob -> CC 1, CV in 1 -> CC 2, on channel 1, each at most every 1000us
+		ccOut.Assign(0, 0, 1, 1000);
+		ccOut.Assign(1, 0, 2, 1000);
+		
+		// Audio runs on core 1, and MIDI on core 0, so that TinyUSB's
+		// interrupt never shares a core with the audio interrupt
+		EnableAudioOnCore1();
+		RunOnCore1(&MIDIDevice::USBCore);
 	}
 
 	void HandleMIDIMessage(const MIDIMessage &m)
@@ -152,11 +160,12 @@ public:
 		}
 	}
 	
-	// Code for second RP2040 core. Blocking.
+	// Code for the MIDI core (core 0, see EnableAudioOnCore1). Blocking.
 	void USBCore()
 	{
-		uint8_t lastCCOut = 0;
 		uint8_t buffer[64];
+		uint8_t ccBytes[48];
+		bool wasMounted = false;
 
 		// Initialise TinyUSB
 		tusb_init();
@@ -194,15 +203,16 @@ public:
 			////////////////////////////////////////
 			// Sending MIDI
 			
-			// Read main knob, and if value has changed, send 
-			// MIDI CC 1 (Mod wheel) on channel 1 with knob position
-			// (In a real application, would want to add some hysteresis to eliminate jitter)
-			uint8_t ccOut = KnobVal(Knob::Main) >> 5;
-			if (ccOut != lastCCOut) // if value that would be sent has changed since last time,
+			// Send all CCs whose values have changed (and whose minimum interval has passed)
+			// in one write, so that they are packed into as few USB packets as possible.
+			// On connection, send every CC, so that the host starts with the current values.
+			bool mounted = tud_midi_mounted();
+			if (mounted && !wasMounted) ccOut.ResendAll();
+			wasMounted = mounted;
+			if (mounted)
 			{
-				uint8_t ccmesg[3] = {0xB0, 0x01, ccOut}; // construct...
-				tud_midi_stream_write(0, ccmesg, 3); // ...and send MIDI message
-				lastCCOut = ccOut;
+				unsigned n = ccOut.Poll(ccBytes, sizeof(ccBytes), time_us_32());
+				if (n) tud_midi_stream_write(0, ccBytes, n);
 			}
 		}
 	}
@@ -218,6 +228,10 @@ public:
 		frame++;
 
 
+		// Latest CC values to send; only changes are sent, by the MIDI core
+		ccOut.Set(0, KnobVal(Knob::Main) >> 5);
+		ccOut.Set(1, (CVIn1() + 2048) >> 5);
+
 		// Set CV out 2 and LED 3 according to value received from MIDI
 		CVOut2(receivedCC1 << 4);
 		LedBrightness(3, receivedCC1 << 4);
@@ -226,6 +240,9 @@ public:
 private:
 	// Variable to communicate between the MIDI and audio cores
 	volatile uint32_t receivedCC1;
+
+	// CC values set by the audio core, sent by the MIDI core
+	MIDICCOut<2> ccOut;
 };
 
 
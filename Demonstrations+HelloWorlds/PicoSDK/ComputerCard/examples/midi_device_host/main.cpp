@@ -3,6 +3,8 @@
 #include "pico/multicore.h"
 #include "tusb.h"
 #include "usb_midi_host.h"
+#include "usb_role.h"
+#include "usb_midi_router.h"
 
 
 /*
@@ -18,9 +20,18 @@
 
    This example is extremely minimal and primarily demonstrates the process for
    detecting the USB power state (downstream facing or upstream facing port) and
-   setting up TinyUSB in Host or Device more accordingly.
-
-   Only the sending of MIDI messages is demonstrated here. 
+   setting up TinyUSB in Host or Device more accordingly. USBRoleManager does
+   this, and switches between the two while the card runs, whenever the USB
+   cable is re-patched, without a reset.
+
+   Messages go out through a MIDIRouter, which sends the card's messages to
+   the computer (as device) or to every attached MIDI device (as host), and,
+   as host with a USB hub, also passes the messages of each attached device
+   on to the others.
+
+   Only the sending of MIDI messages is demonstrated here: alternate note on
+   and note off messages, and the main knob position as MIDI CC 1 (Mod wheel),
+   sent through a MIDICCOut only when it changes and at most every 2ms.
    The midi_device and midi_host examples demonstrate receiving MIDI messages.
  */
 
@@ -32,11 +43,17 @@ public:
 		noteOnNext = true;
 		isUSBMIDIHost = false;
 		
-		midi_dev_addr = 0;
-		device_connected = 0;
-		
 		counter = 0;
 		powerState = Unsupported;
+		EnableAdaptiveSmoothing();
+
+		// Main knob -> CC 1 on channel 1, at most every 2000us
+		ccOut.Assign(0, 0, 1, 2000);
+
+		// The card's messages to whichever USB port is running, and between attached devices
+		router.AddRoute(Router::Card, Router::Device);
+		router.AddRoute(Router::Card, Router::Host);
+		router.AddRoute(Router::Host, Router::Host);
 		
 		// Start the second core
 		multicore_launch_core1(core1);
@@ -56,107 +73,50 @@ public:
 		static uint8_t noteOff[3] = {0x80, 0x5f, 0x00};
 
 
-		uint8_t *noteBuf = noteOnNext ? noteOn : noteOff;
-		int noteBufSize = 3;
-
-		// Send message, either as MIDI host (tuh_...) or MIDI device (tud_...)
-		if (isUSBMIDIHost)
-		{
-			// Transmit the note message on the highest cable number
-			uint8_t cable = tuh_midih_get_num_tx_cables(midi_dev_addr) - 1;
-			tuh_midi_stream_write(midi_dev_addr, cable, noteBuf, noteBufSize);
-		}
-		else
-		{
-			tud_midi_stream_write(0, noteBuf, noteBufSize);
-		}
+		SendMIDI(noteOnNext ? noteOn : noteOff, 3);
 
 		// Toggle between note on / note off
 		noteOnNext = !noteOnNext;
 	}
 
-	void SetDeviceHostMode()
+	// Send any CC values that have changed, packed together
+	void SendCCs()
 	{
-		powerState = USBPowerState();
-
-		// On reboot, choose between USB device or USB host mode
-		// Support device mode only on 2024 boards with unsupported power state
-		// Note that the USB power circuitry may only establish the right port state
-		// when power is first appled to the WS; a reset of the RP2040 alone may not
-		// be sufficient to switch the correct state.
-		if (powerState == UFP || powerState == Unsupported)
-		{
-			isUSBMIDIHost = false;
-		}
-		else if (powerState == DFP)
+		uint8_t ccBytes[48];
+		unsigned n = ccOut.Poll(ccBytes, sizeof(ccBytes), time_us_32());
+		if (n) SendMIDI(ccBytes, n);
+	}
+
+	// Send 3-byte MIDI messages through the router, to the USB host or attached devices
+	void SendMIDI(uint8_t *bytes, unsigned n)
+	{
+		for (unsigned i=0; i+3<=n; i+=3)
 		{
-			isUSBMIDIHost = true;
+			router.FromCard(bytes[i], bytes[i+1], bytes[i+2]);
 		}
-
 	}
-	
+
 	// Code for second RP2040 core, blocking
 	// Handles MIDI in/out messages
 	void USBCore()
 	{
-		uint8_t packet[32];
-
-		// Wait 150ms for USB to decide which power state it is in
-		sleep_us(150000); 
-		// Set USB device/host flag from USB power state
-		SetDeviceHostMode();
-
-		// Setup TinyUSB in appropriate host/device mode
-		if (isUSBMIDIHost)
-		{
-			tuh_init(TUH_OPT_RHPORT);
-		}
-		else
-		{
-			tud_init(TUD_OPT_RHPORT);
-		}
-			
-		// Now the MIDI processing loop, here split into two parts for host/device.
+		// Now the MIDI processing loop, the same for host and device
 		while (1)
 		{
-			if (!isUSBMIDIHost) // Computer is USB device
-			{
-				tud_task();
-				while (tud_midi_available())
-				{
-					// Read and discard MIDI input
-					tud_midi_stream_read(packet, sizeof(packet));
-
-					// Use code from midi_device example here to process MIDI input
-				}
-				
-				if (counter >= 20000)
-				{
-					SendNextNote();
-					counter -= 20000;
-				}
-			}
-			else  // Computer is USB host
+			// Device on 2024 boards with unsupported power state, otherwise following the power
+			// state, after it has held for 150ms. The router runs the USB stack, and sends on
+			// everything routed in this pass.
+			powerState = USBPowerState();
+			USBRoleManager::Role role = router.Task(usbRole, powerState);
+			if (role == USBRoleManager::None) continue;
+			isUSBMIDIHost = (role == USBRoleManager::Host);
+
+			if (counter >= 20000)
 			{
-				tuh_task();
-		
-				bool connected = midi_dev_addr != 0 && tuh_midi_configured(midi_dev_addr);
-
-				// device must be attached and have at least one endpoint ready to receive a message
-				if (connected && tuh_midih_get_num_tx_cables(midi_dev_addr) >= 1)
-				{
-
-					if (counter >= 20000)
-					{
-						SendNextNote();
-						counter -= 20000;
-					}
-
-					// Send a USB packet immediately (even though in this case,
-					// we are not close to the 64-byte maximum payload)
-					tuh_midi_stream_flush(midi_dev_addr);
-				}
+				SendNextNote();
+				counter -= 20000;
 			}
+			SendCCs();
 		}
 
 	}
@@ -172,18 +132,21 @@ public:
 
 		// Flash LED 4 (bottom left) if acting as MIDI Host (DFP)
 		// Flash LED 5 (bottom right) if acting as MIDI Device (UFP)
-		int activeLED = (powerState==DFP)?4:5;
-		int inactiveLED = (powerState==DFP)?5:4;
+		int activeLED = isUSBMIDIHost?4:5;
+		int inactiveLED = isUSBMIDIHost?5:4;
 		LedOn(activeLED, !noteOnNext);
 		LedOff(inactiveLED);
 
 
 		// Middle two LEDs show 'live' USB power state
 		// If the LED lit here is not in the same column as the flashing LED
-		// in the bottom row, then the host/device mode and USB power DFP/UFP
-		// are not aligned, and the RP2040 needs to be reset.
+		// in the bottom row, then the host/device mode is about to follow the
+		// new USB power state DFP/UFP.
 		LedOn(2, USBPowerState()==DFP);
 		LedOn(3, USBPowerState()==UFP);
+
+		// Latest CC value to send; only changes are sent, by the USB core
+		ccOut.Set(0, KnobVal(Knob::Main) >> 5);
 		
 		// Counter increment here, but reset by other core
 		if (counter <= 30000)
@@ -193,8 +156,8 @@ public:
 	}
 
 	
-	static uint8_t device_connected;
-	static uint8_t midi_dev_addr;
+	typedef MIDIRouter<> Router;
+	static Router router;
 	
 private:
 	volatile bool noteOnNext;
@@ -205,11 +168,16 @@ private:
 	// We keep powerState as a class member only so that we can indicate
 	// when the board is unsupported
 	volatile USBPowerState_t powerState;
-	bool isUSBMIDIHost;
+	volatile bool isUSBMIDIHost;
+
+	// Host or device, following the power state
+	USBRoleManager usbRole;
+
+	// CC values set by the audio core, sent by the USB core
+	MIDICCOut<1> ccOut;
 };
 
-uint8_t MIDIDeviceHost::device_connected;
-uint8_t MIDIDeviceHost::midi_dev_addr;
+MIDIDeviceHost::Router MIDIDeviceHost::router;
 
 
 // Four callback functions that rppicomidi/usb_midi_host uses
@@ -219,12 +187,7 @@ void tuh_midi_mount_cb(uint8_t dev_addr, uint8_t in_ep, uint8_t out_ep, uint8_t
 {
 	(void)in_ep; (void)out_ep; (void)num_cables_rx; (void)num_cables_tx; // avoid unused variable warnings
 
-	
-	if (MIDIDeviceHost::midi_dev_addr == 0)
-	{
-		MIDIDeviceHost::midi_dev_addr = dev_addr;
-		MIDIDeviceHost::device_connected = 1;
-	}
+	MIDIDeviceHost::router.Mount(dev_addr);
 }
 
 // Unmount USB host callback
@@ -232,36 +195,15 @@ void tuh_midi_umount_cb(uint8_t dev_addr, uint8_t instance)
 {
 	(void)instance;
 	
-	if (dev_addr == MIDIDeviceHost::midi_dev_addr)
-	{
-		MIDIDeviceHost::midi_dev_addr = 0;
-		MIDIDeviceHost::device_connected = 0;
-	}
+	MIDIDeviceHost::router.Unmount(dev_addr);
 }
 
 // USB host MIDI data received callback
-void tuh_midi_rx_cb(uint8_t dev_addr, uint32_t num_packets)
+void tuh_midi_rx_packets_cb(uint8_t dev_addr, uint8_t const *packets, uint32_t num_packets)
 {
-	if (MIDIDeviceHost::midi_dev_addr != dev_addr)
-		return;
-
-	if (num_packets == 0)
-		return;
-	
-	uint8_t cable_num;
-	uint8_t buffer[48];
-	while (1)
-	{
-		// Read and discard MIDI data received as USB MIDI host
-		// See midi_host example for how to process this
-		int32_t bytesToProcess = tuh_midi_stream_read(dev_addr, &cable_num, buffer, sizeof(buffer));
-
-		if (bytesToProcess == 0)
-		{
-			break;
-		}
-	}
-
+	// Forward in place, from the endpoint buffer, to the other attached devices
+	// See midi_host example for how to process this on the card
+	MIDIDeviceHost::router.FromHost(dev_addr, packets, num_packets);
 }
 
 // USB hist MIDI data sent callback (unused)
@@ -7,6 +7,15 @@
 // To connect with USB to a laptop/desktop computer (which itself acts as a USB host),
 // see the usb_device example.
 
+// Incoming MIDI messages are queued with QueueMIDIPackets on the USB core and
+// passed, sample-accurately, by ProcessMIDI on the audio core to a MIDIToCV,
+// whose outputs are updated every 32 samples in ProcessControl:
+// CV 1:      pitch of the last note held, with pitch bend and glide
+// Pulse 1:   gate
+// CV 2:      mod wheel (14-bit CC 1), or pressure if switch is up
+// Pulse 2:   sixteenth notes from MIDI clock, while running
+// Main knob: glide time
+
 
 // This is a very slightly modified 
 
@@ -29,6 +38,7 @@ public:
 		device_connected = 0;
 		
 		counter = 0;
+		EnableControlRate(32);
 		
 		// Start the second core
 		multicore_launch_core1(core1);
@@ -98,15 +108,42 @@ public:
 	}
 
 	
+	// Received MIDI messages, called from PollMIDIEvents when each is due.
+	// These only update the MIDIToCV state; outputs are set in ProcessControl
+	virtual void ProcessMIDI(const MIDIEvent &event)
+	{
+		midiCV.MIDI(event);
+	}
+
+	// Called every 32 samples
+	virtual void ProcessControl()
+	{
+		// Glide time constant up to a second
+		midiCV.SetGlide(KnobVal(Knob::Main) * 12);
+		midiCV.Update(32);
+
+		CVOutMIDIPitch(0, midiCV.Pitch());
+		PulseOut1(midiCV.Gate());
+
+		int32_t mod = (SwitchVal() == Switch::Up) ? midiCV.Pressure() : midiCV.CC(0, 1);
+		CVOut2((mod >> 3) - 2048);
+
+		// Sixteenth notes: high for the first half of each quarter of a beat
+		PulseOut2(midiCV.Running() && ((midiCV.BeatPhase() >> 29) & 1) == 0);
+	}
+
 	// 48kHz audio processing function
 	virtual void ProcessSample()
 	{
+		PollMIDIEvents(SampleCounter());
+
 		// No audio I/O, so just flash an LED
 		// to indicate that the card is running
 		LedOn(5, counter < 10000);
 
 		// LED 4 indicates whether MIDI device is connected
 		LedOn(4, device_connected);
+		LedOn(0, midiCV.Gate());
 		
 		// Counter is reset by other core
 		if (counter <= 30000)
@@ -118,6 +155,7 @@ public:
 	
 private:
 	volatile uint32_t counter;
+	MIDIToCV midiCV;
 };
 
 
@@ -125,7 +163,7 @@ uint8_t MIDIHost::device_connected;
 uint8_t MIDIHost::midi_dev_addr;
 
 
-// Four callback functions that rppicomidi/usb_midi_host uses
+// Four callback functions that usb_midi_host uses
 
 void tuh_midi_mount_cb(uint8_t dev_addr, uint8_t in_ep, uint8_t out_ep, uint8_t num_cables_rx, uint16_t num_cables_tx)
 {
@@ -150,29 +188,15 @@ void tuh_midi_umount_cb(uint8_t dev_addr, uint8_t instance)
 	}
 }
 
-void tuh_midi_rx_cb(uint8_t dev_addr, uint32_t num_packets)
+// Called with the USB-MIDI packets received, still in the USB endpoint buffer
+void tuh_midi_rx_packets_cb(uint8_t dev_addr, uint8_t const *packets, uint32_t num_packets)
 {
 	if (MIDIHost::midi_dev_addr != dev_addr)
 		return;
 
-	if (num_packets == 0)
-		return;
-	
-	uint8_t cable_num;
-	uint8_t buffer[48];
-	while (1)
-	{
-		uint32_t bytes_read = tuh_midi_stream_read(dev_addr, &cable_num, buffer, sizeof(buffer));
-
-		if (bytes_read == 0)
-			return;
-		
-		for (uint32_t idx = 0; idx < bytes_read; idx++)
-		{
-			//buffer[idx]
-		}
-	}
-
+	// Pass to the audio core, timestamped
+	MIDIHost *mh = (MIDIHost *)ComputerCard::ThisPtr();
+	mh->QueueMIDIPackets(packets, num_packets);
 }
 
 void tuh_midi_tx_cb(uint8_t dev_addr)
@@ -0,0 +1,102 @@
+#include "ComputerCard.h"
+#include "dsp_pitch.h"
+#include <cstdio>
+
+/*
+
+Audio to CV: pitch tracking of audio input 1
+
+CMakeLists.txt builds this example with COMPUTERCARD_BLOCK_SIZE=32. Each
+ProcessBlock passes the block of audio input 1 to a PitchTracker
+(dsp_pitch.h), and sets the CV outputs from the latest pitch found. The
+estimates themselves run on core 1, as a task every 10ms, so the audio
+interrupt only pays for decimating the input.
+
+Knobs set the tracking range and threshold. Raising the lowest frequency
+shortens the span of audio each estimate analyses, so the CV follows the
+input sooner and each estimate costs less. Once a second, the latency and
+the time taken per estimate are printed over USB serial.
+
+
+User interface:
+---------------
+
+Main knob:     Lowest frequency tracked, 50Hz to 250Hz
+Knob X:        Highest frequency tracked, 500Hz to 2kHz
+Knob Y:        Threshold, from strict (few false pitches) to lenient
+Audio in 1:    Monophonic input to track
+Audio out 1:   Audio in 1, passed through
+CV out 1:      Tracked pitch, 1V/octave (middle C at 0V), calibrated
+CV out 2:      Tracked pitch, to the nearest semitone
+Pulse out 1:   High while a pitch is found
+LEDs 0 to 5:   Tracked note within the octave, in pairs of semitones
+
+ */
+
+class PitchTrackerCard : public ComputerCard
+{
+	fxp::PitchTracker<256, 4> tracker;
+	volatile int32_t knobMain, knobX, knobY;
+	int taskTrack, taskReport;
+
+public:
+	PitchTrackerCard()
+	{
+		knobMain = knobX = knobY = 0;
+		taskTrack = AddCore1Task(&PitchTrackerCard::Track, 10000, 1);
+		taskReport = AddCore1Task(&PitchTrackerCard::Report, 1000000, 0);
+		RunCore1Tasks();
+	}
+
+	// Core 1: apply the knobs, then estimate the pitch of the latest input
+	void Track()
+	{
+		tracker.SetRange(50.0f + 200.0f * (knobMain * (1.0f / 4095.0f)), 500.0f + 1500.0f * (knobX * (1.0f / 4095.0f)));
+		tracker.SetThreshold(6554 + knobY * 5);
+		tracker.Estimate();
+	}
+
+	void Report()
+	{
+		TaskStats s = Core1TaskStats(taskTrack);
+		float pitch = tracker.PitchQ16() * (1.0f / 65536.0f);
+		printf("%s note %.2f  latency %.1fms  estimate %luus avg, %luus max  %lu MACs (max %lu)\n",
+			   tracker.Voiced() ? "voiced  " : "unvoiced", double(pitch),
+			   double(tracker.LatencySamples() * (1000.0f / 48000.0f)),
+			   (unsigned long)(s.runs ? s.totalUs / s.runs : 0), (unsigned long)s.maxUs,
+			   (unsigned long)tracker.Work(), (unsigned long)tracker.CostMACs());
+	}
+
+	virtual void ProcessBlock(const Frame *in, Frame *out, int n)
+	{
+		knobMain = KnobVal(Knob::Main);
+		knobX = KnobVal(Knob::X);
+		knobY = KnobVal(Knob::Y);
+
+		for (int i=0; i<n; i++)
+		{
+			tracker.Push(in[i].audio[0]);
+			out[i].audio[0] = in[i].audio[0];
+			out[i].audio[1] = 0;
+		}
+
+		int32_t pitch = tracker.PitchQ16();
+		int note = (pitch + 32768) >> 16;
+		if (note < 0) note = 0;
+		if (note > 127) note = 127;
+		CVOutMIDIPitch(0, pitch);
+		CVOutMIDINote(1, uint8_t(note));
+		PulseOut1(tracker.Voiced());
+
+		for (int i=0; i<6; i++) LedOn(i, tracker.Voiced() && (note % 12) / 2 == i);
+	}
+};
+
+
+int main()
+{
+	stdio_init_all();
+
+	static PitchTrackerCard card;
+	card.Run();
+}
@@ -0,0 +1,97 @@
+#include "ComputerCard.h"
+#include <cstdio>
+
+/*
+
+Sample clock sync between two or more Computers
+
+One card leads: with the switch up at power-on, it sends a word clock on
+pulse output 1, a rising edge every 48 samples. The others follow: with
+the switch middle or down at power-on, each takes the word clock on pulse
+input 1, and trims its own sample rate until the edges fall on multiples of
+48 samples of SyncFrame. Their sample clocks then stay together to a
+fraction of a sample indefinitely, rather than drifting apart by up to a
+few hundred ppm (as their crystals differ), and SyncFrame counts the same
+samples on every card.
+
+As a demonstration, every card clicks on audio output 1, and flashes LED
+0, every 24000 samples of SyncFrame: once locked, the clicks from all the
+cards coincide. Audio inputs pass through to audio output 2.
+
+Followers print their lock state, phase error and trim over USB serial
+once a second.
+
+
+User interface:
+---------------
+
+Switch:        At power-on, up: lead; middle or down: follow
+Audio in 2:    Passed through to audio out 2
+Audio out 1:   Click every 24000 samples of SyncFrame
+Audio out 2:   Audio in 2
+Pulse in 1:    Word clock from the leader (followers)
+Pulse out 1:   Word clock to the followers (leader)
+LED 0:         Flash every 24000 samples of SyncFrame
+LED 1:         Leader
+LED 2:         Follower, and locked
+LED 3:         Follower, and unlocked
+
+ */
+
+class SampleSync : public ComputerCard
+{
+	static constexpr uint32_t clickPeriod = 24000;
+
+	volatile bool started, leader;
+	bool locked;
+
+public:
+	SampleSync()
+	{
+		started = leader = locked = false;
+		EnablePulseCapture();
+		AddCore1Task(&SampleSync::Report, 1000000, 0);
+		RunCore1Tasks();
+	}
+
+	// Core 1: report the follower's phase-locked loop
+	void Report()
+	{
+		if (!started || leader) return;
+		SyncStats s = SyncStatus();
+		printf("%s  phase %+.3f samples  trim %+ldppm  %lu realigns\n",
+			   s.locked ? "locked  " : "unlocked", double(s.phaseError * (1.0f / 65536.0f)),
+			   (long)s.trimPPM, (unsigned long)s.realigns);
+	}
+
+	virtual void ProcessSample()
+	{
+		// The switch is only read once audio is running, so the role is chosen 10ms in
+		if (!started && SampleCounter() >= 480)
+		{
+			started = true;
+			leader = SwitchVal() == Up;
+			if (leader) EnableSyncLead(0);
+			else EnableSyncFollow(0);
+		}
+
+		uint32_t phase = SyncFrame() % clickPeriod;
+		AudioOut1(phase < 48 ? 2047 - int32_t(phase) * 85 : 0);
+		AudioOut2(AudioIn2());
+
+		if ((phase & 1023) == 0) locked = SyncStatus().locked;
+		LedOn(0, phase < 2400);
+		LedOn(1, leader);
+		LedOn(2, !leader && locked);
+		LedOn(3, !leader && !locked);
+	}
+};
+
+
+int main()
+{
+	stdio_init_all();
+
+	static SampleSync card;
+	card.Run();
+}
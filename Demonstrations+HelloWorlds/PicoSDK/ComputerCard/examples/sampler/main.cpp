@@ -0,0 +1,186 @@
+#include "ComputerCard.h"
+#include "pico/multicore.h"
+#include "tusb.h"
+
+#include <pico/bootrom.h>
+
+/*
+
+Polyphonic sampler example.
+
+Plays the WAV files uploaded with the sample_upload example's
+generate_sample_uf2.html page, on six voices, from USB MIDI (the Computer
+acting as a USB device) and from the pulse/CV inputs, using the Sampler
+class of ComputerCard.
+
+CMakeLists.txt builds this example with COMPUTERCARD_BLOCK_SIZE=32. Voices are
+rendered a block at a time, but MIDI messages still start and stop notes on
+the sample they are due: the block is rendered up to that sample before each
+message is handled.
+
+
+User interface:
+---------------
+
+Main knob:     Sample played (also set by MIDI program change)
+Knob X:        Attack time, up to about 1.4s
+Knob Y:        Release time, up to about 1.4s
+Switch:        Up: notes loop between the sample's loop points until released
+               Middle: notes play once
+               Down, held for two seconds: reboot into UF2 upload mode
+Pulse in 1:    Gate: plays a note while high
+CV in 1:       Pitch of notes from Pulse in 1, 1V/octave, quantised to semitones (0V = middle C)
+CV in 2:       Pitch of all notes, 1V/octave
+USB MIDI:      Note on/off (middle C plays the original pitch), pitch bend (+/-2 semitones),
+               program change, all notes off
+Audio out 1/2: Mix of all voices
+Pulse out 1:   High while any voice is playing
+LEDs:          Envelope level of each voice
+
+ */
+
+class SamplerCard : public ComputerCard
+{
+public:
+	SamplerCard() : sampler(bank)
+	{
+		switchDownCount = 0;
+		lastKnobSample = -1;
+		gateNote = -1;
+		mixBuf = nullptr;
+		rendered = 0;
+
+		// Start the second core
+		multicore_launch_core1(core1);
+	}
+
+	// Boilerplate static function to call member function as second core
+	static void core1()
+	{
+		((SamplerCard *)ThisPtr())->USBCore();
+	}
+
+	// Code for second RP2040 core: passes received MIDI to the audio core, timestamped
+	void USBCore()
+	{
+		uint8_t buffer[64];
+		tusb_init();
+
+		while (1)
+		{
+			tud_task();
+			while (tud_midi_available())
+			{
+				uint32_t n = tud_midi_stream_read(buffer, sizeof(buffer));
+				QueueMIDIStream(buffer, n);
+			}
+		}
+	}
+
+	// Called from PollMIDIEvents when each message is due: render the block
+	// up to this sample, so the message takes effect from here
+	virtual void ProcessMIDI(const MIDIEvent &event)
+	{
+		sampler.Render(mixBuf + rendered, pollFrame - rendered);
+		rendered = pollFrame;
+		sampler.MIDI(event);
+	}
+
+	virtual void ProcessBlock(const Frame *in, Frame *out, int n)
+	{
+		(void)in;
+
+		////////////////////////////////////////
+		// If the switch is held down for >2s, reboot into sample upload mode
+		switchDownCount = (SwitchVal() == Down) ? switchDownCount + n : 0;
+		if (switchDownCount >= 96000)
+		{
+			Abort();
+		}
+
+		if (bank.Count() == 0)
+		{
+			// No samples uploaded
+			LedOn(5);
+			for (int i=0; i<n; i++) out[i].audio[0] = out[i].audio[1] = 0;
+			return;
+		}
+
+		////////////////////////////////////////
+		// Controls, once per block
+
+		// Main knob selects the sample when it moves to a new one
+		int32_t knobSample = (KnobVal(Knob::Main) * bank.Count()) >> 12;
+		if (knobSample != lastKnobSample)
+		{
+			sampler.SetSample(knobSample);
+			lastKnobSample = knobSample;
+		}
+
+		int32_t x = KnobVal(Knob::X), y = KnobVal(Knob::Y);
+		sampler.SetEnvelope(48 + ((x * x) >> 8), 48 + ((y * y) >> 8));
+		sampler.SetLoop(SwitchVal() == Up);
+		sampler.SetPitchCents((CVIn2() * 225) >> 6); // ~3.5 cents per CV step
+
+		// Gate on pulse in 1, pitch from CV in 1 (1V/octave, 0V = middle C) to the nearest semitone
+		if (PulseIn1RisingEdge())
+		{
+			int32_t note = CVInNote(0);
+			gateNote = note < 0 ? 0 : (note > 127 ? 127 : note);
+			sampler.NoteOn(sampler.CurrentSample(), gateNote, 100);
+		}
+		if (PulseIn1FallingEdge() && gateNote >= 0)
+		{
+			sampler.NoteOff(gateNote);
+			gateNote = -1;
+		}
+
+		////////////////////////////////////////
+		// Render voices, splitting the block at each MIDI message
+		int32_t mix[blockSize];
+		for (int i=0; i<n; i++) mix[i] = 0;
+		mixBuf = mix;
+		rendered = 0;
+		for (int i=0; i<n; i++)
+		{
+			pollFrame = i;
+			PollMIDIEvents(SampleCounter() + i);
+		}
+		sampler.Render(mix + rendered, n - rendered);
+
+		for (int i=0; i<n; i++)
+		{
+			int32_t v = mix[i] >> 4; // 16-bit samples to 12-bit output
+			if (v < -2048) v = -2048;
+			if (v > 2047) v = 2047;
+			out[i].audio[0] = v;
+			out[i].audio[1] = v;
+		}
+
+		PulseOut1(sampler.Active() > 0);
+		for (int i=0; i<6; i++)
+		{
+			LedBrightness(i, sampler.Level(i) >> 19);
+		}
+	}
+
+private:
+	SampleBank bank;
+	Sampler<6> sampler;
+
+	int32_t *mixBuf;
+	int pollFrame, rendered;
+	int32_t switchDownCount, lastKnobSample, gateNote;
+};
+
+
+int main()
+{
+	SamplerCard sc;
+	sc.Run();
+
+	// We only get here if Abort() called in ProcessBlock.
+	// Reboot into UF2 upload mode
+	rom_reset_usb_boot(1<<11, 0); // pin 11 (top right LED) is USB activity
+	return 0;
+}
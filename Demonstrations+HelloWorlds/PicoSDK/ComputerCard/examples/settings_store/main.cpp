@@ -0,0 +1,74 @@
+#include "ComputerCard.h"
+
+/*
+
+Saving settings to flash with FlashStore, without stopping the audio.
+
+A stepped pitch CV source that remembers its step across power cycles.
+Each push of the switch moves to the next step, and saves it. The save
+only copies the settings in ProcessSample; the flash write is done by
+core 1, half a second after the last change, so stepping quickly through
+several steps writes to flash once. Saves are appended to a log over four
+sectors, so most of them do not erase flash at all.
+
+Audio keeps running while core 1 writes to flash, so this card must be
+built to run from SRAM (copy_to_ram), as it is in CMakeLists.txt.
+
+
+User interface:
+---------------
+
+Switch down:   Next step
+CV out 1:      Pitch CV, an octave higher for each step
+LEDs 0-5:      Current step
+ */
+
+class SettingsStore : public ComputerCard
+{
+	struct Settings
+	{
+		uint32_t step;
+	};
+
+	FlashStore<sizeof(Settings)> store;
+	Settings settings;
+
+public:
+	SettingsStore()
+	{
+		settings.step = 0;
+		store.Load(&settings, sizeof(settings)); // leaves defaults if nothing saved yet
+		if (settings.step > 5) settings.step = 0;
+
+		RunOnCore1(&SettingsStore::StorageLoop);
+	}
+
+	// Code for second RP2040 core, blocking
+	void StorageLoop()
+	{
+		while (1)
+		{
+			store.Service();
+		}
+	}
+
+	virtual void ProcessSample()
+	{
+		if (SwitchChanged() && SwitchVal() == Switch::Down)
+		{
+			settings.step = (settings.step + 1) % 6;
+			store.Save(&settings, sizeof(settings));
+		}
+
+		CVOut1MIDINote(uint8_t(36 + 12 * settings.step));
+
+		for (uint32_t i=0; i<6; i++) LedOn(i, i == settings.step);
+	}
+};
+
+
+int main()
+{
+	SettingsStore ss;
+	ss.Run();
+}
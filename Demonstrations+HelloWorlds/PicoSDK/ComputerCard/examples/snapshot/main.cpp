@@ -0,0 +1,103 @@
+#include "ComputerCard.h"
+
+/*
+
+Restoring a card's state at power-on with Snapshot
+
+A looping random sequence, whose loop comes back exactly as it was after
+a power cycle. Each clock on pulse in 1 rotates a 16-step shift register,
+and the main knob sets the chance that the step coming round is flipped:
+fully anticlockwise, the loop is locked and repeats.
+
+The register and the random number generator are the card's state,
+added to a Snapshot in the constructor and restored before audio starts.
+Two kinds of capture save it: switching down saves at once, and otherwise
+the state is saved two seconds after the loop last changed, so a locked
+loop is saved without writing flash on every step of a changing one. Core
+1 does the flash writes, so this card must be built to run from SRAM
+(copy_to_ram), as it is in CMakeLists.txt.
+
+
+User interface:
+---------------
+
+Main knob:     Chance of flipping each step, locked fully anticlockwise
+Knob X:        Loop length, 2 to 16 steps
+Switch down:   Save now
+Pulse in 1:    Clock
+Pulse out 1:   Current step's bit
+CV out 1:      Pitch CV from the register's low 5 bits, in semitones
+LEDs 0-5:      Low 6 bits of the register; all flash on a save
+ */
+
+class SnapshotDemo : public ComputerCard
+{
+	Snapshot<16> snapshot;
+	uint16_t reg;
+	uint32_t rng;
+	int flashTime;
+
+public:
+	SnapshotDemo()
+	{
+		reg = 0x5A3C;
+		rng = 1;
+		flashTime = 0;
+
+		snapshot.Add(reg);
+		snapshot.Add(rng);
+		snapshot.Restore(); // leaves the defaults if nothing saved yet
+
+		RunOnCore1(&SnapshotDemo::StorageLoop);
+	}
+
+	// Code for second RP2040 core, blocking
+	void StorageLoop()
+	{
+		while (1)
+		{
+			snapshot.Service();
+		}
+	}
+
+	virtual void ProcessSample()
+	{
+		// Only a flipped step counts as a change, not the loop's rotation
+		bool changed = false;
+
+		if (PulseIn1RisingEdge())
+		{
+			// Rotate the loop, flipping the step coming round with the chance set by the main knob
+			int length = 2 + (KnobVal(Knob::X) * 15 >> 12);
+			int chance = KnobVal(Knob::Main) - 32; // locked near fully anticlockwise, despite knob noise
+			uint16_t bit = (reg >> (length - 1)) & 1;
+			rng = rng * 1664525 + 1013904223;
+			if (int32_t(rng >> 20) < chance)
+			{
+				bit ^= 1;
+				changed = true;
+			}
+			reg = uint16_t((reg << 1) | bit);
+		}
+
+		if (SwitchChanged() && SwitchVal() == Switch::Down)
+		{
+			snapshot.Capture();
+			flashTime = 4800;
+		}
+		snapshot.Update(changed);
+
+		PulseOut1(reg & 1);
+		CVOut1MIDINote(uint8_t(48 + (reg & 31)));
+
+		if (flashTime) flashTime--;
+		for (int i=0; i<6; i++) LedOn(i, flashTime ? true : ((reg >> i) & 1));
+	}
+};
+
+
+int main()
+{
+	SnapshotDemo sd;
+	sd.Run();
+}
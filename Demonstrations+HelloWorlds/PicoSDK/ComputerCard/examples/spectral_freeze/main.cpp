@@ -0,0 +1,165 @@
+#include "ComputerCard.h"
+#include "dsp_fft.h"
+#include "dsp_primitives.h"
+#include <cstdio>
+
+/*
+
+Spectral freeze and blur, with the fixed-point FFT in dsp_fft.h
+
+ProcessSample passes audio input 1 through an OverlapAdd, which frames it
+into 1024-sample FFTs every 256 samples (75% overlap). Core 1 analyses
+each frame, and resynthesises it from a magnitude spectrum, with a random
+phase for each bin and frame:
+
+- Blur (switch middle): the magnitudes follow the input's, smoothed over
+  time by the main knob, from immediate to several seconds, smearing
+  transients into a wash.
+- Freeze (switch up): the magnitudes are held, sustaining the sound at the
+  moment of freezing indefinitely.
+
+Switching down (momentary), or a rising edge on pulse in 1, captures the
+current input as the frozen spectrum.
+
+The output is 1280 samples (27ms) behind the input. Core 1 must process a
+frame every 256 samples (5.3ms); once a second, the time taken per frame
+and any frames missed are printed over USB serial.
+
+
+User interface:
+---------------
+
+Main knob:     Blur time
+Knob X:        Dry level
+Knob Y:        Wet level
+Switch:        Up: freeze; middle: blur; down (momentary): capture
+Audio in 1:    Input
+Audio out 1/2: Dry and wet mix
+Pulse in 1:    Capture, on a rising edge
+LED 0:         Frozen
+LED 1:         Lit for a second after core 1 misses a frame
+
+ */
+
+class SpectralFreeze : public ComputerCard
+{
+	static constexpr int fftSize = 1024, hop = 256, bins = fftSize / 2 + 1;
+
+	fxp::OverlapAdd<fftSize, hop> ola;
+	fxp::WhiteNoise random;
+	int32_t held[bins];          // resynthesised magnitudes, as unnormalised DFT magnitudes
+
+	volatile bool frozen, capture;
+	volatile uint32_t blur;      // Q16 coefficient of the magnitude smoothing
+	uint32_t lastOverruns, overrunLedTime;
+
+public:
+	SpectralFreeze()
+	{
+		for (int i=0; i<bins; i++) held[i] = 0;
+		frozen = capture = false;
+		blur = 65535;
+		lastOverruns = 0;
+		overrunLedTime = 0;
+		RunOnCore1(&SpectralFreeze::SpectralLoop);
+	}
+
+	// Code for second RP2040 core, blocking
+	void SpectralLoop()
+	{
+		uint32_t frames = 0, busyUs = 0, maxUs = 0, lastPrint = time_us_32();
+		while (1)
+		{
+			int exponent;
+			int16_t *spectrum = ola.NextFrame(exponent);
+			if (!spectrum)
+			{
+				if (time_us_32() - lastPrint >= 1000000)
+				{
+					lastPrint = time_us_32();
+					printf("%lu frames, %luus per frame (max %luus) of %luus, %lu missed\n",
+						   (unsigned long)frames, (unsigned long)(frames ? busyUs / frames : 0), (unsigned long)maxUs,
+						   (unsigned long)(hop * 1000000 / 48000), (unsigned long)ola.Overruns());
+					frames = busyUs = maxUs = 0;
+				}
+				tight_loop_contents();
+				continue;
+			}
+			uint32_t start = time_us_32();
+
+			// Magnitudes, at the scale of an unnormalised DFT
+			bool take = capture, hold = frozen && !take;
+			uint32_t b = take ? 65535 : blur;
+			int32_t largest = 0;
+			for (int k=0; k<bins; k++)
+			{
+				if (!hold)
+				{
+					int32_t re = (k == 0) ? spectrum[0] : (k == bins - 1 ? spectrum[1] : spectrum[2 * k]);
+					int32_t im = (k == 0 || k == bins - 1) ? 0 : spectrum[2 * k + 1];
+					int32_t mag = fxp::MagnitudeApprox(re, im) << exponent;
+					held[k] += fxp::MulQ16(mag - held[k], b);
+				}
+				if (held[k] > largest) largest = held[k];
+			}
+			if (take) capture = false;
+
+			// Resynthesise with random phases, scaled to 15 bits. Overlapping frames of random
+			// phase add up 4.3dB quieter than the input's, so the magnitudes are raised by 13/8
+			int shift = 0;
+			while ((largest >> shift) > 20000) shift++;
+			const fxp::RealFFT<fftSize> &fft = ola.Transform();
+			for (int k=1; k<bins-1; k++)
+			{
+				int32_t m = ((held[k] >> shift) * 13) >> 3;
+				int phase = int(random.NextU32() >> 22); // 0 to 1023
+				spectrum[2 * k] = int16_t((m * fft.Cos(phase)) >> 15);
+				spectrum[2 * k + 1] = int16_t((m * fft.Sin(phase)) >> 15);
+			}
+			spectrum[0] = 0; // no DC
+			spectrum[1] = int16_t(held[bins - 1] >> shift);
+			ola.Synthesise(shift);
+
+			uint32_t us = time_us_32() - start;
+			frames++;
+			busyUs += us;
+			if (us > maxUs) maxUs = us;
+		}
+	}
+
+	virtual void ProcessSample()
+	{
+		// Blur time: the main knob slows the magnitudes' one-pole smoothing from every frame to ~10s
+		int32_t k = 4095 - KnobVal(Knob::Main);
+		blur = uint32_t(((k * k) >> 8) + 31);
+
+		frozen = SwitchVal() == Up;
+		if ((SwitchChanged() && SwitchVal() == Down) || PulseIn1RisingEdge()) capture = true;
+
+		int32_t dry = AudioIn1();
+		int32_t wet = ola.Process(int16_t(dry << 4)) >> 4;
+		int32_t out = fxp::Sat12((dry * KnobVal(Knob::X) + wet * KnobVal(Knob::Y)) >> 12);
+		AudioOut1(out);
+		AudioOut2(out);
+
+		// LED 1 for a second after an overrun
+		uint32_t overruns = ola.Overruns();
+		if (overruns != lastOverruns)
+		{
+			lastOverruns = overruns;
+			overrunLedTime = 48000;
+		}
+		if (overrunLedTime) overrunLedTime--;
+		LedOn(0, frozen);
+		LedOn(1, overrunLedTime > 0);
+	}
+};
+
+
+int main()
+{
+	stdio_init_all();
+
+	static SpectralFreeze card;
+	card.Run();
+}
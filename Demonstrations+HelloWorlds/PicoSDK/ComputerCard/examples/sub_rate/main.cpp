@@ -0,0 +1,75 @@
+#include "ComputerCard.h"
+
+/*
+
+Echo running at a quarter of the sample rate, with EnableSubRate
+
+The echo, a delay line with feedback through a one-pole lowpass, is a
+part of a signal chain that needs neither the full sample rate nor the
+full bandwidth. EnableSubRate(4) has ComputerCard call ProcessSubRate at
+12kHz, with the audio inputs decimated by half-band filters, and
+interpolate its outputs back up to 48kHz. The delay line then holds two
+seconds in a quarter of the memory, and the echo's arithmetic is done a
+quarter as often. ProcessSample still runs at 48kHz, passing the dry
+input through at full bandwidth; ComputerCard adds the two.
+
+
+User interface:
+---------------
+
+Main knob:     Echo time, up to 2s
+Knob X:        Feedback
+Knob Y:        Echo level
+Audio in 1:    Input
+Audio out 1/2: Dry input plus the echo
+
+ */
+
+class SubRate : public ComputerCard
+{
+	static constexpr int delayLen = 24000; // 2s at 12kHz
+	int16_t delayLine[delayLen];
+	int writeInd;
+	int32_t lp;
+
+public:
+	SubRate()
+	{
+		for (int i=0; i<delayLen; i++) delayLine[i] = 0;
+		writeInd = 0;
+		lp = 0;
+		EnableSubRate(4);
+	}
+
+	virtual void ProcessSample()
+	{
+		// Dry path at 48kHz
+		AudioOut1(AudioIn1());
+		AudioOut2(AudioIn1());
+	}
+
+	virtual void ProcessSubRate()
+	{
+		int delay = 1 + (KnobVal(Knob::Main) * (delayLen - 1) >> 12);
+		int readInd = writeInd - delay;
+		if (readInd < 0) readInd += delayLen;
+		int32_t echo = delayLine[readInd];
+
+		// Each repeat darker, through a one-pole lowpass at about 2kHz at 12kHz
+		lp += (echo - lp) >> 1;
+		int32_t w = SubRateIn(0) + ((lp * KnobVal(Knob::X)) >> 12);
+		delayLine[writeInd] = int16_t(w < -2048 ? -2048 : (w > 2047 ? 2047 : w));
+		if (++writeInd == delayLen) writeInd = 0;
+
+		int16_t out = int16_t((echo * KnobVal(Knob::Y)) >> 12);
+		SubRateOut(0, out);
+		SubRateOut(1, out);
+	}
+};
+
+
+int main()
+{
+	static SubRate card;
+	card.Run();
+}
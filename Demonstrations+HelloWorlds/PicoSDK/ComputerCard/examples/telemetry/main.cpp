@@ -0,0 +1,99 @@
+#include "ComputerCard.h"
+#include "pico/stdio_usb.h"
+
+/*
+
+Streaming internal signals to a computer at audio rate, for debugging
+
+ProcessSample records four channels every sample into a Telemetry queue:
+the filter input, its low-pass and band-pass outputs, and its cutoff
+coefficient. Core 1 packs queued frames into binary packets and writes
+them to the USB serial port. Open telemetry_scope.html in Chrome or Edge,
+connect to the card, and the four channels are plotted as they arrive,
+and can be saved as a CSV file.
+
+Four channels at 48kHz is 384kB/s over USB. If frames are dropped
+because the computer is not keeping up, LED 5 lights; record fewer
+channels, or pass a decimation factor to the Telemetry constructor.
+
+
+User interface:
+---------------
+
+Main knob:     Filter cutoff
+Knob X:        Filter resonance
+CV in 1:       Added to main knob
+Audio in 1:    Filter input
+Audio out 1/2: Low-pass and band-pass outputs
+LED 5:         Lit once any telemetry frames have been dropped
+
+ */
+
+class TelemetryExample : public ComputerCard
+{
+	static constexpr unsigned packetFrames = 64;
+	using Scope = Telemetry<4, 2048>;
+	Scope scope;
+	int32_t low, band;
+
+public:
+	TelemetryExample() : scope(48000)
+	{
+		low = band = 0;
+		RunOnCore1(&TelemetryExample::SendLoop);
+	}
+
+	static int16_t Clip(int32_t v)
+	{
+		if (v < -2048) v = -2048;
+		if (v > 2047) v = 2047;
+		return v;
+	}
+
+	// Code for second RP2040 core, blocking
+	void SendLoop()
+	{
+		static uint8_t packet[Scope::PacketBytes(packetFrames)];
+		while (1)
+		{
+			unsigned n = scope.Packet(packet, packetFrames);
+			// Written straight to the USB serial driver, so bytes aren't altered by line-ending translation
+			if (n) stdio_usb.out_chars(reinterpret_cast<const char *>(packet), n);
+		}
+	}
+
+	virtual void ProcessSample()
+	{
+		// Chamberlin state-variable filter, coefficients in 1/4096ths
+		int32_t cutoff = KnobVal(Knob::Main) + CVIn1();
+		if (cutoff < 0) cutoff = 0;
+		if (cutoff > 4095) cutoff = 4095;
+		int32_t f = 8 + ((cutoff * cutoff) >> 13);
+		int32_t damping = 4096 - ((KnobVal(Knob::X) * 3900) >> 12);
+
+		int32_t in = AudioIn1();
+		low += (f * band) >> 12;
+		int32_t high = in - low - ((damping * band) >> 12);
+		band += (f * high) >> 12;
+
+		AudioOut1(Clip(low));
+		AudioOut2(Clip(band));
+
+		scope.Set(0, in);
+		scope.Set(1, Clip(low));
+		scope.Set(2, Clip(band));
+		scope.Set(3, f);
+		scope.Send();
+
+		LedOn(5, scope.Dropped() != 0);
+	}
+};
+
+
+int main()
+{
+	stdio_init_all();
+
+	TelemetryExample te;
+	te.Run();
+}
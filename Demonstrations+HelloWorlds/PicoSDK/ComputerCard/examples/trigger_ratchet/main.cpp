@@ -0,0 +1,61 @@
+#include "ComputerCard.h"
+
+/*
+
+Trigger delay and ratchet, with pulses timed by PIO rather than counted down each sample
+
+Each rising edge on Pulse in 1 is echoed on Pulse out 1 as a trigger, a fixed two
+samples later: the input edge is timed with EnablePulseCapture, and the output
+trigger scheduled with EnablePulseEngine at the matching point within the sample,
+so the delay has no sample-to-sample jitter. Each rising edge on Pulse in 2 starts a
+ratchet, a burst of triggers on Pulse out 2. The LEDs are faded by EnableLedEngine.
+
+User interface:
+---------------
+
+Main knob:     Trigger length, 1 to 41ms
+Knob X:        Ratchet count, 1 to 8
+Knob Y:        Ratchet rate, 4 to about 130 triggers per second
+Pulse in 1:    Trigger input
+Pulse in 2:    Ratchet input
+Pulse out 1:   Trigger, two samples after Pulse in 1
+Pulse out 2:   Ratchets
+LEDs:          Top row flash and fade out on each trigger and ratchet
+
+ */
+
+class TriggerRatchet : public ComputerCard
+{
+public:
+	virtual void ProcessSample()
+	{
+		uint32_t lengthUs = 1000 + 10 * KnobVal(Knob::Main);
+
+		if (PulseIn1RisingEdge())
+		{
+			PulseOutTrigger(0, lengthUs, 65536 - PulseInRisingEdgeOffset(0));
+			LedOn(0);
+			LedFade(0, 0, 200);
+		}
+
+		if (PulseIn2RisingEdge())
+		{
+			uint32_t count = 1 + (KnobVal(Knob::X) >> 9);
+			uint32_t periodUs = 250000 / (1 + (KnobVal(Knob::Y) >> 7)); // 250ms to 7.6ms
+			uint32_t ratchetLengthUs = (lengthUs < periodUs / 2) ? lengthUs : periodUs / 2;
+			PulseOutBurst(1, count, ratchetLengthUs, periodUs);
+			LedOn(1);
+			LedFade(1, 0, (count * periodUs) / 1000);
+		}
+	}
+};
+
+
+int main()
+{
+	TriggerRatchet tr;
+	tr.EnablePulseCapture();
+	tr.EnablePulseEngine();
+	tr.EnableLedEngine();
+	tr.Run();
+}
@@ -0,0 +1,254 @@
+#include "ComputerCard.h"
+#include "tusb.h"
+
+#include <hardware/flash.h>
+#include <hardware/sync.h>
+
+/*
+
+Sample player that takes new samples over USB, without rebooting
+
+Plays the same samples as the sample_upload example, uploaded the same way,
+but new samples can also be sent straight from the sample_upload page
+(generate_sample_uf2.html, "Send to card over USB") while the card runs:
+no holding the switch, BOOTSEL drive or reboot.
+
+The card is a USB vendor-class device, with a WebUSB BOS descriptor, so the
+page can open it from the browser. The page sends the samples in 4kB flash
+sectors, each checksummed; core 1 erases and programs each one as it arrives,
+while core 0 carries on with the audio, from SRAM (this example is built
+copy_to_ram). The first sector of an upload stops the voices, and erases
+the top sector of flash, holding the footer that points to the sample index,
+so that the bank is empty rather than half-written until the upload
+finishes. The top sector is sent last, and once it is written the bank
+re-reads the index and playback starts again with the new samples.
+
+Each sector takes ~50ms to erase and program, most of which is the erase,
+so uploads run at around 70kB/s, limited by the flash rather than USB.
+
+
+User interface:
+---------------
+
+Main knob:     Sample played
+Knob Y:        Playback speed (original speed at about 3 o'clock)
+Pulse in 1:    Each rising edge plays the selected sample once, on the next of three voices;
+               with nothing connected, the selected sample plays in a loop
+Audio out 1/2: Mix of all voices
+LED 4:         Lit while an upload is in progress
+LED 5:         Lit if there are no samples
+
+ */
+
+extern "C" char __flash_binary_end;
+
+class USBSampleUpload : public ComputerCard
+{
+public:
+	USBSampleUpload()
+	{
+		uploading = false;
+		audioIdle = false;
+		nextVoice = 0;
+		for (unsigned v=0; v<numVoices; v++) rateScale[v] = 0;
+
+		RunOnCore1(&USBSampleUpload::USBCore);
+	}
+
+	// Code for second RP2040 core: the USB device, and the flash writes
+	void USBCore()
+	{
+		unsigned got = 0;
+		tusb_init();
+
+		while (1)
+		{
+			tud_task();
+			if (!tud_vendor_available()) continue;
+
+			// Gather a command, then the sector following a write command
+			unsigned want = (got < sizeof(Command) || Received().cmd != CmdWrite) ? sizeof(Command) : sizeof(Command) + SectorBytes;
+			got += tud_vendor_read(rx + got, want - got);
+			if (got < sizeof(Command)) continue;
+			if (Received().cmd == CmdWrite && Received().magic == Magic && got < sizeof(Command) + SectorBytes) continue;
+
+			Reply r = Handle();
+			tud_vendor_write(&r, sizeof(r));
+			tud_vendor_write_flush();
+			got = 0;
+		}
+	}
+
+	virtual void ProcessSample()
+	{
+		// While core 1 writes to flash, nothing may read it
+		if (__atomic_load_n(&uploading, __ATOMIC_ACQUIRE))
+		{
+			if (!audioIdle)
+			{
+				for (unsigned v=0; v<numVoices; v++) voices[v].Stop();
+				__atomic_store_n(&audioIdle, true, __ATOMIC_RELEASE);
+			}
+			LedOn(4);
+			LedOff(5);
+			AudioOut1(0);
+			AudioOut2(0);
+			return;
+		}
+		LedOff(4);
+
+		unsigned numFiles = bank.Count();
+		LedOn(5, numFiles == 0);
+		if (numFiles == 0) return;
+
+		unsigned file = (numFiles * KnobVal(Main)) >> 12;
+		uint32_t speed = KnobVal(Y);
+
+		int32_t mix = 0;
+		if (Connected(Input::Pulse1))
+		{
+			if (PulseIn1RisingEdge())
+			{
+				Play(nextVoice, file, false);
+				if (++nextVoice == numVoices) nextVoice = 0;
+			}
+		}
+		else
+		{
+			// Voice 0 loops the selected sample, changing sample at the end of the loop
+			if (!voices[0].Playing() || (voices[0].Wrapped() && file != currentFile)) Play(0, file, true);
+			for (unsigned v=1; v<numVoices; v++) voices[v].Stop();
+		}
+		for (unsigned v=0; v<numVoices; v++) mix += voices[v].Next((speed * rateScale[v]) >> 16);
+
+		int32_t sample = mix >> 4; // 16-bit WAV to 12-bit DAC output
+		if (sample < -2048) sample = -2048;
+		if (sample > 2047) sample = 2047;
+		AudioOut1(sample);
+		AudioOut2(sample);
+	}
+
+private:
+	// Upload protocol, over the vendor interface's bulk endpoints, matching generate_sample_uf2.html.
+	// Each Command is answered with a Reply; CmdWrite is followed by SectorBytes of data, whose
+	// checksum (FNV-1a of its words, as the sample index's) is given in check
+	struct Command
+	{
+		uint32_t magic, cmd, address, check;
+	};
+	struct Reply
+	{
+		uint32_t magic, status, a, b;
+	};
+	static constexpr uint32_t Magic = 0x55534343; // "CCSU"
+	enum {CmdInfo = 1, CmdWrite = 2};
+	enum {StatusOK = 0, StatusBadCommand = 1, StatusBadAddress = 2, StatusBadCheck = 3};
+	static constexpr unsigned SectorBytes = FLASH_SECTOR_SIZE, PageBytes = FLASH_PAGE_SIZE;
+	static constexpr uint32_t TopSector = PICO_FLASH_SIZE_BYTES - SectorBytes;
+
+	const Command &Received() const {return *reinterpret_cast<const Command *>(rx);}
+
+	// CmdInfo replies with the flash size and the lowest address that can be written (above this firmware);
+	// CmdWrite with the address written and, after the top sector, the number of samples now in the bank
+	Reply Handle()
+	{
+		const Command &c = Received();
+		Reply r = {Magic, StatusOK, 0, 0};
+		if (c.magic != Magic)
+		{
+			r.status = StatusBadCommand;
+		}
+		else if (c.cmd == CmdInfo)
+		{
+			r.a = PICO_FLASH_SIZE_BYTES;
+			r.b = XIP_BASE + FirstFree();
+		}
+		else if (c.cmd == CmdWrite)
+		{
+			r.a = c.address;
+			r.status = WriteSector(c.address - XIP_BASE, rx + sizeof(Command), c.check, r.b);
+		}
+		else
+		{
+			r.status = StatusBadCommand;
+		}
+		return r;
+	}
+
+	uint32_t WriteSector(uint32_t offset, const uint8_t *data, uint32_t check, uint32_t &count)
+	{
+		if ((offset & (SectorBytes - 1)) || offset < FirstFree() || offset > TopSector) return StatusBadAddress;
+		if (Check(data) != check) return StatusBadCheck;
+
+		if (!audioIdle)
+		{
+			// Stop the voices, and wait for any block they queued to finish streaming from flash
+			__atomic_store_n(&uploading, true, __ATOMIC_RELEASE);
+			while (!__atomic_load_n(&audioIdle, __ATOMIC_ACQUIRE) || bank.Busy()) {}
+			Erase(TopSector);
+		}
+
+		Erase(offset);
+		for (unsigned p=0; p<SectorBytes; p+=PageBytes) Program(offset + p, data + p);
+
+		if (offset == TopSector)
+		{
+			count = bank.Reload();
+			__atomic_store_n(&audioIdle, false, __ATOMIC_RELEASE);
+			__atomic_store_n(&uploading, false, __ATOMIC_RELEASE);
+		}
+		return StatusOK;
+	}
+
+	static uint32_t FirstFree()
+	{
+		uint32_t end = reinterpret_cast<uintptr_t>(&__flash_binary_end) - XIP_BASE;
+		return (end + SectorBytes - 1) & ~(SectorBytes - 1);
+	}
+
+	static uint32_t Check(const uint8_t *data)
+	{
+		const uint32_t *w = reinterpret_cast<const uint32_t *>(data);
+		uint32_t h = 0x811C9DC5;
+		for (unsigned i=0; i<SectorBytes/4; i++) h = (h ^ w[i]) * 0x01000193;
+		return h;
+	}
+
+	void Erase(uint32_t offset)
+	{
+		uint32_t ints = save_and_disable_interrupts();
+		flash_range_erase(offset, SectorBytes);
+		restore_interrupts(ints);
+	}
+
+	void Program(uint32_t offset, const uint8_t *data)
+	{
+		uint32_t ints = save_and_disable_interrupts();
+		flash_range_program(offset, data, PageBytes);
+		restore_interrupts(ints);
+	}
+
+	void Play(unsigned v, unsigned file, bool loop)
+	{
+		voices[v].Play(bank, file, loop);
+		// (speed * rateScale) >> 16 plays at the original rate for speed 3072
+		rateScale[v] = (voices[v].SampleRate() << 16) / (48000 * 12);
+		if (v == 0) currentFile = file;
+	}
+
+	static constexpr unsigned numVoices = 3;
+
+	SampleBank bank;
+	SampleStream voices[numVoices];
+	uint32_t rateScale[numVoices];
+	unsigned nextVoice, currentFile = 0;
+	bool uploading, audioIdle;
+	alignas(4) uint8_t rx[sizeof(Command) + SectorBytes];
+};
+
+
+int main()
+{
+	static USBSampleUpload card;
+	card.Run();
+}
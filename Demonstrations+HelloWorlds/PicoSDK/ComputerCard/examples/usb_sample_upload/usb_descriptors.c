@@ -0,0 +1,236 @@
+#include "tusb.h"
+#include <pico/unique_id.h>
+
+
+/*
+  USB vendor-class device descriptors for usb_sample_upload, using serial number from RP2040 flash
+
+  The vendor interface is a pair of bulk endpoints. A BOS descriptor marks the device as
+  WebUSB-capable, and its Microsoft OS 2.0 descriptor has Windows bind the WinUSB driver to
+  the interface, so browsers can open it with no driver installed.
+ */
+
+
+#define USB_PID   0x10C1 // Music Thing Modular Workshop System Computer
+#define USB_VID   0x2E8A // Raspberry Pi
+#define USB_BCD   0x0210 // USB 2.1, for the BOS descriptor
+
+// String Descriptor Index
+enum {
+  STRING_LANGID = 0,
+  STRING_MANUFACTURER,
+  STRING_PRODUCT,
+  STRING_SERIAL,
+  STRING_LAST,
+};
+
+// array of pointer to string descriptors
+char const *string_desc_arr[] = {
+	(const char[]){ 0x09, 0x04 }, // 0: is supported language is English (0x0409)
+	"Music Thing", // 1: Manufacturer
+	"MTMComputer", // 2: Product
+	NULL, // 3: Serial number, using flash chip ID
+};
+
+
+
+// Device Descriptor
+tusb_desc_device_t const desc_device = {
+	.bLength = sizeof(tusb_desc_device_t),
+	.bDescriptorType = TUSB_DESC_DEVICE,
+	.bcdUSB = USB_BCD,
+	.bDeviceClass = 0x00,
+	.bDeviceSubClass = 0x00,
+	.bDeviceProtocol = 0x00,
+	.bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+
+	.idVendor = USB_VID,
+	.idProduct = USB_PID,
+	.bcdDevice = 0x0100,
+
+	.iManufacturer = STRING_MANUFACTURER,
+	.iProduct = STRING_PRODUCT,
+	.iSerialNumber = STRING_SERIAL,
+
+	.bNumConfigurations = 0x01
+};
+
+uint8_t const *tud_descriptor_device_cb(void)
+{
+	return (uint8_t const *)&desc_device;
+}
+
+// Configuration descriptor
+enum
+{
+	ITF_NUM_VENDOR = 0,
+	ITF_NUM_TOTAL
+};
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_VENDOR_DESC_LEN)
+
+// Endpoint number
+#define EPNUM_VENDOR 0x01
+
+uint8_t const desc_fs_configuration[] = {
+	// Config number, interface count, string index, total length, attribute, power in mA
+	TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 100),
+
+	// Interface number, string index, EP Out & EP In address, EP size
+	TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 0, EPNUM_VENDOR, 0x80 | EPNUM_VENDOR, 64)
+};
+
+#if TUD_OPT_HIGH_SPEED
+uint8_t const desc_hs_configuration[] = {
+	// Config number, interface count, string index, total length, attribute, power in mA
+	TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 100),
+
+	// Interface number, string index, EP Out & EP In address, EP size
+	TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 0, EPNUM_VENDOR, 0x80 | EPNUM_VENDOR, 512)
+};
+#endif
+
+// Invoked when received GET CONFIGURATION DESCRIPTOR
+// Application return pointer to descriptor
+// Descriptor contents must exist long enough for transfer to complete
+uint8_t const *tud_descriptor_configuration_cb(uint8_t index)
+{
+	(void)index; // for multiple configurations
+
+#if TUD_OPT_HIGH_SPEED
+	// Although we are highspeed, host may be fullspeed.
+	return (tud_speed_get() == TUSB_SPEED_HIGH) ? desc_hs_configuration : desc_fs_configuration;
+#else
+	return desc_fs_configuration;
+#endif
+}
+
+// BOS descriptor: WebUSB, with no landing page, and Microsoft OS 2.0
+enum
+{
+	VENDOR_REQUEST_WEBUSB = 1,
+	VENDOR_REQUEST_MICROSOFT = 2
+};
+
+#define BOS_TOTAL_LEN (TUD_BOS_DESC_LEN + TUD_BOS_WEBUSB_DESC_LEN + TUD_BOS_MICROSOFT_OS_DESC_LEN)
+#define MS_OS_20_DESC_LEN 0xB2
+
+uint8_t const desc_bos[] = {
+	// total length, number of device caps
+	TUD_BOS_DESCRIPTOR(BOS_TOTAL_LEN, 2),
+
+	// Vendor code, iLandingPage
+	TUD_BOS_WEBUSB_DESCRIPTOR(VENDOR_REQUEST_WEBUSB, 0),
+
+	// Microsoft OS 2.0 descriptor
+	TUD_BOS_MS_OS_20_DESCRIPTOR(MS_OS_20_DESC_LEN, VENDOR_REQUEST_MICROSOFT)
+};
+
+uint8_t const *tud_descriptor_bos_cb(void)
+{
+	return desc_bos;
+}
+
+uint8_t const desc_ms_os_20[] = {
+	// Set header: length, type, windows version, total length
+	U16_TO_U8S_LE(0x000A), U16_TO_U8S_LE(MS_OS_20_SET_HEADER_DESCRIPTOR), U32_TO_U8S_LE(0x06030000), U16_TO_U8S_LE(MS_OS_20_DESC_LEN),
+
+	// Configuration subset header: length, type, configuration index, reserved, configuration total length
+	U16_TO_U8S_LE(0x0008), U16_TO_U8S_LE(MS_OS_20_SUBSET_HEADER_CONFIGURATION), 0, 0, U16_TO_U8S_LE(MS_OS_20_DESC_LEN - 0x0A),
+
+	// Function subset header: length, type, first interface, reserved, subset length
+	U16_TO_U8S_LE(0x0008), U16_TO_U8S_LE(MS_OS_20_SUBSET_HEADER_FUNCTION), ITF_NUM_VENDOR, 0, U16_TO_U8S_LE(MS_OS_20_DESC_LEN - 0x0A - 0x08),
+
+	// Compatible ID descriptor: length, type, compatible ID, sub-compatible ID
+	U16_TO_U8S_LE(0x0014), U16_TO_U8S_LE(MS_OS_20_FEATURE_COMPATBLE_ID), 'W', 'I', 'N', 'U', 'S', 'B', 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+
+	// Registry property descriptor: length, type, property data type, property name length
+	U16_TO_U8S_LE(MS_OS_20_DESC_LEN - 0x0A - 0x08 - 0x08 - 0x14), U16_TO_U8S_LE(MS_OS_20_FEATURE_REG_PROPERTY),
+	U16_TO_U8S_LE(0x0007), U16_TO_U8S_LE(0x002A),
+	// "DeviceInterfaceGUIDs", UTF-16, null-terminated
+	'D', 0x00, 'e', 0x00, 'v', 0x00, 'i', 0x00, 'c', 0x00, 'e', 0x00, 'I', 0x00, 'n', 0x00, 't', 0x00, 'e', 0x00,
+	'r', 0x00, 'f', 0x00, 'a', 0x00, 'c', 0x00, 'e', 0x00, 'G', 0x00, 'U', 0x00, 'I', 0x00, 'D', 0x00, 's', 0x00, 0x00, 0x00,
+	// Property data length, then "{6A1F3C52-8E0B-4D7A-9C41-2B5E7F0D3A98}", UTF-16, double null-terminated
+	U16_TO_U8S_LE(0x0050),
+	'{', 0x00, '6', 0x00, 'A', 0x00, '1', 0x00, 'F', 0x00, '3', 0x00, 'C', 0x00, '5', 0x00, '2', 0x00, '-', 0x00,
+	'8', 0x00, 'E', 0x00, '0', 0x00, 'B', 0x00, '-', 0x00, '4', 0x00, 'D', 0x00, '7', 0x00, 'A', 0x00, '-', 0x00,
+	'9', 0x00, 'C', 0x00, '4', 0x00, '1', 0x00, '-', 0x00, '2', 0x00, 'B', 0x00, '5', 0x00, 'E', 0x00, '7', 0x00,
+	'F', 0x00, '0', 0x00, 'D', 0x00, '3', 0x00, 'A', 0x00, '9', 0x00, '8', 0x00, '}', 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+TU_VERIFY_STATIC(sizeof(desc_ms_os_20) == MS_OS_20_DESC_LEN, "Incorrect size");
+
+// Invoked on vendor control requests: the only one handled is for the Microsoft OS 2.0 descriptor
+bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request)
+{
+	if (stage != CONTROL_STAGE_SETUP) return true;
+
+	if (request->bmRequestType_bit.type == TUSB_REQ_TYPE_VENDOR && request->bRequest == VENDOR_REQUEST_MICROSOFT && request->wIndex == 7)
+	{
+		return tud_control_xfer(rhport, request, (void *)(uintptr_t)desc_ms_os_20, MS_OS_20_DESC_LEN);
+	}
+	return false;
+}
+
+static uint16_t _desc_str[32];
+
+// Invoked when received GET STRING DESCRIPTOR request
+// Application return pointer to descriptor, whose contents must exist long enough for transfer to complete
+uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+	(void)langid;
+
+	uint8_t chr_count;
+
+	if (index == 0)
+	{
+		memcpy(&_desc_str[1], string_desc_arr[0], 2);
+		chr_count = 1;
+	}
+	else if (index == STRING_SERIAL)
+	{
+		pico_unique_board_id_t id;
+		pico_get_unique_board_id(&id);
+		uint64_t idx = *(uint64_t *)&id.id;
+		int serialnum = ((idx + 1) % 10000000ull);
+		if (serialnum < 1000000)
+			serialnum += 1000000; // 7 digits
+		char temp[16];
+		chr_count = sprintf(temp, "%07d", serialnum);
+		for (uint8_t i = 0; i < chr_count; i++)
+		{
+			_desc_str[1 + i] = temp[i];
+		}
+	}
+	else if (index < STRING_LAST)
+	{
+		// Note: the 0xEE index string is a Microsoft OS 1.0 Descriptors.
+		// https://docs.microsoft.com/en-us/windows-hardware/drivers/usbcon/microsoft-defined-usb-descriptors
+
+		if (!(index < sizeof(string_desc_arr) / sizeof(string_desc_arr[0]))) return NULL;
+
+		const char *str = string_desc_arr[index];
+
+		// Cap at max char
+		chr_count = strlen(str);
+		if (chr_count > 31)
+		{
+			chr_count = 31;
+		}
+		// Convert ASCII string into UTF-16
+		for (uint8_t i = 0; i < chr_count; i++)
+		{
+			_desc_str[1 + i] = str[i];
+		}
+	}
+	else
+	{
+		return NULL;
+	}
+
+	// first byte is length (including header), second byte is string type
+	_desc_str[0] = (TUSB_DESC_STRING << 8) | (2 * chr_count + 2);
+
+	return _desc_str;
+}
@@ -0,0 +1,119 @@
+#include "ComputerCard.h"
+#include "wavetable_osc.h"
+#include <cmath>
+
+/*
+
+Wavetable oscillator with the tables of releases/30_cirpy_wavetable
+
+The same WAV banks (Plaits, Braids and Microwave wavetables, 64 waves of 256
+samples each) and the same controls as the CircuitPython card, but native.
+The build runs make_wavetables.py on the card's wav/ directory, which adds
+band-limited mip levels of every wave, so high notes don't alias. Any other
+waveeditonline.com tables can be added to that directory.
+
+The CircuitPython card recalculates the waveform a few dozen times a second;
+here the wavetable position, including the LFO, is applied to every sample,
+and Audio out 2 plays five voices at once.
+
+
+User interface:
+---------------
+
+Main knob:     Wavetable position
+Knob X:        Amount of triangle LFO added to wavetable position
+Knob Y:        LFO rate, 0.01 to 10Hz
+Switch down:   Next wavetable bank
+Switch up:     Toggles quantising CV 1 in to semitones
+CV 1 in:       Pitch, 1V/oct, from C2 (MIDI note 36)
+CV 2 in:       Adds to wavetable position
+Audio out 1:   Oscillator
+Audio out 2:   Five detuned oscillators
+CV 1 out:      Wavetable position
+CV 2 out:      LFO
+LEDs:          LFO, knob X, knob Y, -, CV 1 in, CV 2 in
+
+ */
+
+class Wavetable : public ComputerCard
+{
+	static constexpr int numUnison = 5;
+	static constexpr float detune[numUnison] = {1.0f, 1.003f, 0.997f, 1.0071f, 0.9931f};
+
+	WavetableBank bank;
+	WavetableVoice voice, unison[numUnison];
+	uint32_t lfoPhase, lfoIncrement;
+	bool quantise;
+
+public:
+	Wavetable()
+	{
+		lfoPhase = lfoIncrement = 0;
+		quantise = true;
+		for (int i=0; i<numUnison; i++) unison[i].SetPhase(uint32_t(i) * 0x3456789u);
+		EnableControlRate(32);
+	}
+
+	virtual void ProcessControl()
+	{
+		if (Changed(ChangedSwitch))
+		{
+			if (SwitchVal() == Switch::Down) bank.Select((bank.Selected() + 1) % wavetables::numBanks);
+			if (SwitchVal() == Switch::Up) quantise = !quantise;
+		}
+
+		// CV of 2047 is about +6V
+		float note = 36.0f + CVIn1() * (72.0f / 2048.0f);
+		if (quantise) note = floorf(note + 0.5f);
+		float freq = 440.0f * exp2f((note - 69.0f) * (1.0f / 12.0f));
+		if (freq > 12000.0f) freq = 12000.0f;
+
+		// Increment = 2^32 * freq / 48000
+		float inc = freq * (4294967296.0f / 48000.0f);
+		voice.SetIncrement(uint32_t(inc));
+		for (int i=0; i<numUnison; i++) unison[i].SetIncrement(uint32_t(inc * detune[i]));
+
+		// LFO at 0.01 to 10Hz, exponential in knob Y
+		lfoIncrement = uint32_t(0.01f * exp2f(KnobVal(Knob::Y) * (9.97f / 4096.0f)) * (4294967296.0f / 48000.0f));
+
+		LedBrightness(1, uint16_t(KnobVal(Knob::X)));
+		LedBrightness(2, uint16_t(KnobVal(Knob::Y)));
+		LedBrightness(4, uint16_t(CVIn1() < 0 ? 0 : 2 * CVIn1()));
+		LedBrightness(5, uint16_t(CVIn2() < 0 ? 0 : 2 * CVIn2()));
+	}
+
+	virtual void ProcessSample()
+	{
+		// Triangle LFO, -2048 to 2047
+		lfoPhase += lfoIncrement;
+		int32_t lfo = int32_t(lfoPhase >> 19) - 4096;
+		lfo = (lfo < 0 ? -lfo : lfo) - 2048;
+		if (lfo > 2047) lfo = 2047;
+
+		// Knob sets position across the bank; LFO up to +-1/8 and CV 2 up to +-1/4 of it
+		int32_t waves = bank.Waves() - 1;
+		int32_t pos = KnobVal(Knob::Main) * waves * 16
+			+ ((lfo * KnobVal(Knob::X)) >> 12) * waves * 4
+			+ CVIn2() * waves * 8;
+		if (pos < 0) pos = 0;
+		if (pos > int32_t(bank.MaxPosition())) pos = int32_t(bank.MaxPosition());
+
+		int32_t out1 = voice.Next(bank, uint32_t(pos));
+		int32_t out2 = 0;
+		for (int i=0; i<numUnison; i++) out2 += unison[i].Next(bank, uint32_t(pos));
+
+		AudioOut1(out1 >> 4);
+		AudioOut2((out2 * 12) >> 10); // divided by about five, and Q15 to 12 bits
+
+		CVOut1(int16_t((pos / (waves > 0 ? waves : 1) >> 4) - 2048));
+		CVOut2(int16_t(lfo));
+		LedBrightness(0, uint16_t(lfo + 2048));
+	}
+};
+
+
+int main()
+{
+	static Wavetable card;
+	card.Run();
+}
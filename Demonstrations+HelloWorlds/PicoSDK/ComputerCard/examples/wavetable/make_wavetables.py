@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Build band-limited wavetable banks for the wavetable example, as a C++ header
+
+    make_wavetables.py wavetables.h 10_PLAITS02.WAV 20_PLAITS01.WAV ...
+
+Each WAV file (16-bit mono, as in releases/30_cirpy_wavetable/wav and on
+waveeditonline.com) is a bank of single-cycle waves of 256 samples, up to 64 of
+them. For each wave, mip level 0 is the wave as it is (up to 128 harmonics), and
+each level above it keeps half the harmonics of the one below, down to the
+fundamental at level 7, so that a wave played at any pitch can be read from a
+level with no harmonics above the Nyquist frequency.
+
+Each bank is written as [level][sample][wave]: the same sample of every wave is
+adjacent, so that the card's interpolator morphs between neighbouring waves as it
+reads. Banks with fewer than 64 waves repeat their last wave.
+"""
+
+import cmath
+import os
+import struct
+import sys
+import wave
+
+WAVE_LENGTH = 256
+NUM_WAVES = 64
+NUM_LEVELS = 8
+
+
+def fft(x, inverse=False):
+    """Radix-2 FFT of a list of complex numbers"""
+    n = len(x)
+    if n == 1:
+        return list(x)
+    sign = 1 if inverse else -1
+    even = fft(x[0::2], inverse)
+    odd = fft(x[1::2], inverse)
+    out = [0j] * n
+    for k in range(n // 2):
+        t = cmath.exp(sign * 2j * cmath.pi * k / n) * odd[k]
+        out[k] = even[k] + t
+        out[k + n // 2] = even[k] - t
+    return out
+
+
+def band_limit(spectrum, harmonics):
+    """Samples of a wave with only harmonics up to the given number"""
+    n = len(spectrum)
+    kept = [spectrum[k] if k <= harmonics or k >= n - harmonics else 0j for k in range(n)]
+    return [int(round(min(max(v.real / n, -32768), 32767))) for v in fft(kept, inverse=True)]
+
+
+def read_bank(path):
+    with wave.open(path, 'rb') as w:
+        if w.getsampwidth() != 2 or w.getnchannels() != 1:
+            sys.exit('%s: only 16-bit mono WAV files are supported' % path)
+        frames = w.readframes(w.getnframes())
+    samples = struct.unpack('<%dh' % (len(frames) // 2), frames)
+    count = min(len(samples) // WAVE_LENGTH, NUM_WAVES)
+    if count == 0:
+        sys.exit('%s: shorter than one %d-sample wave' % (path, WAVE_LENGTH))
+    return [list(samples[i * WAVE_LENGTH:(i + 1) * WAVE_LENGTH]) for i in range(count)]
+
+
+def mip_levels(samples):
+    """The wave at each mip level, level 0 being the wave itself"""
+    spectrum = fft([complex(s) for s in samples])
+    levels = [samples]
+    for level in range(1, NUM_LEVELS):
+        levels.append(band_limit(spectrum, (WAVE_LENGTH // 2) >> level))
+    return levels
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(__doc__)
+    out_path, wav_paths = sys.argv[1], sys.argv[2:]
+
+    banks = []
+    for path in wav_paths:
+        waves = read_bank(path)
+        count = len(waves)
+        waves += [waves[-1]] * (NUM_WAVES - count)
+        levels = [mip_levels(w) for w in waves]
+        data = []
+        for level in range(NUM_LEVELS):
+            for i in range(WAVE_LENGTH):
+                data.extend(levels[w][level][i] for w in range(NUM_WAVES))
+        name = os.path.splitext(os.path.basename(path))[0]
+        banks.append((name, count, data))
+
+    with open(out_path, 'w') as f:
+        f.write('// Generated by make_wavetables.py from %s\n' % ', '.join(os.path.basename(p) for p in wav_paths))
+        f.write('#pragma once\n#include <cstdint>\n\nnamespace wavetables\n{\n')
+        f.write('constexpr int numBanks = %d, numWaves = %d, waveLength = %d, numLevels = %d;\n\n'
+                % (len(banks), NUM_WAVES, WAVE_LENGTH, NUM_LEVELS))
+        f.write('const char *const bankNames[numBanks] = {%s};\n' % ', '.join('"%s"' % b[0] for b in banks))
+        f.write('const uint8_t bankWaves[numBanks] = {%s};\n\n' % ', '.join(str(b[1]) for b in banks))
+        f.write('// [bank][level][sample][wave]\n')
+        f.write('const int16_t data[numBanks][numLevels * waveLength * numWaves] = {\n')
+        for name, count, data in banks:
+            f.write('{\n')
+            for i in range(0, len(data), 32):
+                f.write(','.join(str(v) for v in data[i:i + 32]) + ',\n')
+            f.write('},\n')
+        f.write('};\n}\n')
+
+
+if __name__ == '__main__':
+    main()
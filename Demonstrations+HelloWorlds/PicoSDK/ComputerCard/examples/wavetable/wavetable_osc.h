@@ -0,0 +1,81 @@
+#ifndef WAVETABLE_OSC_H
+#define WAVETABLE_OSC_H
+
+#include "ComputerCard.h"
+#include "wavetables.h" // generated by make_wavetables.py
+
+/** \brief One bank of wavetables.h, read through the interpolators
+
+	A bank is 2^17 samples: [level][sample][wave], 8 levels of 256 samples of 64 waves.
+	With the waves of each sample adjacent, the interpolator's blend morphs between two
+	neighbouring waves in the same read that looks up the sample. One bank is shared by
+	all voices, so the interpolators are only reconfigured when the bank changes.
+*/
+class WavetableBank
+{
+	static_assert(wavetables::numLevels == 8 && wavetables::waveLength == 256 && wavetables::numWaves == 64,
+				  "WavetableBank: wavetables.h must have 8 levels of 256 samples of 64 waves");
+public:
+	WavetableBank() : reader(wavetables::data[0]), bank(0) {}
+
+	void Select(int b)
+	{
+		bank = b;
+		reader.SetBuffer(wavetables::data[b]);
+	}
+	int Selected() const {return bank;}
+
+	/// Number of waves in the bank, which morph positions span
+	int Waves() const {return wavetables::bankWaves[bank];}
+
+	/// Highest morph position (Q16 waves) of the bank
+	uint32_t MaxPosition() const {return uint32_t(Waves() - 1) << 16;}
+
+	/// Sample s (0-255) of mip level, morphed to position pos (Q16 waves, up to MaxPosition), in 1/256ths between waves
+	int32_t __not_in_flash_func(Read)(int level, uint32_t s, uint32_t pos)
+	{
+		uint32_t index = (uint32_t(level) << 14) | (s << 6) | (pos >> 16);
+		return reader.Read((index << 15) | ((pos & 0xFFFF) >> 1));
+	}
+
+private:
+	ComputerCard::InterpReader<17, 15> reader;
+	int bank;
+};
+
+/** \brief Wavetable voice, reading a WavetableBank at any morph position
+
+	The mip level is chosen from the pitch, so that no harmonic is above the Nyquist
+	frequency: level k, with 128 >> k harmonics, for increments up to 2^(24 + k), i.e.
+	up to 187.5Hz << k at 48kHz. The morph position can change every sample.
+*/
+class WavetableVoice
+{
+public:
+	/// Phase increment per sample, 2^32 * frequency / sample rate
+	void SetIncrement(uint32_t inc)
+	{
+		increment = inc;
+		level = inc <= (1u << 24) ? 0 : 32 - __builtin_clz(inc - 1) - 24;
+		if (level > 7) level = 7;
+	}
+
+	/// Next sample, Q15, at morph position pos (Q16 waves, up to bank.MaxPosition())
+	int32_t __not_in_flash_func(Next)(WavetableBank &bank, uint32_t pos)
+	{
+		uint32_t s = phase >> 24;
+		int32_t a = bank.Read(level, s, pos);
+		int32_t b = bank.Read(level, (s + 1) & 0xFF, pos);
+		int32_t frac = (phase >> 10) & 0x3FFF;
+		phase += increment;
+		return a + (((b - a) * frac) >> 14);
+	}
+
+	void SetPhase(uint32_t p) {phase = p;}
+
+private:
+	uint32_t phase = 0, increment = 0;
+	int level = 0;
+};
+
+#endif
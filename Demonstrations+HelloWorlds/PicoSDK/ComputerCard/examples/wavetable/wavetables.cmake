@@ -0,0 +1,19 @@
+# Generates wavetables.h, with band-limited mip levels, from a directory of wavetable WAV files,
+# and adds it to a card. Needs Python 3, as does the Pico SDK.
+#   add_wavetables(wavetable ${RELEASES_DIR}/30_cirpy_wavetable/wav)
+set(WAVETABLES_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/make_wavetables.py)
+
+function (add_wavetables _name _wav_dir)
+	find_package(Python3 REQUIRED COMPONENTS Interpreter)
+	file(GLOB _wavs ${_wav_dir}/*.wav ${_wav_dir}/*.WAV)
+	list(REMOVE_DUPLICATES _wavs)
+	list(SORT _wavs)
+	set(_dir ${CMAKE_CURRENT_BINARY_DIR}/${_name}_wavetables)
+	add_custom_command(OUTPUT ${_dir}/wavetables.h
+		COMMAND ${CMAKE_COMMAND} -E make_directory ${_dir}
+		COMMAND ${Python3_EXECUTABLE} ${WAVETABLES_SCRIPT} ${_dir}/wavetables.h ${_wavs}
+		DEPENDS ${WAVETABLES_SCRIPT} ${_wavs}
+		VERBATIM)
+	target_sources(${_name} PRIVATE ${_dir}/wavetables.h)
+	target_include_directories(${_name} PRIVATE ${_dir})
+endfunction()
@@ -0,0 +1,32 @@
+# Fail the build of a card that uses the heap, for the COMPUTERCARD_NO_HEAP build option.
+#
+# Run after linking, with
+#   cmake -DNM=<path to nm> -DELF=<card.elf> -P heap_check.cmake
+#
+# The linker only keeps the allocator if something calls it, so any of its entry points
+# in the image means a call to malloc, calloc, realloc or operator new somewhere in the
+# card, ComputerCard or a library. The ELF is deleted, so that the card is relinked (and
+# checked again) by the next build. See static_alloc.h for alternatives.
+
+execute_process(COMMAND ${NM} --defined-only ${ELF}
+	OUTPUT_VARIABLE symbols
+	RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+	message(FATAL_ERROR "heap_check: could not read symbols from ${ELF}")
+endif()
+
+set(allocators "")
+string(REPLACE "\n" ";" lines "${symbols}")
+foreach (line IN LISTS lines)
+	# malloc and friends, their reentrant and Pico SDK (--wrap) versions, and operator new (_Znwj, _Znaj)
+	if (line MATCHES " [A-Za-z] ((__wrap_|_)?(malloc|calloc|realloc)(_r)?|_Zn[aw]j.*)$")
+		list(APPEND allocators ${CMAKE_MATCH_1})
+	endif()
+endforeach()
+
+if (allocators)
+	get_filename_component(card ${ELF} NAME_WE)
+	file(REMOVE ${ELF})
+	list(JOIN allocators ", " names)
+	message(FATAL_ERROR "${card} uses the heap (${names}), but is built with COMPUTERCARD_NO_HEAP")
+endif()
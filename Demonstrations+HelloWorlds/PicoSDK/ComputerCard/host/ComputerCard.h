@@ -0,0 +1,5408 @@
+/*
+ComputerCard host backend
+
+version 0.3.0  -  unreleased
+
+Drop-in replacement for ComputerCard.h that compiles the same card classes
+natively on a desktop/build machine (Linux, macOS), for offline rendering,
+benchmarking and regression testing of card DSP code.
+
+Instead of running forever from an audio-rate interrupt, Run() renders a fixed
+length of audio as fast as possible, then returns:
+- Audio inputs are read from a WAV file (16-bit PCM, 1 or 2 channels)
+- Knobs, switch, CV and pulse inputs are read from a CSV automation file
+- Outputs are written to a 6-channel 16-bit WAV file, in the order
+  Audio 1, Audio 2, CV 1, CV 2, Pulse 1, Pulse 2
+- Time taken per sample is reported on stderr
+
+The input/output files are set either by the Host() configuration struct,
+before Run() is called, or by the environment variables
+	COMPUTERCARD_IN         input WAV file
+	COMPUTERCARD_OUT        output WAV file
+	COMPUTERCARD_CONTROL    CSV automation file
+	COMPUTERCARD_SECONDS    length to render, if no input WAV file (default 10)
+	COMPUTERCARD_SAMPLES    sample UF2 file, from examples/sample_upload, for SampleBank
+	COMPUTERCARD_LOCKSTEP   1 to run RunOnCore1's thread in lockstep with the audio (see below)
+	COMPUTERCARD_REPLAY     control recording, from RecordingWrite, to replay instead of the CSV file
+	COMPUTERCARD_RECORD_OUT file to write a recording of the control inputs to, as RecordingWrite
+	COMPUTERCARD_LINK_IN    WAV file of frames received by EnableAudioLink
+	COMPUTERCARD_LINK_OUT   WAV file to write the frames sent by EnableAudioLink to
+
+The CSV automation file has a header row naming its columns, the first of
+which is 'time' (in seconds). Other columns may be any of
+	main, x, y           knob values, 0-4095
+	switch               0 = Down, 1 = Middle, 2 = Up
+	cv1, cv2             CV input values, -2048 to 2047
+	pulse1, pulse2       pulse input values, 0 or 1
+Knob and CV values are linearly interpolated between rows; switch and
+pulse values change at the row time. Inputs not mentioned in the CSV file
+are left at knobs half-way, switch in the middle, and CV/pulses zero.
+
+Audio inputs are reported as Connected if an input WAV file is given;
+CV/pulse inputs are Connected if they have a column in the CSV file.
+
+A control recording, made on the card with COMPUTERCARD_RECORD, sets the
+knobs, switch, CV and pulse inputs and jack connections to the values the
+card saw, sample for sample (or block for block, so the card must be built
+with the same COMPUTERCARD_BLOCK_SIZE), and without the input smoothing,
+which the card applied before recording them. Without an input WAV file,
+the render lasts as long as the card had run when the recording was written. If the card's ring had
+wrapped, inputs keep the values of the oldest recorded sample until then.
+
+Built with COMPUTERCARD_SOAK defined, as on the card, the stress generator
+drives every input in place of the input files and automation, and the soak
+report (SoakReportWrite) is written to stderr after rendering, so that hours
+of worst-case input can be rendered quickly, e.g. under a sanitizer.
+
+RunOnCore1 starts a second thread, which normally runs freely alongside the
+render, so output that depends on how far ahead the second core has got
+varies from run to run. In lockstep, the two threads take turns instead:
+every 32 samples (or block, if longer), the second core runs until it has
+made 1024 calls to Ring functions or tight_loop_contents (usually, until it
+is waiting for the audio core), and its sleeps last the given time in
+rendered audio. Output is then
+the same on every run, as regression.cmake needs. A second core that waits
+for the audio core in any other way would stop the render.
+
+Build with the host/ directory on the include path ahead of the directory
+containing the card, e.g. `c++ -O2 -I host card.cpp`, or see
+host/CMakeLists.txt.
+*/
+
+
+#ifndef COMPUTERCARD_H
+#define COMPUTERCARD_H
+
+#include "pico_host.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define PULSE_1_RAW_OUT 8
+#define PULSE_2_RAW_OUT 9
+
+#define CV_OUT_1 23
+#define CV_OUT_2 22
+
+// USB host status pin
+#define USB_HOST_STATUS 20
+
+#ifndef COMPUTERCARD_BLOCK_SIZE
+#define COMPUTERCARD_BLOCK_SIZE 1
+#endif
+
+// RunOnCore1 is always available, running on a second thread
+#define COMPUTERCARD_HAS_MULTICORE 1
+
+// Sequencer is available when compiled as C++20 or later, with coroutines
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define COMPUTERCARD_HAS_COROUTINES 1
+#endif
+
+class ComputerCard
+{
+	constexpr static int numLeds = 6;
+public:
+
+	/// Knob index, used by KnobVal
+	enum Knob {Main, X, Y};
+	/// Switch position, used by SwitchVal
+	enum Switch {Down, Middle, Up};
+	/// Input jack socket, used by Connected and Disconnected
+	enum Input {Audio1, Audio2, CV1, CV2, Pulse1, Pulse2};
+	/// Hardware version
+	enum HardwareVersion_t {Proto1=0x2a, Proto2_Rev1=0x30, Rev1_1=0x0C, Unknown=0xFF};
+	/// USB Power state
+	enum USBPowerState_t {DFP, UFP, Unsupported};
+	/// Audio sample rate, used by Run
+	enum SampleRate_t {SR24kHz = 24000, SR48kHz = 48000, SR96kHz = 96000};
+
+	/// Number of frames per ProcessBlock call, set by COMPUTERCARD_BLOCK_SIZE
+	constexpr static int blockSize = COMPUTERCARD_BLOCK_SIZE;
+	static_assert(blockSize > 0 && (blockSize & (blockSize - 1)) == 0 && blockSize <= 256,
+				  "COMPUTERCARD_BLOCK_SIZE must be a power of two, at most 256");
+
+	/// Statistics collected by the load meter, see EnableLoadMeter.
+	/// On the host, 'cycles' are nanoseconds.
+	struct LoadStats
+	{
+		uint32_t minCycles;
+		uint32_t avgCycles;
+		uint32_t maxCycles;
+		uint32_t budgetCycles;
+		uint32_t overruns;
+	};
+
+	/// State of the sample clock sync, see EnableSyncFollow
+	struct SyncStats
+	{
+		bool locked;           ///< The last 16 edges were all within 1/8 sample of their expected time
+		int32_t phaseError;    ///< Last edge's time from the expected, in 1/65536ths of a sample (positive: this card was ahead)
+		int32_t trimPPM;       ///< Trim the card would make, in parts per million (positive: slowed down)
+		uint32_t realigns;     ///< Times SyncFrame has been reset to the leader's count
+	};
+
+	/// State of the audio link, see EnableAudioLink
+	struct LinkStats
+	{
+		bool connected;        ///< Frames are arriving, and LinkIn is playing them
+		uint32_t frames;       ///< Frames received intact
+		uint32_t errors;       ///< Frames lost or corrupted on the way, or not sent in time
+		uint32_t slips;        ///< Frames dropped or missed to keep the latency, as the two sample clocks drift
+		int32_t queued;        ///< Frames waiting behind the one LinkIn is playing, normally the latency
+	};
+
+	/// Result of a latency measurement, see MeasureLatency
+	struct LatencyStats
+	{
+		bool done;             ///< The measurement has finished
+		bool found;            ///< Every step came back on the input
+		bool inverted;         ///< The steps came back inverted
+		int32_t samplesQ8;     ///< Latency, averaged over the steps, in 1/256ths of a sample
+		int32_t spreadQ8;      ///< Largest less smallest latency of the steps, in 1/256ths of a sample
+		uint32_t us;           ///< Latency, in microseconds
+	};
+
+	/// One frame of audio, used by ProcessBlock. audio[0] is Audio 1, audio[1] is Audio 2 (-2048 to 2047)
+	struct alignas(4) Frame
+	{
+		int16_t audio[2];
+	};
+
+	/// Copy of the inputs for one sample (or block), read by the input functions of ComputerCardT cards
+	struct Inputs
+	{
+		int32_t knobs[4];
+		int16_t audio[2];
+		int16_t cv[2], cvFast[2];
+		bool pulse[2], lastPulse[2];
+		bool connected[6];
+		Switch switchVal, lastSwitchVal;
+	};
+
+	/// One MIDI message (not sysex), as queued by QueueMIDI and passed to ProcessMIDI
+	struct MIDIEvent
+	{
+		uint32_t sample;
+		uint8_t cable;
+		uint8_t length;
+		uint8_t data[3];
+	};
+
+	/** \brief Parameter linearly interpolated across one control period, see EnableControlRate
+
+		Call Set() from ProcessControl with a new target (-32767 to 32767),
+		and Next() once per sample from ProcessSample/ProcessBlock to read
+		a value that ramps to the target by the next ProcessControl call.
+	*/
+	class Smoothed
+	{
+	public:
+		Smoothed(int32_t initial = 0) : value(initial << 16), step(0), remaining(0), target(initial) {}
+
+		/// Set new target value, reached after one control period
+		void Set(int32_t newTarget)
+		{
+			target = newTarget;
+			step = int32_t(((int64_t(newTarget) << 16) - value) >> ComputerCard::controlShift);
+			remaining = 1 << ComputerCard::controlShift;
+		}
+
+		/// Jump immediately to a value, without interpolation
+		void Reset(int32_t newValue)
+		{
+			target = newValue;
+			value = newValue << 16;
+			remaining = 0;
+		}
+
+		/// Advance by one sample and return the interpolated value
+		int32_t __not_in_flash_func(Next)()
+		{
+			if (remaining)
+			{
+				if (--remaining) value += step;
+				else value = target << 16;
+			}
+			return value >> 16;
+		}
+
+		/// Return current interpolated value, without advancing
+		int32_t Value() const {return value >> 16;}
+
+		/// Return target value, as given to Set
+		int32_t Target() const {return target;}
+
+	private:
+		int32_t value, step, remaining, target;
+	};
+
+	/** \brief 11-tap half-band lowpass, for resampling by two, as used by EnableSubRate
+
+		Decimate takes two samples and returns one at half the rate; Interpolate takes one
+		and returns two at twice the rate. Either way, the filter is flat to within 0.15dB
+		up to 0.15 of the higher rate (7.2kHz at 48kHz), and at least 35dB down from 0.35
+		of it, so cascades of them, one per halving, are clean up to about 0.3 of the
+		lower rate. Half the taps of a half-band filter are zero, and of the rest, all but
+		the centre tap are in one polyphase branch, so each costs three multiplies per
+		sample at the lower rate. Samples are int32_t, of up to 16 bits; the gain is one,
+		and the delay five samples at the higher rate.
+	*/
+	class HalfBand
+	{
+	public:
+		HalfBand() {Reset();}
+
+		/// Two samples in, oldest first, and one out at half the rate
+		int32_t __not_in_flash_func(Decimate)(int32_t x0, int32_t x1)
+		{
+			for (int i=5; i>0; i--) odd[i] = odd[i-1];
+			odd[0] = x1;
+			int32_t centre = even[1];
+			even[1] = even[0];
+			even[0] = x0;
+			return (Taps(odd) + (centre << 14) + 16384) >> 15;
+		}
+
+		/// One sample in, and two out at twice the rate, oldest first
+		void __not_in_flash_func(Interpolate)(int32_t x, int32_t &y0, int32_t &y1)
+		{
+			for (int i=5; i>0; i--) odd[i] = odd[i-1];
+			odd[0] = x;
+			y0 = (Taps(odd) + 8192) >> 14;
+			y1 = odd[2];
+		}
+
+		/// Clear the filter's history
+		void Reset()
+		{
+			for (int i=0; i<6; i++) odd[i] = 0;
+			even[0] = even[1] = 0;
+		}
+
+	private:
+		// Non-zero taps either side of the centre (0.5), Q15, summing to a quarter
+		static constexpr int32_t c1 = 9937, c3 = -2173, c5 = 428;
+
+		static int32_t Taps(const int32_t *h) {return c1 * (h[2] + h[3]) + c3 * (h[1] + h[4]) + c5 * (h[0] + h[5]);}
+
+		int32_t odd[6], even[2];
+	};
+
+	/** \brief Unsigned 32-bit divide, started now and collected later
+
+		Uses the RP2040 SIO hardware divider on the card; on the host, the divide is done in Start().
+	*/
+	class Divider
+	{
+	public:
+		Divider() : quotient(0) {}
+
+		/// Start calculating num / den (den must not be zero)
+		void __not_in_flash_func(Start)(uint32_t num, uint32_t den)
+		{
+			quotient = num / den;
+		}
+
+		/// Return the quotient of the last Start
+		uint32_t __not_in_flash_func(Result)()
+		{
+			return quotient;
+		}
+
+	private:
+		uint32_t quotient;
+	};
+
+	/** \brief Linear ramp to a target over a given number of samples
+
+		Like Smoothed, but each ramp has its own length, e.g. the time since the last clock pulse.
+		SetTarget() starts the divide for the ramp step on the hardware divider, and the
+		following Next() collects it, so setting a new target costs no divide wait.
+		Values are -32767 to 32767.
+	*/
+	class Slew
+	{
+	public:
+		Slew(int32_t initial = 0) : value(initial << 16), step(0), remaining(0), target(initial), negative(false), stepPending(false) {}
+
+		/// Ramp from the current value to newTarget over the next samples calls to Next()
+		void __not_in_flash_func(SetTarget)(int32_t newTarget, uint32_t samples)
+		{
+			target = newTarget;
+			if (samples == 0)
+			{
+				Reset(newTarget);
+				return;
+			}
+			int64_t diff = (int64_t(newTarget) << 16) - value;
+			negative = diff < 0;
+			div.Start(uint32_t(negative ? -diff : diff), samples);
+			stepPending = true;
+			remaining = samples;
+		}
+
+		/// Jump immediately to a value, without a ramp
+		void Reset(int32_t newValue)
+		{
+			target = newValue;
+			value = newValue << 16;
+			remaining = 0;
+			stepPending = false;
+		}
+
+		/// Advance by one sample and return the ramped value
+		int32_t __not_in_flash_func(Next)()
+		{
+			if (remaining)
+			{
+				if (stepPending)
+				{
+					step = int32_t(div.Result());
+					if (negative) step = -step;
+					stepPending = false;
+				}
+				if (--remaining) value += step;
+				else value = target << 16;
+			}
+			return value >> 16;
+		}
+
+		/// Return current value, without advancing
+		int32_t Value() const {return value >> 16;}
+
+		/// Return target value, as given to SetTarget
+		int32_t Target() const {return target;}
+
+		/// True while a ramp is in progress
+		bool Ramping() const {return remaining != 0;}
+
+	private:
+		Divider div;
+		int32_t value, step;
+		uint32_t remaining;
+		int32_t target;
+		bool negative, stepPending;
+	};
+
+	/** \brief Parameter ramp worked out once per block, and read per sample with a single add
+
+		Give the ramp a target with SetLinear, SetExponential or SetTarget. Then, at the start of
+		each block, call Block(n) to work out the step for the block's n samples, and Next() n
+		times to read them. Next() has no branches or divides; Block() divides by n with a shift
+		when n is a power of two (as blockSize is), or on the hardware divider otherwise.
+		- SetLinear(target): reach target by the end of the next block
+		- SetExponential(target, shift): each block, move 2^-shift of the way to target (a
+		  one-pole filter at the block rate), ramping linearly across the block
+		- SetTarget(target, samples): reach target after samples samples, however many blocks
+		  that spans. A ramp ending part way through a block finishes at the end of that block;
+		  with blocks of one sample, this gives exactly the values of a Slew.
+		Values are -32767 to 32767.
+	*/
+	class Ramp
+	{
+	public:
+		Ramp(int32_t initial = 0) : value(initial << 16), step(0), overStep(0), remaining(0), target(initial), shift(0), mode(Hold), negative(false), stepPending(false), landing(false) {}
+
+		/// Ramp from the current value to newTarget over the next block
+		void SetLinear(int32_t newTarget)
+		{
+			Land();
+			target = newTarget;
+			mode = Linear;
+		}
+
+		/// Approach newTarget, by 2^-newShift of the remaining distance each block
+		void SetExponential(int32_t newTarget, int newShift)
+		{
+			Land();
+			target = newTarget;
+			shift = newShift;
+			mode = Exponential;
+		}
+
+		/// Ramp from the current value to newTarget over the next samples samples
+		void __not_in_flash_func(SetTarget)(int32_t newTarget, uint32_t samples)
+		{
+			if (samples == 0)
+			{
+				Reset(newTarget);
+				return;
+			}
+			Land();
+			target = newTarget;
+			int64_t diff = (int64_t(newTarget) << 16) - value;
+			negative = diff < 0;
+			div.Start(uint32_t(negative ? -diff : diff), samples);
+			stepPending = true;
+			remaining = samples;
+			mode = Samples;
+		}
+
+		/// Jump immediately to a value, without a ramp
+		void Reset(int32_t newValue)
+		{
+			target = newValue;
+			value = newValue << 16;
+			step = 0;
+			remaining = 0;
+			mode = Hold;
+			stepPending = false;
+			landing = false;
+		}
+
+		/// Work out the next n values, to be read with Next()
+		void __not_in_flash_func(Block)(uint32_t n)
+		{
+			Land();
+			step = 0;
+			if (mode == Hold) return;
+
+			int64_t diff = (int64_t(target) << 16) - value;
+			if (mode == Samples)
+			{
+				if (stepPending)
+				{
+					overStep = int32_t(div.Result());
+					if (negative) overStep = -overStep;
+					stepPending = false;
+				}
+				if (remaining > n)
+				{
+					remaining -= n;
+					step = overStep;
+					return;
+				}
+			}
+			else if (mode == Exponential)
+			{
+				// Until the step gets too small to move
+				step = Divide(diff >> shift, n);
+				if (step > 0 || step < -1) return;
+			}
+
+			// Reach the target by the end of this block
+			step = Divide(diff, n);
+			remaining = 0;
+			mode = Hold;
+			landing = true;
+		}
+
+		/// Advance by one sample and return the ramped value
+		int32_t Next()
+		{
+			value += step;
+			return value >> 16;
+		}
+
+		/// Return current value, without advancing
+		int32_t Value() const {return value >> 16;}
+
+		/// Return target value
+		int32_t Target() const {return target;}
+
+		/// True while a ramp is in progress (including its last block)
+		bool Ramping() const {return mode != Hold || landing;}
+
+	private:
+		enum Mode {Hold, Linear, Exponential, Samples};
+
+		// The last block of a ramp can fall short of the target by what the divide dropped
+		void Land()
+		{
+			if (landing)
+			{
+				value = target << 16;
+				landing = false;
+			}
+		}
+
+		// diff / n, to within one unit
+		int32_t __not_in_flash_func(Divide)(int64_t diff, uint32_t n)
+		{
+			if ((n & (n - 1)) == 0)
+			{
+				int s = 0;
+				while ((1u << s) < n) s++;
+				return int32_t(diff >> s);
+			}
+			bool neg = diff < 0;
+			div.Start(uint32_t(neg ? -diff : diff), n);
+			int32_t q = int32_t(div.Result());
+			return neg ? -q : q;
+		}
+
+		Divider div;
+		int32_t value, step, overStep;
+		uint32_t remaining;
+		int32_t target;
+		int shift;
+		Mode mode;
+		bool negative, stepPending, landing;
+	};
+
+	/** \brief Measures the period of a clock, e.g. a pulse input, in samples
+
+		Call Tick() once per sample (or Tick(n) once per block of n samples), and Clock() on each
+		rising edge. Period() is the latest interval between edges; SmoothedPeriod() averages
+		out jitter (an interval differing by more than a quarter from the average is taken as a
+		tempo change, and replaces it). Gaps longer than maxPeriodSamples are clamped to maxPeriod.
+		PhaseIncrement() gives the matching oscillator rate, with its divide started on the
+		hardware divider by Clock() and collected when first read.
+	*/
+	class ClockTracker
+	{
+	public:
+		ClockTracker(uint32_t maxPeriodSamples = 1u << 20) : maxPeriod(maxPeriodSamples), since(0), period(0), smoothed8(0), edges(0), inc(0), incPending(false) {}
+
+		/// Advance by n samples
+		void __not_in_flash_func(Tick)(uint32_t n = 1)
+		{
+			since += n;
+			if (since > maxPeriod) since = maxPeriod;
+		}
+
+		/// Register a clock edge, returning the interval since the previous one (0 for the first edge)
+		uint32_t __not_in_flash_func(Clock)()
+		{
+			uint32_t p = since;
+			since = 0;
+			if (edges < 2) edges++;
+			if (edges < 2) return 0;
+			if (p == 0) p = 1;
+			period = p;
+
+			uint32_t p8 = p << 8;
+			uint32_t s8 = smoothed8;
+			uint32_t d8 = (p8 > s8) ? p8 - s8 : s8 - p8;
+			if (smoothed8 == 0 || d8 > (s8 >> 2)) smoothed8 = p8;
+			else smoothed8 = (p8 > s8) ? s8 + (d8 >> smoothShift) : s8 - (d8 >> smoothShift);
+
+			div.Start(0xFFFFFFFFu, SmoothedPeriod());
+			incPending = true;
+			return p;
+		}
+
+		/// True once two edges have been seen, so a period is known
+		bool Valid() const {return edges >= 2;}
+		/// Latest interval between edges, in samples (0 until Valid)
+		uint32_t Period() const {return period;}
+		/// Jitter-smoothed interval between edges, in samples (0 until Valid)
+		uint32_t SmoothedPeriod() const {return (smoothed8 + 128) >> 8;}
+		/// Samples since the last edge (saturating at maxPeriod)
+		uint32_t SinceLastClock() const {return since;}
+
+		/// Phase increment per sample (2^32 per cycle) of one cycle per smoothed period (0 until Valid)
+		uint32_t __not_in_flash_func(PhaseIncrement)()
+		{
+			if (incPending)
+			{
+				inc = div.Result();
+				incPending = false;
+			}
+			return inc;
+		}
+
+		/// Forget the clock history, e.g. after the clock input is disconnected
+		void Reset()
+		{
+			since = period = smoothed8 = 0;
+			edges = 0;
+			inc = 0;
+			if (incPending) div.Result();
+			incPending = false;
+		}
+
+	private:
+		static constexpr int smoothShift = 3; // one-pole average over ~8 intervals
+		Divider div;
+		uint32_t maxPeriod, since, period, smoothed8;
+		uint8_t edges;
+		uint32_t inc;
+		bool incPending;
+	};
+
+	/** \brief Adaptive integer smoothing of a knob or CV reading, in the style of ResponsiveAnalogRead
+
+		Smoothing is heaviest while the reading is still, and lightens by one step for each
+		doubling of the distance between reading and smoothed value beyond snap, so a moving
+		knob is followed closely without noise on a still one. Once the input settles,
+		Value() sleeps, and only changes again once the input moves more than sleepThreshold.
+		Used for the knobs and CV inputs after EnableAdaptiveSmoothing, and can be used on
+		other control signals too, e.g. audio inputs patched from a CV.
+	*/
+	class AdaptiveSmoother
+	{
+	public:
+		/// sleepThreshold and snap are in the units of the readings
+		AdaptiveSmoother(int32_t sleepThreshold = 8, int32_t snap = 8) : sleep(sleepThreshold), snap16(snap << 4), s(0), err(0), value(0), awake(false), started(false) {}
+
+		void SetSleepThreshold(int32_t sleepThreshold) {sleep = sleepThreshold;}
+
+		/** \brief Add a reading, returning true if Value() has changed
+
+			maxShift is the smoothing while still, as a one-pole filter coefficient of 2^-maxShift per reading.
+		*/
+		bool __not_in_flash_func(Update)(int32_t x, int maxShift = 7)
+		{
+			int32_t x16 = x << 4;
+			if (!started)
+			{
+				s = x16;
+				started = awake = true;
+			}
+			int32_t d = x16 - s;
+			int32_t ad = d < 0 ? -d : d;
+			int shift = maxShift;
+			for (int32_t t = snap16; ad > t && shift > 0; t <<= 1) shift--;
+			s += shift ? (d + (1 << (shift - 1))) >> shift : d;
+			err += (ad - err) >> 4;
+
+			int32_t v = s >> 4;
+			int32_t dv = v - value;
+			if (dv > sleep || dv < -sleep) awake = true;
+			bool changed = awake && v != value;
+			if (changed) value = v;
+			if (err <= (sleep << 3)) awake = false; // sleep once within half the threshold
+			return changed;
+		}
+
+		/// Smoothed value, which holds still while the input is asleep
+		int32_t Value() const {return value;}
+
+		/// True while the input is moving
+		bool Awake() const {return awake;}
+
+	private:
+		int32_t sleep, snap16;
+		int32_t s, err, value; // s and err have 4 fractional bits
+		bool awake, started;
+	};
+
+	/** \brief MIDI to CV conversion: held notes, pitch bend, glide, 14-bit CCs, MPE and MIDI clock
+
+		Pass each received message to MIDI (e.g. from ProcessMIDI). This only stores state:
+		every message takes constant time, apart from a note off searching the short stack of
+		held notes. Call Update once per block or control period, with the number of samples
+		since the last call. Update applies glide, smooths pressure and timbre, and advances
+		the clock. Then read Pitch(), Gate() and the rest to set outputs, e.g. with
+		CVOutMIDIPitch.
+
+		Notes from all channels share one stack, with last note priority. Pitch bend is per
+		channel, with a range set by SetBendRange or by RPN 0. In MPE mode (SetMPE), channel
+		1 is the manager channel, whose bend applies to every note. The sounding note's own
+		channel adds its bend (48 semitones by default), pressure and timbre (CC 74).
+		CCs 0-31 are 14-bit, with the LSB from CCs 32-63.
+
+		MIDI clock (24 per quarter note) is timed by a ClockTracker, so BeatPhase() moves
+		smoothly between clock messages, at the jitter-smoothed tempo.
+	*/
+	class MIDIToCV
+	{
+	public:
+		static constexpr unsigned maxHeld = 16;
+
+		MIDIToCV() {Reset();}
+
+		/// Release all notes, and return bends, pressure, CCs and clock to their initial state
+		void Reset()
+		{
+			held = 0;
+			for (int c=0; c<16; c++)
+			{
+				bend[c] = 0;
+				pressure[c] = 0;
+				rpn[c] = rpnNull;
+				for (int n=0; n<128; n++) ccMSB[c][n] = 0;
+				for (int n=0; n<32; n++) ccLSB[c][n] = 0;
+			}
+			SetMPE(mpe);
+			pitch = 0;
+			snap = true;
+			started = false;
+			pressureOut = timbreOut = 0;
+			ticks = tickInBeat = 0;
+			running = waitFirstTick = false;
+			clock.Reset();
+		}
+
+		/// Respond only to MIDI channel (0-15), or to all channels if -1 (the default). MPE mode always uses all channels
+		void SetChannel(int channel) {listenChannel = channel;}
+
+		/// Range of pitch bend on every channel, in semitones (also set per channel by RPN 0)
+		void SetBendRange(uint8_t semitones)
+		{
+			for (int c=0; c<16; c++) bendRange[c] = semitones;
+		}
+
+		/// MPE mode: channel 1 is the manager channel (bend range 2), channels 2-16 carry one note each (bend range 48)
+		void SetMPE(bool enable)
+		{
+			mpe = enable;
+			SetBendRange(enable ? 48 : 2);
+			if (enable) bendRange[0] = 2;
+		}
+
+		/** \brief Glide time constant, in samples (0 for none)
+
+			Pitch moves exponentially towards each new note, covering about two thirds of
+			the way in the given time. If legatoOnly, glide only between overlapping notes.
+		*/
+		void SetGlide(uint32_t samples, bool legatoOnly = false)
+		{
+			glideRate = samples ? 0xFFFFFFFFu / samples : 0;
+			legato = legatoOnly;
+		}
+
+		/// Handle one MIDI message
+		void __not_in_flash_func(MIDI)(const MIDIEvent &e)
+		{
+			uint8_t status = e.data[0];
+			if (status >= 0xF0)
+			{
+				Realtime(status);
+				return;
+			}
+			uint8_t ch = status & 0x0F;
+			if (!mpe && listenChannel >= 0 && ch != listenChannel) return;
+			uint8_t d1 = e.data[1] & 0x7F, d2 = e.data[2] & 0x7F;
+
+			switch (status & 0xF0)
+			{
+			case 0x90: // note on with velocity 0 is a note off
+				if (d2) NoteOn(ch, d1, d2);
+				else Remove(ch, d1);
+				break;
+
+			case 0x80:
+				Remove(ch, d1);
+				break;
+
+			case 0xE0:
+				bend[ch] = int16_t((d1 | (d2 << 7)) - 8192);
+				break;
+
+			case 0xD0:
+				pressure[ch] = uint16_t(d1 << 7);
+				break;
+
+			case 0xA0: // polyphonic aftertouch, used only for the sounding note
+				if (held && stack[held - 1].note == d1 && stack[held - 1].channel == ch) pressure[ch] = uint16_t(d2 << 7);
+				break;
+
+			case 0xB0:
+				ControlChange(ch, d1, d2);
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		/// Apply glide and smoothing for n samples, and advance the clock (once per block or control period)
+		void __not_in_flash_func(Update)(uint32_t n)
+		{
+			clock.Tick(n);
+
+			uint8_t ch = Channel();
+			int32_t t = int32_t(Note()) << 16;
+			// Bend of -8192 to 8191 is +-range semitones, in 16.16
+			t += int32_t(bend[ch]) * bendRange[ch] * 8;
+			if (mpe && ch != 0) t += int32_t(bend[0]) * bendRange[0] * 8;
+
+			if (snap || glideRate == 0)
+			{
+				pitch = t;
+				snap = false;
+			}
+			else
+			{
+				uint64_t a = (uint64_t(n) * glideRate) >> 16;
+				int32_t alpha = a > 65536 ? 65536 : int32_t(a);
+				int32_t d = t - pitch;
+				int32_t step = int32_t((int64_t(d) * alpha) >> 16);
+				if (step == 0) step = d; // finish the last fraction
+				pitch += step;
+			}
+
+			int32_t p = pressure[ch], tb = CC(ch, 74);
+			pressureOut += (p - pressureOut) >> 2;
+			timbreOut += (tb - timbreOut) >> 2;
+		}
+
+		/// Current pitch, as a MIDI note number in 16.16 fixed point, including bend and glide
+		int32_t Pitch() const {return pitch;}
+		/// True while any note is held
+		bool Gate() const {return held != 0;}
+		/// True once after each note on, until read
+		bool NoteStarted()
+		{
+			bool s = started;
+			started = false;
+			return s;
+		}
+		/// MIDI note number of the sounding (or last sounded) note
+		uint8_t Note() const {return held ? stack[held - 1].note : lastNote;}
+		/// Velocity (1-127) of the sounding (or last) note
+		uint8_t Velocity() const {return held ? stack[held - 1].velocity : lastVelocity;}
+		/// Channel (0-15) of the sounding (or last) note
+		uint8_t Channel() const {return held ? stack[held - 1].channel : lastChannel;}
+		/// Smoothed channel or polyphonic pressure of the sounding note's channel (0-16383)
+		int32_t Pressure() const {return pressureOut;}
+		/// Smoothed CC 74 (MPE timbre) of the sounding note's channel (0-16383)
+		int32_t Timbre() const {return timbreOut;}
+		/// Pitch bend of a channel (-8192 to 8191)
+		int32_t Bend(uint8_t channel) const {return bend[channel & 0x0F];}
+
+		/// Controller cc on channel (0-15), as 0-16383: 14-bit for CCs 0-31 (LSB from CC 32-63), else the 7-bit value << 7
+		int32_t CC(uint8_t channel, uint8_t cc) const
+		{
+			channel &= 0x0F;
+			cc &= 0x7F;
+			return (ccMSB[channel][cc] << 7) | (cc < 32 ? ccLSB[channel][cc] : 0);
+		}
+
+		/// True between MIDI start (or continue) and stop
+		bool Running() const {return running;}
+		/// Clock messages since the last MIDI start
+		uint32_t Ticks() const {return ticks;}
+		/// Smoothed interval between clock messages, in samples (0 until two have arrived)
+		uint32_t TickPeriod() const {return clock.SmoothedPeriod();}
+
+		/** \brief Position within the current quarter note, 0 to 2^32-1
+
+			Advances by 1/24 at each clock message, and is interpolated between them from the
+			smoothed tick period, stopping at the next tick's position if that tick is late.
+		*/
+		uint32_t __not_in_flash_func(BeatPhase)()
+		{
+			static constexpr uint32_t tickPhase = 178956970; // 2^32 / 24
+			uint32_t frac = 0xFFFFFFFFu;
+			uint32_t inc = clock.PhaseIncrement();
+			if (inc)
+			{
+				uint64_t f = uint64_t(clock.SinceLastClock()) * inc;
+				if (f < 0xFFFFFFFFu) frac = uint32_t(f);
+			}
+			return tickInBeat * tickPhase + uint32_t((uint64_t(frac) * tickPhase) >> 32);
+		}
+
+	private:
+		struct Held
+		{
+			uint8_t note, channel, velocity;
+		};
+
+		static constexpr uint16_t rpnNull = 0x3FFF;
+
+		void NoteOn(uint8_t ch, uint8_t note, uint8_t vel)
+		{
+			if (held == 0 && legato) snap = true;
+			Remove(ch, note);
+			if (held == maxHeld) // drop the oldest note
+			{
+				for (unsigned i=1; i<maxHeld; i++) stack[i - 1] = stack[i];
+				held--;
+			}
+			stack[held++] = {note, ch, vel};
+			started = true;
+			if (mpe) pressure[ch] = 0; // each MPE note starts with its channel's pressure reset
+		}
+
+		void Remove(uint8_t ch, uint8_t note)
+		{
+			for (int i=int(held)-1; i>=0; i--)
+			{
+				if (stack[i].note == note && stack[i].channel == ch)
+				{
+					if (held == 1) // keep the pitch of the last note sounding
+					{
+						lastNote = note;
+						lastChannel = ch;
+						lastVelocity = stack[i].velocity;
+					}
+					for (unsigned j=i+1; j<held; j++) stack[j - 1] = stack[j];
+					held--;
+					return;
+				}
+			}
+		}
+
+		void ControlChange(uint8_t ch, uint8_t cc, uint8_t val)
+		{
+			if (cc < 32)
+			{
+				ccMSB[ch][cc] = val;
+				ccLSB[ch][cc] = 0; // a new MSB resets the LSB
+			}
+			else if (cc < 64) ccLSB[ch][cc - 32] = val;
+			else ccMSB[ch][cc] = val;
+
+			switch (cc)
+			{
+			case 101: rpn[ch] = uint16_t((rpn[ch] & 0x7F) | (val << 7)); break;
+			case 100: rpn[ch] = uint16_t((rpn[ch] & 0x3F80) | val); break;
+			case 99: case 98: rpn[ch] = rpnNull; break; // NRPNs are not handled
+			case 6: if (rpn[ch] == 0) bendRange[ch] = val; break; // RPN 0: pitch bend range
+			case 123: // all notes off
+				for (int i=int(held)-1; i>=0; i--) if (stack[i].channel == ch) Remove(ch, stack[i].note);
+				break;
+			default: break;
+			}
+		}
+
+		void Realtime(uint8_t status)
+		{
+			switch (status)
+			{
+			case 0xF8:
+				clock.Clock();
+				if (waitFirstTick) waitFirstTick = false;
+				else if (running)
+				{
+					ticks++;
+					if (++tickInBeat == 24) tickInBeat = 0;
+				}
+				break;
+			case 0xFA: // start: the next clock is the first beat
+				running = true;
+				waitFirstTick = true;
+				ticks = tickInBeat = 0;
+				break;
+			case 0xFB:
+				running = true;
+				break;
+			case 0xFC:
+				running = false;
+				break;
+			default:
+				break;
+			}
+		}
+
+		Held stack[maxHeld];
+		unsigned held;
+		uint8_t lastNote = 60, lastChannel = 0, lastVelocity = 0;
+		int listenChannel = -1;
+		bool mpe = false, legato = false, snap, started;
+
+		int16_t bend[16];
+		uint8_t bendRange[16];
+		uint16_t pressure[16], rpn[16];
+		uint8_t ccMSB[16][128], ccLSB[16][32];
+
+		int32_t pitch;
+		uint32_t glideRate = 0;
+		int32_t pressureOut, timbreOut;
+
+		ClockTracker clock;
+		uint32_t ticks, tickInBeat;
+		bool running, waitFirstTick;
+	};
+
+	/// Host rendering configuration, used by Run()
+	struct HostConfig
+	{
+		std::string inputWav;    ///< Audio input WAV file, or empty for silence
+		std::string outputWav;   ///< Output WAV file, or empty to discard output
+		std::string controlCsv;  ///< Knob/switch/CV/pulse automation CSV file, or empty
+		double seconds = 10.0;   ///< Render length, if there is no input WAV file
+		bool quiet = false;      ///< Don't print timing report
+		bool lockstep = false;   ///< Run the RunOnCore1 thread in turn with the audio, for repeatable output
+		std::string replay;      ///< Control recording to replay instead of controlCsv, or empty
+		std::string recordOut;   ///< File to write a control recording to, or empty
+		std::string linkIn;      ///< Audio link frames received, as a WAV file, or empty
+		std::string linkOut;     ///< WAV file to write the audio link's frames sent to, or empty
+	};
+
+	/// Results of the last Run(), on the host
+	struct HostReport
+	{
+		uint64_t samples = 0;
+		double seconds = 0;      ///< Wall-clock time spent rendering
+		double nsPerSample = 0;
+		double realTimeFactor = 0;
+	};
+
+	/// Host configuration, also filled from environment variables when first used
+	static HostConfig &Host()
+	{
+		static HostConfig config = ConfigFromEnvironment();
+		return config;
+	}
+
+	/// Timing results of the last Run()
+	static HostReport &Report()
+	{
+		static HostReport report;
+		return report;
+	}
+
+	ComputerCard()
+	{
+		bootTimes = {};
+		bootTimes.constructor = time_us_32();
+		numStartupTasks = nextStartupTask = startupStep = 0;
+		useNormProbe = false;
+		useLoadMeter = false;
+		noiseShapingOrder = 0;
+		ResetCVInCalibration(0);
+		ResetCVInCalibration(1);
+		controlPeriod = 0;
+		controlCount = 0;
+		for (int i=0; i<6; i++) connected[i] = false;
+		for (int i=0; i<numLeds; i++) ledValue[i] = 0;
+		for (int i=0; i<2; i++) pulseOut[i] = false;
+		ReadEEPROM();
+		bootTimes.calibrated = time_us_32();
+		ResetLoadMeter();
+		loadAvgCycles8 = 0;
+	}
+
+	virtual ~ComputerCard() {}
+
+	/** \brief Render audio offline
+
+		Renders the configured length of audio by calling ProcessSample (or ProcessBlock)
+		at the given sample rate, as fast as possible, then returns.
+	*/
+	void Run(SampleRate_t rate = SR48kHz)
+	{
+		bootTimes.run = time_us_32();
+		if (StartupDone()) bootTimes.startupDone = bootTimes.run;
+		ComputerCard::thisptr = this;
+		sampleRate = rate;
+		AudioWorker();
+	}
+
+	/// Return audio sample rate in Hz, as set by Run
+	int32_t SampleRate() {return sampleRate;}
+
+	/// Times at which startup reached each stage, in µs (as time_us_32; on the host, from the first time_us_32 call, normally the constructor), see BootProfile
+	struct BootTimes
+	{
+		uint32_t constructor; // ComputerCard constructor entered, after clock and C runtime setup
+		uint32_t calibrated;  // CV output calibration read
+		uint32_t run;         // Run called, after the card's constructor
+		uint32_t firstSample; // first audio interrupt
+		uint32_t startupDone; // startup tasks (AddStartupTask) finished, 0 until then
+	};
+
+	/// Times at which startup reached each stage, to find what delays the first sample
+	const BootTimes &BootProfile() const {return bootTimes;}
+
+	/** \brief Use before Run() to finish part of the card's setup in the background, once audio is running
+
+		Slow setup, such as clearing a large buffer, can be split into steps and given here
+		(e.g. AddStartupTask(&MyCard::ClearBuffer) in the card's constructor) so that audio
+		starts sooner. fn is called as fn(0), fn(1), ... until it returns false, from the loop
+		in Run that idles between audio interrupts, so it never delays the audio (on the host,
+		one step per block); tasks run
+		one after another, in the order added, up to maxStartupTasks. Until StartupDone,
+		ProcessSample must cope with the setup being unfinished.
+	*/
+	template <class C>
+	void AddStartupTask(bool (C::*fn)(int step))
+	{
+		if (numStartupTasks < maxStartupTasks) startupTasks[numStartupTasks++] = static_cast<StartupTask>(fn);
+	}
+
+	/// True once every task given to AddStartupTask has finished
+	bool StartupDone() const {return nextStartupTask == numStartupTasks;}
+
+	static constexpr int maxStartupTasks = 8;
+
+	/// Use before Run() to enable Connected/Disconnected detection
+	/// How the normalisation probe runs, set by EnableNormalisationProbe
+	enum ProbeMode {ProbeContinuous, ProbeBursts, ProbeOnDemand};
+
+	/// Use before Run() to enable Connected/Disconnected detection. On the host, inputs are connected if the input files drive them, whatever the mode
+	void EnableNormalisationProbe(ProbeMode mode = ProbeContinuous, int32_t intervalMs = 100, int32_t burstSamples = 256)
+	{
+		(void)mode; (void)intervalMs; (void)burstSamples;
+		useNormProbe = true;
+	}
+
+	/// Run a burst of the normalisation probe as soon as possible, in ProbeBursts or ProbeOnDemand modes
+	void ProbeJacks() {}
+
+	/** \brief Use before Run() to smooth knobs and CV inputs with AdaptiveSmoother, rather than a fixed filter
+
+		Knobs and CV then follow movements more quickly, and hold still (so are not reported
+		by ControlsChanged) until they move more than sleepThreshold (in 0-4095 ADC units).
+	*/
+	void EnableAdaptiveSmoothing(int32_t sleepThreshold = 8)
+	{
+		for (int i=0; i<3; i++) knobSmoother[i].SetSleepThreshold(sleepThreshold);
+		for (int i=0; i<2; i++) cvSmoother[i].SetSleepThreshold(sleepThreshold);
+		useAdaptiveSmoothing = true;
+	}
+
+	/// Use before Run() to set how often each knob and CV input is read. On the host, all are read every block
+	void SetMuxScan(int cv1Weight, int cv2Weight, int mainWeight = 1, int yWeight = 1, int xWeight = 1, int switchWeight = 1)
+	{
+		(void)cv1Weight; (void)cv2Weight; (void)mainWeight; (void)yWeight; (void)xWeight; (void)switchWeight;
+	}
+
+	/// Use before Run() to read CV inputs at audio rate, for CVInFast. On the host, CVInFast is always the unsmoothed CV
+	void EnableFastCV(bool cv1 = true, bool cv2 = true) {(void)cv1; (void)cv2;}
+
+	/// Use before Run() to remove interference from the mux at the audio inputs. No effect on the host, which has no mux
+	void EnableMuxCorrection(int shift = 8) {(void)shift;}
+
+	/// Replace the ADC DNL correction table. No effect on the host, which has no ADC
+	void SetADCCorrection(const int8_t *table) {(void)table;}
+
+	/// Use before Run() to set the ADC conversions of each audio input per sample. No effect on the host, which has no ADC
+	void SetAudioOversampling(int conversions) {(void)conversions;}
+
+	/// Use before Run() to record the audio inputs into a ring of frames, as on the RP2040 (copied by the host, rather than DMA)
+	void EnableInputCapture(Frame *buffer, uint32_t frames)
+	{
+		captureFrames = frames - frames % blockSize;
+		captureBuffer = captureFrames ? buffer : nullptr;
+		captureIndex = 0;
+	}
+
+	/// Position in the EnableInputCapture ring of the current frame (or block); the frames before it are the most recent
+	uint32_t CaptureIndex() const {return captureIndex;}
+
+	/** \brief Use before Run() to call ProcessControl every period samples
+
+		period is rounded down to a power of two. In block mode, ProcessControl
+		is called at most once per block, so periods shorter than blockSize
+		are rounded up to blockSize.
+	*/
+	void EnableControlRate(int period = 32)
+	{
+		if (period < blockSize) period = blockSize;
+		controlShift = 0;
+		while ((1 << (controlShift + 1)) <= period) controlShift++;
+		controlPeriod = 1 << controlShift;
+		// First call happens before the first ProcessSample/ProcessBlock
+		controlCount = controlPeriod;
+	}
+
+	/// Use before Run() to call ProcessSubRate every factor (2, 4 or 8) samples, with half-band resampling, as on the RP2040
+	void EnableSubRate(int factor = 2)
+	{
+		subRateStages = factor >= 8 ? 3 : (factor >= 4 ? 2 : (factor >= 2 ? 1 : 0));
+	}
+
+	/// Use before Run() to drive CV outputs by DMA. No effect on the host, where CV outputs are written exactly
+	void EnableCVOutputDMA() {}
+
+	/// Use before Run() to measure the time taken by ProcessSample/ProcessBlock
+	void EnableLoadMeter() {useLoadMeter = true;}
+
+	/** \brief Use before Run() to pass 16-bit audio outputs from ProcessBlock, noise shaped to the DAC's 12 bits
+
+		As on the Computer: ProcessBlock's audio outputs are -32768 to 32767, rounded to 12 bits with
+		error feedback of the given order (1 or 2). Block mode only.
+	*/
+	void EnableNoiseShaping(int order = 2)
+	{
+		noiseShapingOrder = order < 1 ? 1 : (order > 2 ? 2 : order);
+	}
+
+	/** \brief Use before Run() to time pulse input edges to within a sample
+
+		On the host, edges are timed from the row times in the automation CSV file.
+	*/
+	void EnablePulseCapture() {usePulseCapture = true;}
+
+	/** \brief Use before Run() to step the knob/CV mux from PIO, at a fixed point in each frame
+
+		On the host, there is no mux to step, so this does nothing.
+	*/
+	void EnableMuxSequencer() {}
+
+	/** \brief Use before Run() to generate timed pulses, for PulseOutTrigger and PulseOutBurst
+
+		On the host, pulses are rendered to the nearest sample.
+	*/
+	void EnablePulseEngine() {usePulseEngine = true;}
+
+	/// Lead a sync group, sending a word clock on pulse output i, as on the card
+	void EnableSyncLead(int i = 0, int32_t period = 48)
+	{
+		syncMode = SyncOff;
+		syncPin = i ? 1 : 0;
+		syncPeriod = period;
+		SetupSync();
+		syncMode = SyncLead;
+	}
+
+	/** \brief Follow a sync group's word clock on pulse input i, as on the card
+
+		SyncFrame is matched to the edges in the automation, and the phase-locked loop runs,
+		but the rendered sample rate can't be trimmed, so trimPPM only reports what the card would do.
+	*/
+	void EnableSyncFollow(int i = 0, int32_t period = 48)
+	{
+		syncMode = SyncOff;
+		syncPin = i ? 1 : 0;
+		syncPeriod = period;
+		SetupSync();
+		syncMode = SyncFollow;
+	}
+
+	/// SampleCounter, shared by a sync group
+	uint32_t SyncFrame() {return callbackFrame + syncOffset;}
+
+	/// With EnableSyncFollow, return the phase-locked loop's state
+	SyncStats SyncStatus()
+	{
+		SyncStats ss;
+		ss.locked = syncGood >= 16;
+		ss.phaseError = syncPhase;
+		ss.trimPPM = int32_t((int64_t(syncTrim) * 1000000) / (int64_t(syncADCInterval) << 24));
+		ss.realigns = syncRealigns;
+		return ss;
+	}
+
+	/** \brief Use before Run() to stream audio to and from another Computer over the debug pins, as on the card
+
+		On the host, frames sent are written to COMPUTERCARD_LINK_OUT, and frames received are
+		read from COMPUTERCARD_LINK_IN: WAV files of the COMPUTERCARD_LINK channels, then the
+		control word's low and high halves. Each frame is played latency + 1 samples (or blocks)
+		after it was sent, as on the card with the two sample clocks in sync, so one card's
+		render can be fed to another's. Without COMPUTERCARD_LINK_IN, the link is not connected.
+	*/
+	void EnableAudioLink(int latency = 2)
+	{
+#ifdef COMPUTERCARD_LINK
+		linkLatency = latency < 1 ? 1 : (latency > 4 ? 4 : latency);
+		useAudioLink = true;
+#else
+		(void)latency;
+#endif
+	}
+
+	/// With EnableAudioLink, send val on link channel ch (0 to COMPUTERCARD_LINK - 1); in block mode, for the given frame
+	void LinkOut(int ch, int16_t val, int frame = 0)
+	{
+#ifdef COMPUTERCARD_LINK
+		linkTx[frame][ch] = val;
+#else
+		(void)ch; (void)val; (void)frame;
+#endif
+	}
+
+	/// With EnableAudioLink, the sample received on link channel ch; in block mode, for the given frame. Zero while not connected
+	int16_t LinkIn(int ch, int frame = 0)
+	{
+#ifdef COMPUTERCARD_LINK
+		if (!linkConnected) return 0;
+		return linkInSamples[(linkPlaying + uint64_t(frame)) * (COMPUTERCARD_LINK + 2) + uint64_t(ch)];
+#else
+		(void)ch; (void)frame;
+		return 0;
+#endif
+	}
+
+	/// With EnableAudioLink, send a word of control data along with this sample (or block)
+	void LinkControlOut(uint32_t val)
+	{
+#ifdef COMPUTERCARD_LINK
+		linkControl = val;
+#else
+		(void)val;
+#endif
+	}
+
+	/// With EnableAudioLink, the control word received with this sample (or block). Zero while not connected
+	uint32_t LinkControlIn()
+	{
+#ifdef COMPUTERCARD_LINK
+		if (!linkConnected) return 0;
+		const int16_t *f = &linkInSamples[linkPlaying * (COMPUTERCARD_LINK + 2) + COMPUTERCARD_LINK];
+		return uint32_t(uint16_t(f[0])) | (uint32_t(uint16_t(f[1])) << 16);
+#else
+		return 0;
+#endif
+	}
+
+	/// With EnableAudioLink, return the link's state
+	LinkStats LinkStatus()
+	{
+		LinkStats ls = {};
+#ifdef COMPUTERCARD_LINK
+		ls.connected = linkConnected;
+		ls.frames = linkFrames;
+		ls.queued = linkConnected ? linkLatency : 0;
+#endif
+		return ls;
+	}
+
+	/** \brief Measure the latency from audio output out, through a patch cable, to audio input in
+
+		On the host, no output reaches an input, so the measurement finishes at once, with
+		nothing found.
+	*/
+	void MeasureLatency(int out = 0, int in = 0) {(void)out; (void)in; latencyResult = LatencyStats{}; latencyResult.done = true;}
+
+	/// Measure the latency of audio input in alone, with the normalisation probe. On the host, as MeasureLatency
+	void MeasureInputLatency(int in = 0) {MeasureLatency(0, in);}
+
+	/// Return the result of the last MeasureLatency or MeasureInputLatency
+	LatencyStats LatencyStatus() {return latencyResult;}
+
+	/** \brief Use before Run() to play audio on the two pulse outputs, set with PulseAudioOut
+
+		On the host, the pulse output channels of the output file carry the 8-bit PWM level
+		of each frame, 0 to 32767. PulseOut and EnablePulseEngine then have no effect.
+	*/
+	void EnablePulseAudio() {usePulseAudio = true;}
+
+	/// Use before Run() to drive the LEDs from a frame buffer, refreshed refreshHz times a second, for LedFade and LedMeter
+	void EnableLedEngine(int32_t refreshHz = 200)
+	{
+		useLedEngine = true;
+		ledRefreshHz = refreshHz < 1 ? 1 : refreshHz;
+	}
+
+	/// Use before Run() to lower the system clock and sleep between interrupts. No effect on the host
+	void EnableLowPower(uint32_t sysClockKHz = 48000) {(void)sysClockKHz;}
+
+	/// Percentage of time the audio core is awake with EnableLowPower. Always 0 on the host
+	int32_t DutyPercent() {return 0;}
+
+	/// Return load meter statistics. On the host, times are in nanoseconds
+	LoadStats LoadMeter()
+	{
+		LoadStats ls;
+		ls.minCycles = loadMinCycles;
+		ls.avgCycles = loadAvgCycles8 >> 8;
+		ls.maxCycles = loadMaxCycles;
+		ls.budgetCycles = loadBudgetCycles;
+		ls.overruns = loadOverruns;
+		return ls;
+	}
+
+	/// Return average load of ProcessSample/ProcessBlock, as percentage of time available in real time
+	int32_t LoadPercent()
+	{
+		return loadBudgetCycles ? int32_t(((loadAvgCycles8 >> 8) * 100) / loadBudgetCycles) : 0;
+	}
+
+	/// Return number of calls that would have overrun in real time
+	uint32_t OverrunCount() {return loadOverruns;}
+
+	/// Clear minimum, maximum and overrun count of the load meter
+	void ResetLoadMeter()
+	{
+		loadMinCycles = 0xFFFFFFFF;
+		loadMaxCycles = 0;
+		loadOverruns = 0;
+	}
+
+	/// As on the device, but host renders aren't real time, so the level stays at the best, levels - 1
+	void EnableAutoQuality(int32_t levels, int32_t = 90, int32_t = 60, int32_t = 100, int32_t = 10)
+	{
+		useLoadMeter = true;
+		qualityLevel = levels < 1 ? 0 : levels - 1;
+	}
+
+	/// With EnableAutoQuality, the quality level to run at, from levels - 1 (best) down to 0
+	int32_t QualityLevel() const {return qualityLevel;}
+
+	/// Events recorded by Trace, as on the device
+	enum TraceEvent : uint8_t
+	{
+		TraceAudio,
+		TraceOverrun,
+		TraceCVPWMWrap,
+		TraceFlash,
+		TraceUser = 32,
+		TraceBegin = 0x40,
+		TraceEnd = 0x80
+	};
+
+	/// One traced event
+	struct TraceRecord
+	{
+		uint32_t time;
+		uint8_t event;
+		uint8_t core;
+		uint16_t arg;
+	};
+
+	/// The tracer follows the hardware's interrupts and cores, so on the host nothing is recorded
+	static void Trace(uint8_t, uint16_t = 0) {}
+	static void SetTraceMask(uint32_t) {}
+	static unsigned TraceSnapshot(TraceRecord *, unsigned) {return 0;}
+	template <typename Write>
+	static void TraceWriteJSON(Write write)
+	{
+		const char empty[] = "{\"traceEvents\":[]}\n";
+		write(empty, int(sizeof(empty) - 1));
+	}
+
+	/// Write the recorded control inputs, as on the device. Recorded with COMPUTERCARD_RECORD defined, or COMPUTERCARD_RECORD_OUT set
+	template <typename Write>
+	void RecordingWrite(Write write)
+	{
+		char line[96];
+		int n = std::snprintf(line, sizeof(line), "# ComputerCard control recording, for COMPUTERCARD_REPLAY\nCCREC %d %d %u\n",
+							  int(sampleRate), blockSize, unsigned(callbackFrame + blockSize));
+		write(line, n);
+		if (recordRing.empty()) return;
+		static const char hex[] = "0123456789abcdef";
+		uint32_t numPages = uint32_t(recordRing.size() / recordPageSize);
+		uint32_t first = recordPages > numPages ? recordPages - numPages : 0;
+		for (uint32_t page = first; page < recordPages; page++)
+		{
+			const uint8_t *b = recordRing.data() + (page % numPages) * recordPageSize;
+			for (int i=0; i<recordPageSize; i+=32)
+			{
+				char *p = line;
+				for (int j=0; j<32; j++)
+				{
+					*p++ = hex[b[i + j] >> 4];
+					*p++ = hex[b[i + j] & 15];
+				}
+				*p++ = '\n';
+				write(line, int(p - line));
+			}
+		}
+		recordResync = true;
+	}
+
+	/// Discard the recorded control inputs
+	void RecordingClear()
+	{
+		recordPages = 0;
+		recordResync = true;
+	}
+
+	/// Buckets of SoakStats::histogram: sixteen of 1/16 of the budget each, and a last for calls over budget
+	static constexpr int soakBuckets = 17;
+
+	/// One soak test run, see COMPUTERCARD_SOAK. On the host, times are in nanoseconds
+	struct SoakStats
+	{
+		uint32_t seconds;       ///< Length of the run, in seconds of audio
+		uint32_t overruns;      ///< Calls that would have overrun in real time
+		uint32_t firstOverrun;  ///< Second of the run at which the first overrun happened
+		uint32_t lastOverrun;   ///< Second of the run at which the last overrun happened
+		uint32_t maxCycles;     ///< Longest ProcessSample/ProcessBlock call
+		uint32_t budgetCycles;  ///< Time available per call
+		uint32_t midiQueued;    ///< MIDI messages queued by the stress generator
+		uint32_t midiDropped;   ///< MIDI messages the stress generator found no room for
+		uint32_t jackChanges;   ///< Jacks plugged or unplugged by the stress generator
+		uint32_t histogram[soakBuckets]; ///< Calls by length, in 1/16ths of budgetCycles
+	};
+
+	/// With COMPUTERCARD_SOAK, the soak test render so far
+	SoakStats SoakThisRun() {return soakRun;}
+
+	/// Runs before this boot, from flash. Always empty on the host, which renders a single run
+	SoakStats SoakLastRun() {return SoakStats{};}
+
+	/// Longest earlier run saved in flash. Always empty on the host
+	SoakStats SoakLongestRun() {return SoakStats{};}
+
+	/// Forget the longest run. No effect on the host
+	void SoakClear() {}
+
+	/// Write the soak test report as text, as on the RP2040; with COMPUTERCARD_SOAK, the host also writes it to stderr after rendering
+	template <typename Write>
+	void SoakReportWrite(Write write)
+	{
+#ifdef COMPUTERCARD_SOAK
+		const SoakStats &s = soakRun;
+		char line[256];
+		int n = std::snprintf(line, sizeof(line), "this run: %us, %u overruns", s.seconds, s.overruns);
+		if (s.overruns) n += std::snprintf(line + n, sizeof(line) - n, " (%us to %us)", s.firstOverrun, s.lastOverrun);
+		n += std::snprintf(line + n, sizeof(line) - n, ", longest call %u%%, %u MIDI (%u dropped), %u jack changes\n",
+						   s.budgetCycles ? unsigned((uint64_t(s.maxCycles) * 100) / s.budgetCycles) : 0u,
+						   s.midiQueued, s.midiDropped, s.jackChanges);
+		write(line, n);
+		n = std::snprintf(line, sizeof(line), "  load");
+		for (int i=0; i<soakBuckets; i++)
+			n += std::snprintf(line + n, sizeof(line) - n, i == soakBuckets - 1 ? " | %u" : " %u", s.histogram[i]);
+		n += std::snprintf(line + n, sizeof(line) - n, "\n");
+		write(line, n);
+#else
+		(void)write;
+#endif
+	}
+
+	/// Write the soak test record to flash. No effect on the host
+	void SoakService() {}
+
+	/// SRAM and flash cache use, returned by MemoryUsage
+	struct MemoryStats
+	{
+		uint32_t stackUsed[2];
+		uint32_t stackSize[2];
+		uint32_t staticBytes;
+		uint32_t heapPeak;
+		uint32_t heapInUse;
+		uint32_t heapFree;
+		uint32_t xipAccesses;
+		uint32_t xipHits;
+	};
+
+	/// Measures the RP2040's SRAM, so on the host all zero
+	static MemoryStats MemoryUsage() {return MemoryStats{};}
+	static void PaintCore1Stack() {}
+	static void ResetXIPCounters() {}
+
+	/// Run-time statistics of one core 1 task, see AddCore1Task
+	struct TaskStats
+	{
+		uint32_t runs;      ///< Number of runs
+		uint32_t totalUs;   ///< Total run time, in µs
+		uint32_t maxUs;     ///< Longest run, in µs
+		uint32_t late;      ///< Runs started more than the task's deadline after they were due
+		uint32_t maxLateUs; ///< Latest start, in µs after due
+	};
+
+	static constexpr int maxCore1Tasks = 8;
+
+	/** \brief Add a task to the core 1 scheduler, started by RunCore1Tasks
+
+		Tasks run to completion, one at a time, on core 1: USB, UI, flash saves, telemetry and
+		so on, each in its own member function, rather than one hand-written loop. A task is due
+		every periodUs, or always if periodUs is 0. Of the tasks due, the highest priority runs;
+		among equal priorities, the one due longest, so that background tasks take turns. A run
+		is counted late if it starts more than deadlineUs after it was due (by default, one
+		period). A task that falls more than a period behind skips the runs it missed. Each task
+		should do a slice of work and return, so that it does not hold up the others.
+		Returns the task's index, or -1 if there are already maxCore1Tasks.
+	*/
+	template <class C>
+	int AddCore1Task(void (C::*fn)(), uint32_t periodUs, int priority = 0, uint32_t deadlineUs = 0)
+	{
+		if (numCore1Tasks >= maxCore1Tasks) return -1;
+		Core1Task &t = core1Tasks[numCore1Tasks];
+		t.fn = static_cast<Core1TaskFn>(fn);
+		t.period = periodUs;
+		t.deadline = deadlineUs ? deadlineUs : periodUs;
+		t.priority = priority;
+		t.stats = TaskStats();
+		return numCore1Tasks++;
+	}
+
+	/// Statistics of core 1 task i (the index returned by AddCore1Task)
+	TaskStats Core1TaskStats(int i) const {return core1Tasks[i].stats;}
+
+	/// Return index of the first frame of the current ProcessSample/ProcessBlock call, counting from 0 at Run()
+	uint32_t SampleCounter() const {return callbackFrame;}
+
+	/** \brief Queue a MIDI message (not sysex) for ProcessMIDI, from the USB core
+
+		The message is stamped with the frame being processed when it arrives (on the host,
+		rendering faster than real time, the first frame of the current callback), and passed to
+		ProcessMIDI by PollMIDIEvents a fixed latency (see SetMIDILatency) later.
+		Call from one thread only.
+		Returns false if the queue is full or the message is not 1 to 3 bytes long.
+	*/
+	bool QueueMIDI(const uint8_t *msg, int length, uint8_t cable = 0)
+	{
+		if (length < 1 || length > 3) return false;
+#ifdef COMPUTERCARD_SOAK
+		return true; // the stress generator is the only source of MIDI
+#endif
+		MIDIEvent e;
+		e.sample = MIDIArrivalFrame();
+		e.cable = cable;
+		e.length = uint8_t(length);
+		for (int i=0; i<3; i++) e.data[i] = (i < length) ? msg[i] : 0;
+		return midiQueue.Push(e);
+	}
+
+	/** \brief Queue all MIDI messages in a byte stream, e.g. from tud_midi_stream_read/tuh_midi_stream_read
+
+		Messages are split at status bytes, with running status; sysex is skipped.
+		Returns the number of messages queued.
+	*/
+	int QueueMIDIStream(const uint8_t *bytes, int n, uint8_t cable = 0)
+	{
+		int queued = 0;
+		for (int i=0; i<n; i++)
+		{
+			uint8_t b = bytes[i];
+			if (b >= 0xF8) // Real-time messages can appear anywhere, even within sysex
+			{
+				queued += QueueMIDI(&b, 1, cable);
+				continue;
+			}
+			if (b & 0x80)
+			{
+				midiStreamInSysex = (b == 0xF0);
+				midiStreamStatus = (b < 0xF0) ? b : 0; // System common messages cancel running status
+				if (b >= 0xF0)
+				{
+					int len = MIDIMessageLength(b);
+					if (len == 1) queued += QueueMIDI(&b, 1, cable);
+					else if (len > 1 && i + len <= n) queued += QueueMIDI(&bytes[i], len, cable);
+					if (len > 1) i += len - 1;
+					continue;
+				}
+				i++; // first data byte
+			}
+			else if (midiStreamInSysex || !midiStreamStatus)
+			{
+				continue; // sysex data, or data with no status
+			}
+
+			// Channel voice message: running status, then one or two data bytes from bytes[i]
+			int len = MIDIMessageLength(midiStreamStatus);
+			if (i + len - 1 > n) break;
+			uint8_t msg[3] = {midiStreamStatus, (len > 1) ? bytes[i] : uint8_t(0), (len > 2) ? bytes[i+1] : uint8_t(0)};
+			queued += QueueMIDI(msg, len, cable);
+			i += len - 2;
+		}
+		return queued;
+	}
+
+	/** \brief Queue the MIDI messages (not sysex) in n 4-byte USB-MIDI event packets
+
+		For parsing packets in place, e.g. from tuh_midi_rx_packets_cb (see usb_midi_host/)
+		or tud_midi_packet_read. Each packet holds one complete message, with its cable number.
+		Returns the number of messages queued.
+	*/
+	int QueueMIDIPackets(const uint8_t *packets, int n)
+	{
+		int queued = 0;
+		for (int i=0; i<n; i++, packets += 4)
+		{
+			uint8_t cin = packets[0] & 0x0F;
+			if (cin < 0x2 || cin == 0x4 || cin == 0x6 || cin == 0x7) continue; // padding, reserved or sysex
+			if (!(packets[1] & 0x80)) continue;
+			int len = MIDIMessageLength(packets[1]); // 0 for sysex start/end
+			if (len > 0) queued += QueueMIDI(packets + 1, len, packets[0] >> 4);
+		}
+		return queued;
+	}
+
+	/** \brief Use to set the delay (in samples) from a MIDI message arriving to it being passed to ProcessMIDI
+
+		Should be at least the jitter of the USB loop, plus one block in block mode;
+		the default is 1ms plus one block.
+	*/
+	void SetMIDILatency(uint32_t samples) {midiLatency = samples;}
+
+	/** \brief Pass queued MIDI messages that are due by frame sampleIndex to ProcessMIDI
+
+		Call from ProcessSample with SampleCounter(), or from ProcessBlock with
+		SampleCounter() + i before processing frame i.
+	*/
+	void PollMIDIEvents(uint32_t sampleIndex)
+	{
+		MIDIEvent e;
+		while (midiQueue.Peek(e) && int32_t(sampleIndex - (e.sample + midiLatency)) >= 0)
+		{
+			midiQueue.Pop(e);
+			ProcessMIDI(e);
+		}
+	}
+	
+static ComputerCard *ThisPtr() {return thisptr;}
+
+	/// Lock-free single-producer, single-consumer ring buffer, as on the hardware
+	template <typename T, unsigned N>
+	class Ring
+	{
+		static_assert(N > 0 && (N & (N - 1)) == 0, "Ring size must be a power of two");
+	public:
+		Ring() : head(0), tail(0) {}
+
+		bool Push(const T &val)
+		{
+			Core1Yield(false);
+			uint32_t h = head;
+			if (h - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) == N) return false;
+			buf[h & (N - 1)] = val;
+			__atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		bool Pop(T &val)
+		{
+			Core1Yield(false);
+			uint32_t t = tail;
+			if (__atomic_load_n(&head, __ATOMIC_ACQUIRE) == t) return false;
+			val = buf[t & (N - 1)];
+			__atomic_store_n(&tail, t + 1, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		bool Peek(T &val) const
+		{
+			Core1Yield(false);
+			uint32_t t = tail;
+			if (__atomic_load_n(&head, __ATOMIC_ACQUIRE) == t) return false;
+			val = buf[t & (N - 1)];
+			return true;
+		}
+
+		unsigned Size() const
+		{
+			Core1Yield(false);
+			return __atomic_load_n(&head, __ATOMIC_ACQUIRE) - __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+		}
+		unsigned Free() const {return N - Size();}
+		bool Empty() const {return Size() == 0;}
+		bool Full() const {return Size() == N;}
+
+	private:
+		// Separate cache lines on the host, so the two threads don't contend
+		alignas(64) uint32_t head;
+		alignas(64) uint32_t tail;
+		T buf[N];
+	};
+
+#ifdef COMPUTERCARD_HAS_COROUTINES
+	/** \brief Timed and clocked sequences written as C++20 coroutines
+
+		A sequence is a card member function returning Sequencer::Task, which waits with
+		co_await Sequencer::Samples(n) (resume n ticks later) or co_await Sequencer::NextClock(ch)
+		(resume at the next Clock(ch) call), rather than a state machine polled every sample:
+
+			Sequencer::Task Ratchet()
+			{
+				while (true)
+				{
+					co_await Sequencer::NextClock();
+					for (int i=0; i<3; i++)
+					{
+						PulseOut1(true);
+						co_await Sequencer::Samples(100);
+						PulseOut1(false);
+						co_await Sequencer::Samples(1900);
+					}
+				}
+			}
+
+		Start it with seq.Start(Ratchet()), e.g. in the card's constructor. This allocates the
+		coroutine's frame, so should not be done from ProcessSample. Then call seq.Tick() each
+		sample (or seq.Tick(n) each block of n frames), and seq.Clock(ch) for each clock. Sleeping
+		sequences are kept in wake order, so Tick costs one comparison until one is due. Tick and
+		Clock resume sequences in whichever context they are called from. A sequence that
+		returns frees its frame there too, so sequences usually loop forever. Needs C++20.
+	*/
+	class Sequencer
+	{
+	public:
+		static constexpr int numClocks = 4;
+
+		struct Task
+		{
+			struct promise_type
+			{
+				Sequencer *seq = nullptr;
+				uint32_t wake = 0;
+				promise_type *next = nullptr;
+
+				Task get_return_object() {return Task{std::coroutine_handle<promise_type>::from_promise(*this)};}
+				std::suspend_always initial_suspend() noexcept {return {};}
+				std::suspend_never final_suspend() noexcept {return {};}
+				void return_void() {}
+				void unhandled_exception() {}
+			};
+			std::coroutine_handle<promise_type> handle;
+		};
+		using Handle = std::coroutine_handle<Task::promise_type>;
+
+		/// Wait n ticks
+		struct Samples
+		{
+			uint32_t n;
+			explicit Samples(uint32_t ticks) : n(ticks) {}
+			bool await_ready() const {return n == 0;}
+			void await_suspend(Handle h) {h.promise().seq->Sleep(h.promise(), n);}
+			void await_resume() {}
+		};
+
+		/// Wait for the next Clock(ch)
+		struct NextClock
+		{
+			int ch;
+			explicit NextClock(int channel = 0) : ch(channel) {}
+			bool await_ready() const {return false;}
+			void await_suspend(Handle h)
+			{
+				Task::promise_type &p = h.promise();
+				p.next = p.seq->clockWaiters[ch];
+				p.seq->clockWaiters[ch] = &p;
+			}
+			void await_resume() {}
+		};
+
+		Sequencer() : now(0), sleepers(nullptr)
+		{
+			for (int i=0; i<numClocks; i++) clockWaiters[i] = nullptr;
+		}
+
+		/// Run a sequence until its first co_await
+		void Start(Task t)
+		{
+			t.handle.promise().seq = this;
+			t.handle.resume();
+		}
+
+		/// Advance time by n ticks, resuming the sequences now due
+		void Tick(uint32_t n = 1)
+		{
+			now += n;
+			while (sleepers && int32_t(now - sleepers->wake) >= 0)
+			{
+				Task::promise_type *p = sleepers;
+				sleepers = p->next;
+				Handle::from_promise(*p).resume();
+			}
+		}
+
+		/// Resume the sequences waiting for clock ch
+		void Clock(int ch = 0)
+		{
+			Task::promise_type *p = clockWaiters[ch];
+			clockWaiters[ch] = nullptr; // sequences resumed here wait for the next Clock
+			while (p)
+			{
+				Task::promise_type *next = p->next;
+				Handle::from_promise(*p).resume();
+				p = next;
+			}
+		}
+
+		/// Ticks since the sequencer was created
+		uint32_t Now() const {return now;}
+
+	private:
+		// Insert into the wake-ordered list of sleeping sequences
+		void Sleep(Task::promise_type &p, uint32_t n)
+		{
+			p.wake = now + n;
+			Task::promise_type **q = &sleepers;
+			while (*q && int32_t((*q)->wake - p.wake) <= 0) q = &(*q)->next;
+			p.next = *q;
+			*q = &p;
+		}
+
+		uint32_t now;
+		Task::promise_type *sleepers;
+		Task::promise_type *clockWaiters[numClocks];
+	};
+#endif
+
+	/** \brief Streams frames of several 16-bit channels from ProcessSample to a computer, in binary packets
+
+		On the audio core, Set each channel and then call Send() once per sample; every
+		decimation'th frame is queued in a Ring. On the other core, Packet() takes the queued
+		frames and builds one packet for the USB serial port (written to it with e.g.
+		stdio_usb.out_chars, so no line-ending translation is applied). If the queue fills,
+		frames are dropped, and the next packet is flagged. See examples/telemetry.
+
+		Packet layout, little-endian:
+		  0  'C','T'               sync bytes
+		  2  uint8  channels
+		  3  uint8  flags          bit 0: frames were dropped before this packet
+		  4  uint16 sequence       packet counter
+		  6  uint16 frames         number of frames n
+		  8  uint32 frameRate      frames per second (sample rate / decimation)
+		  12 int16  data[n][channels]
+		  then uint16 Fletcher-16 checksum of all bytes from 2 onwards
+	*/
+	template <unsigned Channels, unsigned N = 1024>
+	class Telemetry
+	{
+		static_assert(Channels > 0 && Channels < 256, "Telemetry needs 1 to 255 channels");
+	public:
+		static constexpr unsigned headerBytes = 12;
+
+		/// Bytes in a packet of the given number of frames
+		static constexpr unsigned PacketBytes(unsigned frames) {return headerBytes + frames * Channels * 2 + 2;}
+
+		Telemetry(uint32_t sampleRate = 48000, unsigned decimation = 1) : rate(sampleRate), decim(decimation ? decimation : 1), count(0), dropped(0), droppedSent(0), sequence(0)
+		{
+			for (unsigned c=0; c<Channels; c++) frame.v[c] = 0;
+		}
+
+		/// Set channel ch of the next frame (audio core)
+		void __not_in_flash_func(Set)(unsigned ch, int16_t value) {frame.v[ch] = value;}
+
+		/// Queue the frame (audio core), returning false if it was dropped because the queue is full
+		bool __not_in_flash_func(Send)()
+		{
+			if (++count < decim) return true;
+			count = 0;
+			if (ring.Push(frame)) return true;
+			__atomic_store_n(&dropped, dropped + 1, __ATOMIC_RELEASE);
+			return false;
+		}
+
+		/// Number of frames dropped so far
+		uint32_t Dropped() const {return __atomic_load_n(&dropped, __ATOMIC_ACQUIRE);}
+
+		/// Frames waiting to be sent
+		unsigned Queued() const {return ring.Size();}
+
+		/** \brief Build a packet of up to maxFrames queued frames into out (other core)
+
+			out must hold PacketBytes(maxFrames) bytes. Returns the packet length, or 0 if no frames are queued.
+		*/
+		unsigned Packet(uint8_t *out, unsigned maxFrames)
+		{
+			unsigned n = 0;
+			uint8_t *p = out + headerBytes;
+			Frame f;
+			while (n < maxFrames && n < 65535 && ring.Pop(f))
+			{
+				for (unsigned c=0; c<Channels; c++)
+				{
+					*p++ = uint8_t(f.v[c]);
+					*p++ = uint8_t(uint16_t(f.v[c]) >> 8);
+				}
+				n++;
+			}
+			if (n == 0) return 0;
+
+			uint32_t d = Dropped();
+			uint32_t r = rate / decim;
+			uint8_t header[headerBytes] = {'C', 'T', uint8_t(Channels), uint8_t(d != droppedSent),
+										   uint8_t(sequence), uint8_t(sequence >> 8), uint8_t(n), uint8_t(n >> 8),
+										   uint8_t(r), uint8_t(r >> 8), uint8_t(r >> 16), uint8_t(r >> 24)};
+			for (unsigned i=0; i<headerBytes; i++) out[i] = header[i];
+			droppedSent = d;
+			sequence++;
+
+			// Fletcher-16, reduced every 2048 bytes rather than every byte
+			uint32_t s1 = 0, s2 = 0;
+			unsigned k = 0;
+			for (uint8_t *q = out + 2; q < p; q++)
+			{
+				s1 += *q;
+				s2 += s1;
+				if (++k == 2048)
+				{
+					s1 %= 255;
+					s2 %= 255;
+					k = 0;
+				}
+			}
+			s1 %= 255;
+			s2 %= 255;
+			*p++ = uint8_t(s1);
+			*p++ = uint8_t(s2);
+			return unsigned(p - out);
+		}
+
+	private:
+		struct Frame
+		{
+			int16_t v[Channels];
+		};
+
+		Ring<Frame, N> ring;
+		Frame frame;
+		uint32_t rate;
+		unsigned decim, count;
+		uint32_t dropped;              // written by the audio core only
+		uint32_t droppedSent;          // the rest by the sending core only
+		uint16_t sequence;
+	};
+
+	/** \brief Coalescing, rate-limited MIDI CC output, from the audio core to the USB core
+
+		NumSlots controllers, each given a MIDI channel and CC number with Assign. The audio
+		core only writes each controller's latest value with Set, as often as it likes. The
+		USB core calls Poll, which writes a CC message for each controller whose value has
+		changed since it was last sent, but no more than once per that controller's minimum
+		interval: intermediate values are dropped, and the latest is sent once the interval
+		has passed. Messages are written as one byte stream, so that a single
+		tud_midi_stream_write (or tuh_midi_stream_write) packs them into as few USB packets
+		as possible. Controllers are scanned round-robin, so a small buffer is shared fairly.
+	*/
+	template <unsigned NumSlots>
+	class MIDICCOut
+	{
+		static_assert(NumSlots > 0, "MIDICCOut needs at least one controller");
+	public:
+		MIDICCOut() : next(0)
+		{
+			for (unsigned i=0; i<NumSlots; i++)
+			{
+				Assign(i, 0, i & 0x7F);
+				value[i] = 0;
+			}
+		}
+
+		/// Send slot i as controller ccNum on channel (0-15), at most once per minInterval, in the units of Poll's now
+		void Assign(unsigned i, uint8_t channel, uint8_t ccNum, uint32_t minInterval = 0)
+		{
+			status[i] = 0xB0 | (channel & 0x0F);
+			cc[i] = ccNum & 0x7F;
+			interval[i] = minInterval;
+			sent[i] = unsent;
+			lastSent[i] = 0;
+		}
+
+		/// Set the latest value (0-127) of slot i (audio core)
+		void __not_in_flash_func(Set)(unsigned i, uint8_t v) {value[i] = v & 0x7F;}
+
+		/// Send every controller again on the next Poll, even if unchanged, e.g. when USB connects (USB core)
+		void ResendAll()
+		{
+			for (unsigned i=0; i<NumSlots; i++) sent[i] = unsent;
+		}
+
+		/** \brief Write CC messages for changed controllers to out (USB core)
+
+			now is any increasing time (e.g. time_us_32()), in the units of the intervals given
+			to Assign. Returns the number of bytes written, a multiple of 3 and at most maxBytes.
+		*/
+		unsigned Poll(uint8_t *out, unsigned maxBytes, uint32_t now)
+		{
+			unsigned n = 0;
+			unsigned i = next;
+			for (unsigned k=0; k<NumSlots; k++)
+			{
+				uint8_t v = value[i];
+				if (v != sent[i] && (sent[i] == unsent || now - lastSent[i] >= interval[i]))
+				{
+					if (n + 3 > maxBytes)
+					{
+						next = i; // start here next time
+						return n;
+					}
+					out[n++] = status[i];
+					out[n++] = cc[i];
+					out[n++] = v;
+					sent[i] = v;
+					lastSent[i] = now;
+				}
+				if (++i == NumSlots) i = 0;
+			}
+			return n;
+		}
+
+	private:
+		static constexpr uint8_t unsent = 0xFF;
+
+		volatile uint8_t value[NumSlots];  // written by the audio core only
+		uint8_t status[NumSlots], cc[NumSlots], sent[NumSlots]; // the rest by the USB core only
+		uint32_t interval[NumSlots], lastSent[NumSlots];
+		unsigned next;
+	};
+
+	/// Circular buffer for delay lines and loopers, as on the hardware
+	template <typename T, unsigned N>
+	class RingBuffer
+	{
+		static_assert(N > 1, "RingBuffer needs at least two items");
+		static constexpr bool pow2 = (N & (N - 1)) == 0;
+	public:
+		RingBuffer() : writeInd(0)
+		{
+			for (unsigned i = 0; i < N; i++) buf[i] = 0;
+		}
+
+		/// Add the newest item, overwriting the oldest
+		void __not_in_flash_func(Write)(T val)
+		{
+			buf[writeInd] = val;
+			writeInd = Wrap(writeInd + 1);
+		}
+
+		/// Add n items, oldest first
+		void __not_in_flash_func(WriteBlock)(const T *vals, unsigned n)
+		{
+			for (unsigned i = 0; i < n; i++) Write(vals[i]);
+		}
+
+		/// Item delay samples behind the newest
+		T __not_in_flash_func(Read)(unsigned delay) const
+		{
+			return buf[Behind(delay)];
+		}
+
+		/// Copy out n items, oldest first, the newest being delay samples behind the newest written
+		void __not_in_flash_func(ReadBlock)(T *vals, unsigned n, unsigned delay = 0) const
+		{
+			unsigned ind = Behind(delay + n - 1);
+			for (unsigned i = 0; i < n; i++)
+			{
+				vals[i] = buf[ind];
+				ind = Wrap(ind + 1);
+			}
+		}
+
+		/// Item delay128/128 samples behind the newest, linearly interpolated
+		T __not_in_flash_func(ReadInterp)(uint32_t delay128) const
+		{
+			int32_t r = delay128 & 0x7F;
+			unsigned ind1 = Behind(delay128 >> 7);
+			int32_t fromBuffer1 = buf[ind1];
+			int32_t fromBuffer2 = buf[Older(ind1)];
+			return (fromBuffer2 * r + fromBuffer1 * (128 - r)) >> 7;
+		}
+
+		/// Two interpolated taps at once, as ReadInterp, e.g. for left and right channels
+		void __not_in_flash_func(ReadInterp)(uint32_t delay128A, uint32_t delay128B, T &a, T &b) const
+		{
+			a = ReadInterp(delay128A);
+			b = ReadInterp(delay128B);
+		}
+
+		/// Item at absolute position ind (less than N), e.g. for a loop recorded since Reset
+		T &operator[](unsigned ind) {return buf[ind];}
+		const T &operator[](unsigned ind) const {return buf[ind];}
+
+		/// Position that the next Write will go to
+		unsigned WriteIndex() const {return writeInd;}
+		/// Make the next Write go to position 0, without clearing the contents
+		void Reset() {writeInd = 0;}
+
+	private:
+		static unsigned __not_in_flash_func(Wrap)(unsigned ind)
+		{
+			if (pow2) return ind & (N - 1);
+			return ind >= N ? ind - N : ind;
+		}
+		unsigned __not_in_flash_func(Behind)(unsigned delay) const
+		{
+			if (pow2) return (writeInd - 1 - delay) & (N - 1);
+			return Wrap(writeInd + (N - 1) - delay);
+		}
+		static unsigned __not_in_flash_func(Older)(unsigned ind)
+		{
+			if (pow2) return (ind - 1) & (N - 1);
+			return ind == 0 ? N - 1 : ind - 1;
+		}
+
+		unsigned writeInd;
+		T buf[N];
+	};
+
+	/** \brief Log-structured settings store, as on the RP2040
+
+		On the host, the flash sectors are emulated in RAM, starting erased at each run.
+	*/
+	template <unsigned MaxBytes, unsigned NumSectors = 4>
+	class FlashStore
+	{
+		static constexpr unsigned SectorBytes = 4096;
+		static constexpr unsigned PageBytes = 256;
+		static_assert(NumSectors >= 2, "FlashStore needs at least two sectors");
+		static_assert(MaxBytes > 0 && 16 + MaxBytes <= SectorBytes, "FlashStore record must fit in one sector");
+	public:
+		FlashStore(unsigned reserveSectors = 0, uint32_t quietMs = 500) : quietUs(quietMs * 1000)
+		{
+			(void)reserveSectors;
+			memset(flash, 0xFF, sizeof(flash));
+		}
+
+		/// Copy the newest saved record into data, returning false (and leaving data unchanged) if there is none of this size
+		bool Load(void *data, unsigned size)
+		{
+			if (!scanned) Scan();
+			if (!found || RecordHeader(sector, lastPos)->size != size) return false;
+			memcpy(data, FlashPtr(sector * SectorBytes + lastPos + sizeof(Header)), size);
+			return true;
+		}
+
+		/// Copy data (size at most MaxBytes) to be written to flash by Service, once no more saves have been made for the quiet time
+		void Save(const void *data, unsigned size)
+		{
+			if (size > MaxBytes) return;
+			__atomic_store_n(&saveSeq, saveSeq + 1, __ATOMIC_RELEASE); // odd while copying
+			memcpy(pending, data, size);
+			pendingSize = size;
+			saveTime = time_us_32();
+			__atomic_store_n(&saveSeq, saveSeq + 1, __ATOMIC_RELEASE);
+		}
+
+		/// True if a Save has not yet been written to flash
+		bool Pending() const {return __atomic_load_n(&saveSeq, __ATOMIC_ACQUIRE) != writtenSeq;}
+
+		/** \brief Do the next step of writing a pending save: erase a sector, or append a record
+
+			Call regularly (e.g. every pass of a USB loop) from the core not running the audio.
+			Returns true if flash was modified.
+		*/
+		bool Service()
+		{
+			if (!scanned) Scan();
+
+			uint32_t seq = __atomic_load_n(&saveSeq, __ATOMIC_ACQUIRE);
+			if ((seq & 1) || seq == writtenSeq) return false; // nothing new, or Save is copying
+			if (time_us_32() - saveTime < quietUs) return false; // settings still changing
+
+			// Copy out the pending data, and check that no Save overlapped the copy
+			unsigned size = pendingSize;
+			memcpy(record + sizeof(Header), pending, size);
+			if (__atomic_load_n(&saveSeq, __ATOMIC_ACQUIRE) != seq) return false;
+
+			// Skip the write if the data are unchanged
+			if (found && RecordHeader(sector, lastPos)->size == size
+				&& memcmp(FlashPtr(sector * SectorBytes + lastPos + sizeof(Header)), record + sizeof(Header), size) == 0)
+			{
+				writtenSeq = seq;
+				return false;
+			}
+
+			// Move to the next sector (and erase it) if the record doesn't fit in this one;
+			// the record itself is written by the next call, to keep each step short
+			unsigned bytes = RecordBytes(size);
+			if (writePos + bytes > SectorBytes)
+			{
+				nextSector = (sector + 1) % NumSectors;
+				if (!nextErased)
+				{
+					Erase(nextSector * SectorBytes);
+					nextErased = true;
+					return true;
+				}
+				sector = nextSector;
+				writePos = 0;
+				nextErased = false;
+			}
+
+			Header *h = reinterpret_cast<Header *>(record);
+			h->magic = Magic;
+			h->seq = ++recordSeq;
+			h->size = size;
+			h->crc = CRC(record + 4, sizeof(Header) - 8, size);
+			memset(record + sizeof(Header) + size, 0xFF, bytes - sizeof(Header) - size);
+			Program(sector * SectorBytes + writePos, record, bytes);
+
+			found = true;
+			lastPos = writePos;
+			writePos += bytes;
+			writtenSeq = seq;
+			return true;
+		}
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t seq;  // increases by one each record
+			uint32_t size; // of data following header
+			uint32_t crc;  // of seq, size and data
+		};
+		static constexpr uint32_t Magic = 0x43435331; // "CCS1"
+
+		static constexpr unsigned RecordBytes(unsigned size) {return (sizeof(Header) + size + PageBytes - 1) & ~(PageBytes - 1);}
+
+		const Header *RecordHeader(unsigned s, unsigned pos) const {return reinterpret_cast<const Header *>(FlashPtr(s * SectorBytes + pos));}
+
+		// CRC-32 of n bytes of header (the seq and size fields), then size bytes of data following the header
+		static uint32_t CRC(const uint8_t *header, unsigned n, unsigned size)
+		{
+			uint32_t crc = 0xFFFFFFFF;
+			for (unsigned i=0; i<n+size; i++)
+			{
+				crc ^= (i < n) ? header[i] : header[i + 4]; // data starts after the crc field
+				for (int b=0; b<8; b++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+			}
+			return ~crc;
+		}
+
+		// Find the newest valid record, and the first erased page after it
+		void Scan()
+		{
+			found = false;
+			for (unsigned s=0; s<NumSectors; s++)
+			{
+				for (unsigned pos=0; pos + sizeof(Header) <= SectorBytes; pos += PageBytes)
+				{
+					const Header *h = RecordHeader(s, pos);
+					if (h->magic != Magic || h->size > MaxBytes || pos + RecordBytes(h->size) > SectorBytes) continue;
+					if (found && int32_t(h->seq - recordSeq) <= 0) continue;
+					if (CRC(reinterpret_cast<const uint8_t *>(h) + 4, sizeof(Header) - 8, h->size) != h->crc) continue;
+					found = true;
+					recordSeq = h->seq;
+					sector = s;
+					lastPos = pos;
+				}
+			}
+
+			if (found)
+			{
+				// Append after the newest record, and after anything else written to the sector (e.g. an interrupted save)
+				writePos = SectorBytes;
+				const uint8_t *p = FlashPtr(sector * SectorBytes);
+				while (writePos > lastPos + RecordBytes(RecordHeader(sector, lastPos)->size))
+				{
+					bool erased = true;
+					for (unsigned i=writePos-PageBytes; i<writePos && erased; i++) erased = (p[i] == 0xFF);
+					if (!erased) break;
+					writePos -= PageBytes;
+				}
+			}
+			else
+			{
+				// No records: the first save erases sector 0
+				sector = NumSectors - 1;
+				writePos = SectorBytes;
+			}
+			scanned = true;
+		}
+
+		const uint8_t *FlashPtr(uint32_t offset) const {return flash + offset;}
+
+		void Erase(uint32_t offset) {memset(flash + offset, 0xFF, SectorBytes);}
+
+		// Programming can only clear bits, as in flash
+		void Program(uint32_t offset, const uint8_t *data, unsigned n)
+		{
+			for (unsigned i=0; i<n; i++) flash[offset + i] &= data[i];
+		}
+
+		uint32_t quietUs;
+		uint8_t flash[NumSectors * SectorBytes];
+		uint8_t pending[MaxBytes];
+		alignas(4) uint8_t record[(16 + MaxBytes + PageBytes - 1) & ~(PageBytes - 1)];
+		unsigned pendingSize = 0;
+		volatile uint32_t saveTime = 0;
+		uint32_t saveSeq = 0, writtenSeq = 0; // count of Save calls started/finished (x2), and last written
+		uint32_t recordSeq = 0;               // seq of newest record in flash
+		unsigned sector = 0, lastPos = 0, writePos = 0, nextSector = 0;
+		bool scanned = false, found = false, nextErased = false;
+	};
+
+	/** \brief Large fixed-size slots in flash, saved in the background, as on the RP2040
+
+		On the host, the flash sectors are emulated in RAM, starting erased at each run.
+	*/
+	template <unsigned SlotBytes, unsigned NumSlots>
+	class FlashSlots
+	{
+		static constexpr unsigned SectorBytes = 4096;
+		static constexpr unsigned PageBytes = 256;
+		static_assert(SlotBytes > 0 && NumSlots > 0, "FlashSlots needs at least one slot");
+	public:
+		/// Sectors taken by each slot: a header page, then the data
+		static constexpr unsigned SlotSectors = (PageBytes + SlotBytes + SectorBytes - 1) / SectorBytes;
+
+		FlashSlots(unsigned reserveSectors = 0)
+		{
+			(void)reserveSectors;
+			memset(flash, 0xFF, sizeof(flash));
+		}
+
+		/// Number of bytes saved in slot, or 0 if it is empty
+		unsigned Size(unsigned slot) const {return Valid(slot) ? SlotHeader(slot)->size : 0;}
+		/// Tag word given to Save for slot
+		uint32_t Tag(unsigned slot) const {return Valid(slot) ? SlotHeader(slot)->tag : 0;}
+		/// Contents of slot, in flash. Not to be read while Busy
+		const uint8_t *Data(unsigned slot) const {return FlashPtr(slot * SlotSectors * SectorBytes + PageBytes);}
+
+		/// The most recently saved slot, or -1 if all are empty
+		int Newest() const
+		{
+			int newest = -1;
+			for (unsigned s=0; s<NumSlots; s++)
+			{
+				if (Valid(s) && (newest < 0 || int32_t(SlotHeader(s)->seq - SlotHeader(newest)->seq) > 0)) newest = s;
+			}
+			return newest;
+		}
+
+		/** \brief Start saving size bytes (at most SlotBytes) of data to slot
+
+			Returns false, doing nothing, if a save is already in progress.
+			data must stay valid until Busy returns false.
+		*/
+		bool Save(unsigned slot, const void *data, unsigned size, uint32_t tag = 0)
+		{
+			if (slot >= NumSlots || size == 0 || size > SlotBytes || Busy()) return false;
+			saveSlot = slot;
+			saveData = static_cast<const uint8_t *>(data);
+			saveSize = size;
+			saveTag = tag;
+			step = 0;
+			__atomic_store_n(&busy, true, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		/// True from Save until the slot has been written
+		bool Busy() const {return __atomic_load_n(&busy, __ATOMIC_ACQUIRE);}
+
+		/** \brief Do the next step of a save in progress: erase a sector, or program a page
+
+			Call regularly from the core not running the audio. Sectors are erased first,
+			starting with the one holding the header, then the data pages are programmed
+			in order, then the header. Returns true if flash was modified.
+		*/
+		bool Service()
+		{
+			if (!Busy()) return false;
+
+			uint32_t slotOffset = saveSlot * SlotSectors * SectorBytes;
+			unsigned sectors = (PageBytes + saveSize + SectorBytes - 1) / SectorBytes;
+			unsigned pages = (saveSize + PageBytes - 1) / PageBytes;
+			if (step < sectors)
+			{
+				Erase(slotOffset + step * SectorBytes);
+			}
+			else if (step < sectors + pages)
+			{
+				unsigned offset = (step - sectors) * PageBytes;
+				unsigned n = saveSize - offset < PageBytes ? saveSize - offset : PageBytes;
+				memcpy(page, saveData + offset, n);
+				memset(page + n, 0xFF, PageBytes - n);
+				Program(slotOffset + PageBytes + offset, page);
+			}
+			else
+			{
+				int newest = Newest();
+				Header *h = reinterpret_cast<Header *>(page);
+				h->magic = Magic;
+				h->seq = newest < 0 ? 1 : SlotHeader(newest)->seq + 1;
+				h->size = saveSize;
+				h->tag = saveTag;
+				h->check = Check(h);
+				memset(page + sizeof(Header), 0xFF, PageBytes - sizeof(Header));
+				Program(slotOffset, page);
+				__atomic_store_n(&busy, false, __ATOMIC_RELEASE);
+			}
+			step++;
+			return true;
+		}
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t seq;   // one more than the newest slot's, at each save
+			uint32_t size;  // of data following the header page
+			uint32_t tag;
+			uint32_t check; // of seq, size and tag
+		};
+		static constexpr uint32_t Magic = 0x4343534C; // "CCSL"
+
+		static uint32_t Check(const Header *h) {return ~(h->seq ^ (h->size * 0x9E3779B1) ^ (h->tag * 0x85EBCA77));}
+
+		const Header *SlotHeader(unsigned slot) const {return reinterpret_cast<const Header *>(FlashPtr(slot * SlotSectors * SectorBytes));}
+
+		bool Valid(unsigned slot) const
+		{
+			if (slot >= NumSlots) return false;
+			const Header *h = SlotHeader(slot);
+			return h->magic == Magic && h->size > 0 && h->size <= SlotBytes && h->check == Check(h);
+		}
+
+		const uint8_t *FlashPtr(uint32_t offset) const {return flash + offset;}
+
+		void Erase(uint32_t offset) {memset(flash + offset, 0xFF, SectorBytes);}
+
+		// Programming can only clear bits, as in flash
+		void Program(uint32_t offset, const uint8_t *data)
+		{
+			for (unsigned i=0; i<PageBytes; i++) flash[offset + i] &= data[i];
+		}
+
+		uint8_t flash[NumSlots * SlotSectors * SectorBytes];
+		alignas(4) uint8_t page[PageBytes];
+		const uint8_t *saveData = nullptr;
+		unsigned saveSlot = 0, saveSize = 0, step = 0;
+		uint32_t saveTag = 0;
+		bool busy = false;
+	};
+
+	/** \brief A card's state, restored at power-on and saved to flash in the background, as on the RP2040
+
+		On the host, the FlashStore it uses starts empty at each run, so Restore finds nothing.
+	*/
+	template <unsigned MaxBytes, unsigned NumSectors = 4>
+	class Snapshot
+	{
+		static constexpr unsigned MaxRegions = 16;
+		static_assert(MaxBytes + 4 + 16 <= 4096, "Snapshot must fit in one flash sector");
+	public:
+		Snapshot(unsigned reserveSectors = 0, uint32_t idleMs = 2000)
+			: store(reserveSectors, 0), idleUs(idleMs * 1000) {}
+
+		/// Add size bytes at data to the state, in the card's constructor; returns false if there is no room
+		bool Add(void *data, unsigned size)
+		{
+			if (numRegions == MaxRegions || totalBytes + size > MaxBytes) return false;
+			regions[numRegions++] = {static_cast<uint8_t *>(data), size};
+			totalBytes += size;
+			return true;
+		}
+
+		/// Add a variable or array to the state
+		template <typename T>
+		bool Add(T &value) {return Add(&value, sizeof(T));}
+
+		/// Copy the last snapshot saved into the state added, returning false (leaving it unchanged) if there is none of this layout
+		bool Restore()
+		{
+			if (!store.Load(buffer, 4 + totalBytes)) return false;
+			uint32_t check;
+			memcpy(&check, buffer, 4);
+			if (check != Layout()) return false;
+			Unpack();
+			return true;
+		}
+
+		/// Copy the state, to be written to flash by Service
+		void __not_in_flash_func(Capture)()
+		{
+			uint32_t check = Layout();
+			memcpy(buffer, &check, 4);
+			unsigned pos = 4;
+			for (unsigned i=0; i<numRegions; i++)
+			{
+				memcpy(buffer + pos, regions[i].data, regions[i].size);
+				pos += regions[i].size;
+			}
+			store.Save(buffer, pos);
+			changed = false;
+		}
+
+		/** \brief Idle heuristic: call once per sample or block, with whether the card's controls have changed
+
+			Captures the state once the controls have been still for the idle time (the second
+			constructor argument, 2s by default) after a change, so that a settled setting is
+			saved before the power goes, and nothing is written while it is being adjusted.
+		*/
+		void __not_in_flash_func(Update)(bool controlsChanged)
+		{
+			uint32_t now = time_us_32();
+			if (controlsChanged)
+			{
+				changed = true;
+				changeTime = now;
+			}
+			else if (changed && now - changeTime >= idleUs) Capture();
+		}
+
+		/// True from a Capture until it has been written to flash
+		bool Pending() const {return store.Pending();}
+
+		/// Do the next step of writing a capture, as FlashStore::Service; returns true if flash was modified
+		bool Service() {return store.Service();}
+
+	private:
+		struct Region
+		{
+			uint8_t *data;
+			unsigned size;
+		};
+
+		// Sizes of the regions added, so a snapshot from a build with other state isn't restored
+		uint32_t Layout() const
+		{
+			uint32_t h = 0x811C9DC5;
+			for (unsigned i=0; i<numRegions; i++) h = (h ^ regions[i].size) * 0x01000193;
+			return h;
+		}
+
+		void Unpack()
+		{
+			unsigned pos = 4;
+			for (unsigned i=0; i<numRegions; i++)
+			{
+				memcpy(regions[i].data, buffer + pos, regions[i].size);
+				pos += regions[i].size;
+			}
+		}
+
+		FlashStore<MaxBytes + 4, NumSectors> store;
+		Region regions[MaxRegions];
+		unsigned numRegions = 0, totalBytes = 0;
+		uint8_t buffer[MaxBytes + 4];
+		uint32_t idleUs, changeTime = 0;
+		bool changed = false;
+	};
+
+	class SampleStream;
+
+	/** \brief Index of the WAV samples uploaded to the top of flash by examples/sample_upload/generate_sample_uf2.html
+
+		The UF2 generator writes a pre-validated index ahead of the WAV files, giving each
+		file's sample data address, length, sample rate and loop points (from the WAV 'smpl'
+		chunk, or the whole file if it has none). The constructor just checks the index, so
+		there is no walking of RIFF headers through flash at boot, and Get is a single lookup.
+		Samples are 16-bit mono PCM, or, if the generator was asked to compress them, 8-bit
+		u-law (2:1) or 4-bit IMA ADPCM (4:1), given by the index's format word. ADPCM samples
+		are coded in blocks of 256 samples, each starting with a header giving the decoder
+		state, so that any block can be decoded on its own. UF2s from earlier versions of the
+		generator, with no index, give an empty bank and need regenerating.
+
+		On the host, the UF2 file named by COMPUTERCARD_SAMPLES is read into an image of
+		flash, and each block is copied to its voice as soon as it is queued.
+	*/
+	class SampleBank
+	{
+	public:
+		enum Format
+		{
+			PCM16 = 0, // 16-bit samples
+			MuLaw = 1, // 8-bit u-law (G.711) samples
+			ADPCM = 2  // IMA ADPCM blocks of 256 samples: the first sample (int16) and step index (uint8, then a zero byte), then 4-bit codes for the other 255 samples, low nibble first
+		};
+		static constexpr unsigned MuLawBlockBytes = 256, ADPCMBlockBytes = 132;
+
+		struct Sample
+		{
+			const void *data;    // in flash
+			uint32_t length;     // in samples
+			uint32_t sampleRate;
+			uint32_t loopStart;  // loop from loopStart up to (but not including) loopEnd
+			uint32_t loopEnd;
+			Format format;
+		};
+
+		/// On the host, reads the samples from the UF2 file named by the environment variable COMPUTERCARD_SAMPLES
+		SampleBank() {Reload();}
+
+		/// Read the UF2 file again; returns the new Count()
+		unsigned Reload()
+		{
+			count = 0;
+			index.clear();
+			const char *name = std::getenv("COMPUTERCARD_SAMPLES");
+			if (!name || !LoadUF2(name)) return 0;
+
+			const uint8_t *footer = At(flashEnd - 256, 16);
+			if (!footer || Word(footer, 2) != Magic) return 0;
+			uint32_t indexAddress = Word(footer, 3);
+			const uint8_t *h = At(indexAddress, sizeof(Header));
+			if (!h) return 0;
+
+			Header hdr;
+			memcpy(&hdr, h, sizeof(hdr));
+			if (hdr.magic != Magic || hdr.count == 0 || hdr.count > MaxSamples || !At(indexAddress, sizeof(Header) + hdr.count * sizeof(Entry))) return 0;
+			index.resize(hdr.count);
+			memcpy(index.data(), h + sizeof(Header), hdr.count * sizeof(Entry));
+			if (hdr.check != Check(reinterpret_cast<const uint32_t *>(index.data()), hdr.count * sizeof(Entry) / 4) || hdr.format > ADPCM) {index.clear(); return 0;}
+			format = Format(hdr.format);
+
+			for (const Entry &e : index)
+			{
+				if (!At(e.address, DataBytes(format, e.length))) {index.clear(); return 0;}
+			}
+			count = hdr.count;
+			return count;
+		}
+
+		/// Number of samples in the bank, 0 if no valid index was found
+		unsigned Count() const {return count;}
+
+		/// On the host, blocks are read at once, so never busy
+		bool Busy() const {return false;}
+
+		/// Sample number i (i < Count())
+		Sample Get(unsigned i) const
+		{
+			const Entry &e = index[i];
+			return Sample{At(e.address, DataBytes(format, e.length)), e.length, e.sampleRate, e.loopStart, e.loopEnd, format};
+		}
+
+	private:
+		friend class SampleStream;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t count;
+			uint32_t check; // of the entries
+			uint32_t format; // for all samples; 0 (16-bit PCM) from generators before compression was added
+		};
+		struct Entry
+		{
+			uint32_t address, length, sampleRate, loopStart, loopEnd;
+		};
+		static constexpr uint32_t Magic = 0x49534343; // "CCSI"
+		static constexpr unsigned MaxSamples = 1024;
+
+		// Bytes of flash taken by length samples in format f, as padded by the generator
+		static uint32_t DataBytes(uint32_t f, uint32_t length)
+		{
+			if (f == MuLaw) return (length + 3) & ~3u;
+			if (f == ADPCM) return ((length + 255) >> 8) * ADPCMBlockBytes;
+			return length * 2;
+		}
+
+		static int16_t __not_in_flash_func(DecodeMuLaw)(uint8_t u)
+		{
+			u = ~u;
+			int32_t t = (((u & 0x0F) << 3) + 0x84) << ((u & 0x70) >> 4);
+			return int16_t((u & 0x80) ? 0x84 - t : t - 0x84);
+		}
+
+		// Decode the 4-bit code in the low bits of nibble, updating the predicted sample and step index
+		static void __not_in_flash_func(DecodeADPCM)(int32_t &pred, int32_t &index, unsigned nibble)
+		{
+			static constexpr int16_t stepTable[89] = {
+				7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+				50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+				337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+				2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+				15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+			static constexpr int8_t indexTable[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+			int32_t step = stepTable[index];
+			int32_t diff = step >> 3;
+			if (nibble & 4) diff += step;
+			if (nibble & 2) diff += step >> 1;
+			if (nibble & 1) diff += step >> 2;
+			pred += (nibble & 8) ? -diff : diff;
+			if (pred > 32767) pred = 32767; else if (pred < -32768) pred = -32768;
+			index += indexTable[nibble & 7];
+			if (index < 0) index = 0; else if (index > 88) index = 88;
+		}
+
+		static uint32_t Check(const uint32_t *w, unsigned n)
+		{
+			uint32_t h = 0x811C9DC5;
+			for (unsigned i=0; i<n; i++) h = (h ^ w[i]) * 0x01000193;
+			return h;
+		}
+
+		static uint32_t Word(const uint8_t *p, unsigned i) {return p[4*i] | (p[4*i+1] << 8) | (p[4*i+2] << 16) | (uint32_t(p[4*i+3]) << 24);}
+
+		// Host pointer to size bytes of flash at RP2040 address, or nullptr if not all in the UF2
+		const uint8_t *At(uint32_t address, uint32_t size) const
+		{
+			if (address < flashStart || address > flashEnd || size > flashEnd - address) return nullptr;
+			return image.data() + (address - flashStart);
+		}
+
+		// Copy the payload of each UF2 block into an image of flash, from the lowest address written to the highest
+		bool LoadUF2(const char *name)
+		{
+			FILE *f = std::fopen(name, "rb");
+			if (!f)
+			{
+				std::fprintf(stderr, "SampleBank: can't open %s\n", name);
+				return false;
+			}
+			std::vector<uint8_t> uf2;
+			uint8_t block[512];
+			while (std::fread(block, 1, 512, f) == 512) uf2.insert(uf2.end(), block, block + 512);
+			std::fclose(f);
+
+			flashStart = 0xFFFFFFFF; flashEnd = 0;
+			for (size_t p=0; p<uf2.size(); p+=512)
+			{
+				const uint8_t *blk = &uf2[p];
+				if (Word(blk, 0) != 0x0A324655 || Word(blk, 1) != 0x9E5D5157 || Word(blk, 4) > 476) continue;
+				if (Word(blk, 3) < flashStart) flashStart = Word(blk, 3);
+				if (Word(blk, 3) + Word(blk, 4) > flashEnd) flashEnd = Word(blk, 3) + Word(blk, 4);
+			}
+			if (flashEnd <= flashStart) return false;
+
+			image.assign(flashEnd - flashStart, 0xFF);
+			for (size_t p=0; p<uf2.size(); p+=512)
+			{
+				const uint8_t *blk = &uf2[p];
+				if (Word(blk, 0) != 0x0A324655 || Word(blk, 1) != 0x9E5D5157 || Word(blk, 4) > 476) continue;
+				memcpy(&image[Word(blk, 3) - flashStart], blk + 32, Word(blk, 4));
+			}
+			return true;
+		}
+
+		void __not_in_flash_func(Queue)(SampleStream *s)
+		{
+			uint32_t *dst; const uint32_t *src; unsigned words;
+			if (!s->FillSource(dst, src, words)) return;
+			memcpy(dst, src, words * 4);
+			s->Filled();
+		}
+
+		std::vector<uint8_t> image;
+		uint32_t flashStart = 0, flashEnd = 0;
+		std::vector<Entry> index;
+		unsigned count = 0;
+		Format format = PCM16;
+	};
+
+	/** \brief Sample playback voice, reading from SRAM blocks streamed from flash by a SampleBank
+
+		Holds two blocks of BlockSamples samples: while the play position is in one, the next
+		block to be played (allowing for looping) is read into the other in the background.
+		If the play position gets ahead of the streaming (just after Play, or with many voices
+		at high speed), samples are read directly from flash until the block arrives, so
+		playback is always correct, just slower for those samples.
+
+		The play position is a sample index plus a 24-bit fraction, so that speeds (in 2^24ths
+		of a sample per output sample) are precise enough for pitch-tracked playback.
+
+		Compressed (u-law or IMA ADPCM) blocks are streamed into the end of their SRAM buffer
+		and decoded in place, a few samples ahead of the play position at a time, so the
+		decoding cost is spread evenly over playback rather than falling on one sample.
+	*/
+	class SampleStream
+	{
+	public:
+		static constexpr unsigned BlockSamples = 256;
+
+		SampleStream() {slotBlock[0] = slotBlock[1] = -1;}
+
+		/// Start playing sample i of bank from the beginning, looping between its loop points if loop is true
+		void __not_in_flash_func(Play)(SampleBank &bank, unsigned i, bool loop = false)
+		{
+			if (i >= bank.Count()) {Stop(); return;}
+			b = &bank;
+			s = bank.Get(i);
+			end = loop ? s.loopEnd : s.length;
+			looping = loop && s.loopEnd > s.loopStart;
+			uintptr_t address = reinterpret_cast<uintptr_t>(s.data);
+			skew = (s.format == SampleBank::PCM16) ? (address & 2) >> 1 : 0;
+			// Compressed blocks can only be streamed if word-aligned, as the generator writes them
+			streamed = (s.format == SampleBank::PCM16) || !(address & 3);
+			idx = 0;
+			frac = 0;
+			wrapped = false;
+			playing = s.length > 0;
+			gen++;
+			slotBlock[0] = slotBlock[1] = -1;
+			fastBase = NoBlock;
+			cursor = NoBlock;
+			Prefetch();
+		}
+
+		/// Stop playing: Next then returns 0
+		void Stop() {playing = false;}
+
+		bool Playing() const {return playing;}
+
+		/// True if the last call to Next or Render reached the end of the sample, or the loop end
+		bool Wrapped() const {return wrapped;}
+
+		/// Sample rate of the sample being played
+		uint32_t SampleRate() const {return s.sampleRate;}
+
+		/// Play position, in samples, as a fixed-point number with 8 fractional bits
+		uint32_t Position() const {return (idx << 8) | (frac >> 16);}
+
+		/** \brief Return the sample at the play position, linearly interpolated, then advance
+
+			The position advances by speed/256 samples, so 256 plays at the original pitch
+			if the sample rate is the same as the card's.
+		*/
+		int16_t __not_in_flash_func(Next)(uint32_t speed)
+		{
+			wrapped = false;
+			if (!playing) return 0;
+
+			uint32_t j = idx + 1;
+			if (j >= end) j = looping ? s.loopStart : idx;
+			int32_t r = frac >> 16;
+			int32_t out = (At(idx) * (256 - r) + At(j) * r) >> 8;
+
+			if (Advance(speed << 16)) Prefetch();
+			return int16_t(out);
+		}
+
+		/** \brief Add n samples, interpolated and scaled by a ramped gain, to out
+
+			The position advances by inc/2^24 samples per output sample. The gain starts at
+			gain (0 to 2^31-1, 2^31 being unity) and changes by gainStep each sample.
+			Reads within the decoded part of the current SRAM block take a short path with
+			no block lookup.
+		*/
+		void __not_in_flash_func(Render)(int32_t *out, unsigned n, uint32_t inc, int32_t gain, int32_t gainStep)
+		{
+			wrapped = false;
+			for (unsigned k=0; k<n && playing; k++)
+			{
+				int32_t a, c;
+				uint32_t o = idx - fastBase;
+				if (o < fastLimit)
+				{
+					a = fastBuf[o];
+					c = fastBuf[o + 1];
+				}
+				else
+				{
+					uint32_t j = idx + 1;
+					if (j >= end) j = looping ? s.loopStart : idx;
+					a = At(idx);
+					c = At(j);
+					SetFastBlock();
+				}
+				int32_t v = a + (((c - a) * int32_t(frac >> 10)) >> 14);
+				out[k] += (v * (gain >> 16)) >> 15;
+				gain += gainStep;
+
+				bool w = Advance(inc);
+				wrapped |= w;
+				if (w) Prefetch();
+			}
+			Prefetch();
+		}
+
+	private:
+		friend class SampleBank;
+		static constexpr unsigned BlockShift = 8;
+		static_assert(BlockSamples == 1u << BlockShift, "SampleStream: BlockShift must match BlockSamples");
+		static constexpr uint32_t NoBlock = 0x80000000;
+		static constexpr unsigned BufWords = (BlockSamples + 2) / 2;
+		static_assert(SampleBank::MuLawBlockBytes == BlockSamples && SampleBank::ADPCMBlockBytes == 4 + BlockSamples / 2,
+					  "SampleStream: compressed block sizes must match BlockSamples");
+		// Samples decoded at a time, once the play position reaches the undecoded part of a block
+		static constexpr unsigned DecodeAhead = 16;
+
+		// Move the play position on by inc/2^24 samples. Returns true if it reached the end
+		bool __not_in_flash_func(Advance)(uint32_t inc)
+		{
+			frac += inc & 0x00FFFFFF;
+			idx += (inc >> 24) + (frac >> 24);
+			frac &= 0x00FFFFFF;
+			if (idx < end) return false;
+
+			if (looping)
+			{
+				idx = s.loopStart + (idx - end) % (end - s.loopStart);
+			}
+			else
+			{
+				playing = false;
+			}
+			return true;
+		}
+
+		int32_t __not_in_flash_func(At)(uint32_t i)
+		{
+			int32_t k = i >> BlockShift;
+			unsigned o = i & (BlockSamples - 1);
+			for (unsigned slot=0; slot<2; slot++)
+			{
+				if (slotBlock[slot] != k) continue;
+				if (o >= slotDecoded[slot]) Decode(slot, o + DecodeAhead);
+				return buf[slot][o + skew];
+			}
+			return FromFlash(i);
+		}
+
+		// Sample i read directly from flash
+		int32_t __not_in_flash_func(FromFlash)(uint32_t i)
+		{
+			const uint8_t *data = static_cast<const uint8_t *>(s.data);
+			switch (s.format)
+			{
+			case SampleBank::MuLaw:
+				return SampleBank::DecodeMuLaw(data[i]);
+			case SampleBank::ADPCM:
+			{
+				// Carry on from the last sample read if possible, else from the start of its block
+				if (i == cursor) return cursorPred;
+				if (i + 1 == cursor && (cursor & (BlockSamples - 1))) return cursorPrev;
+				uint32_t k = i >> BlockShift;
+				const uint8_t *block = data + k * SampleBank::ADPCMBlockBytes;
+				if (cursor == NoBlock || (cursor >> BlockShift) != k || i < cursor)
+				{
+					cursor = k << BlockShift;
+					cursorPred = cursorPrev = int16_t(block[0] | (block[1] << 8));
+					cursorIndex = (block[2] > 88) ? 88 : block[2];
+				}
+				while (cursor < i)
+				{
+					unsigned m = cursor & (BlockSamples - 1);
+					cursorPrev = cursorPred;
+					SampleBank::DecodeADPCM(cursorPred, cursorIndex, block[4 + (m >> 1)] >> ((m & 1) << 2));
+					cursor++;
+				}
+				return cursorPred;
+			}
+			default:
+				return static_cast<const int16_t *>(s.data)[i];
+			}
+		}
+
+		// Decode a streamed compressed block in place, up to sample o (or the end of the block)
+		void __not_in_flash_func(Decode)(unsigned slot, unsigned o)
+		{
+			if (o > BlockSamples - 1) o = BlockSamples - 1;
+			int16_t *dst = buf[slot];
+			const uint8_t *raw = reinterpret_cast<const uint8_t *>(buf[slot]) + RawOffset();
+			unsigned n = slotDecoded[slot];
+			if (s.format == SampleBank::MuLaw)
+			{
+				// Sample n overwrites raw bytes before raw[n+1], so is safe to write in order
+				for (; n <= o; n++) dst[n] = SampleBank::DecodeMuLaw(raw[n]);
+			}
+			else
+			{
+				int32_t pred = slotPred[slot], index = slotIndex[slot];
+				if (n == 0)
+				{
+					pred = int16_t(raw[0] | (raw[1] << 8));
+					index = (raw[2] > 88) ? 88 : raw[2];
+					dst[n++] = int16_t(pred);
+				}
+				for (; n <= o; n++)
+				{
+					SampleBank::DecodeADPCM(pred, index, raw[4 + ((n - 1) >> 1)] >> (((n - 1) & 1) << 2));
+					dst[n] = int16_t(pred);
+				}
+				slotPred[slot] = pred;
+				slotIndex[slot] = index;
+			}
+			slotDecoded[slot] = n;
+		}
+
+		// Byte offset in a buffer at which compressed blocks are streamed, ending at the end of the buffer
+		unsigned RawOffset() const
+		{
+			return (BufWords - ((s.format == SampleBank::MuLaw ? SampleBank::MuLawBlockBytes : SampleBank::ADPCMBlockBytes) >> 2)) << 2;
+		}
+
+		// Point the short read path of Render at the block holding the play position, if it is in SRAM
+		void __not_in_flash_func(SetFastBlock)()
+		{
+			int32_t k = idx >> BlockShift;
+			fastBase = NoBlock;
+			for (unsigned slot=0; slot<2; slot++)
+			{
+				if (slotBlock[slot] == k && slotDecoded[slot] > 1)
+				{
+					fastBase = uint32_t(k) << BlockShift;
+					fastBuf = buf[slot] + skew;
+					fastLimit = slotDecoded[slot] - 1;
+					fastSlot = slot;
+				}
+			}
+		}
+
+		// Block to be played after block k, or -1 if none
+		int32_t NextBlock(int32_t k) const
+		{
+			uint32_t next = uint32_t(k + 1) << BlockShift;
+			if (next < end) return k + 1;
+			return looping ? int32_t(s.loopStart >> BlockShift) : -1;
+		}
+
+		// Queue a read of the current block, if not held, or else of the next block
+		void __not_in_flash_func(Prefetch)()
+		{
+			if (fillPending || !playing || !streamed) return;
+			int32_t k = idx >> BlockShift;
+			int32_t want = k;
+			if (slotBlock[0] == k || slotBlock[1] == k)
+			{
+				want = NextBlock(k);
+				if (want < 0 || slotBlock[0] == want || slotBlock[1] == want) return;
+			}
+			fillSlot = (slotBlock[0] == k) ? 1 : 0;
+			fillBlock = want;
+			fillGen = gen;
+			slotBlock[fillSlot] = -1;
+			if (fastBase != NoBlock && fastSlot == fillSlot) fastBase = NoBlock;
+			fillPending = true;
+			b->Queue(this);
+		}
+
+		// Destination, flash source and length in words of the queued read; false if it is no longer wanted
+		bool __not_in_flash_func(FillSource)(uint32_t *&dst, const uint32_t *&src, unsigned &words)
+		{
+			if (fillGen != gen) {fillPending = false; return false;}
+			uintptr_t data = reinterpret_cast<uintptr_t>(s.data);
+			uintptr_t last = data + SampleBank::DataBytes(s.format, s.length);
+			uintptr_t first;
+			if (s.format == SampleBank::PCM16)
+			{
+				// Stream reads whole words, so start at the word holding the block's first sample
+				first = (data + (uint32_t(fillBlock) << (BlockShift + 1))) & ~uintptr_t(3);
+				words = BlockSamples / 2 + skew;
+				dst = reinterpret_cast<uint32_t *>(buf[fillSlot]);
+			}
+			else
+			{
+				unsigned blockBytes = (s.format == SampleBank::MuLaw) ? SampleBank::MuLawBlockBytes : SampleBank::ADPCMBlockBytes;
+				first = data + uint32_t(fillBlock) * blockBytes;
+				words = blockBytes >> 2;
+				dst = reinterpret_cast<uint32_t *>(buf[fillSlot]) + (RawOffset() >> 2);
+			}
+			src = reinterpret_cast<const uint32_t *>(first);
+			unsigned avail = unsigned((last + 3 - first) >> 2);
+			if (words > avail) words = avail;
+			return true;
+		}
+
+		void __not_in_flash_func(Filled)()
+		{
+			if (fillGen == gen)
+			{
+				slotBlock[fillSlot] = fillBlock;
+				slotDecoded[fillSlot] = (s.format == SampleBank::PCM16) ? BlockSamples : 0;
+			}
+			fillPending = false;
+		}
+
+		SampleBank *b = nullptr;
+		SampleBank::Sample s = {};
+		alignas(4) int16_t buf[2][BlockSamples + 2];
+		int32_t slotBlock[2];
+		unsigned slotDecoded[2] = {0, 0};
+		int32_t slotPred[2] = {0, 0}, slotIndex[2] = {0, 0};
+		uint32_t idx = 0, frac = 0, end = 0;
+		uint32_t fastBase = NoBlock, fastLimit = 0;
+		const int16_t *fastBuf = nullptr;
+		uint32_t cursor = NoBlock;
+		int32_t cursorPred = 0, cursorPrev = 0, cursorIndex = 0;
+		uint32_t gen = 0, fillGen = 0;
+		int32_t fillBlock = 0;
+		unsigned fillSlot = 0, fastSlot = 0, skew = 0;
+		bool playing = false, looping = false, wrapped = false, fillPending = false, streamed = false;
+		SampleStream *nextQueued = nullptr;
+	};
+
+	/** \brief Polyphonic, pitch-tracked sampler: a pool of NumVoices SampleStream voices
+
+		Notes are started by NoteOn (or MIDI note on messages, through MIDI) on a free voice,
+		or else by stealing the quietest releasing voice, or the oldest. Each note is pitched
+		relative to the root note (SetRootNote, middle C by default), allowing for the
+		sample's own sample rate, with pitch bend and a global offset in cents applied at
+		each Render. Notes have a linear attack/release envelope, scaled by velocity.
+
+		Render adds a block of all voices to a mix buffer; the pitch and envelope are
+		updated once per block, and ramped across it, so the per-sample cost of each voice
+		is an interpolated read, a gain and a position update.
+	*/
+	template <unsigned NumVoices>
+	class Sampler
+	{
+	public:
+		Sampler(SampleBank &sampleBank, uint32_t outputSampleRate = 48000) : bank(sampleBank), outputRate(outputSampleRate)
+		{
+			for (unsigned v=0; v<NumVoices; v++) voice[v].state = Idle;
+			SetEnvelope(48, 4800);
+		}
+
+		/// Sample played by MIDI notes (also set by MIDI program change)
+		void SetSample(unsigned i) {sample = i;}
+		unsigned CurrentSample() const {return sample;}
+
+		/// MIDI note number at which samples play at their original pitch
+		void SetRootNote(uint8_t note) {rootNote = note;}
+
+		/// Attack and release times, in samples
+		void SetEnvelope(uint32_t attackSamples, uint32_t releaseSamples)
+		{
+			attack = attackSamples ? attackSamples : 1;
+			release = releaseSamples ? releaseSamples : 1;
+		}
+
+		/// If true, notes loop between the sample's loop points until released
+		void SetLoop(bool loop) {looping = loop;}
+
+		/// Range of MIDI pitch bend, in semitones
+		void SetPitchBendRange(int32_t semitones) {bendRange = semitones;}
+
+		/// Offset in cents added to the pitch of all voices, e.g. from a CV input
+		void SetPitchCents(int32_t cents) {pitchCents = cents;}
+
+		/// Start sample i at MIDI note number note, with velocity 1 to 127. Returns the voice used
+		int NoteOn(unsigned i, uint8_t note, uint8_t velocity)
+		{
+			if (i >= bank.Count()) return -1;
+			unsigned v = FreeVoice();
+			Voice &vc = voice[v];
+			vc.stream.Play(bank, i, looping);
+			// Playback increment at the root note, in 2^24ths of a sample
+			vc.rootInc = uint32_t((uint64_t(vc.stream.SampleRate()) << 24) / outputRate);
+			vc.note = note;
+			vc.peak = int32_t(velocity > 127 ? 127 : velocity) * (0x7FFFFFFF / 127);
+			vc.level = 0;
+			vc.step = vc.peak / int32_t(attack) + 1;
+			vc.state = Attack;
+			vc.age = ++ageCounter;
+			return v;
+		}
+
+		/// Release all notes at note number note
+		void NoteOff(uint8_t note)
+		{
+			for (unsigned v=0; v<NumVoices; v++)
+			{
+				if (voice[v].note == note && (voice[v].state == Attack || voice[v].state == Sustain)) StartRelease(voice[v]);
+			}
+		}
+
+		/// Release all playing notes
+		void AllNotesOff()
+		{
+			for (unsigned v=0; v<NumVoices; v++)
+			{
+				if (voice[v].state == Attack || voice[v].state == Sustain) StartRelease(voice[v]);
+			}
+		}
+
+		/// Handle a MIDI message, on any channel: note on/off, pitch bend, program change and all notes off
+		void MIDI(const MIDIEvent &e)
+		{
+			uint8_t status = e.data[0] & 0xF0;
+			if (status == 0x90 && e.data[2] > 0) NoteOn(sample, e.data[1], e.data[2]);
+			else if (status == 0x80 || status == 0x90) NoteOff(e.data[1]);
+			else if (status == 0xE0) bendCents = ((int32_t(e.data[1] | (e.data[2] << 7)) - 8192) * bendRange * 100) >> 13;
+			else if (status == 0xC0) sample = e.data[1];
+			else if (status == 0xB0 && (e.data[1] == 120 || e.data[1] == 123)) AllNotesOff();
+		}
+
+		/// Add the next n samples of all voices (16-bit scale) to mix
+		void __not_in_flash_func(Render)(int32_t *mix, unsigned n)
+		{
+			for (unsigned v=0; v<NumVoices; v++)
+			{
+				Voice &vc = voice[v];
+				if (vc.state == Idle) continue;
+
+				int32_t gain = vc.level;
+				int32_t step = EnvelopeStep(vc, n);
+				int32_t cents = (int32_t(vc.note) - rootNote) * 100 + bendCents + pitchCents;
+				vc.stream.Render(mix, n, Increment(vc.rootInc, cents), gain, step);
+				if (vc.state == Idle) vc.stream.Stop();
+				else if (!vc.stream.Playing()) vc.state = Idle;
+			}
+		}
+
+		/// Number of voices playing
+		unsigned Active() const
+		{
+			unsigned n = 0;
+			for (unsigned v=0; v<NumVoices; v++) n += (voice[v].state != Idle);
+			return n;
+		}
+
+		/// Envelope level of voice v, 0 to 2^31-1
+		int32_t Level(unsigned v) const {return voice[v].state == Idle ? 0 : voice[v].level;}
+
+	private:
+		enum State {Idle, Attack, Sustain, Release};
+		struct Voice
+		{
+			SampleStream stream;
+			uint32_t rootInc, age;
+			int32_t level, peak, step;
+			uint8_t note;
+			State state;
+		};
+
+		void StartRelease(Voice &vc)
+		{
+			vc.state = Release;
+			vc.step = vc.level / int32_t(release) + 1;
+		}
+
+		// Idle voice, or else the quietest releasing voice, or else the oldest
+		unsigned FreeVoice() const
+		{
+			int best = -1;
+			for (unsigned v=0; v<NumVoices; v++)
+			{
+				if (voice[v].state == Idle) return v;
+				if (voice[v].state == Release && (best < 0 || voice[v].level < voice[best].level)) best = v;
+			}
+			if (best >= 0) return best;
+			best = 0;
+			for (unsigned v=1; v<NumVoices; v++)
+			{
+				if (int32_t(voice[v].age - voice[best].age) < 0) best = v;
+			}
+			return best;
+		}
+
+		// Per-sample gain step across the next n samples, updating the level and state for the end of the block
+		int32_t __not_in_flash_func(EnvelopeStep)(Voice &vc, unsigned n)
+		{
+			int32_t step = 0;
+			if (vc.state == Attack)
+			{
+				if (int64_t(vc.level) + int64_t(vc.step) * n >= vc.peak)
+				{
+					step = (vc.peak - vc.level) / int32_t(n);
+					vc.state = Sustain;
+				}
+				else step = vc.step;
+			}
+			else if (vc.state == Release)
+			{
+				if (int64_t(vc.level) - int64_t(vc.step) * n <= 0)
+				{
+					step = -vc.level / int32_t(n);
+					vc.state = Idle; // after this block
+				}
+				else step = -vc.step;
+			}
+			vc.level += step * int32_t(n);
+			return step;
+		}
+
+		// Increment for playing cents above the root note, from the increment at the root note
+		uint32_t __not_in_flash_func(Increment)(uint32_t rootInc, int32_t cents) const
+		{
+			// cents/1200 octaves, as 16.16 fixed point
+			int32_t oct16 = int32_t((int64_t(cents) * 3579139) >> 16);
+			int32_t oct = oct16 >> 16;
+			uint32_t f = oct16 & 0xFFFF;
+			uint32_t t0 = octaveTable[f >> 10], t1 = octaveTable[(f >> 10) + 1];
+			uint32_t ratio = t0 + uint32_t((uint64_t(t1 - t0) * (f & 0x3FF)) >> 10);
+			uint64_t inc = (uint64_t(rootInc) * ratio) >> 30;
+			if (oct >= 0) inc <<= (oct > 8 ? 8 : oct);
+			else inc >>= (-oct > 31 ? 31 : -oct);
+			return inc > 0xFFFFFFFF ? 0xFFFFFFFF : uint32_t(inc);
+		}
+
+		// 2^(i/64) * 2^30, for fractions of an octave
+		static constexpr uint32_t octaveTable[65] = {
+			1073741824, 1085434106, 1097253708, 1109202018, 1121280436, 1133490379, 1145833280, 1158310587,
+			1170923762, 1183674286, 1196563654, 1209593378, 1222764986, 1236080024, 1249540052, 1263146652,
+			1276901417, 1290805962, 1304861917, 1319070932, 1333434672, 1347954824, 1362633090, 1377471191,
+			1392470869, 1407633882, 1422962010, 1438457051, 1454120821, 1469955159, 1485961921, 1502142985,
+			1518500250, 1535035634, 1551751076, 1568648537, 1585730000, 1602997467, 1620452965, 1638098541,
+			1655936265, 1673968228, 1692196547, 1710623359, 1729250827, 1748081133, 1767116489, 1786359126,
+			1805811301, 1825475297, 1845353420, 1865448001, 1885761398, 1906295993, 1927054196, 1948038440,
+			1969251188, 1990694927, 2012372174, 2034285470, 2056437387, 2078830522, 2101467502, 2124350982,
+			2147483648
+		};
+
+		SampleBank &bank;
+		uint32_t outputRate;
+		Voice voice[NumVoices];
+		uint32_t attack = 48, release = 4800, ageCounter = 0;
+		unsigned sample = 0;
+		int32_t bendCents = 0, pitchCents = 0, bendRange = 2;
+		uint8_t rootNote = 60;
+		bool looping = false;
+	};
+
+	/** \brief Linearly-interpolated reader for a power-of-two length int16_t buffer
+
+		On the RP2040 this uses the SIO interpolators; on the host, the same
+		calculation is done in software. Positions are unsigned fixed-point, with the
+		buffer index above bit FracBits (at least 8) and the fraction below it.
+	*/
+	template <int SizeBits, int FracBits>
+	class InterpReader
+	{
+		static_assert(SizeBits > 0 && FracBits >= 8 && SizeBits + FracBits <= 32, "InterpReader: index and fraction must fit in 32 bits");
+	public:
+		InterpReader(const int16_t *buffer) : buf(buffer) {}
+
+		/// Change the buffer being read, also of length 2^SizeBits
+		void SetBuffer(const int16_t *buffer) {buf = buffer;}
+
+		/// Return the interpolated buffer value at a position
+		int32_t Read(uint32_t pos)
+		{
+			constexpr uint32_t mask = (1u << SizeBits) - 1;
+			uint32_t index = (pos >> FracBits) & mask;
+			int32_t alpha = (pos >> (FracBits - 8)) & 0xFF;
+			int32_t s1 = buf[index];
+			int32_t s2 = buf[(index + 1) & mask];
+			return s1 + (((s2 - s1) * alpha) >> 8);
+		}
+
+	private:
+		const int16_t *buf;
+	};
+
+	/** \brief Interpolated read from a circular delay line of 2^SizeBits int16_t samples
+
+		Positions are in 1/256ths of a sample. ReadDelayed reads the point a given
+		(fractional) delay before the given write index.
+	*/
+	template <int SizeBits>
+	class InterpDelayReader : public InterpReader<SizeBits, 8>
+	{
+	public:
+		InterpDelayReader(const int16_t *buffer) : InterpReader<SizeBits, 8>(buffer) {}
+
+		/// Return delay line value delay256/256 samples before writeIndex
+		int32_t ReadDelayed(uint32_t writeIndex, uint32_t delay256)
+		{
+			return this->Read((writeIndex << 8) - delay256);
+		}
+	};
+
+	/** \brief Wavetable oscillator, reading a table of 2^SizeBits int16_t samples with interpolation
+
+		Phase is a 32-bit unsigned integer, with 2^32 corresponding to one cycle of the table.
+	*/
+	template <int SizeBits>
+	class InterpTableOsc : public InterpReader<SizeBits, 32 - SizeBits>
+	{
+	public:
+		InterpTableOsc(const int16_t *table) : InterpReader<SizeBits, 32 - SizeBits>(table), phase(0), increment(0) {}
+
+		/// Set phase increment per sample (2^32 * frequency / sample rate)
+		void SetIncrement(uint32_t inc) {increment = inc;}
+		/// Set current phase
+		void SetPhase(uint32_t ph) {phase = ph;}
+		uint32_t Phase() const {return phase;}
+
+		/// Return interpolated table value at current phase, then advance phase by one sample
+		int32_t Next()
+		{
+			int32_t val = this->Read(phase);
+			phase += increment;
+			return val;
+		}
+
+		/// Write n samples of output to out
+		void Render(int16_t *out, int n)
+		{
+			for (int i=0; i<n; i++) out[i] = int16_t(Next());
+		}
+
+	private:
+		uint32_t phase, increment;
+	};
+
+	/// Run a member function of the card on a second thread
+	template <class C>
+	void RunOnCore1(void (C::*fn)())
+	{
+		C *card = static_cast<C *>(this);
+		StartCore1([card, fn]() { (card->*fn)(); });
+	}
+
+	/// Run a function on a second thread
+	void RunOnCore1(void (*fn)())
+	{
+		StartCore1(fn);
+	}
+
+	/// Start the tasks given to AddCore1Task, on a second thread
+	void RunCore1Tasks() {RunOnCore1(&ComputerCard::Core1TaskLoop);}
+
+	/// Run the audio engine on core 1 on the card; on the host, the audio and RunOnCore1 threads are the same either way
+	void EnableAudioOnCore1() {}
+
+protected:
+	/// Callback, called once per sample, at 48kHz unless another rate is given to Run
+	virtual void ProcessSample() {}
+
+	/** \brief Callback, called every control period (see EnableControlRate)
+
+		Runs on the audio interrupt, immediately before ProcessSample/ProcessBlock,
+		so it should be used for work that need not happen every sample:
+		reading knobs and CV, and computing parameters, with Smoothed
+		to interpolate them at audio rate.
+	*/
+	virtual void ProcessControl() {}
+
+	/// Callback, called every factor samples (see EnableSubRate)
+	virtual void ProcessSubRate() {}
+
+	/// Audio input i, decimated to the sub-rate, for ProcessSubRate
+	int16_t SubRateIn(int i) {return int16_t(subRateIn[i ? 1 : 0]);}
+
+	/// Write audio output i at the sub-rate, from ProcessSubRate (-2048 to 2047)
+	void SubRateOut(int i, int16_t val) {subRateOut[i ? 1 : 0] = val;}
+
+	/// Callback, called by PollMIDIEvents for each queued MIDI message when it is due
+	virtual void ProcessMIDI(const MIDIEvent &event) {(void)event;}
+
+	/// Callback, called when the normalisation probe finds a jack plugged into or removed from input i
+	virtual void ConnectionChanged(Input i, bool isConnected) {(void)i; (void)isConnected;}
+
+	/// Callback, called once per block of blockSize frames, if COMPUTERCARD_BLOCK_SIZE > 1
+	virtual void ProcessBlock(const Frame *in, Frame *out, int n)
+	{
+		for (int i=0; i<n; i++)
+		{
+			adcInL = in[i].audio[0];
+			adcInR = in[i].audio[1];
+			ProcessSample();
+			out[i].audio[0] = dacOut[0];
+			out[i].audio[1] = dacOut[1];
+
+			// Edges and switch changes are only reported on the first frame of the block
+			last_pulse[0] = pulse[0];
+			last_pulse[1] = pulse[1];
+			lastSwitchVal = switchVal;
+		}
+	}
+
+	/// Read knob position (returns 0-4095)
+	int32_t KnobVal(Knob ind) {return knobs[ind];}
+
+	/// Read switch position
+	Switch SwitchVal() {return switchVal;}
+
+	/// Read switch position
+	bool SwitchChanged() {return switchVal != lastSwitchVal;}
+
+	/// Bits in the mask returned by ControlsChanged
+	enum ControlChange {ChangedMain = 1, ChangedX = 2, ChangedY = 4, ChangedSwitch = 8, ChangedCV1 = 16, ChangedCV2 = 32};
+
+	/** \brief Knobs, switch and CV inputs that have changed since the last call, as ControlChange bits
+
+		Call from ProcessSample, ProcessBlock or ProcessControl, to skip work that depends only
+		on controls that are still. Without EnableAdaptiveSmoothing, ADC noise means knobs and
+		CV are reported as changing nearly all the time.
+	*/
+	uint32_t ControlsChanged()
+	{
+		uint32_t c = controlsChanged;
+		controlsChanged = 0;
+		return c;
+	}
+
+	/// True if the given control (a ControlChange bit) has changed since it was last checked, by Changed or ControlsChanged
+	bool Changed(ControlChange c)
+	{
+		bool changed = controlsChanged & c;
+		controlsChanged &= ~uint32_t(c);
+		return changed;
+	}
+
+	/// Set Audio output (values -2048 to 2047)
+	void AudioOut(int i, int16_t val) {dacOut[i] = val;}
+	/// Set Audio 1 output (values -2048 to 2047)
+	void AudioOut1(int16_t val) {dacOut[0] = val;}
+	/// Set Audio 2 output (values -2048 to 2047)
+	void AudioOut2(int16_t val) {dacOut[1] = val;}
+
+	/// Set CV output (values -2048 to 2047)
+	void CVOut(int i, int16_t val)
+	{
+		if (val<-2048) val = -2048;
+		if (val > 2047) val = 2047;
+		cvValue[i] = (2047-val)<<7;
+	}
+	/// Set CV 1 output (values -2048 to 2047)
+	void CVOut1(int16_t val) {CVOut(0, val);}
+	/// Set CV 2 output (values -2048 to 2047)
+	void CVOut2(int16_t val) {CVOut(1, val);}
+
+	/// Set CV output (values -262144 to 262143)
+	void CVOutPrecise(int i, int32_t val)
+	{
+		if (val<-262144) val = -262144;
+		if (val > 262143) val = 262143;
+		cvValue[i] = 262143-val;
+	}
+	/// Set CV 1 output (values -262144 to 262143)
+	void CVOut1Precise(int32_t val) {CVOutPrecise(0, val);}
+	/// Set CV 2 output (values -262144 to 262143)
+	void CVOut2Precise(int32_t val) {CVOutPrecise(1, val);}
+
+	/// Set CV output from calibrated MIDI note number (values 0 to 127)
+	void CVOutMIDINote(int i, uint8_t noteNum) {cvValue[i] = midiDacTable[i][noteNum & 0x7F];}
+	/// Set CV 1 output from calibrated MIDI note number (values 0 to 127)
+	void CVOut1MIDINote(uint8_t noteNum) {cvValue[0] = midiDacTable[0][noteNum & 0x7F];}
+	/// Set CV 2 output from calibrated MIDI note number (values 0 to 127)
+	void CVOut2MIDINote(uint8_t noteNum) {cvValue[1] = midiDacTable[1][noteNum & 0x7F];}
+	/// Set CV output from calibrated MIDI note number (0 to 127), offset by cents (e.g. pitch bend, glide)
+	void CVOutMIDINoteCents(int i, uint8_t noteNum, int32_t cents) {cvValue[i] = CVCodeMIDINoteCents(i, noteNum, cents);}
+	/// Calibrated CV output code for a MIDI note number (0 to 127) offset by cents, to precompute for CVOutCode
+	uint32_t CVCodeMIDINoteCents(int i, uint8_t noteNum, int32_t cents)
+	{
+		int32_t dacValue = int32_t(midiDacTable[i][noteNum & 0x7F]) + ((cents * calCentsSlope[i]) >> 8);
+		if (dacValue > 524287) dacValue = 524287;
+		if (dacValue < 0) dacValue = 0;
+		return dacValue;
+	}
+	/// Set CV output from a calibrated MIDI note number in 16.16 fixed point (e.g. MIDIToCV::Pitch), interpolating between notes
+	void CVOutMIDIPitch(int i, int32_t pitch) {cvValue[i] = CVCodeMIDIPitch(i, pitch);}
+	/// Calibrated CV output code for a MIDI note number (0 to 127) in 16.16 fixed point, to precompute for CVOutCode
+	uint32_t CVCodeMIDIPitch(int i, int32_t pitch)
+	{
+		if (pitch <= 0) return midiDacTable[i][0];
+		if (pitch >= (127 << 16)) return midiDacTable[i][127];
+		int n = pitch >> 16;
+		int32_t a = midiDacTable[i][n], b = midiDacTable[i][n + 1];
+		return uint32_t(a + int32_t((int64_t(b - a) * (pitch & 0xFFFF)) >> 16));
+	}
+	/// Set CV output from a code returned by CVCodeMIDINoteCents
+	void CVOutCode(int i, uint32_t code) {cvValue[i] = code;}
+
+	/// Set Pulse output (true = on). With EnablePulseEngine, also cancels any pulses scheduled on it
+	void PulseOut(int i, bool val)
+	{
+		scheduledPulses[i].pending = scheduledPulses[i].active = false;
+		pulseOut[i] = val;
+	}
+	/// Set Pulse 1 output (true = on)
+	void PulseOut1(bool val) {PulseOut(0, val);}
+	/// Set Pulse 2 output (true = on)
+	void PulseOut2(bool val) {PulseOut(1, val);}
+
+	/// With EnablePulseAudio, set pulse output i to val (-2048 to 2047), in frame of the block (0 in ProcessSample)
+	void PulseAudioOut(int i, int16_t val, int frame = 0)
+	{
+		pulseAudioLevel[frame][i] = uint8_t((Clip12(val) + 2048) >> 4);
+	}
+
+	/// With EnablePulseEngine, schedule a pulse lengthUs long on pulse output i, starting offset/65536 samples after the start of the next sample (or block)
+	void PulseOutTrigger(int i, uint32_t lengthUs, uint32_t offset = 0)
+	{
+		PulseOutBurst(i, 1, lengthUs, lengthUs, offset);
+	}
+
+	/// With EnablePulseEngine, schedule count pulses lengthUs long, one every periodUs, on pulse output i, timed as PulseOutTrigger
+	void PulseOutBurst(int i, uint32_t count, uint32_t lengthUs, uint32_t periodUs, uint32_t offset = 0)
+	{
+		if (!usePulseEngine || !count) return;
+		ScheduledPulses &p = scheduledPulses[i];
+		p.count = count;
+		p.delay = offset;
+		p.length = UsToQ16Samples(lengthUs);
+		p.period = UsToQ16Samples(periodUs);
+		if (p.period <= p.length) p.period = p.length + 1;
+		p.pending = true;
+	}
+
+	/// Return audio in (-2048 to 2047)
+	int16_t AudioIn(int i){return i?adcInR:adcInL;}
+	/// Return audio in 1 (-2048 to 2047)
+	int16_t AudioIn1(){return adcInL;}
+	/// Return audio in 1 (-2048 to 2047)
+	int16_t AudioIn2(){return adcInR;}
+
+	/// Return CV in (-2048 to 2047)
+	int16_t CVIn(int i){return cv[i];}
+	/// Return CV in 1 (-2048 to 2047)
+	int16_t CVIn1(){return cv[0];}
+	/// Return CV in 2 (-2048 to 2047)
+	int16_t CVIn2(){return cv[1];}
+	/// Return CV in, unsmoothed (-2048 to 2047)
+	int16_t CVInFast(int i){return cvFast[i];}
+
+	/// A measured point for SetCVInCalibration: the CVIn value read with a known voltage at the input
+	struct CVInCalPoint
+	{
+		int16_t cvIn;
+		int16_t millivolts;
+	};
+
+	/// Return the pitch at CV input i, as a MIDI note number in 16.16 fixed point, through the calibration table as on the Computer
+	int32_t CVInPitchQ16(int i){return CVInPitch(i, cv[i]);}
+	/// Return the nearest MIDI note to the pitch at CV input i
+	int CVInNote(int i){return (CVInPitchQ16(i) + 32768) >> 16;}
+
+	/// Calibrate CV input i for CVInPitchQ16 and CVInNote from n measured points, as ComputerCard::SetCVInCalibration
+	bool SetCVInCalibration(int i, const CVInCalPoint *points, int n)
+	{
+		if (n < 2 || n > calMaxPoints) return false;
+		CVInCalPoint p[calMaxPoints];
+		for (int j = 0; j < n; j++)
+		{
+			int k = j;
+			for (; k > 0 && p[k - 1].cvIn > points[j].cvIn; k--) p[k] = p[k - 1];
+			p[k] = points[j];
+		}
+		for (int j = 1; j < n; j++)
+		{
+			if (p[j].cvIn == p[j - 1].cvIn) return false;
+		}
+		int s = 0;
+		for (int k = 0; k <= 64; k++)
+		{
+			int32_t c = k * 64 - 2048;
+			while (s < n - 2 && c > p[s + 1].cvIn) s++;
+			int64_t dc = p[s + 1].cvIn - p[s].cvIn;
+			int64_t mv = p[s].millivolts * dc + int64_t(p[s + 1].millivolts - p[s].millivolts) * (c - p[s].cvIn);
+			int64_t num = mv * (12 << 16), den = 1000 * dc;
+			int64_t pitch = (num >= 0 ? num + den / 2 : num - den / 2) / den;
+			cvInPitchTable[i][k] = int32_t((60 << 16) + pitch);
+		}
+		return true;
+	}
+
+	/// Return CV input i to its nominal calibration, ±6V over the full range of CVIn
+	void ResetCVInCalibration(int i)
+	{
+		for (int k = 0; k <= 64; k++) cvInPitchTable[i][k] = (60 << 16) + (k * 64 - 2048) * 2304;
+	}
+
+	/// Pitch (see CVInPitchQ16) at CV input i, for a given CVIn value
+	int32_t CVInPitch(int i, int32_t cvIn)
+	{
+		uint32_t u = uint32_t(cvIn + 2048);
+		int32_t a = cvInPitchTable[i][u >> 6], b = cvInPitchTable[i][(u >> 6) + 1];
+		return a + (((b - a) * int32_t(u & 63)) >> 6);
+	}
+
+	/// Read pulse in
+	bool PulseIn(int i){return pulse[i];}
+	/// Return true for one sample on pulse rising edge
+	bool PulseInRisingEdge(int i){return pulse[i] && !last_pulse[i];}
+	/// Return true for one sample on pulse falling edge
+	bool PulseInFallingEdge(int i){return !pulse[i] && last_pulse[i];}
+
+	/// Read pulse in 1
+	bool PulseIn1(){return pulse[0];}
+	/// Return true for one sample on pulse 1 rising edge
+	bool PulseIn1RisingEdge(){return pulse[0] && !last_pulse[0];}
+	/// Return true for one sample on pulse 1 falling edge
+	bool PulseIn1FallingEdge(){return !pulse[0] && last_pulse[0];}
+
+	/// Read pulse in 2
+	bool PulseIn2(){return pulse[1];}
+	/// Return true for one sample on pulse 2 falling edge
+	bool PulseIn2FallingEdge(){return !pulse[1] && last_pulse[1];}
+	/// Return true for one sample on pulse 2 rising edge
+	bool PulseIn2RisingEdge(){return pulse[1] && !last_pulse[1];}
+
+	/// With EnablePulseCapture, how long before the current sample (or end of block) the last rising edge on pulse input i happened, in 1/65536ths of a sample
+	uint32_t PulseInRisingEdgeOffset(int i){return pulseEdgeOffset[i][0];}
+	/// As PulseInRisingEdgeOffset, for the last falling edge on pulse input i
+	uint32_t PulseInFallingEdgeOffset(int i){return pulseEdgeOffset[i][1];}
+
+	/// Return true if jack connected to input
+	bool Connected(Input i){return connected[i];}
+	/// Return true if no jack connected to input
+	bool Disconnected(Input i){return !connected[i];}
+
+	/// Set LED brightness, values 0-4095
+	void LedBrightness(uint32_t index, uint16_t value)
+	{
+		if (useLedEngine) SetLedLevel(index, value);
+		else ledValue[index] = (value*value)>>8;
+	}
+	/// Turn LED on/off
+	void LedOn(uint32_t index, bool value = true)
+	{
+		if (useLedEngine) SetLedLevel(index, value ? 4095 : 0);
+		else ledValue[index] = value?65535:0;
+	}
+	/// Turn LED off
+	void LedOff(uint32_t index) {LedOn(index, false);}
+
+	/// With EnableLedEngine, fade LED index from its current brightness to value (0-4095) over ms milliseconds
+	void LedFade(uint32_t index, uint16_t value, uint32_t ms)
+	{
+		if (!useLedEngine) return;
+		int32_t frames = int32_t((ms * uint32_t(ledRefreshHz)) / 1000);
+		if (frames < 1) frames = 1;
+		ledMeterActive[index & 1] = false;
+		ledFadeTarget[index] = int32_t(value) << 16;
+		ledFadeStep[index] = (ledFadeTarget[index] - ledLevel[index]) / frames;
+		ledFadeFrames[index] = frames;
+	}
+
+	/// With EnableLedEngine, show level (0-4095) on a column of LEDs (0 = left, 1 = right) as a bar graph, falling back over about 300ms
+	void LedMeter(int column, uint16_t level)
+	{
+		if (level > ledMeterPeak[column]) ledMeterPeak[column] = level;
+		ledMeterActive[column] = true;
+	}
+
+	/// Display average (left column) and maximum (right column) load meter values on LEDs
+	void LedsShowLoad() {}
+
+	/// Return power state of USB port
+	USBPowerState_t USBPowerState() {return UFP;}
+
+	/// Return hardware version
+	HardwareVersion_t HardwareVersion() {return Rev1_1;}
+
+	/// Return ID number unique to flash card
+	uint64_t UniqueCardID() {return 0x0123456789ABCDEFULL;}
+
+	void Abort() {aborted = true;}
+
+	/// Stop this card and run card number card of the CardLauncher instead, which renders from the start
+	static void SwitchCard(int card)
+	{
+		cardRequest = card;
+		if (thisptr) thisptr->Abort();
+	}
+
+	/// Number of the card running under CardLauncher (0 otherwise)
+	static int CurrentCard() {return cardIndex;}
+
+	uint16_t CRCencode(const uint8_t *data, int length)
+	{
+		uint16_t crc = 0xFFFF; // Initial CRC value
+		for (int i = 0; i < length; i++)
+		{
+			crc ^= ((uint16_t)data[i]) << 8; // Bring in the next byte
+			for (uint8_t bit = 0; bit < 8; bit++)
+			{
+				if (crc & 0x8000)
+					crc = (crc << 1) ^ 0x1021; // CRC-CCITT polynomial
+				else
+					crc = crc << 1;
+			}
+		}
+		return crc;
+	}
+
+	/// Host only: current LED values (0-65535), for inspection by test code
+	uint16_t HostLedValue(int i) {return ledValue[i];}
+
+private:
+
+	typedef struct
+	{
+		float m, b;
+		int32_t mi, bi;
+	} CalCoeffs;
+
+	typedef struct
+	{
+		int32_t dacSetting;
+		int8_t voltage;
+	} CalPoint;
+
+	static constexpr int calMaxChannels = 2;
+	static constexpr int calMaxPoints = 10;
+
+	uint32_t cvValue[2] = {262144, 262144};
+
+	uint8_t numCalibrationPoints[calMaxChannels];
+	CalPoint calibrationTable[calMaxChannels][calMaxPoints];
+	CalCoeffs calCoeffs[calMaxChannels];
+
+	// Calibrated CV output value for each MIDI note, and change in CV output value per cent (Q8), built by CalcCalCoeffs
+	uint32_t midiDacTable[calMaxChannels][128];
+	int32_t calCentsSlope[calMaxChannels];
+
+	// Pitch (MIDI note, Q16) at every 64th CVIn value from -2048 to 2048, see CVInPitchQ16
+	int32_t cvInPitchTable[2][65];
+
+	int16_t dacOut[2] = {0, 0};
+	bool pulseOut[2];
+	uint16_t ledValue[numLeds];
+
+	int32_t knobs[4] = { 2048, 2048, 2048, 2048 }; // 0-4095
+	bool pulse[2] = { 0, 0 };
+	bool last_pulse[2] = { 0, 0 };
+	bool usePulseCapture = false;
+
+	// Pulses scheduled by PulseOutTrigger/PulseOutBurst, times in Q16 samples
+	struct ScheduledPulses
+	{
+		uint64_t delay, length, period, t;
+		uint32_t count;
+		bool pending = false, active = false;
+	};
+	bool usePulseEngine = false;
+
+	// EnablePulseAudio: PWM level of each pulse output, for each frame of the block
+	bool usePulseAudio = false;
+	uint8_t pulseAudioLevel[blockSize][2] = {};
+
+	// MeasureLatency's result, always nothing found
+	LatencyStats latencyResult = {};
+
+	// Audio input ring, see EnableInputCapture
+	Frame *captureBuffer = nullptr;
+	uint32_t captureFrames = 0, captureIndex = 0;
+
+	// Audio link, see EnableAudioLink: frames sent, and received, as samples of the link's
+	// channels and the control word's two halves, interleaved
+	bool useAudioLink = false;
+#ifdef COMPUTERCARD_LINK
+	static_assert(COMPUTERCARD_LINK >= 1 && COMPUTERCARD_LINK <= 4, "COMPUTERCARD_LINK must be 1 to 4 channels");
+	int linkLatency = 2;
+	int16_t linkTx[blockSize][COMPUTERCARD_LINK] = {};
+	uint32_t linkControl = 0;
+	std::vector<int16_t> linkInSamples, linkOutSamples;
+	uint64_t linkInFrames = 0, linkPlaying = 0;
+	bool linkConnected = false;
+	uint32_t linkFrames = 0;
+#endif
+
+	// Play the frame sent latency + 1 callbacks ago, if there is one
+	void ReceiveLink(uint64_t frame)
+	{
+#ifdef COMPUTERCARD_LINK
+		uint64_t delay = uint64_t(linkLatency + 1) * blockSize;
+		linkConnected = frame >= delay && frame - delay + blockSize <= linkInFrames;
+		linkPlaying = frame - delay;
+		if (linkConnected) linkFrames++;
+#else
+		(void)frame;
+#endif
+	}
+
+	// Collect this callback's frame for COMPUTERCARD_LINK_OUT, and start the next from silence
+	void SendLink(bool keep)
+	{
+#ifdef COMPUTERCARD_LINK
+		for (int i=0; i<blockSize; i++)
+		{
+			if (keep)
+			{
+				for (int ch=0; ch<COMPUTERCARD_LINK; ch++) linkOutSamples.push_back(linkTx[i][ch]);
+				linkOutSamples.push_back(int16_t(linkControl & 0xFFFF));
+				linkOutSamples.push_back(int16_t(linkControl >> 16));
+			}
+			for (int ch=0; ch<COMPUTERCARD_LINK; ch++) linkTx[i][ch] = 0;
+		}
+#else
+		(void)keep;
+#endif
+	}
+
+	// LED frame buffer, see EnableLedEngine. Levels are 0-4095, << 16
+	bool useLedEngine = false;
+	int32_t ledRefreshHz = 200, ledPeriod = 240, ledCount = 0, ledMeterDecay = 68;
+	int32_t ledLevel[numLeds] = {0, 0, 0, 0, 0, 0};
+	int32_t ledFadeTarget[numLeds] = {0, 0, 0, 0, 0, 0}, ledFadeStep[numLeds] = {0, 0, 0, 0, 0, 0};
+	int32_t ledFadeFrames[numLeds] = {0, 0, 0, 0, 0, 0};
+	uint16_t ledMeterPeak[2] = {0, 0}, ledMeterLevel[2] = {0, 0};
+	bool ledMeterActive[2] = {false, false};
+
+	void SetLedLevel(uint32_t index, uint16_t value)
+	{
+		ledFadeFrames[index] = 0;
+		ledMeterActive[index & 1] = false;
+		ledLevel[index] = int32_t(value) << 16;
+	}
+
+	void PollLeds()
+	{
+		ledCount += blockSize;
+		if (ledCount >= ledPeriod)
+		{
+			ledCount = 0;
+			UpdateLeds();
+		}
+	}
+
+	// Once every LED engine frame: run animations, and set all LEDs, as on the device
+	void UpdateLeds()
+	{
+		static constexpr uint16_t gamma[33] = {
+			0, 32, 147, 359, 676, 1104, 1648, 2314, 3104, 4022, 5072, 6255, 7574, 9033, 10632, 12375,
+			14263, 16298, 18482, 20816, 23303, 25943, 28739, 31692, 34802, 38072, 41503, 45097, 48853, 52774, 56860, 61114,
+			65535};
+
+		for (int c=0; c<2; c++)
+		{
+			if (!ledMeterActive[c]) continue;
+			int32_t level = ledMeterLevel[c] - ledMeterDecay;
+			if (level < ledMeterPeak[c]) level = ledMeterPeak[c];
+			ledMeterLevel[c] = uint16_t(level < 0 ? 0 : level);
+			ledMeterPeak[c] = 0;
+			int32_t v = ledMeterLevel[c] * 3;
+			for (int r=0; r<3; r++)
+			{
+				int32_t a = v - (2-r) * 4095;
+				ledLevel[2*r + c] = (a < 0 ? 0 : (a > 4095 ? 4095 : a)) << 16;
+			}
+		}
+
+		for (int i=0; i<numLeds; i++)
+		{
+			if (ledFadeFrames[i])
+			{
+				if (--ledFadeFrames[i]) ledLevel[i] += ledFadeStep[i];
+				else ledLevel[i] = ledFadeTarget[i];
+			}
+			uint32_t v = uint32_t(ledLevel[i]) >> 16;
+			if (v >= 4095) ledValue[i] = 65535;
+			else
+			{
+				uint32_t a = gamma[v >> 7], b = gamma[(v >> 7) + 1];
+				ledValue[i] = uint16_t(a + (((b - a) * (v & 127)) >> 7));
+			}
+		}
+	}
+	ScheduledPulses scheduledPulses[2];
+
+	uint64_t UsToQ16Samples(uint32_t us) {return (uint64_t(us) * uint64_t(sampleRate) * 65536) / 1000000;}
+
+	// Start pulses scheduled in the last sample/block, as the device does at the start of each
+	void StartScheduledPulses()
+	{
+		for (ScheduledPulses &p : scheduledPulses)
+		{
+			if (!p.pending) continue;
+			p.pending = false;
+			p.active = true;
+			p.t = 0;
+		}
+	}
+
+	// Set pulse outputs from scheduled pulses for one frame
+	void UpdateScheduledPulses()
+	{
+		for (int i=0; i<2; i++)
+		{
+			ScheduledPulses &p = scheduledPulses[i];
+			if (!p.active) continue;
+			if (p.t >= p.delay)
+			{
+				uint64_t n = (p.t - p.delay) / p.period;
+				if (n >= p.count)
+				{
+					p.active = false;
+					pulseOut[i] = false;
+					continue;
+				}
+				pulseOut[i] = (p.t - p.delay) - n * p.period < p.length;
+			}
+			p.t += 65536;
+		}
+	}
+	uint32_t pulseEdgeOffset[2][2] = {{0, 0}, {0, 0}}; // [input][rising, falling], Q16 samples
+	int32_t cv[2] = { 0, 0 }; // -2047 - 2048
+	int32_t cvFast[2] = { 0, 0 }; // before smoothing, see CVInFast
+	int16_t adcInL = 0, adcInR = 0;
+
+	bool connected[6];
+	bool useNormProbe;
+
+	// Adaptive knob/CV smoothing, and controls changed since ControlsChanged was last called
+	bool useAdaptiveSmoothing = false;
+	AdaptiveSmoother knobSmoother[3], cvSmoother[2];
+	uint32_t controlsChanged = 0;
+	// Automation has no ADC noise, so is smoothed lightly to stay close to the CSV file
+	static constexpr int hostSmoothShift = 3;
+	bool aborted = false;
+
+	Switch switchVal = Middle, lastSwitchVal = Middle;
+
+	// Boot profile, and setup finished a step per block by Run (see AddStartupTask)
+	BootTimes bootTimes;
+	typedef bool (ComputerCard::*StartupTask)(int step);
+	StartupTask startupTasks[maxStartupTasks];
+	int numStartupTasks, nextStartupTask, startupStep;
+
+	// Control rate callback, controlPeriod = 0 if disabled
+	int32_t controlPeriod, controlCount;
+	static inline uint8_t controlShift = 0;
+
+	// Sub-rate callback, see EnableSubRate: a decimator and an interpolator per channel and halving
+	int subRateStages = 0, subRatePos = 0;
+	HalfBand subRateDown[2][3], subRateUp[2][3];
+	int32_t subRateHeld[2][3] = {};
+	bool subRateHalf[3] = {};
+	int32_t subRateIn[2] = {}, subRateOut[2] = {};
+	int32_t subRateUpBuf[2][8] = {};
+
+	// Sub-rate processing for one frame, as ComputerCard::ServiceSubRate on the RP2040
+	void ServiceSubRate(int16_t inL, int16_t inR, int32_t *out)
+	{
+		int32_t x[2] = {inL, inR};
+		int s = 0;
+		for (; s<subRateStages; s++)
+		{
+			if (!subRateHalf[s])
+			{
+				subRateHeld[0][s] = x[0];
+				subRateHeld[1][s] = x[1];
+				subRateHalf[s] = true;
+				break;
+			}
+			subRateHalf[s] = false;
+			for (int c=0; c<2; c++) x[c] = subRateDown[c][s].Decimate(subRateHeld[c][s], x[c]);
+		}
+
+		if (s == subRateStages)
+		{
+			subRateIn[0] = x[0];
+			subRateIn[1] = x[1];
+			ProcessSubRate();
+
+			for (int c=0; c<2; c++)
+			{
+				int32_t *buf = subRateUpBuf[c];
+				int32_t tmp[8];
+				buf[0] = subRateOut[c];
+				int n = 1;
+				for (int t=subRateStages-1; t>=0; t--)
+				{
+					for (int i=0; i<n; i++) subRateUp[c][t].Interpolate(buf[i], tmp[2*i], tmp[2*i+1]);
+					n *= 2;
+					for (int i=0; i<n; i++) buf[i] = tmp[i];
+				}
+			}
+			subRatePos = 0;
+		}
+
+		out[0] = subRateUpBuf[0][subRatePos];
+		out[1] = subRateUpBuf[1][subRatePos];
+		if (subRatePos < (1 << subRateStages) - 1) subRatePos++;
+	}
+
+	// Sub-rate outputs added to a block's outputs, shifted up to 16 bits with noise shaping
+	void MixSubRate(Frame *frames, const Frame *in, int n, int shift)
+	{
+		int32_t hi = shift ? 32767 : 2047;
+		for (int f=0; f<n; f++)
+		{
+			int32_t sub[2];
+			ServiceSubRate(in[f].audio[0], in[f].audio[1], sub);
+			for (int c=0; c<2; c++)
+			{
+				int32_t v = frames[f].audio[c] + (sub[c] << shift);
+				frames[f].audio[c] = int16_t(v < -hi - 1 ? -hi - 1 : (v > hi ? hi : v));
+			}
+		}
+	}
+
+	void __not_in_flash_func(PollControl)()
+	{
+		if (controlPeriod)
+		{
+			controlCount += blockSize;
+			if (controlCount >= controlPeriod)
+			{
+				controlCount = 0;
+				ProcessControl();
+			}
+		}
+	}
+
+	int32_t sampleRate = SR48kHz;
+
+	// MIDI event queue, filled by QueueMIDI and emptied by PollMIDIEvents
+	Ring<MIDIEvent, 64> midiQueue;
+	uint32_t midiLatency = 48 + blockSize;
+	uint8_t midiStreamStatus = 0;
+	bool midiStreamInSysex = false;
+
+	// First frame of the current ProcessSample/ProcessBlock call
+	uint32_t callbackFrame = 0;
+
+	uint32_t MIDIArrivalFrame() {return __atomic_load_n(&callbackFrame, __ATOMIC_ACQUIRE);}
+
+	// Bytes in a MIDI message with the given status byte (0 for sysex and undefined statuses)
+	static int MIDIMessageLength(uint8_t status)
+	{
+		if (status < 0xF0) return ((status & 0xE0) == 0xC0) ? 2 : 3; // program change and channel pressure are 2 bytes
+		switch (status)
+		{
+		case 0xF1: case 0xF3: return 2;
+		case 0xF2: return 3;
+		case 0xF6: case 0xF8: case 0xFA: case 0xFB: case 0xFC: case 0xFE: case 0xFF: return 1;
+		default: return 0;
+		}
+	}
+
+	// Core 1 scheduler, see AddCore1Task
+	typedef void (ComputerCard::*Core1TaskFn)();
+	struct Core1Task
+	{
+		Core1TaskFn fn;
+		uint32_t period, deadline, due;
+		int priority;
+		TaskStats stats;
+	};
+	Core1Task core1Tasks[maxCore1Tasks];
+	int numCore1Tasks = 0;
+
+	void Core1TaskLoop()
+	{
+		uint32_t now = time_us_32();
+		for (int i=0; i<numCore1Tasks; i++) core1Tasks[i].due = now;
+		while (1)
+		{
+			// The highest priority task that is due, and of those, the one due longest
+			now = time_us_32();
+			Core1Task *next = nullptr;
+			for (int i=0; i<numCore1Tasks; i++)
+			{
+				Core1Task &t = core1Tasks[i];
+				if (int32_t(now - t.due) < 0) continue;
+				if (!next || t.priority > next->priority || (t.priority == next->priority && int32_t(t.due - next->due) < 0)) next = &t;
+			}
+			if (!next)
+			{
+				tight_loop_contents();
+				continue;
+			}
+
+			uint32_t late = now - next->due;
+			(this->*next->fn)();
+			uint32_t end = time_us_32();
+
+			TaskStats &s = next->stats;
+			uint32_t took = end - now;
+			s.runs++;
+			s.totalUs += took;
+			if (took > s.maxUs) s.maxUs = took;
+			if (next->deadline && late > next->deadline) s.late++;
+			if (late > s.maxLateUs) s.maxLateUs = late;
+
+			next->due += next->period;
+			if (int32_t(end - next->due) > int32_t(next->period)) next->due = end; // fell behind: skip the missed runs
+		}
+	}
+
+	bool useLoadMeter;
+	uint32_t loadMinCycles, loadMaxCycles, loadAvgCycles8, loadOverruns;
+	uint32_t loadBudgetCycles = 0;
+	int32_t qualityLevel = 0;
+
+	static inline ComputerCard *thisptr = nullptr;
+
+	// Inputs copied once per sample (or block) for ComputerCardT, by TakeInputSnapshot
+	bool useInputSnapshot = false;
+	Inputs inputs = {};
+	void TakeInputSnapshot()
+	{
+		for (int i=0; i<4; i++) inputs.knobs[i] = knobs[i];
+		inputs.audio[0] = adcInL;
+		inputs.audio[1] = adcInR;
+		inputs.cv[0] = cv[0];
+		inputs.cv[1] = cv[1];
+		inputs.cvFast[0] = cvFast[0];
+		inputs.cvFast[1] = cvFast[1];
+		for (int i=0; i<2; i++)
+		{
+			inputs.pulse[i] = pulse[i];
+			inputs.lastPulse[i] = last_pulse[i];
+		}
+		for (int i=0; i<6; i++) inputs.connected[i] = connected[i];
+		inputs.switchVal = switchVal;
+		inputs.lastSwitchVal = lastSwitchVal;
+	}
+
+	template <class Derived> friend class ComputerCardT;
+
+	// CardLauncher state: card running, and card asked for by SwitchCard (-1 for none)
+	static inline volatile int cardIndex = 0, cardRequest = -1;
+	template <class... Cards> friend class CardLauncher;
+
+	// Lockstep scheduling of the RunOnCore1 thread, see HostConfig::lockstep
+	static constexpr unsigned lockstepCalls = 1024;
+	static constexpr unsigned lockstepFrames = blockSize > 32 ? blockSize : 32; // audio frames per turn
+	struct Lockstep
+	{
+		std::mutex m;
+		std::condition_variable cv;
+		bool core1Turn = false, core1Running = false;
+		unsigned calls = 0;
+	};
+	static Lockstep &Steps()
+	{
+		static Lockstep *l = new Lockstep; // never destroyed, as core1 may still be waiting at exit
+		return *l;
+	}
+	static inline thread_local bool onCore1 = false;
+
+	template <typename F>
+	static void StartCore1(F fn)
+	{
+		bool lockstep = Host().lockstep;
+		if (lockstep)
+		{
+			Steps().core1Running = true;
+			host_wait_hook = Core1Wait;
+		}
+		std::thread([fn, lockstep]() {
+			onCore1 = true;
+			Lockstep &l = Steps();
+			if (lockstep)
+			{
+				std::unique_lock<std::mutex> lock(l.m);
+				l.cv.wait(lock, [&]{return l.core1Turn;});
+			}
+			fn();
+			std::lock_guard<std::mutex> lock(l.m);
+			l.core1Running = l.core1Turn = false;
+			l.cv.notify_all();
+		}).detach();
+	}
+
+	// Core1, in lockstep: hand back to the audio thread now, or after lockstepCalls calls
+	static void Core1Yield(bool now)
+	{
+		if (!onCore1 || !Host().lockstep) return;
+		Lockstep &l = Steps();
+		if (!now && ++l.calls < lockstepCalls) return;
+		l.calls = 0;
+		std::unique_lock<std::mutex> lock(l.m);
+		l.core1Turn = false;
+		l.cv.notify_all();
+		l.cv.wait(lock, [&]{return l.core1Turn;});
+	}
+
+	// host_wait_hook: sleeps and tight_loop_contents on core1, in lockstep. Sleeps last until
+	// the audio has been rendered that far.
+	static bool Core1Wait(uint64_t us)
+	{
+		if (!onCore1) return false;
+		if (us == 0)
+		{
+			Core1Yield(false);
+			return true;
+		}
+		uint64_t frames = (us * uint64_t(thisptr->sampleRate) + 999999) / 1000000;
+		uint32_t start = __atomic_load_n(&thisptr->callbackFrame, __ATOMIC_ACQUIRE);
+		while (__atomic_load_n(&thisptr->callbackFrame, __ATOMIC_ACQUIRE) - start < frames) Core1Yield(true);
+		return true;
+	}
+
+	// Audio thread, in lockstep: let core1 run until it hands back
+	static void RunCore1Turn()
+	{
+		Lockstep &l = Steps();
+		if (!Host().lockstep) return;
+		std::unique_lock<std::mutex> lock(l.m);
+		if (!l.core1Running) return;
+		l.core1Turn = true;
+		l.cv.notify_all();
+		l.cv.wait(lock, [&]{return !l.core1Turn;});
+	}
+
+	static HostConfig ConfigFromEnvironment()
+	{
+		HostConfig c;
+		if (const char *e = std::getenv("COMPUTERCARD_IN")) c.inputWav = e;
+		if (const char *e = std::getenv("COMPUTERCARD_OUT")) c.outputWav = e;
+		if (const char *e = std::getenv("COMPUTERCARD_CONTROL")) c.controlCsv = e;
+		if (const char *e = std::getenv("COMPUTERCARD_SECONDS")) c.seconds = std::atof(e);
+		if (const char *e = std::getenv("COMPUTERCARD_LOCKSTEP")) c.lockstep = std::atoi(e) != 0;
+		if (const char *e = std::getenv("COMPUTERCARD_REPLAY")) c.replay = e;
+		if (const char *e = std::getenv("COMPUTERCARD_RECORD_OUT")) c.recordOut = e;
+		if (const char *e = std::getenv("COMPUTERCARD_LINK_IN")) c.linkIn = e;
+		if (const char *e = std::getenv("COMPUTERCARD_LINK_OUT")) c.linkOut = e;
+		return c;
+	}
+
+	// Same default calibration as the hardware, so that MIDI note outputs match
+	int ReadEEPROM()
+	{
+		for (int ch=0; ch<calMaxChannels; ch++)
+		{
+			numCalibrationPoints[ch] = 3;
+			calibrationTable[ch][0].voltage = -20; // -2V
+			calibrationTable[ch][0].dacSetting = 347700;
+			calibrationTable[ch][1].voltage = 0; // 0V
+			calibrationTable[ch][1].dacSetting = 261200;
+			calibrationTable[ch][2].voltage = 20; // +2V
+			calibrationTable[ch][2].dacSetting = 174400;
+			CalcCalCoeffs(ch);
+		}
+		return 0;
+	}
+
+	void CalcCalCoeffs(int channel)
+	{
+		float sumV = 0.0f, sumDAC = 0.0f, sumV2 = 0.0f, sumVDAC = 0.0f;
+		int N = numCalibrationPoints[channel];
+		for (int i = 0; i < N; i++)
+		{
+			float v = calibrationTable[channel][i].voltage * 0.1f;
+			float dac = float(calibrationTable[channel][i].dacSetting);
+			sumV += v;
+			sumDAC += dac;
+			sumV2 += v * v;
+			sumVDAC += v * dac;
+		}
+		float denominator = N * sumV2 - sumV * sumV;
+		calCoeffs[channel].m = (denominator != 0) ? (N * sumVDAC - sumV * sumDAC) / denominator : 0.0f;
+		calCoeffs[channel].b = (sumDAC - calCoeffs[channel].m * sumV) / N;
+		calCoeffs[channel].mi = int32_t(calCoeffs[channel].m * 1.333333333333333f + 0.5f);
+		calCoeffs[channel].bi = int32_t(calCoeffs[channel].b + 0.5f);
+
+		calCentsSlope[channel] = int32_t(calCoeffs[channel].m * (256.0f / 1200.0f) + (calCoeffs[channel].m < 0 ? -0.5f : 0.5f));
+		for (int note = 0; note < 128; note++) midiDacTable[channel][note] = MIDIToDac(note, channel);
+	}
+
+	uint32_t MIDIToDac(int midiNote, int channel)
+	{
+		int32_t dacValue = ((calCoeffs[channel].mi * (midiNote - 60)) >> 4) + calCoeffs[channel].bi;
+		if (dacValue > 524287) dacValue = 524287;
+		if (dacValue < 0) dacValue = 0;
+		return dacValue;
+	}
+
+	////////////////////////////////////////
+	// WAV file input/output
+
+	struct WavData
+	{
+		int channels = 0;
+		int sampleRate = 48000;
+		std::vector<int16_t> samples; // interleaved
+	};
+
+	static uint32_t ReadLE(const uint8_t *p, int bytes)
+	{
+		uint32_t v = 0;
+		for (int i=bytes-1; i>=0; i--) v = (v << 8) | p[i];
+		return v;
+	}
+
+	static bool ReadWav(const std::string &filename, WavData &wav)
+	{
+		FILE *f = std::fopen(filename.c_str(), "rb");
+		if (!f) return false;
+		std::vector<uint8_t> data;
+		uint8_t buf[4096];
+		size_t n;
+		while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+		std::fclose(f);
+
+		if (data.size() < 12 || std::memcmp(data.data(), "RIFF", 4) || std::memcmp(data.data() + 8, "WAVE", 4)) return false;
+		int bitsPerSample = 0;
+		size_t pos = 12;
+		while (pos + 8 <= data.size())
+		{
+			uint32_t chunkSize = ReadLE(&data[pos+4], 4);
+			const uint8_t *chunk = &data[pos+8];
+			if (pos + 8 + chunkSize > data.size()) chunkSize = uint32_t(data.size() - pos - 8);
+			if (!std::memcmp(&data[pos], "fmt ", 4) && chunkSize >= 16)
+			{
+				wav.channels = int(ReadLE(chunk + 2, 2));
+				wav.sampleRate = int(ReadLE(chunk + 4, 4));
+				bitsPerSample = int(ReadLE(chunk + 14, 2));
+			}
+			else if (!std::memcmp(&data[pos], "data", 4))
+			{
+				if (bitsPerSample != 16 || wav.channels < 1) return false;
+				wav.samples.resize(chunkSize / 2);
+				for (size_t i=0; i<wav.samples.size(); i++) wav.samples[i] = int16_t(ReadLE(chunk + 2*i, 2));
+				return true;
+			}
+			pos += 8 + chunkSize + (chunkSize & 1);
+		}
+		return false;
+	}
+
+	static void WriteLE(FILE *f, uint32_t v, int bytes)
+	{
+		for (int i=0; i<bytes; i++) std::fputc((v >> (8*i)) & 0xFF, f);
+	}
+
+	static bool WriteWav(const std::string &filename, int channels, int rate, const std::vector<int16_t> &samples)
+	{
+		FILE *f = std::fopen(filename.c_str(), "wb");
+		if (!f) return false;
+		uint32_t dataBytes = uint32_t(samples.size() * 2);
+		std::fwrite("RIFF", 1, 4, f);
+		WriteLE(f, 36 + dataBytes, 4);
+		std::fwrite("WAVEfmt ", 1, 8, f);
+		WriteLE(f, 16, 4);
+		WriteLE(f, 1, 2); // PCM
+		WriteLE(f, channels, 2);
+		WriteLE(f, rate, 4);
+		WriteLE(f, rate * 2 * channels, 4);
+		WriteLE(f, 2 * channels, 2);
+		WriteLE(f, 16, 2);
+		std::fwrite("data", 1, 4, f);
+		WriteLE(f, dataBytes, 4);
+		for (int16_t s : samples) WriteLE(f, uint16_t(s), 2);
+		std::fclose(f);
+		return true;
+	}
+
+	////////////////////////////////////////
+	// CSV automation
+
+	enum ControlColumn {CtrlMain, CtrlX, CtrlY, CtrlSwitch, CtrlCV1, CtrlCV2, CtrlPulse1, CtrlPulse2, numControls};
+
+	struct Automation
+	{
+		std::vector<int> columns;         // ControlColumn for each CSV column after 'time', or -1
+		std::vector<double> times;
+		std::vector<std::vector<double>> rows;
+		bool present[numControls] = {};
+		size_t row = 0;                   // current row during playback
+	};
+
+	static bool ReadCsv(const std::string &filename, Automation &a)
+	{
+		static const char *names[numControls] = {"main", "x", "y", "switch", "cv1", "cv2", "pulse1", "pulse2"};
+		FILE *f = std::fopen(filename.c_str(), "r");
+		if (!f) return false;
+		char line[1024];
+		bool header = true;
+		while (std::fgets(line, sizeof(line), f))
+		{
+			std::vector<std::string> fields;
+			std::string field;
+			for (char *p = line; *p; p++)
+			{
+				if (*p == ',' || *p == '\n' || *p == '\r')
+				{
+					if (*p == ',' || !field.empty() || !fields.empty()) fields.push_back(field);
+					field.clear();
+					if (*p != ',') break;
+				}
+				else if (*p != ' ' && *p != '\t') field += *p;
+			}
+			if (!field.empty()) fields.push_back(field);
+			if (fields.empty() || fields[0][0] == '#') continue;
+
+			if (header)
+			{
+				for (size_t i=1; i<fields.size(); i++)
+				{
+					int c = -1;
+					for (int j=0; j<numControls; j++) if (fields[i] == names[j]) c = j;
+					if (c < 0) std::fprintf(stderr, "ComputerCard: ignoring unknown CSV column '%s'\n", fields[i].c_str());
+					else a.present[c] = true;
+					a.columns.push_back(c);
+				}
+				header = false;
+			}
+			else
+			{
+				a.times.push_back(std::atof(fields[0].c_str()));
+				std::vector<double> values(a.columns.size(), 0.0);
+				for (size_t i=1; i<fields.size() && i<=values.size(); i++) values[i-1] = std::atof(fields[i].c_str());
+				a.rows.push_back(values);
+			}
+		}
+		std::fclose(f);
+		return true;
+	}
+
+	////////////////////////////////////////
+	// Soak test, see COMPUTERCARD_SOAK and the stress generator in ComputerCard.h, which this
+	// follows, in place of the input files and automation
+	SoakStats soakRun = {};
+#ifdef COMPUTERCARD_SOAK
+	uint32_t soakRng = 0x1234567, soakPattern = 0, soakCalls = 0, soakFrames = 0;
+	uint32_t soakJacks = 0x3F; // bit i: jack i plugged in
+	uint32_t soakBucketCycles = 1;
+
+	uint32_t SoakRandom()
+	{
+		soakRng ^= soakRng << 13;
+		soakRng ^= soakRng >> 17;
+		soakRng ^= soakRng << 5;
+		return soakRng;
+	}
+
+	// Control i (0-4095) in the given mode, at frame f
+	int32_t SoakControl(uint32_t mode, int i, uint32_t f)
+	{
+		switch (mode)
+		{
+		case 0:
+		{
+			// Triangle, full range and back in 2^(11 + i) frames
+			int32_t v = int32_t((f << (21 - i)) >> 19);
+			return v < 4096 ? v : 8191 - v;
+		}
+		case 1: return int32_t(SoakRandom() & 4095);
+		case 2: return 0;
+		default: return 4095;
+		}
+	}
+
+	void SoakInputs(uint32_t f)
+	{
+		SoakStats &s = soakRun;
+		if ((f & 16383) == 0)
+		{
+			soakPattern = SoakRandom();
+			uint32_t sw = (soakPattern >> 28) & 3;
+			switchVal = sw == 3 ? Down : Switch(sw);
+			for (int i=0; i<6; i++)
+			{
+				if (((soakPattern >> (16 + 2*i)) & 3) == 0)
+				{
+					soakJacks ^= 1u << i;
+					s.jackChanges++;
+				}
+			}
+		}
+		uint32_t p = soakPattern;
+		for (int i=0; i<6; i++) connected[i] = (soakJacks >> i) & 1;
+		for (int i=0; i<3; i++) knobs[i] = SoakControl((p >> (2*i)) & 3, i, f);
+		for (int i=0; i<2; i++)
+		{
+			cv[i] = cvFast[i] = connected[CV1 + i] ? SoakControl((p >> (6 + 2*i)) & 3, 3 + i, f) - 2048 : 0;
+			bool on = (p & (1u << (10 + i))) ? (SoakRandom() & 1) : ((soakCalls >> i) & 1);
+			pulse[i] = connected[Pulse1 + i] && on;
+		}
+		soakCalls++;
+
+		if ((p >> 14) & 3)
+		{
+			static const uint8_t status[8] = {0x80, 0x90, 0x90, 0xB0, 0xB0, 0xD0, 0xE0, 0xF8};
+			uint32_t r = SoakRandom();
+			MIDIEvent e;
+			e.sample = f;
+			e.cable = 0;
+			e.data[0] = status[r & 7];
+			if (e.data[0] < 0xF0) e.data[0] |= uint8_t((r >> 3) & 15);
+			e.data[1] = uint8_t((r >> 8) & 127);
+			e.data[2] = uint8_t((r >> 16) & 127);
+			e.length = uint8_t(MIDIMessageLength(e.data[0]));
+			if (midiQueue.Push(e)) s.midiQueued++;
+			else s.midiDropped++;
+		}
+
+		soakFrames += blockSize;
+		if (soakFrames >= uint32_t(sampleRate))
+		{
+			soakFrames -= uint32_t(sampleRate);
+			s.seconds++;
+		}
+	}
+
+	int16_t SoakAudio(int ch, uint32_t frame)
+	{
+		if (!connected[Audio1 + ch]) return 0;
+		switch ((soakPattern >> 12) & 3)
+		{
+		case 0: return int16_t(int32_t(SoakRandom() & 4095) - 2048);
+		case 1: return (frame & 1) ? 2047 : -2048;
+		case 2: return 0;
+		default: return ch ? 2047 : -2048;
+		}
+	}
+
+	void SoakLoad(uint32_t t)
+	{
+		SoakStats &s = soakRun;
+		uint32_t b = soakBuckets - 1;
+		if (t <= s.budgetCycles)
+		{
+			b = t / soakBucketCycles;
+			if (b > soakBuckets - 2) b = soakBuckets - 2;
+		}
+		else if (s.overruns++ == 0) s.firstOverrun = s.seconds;
+		if (t > s.budgetCycles) s.lastOverrun = s.seconds;
+		s.histogram[b]++;
+		if (t > s.maxCycles) s.maxCycles = t;
+	}
+#endif
+
+	// Control recordings, see RecordingWrite and ComputerCard.h for the format
+
+	static constexpr int recordPageSize = 256;
+	std::vector<uint8_t> recordRing;
+	uint32_t recordPages = 0;
+	bool recordResync = true;
+	int recordPos = 0;
+	uint32_t recordTick = 0;
+	int32_t recordAnalog[5] = {};
+	uint32_t recordDigital = 0;
+
+	void RecordInputs(uint32_t frame)
+	{
+		int32_t a[5] = {knobs[0], knobs[1], knobs[2], cv[0], cv[1]};
+		uint32_t d = uint32_t(switchVal);
+		for (int i=0; i<2; i++)
+		{
+			d |= uint32_t(pulse[i]) << (2 + i);
+			if (pulse[i] && !last_pulse[i] && (recordDigital & (4u << i))) d |= 16u << i;
+		}
+		for (int i=0; i<6; i++) d |= uint32_t(connected[i]) << (6 + i);
+
+		uint32_t changed = (d != recordDigital) ? 32 : 0;
+		for (int i=0; i<5; i++) if (a[i] != recordAnalog[i]) changed |= 1u << i;
+		uint32_t tick = frame / blockSize;
+		if (!changed && !recordResync) return;
+
+		uint32_t numPages = uint32_t(recordRing.size() / recordPageSize);
+		if (recordResync || recordPos + 18 > recordPageSize)
+		{
+			uint8_t *page = recordRing.data() + (recordPages % numPages) * recordPageSize;
+			recordPages++;
+			std::memset(page, 0, recordPageSize);
+			for (int i=0; i<4; i++) page[i] = uint8_t(frame >> (8 * i));
+			for (int i=0; i<5; i++)
+			{
+				page[4 + 2*i] = uint8_t(a[i]);
+				page[5 + 2*i] = uint8_t(a[i] >> 8);
+			}
+			page[14] = uint8_t(d);
+			page[15] = uint8_t(d >> 8);
+			recordPos = 16;
+			recordResync = false;
+		}
+		else
+		{
+			uint8_t *page = recordRing.data() + ((recordPages - 1) % numPages) * recordPageSize;
+			uint8_t *r = page + recordPos;
+			uint32_t gap = tick - recordTick - 1;
+			*r++ = uint8_t(changed | ((gap < 3 ? gap : 3) << 6));
+			if (gap >= 3)
+			{
+				gap -= 3;
+				while (gap >= 128) {*r++ = uint8_t(gap | 128); gap >>= 7;}
+				*r++ = uint8_t(gap);
+			}
+			for (int i=0; i<5; i++)
+			{
+				if (!(changed & (1u << i))) continue;
+				int32_t delta = a[i] - recordAnalog[i];
+				uint32_t z = (uint32_t(delta) << 1) ^ uint32_t(delta >> 31);
+				while (z >= 128) {*r++ = uint8_t(z | 128); z >>= 7;}
+				*r++ = uint8_t(z);
+			}
+			if (changed & 32)
+			{
+				*r++ = uint8_t(d);
+				*r++ = uint8_t(d >> 8);
+			}
+			recordPos = int(r - page);
+		}
+		recordTick = tick;
+		for (int i=0; i<5; i++) recordAnalog[i] = a[i];
+		recordDigital = d;
+	}
+
+	// Inputs from a control recording, from the given frame on
+	struct ReplayState
+	{
+		uint64_t frame;
+		int32_t analog[5];                // knobs Main, X, Y, then CV 1, 2
+		uint32_t digital;                 // as recorded
+	};
+
+	struct Replay
+	{
+		std::vector<ReplayState> states;
+		int sampleRate = 0, blockSize = 0;
+		uint32_t endFrame = 0;            // frames played when it was written
+		size_t next = 0;                  // current state during playback
+	};
+
+	static bool ReadRecording(const std::string &filename, Replay &r)
+	{
+		FILE *f = std::fopen(filename.c_str(), "r");
+		if (!f) return false;
+		std::vector<uint8_t> bytes;
+		char line[1024];
+		while (std::fgets(line, sizeof(line), f))
+		{
+			if (line[0] == '#') continue;
+			if (!std::strncmp(line, "CCREC", 5))
+			{
+				std::sscanf(line + 5, "%d %d %u", &r.sampleRate, &r.blockSize, &r.endFrame);
+				continue;
+			}
+			auto nibble = [](char c) {return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;};
+			for (char *p = line; std::isxdigit(uint8_t(p[0])) && std::isxdigit(uint8_t(p[1])); p += 2)
+			{
+				bytes.push_back(uint8_t((nibble(p[0]) << 4) | nibble(p[1])));
+			}
+		}
+		std::fclose(f);
+		if (r.blockSize < 1 || bytes.size() % recordPageSize) return false;
+
+		for (size_t page = 0; page < bytes.size(); page += recordPageSize)
+		{
+			const uint8_t *b = &bytes[page], *end = b + recordPageSize;
+			ReplayState s;
+			s.frame = ReadLE(b, 4);
+			// Key frames in later pages continue the frame count, modulo 2^32
+			if (!r.states.empty()) s.frame += (r.states.back().frame - s.frame + 0x80000000ull) & ~uint64_t(0xFFFFFFFF);
+			for (int i=0; i<5; i++) s.analog[i] = int16_t(ReadLE(b + 4 + 2*i, 2));
+			s.digital = ReadLE(b + 14, 2);
+			r.states.push_back(s);
+			b += 16;
+			auto varint = [&]() {
+				uint32_t v = 0;
+				for (int shift = 0; b < end; shift += 7)
+				{
+					uint8_t c = *b++;
+					v |= uint32_t(c & 127) << shift;
+					if (!(c & 128)) break;
+				}
+				return v;
+			};
+			while (b < end && *b)
+			{
+				uint8_t header = *b++;
+				uint64_t gap = header >> 6;
+				if (gap == 3) gap += varint();
+				s.frame += (gap + 1) * uint64_t(r.blockSize);
+				for (int i=0; i<5; i++)
+				{
+					if (!(header & (1u << i))) continue;
+					uint32_t z = varint();
+					s.analog[i] += int32_t(z >> 1) ^ -int32_t(z & 1);
+				}
+				if (header & 32)
+				{
+					s.digital = (b + 2 <= end) ? ReadLE(b, 2) : s.digital;
+					b += 2;
+				}
+				r.states.push_back(s);
+			}
+		}
+		return !r.states.empty();
+	}
+
+	// Set knobs/switch/CV/pulse inputs and connections from a recording, at the given frame
+	void ApplyReplay(Replay &r, uint64_t frame)
+	{
+		if (r.states.empty()) return;
+		while (r.next + 1 < r.states.size() && r.states[r.next + 1].frame <= frame) r.next++;
+		const ReplayState &s = r.states[r.next];
+		for (int i=0; i<3; i++) knobs[i] = s.analog[i];
+		cv[0] = s.analog[3];
+		cv[1] = s.analog[4];
+		switchVal = static_cast<Switch>(Clamp(int(s.digital & 3), 0, 2));
+		for (int i=0; i<2; i++)
+		{
+			pulse[i] = (s.digital >> (2 + i)) & 1;
+			// A pulse latched within a block, which rose again while still high
+			if ((s.digital & (16u << i)) && s.frame == frame) last_pulse[i] = false;
+		}
+		for (int i=0; i<6; i++)
+		{
+			bool c = (s.digital >> (6 + i)) & 1;
+			if (c == connected[i]) continue;
+			connected[i] = c;
+			if (useNormProbe) ConnectionChanged(Input(i), c);
+		}
+	}
+
+	// Set knobs/switch/CV/pulse inputs from automation at time t (seconds)
+	void ApplyAutomation(Automation &a, double t)
+	{
+		if (a.rows.empty()) return;
+		while (a.row + 1 < a.times.size() && a.times[a.row + 1] <= t) a.row++;
+		size_t r0 = a.row, r1 = (a.row + 1 < a.times.size()) ? a.row + 1 : a.row;
+		double frac = 0.0;
+		if (r1 != r0 && t > a.times[r0]) frac = (t - a.times[r0]) / (a.times[r1] - a.times[r0]);
+		if (frac > 1.0) frac = 1.0;
+
+		for (size_t i=0; i<a.columns.size(); i++)
+		{
+			double v0 = a.rows[r0][i];
+			double v = v0 + (a.rows[r1][i] - v0) * frac;
+			switch (a.columns[i])
+			{
+			case CtrlMain: knobs[Main] = Clamp(int(std::lround(v)), 0, 4095); break;
+			case CtrlX: knobs[X] = Clamp(int(std::lround(v)), 0, 4095); break;
+			case CtrlY: knobs[Y] = Clamp(int(std::lround(v)), 0, 4095); break;
+			case CtrlSwitch: switchVal = static_cast<Switch>(Clamp(int(v0), 0, 2)); break;
+			case CtrlCV1: cv[0] = Clamp(int(std::lround(v)), -2048, 2047); break;
+			case CtrlCV2: cv[1] = Clamp(int(std::lround(v)), -2048, 2047); break;
+			case CtrlPulse1: SetPulse(0, v0 > 0.5, t - a.times[r0]); break;
+			case CtrlPulse2: SetPulse(1, v0 > 0.5, t - a.times[r0]); break;
+			default: break;
+			}
+		}
+	}
+
+	// Set a pulse input from automation, timing any edge from the row that changed it, 'ago' seconds before now
+	void SetPulse(int i, bool value, double ago)
+	{
+		if (usePulseCapture && value != pulse[i])
+		{
+			double offset = ago * sampleRate * 65536.0;
+			double period = blockSize * 65536.0;
+			pulseEdgeOffset[i][value ? 0 : 1] = uint32_t(offset < period ? offset : period);
+		}
+		pulse[i] = value;
+	}
+
+	static int Clamp(int v, int lo, int hi) {return v < lo ? lo : (v > hi ? hi : v);}
+
+	static int16_t Clip12(int32_t v) {return int16_t(Clamp(v, -2048, 2047));}
+
+	// EnableNoiseShaping: 16-bit outputs rounded to 12 bits in place, as ComputerCard::ShapeOutputs
+	int noiseShapingOrder;
+	int32_t shapingError[2][2] = {};
+	void ShapeOutputs(Frame *frames, int n)
+	{
+		for (int c=0; c<2; c++)
+		{
+			int32_t e1 = shapingError[c][0], e2 = shapingError[c][1];
+			for (int f=0; f<n; f++)
+			{
+				int32_t v = frames[f].audio[c] - e1;
+				if (noiseShapingOrder == 2) v += e2 - e1;
+				int32_t q = (v + 8) >> 4;
+				e2 = e1;
+				e1 = (q << 4) - v;
+				frames[f].audio[c] = Clip12(q);
+			}
+			shapingError[c][0] = e1;
+			shapingError[c][1] = e2;
+		}
+	}
+
+	// Read current output values into one frame of the 6-channel output file
+	void CollectOutputs(std::vector<int16_t> &out, int16_t a1, int16_t a2, int frame = 0)
+	{
+		out.push_back(int16_t(Clip12(a1) * 16));
+		out.push_back(int16_t(Clip12(a2) * 16));
+		for (int i=0; i<2; i++)
+		{
+			// Convert 19-bit (inverted) PWM value back to signed 16-bit
+			int32_t cvOut = (262143 - int32_t(cvValue[i])) >> 3;
+			out.push_back(int16_t(Clamp(cvOut, -32768, 32767)));
+		}
+		for (int i=0; i<2; i++)
+		{
+			if (usePulseAudio) out.push_back(int16_t(pulseAudioLevel[frame][i] * 32767 / 255));
+			else out.push_back(pulseOut[i] ? 32767 : 0);
+		}
+	}
+
+	// Sample clock sync, as ComputerCard.h, without the ADC clock to trim
+	enum SyncMode {SyncOff, SyncLead, SyncFollow};
+	SyncMode syncMode = SyncOff;
+	int syncPin = 0;
+	int32_t syncPeriod = 48;
+	uint32_t syncCount = 0, syncOffset = 0;
+	static constexpr uint32_t syncADCInterval = 125;
+	int32_t syncKp = 0, syncKi = 0, syncMaxTrim = 0;
+	int32_t syncIntegral = 0, syncTrim = 0, syncPhase = 0, syncGood = -1;
+	uint32_t syncRealigns = 0, syncEdgeAge = 0;
+
+	void SetupSync()
+	{
+		syncPeriod = ((syncPeriod + blockSize - 1) / blockSize) * blockSize;
+		if (syncPeriod < 2 * blockSize) syncPeriod = 2 * blockSize;
+		if (syncPeriod > 4096) syncPeriod = 4096;
+		float g = float(syncPeriod) / (256.0f * float(syncADCInterval));
+		float wT = 2.0f * 3.14159265f * 0.5f * float(syncPeriod) / float(sampleRate);
+		syncKp = int32_t(65536.0f * 2.0f * 0.7f * wT / g);
+		syncKi = int32_t(65536.0f * wT * wT / g);
+		syncMaxTrim = int32_t((int64_t(syncADCInterval) << 24) / 1000);
+		syncCount = ~0u; // aligned with SampleCounter by the next ServiceSync
+		syncOffset = 0;
+		syncIntegral = syncTrim = syncPhase = 0;
+		syncGood = -1;
+		syncRealigns = syncEdgeAge = 0;
+	}
+
+	void ServiceSync()
+	{
+		if (syncCount >= uint32_t(syncPeriod)) syncCount = callbackFrame % uint32_t(syncPeriod);
+		if (syncMode == SyncLead)
+		{
+			PulseOut(syncPin, syncCount < uint32_t(syncPeriod / 2));
+		}
+		else if (pulse[syncPin] && !last_pulse[syncPin])
+		{
+			uint32_t offset = usePulseCapture ? pulseEdgeOffset[syncPin][0] : uint32_t(blockSize) << 16;
+			int32_t half = syncPeriod << 15;
+			int32_t p = int32_t(syncCount << 16) - int32_t(offset);
+			if (p >= half) p -= 2 * half;
+			if (p < -half) p += 2 * half;
+			if (syncGood < 0 || p > (2 << 16) || p < -(2 << 16))
+			{
+				int32_t shift = (p + 32768) >> 16;
+				syncOffset -= uint32_t(shift);
+				syncCount = uint32_t((int32_t(syncCount) - shift % syncPeriod + syncPeriod) % syncPeriod);
+				p -= shift << 16;
+				syncRealigns++;
+				syncGood = 0;
+			}
+			syncPhase = p;
+			int32_t limit = syncMaxTrim;
+			syncIntegral += int32_t((int64_t(p) * syncKi) >> 16);
+			syncIntegral = syncIntegral > limit ? limit : (syncIntegral < -limit ? -limit : syncIntegral);
+			int64_t u = ((int64_t(p) * syncKp) >> 16) + syncIntegral;
+			syncTrim = int32_t(u > limit ? limit : (u < -limit ? -limit : u));
+			if (p < 8192 && p > -8192) {if (syncGood < 16) syncGood++;}
+			else syncGood = 0;
+			syncEdgeAge = 0;
+		}
+		else if (syncEdgeAge < 0x80000000u)
+		{
+			syncEdgeAge += blockSize;
+			if (syncEdgeAge > 4 * uint32_t(syncPeriod) && syncGood > 0) syncGood = 0;
+		}
+		syncCount += blockSize;
+		if (syncCount >= uint32_t(syncPeriod)) syncCount -= syncPeriod;
+	}
+
+	void UpdateLoadMeter(uint64_t ns)
+	{
+		uint32_t t = ns > 0xFFFFFF ? 0xFFFFFF : uint32_t(ns);
+		if (t < loadMinCycles) loadMinCycles = t;
+		if (t > loadMaxCycles) loadMaxCycles = t;
+		loadAvgCycles8 += t - (loadAvgCycles8 >> 8);
+		if (t > loadBudgetCycles) loadOverruns++;
+#ifdef COMPUTERCARD_SOAK
+		SoakLoad(t);
+#endif
+	}
+
+	void AudioWorker()
+	{
+		using clock = std::chrono::steady_clock;
+		HostConfig &config = Host();
+
+		WavData in;
+		if (!config.inputWav.empty() && !ReadWav(config.inputWav, in))
+		{
+			std::fprintf(stderr, "ComputerCard: can't read 16-bit PCM WAV file '%s'\n", config.inputWav.c_str());
+			std::exit(1);
+		}
+		if (in.channels && in.sampleRate != sampleRate)
+		{
+			std::fprintf(stderr, "ComputerCard: warning, '%s' is %dHz, but will be played at %dHz\n", config.inputWav.c_str(), in.sampleRate, int(sampleRate));
+		}
+
+#ifdef COMPUTERCARD_LINK
+		linkOutSamples.clear();
+		linkInSamples.clear();
+		linkInFrames = 0;
+		if (useAudioLink && !config.linkIn.empty())
+		{
+			WavData link;
+			if (!ReadWav(config.linkIn, link))
+			{
+				std::fprintf(stderr, "ComputerCard: can't read 16-bit PCM WAV file '%s'\n", config.linkIn.c_str());
+				std::exit(1);
+			}
+			if (link.channels != COMPUTERCARD_LINK + 2)
+			{
+				std::fprintf(stderr, "ComputerCard: '%s' has %d channels, but a link of %d needs %d\n",
+							 config.linkIn.c_str(), link.channels, COMPUTERCARD_LINK, COMPUTERCARD_LINK + 2);
+				std::exit(1);
+			}
+			linkInSamples.swap(link.samples);
+			linkInFrames = linkInSamples.size() / (COMPUTERCARD_LINK + 2);
+		}
+#endif
+
+		Automation automation;
+		Replay replay;
+		if (!config.replay.empty())
+		{
+			if (!ReadRecording(config.replay, replay))
+			{
+				std::fprintf(stderr, "ComputerCard: can't read control recording '%s'\n", config.replay.c_str());
+				std::exit(1);
+			}
+			if (replay.blockSize != blockSize || replay.sampleRate != sampleRate)
+			{
+				std::fprintf(stderr, "ComputerCard: warning, '%s' was recorded at %dHz with blocks of %d, but is replayed at %dHz with blocks of %d\n",
+							 config.replay.c_str(), replay.sampleRate, replay.blockSize, int(sampleRate), blockSize);
+			}
+		}
+		else if (!config.controlCsv.empty() && !ReadCsv(config.controlCsv, automation))
+		{
+			std::fprintf(stderr, "ComputerCard: can't read CSV file '%s'\n", config.controlCsv.c_str());
+			std::exit(1);
+		}
+
+#ifdef COMPUTERCARD_RECORD
+		recordRing.assign(COMPUTERCARD_RECORD, 0);
+#else
+		if (!config.recordOut.empty()) recordRing.assign(1 << 20, 0);
+#endif
+		RecordingClear();
+
+		if (useNormProbe && replay.states.empty())
+		{
+			connected[Audio1] = in.channels >= 1;
+			connected[Audio2] = in.channels >= 2;
+			connected[CV1] = automation.present[CtrlCV1];
+			connected[CV2] = automation.present[CtrlCV2];
+			connected[Pulse1] = automation.present[CtrlPulse1];
+			connected[Pulse2] = automation.present[CtrlPulse2];
+			// As on the card, where every input starts disconnected until the probe finds its jack
+			for (int i=0; i<6; i++) if (connected[i]) ConnectionChanged(Input(i), true);
+		}
+
+		uint64_t numFrames = in.channels ? in.samples.size() / in.channels : uint64_t(config.seconds * sampleRate);
+		if (!in.channels && !replay.states.empty())
+		{
+			numFrames = replay.states.back().frame + blockSize;
+			if (replay.endFrame > numFrames) numFrames = replay.endFrame;
+		}
+		numFrames -= numFrames % blockSize;
+
+		if (syncMode) SetupSync();
+
+		// ns per sample/block available in real time
+		loadBudgetCycles = uint32_t((1000000000ULL * blockSize) / sampleRate);
+		loadAvgCycles8 = 0;
+		ResetLoadMeter();
+#ifdef COMPUTERCARD_SOAK
+		useLoadMeter = true;
+		soakRun.budgetCycles = loadBudgetCycles;
+		soakBucketCycles = loadBudgetCycles >= 16 ? loadBudgetCycles / 16 : 1;
+#endif
+
+		std::vector<int16_t> out;
+		if (!config.outputWav.empty()) out.reserve(numFrames * 6);
+
+		Frame blockIn[blockSize], blockOut[blockSize];
+		aborted = false;
+		bool startup = true;
+		if (usePulseAudio) usePulseEngine = false;
+
+		if (useLedEngine)
+		{
+			ledPeriod = sampleRate / ledRefreshHz;
+			ledMeterDecay = (4095 * 1000) / (300 * ledRefreshHz); // full scale to zero in 300ms
+			if (ledMeterDecay < 1) ledMeterDecay = 1;
+		}
+
+		// Time the whole render loop, which includes a little overhead from reading
+		// automation and collecting outputs, rather than timing every call
+		clock::time_point renderStart = clock::now();
+		uint64_t frame = 0;
+		for (; frame < numFrames && !aborted; frame += blockSize)
+		{
+			last_pulse[0] = pulse[0];
+			last_pulse[1] = pulse[1];
+			int32_t lastKnobs[3] = {knobs[0], knobs[1], knobs[2]}, lastCV[2] = {cv[0], cv[1]};
+			if (!replay.states.empty()) ApplyReplay(replay, frame);
+			else ApplyAutomation(automation, double(frame) / sampleRate);
+			cvFast[0] = cv[0];
+			cvFast[1] = cv[1];
+			if (useAdaptiveSmoothing && replay.states.empty())
+			{
+				for (int i=0; i<3; i++)
+				{
+					knobSmoother[i].Update(knobs[i], hostSmoothShift);
+					knobs[i] = knobSmoother[i].Value();
+				}
+				for (int i=0; i<2; i++)
+				{
+					cvSmoother[i].Update(cv[i], hostSmoothShift);
+					cv[i] = cvSmoother[i].Value();
+				}
+			}
+#ifdef COMPUTERCARD_SOAK
+			SoakInputs(uint32_t(frame));
+#endif
+			for (int i=0; i<3; i++) if (knobs[i] != lastKnobs[i]) controlsChanged |= ChangedMain << i;
+			for (int i=0; i<2; i++) if (cv[i] != lastCV[i]) controlsChanged |= ChangedCV1 << i;
+			if (switchVal != lastSwitchVal) controlsChanged |= ChangedSwitch;
+			if (startup)
+			{
+				// Don't detect switch change or pulse edges on first sample
+				lastSwitchVal = switchVal;
+				last_pulse[0] = pulse[0];
+				last_pulse[1] = pulse[1];
+				startup = false;
+			}
+
+			for (int i=0; i<blockSize; i++)
+			{
+				int16_t l = 0, r = 0;
+				if (in.channels)
+				{
+					// Mono input files drive Audio 1 only
+					l = in.samples[(frame + i) * in.channels] >> 4;
+					if (in.channels > 1) r = in.samples[(frame + i) * in.channels + 1] >> 4;
+				}
+				blockIn[i].audio[0] = l;
+				blockIn[i].audio[1] = r;
+#ifdef COMPUTERCARD_SOAK
+				blockIn[i].audio[0] = SoakAudio(0, uint32_t(frame) + i);
+				blockIn[i].audio[1] = SoakAudio(1, uint32_t(frame) + i);
+#endif
+			}
+			if (captureBuffer) memcpy(captureBuffer + captureIndex, blockIn, sizeof(blockIn));
+
+			clock::time_point start;
+			if (useLoadMeter) start = clock::now();
+			__atomic_store_n(&callbackFrame, uint32_t(frame), __ATOMIC_RELEASE);
+			if (!recordRing.empty()) RecordInputs(uint32_t(frame));
+			if (syncMode) ServiceSync();
+			if (useAudioLink) ReceiveLink(frame);
+			if (frame % lockstepFrames == 0) RunCore1Turn();
+			if (usePulseEngine) StartScheduledPulses();
+			if (useInputSnapshot) TakeInputSnapshot();
+			PollControl();
+			if (blockSize > 1)
+			{
+				ProcessBlock(blockIn, blockOut, blockSize);
+				if (subRateStages) MixSubRate(blockOut, blockIn, blockSize, noiseShapingOrder ? 4 : 0);
+				if (noiseShapingOrder) ShapeOutputs(blockOut, blockSize);
+			}
+			else
+			{
+				adcInL = blockIn[0].audio[0];
+				adcInR = blockIn[0].audio[1];
+				inputs.audio[0] = adcInL;
+				inputs.audio[1] = adcInR;
+				ProcessSample();
+				blockOut[0].audio[0] = dacOut[0];
+				blockOut[0].audio[1] = dacOut[1];
+				if (subRateStages) MixSubRate(blockOut, blockIn, 1, 0);
+			}
+			if (captureBuffer && (captureIndex += blockSize) == captureFrames) captureIndex = 0;
+			if (useAudioLink) SendLink(!config.linkOut.empty());
+			if (useLoadMeter)
+			{
+				clock::duration elapsed = clock::now() - start;
+				UpdateLoadMeter(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+			}
+			if (useLedEngine) PollLeds();
+			if (frame == 0) bootTimes.firstSample = time_us_32();
+			if (nextStartupTask < numStartupTasks)
+			{
+				// One step of background setup per block, see AddStartupTask
+				if (!(this->*startupTasks[nextStartupTask])(startupStep++))
+				{
+					startupStep = 0;
+					if (++nextStartupTask == numStartupTasks) bootTimes.startupDone = time_us_32();
+				}
+			}
+
+			for (int i=0; i<blockSize; i++)
+			{
+				if (usePulseEngine) UpdateScheduledPulses();
+				if (!config.outputWav.empty()) CollectOutputs(out, blockOut[i].audio[0], blockOut[i].audio[1], i);
+			}
+			lastSwitchVal = switchVal;
+		}
+
+		clock::duration processTime = clock::now() - renderStart;
+
+		HostReport &report = Report();
+		report.samples = frame;
+		report.seconds = std::chrono::duration<double>(processTime).count();
+		report.nsPerSample = frame ? report.seconds * 1e9 / double(frame) : 0;
+		report.realTimeFactor = report.seconds > 0 ? (double(frame) / sampleRate) / report.seconds : 0;
+
+		if (!config.quiet)
+		{
+			std::fprintf(stderr, "ComputerCard: %llu samples (%.2fs of audio) in %.3fs: %.1f ns/sample, %.0fx real time\n",
+						 (unsigned long long)report.samples, double(report.samples) / sampleRate, report.seconds,
+						 report.nsPerSample, report.realTimeFactor);
+		}
+
+#ifdef COMPUTERCARD_SOAK
+		if (!config.quiet) SoakReportWrite([](const char *s, int n) {std::fwrite(s, 1, size_t(n), stderr);});
+#endif
+
+		if (!config.outputWav.empty() && !WriteWav(config.outputWav, 6, sampleRate, out))
+		{
+			std::fprintf(stderr, "ComputerCard: can't write WAV file '%s'\n", config.outputWav.c_str());
+			std::exit(1);
+		}
+
+#ifdef COMPUTERCARD_LINK
+		if (useAudioLink && !config.linkOut.empty() && !WriteWav(config.linkOut, COMPUTERCARD_LINK + 2, sampleRate, linkOutSamples))
+		{
+			std::fprintf(stderr, "ComputerCard: can't write WAV file '%s'\n", config.linkOut.c_str());
+			std::exit(1);
+		}
+#endif
+
+		if (!config.recordOut.empty())
+		{
+			FILE *f = std::fopen(config.recordOut.c_str(), "w");
+			if (!f)
+			{
+				std::fprintf(stderr, "ComputerCard: can't write control recording '%s'\n", config.recordOut.c_str());
+				std::exit(1);
+			}
+			RecordingWrite([f](const char *s, int n) {std::fwrite(s, 1, size_t(n), f);});
+			std::fclose(f);
+		}
+	}
+};
+
+/** \brief ComputerCard with the card's ProcessSample called directly, rather than through a virtual function
+
+	As on the card: derive as class MyCard : public ComputerCardT<MyCard>, and the input functions
+	read a copy of the inputs taken once per sample (or block). The render loop still calls
+	ProcessSample virtually with blocks of one frame, which is the same function.
+*/
+template <class Derived>
+class ComputerCardT : public ComputerCard
+{
+public:
+	/// Render audio, as ComputerCard::Run
+	void Run(SampleRate_t rate = SR48kHz)
+	{
+		useInputSnapshot = true;
+		ComputerCard::Run(rate);
+	}
+
+protected:
+	/// ProcessSample for each frame, as ComputerCard::ProcessBlock
+	void ProcessBlock(const Frame *in, Frame *out, int n) override
+	{
+		for (int i=0; i<n; i++)
+		{
+			inputs.audio[0] = in[i].audio[0];
+			inputs.audio[1] = in[i].audio[1];
+			static_cast<Derived *>(this)->Derived::ProcessSample();
+			out[i].audio[0] = dacOut[0];
+			out[i].audio[1] = dacOut[1];
+
+			// Edges and switch changes are only reported on the first frame of the block
+			inputs.lastPulse[0] = inputs.pulse[0];
+			inputs.lastPulse[1] = inputs.pulse[1];
+			inputs.lastSwitchVal = inputs.switchVal;
+		}
+	}
+
+	/// \name Inputs, as ComputerCard's, from the copy taken for this sample
+	///@{
+	int32_t KnobVal(Knob ind) {return inputs.knobs[ind];}
+	Switch SwitchVal() {return inputs.switchVal;}
+	bool SwitchChanged() {return inputs.switchVal != inputs.lastSwitchVal;}
+	int16_t AudioIn(int i) {return inputs.audio[i ? 1 : 0];}
+	int16_t AudioIn1() {return inputs.audio[0];}
+	int16_t AudioIn2() {return inputs.audio[1];}
+	int16_t CVIn(int i) {return inputs.cv[i];}
+	int16_t CVIn1() {return inputs.cv[0];}
+	int16_t CVIn2() {return inputs.cv[1];}
+	int16_t CVInFast(int i) {return inputs.cvFast[i];}
+	int32_t CVInPitchQ16(int i) {return CVInPitch(i, inputs.cv[i]);}
+	int CVInNote(int i) {return (CVInPitchQ16(i) + 32768) >> 16;}
+	bool PulseIn(int i) {return inputs.pulse[i];}
+	bool PulseInRisingEdge(int i) {return inputs.pulse[i] && !inputs.lastPulse[i];}
+	bool PulseInFallingEdge(int i) {return !inputs.pulse[i] && inputs.lastPulse[i];}
+	bool PulseIn1() {return inputs.pulse[0];}
+	bool PulseIn1RisingEdge() {return inputs.pulse[0] && !inputs.lastPulse[0];}
+	bool PulseIn1FallingEdge() {return !inputs.pulse[0] && inputs.lastPulse[0];}
+	bool PulseIn2() {return inputs.pulse[1];}
+	bool PulseIn2RisingEdge() {return inputs.pulse[1] && !inputs.lastPulse[1];}
+	bool PulseIn2FallingEdge() {return !inputs.pulse[1] && inputs.lastPulse[1];}
+	bool Connected(Input i) {return inputs.connected[i];}
+	bool Disconnected(Input i) {return !inputs.connected[i];}
+	///@}
+};
+
+/** \brief Several cards in one firmware image, as on the card
+
+	Each card renders in turn, from the start of the input, until it calls SwitchCard. The switch
+	gesture (holdMs) is not detected, as it would repeat on every render. Threads started with
+	RunOnCore1 can't be stopped, so cards that use them can't be switched away from.
+*/
+template <class... Cards>
+class CardLauncher
+{
+	static constexpr size_t Largest()
+	{
+		size_t sizes[] = {sizeof(Cards)...}, largest = 0;
+		for (size_t s : sizes) if (s > largest) largest = s;
+		return largest;
+	}
+
+public:
+	static constexpr int numCards = sizeof...(Cards);
+
+	/// RAM taken by the cards: that of the largest
+	static constexpr size_t storageBytes = Largest();
+
+	/// Render card number first, then each card switched to
+	static void Run(int first = 0, uint32_t holdMs = 2000, ComputerCard::SampleRate_t rate = ComputerCard::SR48kHz)
+	{
+		(void)holdMs;
+		static void (*const launch[])(ComputerCard::SampleRate_t) = {&Launch<Cards>...};
+		int card = first;
+		while (card >= 0)
+		{
+			ComputerCard::cardIndex = card;
+			ComputerCard::cardRequest = -1;
+			launch[card](rate);
+			card = ComputerCard::cardRequest;
+			if (card >= numCards) card %= numCards;
+		}
+	}
+
+private:
+	alignas(Cards...) static inline uint8_t storage[storageBytes];
+
+	template <class C>
+	static void Launch(ComputerCard::SampleRate_t rate)
+	{
+		C *card = new (storage) C;
+		card->Run(rate);
+		card->~C();
+	}
+};
+
+#endif
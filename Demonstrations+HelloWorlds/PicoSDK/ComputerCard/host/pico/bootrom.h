@@ -0,0 +1,5 @@
+// Host stand-in for the Pico SDK header of the same name
+#include "pico_host.h"
+
+// No bootloader to reboot into on the host
+static inline void rom_reset_usb_boot(uint32_t, uint32_t) {}
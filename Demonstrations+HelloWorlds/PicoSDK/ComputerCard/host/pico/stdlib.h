@@ -0,0 +1,2 @@
+// Host stand-in for the Pico SDK header of the same name
+#include "pico_host.h"
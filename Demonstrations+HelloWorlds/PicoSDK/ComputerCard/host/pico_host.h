@@ -0,0 +1,75 @@
+/*
+Minimal stand-ins for the Pico SDK functions most commonly called by cards,
+so that card source files compile natively with the host ComputerCard.h.
+
+Clock, sleep and timer functions behave sensibly on the host; hardware
+functions that have no meaning here do nothing.
+*/
+
+#ifndef COMPUTERCARD_PICO_HOST_H
+#define COMPUTERCARD_PICO_HOST_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <thread>
+
+typedef unsigned int uint;
+
+// Defined by newlib's math.h on the RP2040, but not by all host C libraries
+#ifndef M_TWOPI
+#define M_TWOPI (2.0 * M_PI)
+#endif
+
+// The RP2040 toolchain's <cmath> provides float versions of these in std::, libstdc++ may not
+namespace std
+{
+	using ::sinf; using ::cosf; using ::tanf; using ::tanhf; using ::atanf; using ::atan2f;
+	using ::expf; using ::exp2f; using ::logf; using ::log2f; using ::log10f; using ::powf;
+	using ::sqrtf; using ::fabsf; using ::floorf; using ::ceilf; using ::roundf; using ::fmodf;
+}
+
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+#define __not_in_flash(group)
+#define __scratch_x(group)
+#define __scratch_y(group)
+#define __uninitialized_ram(group) group
+#define __force_inline inline
+
+static inline bool set_sys_clock_khz(uint32_t, bool) {return true;}
+
+// Set by the host ComputerCard.h when the second core runs in lockstep with the audio
+// (HostConfig::lockstep): called with the time asked for by sleeps, and with 0 by
+// tight_loop_contents. Returns false where the wait should happen as usual.
+inline bool (*host_wait_hook)(uint64_t us) = nullptr;
+
+static inline void tight_loop_contents() {if (host_wait_hook) host_wait_hook(0);}
+
+static inline uint64_t time_us_64()
+{
+	using namespace std::chrono;
+	static const steady_clock::time_point start = steady_clock::now();
+	return duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+static inline uint32_t time_us_32() {return uint32_t(time_us_64());}
+static inline void sleep_us(uint64_t us)
+{
+	if (!host_wait_hook || !host_wait_hook(us)) std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+static inline void sleep_ms(uint32_t ms) {sleep_us(uint64_t(ms) * 1000);}
+
+static inline void stdio_init_all() {}
+
+// No USB serial on the host: nothing is ever received
+#define PICO_ERROR_TIMEOUT (-1)
+static inline int getchar_timeout_us(uint32_t) {return PICO_ERROR_TIMEOUT;}
+
+// Second core runs as a detached thread, which ends when the render finishes and main() returns
+static inline void multicore_launch_core1(void (*entry)(void)) {std::thread(entry).detach();}
+
+static inline uint32_t save_and_disable_interrupts() {return 0;}
+static inline void restore_interrupts(uint32_t) {}
+
+#endif
@@ -0,0 +1,82 @@
+// Function call counts, for profile-guided code placement on the Computer.
+//
+// Linked into host cards built with COMPUTERCARD_PROFILE=ON, whose code is compiled with
+// -finstrument-functions. While the card renders, every call into card code is counted by
+// function address; at exit the counts are written to the file named by the environment
+// variable COMPUTERCARD_PROFILE, as offsets from __cyg_profile_func_enter (so that they
+// survive address space randomisation) and counts, one function per line.
+// host/profile_hot.cmake turns them into a card's hot_functions.txt.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#define NO_INSTRUMENT __attribute__((no_instrument_function))
+
+extern "C"
+{
+	void __cyg_profile_func_enter(void *fn, void *caller) NO_INSTRUMENT;
+	void __cyg_profile_func_exit(void *fn, void *caller) NO_INSTRUMENT;
+}
+
+namespace
+{
+	// Open addressing by function address; cards have far fewer functions than this
+	constexpr unsigned tableSize = 1 << 14;
+	struct Entry
+	{
+		void *fn;
+		uint64_t count;
+	};
+	Entry table[tableSize];
+
+	void WriteProfile() NO_INSTRUMENT;
+	void WriteProfile()
+	{
+		const char *name = std::getenv("COMPUTERCARD_PROFILE");
+		if (!name) return;
+		FILE *f = std::fopen(name, "w");
+		if (!f)
+		{
+			std::fprintf(stderr, "Could not write profile %s\n", name);
+			return;
+		}
+		intptr_t base = intptr_t(&__cyg_profile_func_enter);
+		for (unsigned i=0; i<tableSize; i++)
+		{
+			void *fn = __atomic_load_n(&table[i].fn, __ATOMIC_RELAXED);
+			if (fn) std::fprintf(f, "%lld %llu\n", (long long)(intptr_t(fn) - base), (unsigned long long)table[i].count);
+		}
+		std::fclose(f);
+	}
+
+	struct Writer
+	{
+		~Writer() NO_INSTRUMENT {WriteProfile();}
+	} writer;
+}
+
+// Both cores (threads) count into the same table
+void __cyg_profile_func_enter(void *fn, void *)
+{
+	unsigned h = unsigned(uintptr_t(fn) >> 2) & (tableSize - 1);
+	for (unsigned n=0; n<tableSize; n++, h = (h + 1) & (tableSize - 1))
+	{
+		void *e = __atomic_load_n(&table[h].fn, __ATOMIC_ACQUIRE);
+		if (!e)
+		{
+			void *expected = nullptr;
+			if (__atomic_compare_exchange_n(&table[h].fn, &expected, fn, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) e = fn;
+			else e = expected;
+		}
+		if (e == fn)
+		{
+			__atomic_fetch_add(&table[h].count, 1, __ATOMIC_RELAXED);
+			return;
+		}
+	}
+}
+
+void __cyg_profile_func_exit(void *, void *)
+{
+}
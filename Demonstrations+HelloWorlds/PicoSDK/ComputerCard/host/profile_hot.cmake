@@ -0,0 +1,84 @@
+# Turn a host profile (see profile.cpp) into a card's list of hot functions
+#
+#   cmake -S . -B build-profile -DCOMPUTERCARD_PROFILE=ON && cmake --build build-profile
+#   COMPUTERCARD_PROFILE=card.prof COMPUTERCARD_CONTROL=... build-profile/<card>
+#   cmake -DNM=nm -DEXE=build-profile/<card> -DPROFILE=card.prof -DOUT=../examples/<card>/hot_functions.txt -P profile_hot.cmake
+#
+# Writes the functions called at least 1/HOT_FRACTION (default 1000) as often as the most
+# called one, most called first, one per line as <count> <mangled name>. The device build
+# (hot_link.cmake) links these together at the start of flash, so that the code run by the
+# audio interrupt shares as few XIP cache lines as possible with startup and USB code.
+# Names are those of the host build: functions the device build inlines, or puts in SRAM
+# with __not_in_flash_func, are simply skipped there.
+
+if (NOT NM OR NOT EXE OR NOT PROFILE OR NOT OUT)
+	message(FATAL_ERROR "Set NM, EXE, PROFILE and OUT, e.g. cmake -DNM=nm -DEXE=build/card -DPROFILE=card.prof -DOUT=hot_functions.txt -P profile_hot.cmake")
+endif()
+if (NOT HOT_FRACTION)
+	set(HOT_FRACTION 1000)
+endif()
+
+# Function addresses in the executable, by name (mangled, as in the device build's section names)
+execute_process(COMMAND ${NM} --defined-only ${EXE}
+	OUTPUT_VARIABLE symbols
+	RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+	message(FATAL_ERROR "profile_hot: could not read symbols from ${EXE}")
+endif()
+string(REPLACE "\n" ";" lines "${symbols}")
+set(base "")
+foreach (line IN LISTS lines)
+	if (NOT line MATCHES "^([0-9a-f]+) ([tTwW]) (.*)$")
+		continue()
+	endif()
+	math(EXPR addr "0x${CMAKE_MATCH_1}")
+	set(name "${CMAKE_MATCH_3}")
+	if (name STREQUAL "__cyg_profile_func_enter")
+		set(base ${addr})
+	endif()
+	set(symbol_${addr} "${name}")
+endforeach()
+if (base STREQUAL "")
+	message(FATAL_ERROR "profile_hot: ${EXE} was not built with COMPUTERCARD_PROFILE=ON")
+endif()
+
+# <offset from __cyg_profile_func_enter> <count>, sorted by count through a zero-padded key
+file(STRINGS ${PROFILE} entries)
+set(sorted "")
+set(maxCount 0)
+foreach (entry IN LISTS entries)
+	if (NOT entry MATCHES "^(-?[0-9]+) ([0-9]+)$")
+		continue()
+	endif()
+	math(EXPR addr "${base} + ${CMAKE_MATCH_1}")
+	set(count ${CMAKE_MATCH_2})
+	if (NOT DEFINED symbol_${addr})
+		continue()
+	endif()
+	if (count GREATER maxCount)
+		set(maxCount ${count})
+	endif()
+	string(LENGTH ${count} digits)
+	math(EXPR pad "20 - ${digits}")
+	string(SUBSTRING "00000000000000000000" 0 ${pad} zeros)
+	list(APPEND sorted "${zeros}${count} ${symbol_${addr}}")
+endforeach()
+list(SORT sorted)
+list(REVERSE sorted)
+
+math(EXPR threshold "${maxCount} / ${HOT_FRACTION}")
+set(report "")
+set(numHot 0)
+foreach (entry IN LISTS sorted)
+	string(REGEX REPLACE "^0*([0-9]+) (.*)$" "\\1;\\2" fields "${entry}")
+	list(GET fields 0 count)
+	list(GET fields 1 name)
+	if (count LESS threshold OR count EQUAL 0)
+		break()
+	endif()
+	string(APPEND report "${count} ${name}\n")
+	math(EXPR numHot "${numHot} + 1")
+endforeach()
+
+file(WRITE ${OUT} "${report}")
+message(STATUS "profile_hot: ${numHot} hot functions written to ${OUT}")
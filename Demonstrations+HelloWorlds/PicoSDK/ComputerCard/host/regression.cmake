@@ -0,0 +1,132 @@
+# Golden-output regression check for cards built by the host backend
+#
+#   cmake -S . -B build && cmake --build build
+#   cmake -DBUILD_DIR=build -DUPDATE=1 -P regression.cmake   write golden outputs (from a known-good tree)
+#   cmake -DBUILD_DIR=build -P regression.cmake              check against them
+#
+# Each card in REGRESSION_CARDS is rendered from the same generated input WAV file and its
+# automation CSV file in regression/, with any second core in lockstep (see ComputerCard.h),
+# and its output compared with:
+# - the golden output in GOLDEN_DIR (default BUILD_DIR/golden), written by UPDATE=1
+# - the output of <card>_reference, the same card built with COMPUTERCARD_REFERENCE defined
+#   (see add_reference_card in CMakeLists.txt), with the speedup over it reported
+# - a render of the same card replaying a recording of its control inputs from the first
+#   (COMPUTERCARD_RECORD_OUT, then COMPUTERCARD_REPLAY in place of the CSV file)
+# Outputs must be bit-exact unless the card's entry gives a minimum SNR in dB, for cards
+# whose fast path is allowed to round differently. Fails if any comparison fails.
+#
+# Other options: SECONDS, the length rendered (default 10).
+
+cmake_policy(SET CMP0007 NEW)
+
+# name:minimum SNR (empty for bit-exact)
+set(REGRESSION_CARDS
+	13_noisebox:
+	04_BYO_Benjolin:
+	11_goldfish:
+	78_Talker:
+)
+
+if (NOT BUILD_DIR)
+	message(FATAL_ERROR "Set BUILD_DIR to the host build directory, e.g. cmake -DBUILD_DIR=build -P regression.cmake")
+endif()
+get_filename_component(BUILD_DIR ${BUILD_DIR} ABSOLUTE)
+if (NOT GOLDEN_DIR)
+	set(GOLDEN_DIR ${BUILD_DIR}/golden)
+endif()
+if (NOT SECONDS)
+	set(SECONDS 10)
+endif()
+set(OUT_DIR ${BUILD_DIR}/regression)
+set(CONTROL_DIR ${CMAKE_CURRENT_LIST_DIR}/regression)
+file(MAKE_DIRECTORY ${OUT_DIR} ${GOLDEN_DIR})
+
+set(WAV_COMPARE ${BUILD_DIR}/wav_compare)
+if (NOT EXISTS ${WAV_COMPARE})
+	message(FATAL_ERROR "${WAV_COMPARE} not found; build the host targets first")
+endif()
+execute_process(COMMAND ${WAV_COMPARE} --generate ${OUT_DIR}/input.wav ${SECONDS} RESULT_VARIABLE _result)
+if (_result)
+	message(FATAL_ERROR "Couldn't generate ${OUT_DIR}/input.wav")
+endif()
+
+# Render card _exe to _out, setting _ns to its time per sample. Further arguments are added to the environment
+function (render _exe _card _out _ns)
+	set(_env COMPUTERCARD_IN=${OUT_DIR}/input.wav COMPUTERCARD_OUT=${_out} COMPUTERCARD_LOCKSTEP=1 ${ARGN})
+	if (EXISTS ${CONTROL_DIR}/${_card}.csv)
+		list(APPEND _env COMPUTERCARD_CONTROL=${CONTROL_DIR}/${_card}.csv)
+	endif()
+	execute_process(COMMAND ${CMAKE_COMMAND} -E env ${_env} ${_exe}
+		RESULT_VARIABLE _result ERROR_VARIABLE _err OUTPUT_QUIET)
+	if (_result)
+		message(FATAL_ERROR "${_exe} failed: ${_err}")
+	endif()
+	string(REGEX MATCH "([0-9.]+) ns/sample" _match "${_err}")
+	set(${_ns} ${CMAKE_MATCH_1} PARENT_SCOPE)
+endfunction()
+
+# Compare two renders, appending _what to FAILED if they differ by more than allowed
+function (compare _reference _test _snr _what)
+	set(_command ${WAV_COMPARE} ${_reference} ${_test})
+	if (NOT _snr STREQUAL "")
+		list(APPEND _command ${_snr})
+	endif()
+	execute_process(COMMAND ${_command}
+		RESULT_VARIABLE _result OUTPUT_VARIABLE _out)
+	if (_result)
+		message("  ${_what}: FAILED\n${_out}")
+		set(FAILED ${FAILED} "${_what}" PARENT_SCOPE)
+	elseif (_out MATCHES "SNR")
+		message("  ${_what}: within ${_snr} dB SNR\n${_out}")
+	else()
+		message("  ${_what}: bit-exact")
+	endif()
+endfunction()
+
+set(FAILED)
+foreach (_entry ${REGRESSION_CARDS})
+	string(REPLACE ":" ";" _entry ${_entry})
+	list(GET _entry 0 _card)
+	list(LENGTH _entry _n)
+	set(_snr)
+	if (_n GREATER 1)
+		list(GET _entry 1 _snr)
+	endif()
+
+	if (NOT EXISTS ${BUILD_DIR}/${_card})
+		message("${_card}: not built, skipped")
+		continue()
+	endif()
+	render(${BUILD_DIR}/${_card} ${_card} ${OUT_DIR}/${_card}.wav _ns COMPUTERCARD_RECORD_OUT=${OUT_DIR}/${_card}.rec)
+	message("${_card}: ${_ns} ns/sample")
+
+	render(${BUILD_DIR}/${_card} ${_card} ${OUT_DIR}/${_card}_replay.wav _replayNs COMPUTERCARD_REPLAY=${OUT_DIR}/${_card}.rec)
+	compare(${OUT_DIR}/${_card}.wav ${OUT_DIR}/${_card}_replay.wav "" "${_card} replayed from its control recording")
+
+	if (EXISTS ${BUILD_DIR}/${_card}_reference)
+		render(${BUILD_DIR}/${_card}_reference ${_card} ${OUT_DIR}/${_card}_reference.wav _refNs)
+		# Times are printed with one decimal place; the speedup is worked out in hundredths
+		string(REPLACE "." "" _a ${_refNs})
+		string(REPLACE "." "" _b ${_ns})
+		math(EXPR _hundredths "(${_a} * 100) / ${_b}")
+		math(EXPR _whole "${_hundredths} / 100")
+		math(EXPR _frac "${_hundredths} % 100 + 100")
+		string(SUBSTRING ${_frac} 1 2 _frac)
+		message("  reference: ${_refNs} ns/sample, speedup ${_whole}.${_frac}x")
+		compare(${OUT_DIR}/${_card}_reference.wav ${OUT_DIR}/${_card}.wav "${_snr}" "${_card} against ${_card}_reference")
+	endif()
+
+	if (UPDATE)
+		configure_file(${OUT_DIR}/${_card}.wav ${GOLDEN_DIR}/${_card}.wav COPYONLY)
+		message("  golden output written")
+	elseif (EXISTS ${GOLDEN_DIR}/${_card}.wav)
+		compare(${GOLDEN_DIR}/${_card}.wav ${OUT_DIR}/${_card}.wav "${_snr}" "${_card} against golden output")
+	else()
+		message("  no golden output; run with -DUPDATE=1 to write it")
+	endif()
+endforeach()
+
+if (FAILED)
+	list(JOIN FAILED "\n  " _failed)
+	message(FATAL_ERROR "Regression check failed:\n  ${_failed}")
+endif()
@@ -0,0 +1,177 @@
+/*
+Compare two WAV files rendered by the host backend, for regression.cmake
+
+	wav_compare reference.wav test.wav [min SNR in dB]
+		Compares each channel of test.wav with reference.wav. Passes (exit status 0)
+		if every channel is bit-exact or, with a minimum SNR given, if every channel's
+		signal-to-noise ratio, taking the difference as noise, is at least that.
+
+	wav_compare --generate out.wav seconds
+		Writes a stereo test input: an exponential sine sweep on the left, and
+		pseudo-random noise bursts on the right, the same on every machine.
+
+Only the 16-bit PCM WAV files written by the host backend are read.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	struct Wav
+	{
+		int channels = 0, sampleRate = 0;
+		std::vector<int16_t> samples;
+	};
+
+	uint32_t ReadLE(const unsigned char *p, int bytes)
+	{
+		uint32_t v = 0;
+		for (int i=bytes-1; i>=0; i--) v = (v << 8) | p[i];
+		return v;
+	}
+
+	bool Read(const char *filename, Wav &wav)
+	{
+		FILE *f = std::fopen(filename, "rb");
+		if (!f) return false;
+		std::vector<unsigned char> data;
+		unsigned char buf[65536];
+		size_t n;
+		while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+		std::fclose(f);
+
+		if (data.size() < 12 || std::memcmp(data.data(), "RIFF", 4) || std::memcmp(data.data() + 8, "WAVE", 4)) return false;
+		size_t pos = 12;
+		while (pos + 8 <= data.size())
+		{
+			const unsigned char *chunk = data.data() + pos + 8;
+			uint32_t chunkSize = ReadLE(data.data() + pos + 4, 4);
+			if (pos + 8 + chunkSize > data.size()) chunkSize = uint32_t(data.size() - pos - 8);
+			if (!std::memcmp(data.data() + pos, "fmt ", 4) && chunkSize >= 16)
+			{
+				wav.channels = int(ReadLE(chunk + 2, 2));
+				wav.sampleRate = int(ReadLE(chunk + 4, 4));
+				if (ReadLE(chunk + 14, 2) != 16) return false;
+			}
+			else if (!std::memcmp(data.data() + pos, "data", 4))
+			{
+				wav.samples.resize(chunkSize / 2);
+				for (size_t i=0; i<wav.samples.size(); i++) wav.samples[i] = int16_t(ReadLE(chunk + 2*i, 2));
+			}
+			pos += 8 + chunkSize + (chunkSize & 1);
+		}
+		return wav.channels > 0;
+	}
+
+	void WriteLE(FILE *f, uint32_t v, int bytes)
+	{
+		for (int i=0; i<bytes; i++) std::fputc((v >> (8 * i)) & 0xFF, f);
+	}
+
+	bool Generate(const char *filename, double seconds)
+	{
+		const int sampleRate = 48000;
+		uint32_t frames = uint32_t(seconds * sampleRate);
+		FILE *f = std::fopen(filename, "wb");
+		if (!f) return false;
+		uint32_t dataBytes = frames * 4;
+		std::fwrite("RIFF", 1, 4, f);
+		WriteLE(f, 36 + dataBytes, 4);
+		std::fwrite("WAVEfmt ", 1, 8, f);
+		WriteLE(f, 16, 4);
+		WriteLE(f, 1, 2);              // PCM
+		WriteLE(f, 2, 2);              // channels
+		WriteLE(f, sampleRate, 4);
+		WriteLE(f, sampleRate * 4, 4); // bytes per second
+		WriteLE(f, 4, 2);              // bytes per frame
+		WriteLE(f, 16, 2);
+		std::fwrite("data", 1, 4, f);
+		WriteLE(f, dataBytes, 4);
+
+		// Integer phase and LCG noise, so the file is identical whatever the floating point
+		uint32_t phase = 0, rng = 1;
+		for (uint32_t i=0; i<frames; i++)
+		{
+			// 20Hz to 20kHz over the whole file
+			double freq = 20.0 * std::pow(1000.0, double(i) / double(frames));
+			phase += uint32_t(freq * (4294967296.0 / sampleRate));
+			int16_t l = int16_t(std::lrint(std::sin(double(phase >> 8) * (2.0 * M_PI / 16777216.0)) * 16000.0));
+			rng = rng * 1664525 + 1013904223;
+			int16_t r = ((i / 12000) & 1) ? int16_t(int32_t(rng) >> 17) : 0; // quarter-second bursts
+			WriteLE(f, uint16_t(l), 2);
+			WriteLE(f, uint16_t(r), 2);
+		}
+		std::fclose(f);
+		return true;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	if (argc == 4 && !std::strcmp(argv[1], "--generate"))
+	{
+		if (!Generate(argv[2], std::atof(argv[3])))
+		{
+			std::fprintf(stderr, "wav_compare: can't write '%s'\n", argv[2]);
+			return 2;
+		}
+		return 0;
+	}
+	if (argc < 3 || argc > 4)
+	{
+		std::fprintf(stderr, "usage: wav_compare reference.wav test.wav [min SNR dB]\n"
+					 "       wav_compare --generate out.wav seconds\n");
+		return 2;
+	}
+
+	Wav ref, test;
+	for (int i=0; i<2; i++)
+	{
+		if (!Read(argv[1 + i], i ? test : ref))
+		{
+			std::fprintf(stderr, "wav_compare: can't read 16-bit PCM WAV file '%s'\n", argv[1 + i]);
+			return 2;
+		}
+	}
+	if (ref.channels != test.channels || ref.samples.size() != test.samples.size())
+	{
+		std::printf("different formats: %d channels, %zu frames, against %d channels, %zu frames\n",
+					ref.channels, ref.samples.size() / ref.channels, test.channels, test.samples.size() / test.channels);
+		return 1;
+	}
+
+	bool snrGiven = argc == 4;
+	double minSnr = snrGiven ? std::atof(argv[3]) : 0.0;
+	bool pass = true;
+	size_t frames = ref.samples.size() / ref.channels;
+	for (int c=0; c<ref.channels; c++)
+	{
+		double signal = 0, noise = 0;
+		int maxDiff = 0;
+		size_t firstDiff = frames;
+		for (size_t i=0; i<frames; i++)
+		{
+			int a = ref.samples[i * ref.channels + c], b = test.samples[i * ref.channels + c];
+			int d = std::abs(a - b);
+			if (d && firstDiff == frames) firstDiff = i;
+			if (d > maxDiff) maxDiff = d;
+			signal += double(a) * a;
+			noise += double(d) * d;
+		}
+		if (!maxDiff)
+		{
+			std::printf("  channel %d: bit-exact\n", c);
+			continue;
+		}
+		double snr = signal > 0 ? 10.0 * std::log10(signal / noise) : -INFINITY;
+		bool ok = snrGiven && snr >= minSnr;
+		std::printf("  channel %d: max difference %d, first at frame %zu, SNR %.1f dB%s\n", c, maxDiff, firstDiff, snr, ok ? "" : " FAIL");
+		pass = pass && ok;
+	}
+	return pass ? 0 : 1;
+}
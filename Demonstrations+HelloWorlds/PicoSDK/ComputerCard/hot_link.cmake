@@ -0,0 +1,52 @@
+# Profile-guided code placement in flash
+#
+# computercard_hot_link(<target> <hot_functions.txt>) links the functions listed (one per line,
+# as <count> <mangled name>, most called first, from host/profile_hot.cmake) together at the
+# start of the flash .text section, ahead of all other code. The audio path then occupies a
+# contiguous range of flash, which maps to distinct lines of the 16kB XIP cache as long as it
+# is no larger than the cache, rather than being scattered among startup, USB and library code
+# that evicts it. Functions not in the build (inlined, or in SRAM) are skipped by the linker.
+#
+# This uses a copy of the Pico SDK's default linker script, with the hot functions' sections
+# (from -ffunction-sections, which the SDK enables) placed first. The memory report for the
+# target then also summarises the hot set against the cache size.
+
+function(computercard_hot_link _target _hot)
+	set(_memmap "")
+	foreach (_candidate
+			${PICO_SDK_PATH}/src/rp2_common/pico_crt0/rp2040/memmap_default.ld
+			${PICO_SDK_PATH}/src/rp2_common/pico_standard_link/memmap_default.ld)
+		if (EXISTS ${_candidate})
+			set(_memmap ${_candidate})
+			break()
+		endif()
+	endforeach()
+	if (_memmap STREQUAL "")
+		message(WARNING "computercard_hot_link: no memmap_default.ld in the Pico SDK; ${_target} is linked as usual")
+		return()
+	endif()
+
+	file(STRINGS ${_hot} _entries)
+	set(_sections "")
+	foreach (_entry IN LISTS _entries)
+		if (_entry MATCHES "^[0-9]+ ([^ ]+)$")
+			# Also any clones (.constprop.0 etc.) the compiler makes of it
+			string(APPEND _sections "        *(.text.${CMAKE_MATCH_1} .text.${CMAKE_MATCH_1}.*)\n")
+		endif()
+	endforeach()
+
+	# Hot functions go just ahead of the catch-all .text input section in flash
+	file(READ ${_memmap} _script)
+	string(FIND "${_script}" "*(EXCLUDE_FILE(*libgcc.a: *libc.a:*lib_a-mem*.o *libm.a:) .text*)" _pos)
+	if (_pos LESS 0)
+		message(WARNING "computercard_hot_link: unrecognised ${_memmap}; ${_target} is linked as usual")
+		return()
+	endif()
+	string(SUBSTRING "${_script}" 0 ${_pos} _head)
+	string(SUBSTRING "${_script}" ${_pos} -1 _tail)
+	set(_out ${CMAKE_CURRENT_BINARY_DIR}/${_target}_hot.ld)
+	file(WRITE ${_out} "${_head}/* Hot functions, from ${_hot} */\n${_sections}        ${_tail}")
+
+	pico_set_linker_script(${_target} ${_out})
+	set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${_hot})
+endfunction()
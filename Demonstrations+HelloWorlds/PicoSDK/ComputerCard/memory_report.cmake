@@ -0,0 +1,139 @@
+# Summarise where the code and data of a card end up: XIP flash or SRAM.
+#
+# Run after linking, with
+#   cmake -DNM=<path to nm> -DELF=<card.elf> -DOUT=<report.txt> -P memory_report.cmake
+#
+# Functions and constant tables left in flash are read through the XIP cache,
+# and a cache miss can add microseconds to a ProcessSample call. The report
+# lists the largest of these first, as candidates for __not_in_flash_func,
+# __not_in_flash("...") or the COMPUTERCARD_RUN_FROM_RAM build option.
+#
+# With -DHOT=<hot_functions.txt> (see hot_link.cmake), the report also gives the size of
+# the hot set in flash, and the range of flash it spans, against the 16kB XIP cache.
+
+execute_process(COMMAND ${NM} --print-size --size-sort --reverse-sort --demangle ${ELF}
+	OUTPUT_VARIABLE symbols
+	RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+	message(WARNING "memory_report: could not read symbols from ${ELF}")
+	return()
+endif()
+
+string(REPLACE "\n" ";" lines "${symbols}")
+
+set(flash_code "")
+set(flash_data "")
+set(ram_code "")
+set(flash_code_bytes 0)
+set(flash_data_bytes 0)
+set(ram_code_bytes 0)
+set(ram_data_bytes 0)
+
+foreach (line IN LISTS lines)
+	# <address> <size> <type> <name>
+	if (NOT line MATCHES "^([0-9a-f]+) ([0-9a-f]+) ([A-Za-z]) (.*)$")
+		continue()
+	endif()
+	set(addr ${CMAKE_MATCH_1})
+	math(EXPR size "0x${CMAKE_MATCH_2}")
+	string(TOLOWER ${CMAKE_MATCH_3} type)
+	set(name "${CMAKE_MATCH_4}")
+	string(SUBSTRING ${addr} 0 1 region)
+	set(entry "  ${size}\t${name}")
+
+	if (region STREQUAL "1")
+		# 0x10000000: XIP flash
+		if (type STREQUAL "t" OR type STREQUAL "w")
+			list(APPEND flash_code "${entry}")
+			math(EXPR flash_code_bytes "${flash_code_bytes} + ${size}")
+		elseif (type STREQUAL "r")
+			list(APPEND flash_data "${entry}")
+			math(EXPR flash_data_bytes "${flash_data_bytes} + ${size}")
+		endif()
+	elseif (region STREQUAL "2")
+		# 0x20000000: SRAM
+		if (type STREQUAL "t" OR type STREQUAL "w")
+			list(APPEND ram_code "${entry}")
+			math(EXPR ram_code_bytes "${ram_code_bytes} + ${size}")
+		else()
+			math(EXPR ram_data_bytes "${ram_data_bytes} + ${size}")
+		endif()
+	endif()
+endforeach()
+
+get_filename_component(card ${ELF} NAME_WE)
+set(report "Memory placement report for ${card}\n\n")
+string(APPEND report "Code in SRAM:       ${ram_code_bytes} bytes\n")
+string(APPEND report "Data in SRAM:       ${ram_data_bytes} bytes\n")
+string(APPEND report "Code in flash:      ${flash_code_bytes} bytes\n")
+string(APPEND report "Constants in flash: ${flash_data_bytes} bytes\n")
+
+if (HOT)
+	# Hot functions, by their mangled names as listed, found in flash or SRAM
+	execute_process(COMMAND ${NM} --print-size ${ELF} OUTPUT_VARIABLE raw)
+	string(REPLACE "\n" ";" raw "${raw}")
+	foreach (line IN LISTS raw)
+		if (line MATCHES "^([0-9a-f]+) ([0-9a-f]+) [tTwW] ([^.]+)")
+			set(where_${CMAKE_MATCH_3} "${CMAKE_MATCH_1};${CMAKE_MATCH_2}")
+		endif()
+	endforeach()
+
+	file(STRINGS ${HOT} hot_entries)
+	set(hot_listed 0)
+	set(hot_flash 0)
+	set(hot_flash_bytes 0)
+	set(hot_ram 0)
+	set(hot_start -1)
+	set(hot_end 0)
+	foreach (entry IN LISTS hot_entries)
+		if (NOT entry MATCHES "^[0-9]+ ([^ ]+)$")
+			continue()
+		endif()
+		math(EXPR hot_listed "${hot_listed} + 1")
+		if (NOT DEFINED where_${CMAKE_MATCH_1})
+			continue()
+		endif()
+		list(GET where_${CMAKE_MATCH_1} 0 addr)
+		list(GET where_${CMAKE_MATCH_1} 1 size)
+		string(SUBSTRING ${addr} 0 1 region)
+		if (region STREQUAL "2")
+			math(EXPR hot_ram "${hot_ram} + 1")
+			continue()
+		endif()
+		math(EXPR start "0x${addr}")
+		math(EXPR end "0x${addr} + 0x${size}")
+		math(EXPR hot_flash "${hot_flash} + 1")
+		math(EXPR hot_flash_bytes "${hot_flash_bytes} + 0x${size}")
+		if (hot_start LESS 0 OR start LESS hot_start)
+			set(hot_start ${start})
+		endif()
+		if (end GREATER hot_end)
+			set(hot_end ${end})
+		endif()
+	endforeach()
+	set(hot_span 0)
+	if (hot_flash GREATER 0)
+		math(EXPR hot_span "${hot_end} - ${hot_start}")
+	endif()
+	math(EXPR hot_missing "${hot_listed} - ${hot_flash} - ${hot_ram}")
+
+	string(APPEND report "\nHot functions (${HOT}):\n")
+	string(APPEND report "  ${hot_listed} listed: ${hot_flash} in flash, ${hot_ram} in SRAM, ${hot_missing} inlined or not in this build\n")
+	string(APPEND report "  In flash: ${hot_flash_bytes} bytes, spanning ${hot_span} bytes, against a 16384-byte XIP cache\n")
+	if (hot_flash_bytes GREATER 16384)
+		string(APPEND report "  The hot set is larger than the cache: consider __not_in_flash_func for the hottest functions\n")
+	elseif (hot_span GREATER 16384)
+		string(APPEND report "  The hot set fits the cache, but is scattered over more than its size\n")
+	endif()
+endif()
+
+foreach (section "Code in SRAM;ram_code" "Code in flash;flash_code" "Constants in flash;flash_data")
+	list(GET section 0 title)
+	list(GET section 1 var)
+	string(APPEND report "\n${title} (bytes, name):\n")
+	foreach (entry IN LISTS ${var})
+		string(APPEND report "${entry}\n")
+	endforeach()
+endforeach()
+
+file(WRITE ${OUT} "${report}")
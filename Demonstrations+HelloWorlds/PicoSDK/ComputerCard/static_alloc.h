@@ -0,0 +1,190 @@
+#ifndef STATIC_ALLOC_H
+#define STATIC_ALLOC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <utility>
+
+/*
+
+Static allocation, for cards that take all their memory at build time rather
+than from the heap: nothing to fragment after hours of running, no allocation
+in the audio path, and an over-budget card fails to build rather than failing
+on the module. With the COMPUTERCARD_NO_HEAP build option, a card that links
+in malloc or operator new at all fails to build (see heap_check.cmake).
+
+  StaticArena<Bytes>    memory handed out in order and never freed one
+                        allocation at a time, e.g. buffers sized at startup.
+                        Reset returns it all at once
+  StaticPool<T, N>      up to N objects of type T, made and destroyed in any
+                        order, in constant time
+  StaticVector<T, N>    a std::vector of at most N elements, in place
+
+The objects themselves go wherever they are declared: static (or global)
+objects in main SRAM, or in a core's scratch bank with __scratch_x("...") or
+__scratch_y("..."). SRAMBytes adds up the sizes of such objects, to check
+them against a region's budget at compile time, e.g.
+
+  static_assert(SRAMBytes<sizeof(delayLines), sizeof(voices)>() <= sram_budget::scratchData,
+                "voices don't fit in scratch X");
+
+*/
+
+// SRAM regions of the RP2040, in bytes. Each 4kB scratch bank holds one core's stack
+// (PICO_STACK_SIZE and PICO_CORE1_STACK_SIZE, 2kB by default), leaving the rest for data
+namespace sram_budget
+{
+	constexpr size_t main = 256 * 1024;
+	constexpr size_t scratch = 4 * 1024;
+	constexpr size_t stack = 2 * 1024;
+	constexpr size_t scratchData = scratch - stack;
+}
+
+// Total of the sizes given, each rounded up to a word as the linker places them
+template <size_t... Sizes>
+constexpr size_t SRAMBytes()
+{
+	size_t total = 0;
+	for (size_t s : {size_t(0), Sizes...}) total += (s + 3) & ~size_t(3);
+	return total;
+}
+
+template <size_t Bytes>
+class StaticArena
+{
+	static_assert(Bytes <= sram_budget::main, "StaticArena larger than the RP2040's main SRAM");
+public:
+	/// Uninitialised memory for count objects of type T, or nullptr if the arena is full
+	template <class T>
+	T *Allocate(size_t count = 1)
+	{
+		return static_cast<T *>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	/// A T constructed from args, or nullptr if the arena is full. Its destructor is never called
+	template <class T, class... Args>
+	T *Make(Args &&...args)
+	{
+		void *p = Allocate(sizeof(T), alignof(T));
+		return p ? new (p) T(std::forward<Args>(args)...) : nullptr;
+	}
+
+	void *Allocate(size_t bytes, size_t align)
+	{
+		size_t start = (used + align - 1) & ~(align - 1);
+		if (start + bytes > Bytes) return nullptr;
+		used = start + bytes;
+		return memory + start;
+	}
+
+	/// Free everything at once. Only when nothing allocated is still in use
+	void Reset() {used = 0;}
+
+	size_t Used() const {return used;}
+	static constexpr size_t Capacity() {return Bytes;}
+
+private:
+	alignas(8) uint8_t memory[Bytes];
+	size_t used = 0;
+};
+
+template <class T, size_t N>
+class StaticPool
+{
+	static_assert(sizeof(T) * N <= sram_budget::main, "StaticPool larger than the RP2040's main SRAM");
+public:
+	StaticPool()
+	{
+		for (size_t i=0; i<N; i++) next[i] = int(i + 1);
+	}
+
+	/// A T constructed from args, or nullptr if all N are in use
+	template <class... Args>
+	T *Make(Args &&...args)
+	{
+		if (firstFree == int(N)) return nullptr;
+		int i = firstFree;
+		firstFree = next[i];
+		count++;
+		return new (&slots[i]) T(std::forward<Args>(args)...);
+	}
+
+	/// Destroy an object from Make, returning its slot to the pool
+	void Destroy(T *p)
+	{
+		if (!p) return;
+		p->~T();
+		int i = int(reinterpret_cast<Slot *>(p) - slots);
+		next[i] = firstFree;
+		firstFree = i;
+		count--;
+	}
+
+	size_t Count() const {return count;}
+	static constexpr size_t Capacity() {return N;}
+
+private:
+	struct Slot
+	{
+		alignas(T) uint8_t bytes[sizeof(T)];
+	};
+	Slot slots[N];
+	int next[N]; // free list, through the slots not in use
+	int firstFree = 0;
+	size_t count = 0;
+};
+
+template <class T, size_t N>
+class StaticVector
+{
+	static_assert(sizeof(T) * N <= sram_budget::main, "StaticVector larger than the RP2040's main SRAM");
+public:
+	StaticVector() {}
+	~StaticVector() {Clear();}
+	StaticVector(const StaticVector &) = delete;
+	StaticVector &operator=(const StaticVector &) = delete;
+
+	/// Resize to n elements (at most N), default constructing any new ones. Returns false if n > N
+	bool Resize(size_t n)
+	{
+		if (n > N) return false;
+		while (size > n) Data()[--size].~T();
+		while (size < n) new (&slots[size++]) T();
+		return true;
+	}
+
+	/// Add an element; false if already full
+	template <class... Args>
+	bool Emplace(Args &&...args)
+	{
+		if (size == N) return false;
+		new (&slots[size++]) T(std::forward<Args>(args)...);
+		return true;
+	}
+
+	void Clear()
+	{
+		while (size > 0) Data()[--size].~T();
+	}
+
+	T &operator[](size_t i) {return Data()[i];}
+	const T &operator[](size_t i) const {return Data()[i];}
+	T *begin() {return Data();}
+	T *end() {return Data() + size;}
+	size_t Size() const {return size;}
+	static constexpr size_t Capacity() {return N;}
+
+private:
+	struct Slot
+	{
+		alignas(T) uint8_t bytes[sizeof(T)];
+	};
+	T *Data() {return reinterpret_cast<T *>(slots);}
+	const T *Data() const {return reinterpret_cast<const T *>(slots);}
+	Slot slots[N];
+	size_t size = 0;
+};
+
+#endif
@@ -230,7 +230,12 @@ bool midih_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uint
   {
     // receive new data if available
     uint32_t packets_queued = 0;
-    if (xferred_bytes)
+    if (xferred_bytes && tuh_midi_rx_packets_cb)
+    {
+      // pass packets straight from the endpoint buffer, which is not reused until the next transfer is requested below
+      tuh_midi_rx_packets_cb(dev_addr, p_midi_host->epin_buf, xferred_bytes / 4);
+    }
+    else if (xferred_bytes)
     {
       // put in the RX FIFO only non-zero MIDI IN 4-byte packets
       uint8_t* buf = p_midi_host->epin_buf;
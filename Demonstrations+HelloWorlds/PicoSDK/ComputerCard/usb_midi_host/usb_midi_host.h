@@ -164,6 +164,13 @@ TU_ATTR_WEAK void tuh_midi_mount_cb(uint8_t dev_addr, uint8_t in_ep, uint8_t out
 TU_ATTR_WEAK void tuh_midi_umount_cb(uint8_t dev_addr, uint8_t instance);
 
 TU_ATTR_WEAK void tuh_midi_rx_cb(uint8_t dev_addr, uint32_t num_packets);
+
+// Invoked with each IN transfer, pointing at the USB-MIDI event packets (4 bytes each,
+// possibly including all-zero padding packets) in the endpoint buffer itself.
+// If an application defines this, packets are not copied to the RX FIFO, so
+// tuh_midi_rx_cb, tuh_midi_stream_read and tuh_midi_packet_read are not used;
+// usb_midi_packet.h has helpers to parse the packets in place.
+TU_ATTR_WEAK void tuh_midi_rx_packets_cb(uint8_t dev_addr, uint8_t const *packets, uint32_t num_packets);
 TU_ATTR_WEAK void tuh_midi_tx_cb(uint8_t dev_addr);
 #ifdef __cplusplus
 }
@@ -0,0 +1,108 @@
+/*
+Parsing of USB-MIDI event packets, in place
+
+Each 4-byte USB-MIDI event packet holds a cable number and Code Index Number
+(CIN) in its first byte, followed by one complete MIDI message of up to three
+bytes, or up to three bytes of a SysEx message. Messages therefore never span
+packets (and there is no running status), apart from SysEx, which is reassembled
+here incrementally into a caller-provided buffer.
+
+Used with the tuh_midi_rx_packets_cb callback of usb_midi_host.h, or with packets
+read with tud_midi_packet_read in device mode.
+*/
+
+#ifndef USB_MIDI_PACKET_H
+#define USB_MIDI_PACKET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// USB MIDI cable number of a packet
+static inline uint8_t usb_midi_packet_cable(const uint8_t *packet)
+{
+	return packet[0] >> 4;
+}
+
+// Number of MIDI bytes (starting at packet[1]) in a packet that is not part of a SysEx message,
+// or 0 for SysEx, reserved and all-zero padding packets
+static inline uint8_t usb_midi_packet_length(const uint8_t *packet)
+{
+	switch (packet[0] & 0x0F)
+	{
+	case 0x2: case 0xC: case 0xD: return 2; // two-byte system common, program change, channel pressure
+	case 0x3: case 0x8: case 0x9: case 0xA: case 0xB: case 0xE: return 3;
+	case 0x5: return (packet[1] == 0xF7) ? 0 : 1; // single-byte system common, unless it ends a SysEx
+	case 0xF: return (packet[1] == 0xF0 || packet[1] == 0xF7) ? 0 : 1; // single byte
+	default: return 0;
+	}
+}
+
+// Number of SysEx bytes (starting at packet[1]) in a packet, or 0 if it is not part of a SysEx message
+static inline uint8_t usb_midi_packet_sysex_bytes(const uint8_t *packet)
+{
+	uint8_t cin = packet[0] & 0x0F;
+	if (cin == 0x4) return 3;                                // SysEx starts or continues
+	if (cin == 0x5) return (packet[1] == 0xF7) ? 1 : 0;      // SysEx ends with 1 byte, or single-byte system common
+	if (cin == 0x6 || cin == 0x7) return cin - 0x4;          // SysEx ends with 2 or 3 bytes
+	if (cin == 0xF && (packet[1] == 0xF0 || packet[1] == 0xF7)) return 1; // some devices send single bytes
+	return 0;
+}
+
+// Incremental SysEx reassembly, over any number of packets
+typedef struct
+{
+	uint8_t *buffer;  // SysEx message, from 0xF0 to 0xF7 inclusive
+	uint32_t size;    // of buffer
+	uint32_t length;  // bytes received so far
+	bool overflow;    // message was longer than the buffer, and has been dropped
+} usb_midi_sysex;
+
+static inline void usb_midi_sysex_init(usb_midi_sysex *s, uint8_t *buffer, uint32_t size)
+{
+	s->buffer = buffer;
+	s->size = size;
+	s->length = 0;
+	s->overflow = false;
+}
+
+// Add the SysEx bytes from a packet (other packets are ignored).
+// Returns true when a complete message is in buffer (length bytes), valid until the next call.
+static inline bool usb_midi_sysex_packet(usb_midi_sysex *s, const uint8_t *packet)
+{
+	uint8_t n = usb_midi_packet_sysex_bytes(packet);
+	if (n == 0) return false;
+
+	if (s->length > 0 && s->buffer[s->length - 1] == 0xF7) s->length = 0; // last message was complete
+
+	bool complete = false;
+	for (uint8_t i = 1; i <= n; i++)
+	{
+		uint8_t b = packet[i];
+		if (b == 0xF0) // start of message, even if the last one never ended
+		{
+			s->length = 0;
+			s->overflow = false;
+		}
+		if (s->length < s->size)
+			s->buffer[s->length++] = b;
+		else
+			s->overflow = true;
+		if (b == 0xF7)
+		{
+			complete = !s->overflow && s->length > 0 && s->buffer[0] == 0xF0;
+			if (!complete) s->length = 0;
+			break;
+		}
+	}
+	return complete;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
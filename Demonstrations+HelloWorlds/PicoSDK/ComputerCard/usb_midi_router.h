@@ -0,0 +1,193 @@
+#ifndef USB_MIDI_ROUTER_H
+#define USB_MIDI_ROUTER_H
+
+#include "usb_role.h"
+#include "usb_midi_host.h"
+
+/*
+
+USB MIDI router: merges, filters and forwards USB-MIDI packets between three
+ports, on core 1:
+
+  Card    the card's own events (FromCard), and a receiver for what is routed
+          to the card (SetCardReceiver), e.g. QueueMIDIPackets
+  Device  the computer, when the Computer is a USB device
+  Host    the USB MIDI devices attached, through a hub if there are several,
+          when the Computer is the USB host
+
+The Computer has one USB port, so the Device and Host ports are never running
+at once (USBRoleManager picks one); as host, with a hub, routes from Host to
+Host pass each device's messages to the others, making the Computer a MIDI hub.
+
+Each route has a channel filter (a bit per channel; system messages always
+pass it) and a message filter (a bit per USB-MIDI Code Index Number, the low
+nibble of a packet's first byte), and can move packets to another cable.
+Packets are forwarded as they arrive, in place: those from attached devices
+straight from the endpoint buffer (tuh_midi_rx_packets_cb), and each written
+once to its destination's transmit FIFO. Task services the USB stack, the
+device port's input and all the host transmit flushes in one pass, so a
+packet leaves within the pass after the one it arrived in, normally well
+under a USB frame (1ms).
+
+Routes mixing several sources pass SysEx packet by packet, so two SysEx
+messages arriving at once would interleave; filter SysEx out of all but one
+route to a port to avoid this.
+
+*/
+
+template <unsigned MaxRoutes = 8>
+class MIDIRouter
+{
+public:
+	enum Port : uint8_t {Card, Device, Host};
+
+	/// Channel filter passing all channels
+	static constexpr uint16_t AllChannels = 0xFFFF;
+	/// Message filters, as bits by Code Index Number
+	static constexpr uint16_t AllMessages = 0xFFFC; // CINs 0 and 1 are reserved
+	static constexpr uint16_t NoteMessages = (1u << 0x8) | (1u << 0x9) | (1u << 0xA);
+	static constexpr uint16_t ControlMessages = (1u << 0xB) | (1u << 0xC) | (1u << 0xD) | (1u << 0xE);
+	static constexpr uint16_t SysExMessages = (1u << 0x4) | (1u << 0x5) | (1u << 0x6) | (1u << 0x7);
+	static constexpr uint16_t RealTimeMessages = 1u << 0xF;
+
+	MIDIRouter() {ClearRoutes();}
+
+	/// Add a route, returning its number, or -1 if there are already MaxRoutes. cable is the destination cable, or -1 to keep the source's
+	int AddRoute(Port from, Port to, uint16_t channels = AllChannels, uint16_t messages = AllMessages, int cable = -1)
+	{
+		if (numRoutes == MaxRoutes) return -1;
+		routes[numRoutes] = {from, to, int8_t(cable), channels, messages};
+		return numRoutes++;
+	}
+
+	void ClearRoutes() {numRoutes = 0;}
+
+	/// Called with each packet routed to the card
+	void SetCardReceiver(void (*fn)(const uint8_t *packets, uint32_t n, void *ctx), void *ctx)
+	{
+		cardReceiver = fn;
+		cardContext = ctx;
+	}
+
+	/// Attached devices, from tuh_midi_mount_cb and tuh_midi_umount_cb
+	void Mount(uint8_t devAddr)
+	{
+		for (unsigned i=0; i<maxDevices; i++) if (devices[i] == 0) {devices[i] = devAddr; return;}
+	}
+	void Unmount(uint8_t devAddr)
+	{
+		for (unsigned i=0; i<maxDevices; i++) if (devices[i] == devAddr) devices[i] = 0;
+	}
+
+	/// Packets from an attached device, from tuh_midi_rx_packets_cb
+	void FromHost(uint8_t devAddr, const uint8_t *packets, uint32_t n) {Route(Host, devAddr, packets, n);}
+
+	/// Packets generated by the card (core 1)
+	void FromCard(const uint8_t *packets, uint32_t n) {Route(Card, 0, packets, n);}
+
+	/// A channel message from the card: status, and one or two data bytes
+	void FromCard(uint8_t status, uint8_t data1, uint8_t data2 = 0, uint8_t cable = 0)
+	{
+		const uint8_t packet[4] = {uint8_t((cable << 4) | (status >> 4)), status, data1, data2};
+		FromCard(packet, 1);
+	}
+
+	/// One scheduler pass, from the USB loop on core 1: run the USB stack (through usb, following state),
+	/// route the device port's input, and send everything routed to attached devices. Returns the role running
+	USBRoleManager::Role Task(USBRoleManager &usb, ComputerCard::USBPowerState_t state)
+	{
+		role = usb.Task(state);
+		if (role != USBRoleManager::Host)
+		{
+			for (unsigned i=0; i<maxDevices; i++) devices[i] = 0;
+		}
+		if (role == USBRoleManager::Device)
+		{
+			uint8_t packet[4];
+			while (tud_midi_packet_read(packet)) Route(Device, 0, packet, 1);
+		}
+		else if (role == USBRoleManager::Host)
+		{
+			for (unsigned i=0; i<maxDevices; i++) if (devices[i]) tuh_midi_stream_flush(devices[i]);
+		}
+		return role;
+	}
+
+	/// Packets dropped because a destination's transmit FIFO was full
+	uint32_t Dropped() const {return dropped;}
+
+private:
+	struct Route_t
+	{
+		Port from, to;
+		int8_t cable;
+		uint16_t channels, messages;
+	};
+
+	static constexpr unsigned maxDevices = CFG_TUH_DEVICE_MAX;
+
+	static bool Passes(const Route_t &r, const uint8_t *p)
+	{
+		uint8_t cin = p[0] & 0x0F;
+		if (!(r.messages & (1u << cin))) return false;
+		// Channel voice messages (CIN 8 to E) are filtered by channel
+		if (cin >= 0x8 && cin <= 0xE && !(r.channels & (1u << (p[1] & 0x0F)))) return false;
+		return true;
+	}
+
+	void Route(Port from, uint8_t fromAddr, const uint8_t *packets, uint32_t n)
+	{
+		for (uint32_t k=0; k<n; k++)
+		{
+			const uint8_t *p = packets + 4 * k;
+			if ((p[0] | p[1] | p[2] | p[3]) == 0) continue; // some devices pad transfers with empty packets
+
+			for (unsigned r=0; r<numRoutes; r++)
+			{
+				const Route_t &route = routes[r];
+				if (route.from != from || !Passes(route, p)) continue;
+
+				uint8_t moved[4];
+				const uint8_t *out = p;
+				if (route.cable >= 0)
+				{
+					moved[0] = uint8_t((route.cable << 4) | (p[0] & 0x0F));
+					moved[1] = p[1]; moved[2] = p[2]; moved[3] = p[3];
+					out = moved;
+				}
+				Send(route.to, fromAddr, out);
+			}
+		}
+	}
+
+	void Send(Port to, uint8_t fromAddr, const uint8_t *p)
+	{
+		if (to == Card)
+		{
+			if (cardReceiver) cardReceiver(p, 1, cardContext);
+		}
+		else if (to == Device)
+		{
+			if (role == USBRoleManager::Device && tud_midi_mounted() && !tud_midi_packet_write(p)) dropped++;
+		}
+		else if (role == USBRoleManager::Host)
+		{
+			// Every attached device but the one the packet came from
+			for (unsigned i=0; i<maxDevices; i++)
+			{
+				uint8_t a = devices[i];
+				if (a && a != fromAddr && tuh_midi_configured(a) && !tuh_midi_packet_write(a, p)) dropped++;
+			}
+		}
+	}
+
+	Route_t routes[MaxRoutes];
+	unsigned numRoutes = 0;
+	uint8_t devices[maxDevices] = {};
+	USBRoleManager::Role role = USBRoleManager::None;
+	void (*cardReceiver)(const uint8_t *packets, uint32_t n, void *ctx) = nullptr;
+	void *cardContext = nullptr;
+	uint32_t dropped = 0;
+};
+
+#endif
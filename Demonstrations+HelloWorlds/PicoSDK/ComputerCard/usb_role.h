@@ -0,0 +1,75 @@
+#ifndef USB_ROLE_H
+#define USB_ROLE_H
+
+#include "ComputerCard.h"
+#include "tusb.h"
+
+/*
+
+USB role manager: runs TinyUSB as a host or as a device, following the
+USB port's power state (ComputerCard::USBPowerState), and switches between
+them while the card runs, so re-patching the USB cable needs no power cycle.
+
+Call Task from the USB loop on core 1, in place of tud_init/tuh_init and
+tud_task/tuh_task. When the power state changes, and has held for settleUs,
+Task shuts down the running stack (tud_deinit/tuh_deinit, which reset the
+USB controller) and starts the other. The audio core is not involved.
+
+Before Computer hardware 1.1, the power state is Unsupported, and the card
+is always a device. UFP is also reported with nothing connected, so an
+unplugged card is a device, ready for a computer.
+
+Needs TinyUSB 0.17 or later (Pico SDK 2.1), for tud_deinit and tuh_deinit,
+and CFG_TUSB_RHPORT0_MODE (OPT_MODE_HOST | OPT_MODE_DEVICE) in tusb_config.h.
+
+*/
+
+class USBRoleManager
+{
+public:
+	enum Role {None, Device, Host};
+
+	/// settleUs: how long a new power state must hold before the role follows it
+	explicit USBRoleManager(uint32_t settleUs = 150000) : settleUs(settleUs) {}
+
+	/// Run the USB stack, switching role if the power state has changed; returns the role running
+	Role Task(ComputerCard::USBPowerState_t state)
+	{
+		Role wanted = (state == ComputerCard::DFP) ? Host : Device;
+		uint32_t now = time_us_32();
+		if (wanted != pending)
+		{
+			pending = wanted;
+			since = now;
+		}
+		if (pending != role && now - since >= settleUs) Switch(pending);
+
+		if (role == Device) tud_task();
+		else if (role == Host) tuh_task();
+		return role;
+	}
+
+	/// Role running, None until the power state has first settled
+	Role Current() const {return role;}
+
+	/// Number of times a stack has been started; changes when the role does, for cards to reset their USB state
+	uint32_t Switches() const {return switches;}
+
+private:
+	void Switch(Role r)
+	{
+		if (role == Device) tud_deinit(TUD_OPT_RHPORT);
+		else if (role == Host) tuh_deinit(TUH_OPT_RHPORT);
+
+		if (r == Device) tud_init(TUD_OPT_RHPORT);
+		else tuh_init(TUH_OPT_RHPORT);
+
+		role = r;
+		switches++;
+	}
+
+	uint32_t settleUs, since = 0, switches = 0;
+	Role role = None, pending = None;
+};
+
+#endif
@@ -5,6 +5,7 @@ void Clock::Tick()
 {
 
     const uint32_t prev = phase;  // store old phase
+    prev_phase = prev;
     phase += phase_increment;     // increment phase
     rising_edge = (prev > phase); // detect wraparound for main clock
 
@@ -74,6 +75,12 @@ bool Clock::IsRisingEdgeMult() const
     return rising_edge_mult;
 }
 
+bool Clock::IsRisingEdgeTimes(uint32_t n) const
+{
+    // phase * n wraps n times per beat (for phase_increment * n < 2^32)
+    return uint32_t(prev_phase * n) > uint32_t(phase * n);
+}
+
 uint32_t Clock::GetTicks() const
 {
     return totalTicks;
@@ -158,6 +165,55 @@ uint16_t Clock::TapTempo(uint32_t tapTime)
     return GetBPM10FromPhaseIncrement();
 }
 
+// Phase-locked loop for an external clock. Rather than resetting the phase and
+// taking the period from the last interval alone, the period is filtered over
+// several edges, and the phase error at each edge is corrected by adjusting the
+// rate over the following beat. Subclock edges derived from the phase are then
+// evenly spaced (to a fraction of a sample) instead of jumping at every edge.
+// A tempo change of more than a quarter relocks straight away.
+void Clock::FollowEdge(uint32_t edgeTime)
+{
+    if (lastEdgeTime == 0)
+    {
+        lastEdgeTime = edgeTime;
+        period8 = 0;
+        Reset();
+        return;
+    }
+
+    uint32_t interval = edgeTime - lastEdgeTime;
+    lastEdgeTime = edgeTime;
+
+    if (interval < minInterval || interval > maxInterval)
+    {
+        // Clock stopped or glitched: start again from the next edge
+        period8 = 0;
+        Reset();
+        return;
+    }
+
+    uint32_t p8 = interval << 8;
+    uint32_t d8 = (p8 > period8) ? p8 - period8 : period8 - p8;
+    if (period8 == 0 || d8 > (period8 >> 2))
+    {
+        // First interval, or a new tempo
+        period8 = p8;
+        SetPhaseIncrementFromTicks(interval);
+        Reset();
+        return;
+    }
+    if (p8 > period8)
+        period8 += d8 >> periodShift;
+    else
+        period8 -= d8 >> periodShift;
+
+    // Phase error: positive if the beat wrapped before this edge, negative if it is still to come.
+    // Aim to be half of the way back in line by the next predicted edge.
+    int32_t error = (int32_t)phase;
+    int64_t target = (int64_t(1) << 32) - (error / 2);
+    phase_increment = uint32_t((target << 8) / period8);
+}
+
 void Clock::UpdateDivide(uint8_t step)
 {
     subclockDividor = subclockDivisions[step];
@@ -172,6 +228,8 @@ void Clock::UpdateDivide(uint8_t step)
 void Clock::setExternalClock1(bool ext)
 {
     isExternalClock1 = ext;
+    if (!ext)
+        lastEdgeTime = 0; // follow afresh when a clock is next patched
 }
 
 void Clock::setExternalClock2(bool ext)
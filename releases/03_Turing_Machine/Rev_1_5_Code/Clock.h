@@ -10,7 +10,9 @@ public:
     uint32_t GetPhase() const;
     bool IsRisingEdge() const;
     bool IsRisingEdgeMult() const;
+    bool IsRisingEdgeTimes(uint32_t n) const; // phase-locked xN of the main clock, e.g. x2, x3, x4
     uint16_t TapTempo(uint32_t tapTime); // returns BPM10 when tempo is set, otherwise retuns 0
+    void FollowEdge(uint32_t edgeTime);  // phase-locks to an external clock edge
     uint32_t GetTicks() const;
     void UpdateDivide(uint8_t step);
     void setExternalClock1(bool ext);
@@ -32,10 +34,16 @@ private:
     uint32_t minInterval = 480;    // e.g., 10ms at 48kHz - to lock out double taps and noise
     uint32_t maxInterval = 144000; // 3 seconds
     uint32_t phase = 0;
+    uint32_t prev_phase = 0;
     uint32_t phase_increment = 0;
     bool rising_edge = false;
     bool rising_edge_mult = false;
     uint32_t lastTapTime = 0;
+
+    // External clock follower: period in 1/256 samples, filtered over ~8 edges
+    uint32_t lastEdgeTime = 0;
+    uint32_t period8 = 0;
+    static constexpr int periodShift = 3;
     uint32_t totalTicks = 0;
     void SetPhaseIncrementFromTicks(uint32_t ticks_per_beat);
     void SetPhaseIncrementFromBPM10(uint16_t BPM10);
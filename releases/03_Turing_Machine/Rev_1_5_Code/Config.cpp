@@ -3,7 +3,6 @@
 #include "hardware/sync.h"
 #include <cstring>
 #include "hardware/regs/addressmap.h"
-#include "pico/multicore.h"
 
 uint32_t const Config::MAGIC = 0x434F4E46;
 size_t const Config::FLASH_SIZE = 2 * 1024 * 1024;
@@ -27,35 +26,6 @@ void Config::load(bool forceReset)
     }
 }
 
-/*
-void Config::save()
-{
-    uint8_t flash_copy[BLOCK_SIZE];
-    std::memcpy(flash_copy, CONFIG_FLASH_PTR, BLOCK_SIZE);
-
-    if (std::memcmp(&config, flash_copy, sizeof(Data)) == 0)
-        return; // No change, skip
-
-    uint8_t temp[BLOCK_SIZE] = {0};
-    std::memcpy(temp, &config, sizeof(Data));
-
-    //     // Stop all other execution paths
-    multicore_lockout_start_blocking();
-
-    //     // Kill interrupts
-    uint32_t ints = save_and_disable_interrupts();
-
-    //     // Do the write
-    // flash_range_erase(OFFSET, FLASH_SECTOR_SIZE);
-    // flash_range_program(OFFSET, temp, BLOCK_SIZE);
-
-    //     // Restore
-
-    restore_interrupts(ints);
-    multicore_lockout_end_blocking();
-}
-*/
-
 void Config::save()
 {
     /* ---------- 1. Compare ---------- */
@@ -68,15 +38,14 @@ void Config::save()
     memcpy(wr_buf, &config, sizeof config);         // patch with new data
 
     /* ---------- 3. Critical section ---------- */
-    uint32_t ints = save_and_disable_interrupts(); // 1) IRQs off
-    multicore_lockout_start_blocking();            // 2) park Core 1
+    // Only this core's IRQs are disabled: the whole program runs from SRAM
+    // (copy_to_ram), so Core 1 keeps running the audio while flash is busy
+    uint32_t ints = save_and_disable_interrupts();
 
-    // --- flash operations (uncomment when ready) ---
     flash_range_erase(OFFSET, FLASH_SECTOR_SIZE);
     flash_range_program(OFFSET, wr_buf, Config::BLOCK_SIZE);
 
-    multicore_lockout_end_blocking(); // 3) release Core 1
-    restore_interrupts(ints);         // 4) IRQs on
+    restore_interrupts(ints);
 
 }
 
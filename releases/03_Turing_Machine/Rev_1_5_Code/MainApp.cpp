@@ -14,12 +14,8 @@ const int POINT_VERSION = 0x00;
 MainApp::MainApp()
 
     // Initialise the Turing machines with variations of the memory card ID, unique but not random
-    : turingDAC1(8, MemoryCardID()),
-      turingDAC2(8, MemoryCardID() * 2),
-      turingPWM1(8, MemoryCardID() * 3),
-      turingPWM2(8, MemoryCardID() * 4),
-      turingPulseLength1(8, MemoryCardID() * 5),
-      turingPulseLength2(8, MemoryCardID() * 6)
+    : turingMain(NUM_TRACKS, 8, MemoryCardID()),
+      turingDiv(NUM_TRACKS, 8, MemoryCardID() * 2)
 
 {
 
@@ -33,8 +29,8 @@ void MainApp::UpdateNotePools()
     int base_note = 48; // C3
     int range = settings->preset[p].range;
     int scale = settings->preset[p].scale;
-    turingPWM1.UpdateNotePool(base_note, range, scale);
-    turingPWM2.UpdateNotePool(base_note, range, scale);
+    turingMain.UpdateNotePool(base_note, range, scale);
+    turingDiv.UpdateNotePool(base_note, range, scale);
 }
 
 void MainApp::UpdatePulseLengths()
@@ -113,7 +109,7 @@ void __not_in_flash_func(MainApp::ProcessSample)()
     if (extPulse1Received())
     {
         uint32_t now = clk.GetTicks();
-        clk.TapTempo(now);
+        clk.FollowEdge(now);
         clk.ExtPulse1();
     }
 
@@ -181,7 +177,7 @@ void MainApp::Housekeeping()
 
     updateLedState();
 
-    ui.UpdatePulseMod(turingPulseLength1.DAC_8(), turingPulseLength2.DAC_8());
+    ui.UpdatePulseMod(turingMain.DAC_8(TRACK_PULSE_LENGTH), turingDiv.DAC_8(TRACK_PULSE_LENGTH));
 
     UpdatePulseLengths();
 
@@ -233,7 +229,7 @@ bool MainApp::PulseOutput1(bool requested)
 
     if (isTuringMode && requested)
     {
-        emit = (turingPWM1.DAC_8() & 0x01);
+        emit = (turingMain.DAC_8(TRACK_PWM) & 0x01);
     }
     else
     {
@@ -252,7 +248,7 @@ bool MainApp::PulseOutput2(bool requested)
 
     if (isTuringMode && requested)
     {
-        emit = (turingPWM2.DAC_8() & 0x01);
+        emit = (turingDiv.DAC_8(TRACK_PWM) & 0x01);
     }
     else
     {
@@ -381,12 +377,11 @@ void MainApp::lengthKnobChanged(uint8_t length)
 
     int lengthPlus = settings->preset[p].looplen - 1; // Because 1-1 = 0, 0-1 = -1
 
-    turingDAC1.updateLength(length);
-    turingDAC2.updateLength(length + lengthPlus);
-    turingPWM1.updateLength(length);
-    turingPWM2.updateLength(length + lengthPlus);
-    turingPulseLength1.updateLength(length);
-    turingPulseLength2.updateLength(length + lengthPlus);
+    for (int t = 0; t < NUM_TRACKS; ++t)
+    {
+        turingMain.updateLength(t, length);
+        turingDiv.updateLength(t, length + lengthPlus);
+    }
 
     // This is where to place the LED animation for length changes
     showLengthPattern(length);
@@ -397,10 +392,9 @@ void MainApp::UpdateCh2Lengths()
 {
     bool p = ModeSwitch();
     int lengthPlus = settings->preset[p].looplen - 1; // Because 1-1 = 0, 0-1 = -1
-    uint16_t length = turingPWM1.returnLength();
-    turingDAC2.updateLength(length + lengthPlus);
-    turingPWM2.updateLength(length + lengthPlus);
-    turingPulseLength2.updateLength(length + lengthPlus);
+    uint16_t length = turingMain.returnLength(TRACK_PWM);
+    for (int t = 0; t < NUM_TRACKS; ++t)
+        turingDiv.updateLength(t, length + lengthPlus);
 }
 
 void MainApp::UpdateCVRange()
@@ -414,29 +408,27 @@ void MainApp::updateMainTuring()
 {
 
     // Update Turing Machines
-    turingDAC1.Update(KnobVal(Main), maxRange);
-    turingPWM1.Update(KnobVal(Main), maxRange);
-    turingPulseLength1.Update(KnobVal(Main), maxRange);
+    turingMain.SetAllProbabilities(KnobVal(Main), maxRange);
+    turingMain.Update();
 
     // Scaled CV out on CV/Audio 1
-    uint16_t dac = cv_map_u8(turingDAC1.DAC_8());
+    uint16_t dac = cv_map_u8(turingMain.DAC_8(TRACK_DAC));
     AudioOut1(dac);
 
-    int midi_note = turingPWM1.MidiNote() + midiOffset;
+    int midi_note = turingMain.MidiNote(TRACK_PWM) + midiOffset;
     CVOut1MIDINote(midi_note);
 }
 
 void MainApp::updateDivTuring()
 {
-    turingDAC2.Update(KnobVal(Main), maxRange);
-    turingPWM2.Update(KnobVal(Main), maxRange);
-    turingPulseLength2.Update(KnobVal(Main), maxRange);
+    turingDiv.SetAllProbabilities(KnobVal(Main), maxRange);
+    turingDiv.Update();
 
     // Scaled CV out on CV/Audio 2
-    uint16_t dac = cv_map_u8(turingDAC2.DAC_8());
+    uint16_t dac = cv_map_u8(turingDiv.DAC_8(TRACK_DAC));
     AudioOut2(dac);
 
-    int midi_note = turingPWM2.MidiNote() + midiOffset;
+    int midi_note = turingDiv.MidiNote(TRACK_PWM) + midiOffset;
     CVOut2MIDINote(midi_note);
 }
 
@@ -513,10 +505,10 @@ void MainApp::updateLedState()
     if (ledMode == DYNAMIC_PWM)
     {
 
-        LedBrightness(0, turingDAC1.DAC_8() << 4);
-        LedBrightness(1, turingDAC2.DAC_8() << 4);
-        LedBrightness(2, turingPWM1.DAC_8() << 4);
-        LedBrightness(3, turingPWM2.DAC_8() << 4);
+        LedBrightness(0, turingMain.DAC_8(TRACK_DAC) << 4);
+        LedBrightness(1, turingDiv.DAC_8(TRACK_DAC) << 4);
+        LedBrightness(2, turingMain.DAC_8(TRACK_PWM) << 4);
+        LedBrightness(3, turingDiv.DAC_8(TRACK_PWM) << 4);
         LedOn(4, pulseLed1_status);
         LedOn(5, pulseLed2_status);
     }
@@ -691,21 +683,21 @@ void MainApp::SendLiveStatus()
     msg[out++] = deviceId;
     msg[out++] = messageType;
 
-    msg[out++] = midiHi(turingDAC1.DAC_8());
-    msg[out++] = midiLo(turingDAC1.DAC_8());
+    msg[out++] = midiHi(turingMain.DAC_8(TRACK_DAC));
+    msg[out++] = midiLo(turingMain.DAC_8(TRACK_DAC));
 
-    msg[out++] = midiHi(turingDAC2.DAC_8());
-    msg[out++] = midiLo(turingDAC2.DAC_8());
+    msg[out++] = midiHi(turingDiv.DAC_8(TRACK_DAC));
+    msg[out++] = midiLo(turingDiv.DAC_8(TRACK_DAC));
 
-    msg[out++] = midiHi(turingPWM1.DAC_8());
-    msg[out++] = midiLo(turingPWM1.DAC_8());
+    msg[out++] = midiHi(turingMain.DAC_8(TRACK_PWM));
+    msg[out++] = midiLo(turingMain.DAC_8(TRACK_PWM));
 
-    msg[out++] = midiHi(turingPWM2.DAC_8());
-    msg[out++] = midiLo(turingPWM2.DAC_8());
+    msg[out++] = midiHi(turingDiv.DAC_8(TRACK_PWM));
+    msg[out++] = midiLo(turingDiv.DAC_8(TRACK_PWM));
 
     msg[out++] = KnobVal(Main) >> 5; // 0-4095 down to 0-127
     msg[out++] = ModeSwitch();
-    msg[out++] = turingPWM1.returnLength();
+    msg[out++] = turingMain.returnLength(TRACK_PWM);
 
     msg[out++] = sysExEnd;
 
@@ -717,6 +709,7 @@ void MainApp::cv_map_build(int32_t low, int32_t high)
     const int32_t span = high - low;              // can be negative
     const int32_t lo = (low < high) ? low : high; // for safety clamp
     const int32_t hi = (low < high) ? high : low;
+    const uint8_t back = cv_lut_active ^ 1;
 
     for (int x = 0; x < 256; ++x)
     {
@@ -730,8 +723,10 @@ void MainApp::cv_map_build(int32_t low, int32_t high)
         if (y > hi)
             y = hi;
 
-        cv_lut[x] = (int16_t)y;
+        cv_lut[back][x] = (int16_t)y;
     }
+
+    __atomic_store_n(&cv_lut_active, back, __ATOMIC_RELEASE);
 }
 
 void MainApp::cv_set_mode(uint8_t mode)
@@ -759,7 +754,7 @@ void MainApp::cv_set_mode(uint8_t mode)
 
 int16_t MainApp::cv_map_u8(uint8_t x)
 {
-    return cv_lut[x]; // O(1) in the audio loop
+    return cv_lut[__atomic_load_n(&cv_lut_active, __ATOMIC_ACQUIRE)][x]; // O(1) in the audio loop
 }
 
 int16_t MainApp::readInputIfConnected(Input inputType)
@@ -840,12 +835,8 @@ int MainApp::CVtoMidiOffset(int16_t raw)
 
 void MainApp::onRisingEdgeAudio1()
 {
-    turingDAC1.reset();
-    turingDAC2.reset();
-    turingPWM1.reset();
-    turingPWM2.reset();
-    turingPulseLength1.reset();
-    turingPulseLength2.reset();
+    turingMain.reset();
+    turingDiv.reset();
 }
 
 void MainApp::detectAudio1RisingEdge()
@@ -64,12 +64,16 @@ private:
     UI ui;
     Config cfg;
 
-    Turing turingDAC1;
-    Turing turingDAC2;
-    Turing turingPWM1;
-    Turing turingPWM2;
-    Turing turingPulseLength1;
-    Turing turingPulseLength2;
+    // One bank of Turing machines per clock: main (channel 1) and divided (channel 2)
+    enum TuringTrack
+    {
+        TRACK_DAC,
+        TRACK_PWM,
+        TRACK_PULSE_LENGTH,
+        NUM_TRACKS
+    };
+    TuringBank turingMain;
+    TuringBank turingDiv;
     uint16_t maxRange = 4095; // maximum pot value
 
     volatile uint16_t CurrentBPM10 = 1200; // 10x bpm default
@@ -103,8 +107,10 @@ private:
 
     bool sendViz = false;
 
-    // To handle CV mapping
-    int16_t cv_lut[256];
+    // To handle CV mapping: double-buffered like the Turing note pools, so
+    // cv_set_mode (core 0) never rewrites the table the audio core is reading
+    int16_t cv_lut[2][256];
+    uint8_t cv_lut_active = 0;
     void cv_map_build(int32_t low, int32_t high);
     void cv_set_mode(uint8_t mode);
     int16_t cv_map_u8(uint8_t x);
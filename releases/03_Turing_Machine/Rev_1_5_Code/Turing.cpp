@@ -1,153 +1,244 @@
 #include "Turing.h"
 
-Turing::Turing(int length, uint32_t seed)
+namespace
 {
-    _length = length;
+    constexpr int NUM_SCALES = 7;
+    constexpr int MAX_INTERVALS = 128;
+
+    constexpr int scale_sizes[NUM_SCALES] = {12, 7, 7, 5, 7, 5, 6};
+    constexpr uint8_t scale_steps[NUM_SCALES][12] = {
+        {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}, // chromatic
+        {0, 2, 4, 5, 7, 9, 11},                 // major
+        {0, 2, 3, 5, 7, 8, 10},                 // minor
+        {0, 3, 5, 7, 10},                       // minor pentatonic
+        {0, 2, 3, 5, 7, 9, 10},                 // dorian
+        {0, 1, 3, 7, 10},                       // pelog
+        {0, 2, 4, 6, 8, 10},                    // whole tone
+    };
+
+    // Each scale's intervals above the root, ascending through every octave up to 127 semitones
+    struct ScaleIntervals
+    {
+        uint8_t intervals[NUM_SCALES][MAX_INTERVALS] = {};
+        uint8_t size[NUM_SCALES] = {};
+    };
+
+    constexpr ScaleIntervals BuildScaleIntervals()
+    {
+        ScaleIntervals t;
+        for (int s = 0; s < NUM_SCALES; ++s)
+        {
+            int n = 0;
+            for (int oct = 0; 12 * oct < MAX_INTERVALS; ++oct)
+            {
+                for (int i = 0; i < scale_sizes[s] && 12 * oct + scale_steps[s][i] < MAX_INTERVALS; ++i)
+                {
+                    t.intervals[s][n++] = static_cast<uint8_t>(12 * oct + scale_steps[s][i]);
+                }
+            }
+            t.size[s] = static_cast<uint8_t>(n);
+        }
+        return t;
+    }
+
+    constexpr ScaleIntervals scale_intervals = BuildScaleIntervals();
+}
+
+TuringBank::TuringBank(int tracks, int length, uint32_t seed)
+{
+    if (tracks < 1)
+        tracks = 1;
+    if (tracks > MAX_TRACKS)
+        tracks = MAX_TRACKS;
+    _tracks = tracks;
+    _activeMask = static_cast<uint8_t>((1u << tracks) - 1);
+
     randomSeed(seed);
-    _sequence = next() & 0xFFFF;
+    for (int t = 0; t < _tracks; ++t)
+    {
+        uint32_t bits = next() & 0xFFFF;
+        for (int b = 0; b < MAX_LENGTH; ++b)
+        {
+            if (bits & (1u << b))
+                _slices[b >> 2] |= 1u << (8 * (b & 3) + t);
+        }
+        updateLength(t, length);
+    }
+    for (int i = 0; i < MAX_LENGTH / 4; ++i)
+        _startSlices[i] = _slices[i];
 
     // create default note pool when created
     UpdateNotePool(48, 3, 0);
 }
 
 // Call this each time the clock 'ticks'
-// Pick a random number 0 to maxRange
-// if the number is below the pot reading: bitRotateLflip, otherwise bitRotateL
-// set _outputValue as
-void Turing::Update(int pot, int maxRange)
+void TuringBank::Update()
 {
-    int safeZone = maxRange >> 5;
-    int sample = safeZone + random(maxRange - (safeZone * 2)); // add safe zones at top and bottom
-
-    if (_count == 0)
+    // Each track's bit at its length, folded down into one byte: bit t is track t's feedback
+    uint32_t feedback = 0;
+    for (int i = 0; i < MAX_LENGTH / 4; ++i)
+        feedback |= _slices[i] & _taps[i];
+    feedback |= feedback >> 16;
+    feedback |= feedback >> 8;
+
+    // Flips, two tracks per random number
+    uint32_t flips = 0;
+    for (int t = 0; t < _tracks; t += 2)
     {
-        _startValue = _sequence;
+        uint32_t r = next();
+        flips |= static_cast<uint32_t>((r & 0xFFFF) < _flipThreshold[t]) << t;
+        flips |= static_cast<uint32_t>((r >> 16) < _flipThreshold[t + 1]) << (t + 1);
     }
 
-    if (++_count >= _length)
-    {
-        _count = 0;
-    }
+    // Shift every track left one bit, feeding back into bit 0
+    _slices[3] = (_slices[3] << 8) | (_slices[2] >> 24);
+    _slices[2] = (_slices[2] << 8) | (_slices[1] >> 24);
+    _slices[1] = (_slices[1] << 8) | (_slices[0] >> 24);
+    _slices[0] = (_slices[0] << 8) | ((feedback ^ flips) & _activeMask);
 
-    if (sample >= pot)
+    // Remember each track's value at the start of its cycle, for reset
+    uint32_t started = 0;
+    for (int t = 0; t < _tracks; ++t)
     {
-        _sequence = bitRotateLflip(_sequence, _length);
+        if (++_count[t] >= _length[t])
+        {
+            _count[t] = 0;
+            started |= 1u << t;
+        }
     }
-
-    else
+    if (started)
     {
-        _sequence = bitRotateL(_sequence, _length);
+        uint32_t m = started * 0x01010101u;
+        for (int i = 0; i < MAX_LENGTH / 4; ++i)
+            _startSlices[i] = (_startSlices[i] & ~m) | (_slices[i] & m);
     }
+}
 
-    if (_count++ == 0)
-    {
-        _startValue = _sequence;
-    }
+void TuringBank::SetProbability(int track, int pot, int maxRange)
+{
+    // sample = safeZone + random(span) flips if sample >= pot
+    int safeZone = maxRange >> 5;
+    int span = maxRange - (safeZone * 2);
+    int flipping = maxRange - safeZone - pot;
+    if (flipping < 0)
+        flipping = 0;
+    if (flipping > span)
+        flipping = span;
+    _flipThreshold[track] = span > 0 ? (static_cast<uint32_t>(flipping) << 16) / span : 0;
 }
 
-// returns the full current sequence value as 16 bit number 0 to 65535
-uint16_t Turing::DAC_16()
+void TuringBank::SetAllProbabilities(int pot, int maxRange)
 {
-    return _sequence;
+    SetProbability(0, pot, maxRange);
+    for (int t = 1; t < _tracks; ++t)
+        _flipThreshold[t] = _flipThreshold[0];
 }
 
-// returns the current sequence value as 8 bit number 0 to 255 = ignores the last 8 binary digits
-uint8_t Turing::DAC_8()
+// Bits 0-3 of a track from one slice
+uint32_t TuringBank::gather(uint32_t slice, int track)
 {
+    uint32_t w = (slice >> track) & 0x01010101u;
+    w |= w >> 7;
+    w |= w >> 14;
+    return w & 0xF;
+}
 
-    //  return _sequence >> 8 ; // left hand 8 bits
-    return _sequence & 0xFF; // right hand 8 bits
+// returns the full current sequence value as 16 bit number 0 to 65535
+uint16_t TuringBank::DAC_16(int track)
+{
+    return static_cast<uint16_t>(gather(_slices[0], track) | (gather(_slices[1], track) << 4) |
+                                 (gather(_slices[2], track) << 8) | (gather(_slices[3], track) << 12));
 }
 
-void Turing::updateLength(int newLen)
+// returns the current sequence value as 8 bit number 0 to 255 = ignores the last 8 binary digits
+uint8_t TuringBank::DAC_8(int track)
 {
-    _length = newLen;
+    return static_cast<uint8_t>(gather(_slices[0], track) | (gather(_slices[1], track) << 4)); // right hand 8 bits
 }
 
-uint16_t Turing::returnLength()
+void TuringBank::updateLength(int track, int newLen)
 {
-    return _length;
+    if (newLen < 1)
+        newLen = 1;
+    if (newLen > MAX_LENGTH)
+        newLen = MAX_LENGTH;
+    _length[track] = static_cast<uint8_t>(newLen);
+
+    // Move the track's feedback tap to bit newLen - 1
+    for (int i = 0; i < MAX_LENGTH / 4; ++i)
+        _taps[i] &= ~(0x01010101u << track);
+    _taps[(newLen - 1) >> 2] |= 1u << (8 * ((newLen - 1) & 3) + track);
 }
 
-uint32_t Turing::next()
+uint16_t TuringBank::returnLength(int track)
 {
-    constexpr uint32_t a = 1103515245u;
-    constexpr uint32_t c = 12345u;
-    _seed = a * _seed + c;
-    return static_cast<uint32_t>(_seed >> 1); // 31-bit positive
+    return _length[track];
 }
 
-void Turing::randomSeed(uint32_t seed)
+uint32_t TuringBank::next()
 {
-    if (seed != 0)
-        _seed = seed; // ignore zero (matches Arduino)
+    // xorshift32: a few shifts, no multiply or divide
+    uint32_t x = _seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    _seed = x;
+    return x;
 }
 
-uint32_t Turing::random(uint32_t max) // [0, max)
+void TuringBank::randomSeed(uint32_t seed)
 {
-    if (max <= 0)
-        return 0;
-    return next() % max;
+    if (seed != 0)
+        _seed = seed; // ignore zero (matches Arduino, and xorshift needs a nonzero state)
 }
 
-void Turing::reset()
+void TuringBank::reset()
 {
-    _sequence = _startValue;
-    _count = 0;
+    for (int i = 0; i < MAX_LENGTH / 4; ++i)
+        _slices[i] = _startSlices[i];
+    for (int t = 0; t < _tracks; ++t)
+        _count[t] = 0;
 }
 
-uint8_t Turing::MidiNote()
+uint8_t TuringBank::MidiNote(int track)
 {
-    if (note_pool_size == 0)
+    const NotePool &pool = note_pool[__atomic_load_n(&active_pool, __ATOMIC_ACQUIRE)];
+    if (pool.size == 0)
         return 0; // fallback, silence or base note
 
-    uint8_t val = DAC_8();                   // 0–255 from looping 8-bit register
-    int index = (val * note_pool_size) >> 8; // fast mapping
-    if (index >= note_pool_size)
-        index = note_pool_size - 1; // safety
+    uint8_t val = DAC_8(track);         // 0–255 from looping 8-bit register
+    int index = (val * pool.size) >> 8; // fast mapping
+    if (index >= pool.size)
+        index = pool.size - 1; // safety
 
-    return note_pool[index];
+    return pool.root + pool.intervals[index];
 }
 
-void Turing::UpdateNotePool(int root_note, int octave_range, int scale_type)
+void TuringBank::UpdateNotePool(int root_note, int octave_range, int scale_type)
 {
-    // Define the scale tables (can be moved to global/static later)
-    static const int chromatic[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
-    static const int major[] = {0, 2, 4, 5, 7, 9, 11};
-    static const int minor[] = {0, 2, 3, 5, 7, 8, 10};
-    static const int minor_pent[] = {0, 3, 5, 7, 10};
-    static const int dorian[] = {0, 2, 3, 5, 7, 9, 10};
-    static const int pelog[] = {0, 1, 3, 7, 10};
-    static const int wholetone[] = {0, 2, 4, 6, 8, 10};
-
-    static const int *const scale_tables[] = {
-        chromatic, major, minor, minor_pent, dorian, pelog, wholetone};
-    static const int scale_sizes[] = {
-        12, 7, 7, 5, 7, 5, 6};
-
     // Bounds check
-    if (scale_type < 0 || scale_type >= (int)(sizeof(scale_tables) / sizeof(scale_tables[0])))
+    if (scale_type < 0 || scale_type >= NUM_SCALES)
     {
         scale_type = 0;
     }
-
-    const int *scale = scale_tables[scale_type];
-    int scale_size = scale_sizes[scale_type];
-
-    note_pool_size = 0;
-
-    for (int oct = 0; oct <= octave_range; ++oct)
-    {
-        int base = root_note + 12 * oct;
-        for (int i = 0; i < scale_size; ++i)
-        {
-            int note = base + scale[i];
-            if (note >= 0 && note < 128)
-            {
-                note_pool[note_pool_size++] = note;
-                if (note_pool_size >= MAX_NOTES)
-                    return;
-            }
-        }
-    }
+    if (root_note < 0)
+        root_note = 0;
+    if (root_note > 127)
+        root_note = 127;
+
+    // The intervals below the top of the range that keep the note below 128
+    int limit = 12 * (octave_range + 1);
+    if (limit > 128 - root_note)
+        limit = 128 - root_note;
+    const uint8_t *intervals = scale_intervals.intervals[scale_type];
+    int size = 0;
+    while (size < scale_intervals.size[scale_type] && intervals[size] < limit)
+        ++size;
+
+    // Point the pool not in use at the table, then publish it
+    uint8_t back = active_pool ^ 1;
+    note_pool[back].intervals = intervals;
+    note_pool[back].size = size;
+    note_pool[back].root = root_note;
+    __atomic_store_n(&active_pool, back, __ATOMIC_RELEASE);
 }
@@ -1,40 +1,64 @@
 #pragma once
 #include <stdint.h>
 
-class Turing
-
+// Up to eight Turing machine shift registers, clocked together.
+//
+// The registers are stored bit-sliced: bit b of track t is bit 8 * (b % 4) + t of _slices[b / 4],
+// so each byte of a slice holds one bit position of every track. One clock shifts all the tracks
+// with a few word shifts, finds every track's feedback bit (at its own length) with one mask per
+// slice, and flips each with its own probability, so extra tracks cost little per clock.
+class TuringBank
 {
+public:
+    static constexpr int MAX_TRACKS = 8;
+    static constexpr int MAX_LENGTH = 16;
 
-#define bitRotateL(value, len) ((((value) >> ((len) - 1)) & 0x01) | ((value) << 1))
-#define bitRotateLflip(value, len) (((~((value) >> ((len) - 1)) & 0x01) | ((value) << 1)))
+    TuringBank(int tracks, int length, uint32_t seed);
 
-public:
-    Turing(int length, uint32_t seed);
-    void Update(int pot, int maxRange);
-    void updateLength(int newLen);
-    uint16_t returnLength();
-    uint16_t DAC_16();
-    uint8_t DAC_8();
-    void DAC_print8();
-    void DAC_print16();
+    // Call this each time the clock 'ticks': rotate every track, flipping the bit fed back as set
+    // by SetProbability
+    void Update();
+
+    // As the single Turing machine: pick a random number 0 to maxRange, and flip if it is not
+    // below the pot reading (with safe zones at the top and bottom, so the ends lock or always flip)
+    void SetProbability(int track, int pot, int maxRange);
+    void SetAllProbabilities(int pot, int maxRange);
+
+    void updateLength(int track, int newLen);
+    uint16_t returnLength(int track);
+    uint16_t DAC_16(int track);
+    uint8_t DAC_8(int track);
     void randomSeed(uint32_t seed);
-    // uint8_t MidiNote(int low_note, int high_note, int scale_type, int sieve_type);
     void UpdateNotePool(int root_note, int octave_range, int scale_type);
-    uint8_t MidiNote();
-    void reset(); // Experimental - resets turing to the value at start of the current cycle
+    uint8_t MidiNote(int track);
+    void reset(); // Experimental - resets each track to its value at the start of its current cycle
 
 private:
-    uint16_t _sequence = 0; // randomise on initialisation
-    int _length = 16;
-    inline static uint32_t _seed = 1;
+    int _tracks = 1;
+    uint8_t _activeMask = 1;
+    uint32_t _slices[MAX_LENGTH / 4] = {};
+    uint32_t _taps[MAX_LENGTH / 4] = {};    // bit of each track's slices that is fed back
+    uint8_t _length[MAX_TRACKS] = {};
+    uint32_t _flipThreshold[MAX_TRACKS] = {}; // flip if a 16-bit random number is below this
+    uint32_t _seed = 1;
     uint32_t next();
-    uint32_t random(uint32_t max);
+    static uint32_t gather(uint32_t slice, int track);
 
-    static constexpr uint8_t MAX_NOTES = 128;
-    uint8_t note_pool[MAX_NOTES];
-    int note_pool_size = 0;
+    // A note pool is the root plus a prefix of one scale's table of intervals (in Turing.cpp,
+    // built at compile time), so changing root, scale or range only points at a different
+    // table and length
+    struct NotePool
+    {
+        const uint8_t *intervals = nullptr;
+        int size = 0;
+        int root = 0;
+    };
+    // Double-buffered: UpdateNotePool (core 0) writes the pool not in use, then
+    // swaps active_pool, so MidiNote (audio core) never sees a half-updated pool
+    NotePool note_pool[2];
+    uint8_t active_pool = 0;
 
     // Experimental: Reset system
-    uint16_t _startValue = 0;
-    uint8_t _count = 0;
+    uint32_t _startSlices[MAX_LENGTH / 4] = {};
+    uint8_t _count[MAX_TRACKS] = {};
 };
@@ -1,9 +1,14 @@
 /************************************************************
  *  Core-split bootstrap for ComputerCard on RP2040
  *
- *  • Core 0 – USB-CDC stdio + flash-save service
+ *  • Core 0 – USB MIDI/sysex editor, settings, note-pool and
+ *             CV-table rebuilds, flash-save service
  *  • Core 1 – ComputerCard audio engine (48 kHz ISR)
  *
+ *  Core 0 never locks out Core 1: rebuilt note pools and CV
+ *  tables are published by swapping double buffers, and flash
+ *  writes only disable Core 0's interrupts.
+ *
  *  Requires:
  *    - CMakeLists.txt links pico_stdlib & pico_multicore
  *    - PICO_COPY_TO_RAM 1  (so flash stalls don’t hurt audio)
@@ -26,7 +31,6 @@ static MainApp *volatile gApp = nullptr;
 
 static void core1_entry()
 {
-    multicore_lockout_victim_init();
     // prinft("Core 1 running on core %d\n", get_core_num());
 
     static MainApp app; // all ComputerCard work lives here
@@ -2,8 +2,13 @@
 #include "quantiser.h"
 
 #define SHIFT_REG_SIZE 6
+#define CELL_BITS 2
+#define CELL_MASK 0x3
+#define SHIFT_REG_BITS (SHIFT_REG_SIZE * CELL_BITS)
+#define SHIFT_REG_MASK ((1 << SHIFT_REG_BITS) - 1)
 #define RUNGLER_DAC_BITS 3
 #define RUNGLER_DAC_CELLS 2
+#define RUNGLER_DAC_MASK ((1 << (RUNGLER_DAC_BITS * RUNGLER_DAC_CELLS)) - 1)
 #define FWD 1
 #define BACK 0
 
@@ -22,10 +27,7 @@ public:
 	BYOBenjolin()
 	{
 		// Constructor sets up shift register
-		for (int i = 0; i < SHIFT_REG_SIZE; i++)
-		{
-			bits[i] = 0;
-		}
+		bits = 0;
 	}
 
 	virtual void ProcessSample()
@@ -71,17 +73,17 @@ public:
 		if (fwdClock)
 		{
 
-			rotate(bits, FWD);
+			rotate(FWD);
 
 			if (sw == Switch::Down)
 			{
 				//The equivalent of Turing Machines's write switch
-				bits[0] = 0x3; // Always set the first bit to binary 11 = int 3 = hex 0x3
+				setCell(0, 0x3); // Always set the first bit to binary 11 = int 3 = hex 0x3
 			}
 			else if (sw == Switch::Up || theIllusionOfStability)
 			{
 				//The equivalent of the looping switch on a Rungler.
-				bits[0] = ~bits[0] & 0x3; // Always Toggle the first bit
+				bits ^= CELL_MASK; // Always Toggle the first bit
 			}
 			else // sw == Switch::Middle
 			{
@@ -96,7 +98,7 @@ public:
 
 				if (data > turingP)
 				{
-					bits[0] = ~data & 0x3; // Instead of just flipping the write bit, we are now fliping the entire 2-bit int
+					setCell(0, ~data); // Instead of just flipping the write bit, we are now fliping the entire 2-bit int
 				}
 			}
 
@@ -106,15 +108,15 @@ public:
 
 		if (backClock)
 		{
-			rotate(bits, BACK);
+			rotate(BACK);
 
 			if (sw == Switch::Down)
 			{
-				bits[SHIFT_REG_SIZE - 1] = 0x0; // Always set the last bit to 0
+				setCell(SHIFT_REG_SIZE - 1, 0x0); // Always set the last bit to 0
 			}
 			else if (sw == Switch::Up || theIllusionOfStability)
 			{
-				bits[SHIFT_REG_SIZE - 1] = ~bits[SHIFT_REG_SIZE - 1] & 0x3; // Always Toggle the LAST bit
+				bits ^= CELL_MASK << ((SHIFT_REG_SIZE - 1) * CELL_BITS); // Always Toggle the LAST bit
 			}
 			else // sw == Switch::Middle
 			{
@@ -131,7 +133,7 @@ public:
 
 				if (data > turingP)
 				{
-					bits[SHIFT_REG_SIZE - 1] = ~data & 0x3; //note the write bit is the LAST bit when clocking back/left. This is different than the fwd/right clocking.
+					setCell(SHIFT_REG_SIZE - 1, ~data); //note the write bit is the LAST bit when clocking back/left. This is different than the fwd/right clocking.
 				}
 			}
 			calcOffset();
@@ -143,16 +145,10 @@ public:
 		// Ie. for the right (channel 2) signal, if the shift register contains {0, 1, 2, 3, 0, 1} (in binary: 00, 01, 10, 11, 00, 01)
 		// then we take the last 3 values and concatenate them to build a new six bit signal: binary 110001 which is 49 in decimal
 		// for the left (channel 1) signal, we do the same but with the first 3 values in the shift register
+		// The cells are packed into one word in that order, so each signal is just a slice of it
 
-		for (int i = 0; i < RUNGLER_DAC_BITS; i++)
-		{
-			runglerOut1 |= ((bits[i] << (2 * i)) & 0x3F);
-		}
-
-		for (int i = SHIFT_REG_SIZE - RUNGLER_DAC_BITS - 1; i < SHIFT_REG_SIZE; i++)
-		{
-			runglerOut2 |= ((bits[i] << (2 * (i - (SHIFT_REG_SIZE - RUNGLER_DAC_BITS)))) & 0x3F);
-		}
+		runglerOut1 = bits & RUNGLER_DAC_MASK;
+		runglerOut2 = (bits >> ((SHIFT_REG_SIZE - RUNGLER_DAC_BITS) * CELL_BITS)) & RUNGLER_DAC_MASK;
 
 		// convert 6 bit output to 12 bit values for DAC
 		runglerOut1 = (runglerOut1 << (12 - (RUNGLER_DAC_BITS * RUNGLER_DAC_CELLS)));
@@ -178,8 +174,8 @@ public:
 		clip(quantizedRunglerOut2, -2048, 2047);
 
 		// Quantize the output to the nearest MIDI note for our CV outputs
-		quantizedRunglerOut1 = quantSample(quantizedRunglerOut1);
-		quantizedRunglerOut2 = quantSample(quantizedRunglerOut2);
+		quantizedRunglerOut1 = quant1.process(quantizedRunglerOut1, majorQuantScale);
+		quantizedRunglerOut2 = quant2.process(quantizedRunglerOut2, majorQuantScale);
 
 		// Output rungler signal
 		AudioOut1(runglerOut1);
@@ -190,8 +186,8 @@ public:
 		CVOut2MIDINote(quantizedRunglerOut2);
 
 		// Output pulse signals based on the bottom bit of each channel
-		PulseOut1(bits[SHIFT_REG_SIZE - 4] & 0x1);
-		PulseOut2(bits[SHIFT_REG_SIZE - 1] & 0x1);
+		PulseOut1(cell(SHIFT_REG_SIZE - 4) & 0x1);
+		PulseOut2(cell(SHIFT_REG_SIZE - 1) & 0x1);
 
 		// show shiftreg state on LEDs
 		// each LED shows a 2-bit value from the 6 step shift register
@@ -200,12 +196,13 @@ public:
 		// With 2-bit signals we end up with 4 brightness levels (and possible values) for each LED:
 		for (int i = 0; i < 6; i++)
 		{
-			LedBrightness(ledMap[i], (bits[i] << 10) * vca >> 12);
+			LedBrightness(ledMap[i], (cell(i) << 10) * vca >> 12);
 		}
 	}
 
 private:
-	int16_t bits[SHIFT_REG_SIZE];
+	// Shift register, CELL_BITS bits per cell, with cell 0 in the lowest bits
+	uint32_t bits;
 	bool fwdClock = false;
 	bool backClock = false;
 	int16_t turingP;
@@ -213,31 +210,32 @@ private:
 	int16_t vca = 0;
 	int8_t ledMap[SHIFT_REG_SIZE] = {0, 2, 4, 1, 3, 5};
 	int16_t offset = 0;
+	Quantiser quant1, quant2;
 
-	void rotate(int16_t *array, bool direction)
+	// Rotate the whole register by one cell, in a couple of instructions
+	// however fast it is clocked
+	void rotate(bool direction)
 	{
-		if (direction) // Rotate right
+		if (direction) // Rotate right: each cell moves up one, the last wraps to the first
 		{
-			int16_t lastBit = array[SHIFT_REG_SIZE - 1];
-
-			for (int i = SHIFT_REG_SIZE - 1; i > 0; i--)
-			{
-				array[i] = array[i - 1];
-			}
-			array[0] = lastBit;
+			bits = ((bits << CELL_BITS) | (bits >> (SHIFT_REG_BITS - CELL_BITS))) & SHIFT_REG_MASK;
 		}
-		else // Rotate left
+		else // Rotate left: each cell moves down one, the first wraps to the last
 		{
-			int16_t firstBit = array[0];
-
-			for (int i = 0; i < SHIFT_REG_SIZE - 1; i++)
-			{
-				array[i] = array[i + 1];
-			}
-			array[SHIFT_REG_SIZE - 1] = firstBit;
+			bits = (bits >> CELL_BITS) | ((bits & CELL_MASK) << (SHIFT_REG_BITS - CELL_BITS));
 		}
 	}
 
+	int16_t cell(int i)
+	{
+		return (bits >> (i * CELL_BITS)) & CELL_MASK;
+	}
+
+	void setCell(int i, uint32_t value)
+	{
+		bits = (bits & ~(CELL_MASK << (i * CELL_BITS))) | ((value & CELL_MASK) << (i * CELL_BITS));
+	}
+
 	void calcOffset()
 	{
 		if (Connected(Input::CV1))
@@ -1,36 +1,95 @@
 //A stripped down version of the quantiser from Chris Johnson's Utility Pair project
+//
+//Table driven: quantBands, built at compile time, gives the chromatic note for every
+//12-bit input along with its hysteresis band, and a QuantScale maps chromatic notes
+//to the notes of one scale. Each quantised output has its own Quantiser, so any number
+//of them can share the same tables. This file is the same in every card that uses it.
 
 #ifndef __QUANTISER_H__
 #define __QUANTISER_H__
 
 #define COMPUTERCARD_NOIMPL
 
-int note_in = 69, pulseCounter = 0;
-constexpr static uint8_t majorScale[12] = {0, 0, 2, 2, 4, 4, 5, 7, 7, 9, 9, 11};  // Octaves
+#define QUANT_INPUTS 4096 // 12-bit CV in
+#define QUANT_NOTES 145   // chromatic notes spanned by the input, at 12 per volt
 
-int16_t __not_in_flash_func(quantSample)(int16_t input)
+// For each input (0 being -2048), the chromatic note it falls in when reached from
+// below (up) and from above (down). Inputs where the two differ are in the hysteresis
+// band between two notes, and stay on whichever of them they last had.
+struct QuantBands
 {
-    int32_t note_in_cont = (input + 2048) << 8;
-    if (note_in_cont < 0)
-        note_in_cont = 0;
-    int32_t note_in_up = (note_in_cont - 1000) / 7282;
-    int32_t note_in_down = (note_in_cont + 1000) / 7282;
+    uint8_t up[QUANT_INPUTS];
+    uint8_t down[QUANT_INPUTS];
 
-    if (note_in_up > note_in)
+    constexpr QuantBands() : up(), down()
     {
-        note_in = note_in_up;
+        for (int32_t i = 0; i < QUANT_INPUTS; i++)
+        {
+            int32_t note_in_cont = i << 8;
+            int32_t note_in_up = (note_in_cont - 1000) / 7282;
+            up[i] = note_in_up < 0 ? 0 : note_in_up;
+            down[i] = (note_in_cont + 1000) / 7282;
+        }
     }
-    else if (note_in_down < note_in)
+};
+
+constexpr QuantBands quantBands;
+
+// Output note for each chromatic note, for one scale.
+// scale gives the note that each of the 12 semitones of an octave moves to,
+// and octaveOffset is added to the octave of every note.
+// Fixed scales can be constexpr; others can be set up (again) at run time.
+struct QuantScale
+{
+    int16_t note[QUANT_NOTES];
+
+    constexpr QuantScale() : note() {}
+
+    constexpr QuantScale(const int8_t *scale, int16_t octaveOffset) : note()
     {
-        note_in = note_in_down;
-    };
+        set(scale, octaveOffset);
+    }
 
-    int16_t octave = note_in / 12;
-    int16_t noteval = note_in % 12;
+    constexpr void set(const int8_t *scale, int16_t octaveOffset)
+    {
+        for (int16_t n = 0; n < QUANT_NOTES; n++)
+        {
+            note[n] = 12 * (n / 12 + octaveOffset) + scale[n % 12];
+        }
+    }
+};
 
-    int16_t quantisedNote = 12 * octave + majorScale[noteval];
+constexpr static int8_t majorScale[12] = {0, 0, 2, 2, 4, 4, 5, 7, 7, 9, 9, 11};  // Octaves
+constexpr QuantScale majorQuantScale(majorScale, 0);
+
+// Hysteresis state for one quantised output
+class Quantiser
+{
+public:
+    Quantiser() : note_in(69) {} // Default to A4
+
+    int16_t __not_in_flash_func(process)(int16_t input, const QuantScale &scale)
+    {
+        int32_t i = input + 2048;
+        if (i < 0)
+            i = 0;
+        if (i > QUANT_INPUTS - 1)
+            i = QUANT_INPUTS - 1;
+
+        if (quantBands.up[i] > note_in)
+        {
+            note_in = quantBands.up[i];
+        }
+        else if (quantBands.down[i] < note_in)
+        {
+            note_in = quantBands.down[i];
+        }
+
+        return scale.note[note_in];
+    }
 
-    return quantisedNote;
-}
+private:
+    uint8_t note_in;
+};
 
-#endif // quantiser_h
\ No newline at end of file
+#endif // quantiser_h
@@ -23,16 +23,31 @@
     If starts off unlikely to change and gets more likely with each toss
 
     LEDs show the current note in the chord
+
+    Everything runs in ProcessSample at 48kHz, so a note's CV and pulse are
+    set in the same sample that its clock edge (or note timer) is seen.
+    Most samples have nothing to do: ProcessSample only looks for the events
+    (clock edge, switch change, note due, timer expired) and dispatches those
+    seen to their handlers, and the core sleeps between samples.
+    Pitches are worked out in cents, and each chord is voiced into calibrated CV
+    codes when its root changes, so that playing a step is a table read.
 */
 
-#include <stdio.h>
-#include <math.h>
-#include "pico/stdlib.h"
-#include "computer.h"
-#include "ui.h"
+#include "ComputerCard.h"
+
+// Arpeggiator direction modes
+enum ArpMode
+{
+    ARP_UP = 0,
+    ARP_DOWN = 1,
+    ARP_UPUP = 2,
+    ARP_DOWNDOWN = 3,
+    ARP_UPDOWN_INC = 4,
+    ARP_UPDOWN_EXC = 5
+};
 
 // --- Arp helpers ---
-static inline int chord_size(const int *row)
+static inline int chord_size(const int8_t *row)
 {
     int n = 0;
     while (row[n] != -1)
@@ -40,12 +55,10 @@ static inline int chord_size(const int *row)
     return n;
 }
 
-#define TRIGGER_LENGTH 10
-
-Computer computer;
-UI ui;
+// Most steps in one arpeggio cycle: six chord notes, or six fixed-length steps
+#define MAX_STEPS 6
 
-int chords[12][7] = {
+static const int8_t chords[12][7] = {
     {0, 4, 7, -1},             // M
     {0, 4, 7, 11, -1},         // M7
     {0, 4, 7, 11, 14, -1},     // M9
@@ -60,192 +73,549 @@ int chords[12][7] = {
     {0, 3, 7, -1}              // m
 };
 
-bool pulse_in_got[2] = {false, false};
-void pulsein_callback(uint gpio, uint32_t events)
+class ChordBlimey : public ComputerCard
 {
-    pulse_in_got[gpio - PIN_PULSE1_IN] = true;
-}
+public:
+    static constexpr int32_t SAMPLES_PER_MS = 48;
+    static constexpr int32_t TRIGGER_LENGTH = 10 * SAMPLES_PER_MS;
+    static constexpr int32_t LED_SUPPRESS = 2000 * SAMPLES_PER_MS; // LED suppression duration
+    static constexpr int32_t LONGPRESS = 800 * SAMPLES_PER_MS;     // long-press threshold
 
-// current play state
-bool chord_play = false;
-uint chord = 0;
-uint chord_note = 0;
-uint32_t last_note_time = 0;
+    ChordBlimey()
+    {
+        coin_weight[0] = UINT32_MAX;
+        coin_weight[1] = UINT32_MAX;
 
-int arp_count = 0;
-int arp_length = -1;
+        // output trigger on pulse 2 to start looping if patched
+        Arm(PULSE_2_END, TRIGGER_LENGTH);
+        events = 1 << EV_PULSE_OUTS;
+    }
 
-int main()
-{
-    stdio_init_all();
-    computer.init();
-    computer.calibrateIfSwitchDown();
+    virtual void ProcessSample()
+    {
+        // Handlers in the order they run; each may raise the events after its own
+        static constexpr Handler handlers[NUM_EVENTS] = {
+            &ChordBlimey::OnTimers,
+            &ChordBlimey::OnSwitch,
+            &ChordBlimey::OnLongPress,
+            &ChordBlimey::OnModeChange,
+            &ChordBlimey::OnClock,
+            &ChordBlimey::OnNote,
+            &ChordBlimey::OnPulseOuts};
+
+        samples++;
+
+        if (timers_armed && int32_t(samples - next_due) >= 0)
+            events |= 1 << EV_TIMERS;
+        if (!switch_started || SwitchVal() != prev_switch_state)
+            events |= 1 << EV_SWITCH;
+        if (PulseIn1RisingEdge())
+            events |= 1 << EV_CLOCK;
+        if (chord_play && int32_t(samples - note_start) >= NoteLength())
+            events |= 1 << EV_NOTE;
+
+        if (!events)
+            return;
+        for (int e = 0; e < NUM_EVENTS; e++)
+        {
+            if ((events >> e) & 1)
+                (this->*handlers[e])();
+        }
+        events = 0;
+    }
 
-    computer.setPulseCallback(1, pulsein_callback);
-    ui.init(&computer);
+private:
+    // Events seen in a sample, dispatched in this order
+    enum Event
+    {
+        EV_TIMERS,      // a timer has expired
+        EV_SWITCH,      // switch moved
+        EV_LONG_PRESS,  // switch held down for LONGPRESS
+        EV_MODE_CHANGE, // arp direction changed by a long press
+        EV_CLOCK,       // rising edge at pulse in 1
+        EV_NOTE,        // next note due
+        EV_PULSE_OUTS,  // a pulse output started or ended
+        NUM_EVENTS
+    };
+    typedef void (ChordBlimey::*Handler)();
+    uint32_t events = 0;
+
+    // Timers, each due at a sample count, expiring as EV_TIMERS
+    enum Timer
+    {
+        PULSE_1_END,
+        PULSE_2_END,
+        LED_HOLD_END,     // while armed, do not overwrite UI LED hint
+        LED_SUPPRESS_END, // while armed, do not show step LEDs
+        LONG_PRESS,
+        NUM_TIMERS
+    };
+    uint32_t timer_due[NUM_TIMERS];
+    uint32_t timers_armed = 0;
+    uint32_t next_due = 0; // earliest of the armed timers
+
+    uint32_t coin_weight[2];
+    uint32_t rng = 0x2545F491;
+    uint32_t samples = 0;
+
+    // current play state
+    bool chord_play = false;
+    int chord = 0;
+    int arp_count = 0;
+    uint32_t note_start = 0; // sample count at the last note
+
+    // root note in cents above 0V, read at the start of each note
+    int32_t root_cents = 0;
+
+    // CV codes for each step of the current chord and root, rebuilt by Voice()
+    int32_t voiced_root = INT32_MIN;
+    int voiced_chord = -1;
+    uint32_t note_code[MAX_STEPS];
+    uint32_t root_code[MAX_STEPS];
+
+    // switch state
+    uint8_t fix_length = 6;
+    bool fix_length_on = false;
+    bool switch_started = false;
+    Switch prev_switch_state = Switch::Up;
+
+    // Long-press handling for DOWN position
+    ArpMode arp_mode = ARP_UP;       // default direction
+    bool down_long_consumed = false; // true if long press already handled
+    bool down_pending_short = false; // true until we decide it's a short press
+
+    // Start timer t, to expire in the sample length samples from now
+    void Arm(Timer t, int32_t length)
+    {
+        timer_due[t] = samples + length;
+        timers_armed |= 1 << t;
+        NextDue();
+    }
 
-    // output trigger on pulse 2 to start looping if patched
-    computer.setTimedPulse(2, TRIGGER_LENGTH);
+    void Disarm(Timer t)
+    {
+        timers_armed &= ~(1 << t);
+        NextDue();
+    }
 
-    while (true)
+    bool Armed(Timer t)
     {
-        uint32_t now = to_ms_since_boot(get_absolute_time());
-        computer.poll();
-        ui.checkSwitch();
-        arp_length = ui.getArpLength();
+        return (timers_armed >> t) & 1;
+    }
 
-        // If mode changed, restart the cycle immediately in the new direction
-        if (ui.consumeModeChanged())
+    void NextDue()
+    {
+        int32_t soonest = INT32_MAX;
+        for (int t = 0; t < NUM_TIMERS; t++)
         {
-            if (chord_play)
-            {
-                arp_count = 0;      // restart from beginning of pattern
-                last_note_time = 0; // play immediately on next tick
-            }
+            if (Armed(Timer(t)) && int32_t(timer_due[t] - samples) < soonest)
+                soonest = int32_t(timer_due[t] - samples);
+        }
+        next_due = samples + soonest;
+    }
+
+    void OnTimers()
+    {
+        for (int t = 0; t < NUM_TIMERS; t++)
+        {
+            if (!Armed(Timer(t)) || int32_t(samples - timer_due[t]) < 0)
+                continue;
+            timers_armed &= ~(1 << t);
+            if (t == PULSE_1_END || t == PULSE_2_END)
+                events |= 1 << EV_PULSE_OUTS;
+            else if (t == LONG_PRESS)
+                events |= 1 << EV_LONG_PRESS;
         }
+        NextDue();
+    }
 
-        // if we get a pulse start a new arp
-        if (pulse_in_got[0])
+    // If mode changed, restart the cycle immediately in the new direction
+    void OnModeChange()
+    {
+        if (chord_play)
         {
-            pulse_in_got[0] = false;
-            chord_note = 0;
-            arp_count = 0;
+            arp_count = 0;          // restart from beginning of pattern
+            events |= 1 << EV_NOTE; // play immediately
+        }
+    }
+
+    // if we get a pulse start a new arp
+    void OnClock()
+    {
+        arp_count = 0;
+
+        SpinRandomOuts();
+
+        chord = GetChord();
+        chord_play = true;
+        events |= 1 << EV_NOTE;
+    }
+
+    void OnNote()
+    {
+        NextNote();
+    }
+
+    // Pulse outputs are written once all the events of the sample are handled, so that
+    // one ending and restarting in the same sample does not glitch
+    void OnPulseOuts()
+    {
+        PulseOut(0, Armed(PULSE_1_END));
+        PulseOut(1, Armed(PULSE_2_END));
+    }
 
-            ui.spinRandomOuts();
+    void SetLEDs(uint8_t values)
+    {
+        for (int i = 0; i < 6; i++)
+            LedOn(i, (values >> i) & 1);
+    }
 
-            chord = ui.getChord();
-            chord_play = true;
-            last_note_time = 0; // reset so we play immediately
+    int GetArpLength()
+    {
+        return fix_length_on ? fix_length : -1;
+    }
+
+    int32_t NoteLength()
+    {
+        // invert knob value and curve it so we have more control over the faster end
+        return ((1 << ((4095 - KnobVal(Knob::Main)) / 300)) + 20) * SAMPLES_PER_MS;
+    }
+
+    int GetChord()
+    {
+        // Y knob is 0-1V and CV 2 is 4096 per 12V, both in twelfths of a volt
+        int c = (KnobVal(Knob::Y) * 12 + CVIn2() * 144) >> 12;
+        if (c > 11)
+            return 11;
+        if (c < 0)
+            return 0;
+        return c;
+    }
+
+    void UpdateRoot()
+    {
+        // X knob is 0-1V, CV 1 is 1V/octave through its calibration table
+        root_cents = KnobVal(Knob::X) * 1200 / 4095 + (((CVInPitchQ16(0) - (60 << 16)) * 100) >> 16);
+    }
+
+    // Calibrated CV code for a pitch in cents above 0V
+    uint32_t CentsCode(int i, int32_t cents)
+    {
+        int32_t note = (cents + 6000) / 100;
+        int32_t rem = cents + 6000 - note * 100;
+        if (rem < 0)
+        {
+            note--;
+            rem += 100;
         }
+        if (note < 0)
+        {
+            note = 0;
+            rem = 0;
+        }
+        if (note > 127)
+        {
+            note = 127;
+            rem = 0;
+        }
+        return CVCodeMIDINoteCents(i, note, rem);
+    }
+
+    // Work out the CV codes for every step of the chord from the current root,
+    // if either has changed since last time
+    void Voice()
+    {
+        if (root_cents == voiced_root && chord == voiced_chord)
+            return;
+        voiced_root = root_cents;
+        voiced_chord = chord;
 
-        // if time for a new note
-        uint note_length = ui.getNoteLengthMS();
-        if (chord_play && (now - last_note_time >= note_length || last_note_time == 0))
+        int csize = chord_size(chords[chord]);
+        for (int s = 0; s < MAX_STEPS; s++)
         {
-            // Determine chord size and the total length of this arpeggio cycle
-            int csize = chord_size(chords[chord]);                   // notes in this chord
-            int base_steps = (arp_length >= 0) ? arp_length : csize; // base notes to emit this cycle
+            // steps past the top of the chord go up an octave (+1V per full pass)
+            int32_t octave_root = root_cents + (s / csize) * 1200;
+            note_code[s] = CentsCode(0, octave_root + chords[chord][s % csize] * 100);
+            root_code[s] = CentsCode(1, octave_root);
+        }
+    }
+
+    uint32_t Rand()
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    }
+
+    void SpinRandomOuts()
+    {
+        // fold in the trigger time, so that runs differ from boot to boot
+        rng ^= samples;
+        if (rng == 0)
+            rng = 1;
 
-            // For UPUP and DOWNDOWN modes, double the total steps (each note played twice)
-            ArpMode mode = ui.getArpMode();
-            int total_steps;
-            if (mode == ARP_UPUP || mode == ARP_DOWNDOWN)
+        for (int i = 0; i < 2; i++)
+        {
+            uint32_t change_value = Rand();
+            if (coin_weight[i] < change_value)
             {
-                total_steps = base_steps * 2;
+                coin_weight[i] = UINT32_MAX;
+
+                // output a random semitone from 0v to 10/12v
+                int r = (uint64_t(Rand()) * 11) >> 32;
+                AudioOut(i, r * 256 / 9);
             }
-            else if (mode == ARP_UPDOWN_INC)
+            else
             {
-                total_steps = base_steps * 2;
+                // increase probability of changing next time
+                coin_weight[i] -= 0xfffffff;
             }
-            else if (mode == ARP_UPDOWN_EXC)
+        }
+    }
+
+    void NextNote()
+    {
+        int arp_length = GetArpLength();
+
+        // Determine chord size and the total length of this arpeggio cycle
+        int csize = chord_size(chords[chord]);                   // notes in this chord
+        int base_steps = (arp_length >= 0) ? arp_length : csize; // base notes to emit this cycle
+
+        // For UPUP and DOWNDOWN modes, double the total steps (each note played twice)
+        ArpMode mode = arp_mode;
+        int total_steps;
+        if (mode == ARP_UPUP || mode == ARP_DOWNDOWN)
+        {
+            total_steps = base_steps * 2;
+        }
+        else if (mode == ARP_UPDOWN_INC)
+        {
+            total_steps = base_steps * 2;
+        }
+        else if (mode == ARP_UPDOWN_EXC)
+        {
+            total_steps = (base_steps <= 1) ? 1 : (base_steps * 2 - 2);
+        }
+        else
+        {
+            total_steps = base_steps; // UP or DOWN
+        }
+
+        // End-of-arp condition
+        if (csize <= 0 || arp_count >= total_steps)
+        {
+            Arm(PULSE_2_END, TRIGGER_LENGTH - 1);
+            events |= 1 << EV_PULSE_OUTS;
+            chord_play = false;
+            return;
+        }
+
+        // set next note time and update root
+        note_start = samples;
+        UpdateRoot();
+
+        // step number within the full cycle according to current mode
+        int s;
+        int t = arp_count; // 0..total_steps-1 within a single cycle
+
+        switch (mode)
+        {
+        case ARP_UP:
+            s = t;
+            break;
+
+        case ARP_DOWN:
+            s = total_steps - 1 - t;
+            break;
+
+        case ARP_UPUP:
+            // 0,0,1,1,2,2 (ascending)
+            s = t / 2;
+            break;
+
+        case ARP_DOWNDOWN:
+            // ...3,3,2,2,1,1,0,0 (descending)
+            s = (base_steps - 1) - (t / 2);
+            break;
+
+        case ARP_UPDOWN_INC:
+            // Up then down, inclusive (peak is played twice)
+            // Sequence length = 2 * base_steps
+            // t: 0..base_steps-1 (up), base_steps..2*base_steps-1 (down incl endpoints)
+            if (t < base_steps)
             {
-                total_steps = (base_steps <= 1) ? 1 : (base_steps * 2 - 2);
+                s = t;
             }
             else
             {
-                total_steps = base_steps; // UP or DOWN
+                s = (2 * base_steps - 1) - t;
             }
+            break;
 
-            // End-of-arp condition
-            if (csize <= 0 || arp_count >= total_steps)
+        case ARP_UPDOWN_EXC:
+            // Up then down, exclusive (no double-count of endpoints)
+            // Sequence length = 2 * base_steps - 2  (unless base_steps <= 1 -> 1)
+            if (total_steps <= 1)
             {
-                computer.setTimedPulse(2, TRIGGER_LENGTH);
-                chord_play = false;
-                continue;
+                s = 0;
+            }
+            else if (t < base_steps)
+            {
+                s = t; // up 0..base_steps-1
             }
+            else
+            {
+                s = total_steps - t; // down base_steps-2 .. 1
+            }
+            break;
 
-            // set next note time and update UI
-            last_note_time = now;
-            ui.update();
+        default:
+            s = t; // safe fallback
+            break;
+        }
 
-            // step number within the full cycle according to current mode
-            int s;
-            int t = arp_count; // 0..total_steps-1 within a single cycle
+        // pitch for the step number, from the chord's voicing
+        Voice();
+        CVOutCode(0, note_code[s]);
+        CVOutCode(1, root_code[s]);
 
-            switch (mode)
-            {
-            case ARP_UP:
-                s = t;
-                break;
+        Arm(PULSE_1_END, TRIGGER_LENGTH - 1);
+        events |= 1 << EV_PULSE_OUTS;
 
-            case ARP_DOWN:
-                s = total_steps - 1 - t;
-                break;
+        // show step number (wrap across 6 LEDs) only if suppression time passed
+        if (!Armed(LED_SUPPRESS_END))
+        {
+            SetLEDs(1 << (s % 6));
+        }
 
-            case ARP_UPUP:
-                // 0,0,1,1,2,2 (ascending)
-                s = t / 2;
-                break;
+        // advance to next step in this cycle
+        arp_count++;
+    }
 
-            case ARP_DOWNDOWN:
-                // ...3,3,2,2,1,1,0,0 (descending)
-                s = (base_steps - 1) - (t / 2);
-                break;
+    void OnSwitch()
+    {
+        // switch
+        // up  = play full length of chord
+        // mid = limit number of notes
+        // down short press = toggle number of notes (existing)
+        // down long  press = toggle arp direction mode (new)
+        Switch switch_state = SwitchVal();
+
+        // Initialize prev state to current to avoid spurious edge handling on boot
+        if (!switch_started)
+        {
+            switch_started = true;
+            prev_switch_state = switch_state;
+        }
 
-            case ARP_UPDOWN_INC:
-                // Up then down, inclusive (peak is played twice)
-                // Sequence length = 2 * base_steps
-                // t: 0..base_steps-1 (up), base_steps..2*base_steps-1 (down incl endpoints)
-                if (t < base_steps)
-                {
-                    s = t;
-                }
-                else
+        if (switch_state != prev_switch_state)
+        {
+            // Leaving DOWN: resolve short vs long
+            if (prev_switch_state == Switch::Down)
+            {
+                if (down_pending_short && !down_long_consumed)
                 {
-                    s = (2 * base_steps - 1) - t;
+                    // SHORT PRESS (existing behavior)
+                    fix_length++;
+                    if (fix_length > 6)
+                    {
+                        fix_length = 1;
+                    }
+                    if (!Armed(LED_HOLD_END))
+                    {
+                        Arm(LED_SUPPRESS_END, LED_SUPPRESS);
+                        SetLEDs(0x3f >> (6 - fix_length));
+                    }
                 }
-                break;
+                // reset DOWN press state
+                down_pending_short = false;
+                down_long_consumed = false;
+                Disarm(LONG_PRESS);
+            }
 
-            case ARP_UPDOWN_EXC:
-                // Up then down, exclusive (no double-count of endpoints)
-                // Sequence length = 2 * base_steps - 2  (unless base_steps <= 1 -> 1)
-                if (total_steps <= 1)
-                {
-                    s = 0;
-                }
-                else if (t < base_steps)
+            // Entering new state
+            if (switch_state == Switch::Down)
+            {
+                Arm(LONG_PRESS, LONGPRESS - 1);
+                down_pending_short = true;
+                down_long_consumed = false;
+                // do not change LEDs yet; we decide after timing
+            }
+            else if (switch_state == Switch::Middle)
+            {
+                // existing behavior: MID means fixed-length ON
+                fix_length_on = true;
+                if (!Armed(LED_HOLD_END))
                 {
-                    s = t; // up 0..base_steps-1
+                    Arm(LED_SUPPRESS_END, LED_SUPPRESS);
+                    SetLEDs(0x3f >> (6 - fix_length));
                 }
-                else
+            }
+            else
+            { // UP
+                // existing behavior: full-length mode (fixed-length OFF)
+                fix_length_on = false;
+                if (!Armed(LED_HOLD_END))
                 {
-                    s = total_steps - t; // down base_steps-2 .. 1
+                    Disarm(LED_SUPPRESS_END);
                 }
-                break;
-
-            default:
-                s = t; // safe fallback
-                break;
-            }
-
-            // derive pitch from step number: base degree and octave shift
-            int base_idx = (csize > 0) ? (s % csize) : 0;
-            int octave_shift = (csize > 0) ? (s / csize) : 0; // 0 for first pass, 1 for second, etc.
-            chord_note = base_idx;                            // same degree mapping for all modes; direction is encoded in s
-
-            float chord_root_volts = ui.getRootVolts();
-            if (octave_shift > 0)
-            {
-                chord_root_volts += (float)octave_shift; // +1V per full pass
             }
 
-            float chord_note_volts = chord_root_volts + ((float)chords[chord][chord_note] * VOLT_SEMITONE);
-            computer.setCVOutVolts(1, chord_note_volts);
-            computer.setCVOutVolts(2, chord_root_volts);
-
-            computer.setTimedPulse(1, TRIGGER_LENGTH);
+            prev_switch_state = switch_state;
+        }
+    }
 
-            // show step number (wrap across 6 LEDs) only if suppression time passed
-            if ((now - ui.last_switch_change) >= UI::LED_SUPPRESS_MS)
+    // Switch held in DOWN since LONGPRESS ago
+    void OnLongPress()
+    {
+        if (prev_switch_state == Switch::Down && down_pending_short && !down_long_consumed)
+        {
+            // LONG PRESS: cycle through arp direction modes (6 modes)
+            arp_mode = (ArpMode)((arp_mode + 1) % 6);
+            events |= 1 << EV_MODE_CHANGE; // restart the cycle in the new mode
+            down_long_consumed = true;
+            down_pending_short = false; // suppress short press action
+
+            // Brief LED hint so user sees the change
+            // Different LED patterns for each mode
+            uint8_t led_pattern;
+            switch (arp_mode)
             {
-                int led_index = (total_steps > 0) ? (s % 6) : 0;
-                computer.setLEDs(1 << led_index);
+            case ARP_UP:
+                led_pattern = 0b000001;
+                break; // rightmost
+            case ARP_DOWN:
+                led_pattern = 0b100000;
+                break; // leftmost
+            case ARP_UPUP:
+                led_pattern = 0b000011;
+                break; // two rightmost
+            case ARP_DOWNDOWN:
+                led_pattern = 0b110000;
+                break; // two leftmost
+            case ARP_UPDOWN_INC:
+                led_pattern = 0b010010;
+                break; // symmetric middle hint
+            case ARP_UPDOWN_EXC:
+                led_pattern = 0b001100;
+                break; // adjacent middle hint
+            default:
+                led_pattern = 0b000001;
+                break;
             }
-
-            // advance to next step in this cycle
-            arp_count++;
+            SetLEDs(led_pattern);
+            // Start LED hold so this hint remains visible; step LEDs are suppressed during hold
+            Arm(LED_HOLD_END, LED_SUPPRESS);
+            Arm(LED_SUPPRESS_END, LED_SUPPRESS);
         }
     }
+};
 
-    return 0;
+int main()
+{
+    static ChordBlimey cb;
+    cb.EnableCVOutputDMA();
+    cb.EnableLowPower(96000);
+    cb.Run();
 }
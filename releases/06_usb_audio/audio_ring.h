@@ -0,0 +1,136 @@
+/*
+ * Rings of audio frames between the USB handlers (core0) and the sample interrupt (core1)
+ *
+ * Single producer, single consumer, lock-free: only the producer writes `write` and only the
+ * consumer writes `read`, so neither side ever waits for the other.
+ * - playback_ring: USB OUT packets -> DAC and CV outs. The USB handler unpacks each packet, in
+ *   whichever format the host chose, into PLAYBACK_FRAME_WORDS signed 18-bit samples per frame
+ *   (left, right, CV 1, CV 2), at the host's sample rate; the sample interrupt resamples them to 48kHz.
+ * - capture_ring: ADC -> USB IN packets, the other way round, one word per frame packed as it goes
+ *   over USB, left in the low 16 bits and right in the high 16 bits.
+ *
+ * Both directions steer their fill level towards AUDIO_RING_TARGET: playback through the
+ * asynchronous feedback endpoint, which asks the host for slightly more or fewer samples per
+ * USB frame, and capture by sending a sample more or fewer per packet.
+ */
+
+#ifndef _AUDIO_RING_H
+#define _AUDIO_RING_H
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_RING_FRAMES 512u                    // 10.7ms at 48kHz, power of two
+#define AUDIO_RING_TARGET (AUDIO_RING_FRAMES / 2) // Fill level at which playback starts, and is steered towards
+#define PLAYBACK_FRAME_WORDS 4u
+#define CAPTURE_FRAME_WORDS 1u
+
+struct audio_ring {
+    uint32_t *frames;             // AUDIO_RING_FRAMES * words
+    uint32_t words;               // Words per frame
+    volatile uint32_t write;      // Frames written, ever (producer)
+    volatile uint32_t read;       // Frames read, ever (consumer)
+    volatile uint32_t overruns;   // Writes that didn't fit in full (producer)
+    volatile uint32_t underruns;  // Reads that found too few frames (consumer)
+};
+
+extern struct audio_ring playback_ring;
+extern struct audio_ring capture_ring;
+
+static inline uint32_t audio_ring_fill(const struct audio_ring *r) {
+    return r->write - r->read;
+}
+
+// Producer: append n frames, dropping any that don't fit. Returns the number written
+static inline uint32_t audio_ring_write(struct audio_ring *r, const void *data, uint32_t n) {
+    uint32_t w = r->write;
+    uint32_t space = AUDIO_RING_FRAMES - (w - r->read);
+    if (n > space) {
+        r->overruns = r->overruns + 1;
+        n = space;
+    }
+
+    // In at most two pieces, either side of the end of the ring
+    uint32_t start = w & (AUDIO_RING_FRAMES - 1);
+    uint32_t first = AUDIO_RING_FRAMES - start;
+    if (first > n) first = n;
+    uint32_t bytes = r->words * sizeof(uint32_t);
+    memcpy(&r->frames[start * r->words], data, first * bytes);
+    memcpy(&r->frames[0], (const uint8_t *) data + first * bytes, (n - first) * bytes);
+
+    __dmb(); // Frames land before the write index that publishes them
+    r->write = w + n;
+    return n;
+}
+
+// Producer, in place: up to n free frames from the write index on, without wrapping, to fill and
+// then publish with audio_ring_commit. Sets *frames to the first of them and returns how many there are
+static inline uint32_t audio_ring_reserve(struct audio_ring *r, uint32_t **frames, uint32_t n) {
+    uint32_t w = r->write;
+    uint32_t space = AUDIO_RING_FRAMES - (w - r->read);
+    uint32_t start = w & (AUDIO_RING_FRAMES - 1);
+    if (n > space) n = space;
+    if (n > AUDIO_RING_FRAMES - start) n = AUDIO_RING_FRAMES - start;
+    *frames = &r->frames[start * r->words];
+    return n;
+}
+
+// Producer, in place: publish n frames filled after audio_ring_reserve
+static inline void audio_ring_commit(struct audio_ring *r, uint32_t n) {
+    __dmb(); // Frames land before the write index that publishes them
+    r->write = r->write + n;
+}
+
+// Consumer: take the oldest frame (r->words words). Returns false, leaving frame alone, if the ring is empty
+static inline bool audio_ring_read(struct audio_ring *r, uint32_t *frame) {
+    uint32_t rd = r->read;
+    if (rd == r->write) {
+        r->underruns = r->underruns + 1;
+        return false;
+    }
+    __dmb(); // See the write index before the frames it publishes
+    const uint32_t *f = &r->frames[(rd & (AUDIO_RING_FRAMES - 1)) * r->words];
+    for (uint32_t i = 0; i < r->words; i++) frame[i] = f[i];
+    __dmb(); // Finish with the frame before handing its slot back
+    r->read = rd + 1;
+    return true;
+}
+
+// Consumer: take up to n of the oldest frames. Returns the number read
+static inline uint32_t audio_ring_read_block(struct audio_ring *r, void *data, uint32_t n) {
+    uint32_t rd = r->read;
+    uint32_t fill = r->write - rd;
+    if (n > fill) {
+        r->underruns = r->underruns + 1;
+        n = fill;
+    }
+    __dmb(); // See the write index before the frames it publishes
+
+    uint32_t start = rd & (AUDIO_RING_FRAMES - 1);
+    uint32_t first = AUDIO_RING_FRAMES - start;
+    if (first > n) first = n;
+    uint32_t bytes = r->words * sizeof(uint32_t);
+    memcpy(data, &r->frames[start * r->words], first * bytes);
+    memcpy((uint8_t *) data + first * bytes, &r->frames[0], (n - first) * bytes);
+
+    __dmb(); // Finish with the frames before handing their slots back
+    r->read = rd + n;
+    return n;
+}
+
+// Consumer: drop the oldest frames until at most n are left
+static inline void audio_ring_trim(struct audio_ring *r, uint32_t n) {
+    uint32_t fill = audio_ring_fill(r);
+    if (fill > n) r->read = r->read + (fill - n);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Output mixer, run by the sample interrupt on core1: host playback plus the audio inputs
+ * (direct monitoring), so the inputs can be heard with no more latency than a sample, rather
+ * than the several milliseconds of a round trip through the host.
+ *
+ * All the gains, from the knobs and the host's volume and mute controls, are worked out once
+ * per MIXER_BLOCK samples by mixer_update, leaving two multiplies per channel per sample.
+ * Playback comes in as signed 18-bit samples, the inputs as signed 12-bit ones, and the mix
+ * goes out as signed 12-bit samples, not yet clipped.
+ */
+
+#ifndef _MIXER_H
+#define _MIXER_H
+
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MIXER_BLOCK 48u // 1ms at 48kHz
+
+struct mixer {
+    int32_t play_gain[2];    // Playback to out L/R, 1024 = 0dB (18-bit in, 12-bit out)
+    int32_t monitor_gain[2]; // Input L/R to out L/R, 4096 = 0dB
+    uint32_t count;          // Samples until the next update
+};
+
+// Gains for out L/R from a balance control, 0-4095: both 4096 in the middle, one falling to 0 either side
+static inline void mixer_balance(int32_t balance, int32_t gains[2]) {
+    gains[0] = balance <= 2048 ? 4096 : (4095 - balance) * 2;
+    gains[1] = balance >= 2048 ? 4096 : balance * 2;
+}
+
+// Recalculate the gains, once per block. Knobs are 0-4095; host_volume is Q15, 0 when muted
+static inline void mixer_update(struct mixer *m, int32_t volume, int32_t monitor, int32_t balance,
+                                int32_t host_volume) {
+    // Squared knobs: volume 0dB at 12 o'clock, up to +12dB; monitoring up to 0dB
+    int32_t play = (((volume * volume) >> 12) * host_volume) >> 15;
+    int32_t mon = (monitor * monitor) >> 12;
+    int32_t pan[2];
+    mixer_balance(balance, pan);
+    for (int c = 0; c < 2; c++) {
+        m->play_gain[c] = (play * pan[c]) >> 12;
+        m->monitor_gain[c] = (mon * pan[c]) >> 12;
+    }
+}
+
+// True once every MIXER_BLOCK calls, one per sample, when the gains are due an update
+static inline bool mixer_block_start(struct mixer *m) {
+    if (m->count) {
+        m->count--;
+        return false;
+    }
+    m->count = MIXER_BLOCK - 1;
+    return true;
+}
+
+// Mix of one 48kHz frame
+static inline void mixer_process(struct mixer *m, const int32_t play[2], const int32_t in[2], int32_t out[2]) {
+    for (int c = 0; c < 2; c++)
+        out[c] = ((play[c] * m->play_gain[c]) >> 16) + ((in[c] * m->monitor_gain[c]) >> 12);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
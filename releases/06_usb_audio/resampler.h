@@ -0,0 +1,107 @@
+/*
+ * Polyphase resampler from the host's playback rate to the card's 48kHz, run by the sample interrupt
+ * on core1
+ *
+ * Each 48kHz output frame is an 8-tap FIR of the input frames around it, with the taps taken from
+ * one of 32 phases of a Hann-windowed sinc according to where the output falls between two inputs.
+ * The sinc is cut off at 90% of the lower of the two Nyquist frequencies, so 96kHz streams are
+ * band-limited before being decimated. Each phase is normalised to unity gain, so CV streams
+ * keep their DC levels exactly. At 48kHz the frames are passed straight through.
+ *
+ * Samples are signed 18-bit and taps Q13, so the sums fit in 32 bits.
+ */
+
+#ifndef _RESAMPLER_H
+#define _RESAMPLER_H
+
+#include <math.h>
+#include "pico/stdlib.h"
+#include "audio_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESAMPLER_TAPS 8
+#define RESAMPLER_PHASE_BITS 5
+#define RESAMPLER_PHASES (1 << RESAMPLER_PHASE_BITS)
+#define RESAMPLER_OUT_FREQ 48000u
+
+typedef int16_t resampler_taps[RESAMPLER_PHASES][RESAMPLER_TAPS];
+
+struct resampler {
+    resampler_taps taps_44k1, taps_96k;
+    const int16_t (*taps)[RESAMPLER_TAPS]; // For the current rate, NULL to pass through
+    uint32_t freq;                         // Input rate
+    uint32_t step;                         // Input frames per output frame, 16.16
+    uint32_t pos;                          // Position of the next output after hist[RESAMPLER_TAPS/2 - 1], 16.16
+    int32_t hist[PLAYBACK_FRAME_WORDS][2 * RESAMPLER_TAPS]; // Last RESAMPLER_TAPS inputs, twice over
+    uint8_t head;                          // Oldest input in hist
+};
+
+// Windowed sinc for input rate freq, each phase summing to exactly 1.0
+static void resampler_design(resampler_taps taps, uint32_t freq) {
+    float fc = 0.9f * (freq > RESAMPLER_OUT_FREQ ? (float) RESAMPLER_OUT_FREQ / freq : 1.0f);
+    for (int p = 0; p < RESAMPLER_PHASES; p++) {
+        float mu = (float) p / RESAMPLER_PHASES;
+        float h[RESAMPLER_TAPS], sum = 0;
+        for (int k = 0; k < RESAMPLER_TAPS; k++) {
+            float x = k - (RESAMPLER_TAPS / 2 - 1) - mu;
+            float t = (float) M_PI * fc * x;
+            float sinc = (t == 0) ? 1.0f : sinf(t) / t;
+            h[k] = sinc * (0.5f + 0.5f * cosf((float) M_PI * x / (RESAMPLER_TAPS / 2)));
+            sum += h[k];
+        }
+        int32_t total = 0;
+        for (int k = 0; k < RESAMPLER_TAPS; k++) {
+            taps[p][k] = (int16_t) lroundf(h[k] * 8192.0f / sum);
+            total += taps[p][k];
+        }
+        taps[p][RESAMPLER_TAPS / 2 - 1] += 8192 - total; // Rounding left over goes on the nearest tap
+    }
+}
+
+static void resampler_set_rate(struct resampler *rs, uint32_t freq) {
+    rs->freq = freq;
+    rs->taps = (freq == 44100) ? rs->taps_44k1 : (freq == 96000) ? rs->taps_96k : NULL;
+    rs->step = (freq << 16) / RESAMPLER_OUT_FREQ;
+    rs->pos = 0;
+}
+
+static void resampler_init(struct resampler *rs, uint32_t freq) {
+    resampler_design(rs->taps_44k1, 44100);
+    resampler_design(rs->taps_96k, 96000);
+    resampler_set_rate(rs, freq);
+}
+
+// Next 48kHz output frame, from the ring. Returns false, leaving out alone, if the ring ran dry
+static inline bool resampler_next(struct resampler *rs, struct audio_ring *r, int32_t out[PLAYBACK_FRAME_WORDS]) {
+    if (!rs->taps) return audio_ring_read(r, (uint32_t *) out);
+
+    // Bring in the inputs up to this output
+    while (rs->pos >= (1u << 16)) {
+        uint32_t frame[PLAYBACK_FRAME_WORDS];
+        if (!audio_ring_read(r, frame)) return false;
+        uint32_t h = rs->head;
+        for (uint32_t c = 0; c < PLAYBACK_FRAME_WORDS; c++)
+            rs->hist[c][h] = rs->hist[c][h + RESAMPLER_TAPS] = (int32_t) frame[c];
+        rs->head = (h + 1) & (RESAMPLER_TAPS - 1);
+        rs->pos -= 1u << 16;
+    }
+
+    const int16_t *taps = rs->taps[rs->pos >> (16 - RESAMPLER_PHASE_BITS)];
+    for (uint32_t c = 0; c < PLAYBACK_FRAME_WORDS; c++) {
+        const int32_t *x = &rs->hist[c][rs->head];
+        int32_t acc = 1 << 12;
+        for (int k = 0; k < RESAMPLER_TAPS; k++) acc += taps[k] * x[k];
+        out[c] = acc >> 13;
+    }
+    rs->pos += rs->step;
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,7 +1,33 @@
 #include "usb_audio.h"
+#include "audio_ring.h"
 #include "pico/multicore.h"
 #include "pico/stdlib.h"
 
+static uint32_t playback_frames[AUDIO_RING_FRAMES * PLAYBACK_FRAME_WORDS];
+static uint32_t capture_frames[AUDIO_RING_FRAMES * CAPTURE_FRAME_WORDS];
+struct audio_ring playback_ring = {.frames = playback_frames, .words = PLAYBACK_FRAME_WORDS};
+struct audio_ring capture_ring = {.frames = capture_frames, .words = CAPTURE_FRAME_WORDS};
+
+volatile uint32_t playback_freq = 48000;
+volatile uint8_t playback_format = PLAYBACK_OFF;
+volatile int16_t playback_volume = 0x7fff;
+
+// Ring fill level seen after each audio packet, smoothed over ~8 packets, in frames * 256
+static uint32_t ring_fill_avg = AUDIO_RING_TARGET << 8;
+
+// Feedback steering: ring error in frames, shifted up by this much, is added to the 10.14 feedback
+// value, so 256 frames adrift asks for one sample per USB frame more or less...
+#define FEEDBACK_GAIN_SHIFT 6
+// ...up to at most half a sample per USB frame, a ~1% rate change at 48kHz
+#define FEEDBACK_MAX_CORRECTION (1 << 13)
+
+// Capture sends a sample more (or fewer) than nominal in a packet while the ring is this far
+// above (or below) its target
+#define CAPTURE_SLACK 16
+
+// Capture sends silence until the ring has filled to its target, at startup and after running dry
+static bool capture_priming = true;
+
 const char *_get_descriptor_string(uint index) {
 	 char *descriptor_strings[] =
          {
@@ -16,21 +42,58 @@ const char *_get_descriptor_string(uint index) {
     }
 }
 
+// Little-endian 24-bit sample to signed 18-bit
+static inline int32_t _s24_to_s18(const uint8_t *p) {
+    return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 14;
+}
+
+// Unpacks n frames of a playback packet into 18-bit left/right/CV frames
+static inline void _unpack_frames(uint32_t *out, const uint8_t *in, uint32_t n, uint8_t format, uint8_t bytes) {
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t *f = (int32_t *) &out[i * PLAYBACK_FRAME_WORDS];
+        if (format == PLAYBACK_16_STEREO) {
+            f[0] = (int16_t)(in[0] | (in[1] << 8)) * 4;
+            f[1] = (int16_t)(in[2] | (in[3] << 8)) * 4;
+            f[2] = f[3] = 0;
+        } else {
+            f[0] = _s24_to_s18(in);
+            f[1] = _s24_to_s18(in + 3);
+            f[2] = (format == PLAYBACK_24_CV) ? _s24_to_s18(in + 6) : 0;
+            f[3] = (format == PLAYBACK_24_CV) ? _s24_to_s18(in + 9) : 0;
+        }
+        in += bytes;
+    }
+}
+
 void _as_audio_packet(struct usb_endpoint *ep){
+    // The packet is read where the hardware put it, in the endpoint's DPRAM buffer; the endpoint
+    // is double-buffered, so the next packet lands in the other buffer meanwhile
 	struct usb_buffer *usb_buffer = usb_current_packet_buffer(ep);
-    uint16_t nsamps = (usb_buffer->data_len)>>2;
-    uint16_t vol_mul = audio_state.vol_mul;
-    int16_t *in = (int16_t *) usb_buffer->data;
-    int16_t outL;
-    int16_t outR;
-	
-    for (int i = 0; i < nsamps; i++) {
-        outL = *in;
-        in++;
-        outR = *(in);
-        in++;
-        multicore_fifo_push_blocking((((uint32_t)(outL))&0x0000FFFF) | ((((uint32_t)outR)&0x0000FFFF)<<16));
+    static const uint8_t frame_bytes[PLAYBACK_FORMATS] = {
+            [PLAYBACK_16_STEREO] = 4, [PLAYBACK_24_STEREO] = 6, [PLAYBACK_24_CV] = 12,
+    };
+    uint8_t format = playback_format;
+    const uint8_t *in = usb_buffer->data;
+    uint32_t n = frame_bytes[format] ? usb_buffer->data_len / frame_bytes[format] : 0;
+
+    // Unpack straight into the ring's free frames, in at most two pieces either side of its end,
+    // without waiting on core1
+    for (uint32_t done = 0; done < n;) {
+        uint32_t *frames;
+        uint32_t k = audio_ring_reserve(&playback_ring, &frames, n - done);
+        if (!k) {
+            playback_ring.overruns = playback_ring.overruns + 1;
+            break;
+        }
+        _unpack_frames(frames, in, k, format, frame_bytes[format]);
+        audio_ring_commit(&playback_ring, k);
+        in += k * frame_bytes[format];
+        done += k;
     }
+
+    uint32_t fill = audio_ring_fill(&playback_ring) << 8;
+    ring_fill_avg = ring_fill_avg + ((int32_t)(fill - ring_fill_avg) >> 3);
+
     usb_grow_transfer(ep->current_transfer, 1);
     usb_packet_done(ep);
 
@@ -42,8 +105,12 @@ void _as_sync_packet(struct usb_endpoint *ep){
     assert(buffer->data_max >= 3);
     buffer->data_len = 3;
 
-    // todo lie thru our teeth for now
+    // Nominal samples per USB frame in 10.14, nudged to keep the ring near its target fill
     uint feedback = (audio_state.freq << 14u) / 1000u;
+    int32_t correction = ((int32_t)(AUDIO_RING_TARGET << 8) - (int32_t)ring_fill_avg) >> (8 - FEEDBACK_GAIN_SHIFT);
+    if (correction > FEEDBACK_MAX_CORRECTION) correction = FEEDBACK_MAX_CORRECTION;
+    if (correction < -FEEDBACK_MAX_CORRECTION) correction = -FEEDBACK_MAX_CORRECTION;
+    feedback += correction;
 
     buffer->data[0] = feedback;
     buffer->data[1] = feedback >> 8u;
@@ -54,6 +121,36 @@ void _as_sync_packet(struct usb_endpoint *ep){
     usb_packet_done(ep);
 }
 
+void _as_capture_packet(struct usb_endpoint *ep){
+    struct usb_buffer *buffer = usb_current_in_packet_buffer(ep);
+    uint32_t n = AUDIO_FREQ_HW / 1000u; // the inputs are always sampled at 48kHz
+    uint32_t fill = audio_ring_fill(&capture_ring);
+
+    if (capture_priming && fill >= AUDIO_RING_TARGET) {
+        // Start from the target fill, dropping anything queued up while the host wasn't listening
+        audio_ring_trim(&capture_ring, AUDIO_RING_TARGET);
+        capture_priming = false;
+    }
+
+    if (capture_priming) {
+        memset(buffer->data, 0, n * 4);
+    } else {
+        // Asynchronous source: the packet size follows the card's sample clock
+        if (fill > AUDIO_RING_TARGET + CAPTURE_SLACK) n++;
+        else if (fill + CAPTURE_SLACK < AUDIO_RING_TARGET) n--;
+        uint32_t got = audio_ring_read_block(&capture_ring, buffer->data, n);
+        if (got < n) {
+            memset(buffer->data + got * 4, 0, (n - got) * 4);
+            capture_priming = true;
+        }
+    }
+    assert(buffer->data_max >= n * 4);
+    buffer->data_len = n * 4;
+
+    usb_grow_transfer(ep->current_transfer, 1);
+    usb_packet_done(ep);
+}
+
 bool do_get_current(struct usb_setup_packet *setup) {
     usb_debug("AUDIO_REQ_GET_CUR\n");
 
@@ -123,9 +220,13 @@ void _audio_reconfigure() {
         case 44100:
         case 48000:
             break;
+        case 96000:
+            if (playback_format != PLAYBACK_24_CV) break;
+            // fall through
         default:
             audio_state.freq = 48000;
     }
+    playback_freq = audio_state.freq;
 }
 
 void audio_set_volume(int16_t volume) {
@@ -136,6 +237,7 @@ void audio_set_volume(int16_t volume) {
     if (volume >= count_of(db_to_vol) * 256) volume = count_of(db_to_vol) * 256 - 1;
     audio_state.vol_mul = db_to_vol[((uint16_t)volume) >> 8u];
 //    printf("VOL MUL %04x\n", audio_state.vol_mul);
+    playback_volume = audio_state.mute ? 0 : audio_state.vol_mul;
 }
 
 void audio_cmd_packet(struct usb_endpoint *ep) {
@@ -147,6 +249,7 @@ void audio_cmd_packet(struct usb_endpoint *ep) {
             switch (audio_control_cmd_t.cs) {
                 case FEATURE_MUTE_CONTROL: {
                     audio_state.mute = buffer->data[0];
+                    playback_volume = audio_state.mute ? 0 : audio_state.vol_mul;
                      break;
                 }
                 case FEATURE_VOLUME_CONTROL: {
@@ -172,6 +275,15 @@ void audio_cmd_packet(struct usb_endpoint *ep) {
 bool as_set_alternate(struct usb_interface *interface, uint alt) {
     //assert(interface == &as_op_interface);
     //usb_warn("SET ALTERNATE %d\n", alt);
+    if (alt >= PLAYBACK_FORMATS) return false;
+    playback_format = alt;
+    _audio_reconfigure();
+    return true;
+}
+
+bool capture_set_alternate(__unused struct usb_interface *interface, uint alt) {
+    // Start each stream from a freshly primed ring
+    if (alt == 1) capture_priming = true;
     return alt < 2;
 }
 
@@ -252,7 +364,7 @@ void usb_sound_card_init() {
                 .bLength             = sizeof(audio_device_config.descriptor),
                 .bDescriptorType     = DTYPE_Configuration,
                 .wTotalLength        = sizeof(audio_device_config),
-                .bNumInterfaces      = 2,
+                .bNumInterfaces      = 3,
                 .bConfigurationValue = 0x01,
                 .iConfiguration      = 0x00,
                 .bmAttributes        = 0x80,
@@ -271,14 +383,15 @@ void usb_sound_card_init() {
         },
         .ac_audio = {
                 .core = {
-                        .bLength = sizeof(audio_device_config.ac_audio.core),
+                        .bLength = sizeof(audio_device_config.ac_audio.core) + sizeof(audio_device_config.ac_audio.capture_interface_number),
                         .bDescriptorType = AUDIO_DTYPE_CSInterface,
                         .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_Header,
                         .bcdADC = VERSION_BCD(1, 0, 0),
                         .wTotalLength = sizeof(audio_device_config.ac_audio),
-                        .bInCollection = 1,
+                        .bInCollection = 2,
                         .bInterfaceNumbers = 1,
                 },
+                .capture_interface_number = 2,
                 .input_terminal = {
                         .bLength = sizeof(audio_device_config.ac_audio.input_terminal),
                         .bDescriptorType = AUDIO_DTYPE_CSInterface,
@@ -311,6 +424,50 @@ void usb_sound_card_init() {
                         .bSourceID = 2,
                         .iTerminal = 0,
                 },
+                .capture_input_terminal = {
+                        .bLength = sizeof(audio_device_config.ac_audio.capture_input_terminal),
+                        .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_InputTerminal,
+                        .bTerminalID = 4,
+                        .wTerminalType = AUDIO_TERMINAL_EXTERNAL_LINE,
+                        .bAssocTerminal = 0,
+                        .bNrChannels = 2,
+                        .wChannelConfig = AUDIO_CHANNEL_LEFT_FRONT | AUDIO_CHANNEL_RIGHT_FRONT,
+                        .iChannelNames = 0,
+                        .iTerminal = 0,
+                },
+                .capture_output_terminal = {
+                        .bLength = sizeof(audio_device_config.ac_audio.capture_output_terminal),
+                        .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_OutputTerminal,
+                        .bTerminalID = 5,
+                        .wTerminalType = AUDIO_TERMINAL_STREAMING,
+                        .bAssocTerminal = 0,
+                        .bSourceID = 4,
+                        .iTerminal = 0,
+                },
+                .cv_input_terminal = {
+                        .bLength = sizeof(audio_device_config.ac_audio.cv_input_terminal),
+                        .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_InputTerminal,
+                        .bTerminalID = 6,
+                        .wTerminalType = AUDIO_TERMINAL_STREAMING,
+                        .bAssocTerminal = 0,
+                        .bNrChannels = 4, // left, right and two unlabelled CV channels
+                        .wChannelConfig = AUDIO_CHANNEL_LEFT_FRONT | AUDIO_CHANNEL_RIGHT_FRONT,
+                        .iChannelNames = 0,
+                        .iTerminal = 0,
+                },
+                .cv_output_terminal = {
+                        .bLength = sizeof(audio_device_config.ac_audio.cv_output_terminal),
+                        .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_OutputTerminal,
+                        .bTerminalID = 7,
+                        .wTerminalType = AUDIO_TERMINAL_IN_OUT_UNDEFINED,
+                        .bAssocTerminal = 0,
+                        .bSourceID = 6,
+                        .iTerminal = 0,
+                },
         },
         .as_zero_interface = {
                 .bLength            = sizeof(audio_device_config.as_zero_interface),
@@ -355,8 +512,9 @@ void usb_sound_card_init() {
                                 .bSampleFrequencyType = count_of(audio_device_config.as_audio.format.freqs),
                         },
                         .freqs = {
-//                                AUDIO_SAMPLE_FREQ(44100),
-                                AUDIO_SAMPLE_FREQ(48000)
+                                AUDIO_SAMPLE_FREQ(44100),
+                                AUDIO_SAMPLE_FREQ(48000),
+                                AUDIO_SAMPLE_FREQ(96000)
                         },
                 },
         },
@@ -366,7 +524,7 @@ void usb_sound_card_init() {
                         .bDescriptorType  = DTYPE_Endpoint,
                         .bEndpointAddress = AUDIO_OUT_ENDPOINT,
                         .bmAttributes     = 5,
-                        .wMaxPacketSize   = AUDIO_MAX_PACKET_SIZE(AUDIO_FREQ_MAX),
+                        .wMaxPacketSize   = AUDIO_MAX_PACKET_SIZE(AUDIO_FREQ_MAX, 4),
                         .bInterval        = 1,
                         .bRefresh         = 0,
                         .bSyncAddr        = AUDIO_IN_ENDPOINT,
@@ -390,7 +548,210 @@ void usb_sound_card_init() {
                 .bRefresh         = 2,
                 .bSyncAddr        = 0,
         },
+        .as_24_interface = {
+                .bLength            = sizeof(audio_device_config.as_24_interface),
+                .bDescriptorType    = DTYPE_Interface,
+                .bInterfaceNumber   = 0x01,
+                .bAlternateSetting  = 0x02,
+                .bNumEndpoints      = 0x02,
+                .bInterfaceClass    = AUDIO_CSCP_AudioClass,
+                .bInterfaceSubClass = AUDIO_CSCP_AudioStreamingSubclass,
+                .bInterfaceProtocol = AUDIO_CSCP_ControlProtocol,
+                .iInterface         = 0x00,
+        },
+        .as_24_audio = {
+                .streaming = {
+                        .bLength = sizeof(audio_device_config.as_24_audio.streaming),
+                        .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_General,
+                        .bTerminalLink = 1,
+                        .bDelay = 1,
+                        .wFormatTag = 1, // PCM
+                },
+                .format = {
+                        .core = {
+                                .bLength = sizeof(audio_device_config.as_24_audio.format),
+                                .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                                .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_FormatType,
+                                .bFormatType = 1,
+                                .bNrChannels = 2,
+                                .bSubFrameSize = 3,
+                                .bBitResolution = 24,
+                                .bSampleFrequencyType = count_of(audio_device_config.as_24_audio.format.freqs),
+                        },
+                        .freqs = {
+                                AUDIO_SAMPLE_FREQ(44100),
+                                AUDIO_SAMPLE_FREQ(48000),
+                                AUDIO_SAMPLE_FREQ(96000)
+                        },
+                },
+        },
+        .ep1_24 = {
+                .core = {
+                        .bLength          = sizeof(audio_device_config.ep1_24.core),
+                        .bDescriptorType  = DTYPE_Endpoint,
+                        .bEndpointAddress = AUDIO_OUT_ENDPOINT,
+                        .bmAttributes     = 5,
+                        .wMaxPacketSize   = AUDIO_MAX_PACKET_SIZE(AUDIO_FREQ_MAX, 6),
+                        .bInterval        = 1,
+                        .bRefresh         = 0,
+                        .bSyncAddr        = AUDIO_IN_ENDPOINT,
+                },
+                .audio = {
+                        .bLength = sizeof(audio_device_config.ep1_24.audio),
+                        .bDescriptorType = AUDIO_DTYPE_CSEndpoint,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSEndpoint_General,
+                        .bmAttributes = 1,
+                        .bLockDelayUnits = 0,
+                        .wLockDelay = 0,
+                }
+        },
+        .ep2_24 = {
+                .bLength          = sizeof(audio_device_config.ep2_24),
+                .bDescriptorType  = 0x05,
+                .bEndpointAddress = AUDIO_IN_ENDPOINT,
+                .bmAttributes     = 0x11,
+                .wMaxPacketSize   = 3,
+                .bInterval        = 0x01,
+                .bRefresh         = 2,
+                .bSyncAddr        = 0,
+        },
+        .as_cv_interface = {
+                .bLength            = sizeof(audio_device_config.as_cv_interface),
+                .bDescriptorType    = DTYPE_Interface,
+                .bInterfaceNumber   = 0x01,
+                .bAlternateSetting  = 0x03,
+                .bNumEndpoints      = 0x02,
+                .bInterfaceClass    = AUDIO_CSCP_AudioClass,
+                .bInterfaceSubClass = AUDIO_CSCP_AudioStreamingSubclass,
+                .bInterfaceProtocol = AUDIO_CSCP_ControlProtocol,
+                .iInterface         = 0x00,
+        },
+        .as_cv_audio = {
+                .streaming = {
+                        .bLength = sizeof(audio_device_config.as_cv_audio.streaming),
+                        .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_General,
+                        .bTerminalLink = 6,
+                        .bDelay = 1,
+                        .wFormatTag = 1, // PCM
+                },
+                .format = {
+                        .core = {
+                                .bLength = sizeof(audio_device_config.as_cv_audio.format),
+                                .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                                .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_FormatType,
+                                .bFormatType = 1,
+                                .bNrChannels = 4,
+                                .bSubFrameSize = 3,
+                                .bBitResolution = 24,
+                                .bSampleFrequencyType = count_of(audio_device_config.as_cv_audio.format.freqs),
+                        },
+                        .freqs = {
+                                AUDIO_SAMPLE_FREQ(44100),
+                                AUDIO_SAMPLE_FREQ(48000)
+                        },
+                },
+        },
+        .ep1_cv = {
+                .core = {
+                        .bLength          = sizeof(audio_device_config.ep1_cv.core),
+                        .bDescriptorType  = DTYPE_Endpoint,
+                        .bEndpointAddress = AUDIO_OUT_ENDPOINT,
+                        .bmAttributes     = 5,
+                        .wMaxPacketSize   = AUDIO_MAX_PACKET_SIZE(PLAYBACK_CV_FREQ_MAX, 12),
+                        .bInterval        = 1,
+                        .bRefresh         = 0,
+                        .bSyncAddr        = AUDIO_IN_ENDPOINT,
+                },
+                .audio = {
+                        .bLength = sizeof(audio_device_config.ep1_cv.audio),
+                        .bDescriptorType = AUDIO_DTYPE_CSEndpoint,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSEndpoint_General,
+                        .bmAttributes = 1,
+                        .bLockDelayUnits = 0,
+                        .wLockDelay = 0,
+                }
+        },
+        .ep2_cv = {
+                .bLength          = sizeof(audio_device_config.ep2_cv),
+                .bDescriptorType  = 0x05,
+                .bEndpointAddress = AUDIO_IN_ENDPOINT,
+                .bmAttributes     = 0x11,
+                .wMaxPacketSize   = 3,
+                .bInterval        = 0x01,
+                .bRefresh         = 2,
+                .bSyncAddr        = 0,
+        },
+        .capture_zero_interface = {
+                .bLength            = sizeof(audio_device_config.capture_zero_interface),
+                .bDescriptorType    = DTYPE_Interface,
+                .bInterfaceNumber   = 0x02,
+                .bAlternateSetting  = 0x00,
+                .bNumEndpoints      = 0x00,
+                .bInterfaceClass    = AUDIO_CSCP_AudioClass,
+                .bInterfaceSubClass = AUDIO_CSCP_AudioStreamingSubclass,
+                .bInterfaceProtocol = AUDIO_CSCP_ControlProtocol,
+                .iInterface         = 0x00,
+        },
+        .capture_interface = {
+                .bLength            = sizeof(audio_device_config.capture_interface),
+                .bDescriptorType    = DTYPE_Interface,
+                .bInterfaceNumber   = 0x02,
+                .bAlternateSetting  = 0x01,
+                .bNumEndpoints      = 0x01,
+                .bInterfaceClass    = AUDIO_CSCP_AudioClass,
+                .bInterfaceSubClass = AUDIO_CSCP_AudioStreamingSubclass,
+                .bInterfaceProtocol = AUDIO_CSCP_ControlProtocol,
+                .iInterface         = 0x00,
+        },
+        .capture_audio = {
+                .streaming = {
+                        .bLength = sizeof(audio_device_config.capture_audio.streaming),
+                        .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_General,
+                        .bTerminalLink = 5,
+                        .bDelay = 1,
+                        .wFormatTag = 1, // PCM
+                },
+                .format = {
+                        .core = {
+                                .bLength = sizeof(audio_device_config.capture_audio.format),
+                                .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                                .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_FormatType,
+                                .bFormatType = 1,
+                                .bNrChannels = 2,
+                                .bSubFrameSize = 2,
+                                .bBitResolution = 16,
+                                .bSampleFrequencyType = count_of(audio_device_config.capture_audio.format.freqs),
+                        },
+                        .freqs = {
+                                AUDIO_SAMPLE_FREQ(48000)
+                        },
+                },
+        },
+        .ep3 = {
+                .core = {
+                        .bLength          = sizeof(audio_device_config.ep3.core),
+                        .bDescriptorType  = DTYPE_Endpoint,
+                        .bEndpointAddress = AUDIO_CAPTURE_ENDPOINT,
+                        .bmAttributes     = 5,
+                        .wMaxPacketSize   = AUDIO_MAX_PACKET_SIZE(AUDIO_FREQ_HW, 4),
+                        .bInterval        = 1,
+                        .bRefresh         = 0,
+                        .bSyncAddr        = 0,
+                },
+                .audio = {
+                        .bLength = sizeof(audio_device_config.ep3.audio),
+                        .bDescriptorType = AUDIO_DTYPE_CSEndpoint,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSEndpoint_General,
+                        .bmAttributes = 0,
+                        .bLockDelayUnits = 0,
+                        .wLockDelay = 0,
+                }
+        },
 };
+    static_assert(sizeof(audio_device_config) <= PICO_USBDEV_MAX_DESCRIPTOR_SIZE, "configuration descriptor too long");
     ///
     static struct usb_interface ac_interface;
     usb_interface_init(&ac_interface, &audio_device_config.ac_interface, NULL, 0, true);
@@ -402,7 +763,9 @@ void usb_sound_card_init() {
             &ep_op_out, &ep_op_sync
     };
     static struct usb_interface as_op_interface;
-    usb_interface_init(&as_op_interface, &audio_device_config.as_op_interface, op_endpoints, count_of(op_endpoints), true);
+    // The endpoints are shared by all the alternate settings, so are sized by the one with the largest packets
+    static_assert(AUDIO_MAX_PACKET_SIZE(PLAYBACK_CV_FREQ_MAX, 12) >= AUDIO_MAX_PACKET_SIZE(AUDIO_FREQ_MAX, 6), "");
+    usb_interface_init(&as_op_interface, &audio_device_config.as_cv_interface, op_endpoints, count_of(op_endpoints), true);
     
     ///
     as_op_interface.set_alternate_handler = as_set_alternate;
@@ -428,9 +791,28 @@ void usb_sound_card_init() {
 	
 	//
     usb_set_default_transfer(&ep_op_sync, &as_sync_transfer);
+
+    //
+    static struct usb_endpoint ep_capture;
+    static struct usb_endpoint *const capture_endpoints[] = {
+            &ep_capture
+    };
+    static struct usb_interface capture_interface;
+    usb_interface_init(&capture_interface, &audio_device_config.capture_interface, capture_endpoints, count_of(capture_endpoints), true);
+    capture_interface.set_alternate_handler = capture_set_alternate;
+
+    static const struct usb_transfer_type capture_transfer_type = {
+        .on_packet = _as_capture_packet,
+        .initial_packet_count = 1,
+    };
+    static struct usb_transfer capture_transfer;
+    capture_transfer.type = &capture_transfer_type;
+    usb_set_default_transfer(&ep_capture, &capture_transfer);
+
     static struct usb_interface *const boot_device_interfaces[] = {
             &ac_interface,
             &as_op_interface,
+            &capture_interface,
     };
 	///
 	static const struct usb_device_descriptor boot_device_descriptor = {
@@ -5,14 +5,33 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
-#define AUDIO_FREQ_MAX 48000
+#define AUDIO_FREQ_MAX 96000
+#define AUDIO_FREQ_HW 48000 // the DAC and ADC always run at this rate
 #define VENDOR_ID   0x2e8au
 #define PRODUCT_ID  0xfeddu
 #define AUDIO_OUT_ENDPOINT  0x01U
 #define AUDIO_IN_ENDPOINT   0x82U
+#define AUDIO_CAPTURE_ENDPOINT 0x83U
 #undef AUDIO_SAMPLE_FREQ
 #define AUDIO_SAMPLE_FREQ(frq) (uint8_t)(frq), (uint8_t)((frq >> 8)), (uint8_t)((frq >> 16))
-#define AUDIO_MAX_PACKET_SIZE(freq) (uint8_t)(((freq + 999) / 1000) * 4)
+// One frame over the nominal rate, so that rate matching can ask for (or send) an extra sample
+#define AUDIO_MAX_PACKET_SIZE(freq, frame_bytes) (uint16_t)(((((freq) + 999) / 1000) + 1) * (frame_bytes))
+
+// Alternate settings of the playback streaming interface
+enum playback_format {
+    PLAYBACK_OFF = 0,
+    PLAYBACK_16_STEREO = 1, // 16-bit stereo, 44.1/48/96kHz
+    PLAYBACK_24_STEREO = 2, // 24-bit stereo, 44.1/48/96kHz
+    PLAYBACK_24_CV = 3,     // 24-bit, four channels, 44.1/48kHz: 1/2 to the audio outs, 3/4 to the CV outs
+};
+#define PLAYBACK_FORMATS 4
+#define PLAYBACK_CV_FREQ_MAX 48000 // four 24-bit channels at 96kHz won't fit in a full-speed packet
+
+// Set by the USB handlers, followed by the sample interrupt
+extern volatile uint32_t playback_freq;
+extern volatile uint8_t playback_format;
+extern volatile int16_t playback_volume; // Host volume, Q15, 0 when muted
+#define AUDIO_TERMINAL_EXTERNAL_LINE 0x0603
 #define FEATURE_MUTE_CONTROL 1u
 #define FEATURE_VOLUME_CONTROL 2u
 #define ENDPOINT_FREQ_CONTROL 1u
@@ -31,9 +50,14 @@ struct audio_device_config {
 	
     struct __packed {
         USB_Audio_StdDescriptor_Interface_AC_t core;
+        uint8_t capture_interface_number; // second entry of core's interface list
         USB_Audio_StdDescriptor_InputTerminal_t input_terminal;
         USB_Audio_StdDescriptor_FeatureUnit_t feature_unit;
         USB_Audio_StdDescriptor_OutputTerminal_t output_terminal;
+        USB_Audio_StdDescriptor_InputTerminal_t capture_input_terminal;
+        USB_Audio_StdDescriptor_OutputTerminal_t capture_output_terminal;
+        USB_Audio_StdDescriptor_InputTerminal_t cv_input_terminal;
+        USB_Audio_StdDescriptor_OutputTerminal_t cv_output_terminal;
     } ac_audio;
     struct usb_interface_descriptor as_zero_interface;
     struct usb_interface_descriptor as_op_interface;
@@ -41,7 +65,7 @@ struct audio_device_config {
         USB_Audio_StdDescriptor_Interface_AS_t streaming;
         struct __packed {
             USB_Audio_StdDescriptor_Format_t core;
-            USB_Audio_SampleFreq_t freqs[2];
+            USB_Audio_SampleFreq_t freqs[3];
         } format;
     } as_audio;
     struct __packed {
@@ -49,6 +73,45 @@ struct audio_device_config {
         USB_Audio_StdDescriptor_StreamEndpoint_Spc_t audio;
     } ep1;
     struct usb_endpoint_descriptor_long ep2;
+    struct usb_interface_descriptor as_24_interface;
+    struct __packed {
+        USB_Audio_StdDescriptor_Interface_AS_t streaming;
+        struct __packed {
+            USB_Audio_StdDescriptor_Format_t core;
+            USB_Audio_SampleFreq_t freqs[3];
+        } format;
+    } as_24_audio;
+    struct __packed {
+        struct usb_endpoint_descriptor_long core;
+        USB_Audio_StdDescriptor_StreamEndpoint_Spc_t audio;
+    } ep1_24;
+    struct usb_endpoint_descriptor_long ep2_24;
+    struct usb_interface_descriptor as_cv_interface;
+    struct __packed {
+        USB_Audio_StdDescriptor_Interface_AS_t streaming;
+        struct __packed {
+            USB_Audio_StdDescriptor_Format_t core;
+            USB_Audio_SampleFreq_t freqs[2];
+        } format;
+    } as_cv_audio;
+    struct __packed {
+        struct usb_endpoint_descriptor_long core;
+        USB_Audio_StdDescriptor_StreamEndpoint_Spc_t audio;
+    } ep1_cv;
+    struct usb_endpoint_descriptor_long ep2_cv;
+    struct usb_interface_descriptor capture_zero_interface;
+    struct usb_interface_descriptor capture_interface;
+    struct __packed {
+        USB_Audio_StdDescriptor_Interface_AS_t streaming;
+        struct __packed {
+            USB_Audio_StdDescriptor_Format_t core;
+            USB_Audio_SampleFreq_t freqs[1];
+        } format;
+    } capture_audio;
+    struct __packed {
+        struct usb_endpoint_descriptor_long core;
+        USB_Audio_StdDescriptor_StreamEndpoint_Spc_t audio;
+    } ep3;
 };
  
 static struct {
@@ -87,6 +150,7 @@ static struct audio_control_cmd {
 const char *_get_descriptor_string(uint index);
 void _as_audio_packet(struct usb_endpoint *ep);
 void _as_sync_packet(struct usb_endpoint *ep);
+void _as_capture_packet(struct usb_endpoint *ep);
 bool do_get_current(struct usb_setup_packet *setup);
 bool do_get_minimum(struct usb_setup_packet *setup);
 bool do_get_maximum(struct usb_setup_packet *setup);
@@ -95,6 +159,7 @@ void _audio_reconfigure();
 void audio_set_volume(int16_t volume);
 void audio_cmd_packet(struct usb_endpoint *ep);
 bool as_set_alternate(struct usb_interface *interface, uint alt);
+bool capture_set_alternate(struct usb_interface *interface, uint alt);
 bool do_set_current(struct usb_setup_packet *setup);
 bool ac_setup_request_handler(__unused struct usb_interface *interface, struct usb_setup_packet *setup);
 bool _as_setup_request_handler(__unused struct usb_endpoint *ep, struct usb_setup_packet *setup);
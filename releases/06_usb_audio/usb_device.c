@@ -397,8 +397,9 @@ void _usb_give_buffer(struct usb_endpoint *ep, uint32_t len) {
 #endif
 
 #if !PICO_USBDEV_BULK_ONLY_EP1_THRU_16
-    if (ep->current_give_buffer) {
-        val |= PICO_USBDEV_ISOCHRONOUS_BUFFER_STRIDE_TYPE
+    if (ep->current_give_buffer && ep->buffer_stride >= 128) {
+        // stride type of this endpoint: 128 << type
+        val |= (__builtin_ctz(ep->buffer_stride) - 7u)
                 << 11u; // 11 + 16 = 27 - which is where stride bits go (and only relevant on buffer 1)
     }
 #endif
@@ -1136,7 +1137,10 @@ struct usb_interface *usb_interface_init(struct usb_interface *interface, const
         endpoints[i]->descriptor = ep_desc;
 #if !PICO_USBDEV_BULK_ONLY_EP1_THRU_16
         if (USB_TRANSFER_TYPE_ISOCHRONOUS == (ep_desc->bmAttributes & USB_TRANSFER_TYPE_BITS)) {
-            endpoints[i]->buffer_stride = 128 << PICO_USBDEV_ISOCHRONOUS_BUFFER_STRIDE_TYPE;
+            uint stride = 128u << PICO_USBDEV_ISOCHRONOUS_BUFFER_STRIDE_TYPE;
+            while (stride < ep_desc->wMaxPacketSize) stride <<= 1u;
+            assert(stride <= 1024);
+            endpoints[i]->buffer_stride = stride;
         } else {
             endpoints[i]->buffer_stride = 64;
         }
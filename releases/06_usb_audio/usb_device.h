@@ -70,7 +70,8 @@ static_assert(PICO_USBDEV_MAX_ENDPOINTS >= 1 && PICO_USBDEV_MAX_ENDPOINTS <= 16,
 #define PICO_USBDEV_NO_INTERFACE_ALTERNATES 0
 #endif
 
-// todo this needs to be part of configuration
+// smallest buffer stride for isochronous endpoints (128 << type); endpoints with larger packets get the
+// next power of two up, to at most 1024
 #ifndef PICO_USBDEV_ISOCHRONOUS_BUFFER_STRIDE_TYPE
 #define PICO_USBDEV_ISOCHRONOUS_BUFFER_STRIDE_TYPE 1
 #endif
@@ -92,8 +93,8 @@ typedef void (*usb_transfer_completed_func)(struct usb_endpoint *ep, struct usb_
 
 struct usb_buffer {
     uint8_t *data;
-    uint8_t data_len;
-    uint8_t data_max;
+    uint16_t data_len; // isochronous packets can be up to 1023 bytes
+    uint16_t data_max;
     // then...
     bool valid; // aka user owned
 };
@@ -1,15 +1,24 @@
 /*
-USB audio output for Music Thing Modular Workshop Computer
+USB audio interface for Music Thing Modular Workshop Computer
 
-48kHz 16-bit stereo input through USB
+USB input as 16-bit or 24-bit stereo at 44.1, 48 or 96kHz, resampled to the card's 48kHz
 
 12-bit output through both audio out jacks.
 
+A four-channel 24-bit format (44.1 or 48kHz) also sends channels 3 and 4 to the two CV outs,
+as dithered DC-coupled control voltages.
+
+Both audio in jacks are recorded back to the host, as a 48kHz 16-bit stereo USB input.
+
 Main knob controls volume:
 - Knob at 12 o'clock is the default value (0dB amplification).
 - This volume and quieter will not introduce clipping 
 - Louder volumes may clip but could be useful for boosting quiet sources
 
+Knob X mixes the audio inputs into the outputs (direct monitoring), from off to 0dB.
+Knob Y is the balance between the left and right outputs.
+The host's volume and mute controls apply to playback.
+
 
 Heavily based on GPL code at
   https://github.com/tierneytim/Pico-USB-audio
@@ -26,38 +35,68 @@ with modifications only to:
 #include "pico/multicore.h"
 #include "pico/stdlib.h"
 #include "usb_audio.h"
+#include "audio_ring.h"
+#include "resampler.h"
+#include "mixer.h"
 #include "computer.h"
 #include "pico/multicore.h"
 
 
 volatile int32_t knobs[4] = {0,0,0,0}; // 0-4095
 
+static struct resampler resampler;
+static struct mixer mixer;
+
+// Signed 18-bit value (+/-131072 full scale) to a CV out, as 11-bit PWM with the remaining
+// 8 bits' worth of error carried into the next sample (first-order noise shaping)
+static void CVOutDithered(int i, int32_t val)
+{
+	static const uint pins[2] = {CV_OUT_1, CV_OUT_2};
+	static uint32_t err[2] = {0, 0};
+
+	// 19-bit level, inverted as the output stage is
+	int32_t level = 262143 - (val << 1);
+	if (level < 0) level = 0;
+	if (level > 524287) level = 524287;
+
+	uint32_t total = (uint32_t)level + err[i];
+	err[i] = total & 0xFF;
+	pwm_set_gpio_level(pins[i], total >> 8);
+}
+
 void Sample()
 {
 	static volatile uint8_t mxPos = 0; // external multiplexer value
 	static volatile int32_t knobssm[4] = {0,0,0,0};
 
 	static int orc=0, olc=0; // clipping indicator counters
+	static int32_t capL=0, capR=0; // latest audio inputs, -2048 to 2047
+	static int32_t histL[4], histR[4], sumL=0, sumR=0; // last four inputs, and their sums
+	static uint8_t hist=0;
 	
 	uint16_t adc = adc_fifo_get_blocking(); 
-	static uint32_t left, right;
-   
-	if (multicore_fifo_rvalid())
-	{
-		uint32_t audiodata = multicore_fifo_pop_blocking();
-		left=audiodata &0xFFFF;
-		right= (audiodata & 0xFFFF0000)>>16;
+	static int32_t out[PLAYBACK_FRAME_WORDS]; // left, right, CV 1, CV 2; signed 18-bit
+	static bool playing = false;
 
-	}
+	if (resampler.freq != playback_freq)
+		resampler_set_rate(&resampler, playback_freq);
+
+	// Wait for the ring to fill to its target before playing, at startup and after running dry,
+	// so that USB packet jitter doesn't empty it again straight away. Holds the last frame meanwhile
+	if (!playing && audio_ring_fill(&playback_ring) >= AUDIO_RING_TARGET)
+		playing = true;
 
-	int16_t sl = left;
-	int16_t sr = right;
+	if (playing && !resampler_next(&resampler, &playback_ring, out))
+		playing = false;
 
-	int32_t sl32, sr32;
+	// Host playback plus the inputs, with the gains worked out once per block
+	if (mixer_block_start(&mixer))
+		mixer_update(&mixer, knobs[KNOB_MAIN], knobs[KNOB_X], knobs[KNOB_Y], playback_volume);
+	int32_t in[2] = {sumL>>2, sumR>>2}, mix[2];
+	mixer_process(&mixer, out, in, mix);
 
-	int32_t knob2 = (knobs[KNOB_MAIN]*knobs[KNOB_MAIN])>>12;
-	sl32 = ((int32_t)sl*knob2)>>14;
-	sr32 = ((int32_t)sr*knob2)>>14;
+	int16_t sl, sr;
+	int32_t sl32 = mix[0], sr32 = mix[1];
 
 	if (sl32>2047) {sl32=2047; olc=4800;}
 	if (sr32>2047) {sr32=2047; orc=4800;}
@@ -85,6 +124,13 @@ void Sample()
 	WriteToDAC(sl, DAC_CHANNEL_A);
 	WriteToDAC(sr, DAC_CHANNEL_B);
 
+	// Channels 3/4 of the four-channel format to the CV outs, left at 0V otherwise
+	if (playback_format == PLAYBACK_24_CV)
+	{
+		CVOutDithered(0, out[2]);
+		CVOutDithered(1, out[3]);
+	}
+
 	
 	// (untested) best attempt at correction of DNL errors in ADC
 	uint16_t adc512=adc+512;
@@ -97,9 +143,11 @@ void Sample()
 		break;
 		
 	case 1: // Audio in R  (12kHz)
+		capR = 2048 - adc; // inputs are inverted
 		break;
 		
 	case 2: // Audio in L  (12kHz)
+		capL = 2048 - adc;
 		mxPos=(mxPos+1)&0x03;
 		break;
 		
@@ -115,9 +163,23 @@ void Sample()
 	if (orc) orc--;
 	if (olc) olc--;
 
+	// Capture: each input is only sampled at 12kHz, so the sum of its last four held values
+	// (one per 48kHz sample) linearly interpolates between successive input samples
+	sumL += capL - histL[hist];
+	sumR += capR - histR[hist];
+	histL[hist] = capL;
+	histR[hist] = capR;
+	hist = (hist+1)&0x03;
+
+	// 12-bit samples, times four from the sum, times four again to fill 16 bits
+	uint32_t frame = ((uint32_t)(uint16_t)(sumL<<2)) | (((uint32_t)(uint16_t)(sumR<<2))<<16);
+	audio_ring_write(&capture_ring, &frame, 1);
+
 }
 void core1_worker() {
 
+	resampler_init(&resampler, playback_freq);
+
 	// Set up interrupt on ADC sample received,
 	// as this gives low jitter
 	adc_set_round_robin(0x0F);
@@ -1,5 +1,6 @@
 
 #include "ComputerCard.h"
+#include "exp2.h"
 #include <cmath>
 
 int32_t __not_in_flash_func(rnd12)()
@@ -17,50 +18,62 @@ uint32_t __not_in_flash_func(rnd32)()
 }
 
 
-template <uint32_t bufSize, typename storage=int16_t>
-class DelayLine
+// Coefficients for SVFLowPass, worked out once at startup for cutoffs from 16Hz
+// up ten octaves (to 16.4kHz), 16 per octave, at resonances from Q=0.5 to Q=8,
+// one per octave of Q. Get interpolates between them with integer arithmetic only,
+// so filters can be retuned as often as needed without any float calls.
+template <unsigned shift=16>
+class SVFCoeffTable
 {
 public:
-	unsigned writeInd;
-	DelayLine()
+	constexpr static unsigned stepsPerOctave = 16;
+	constexpr static unsigned octaves = 10;
+	constexpr static unsigned nCutoffs = octaves * stepsPerOctave + 1;
+	constexpr static unsigned nQ = 5;
+	constexpr static uint32_t maxCutoff = octaves << 12;
+
+	SVFCoeffTable()
 	{
-		writeInd=0;
-		for (unsigned i=0; i<bufSize; i++)
+		for (unsigned q=0; q<nQ; q++)
 		{
-			delaybuf[i] = 0;
+			float k = 2.0f / (1 << q); // 1/Q
+			for (unsigned c=0; c<nCutoffs; c++)
+			{
+				float f0 = 16.0f * exp2f(c / float(stepsPerOctave));
+				float g = tanf(float(M_PI) * f0/48000.0f);
+				float fa1 = (1l<<shift)/(1.0f + g*(g+k));
+				coeffs[q][c][0] = fa1;
+				coeffs[q][c][1] = fa1*g;
+				coeffs[q][c][2] = fa1*g*g;
+			}
 		}
-	} 
-
-	// delay is in 128ths of a sample
-	storage ReadInterp(int32_t delay)
-	{
-
-		int32_t r = delay & 0x7F;
-		
-		int32_t readInd1 = (writeInd + (bufSize<<1) - (delay>>7) - 1)%bufSize;
-		int32_t fromBuffer1 =  delaybuf[readInd1];
-		int readInd2 = (writeInd + (bufSize<<1) - (delay>>7) - 2)%bufSize;
-		int32_t fromBuffer2 =  delaybuf[readInd2];
-		return (fromBuffer2*r + fromBuffer1*(128-r))>>7;
 	}
-	// delay is in samples
-	storage ReadRaw(int32_t delay)
+
+	// cutoff in 1/4096ths of an octave above 16Hz, up to maxCutoff
+	// res from 0 (Q=0.5) to 4095 (Q=8), 1024 per octave of Q
+	void Get(uint32_t cutoff, uint32_t res, int32_t a[3]) const
 	{
-		int32_t readInd1 = (writeInd + (bufSize<<1) - delay - 1)%bufSize;
-		return  delaybuf[readInd1];
+		if (cutoff > maxCutoff) cutoff = maxCutoff;
+		if (res > 4095) res = 4095;
+
+		// 8-bit interpolation between cutoffs, and between Qs
+		uint32_t c = cutoff >> 8, cr = cutoff & 0xFF;
+		uint32_t c2 = c < nCutoffs - 1 ? c + 1 : c;
+		uint32_t qpos = res * (nQ - 1);
+		uint32_t q = qpos >> 12, qr = (qpos >> 4) & 0xFF;
+		uint32_t q2 = q < nQ - 1 ? q + 1 : q;
+		for (unsigned i=0; i<3; i++)
+		{
+			int32_t lo = (coeffs[q][c][i]*(256-cr) + coeffs[q][c2][i]*cr) >> 8;
+			int32_t hi = (coeffs[q2][c][i]*(256-cr) + coeffs[q2][c2][i]*cr) >> 8;
+			a[i] = (lo*(256-qr) + hi*qr) >> 8;
+		}
 	}
-	void Write(int16_t value)
-	{
-		delaybuf[writeInd] = value;
 
-		writeInd++;
-		if (writeInd>=bufSize) writeInd=0;
-	}
 private:
-	storage delaybuf[bufSize];
+	int32_t coeffs[nQ][nCutoffs][3];
 };
 
-
 template <typename T=int32_t, unsigned shift=16>
 class SVFLowPass
 {
@@ -69,14 +82,11 @@ protected:
 	T ic1eq, ic2eq, v1rem, v2rem;
 	int32_t a1, a2, a3;
 public:
-	SVFLowPass(float f0, float Q)
+	SVFLowPass()
 	{
-		float g = tanf(M_PI * f0/48000.0f);
-		float k = 1.0f/Q;
-		float fa1 = (1l<<shift)/(1.0f + g*(g+k));
-		a1 = fa1;
-		a2 = fa1*g;
-		a3 = fa1*g*g;
+		a1 = 0;
+		a2 = 0;
+		a3 = 0;
 
 		ic1eq = 0;
 		ic2eq = 0;
@@ -84,12 +94,14 @@ public:
 		v2rem = 0;
 	}
 
-	void SetFreq(float g, float k)
+	// Retune, with cutoff and res as for SVFCoeffTable::Get
+	void SetCutoff(const SVFCoeffTable<shift> &table, uint32_t cutoff, uint32_t res)
 	{
-		float fa1 = (1l<<shift)/(1.0f + g*(g+k));
-		a1 = fa1;
-		a2 = fa1*g;
-		a3 = fa1*g*g;
+		int32_t a[3];
+		table.Get(cutoff, res, a);
+		a1 = a[0];
+		a2 = a[1];
+		a3 = a[2];
 	}
 	
 	int32_t operator()(int32_t x)
@@ -112,68 +124,68 @@ public:
 int pentatonic[5]={0,2,5,7,9};
 class Bumpers : public ComputerCard
 {
-	DelayLine<100000> delay;
+	RingBuffer<int16_t, 100000> delay;
+	SVFCoeffTable<> svfTable;
 	SVFLowPass<> lpf;
 	int32_t pulseDurationTimer[2];
-	int32_t pulseSpacingTimer[2];
 	int32_t pulseSpacing[2];
+	// Bounces are scheduled rather than counted down: nextBounce is the sample
+	// that the next bounce falls on, at the current bounceRate (spacing units per sample)
+	uint32_t nextBounce[2];
+	uint32_t bounceRate[2];
+	uint32_t sampleCount;
+	// MIDI note for each of the 16 possible random bounce pitches
+	uint8_t bounceNote[16];
 	int32_t cvCurrent[2], cvDest[2];
 	int32_t dlLength;
 
 	unsigned delayTime[2][10];
-	// Lookup table for powers of two
-	uint32_t pow2_128[128];
 	
 	constexpr static int32_t minSpacing = 1000;
+	// Bounce rates are read from the knobs and CV every this many samples
+	constexpr static uint32_t rateInterval = 32;
 
 	
-	// Return integer part of 2^(in/4096) (approximate)
-	// 7-bit lookup table (128 entries), 5-bit (32-step) linear interpolation between steps
-	uint32_t Pow2(uint32_t in)
+	// Samples to cover spacing at rate, rounded up, so that bounces land on the
+	// same sample as subtracting rate every sample until spacing reaches zero
+	static uint32_t SamplesFor(uint64_t spacing, uint32_t rate)
 	{
-		uint32_t oct = in >> 12; // floor(in/4096)
-
-		// Table index and value of lookup
-		uint32_t ind1 = (in & 0xFE0) >> 5;  // 0xFE0 = 111111100000
-		uint32_t val1 = pow2_128[ind1];
-
-		// Next lookup
-		uint32_t ind2 = (ind1 + 1) & 0x7F; //
-		uint32_t val2 = pow2_128[ind2];
-		if (ind2 == 0) val2 <<= 1; // interpolating between end of one octave and the start of another
-
-		// Linearly interpolate with 32 steps
-		uint32_t subsample = in & 0x1F;
-		uint32_t val = val1*(32-subsample) + val2*subsample;
-
-		val >>= 31 - oct;
+		uint32_t n = (spacing + rate - 1) / rate;
+		return n ? n : 1;
+	}
 
-		return val;
+	uint32_t BounceRate(unsigned i)
+	{
+		int32_t decrement = (KnobVal(Knob(Knob::X + i)) + CVIn(i));
+		return exp2_q12(16384+8192 + (decrement*7));
 	}
 
 
 public:
-	Bumpers() : lpf(50, 1)
+	Bumpers()
 	{
-		// Set up powers-of-two table
-		float f = 67108864; // 2^26
-		for (int i=0; i<128; i++)
-		{
-			pow2_128[i] = f;
-			f *= 1.005429901112803f; // 2^(1/128)
-		}
+		// Delay time CV smoothing: 50Hz (log2(50/16) octaves above 16Hz), Q=1
+		lpf.SetCutoff(svfTable, 6733, 1024);
 
 		// Zero out variables
 		for (unsigned i=0; i<2; i++)
 		{
 			pulseSpacing[i] = 0;
 			pulseDurationTimer[i]=0;
-			pulseSpacingTimer[i]=0;
+			nextBounce[i]=0;
+			bounceRate[i]=1;
 			cvCurrent[i] = 0;
 			cvDest[i] = 0;
 		}
+		sampleCount = 0;
 		dlLength = 0;
 
+		// Pentatonic notes over three octaves from MIDI note 50
+		for (int r=0; r<16; r++)
+		{
+			bounceNote[r] = 50 + (r/5)*12 + pentatonic[r%5];
+		}
+
 		int val = 20000, lastval = 0;
 		delayTime[0][0] = val;
 		delayTime[1][0] = val/2;
@@ -190,12 +202,22 @@ public:
 	{
 		Switch s = SwitchVal();
 		bool manualPulse = SwitchChanged() && s == Down;
+		bool readRates = (sampleCount % rateInterval) == 0;
 		for (unsigned i=0; i<2; i++)
 		{
-			int32_t decrement = (KnobVal(Knob(Knob::X + i)) + CVIn(i));
-			pulseSpacingTimer[i]-= Pow2(16384+8192 + (decrement*7));
-			
-			if (pulseSpacingTimer[i] <= 0 || manualPulse || PulseInRisingEdge(i))
+			// On a change of rate, reschedule the rest of the current spacing
+			if (readRates)
+			{
+				uint32_t rate = BounceRate(i);
+				int32_t remaining = nextBounce[i] - sampleCount;
+				if (rate != bounceRate[i] && remaining > 0)
+				{
+					nextBounce[i] = sampleCount + SamplesFor(uint64_t(remaining) * bounceRate[i], rate);
+				}
+				bounceRate[i] = rate;
+			}
+
+			if (int32_t(sampleCount - nextBounce[i]) >= 0 || manualPulse || PulseInRisingEdge(i))
 			{
 				pulseSpacing[i] = (pulseSpacing[i]*(64+(KnobVal(Main)>>6)))>>7;
 				if ((pulseSpacing[i] < minSpacing && s != Middle) || manualPulse || PulseInRisingEdge(i))
@@ -206,10 +228,7 @@ public:
 					// Pitch signal is on CV out 1 (on channel 1), and is on audio out 2 (on channel 2) if no delay
 					if (i==0)
 					{
-						int r = rnd12()>>8;
-						int oct = r/5;
-						int note = r%5;
-						CVOutMIDINote(i, 50+(oct*12)+pentatonic[note]);
+						CVOutMIDINote(i, bounceNote[rnd12()>>8]);
 					}
 					else if (Disconnected(Audio1)) AudioOut(i, rnd12()-2048);
 
@@ -226,7 +245,7 @@ public:
 					}
 				}
 			
-				pulseSpacingTimer[i] = pulseSpacing[i];
+				nextBounce[i] = sampleCount + SamplesFor(pulseSpacing[i], bounceRate[i]);
 				pulseDurationTimer[i] =1+(pulseSpacing[i]>>17);
 				//	pulseDurationTimer[i] = (pulseDurationTimer[i]*pulseDurationTimer[i])>>8;
 				int32_t cvStep = cvCurrent[i] + (((cvDest[i]-cvCurrent[i])*(2048-(pulseSpacing[i]>>12)))>>11);
@@ -250,6 +269,7 @@ public:
 				LedOff(i);
 			}
 		}
+		sampleCount++;
 
 		if (Connected(Audio1))
 		{
@@ -274,8 +294,10 @@ public:
 			for (int i=0; i<10; i++)
 			{
 				mul>>=1;
-				outputl += delay.ReadInterp((delayTime[0][i]*dl2)>>8)*mul;
-				outputr += delay.ReadInterp((delayTime[1][i]*dl2)>>8)*mul;
+				int16_t tapl, tapr;
+				delay.ReadInterp((delayTime[0][i]*dl2)>>8, (delayTime[1][i]*dl2)>>8, tapl, tapr);
+				outputl += tapl*mul;
+				outputr += tapr*mul;
 			}
 			AudioOut1(outputl>>11);
 			AudioOut2(outputr>>11);
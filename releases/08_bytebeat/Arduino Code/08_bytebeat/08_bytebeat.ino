@@ -67,8 +67,28 @@ const char SAVE_EXPR_KEYWORD5[] = "_SAVE5";
 const char SAVE_EXPR_KEYWORD6[] = "_SAVE6";
 const char CLEAR_KEYWORD[] = "_CLEAR";
 
-te_expr *expr;
 te_expr *exprs[6];
+// Lowered to bytecode, which is what actually runs
+te_program progs[6];
+// Formulas sent over serial are compiled on core 1 (loop1), into whichever of the
+// two live programs isn't playing, so parsing never holds up the outputs. loop
+// swaps to the new one and crossfades from the old one over FADE_US.
+te_expr *liveExprs[2];
+te_program liveProgs[2];
+te_program *liveProg = &liveProgs[0];
+te_program *fadeProg = nullptr;
+unsigned long fadeStart;
+#define FADE_US 20000
+char pendingFormula[128];
+bool formulaQueued = false;  // core 0: bytebeatFormula still to be handed to core 1
+bool formulaPending = false; // set by core 0 once pendingFormula holds a formula, cleared by core 1
+int compiledProg = -1;       // set by core 1 to the new live program, cleared by core 0 once it has faded in
+// Blocks of TE_BLOCK samples rendered ahead for the two audio outputs
+te_program *blockProg[2];
+uint32_t blockFirst[2];
+int blockStep[2];
+bool blockScalar[2];
+int blockOut[2][TE_BLOCK];
 #define MAX_EXPR_LEN 95
 
 int err;
@@ -398,6 +418,12 @@ switchRead = analog[7]->getValue();
 p1 = ((p1 * (AUDIO1_IN + 2048)) / 4096) % 255;
 p2 = ((p2 * (AUDIO2_IN + 2048)) / 4096) % 255;
 
+// End a crossfade once it's done, whichever mode is playing, so that core 1 can reuse the old program
+if (fadeProg && micros() - fadeStart >= FADE_US) {
+  fadeProg = nullptr;
+  __atomic_store_n(&compiledProg, -1, __ATOMIC_RELEASE);
+}
+
 // BUILT IN
 if (switchState == 0) {
 
@@ -467,6 +493,7 @@ if (switchState == 1) {
 
     if (!serialInput.startsWith("_")) {
       bytebeatFormula = serialInput;
+      formulaQueued = true;
       Serial.println("Formula Recieved!");
 
     } else if (serialInput == SAVE_EXPR_KEYWORD1) {
@@ -501,29 +528,6 @@ if (switchState == 1) {
     // Serial.print("Received formula: ");
     // Serial.println(bytebeatFormula);
 
-    if (expr) {
-      te_free(expr);
-      expr = nullptr;
-      formulaUpdate = 1;
-    }
-
-    //removes warnings about converting a string constant to 'char*'
-    char tchar[] = "t";
-    char xchar[] = "p1";
-    char ychar[] = "p2";
-    char zchar[] = "p3";
-    char wchar[] = "w";
-
-    te_variable vars[] = { { tchar, &t }, { xchar, &x }, { ychar, &y }, { zchar, &z }, { wchar, &w } };
-
-    const char* formulaChar = bytebeatFormula.c_str();
-    expr = te_compile(formulaChar, vars, 5, &err);
-
-    if (!expr) {
-      Serial.print("error compiling: ");
-      Serial.print(err);
-    }
-
 /*
     //blink when recieve formula from htmlpage, redo
     if (currentMillis - previousMillis >= blinkInterval) {
@@ -536,6 +540,24 @@ if (switchState == 1) {
 
   }  //end serial
 
+  // Hand the latest formula to core 1, once it has taken the last one
+  if (formulaQueued && !__atomic_load_n(&formulaPending, __ATOMIC_ACQUIRE)) {
+    strncpy(pendingFormula, bytebeatFormula.c_str(), sizeof(pendingFormula) - 1);
+    pendingFormula[sizeof(pendingFormula) - 1] = '\0';
+    formulaQueued = false;
+    __atomic_store_n(&formulaPending, true, __ATOMIC_RELEASE);
+  }
+
+  // Swap to a newly compiled formula, fading out whichever one was playing
+  int compiled = __atomic_load_n(&compiledProg, __ATOMIC_ACQUIRE);
+  if (compiled >= 0 && !fadeProg) {
+    fadeProg = formulaUpdate ? liveProg : &progs[userslot];
+    liveProg = &liveProgs[compiled];
+    fadeStart = micros();
+    formulaUpdate = 1;
+    blockReset();
+  }
+
   // this didnt work w/ p1, etc. maybe it go confused w/ variables with numbers?
   x = p1;
   y = p2;
@@ -548,11 +570,17 @@ if (switchState == 1) {
   prev_userslot = userslot;
 
 
-    if (formulaUpdate) {
-      w = te_eval(expr);
+    if (formulaUpdate && fadeProg) {
+      // The old formula renders through the second block buffer, which is idle meanwhile
+      int gain = (micros() - fadeStart) * 256 / FADE_US;
+      if (gain > 256) gain = 256;
+      int wNew = runBlock(0, liveProg) & 255, wOld = runBlock(1, fadeProg) & 255;
+      w = (wNew * gain + wOld * (256 - gain)) >> 8;
+    } else if (formulaUpdate) {
+      w = runBlock(0, liveProg);
     } else if (userslot <= 6) {
-      w = te_eval(exprs[userslot]);                        // Recall from flash
-      w2 = te_eval(exprs[constrain(userslot + 1, 0, 5)]);  // Recall from flash
+      w = runBlock(0, &progs[userslot]);                        // Recall from flash
+      w2 = runBlock(1, &progs[constrain(userslot + 1, 0, 5)]);  // Recall from flash
     }
 
 }  //end switch1
@@ -571,12 +599,82 @@ if (switchState == 1) {
 
 
 
+// Core 1: compiles formulas handed over by loop into the live program that isn't playing
+void loop1() {
+  if (!__atomic_load_n(&formulaPending, __ATOMIC_ACQUIRE) || __atomic_load_n(&compiledProg, __ATOMIC_ACQUIRE) >= 0) return;
+
+  char formula[sizeof(pendingFormula)];
+  strcpy(formula, pendingFormula);
+  __atomic_store_n(&formulaPending, false, __ATOMIC_RELEASE);
+
+  //removes warnings about converting a string constant to 'char*'
+  char tchar[] = "t";
+  char xchar[] = "p1";
+  char ychar[] = "p2";
+  char zchar[] = "p3";
+  char wchar[] = "w";
+
+  te_variable vars[] = { { tchar, &t }, { xchar, &x }, { ychar, &y }, { zchar, &z }, { wchar, &w } };
+
+  // Nothing plays the spare program until compiledProg is set
+  const int spare = (liveProg == &liveProgs[0]) ? 1 : 0;
+  te_lower(nullptr, nullptr, 0, &liveProgs[spare]);
+  te_free(liveExprs[spare]);
+
+  int compileErr;
+  liveExprs[spare] = te_compile(formula, vars, 5, &compileErr);
+
+  if (!liveExprs[spare]) {
+    // The old formula carries on
+    Serial.print("error compiling: ");
+    Serial.println(compileErr);
+    return;
+  }
+  if (!te_lower(liveExprs[spare], vars, 5, &liveProgs[spare])) {
+    Serial.println("formula too long for bytecode, running it from the tree");
+  }
+  __atomic_store_n(&compiledProg, spare, __ATOMIC_RELEASE);
+}
+
+
 bool sampleInterruptHandler(repeating_timer_t *rt) {
     t = reversePlayback ? t - 1 : t + 1;
     return true;
 }
 
 
+uint32_t runBlock(int out, te_program *p) {
+
+  // Returns the formula at the current t, from a block rendered for the next TE_BLOCK
+  // values of t at once. p1-p3 are taken at the start of each block. Formulas that
+  // read w depend on the last sample, so they're run one sample at a time.
+
+  const uint32_t now = t;
+  const int step = reversePlayback ? -1 : 1;
+
+  if (blockProg[out] != p) {
+    blockProg[out] = p;
+    blockScalar[out] = te_reads(p, 4);
+    blockStep[out] = 0;
+  }
+  if (blockScalar[out]) return te_run(p);
+
+  uint32_t i = (now - blockFirst[out]) * step;
+  if (blockStep[out] != step || i >= TE_BLOCK) {
+    blockFirst[out] = now;
+    blockStep[out] = step;
+    te_run_block(p, 0, now, step, TE_BLOCK, blockOut[out]);
+    i = 0;
+  }
+  return blockOut[out][i];
+}
+
+
+void blockReset() {
+  blockProg[0] = blockProg[1] = nullptr;
+}
+
+
 void eeSave(const int address) {
 
     // Saves the bytebeat string to the address on EEPROM
@@ -641,6 +739,7 @@ void eeRead(int address) {
     te_variable vars[] = { { tchar, &t }, { xchar, &x }, { ychar, &y }, { zchar, &z }, { wchar, &w } };
     
     if (exprs[address / 100]) {
+      te_lower(nullptr, nullptr, 0, &progs[address / 100]);
       te_free(exprs[address / 100]);
     }
 
@@ -652,6 +751,8 @@ void eeRead(int address) {
       Serial.print(": ");
       Serial.println(err);
     }
+    te_lower(exprs[address / 100], vars, 5, &progs[address / 100]);
+    blockReset();
 
   } else {
     Serial.print(address);
@@ -672,10 +773,12 @@ void clearEEPROM() {
   // Clear the exprs array
   for (int i = 0; i < 6; i++) {
     if (exprs[i]) {
+      te_lower(nullptr, nullptr, 0, &progs[i]);
       te_free(exprs[i]);
       exprs[i] = nullptr;
     }
   }
+  blockReset();
 
 }
 
@@ -1,7 +1,12 @@
 #ifndef FORMULAS_H
 #define FORMULAS_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+#include <stdint.h>
+#include <math.h>
+#endif
 
 uint32_t formula1(uint32_t t, uint8_t w, uint32_t p1, uint32_t p2, uint32_t p3);
 uint32_t formula2(uint32_t t, uint8_t w, uint32_t p1, uint32_t p2, uint32_t p3);
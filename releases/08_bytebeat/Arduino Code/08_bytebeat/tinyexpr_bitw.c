@@ -29,6 +29,9 @@
  * low and high
  *
  * My apologies to the original author for such a sloppy hack :) 
+ *
+ * te_lower and te_run turn a compiled expression into register bytecode, so
+ * uploaded formulas don't have to walk the tree every sample.
  */
 
 /* COMPILE TIME OPTIONS */
@@ -842,3 +845,304 @@ static void pn (const te_expr *n, int depth) {
 void te_print(const te_expr *n) {
     pn(n, 0);
 }
+
+
+/* Bytecode */
+
+#if defined(ARDUINO_ARCH_RP2040) || PICO_ON_DEVICE
+#include <pico.h>
+#else
+#define __not_in_flash_func(f) f
+#endif
+
+enum {
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+    OP_SHL, OP_SHR, OP_AND, OP_OR, OP_XOR,
+    OP_LT, OP_GT, OP_NOT, OP_NEG, OP_LOW, OP_HIGH,
+    OP_COMMA, OP_END
+};
+
+static const struct {const void *function; unsigned char op;} te_ops[] = {
+    {add, OP_ADD}, {sub, OP_SUB}, {mul, OP_MUL}, {divide, OP_DIV}, {intmod, OP_MOD},
+    {shiftl, OP_SHL}, {shiftr, OP_SHR}, {and, OP_AND}, {or, OP_OR}, {xor, OP_XOR},
+    {less_than, OP_LT}, {greater_than, OP_GT}, {not, OP_NOT}, {negate, OP_NEG},
+    {low, OP_LOW}, {high, OP_HIGH}, {comma, OP_COMMA}
+};
+
+typedef struct lowering {
+    te_program *p;
+    const te_variable *vars;
+    int len;    /* instructions so far */
+    int temps;  /* next free temporary */
+    int consts; /* lowest constant so far */
+} lowering;
+
+static int is_constant(const te_expr *n) {
+    int i;
+    if (TYPE_MASK(n->type) == TE_CONSTANT) return 1;
+    if (!IS_FUNCTION(n->type)) return 0;
+    for (i = 0; i < ARITY(n->type); ++i) {
+        if (!is_constant(n->parameters[i])) return 0;
+    }
+    return 1;
+}
+
+/* Returns the register holding the value of n, or -1 if it didn't fit */
+static int lower(lowering *l, const te_expr *n) {
+    te_program *p = l->p;
+    int i;
+
+    if (is_constant(n)) {
+        const int value = te_eval(n);
+        for (i = l->consts; i < TE_PROGRAM_REGS; ++i) {
+            if (p->regs[i] == value) return i;
+        }
+        if (l->consts <= l->temps) return -1;
+        p->regs[--l->consts] = value;
+        return l->consts;
+    }
+
+    if (TYPE_MASK(n->type) == TE_VARIABLE) {
+        for (i = 0; i < p->var_count; ++i) {
+            if (l->vars[i].address == n->bound) return i;
+        }
+        return -1;
+    }
+
+    const int arity = ARITY(n->type);
+    if (IS_CLOSURE(n->type) || arity < 1 || arity > 2) return -1;
+
+    int op = -1;
+    for (i = 0; i < (int)(sizeof(te_ops) / sizeof(te_ops[0])); ++i) {
+        if (te_ops[i].function == n->function) op = te_ops[i].op;
+    }
+    if (op < 0) return -1;
+
+    /* Nothing has side effects, so the left of a comma can go */
+    if (op == OP_COMMA) return lower(l, n->parameters[1]);
+
+    const int top = l->temps;
+    const int a = lower(l, n->parameters[0]);
+    if (a < 0) return -1;
+    const int b = (arity == 2) ? lower(l, n->parameters[1]) : a;
+    if (b < 0) return -1;
+
+    /* The operands' temporaries are free again once they're read */
+    l->temps = top;
+    if (l->temps >= l->consts || l->len == TE_PROGRAM_LEN) return -1;
+    const int dst = l->temps++;
+    te_instr *in = &p->code[l->len++];
+    in->op = op;
+    in->dst = dst;
+    in->a = a;
+    in->b = b;
+    return dst;
+}
+
+int te_lower(const te_expr *n, const te_variable *variables, int var_count, te_program *p) {
+    lowering l;
+    int i;
+
+    p->tree = n;
+    p->lowered = 0;
+    if (!n || var_count > TE_PROGRAM_VARS) return 0;
+
+    p->var_count = var_count;
+    for (i = 0; i < var_count; ++i) {
+        p->bound[i] = variables[i].address;
+    }
+
+    l.p = p;
+    l.vars = variables;
+    l.len = 0;
+    l.temps = var_count;
+    l.consts = TE_PROGRAM_REGS;
+    const int r = lower(&l, n);
+    if (r < 0) return 0;
+
+    p->code[l.len].op = OP_END;
+    p->result = r;
+    p->consts = l.consts;
+    p->lowered = 1;
+    return 1;
+}
+
+/* Threaded dispatch: each instruction jumps straight to the next one's handler */
+#define NEXT goto *dispatch[(++ip)->op]
+#define BINARY(f) r[ip->dst] = f(r[ip->a], r[ip->b]); NEXT
+#define UNARY(f) r[ip->dst] = f(r[ip->a]); NEXT
+
+int __not_in_flash_func(te_run)(te_program *p) {
+    static const void *const dispatch[] = {
+        &&op_add, &&op_sub, &&op_mul, &&op_div, &&op_mod,
+        &&op_shl, &&op_shr, &&op_and, &&op_or, &&op_xor,
+        &&op_lt, &&op_gt, &&op_not, &&op_neg, &&op_low, &&op_high,
+        &&op_end, &&op_end
+    };
+    int *r = p->regs;
+    const te_instr *ip = p->code;
+    int i;
+
+    if (!p->lowered) return te_eval(p->tree);
+
+    for (i = 0; i < p->var_count; ++i) {
+        r[i] = *p->bound[i];
+    }
+
+    goto *dispatch[ip->op];
+    op_add: BINARY(add);
+    op_sub: BINARY(sub);
+    op_mul: BINARY(mul);
+    op_div: BINARY(divide);
+    op_mod: BINARY(intmod);
+    op_shl: BINARY(shiftl);
+    op_shr: BINARY(shiftr);
+    op_and: BINARY(and);
+    op_or: BINARY(or);
+    op_xor: BINARY(xor);
+    op_lt: BINARY(less_than);
+    op_gt: BINARY(greater_than);
+    op_not: UNARY(not);
+    op_neg: UNARY(negate);
+    op_low: UNARY(low);
+    op_high: UNARY(high);
+    op_end: return r[p->result];
+}
+
+#undef NEXT
+#undef BINARY
+#undef UNARY
+
+
+/* Block evaluation */
+
+/* Registers that vary across a block hold one value per lane; the ones that don't
+ * (the other variables, constants, and anything worked out from only those) keep
+ * theirs in lane 0. Uniform operands are read before the loop, since the
+ * destination may be the same register. */
+static int block_regs[TE_PROGRAM_REGS][TE_BLOCK];
+
+#define LANES(f) \
+    if (va && vb) { for (i = 0; i < n; ++i) d[i] = f(a[i], b[i]); } \
+    else if (va) { const int b0 = b[0]; for (i = 0; i < n; ++i) d[i] = f(a[i], b0); } \
+    else if (vb) { const int a0 = a[0]; for (i = 0; i < n; ++i) d[i] = f(a0, b[i]); } \
+    else d[0] = f(a[0], b[0]); \
+    break
+#define LANES1(f) \
+    if (va) { for (i = 0; i < n; ++i) d[i] = f(a[i]); } \
+    else d[0] = f(a[0]); \
+    break
+
+int __not_in_flash_func(te_run_block)(te_program *p, int var, int first, int step, int n, int *out) {
+    unsigned char varying[TE_PROGRAM_REGS];
+    const te_instr *ip;
+    int i;
+
+    if (!p->lowered || var < 0 || var >= p->var_count || n > TE_BLOCK) return 0;
+
+    memset(varying, 0, sizeof(varying));
+    for (i = 0; i < p->var_count; ++i) {
+        block_regs[i][0] = *p->bound[i];
+    }
+    for (i = p->var_count; i < TE_PROGRAM_REGS; ++i) {
+        block_regs[i][0] = p->regs[i];
+    }
+    for (i = 0; i < n; ++i) {
+        block_regs[var][i] = first + i * step;
+    }
+    varying[var] = 1;
+
+    for (ip = p->code; ip->op != OP_END; ++ip) {
+        const int *a = block_regs[ip->a], *b = block_regs[ip->b];
+        const int va = varying[ip->a], vb = varying[ip->b];
+        int *d = block_regs[ip->dst];
+        varying[ip->dst] = va || vb;
+
+        switch (ip->op) {
+            case OP_ADD: LANES(add);
+            case OP_SUB: LANES(sub);
+            case OP_MUL: LANES(mul);
+            case OP_DIV: LANES(divide);
+            case OP_MOD: LANES(intmod);
+            case OP_SHL: LANES(shiftl);
+            case OP_SHR: LANES(shiftr);
+            case OP_AND: LANES(and);
+            case OP_OR: LANES(or);
+            case OP_XOR: LANES(xor);
+            case OP_LT: LANES(less_than);
+            case OP_GT: LANES(greater_than);
+            case OP_NOT: LANES1(not);
+            case OP_NEG: LANES1(negate);
+            case OP_LOW: LANES1(low);
+            case OP_HIGH: LANES1(high);
+        }
+    }
+
+    const int *r = block_regs[p->result];
+    const int vr = varying[p->result];
+    for (i = 0; i < n; ++i) {
+        out[i] = vr ? r[i] : r[0];
+    }
+    return 1;
+}
+
+#undef LANES
+#undef LANES1
+
+int te_reads(const te_program *p, int var) {
+    const te_instr *ip;
+    if (!p->lowered) return 1;
+    if (p->result == var) return 1;
+    for (ip = p->code; ip->op != OP_END; ++ip) {
+        if (ip->a == var || ip->b == var) return 1;
+    }
+    return 0;
+}
+
+
+/* Images */
+
+int te_save(const te_program *p, te_image *im) {
+    int len = 0;
+
+    memset(im, 0, sizeof(*im));
+    if (!p->lowered || TE_PROGRAM_REGS - p->consts > TE_IMAGE_CONSTS) return 0;
+
+    while (p->code[len].op != OP_END) ++len;
+    memcpy(im->code, p->code, len * sizeof(te_instr));
+    memcpy(im->values, &p->regs[p->consts], (TE_PROGRAM_REGS - p->consts) * sizeof(int));
+    im->var_count = p->var_count;
+    im->len = len;
+    im->consts = p->consts;
+    im->result = p->result;
+    im->version = TE_IMAGE_VERSION;
+    return 1;
+}
+
+int te_load(const te_image *im, const te_variable *variables, int var_count, te_program *p) {
+    int i;
+
+    te_lower(0, 0, 0, p);
+    if (im->version != TE_IMAGE_VERSION || im->var_count != var_count || var_count > TE_PROGRAM_VARS) return 0;
+    if (im->len > TE_PROGRAM_LEN || im->consts < var_count || TE_PROGRAM_REGS - im->consts > TE_IMAGE_CONSTS) return 0;
+    if (im->result >= TE_PROGRAM_REGS) return 0;
+
+    /* Temporaries are written only between the variables and the constants */
+    for (i = 0; i < im->len; ++i) {
+        const te_instr *in = &im->code[i];
+        if (in->op >= OP_COMMA || in->dst < var_count || in->dst >= im->consts) return 0;
+        if (in->a >= TE_PROGRAM_REGS || in->b >= TE_PROGRAM_REGS) return 0;
+    }
+
+    memcpy(p->code, im->code, im->len * sizeof(te_instr));
+    p->code[im->len].op = OP_END;
+    memcpy(&p->regs[im->consts], im->values, (TE_PROGRAM_REGS - im->consts) * sizeof(int));
+    for (i = 0; i < var_count; ++i) {
+        p->bound[i] = variables[i].address;
+    }
+    p->var_count = var_count;
+    p->result = im->result;
+    p->consts = im->consts;
+    p->lowered = 1;
+    return 1;
+}
@@ -29,6 +29,9 @@
  * low and high
  *
  * My apologies to the original author for such a sloppy hack :) 
+ *
+ * te_lower and te_run turn a compiled expression into register bytecode, so
+ * uploaded formulas don't have to walk the tree every sample.
  */
 
 
@@ -89,6 +92,70 @@ void te_print(const te_expr *n);
 void te_free(te_expr *n);
 
 
+/* Register bytecode for a compiled expression, so it can be run without walking
+ * the tree. The register file holds the bound variables first, temporaries up from
+ * there, and the expression's constants down from the top. */
+#define TE_PROGRAM_VARS 8
+#define TE_PROGRAM_REGS 128
+#define TE_PROGRAM_LEN 64
+
+typedef struct te_instr {
+    unsigned char op, dst, a, b; /* regs[dst] = regs[a] op regs[b] */
+} te_instr;
+
+typedef struct te_program {
+    int regs[TE_PROGRAM_REGS];
+    te_instr code[TE_PROGRAM_LEN + 1];
+    const int *bound[TE_PROGRAM_VARS];
+    int var_count;
+    int result;  /* register holding the value of the expression */
+    int consts;  /* lowest register holding a constant */
+    int lowered; /* 0 if the expression didn't fit, and is evaluated from tree instead */
+    const te_expr *tree;
+} te_program;
+
+/* Lowers an expression from te_compile, with the same variables, into p.
+ * Constant subexpressions are folded. Returns 0 if the expression is too big
+ * for a te_program, in which case te_run falls back to te_eval on the tree,
+ * so the tree must be kept until p is no longer used. NULL clears p. */
+int te_lower(const te_expr *n, const te_variable *variables, int var_count, te_program *p);
+
+/* Evaluates a lowered expression, reading the variables as te_eval does. */
+int te_run(te_program *p);
+
+/* Evaluates a lowered expression for n (up to TE_BLOCK) values of variable var,
+ * first, first + step, ..., into out, with the other variables as they are now.
+ * Each instruction is run across the whole block before the next, so dispatch is
+ * paid once per block. Returns 0, leaving out alone, if p isn't lowered. */
+#define TE_BLOCK 32
+int te_run_block(te_program *p, int var, int first, int step, int n, int *out);
+
+/* Whether a lowered expression reads variable var at all */
+int te_reads(const te_program *p, int var);
+
+/* A lowered expression with no pointers in it, to be kept (e.g. in flash) and
+ * loaded again without te_compile. The version changes whenever the bytecode
+ * does, so images from older firmware are turned down rather than misread. */
+#define TE_IMAGE_VERSION 1
+#define TE_IMAGE_CONSTS 48
+
+typedef struct te_image {
+    unsigned short version; /* TE_IMAGE_VERSION, or 0 if there is no program */
+    unsigned char var_count, len, consts, result, pad[2];
+    te_instr code[TE_PROGRAM_LEN];
+    int values[TE_IMAGE_CONSTS]; /* regs[consts] up to the top */
+} te_image;
+
+/* Saves a lowered expression to im. Returns 0, with im->version 0, if p isn't
+ * lowered or has more than TE_IMAGE_CONSTS constants. */
+int te_save(const te_program *p, te_image *im);
+
+/* Loads an image from te_save into p, binding the same variables as it was
+ * lowered with. The image is checked before use: returns 0, clearing p, if it
+ * is from another version, for other variables, or not valid bytecode. */
+int te_load(const te_image *im, const te_variable *variables, int var_count, te_program *p);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,493 @@
+#include "ComputerCard.h"
+#include "pico/stdlib.h" // for getchar_timeout_us
+#include <cstdio>
+#include <cstring>
+
+#include "formulas.h"
+#include "tinyexpr_bitw.h"
+
+/*
+
+Bytebeat, as a ComputerCard
+
+The same formulas and controls as the Arduino sketch in "Arduino Code", with
+the bytebeat clock kept by ProcessSample at a fixed audio rate, so that the
+pitch no longer depends on how long a formula takes to evaluate.
+
+Core 1 renders frames of all four outputs, for a block of consecutive
+values of t at a time, into a Ring. ProcessSample steps through them at the
+bytebeat sample rate (set by the main knob and CV 2), holding each frame
+until the next. Blocks are shorter at low bytebeat rates, so that knob
+changes are heard within a few milliseconds; changing formula, resetting
+or reversing drops the frames already rendered and starts again.
+
+Core 1 also reads formulas sent from bytebeat.html over USB serial, and
+saves the user slots to flash with FlashStore, while the audio carries on.
+Each slot is saved with its lowered bytecode as well as its text, so at boot
+the slots are loaded straight into their te_programs, with no parsing or
+heap allocation; only a slot whose bytecode is missing, from an older
+firmware, or too long to lower is compiled from its text.
+
+
+User interface:
+---------------
+
+Main knob:     Speed (bytebeat sample rate, 20Hz - 8kHz)
+Knob X:        Bank/formula select
+Knob Y:        Parameter 1
+Switch up:     Built-in formulas
+Switch middle: User formulas
+Switch down:   Reset t (momentary)
+
+Audio in 1:    Parameter 1 modulation
+Audio in 2:    Parameter 2 modulation
+CV in 1:       Formula select modulation
+CV in 2:       Speed modulation
+Pulse in 1:    Reset t
+Pulse in 2:    Reverse
+
+Audio out 1:   Bytebeat
+Audio out 2:   Next bytebeat
+CV out 1:      Bytebeat at t/64 (slow)
+CV out 2:      Bytebeat at 8t (fast)
+Pulse out 1:   1-bit output (bitbeat)
+Pulse out 2:   t/16, as a clock
+
+ */
+
+// Audio rate of the card; the bytebeat sample rate is independent of this
+#ifndef BYTEBEAT_CARD_RATE
+#define BYTEBEAT_CARD_RATE SR48kHz
+#endif
+
+typedef uint32_t (*FormulaFunction)(uint32_t, uint8_t, uint32_t, uint32_t, uint32_t);
+
+static const FormulaFunction formulas[] = {
+	formula1, formula2, formula3, formula4, formula5,
+	formula6, formula7, formula8, formula9, formula10,
+	formula11, formula12, formula13, formula14, formula15,
+	formula16, formula17, formula18, formula19, formula20,
+	formula21, formula22, formula23, formula24, formula25,
+	formula26, formula27, formula28, formula29, formula30,
+	formula31, formula32, formula33, formula34, formula35,
+	formula36
+};
+
+class Bytebeat : public ComputerCard
+{
+	static constexpr int numFormulas = 36;
+	static constexpr int numSlots = 6;
+	static constexpr int maxExprLen = 95;
+
+	// One bytebeat sample of all four outputs
+	struct Frame
+	{
+		uint32_t t;
+		uint8_t out[4]; // Audio 1, Audio 2, CV 1, CV 2
+		uint32_t epoch;
+	};
+
+	// Everything the render depends on, sent every sample. A new epoch
+	// restarts the render at t = start, and frames of older epochs are dropped.
+	struct Controls
+	{
+		uint32_t epoch, start;
+		int32_t dir, rate, formula, slot, p1, p2, p3;
+		bool user;
+	};
+
+	// The text comes first, as it was all that older firmware saved
+	struct Slots
+	{
+		char expr[numSlots][maxExprLen];
+		te_image code[numSlots];
+	};
+
+	Ring<Frame, 64> frames;     // core 1 -> core 0
+	Ring<Controls, 4> controls; // core 0 -> core 1
+
+	// Core 0 state
+	Controls c;
+	Frame frame;
+	uint32_t phase;
+
+	// Core 1 state. Uploaded formulas read t, p1-p3 and w from these.
+	FlashStore<sizeof(Slots)> store;
+	Slots slots;
+	te_expr *exprs[numSlots], *liveExpr;
+	te_program progs[numSlots], liveProg;
+	bool live;
+	int tVar, p1Var, p2Var, p3Var, wVar;
+	char line[128], liveText[128];
+	int lineLen;
+
+public:
+	Bytebeat()
+	{
+		c.epoch = 0;
+		c.start = 0;
+		c.dir = 1;
+		c.rate = 8000;
+		c.formula = c.slot = 0;
+		c.p1 = 0;
+		c.p2 = 126;
+		c.p3 = 127;
+		c.user = false;
+		frame.t = 0;
+		frame.epoch = 0;
+		for (int i=0; i<4; i++) frame.out[i] = 128;
+		phase = 0;
+
+		memset(&slots, 0, sizeof(slots));
+		if (!store.Load(&slots, sizeof(slots))) store.Load(&slots.expr, sizeof(slots.expr));
+		liveExpr = nullptr;
+		te_lower(nullptr, nullptr, 0, &liveProg);
+		for (int i=0; i<numSlots; i++)
+		{
+			exprs[i] = nullptr;
+			te_lower(nullptr, nullptr, 0, &progs[i]);
+			slots.expr[i][maxExprLen - 1] = '\0';
+			if (slots.expr[i][0] && !Load(slots.code[i], progs[i])) Compile(slots.expr[i], exprs[i], progs[i]);
+		}
+		live = false;
+		liveText[0] = '\0';
+		lineLen = 0;
+
+		RunOnCore1(&Bytebeat::RenderLoop);
+	}
+
+	// Code for second RP2040 core, blocking
+	void RenderLoop()
+	{
+		Controls r{};
+		uint32_t t = 0, epoch = 0;
+		int32_t slot = 0;
+		bool started = false;
+		Frame block[TE_BLOCK];
+
+		while (1)
+		{
+			ReadSerial();
+			store.Service();
+
+			while (controls.Pop(r))
+			{
+				if (!started || r.epoch != epoch)
+				{
+					t = r.start;
+					epoch = r.epoch;
+					started = true;
+				}
+				// An uploaded formula plays until another user slot is chosen
+				if (r.user)
+				{
+					if (r.slot != slot) live = false;
+					slot = r.slot;
+				}
+			}
+			if (!started) continue;
+
+			// Blocks of about 2.5ms of bytebeat, with at most two waiting
+			int n = r.rate / 400;
+			if (n < 1) n = 1;
+			if (n > TE_BLOCK) n = TE_BLOCK;
+			if (frames.Size() >= unsigned(n)) continue;
+
+			if (r.user) RenderUser(r, t, n, block);
+			else RenderBuiltIn(r, t, n, block);
+			for (int i=0; i<n; i++)
+			{
+				block[i].epoch = epoch;
+				frames.Push(block[i]);
+			}
+			t += n * r.dir;
+		}
+	}
+
+	virtual void ProcessSample()
+	{
+		uint32_t epoch = c.epoch;
+
+		// Reverse on Pulse in 2, carrying on from the current t.
+		// Reset on Pulse in 1 or the switch pushed down.
+		if (PulseIn2RisingEdge())
+		{
+			c.dir = -c.dir;
+			c.start = frame.t + c.dir;
+			c.epoch = epoch + 1;
+		}
+		if (PulseIn1RisingEdge() || (SwitchChanged() && SwitchVal() == Switch::Down))
+		{
+			c.start = 0;
+			c.epoch = epoch + 1;
+		}
+
+		// The switch held down keeps the previous mode
+		bool user = c.user;
+		if (SwitchVal() == Switch::Up) user = false;
+		else if (SwitchVal() == Switch::Middle) user = true;
+
+		// CV and audio inputs scale the knobs by 0.5 to 1.5
+		int32_t index = (KnobVal(Knob::X) * 35) / 4000;
+		if (index > 35) index = 35;
+		int32_t cv1 = CVIn1() + 4096;
+		int32_t formula = ((index * cv1) >> 12) % numFormulas;
+		int32_t slot = (((index / 6) * cv1) >> 12) % numSlots;
+
+		if (user != c.user || (user ? slot != c.slot : formula != c.formula))
+		{
+			if (c.epoch == epoch)
+			{
+				c.start = frame.t + c.dir;
+				c.epoch = epoch + 1;
+			}
+			c.user = user;
+			c.formula = formula;
+			c.slot = slot;
+		}
+
+		c.p1 = ((((KnobVal(Knob::Y) * 255) / 4095) * (AudioIn1() + 4096)) >> 12) % 255;
+		c.p2 = ((126 * (AudioIn2() + 4096)) >> 12) % 255;
+		c.p3 = 127;
+		c.rate = ((20 + (KnobVal(Knob::Main) * 7980) / 4095) * (CVIn2() + 4096)) >> 12;
+
+		// Drop frames rendered before a reset, reverse or change of formula
+		Frame f;
+		if (c.epoch != epoch)
+		{
+			while (frames.Pop(f)) {}
+		}
+		controls.Push(c);
+
+		// Step to the next frame at the bytebeat rate, or hold this one if core 1 is behind
+		phase += (c.rate << 16) / SampleRate();
+		while (phase >= 0x10000)
+		{
+			phase -= 0x10000;
+			while (frames.Pop(f))
+			{
+				if (f.epoch == c.epoch)
+				{
+					frame = f;
+					break;
+				}
+			}
+		}
+
+		AudioOut1(AudioValue(frame.out[0]));
+		AudioOut2(AudioValue(frame.out[1]));
+		CVOut1Precise(CVValue(frame.out[2]));
+		CVOut2Precise(CVValue(frame.out[3]));
+		PulseOut1(frame.out[0] & 1);
+		PulseOut2((frame.t >> 4) & 1);
+
+		// Built-in: bright LED shows bank, dim LED shows formula. User: LED shows slot
+		for (int i=0; i<6; i++) LedOff(i);
+		if (c.user)
+		{
+			LedBrightness(c.slot, 4095);
+		}
+		else
+		{
+			LedBrightness(c.formula % 6, 1000);
+			LedBrightness(c.formula / 6, 4095);
+		}
+	}
+
+private:
+	// 8-bit bytebeat to the full output ranges, 255 reaching the top
+	static int16_t __not_in_flash_func(AudioValue)(uint8_t b)
+	{
+		return (b - 128) * 16 + (b == 255 ? 15 : 0);
+	}
+	static int32_t __not_in_flash_func(CVValue)(uint8_t b)
+	{
+		return (b - 128) * 2048 + (b == 255 ? 2047 : 0);
+	}
+
+	// labs on the RP2040, where long is 32 bits, as the sketch passed t to the formulas
+	static uint32_t Labs(uint32_t t)
+	{
+		return int32_t(t) < 0 ? -t : t;
+	}
+
+	// Built-in formulas feed back their last output as w, so are run a sample at a time
+	void RenderBuiltIn(const Controls &r, uint32_t t0, int n, Frame *block)
+	{
+		FormulaFunction f = formulas[r.formula];
+		int32_t next = r.formula + 1;
+		if (next > 32) next = 32;
+		FormulaFunction fNext = formulas[next];
+
+		for (int i=0; i<n; i++)
+		{
+			uint32_t t = t0 + i * r.dir;
+			Frame &b = block[i];
+			b.t = t;
+			wVar = f(Labs(t), wVar, r.p1, r.p2, r.p3);
+			b.out[0] = wVar;
+			b.out[1] = fNext(Labs(t), wVar, r.p1, r.p2, r.p3);
+			b.out[2] = f(Labs(t >> 6), wVar, r.p1, r.p2, r.p3);
+			b.out[3] = f(Labs(t << 3), wVar, r.p1, r.p2, r.p3);
+		}
+	}
+
+	// User formulas are rendered a block at a time, unless they read w
+	void RenderUser(const Controls &r, uint32_t t0, int n, Frame *block)
+	{
+		te_program *p = live ? &liveProg : &progs[r.slot];
+		te_program *pNext = &progs[r.slot < numSlots - 1 ? r.slot + 1 : numSlots - 1];
+		p1Var = r.p1;
+		p2Var = r.p2;
+		p3Var = r.p3;
+
+		for (int i=0; i<n; i++) block[i].t = t0 + i * r.dir;
+
+		if (te_reads(p, 4) || te_reads(pNext, 4))
+		{
+			for (int i=0; i<n; i++)
+			{
+				uint32_t t = block[i].t;
+				tVar = t;
+				wVar = te_run(p);
+				block[i].out[0] = wVar;
+				block[i].out[1] = te_run(pNext);
+				tVar = t >> 6;
+				block[i].out[2] = te_run(p);
+				tVar = t << 3;
+				block[i].out[3] = te_run(p);
+			}
+			return;
+		}
+
+		int out[3][TE_BLOCK];
+		te_run_block(p, 0, t0, r.dir, n, out[0]);
+		te_run_block(pNext, 0, t0, r.dir, n, out[1]);
+		te_run_block(p, 0, t0 << 3, r.dir * 8, n, out[2]);
+
+		// t/64 takes at most two values over a block
+		uint32_t slowFirst = t0 >> 6, slowLast = block[n - 1].t >> 6;
+		tVar = slowFirst;
+		int a = te_run(p);
+		tVar = slowLast;
+		int b = te_run(p);
+
+		for (int i=0; i<n; i++)
+		{
+			block[i].out[0] = out[0][i];
+			block[i].out[1] = out[1][i];
+			block[i].out[2] = (block[i].t >> 6) == slowFirst ? a : b;
+			block[i].out[3] = out[2][i];
+		}
+		wVar = out[0][n - 1];
+	}
+
+	// Compile and lower a formula, replacing the old one
+	bool Compile(const char *text, te_expr *&expr, te_program &prog)
+	{
+		te_variable vars[numVars];
+		Variables(vars);
+
+		te_lower(nullptr, nullptr, 0, &prog);
+		te_free(expr);
+
+		int err;
+		expr = te_compile(text, vars, numVars, &err);
+		if (!expr)
+		{
+			printf("error compiling: %d\n", err);
+			return false;
+		}
+		if (!te_lower(expr, vars, numVars, &prog))
+		{
+			printf("formula too long for bytecode, running it from the tree\n");
+		}
+		return true;
+	}
+
+	// Load a slot's saved bytecode, returning false if it can't be used
+	bool Load(const te_image &code, te_program &prog)
+	{
+		te_variable vars[numVars];
+		Variables(vars);
+		return te_load(&code, vars, numVars, &prog);
+	}
+
+	// The variables formulas can read, in the order they're lowered with
+	static constexpr int numVars = 5;
+	void Variables(te_variable *vars)
+	{
+		static char names[numVars][3] = {"t", "p1", "p2", "p3", "w"};
+		int *addresses[numVars] = {&tVar, &p1Var, &p2Var, &p3Var, &wVar};
+		for (int i=0; i<numVars; i++) vars[i] = {names[i], addresses[i], 0, 0};
+	}
+
+	// Lines from bytebeat.html: a formula to play at once, or _SAVE1-6 to save
+	// the last one to a user slot, or _CLEAR to empty them all
+	void ReadSerial()
+	{
+		int ch;
+		while ((ch = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT)
+		{
+			if (ch == '\r') continue;
+			if (ch != '\n')
+			{
+				if (lineLen < int(sizeof(line)) - 1) line[lineLen++] = ch;
+				continue;
+			}
+			line[lineLen] = '\0';
+			lineLen = 0;
+
+			if (line[0] != '_')
+			{
+				printf("Formula Recieved!\n");
+				strcpy(liveText, line);
+				live = Compile(line, liveExpr, liveProg);
+			}
+			else if (!strncmp(line, "_SAVE", 5) && line[5] >= '1' && line[5] < '1' + numSlots && !line[6])
+			{
+				int slot = line[5] - '1';
+				if (!liveText[0])
+				{
+					printf("Error: no formula to save.\n");
+				}
+				else if (strlen(liveText) >= maxExprLen)
+				{
+					printf("Error: Expression length exceeds maximum allowed length.\n");
+				}
+				else
+				{
+					strcpy(slots.expr[slot], liveText);
+					Compile(slots.expr[slot], exprs[slot], progs[slot]);
+					te_save(&progs[slot], &slots.code[slot]);
+					store.Save(&slots, sizeof(slots));
+					printf("User Slot %d Saved\n", slot + 1);
+				}
+			}
+			else if (!strcmp(line, "_CLEAR"))
+			{
+				for (int i=0; i<numSlots; i++)
+				{
+					slots.expr[i][0] = '\0';
+					slots.code[i].version = 0;
+					te_lower(nullptr, nullptr, 0, &progs[i]);
+					te_free(exprs[i]);
+					exprs[i] = nullptr;
+				}
+				store.Save(&slots, sizeof(slots));
+				printf("Slots Cleared\n");
+			}
+		}
+	}
+};
+
+
+int main()
+{
+	stdio_init_all();
+
+	// Static, as the programs and frame buffers are too big for the stack
+	static Bytebeat bb;
+	bb.EnableCVOutputDMA();
+	bb.Run(ComputerCard::BYTEBEAT_CARD_RATE);
+}
@@ -903,10 +903,12 @@ void DigitalOscillator::RenderStruckBell(
     }
   }
   
+  // Economy: only the lowest partials, which carry most of the energy
+  size_t num_partials = economy_ ? kNumEconomyBellPartials : kNumBellPartials;
   int16_t previous_sample = state_.add.previous_sample;
   while (size--) {
     int32_t out = 0;
-    for (size_t i = 0; i < kNumBellPartials; ++i) {
+    for (size_t i = 0; i < num_partials; ++i) {
       state_.add.partial_phase[i] += state_.add.partial_phase_increment[i];
       int32_t partial = Interpolate824(wav_sine, state_.add.partial_phase[i]);
       out += partial * state_.add.partial_amplitude[i] >> 17;
@@ -928,6 +930,7 @@ void DigitalOscillator::RenderHarmonics(
   uint32_t phase_increment = phase_increment_ << 1;
   int32_t target_amplitude[kNumAdditiveHarmonics];
   int32_t amplitude[kNumAdditiveHarmonics];
+  size_t num_harmonics = economy_ ? kNumEconomyAdditiveHarmonics : kNumAdditiveHarmonics;
   
   int32_t peak = (kNumAdditiveHarmonics * parameter_[0]) >> 7;
   int32_t second_peak = (peak >> 1) + kNumAdditiveHarmonics * 128;
@@ -938,7 +941,7 @@ void DigitalOscillator::RenderHarmonics(
   int32_t sqrt_width = sqrtsqrt_width * sqrtsqrt_width >> 10;
   int32_t width = sqrt_width * sqrt_width + 4;
   int32_t total = 0;
-  for (size_t i = 0; i < kNumAdditiveHarmonics; ++i) {
+  for (size_t i = 0; i < num_harmonics; ++i) {
     int32_t x = i << 8;
     int32_t d, g;
 
@@ -953,7 +956,7 @@ void DigitalOscillator::RenderHarmonics(
   
   int32_t attenuation = 2147483647 / total;
   for (size_t i = 0; i < kNumAdditiveHarmonics; ++i) {
-    if ((phase_increment >> 16) * (i + 1) > 0x4000) {
+    if (i >= num_harmonics || (phase_increment >> 16) * (i + 1) > 0x4000) {
       target_amplitude[i] = 0;
     } else {
       target_amplitude[i] = target_amplitude[i] * attenuation >> 16;
@@ -969,7 +972,7 @@ void DigitalOscillator::RenderHarmonics(
       phase = 0;
     }
     out = 0;
-    for (size_t i = 0; i < kNumAdditiveHarmonics; ++i) {
+    for (size_t i = 0; i < num_harmonics; ++i) {
       out += Interpolate824(wav_sine, phase * (i + 1)) * amplitude[i] >> 15;
       amplitude[i] += (target_amplitude[i] - amplitude[i]) >> 8;
     }
@@ -982,7 +985,8 @@ void DigitalOscillator::RenderHarmonics(
   state_.add.previous_sample = previous_sample;
   phase_ = phase;
   for (size_t i = 0; i < kNumAdditiveHarmonics; ++i) {
-    state_.hrm.amplitude[i] = amplitude[i];
+    // Harmonics left out restart from silence when they come back
+    state_.hrm.amplitude[i] = i < num_harmonics ? amplitude[i] : 0;
   }
 }
 
@@ -1034,6 +1038,9 @@ void DigitalOscillator::RenderStruckDrum(
   int32_t noise_mode_gain = parameter_[1] < 16384 ? 0 : parameter_[1] - 16384;
   noise_mode_gain = noise_mode_gain * 12888 >> 14;
 
+  // Economy: the partials above the noise modes only add to the harmonics
+  size_t num_partials = economy_ ? kNumEconomyDrumPartials : kNumDrumPartials;
+
   int32_t fade_increment = 65536 / size;
   int32_t fade = 0;
   while (size--) {
@@ -1052,7 +1059,7 @@ void DigitalOscillator::RenderStruckDrum(
     lp_state_2 += (lp_state_1 - lp_state_2) * f >> 15;
 
     int32_t partials[kNumDrumPartials];
-    for (size_t i = 0; i < kNumDrumPartials; ++i) {
+    for (size_t i = 0; i < num_partials; ++i) {
       AdditiveState* a = &state_.add;
       a->partial_phase[i] += a->partial_phase_increment[i];
       int32_t partial = Interpolate824(wav_sine, a->partial_phase[i]);
@@ -1137,9 +1144,16 @@ void DigitalOscillator::RenderPlucked(
   
   int16_t previous_sample = state_.plk[0].previous_sample;
 
+  // Economy: let the oldest string go quiet
+  size_t skipped_voice = economy_
+      ? (active_voice_ + 1) % kNumPluckVoices : kNumPluckVoices;
+
   while (size) {
     int32_t sample = 0;
     for (size_t i = 0; i < kNumPluckVoices; ++i) {
+      if (i == skipped_voice) {
+        continue;
+      }
       PluckState* p = &state_.plk[i];
       int16_t* dl = delay_lines_.ks + i * 1025;
       // Initialization: Just use a white noise sample and fill the delay
@@ -2017,13 +2031,16 @@ void DigitalOscillator::RenderGranularCloud(
     int16_t* buffer,
     size_t size) {
   
-  for (size_t i = 0; i < 4; ++i) {
+  // Economy: two grains rather than four, each twice as likely to start
+  size_t num_grains = economy_ ? 2 : 4;
+  uint32_t start_probability = economy_ ? 0x8000 : 0x4000;
+  for (size_t i = 0; i < num_grains; ++i) {
     Grain* g = &state_.grain[i];
     // If a grain has reached the end of its envelope, reset it.
     if (g->envelope_phase > (1 << 24) ||
         g->envelope_phase_increment == 0) {
       g->envelope_phase_increment = 0;
-      if ((Random::GetWord() & 0xffff) < 0x4000) {
+      if ((Random::GetWord() & 0xffff) < start_probability) {
         g->envelope_phase_increment = \
             lut_granular_envelope_rate[parameter_[0] >> 7] << 3;
         g->envelope_phase = 0;
@@ -2053,6 +2070,12 @@ void DigitalOscillator::RenderGranularCloud(
     sample += Interpolate824(wav_sine, state_.grain[1].phase) * \
         lut_granular_envelope[state_.grain[1].envelope_phase >> 16] >> 17;
 
+    if (num_grains == 2) {
+      CLIP(sample)
+      *buffer++ = sample;
+      continue;
+    }
+
     state_.grain[2].phase += state_.grain[2].phase_increment;
     state_.grain[2].envelope_phase += state_.grain[2].envelope_phase_increment;
     sample += Interpolate824(wav_sine, state_.grain[2].phase) * \
@@ -51,6 +51,9 @@ static const size_t kNumOverlappingFof = 3;
 static const size_t kNumBellPartials = 11;
 static const size_t kNumDrumPartials = 6;
 static const size_t kNumAdditiveHarmonics = 12;
+static const size_t kNumEconomyBellPartials = 6;
+static const size_t kNumEconomyDrumPartials = 4;
+static const size_t kNumEconomyAdditiveHarmonics = 6;
 
 enum DigitalOscillatorShape {
   OSC_SHAPE_TRIPLE_RING_MOD,
@@ -255,6 +258,7 @@ class DigitalOscillator {
     phase_ = 0;
     strike_ = true;
     init_ = true;
+    economy_ = false;
   }
   
   inline void set_shape(DigitalOscillatorShape shape) {
@@ -285,6 +289,12 @@ class DigitalOscillator {
     strike_ = true;
   }
 
+  // Cheaper variants of the heaviest shapes (fewer partials, grains, strings),
+  // for when rendering is running out of time
+  inline void set_economy(bool economy) {
+    economy_ = economy;
+  }
+
   void Render(const uint8_t* sync, int16_t* buffer, size_t size);
   
  private:
@@ -351,6 +361,7 @@ class DigitalOscillator {
   
   bool init_;
   bool strike_;
+  bool economy_;
 
   DigitalOscillatorShape shape_;
   DigitalOscillatorShape previous_shape_;
@@ -2,6 +2,8 @@
 
 #include <string.h>
 
+#include "hardware/clocks.h"
+
 namespace braids {
   
 void Dac::Init() {
@@ -16,4 +18,53 @@ void Dac::Init() {
   gpio_set_function(PIN_CS, GPIO_FUNC_SPI);
 }
 
+void Dac::Start(const int16_t* ring, size_t size, uint32_t sample_rate) {
+  ring_ = ring;
+
+  // Pace the words with a DMA timer running at sample_rate / system clock. The ADC clock and
+  // the system clock come from the same crystal, so once reduced this is exact for the usual
+  // system clocks, and the DAC keeps in step with the ADC
+  uint32_t num = sample_rate;
+  uint32_t den = clock_get_hz(clk_sys);
+  uint32_t a = num, b = den;
+  while (b) {
+    uint32_t t = a % b;
+    a = b;
+    b = t;
+  }
+  num /= a;
+  den /= a;
+  while (num > 0xffff || den > 0xffff) {
+    num >>= 1;
+    den >>= 1;
+  }
+  num_ = num;
+  den_ = den;
+  timer_ = dma_claim_unused_timer(true);
+  dma_timer_set_fraction(timer_, num_, den_);
+
+  data_dma_ = dma_claim_unused_channel(true);
+  control_dma_ = dma_claim_unused_channel(true);
+
+  // Data: the ring into the SPI FIFO, then hand over to the control channel
+  dma_channel_config cfg = dma_channel_get_default_config(data_dma_);
+  channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+  channel_config_set_read_increment(&cfg, true);
+  channel_config_set_write_increment(&cfg, false);
+  channel_config_set_dreq(&cfg, dma_get_timer_dreq(timer_));
+  channel_config_set_chain_to(&cfg, control_dma_);
+  dma_channel_configure(
+      data_dma_, &cfg, &spi_get_hw(DAC_SPI_PORT)->dr, ring, size, false);
+
+  // Control: point the data channel back at the start of the ring, which restarts it
+  cfg = dma_channel_get_default_config(control_dma_);
+  channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+  channel_config_set_read_increment(&cfg, false);
+  channel_config_set_write_increment(&cfg, false);
+  dma_channel_configure(
+      control_dma_, &cfg, &dma_hw->ch[data_dma_].al3_read_addr_trig, &ring_, 1, false);
+
+  dma_channel_start(data_dma_);
+}
+
 }  // namespace braids
@@ -4,6 +4,7 @@
 #include "stmlib/stmlib.h"
 #include "hardware/gpio.h"
 #include "hardware/spi.h"
+#include "hardware/dma.h"
 
 #define PIN_SCK             18
 #define PIN_MOSI            19
@@ -21,12 +22,34 @@ class Dac {
   ~Dac() { }
   
   void Init();
+
+  // Stream ring, size words made by Word(), to the DAC over and over, one word per sample at
+  // sample_rate, by DMA. The CPU only has to keep ahead of it a block at a time
+  void Start(const int16_t* ring, size_t size, uint32_t sample_rate);
+
+  // Hold the last word rather than go round the ring, e.g. while the CPU can't render
+  inline void Pause() {
+    dma_timer_set_fraction(timer_, 0, den_);
+  }
+  inline void Resume() {
+    dma_timer_set_fraction(timer_, num_, den_);
+  }
+
+  static inline uint16_t Word(uint16_t value) {
+    return DAC_config_chan_A_gain | (value & 0x0fff);
+  }
   inline void Write(uint16_t value) {
-    uint16_t DAC_data = DAC_config_chan_A_gain | (value & 0x0fff);
+    uint16_t DAC_data = Word(value);
     spi_write16_blocking(DAC_SPI_PORT, &DAC_data, 1);
   }
  
  private:
+  const int16_t* ring_;  // Read by the control DMA, to rewind the data DMA
+  uint8_t data_dma_;
+  uint8_t control_dma_;
+  uint8_t timer_;
+  uint16_t num_;
+  uint16_t den_;
   
   DISALLOW_COPY_AND_ASSIGN(Dac);
 };
@@ -0,0 +1,30 @@
+#include "braids/drivers/sync_in.h"
+
+#include "hardware/pio_instructions.h"
+
+namespace braids {
+
+void SyncIn::Init(uint8_t pin, uint8_t clock_pin, size_t samples) {
+  pio_ = pio0;
+  sm_ = pio_claim_unused_sm(pio_, true);
+
+  // Small enough to assemble here rather than with pioasm
+  uint16_t instructions[] = {
+    static_cast<uint16_t>(pio_encode_wait_gpio(false, clock_pin)),
+    static_cast<uint16_t>(pio_encode_in(pio_pins, 1)),
+    static_cast<uint16_t>(pio_encode_wait_gpio(true, clock_pin)),
+  };
+  pio_program_t program = { instructions, 3, -1 };
+  uint offset = pio_add_program(pio_, &program);
+
+  pio_sm_config config = pio_get_default_sm_config();
+  sm_config_set_wrap(&config, offset, offset + 2);
+  sm_config_set_in_pins(&config, pin);
+  // Shift left, so the oldest sample ends up the most significant, and push every block
+  sm_config_set_in_shift(&config, false, true, samples);
+  sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_RX);
+  pio_sm_init(pio_, sm_, offset, &config);
+  pio_sm_set_enabled(pio_, sm_, true);
+}
+
+}  // namespace braids
@@ -0,0 +1,39 @@
+#ifndef BRAIDS_DRIVERS_SYNC_IN_H_
+#define BRAIDS_DRIVERS_SYNC_IN_H_
+
+#include "stmlib/stmlib.h"
+#include "hardware/pio.h"
+
+namespace braids {
+
+// Samples a pulse input once per DAC word, by PIO: the state machine waits for the DAC's chip
+// select to go low, reads the pin, and pushes a word every block of samples, so the samples
+// line up with the audio without any work per sample.
+class SyncIn {
+ public:
+  SyncIn() { }
+  ~SyncIn() { }
+
+  // pin: input to sample. clock_pin: DAC chip select. samples: samples per word, at most 32
+  void Init(uint8_t pin, uint8_t clock_pin, size_t samples);
+
+  // Next block of raw pin levels, the oldest in the most significant bit.
+  // Returns false if no block is ready yet
+  inline bool Read(uint32_t* levels) {
+    if (pio_sm_is_rx_fifo_empty(pio_, sm_)) {
+      return false;
+    }
+    *levels = pio_sm_get(pio_, sm_);
+    return true;
+  }
+
+ private:
+  PIO pio_;
+  uint sm_;
+
+  DISALLOW_COPY_AND_ASSIGN(SyncIn);
+};
+
+}  // namespace braids
+
+#endif  // BRAIDS_DRIVERS_SYNC_IN_H_
@@ -80,6 +80,10 @@ class MacroOscillator {
   inline void Strike() {
     digital_oscillator_.Strike();
   }
+
+  inline void set_economy(bool economy) {
+    digital_oscillator_.set_economy(economy);
+  }
   
   void Render(const uint8_t* sync_buffer, int16_t* buffer, size_t size);
   
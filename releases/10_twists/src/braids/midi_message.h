@@ -4,8 +4,14 @@
 #ifndef BRAIDS_MIDI_MESSAGE_H_
 #define BRAIDS_MIDI_MESSAGE_H_
 
+#include <cstddef>
+#include <cstdint>
+#include "hardware/sync.h"
+
 struct MIDIMessage
 {
+	MIDIMessage() : command(Command::Unknown), channel(0), pitchbend(0) {}
+
 	// Parse a MIDI message from the raw packet data
 	MIDIMessage(uint8_t* packet)
 	{
@@ -60,4 +66,49 @@ struct MIDIMessage
 	};
 };
 
+// Lock-free queue of messages from the USB worker (core1) to the renderer (core0).
+// Single producer, single consumer; N must be a power of two. Fixed size, in SRAM, with
+// messages that arrive while it is full counted and dropped
+template <size_t N>
+class MIDIMessageQueue
+{
+public:
+	// Producer: false, dropping the message, if the queue is full
+	bool Push(const MIDIMessage& message)
+	{
+		uint32_t w = write_;
+		if (w - read_ >= N)
+		{
+			dropped_ = dropped_ + 1;
+			return false;
+		}
+		messages_[w & (N - 1)] = message;
+		__dmb(); // Message lands before the index that publishes it
+		write_ = w + 1;
+		return true;
+	}
+
+	// Consumer: false if the queue is empty
+	bool Pop(MIDIMessage& message)
+	{
+		uint32_t r = read_;
+		if (r == write_) return false;
+		__dmb(); // See the index before the message it publishes
+		message = messages_[r & (N - 1)];
+		__dmb(); // Finish with the message before handing its slot back
+		read_ = r + 1;
+		return true;
+	}
+
+	// Messages dropped by Push because the queue was full
+	uint32_t Dropped() const { return dropped_; }
+
+private:
+	static_assert((N & (N - 1)) == 0, "MIDIMessageQueue size must be a power of two");
+	MIDIMessage messages_[N];
+	volatile uint32_t write_ = 0;
+	volatile uint32_t read_ = 0;
+	volatile uint32_t dropped_ = 0;
+};
+
 #endif
\ No newline at end of file
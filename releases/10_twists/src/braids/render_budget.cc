@@ -0,0 +1,85 @@
+// Render time budget: per-shape cycle costs, and adaptive quality
+
+#include "braids/render_budget.h"
+
+#include <algorithm>
+
+namespace braids {
+
+using namespace std;
+
+void RenderBudget::Init(uint32_t block_cycles) {
+  block_cycles_ = block_cycles;
+  load_ = 0;
+  economy_ = false;
+  fill(&shape_cycles_[0][0], &shape_cycles_[MACRO_OSC_SHAPE_LAST][0], 0);
+  fill(&shape_xip_misses_[0], &shape_xip_misses_[MACRO_OSC_SHAPE_LAST], 0);
+
+  // Free-running from the processor clock
+  systick_hw->csr = 0;
+  systick_hw->rvr = 0xffffff;
+  systick_hw->cvr = 0;
+  systick_hw->csr = 5;
+}
+
+void RenderBudget::Benchmark(
+    MacroOscillator* osc,
+    const uint8_t* sync,
+    int16_t* buffer,
+    size_t size) {
+  // Some shapes cost more at one end of TIMBRE (more partials, denser grains)
+  static const int16_t kTimbres[] = { 0, 16384, 32767 };
+
+  for (int32_t s = 0; s < MACRO_OSC_SHAPE_LAST; ++s) {
+    MacroOscillatorShape shape = static_cast<MacroOscillatorShape>(s);
+    for (size_t economy = 0; economy < 2; ++economy) {
+      osc->Init();
+      osc->set_economy(economy);
+      osc->set_shape(shape);
+      osc->set_pitch(60 << 7);
+      uint32_t worst = 0;
+      uint32_t worst_misses = 0;
+      for (size_t t = 0; t < sizeof(kTimbres) / sizeof(kTimbres[0]); ++t) {
+        osc->set_parameters(kTimbres[t], 16384);
+        osc->Strike();
+        for (size_t b = 0; b < kBenchmarkBlocks; ++b) {
+          // Flash reads, code included, that missed the cache (writing clears the counters)
+          xip_ctrl_hw->ctr_hit = 0;
+          xip_ctrl_hw->ctr_acc = 0;
+          uint32_t start = systick_hw->cvr;
+          osc->Render(sync, buffer, size);
+          worst = max(worst, Elapsed(start));
+          worst_misses = max(worst_misses, xip_ctrl_hw->ctr_acc - xip_ctrl_hw->ctr_hit);
+        }
+      }
+      shape_cycles_[s][economy] = worst;
+      if (!economy) {
+        shape_xip_misses_[s] = worst_misses;
+      }
+    }
+  }
+  osc->Init();
+}
+
+bool RenderBudget::EndBlock(MacroOscillatorShape shape, size_t voices) {
+  load_ = (load_ * 7 + Elapsed(start_)) >> 3;
+
+  // What the oscillators should have taken, and what they would take at full quality. The
+  // rest of the load (envelope, mix, waveshaper, interrupts) is assumed to stay the same
+  uint32_t predicted = shape_cycles(shape, economy_) * voices;
+  uint32_t full = shape_cycles(shape, false) * voices;
+  uint32_t overhead = load_ > predicted ? load_ - predicted : 0;
+
+  uint32_t high = block_cycles_ / 100 * kHighLoad;
+  uint32_t low = block_cycles_ / 100 * kLowLoad;
+  if (!economy_) {
+    economy_ = load_ > high || overhead + full > high;
+  } else {
+    economy_ = overhead + full > low;
+  }
+  return economy_;
+}
+
+RenderBudget render_budget;
+
+}  // namespace braids
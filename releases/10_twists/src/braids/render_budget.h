@@ -0,0 +1,81 @@
+// Render time budget: per-shape cycle costs, and adaptive quality
+//
+// At boot, Benchmark() renders every shape for a few blocks at full and at economy quality
+// (see DigitalOscillator::set_economy), and keeps the worst cycles per block of each, timed with
+// SysTick, along with the worst XIP cache misses per block at full quality. After that, EndBlock() is given the cycles each RenderBlock actually took; once its
+// smoothed load goes over kHighLoad% of the time between blocks, the oscillators drop to economy
+// quality, and go back to full quality only once the table says full quality fits under kLowLoad%.
+// The table also makes the call straight away when the shape or the voice count changes, rather
+// than waiting to run late.
+
+#ifndef BRAIDS_RENDER_BUDGET_H_
+#define BRAIDS_RENDER_BUDGET_H_
+
+#include "stmlib/stmlib.h"
+#include "hardware/structs/systick.h"
+#include "hardware/structs/xip_ctrl.h"
+
+#include "braids/macro_oscillator.h"
+#include "braids/settings.h"
+
+namespace braids {
+
+class RenderBudget {
+ public:
+  RenderBudget() { }
+  ~RenderBudget() { }
+
+  // block_cycles: system clock cycles between two blocks, i.e. the deadline for each one
+  void Init(uint32_t block_cycles);
+
+  // Fill the table by rendering blocks of size samples with osc, which is re-initialised
+  // afterwards. Run before the audio interrupt is started, so nothing else is counted
+  void Benchmark(
+      MacroOscillator* osc,
+      const uint8_t* sync,
+      int16_t* buffer,
+      size_t size);
+
+  inline void BeginBlock() {
+    start_ = systick_hw->cvr;
+  }
+
+  // After rendering a block of shape, with voices oscillators on the busiest core.
+  // Returns whether the next block should be rendered at economy quality
+  bool EndBlock(MacroOscillatorShape shape, size_t voices);
+
+  inline uint32_t shape_cycles(MacroOscillatorShape shape, bool economy) const {
+    return shape_cycles_[shape][economy ? 1 : 0];
+  }
+  inline uint32_t shape_xip_misses(MacroOscillatorShape shape) const {
+    return shape_xip_misses_[shape];
+  }
+  inline uint32_t block_cycles() const { return block_cycles_; }
+  inline uint32_t load() const { return load_; }
+  inline bool economy() const { return economy_; }
+
+ private:
+  static const uint32_t kHighLoad = 85;
+  static const uint32_t kLowLoad = 70;
+  static const size_t kBenchmarkBlocks = 8;
+
+  // SysTick counts down, 24 bits
+  inline uint32_t Elapsed(uint32_t start) const {
+    return (start - systick_hw->cvr) & 0xffffff;
+  }
+
+  uint32_t shape_cycles_[MACRO_OSC_SHAPE_LAST][2];
+  uint32_t shape_xip_misses_[MACRO_OSC_SHAPE_LAST];
+  uint32_t block_cycles_;
+  uint32_t start_;
+  uint32_t load_;  // Smoothed cycles per block
+  bool economy_;
+
+  DISALLOW_COPY_AND_ASSIGN(RenderBudget);
+};
+
+extern RenderBudget render_budget;
+
+}  // namespace braids
+
+#endif  // BRAIDS_RENDER_BUDGET_H_
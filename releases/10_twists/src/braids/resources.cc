@@ -312,7 +312,7 @@ const uint16_t lut_svf_scale[] = {
     2890,   2701,   2499,   2280,
     2038,
 };
-const uint16_t lut_granular_envelope[] = {
+const uint16_t lut_granular_envelope[] BRAIDS_SRAM_TABLE = {
        0,      4,     19,     44,
       78,    123,    177,    241,
      314,    398,    490,    593,
@@ -510,7 +510,7 @@ const uint16_t lut_granular_envelope_rate[] = {
    31378,  31720,  32065,  32415,
    32768,
 };
-const uint16_t lut_bowing_envelope[] = {
+const uint16_t lut_bowing_envelope[] BRAIDS_SRAM_TABLE = {
        0,     10,     21,     32,
       43,     54,     65,     76,
       87,     98,    109,    120,
@@ -700,7 +700,7 @@ const uint16_t lut_bowing_envelope[] = {
     5242,   5242,   5242,   5242,
     5242,   5242,   5242,   5242,
 };
-const uint16_t lut_bowing_friction[] = {
+const uint16_t lut_bowing_friction[] BRAIDS_SRAM_TABLE = {
    32768,  32768,  32768,  32768,
    32768,  32768,  32768,  32768,
    32768,  32768,  32768,  32768,
@@ -767,7 +767,7 @@ const uint16_t lut_bowing_friction[] = {
       67,     66,     66,     65,
       64,
 };
-const uint16_t lut_blowing_envelope[] = {
+const uint16_t lut_blowing_envelope[] BRAIDS_SRAM_TABLE = {
        0,    178,    357,    536,
      715,    894,   1073,   1252,
     1431,   1610,   1789,   1968,
@@ -1003,7 +1003,7 @@ const uint16_t lut_vco_detune[] = {
    15913,  15971,  16029,  16086,
    16143,
 };
-const uint16_t lut_bell[] = {
+const uint16_t lut_bell[] BRAIDS_SRAM_TABLE = {
        0,    670,   2655,   5873,
    10191,  15434,  21387,  27805,
    34427,  40980,  47198,  52824,
@@ -1157,7 +1157,7 @@ const uint16_t* lookup_table_table[] = {
   lut_env_expo,
 };
 
-const int16_t lut_blowing_jet[] = {
+const int16_t lut_blowing_jet[] BRAIDS_SRAM_TABLE = {
        0,   -255,   -511,   -767,
    -1022,  -1278,  -1532,  -1786,
    -2039,  -2292,  -2544,  -2795,
@@ -1326,7 +1326,7 @@ const uint32_t* lookup_table_hr_table[] = {
   lut_env_portamento_increments,
 };
 
-const int16_t wav_formant_sine[] = {
+const int16_t wav_formant_sine[] BRAIDS_SRAM_TABLE = {
        0,      0,      0,      0,
        0,      0,      0,      0,
        0,      0,      0,      0,
@@ -1392,7 +1392,7 @@ const int16_t wav_formant_sine[] = {
       -7,     -8,    -10,    -12,
      -14,    -17,    -20,    -24,
 };
-const int16_t wav_formant_square[] = {
+const int16_t wav_formant_square[] BRAIDS_SRAM_TABLE = {
        0,      1,      1,      2,
        2,      3,      3,      4,
        4,      5,      6,      8,
@@ -1458,7 +1458,7 @@ const int16_t wav_formant_square[] = {
       -4,     -5,     -6,     -8,
       -9,    -11,    -13,    -16,
 };
-const int16_t wav_sine[] = {
+const int16_t wav_sine[] BRAIDS_SRAM_TABLE = {
   -32512, -32502, -32473, -32423,
   -32356, -32265, -32160, -32031,
   -31885, -31719, -31533, -31331,
@@ -1525,7 +1525,7 @@ const int16_t wav_sine[] = {
   -32356, -32423, -32473, -32502,
   -32512,
 };
-const int16_t wav_bandlimited_comb_0[] = {
+const int16_t wav_bandlimited_comb_0[] BRAIDS_SRAM_TABLE = {
     -142,   -146,   -143,   -139,
     -129,   -125,   -122,   -125,
     -133,   -142,   -146,   -146,
@@ -1592,7 +1592,7 @@ const int16_t wav_bandlimited_comb_0[] = {
     -124,   -124,   -129,   -135,
     -142,
 };
-const int16_t wav_bandlimited_comb_1[] = {
+const int16_t wav_bandlimited_comb_1[] BRAIDS_SRAM_TABLE = {
     -150,   -157,   -152,   -144,
     -132,   -121,   -119,   -125,
     -135,   -149,   -157,   -157,
@@ -1659,7 +1659,7 @@ const int16_t wav_bandlimited_comb_1[] = {
     -122,   -121,   -129,   -140,
     -150,
 };
-const int16_t wav_bandlimited_comb_2[] = {
+const int16_t wav_bandlimited_comb_2[] BRAIDS_SRAM_TABLE = {
     -159,   -164,   -128,   -110,
     -139,   -167,   -154,   -114,
     -116,   -153,   -171,   -138,
@@ -1726,7 +1726,7 @@ const int16_t wav_bandlimited_comb_2[] = {
     -167,   -144,   -112,   -125,
     -159,
 };
-const int16_t wav_bandlimited_comb_3[] = {
+const int16_t wav_bandlimited_comb_3[] BRAIDS_SRAM_TABLE = {
     -190,   -184,   -179,   -172,
     -166,   -156,   -150,   -143,
     -133,   -128,   -121,   -114,
@@ -1793,7 +1793,7 @@ const int16_t wav_bandlimited_comb_3[] = {
     -200,   -199,   -197,   -194,
     -190,
 };
-const int16_t wav_bandlimited_comb_4[] = {
+const int16_t wav_bandlimited_comb_4[] BRAIDS_SRAM_TABLE = {
     -201,    -92,   -117,   -221,
     -162,    -74,   -164,   -225,
     -112,    -86,   -211,   -197,
@@ -1860,7 +1860,7 @@ const int16_t wav_bandlimited_comb_4[] = {
     -218,   -129,    -88,   -193,
     -200,
 };
-const int16_t wav_bandlimited_comb_5[] = {
+const int16_t wav_bandlimited_comb_5[] BRAIDS_SRAM_TABLE = {
        0,   -130,   -195,   -104,
       21,     14,   -125,   -204,
     -116,     24,     26,   -117,
@@ -1927,7 +1927,7 @@ const int16_t wav_bandlimited_comb_5[] = {
     -135,   -187,    -94,     21,
        0,
 };
-const int16_t wav_bandlimited_comb_6[] = {
+const int16_t wav_bandlimited_comb_6[] BRAIDS_SRAM_TABLE = {
        0,   -260,     12,   -272,
       24,   -285,     38,   -298,
       50,   -310,     62,   -322,
@@ -1994,7 +1994,7 @@ const int16_t wav_bandlimited_comb_6[] = {
      -24,   -236,    -12,   -248,
        0,
 };
-const int16_t wav_bandlimited_comb_7[] = {
+const int16_t wav_bandlimited_comb_7[] BRAIDS_SRAM_TABLE = {
        0,   -101,   -495,    -60,
      -22,   -500,   -136,     49,
     -484,   -223,    106,   -442,
@@ -2061,7 +2061,7 @@ const int16_t wav_bandlimited_comb_7[] = {
     -422,     40,   -182,   -467,
        0,
 };
-const int16_t wav_bandlimited_comb_8[] = {
+const int16_t wav_bandlimited_comb_8[] BRAIDS_SRAM_TABLE = {
     -640,   -727,   -239,    149,
     -114,   -674,   -747,   -215,
      185,   -116,   -715,   -769,
@@ -2128,7 +2128,7 @@ const int16_t wav_bandlimited_comb_8[] = {
     -711,   -259,    118,   -112,
     -640,
 };
-const int16_t wav_bandlimited_comb_9[] = {
+const int16_t wav_bandlimited_comb_9[] BRAIDS_SRAM_TABLE = {
        0,   -521,  -1050,  -1263,
    -1024,   -465,     82,    279,
        1,   -602,  -1168,  -1350,
@@ -2195,7 +2195,7 @@ const int16_t wav_bandlimited_comb_9[] = {
    -1024,   -538,    -24,    203,
        0,
 };
-const int16_t wav_bandlimited_comb_10[] = {
+const int16_t wav_bandlimited_comb_10[] BRAIDS_SRAM_TABLE = {
        0,   -492,  -1080,  -1617,
    -1967,  -2040,  -1807,  -1322,
     -691,    -79,    371,    533,
@@ -2262,7 +2262,7 @@ const int16_t wav_bandlimited_comb_10[] = {
     -446,     19,    284,    280,
        0,
 };
-const int16_t wav_bandlimited_comb_11[] = {
+const int16_t wav_bandlimited_comb_11[] BRAIDS_SRAM_TABLE = {
        0,   -465,  -1027,  -1635,
    -2234,  -2768,  -3185,  -3439,
    -3506,  -3375,  -3045,  -2548,
@@ -2329,7 +2329,7 @@ const int16_t wav_bandlimited_comb_11[] = {
      301,    481,    492,    328,
        0,
 };
-const int16_t wav_bandlimited_comb_12[] = {
+const int16_t wav_bandlimited_comb_12[] BRAIDS_SRAM_TABLE = {
        0,   -449,   -979,  -1569,
    -2199,  -2835,  -3457,  -4036,
    -4543,  -4957,  -5256,  -5424,
@@ -2396,7 +2396,7 @@ const int16_t wav_bandlimited_comb_12[] = {
      712,    712,    591,    350,
        0,
 };
-const int16_t wav_bandlimited_comb_13[] = {
+const int16_t wav_bandlimited_comb_13[] BRAIDS_SRAM_TABLE = {
        0,    457,    858,   1194,
     1456,   1640,   1738,   1748,
     1666,   1490,   1224,    864,
@@ -2463,7 +2463,7 @@ const int16_t wav_bandlimited_comb_13[] = {
    -2203,  -1616,  -1046,   -505,
        0,
 };
-const int16_t wav_bandlimited_comb_14[] = {
+const int16_t wav_bandlimited_comb_14[] BRAIDS_SRAM_TABLE = {
        0,    804,   1608,   2410,
     3212,   4011,   4808,   5601,
     6393,   7178,   7963,   8738,
@@ -2553,7 +2553,7 @@ const int16_t* waveform_table[] = {
   wav_bandlimited_comb_14,
 };
 
-const int16_t ws_moderate_overdrive[] = {
+const int16_t ws_moderate_overdrive[] BRAIDS_SRAM_TABLE = {
   -32766, -32728, -32689, -32648,
   -32607, -32564, -32519, -32474,
   -32427, -32378, -32328, -32277,
@@ -2620,7 +2620,7 @@ const int16_t ws_moderate_overdrive[] = {
    32607,  32648,  32689,  32728,
    32728,
 };
-const int16_t ws_violent_overdrive[] = {
+const int16_t ws_violent_overdrive[] BRAIDS_SRAM_TABLE = {
   -32766, -32766, -32766, -32766,
   -32766, -32766, -32766, -32766,
   -32766, -32766, -32766, -32766,
@@ -2687,7 +2687,7 @@ const int16_t ws_violent_overdrive[] = {
    32766,  32766,  32766,  32766,
    32766,
 };
-const int16_t ws_sine_fold[] = {
+const int16_t ws_sine_fold[] BRAIDS_SRAM_TABLE = {
   -32766, -32682, -32595, -32504,
   -32410, -32315, -32218, -32121,
   -32025, -31931, -31840, -31754,
@@ -2754,7 +2754,7 @@ const int16_t ws_sine_fold[] = {
    32410,  32504,  32595,  32682,
    32682,
 };
-const int16_t ws_tri_fold[] = {
+const int16_t ws_tri_fold[] BRAIDS_SRAM_TABLE = {
      -78, -20070, -31636, -30481,
   -17545,   1825,  20257,  31198,
    31144,  20555,   3335, -14748,
@@ -2830,7 +2830,7 @@ const int16_t* waveshaper_table[] = {
   ws_tri_fold,
 };
 
-const uint8_t wt_waves[] = {
+const uint8_t wt_waves[] BRAIDS_SRAM_TABLE = {
      104,    105,    107,    108,
      110,    112,    115,    116,
      118,    122,    124,    124,
@@ -11154,7 +11154,7 @@ const uint8_t wt_map[] = {
       76,     75,     74,     73,
       72,     71,     70,     69,
 };
-const uint8_t wt_code[] = {
+const uint8_t wt_code[] BRAIDS_SRAM_TABLE = {
        5,      0,    132,      0,
       20,     16,     20,     81,
       16,     65,      8,     17,
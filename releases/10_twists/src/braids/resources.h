@@ -35,6 +35,13 @@
 
 
 #include "stmlib/stmlib.h"
+#include "pico/platform.h"
+
+// Tables read in the renderers' sample loops are copied to SRAM at boot: read at random from
+// flash, they thrash the XIP cache, and a block's cost depends on what the cache last held.
+// Tables read once per block or less (pitch, filter and envelope coefficients, the CV curve,
+// the font) stay in flash. RenderBudget::Benchmark measures the XIP misses each shape makes
+#define BRAIDS_SRAM_TABLE __not_in_flash("braids_resources")
 
 
 
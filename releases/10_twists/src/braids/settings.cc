@@ -66,6 +66,7 @@ const SettingsData kInitSettings = {
   0,  // MIDI - engine
   0,  // MIDI - out 1
   0,  // MIDI - out 2
+  1,  // Voices
 
   0,  // Selected shape from available subset
 
@@ -152,7 +152,8 @@ enum Setting {
   SETTING_MIDICHANNEL_ENGINE,
   SETTING_MIDICHANNEL_OUT1,
   SETTING_MIDICHANNEL_OUT2,
-  SETTING_LAST_EDITABLE_SETTING = SETTING_MIDICHANNEL_OUT2,
+  SETTING_VOICES,
+  SETTING_LAST_EDITABLE_SETTING = SETTING_VOICES,
   
   SETTING_SELECTED_AVAILABLE_SHAPE,
 
@@ -188,6 +189,7 @@ struct SettingsData {
   uint8_t midi_channels_engine;
   uint8_t midi_channels_out1;
   uint8_t midi_channels_out2;
+  uint8_t voices;  // 1 = mono, 2-4 = paraphonic
 
   uint8_t selected_available_shape = 0;
 
@@ -25,17 +25,20 @@
 // Ported to Music Thing Computer by Tom Waters using code from Chris Johnson's Reverb card
 
 #include <algorithm>
-#include <queue>
 #include "pico/stdlib.h"
 #include "pico/multicore.h"
 #include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
 #include "hardware/flash.h"
+#include "hardware/sync.h"
 
 #include "stmlib/utils/dsp.h"
 
 #include "braids/drivers/switch.h"
 #include "braids/drivers/dac.h"
 #include "braids/drivers/cv_out.h"
+#include "braids/drivers/sync_in.h"
 #include "braids/envelope.h"
 #include "braids/macro_oscillator.h"
 #include "braids/quantizer.h"
@@ -46,6 +49,7 @@
 #include "braids/quantizer_scales.h"
 #include "braids/resources.h"
 #include "braids/midi_message.h"
+#include "braids/render_budget.h"
 
 #define PIN_PULSE1_IN       2
 #define PIN_PULSE1_OUT      8
@@ -61,8 +65,16 @@ using namespace stmlib;
 
 const size_t kNumBlocks = 4;
 const size_t kBlockSize = 24;
-
-MacroOscillator osc;
+const uint32_t kSampleRate = 96000;
+const size_t kMaxVoices = 4;
+
+// Voice 0 is the only voice in mono mode. With more voices (paraphonic mode), each MIDI note gets
+// its own oscillator; they are mixed, then share the envelope, bit/rate reduction and signature.
+// Voices [kNumVoices / 2, kNumVoices) are rendered by core1, between USB tasks.
+// The oscillators live in osc_pool, with one to spare for changing voice 0's shape (see StageShape).
+MacroOscillator osc_pool[kMaxVoices + 1];
+MacroOscillator* osc[kMaxVoices] = { &osc_pool[0], &osc_pool[1], &osc_pool[2], &osc_pool[3] };
+MacroOscillator* staged_osc = &osc_pool[kMaxVoices];
 Envelope envelope;
 Dac dac;
 Quantizer quantizer;
@@ -71,25 +83,73 @@ VcoJitterSource jitter_source;
 Ui ui;
 UsbWorker usbWorker;
 CvOut cvOut;
+SyncIn syncIn;
 
 uint8_t current_scale = 0xff;
-size_t current_sample;
 volatile size_t playback_block;
 volatile size_t render_block;
+// DAC words, streamed out by DMA round and round; RenderBlock fills in the blocks behind the one playing
 int16_t audio_samples[kNumBlocks][kBlockSize];
-uint8_t sync_samples[kNumBlocks][kBlockSize];
+uint8_t sync_samples[kBlockSize];
+
+// The ADC runs round-robin over its four inputs (mux, audio 1, audio 2, mux), one reading per
+// sample, into one half of adc_samples by DMA while the other is read
+const size_t kMuxFrames = 4; // Frames at the end of each block in which the mux has settled
+uint16_t adc_samples[2][kBlockSize];
+uint8_t adc_dma;
+uint8_t adc_phase = 0;
 
 bool trigger_detected_flag;
-volatile bool trigger_flag;
+bool trigger_flag;
 uint16_t trigger_delay;
 
-queue<MIDIMessage> midi_messages;
+MIDIMessageQueue<64> midi_messages;
+const int kMaxMidiMessagesPerBlock = 8; // Messages taken from midi_messages per render, in paraphonic mode
 volatile bool midi_active = false;
 volatile bool midi_note_on = false;
 volatile bool midi_note_off = false;
 volatile uint8_t midi_notes_on = 0;
 volatile uint8_t midi_note = 0;
 
+// Paraphonic voice allocation, core0 only
+struct VoiceState {
+  uint8_t note;
+  bool held;        // Note is down
+  bool audible;     // Held, or part of the last chord, decaying with the envelope
+  bool strike;      // Strike at the start of the next block
+  uint32_t age;     // When the note started, for stealing the oldest
+  uint16_t level;   // Smoothed audible gain, 0-65535
+};
+VoiceState voice_state[kMaxVoices];
+size_t num_voices = 1;
+uint32_t voice_clock = 0;
+uint8_t voice_notes_held = 0;
+
+// Per-voice render buffers, and core1's share of the current block
+int16_t voice_samples[kMaxVoices][kBlockSize];
+volatile bool core1_render_request = false;
+const uint8_t* volatile core1_sync_buffer;
+
+// Shape changes in mono mode. A shape's first block (initialising its state, its strike, its code
+// coming into the XIP cache) can take longer than a block's time, so core1 prepares the new shape
+// in the spare oscillator, rendering a block of it to throw away, while voice 0 carries on with the
+// old one. The spare then takes over as voice 0, crossfading from the old shape over
+// kShapeCrossfadeBlocks, with core1 rendering the new shape alongside.
+enum ShapeStage {
+  SHAPE_STEADY,     // The spare is core0's, and unused
+  SHAPE_PREPARING,  // Core1 is preparing staged_shape in the spare
+  SHAPE_READY,      // Prepared, and the spare is core0's again
+  SHAPE_CROSSFADE   // Core1 renders the spare alongside voice 0
+};
+const size_t kShapeCrossfadeBlocks = 4;
+const uint16_t kShapeCrossfadeStep = 65535 / (kShapeCrossfadeBlocks * kBlockSize);
+volatile ShapeStage shape_stage = SHAPE_STEADY;
+MacroOscillatorShape playing_shape;  // Voice 0's shape in mono mode
+MacroOscillatorShape staged_shape;
+size_t crossfade_block;
+int16_t staged_samples[kBlockSize];
+const uint8_t no_sync_samples[kBlockSize] = { };
+
 volatile uint8_t mxPos = 0; // external multiplexer value
 volatile int32_t knobssm[4] = {0,0,0,0};
 volatile int32_t cvsm[2] = {0,0};
@@ -97,67 +157,57 @@ volatile uint16_t knobs[4] = {0,0,0,0}; // 0-4095
 volatile uint16_t cv[2] = {0,0}; // -2047 - 2048
 volatile uint16_t audio_in[2] = {2048, 2048};
 
-void timer_callback() {
-  // Now, get ADC data from this cycle
-	// Should return immediately since this IRQ handler called only when ADC FIFO has data
-	uint16_t adc = adc_fifo_get_blocking();
+// (untested) best attempt at correction of DNL errors in ADC
+inline uint16_t CorrectDnl(uint16_t adc) {
+  uint16_t adc512 = adc + 512;
+  if (!(adc512 % 0x01FF)) adc += 4;
+  adc -= (adc512>>10) << 3;
+  return adc;
+}
 
-  dac.Write(audio_samples[playback_block][current_sample]);
-  
-  bool trigger_detected = !gpio_get(PIN_PULSE1_IN);
-  sync_samples[playback_block][current_sample] = trigger_detected;
-  trigger_detected_flag = trigger_detected;
-
-  current_sample = current_sample + 1;
-  if (current_sample >= kBlockSize) {
-    current_sample = 0;
-    playback_block = (playback_block + 1) % kNumBlocks;
-  }
-
-	// (untested) best attempt at correction of DNL errors in ADC
-	uint16_t adc512 = adc + 512;
-	if (!(adc512 % 0x01FF)) adc += 4;
-	adc -= (adc512>>10) << 3;
-
-  switch(adc_get_selected_input()) 
-	{
-    case 0:
-    	// ~100Hz LPF on CV input
-		  cvsm[mxPos % 2] = (7 * (cvsm[mxPos % 2]) + 16 * adc) >> 3;
-      cv[mxPos % 2] = cvsm[mxPos % 2] >> 4;
-    break;
-    case 1:
-      audio_in[0] = adc;
-      break;
-    case 2:
-      audio_in[1] = adc;
-      break;
-    case 3:
-      // Each knob sampled at 48kHz/4 = 12kHz
-		  // Then IIR filter with time constant ~128 samples, so around 100Hz
-		  knobssm[mxPos] = (127 * (knobssm[mxPos]) + 16 * adc) >> 7;
-      knobs[mxPos] = knobssm[mxPos] >> 4;
-
-      mxPos = (mxPos + 1) & 0x03;
-      bool logic_a = (mxPos & 1) ? true : false;
-      bool logic_b = (mxPos >> 1) ? true : false; 
-    	gpio_put(PIN_MUX_LOGIC_A, logic_a);
-		  gpio_put(PIN_MUX_LOGIC_B, logic_b);
-      
-      if (trigger_detected_flag) {
-        trigger_delay = settings.trig_delay() ? (1 << settings.trig_delay()) : 0;
-        ++trigger_delay;
-        trigger_detected_flag = false;
-      }
-      if (trigger_delay) {
-        --trigger_delay;
-        if (trigger_delay == 0) {
-          trigger_flag = true;
-        }
-      }
+// DMA interrupt, once per block: the ADC has filled a block, and the DAC has moved on to the
+// next one
+void adc_block_callback() {
+  const uint16_t* adc = adc_samples[adc_phase];
+  adc_phase ^= 1;
+  dma_hw->ints0 = 1u << adc_dma;
+  if (adc_hw->fcs & ADC_FCS_OVER_BITS) {
+    // Readings were lost (interrupts were off, e.g. while core0 was locked out), so which
+    // input is which is lost too: start the round-robin again from input 0
+    adc_run(false);
+    while (!(adc_hw->cs & ADC_CS_READY_BITS)) { }
+    adc_fifo_drain();
+    adc_hw->fcs |= ADC_FCS_OVER_BITS; // Write 1 to clear
+    adc_select_input(0);
+    dma_channel_set_write_addr(adc_dma, adc_samples[adc_phase], true);
+    adc_run(true);
+  } else {
+    dma_channel_set_write_addr(adc_dma, adc_samples[adc_phase], true);
+  }
 
-      break;
+  playback_block = (playback_block + 1) % kNumBlocks;
+
+  // The mux moves once per block, so each knob is read at 1kHz and each CV at 2kHz,
+  // averaged over the frames in which the mux has settled
+  uint32_t cv_sum = 0;
+  uint32_t knob_sum = 0;
+  for (size_t i = (kBlockSize / 4 - kMuxFrames) * 4; i < kBlockSize; i += 4) {
+    cv_sum += CorrectDnl(adc[i]);
+    knob_sum += CorrectDnl(adc[i + 3]);
   }
+  // Then IIR filters with about the same time constants as when they were read every sample
+  cvsm[mxPos % 2] = (cvsm[mxPos % 2] + (cv_sum << 4) / kMuxFrames) >> 1;
+  cv[mxPos % 2] = cvsm[mxPos % 2] >> 4;
+  knobssm[mxPos] = (15 * (knobssm[mxPos]) + (knob_sum << 4) / kMuxFrames) >> 4;
+  knobs[mxPos] = knobssm[mxPos] >> 4;
+  audio_in[0] = CorrectDnl(adc[kBlockSize - 3]);
+  audio_in[1] = CorrectDnl(adc[kBlockSize - 2]);
+
+  mxPos = (mxPos + 1) & 0x03;
+  bool logic_a = (mxPos & 1) ? true : false;
+  bool logic_b = (mxPos >> 1) ? true : false; 
+  gpio_put(PIN_MUX_LOGIC_A, logic_a);
+  gpio_put(PIN_MUX_LOGIC_B, logic_b);
 }
 
 uint32_t GetUniqueId() {
@@ -180,7 +230,7 @@ void USBMIDICallback(MIDIMessage message) {
     case MIDIMessage::NoteOn:
       if(message.velocity > 0) {
         if(engine_channel == 0 || message.channel == engine_channel) {
-          midi_messages.push(message);
+          midi_messages.Push(message);
         }
 
         if(out1_channel == 0 || message.channel == out1_channel) {
@@ -195,7 +245,7 @@ void USBMIDICallback(MIDIMessage message) {
       break;
     case MIDIMessage::NoteOff:
       if(engine_channel == 0 || message.channel == engine_channel) {
-        midi_messages.push(message);
+        midi_messages.Push(message);
       }
       if(out1_channel == 0 || message.channel == out1_channel) {
         gpio_put(PIN_PULSE1_OUT, true);
@@ -207,6 +257,50 @@ void USBMIDICallback(MIDIMessage message) {
   }
 }
 
+// Core1: get the spare oscillator ready to take over with staged_shape. Its pitch and parameters
+// were set by core0. The block rendered here, like a shape's first after a change, does the
+// shape's initialisation; the spare is then struck again, as a shape change strikes.
+void PrepareStagedShape() {
+  staged_osc->Init();
+  staged_osc->set_shape(staged_shape);
+  staged_osc->Render(no_sync_samples, staged_samples, kBlockSize);
+  staged_osc->Strike();
+}
+
+// Core1, between USB tasks: prepare a new shape, and render core1's voices (or, while changing
+// shape in mono mode, the new shape) when core0 asks
+void RenderCore1Voices() {
+  if (shape_stage == SHAPE_PREPARING) {
+    __dmb(); // See core0's settings for the spare
+    PrepareStagedShape();
+    __dmb(); // Finish with the spare before handing it back
+    shape_stage = SHAPE_READY;
+  }
+  if (!core1_render_request) {
+    return;
+  }
+  __dmb(); // See core0's parameter updates before rendering with them
+  if (shape_stage == SHAPE_CROSSFADE) {
+    staged_osc->Render(core1_sync_buffer, staged_samples, kBlockSize);
+  } else {
+    for (size_t v = num_voices / 2; v < num_voices; ++v) {
+      osc[v]->Render(core1_sync_buffer, voice_samples[v], kBlockSize);
+    }
+  }
+  __dmb(); // Finish with the voices before handing them back
+  core1_render_request = false;
+}
+
+// Core1, while core0 is locked out to save to flash: hold the DAC, rather than let it go round
+// the last few blocks until core0 is back
+void FlashWriteCallback(bool starting) {
+  if (starting) {
+    dac.Pause();
+  } else {
+    dac.Resume();
+  }
+}
+
 void RunUSBWorker() {
   usbWorker.Run();
 }
@@ -228,22 +322,30 @@ void Init() {
   settings.Init();
   ui.Init();
   dac.Init();
-  osc.Init();
+  for (size_t v = 0; v <= kMaxVoices; ++v) {
+    osc_pool[v].Init();
+  }
+  playing_shape = settings.shape();
   quantizer.Init();
+
+  // Time every shape while nothing else is running yet; a block is due every kBlockSize samples
+  // at 96kHz
+  render_budget.Init(clock_get_hz(clk_sys) / kSampleRate * kBlockSize);
+  fill(&sync_samples[0], &sync_samples[kBlockSize], 0);
+  render_budget.Benchmark(osc[0], sync_samples, audio_samples[0], kBlockSize);
   
+  // Silence until the first blocks are rendered (a zero word would shut the DAC down)
   for (size_t i = 0; i < kNumBlocks; ++i) {
-    fill(&audio_samples[i][0], &audio_samples[i][kBlockSize], 0);
-    fill(&sync_samples[i][0], &sync_samples[i][kBlockSize], 0);
+    fill(&audio_samples[i][0], &audio_samples[i][kBlockSize], Dac::Word(1024));
   }
-  playback_block = kNumBlocks / 2;
-  render_block = 0;
-  current_sample = 0;
+  playback_block = 0;
+  render_block = kNumBlocks / 2;
   
   envelope.Init();
   ws.Init(GetUniqueId());
   jitter_source.Init();
 
-  usbWorker.Init(&USBMIDICallback);
+  usbWorker.Init(&USBMIDICallback, &RenderCore1Voices, &FlashWriteCallback);
   multicore_launch_core1(RunUSBWorker);
 
   gpio_init(PIN_MUX_LOGIC_A);
@@ -255,12 +357,26 @@ void Init() {
   adc_gpio_init(PIN_MUX_OUT_X);
   adc_gpio_init(PIN_MUX_OUT_Y);
 
+  adc_select_input(0);
   adc_set_round_robin(0x0F);
 	adc_fifo_setup(true, true, 1, false, false);
-	adc_set_clkdiv((48000000 / 96000) - 1); // 96KHz interrupt
-	irq_set_exclusive_handler(ADC_IRQ_FIFO, timer_callback);
-	adc_irq_set_enabled(true);
-	irq_set_enabled(ADC_IRQ_FIFO, true);
+	adc_set_clkdiv((48000000 / kSampleRate) - 1); // 96KHz, one input each sample
+
+  // A block of ADC readings at a time, by DMA, interrupting when it is full
+  adc_dma = dma_claim_unused_channel(true);
+  dma_channel_config adc_dma_config = dma_channel_get_default_config(adc_dma);
+  channel_config_set_transfer_data_size(&adc_dma_config, DMA_SIZE_16);
+  channel_config_set_read_increment(&adc_dma_config, false);
+  channel_config_set_write_increment(&adc_dma_config, true);
+  channel_config_set_dreq(&adc_dma_config, DREQ_ADC);
+  dma_channel_configure(adc_dma, &adc_dma_config, adc_samples[adc_phase], &adc_hw->fifo, kBlockSize, true);
+  dma_channel_set_irq0_enabled(adc_dma, true);
+  irq_set_exclusive_handler(DMA_IRQ_0, adc_block_callback);
+  irq_set_enabled(DMA_IRQ_0, true);
+
+  // The pulse input is sampled on each DAC word, and the DAC and ADC start together
+  syncIn.Init(PIN_PULSE1_IN, PIN_CS, kBlockSize);
+  dac.Start(&audio_samples[0][0], kNumBlocks * kBlockSize, kSampleRate);
 	adc_run(true);
 
   cvOut.Init();
@@ -283,36 +399,274 @@ int16_t clamp(int16_t val, int16_t min, int16_t max) {
   return val;
 }
 
+// Paraphonic note on: retrigger the voice already playing the note, or take the oldest
+// free voice, or steal the oldest held one
+void VoiceNoteOn(uint8_t note) {
+  if (voice_notes_held == 0) {
+    // A new chord: the last one's voices stop ringing
+    for (size_t v = 0; v < num_voices; ++v) {
+      voice_state[v].audible = false;
+    }
+  }
+  size_t voice = num_voices;
+  for (size_t v = 0; v < num_voices && voice == num_voices; ++v) {
+    if (voice_state[v].held && voice_state[v].note == note) {
+      voice = v;
+    }
+  }
+  for (int pass = 0; pass < 2 && voice == num_voices; ++pass) {
+    uint32_t oldest = 0;
+    for (size_t v = 0; v < num_voices; ++v) {
+      bool candidate = pass ? true : !voice_state[v].held;
+      if (candidate && (voice == num_voices || voice_state[v].age < oldest)) {
+        voice = v;
+        oldest = voice_state[v].age;
+      }
+    }
+  }
+  VoiceState& state = voice_state[voice];
+  if (!state.held) {
+    ++voice_notes_held;
+  }
+  state.note = note;
+  state.held = true;
+  state.audible = true;
+  state.strike = true;
+  state.age = ++voice_clock;
+}
+
+// Paraphonic note off: the last note released keeps sounding through the envelope's decay,
+// others are faded out straight away
+bool VoiceNoteOff(uint8_t note) {
+  for (size_t v = 0; v < num_voices; ++v) {
+    VoiceState& state = voice_state[v];
+    if (state.held && state.note == note) {
+      state.held = false;
+      --voice_notes_held;
+      if (voice_notes_held) {
+        state.audible = false;
+      }
+      return voice_notes_held == 0;
+    }
+  }
+  return false;
+}
+
+// Mono mode, once voice 0's pitch and parameters are set: start preparing a shape newly chosen
+// in the settings, or start the crossfade to one that is ready
+void StageShape(int16_t timbre, int16_t color) {
+  MacroOscillatorShape shape = settings.shape();
+  if (shape_stage == SHAPE_STEADY && shape != playing_shape) {
+    staged_shape = shape;
+    staged_osc->set_pitch(osc[0]->pitch());
+    staged_osc->set_parameters(timbre, color);
+    staged_osc->set_economy(render_budget.economy());
+    __dmb(); // The spare's settings land before core1 is asked to prepare it
+    shape_stage = SHAPE_PREPARING;
+  } else if (shape_stage == SHAPE_READY) {
+    __dmb(); // See core1's preparation of the spare
+    if (shape == staged_shape) {
+      crossfade_block = 0;
+      shape_stage = SHAPE_CROSSFADE;
+    } else {
+      // Changed again meanwhile: start again with the latest shape next block
+      shape_stage = SHAPE_STEADY;
+    }
+  }
+  if (shape_stage == SHAPE_CROSSFADE) {
+    staged_osc->set_pitch(osc[0]->pitch());
+    staged_osc->set_parameters(timbre, color);
+    staged_osc->set_economy(render_budget.economy());
+  }
+}
+
+// The spare takes over as voice 0
+void EndShapeChange() {
+  swap(osc[0], staged_osc);
+  playing_shape = staged_shape;
+  shape_stage = SHAPE_STEADY;
+}
+
+// Mono mode, while changing shape: crossfade voice 0's block in buffer towards the new shape's
+void CrossfadeShape(int16_t* buffer) {
+  uint16_t balance = crossfade_block * kBlockSize * kShapeCrossfadeStep;
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    balance += kShapeCrossfadeStep;
+    buffer[i] = Mix(buffer[i], staged_samples[i], balance);
+  }
+  if (++crossfade_block == kShapeCrossfadeBlocks) {
+    EndShapeChange();
+  }
+}
+
+void SetNumVoices(size_t n) {
+  num_voices = n;
+  for (size_t v = 0; v < kMaxVoices; ++v) {
+    voice_state[v].held = false;
+    voice_state[v].audible = false;
+    voice_state[v].strike = false;
+  }
+  voice_notes_held = 0;
+  midi_notes_on = 0;
+}
+
+// Final pitch for the oscillator, from pitch in semitones * 128 with all modulation applied
+int32_t OscillatorPitch(int32_t pitch) {
+  if (pitch > 16383) {
+    pitch = 16383;
+  } else if (pitch < 0) {
+    pitch = 0;
+  }
+  
+  if (settings.vco_flatten()) {
+    pitch = Interpolate88(lut_vco_detune, pitch << 2);
+  }
+  return pitch + settings.pitch_transposition();
+}
+
+// Mix gain for 1-4 voices, Q15: roughly equal loudness, with headroom for unrelated voices
+const int32_t voice_mix_gains[kMaxVoices] = { 32767, 23170, 18919, 16384 };
+
+// One pass over a block: mix the voices (paraphonic), then sample rate and bit reduction, the
+// AD VCA, the signature waveshaper and the conversion to DAC words, in place in buffer. In mono
+// mode, buffer holds the oscillator's samples.
+// The VCA's gain, smoothed, carried across blocks and shared by every FinishBlock
+uint16_t vca_gain_lp;
+
+template<bool paraphonic, bool warp>
+void FinishBlock(int16_t* buffer, int32_t gain, size_t decimation_factor, uint16_t bit_mask,
+    uint16_t signature) {
+  int32_t mix_gain = voice_mix_gains[num_voices - 1];
+  int16_t held_sample = 0;
+  size_t hold = 0;
+
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    int16_t rendered;
+    if (paraphonic) {
+      // Fading voices in and out as they start and stop sounding
+      int32_t mix = 0;
+      for (size_t v = 0; v < num_voices; ++v) {
+        VoiceState& state = voice_state[v];
+        int32_t target = state.audible ? 65535 : 0;
+        state.level += (target - state.level) >> 4;
+        mix += voice_samples[v][i] * state.level >> 16;
+      }
+      mix = mix * mix_gain >> 15;
+      CLIP(mix)
+      rendered = mix;
+    } else {
+      rendered = buffer[i];
+    }
+
+    if (hold == 0) {
+      held_sample = rendered & bit_mask;
+      hold = decimation_factor;
+    }
+    --hold;
+    int16_t sample = held_sample * vca_gain_lp >> 16;
+    vca_gain_lp += (gain - vca_gain_lp) >> 4;
+    // With no signature, the mix doesn't depend on the waveshaper
+    int16_t warped = warp ? ws.Transform(sample) : 0;
+    int16_t out = Mix(sample, warped, signature);
+    buffer[i] = Dac::Word((-out + 32768) >> 5);
+  }
+}
+
 void RenderBlock() {
   static int16_t previous_pitch = 0;
-  static uint16_t gain_lp;
+
+  render_budget.BeginBlock();
+
+  // Pulse input 1 over the last block played, active low. If it isn't in yet, it will be
+  // next time
+  uint32_t pulse_levels;
+  uint32_t pulses = 0;
+  if (syncIn.Read(&pulse_levels)) {
+    pulses = ~pulse_levels & ((1u << kBlockSize) - 1);
+  }
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    sync_samples[i] = (pulses >> (kBlockSize - 1 - i)) & 1;
+  }
+
+  // Triggers, delayed by 2^trig_delay ticks of 24kHz, counted down a block at a time
+  const uint16_t kTriggerTicksPerBlock = kBlockSize / 4;
+  if (pulses) {
+    trigger_detected_flag = true;
+  }
+  if (trigger_detected_flag) {
+    trigger_delay = settings.trig_delay() ? (1 << settings.trig_delay()) : 0;
+    ++trigger_delay;
+    trigger_detected_flag = false;
+  }
+  if (trigger_delay) {
+    trigger_delay = trigger_delay > kTriggerTicksPerBlock
+        ? trigger_delay - kTriggerTicksPerBlock : 0;
+    if (trigger_delay == 0) {
+      trigger_flag = true;
+    }
+  }
+
+  // Anything out of range (e.g. a config saved before this setting existed) is mono
+  size_t voices = settings.GetValue(SETTING_VOICES);
+  if (voices < 1 || voices > kMaxVoices) {
+    voices = 1;
+  }
+  if (voices != num_voices) {
+    SetNumVoices(voices);
+  }
+  bool paraphonic = num_voices > 1;
+  if (paraphonic) {
+    // Core1 is rendering voices, so shapes change straight away; a change under way finishes now
+    if (shape_stage == SHAPE_CROSSFADE) {
+      EndShapeChange();
+    } else if (shape_stage == SHAPE_READY) {
+      shape_stage = SHAPE_STEADY;
+    }
+    playing_shape = settings.shape();
+  }
 
   envelope.Update(
       settings.GetValue(SETTING_AD_ATTACK) * 8,
       settings.GetValue(SETTING_AD_DECAY) * 8);
   uint32_t ad_value = envelope.Render(midi_active);
   
-  osc.set_shape(settings.shape());
-
   int16_t timbre = clamp(knobs[1] + (audio_in[0] - 2048), 0, 4095);;
   timbre = timbre << 3;
   int16_t color = clamp(knobs[2] + (audio_in[1] - 2048), 0, 4095);
   color = color << 3;
-  osc.set_parameters(timbre, color);
-
-  if(!midi_messages.empty()) {
-    MIDIMessage midi_message = midi_messages.front();
-    midi_messages.pop();
-
-    if(midi_message.command == MIDIMessage::NoteOn) {
-      midi_note_on = true;
-      midi_active = true;
-      midi_note = midi_message.note;
-      midi_notes_on++;      
-    } else if(midi_message.command == MIDIMessage::NoteOff) {
-      midi_notes_on--;
-      if(midi_notes_on == 0) {
+  for (size_t v = 0; v < num_voices; ++v) {
+    osc[v]->set_shape(paraphonic ? settings.shape() : playing_shape);
+    osc[v]->set_parameters(timbre, color);
+    osc[v]->set_economy(render_budget.economy());
+  }
+
+  MIDIMessage midi_message;
+  if (!paraphonic) {
+    if (midi_messages.Pop(midi_message)) {
+      if(midi_message.command == MIDIMessage::NoteOn) {
+        midi_note_on = true;
+        midi_active = true;
+        midi_note = midi_message.note;
+        midi_notes_on++;      
+      } else if(midi_message.command == MIDIMessage::NoteOff) {
+        midi_notes_on--;
+        if(midi_notes_on == 0) {
+            midi_note_off = true;
+        }
+      }
+    }
+  } else {
+    // Chords arrive as several messages at once, so take several, but a bounded number per
+    // block; any more wait for the next block
+    for (int m = 0; m < kMaxMidiMessagesPerBlock && midi_messages.Pop(midi_message); ++m) {
+      if (midi_message.command == MIDIMessage::NoteOn) {
+        VoiceNoteOn(midi_message.note);
+        midi_note_on = true;
+        midi_active = true;
+      } else if (midi_message.command == MIDIMessage::NoteOff) {
+        if (VoiceNoteOff(midi_message.note)) {
           midi_note_off = true;
+        }
       }
     }
   }
@@ -330,9 +684,12 @@ void RenderBlock() {
   int32_t pot_pitch = (knobs[0] * 3) - 6144;
 
   // if we're using midi, react to the latest message
+  // (in paraphonic mode, each voice adds its own note later)
   int32_t pitch = cv_pitch + 7680;
   if(midi_active) {
-    pitch += ((midi_note - 60) * 128);
+    if (!paraphonic) {
+      pitch += ((midi_note - 60) * 128);
+    }
     if(pot_pitch < -1000) {
       pitch += pot_pitch + 1000;
     } else if(pot_pitch > 1000) {
@@ -355,19 +712,27 @@ void RenderBlock() {
   pitch += jitter_source.Render(settings.vco_drift());
   pitch += ad_value * settings.GetValue(SETTING_AD_FM) >> 7;
   
-  if (pitch > 16383) {
-    pitch = 16383;
-  } else if (pitch < 0) {
-    pitch = 0;
-  }
-  
-  if (settings.vco_flatten()) {
-    pitch = Interpolate88(lut_vco_detune, pitch << 2);
+  if (!paraphonic) {
+    osc[0]->set_pitch(OscillatorPitch(pitch));
+    StageShape(timbre, color);
+  } else {
+    for (size_t v = 0; v < num_voices; ++v) {
+      int32_t note_pitch = midi_active ? (voice_state[v].note - 60) * 128 : 0;
+      osc[v]->set_pitch(OscillatorPitch(pitch + note_pitch));
+    }
   }
-  osc.set_pitch(pitch + settings.pitch_transposition());
 
   if (trigger_flag || midi_note_on) {
-    osc.Strike();
+    for (size_t v = 0; v < num_voices; ++v) {
+      // A trigger strikes every sounding voice, a note only its own
+      if (!paraphonic || trigger_flag || voice_state[v].strike) {
+        osc[v]->Strike();
+      }
+      voice_state[v].strike = false;
+    }
+    if (shape_stage == SHAPE_CROSSFADE) {
+      staged_osc->Strike();
+    }
     envelope.Trigger(ENV_SEGMENT_ATTACK);
     trigger_flag = false;
     midi_note_on = false;
@@ -377,7 +742,7 @@ void RenderBlock() {
     envelope.Trigger(ENV_SEGMENT_DECAY);
   }
   
-  uint8_t* sync_buffer = sync_samples[render_block];
+  uint8_t* sync_buffer = sync_samples;
   int16_t* render_buffer = audio_samples[render_block];
   
   if (settings.GetValue(SETTING_AD_VCA) != 0
@@ -387,28 +752,56 @@ void RenderBlock() {
     memset(sync_buffer, 0, kBlockSize);
   }
   
-  osc.Render(sync_buffer, render_buffer, kBlockSize);
-  
-  // Copy to DAC buffer with sample rate and bit reduction applied.
-  int16_t held_sample = 0;
+  if (!paraphonic && shape_stage == SHAPE_CROSSFADE) {
+    // The new shape on core1, the old one here meanwhile
+    core1_sync_buffer = sync_buffer;
+    __dmb(); // Parameter updates land before core1 is asked to render
+    core1_render_request = true;
+    osc[0]->Render(sync_buffer, render_buffer, kBlockSize);
+    while (core1_render_request) {
+      tight_loop_contents();
+    }
+    __dmb(); // See core1's samples once it's done
+    CrossfadeShape(render_buffer);
+  } else if (!paraphonic) {
+    osc[0]->Render(sync_buffer, render_buffer, kBlockSize);
+  } else {
+    // Half the voices (rounded up) go to core1, the rest are rendered here meanwhile
+    core1_sync_buffer = sync_buffer;
+    __dmb(); // Parameter updates land before core1 is asked to render
+    core1_render_request = true;
+    for (size_t v = 0; v < num_voices / 2; ++v) {
+      osc[v]->Render(sync_buffer, voice_samples[v], kBlockSize);
+    }
+    while (core1_render_request) {
+      tight_loop_contents();
+    }
+    __dmb(); // See core1's samples once it's done
+  }
+
+  // The mix (paraphonic), sample rate and bit reduction, VCA, signature and DAC scaling
   size_t decimation_factor = decimation_factors[settings.data().sample_rate];
   uint16_t bit_mask = bit_reduction_masks[settings.data().resolution];
   int32_t gain = settings.GetValue(SETTING_AD_VCA) ? ad_value : 65535;
   uint16_t signature = settings.signature() * settings.signature() * 4095;
-
-  for (size_t i = 0; i < kBlockSize; ++i) {
-
-    if ((i % decimation_factor) == 0) {
-      held_sample = render_buffer[i] & bit_mask;
+  if (paraphonic) {
+    if (signature) {
+      FinishBlock<true, true>(render_buffer, gain, decimation_factor, bit_mask, signature);
+    } else {
+      FinishBlock<true, false>(render_buffer, gain, decimation_factor, bit_mask, signature);
+    }
+  } else {
+    if (signature) {
+      FinishBlock<false, true>(render_buffer, gain, decimation_factor, bit_mask, signature);
+    } else {
+      FinishBlock<false, false>(render_buffer, gain, decimation_factor, bit_mask, signature);
     }
-    int16_t sample = held_sample * gain_lp >> 16;
-    gain_lp += (gain - gain_lp) >> 4;
-    int16_t warped = ws.Transform(sample);
-    render_buffer[i] = Mix(sample, warped, signature);
-    render_buffer[i] = (-render_buffer[i] + 32768) >> 5;
   }
 
   render_block = (render_block + 1) % kNumBlocks;
+
+  // Core0 waits for core1, so the busier core's share of the voices is what counts
+  render_budget.EndBlock(settings.shape(), paraphonic ? (num_voices + 1) / 2 : 1);
 }
 
 uint32_t last = 0;
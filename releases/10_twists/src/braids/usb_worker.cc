@@ -1,5 +1,6 @@
 #include "braids/usb_worker.h"
 #include "braids/midi_message.h"
+#include "braids/render_budget.h"
 #include "bsp/board.h"
 #include "tusb.h"
 
@@ -7,8 +8,13 @@
 
 namespace braids {
 
-void UsbWorker::Init(midi_in_callback_t midiInCallback) {
+void UsbWorker::Init(
+		midi_in_callback_t midiInCallback,
+		idle_callback_t idleCallback,
+		flash_write_callback_t flashWriteCallback) {
 	midi_in_callback = midiInCallback;
+	idle_callback = idleCallback;
+	flash_write_callback = flashWriteCallback;
 }
 
 void UsbWorker::PostConfigProcessing() {
@@ -24,6 +30,7 @@ void UsbWorker::PostConfigProcessing() {
 	settings.SetValue(SETTING_MIDICHANNEL_ENGINE, config_[OPT_MIDICHANENGINE]);
 	settings.SetValue(SETTING_MIDICHANNEL_OUT1, config_[OPT_MIDICHANOUT1]);
 	settings.SetValue(SETTING_MIDICHANNEL_OUT2, config_[OPT_MIDICHANOUT2]);
+	settings.SetValue(SETTING_VOICES, config_[OPT_VOICES]);
 }
 
 void UsbWorker::SetConfigFromFlash() {
@@ -43,6 +50,7 @@ void UsbWorker::SetConfigFromFlash() {
 		config_[OPT_MIDICHANENGINE] = settings.GetValue(SETTING_MIDICHANNEL_ENGINE);
 		config_[OPT_MIDICHANOUT1] = settings.GetValue(SETTING_MIDICHANNEL_OUT1);
 		config_[OPT_MIDICHANOUT2] = settings.GetValue(SETTING_MIDICHANNEL_OUT2);
+		config_[OPT_VOICES] = settings.GetValue(SETTING_VOICES);
 	}
 }
 
@@ -75,6 +83,7 @@ void UsbWorker::ProcessSysExCommand(uint8_t *packet) {
 		{
 			// shut down the other core
 			multicore_lockout_start_blocking();
+			if (flash_write_callback != NULL) flash_write_callback(true);
 			// erase page of flash
 			uint32_t ints = save_and_disable_interrupts();
 			flash_range_erase(configFlashAddr_, 4096);
@@ -86,6 +95,7 @@ void UsbWorker::ProcessSysExCommand(uint8_t *packet) {
 			restore_interrupts(ints);
 
 			// restore other core
+			if (flash_write_callback != NULL) flash_write_callback(false);
 			multicore_lockout_end_blocking();
 		}
 		break;
@@ -100,11 +110,53 @@ void UsbWorker::ProcessSysExCommand(uint8_t *packet) {
 		tud_midi_stream_write(0, packet_, CONFIG_LENGTH+5);
 		break;
 
+	case SYSEX_COMMAND_BENCHMARK:
+		SendBenchmark();
+		break;
+
 	default:
 		break;
 	}
 }
 
+// Reply to SYSEX_COMMAND_BENCHMARK with the render budget's table:
+// F0 7D 04 <number of shapes> <cycles between blocks>
+// then for each shape <cycles per block at full quality> <cycles per block at economy quality>
+// <XIP cache misses per block>, F7, each number as three 7-bit bytes, least significant first
+void UsbWorker::SendBenchmark() {
+	static uint8_t reply[4 + 3 + MACRO_OSC_SHAPE_LAST * 9 + 1];
+	uint32_t n = 0;
+	reply[n++] = 0xF0;
+	reply[n++] = SYSEX_MANUFACTURER_DEV;
+	reply[n++] = SYSEX_COMMAND_BENCHMARK;
+	reply[n++] = MACRO_OSC_SHAPE_LAST;
+	for (int32_t i = -1; i < MACRO_OSC_SHAPE_LAST; i++)
+	{
+		for (int32_t column = 0; column < (i < 0 ? 1 : 3); column++)
+		{
+			MacroOscillatorShape shape = static_cast<MacroOscillatorShape>(i);
+			uint32_t value = i < 0 ? render_budget.block_cycles()
+				: column < 2 ? render_budget.shape_cycles(shape, column)
+				: render_budget.shape_xip_misses(shape);
+			if (value > 0x1FFFFF) value = 0x1FFFFF;
+			reply[n++] = value & 0x7F;
+			reply[n++] = (value >> 7) & 0x7F;
+			reply[n++] = (value >> 14) & 0x7F;
+		}
+	}
+	reply[n++] = 0xF7;
+
+	// Much longer than the other replies, so it may take several passes to get out
+	const uint8_t *data = reply;
+	while (n && tud_midi_mounted())
+	{
+		uint32_t written = tud_midi_stream_write(0, data, n);
+		data += written;
+		n -= written;
+		if (n) tud_task();
+	}
+}
+
 void UsbWorker::MidiTask()
 {
 	// Read incoming packet if availabie
@@ -118,8 +170,20 @@ void UsbWorker::MidiTask()
 		}
 		else //if(midi_in_callback != NULL)
 		{
-			// else pass on to application midi message handler
-			midi_in_callback(packet_);
+			// else pass each message on to application midi message handler;
+			// several (e.g. the notes of a chord) can arrive in one read
+			uint32_t i = 0;
+			while (i < bytes_read)
+			{
+				uint8_t status = packet_[i];
+				uint32_t length;
+				if (status < 0x80 || status >= 0xF0) length = 1; // stray data, or system messages
+				else if ((status & 0xE0) == 0xC0) length = 2;    // patch change, channel pressure
+				else length = 3;
+				if (i + length > bytes_read) break;
+				if (length > 1) midi_in_callback(packet_ + i);
+				i += length;
+			}
 		}
 	}
 }
@@ -133,6 +197,7 @@ void UsbWorker::Run() {
   {
     tud_task();
     MidiTask();
+    if (idle_callback) idle_callback();
   }
 }
 
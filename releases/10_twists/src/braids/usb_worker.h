@@ -20,8 +20,9 @@
 #define OPT_MIDICHANENGINE  10
 #define OPT_MIDICHANOUT1    11
 #define OPT_MIDICHANOUT2    12
+#define OPT_VOICES          13
 
-#define CONFIG_LENGTH 13
+#define CONFIG_LENGTH 14
 #define SYSEX_INDEX_MANUFACTURER 1
 #define SYSEX_INDEX_COMMAND 2
 #define SYSEX_INDEX_LENGTH 3
@@ -29,10 +30,13 @@
 #define SYSEX_COMMAND_PREVIEW 1
 #define SYSEX_COMMAND_WRITE_FLASH 2
 #define SYSEX_COMMAND_READ 3
+#define SYSEX_COMMAND_BENCHMARK 4
 
 namespace braids {
 
 typedef void (*midi_in_callback_t)(MIDIMessage);
+typedef void (*idle_callback_t)();
+typedef void (*flash_write_callback_t)(bool starting);
 
 class UsbWorker {
  public:
@@ -40,7 +44,13 @@ class UsbWorker {
   UsbWorker() { }
   ~UsbWorker() { }
 
-  void Init(midi_in_callback_t midiInCallback);
+  // idleCallback, if given, is run on every pass of the worker loop, between USB tasks.
+  // flashWriteCallback, if given, is run before (true) and after (false) saving to flash,
+  // while the other core is locked out
+  void Init(
+      midi_in_callback_t midiInCallback,
+      idle_callback_t idleCallback = NULL,
+      flash_write_callback_t flashWriteCallback = NULL);
   void Run();
 
  private:
@@ -49,12 +59,15 @@ class UsbWorker {
   void SetConfigFromFlash();
   int SetConfigFromSysEx(uint8_t *packet);
   void PostConfigProcessing();
+  void SendBenchmark();
 
   uint8_t config_[CONFIG_LENGTH];
   uint8_t packet_[32];
   uint32_t configFlashAddr_ = (PICO_FLASH_SIZE_BYTES - 4096) - (PICO_FLASH_SIZE_BYTES - 4096)%4096;
   
   midi_in_callback_t midi_in_callback;
+  idle_callback_t idle_callback;
+  flash_write_callback_t flash_write_callback;
 
   DISALLOW_COPY_AND_ASSIGN(UsbWorker);
 };
@@ -56,6 +56,103 @@ public:
 	/// Use before Run() to enable Connected/Disconnected detection
 	void EnableNormalisationProbe() {useNormProbe = true;}
 	
+	/** \brief Circular buffer for delay lines and loopers
+
+		Holds the last N items of type T written, to be read back at any delay behind the
+		newest, in samples (0 being the newest) or in 128ths of a sample with linear
+		interpolation. Indices wrap with a mask when N is a power of two, and with a
+		compare and subtract otherwise, so no division is done for any N.
+		Delays must be less than N (less than N-1 samples for interpolated reads).
+		Not for passing data between cores.
+	*/
+	template <typename T, unsigned N>
+	class RingBuffer
+	{
+		static_assert(N > 1, "RingBuffer needs at least two items");
+		static constexpr bool pow2 = (N & (N - 1)) == 0;
+	public:
+		RingBuffer() : writeInd(0)
+		{
+			for (unsigned i = 0; i < N; i++) buf[i] = 0;
+		}
+
+		/// Add the newest item, overwriting the oldest
+		void __not_in_flash_func(Write)(T val)
+		{
+			buf[writeInd] = val;
+			writeInd = Wrap(writeInd + 1);
+		}
+
+		/// Add n items, oldest first
+		void __not_in_flash_func(WriteBlock)(const T *vals, unsigned n)
+		{
+			for (unsigned i = 0; i < n; i++) Write(vals[i]);
+		}
+
+		/// Item delay samples behind the newest
+		T __not_in_flash_func(Read)(unsigned delay) const
+		{
+			return buf[Behind(delay)];
+		}
+
+		/// Copy out n items, oldest first, the newest being delay samples behind the newest written
+		void __not_in_flash_func(ReadBlock)(T *vals, unsigned n, unsigned delay = 0) const
+		{
+			unsigned ind = Behind(delay + n - 1);
+			for (unsigned i = 0; i < n; i++)
+			{
+				vals[i] = buf[ind];
+				ind = Wrap(ind + 1);
+			}
+		}
+
+		/// Item delay128/128 samples behind the newest, linearly interpolated
+		T __not_in_flash_func(ReadInterp)(uint32_t delay128) const
+		{
+			int32_t r = delay128 & 0x7F;
+			unsigned ind1 = Behind(delay128 >> 7);
+			int32_t fromBuffer1 = buf[ind1];
+			int32_t fromBuffer2 = buf[Older(ind1)];
+			return (fromBuffer2 * r + fromBuffer1 * (128 - r)) >> 7;
+		}
+
+		/// Two interpolated taps at once, as ReadInterp, e.g. for left and right channels
+		void __not_in_flash_func(ReadInterp)(uint32_t delay128A, uint32_t delay128B, T &a, T &b) const
+		{
+			a = ReadInterp(delay128A);
+			b = ReadInterp(delay128B);
+		}
+
+		/// Item at absolute position ind (less than N), e.g. for a loop recorded since Reset
+		T &operator[](unsigned ind) {return buf[ind];}
+		const T &operator[](unsigned ind) const {return buf[ind];}
+
+		/// Position that the next Write will go to
+		unsigned WriteIndex() const {return writeInd;}
+		/// Make the next Write go to position 0, without clearing the contents
+		void Reset() {writeInd = 0;}
+
+	private:
+		static unsigned __not_in_flash_func(Wrap)(unsigned ind)
+		{
+			if (pow2) return ind & (N - 1);
+			return ind >= N ? ind - N : ind;
+		}
+		unsigned __not_in_flash_func(Behind)(unsigned delay) const
+		{
+			if (pow2) return (writeInd - 1 - delay) & (N - 1);
+			return Wrap(writeInd + (N - 1) - delay);
+		}
+		static unsigned __not_in_flash_func(Older)(unsigned ind)
+		{
+			if (pow2) return (ind - 1) & (N - 1);
+			return ind == 0 ? N - 1 : ind - 1;
+		}
+
+		unsigned writeInd;
+		T buf[N];
+	};
+
 	/// Callback, called once per sample at 48kHz
 	virtual void ProcessSample() = 0;
 
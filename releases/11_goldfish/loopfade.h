@@ -0,0 +1,62 @@
+#ifndef LOOPFADE_H
+#define LOOPFADE_H
+
+#include "varispeed.h"
+
+////////////////////////////////////////
+// Crossfade from an old read head to a new one, over a fixed N samples
+//
+// When a head jumps (a reset, or the wrap at the end of a loop), Start keeps
+// its old position, which the caller goes on stepping and reading, and Mix
+// fades it out against the new head with an equal-power table. The old head
+// is only read while a fade is running.
+
+template <unsigned N>
+class LoopFade
+{
+public:
+	static constexpr unsigned length = N;
+
+	// Start fading out a head that was at phase
+	void Start(int32_t phase)
+	{
+		oldPhase = phase;
+		remaining = N;
+	}
+
+	bool Active() const {return remaining != 0;}
+
+	// Position of the old head, for the caller to step and read during the fade
+	int32_t &OldPhase() {return oldPhase;}
+
+	// Mix of the new and old heads' samples (any scale up to 2^20), stepping the fade; only while Active
+	int32_t __not_in_flash_func(Mix)(int32_t in, int32_t old)
+	{
+		unsigned i = N - remaining--;
+		return (in * gain.g[i] + old * gain.g[N - i]) >> gainBits;
+	}
+
+private:
+	static constexpr int gainBits = 10;
+
+	// sin(pi/2 * i/N), so the old head's gain is the new one's mirrored
+	struct Gains
+	{
+		int16_t g[N + 1];
+	};
+	static constexpr Gains MakeGains()
+	{
+		Gains t = {};
+		for (unsigned i = 0; i <= N; i++)
+		{
+			t.g[i] = int16_t(varispeed::Sin(varispeed::pi / 2 * i / N) * (1 << gainBits) + 0.5);
+		}
+		return t;
+	}
+	static constexpr Gains gain = MakeGains();
+
+	int32_t oldPhase = 0;
+	unsigned remaining = 0;
+};
+
+#endif
@@ -1,6 +1,14 @@
 #include "ComputerCard.h"
 #include "quantiser.h"
 #include "divider.h"
+#include "packed12.h"
+#include "varispeed.h"
+#include "loopfade.h"
+
+// Interpolation of the loop in PLAY mode: varispeed::Linear, Hermite or Sinc
+#ifndef GOLDFISH_VARISPEED
+#define GOLDFISH_VARISPEED varispeed::Sinc
+#endif
 
 // 12 bit random number generator
 uint32_t __not_in_flash_func(rnd12)()
@@ -10,12 +18,6 @@ uint32_t __not_in_flash_func(rnd12)()
     return lcg_seed >> 20;
 }
 
-// Zero crossing detector
-bool __not_in_flash_func(zeroCrossing)(int16_t a, int16_t b)
-{
-    return (a < 0 && b >= 0) || (a >= 0 && b < 0);
-};
-
 // Highpass filter for delay
 int32_t __not_in_flash_func(highpass_process)(int32_t *out, int32_t b, int32_t in)
 {
@@ -34,13 +36,6 @@ public:
         startPosL = KnobVal(Knob::X) * bufSize >> 4;
         startPosR = KnobVal(Knob::Y) * bufSize >> 4;
 
-        for (int i = 0; i < bufSize; i++)
-        {
-            delaybuf[i] = 0;
-        }
-        writeInd = 0;
-        readIndL = 0;
-        readIndR = 0;
         cvsL = 0;
         cvsR = 0;
         halftime = false;
@@ -117,13 +112,6 @@ public:
                 audioL >>= 2;
                 audioLf >>= 2;
 
-                int16_t lastSampleL = 0;
-                int16_t lastSampleR = 0;
-
-                int16_t fromBufferL = 0;
-                int16_t fromBufferR = 0;
-
-
                 // internal clock rate and divisor
                 internalClockRate = cabs(x - 2048) * 50 >> 12 + 1;
                 divisor = (cabs(y - 2048) * 16 >> 12) + 1;
@@ -134,7 +122,8 @@ public:
                 {
                     runMode = RECORD;
                     loopLength = 0;
-                    writeInd = 0;
+                    delaybuf.Reset();
+                    cvBuf.Reset();
                     internalClockCounter = 0;
                     clockDivider.SetResetPhase(divisor);
                     pulseL = true;
@@ -165,7 +154,7 @@ public:
                 // Internal clock
                 internalClockCounter += internalClockRate;
 
-                if (internalClockCounter >= bufSize >> 2)
+                if (internalClockCounter >= internalClockPeriod)
                 {
                     internalClockCounter = 0;
 
@@ -194,7 +183,7 @@ public:
                     //each output (left and right) is read back with a different delay time, set by the big knob and the CV input
                     
                     //CVout2 is set to the quantised CV mix, the quantiser is also from Chris Johnson's Utility Pair project
-                    qSample = quantSample(cvMix);
+                    qSample = quant.process(cvMix, majorQuantScale);
 
                     int32_t k = (bigKnob_CV + 2048) >> 1; //2048 to 0
 
@@ -219,23 +208,9 @@ public:
                     cvsL = (cvsL * 255 + (cvtargL << 4)) >> 8;
                     cvsR = (cvsR * 255 + (cvtargR << 4)) >> 8;
 
-                    int64_t cvs1L = cvsL >> 7;
-                    int64_t cvs1R = cvsR >> 7;
-
-                    int64_t rL = cvsL & 0x7F;
-                    int64_t rR = cvsR & 0x7F;
-
-                    readIndL = (writeInd + (bufSize << 1) - (cvs1L)-1) % bufSize;
-                    readIndR = (writeInd + (bufSize << 1) - (cvs1R)-1) % bufSize;
-                    int32_t fromBuffer1L = delaybuf[readIndL];
-                    int32_t fromBuffer1R = delaybuf[readIndR];
-                    int readInd2L = (writeInd + (bufSize << 1) - (cvs1L)-2) % bufSize;
-                    int readInd2R = (writeInd + (bufSize << 1) - (cvs1R)-2) % bufSize;
-                    int32_t fromBuffer2L = delaybuf[readInd2L];
-                    int32_t fromBuffer2R = delaybuf[readInd2R];
-
-                    int32_t fromBufferL = (fromBuffer2L * rL + fromBuffer1L * (128 - rL)) >> 7;
-                    int32_t fromBufferR = (fromBuffer2R * rR + fromBuffer1R * (128 - rR)) >> 7;
+                    // cvsL and cvsR are the delay times, in 128ths of a sample
+                    int16_t fromBufferL, fromBufferR;
+                    delaybuf.ReadInterp(cvsL, cvsR, fromBufferL, fromBufferR);
 
                     outL = fromBufferL;
                     outR = fromBufferR;
@@ -244,11 +219,7 @@ public:
 
                     int32_t buf_write = highpass_process(&hpf, 200, audioLf);
 
-                    delaybuf[writeInd] = buf_write;
-
-                    writeInd++;
-                    if (writeInd >= bufSize)
-                        writeInd = 0;
+                    delaybuf.Write(buf_write);
 
                     break;
                 }
@@ -256,20 +227,16 @@ public:
                 {
 
                     // in record mode the audio is written to the delay buffer and the CV input is written to the CV buffer
-                    qSample = quantSample(cvMix);
+                    qSample = quant.process(cvMix, majorQuantScale);
 
-                    cvBuf[writeInd] = cvMix;
-                    delaybuf[writeInd] = audioLf;
+                    cvBuf.Write(cvMix);
+                    delaybuf.Write(audioLf);
 
                     outL = audioLf;
                     outR = audioLf;
 
                     outCV = cvMix;
 
-                    writeInd++;
-                    if (writeInd >= bufSize)
-                        writeInd = 0;
-
                     loopLength++;
                     if (loopLength > bufSize)
                     {
@@ -302,8 +269,11 @@ public:
                     dphaseL -= 1024;
                     dphaseR -= 1024;
 
-                    phaseL += dphaseL >> 1;
-                    phaseR += dphaseR >> 1;
+                    // Speeds in 256ths of a sample per sample
+                    int32_t speedL = dphaseL >> 1;
+                    int32_t speedR = dphaseR >> 1;
+                    phaseL += speedL;
+                    phaseR += speedR;
 
                     if (loopLength < 1)
                     {
@@ -312,16 +282,12 @@ public:
 
                     calculateStartPos();
 
-                    //This is really only a best effort to reduce discontinuities in the audio output that cause clicks on reset
-                    //It's not perfect and could be improved
-                    checkZero = zeroCrossing(outL, lastSampleL);
-
-                    lastSampleL = fromBufferL;
-                    lastSampleR = fromBufferR;
-
-                    if (reset && ((checkZero && Connected(Input::Audio1)) || !Connected(Input::Audio1)))
+                    // A reset jumps straight to the start positions, crossfading from where the heads were
+                    if (reset)
                     {
                         reset = false;
+                        fadeL.Start(phaseL);
+                        fadeR.Start(phaseR);
                         phaseL = startPosL;
                         phaseR = startPosR;
                         pulseL = true;
@@ -330,75 +296,30 @@ public:
                         internalClockCounter = 0;
                     };
 
-                    if (phaseL < 0)
+                    // Each head wraps early, by the distance a crossfade covers, so that the end of the
+                    // loop (or the start, playing backwards) fades into the other end as it finishes
+                    if (WrapEarly(phaseL, speedL, fadeL) || WrapLoop(phaseL))
                     {
-                        phaseL += loopLength << 8;
                         clockDivider.SetResetPhase(divisor);
                         pulseL = true;
                         pulseR = clockDivider.Step(true);
                     }
-                    if (phaseL > (loopLength << 8))
-                    {
-                        phaseL -= loopLength << 8;
-                        pulseL = true;
-                        clockDivider.SetResetPhase(divisor);
-                        pulseR = clockDivider.Step(true);
-                    }
-
-                    if (phaseR < 0)
-                    {
-                        phaseR += loopLength << 8;
-                    }
-                    if (phaseR > (loopLength << 8))
-                    {
-                        phaseR -= loopLength << 8;
-                    }
+                    if (!WrapEarly(phaseR, speedR, fadeR)) WrapLoop(phaseR);
 
                     int32_t rL = phaseL & 0xFF;
                     int32_t readIndL = phaseL >> 8;
-                    int32_t rR = phaseR & 0xFF;
-                    int32_t readIndR = phaseR >> 8;
-
-                    int32_t fadeLength = loopLength; // Adjust this value as needed for the fade length
+                    int32_t nextIndL = readIndL + 1;
+                    if (nextIndL >= loopLength)
+                        nextIndL -= loopLength;
 
-                    // Apply fade-out at the end of the loop
-                    if (phaseL >= (loopLength << 8) - fadeLength)
-                    {
-                        int32_t fadeOutFactor = ((loopLength << 8) - phaseL) * 256 / fadeLength;
-                        outL = ((delaybuf[readIndL] << 3) * (256 - rL) + (delaybuf[(readIndL + 1) % loopLength] << 3) * (rL)) * fadeOutFactor >> 8;
-                    }
-                    else
-                    {
-                        outL = (delaybuf[readIndL] << 3) * (256 - rL) + (delaybuf[(readIndL + 1) % loopLength] << 3) * (rL);
-                    }
-
-                    // Apply fade-in at the beginning of the loop
-                    if (phaseL < fadeLength)
-                    {
-                        int32_t fadeInFactor = phaseL * 256 / fadeLength;
-                        outL = outL * fadeInFactor >> 8;
-                    }
-
-                    if (phaseR >= (loopLength << 8) - fadeLength)
-                    {
-                        int32_t fadeOutFactor = ((loopLength << 8) - phaseR) * 256 / fadeLength;
-                        outR = ((delaybuf[readIndR] << 3) * (256 - rR) + (delaybuf[(readIndR + 1) % loopLength] << 3) * (rR)) * fadeOutFactor >> 8;
-                    }
-                    else
-                    {
-                        outR = (delaybuf[readIndR] << 3) * (256 - rR) + (delaybuf[(readIndR + 1) % loopLength] << 3) * (rR);
-                    }
-
-                    if (phaseR < fadeLength)
-                    {
-                        int32_t fadeInFactor = phaseR * 256 / fadeLength;
-                        outR = outR * fadeInFactor >> 8;
-                    }
+                    // Audio is read at the speed the phase moves, the CV (below) always linearly interpolated
+                    outL = ReadHead(phaseL, speedL, fadeL) << 3;
+                    outR = ReadHead(phaseR, speedR, fadeR) << 3;
 
                     if (loopLength > 0)
                     {
-                        outCV = (cvBuf[readIndL] * (256 - rL) + cvBuf[(readIndL + 1) % loopLength] * rL) >> 8;
-                        qSample = quantSample(outCV);
+                        outCV = (cvBuf.Get(readIndL) * (256 - rL) + cvBuf.Get(nextIndL) * rL) >> 8;
+                        qSample = quant.process(outCV, majorQuantScale);
                     }
 
                     outL >>= 11;
@@ -502,19 +423,20 @@ private:
     int16_t cv2;
     int16_t cvMix;
 
-    static constexpr uint32_t bufSize = 64000;
-    int16_t delaybuf[bufSize];
-    int16_t cvBuf[bufSize];
-    unsigned writeInd, readIndL, readIndR, cvsL, cvsR;
+    // 12-bit samples, packed, so 1.78 seconds each in the RAM that 64000 int16_t (1.33 seconds) would take
+    static constexpr uint32_t bufSize = 85332;
+    PackedRing12<bufSize> delaybuf;
+    PackedRing12<bufSize> cvBuf;
+    unsigned cvsL, cvsR;
     int32_t ledtimer = 0;
     int32_t hpf = 0;
-    bool checkZero = false;
     int phaseL = 0;
     int phaseR = 0;
     bool halftime;
-    Divider clockDivider;
+    ::Divider clockDivider; // divider.h, not ComputerCard::Divider in the shared header
     int divisor;
     int internalClockCounter = 0;
+    static constexpr int internalClockPeriod = 16000; // at internalClockRate 1
     int internalClockRate;
     bool lastRisingEdge1 = false;
     bool lastRisingEdge2 = false;
@@ -528,6 +450,7 @@ private:
     int audioRf2 = 0;
 
     int16_t qSample;
+    Quantiser quant;
 
     enum RunMode
     {
@@ -593,6 +516,64 @@ private:
         return result;
     };
 
+    // Crossfades at loop resets and wraps, 2.7ms long at the 24kHz that PLAY mode runs at
+    typedef LoopFade<64> Fade;
+    Fade fadeL, fadeR;
+
+    // Wrap a head that is within a crossfade of the end of the loop (or the start, playing
+    // backwards) to the other end, starting a fade from where it was, unless one is running
+    bool WrapEarly(int &phase, int32_t speed, Fade &fade)
+    {
+        int32_t loopEnd = loopLength << 8;
+        int32_t lead = Fade::length * cabs(speed);
+        if (fade.Active() || lead > loopEnd >> 1)
+            return false;
+
+        if (speed >= 0 && phase > loopEnd - lead)
+        {
+            fade.Start(phase);
+            phase -= loopEnd - lead;
+            return true;
+        }
+        if (speed < 0 && phase < lead)
+        {
+            fade.Start(phase);
+            phase += loopEnd - lead;
+            return true;
+        }
+        return false;
+    }
+
+    // Wrap a head that has left the loop, with no crossfade
+    bool WrapLoop(int &phase)
+    {
+        if (phase < 0)
+        {
+            phase += loopLength << 8;
+            return true;
+        }
+        if (phase > (loopLength << 8))
+        {
+            phase -= loopLength << 8;
+            return true;
+        }
+        return false;
+    }
+
+    // Sample of the loop at a head, times 256, mixed with the old head while a crossfade runs
+    int32_t ReadHead(int phase, int32_t speed, Fade &fade)
+    {
+        int32_t out = varispeed::Read<GOLDFISH_VARISPEED>(delaybuf, phase, loopLength, speed);
+        if (fade.Active())
+        {
+            int32_t &old = fade.OldPhase();
+            old += speed;
+            WrapLoop(old);
+            out = fade.Mix(out, varispeed::Read<GOLDFISH_VARISPEED>(delaybuf, old, loopLength, speed));
+        }
+        return out;
+    }
+
     void clip(int32_t &a)
     {
         if (a < -2047)
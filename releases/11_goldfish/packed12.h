@@ -0,0 +1,103 @@
+#ifndef PACKED12_H
+#define PACKED12_H
+
+////////////////////////////////////////
+// Circular buffer of 12-bit samples, packed two to every three bytes
+//
+// The same interface as ComputerCard::RingBuffer<int16_t, N>, for the
+// -2048 to 2047 range of the ADC, in three quarters of the memory.
+// Samples are clipped to 12 bits when written.
+// Even samples are in the low 12 bits of each three bytes, odd samples
+// in the high 12 bits:
+//   byte 0: even bits 0-7
+//   byte 1: odd bits 0-3 (high nibble), even bits 8-11 (low nibble)
+//   byte 2: odd bits 4-11
+
+
+template <unsigned N>
+class PackedRing12
+{
+	static_assert(N > 1 && (N & 1) == 0, "PackedRing12 needs an even number of samples");
+public:
+	PackedRing12()
+	{
+		writeInd = 0;
+		for (unsigned i = 0; i < sizeof(buf); i++)
+		{
+			buf[i] = 0;
+		}
+	}
+
+	// Add the newest sample, overwriting the oldest
+	void __not_in_flash_func(Write)(int32_t val)
+	{
+		if (val > 2047) val = 2047;
+		if (val < -2048) val = -2048;
+		uint8_t *b = &buf[(writeInd >> 1) * 3];
+		if (writeInd & 1)
+		{
+			b[1] = (b[1] & 0x0F) | ((val & 0x0F) << 4);
+			b[2] = val >> 4;
+		}
+		else
+		{
+			b[0] = val;
+			b[1] = (b[1] & 0xF0) | ((val >> 8) & 0x0F);
+		}
+		writeInd++;
+		if (writeInd >= N) writeInd = 0;
+	}
+
+	// Sample at absolute position ind (less than N)
+	int16_t __not_in_flash_func(Get)(unsigned ind) const
+	{
+		const uint8_t *b = &buf[(ind >> 1) * 3];
+		uint32_t v;
+		if (ind & 1)
+			v = (b[1] >> 4) | (b[2] << 4);
+		else
+			v = b[0] | (b[1] << 8);
+		// Sign extend from 12 bits
+		return int32_t(v << 20) >> 20;
+	}
+
+	// Sample delay samples behind the newest (0 being the newest)
+	int16_t __not_in_flash_func(Read)(unsigned delay) const
+	{
+		return Get(Behind(delay));
+	}
+
+	// Sample delay128/128 samples behind the newest, linearly interpolated
+	int16_t __not_in_flash_func(ReadInterp)(uint32_t delay128) const
+	{
+		int32_t r = delay128 & 0x7F;
+		unsigned ind1 = Behind(delay128 >> 7);
+		int32_t fromBuffer1 = Get(ind1);
+		int32_t fromBuffer2 = Get(ind1 == 0 ? N - 1 : ind1 - 1);
+		return (fromBuffer2 * r + fromBuffer1 * (128 - r)) >> 7;
+	}
+
+	// Two interpolated taps at once, e.g. for left and right channels
+	void __not_in_flash_func(ReadInterp)(uint32_t delay128A, uint32_t delay128B, int16_t &a, int16_t &b) const
+	{
+		a = ReadInterp(delay128A);
+		b = ReadInterp(delay128B);
+	}
+
+	// Position that the next Write will go to
+	unsigned WriteIndex() const {return writeInd;}
+	// Make the next Write go to position 0, without clearing the contents
+	void Reset() {writeInd = 0;}
+
+private:
+	unsigned __not_in_flash_func(Behind)(unsigned delay) const
+	{
+		unsigned ind = writeInd + (N - 1) - delay;
+		return ind >= N ? ind - N : ind;
+	}
+
+	unsigned writeInd;
+	uint8_t buf[N / 2 * 3];
+};
+
+#endif
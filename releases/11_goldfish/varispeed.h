@@ -0,0 +1,172 @@
+#ifndef VARISPEED_H
+#define VARISPEED_H
+
+#include <cstdint>
+
+////////////////////////////////////////
+// Varispeed interpolation, for reading a loop back at any speed
+//
+// Read returns the sample at a position in 24.8 fixed point, in a loop of
+// the first length samples of a buffer with Get(ind) (such as PackedRing12),
+// in 256ths of the buffer's units. Three qualities:
+//   Linear  - two points
+//   Hermite - four points, third-order (Catmull-Rom) Hermite, which keeps
+//             much more of the top end at slow speeds
+//   Sinc    - eight points, Blackman-windowed sinc, which also keeps the
+//             images out at slow speeds, and above 1x has its cutoff
+//             lowered with the speed (in steps, up to 3x), against aliasing
+// Hermite and Sinc take their coefficients from tables (in flash, built at
+// compile time) of all 256 sub-sample positions, so a read is just one
+// multiply-add per point.
+
+namespace varispeed
+{
+	enum Quality {Linear, Hermite, Sinc};
+
+	constexpr int phases = 256;
+	constexpr int coefficientBits = 14;
+
+	constexpr double pi = 3.14159265358979323846;
+
+	// sin from its Taylor series, for the tables
+	constexpr double Sin(double x)
+	{
+		while (x > pi) x -= 2 * pi;
+		while (x < -pi) x += 2 * pi;
+		double term = x, sum = x;
+		for (int n = 1; n < 12; n++)
+		{
+			term *= -x * x / ((2 * n) * (2 * n + 1));
+			sum += term;
+		}
+		return sum;
+	}
+	constexpr double Cos(double x) {return Sin(x + pi / 2);}
+
+	// Coefficients for each sub-sample position, scaled to sum to exactly 1 << coefficientBits
+	template <int taps>
+	struct Kernel
+	{
+		int16_t c[phases][taps];
+	};
+
+	template <int taps>
+	constexpr void Quantise(const double (&h)[taps], int16_t (&c)[taps])
+	{
+		double sum = 0;
+		for (int j = 0; j < taps; j++) sum += h[j];
+		int total = 0, largest = 0;
+		for (int j = 0; j < taps; j++)
+		{
+			double v = h[j] * (1 << coefficientBits) / sum;
+			c[j] = int16_t(v >= 0 ? v + 0.5 : v - 0.5);
+			total += c[j];
+			if (c[j] > c[largest]) largest = j;
+		}
+		c[largest] += (1 << coefficientBits) - total;
+	}
+
+	// Points at offsets -1 to 2 from the sample before the position
+	constexpr Kernel<4> MakeHermite()
+	{
+		Kernel<4> k = {};
+		for (int p = 0; p < phases; p++)
+		{
+			double t = p / double(phases);
+			double h[4] = {
+				(-t * t * t + 2 * t * t - t) / 2,
+				(3 * t * t * t - 5 * t * t + 2) / 2,
+				(-3 * t * t * t + 4 * t * t + t) / 2,
+				(t * t * t - t * t) / 2};
+			Quantise(h, k.c[p]);
+		}
+		return k;
+	}
+
+	// Points at offsets -3 to 4, in bands for speeds up to 1x, 1.5x, 2x and 3x,
+	// each with its cutoff at the Nyquist frequency divided by the speed. The first is
+	// the samples themselves at whole-sample positions
+	constexpr int sincBands = 4;
+	constexpr double sincBandSpeed[sincBands] = {1.0, 1.5, 2.0, 3.0};
+
+	struct SincKernels
+	{
+		Kernel<8> band[sincBands];
+	};
+
+	constexpr SincKernels MakeSinc()
+	{
+		SincKernels k = {};
+		for (int b = 0; b < sincBands; b++)
+		{
+			double fc = 1 / sincBandSpeed[b];
+			for (int p = 0; p < phases; p++)
+			{
+				double h[8] = {};
+				for (int j = 0; j < 8; j++)
+				{
+					double x = (j - 3) - p / double(phases);
+					double sinc = x == 0 ? 1 : Sin(pi * fc * x) / (pi * fc * x);
+					double window = 0.42 + 0.5 * Cos(pi * x / 4) + 0.08 * Cos(2 * pi * x / 4);
+					h[j] = sinc * window;
+				}
+				Quantise(h, k.band[b].c[p]);
+			}
+		}
+		return k;
+	}
+
+	constexpr Kernel<4> hermite = MakeHermite();
+	constexpr SincKernels sinc = MakeSinc();
+
+	// Index wrapped into a loop of length samples
+	inline int32_t Wrap(int32_t ind, int32_t length)
+	{
+		while (ind < 0) ind += length;
+		while (ind >= length) ind -= length;
+		return ind;
+	}
+
+	// Sum of taps points of buf from first, weighted by c
+	template <int taps, class Buffer>
+	int32_t __not_in_flash_func(Convolve)(const Buffer &buf, const int16_t *c, int32_t first, int32_t length)
+	{
+		int32_t sum = 0;
+		if (first >= 0 && first + taps <= length)
+		{
+			for (int j = 0; j < taps; j++) sum += c[j] * buf.Get(first + j);
+		}
+		else
+		{
+			for (int j = 0; j < taps; j++) sum += c[j] * buf.Get(Wrap(first + j, length));
+		}
+		return sum >> (coefficientBits - 8);
+	}
+
+	// Sample at pos (24.8 fixed point) of a loop of the first length samples of buf,
+	// times 256, read at speed (256ths of a sample per sample, either way)
+	template <Quality quality, class Buffer>
+	int32_t __not_in_flash_func(Read)(const Buffer &buf, int32_t pos, int32_t length, int32_t speed)
+	{
+		int32_t r = pos & 0xFF;
+		int32_t ind = pos >> 8;
+		if (quality == Linear)
+		{
+			int32_t next = ind + 1;
+			if (next >= length) next -= length;
+			return buf.Get(ind) * (256 - r) + buf.Get(next) * r;
+		}
+		else if (quality == Hermite)
+		{
+			return Convolve<4>(buf, hermite.c[r], ind - 1, length);
+		}
+		else
+		{
+			if (speed < 0) speed = -speed;
+			int band = speed <= 256 ? 0 : speed <= 384 ? 1 : speed <= 512 ? 2 : 3;
+			return Convolve<8>(buf, sinc.band[band].c[r], ind - 3, length);
+		}
+	}
+}
+
+#endif
@@ -1,11 +1,22 @@
 #include <cstdint>
+#include "hardware/dma.h"
+#include "hardware/structs/xip_ctrl.h"
 
 ////////////////////////////////////////
 // A very simple WAV file parsing class.
 //
 // Takes a WAV file mapped into memory (e.g. in flash)
 // and gives an interface to the samples and basic format info
-// Currently hard-coded to 16-bit mono PCM files
+// Supports mono 16-bit PCM, 8-bit u-law and 4-bit IMA ADPCM files,
+// the last as written by generate_sample_uf2.html: blocks of 256 samples,
+// each a 4-byte header (first sample, step index) then 255 4-bit codes.
+// ADPCM blocks are decoded into a small SRAM cache as they are played.
+//
+// Sample data in flash is streamed into SRAM a chunk at a time ahead of
+// the play position, through the XIP stream FIFO and a DMA channel, so
+// that playing megabytes of samples doesn't evict code from the XIP cache.
+// Samples in a chunk that hasn't arrived yet (just after a jump) are read
+// from flash directly, as before.
 
 class WAVFile
 {
@@ -30,13 +41,173 @@ private:
 		return (a4<<24)+(a3<<16)+(a2<<8)+a1;
 	}
 
+	static int16_t DecodeMuLaw(uint8_t u)
+	{
+		u = ~u;
+		int32_t t = (((u & 0x0F) << 3) + 0x84) << ((u & 0x70) >> 4);
+		return (u & 0x80) ? 0x84 - t : t - 0x84;
+	}
+
+	static void DecodeADPCM(int32_t &pred, int32_t &index, unsigned nibble)
+	{
+		static const int16_t stepTable[89] = {
+			7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+			50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+			337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+			2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+			15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+		static const int8_t indexTable[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+		int32_t step = stepTable[index];
+		int32_t diff = step >> 3;
+		if (nibble & 4) diff += step;
+		if (nibble & 2) diff += step >> 1;
+		if (nibble & 1) diff += step >> 2;
+		pred += (nibble & 8) ? -diff : diff;
+		if (pred > 32767) pred = 32767; else if (pred < -32768) pred = -32768;
+		index += indexTable[nibble & 7];
+		if (index < 0) index = 0; else if (index > 88) index = 88;
+	}
+
+	// Decoded ADPCM blocks, shared by all files as only one is played at a time.
+	// Consecutive blocks go in different entries, so interpolating across a block
+	// boundary doesn't decode either block twice. Each block is decoded only as far
+	// as has been read, so playing costs about one sample's decoding per sample.
+	struct BlockCache
+	{
+		const uint8_t *block;
+		unsigned decoded;
+		int32_t pred, index;
+		int16_t samples[256];
+	};
+	static inline BlockCache cache[2] = {};
+
+	// Chunks of sample data streamed from flash, shared by all files as only one
+	// is played at a time. Chunks are counted from the word below the file's data,
+	// as the stream FIFO reads whole words.
+	static constexpr unsigned chunkBits = 9, chunkBytes = 1u << chunkBits;
+	struct Chunk
+	{
+		const uint8_t *base; // file's data, rounded down to a word
+		uint32_t number;
+		uint32_t words[chunkBytes / 4];
+	};
+	static inline Chunk chunks[2] = {};
+	static inline int streamSlot = -1; // chunk being streamed into, if any
+	static inline int dmaChannel = -2; // -2 before the first stream, -1 if none was free
+
+	// The byte at offset bytes into the file's data, from SRAM if its chunk has been
+	// streamed, otherwise from flash
+	const uint8_t *Raw(uint32_t offset)
+	{
+		offset += skew;
+		uint32_t number = offset >> chunkBits;
+		const uint8_t *base = dataptr - skew;
+		for (int slot=0; slot<2; slot++)
+		{
+			const Chunk &c = chunks[slot];
+			if (c.number == number && c.base == base && slot != streamSlot)
+			{
+				return (const uint8_t *)c.words + (offset & (chunkBytes - 1));
+			}
+		}
+		return base + offset;
+	}
+
+	// Stream the chunk after the one holding byte offset, if it isn't in SRAM already.
+	// Called once per sample played, so a chunk is never overwritten while being read.
+	void Prefetch(uint32_t offset)
+	{
+		if (dmaChannel == -2) dmaChannel = dma_claim_unused_channel(false);
+		if (dmaChannel < 0) return;
+		if (streamSlot >= 0)
+		{
+			if (dma_channel_is_busy(dmaChannel)) return;
+			streamSlot = -1;
+		}
+
+		const uint8_t *base = dataptr - skew;
+		uint32_t number = (offset + skew) >> chunkBits;
+		uint32_t next = number + 1;
+		if (next >= numChunks) next = 0; // playback loops
+		if (next == number) return;      // whole file in one chunk: read from flash
+		int slot = (chunks[0].number == number && chunks[0].base == base) ? 1 : 0;
+		Chunk &c = chunks[slot];
+		if (c.number == next && c.base == base) return;
+		if (chunks[slot ^ 1].number == next && chunks[slot ^ 1].base == base) return;
+
+		// Empty the stream FIFO of anything left over, then stream the chunk by DMA
+		c.base = base;
+		c.number = next;
+		streamSlot = slot;
+		while (!(xip_ctrl_hw->stat & XIP_STAT_FIFO_EMPTY_BITS)) (void)xip_ctrl_hw->stream_fifo;
+		xip_ctrl_hw->stream_addr = (uint32_t)(base + (next << chunkBits));
+		xip_ctrl_hw->stream_ctr = chunkBytes / 4;
+		dma_channel_config cfg = dma_channel_get_default_config(dmaChannel);
+		channel_config_set_read_increment(&cfg, false);
+		channel_config_set_write_increment(&cfg, true);
+		channel_config_set_dreq(&cfg, DREQ_XIP_STREAM);
+		dma_channel_configure(dmaChannel, &cfg, c.words, (const void *)XIP_AUX_BASE, chunkBytes / 4, true);
+	}
+
+	// Streaming only applies to data in flash; chunks go to the end of the data
+	void SetData(uint8_t *data)
+	{
+		dataptr = data;
+		skew = (uint32_t)data & 3;
+		uint32_t bytes = format == PCM16 ? numSamples * 2 : format == MuLaw ? numSamples : ((numSamples + 255) >> 8) * 132;
+		bool inFlash = (uint32_t)data >= XIP_BASE && (uint32_t)data < XIP_BASE + PICO_FLASH_SIZE_BYTES;
+		numChunks = inFlash ? (bytes + skew + chunkBytes - 1) >> chunkBits : 0;
+	}
+
+	int16_t Sample(uint32_t i)
+	{
+		if (format == PCM16)
+		{
+			const uint8_t *p = Raw(i * 2); // WAV data is 2-byte aligned, so both bytes are in one chunk
+			return (int16_t)(p[0] | (p[1] << 8));
+		}
+		if (format == MuLaw) return DecodeMuLaw(*Raw(i));
+
+		uint32_t k = i >> 8;
+		unsigned o = i & 255;
+		const uint8_t *block = dataptr + k * 132;
+		BlockCache &c = cache[k & 1];
+		if (c.block != block)
+		{
+			c.block = block;
+			c.pred = (int16_t)(*Raw(k * 132) | (*Raw(k * 132 + 1) << 8));
+			uint8_t index = *Raw(k * 132 + 2);
+			c.index = (index > 88) ? 88 : index;
+			c.samples[0] = c.pred;
+			c.decoded = 1;
+		}
+		for (; c.decoded <= o; c.decoded++)
+		{
+			unsigned n = c.decoded - 1;
+			DecodeADPCM(c.pred, c.index, (*Raw(k * 132 + 4 + (n >> 1)) >> ((n & 1) << 2)) & 0x0F);
+			c.samples[c.decoded] = c.pred;
+		}
+		return c.samples[o];
+	}
+
+	// Byte offset of sample i in the file's data
+	uint32_t Offset(uint32_t i)
+	{
+		return format == PCM16 ? i * 2 : format == MuLaw ? i : (i >> 8) * 132;
+	}
+
 public:
+	enum Format {PCM16 = 0, MuLaw = 1, ADPCM = 2}; // as in the sample upload index
+
 	WAVFile()
 	{
 		dataptr = nullptr;
+		skew = 0;
+		numChunks = 0;
 		numSamples = 0;
 		sampleRate = 0;
 		fileSize = 0;
+		format = PCM16;
 	}
 
 	// Get raw sample
@@ -47,7 +218,7 @@ public:
 			return 0;
 		}
 		
-		return dataptr[index];
+		return Sample(index);
 	}
 
 	// Get sample value at fractional position index/256, linearly interpolated.
@@ -65,7 +236,9 @@ public:
 		uint32_t nextIndex = index+1;
 		if (nextIndex > numSamples) nextIndex -= numSamples;
 		
-		return (dataptr[index]*(256-r) + dataptr[nextIndex]*r)>>8;
+		int16_t a = Sample(index), b = Sample(nextIndex);
+		if (numChunks) Prefetch(Offset(index));
+		return (a*(256-r) + b*r)>>8;
 	}
 
 	uint32_t SampleRate() {return sampleRate;}
@@ -73,6 +246,17 @@ public:
 	uint32_t NumSamples() {return numSamples;}
 	uint16_t NumChannels() {return numChannels;}
 	
+	// Use sample data already located in memory, e.g. from the sample upload index
+	void Set(uint8_t *data, uint32_t samples, uint32_t rate, Format fmt = PCM16)
+	{
+		format = fmt;
+		numSamples = samples;
+		numChannels = 1;
+		sampleRate = rate;
+		fileSize = 0;
+		SetData(data);
+	}
+
 	int Load(uint8_t *startptr)
 	{
 		uint8_t *ptr = startptr;
@@ -90,36 +274,64 @@ public:
 		uint32_t subChunkSize = GetU32(ptr);
 
 		uint16_t audioFormat = GetU16(ptr);
-		if (audioFormat != 1) return 4; // must be PCM format
+		if (audioFormat == 1) format = PCM16;
+		else if (audioFormat == 7) format = MuLaw;
+		else if (audioFormat == 0x11) format = ADPCM;
+		else return 4; // must be PCM, u-law or IMA ADPCM
 
 		numChannels = GetU16(ptr);
 		if (numChannels != 1) return 5; // must be mono
 
 		sampleRate = GetU32(ptr);
 
-		ptr += 6; // skip 'byte rate' and 'block align' fields
+		ptr += 4; // skip 'byte rate' field
+		uint16_t blockAlign = GetU16(ptr);
 	
 		uint16_t bitsPerSample  = GetU16(ptr);
-		if (bitsPerSample != 16) return 6; // must be 16-bit
+		if (bitsPerSample != (format == PCM16 ? 16 : format == MuLaw ? 8 : 4)) return 6; // must be 16-bit PCM, 8-bit u-law or 4-bit ADPCM
+		if (format == ADPCM)
+		{
+			// must have the generator's block layout, of 256 samples per block
+			if (blockAlign != 132 || subChunkSize < 20) return 6;
+			ptr += 2;
+			if (GetU16(ptr) != 256) return 6;
+			subChunkSize -= 4;
+		}
 
 		// skip any 'extra params' which may or may not be in the format chunk
-		if (subChunkSize>16) {ptr += subChunkSize-16;}
-	
+		if (subChunkSize>16) {ptr += subChunkSize - 16 + (subChunkSize & 1);}
+
+		// skip other chunks ('fact', 'JUNK'...) up to the sample data,
+		// noting the number of samples of compressed files from the 'fact' chunk
+		uint32_t factSamples = 0;
 		uint32_t dataMarker = GetU32(ptr);
-		if (dataMarker != 0x61746164) return 7;
+		while (dataMarker != 0x61746164)
+		{
+			uint32_t chunkSize = GetU32(ptr);
+			if (dataMarker == 0x74636166 && chunkSize >= 4) {uint8_t *p = ptr; factSamples = GetU32(p);}
+			ptr += chunkSize + (chunkSize & 1);
+			if (ptr >= startptr + fileSize) return 7;
+			dataMarker = GetU32(ptr);
+		}
 
-		numSamples = GetU32(ptr) / numChannels / (bitsPerSample/8);
+		uint32_t dataSize = GetU32(ptr);
+		if (format == PCM16) numSamples = dataSize / 2;
+		else if (format == MuLaw) numSamples = dataSize;
+		else numSamples = (dataSize / 132) * 256;
+		if (format != PCM16 && factSamples && factSamples < numSamples) numSamples = factSamples;
 
-		
 		// WAV file format specifies that all data is an even number
-		// of bytes long, so 16-bit samples are aligned, so we can just cast here
-		// (WAV and Arm Cortex M0+ both little endian too)
-		dataptr = (int16_t*)ptr;
+		// of bytes long, so 16-bit samples are aligned, so we can just read
+		// them directly (WAV and Arm Cortex M0+ both little endian too)
+		SetData(ptr);
 
 		return 0;
 	}
 	
-	int16_t *dataptr;
+	uint8_t *dataptr;
+	uint32_t skew;      // dataptr's offset from a word boundary
+	uint32_t numChunks; // of streamed data, 0 if not streamed
+	Format format;
 	uint32_t numSamples;
 	uint16_t numChannels;
 	uint32_t sampleRate;
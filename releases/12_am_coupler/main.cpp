@@ -4,12 +4,10 @@
 #include "pico/stdlib.h" 
 #include <cstdio>
 #include <cstring>
-#include <vector>
-#include "pico/multicore.h"
+#include "hardware/pio.h"
+#include "am_rf.pio.h"
 #include <algorithm>
 
-volatile int32_t amValue=0, fqValue=1024000;
-
 class WindowNR
 {
 public:
@@ -41,7 +39,7 @@ public:
 		startupTimer = 48000;
 		
 		// Set up UART TX pin as RF output
-		SetupDebugPinAsPWM();
+		SetupRF();
 
 		// Ground the UART_RX pin
 		gpio_init(DEBUG_2);
@@ -49,48 +47,93 @@ public:
 		gpio_put(DEBUG_2, false);	
 	}
 
-	static void __not_in_flash_func(OnRFPWMWrap)()
-	{	
-		static int32_t amError = 0, fqError = 0;
-		int32_t amv = amValue, fqv = fqValue;
-		//sio_hw->gpio_set = 2; // turn on DEBUG_2 LED
-		uint32_t amTruncated = (amv - amError) & 0xFFFFF000;
-		uint32_t fqTruncated = (fqv - fqError) & 0xFFFFF000;
-		
-	   	amError += amTruncated - amv;
-		fqError += fqTruncated - fqv;
-		pwm_hw->slice[0].cc = amTruncated >> 12;
-		pwm_hw->slice[0].top = fqTruncated >> 12;
-		//sio_hw->gpio_clr = 2; // turn off DEBUG_2 LED
-		
-		pwm_hw->intr = 1; // clear interrupt flag for slice 0
+	// The RF carrier is generated by a PIO state machine, one carrier cycle per 32-bit word,
+	// fed by a DMA channel endlessly reading a ring buffer of words. ProcessSample tops up
+	// the ring each sample with the cycles played since the last, so the carrier costs no
+	// interrupts, and the ring gives a few hundred microseconds of slack.
+	void SetupRF()
+	{
+		PIO pio = pio0;
+		uint sm = pio_claim_unused_sm(pio, true);
+		uint offset = pio_add_program(pio, &am_rf_program);
+
+		// Start with carrier off
+		for (unsigned i=0; i<rfRingWords; i++) rfRing[i] = RFWord(220, 0);
+		am_rf_program_init(pio, sm, offset, DEBUG_1);
+
+		rfDMA = dma_claim_unused_channel(true);
+		int reloadDMA = dma_claim_unused_channel(true);
+
+		dma_channel_config c = dma_channel_get_default_config(rfDMA);
+		channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+		channel_config_set_read_increment(&c, true);
+		channel_config_set_write_increment(&c, false);
+		channel_config_set_ring(&c, false, rfRingBits + 2); // wrap read address around the ring
+		channel_config_set_dreq(&c, pio_get_dreq(pio, sm, true));
+		channel_config_set_chain_to(&c, reloadDMA);
+		dma_channel_configure(rfDMA, &c, &pio->txf[sm], rfRing, 0xFFFFFFFF, false);
+
+		// When the transfer count runs out, after tens of minutes, restart it, carrying on around the ring
+		static const uint32_t transferCount = 0xFFFFFFFF;
+		dma_channel_config r = dma_channel_get_default_config(reloadDMA);
+		channel_config_set_transfer_data_size(&r, DMA_SIZE_32);
+		channel_config_set_read_increment(&r, false);
+		channel_config_set_write_increment(&r, false);
+		dma_channel_configure(reloadDMA, &r, &dma_hw->ch[rfDMA].al1_transfer_count_trig, &transferCount, 1, false);
+
+		dma_channel_start(rfDMA);
 	}
 
-	
-	void SetupDebugPinAsPWM()
+	// PIO word for one carrier cycle of period cycles, high for high cycles (see am_rf.pio)
+	static uint32_t RFWord(uint32_t period, uint32_t high)
 	{
-		gpio_set_function(DEBUG_1, GPIO_FUNC_PWM);
-		// now create PWM config struct
-		pwm_config config = pwm_get_default_config();
-		pwm_config_set_wrap(&config, 220);
+		if (high == 0) return (period - 4) << 16;
+		if (high > period - 5) high = period - 5;
+		return high | ((period - high - 5) << 16);
+	}
 
-		// now set this PWM config to apply to the two outputs
-		pwm_init(pwm_gpio_to_slice_num(DEBUG_1), &config, true);
-		
-		// set initial level 
-		pwm_set_gpio_level(DEBUG_1, 0);
+	// Fill the ring up to the word before the one the DMA will read next, with carrier cycles
+	// of period and high time given in 1/65536ths of a PIO cycle. The fractional parts are
+	// carried from each cycle to the next, so the average frequency and amplitude are exact
+	void __not_in_flash_func(FillRF)(uint32_t period, uint32_t high)
+	{
+		uint32_t next = (dma_hw->ch[rfDMA].read_addr - (uint32_t)rfRing) >> 2;
+		uint32_t stop = (next - 1) & (rfRingWords - 1);
+		while (rfWrite != stop)
+		{
+			periodAcc += period;
+			highAcc += high;
+			rfRing[rfWrite] = RFWord(periodAcc >> 16, highAcc >> 16);
+			periodAcc &= 0xFFFF;
+			highAcc &= 0xFFFF;
+			rfWrite = (rfWrite + 1) & (rfRingWords - 1);
+		}
+	}
 
-		
-		// Turn on IRQ for CV output PWM
-		uint slice_num = pwm_gpio_to_slice_num(DEBUG_1);
-		pwm_clear_irq(slice_num);
-		pwm_set_irq_enabled(slice_num, true);
-		
-		irq_set_exclusive_handler(PWM_IRQ_WRAP, AMCoupler::OnRFPWMWrap);
-		irq_set_priority(PWM_IRQ_WRAP, PICO_HIGHEST_IRQ_PRIORITY);
-		irq_set_enabled(PWM_IRQ_WRAP, true);	
+	// Fill wavfiles from the sample index, if the last block of flash points to a valid one
+	bool LoadWAVIndex()
+	{
+		const uint32_t *footer = (uint32_t *)(XIP_BASE + PICO_FLASH_SIZE_BYTES - 256);
+		if (footer[2] != 0x49534343) return false; // "CCSI"
+		uint32_t indexAddress = footer[3];
+		if (indexAddress < XIP_BASE || indexAddress + 16 + numFiles*20 > XIP_BASE + PICO_FLASH_SIZE_BYTES) return false;
+
+		// Header (magic, count, check, sample format), then entries of
+		// data address, length, sample rate, loop start, loop end
+		const uint32_t *index = (const uint32_t *)indexAddress;
+		if (index[0] != 0x49534343 || index[1] != numFiles || index[3] > WAVFile::ADPCM) return false;
+		uint32_t check = 0x811C9DC5;
+		for (unsigned i=0; i<numFiles*5; i++) check = (check ^ index[4+i]) * 0x01000193;
+		if (check != index[2]) return false;
+
+		for (unsigned i=0; i<numFiles; i++)
+		{
+			const uint32_t *e = index + 4 + i*5;
+			wavfiles[i].Set((uint8_t *)e[0], e[1], e[2], (WAVFile::Format)index[3]);
+		}
+		return true;
 	}
-	
+
 	// Load WAV files uploaded to the RP2040 using a UF2 from the generate_sample_uf2.html page
 	int LoadWAVsFromFlash()
 	{
@@ -101,7 +144,7 @@ public:
 		numFiles = *wavStart; // get number of WAV files
 
 		// If an invalid number of files, probably no valid sample UF2 was uploaded
-		if (numFiles == 0 || numFiles > 256)
+		if (numFiles == 0 || numFiles > maxFiles)
 		{
 			numFiles = 0;
 			return -1;
@@ -114,8 +157,9 @@ public:
 			return -1;
 		}
 
-		// If above tests pass, create list of wav files
-		wavfiles = std::vector<WAVFile>(numFiles);
+		// Newer sample UF2s also carry an index of the files (see ComputerCard::SampleBank),
+		// giving the sample data of each directly, with no need to walk the WAV headers
+		if (LoadWAVIndex()) return 0;
 
 		// Loop through wav files, processing each in turn
 		uint8_t *wavptr = ((uint8_t *)(wavStartAddress));
@@ -227,15 +271,18 @@ public:
 
 
 
-		// RF frequency is 220MHz * 4096 / (fqValue+1)
+		// RF frequency is 220MHz * 4096 / (fqValue+4096)
 		// Main knob controls frequency over MW band, between 530 and 1600kHz approximately
-		// Knob X adds fine tune
-	   	fqValue = 563200 + (4095-mainKnobNR(KnobVal(Main)))*280 - KnobVal(X)*6 - CVIn1()*6;
+		// Knob X adds fine tune, and CV 1 frequency modulation
+	   	int32_t fqValue = 563200 + (4095-mainKnobNR(KnobVal(Main)))*280 - KnobVal(X)*6 - CVIn1()*6;
 
 		// If RF output is off, set duty cycle to 0.
 		// Otherwise, duty cycle is (0.25 + the audio), ranging from 0 to 0.5 at most.
 		// This sets the amplitude
-		amValue = rfOn?((signal+2048)*(fqValue>>13)):0;
+		int32_t amValue = rfOn?((signal+2048)*(fqValue>>13)):0;
+
+		// Period and high time, in 1/65536ths of a PIO cycle
+		FillRF((fqValue+4096)<<4, amValue<<4);
 	}
 
 	
@@ -244,34 +291,26 @@ private:
 	WindowNR mainKnobNR;
 	
 	unsigned numFiles, currentFile;
-	std::vector<WAVFile> wavfiles;
+	// Room for the most files a sample UF2 can hold, so nothing is allocated at startup
+	static constexpr unsigned maxFiles = 256;
+	WAVFile wavfiles[maxFiles];
 
 	unsigned startupTimer;
+
+	static constexpr unsigned rfRingBits = 8, rfRingWords = 1u << rfRingBits;
+	static inline uint32_t rfRing[rfRingWords] __attribute__((aligned(4 << rfRingBits)));
+	int rfDMA;
+	uint32_t rfWrite = 0, periodAcc = 0, highAcc = 0;
 };
 
 
-AMCoupler *amp;
-void core1()
-{
-	amp->Run();
-}
-
 int main()
 {
-	// Mild overclock, required to fit even worse-case jitter of PWM IRQ into the 625ns available
+	// Mild overclock, giving finer steps of the PIO clock for the RF carrier
 	set_sys_clock_khz(220000, true);
 
-	AMCoupler am;
-	amp = &am;
+	// Static, as the card is too large for the stack
+	static AMCoupler am;
 	am.EnableNormalisationProbe();
-
-	// Run ComputerCard audio on core 1
-	multicore_launch_core1(core1);
-
-	// This core just does RF IRQ
-	while (1)
-	{
-		__wfi();
-	}
+	am.Run();
 }
-
@@ -0,0 +1,183 @@
+// Lazy activation and click-free switching between noisebox algorithms
+//
+// Nothing is warmed at boot. When the selection moves to an algorithm that has not run yet, a warm-up
+// request goes to core1, which runs that algorithm for a while so its filters/reverbs settle, while
+// core0 keeps playing the previous one. Once it is warm, core0 crossfades old -> new over FADE_SAMPLES.
+//
+// Ownership: an algorithm is only ever touched by core1 while it is not warm, and only rendered by
+// core0 once core0 has seen it come back warm, so the two cores never share algorithm state.
+// (A manager whose next()/nextBlock() run on core1 itself works the same way, with core1 servicing
+// its own warm-ups between blocks.)
+// Resources: activate(i) runs on core0 before an algorithm is warmed (e.g. to borrow delay memory from
+// the arena) and may refuse, in which case it is retried on later samples. deactivate(i) runs on core0
+// once an algorithm has faded out; if it returns true the algorithm gave resources up and is cold again,
+// so it will be re-activated and re-warmed before its next use.
+
+#pragma once
+
+#include <cstdint>
+#include "ComputerCard.h"
+
+template <int NumAlgos>
+class AlgoManager {
+    static_assert(NumAlgos > 0 && NumAlgos < 128, "AlgoManager index must fit in int8_t");
+public:
+    static constexpr int FADE_SHIFT = 8;                 // 256 samples ≈ 5.3 ms at 48 kHz
+    static constexpr int FADE_SAMPLES = 1 << FADE_SHIFT;
+    static constexpr int WARMUP_SAMPLES = 1024;          // ~21 ms of settling per algorithm
+    static constexpr int WARMUP_CHUNK = 32;              // serviceWarmup() runs this many samples per call
+
+    AlgoManager()
+    {
+        for (int i = 0; i < NumAlgos; ++i) warm_[i] = false;
+    }
+
+    // Core0, once per sample. want = selected algorithm; render(i) returns one sample of algorithm i.
+    // bool activate(i) prepares a cold algorithm, bool deactivate(i) releases one that has faded out.
+    template <typename Render, typename Activate, typename Deactivate>
+    inline int16_t next(int want, Render&& render, Activate&& activate, Deactivate&& deactivate)
+    {
+        select(want, activate, deactivate);
+
+        int32_t y = (active_ >= 0) ? render(active_) : 0;
+        if (fadeCount_ > 0)
+        {
+            int32_t yn = render(next_);
+            y = (yn * fadeCount_ + y * (FADE_SAMPLES - fadeCount_)) >> FADE_SHIFT;
+            if (++fadeCount_ > FADE_SAMPLES) finishFade(want, deactivate);
+        }
+        return static_cast<int16_t>(y);
+    }
+
+    // Core0, once per block: as next(), for n samples. renderBlock(i, out, n) renders n samples of
+    // algorithm i into out[]. The selection is only re-examined at block boundaries; a crossfade
+    // runs over FADE_SAMPLES samples whatever the block size.
+    template <typename RenderBlock, typename Activate, typename Deactivate>
+    inline void nextBlock(int want, int16_t* out, int n, RenderBlock&& renderBlock, Activate&& activate, Deactivate&& deactivate)
+    {
+        select(want, activate, deactivate);
+
+        if (active_ >= 0) renderBlock(active_, out, n);
+        else for (int j = 0; j < n; ++j) out[j] = 0;
+
+        if (fadeCount_ > 0)
+        {
+            int16_t yn[FADE_CHUNK];
+            for (int j0 = 0; j0 < n; j0 += FADE_CHUNK)
+            {
+                const int m = (n - j0 < FADE_CHUNK) ? n - j0 : FADE_CHUNK;
+                renderBlock(next_, yn, m);
+                for (int j = 0; j < m; ++j)
+                {
+                    if (fadeCount_ <= FADE_SAMPLES)
+                    {
+                        const int32_t y = out[j0 + j];
+                        out[j0 + j] = static_cast<int16_t>((yn[j] * fadeCount_ + y * (FADE_SAMPLES - fadeCount_)) >> FADE_SHIFT);
+                        ++fadeCount_;
+                    }
+                    else
+                    {
+                        out[j0 + j] = yn[j]; // fade finished within this block
+                    }
+                }
+            }
+            if (fadeCount_ > FADE_SAMPLES) finishFade(want, deactivate);
+        }
+    }
+
+    int active() const { return active_; }
+
+    // Core1: run the next WARMUP_CHUNK samples of the oldest warm-up request, so warm-ups can be
+    // interleaved with other core1 work. warmup(i, n) runs algorithm i for n samples.
+    // Returns false if there was nothing to do.
+    template <typename Warmup>
+    bool serviceWarmup(Warmup&& warmup)
+    {
+        if (warming_ < 0)
+        {
+            uint8_t i;
+            if (!warmRequests_.Pop(i)) return false;
+            warming_ = static_cast<int8_t>(i);
+            warmLeft_ = WARMUP_SAMPLES;
+        }
+        if (warmLeft_ > 0)
+        {
+            warmup(warming_, WARMUP_CHUNK);
+            warmLeft_ -= WARMUP_CHUNK;
+        }
+        if (warmLeft_ <= 0 && warmDone_.Push(static_cast<uint8_t>(warming_))) warming_ = -1;
+        return true;
+    }
+
+    // Core1, never returns: service warm-ups only
+    template <typename Warmup>
+    void core1Loop(Warmup&& warmup)
+    {
+        while (true)
+        {
+            if (!serviceWarmup(warmup)) tight_loop_contents();
+        }
+    }
+
+private:
+    static constexpr int FADE_CHUNK = 32; // nextBlock renders the incoming algorithm this many samples at a time
+
+    // Collect finished warm-ups, then start a warm-up or a crossfade if the selection has changed
+    template <typename Activate, typename Deactivate>
+    inline void select(int want, Activate& activate, Deactivate& deactivate)
+    {
+        uint8_t done;
+        while (warmDone_.Pop(done))
+        {
+            warm_[done] = true;
+            if (done == pending_) pending_ = -1;
+            // Selection moved on while it was warming: don't let it sit on its resources
+            if (done != want && deactivate(done)) warm_[done] = false;
+        }
+
+        if (fadeCount_ == 0 && want != active_)
+        {
+            if (warm_[want])
+            {
+                // Start fading to the new algorithm
+                next_ = static_cast<int8_t>(want);
+                fadeCount_ = 1;
+            }
+            else if (pending_ < 0 && !warmRequests_.Full() && activate(want))
+            {
+#ifdef COMPUTERCARD_HAS_MULTICORE
+                // Keep playing the current algorithm while core1 warms the new one
+                warmRequests_.Push(static_cast<uint8_t>(want));
+                pending_ = static_cast<int8_t>(want);
+#else
+                // No second core: switch straight away, unwarmed
+                warm_[want] = true;
+#endif
+            }
+        }
+    }
+
+    // The incoming algorithm has fully replaced the outgoing one
+    template <typename Deactivate>
+    inline void finishFade(int want, Deactivate& deactivate)
+    {
+        int8_t old = active_;
+        active_ = next_;
+        fadeCount_ = 0;
+        if (old >= 0 && old != want && deactivate(old)) warm_[old] = false;
+    }
+
+    ComputerCard::Ring<uint8_t, 16> warmRequests_; // core0 -> core1
+    ComputerCard::Ring<uint8_t, 16> warmDone_;     // core1 -> core0
+
+    // Core0 only
+    bool warm_[NumAlgos];
+    int8_t active_ = -1;   // -1 = silence (nothing selected yet)
+    int8_t next_ = -1;
+    int8_t pending_ = -1;  // algorithm being warmed on core1
+    int fadeCount_ = 0;    // 0 = not fading, else 1..FADE_SAMPLES
+
+    // Core1 only
+    int8_t warming_ = -1;  // algorithm being warmed by serviceWarmup
+    int warmLeft_ = 0;     // samples of its warm-up still to run
+};
@@ -0,0 +1,203 @@
+// Compile-time registry of noisebox algorithms
+//
+// AlgoSet<A, B, C, ...> owns one of each algorithm, and generates from the list what used to be written
+// out by hand in switch statements: per-sample and per-block dispatch through a table of function
+// pointers (the same cost however many algorithms), borrowing and returning delay memory for the
+// algorithms that need it, memory accounting, and per-algorithm timing. An algorithm's index is its
+// position in the list.
+//
+// An algorithm needs render(out, n, kX, kY), and nextSample(kX, kY) or process(kX, kY) for one sample.
+// One with a static constexpr bufferSamples also needs attachBuffer(int16_t*) and detachBuffer(), and
+// is given a slot of the delay arena while it is in use.
+//
+// Timing: each render() of the selected algorithm is timed, in processor cycles (SysTick, on whichever
+// core renders it), or nanoseconds on the host. Define NOISEBOX_PROFILE 0 to leave it out.
+// Warm-ups use renderUntimed(), so only the rendering core's blocks are counted.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#ifndef NOISEBOX_PROFILE
+#define NOISEBOX_PROFILE 1
+#endif
+
+#if NOISEBOX_PROFILE
+#if defined(__arm__)
+#include "hardware/structs/systick.h"
+#else
+#include <chrono>
+#endif
+#endif
+
+template <typename... Algos>
+class AlgoSet {
+    static_assert(sizeof...(Algos) > 0, "AlgoSet needs at least one algorithm");
+
+    // Algorithms with a static bufferSamples borrow delay memory
+    template <typename A, typename = void>
+    struct BufferSamples : std::integral_constant<size_t, 0> {};
+    template <typename A>
+    struct BufferSamples<A, std::void_t<decltype(A::bufferSamples)>> : std::integral_constant<size_t, A::bufferSamples> {};
+
+    // Per-sample entry point: nextSample if there is one, else process
+    template <typename A, typename = void>
+    struct HasNextSample : std::false_type {};
+    template <typename A>
+    struct HasNextSample<A, std::void_t<decltype(std::declval<A&>().nextSample(uint16_t(), uint16_t()))>> : std::true_type {};
+
+public:
+    static constexpr int size = static_cast<int>(sizeof...(Algos));
+
+    // ---- memory accounting ----
+    static constexpr std::array<size_t, sizeof...(Algos)> stateBytes = {sizeof(Algos)...};
+    static constexpr std::array<size_t, sizeof...(Algos)> bufferSamples = {BufferSamples<Algos>::value...};
+    static constexpr size_t totalStateBytes = (sizeof(Algos) + ...);
+    static constexpr size_t maxBufferSamples = std::max({BufferSamples<Algos>::value...});
+
+    // True if every algorithm that borrows delay memory fits one slot of Arena
+    template <typename Arena>
+    static constexpr bool fitsArena() { return ((BufferSamples<Algos>::value <= Arena::slotSamples) && ...); }
+
+    template <int I>
+    auto& get() { return std::get<I>(algos_); }
+
+    // ---- dispatch ----
+    // One sample of algorithm i
+    inline int16_t next(int i, uint16_t kX, uint16_t kY) { return sampleTable[i](*this, kX, kY); }
+
+    // n samples of algorithm i, with the controls held for the block, timed
+    inline void render(int i, int16_t* out, int n, uint16_t kX, uint16_t kY)
+    {
+#if NOISEBOX_PROFILE
+        const uint32_t start = now();
+        renderTable[i](*this, out, n, kX, kY);
+        Profile& p = profile_[i];
+        const uint32_t t = elapsed(start);
+        p.blocks++;
+        p.samples += static_cast<uint32_t>(n);
+        p.time += t;
+        if (t > p.maxTime) p.maxTime = t;
+#else
+        renderTable[i](*this, out, n, kX, kY);
+#endif
+    }
+
+    // As render, without timing (for warm-ups)
+    inline void renderUntimed(int i, int16_t* out, int n, uint16_t kX, uint16_t kY) { renderTable[i](*this, out, n, kX, kY); }
+
+    // ---- delay memory ----
+    // Borrow a slot of arena for algorithm i if it needs one; false if none is free
+    template <typename Arena>
+    bool acquire(int i, Arena& arena) { return acquireTable<Arena>[i](*this, arena); }
+
+    // Return algorithm i's slot; true if it had one (and so must be re-warmed before use)
+    template <typename Arena>
+    bool release(int i, Arena& arena) { return releaseTable<Arena>[i](*this, arena); }
+
+#if NOISEBOX_PROFILE
+    // ---- timing ----
+    struct Profile
+    {
+        uint32_t blocks = 0, samples = 0;
+        uint32_t time = 0;    // total, cycles (ns on the host); wraps, so read and clear regularly
+        uint32_t maxTime = 0; // longest block
+    };
+    const Profile& profile(int i) const { return profile_[i]; }
+    void clearProfile(int i) { profile_[i] = Profile(); }
+#endif
+
+private:
+    using SampleFn = int16_t (*)(AlgoSet&, uint16_t, uint16_t);
+    using RenderFn = void (*)(AlgoSet&, int16_t*, int, uint16_t, uint16_t);
+    template <typename Arena>
+    using ArenaFn = bool (*)(AlgoSet&, Arena&);
+
+    template <size_t I>
+    static int16_t sampleOne(AlgoSet& s, uint16_t kX, uint16_t kY)
+    {
+        auto& a = std::get<I>(s.algos_);
+        if constexpr (HasNextSample<std::tuple_element_t<I, std::tuple<Algos...>>>::value)
+            return a.nextSample(kX, kY);
+        else
+            return static_cast<int16_t>(a.process(kX, kY));
+    }
+
+    template <size_t I>
+    static void renderOne(AlgoSet& s, int16_t* out, int n, uint16_t kX, uint16_t kY)
+    {
+        std::get<I>(s.algos_).render(out, n, kX, kY);
+    }
+
+    template <size_t I, typename Arena>
+    static bool acquireOne(AlgoSet& s, Arena& arena)
+    {
+        if constexpr (BufferSamples<std::tuple_element_t<I, std::tuple<Algos...>>>::value > 0)
+        {
+            int16_t* mem = arena.acquire();
+            if (!mem) return false;
+            std::get<I>(s.algos_).attachBuffer(mem);
+        }
+        return true;
+    }
+
+    template <size_t I, typename Arena>
+    static bool releaseOne(AlgoSet& s, Arena& arena)
+    {
+        if constexpr (BufferSamples<std::tuple_element_t<I, std::tuple<Algos...>>>::value > 0)
+        {
+            arena.release(std::get<I>(s.algos_).detachBuffer());
+            return true;
+        }
+        return false;
+    }
+
+    template <size_t... I>
+    static constexpr std::array<SampleFn, sizeof...(Algos)> makeSampleTable(std::index_sequence<I...>) { return {{&sampleOne<I>...}}; }
+    template <size_t... I>
+    static constexpr std::array<RenderFn, sizeof...(Algos)> makeRenderTable(std::index_sequence<I...>) { return {{&renderOne<I>...}}; }
+    template <typename Arena, size_t... I>
+    static constexpr std::array<ArenaFn<Arena>, sizeof...(Algos)> makeAcquireTable(std::index_sequence<I...>) { return {{&acquireOne<I, Arena>...}}; }
+    template <typename Arena, size_t... I>
+    static constexpr std::array<ArenaFn<Arena>, sizeof...(Algos)> makeReleaseTable(std::index_sequence<I...>) { return {{&releaseOne<I, Arena>...}}; }
+
+    static constexpr std::array<SampleFn, sizeof...(Algos)> sampleTable = makeSampleTable(std::index_sequence_for<Algos...>());
+    static constexpr std::array<RenderFn, sizeof...(Algos)> renderTable = makeRenderTable(std::index_sequence_for<Algos...>());
+    template <typename Arena>
+    static constexpr std::array<ArenaFn<Arena>, sizeof...(Algos)> acquireTable = makeAcquireTable<Arena>(std::index_sequence_for<Algos...>());
+    template <typename Arena>
+    static constexpr std::array<ArenaFn<Arena>, sizeof...(Algos)> releaseTable = makeReleaseTable<Arena>(std::index_sequence_for<Algos...>());
+
+#if NOISEBOX_PROFILE
+#if defined(__arm__)
+    // SysTick counts down; ComputerCard only starts it for the load meter, and each core has its own
+    static inline uint32_t now()
+    {
+        if (!(systick_hw->csr & 1))
+        {
+            systick_hw->rvr = 0x00FFFFFF;
+            systick_hw->cvr = 0;
+            systick_hw->csr = 0x5; // processor clock, enabled
+        }
+        return systick_hw->cvr;
+    }
+    static inline uint32_t elapsed(uint32_t start) { return (start - systick_hw->cvr) & 0x00FFFFFF; }
+#else
+    static inline uint32_t now()
+    {
+        return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+    static inline uint32_t elapsed(uint32_t start) { return now() - start; }
+#endif
+    Profile profile_[sizeof...(Algos)];
+#endif
+
+    std::tuple<Algos...> algos_;
+};
@@ -0,0 +1,83 @@
+// One noisebox voice: the full set of algorithms, the manager that switches between them, and the
+// delay memory they borrow. Everything here belongs to the core that renders the voice (next/render),
+// except warm-ups, which run on core1 through serviceWarmup().
+
+#pragma once
+
+#include <cstdint>
+#include "ComputerCard.h"
+#include "algos/ResoNoise.hpp"
+#include "algos/RadioOhNo.hpp"
+#include "algos/CrossModRingSquare.hpp"
+#include "algos/CrossModRingSine.hpp"
+#include "algos/ClusterSaw.hpp"
+#include "algos/Atari.hpp"
+#include "algos/Basurilla.hpp"
+#include "algos/ArrayOnTheRocks.hpp"
+#include "algos/PwCluster.hpp"
+#include "algos/ExistencelsPain.hpp"
+#include "algos/BasuraTotal.hpp"
+#include "algos/S_H.hpp"
+#include "algos/SatanWorkout.hpp"
+#include "AlgoManager.hpp"
+#include "AlgoSet.hpp"
+#include "dsp/DelayArena.hpp"
+
+class NoiseVoice
+{
+    // The algorithms, in knob order
+    using Algos = AlgoSet<ResoNoiseAlgo, RadioOhNoAlgo, CrossModRingSquare, CrossModRingSine, ClusterSaw, Basurilla,
+                          PwCluster, ArrayOnTheRocks, Atari, SatanWorkoutAlgo, SampleHoldReverbAlgo, BasuraTotalAlgo,
+                          ExistencelsPain>;
+
+public:
+    static constexpr int num_algos = Algos::size;
+
+    // One sample, crossfading to algorithm 'want' once it is warm
+    inline int16_t next(int want, uint16_t kX, uint16_t kY)
+    {
+        return algos_.next(want,
+                           [&](int i) { return set_.next(i, kX, kY); },
+                           [this](int i) { return set_.acquire(i, arena); },
+                           [this](int i) { return set_.release(i, arena); });
+    }
+
+    // n samples with the controls held for the block
+    inline void render(int want, int16_t* out, int n, uint16_t kX, uint16_t kY)
+    {
+        algos_.nextBlock(want, out, n,
+                         [&](int i, int16_t* o, int m) { set_.render(i, o, m, kX, kY); },
+                         [this](int i) { return set_.acquire(i, arena); },
+                         [this](int i) { return set_.release(i, arena); });
+    }
+
+    // Core1: run one chunk of a pending warm-up; false if there was none.
+    // Each algorithm runs with centred controls so internal states (e.g. reverbs/filters) settle.
+    inline bool serviceWarmup()
+    {
+        return algos_.serviceWarmup([this](int i, int samples) {
+            int16_t scratch[AlgoManager<num_algos>::WARMUP_CHUNK];
+            for (int n = 0; n < samples; n += AlgoManager<num_algos>::WARMUP_CHUNK)
+                set_.renderUntimed(i, scratch, AlgoManager<num_algos>::WARMUP_CHUNK, 2048, 2048);
+        });
+    }
+
+    int active() const { return algos_.active(); }
+
+#if NOISEBOX_PROFILE
+    // Time spent rendering algorithm i on this voice (see AlgoSet.hpp)
+    const Algos::Profile& profile(int i) const { return set_.profile(i); }
+    void clearProfile(int i) { set_.clearProfile(i); }
+#endif
+
+private:
+    AlgoManager<num_algos> algos_;
+
+    // Reverb delay memory, shared by the algorithms that need it. Two slots cover the playing algorithm
+    // plus the one fading in; a third reverb algorithm waits for a slot before it is warmed.
+    using Arena = dsp::DelayArena<Algos::maxBufferSamples, 2>;
+    static_assert(Algos::fitsArena<Arena>(), "algorithm delay memory exceeds arena slot");
+    Arena arena;
+
+    Algos set_;
+};
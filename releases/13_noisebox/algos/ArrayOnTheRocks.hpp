@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include "../dsp/WaveformOsc.hpp"
+#include "../dsp/ControlMaps.hpp"
 
 // Port of P_arrayOnTheRocks: a sine carrier FM'd by an arbitrary waveform oscillator.
 // Controls:
@@ -44,41 +45,56 @@ public:
 
     inline int32_t process(int32_t k1_4095, int32_t k2_4095)
     {
-        if (k1_4095 < 0) k1_4095 = 0; else if (k1_4095 > 4095) k1_4095 = 4095;
-        if (k2_4095 < 0) k2_4095 = 0; else if (k2_4095 > 4095) k2_4095 = 4095;
+        setControls(k1_4095, k2_4095);
+        return tick();
+    }
 
-        float k1 = static_cast<float>(k1_4095) * (1.0f / 4095.0f);
-        float k2 = static_cast<float>(k2_4095) * (1.0f / 4095.0f);
-        float pitch = k1 * k1;
+    // Render n samples with the controls held for the block, decoding them once
+    inline void render(int16_t* out, int n, int32_t k1_4095, int32_t k2_4095)
+    {
+        setControls(k1_4095, k2_4095);
+        for (int j = 0; j < n; ++j) out[j] = static_cast<int16_t>(tick());
+    }
+
+private:
+    inline void setControls(int32_t k1_4095, int32_t k2_4095)
+    {
+        using namespace ControlMaps;
 
-        float f_mod = 10.0f + pitch * 10000.0f;
-        float f_car = 100.0f + pitch * 500.0f;
-        mod_.setFrequencyHz(f_mod);
-        car_.setFrequencyHz(f_car);
+        const uint32_t k2 = knobQ16(k2_4095);
+        const uint32_t pitch = knobSquaredQ16(k1_4095);
 
-        // Compute carrier (sine) sample; its effective contribution scales with k2
-        int16_t car_sample = car_.nextSample();   // -2048..2047
+        mod_.setPhaseIncrement(lerpInc(incFromHz(10.0), incFromHz(10000.0), pitch));  // 10 + pitch * 10000 Hz
+        car_.setPhaseIncrement(lerpInc(incFromHz(100.0), incFromHz(500.0), pitch));   // 100 + pitch * 500 Hz
 
-        // FM the arbitrary oscillator by the carrier: map car_sample to Hz in Q16.16
         // FM depth grows with k2, but base output remains present even at k2=0
         // fm_hz = (car/2048) * ((0.25 + 6*k2) * f_car)
-        float depth_mult = 0.25f + 6.0f * k2;     // 0.25..6.25
-        int32_t fcar_q16_16 = static_cast<int32_t>(f_car * 65536.0f + 0.5f);
-        int32_t depth_q16_16 = static_cast<int32_t>(depth_mult * static_cast<float>(fcar_q16_16));
+        const uint32_t depth_mult_q16 = ratioQ16(0.25) + 6 * k2;  // 0.25..6.25
+        const int32_t fcar_q16_16 = lerpHzQ16(100, 500, pitch);
+        const int64_t depth_q16_16 = (static_cast<int64_t>(fcar_q16_16) * depth_mult_q16) >> 16;
         // Apply k2 as additional linear scaler on FM depth (like amplitude to FM input)
-        int32_t k2_q16_16 = static_cast<int32_t>(k2 * 65536.0f + 0.5f);
-        int64_t depth_scaled = (static_cast<int64_t>(depth_q16_16) * k2_q16_16) >> 16;
-        int32_t fm_q16_16 = static_cast<int32_t>((static_cast<int64_t>(car_sample) * depth_scaled) >> 11);
+        depthScaled_q16_16_ = (depth_q16_16 * k2) >> 16;
+
+        // Ring-mod mix rises with k2
+        mix_q15_ = static_cast<int32_t>((k2 * 32767u) >> 16); // 0..32767
+    }
+
+    inline int32_t tick()
+    {
+        // Compute carrier (sine) sample; its effective contribution scales with k2
+        int16_t car_sample = car_.nextSample();   // -2048..2047
+
+        // FM the arbitrary oscillator by the carrier: map car_sample to Hz in Q16.16
+        int32_t fm_q16_16 = static_cast<int32_t>((static_cast<int64_t>(car_sample) * depthScaled_q16_16_) >> 11);
 
         // Generate arbitrary modulator output with FM applied
         int16_t mod_sample = mod_.nextSample(fm_q16_16);
 
-        // Add ring modulation between mod and carrier; mix rises with k2
+        // Add ring modulation between mod and carrier
         int32_t ring = (static_cast<int32_t>(mod_sample) * static_cast<int32_t>(car_sample)) >> 11; // ~12-bit
         if (ring < -4096) ring = -4096; if (ring > 4095) ring = 4095;
-        int32_t mix_q15 = static_cast<int32_t>(k2 * 32767.0f + 0.5f); // 0..32767
-        int32_t inv_q15 = 32767 - mix_q15;
-        int32_t mixed = (static_cast<int32_t>(mod_sample) * inv_q15 + ring * mix_q15) >> 15;
+        int32_t inv_q15 = 32767 - mix_q15_;
+        int32_t mixed = (static_cast<int32_t>(mod_sample) * inv_q15 + ring * mix_q15_) >> 15;
 
         // No overall amplitude gating by k2 to ensure constant audibility
         if (mixed < -2048) mixed = -2048;
@@ -86,10 +102,13 @@ public:
         return mixed;
     }
 
-private:
     WaveformOscillator mod_;
     WaveformOscillator car_;
 
+    // Decoded from k2 by setControls
+    int64_t depthScaled_q16_16_ = 0;
+    int32_t mix_q15_ = 0;
+
     // Copied from P_arrayOnTheRocks.hpp, with 'test' placeholders replaced by 0.
     static constexpr int16_t kDefaultWaveform256[256] = {
         0, 1895, 3748, 5545, 7278, 8934, 10506, 11984, 13362, 14634,
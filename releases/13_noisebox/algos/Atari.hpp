@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include "../dsp/WaveformOsc.hpp"
+#include "../dsp/ControlMaps.hpp"
 
 // Port of Noise Plethora's Atari plugin using the local WaveformOscillator.
 // Reference: P_Atari.hpp
@@ -36,34 +37,44 @@ public:
     // Returns 12-bit signed sample in -2048..2047 (int32 for consistency with other algos)
     inline int32_t process(int32_t k1_4095, int32_t k2_4095)
     {
-        // Clamp incoming controls to 0..4095 to avoid CV sum overflow/underflow
-        if (k1_4095 < 0) k1_4095 = 0; else if (k1_4095 > 4095) k1_4095 = 4095;
-        if (k2_4095 < 0) k2_4095 = 0; else if (k2_4095 > 4095) k2_4095 = 4095;
+        setControls(k1_4095, k2_4095);
+        return tick();
+    }
 
-        // Knob normalization
-        float k1 = static_cast<float>(k1_4095) * (1.0f / 4095.0f);
-        float k2 = static_cast<float>(k2_4095) * (1.0f / 4095.0f);
+    // Render n samples with the controls held for the block, decoding them once
+    inline void render(int16_t* out, int n, int32_t k1_4095, int32_t k2_4095)
+    {
+        setControls(k1_4095, k2_4095);
+        for (int j = 0; j < n; ++j) out[j] = static_cast<int16_t>(tick());
+    }
 
-        // Frequency mapping (match original)
-        float pitch1 = k1 * k1;                         // pow(knob_1, 2)
-        float f1 = 10.0f + pitch1 * 50.0f;              // waveformMod1.frequency(10+(pitch1*50))
-        float f2 = 10.0f + k2 * 200.0f;                 // waveformMod2.frequency(10+(knob_2*200))
+private:
+    inline void setControls(int32_t k1_4095, int32_t k2_4095)
+    {
+        using namespace ControlMaps;
 
-        mod1_.setFrequencyHz(f1);
-        mod2_.setFrequencyHz(f2);
+        // Knob normalization (clamps to 0..4095 to avoid CV sum overflow/underflow)
+        const uint32_t k2 = knobQ16(k2_4095);
+
+        // Frequency mapping (match original)
+        const uint32_t pitch1 = knobSquaredQ16(k1_4095);                         // pow(knob_1, 2)
+        mod1_.setPhaseIncrement(lerpInc(incFromHz(10.0), incFromHz(50.0), pitch1)); // waveformMod1.frequency(10+(pitch1*50))
+        mod2_.setPhaseIncrement(lerpInc(incFromHz(10.0), incFromHz(200.0), k2));    // waveformMod2.frequency(10+(knob_2*200))
 
         // FM depth for mod1 depends on k2: (knob_2*8 + 3)
-        // Map that depth to Hz in Q16.16 with stronger scaling for audibility
-        float depth_index = (k2 * 8.0f) + 3.0f;         // ~3..11
-        int32_t fm1_scale = static_cast<int32_t>(depth_index * 512.0f); // stronger coupling
+        // Map that depth to Hz in Q16.16 with stronger scaling for audibility: depth * 512
+        fm1_scale_ = 3 * 512 + static_cast<int32_t>(k2 >> 4); // stronger coupling
+    }
 
+    inline int32_t tick()
+    {
         // Emulate waveformMod1.offset(1) by adding a DC bias when feeding mod2
         // Square amplitude here is ~±1024; add 1024 -> 0..2048 (unipolar)
         int32_t mod1_unipolar = static_cast<int32_t>(prev_mod1_out_) + 1024;
         if (mod1_unipolar < 0) mod1_unipolar = 0; else if (mod1_unipolar > 2048) mod1_unipolar = 2048;
 
         // Cross-modulation: mod2 -> mod1 (variable depth), mod1 -> mod2 (with DC bias, strong depth)
-        int32_t fm1_q16_16 = static_cast<int32_t>(prev_mod2_out_) * fm1_scale;
+        int32_t fm1_q16_16 = static_cast<int32_t>(prev_mod2_out_) * fm1_scale_;
         int32_t fm2_q16_16 = mod1_unipolar * 2048; // strong positive FM like offset(1)
 
         // Generate new samples
@@ -81,12 +92,12 @@ public:
         return out;
     }
 
-private:
     WaveformOscillator mod1_; // waveformMod1
     WaveformOscillator mod2_; // waveformMod2 (pulse in original)
 
     int16_t prev_mod1_out_;
     int16_t prev_mod2_out_;
+    int32_t fm1_scale_ = 3 * 512; // mod2 -> mod1 FM depth, set from k2
 };
 
 
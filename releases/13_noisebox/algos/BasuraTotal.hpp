@@ -5,6 +5,7 @@
 #include "dsp/WaveformOsc.hpp"
 #include "dsp/WhiteNoise.hpp"
 #include "algos/MicroVerbInt.hpp"
+#include "dsp/ControlMaps.hpp"
 
 // Port of Noise Plethora P_BasuraTotal without reverb.
 // Behavior:
@@ -34,37 +35,55 @@ public:
     // Generate one 12-bit sample. k1/k2: 0..4095
     inline int32_t process(int32_t k1_0_to_4095, int32_t k2_0_to_4095)
     {
-        if (k1_0_to_4095 < 0) k1_0_to_4095 = 0; else if (k1_0_to_4095 > 4095) k1_0_to_4095 = 4095;
-        if (k2_0_to_4095 < 0) k2_0_to_4095 = 0; else if (k2_0_to_4095 > 4095) k2_0_to_4095 = 4095;
+        // Controls are only read when the countdown is about to expire
+        if (counter_ <= 1) setControls(k1_0_to_4095, k2_0_to_4095);
+        return tick();
+    }
 
-        const float k1 = static_cast<float>(k1_0_to_4095) * (1.0f / 4095.0f);
-        const float k2 = static_cast<float>(k2_0_to_4095) * (1.0f / 4095.0f);
+    // Render n samples with the controls held for the block, decoding them once
+    inline void render(int16_t* out, int n, int32_t k1_0_to_4095, int32_t k2_0_to_4095)
+    {
+        setControls(k1_0_to_4095, k2_0_to_4095);
+        for (int j = 0; j < n; ++j) out[j] = static_cast<int16_t>(tick());
+    }
 
-        const float pitch1 = k1 * k1;
-        const float pitch2 = k2 * k2;
+    // Reverb delay memory, borrowed from the shared arena while this algorithm is active
+    static constexpr size_t bufferSamples = dsp::MicroVerbMonoInt::bufferSamples;
+    void attachBuffer(int16_t* mem) { verb_.attachBuffer(mem); }
+    int16_t* detachBuffer() { return verb_.detachBuffer(); }
+
+private:
+    inline void setControls(int32_t k1_0_to_4095, int32_t k2_0_to_4095)
+    {
+        using namespace ControlMaps;
 
-        // Base frequency mapping from original
-        const float baseHz = 200.0f + pitch1 * 5000.0f;
+        const uint32_t pitch1 = knobSquaredQ16(k1_0_to_4095);
+        const uint32_t pitch2 = knobSquaredQ16(k2_0_to_4095);
 
         // Control-rate timing: original used 100000 * pitch2 microseconds.
         // Convert to samples at 48 kHz: 100000 us = 0.1 s => 4800 samples.
         // intervalSamples in [0..4800]. Ensure at least 1 to avoid stall.
-        int32_t intervalSamples = static_cast<int32_t>(4800.0f * pitch2 + 0.5f);
-        if (intervalSamples < 1) intervalSamples = 1;
+        intervalSamples_ = static_cast<int32_t>((pitch2 * 4800u + 32768u) >> 16);
+        if (intervalSamples_ < 1) intervalSamples_ = 1;
+
+        // Base frequency mapping from original: 200 + pitch1 * 5000 Hz
+        onInc_ = lerpInc(incFromHz(200.0), incFromHz(5000.0), pitch1);
+    }
 
+    inline int32_t tick()
+    {
         // Trigger update when countdown expires
         if (--counter_ <= 0)
         {
-            counter_ = intervalSamples;
+            counter_ = intervalSamples_;
 
             // Use existing white noise generator to decide gate (approx 50/50)
             // Sign bit as boolean: >= 0 -> 1, < 0 -> 0
             const bool on = (noise_.nextSample(4095) >= 0);
-            const float f = on ? baseHz : 0.0f;
 
             // Emulate Teensy begin() at each click: set shape and reset phase
             osc_.setShape(WaveformOscillator::Shape::Square);
-            osc_.setFrequencyHz(f);
+            osc_.setPhaseIncrement(on ? onInc_ : 0);
             osc_.resetPhase(0);
         }
         // Dry synth sample
@@ -75,9 +94,10 @@ public:
         return mono;
     }
 
-private:
     WaveformOscillator osc_;
     int32_t counter_ = 1;
+    int32_t intervalSamples_ = 1;  // set from k2
+    uint32_t onInc_ = 0;           // gate-on phase increment, set from k1
     WhiteNoise noise_;
     dsp::MicroVerbMonoInt verb_;
 };
@@ -1,8 +1,9 @@
 #pragma once
 
 #include <cstdint>
-#include "../dsp/WaveformOsc.hpp"
+#include "../dsp/WaveformOscBank.hpp"
 #include "../dsp/WhiteNoise.hpp"
+#include "../dsp/ControlMaps.hpp"
 
 // Port of Noise Plethora "basurilla" plugin.
 // Topology:
@@ -16,59 +17,61 @@ class Basurilla {
 public:
     Basurilla()
     {
-        // Initialize common samplerate and shapes
-        for (int i = 0; i < 3; ++i)
-        {
-            waves_[i].setSampleRate(48000.0f);
-            waves_[i].setShape(WaveformOscillator::Shape::Square); // Pulse equivalent
-            waves_[i].setAmplitudeQ12(4095);
-            waves_[i].setPulseWidthQ15(16384); // 50%
-        }
+        waves_.setAmplitudeQ12(4095);
+        waves_.setPulseWidthQ15(16384); // 50%
 
         // Initial frequencies roughly inspired by original (will be set each call)
-        waves_[0].setFrequencyHz(110.0f);
-        waves_[1].setFrequencyHz(10.0f);
-        waves_[2].setFrequencyHz(10.0f);
+        waves_.setFrequencyHz(0, 110.0f);
+        waves_.setFrequencyHz(1, 10.0f);
+        waves_.setFrequencyHz(2, 10.0f);
     }
 
     // Generate one sample. k1/k2 are 0..4095
     inline int32_t process(int32_t k1_4095, int32_t k2_4095)
     {
-        // Clamp controls
-        if (k1_4095 < 0) k1_4095 = 0; else if (k1_4095 > 4095) k1_4095 = 4095;
-        if (k2_4095 < 0) k2_4095 = 0; else if (k2_4095 > 4095) k2_4095 = 4095;
+        setControls(k1_4095, k2_4095);
+        return tick();
+    }
 
-        // Normalize to 0..1
-        float k1 = static_cast<float>(k1_4095) * (1.0f / 4095.0f);
-        float k2 = static_cast<float>(k2_4095) * (1.0f / 4095.0f);
+    // Render n samples with the controls held for the block, decoding them once
+    inline void render(int16_t* out, int n, int32_t k1_4095, int32_t k2_4095)
+    {
+        setControls(k1_4095, k2_4095);
+        for (int j = 0; j < n; ++j) out[j] = static_cast<int16_t>(tick());
+    }
 
-        // Pitch mapping
-        float pitch = k1 * k1; // pow(knob_1, 2)
+private:
+    inline void setControls(int32_t k1_4095, int32_t k2_4095)
+    {
+        using namespace ControlMaps;
 
-        // Frequency mappings (faithful to original intent)
-        float f1 = pitch * 100.0f + 10.0f;   // waveform1.frequency(pitch*100+10)
-        float f2 = pitch * 0.1f;             // waveform2.frequency(pitch*0.1)
-        float f3 = pitch * 0.7f - 500.0f;    // waveform3.frequency(pitch*0.7-500)
-        if (f2 < 0.0f) f2 = 0.0f;            // guard low frequencies
-        if (f3 < 0.0f) f3 = 0.0f;
+        // Pitch mapping: pow(knob_1, 2)
+        const uint32_t pitch = knobSquaredQ16(k1_4095);
+        const uint32_t k2 = knobQ16(k2_4095);
 
-        waves_[0].setFrequencyHz(f1);
-        waves_[1].setFrequencyHz(f2);
-        waves_[2].setFrequencyHz(f3);
+        // Frequency mappings (faithful to original intent)
+        // waveform1.frequency(pitch*100+10)
+        // waveform2.frequency(pitch*0.1)
+        // waveform3.frequency(pitch*0.7-500), always below 0 Hz, so guarded to 0
+        waves_.setPhaseIncrement(0, lerpInc(incFromHz(10.0), incFromHz(100.0), pitch));
+        waves_.setPhaseIncrement(1, lerpInc(0, incFromHz(0.1), pitch));
+        waves_.setPhaseIncrement(2, 0);
 
         // Pulse width mappings
         // waveform1.pulseWidth(knob_2*0.95)
         // waveform2.pulseWidth(knob_2*0.5+0.2)
         // waveform3.pulseWidth(knob_2*0.5)
-        auto toQ15 = [](float duty01) -> uint16_t {
-            if (duty01 < 0.0f) duty01 = 0.0f;
-            if (duty01 > 0.999969f) duty01 = 0.999969f; // avoid full 100%
-            return static_cast<uint16_t>(duty01 * 32768.0f + 0.5f);
+        auto toQ15 = [](uint32_t duty_q16) -> uint16_t {
+            uint32_t q = (duty_q16 + 1) >> 1;
+            return static_cast<uint16_t>(q > 32767 ? 32767 : q); // avoid full 100%
         };
-        waves_[0].setPulseWidthQ15(toQ15(k2 * 0.95f));
-        waves_[1].setPulseWidthQ15(toQ15(k2 * 0.5f + 0.2f));
-        waves_[2].setPulseWidthQ15(toQ15(k2 * 0.5f));
+        waves_.setPulseWidthQ15(0, toQ15(mulQ16(k2, ratioQ16(0.95))));
+        waves_.setPulseWidthQ15(1, toQ15((k2 >> 1) + ratioQ16(0.2)));
+        waves_.setPulseWidthQ15(2, toQ15(k2 >> 1));
+    }
 
+    inline int32_t tick()
+    {
         // Original sets noise amplitude to (2 - k2), which saturates to full-scale.
         // Use full amplitude for parity.
         int16_t n = noise_.nextSample(4095);
@@ -76,10 +79,12 @@ public:
         // Build three amplitude-modulated branches: noise × unipolar(wave)
         // Convert each wave from ±1024-ish to 0..2048 gate via bias
         // Then multiply and scale back to 12-bit
+        int16_t w3[3];
+        waves_.nextVoices(w3);
         int32_t sum = 0;
         for (int i = 0; i < 3; ++i)
         {
-            int16_t w = waves_[i].nextSample(); // ~±1024 for square
+            int16_t w = w3[i]; // ~±1024 for square
             int32_t gate = static_cast<int32_t>(w) + 1024; // 0..2048
             if (gate < 0) gate = 0; else if (gate > 2048) gate = 2048;
             // product: n(-2048..2047) * gate(0..2048) -> scale by >>11 to return ~12-bit
@@ -97,8 +102,7 @@ public:
         return mixed;
     }
 
-private:
-    WaveformOscillator waves_[3];
+    WaveformOscBank<3, WaveformOscillator::Shape::Square> waves_; // Pulse equivalent
     WhiteNoise noise_;
 };
 
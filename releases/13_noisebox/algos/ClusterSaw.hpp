@@ -1,24 +1,19 @@
 #pragma once
 
 #include <cstdint>
-#include "../dsp/WaveformOsc.hpp"
+#include "../dsp/WaveformOscBank.hpp"
+#include "../dsp/ControlMaps.hpp"
 
 class ClusterSaw {
 public:
     static constexpr int MAX_OSCILLATORS = 6;  // Adjust this to change number of oscillators
     
     ClusterSaw() {
-        // Initialize all sawtooth oscillators
-        for(int i = 0; i < MAX_OSCILLATORS; i++) {
-            oscs_[i].setSampleRate(48000.0f);
-            oscs_[i].setShape(WaveformOscillator::Shape::Saw);
-            
-            // masterVolume = 0.25, scaled to Q12: 0.25 * 4095 ≈ 1024
-            oscs_[i].setAmplitudeQ12(1024);
-            
-            // Initialize to base frequency (will be updated in process)
-            oscs_[i].setFrequencyHz(100.0f);
-        }
+        // masterVolume = 0.25, scaled to Q12: 0.25 * 4095 ≈ 1024
+        oscs_.setAmplitudeQ12(1024);
+        
+        // Initialize to base frequency (will be updated in process)
+        oscs_.setFrequencyHz(100.0f);
         
         // Initialize control state
         ctrlCounter = 0;
@@ -30,39 +25,11 @@ public:
         // Control-rate updates (every 128 samples) to reduce expensive calculations
         if ((ctrlCounter++ & 0x7F) == 0 || 
             (k1_4095 != lastK1) || (k2_4095 != lastK2)) {
-            
-            lastK1 = k1_4095;
-            lastK2 = k2_4095;
-            
-            // Convert knobs to 0.0-1.0 range
-            float k1_01 = static_cast<float>(k1_4095) * (1.0f / 4095.0f);
-            float k2_01 = static_cast<float>(k2_4095) * (1.0f / 4095.0f);
-            
-            // K1: Base frequency with quadratic response (original: pitch1 = pow(knob_1, 2))
-            float pitch1 = k1_01 * k1_01;
-            float f1 = 20.0f + (pitch1 * 1000.0f);       // Range: 20 Hz to 1020 Hz
-            
-            // K2: Multiplication factor with quadratic response (original: pitch2 = pow(knob_2, 2))
-            float pitch2 = k2_01 * k2_01;
-            float multFactor = 1.01f + (pitch2 * 0.9f);  // Range: 1.01 to 1.91 (original behavior)
-            
-            // Calculate and set frequencies for ALL oscillators (original behavior)
-            float freq = f1;
-            for(int i = 0; i < MAX_OSCILLATORS; i++) {
-                // Clamp frequency to reasonable range
-                if(freq > 8000.0f) freq = 8000.0f;
-                if(freq < 10.0f) freq = 10.0f;
-                
-                oscs_[i].setFrequencyHz(freq);
-                freq *= multFactor;  // Exponential spacing controlled by Y knob
-            }
+            updateControls(k1_4095, k2_4095);
         }
         
-        // Generate all oscillator outputs and mix - optimized loop
-        int32_t total_mix = 0;
-        for(int i = 0; i < MAX_OSCILLATORS; i++) {
-            total_mix += static_cast<int32_t>(oscs_[i].nextSample());
-        }
+        // Generate all oscillator outputs and mix in one pass over the bank
+        int32_t total_mix = oscs_.nextMix();
         
         // Clamp to 12-bit output range
         if(total_mix > 2047) total_mix = 2047;  
@@ -71,14 +38,53 @@ public:
         return total_mix;
     }
 
+    // Render n samples with the controls held for the block
+    void render(int16_t* out, int n, int32_t k1_4095, int32_t k2_4095) {
+        if (k1_4095 != lastK1 || k2_4095 != lastK2) updateControls(k1_4095, k2_4095);
+        ctrlCounter += static_cast<uint32_t>(n);
+        for (int j = 0; j < n; ++j) {
+            int32_t total_mix = oscs_.nextMix();
+            if(total_mix > 2047) total_mix = 2047;
+            if(total_mix < -2048) total_mix = -2048;
+            out[j] = static_cast<int16_t>(total_mix);
+        }
+    }
+
 private:
+    void updateControls(int32_t k1_4095, int32_t k2_4095) {
+        lastK1 = k1_4095;
+        lastK2 = k2_4095;
+        
+        using namespace ControlMaps;
+
+        // K1: Base frequency with quadratic response (original: pitch1 = pow(knob_1, 2))
+        // f1 = 20 Hz + pitch1 * 1000 Hz
+        uint32_t pitch1 = knobSquaredQ16(k1_4095);
+        uint32_t inc = lerpInc(incFromHz(20.0), incFromHz(1000.0), pitch1);
+        
+        // K2: Multiplication factor with quadratic response (original: pitch2 = pow(knob_2, 2))
+        // multFactor = 1.01 + pitch2 * 0.9, range 1.01 to 1.91 (original behavior)
+        uint32_t pitch2 = knobSquaredQ16(k2_4095);
+        uint32_t multFactor = ratioQ16(1.01) + mulQ16(pitch2, ratioQ16(0.9));
+        
+        // Calculate and set frequencies for ALL oscillators (original behavior)
+        for(int i = 0; i < MAX_OSCILLATORS; i++) {
+            // Clamp frequency to reasonable range
+            inc = clampInc(inc, incFromHz(10.0), incFromHz(8000.0));
+            
+            oscs_.setPhaseIncrement(i, inc);
+            inc = scaleInc(inc, multFactor);  // Exponential spacing controlled by Y knob
+        }
+    }
+
     // Signal Flow: 
     // MAX_OSCILLATORS sawtooth oscillators → direct mix → output
     //
     // oscs[0] through oscs[MAX_OSCILLATORS-1] → total_mix → final_mix → output
     // Number of active oscillators controlled by Y knob
     
-    WaveformOscillator oscs_[MAX_OSCILLATORS];  // Configurable number of sawtooth oscillators
+    // Voices reach 8 kHz, so use the band-limited saw
+    WaveformOscBank<MAX_OSCILLATORS, WaveformOscillator::Shape::SawBlep> oscs_;  // Configurable number of sawtooth oscillators
     
     // Control-rate optimization state
     uint32_t ctrlCounter;
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include "../dsp/WaveformOsc.hpp"
+#include "../dsp/ControlMaps.hpp"
 
 class CrossModRingSine {
 public:
@@ -30,26 +31,34 @@ public:
     }
     
     int32_t process(int32_t k1_4095, int32_t k2_4095) {
+        setControls(k1_4095, k2_4095);
+        return tick();
+    }
+
+    // Render n samples with the controls held for the block, decoding them once
+    void render(int16_t* out, int n, int32_t k1_4095, int32_t k2_4095) {
+        setControls(k1_4095, k2_4095);
+        for (int j = 0; j < n; ++j) out[j] = static_cast<int16_t>(tick());
+    }
+
+private:
+    void setControls(int32_t k1_4095, int32_t k2_4095) {
         // Map knobs to frequencies using original's approach:
         // sine_fm1.frequency(100+(pitch1*8000));  where pitch1 = pow(knob_1, 2)
         // sine_fm2.frequency(60+(pitch2*3000));   where pitch2 = pow(knob_2, 2)
         
-        // Convert knobs to 0.0-1.0 range
-        float k1_01 = static_cast<float>(k1_4095) / 4095.0f;
-        float k2_01 = static_cast<float>(k2_4095) / 4095.0f;
-        
+        using namespace ControlMaps;
+
         // Apply quadratic response: pitch = knob^2
-        float pitch1 = k1_01 * k1_01;
-        float pitch2 = k2_01 * k2_01;
-        
-        // Calculate frequencies
-        float freq1 = 100.0f + (pitch1 * 8000.0f);
-        float freq2 = 60.0f + (pitch2 * 3000.0f);
+        uint32_t pitch1 = knobSquaredQ16(k1_4095);
+        uint32_t pitch2 = knobSquaredQ16(k2_4095);
         
         // Update base frequencies
-        osc1_.setFrequencyHz(freq1);
-        osc2_.setFrequencyHz(freq2);
-        
+        osc1_.setPhaseIncrement(lerpInc(incFromHz(100.0), incFromHz(8000.0), pitch1));
+        osc2_.setPhaseIncrement(lerpInc(incFromHz(60.0), incFromHz(3000.0), pitch2));
+    }
+
+    int32_t tick() {
         // Cross-modulation: each oscillator's output modulates the other's frequency
         // Convert previous outputs to FM format (Q16.16 Hz)
         // Scale the previous outputs for FM (similar to CrossModRingSquare)
@@ -75,7 +84,6 @@ public:
         return ring_mod;
     }
 
-private:
     // Signal Flow (matching Teensy patch cords):
     // sine_fm1 ←→ sine_fm2 (cross-modulation via FM inputs)
     //    ↓         ↓
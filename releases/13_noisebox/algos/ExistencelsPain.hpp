@@ -17,7 +17,7 @@
 #include <cmath>
 #include "dsp/WaveformOsc.hpp"
 #include "dsp/StateVariableFilterInt.hpp"
-#include "dsp/SVF_LUT_512.h" // direct LUT access for fast knob->f mapping
+#include "dsp/ControlMaps.hpp"
 
 // ====== Algorithm class ======
 class ExistencelsPain {
@@ -58,70 +58,96 @@ public:
         }
 
         // Precompute base knob position once (avoid per-sample log)
-        baseKnobNorm_ = hzToKnobNorm_(baseCutoffHz_);
+        baseKnobNorm_q16_ = static_cast<int32_t>(hzToKnobNorm_(baseCutoffHz_) * 65536.0f + 0.5f);
 
         // Init control-rate caches
         for (int i = 0; i < kNumMods; ++i) {
-            f_q15_cur_[i] = knobNormToFq15_(baseKnobNorm_);
+            svf_[i].setCutoffNormQ16(baseKnobNorm_q16_);
             lfoHold_[i] = 0;
         }
     }
 
     // ----- Audio tick -----
     // Generate one 12-bit sample. k1/k2 are expected in 0..4095 (clamped internally).
-    // This scaffold outlines steps; detailed math filled in in implementation step.
     inline int32_t process(int32_t k1_0_to_4095, int32_t k2_0_to_4095)
     {
-        // 1) Clamp and normalize controls (0..1)
-        if (k1_0_to_4095 < 0) k1_0_to_4095 = 0; else if (k1_0_to_4095 > 4095) k1_0_to_4095 = 4095;
-        if (k2_0_to_4095 < 0) k2_0_to_4095 = 0; else if (k2_0_to_4095 > 4095) k2_0_to_4095 = 4095;
-        const float k1 = static_cast<float>(k1_0_to_4095) * (1.0f / 4095.0f);
-        const float k2 = static_cast<float>(k2_0_to_4095) * (1.0f / 4095.0f);
-
-        // 2) Map k1 -> S&H clock frequency (per original: 50 + pitch^2 * 5000)
-        //    pitch = k1^2 for musical feel
-        const float pitch = k1 * k1;
-        const float srcHz = 50.0f + pitch * 5000.0f;
-        source_.setFrequencyHz(srcHz);
-
-        // 3) Map k2 -> octave span for cutoff modulation (oct = 0.3 + 3*k2)
-        const float octaveSpan = 0.3f + 3.0f * k2;
-
-        // 4) Per-filter cutoff modulation from its LFO:
-        //    We avoid per-sample log mapping by working in the LUT's normalized knob domain.
-        //    The LUT spans 20..8000 Hz, i.e. totalOctaves = log2(8000/20).
-        //    A delta of D octaves corresponds to D/totalOctaves in knob-normalized units.
-
-        // Scale to convert octaves -> knob units (control-rate)
+        setSourceRate_(k1_0_to_4095);
+
         // Update control-rate parameters every ctrlDiv_ samples
         if ((ctrlCounter_++ & (ctrlDiv_ - 1)) == 0)
         {
-            const float knobOctaveScale = octaveSpan * invTotalOctaves_;
-            for (int i = 0; i < kNumMods; ++i)
-            {
-                // Triangle LFO at control-rate; hold value between updates
-                const int16_t l = lfo_[i].nextSample();
-                lfoHold_[i] = l;
-                const float lfoNorm = static_cast<float>(l) * (1.0f / 2048.0f);
-                float knobNorm = baseKnobNorm_ + (lfoNorm * knobOctaveScale);
-                if (knobNorm < 0.0f) knobNorm = 0.0f;
-                if (knobNorm > 1.0f) knobNorm = 1.0f;
-                f_q15_cur_[i] = knobNormToFq15_(knobNorm);
-            }
-            // Also update S&H frequency at control-rate
-            const float pitch = k1 * k1;
-            const float srcHz = 50.0f + pitch * 5000.0f;
-            source_.setFrequencyHz(srcHz);
+            updateCutoffs_(knobOctaveScaleQ16_(k2_0_to_4095));
+        }
+        return tick_();
+    }
+
+    // ----- Block render -----
+    // n samples with k1/k2 held for the block: controls are decoded once, the filter cutoffs still
+    // follow their LFOs every ctrlDiv_ samples.
+    inline void render(int16_t* out, int n, int32_t k1_0_to_4095, int32_t k2_0_to_4095)
+    {
+        setSourceRate_(k1_0_to_4095);
+        const int32_t knobOctaveScale_q16 = knobOctaveScaleQ16_(k2_0_to_4095);
+
+        int j = 0;
+        while (j < n)
+        {
+            const uint32_t phase = ctrlCounter_ & (ctrlDiv_ - 1);
+            if (phase == 0) updateCutoffs_(knobOctaveScale_q16);
+            int run = static_cast<int>(ctrlDiv_ - phase);
+            if (run > n - j) run = n - j;
+            ctrlCounter_ += static_cast<uint32_t>(run);
+            for (const int end = j + run; j < end; ++j) out[j] = static_cast<int16_t>(tick_());
+        }
+    }
+
+private:
+    // ----- Control decoding -----
+    // Map k1 -> S&H clock frequency (per original: 50 + pitch^2 * 5000)
+    // pitch = k1^2 for musical feel
+    inline void setSourceRate_(int32_t k1_0_to_4095)
+    {
+        using namespace ControlMaps;
+        const uint32_t pitch = knobSquaredQ16(k1_0_to_4095);
+        source_.setPhaseIncrement(lerpInc(incFromHz(50.0), incFromHz(5000.0), pitch));
+    }
+
+    // Map k2 -> octave span for cutoff modulation (oct = 0.3 + 3*k2), then octaves -> knob units (Q16)
+    // We avoid per-sample log mapping by working in the LUT's normalized knob domain.
+    // The LUT spans 20..8000 Hz, i.e. totalOctaves = log2(8000/20).
+    // A delta of D octaves corresponds to D/totalOctaves in knob-normalized units.
+    static inline int32_t knobOctaveScaleQ16_(int32_t k2_0_to_4095)
+    {
+        using namespace ControlMaps;
+        const uint32_t octaveSpan_q16 = ratioQ16(0.3) + 3 * knobQ16(k2_0_to_4095);
+        return static_cast<int32_t>((octaveSpan_q16 * invTotalOctaves_q16_) >> 16);
+    }
+
+    // Per-filter cutoff modulation from its LFO, at control rate; each filter glides to its new cutoff
+    // over the next ctrlDiv_ samples rather than stepping, so the sweep has no control-rate zipper
+    inline void updateCutoffs_(int32_t knobOctaveScale_q16)
+    {
+        for (int i = 0; i < kNumMods; ++i)
+        {
+            // Triangle LFO at control-rate; hold value between updates
+            const int16_t l = lfo_[i].nextSample();
+            lfoHold_[i] = l;
+            // knobNorm = base + (l / 2048) * scale
+            const int32_t knobNorm_q16 = baseKnobNorm_q16_ + ((static_cast<int32_t>(l) * knobOctaveScale_q16) >> 11);
+            svf_[i].rampCutoffTo(StateVariableFilterIntLUT::fFromNormQ16(knobNorm_q16), static_cast<int>(ctrlDiv_));
         }
+    }
 
+    inline int32_t tick_()
+    {
         // Generate shared input once
         const int16_t src = source_.nextSample();
 
         int32_t mix = 0;
         for (int i = 0; i < kNumMods; ++i)
         {
-            // Process bandpass using held cutoff f value in Q15
-            int16_t y = svf_[i].processWithFMod(src, f_q15_cur_[i]);
+            // Bandpass at the filter's (ramping) cutoff
+            int16_t y = svf_[i].process(src);
             mix += y;
         }
 
@@ -134,11 +160,10 @@ public:
         return mix;
     }
 
-private:
     // ----- Configuration -----
     // Base cutoff (center frequency) before octave modulation
     float baseCutoffHz_ = 1000.0f; // loosely matches Teensy default when not explicitly set
-    float baseKnobNorm_ = 0.0f;    // normalized 0..1 mapping of base cutoff into LUT domain
+    int32_t baseKnobNorm_q16_ = 0; // normalized 0..1 (Q16) mapping of base cutoff into LUT domain
     // Control-rate update cadence (must be power of two for mask)
     static constexpr uint32_t ctrlDiv_ = 8; // update every 8 samples (~6 kHz)
     uint32_t ctrlCounter_ = 0;
@@ -148,7 +173,6 @@ private:
     WaveformOscillator        lfo_[kNumMods];   // Triangle modulators for cutoff
     StateVariableFilterIntLUT svf_[kNumMods];   // Bandpass filters
     // Control-rate caches
-    uint16_t f_q15_cur_[kNumMods];
     int16_t  lfoHold_[kNumMods];
 
     // ----- Helpers -----
@@ -161,7 +185,7 @@ private:
 
     // Precomputed constants
     static constexpr float totalOctaves_ = 8.643856189774724f; // log2(8000/20) = log2(400)
-    static constexpr float invTotalOctaves_ = 1.0f / totalOctaves_;
+    static constexpr uint32_t invTotalOctaves_q16_ = ControlMaps::ratioQ16(1.0 / 8.643856189774724);
 
     // Map Hz -> knob normalized 0..1 for the LUT domain
     static inline float hzToKnobNorm_(float hz)
@@ -175,22 +199,5 @@ private:
         if (t > 1.0f) t = 1.0f;
         return t;
     }
-
-    // Map knobNorm in [0,1] directly to f_q15 via the LUT with linear interpolation
-    static inline uint16_t knobNormToFq15_(float knobNorm)
-    {
-        if (knobNorm < 0.0f) knobNorm = 0.0f;
-        if (knobNorm > 1.0f) knobNorm = 1.0f;
-        const float pos = knobNorm * float(F_LUT_SIZE - 1);
-        int idx = int(pos);
-        float fracf = pos - float(idx);
-        if (idx < 0) { idx = 0; fracf = 0.0f; }
-        if (idx >= F_LUT_SIZE - 1) { idx = F_LUT_SIZE - 2; fracf = 1.0f; }
-        const uint16_t a = F_LUT_512[idx];
-        const uint16_t b = F_LUT_512[idx + 1];
-        const uint16_t frac = (uint16_t)std::lrint(fracf * 65535.0f);
-        const uint32_t diff = uint32_t(b) - uint32_t(a);
-        return uint16_t(uint32_t(a) + ((diff * uint32_t(frac)) >> 16));
-    }
 };
 
@@ -1,12 +1,14 @@
 // dsp/MicroVerbMonoInt.hpp
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include "dsp_intrinsics.h"
 
 namespace dsp {
 
 // ---- small Q15 helpers ----
-static inline int32_t sat_q15(int32_t v){ if(v<-32768) return -32768; if(v>32767) return 32767; return v; }
+static inline int32_t sat_q15(int32_t v){ return DSP_SSAT(v, 16); } // one SSAT on RP2350
 static inline int16_t sat_q12_from_q15(int32_t q15){
     int32_t y = q15 >> 4; if (y < -2048) y = -2048; if (y > 2047) y = 2047; return (int16_t)y;
 }
@@ -23,9 +25,10 @@ static constexpr int APCORE = 225;    // ~5 ms
 static constexpr int PREDELAY_MAX = 240; // up to ~5 ms @48k
 
 // ---- primitives ----
+// Delay memory is borrowed (see dsp/DelayArena.hpp): attach() before process()
 template<int N>
 struct CombQ15 {
-    int16_t buf[N] = {};
+    int16_t* buf = nullptr;
     int idx = 0;
     int32_t store = 0;     // Q15
     int32_t fb = 27000;    // feedback (Q15)
@@ -34,7 +37,8 @@ struct CombQ15 {
 
     inline void set_feedback_q15(int32_t q){ if(q<0)q=0; if(q>32767)q=32767; fb=q; }
     inline void set_damp_q15(int32_t d){ if(d<0)d=0; if(d>32767)d=32767; d1=d; d2=32767-d; }
-    inline void mute(){ std::memset(buf,0,sizeof(buf)); idx=0; store=0; }
+    inline void attach(int16_t* mem){ buf = mem; mute(); }
+    inline void mute(){ if(buf) std::memset(buf,0,N*sizeof(int16_t)); idx=0; store=0; }
 
     inline int32_t process(int32_t x){           // x: Q15, returns Q15
         int32_t y = (int32_t)buf[idx] << 1;      // int16 -> Q15 (keep headroom)
@@ -49,12 +53,13 @@ struct CombQ15 {
 
 template<int N>
 struct AllpassQ15 {
-    int16_t buf[N] = {};
+    int16_t* buf = nullptr;
     int idx = 0;
     int32_t fb = 16384; // ~0.5
 
     inline void set_feedback_q15(int32_t q){ if(q<-32768)q=-32768; if(q>32767)q=32767; fb=q; }
-    inline void mute(){ std::memset(buf,0,sizeof(buf)); idx=0; }
+    inline void attach(int16_t* mem){ buf = mem; mute(); }
+    inline void mute(){ if(buf) std::memset(buf,0,N*sizeof(int16_t)); idx=0; }
 
     inline int32_t process(int32_t x){           // x: Q15, returns Q15
         int32_t b = (int32_t)buf[idx] << 1;
@@ -68,7 +73,7 @@ struct AllpassQ15 {
 };
 
 struct PredelayQ15 {
-    int16_t buf[PREDELAY_MAX] = {};
+    int16_t* buf = nullptr;
     int idx = 0;
     int len = 0; // 0..PREDELAY_MAX
 
@@ -76,8 +81,9 @@ struct PredelayQ15 {
         int L = (int)(ms * 0.001f * fs + 0.5f);
         if (L < 0) L = 0; if (L > PREDELAY_MAX) L = PREDELAY_MAX;
         len = L; idx = 0;
-        std::memset(buf,0,sizeof(buf));
+        if (buf) std::memset(buf,0,PREDELAY_MAX*sizeof(int16_t));
     }
+    inline void attach(int16_t* mem){ buf = mem; idx = 0; std::memset(buf,0,PREDELAY_MAX*sizeof(int16_t)); }
     inline int32_t process(int32_t x){ // Q15 -> Q15
         if (len == 0) return x;
         int32_t y = (int32_t)buf[idx] << 1;
@@ -90,8 +96,29 @@ struct PredelayQ15 {
 // ---- MicroVerbMonoInt ----
 class MicroVerbMonoInt {
 public:
+    // Delay memory needed by attachBuffer(), in int16_t samples (~9.8 KB)
+    static constexpr size_t bufferSamples = size_t(COMB1) + COMB2 + COMB3 + APCORE + PREDELAY_MAX;
+
     MicroVerbMonoInt(){ setDefaults(); mute(); }
 
+    // Hand the reverb bufferSamples of delay memory (cleared here); it must be attached before process()
+    void attachBuffer(int16_t* mem){
+        mem_ = mem;
+        c1.attach(mem); mem += COMB1;
+        c2.attach(mem); mem += COMB2;
+        c3.attach(mem); mem += COMB3;
+        ap.attach(mem); mem += APCORE;
+        pre.attach(mem);
+    }
+    // Take the delay memory back; the reverb must not process() until attached again
+    int16_t* detachBuffer(){
+        int16_t* m = mem_;
+        c1.buf = nullptr; c2.buf = nullptr; c3.buf = nullptr; ap.buf = nullptr; pre.buf = nullptr;
+        mem_ = nullptr;
+        return m;
+    }
+    bool attached() const { return mem_ != nullptr; }
+
     // Control-rate setters (float ok; precompute Q15)
     void setRoomSize(float v){ // 0..1 → ~0.25..0.95 feedback
         if(v<0)v=0; if(v>1)v=1;
@@ -146,6 +173,7 @@ private:
     CombQ15<COMB3>  c3;
     AllpassQ15<APCORE> ap;
     PredelayQ15 pre;
+    int16_t* mem_ = nullptr;
 
     // params (Q15)
     static constexpr int32_t input_gain_q15 = 8096;   // ~0.03
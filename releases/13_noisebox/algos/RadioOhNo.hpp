@@ -9,6 +9,7 @@
 
 #include <cstdint>
 #include "dsp/WaveformOsc.hpp"
+#include "dsp/ControlMaps.hpp"
 
 class RadioOhNoAlgo {
 public:
@@ -30,38 +31,57 @@ public:
         // Control-rate update of base freqs and FM scales (every 128 samples)
         if ((ctrlCounter++ & 0x7F) == 0)
         {
-            float x01 = static_cast<float>(x_q12) * (1.0f / 4095.0f);
-            float pitch = x01 * x01; // pow2
-
-            float f1 = 2500.0f * pitch + 20.0f;
-            float f2 = 1120.0f - 1100.0f * pitch; if (f2 < 20.0f) f2 = 20.0f;
-            float f3 = 2900.0f * pitch + 20.0f;
-            float f4 = 8020.0f - (8000.0f * pitch + 20.0f); if (f4 < 20.0f) f4 = 20.0f;
-
-            baseHz[0] = f1; baseHz[1] = f2; baseHz[2] = f3; baseHz[3] = f4;
-            osc[0].setFrequencyHz(f1);
-            osc[1].setFrequencyHz(f2);
-            osc[2].setFrequencyHz(f3);
-            osc[3].setFrequencyHz(f4);
-
-            // FM depth = 0.5 octaves (like Teensy frequencyModulation(0.5))
-            // 0.5 octaves = base_freq * (2^0.5 - 1) ≈ base_freq * 0.414
-            for (int i = 0; i < 4; ++i)
-            {
-                float octaves = 5.0f; // equivalent to frequencyModulation(0.5)
-                float depth_hz = baseHz[i] * (powf(2.0f, octaves) - 1.0f);
-                if (depth_hz < 0.0f) depth_hz = 0.0f;
-                fmScale_q16_16[i] = static_cast<int32_t>(depth_hz * 65536.0f + 0.5f);
-                // Cap at 80% to prevent negative frequencies
-                float cap_hz = 0.8f * baseHz[i];
-                maxFm_q16_16[i] = static_cast<int32_t>(cap_hz * 65536.0f + 0.5f);
-            }
-
-            // Precompute Ky DC FM component in Q16.16 (0..1)
-            y_dc_q16_16 = static_cast<int32_t>((static_cast<int64_t>(y_q12) * 65536 + 2047) / 4095);
-            if (y_dc_q16_16 < 0) y_dc_q16_16 = 0; if (y_dc_q16_16 > 65536) y_dc_q16_16 = 65536;
+            setControls(x_q12, y_q12);
         }
+        return tick();
+    }
+
+    // Render n samples with the controls held for the block; they are decoded at most once per block
+    inline void render(int16_t* out, int n, uint16_t x_q12, uint16_t y_q12)
+    {
+        if (ControlMaps::controlTickInBlock<128>(ctrlCounter, n))
+        {
+            setControls(x_q12, y_q12);
+        }
+        for (int j = 0; j < n; ++j) out[j] = tick();
+    }
+
+private:
+    inline void setControls(uint16_t x_q12, uint16_t y_q12)
+    {
+        using namespace ControlMaps;
+
+        const uint32_t pitch = knobSquaredQ16(x_q12); // pow2
 
+        // Base frequencies in Hz Q16.16
+        int32_t f[4];
+        f[0] = lerpHzQ16(20, 2500, pitch);     // 2500 * pitch + 20
+        f[1] = lerpHzQ16(1120, -1100, pitch);  // 1120 - 1100 * pitch
+        f[2] = lerpHzQ16(20, 2900, pitch);     // 2900 * pitch + 20
+        f[3] = lerpHzQ16(8000, -8000, pitch);  // 8020 - (8000 * pitch + 20)
+
+        for (int i = 0; i < 4; ++i)
+        {
+            if (f[i] < (20 << 16)) f[i] = 20 << 16;
+            baseHz_q16_16[i] = f[i];
+            osc[i].setPhaseIncrement(incFromHzQ16(static_cast<uint32_t>(f[i])));
+
+            // FM depth = 5 octaves: base_freq * (2^5 - 1), saturated to Q16.16 range
+            // (as the Cortex-M float -> int conversion did)
+            const int64_t depth = static_cast<int64_t>(f[i]) * 31;
+            fmScale_q16_16[i] = (depth > INT32_MAX) ? INT32_MAX : static_cast<int32_t>(depth);
+            // Cap at 80% to prevent negative frequencies
+            maxFm_q16_16[i] = static_cast<int32_t>((static_cast<int64_t>(f[i]) * 52429) >> 16); // 0.8 * base
+        }
+
+        // Precompute Ky DC FM component in Q16.16 (0..1)
+        y_dc_q16_16 = static_cast<int32_t>((static_cast<int64_t>(y_q12) * 65536 + 2047) / 4095);
+        if (y_dc_q16_16 < 0) y_dc_q16_16 = 0;
+        if (y_dc_q16_16 > 65536) y_dc_q16_16 = 65536;
+    }
+
+    inline int16_t tick()
+    {
         // Build FM inputs from previous samples (normalized) plus Ky DC; pairwise cross-FM
         // prevSample normalized to Q16.16: prev * 32 (since 65536/2048 = 32)
         int32_t nrm[4];
@@ -101,10 +121,9 @@ public:
         return static_cast<int16_t>(s);
     }
 
-private:
     WaveformOscillator osc[4];
     uint32_t ctrlCounter = 0;
-    float baseHz[4] = {500,500,500,500};
+    int32_t baseHz_q16_16[4] = {500 << 16, 500 << 16, 500 << 16, 500 << 16};
     int32_t fmScale_q16_16[4] = {0,0,0,0};
     int32_t maxFm_q16_16[4] = {0,0,0,0};
     int16_t prevSample[4] = {0,0,0,0};
@@ -8,6 +8,7 @@
 #include "dsp/WaveformOsc.hpp"
 #include "dsp/StateVariableFilterInt.hpp"  // <-- use LUT SVF
 #include "dsp/Wavefolder.hpp"
+#include "dsp/ControlMaps.hpp"
 
 class ResoNoiseAlgo {
 public:
@@ -43,44 +44,84 @@ public:
     // NOTE: Noise Plethora inverts knob readings! We must match this behavior.
     inline int16_t nextSample(uint16_t x_q12, uint16_t y_q12)
     {
-        // Rarely reseed noise to vary texture with X
-        seedAccumulator += static_cast<uint32_t>(x_q12);
-        if ((reseedCounter++ & 0x0FFFu) == 0) {
-            noise.init(baseSeed ^ seedAccumulator);
-        }
-
-        // Base noise voice (full amplitude)
-        int16_t n = noise.nextSample(4095);
-
         // Control-rate updates (every 128 samples)
         if ((paramUpdateCounter++ & 0x7F) == 0) {
-            // X → pitch (quadratic), match Plethora inversion
-            const float x01 = 1.0f - (float)x_q12 * (1.0f / 4095.0f);
-            const float pitch = x01 * x01;
-            const float modHz  = 20.0f + pitch * 7777.0f;
-            const float sineHz = 20.0f + pitch * 10000.0f;
-
-            lfo.setFrequencyHz(modHz);
-            fmSine.setFrequencyHz(sineHz);
-            modSquare.setFrequencyHz(modHz);
-
-            // Precompute FM depth (Q16.16), here using full sineHz (you had 25% note)
-            sineHz_q16_16 = (int32_t)(sineHz * 65536.0f + 0.5f);
-            fmDepth_q16_16 = sineHz_q16_16; // adjust if you want 25%: >> 2
+            setPitch(x_q12);
+        }
+        return tick(x_q12, dcFromY(y_q12));
+    }
+
+    // Render n samples with the controls held for the block; pitch is decoded at most once per block
+    inline void render(int16_t* out, int n, uint16_t x_q12, uint16_t y_q12)
+    {
+        if (ControlMaps::controlTickInBlock<128>(paramUpdateCounter, n)) {
+            setPitch(x_q12);
         }
+        const int16_t dc_value = dcFromY(y_q12);
+        // The FM sine for the whole block, folded in place, then noise and filter
+        for (int j = 0; j < n; ++j) out[j] = fmSineSample();
+        folder.processBlock(out, dc_value, out, n);
+        for (int j = 0; j < n; ++j) out[j] = filterSample(x_q12, out[j]);
+    }
+
+    void setBaseSeed(uint32_t seed) { baseSeed = seed != 0 ? seed : 0x1u; }
+
+    // Run the wavefolder at 1x (default), 2x or 4x the sample rate, for less aliasing at high Y
+    void setFoldOversampling(int factor) { folder.setOversampling(factor); }
+
+private:
+    inline void setPitch(uint16_t x_q12)
+    {
+        using namespace ControlMaps;
+
+        // X → pitch (quadratic), match Plethora inversion
+        const uint32_t pitch = squareQ16(knobInvQ16(x_q12));
+        const uint32_t modInc  = lerpInc(incFromHz(20.0), incFromHz(7777.0), pitch);   // 20 + pitch * 7777 Hz
+        const uint32_t sineInc = lerpInc(incFromHz(20.0), incFromHz(10000.0), pitch);  // 20 + pitch * 10000 Hz
+
+        lfo.setPhaseIncrement(modInc);
+        fmSine.setPhaseIncrement(sineInc);
+        modSquare.setPhaseIncrement(modInc);
 
-        // FM the sine with the square modulator
+        // Precompute FM depth (Q16.16), here using full sineHz (you had 25% note)
+        sineHz_q16_16 = lerpHzQ16(20, 10000, pitch);
+        fmDepth_q16_16 = sineHz_q16_16; // adjust if you want 25%: >> 2
+    }
+
+    // Wavefolder DC from Y (Plethora inversion): (y_norm * 0.2 + 0.03) * 32767, 0.03..0.23
+    static inline int16_t dcFromY(uint16_t y_q12)
+    {
+        return static_cast<int16_t>(983 + ((ControlMaps::knobInvQ16(y_q12) * 6553u) >> 16));
+    }
+
+    inline int16_t tick(uint16_t x_q12, int16_t dc_value)
+    {
+        // Wavefolder input: sine FM + DC from Y
+        const int16_t folded = folder.processOversampled(fmSineSample(), dc_value);
+        return filterSample(x_q12, folded);
+    }
+
+    // Sine, FM'd by the square modulator
+    inline int16_t fmSineSample()
+    {
         const int16_t m = modSquare.nextSample(); // -2048..2047
         // fm_hz_q16_16 = (m/2048) * fmDepth_q16_16
         const int64_t fm_tmp = (int64_t)m * (int64_t)fmDepth_q16_16;
         const int32_t fm_q16_16 = (int32_t)(fm_tmp >> 11); // /2048
-        const int16_t sine = fmSine.nextSample(fm_q16_16);
+        return fmSine.nextSample(fm_q16_16);
+    }
+
+    // Noise through the filter, with the folded sine as its second input
+    inline int16_t filterSample(uint16_t x_q12, int16_t folded)
+    {
+        // Rarely reseed noise to vary texture with X
+        seedAccumulator += static_cast<uint32_t>(x_q12);
+        if ((reseedCounter++ & 0x0FFFu) == 0) {
+            noise.init(baseSeed ^ seedAccumulator);
+        }
 
-        // Wavefolder input: sine FM + DC from Y (Plethora inversion)
-        const float y_norm = 1.0f - (float)y_q12 * (1.0f / 4095.0f);
-        const float dc_amplitude = y_norm * 0.2f + 0.03f; // 0.03..0.23
-        const int16_t dc_value = (int16_t)(dc_amplitude * 32767.0f);
-        const int16_t folded = folder.process(sine, dc_value);
+        // Base noise voice (full amplitude)
+        int16_t n = noise.nextSample(4095);
 
         // Route through filter (dual-input path like Teensy wiring)
         int16_t y = svf.process(n, folded); // correct LUT-SVF call
@@ -93,9 +134,6 @@ public:
         return (int16_t)ys;
     }
 
-    void setBaseSeed(uint32_t seed) { baseSeed = seed != 0 ? seed : 0x1u; }
-
-private:
     WhiteNoise noise;
     WaveformOscillator lfo;       // reserved for future modulation
     WaveformOscillator fmSine;
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include "../dsp/WaveformOsc.hpp"
 #include "MicroVerbInt.hpp"
+#include "../dsp/ControlMaps.hpp"
 
 // Integer-optimized port of Noise Plethora P_S_H:
 // - Source: Sample & Hold waveform generator
@@ -31,42 +32,71 @@ public:
 
     inline int16_t nextSample(uint16_t k1_0_to_4095, uint16_t k2_0_to_4095)
     {
-        // Control-rate parameter updates to minimize float work
+        // Control-rate parameter updates
         if ((ctrlCounter_++ & 0x7F) == 0)
         {
-            // freq = 15 + 5000*(k1/4095)
-            float k1 = static_cast<float>(k1_0_to_4095) * (1.0f / 4095.0f);
-            float freq = 15.0f + 5000.0f * k1;
-            if (freq < 0.0f) freq = 0.0f;
-            shOsc_.setFrequencyHz(freq);
+            setFrequency(k1_0_to_4095);
         }
+        setMix(k2_0_to_4095);
+        return tick();
+    }
 
-        // Source
-        const int16_t dry_s = shOsc_.nextSample(); // -2048..2047
+    // Render n samples with the controls held for the block; they are decoded at most once per block
+    inline void render(int16_t* out, int n, uint16_t k1_0_to_4095, uint16_t k2_0_to_4095)
+    {
+        if (ControlMaps::controlTickInBlock<128>(ctrlCounter_, n))
+        {
+            setFrequency(k1_0_to_4095);
+        }
+        setMix(k2_0_to_4095);
+        for (int j = 0; j < n; ++j) out[j] = tick();
+    }
 
-        // Reverb (pure wet mono)
-        int16_t wet = reverb_.process(dry_s);
+    // Reverb delay memory, borrowed from the shared arena while this algorithm is active
+    static constexpr size_t bufferSamples = dsp::MicroVerbMonoInt::bufferSamples;
+    void attachBuffer(int16_t* mem) { reverb_.attachBuffer(mem); }
+    int16_t* detachBuffer() { return reverb_.detachBuffer(); }
 
+private:
+    inline void setFrequency(uint16_t k1_0_to_4095)
+    {
+        // freq = 15 + 5000*(k1/4095)
+        using namespace ControlMaps;
+        shOsc_.setPhaseIncrement(lerpInc(incFromHz(15.0), incFromHz(5000.0), knobQ16(k1_0_to_4095)));
+    }
+
+    inline void setMix(uint16_t k2_0_to_4095)
+    {
         // Integer cross-mix
         // dry_gain = (4095 - k2); wet_gain = min(4*k2, 4095)  [Q12 gains]
         int32_t k2c = static_cast<int32_t>(k2_0_to_4095);
         if (k2c < 0) k2c = 0; else if (k2c > 4095) k2c = 4095;
-        int32_t dry_gain_q12 = 4095 - k2c;
-        int32_t wet_gain_q12 = k2c << 2; // *4
-        if (wet_gain_q12 > 4095) wet_gain_q12 = 4095;
+        dryGain_q12_ = 4095 - k2c;
+        wetGain_q12_ = k2c << 2; // *4
+        if (wetGain_q12_ > 4095) wetGain_q12_ = 4095;
+    }
 
-        int32_t dry_mix = (static_cast<int32_t>(dry_s) * dry_gain_q12) >> 12;
-        int32_t wet_mix = (static_cast<int32_t>(wet) * wet_gain_q12) >> 12;
+    inline int16_t tick()
+    {
+        // Source
+        const int16_t dry_s = shOsc_.nextSample(); // -2048..2047
+
+        // Reverb (pure wet mono)
+        int16_t wet = reverb_.process(dry_s);
+
+        int32_t dry_mix = (static_cast<int32_t>(dry_s) * dryGain_q12_) >> 12;
+        int32_t wet_mix = (static_cast<int32_t>(wet) * wetGain_q12_) >> 12;
         int32_t out = dry_mix + wet_mix;
         if (out < -2048) out = -2048;
         if (out >  2047) out =  2047;
         return static_cast<int16_t>(out);
     }
 
-private:
     WaveformOscillator shOsc_;
     dsp::MicroVerbMonoInt reverb_;
     uint32_t ctrlCounter_ = 0;
+    int32_t dryGain_q12_ = 4095;
+    int32_t wetGain_q12_ = 0;
 };
 
 
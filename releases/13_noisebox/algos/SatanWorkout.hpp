@@ -5,6 +5,7 @@
 #include "dsp/WaveformOsc.hpp"
 #include "dsp/WhiteNoise.hpp"
 #include "MicroVerbInt.hpp"
+#include "dsp/ControlMaps.hpp"
 
 // Port of Noise Plethora P_satanWorkout using available DSP blocks only.
 // Topology (approximation of the Teensy patch-cord graph):
@@ -37,30 +38,51 @@ public:
 
         // Noise/pink init
         noise_.init(0x12345u);
-        pinkState_q19_() = 0; // force zeroed
+        pinkState_q19_ = 0; // force zeroed
     }
 
     // Generate one 12-bit sample. k1/k2: 0..4095
     inline int32_t process(int32_t k1_0_to_4095, int32_t k2_0_to_4095)
     {
-        // Clamp controls
-        if (k1_0_to_4095 < 0) k1_0_to_4095 = 0; else if (k1_0_to_4095 > 4095) k1_0_to_4095 = 4095;
-        if (k2_0_to_4095 < 0) k2_0_to_4095 = 0; else if (k2_0_to_4095 > 4095) k2_0_to_4095 = 4095;
-
         // Control-rate updates (every 64 samples)
         if ((ctrlCounter_++ & 0x3F) == 0)
         {
-            const float k1 = static_cast<float>(k1_0_to_4095) * (1.0f / 4095.0f);
-            const float pitch1 = k1 * k1; // pow2 mapping
-            const float f_hz = 8.0f + pitch1 * 6000.0f;
-            pwm_.setFrequencyHz(f_hz);
-
-            const float k2 = static_cast<float>(k2_0_to_4095) * (1.0f / 4095.0f);
-            float room = 0.001f + 4.0f * k2; // as per original; clamp to [0..1]
-            if (room < 0.0f) room = 0.0f; if (room > 1.0f) room = 1.0f;
-            verb_.setRoomSize(room);
+            setControls(k1_0_to_4095, k2_0_to_4095);
+        }
+        return tick();
+    }
+
+    // Render n samples with the controls held for the block; they are decoded at most once per block
+    inline void render(int16_t* out, int n, int32_t k1_0_to_4095, int32_t k2_0_to_4095)
+    {
+        if (ControlMaps::controlTickInBlock<64>(ctrlCounter_, n))
+        {
+            setControls(k1_0_to_4095, k2_0_to_4095);
         }
+        for (int j = 0; j < n; ++j) out[j] = static_cast<int16_t>(tick());
+    }
+
+    // Reverb delay memory, borrowed from the shared arena while this algorithm is active
+    static constexpr size_t bufferSamples = dsp::MicroVerbMonoInt::bufferSamples;
+    void attachBuffer(int16_t* mem) { verb_.attachBuffer(mem); }
+    int16_t* detachBuffer() { return verb_.detachBuffer(); }
 
+private:
+    inline void setControls(int32_t k1_0_to_4095, int32_t k2_0_to_4095)
+    {
+        using namespace ControlMaps;
+
+        const uint32_t pitch1 = knobSquaredQ16(k1_0_to_4095); // pow2 mapping
+        pwm_.setPhaseIncrement(lerpInc(incFromHz(8.0), incFromHz(6000.0), pitch1)); // 8 + pitch1 * 6000 Hz
+
+        uint32_t room_q16 = ratioQ16(0.001) + 4 * knobQ16(k2_0_to_4095); // as per original; clamp to [0..1]
+        if (room_q16 > kOneQ16) room_q16 = kOneQ16;
+        // Same curve as MicroVerbMonoInt::setRoomSize: 0..1 → 0.25..0.95 feedback
+        verb_.setRoomSizeQ15(q15(0.25) + static_cast<int32_t>((room_q16 * static_cast<uint32_t>(q15(0.70))) >> 16));
+    }
+
+    inline int32_t tick()
+    {
         // Pink-ish modulation source from low-passed white noise (fixed-point)
         // White in: 12-bit signed [-2048..2047]
         int32_t w12 = static_cast<int32_t>(noise_.nextSample(4095));
@@ -71,12 +93,12 @@ public:
         static constexpr int32_t a_Q12 = 4050;          // ~0.9897
         static constexpr int32_t one_Q12 = 4096;
         const int32_t x_q19 = (w12 << 7);               // promote to ~Q19
-        int32_t y_q19 = pinkState_q19_();               // previous state
+        int32_t y_q19 = pinkState_q19_;               // previous state
         // y = (a*y + (1-a)*x) >> 12  (keep in Q19)
         int64_t acc = (static_cast<int64_t>(a_Q12) * y_q19)
                     + (static_cast<int64_t>(one_Q12 - a_Q12) * x_q19);
         y_q19 = static_cast<int32_t>(acc >> 12);
-        pinkState_q19_() = y_q19;
+        pinkState_q19_ = y_q19;
 
         // Back to ~12-bit domain
         int32_t pink12 = (y_q19 >> 7);                  // ~-2048..2047
@@ -101,12 +123,11 @@ public:
         int16_t wet = verb_.process(dry);
 
         // Mono output
-        int32_t mono = static_cast<int32_t>(wet * 8.0f);
+        int32_t mono = static_cast<int32_t>(wet) * 8;
         if (mono < -2048) mono = -2048; if (mono > 2047) mono = 2047;
         return mono;
     }
 
-private:
     // Minimal Q15 multiply with rounding (same convention as dsp::FreeverbInt)
     static inline int32_t mul_q15_(int32_t a, int32_t b)
     {
@@ -115,17 +136,11 @@ private:
         return static_cast<int32_t>((p + adj) >> 15);
     }
 
-    // Accessor to ensure a single definition and avoid static init order issues
-    static inline int32_t& pinkState_q19_()
-    {
-        static int32_t s = 0;
-        return s;
-    }
-
     WaveformOscillator pwm_;
     WhiteNoise noise_;
     dsp::MicroVerbMonoInt verb_;
     uint32_t ctrlCounter_ = 0;
+    int32_t pinkState_q19_ = 0; // per instance, so two voices on different cores don't share it
 };
 
 
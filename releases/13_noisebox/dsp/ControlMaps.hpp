@@ -0,0 +1,128 @@
+// Fixed-point control maps: knob/CV values -> curves -> phase increments (48 kHz)
+// The RP2040 has no FPU, so algorithm control paths use these instead of float normalisation,
+// pow(knob, 2) and setFrequencyHz(float). Everything at run time is integer; only constants
+// (e.g. incFromHz(20.0)) are computed with doubles, at compile time.
+//
+// Conventions:
+//   - knobs/CVs are 0..4095; curves are Q16 with 65536 = 1.0
+//   - phase increments are uint32_t, 2^32 = one cycle per sample (WaveformOscillator::setPhaseIncrement)
+//   - "Hz Q16.16" is the FM input format of WaveformOscillator::nextSample
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "DspTables.hpp"
+
+namespace ControlMaps {
+
+constexpr double kSampleRate = 48000.0;
+constexpr uint32_t kOneQ16 = 65536;
+
+// ---- compile-time constants ----
+// Phase increment for hz, for constants only (rounds, clamps to 0..fs)
+constexpr uint32_t incFromHz(double hz)
+{
+    if (hz <= 0.0) return 0;
+    if (hz >= kSampleRate) return 0xFFFFFFFFu;
+    return static_cast<uint32_t>(hz * (4294967296.0 / kSampleRate) + 0.5);
+}
+// Multiplier in Q16, e.g. ratioQ16(1.227)
+constexpr uint32_t ratioQ16(double r) { return (r <= 0.0) ? 0 : static_cast<uint32_t>(r * 65536.0 + 0.5); }
+// Fraction 0..1 in Q15, as used for pulse widths and mix gains
+constexpr int32_t q15(double v) { return static_cast<int32_t>(v * 32768.0 + 0.5); }
+
+// ---- knob curves ----
+static inline int32_t clampKnob(int32_t k) { return (k < 0) ? 0 : (k > 4095 ? 4095 : k); }
+
+// Knob 0..4095 -> 0..65536 (Q16, 4095 -> 1.0), within 1 LSB of k * 65536 / 4095
+static inline uint32_t knobQ16(int32_t k)
+{
+    const uint32_t u = static_cast<uint32_t>(clampKnob(k));
+    return (u << 4) + (u >> 8) + (u >> 11);
+}
+// 1 - knob, for Noise Plethora's inverted knobs
+static inline uint32_t knobInvQ16(int32_t k) { return kOneQ16 - knobQ16(k); }
+
+// Square of a Q16 value, i.e. pow(x, 2)
+static inline uint32_t squareQ16(uint32_t x_q16) { return static_cast<uint32_t>((static_cast<uint64_t>(x_q16) * x_q16) >> 16); }
+// pow(knob, 2) in Q16, the "pitch" curve most algorithms use
+static inline uint32_t knobSquaredQ16(int32_t k) { return squareQ16(knobQ16(k)); }
+
+// x * y, both Q16
+static inline uint32_t mulQ16(uint32_t x_q16, uint32_t y_q16) { return static_cast<uint32_t>((static_cast<uint64_t>(x_q16) * y_q16) >> 16); }
+
+// ---- increments ----
+// base + x * span, in the increment domain: equivalent to setFrequencyHz(baseHz + x * spanHz)
+static inline uint32_t lerpInc(uint32_t baseInc, uint32_t spanInc, uint32_t x_q16)
+{
+    return baseInc + static_cast<uint32_t>((static_cast<uint64_t>(spanInc) * x_q16) >> 16);
+}
+// inc * ratio (Q16), saturating
+static inline uint32_t scaleInc(uint32_t inc, uint32_t ratio_q16)
+{
+    const uint64_t v = (static_cast<uint64_t>(inc) * ratio_q16) >> 16;
+    return (v > 0xFFFFFFFFull) ? 0xFFFFFFFFu : static_cast<uint32_t>(v);
+}
+static inline uint32_t clampInc(uint32_t inc, uint32_t lo, uint32_t hi) { return (inc < lo) ? lo : (inc > hi ? hi : inc); }
+
+// Frequency in Hz Q16.16 -> phase increment: hz_q16 * 2^16 / fs, with 2^16 / fs kept in 32.32 fixed point
+static inline uint32_t incFromHzQ16(uint32_t hz_q16)
+{
+    return static_cast<uint32_t>((static_cast<uint64_t>(hz_q16) * 5864062015ull) >> 32);
+}
+// base + x * span in Hz Q16.16 (spanHz may be negative); for FM depths and caps
+static inline int32_t lerpHzQ16(int32_t baseHz, int32_t spanHz, uint32_t x_q16)
+{
+    return static_cast<int32_t>((static_cast<int64_t>(baseHz) << 16) + static_cast<int64_t>(spanHz) * x_q16);
+}
+
+// ---- exponential (V/oct) ----
+// 2^(i/256) in Q30 for i = 0..256, generated at compile time
+constexpr std::array<uint32_t, 257> makeExp2Table()
+{
+    std::array<uint32_t, 257> t{};
+    for (int i = 0; i <= 256; ++i)
+        t[i] = static_cast<uint32_t>(DspTables::exp(0.69314718055994530942 * i / 256.0) * 1073741824.0 + 0.5);
+    return t;
+}
+inline constexpr std::array<uint32_t, 257> exp2Q30 = makeExp2Table();
+
+// 2^frac for frac in Q16 [0, 1), Q30 result in [2^30, 2^31)
+static inline uint32_t exp2FracQ30(uint32_t frac_q16)
+{
+    const uint32_t i = (frac_q16 >> 8) & 0xFF, f = frac_q16 & 0xFF;
+    const uint32_t a = exp2Q30[i], b = exp2Q30[i + 1];
+    return a + (((b - a) * f) >> 8);
+}
+
+// inc * 2^(octaves), octaves in Q16 (e.g. 1 V/oct CV scaled to octaves); saturating
+static inline uint32_t incTimesExp2(uint32_t inc, int32_t octaves_q16)
+{
+    const int32_t whole = octaves_q16 >> 16;               // floor
+    const uint32_t m = exp2FracQ30(static_cast<uint32_t>(octaves_q16) & 0xFFFF);
+    const uint64_t v = static_cast<uint64_t>(inc) * m;     // Q30
+    const int shift = 30 - whole;
+    if (shift >= 64) return 0;
+    if (shift <= 0)  return 0xFFFFFFFFu;
+    const uint64_t r = v >> shift;
+    return (r > 0xFFFFFFFFull) ? 0xFFFFFFFFu : static_cast<uint32_t>(r);
+}
+
+// 2^(octaves) in Q16 for octaves_q16 in about [-16, 15]
+static inline uint32_t exp2Q16(int32_t octaves_q16) { return incTimesExp2(kOneQ16, octaves_q16); }
+
+// ---- block rendering ----
+// For render(): true if a control-rate update (every Period samples, Period a power of two) falls within
+// the next n samples, then advances counter by n. Decoding once at the start of such a block keeps the
+// per-sample path's update cadence without testing the counter every sample.
+template <uint32_t Period>
+static inline bool controlTickInBlock(uint32_t& counter, int n)
+{
+    static_assert((Period & (Period - 1)) == 0, "Period must be a power of two");
+    const uint32_t phase = counter & (Period - 1);
+    counter += static_cast<uint32_t>(n);
+    return phase == 0 || phase + static_cast<uint32_t>(n) > Period;
+}
+
+} // namespace ControlMaps
@@ -0,0 +1,53 @@
+// dsp/DelayArena.hpp
+// Shared pool for delay-line memory (reverb combs/allpasses, predelays)
+//
+// Delay primitives no longer own their int16_t buffers; an algorithm borrows one slot from the arena
+// when it is activated and returns it when deactivated, so only the selected algorithms pay for their
+// reverb memory. Slots are fixed-size (the largest client's requirement), so borrowing and returning in
+// any order never fragments. Not thread-safe: acquire/release from one core only.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#ifndef NOISEBOX_ARENA_BUDGET_BYTES
+#define NOISEBOX_ARENA_BUDGET_BYTES (32 * 1024)
+#endif
+
+namespace dsp {
+
+template<size_t SlotSamples, int NumSlots>
+class DelayArena {
+    static_assert(NumSlots > 0 && NumSlots <= 32, "DelayArena supports 1..32 slots");
+public:
+    static constexpr size_t slotSamples = SlotSamples;
+    static constexpr int numSlots = NumSlots;
+    static constexpr size_t bytes = SlotSamples * NumSlots * sizeof(int16_t);
+    static_assert(bytes <= NOISEBOX_ARENA_BUDGET_BYTES, "DelayArena exceeds NOISEBOX_ARENA_BUDGET_BYTES");
+
+    // Compile-time check that a client fits in one slot
+    template<size_t ClientSamples>
+    static constexpr bool fits(){ return ClientSamples <= SlotSamples; }
+
+    // Borrow a slot of SlotSamples int16_t (contents undefined); nullptr if all are in use
+    int16_t* acquire(){
+        for (int i = 0; i < NumSlots; ++i){
+            if (!(used_ & (1u << i))){ used_ |= (1u << i); return pool_ + size_t(i) * SlotSamples; }
+        }
+        return nullptr;
+    }
+
+    // Return a slot obtained from acquire(); nullptr is ignored
+    void release(int16_t* p){
+        if (!p) return;
+        int i = int(size_t(p - pool_) / SlotSamples);
+        if (i >= 0 && i < NumSlots) used_ &= ~(1u << i);
+    }
+
+    int freeSlots() const { int n = 0; for (int i = 0; i < NumSlots; ++i) n += !(used_ & (1u << i)); return n; }
+
+private:
+    int16_t pool_[SlotSamples * NumSlots];
+    uint32_t used_ = 0;
+};
+
+} // namespace dsp
@@ -0,0 +1,125 @@
+// Shared lookup tables for the dsp headers, generated at compile time
+// Every table-driven dsp block reads its table from here instead of building a private copy at
+// startup, so constructors do no table work and each table exists once in the image.
+//
+// Placement: tables read every sample (sine, SVF coefficients) go in SRAM so lookups never wait on
+// an XIP cache miss; they are copied there with the rest of .data at boot. The 16 KB SVF knob map
+// stays in flash. Define NOISEBOX_TABLES_IN_FLASH to keep every table in flash (saves ~2 KB RAM),
+// or NOISEBOX_KNOBMAP_IN_RAM to move the knob map to SRAM as well.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#if defined(__arm__) && !defined(NOISEBOX_TABLES_IN_FLASH)
+#define DSP_TABLE_RAM __attribute__((section(".data.dsp_tables")))
+#else
+#define DSP_TABLE_RAM
+#endif
+
+#if defined(__arm__) && !defined(NOISEBOX_TABLES_IN_FLASH) && defined(NOISEBOX_KNOBMAP_IN_RAM)
+#define DSP_TABLE_KNOBMAP DSP_TABLE_RAM
+#else
+#define DSP_TABLE_KNOBMAP
+#endif
+
+namespace DspTables {
+
+// ---- constexpr math, double precision, only used to build tables ----
+constexpr double kPi = 3.14159265358979323846;
+
+constexpr double sin(double x)
+{
+    // Reduce to [-pi, pi], then Taylor series
+    while (x > kPi) x -= 2.0 * kPi;
+    while (x < -kPi) x += 2.0 * kPi;
+    double term = x, sum = x;
+    for (int n = 1; n < 30; ++n)
+    {
+        term *= -x * x / static_cast<double>((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double exp(double x)
+{
+    // exp(x) = exp(x / 2^k)^(2^k), with |x / 2^k| < 0.5
+    int k = 0;
+    while (x > 0.5 || x < -0.5) { x *= 0.5; ++k; }
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 25; ++n)
+    {
+        term *= x / static_cast<double>(n);
+        sum += term;
+    }
+    while (k-- > 0) sum *= sum;
+    return sum;
+}
+
+constexpr double log(double x)
+{
+    // x = m * 2^e with m in [0.5, 1), ln(m) = 2 atanh((m - 1) / (m + 1))
+    constexpr double ln2 = 0.69314718055994530942;
+    int e = 0;
+    while (x >= 1.0) { x *= 0.5; ++e; }
+    while (x < 0.5) { x *= 2.0; --e; }
+    const double z = (x - 1.0) / (x + 1.0);
+    double zp = z, sum = 0.0;
+    for (int n = 0; n < 40; ++n)
+    {
+        sum += zp / static_cast<double>(2 * n + 1);
+        zp *= z * z;
+    }
+    return 2.0 * sum + static_cast<double>(e) * ln2;
+}
+
+constexpr int32_t roundToInt(double x) { return (x >= 0.0) ? static_cast<int32_t>(x + 0.5) : -static_cast<int32_t>(-x + 0.5); }
+
+// ---- 512-point sine, 12-bit (-2047..2047) ----
+// Same values WaveformOscillator used to build at runtime: float angle, sin rounded to float, truncated.
+constexpr int kSine512Size = 512;
+
+constexpr std::array<int16_t, kSine512Size> makeSine512()
+{
+    std::array<int16_t, kSine512Size> t{};
+    for (int i = 0; i < kSine512Size; ++i)
+    {
+        const float angle = (2.0f * 3.14159265358979323846f * static_cast<float>(i)) / static_cast<float>(kSine512Size);
+        const float sv = static_cast<float>(DspTables::sin(static_cast<double>(angle)));
+        int32_t v = static_cast<int32_t>(sv * 2047.0f);
+        if (v < -2048) v = -2048;
+        if (v > 2047) v = 2047;
+        t[i] = static_cast<int16_t>(v);
+    }
+    return t;
+}
+
+DSP_TABLE_RAM inline constexpr std::array<int16_t, kSine512Size> sine512 = makeSine512();
+
+// ---- resonant filter cutoff coefficients, 20Hz to 20480Hz in 32 steps per octave ----
+// For cutoff w = 2 pi fc / 48000: g = 1 - exp(-w) (one-pole coefficient), cos(w) and sin(w), all Q15.
+// Read once per band per control update (ResonantFilterBank), so left in flash.
+constexpr int kCutoffStepsPerOctave = 32;
+constexpr int kCutoffOctaves = 10;
+constexpr int kCutoffSize = kCutoffStepsPerOctave * kCutoffOctaves + 1;
+
+struct CutoffCoeffs { int16_t g, cosw, sinw; };
+
+constexpr std::array<CutoffCoeffs, kCutoffSize> makeCutoffCoeffs()
+{
+    std::array<CutoffCoeffs, kCutoffSize> t{};
+    for (int i = 0; i < kCutoffSize; ++i)
+    {
+        const double hz = 20.0 * DspTables::exp(0.69314718055994530942 * i / static_cast<double>(kCutoffStepsPerOctave));
+        const double w = 2.0 * kPi * hz / 48000.0;
+        auto q15 = [](double v) { const int32_t r = roundToInt(32768.0 * v); return static_cast<int16_t>(r > 32767 ? 32767 : r); };
+        t[i] = { q15(1.0 - DspTables::exp(-w)), q15(DspTables::sin(w + 0.5 * kPi)), q15(DspTables::sin(w)) };
+    }
+    return t;
+}
+
+inline constexpr std::array<CutoffCoeffs, kCutoffSize> cutoffCoeffs = makeCutoffCoeffs();
+
+} // namespace DspTables
@@ -1,11 +1,13 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include "dsp_intrinsics.h"
 
 namespace dsp {
 
 // ---- small Q15 helpers ----
-static inline int32_t sat_q15(int32_t v){ if(v<-32768) return -32768; if(v>32767) return 32767; return v; }
+static inline int32_t sat_q15(int32_t v){ return DSP_SSAT(v, 16); } // one SSAT on RP2350
 static inline int16_t sat_q12_from_q15(int32_t q15){
     int32_t y = q15 >> 4; if (y < -2048) y = -2048; if (y > 2047) y = 2047; return (int16_t)y;
 }
@@ -19,9 +21,10 @@ static constexpr int combL_tunings[5]    = { 1188, 1277, 1356, 1491, 1617 };
 static constexpr int allpassL_tunings[3] = { 556,  441,  341  };
 
 // ---- Delay primitives ----
+// Delay memory is borrowed (see DelayArena.hpp): attach() before process()
 template<int N>
 struct CombQ15 {
-    int16_t buf[N] = {};
+    int16_t* buf = nullptr;
     int idx = 0;
     int32_t filterstore = 0; // Q15
     int32_t feedback = 0;    // Q15
@@ -29,7 +32,8 @@ struct CombQ15 {
 
     inline void set_feedback_q15(int32_t fb){ feedback = fb; }
     inline void set_damp_q15(int32_t d){ if(d<0)d=0; if(d>32767)d=32767; damp1=d; damp2=32767-d; }
-    inline void mute(){ std::memset(buf,0,sizeof(buf)); idx=0; filterstore=0; }
+    inline void attach(int16_t* mem){ buf = mem; mute(); }
+    inline void mute(){ if(buf) std::memset(buf,0,N*sizeof(int16_t)); idx=0; filterstore=0; }
 
     inline int32_t process(int32_t x){
         int32_t y = (int32_t)buf[idx] << 1; // int16→Q15
@@ -45,12 +49,13 @@ struct CombQ15 {
 
 template<int N>
 struct AllpassQ15 {
-    int16_t buf[N] = {};
+    int16_t* buf = nullptr;
     int idx = 0;
     int32_t feedback = 16384; // ~0.5
 
     inline void set_feedback_q15(int32_t fb){ if(fb<-32768)fb=-32768; if(fb>32767)fb=32767; feedback=fb; }
-    inline void mute(){ std::memset(buf,0,sizeof(buf)); idx=0; }
+    inline void attach(int16_t* mem){ buf = mem; mute(); }
+    inline void mute(){ if(buf) std::memset(buf,0,N*sizeof(int16_t)); idx=0; }
 
     inline int32_t process(int32_t x){
         int32_t b = (int32_t)buf[idx] << 1;
@@ -66,8 +71,39 @@ struct AllpassQ15 {
 // ---- FreeverbLiteInt (mono path using 3 combs + 2 allpasses) ----
 class FreeverbLiteInt {
 public:
+    // Delay memory needed by attachBuffer(), in int16_t samples (~33 KB): L and R lines, R longer by stereo_spread
+    static constexpr size_t lineSamplesL = size_t(combL_tunings[0]) + combL_tunings[1] + combL_tunings[2]
+        + combL_tunings[3] + combL_tunings[4] + allpassL_tunings[0] + allpassL_tunings[1] + allpassL_tunings[2];
+    static constexpr size_t bufferSamples = 2 * lineSamplesL + 8 * stereo_spread;
+
     FreeverbLiteInt(){ setDefaults(); mute(); }
 
+    // Hand the reverb bufferSamples of delay memory (cleared here); it must be attached before process()
+    void attachBuffer(int16_t* mem){
+        mem_ = mem;
+        combL0.attach(mem); mem += combL_tunings[0]; combL1.attach(mem); mem += combL_tunings[1];
+        combL2.attach(mem); mem += combL_tunings[2]; combL3.attach(mem); mem += combL_tunings[3];
+        combL4.attach(mem); mem += combL_tunings[4];
+        combR0.attach(mem); mem += combL_tunings[0] + stereo_spread; combR1.attach(mem); mem += combL_tunings[1] + stereo_spread;
+        combR2.attach(mem); mem += combL_tunings[2] + stereo_spread; combR3.attach(mem); mem += combL_tunings[3] + stereo_spread;
+        combR4.attach(mem); mem += combL_tunings[4] + stereo_spread;
+        allpassL0.attach(mem); mem += allpassL_tunings[0]; allpassL1.attach(mem); mem += allpassL_tunings[1];
+        allpassL2.attach(mem); mem += allpassL_tunings[2];
+        allpassR0.attach(mem); mem += allpassL_tunings[0] + stereo_spread; allpassR1.attach(mem); mem += allpassL_tunings[1] + stereo_spread;
+        allpassR2.attach(mem);
+    }
+    // Take the delay memory back; the reverb must not process() until attached again
+    int16_t* detachBuffer(){
+        int16_t* m = mem_;
+        combL0.buf = combL1.buf = combL2.buf = combL3.buf = combL4.buf = nullptr;
+        combR0.buf = combR1.buf = combR2.buf = combR3.buf = combR4.buf = nullptr;
+        allpassL0.buf = allpassL1.buf = allpassL2.buf = nullptr;
+        allpassR0.buf = allpassR1.buf = allpassR2.buf = nullptr;
+        mem_ = nullptr;
+        return m;
+    }
+    bool attached() const { return mem_ != nullptr; }
+
     // Control-rate setters
     void setRoomSize(float v){ if(v<0)v=0; if(v>1)v=1; roomsize_q15 = toQ15(0.28f + v*0.69f); refreshCombFeedbacks(); }
     void setDamp(float v){ if(v<0)v=0; if(v>1)v=1; damp_q15 = toQ15(v); applyDampAll(); }
@@ -140,6 +176,7 @@ private:
     AllpassQ15<allpassL_tunings[0] + stereo_spread> allpassR0;
     AllpassQ15<allpassL_tunings[1] + stereo_spread> allpassR1;
     AllpassQ15<allpassL_tunings[2] + stereo_spread> allpassR2;
+    int16_t* mem_ = nullptr;
 
     // Params (Q15)
     static constexpr int32_t fixed_gain_q15 = 492; // ~0.015
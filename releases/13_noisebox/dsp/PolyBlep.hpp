@@ -0,0 +1,41 @@
+// Integer polyBLEP residual for band-limited Saw/Square (48 kHz)
+// A naive saw or pulse jumps once per cycle, which aliases badly at high pitch. polyBLEP subtracts a
+// two-sample polynomial (band-limited step minus naive step) around each jump, which removes most of
+// the audible aliasing for one divide and one multiply per edge, and nothing away from the edges.
+//
+// Phases and increments use the oscillator convention: uint32_t, 2^32 = one cycle.
+
+#pragma once
+
+#include <cstdint>
+
+namespace dsp {
+
+// Residual of a rising unit step at phase 0, in Q15 (-32768..32768 = -1..+1), for the sample at
+// 'phase' of an oscillator advancing by 'inc' per sample. Add (residual * step height / 2) to the
+// naive waveform at every upward jump, subtract it at every downward jump.
+static inline int32_t polyBlepQ15(uint32_t phase, uint32_t inc)
+{
+    // Below ~0.4 Hz nothing aliases (and inc >> 15 would be 0); at or above fs/2 the edges overlap
+    if (inc < (1u << 15) || inc >= 0x80000000u) return 0;
+    const uint32_t dt = inc >> 15; // so phase / dt is Q15; a 32-bit divide (RP2040 hardware divider)
+
+    if (phase < inc)
+    {
+        // Just after the edge: x = phase / inc, residual = -(1 - x)^2
+        uint32_t x = phase / dt; if (x > 32768) x = 32768;
+        const int32_t r = 32768 - static_cast<int32_t>(x);
+        return -((r * r) >> 15);
+    }
+    const uint32_t before = 0u - phase; // distance to the next edge
+    if (before <= inc)
+    {
+        // Just before the edge: y = (1 - phase) / inc, residual = (1 - y)^2
+        uint32_t y = before / dt; if (y > 32768) y = 32768;
+        const int32_t r = 32768 - static_cast<int32_t>(y);
+        return (r * r) >> 15;
+    }
+    return 0;
+}
+
+} // namespace dsp
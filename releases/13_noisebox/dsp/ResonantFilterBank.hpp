@@ -0,0 +1,251 @@
+// Bank of N cheap resonant filters sharing one control pass per block
+// Type is one of the CheapResonantFilters.hpp classes; the bank runs the same filter, but with the
+// state for all bands held as arrays (one per state variable) and the coefficients for every band
+// worked out together in update(), from a shared table (DspTables::cutoffCoeffs) rather than each
+// filter recomputing its own. Meant for formant or vocoder style banks of 8 to 16 bands.
+//
+// Cutoffs are in octaves above 20Hz, Q16 (0..10 octaves, i.e. up to 20480Hz). Each band has a
+// base cutoff, and optionally a triangle LFO, plus a shift common to all bands passed to update().
+// Input is 12-bit (-2048..2047), as for the single filters; each band is clamped to 12 bits as
+// they are, then mixed with its gain. Everything at run time is int32.
+//
+// Per block:
+//   bank.update(shift_q16, n);            // LFOs advanced by n samples, coefficients recomputed
+//   bank.processBlock(in, out, n);
+//
+// BiquadResonant bands use the exact cookbook coefficients (the single filter approximates sin and
+// cos), and can be switched to bandpass (constant 0dB peak) with setBandpass, for formants.
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include "CheapResonantFilters.hpp"
+#include "DspTables.hpp"
+
+template <int N, typename Type>
+class ResonantFilterBank {
+    static_assert(N >= 1, "a bank needs at least one band");
+    static_assert(std::is_same<Type, OnePoleResonant>::value || std::is_same<Type, BiquadResonant>::value ||
+                  std::is_same<Type, MoogLadderApprox>::value || std::is_same<Type, UltraFastResonant>::value,
+                  "Type must be one of the CheapResonantFilters classes");
+
+    static constexpr bool kOnePole = std::is_same<Type, OnePoleResonant>::value;
+    static constexpr bool kBiquad = std::is_same<Type, BiquadResonant>::value;
+    static constexpr bool kMoog = std::is_same<Type, MoogLadderApprox>::value;
+
+public:
+    static constexpr int kBands = N;
+    static constexpr int32_t kMaxOctavesQ16 = DspTables::kCutoffOctaves << 16;
+
+    ResonantFilterBank()
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            baseQ16[i] = 0;
+            lfoInc[i] = 0;
+            lfoPhase[i] = 0;
+            gain[i] = 32767 / N;
+        }
+        setResonanceQ15(kBiquad ? 8192 : 16384);
+        reset();
+        update(0, 0);
+    }
+
+    void reset()
+    {
+        for (int i = 0; i < N; ++i) s1[i] = s2[i] = s3[i] = s4[i] = 0;
+    }
+
+    // ---- setup ----
+    // Base cutoff of a band in Hz (double math, for setup only)
+    void setBandHz(int band, double hz)
+    {
+        if (hz < 20.0) hz = 20.0;
+        setBandOctaves(band, static_cast<int32_t>(DspTables::log(hz / 20.0) * (65536.0 / 0.69314718055994530942)));
+    }
+    void setBandOctaves(int band, int32_t octaves_q16) { baseQ16[band] = octaves_q16; }
+
+    // Band LFO rate as a phase increment (ControlMaps::incFromHz), 0 for none
+    void setLfoIncrement(int band, uint32_t inc) { lfoInc[band] = inc; }
+    void setLfoPhase(int band, uint32_t phase) { lfoPhase[band] = phase; }
+    // LFO swing, +-octaves (Q16), shared by all bands
+    void setLfoDepthQ16(int32_t octaves_q16) { lfoDepthQ16 = octaves_q16; }
+
+    // Band gain in the mix, Q15; defaults to 1/N
+    void setGainQ15(int band, int32_t g) { gain[band] = g; }
+
+    // Shared by all bands, with the same meaning and limits as the single filter's setResonanceQ15
+    // (for BiquadResonant it is 1/Q)
+    void setResonanceQ15(int32_t res_q15)
+    {
+        int32_t lo = 0, hi = 32000;
+        if (kBiquad) { lo = 1000; hi = 25000; }
+        else if (kMoog) hi = 31000;
+        else if (!kOnePole) hi = 30000;
+        resonance = res_q15 < lo ? lo : (res_q15 > hi ? hi : res_q15);
+    }
+
+    // BiquadResonant only: bandpass instead of lowpass, from the next update()
+    void setBandpass(bool on) { bandpass = on; }
+
+    // ---- control rate ----
+    // Advance the LFOs by n samples, then recompute every band's coefficients for cutoff
+    // base + shift + LFO
+    void update(int32_t shift_q16, int n)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            lfoPhase[i] += lfoInc[i] * static_cast<uint32_t>(n);
+            int32_t oct = baseQ16[i] + shift_q16;
+            if (lfoInc[i])
+            {
+                // Triangle, Q15 -32768..32767, from the top 16 bits of the phase
+                const int32_t p = static_cast<int32_t>(lfoPhase[i] >> 16);
+                const int32_t tri = (p < 32768) ? (p * 2 - 32768) : (32767 - (p - 32768) * 2);
+                oct += (tri * (lfoDepthQ16 >> 4)) >> 11;
+            }
+            setCoefficients(i, oct);
+        }
+    }
+
+    // ---- audio rate ----
+    // All bands for one sample, mixed
+    inline int16_t process(int16_t x)
+    {
+        int32_t mix = 0;
+        for (int i = 0; i < N; ++i) mix += gain[i] * tick(i, x);
+        return clamp12(mix >> 15);
+    }
+
+    // n samples: each band in turn runs over the whole block with its state in registers,
+    // accumulating into the mix. out may be in
+    inline void processBlock(const int16_t* in, int16_t* out, int n)
+    {
+        constexpr int kChunk = 32;
+        int32_t mix[kChunk];
+        for (int start = 0; start < n; start += kChunk)
+        {
+            const int m = (n - start < kChunk) ? n - start : kChunk;
+            const int16_t* x = in + start;
+            for (int j = 0; j < m; ++j) mix[j] = 0;
+            for (int i = 0; i < N; ++i)
+            {
+                const int32_t g = gain[i];
+                for (int j = 0; j < m; ++j) mix[j] += g * tick(i, x[j]);
+            }
+            for (int j = 0; j < m; ++j) out[start + j] = clamp12(mix[j] >> 15);
+        }
+    }
+
+private:
+    static inline int32_t clamp12(int32_t v) { return v < -2048 ? -2048 : (v > 2047 ? 2047 : v); }
+    static inline int32_t clamp16(int32_t v) { return v < -32768 ? -32768 : (v > 32767 ? 32767 : v); }
+
+    // Coefficients for band i at cutoff oct (Q16 octaves above 20Hz), interpolated from the table
+    inline void setCoefficients(int i, int32_t oct)
+    {
+        if (oct < 0) oct = 0;
+        if (oct >= kMaxOctavesQ16) oct = kMaxOctavesQ16 - 1;
+        const int32_t pos = oct >> 11;      // 32 steps per octave
+        const int32_t frac = oct & 0x7FF;   // Q11
+        const DspTables::CutoffCoeffs& a = DspTables::cutoffCoeffs[pos];
+        const DspTables::CutoffCoeffs& b = DspTables::cutoffCoeffs[pos + 1];
+
+        if (kBiquad)
+        {
+            const int32_t cosw = a.cosw + (((b.cosw - a.cosw) * frac) >> 11);
+            const int32_t sinw = a.sinw + (((b.sinw - a.sinw) * frac) >> 11);
+            // alpha = sin / 2Q; everything divided by a0 = 1 + alpha, through inv = 1 / a0 (Q15).
+            // Coefficients Q14, so that a1 (down to -2) fits
+            const int32_t alpha = (sinw * resonance) >> 16;
+            const int32_t inv = (1 << 30) / (32768 + alpha);
+            c2[i] = -((cosw * inv) >> 15);                   // a1 = -2 cos / a0
+            c3[i] = ((32768 - alpha) * inv) >> 16;           // a2 = (1 - alpha) / a0
+            if (bandpass)
+            {
+                c0[i] = (alpha * inv) >> 16;                 // b0 = alpha / a0, b1 = 0, b2 = -b0
+                c1[i] = 0;
+                c4[i] = -c0[i];
+            }
+            else
+            {
+                c0[i] = ((32768 - cosw) * inv) >> 17;        // b0 = b2 = (1 - cos) / 2a0
+                c1[i] = c0[i] * 2;                           // b1 = (1 - cos) / a0
+                c4[i] = c0[i];
+            }
+            return;
+        }
+
+        int32_t g = a.g + (((b.g - a.g) * frac) >> 11);
+        int32_t lo = 100, hi = 16000;                        // UltraFastResonant
+        if (kOnePole) { lo = 0; hi = 32767; }
+        else if (kMoog) { lo = 50; hi = 8000; }
+        g = g < lo ? lo : (g > hi ? hi : g);
+        c0[i] = g;
+        // UltraFastResonant: y1 * (2 - f - res * f) is worked out as 2 * y1 - y1 * c1, to stay in int32
+        c1[i] = g + ((resonance * g) >> 15);
+    }
+
+    // One sample of band i; states are clamped to 16 bits so that every product fits in int32
+    inline int32_t tick(int i, int32_t x)
+    {
+        if (kOnePole)
+        {
+            // y = x * f + y1 * (1 - f), with delayed feedback for resonance
+            const int32_t fb = (s3[i] * resonance) >> 15;
+            const int32_t xfb = clamp16(x - fb);
+            const int32_t y = s1[i] + (((xfb - s1[i]) * c0[i]) >> 15);
+            s3[i] = s2[i];
+            s2[i] = s1[i];
+            s1[i] = clamp16(y);
+            return clamp12(y);
+        }
+        else if (kBiquad)
+        {
+            // Direct form I: s1, s2 = x[n-1], x[n-2]; s3, s4 = y[n-1], y[n-2]
+            const int32_t acc = c0[i] * x + c1[i] * s1[i] + c4[i] * s2[i] - c2[i] * s3[i] - c3[i] * s4[i];
+            const int32_t y = clamp16(acc >> 14);
+            s2[i] = s1[i];
+            s1[i] = x;
+            s4[i] = s3[i];
+            s3[i] = y;
+            return clamp12(y);
+        }
+        else if (kMoog)
+        {
+            // Four one-pole stages, with feedback from the last
+            const int32_t f = c0[i];
+            const int32_t input = clamp16(x - ((s4[i] * resonance) >> 15));
+            s1[i] += ((input - s1[i]) * f) >> 15;
+            s2[i] += ((s1[i] - s2[i]) * f) >> 15;
+            s3[i] += ((s2[i] - s3[i]) * f) >> 15;
+            s4[i] += ((s3[i] - s4[i]) * f) >> 15;
+            return clamp12(s4[i]);
+        }
+        else
+        {
+            // y = x * f + y1 * (2 - f - res * f) - y2 * (1 - f)
+            const int32_t f = c0[i];
+            const int32_t y = clamp16(((x * f) >> 15) + 2 * s1[i] - ((s1[i] * c1[i]) >> 15)
+                                      - ((s2[i] * (32768 - f)) >> 15));
+            s2[i] = s1[i];
+            s1[i] = y;
+            return clamp12(y);
+        }
+    }
+
+    // Controls
+    int32_t baseQ16[N];
+    uint32_t lfoInc[N];
+    uint32_t lfoPhase[N];
+    int32_t lfoDepthQ16 = 0;
+    int32_t gain[N];
+    int32_t resonance = 0;
+    bool bandpass = false;
+
+    // Coefficients: one-pole/Moog/UltraFast use c0 = f (and UltraFast c1); biquad c0..c4 = b0, b1, a1, a2, b2
+    int32_t c0[N], c1[N], c2[N], c3[N], c4[N];
+    // State, see tick()
+    int32_t s1[N], s2[N], s3[N], s4[N];
+};
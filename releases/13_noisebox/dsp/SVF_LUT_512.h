@@ -1,7 +1,10 @@
 #pragma once
 #include <cstdint>
+#include "DspTables.hpp"
 
-// Auto-generated SVF LUTs: FS=48000, FMIN=20 Hz, FMAX=8000 Hz, F_LUT_SIZE=512
+// SVF LUTs, generated at compile time. The f table is built per sample rate and cutoff range
+// (SvfFLut<FS, FMIN, FMAX>), and only for the rates a build's filters are instantiated at, e.g.
+// FS=96000 for a filter run 2x oversampled at 48 kHz.
 static constexpr int F_LUT_SIZE = 512;
 
 // Resonance constants (q_ch = 1/Q in Q15)
@@ -10,555 +13,76 @@ static constexpr int32_t q_ch_q15_Q6  = 5461;
 static constexpr int32_t q_ch_q15_Q9  = 3641;
 static constexpr int32_t q_ch_q15_Q12 = 2731;
 
-// f coefficient LUT (Q15), size 512
-static constexpr uint16_t F_LUT_512[F_LUT_SIZE] = {
-86, 87, 88, 89, 90, 91, 92, 93, 94, 95, 96, 98, 99, 100, 101, 102,
-103, 105, 106, 107, 108, 110, 111, 112, 114, 115, 116, 118, 119, 121, 122, 123,
-125, 126, 128, 129, 131, 132, 134, 136, 137, 139, 140, 142, 144, 145, 147, 149,
-151, 152, 154, 156, 158, 160, 162, 163, 165, 167, 169, 171, 173, 175, 177, 180,
-182, 184, 186, 188, 190, 193, 195, 197, 200, 202, 204, 207, 209, 212, 214, 217,
-219, 222, 224, 227, 230, 232, 235, 238, 241, 244, 246, 249, 252, 255, 258, 261,
-264, 268, 271, 274, 277, 280, 284, 287, 290, 294, 297, 301, 304, 308, 312, 315,
-319, 323, 327, 330, 334, 338, 342, 346, 350, 354, 359, 363, 367, 371, 376, 380,
-385, 389, 394, 399, 403, 408, 413, 418, 423, 428, 433, 438, 443, 448, 453, 459,
-464, 470, 475, 481, 486, 492, 498, 504, 510, 516, 522, 528, 534, 541, 547, 553,
-560, 567, 573, 580, 587, 594, 601, 608, 615, 622, 630, 637, 645, 652, 660, 668,
-675, 683, 692, 700, 708, 716, 725, 733, 742, 751, 760, 768, 778, 787, 796, 805,
-815, 824, 834, 844, 854, 864, 874, 885, 895, 906, 916, 927, 938, 949, 960, 972,
-983, 995, 1006, 1018, 1030, 1042, 1055, 1067, 1080, 1092, 1105, 1118, 1132, 1145, 1158, 1172,
-1186, 1200, 1214, 1228, 1243, 1257, 1272, 1287, 1302, 1318, 1333, 1349, 1365, 1381, 1397, 1414,
-1430, 1447, 1464, 1482, 1499, 1517, 1535, 1553, 1571, 1590, 1608, 1627, 1647, 1666, 1686, 1706,
-1726, 1746, 1767, 1787, 1808, 1830, 1851, 1873, 1895, 1918, 1940, 1963, 1986, 2010, 2033, 2057,
-2082, 2106, 2131, 2156, 2182, 2207, 2233, 2260, 2286, 2313, 2340, 2368, 2396, 2424, 2453, 2482,
-2511, 2541, 2570, 2601, 2631, 2662, 2694, 2726, 2758, 2790, 2823, 2856, 2890, 2924, 2959, 2993,
-3029, 3064, 3101, 3137, 3174, 3211, 3249, 3288, 3326, 3366, 3405, 3445, 3486, 3527, 3569, 3611,
-3653, 3696, 3740, 3784, 3828, 3873, 3919, 3965, 4012, 4059, 4107, 4155, 4204, 4254, 4304, 4355,
-4406, 4458, 4510, 4563, 4617, 4671, 4726, 4782, 4838, 4895, 4953, 5011, 5070, 5130, 5190, 5251,
-5313, 5376, 5439, 5503, 5568, 5633, 5700, 5767, 5834, 5903, 5972, 6043, 6114, 6186, 6258, 6332,
-6406, 6482, 6558, 6635, 6713, 6792, 6872, 6952, 7034, 7117, 7200, 7285, 7370, 7457, 7545, 7633,
-7723, 7813, 7905, 7998, 8092, 8187, 8283, 8380, 8478, 8578, 8678, 8780, 8883, 8987, 9092, 9199,
-9306, 9415, 9526, 9637, 9750, 9864, 9980, 10096, 10215, 10334, 10455, 10577, 10701, 10826, 10952, 11080,
-11210, 11340, 11473, 11607, 11742, 11879, 12018, 12158, 12299, 12443, 12588, 12734, 12882, 13032, 13184, 13337,
-13492, 13649, 13808, 13968, 14130, 14294, 14460, 14628, 14797, 14969, 15142, 15317, 15494, 15674, 15855, 16038,
-16223, 16411, 16600, 16791, 16985, 17180, 17378, 17578, 17780, 17984, 18191, 18400, 18611, 18824, 19040, 19258,
-19478, 19700, 19925, 20153, 20382, 20615, 20849, 21086, 21326, 21568, 21813, 22060, 22309, 22562, 22816, 23074,
-23334, 23597, 23862, 24130, 24401, 24674, 24950, 25229, 25511, 25795, 26082, 26372, 26665, 26961, 27259, 27560,
-27864, 28171, 28481, 28793, 29109, 29427, 29748, 30072, 30399, 30729, 31062, 31397, 31736, 32077, 32421, 32768
-};
+// Continuous resonance: Q log-spaced from QMIN to QMAX over Q_LUT_SIZE - 1 steps (last entry repeats for interpolation)
+static constexpr int Q_LUT_SIZE = 65;
+static constexpr double SVF_QMIN = 0.7;
+static constexpr double SVF_QMAX = 16.0;
+
+namespace DspTables {
+
+// f coefficient (Q15): f = 2 sin(pi fc / fs), fc log-spaced from FMIN to FMAX
+template <uint32_t FS, uint32_t FMIN, uint32_t FMAX>
+constexpr std::array<uint16_t, F_LUT_SIZE> makeSvfFLut()
+{
+    static_assert(FMIN > 0 && FMIN < FMAX && 2 * FMAX < FS, "SVF cutoff range must be below Nyquist");
+    constexpr double fs = FS, fmin = FMIN, fmax = FMAX;
+    const double logSpan = DspTables::log(fmax / fmin);
+    std::array<uint16_t, F_LUT_SIZE> t{};
+    for (int i = 0; i < F_LUT_SIZE; ++i)
+    {
+        const double fc = fmin * DspTables::exp(logSpan * static_cast<double>(i) / static_cast<double>(F_LUT_SIZE - 1));
+        t[i] = static_cast<uint16_t>(roundToInt(2.0 * DspTables::sin(kPi * fc / fs) * 32768.0));
+    }
+    return t;
+}
+
+} // namespace DspTables
+
+// f coefficient LUT (Q15), size 512, for sample rate FS and cutoffs FMIN to FMAX Hz
+template <uint32_t FS, uint32_t FMIN = 20, uint32_t FMAX = 8000>
+DSP_TABLE_RAM inline constexpr std::array<uint16_t, F_LUT_SIZE> SvfFLut = DspTables::makeSvfFLut<FS, FMIN, FMAX>();
+
+namespace DspTables {
+
+// q_ch = 1/Q (Q15) for resonance r = i / (Q_LUT_SIZE - 2), Q = QMIN * (QMAX / QMIN)^r
+constexpr std::array<int32_t, Q_LUT_SIZE> makeSvfQLut()
+{
+    const double logSpan = DspTables::log(SVF_QMAX / SVF_QMIN);
+    std::array<int32_t, Q_LUT_SIZE> t{};
+    for (int i = 0; i < Q_LUT_SIZE; ++i)
+    {
+        const int j = (i < Q_LUT_SIZE - 1) ? i : Q_LUT_SIZE - 2;
+        const double q = SVF_QMIN * DspTables::exp(logSpan * static_cast<double>(j) / static_cast<double>(Q_LUT_SIZE - 2));
+        t[i] = roundToInt(32768.0 / q);
+    }
+    return t;
+}
+
+} // namespace DspTables
+
+// 1/Q LUT (Q15), read at control rate only, so it stays in flash
+inline constexpr std::array<int32_t, Q_LUT_SIZE> QCH_LUT = DspTables::makeSvfQLut();
 
 // Knob map (0..4095 -> idx, frac) for integer-only interpolation
+// The LUT is already log-spaced, so the knob maps linearly onto its index: pos = knob * 511 / 4095
 struct KnobIdxFrac { uint16_t idx; uint16_t frac; };
-static constexpr KnobIdxFrac KnobMap_512[4096] = {
-{0,0}, {0,8178}, {0,16356}, {0,24534}, {0,32711}, {0,40889}, {0,49067}, {0,57245},
-{0,65423}, {1,8066}, {1,16244}, {1,24422}, {1,32599}, {1,40777}, {1,48955}, {1,57133},
-{1,65311}, {2,7954}, {2,16132}, {2,24310}, {2,32487}, {2,40665}, {2,48843}, {2,57021},
-{2,65199}, {3,7842}, {3,16020}, {3,24198}, {3,32375}, {3,40553}, {3,48731}, {3,56909},
-{3,65087}, {4,7730}, {4,15908}, {4,24086}, {4,32263}, {4,40441}, {4,48619}, {4,56797},
-{4,64975}, {5,7618}, {5,15796}, {5,23973}, {5,32151}, {5,40329}, {5,48507}, {5,56685},
-{5,64863}, {6,7506}, {6,15684}, {6,23861}, {6,32039}, {6,40217}, {6,48395}, {6,56573},
-{6,64751}, {7,7394}, {7,15572}, {7,23749}, {7,31927}, {7,40105}, {7,48283}, {7,56461},
-{7,64639}, {8,7282}, {8,15460}, {8,23637}, {8,31815}, {8,39993}, {8,48171}, {8,56349},
-{8,64527}, {9,7170}, {9,15348}, {9,23525}, {9,31703}, {9,39881}, {9,48059}, {9,56237},
-{9,64415}, {10,7058}, {10,15235}, {10,23413}, {10,31591}, {10,39769}, {10,47947}, {10,56125},
-{10,64303}, {11,6946}, {11,15123}, {11,23301}, {11,31479}, {11,39657}, {11,47835}, {11,56013},
-{11,64191}, {12,6834}, {12,15011}, {12,23189}, {12,31367}, {12,39545}, {12,47723}, {12,55901},
-{12,64079}, {13,6722}, {13,14899}, {13,23077}, {13,31255}, {13,39433}, {13,47611}, {13,55789},
-{13,63967}, {14,6610}, {14,14787}, {14,22965}, {14,31143}, {14,39321}, {14,47499}, {14,55677},
-{14,63855}, {15,6497}, {15,14675}, {15,22853}, {15,31031}, {15,39209}, {15,47387}, {15,55565},
-{15,63743}, {16,6385}, {16,14563}, {16,22741}, {16,30919}, {16,39097}, {16,47275}, {16,55453},
-{16,63631}, {17,6273}, {17,14451}, {17,22629}, {17,30807}, {17,38985}, {17,47163}, {17,55341},
-{17,63519}, {18,6161}, {18,14339}, {18,22517}, {18,30695}, {18,38873}, {18,47051}, {18,55229},
-{18,63407}, {19,6049}, {19,14227}, {19,22405}, {19,30583}, {19,38761}, {19,46939}, {19,55117},
-{19,63294}, {20,5937}, {20,14115}, {20,22293}, {20,30471}, {20,38649}, {20,46827}, {20,55005},
-{20,63182}, {21,5825}, {21,14003}, {21,22181}, {21,30359}, {21,38537}, {21,46715}, {21,54893},
-{21,63070}, {22,5713}, {22,13891}, {22,22069}, {22,30247}, {22,38425}, {22,46603}, {22,54781},
-{22,62958}, {23,5601}, {23,13779}, {23,21957}, {23,30135}, {23,38313}, {23,46491}, {23,54669},
-{23,62846}, {24,5489}, {24,13667}, {24,21845}, {24,30023}, {24,38201}, {24,46379}, {24,54556},
-{24,62734}, {25,5377}, {25,13555}, {25,21733}, {25,29911}, {25,38089}, {25,46267}, {25,54444},
-{25,62622}, {26,5265}, {26,13443}, {26,21621}, {26,29799}, {26,37977}, {26,46155}, {26,54332},
-{26,62510}, {27,5153}, {27,13331}, {27,21509}, {27,29687}, {27,37865}, {27,46043}, {27,54220},
-{27,62398}, {28,5041}, {28,13219}, {28,21397}, {28,29575}, {28,37753}, {28,45931}, {28,54108},
-{28,62286}, {29,4929}, {29,13107}, {29,21285}, {29,29463}, {29,37641}, {29,45818}, {29,53996},
-{29,62174}, {30,4817}, {30,12995}, {30,21173}, {30,29351}, {30,37529}, {30,45706}, {30,53884},
-{30,62062}, {31,4705}, {31,12883}, {31,21061}, {31,29239}, {31,37417}, {31,45594}, {31,53772},
-{31,61950}, {32,4593}, {32,12771}, {32,20949}, {32,29127}, {32,37305}, {32,45482}, {32,53660},
-{32,61838}, {33,4481}, {33,12659}, {33,20837}, {33,29015}, {33,37193}, {33,45370}, {33,53548},
-{33,61726}, {34,4369}, {34,12547}, {34,20725}, {34,28903}, {34,37080}, {34,45258}, {34,53436},
-{34,61614}, {35,4257}, {35,12435}, {35,20613}, {35,28791}, {35,36968}, {35,45146}, {35,53324},
-{35,61502}, {36,4145}, {36,12323}, {36,20501}, {36,28679}, {36,36856}, {36,45034}, {36,53212},
-{36,61390}, {37,4033}, {37,12211}, {37,20389}, {37,28567}, {37,36744}, {37,44922}, {37,53100},
-{37,61278}, {38,3921}, {38,12099}, {38,20277}, {38,28455}, {38,36632}, {38,44810}, {38,52988},
-{38,61166}, {39,3809}, {39,11987}, {39,20165}, {39,28342}, {39,36520}, {39,44698}, {39,52876},
-{39,61054}, {40,3697}, {40,11875}, {40,20053}, {40,28230}, {40,36408}, {40,44586}, {40,52764},
-{40,60942}, {41,3585}, {41,11763}, {41,19941}, {41,28118}, {41,36296}, {41,44474}, {41,52652},
-{41,60830}, {42,3473}, {42,11651}, {42,19829}, {42,28006}, {42,36184}, {42,44362}, {42,52540},
-{42,60718}, {43,3361}, {43,11539}, {43,19717}, {43,27894}, {43,36072}, {43,44250}, {43,52428},
-{43,60606}, {44,3249}, {44,11427}, {44,19604}, {44,27782}, {44,35960}, {44,44138}, {44,52316},
-{44,60494}, {45,3137}, {45,11315}, {45,19492}, {45,27670}, {45,35848}, {45,44026}, {45,52204},
-{45,60382}, {46,3025}, {46,11203}, {46,19380}, {46,27558}, {46,35736}, {46,43914}, {46,52092},
-{46,60270}, {47,2913}, {47,11091}, {47,19268}, {47,27446}, {47,35624}, {47,43802}, {47,51980},
-{47,60158}, {48,2801}, {48,10979}, {48,19156}, {48,27334}, {48,35512}, {48,43690}, {48,51868},
-{48,60046}, {49,2689}, {49,10866}, {49,19044}, {49,27222}, {49,35400}, {49,43578}, {49,51756},
-{49,59934}, {50,2577}, {50,10754}, {50,18932}, {50,27110}, {50,35288}, {50,43466}, {50,51644},
-{50,59822}, {51,2465}, {51,10642}, {51,18820}, {51,26998}, {51,35176}, {51,43354}, {51,51532},
-{51,59710}, {52,2353}, {52,10530}, {52,18708}, {52,26886}, {52,35064}, {52,43242}, {52,51420},
-{52,59598}, {53,2241}, {53,10418}, {53,18596}, {53,26774}, {53,34952}, {53,43130}, {53,51308},
-{53,59486}, {54,2128}, {54,10306}, {54,18484}, {54,26662}, {54,34840}, {54,43018}, {54,51196},
-{54,59374}, {55,2016}, {55,10194}, {55,18372}, {55,26550}, {55,34728}, {55,42906}, {55,51084},
-{55,59262}, {56,1904}, {56,10082}, {56,18260}, {56,26438}, {56,34616}, {56,42794}, {56,50972},
-{56,59150}, {57,1792}, {57,9970}, {57,18148}, {57,26326}, {57,34504}, {57,42682}, {57,50860},
-{57,59038}, {58,1680}, {58,9858}, {58,18036}, {58,26214}, {58,34392}, {58,42570}, {58,50748},
-{58,58925}, {59,1568}, {59,9746}, {59,17924}, {59,26102}, {59,34280}, {59,42458}, {59,50636},
-{59,58813}, {60,1456}, {60,9634}, {60,17812}, {60,25990}, {60,34168}, {60,42346}, {60,50524},
-{60,58701}, {61,1344}, {61,9522}, {61,17700}, {61,25878}, {61,34056}, {61,42234}, {61,50412},
-{61,58589}, {62,1232}, {62,9410}, {62,17588}, {62,25766}, {62,33944}, {62,42122}, {62,50300},
-{62,58477}, {63,1120}, {63,9298}, {63,17476}, {63,25654}, {63,33832}, {63,42010}, {63,50187},
-{63,58365}, {64,1008}, {64,9186}, {64,17364}, {64,25542}, {64,33720}, {64,41898}, {64,50075},
-{64,58253}, {65,896}, {65,9074}, {65,17252}, {65,25430}, {65,33608}, {65,41786}, {65,49963},
-{65,58141}, {66,784}, {66,8962}, {66,17140}, {66,25318}, {66,33496}, {66,41674}, {66,49851},
-{66,58029}, {67,672}, {67,8850}, {67,17028}, {67,25206}, {67,33384}, {67,41562}, {67,49739},
-{67,57917}, {68,560}, {68,8738}, {68,16916}, {68,25094}, {68,33272}, {68,41449}, {68,49627},
-{68,57805}, {69,448}, {69,8626}, {69,16804}, {69,24982}, {69,33160}, {69,41337}, {69,49515},
-{69,57693}, {70,336}, {70,8514}, {70,16692}, {70,24870}, {70,33048}, {70,41225}, {70,49403},
-{70,57581}, {71,224}, {71,8402}, {71,16580}, {71,24758}, {71,32936}, {71,41113}, {71,49291},
-{71,57469}, {72,112}, {72,8290}, {72,16468}, {72,24646}, {72,32824}, {72,41001}, {72,49179},
-{72,57357}, {73,0}, {73,8178}, {73,16356}, {73,24534}, {73,32711}, {73,40889}, {73,49067},
-{73,57245}, {73,65423}, {74,8066}, {74,16244}, {74,24422}, {74,32599}, {74,40777}, {74,48955},
-{74,57133}, {74,65311}, {75,7954}, {75,16132}, {75,24310}, {75,32487}, {75,40665}, {75,48843},
-{75,57021}, {75,65199}, {76,7842}, {76,16020}, {76,24198}, {76,32375}, {76,40553}, {76,48731},
-{76,56909}, {76,65087}, {77,7730}, {77,15908}, {77,24086}, {77,32263}, {77,40441}, {77,48619},
-{77,56797}, {77,64975}, {78,7618}, {78,15796}, {78,23973}, {78,32151}, {78,40329}, {78,48507},
-{78,56685}, {78,64863}, {79,7506}, {79,15684}, {79,23861}, {79,32039}, {79,40217}, {79,48395},
-{79,56573}, {79,64751}, {80,7394}, {80,15572}, {80,23749}, {80,31927}, {80,40105}, {80,48283},
-{80,56461}, {80,64639}, {81,7282}, {81,15460}, {81,23637}, {81,31815}, {81,39993}, {81,48171},
-{81,56349}, {81,64527}, {82,7170}, {82,15348}, {82,23525}, {82,31703}, {82,39881}, {82,48059},
-{82,56237}, {82,64415}, {83,7058}, {83,15235}, {83,23413}, {83,31591}, {83,39769}, {83,47947},
-{83,56125}, {83,64303}, {84,6946}, {84,15123}, {84,23301}, {84,31479}, {84,39657}, {84,47835},
-{84,56013}, {84,64191}, {85,6834}, {85,15011}, {85,23189}, {85,31367}, {85,39545}, {85,47723},
-{85,55901}, {85,64079}, {86,6722}, {86,14899}, {86,23077}, {86,31255}, {86,39433}, {86,47611},
-{86,55789}, {86,63967}, {87,6610}, {87,14787}, {87,22965}, {87,31143}, {87,39321}, {87,47499},
-{87,55677}, {87,63855}, {88,6497}, {88,14675}, {88,22853}, {88,31031}, {88,39209}, {88,47387},
-{88,55565}, {88,63743}, {89,6385}, {89,14563}, {89,22741}, {89,30919}, {89,39097}, {89,47275},
-{89,55453}, {89,63631}, {90,6273}, {90,14451}, {90,22629}, {90,30807}, {90,38985}, {90,47163},
-{90,55341}, {90,63519}, {91,6161}, {91,14339}, {91,22517}, {91,30695}, {91,38873}, {91,47051},
-{91,55229}, {91,63407}, {92,6049}, {92,14227}, {92,22405}, {92,30583}, {92,38761}, {92,46939},
-{92,55117}, {92,63294}, {93,5937}, {93,14115}, {93,22293}, {93,30471}, {93,38649}, {93,46827},
-{93,55005}, {93,63182}, {94,5825}, {94,14003}, {94,22181}, {94,30359}, {94,38537}, {94,46715},
-{94,54893}, {94,63070}, {95,5713}, {95,13891}, {95,22069}, {95,30247}, {95,38425}, {95,46603},
-{95,54781}, {95,62958}, {96,5601}, {96,13779}, {96,21957}, {96,30135}, {96,38313}, {96,46491},
-{96,54669}, {96,62846}, {97,5489}, {97,13667}, {97,21845}, {97,30023}, {97,38201}, {97,46379},
-{97,54556}, {97,62734}, {98,5377}, {98,13555}, {98,21733}, {98,29911}, {98,38089}, {98,46267},
-{98,54444}, {98,62622}, {99,5265}, {99,13443}, {99,21621}, {99,29799}, {99,37977}, {99,46155},
-{99,54332}, {99,62510}, {100,5153}, {100,13331}, {100,21509}, {100,29687}, {100,37865}, {100,46043},
-{100,54220}, {100,62398}, {101,5041}, {101,13219}, {101,21397}, {101,29575}, {101,37753}, {101,45931},
-{101,54108}, {101,62286}, {102,4929}, {102,13107}, {102,21285}, {102,29463}, {102,37641}, {102,45818},
-{102,53996}, {102,62174}, {103,4817}, {103,12995}, {103,21173}, {103,29351}, {103,37529}, {103,45706},
-{103,53884}, {103,62062}, {104,4705}, {104,12883}, {104,21061}, {104,29239}, {104,37417}, {104,45594},
-{104,53772}, {104,61950}, {105,4593}, {105,12771}, {105,20949}, {105,29127}, {105,37305}, {105,45482},
-{105,53660}, {105,61838}, {106,4481}, {106,12659}, {106,20837}, {106,29015}, {106,37193}, {106,45370},
-{106,53548}, {106,61726}, {107,4369}, {107,12547}, {107,20725}, {107,28903}, {107,37080}, {107,45258},
-{107,53436}, {107,61614}, {108,4257}, {108,12435}, {108,20613}, {108,28791}, {108,36968}, {108,45146},
-{108,53324}, {108,61502}, {109,4145}, {109,12323}, {109,20501}, {109,28679}, {109,36856}, {109,45034},
-{109,53212}, {109,61390}, {110,4033}, {110,12211}, {110,20389}, {110,28567}, {110,36744}, {110,44922},
-{110,53100}, {110,61278}, {111,3921}, {111,12099}, {111,20277}, {111,28455}, {111,36632}, {111,44810},
-{111,52988}, {111,61166}, {112,3809}, {112,11987}, {112,20165}, {112,28342}, {112,36520}, {112,44698},
-{112,52876}, {112,61054}, {113,3697}, {113,11875}, {113,20053}, {113,28230}, {113,36408}, {113,44586},
-{113,52764}, {113,60942}, {114,3585}, {114,11763}, {114,19941}, {114,28118}, {114,36296}, {114,44474},
-{114,52652}, {114,60830}, {115,3473}, {115,11651}, {115,19829}, {115,28006}, {115,36184}, {115,44362},
-{115,52540}, {115,60718}, {116,3361}, {116,11539}, {116,19717}, {116,27894}, {116,36072}, {116,44250},
-{116,52428}, {116,60606}, {117,3249}, {117,11427}, {117,19604}, {117,27782}, {117,35960}, {117,44138},
-{117,52316}, {117,60494}, {118,3137}, {118,11315}, {118,19492}, {118,27670}, {118,35848}, {118,44026},
-{118,52204}, {118,60382}, {119,3025}, {119,11203}, {119,19380}, {119,27558}, {119,35736}, {119,43914},
-{119,52092}, {119,60270}, {120,2913}, {120,11091}, {120,19268}, {120,27446}, {120,35624}, {120,43802},
-{120,51980}, {120,60158}, {121,2801}, {121,10979}, {121,19156}, {121,27334}, {121,35512}, {121,43690},
-{121,51868}, {121,60046}, {122,2689}, {122,10866}, {122,19044}, {122,27222}, {122,35400}, {122,43578},
-{122,51756}, {122,59934}, {123,2577}, {123,10754}, {123,18932}, {123,27110}, {123,35288}, {123,43466},
-{123,51644}, {123,59822}, {124,2465}, {124,10642}, {124,18820}, {124,26998}, {124,35176}, {124,43354},
-{124,51532}, {124,59710}, {125,2353}, {125,10530}, {125,18708}, {125,26886}, {125,35064}, {125,43242},
-{125,51420}, {125,59598}, {126,2241}, {126,10418}, {126,18596}, {126,26774}, {126,34952}, {126,43130},
-{126,51308}, {126,59486}, {127,2128}, {127,10306}, {127,18484}, {127,26662}, {127,34840}, {127,43018},
-{127,51196}, {127,59374}, {128,2016}, {128,10194}, {128,18372}, {128,26550}, {128,34728}, {128,42906},
-{128,51084}, {128,59262}, {129,1904}, {129,10082}, {129,18260}, {129,26438}, {129,34616}, {129,42794},
-{129,50972}, {129,59150}, {130,1792}, {130,9970}, {130,18148}, {130,26326}, {130,34504}, {130,42682},
-{130,50860}, {130,59038}, {131,1680}, {131,9858}, {131,18036}, {131,26214}, {131,34392}, {131,42570},
-{131,50748}, {131,58925}, {132,1568}, {132,9746}, {132,17924}, {132,26102}, {132,34280}, {132,42458},
-{132,50636}, {132,58813}, {133,1456}, {133,9634}, {133,17812}, {133,25990}, {133,34168}, {133,42346},
-{133,50524}, {133,58701}, {134,1344}, {134,9522}, {134,17700}, {134,25878}, {134,34056}, {134,42234},
-{134,50412}, {134,58589}, {135,1232}, {135,9410}, {135,17588}, {135,25766}, {135,33944}, {135,42122},
-{135,50300}, {135,58477}, {136,1120}, {136,9298}, {136,17476}, {136,25654}, {136,33832}, {136,42010},
-{136,50187}, {136,58365}, {137,1008}, {137,9186}, {137,17364}, {137,25542}, {137,33720}, {137,41898},
-{137,50075}, {137,58253}, {138,896}, {138,9074}, {138,17252}, {138,25430}, {138,33608}, {138,41786},
-{138,49963}, {138,58141}, {139,784}, {139,8962}, {139,17140}, {139,25318}, {139,33496}, {139,41674},
-{139,49851}, {139,58029}, {140,672}, {140,8850}, {140,17028}, {140,25206}, {140,33384}, {140,41562},
-{140,49739}, {140,57917}, {141,560}, {141,8738}, {141,16916}, {141,25094}, {141,33272}, {141,41449},
-{141,49627}, {141,57805}, {142,448}, {142,8626}, {142,16804}, {142,24982}, {142,33160}, {142,41337},
-{142,49515}, {142,57693}, {143,336}, {143,8514}, {143,16692}, {143,24870}, {143,33048}, {143,41225},
-{143,49403}, {143,57581}, {144,224}, {144,8402}, {144,16580}, {144,24758}, {144,32936}, {144,41113},
-{144,49291}, {144,57469}, {145,112}, {145,8290}, {145,16468}, {145,24646}, {145,32824}, {145,41001},
-{145,49179}, {145,57357}, {146,0}, {146,8178}, {146,16356}, {146,24534}, {146,32711}, {146,40889},
-{146,49067}, {146,57245}, {146,65423}, {147,8066}, {147,16244}, {147,24422}, {147,32599}, {147,40777},
-{147,48955}, {147,57133}, {147,65311}, {148,7954}, {148,16132}, {148,24310}, {148,32487}, {148,40665},
-{148,48843}, {148,57021}, {148,65199}, {149,7842}, {149,16020}, {149,24198}, {149,32375}, {149,40553},
-{149,48731}, {149,56909}, {149,65087}, {150,7730}, {150,15908}, {150,24086}, {150,32263}, {150,40441},
-{150,48619}, {150,56797}, {150,64975}, {151,7618}, {151,15796}, {151,23973}, {151,32151}, {151,40329},
-{151,48507}, {151,56685}, {151,64863}, {152,7506}, {152,15684}, {152,23861}, {152,32039}, {152,40217},
-{152,48395}, {152,56573}, {152,64751}, {153,7394}, {153,15572}, {153,23749}, {153,31927}, {153,40105},
-{153,48283}, {153,56461}, {153,64639}, {154,7282}, {154,15460}, {154,23637}, {154,31815}, {154,39993},
-{154,48171}, {154,56349}, {154,64527}, {155,7170}, {155,15348}, {155,23525}, {155,31703}, {155,39881},
-{155,48059}, {155,56237}, {155,64415}, {156,7058}, {156,15235}, {156,23413}, {156,31591}, {156,39769},
-{156,47947}, {156,56125}, {156,64303}, {157,6946}, {157,15123}, {157,23301}, {157,31479}, {157,39657},
-{157,47835}, {157,56013}, {157,64191}, {158,6834}, {158,15011}, {158,23189}, {158,31367}, {158,39545},
-{158,47723}, {158,55901}, {158,64079}, {159,6722}, {159,14899}, {159,23077}, {159,31255}, {159,39433},
-{159,47611}, {159,55789}, {159,63967}, {160,6610}, {160,14787}, {160,22965}, {160,31143}, {160,39321},
-{160,47499}, {160,55677}, {160,63855}, {161,6497}, {161,14675}, {161,22853}, {161,31031}, {161,39209},
-{161,47387}, {161,55565}, {161,63743}, {162,6385}, {162,14563}, {162,22741}, {162,30919}, {162,39097},
-{162,47275}, {162,55453}, {162,63631}, {163,6273}, {163,14451}, {163,22629}, {163,30807}, {163,38985},
-{163,47163}, {163,55341}, {163,63519}, {164,6161}, {164,14339}, {164,22517}, {164,30695}, {164,38873},
-{164,47051}, {164,55229}, {164,63407}, {165,6049}, {165,14227}, {165,22405}, {165,30583}, {165,38761},
-{165,46939}, {165,55117}, {165,63294}, {166,5937}, {166,14115}, {166,22293}, {166,30471}, {166,38649},
-{166,46827}, {166,55005}, {166,63182}, {167,5825}, {167,14003}, {167,22181}, {167,30359}, {167,38537},
-{167,46715}, {167,54893}, {167,63070}, {168,5713}, {168,13891}, {168,22069}, {168,30247}, {168,38425},
-{168,46603}, {168,54781}, {168,62958}, {169,5601}, {169,13779}, {169,21957}, {169,30135}, {169,38313},
-{169,46491}, {169,54669}, {169,62846}, {170,5489}, {170,13667}, {170,21845}, {170,30023}, {170,38201},
-{170,46379}, {170,54556}, {170,62734}, {171,5377}, {171,13555}, {171,21733}, {171,29911}, {171,38089},
-{171,46267}, {171,54444}, {171,62622}, {172,5265}, {172,13443}, {172,21621}, {172,29799}, {172,37977},
-{172,46155}, {172,54332}, {172,62510}, {173,5153}, {173,13331}, {173,21509}, {173,29687}, {173,37865},
-{173,46043}, {173,54220}, {173,62398}, {174,5041}, {174,13219}, {174,21397}, {174,29575}, {174,37753},
-{174,45931}, {174,54108}, {174,62286}, {175,4929}, {175,13107}, {175,21285}, {175,29463}, {175,37641},
-{175,45818}, {175,53996}, {175,62174}, {176,4817}, {176,12995}, {176,21173}, {176,29351}, {176,37529},
-{176,45706}, {176,53884}, {176,62062}, {177,4705}, {177,12883}, {177,21061}, {177,29239}, {177,37417},
-{177,45594}, {177,53772}, {177,61950}, {178,4593}, {178,12771}, {178,20949}, {178,29127}, {178,37305},
-{178,45482}, {178,53660}, {178,61838}, {179,4481}, {179,12659}, {179,20837}, {179,29015}, {179,37193},
-{179,45370}, {179,53548}, {179,61726}, {180,4369}, {180,12547}, {180,20725}, {180,28903}, {180,37080},
-{180,45258}, {180,53436}, {180,61614}, {181,4257}, {181,12435}, {181,20613}, {181,28791}, {181,36968},
-{181,45146}, {181,53324}, {181,61502}, {182,4145}, {182,12323}, {182,20501}, {182,28679}, {182,36856},
-{182,45034}, {182,53212}, {182,61390}, {183,4033}, {183,12211}, {183,20389}, {183,28567}, {183,36744},
-{183,44922}, {183,53100}, {183,61278}, {184,3921}, {184,12099}, {184,20277}, {184,28455}, {184,36632},
-{184,44810}, {184,52988}, {184,61166}, {185,3809}, {185,11987}, {185,20165}, {185,28342}, {185,36520},
-{185,44698}, {185,52876}, {185,61054}, {186,3697}, {186,11875}, {186,20053}, {186,28230}, {186,36408},
-{186,44586}, {186,52764}, {186,60942}, {187,3585}, {187,11763}, {187,19941}, {187,28118}, {187,36296},
-{187,44474}, {187,52652}, {187,60830}, {188,3473}, {188,11651}, {188,19829}, {188,28006}, {188,36184},
-{188,44362}, {188,52540}, {188,60718}, {189,3361}, {189,11539}, {189,19717}, {189,27894}, {189,36072},
-{189,44250}, {189,52428}, {189,60606}, {190,3249}, {190,11427}, {190,19604}, {190,27782}, {190,35960},
-{190,44138}, {190,52316}, {190,60494}, {191,3137}, {191,11315}, {191,19492}, {191,27670}, {191,35848},
-{191,44026}, {191,52204}, {191,60382}, {192,3025}, {192,11203}, {192,19380}, {192,27558}, {192,35736},
-{192,43914}, {192,52092}, {192,60270}, {193,2913}, {193,11091}, {193,19268}, {193,27446}, {193,35624},
-{193,43802}, {193,51980}, {193,60158}, {194,2801}, {194,10979}, {194,19156}, {194,27334}, {194,35512},
-{194,43690}, {194,51868}, {194,60046}, {195,2689}, {195,10866}, {195,19044}, {195,27222}, {195,35400},
-{195,43578}, {195,51756}, {195,59934}, {196,2577}, {196,10754}, {196,18932}, {196,27110}, {196,35288},
-{196,43466}, {196,51644}, {196,59822}, {197,2465}, {197,10642}, {197,18820}, {197,26998}, {197,35176},
-{197,43354}, {197,51532}, {197,59710}, {198,2353}, {198,10530}, {198,18708}, {198,26886}, {198,35064},
-{198,43242}, {198,51420}, {198,59598}, {199,2241}, {199,10418}, {199,18596}, {199,26774}, {199,34952},
-{199,43130}, {199,51308}, {199,59486}, {200,2128}, {200,10306}, {200,18484}, {200,26662}, {200,34840},
-{200,43018}, {200,51196}, {200,59374}, {201,2016}, {201,10194}, {201,18372}, {201,26550}, {201,34728},
-{201,42906}, {201,51084}, {201,59262}, {202,1904}, {202,10082}, {202,18260}, {202,26438}, {202,34616},
-{202,42794}, {202,50972}, {202,59150}, {203,1792}, {203,9970}, {203,18148}, {203,26326}, {203,34504},
-{203,42682}, {203,50860}, {203,59038}, {204,1680}, {204,9858}, {204,18036}, {204,26214}, {204,34392},
-{204,42570}, {204,50748}, {204,58925}, {205,1568}, {205,9746}, {205,17924}, {205,26102}, {205,34280},
-{205,42458}, {205,50636}, {205,58813}, {206,1456}, {206,9634}, {206,17812}, {206,25990}, {206,34168},
-{206,42346}, {206,50524}, {206,58701}, {207,1344}, {207,9522}, {207,17700}, {207,25878}, {207,34056},
-{207,42234}, {207,50412}, {207,58589}, {208,1232}, {208,9410}, {208,17588}, {208,25766}, {208,33944},
-{208,42122}, {208,50300}, {208,58477}, {209,1120}, {209,9298}, {209,17476}, {209,25654}, {209,33832},
-{209,42010}, {209,50187}, {209,58365}, {210,1008}, {210,9186}, {210,17364}, {210,25542}, {210,33720},
-{210,41898}, {210,50075}, {210,58253}, {211,896}, {211,9074}, {211,17252}, {211,25430}, {211,33608},
-{211,41786}, {211,49963}, {211,58141}, {212,784}, {212,8962}, {212,17140}, {212,25318}, {212,33496},
-{212,41674}, {212,49851}, {212,58029}, {213,672}, {213,8850}, {213,17028}, {213,25206}, {213,33384},
-{213,41562}, {213,49739}, {213,57917}, {214,560}, {214,8738}, {214,16916}, {214,25094}, {214,33272},
-{214,41449}, {214,49627}, {214,57805}, {215,448}, {215,8626}, {215,16804}, {215,24982}, {215,33160},
-{215,41337}, {215,49515}, {215,57693}, {216,336}, {216,8514}, {216,16692}, {216,24870}, {216,33048},
-{216,41225}, {216,49403}, {216,57581}, {217,224}, {217,8402}, {217,16580}, {217,24758}, {217,32936},
-{217,41113}, {217,49291}, {217,57469}, {218,112}, {218,8290}, {218,16468}, {218,24646}, {218,32824},
-{218,41001}, {218,49179}, {218,57357}, {219,0}, {219,8178}, {219,16356}, {219,24534}, {219,32711},
-{219,40889}, {219,49067}, {219,57245}, {219,65423}, {220,8066}, {220,16244}, {220,24422}, {220,32599},
-{220,40777}, {220,48955}, {220,57133}, {220,65311}, {221,7954}, {221,16132}, {221,24310}, {221,32487},
-{221,40665}, {221,48843}, {221,57021}, {221,65199}, {222,7842}, {222,16020}, {222,24198}, {222,32375},
-{222,40553}, {222,48731}, {222,56909}, {222,65087}, {223,7730}, {223,15908}, {223,24086}, {223,32263},
-{223,40441}, {223,48619}, {223,56797}, {223,64975}, {224,7618}, {224,15796}, {224,23973}, {224,32151},
-{224,40329}, {224,48507}, {224,56685}, {224,64863}, {225,7506}, {225,15684}, {225,23861}, {225,32039},
-{225,40217}, {225,48395}, {225,56573}, {225,64751}, {226,7394}, {226,15572}, {226,23749}, {226,31927},
-{226,40105}, {226,48283}, {226,56461}, {226,64639}, {227,7282}, {227,15460}, {227,23637}, {227,31815},
-{227,39993}, {227,48171}, {227,56349}, {227,64527}, {228,7170}, {228,15348}, {228,23525}, {228,31703},
-{228,39881}, {228,48059}, {228,56237}, {228,64415}, {229,7058}, {229,15235}, {229,23413}, {229,31591},
-{229,39769}, {229,47947}, {229,56125}, {229,64303}, {230,6946}, {230,15123}, {230,23301}, {230,31479},
-{230,39657}, {230,47835}, {230,56013}, {230,64191}, {231,6834}, {231,15011}, {231,23189}, {231,31367},
-{231,39545}, {231,47723}, {231,55901}, {231,64079}, {232,6722}, {232,14899}, {232,23077}, {232,31255},
-{232,39433}, {232,47611}, {232,55789}, {232,63967}, {233,6610}, {233,14787}, {233,22965}, {233,31143},
-{233,39321}, {233,47499}, {233,55677}, {233,63855}, {234,6497}, {234,14675}, {234,22853}, {234,31031},
-{234,39209}, {234,47387}, {234,55565}, {234,63743}, {235,6385}, {235,14563}, {235,22741}, {235,30919},
-{235,39097}, {235,47275}, {235,55453}, {235,63631}, {236,6273}, {236,14451}, {236,22629}, {236,30807},
-{236,38985}, {236,47163}, {236,55341}, {236,63519}, {237,6161}, {237,14339}, {237,22517}, {237,30695},
-{237,38873}, {237,47051}, {237,55229}, {237,63407}, {238,6049}, {238,14227}, {238,22405}, {238,30583},
-{238,38761}, {238,46939}, {238,55117}, {238,63294}, {239,5937}, {239,14115}, {239,22293}, {239,30471},
-{239,38649}, {239,46827}, {239,55005}, {239,63182}, {240,5825}, {240,14003}, {240,22181}, {240,30359},
-{240,38537}, {240,46715}, {240,54893}, {240,63070}, {241,5713}, {241,13891}, {241,22069}, {241,30247},
-{241,38425}, {241,46603}, {241,54781}, {241,62958}, {242,5601}, {242,13779}, {242,21957}, {242,30135},
-{242,38313}, {242,46491}, {242,54669}, {242,62846}, {243,5489}, {243,13667}, {243,21845}, {243,30023},
-{243,38201}, {243,46379}, {243,54556}, {243,62734}, {244,5377}, {244,13555}, {244,21733}, {244,29911},
-{244,38089}, {244,46267}, {244,54444}, {244,62622}, {245,5265}, {245,13443}, {245,21621}, {245,29799},
-{245,37977}, {245,46155}, {245,54332}, {245,62510}, {246,5153}, {246,13331}, {246,21509}, {246,29687},
-{246,37865}, {246,46043}, {246,54220}, {246,62398}, {247,5041}, {247,13219}, {247,21397}, {247,29575},
-{247,37753}, {247,45931}, {247,54108}, {247,62286}, {248,4929}, {248,13107}, {248,21285}, {248,29463},
-{248,37641}, {248,45818}, {248,53996}, {248,62174}, {249,4817}, {249,12995}, {249,21173}, {249,29351},
-{249,37529}, {249,45706}, {249,53884}, {249,62062}, {250,4705}, {250,12883}, {250,21061}, {250,29239},
-{250,37417}, {250,45594}, {250,53772}, {250,61950}, {251,4593}, {251,12771}, {251,20949}, {251,29127},
-{251,37305}, {251,45482}, {251,53660}, {251,61838}, {252,4481}, {252,12659}, {252,20837}, {252,29015},
-{252,37193}, {252,45370}, {252,53548}, {252,61726}, {253,4369}, {253,12547}, {253,20725}, {253,28903},
-{253,37080}, {253,45258}, {253,53436}, {253,61614}, {254,4257}, {254,12435}, {254,20613}, {254,28791},
-{254,36968}, {254,45146}, {254,53324}, {254,61502}, {255,4145}, {255,12323}, {255,20501}, {255,28679},
-{255,36856}, {255,45034}, {255,53212}, {255,61390}, {256,4033}, {256,12211}, {256,20389}, {256,28567},
-{256,36744}, {256,44922}, {256,53100}, {256,61278}, {257,3921}, {257,12099}, {257,20277}, {257,28455},
-{257,36632}, {257,44810}, {257,52988}, {257,61166}, {258,3809}, {258,11987}, {258,20165}, {258,28342},
-{258,36520}, {258,44698}, {258,52876}, {258,61054}, {259,3697}, {259,11875}, {259,20053}, {259,28230},
-{259,36408}, {259,44586}, {259,52764}, {259,60942}, {260,3585}, {260,11763}, {260,19941}, {260,28118},
-{260,36296}, {260,44474}, {260,52652}, {260,60830}, {261,3473}, {261,11651}, {261,19829}, {261,28006},
-{261,36184}, {261,44362}, {261,52540}, {261,60718}, {262,3361}, {262,11539}, {262,19717}, {262,27894},
-{262,36072}, {262,44250}, {262,52428}, {262,60606}, {263,3249}, {263,11427}, {263,19604}, {263,27782},
-{263,35960}, {263,44138}, {263,52316}, {263,60494}, {264,3137}, {264,11315}, {264,19492}, {264,27670},
-{264,35848}, {264,44026}, {264,52204}, {264,60382}, {265,3025}, {265,11203}, {265,19380}, {265,27558},
-{265,35736}, {265,43914}, {265,52092}, {265,60270}, {266,2913}, {266,11091}, {266,19268}, {266,27446},
-{266,35624}, {266,43802}, {266,51980}, {266,60158}, {267,2801}, {267,10979}, {267,19156}, {267,27334},
-{267,35512}, {267,43690}, {267,51868}, {267,60046}, {268,2689}, {268,10866}, {268,19044}, {268,27222},
-{268,35400}, {268,43578}, {268,51756}, {268,59934}, {269,2577}, {269,10754}, {269,18932}, {269,27110},
-{269,35288}, {269,43466}, {269,51644}, {269,59822}, {270,2465}, {270,10642}, {270,18820}, {270,26998},
-{270,35176}, {270,43354}, {270,51532}, {270,59710}, {271,2353}, {271,10530}, {271,18708}, {271,26886},
-{271,35064}, {271,43242}, {271,51420}, {271,59598}, {272,2241}, {272,10418}, {272,18596}, {272,26774},
-{272,34952}, {272,43130}, {272,51308}, {272,59486}, {273,2128}, {273,10306}, {273,18484}, {273,26662},
-{273,34840}, {273,43018}, {273,51196}, {273,59374}, {274,2016}, {274,10194}, {274,18372}, {274,26550},
-{274,34728}, {274,42906}, {274,51084}, {274,59262}, {275,1904}, {275,10082}, {275,18260}, {275,26438},
-{275,34616}, {275,42794}, {275,50972}, {275,59150}, {276,1792}, {276,9970}, {276,18148}, {276,26326},
-{276,34504}, {276,42682}, {276,50860}, {276,59038}, {277,1680}, {277,9858}, {277,18036}, {277,26214},
-{277,34392}, {277,42570}, {277,50748}, {277,58925}, {278,1568}, {278,9746}, {278,17924}, {278,26102},
-{278,34280}, {278,42458}, {278,50636}, {278,58813}, {279,1456}, {279,9634}, {279,17812}, {279,25990},
-{279,34168}, {279,42346}, {279,50524}, {279,58701}, {280,1344}, {280,9522}, {280,17700}, {280,25878},
-{280,34056}, {280,42234}, {280,50412}, {280,58589}, {281,1232}, {281,9410}, {281,17588}, {281,25766},
-{281,33944}, {281,42122}, {281,50300}, {281,58477}, {282,1120}, {282,9298}, {282,17476}, {282,25654},
-{282,33832}, {282,42010}, {282,50187}, {282,58365}, {283,1008}, {283,9186}, {283,17364}, {283,25542},
-{283,33720}, {283,41898}, {283,50075}, {283,58253}, {284,896}, {284,9074}, {284,17252}, {284,25430},
-{284,33608}, {284,41786}, {284,49963}, {284,58141}, {285,784}, {285,8962}, {285,17140}, {285,25318},
-{285,33496}, {285,41674}, {285,49851}, {285,58029}, {286,672}, {286,8850}, {286,17028}, {286,25206},
-{286,33384}, {286,41562}, {286,49739}, {286,57917}, {287,560}, {287,8738}, {287,16916}, {287,25094},
-{287,33272}, {287,41449}, {287,49627}, {287,57805}, {288,448}, {288,8626}, {288,16804}, {288,24982},
-{288,33160}, {288,41337}, {288,49515}, {288,57693}, {289,336}, {289,8514}, {289,16692}, {289,24870},
-{289,33048}, {289,41225}, {289,49403}, {289,57581}, {290,224}, {290,8402}, {290,16580}, {290,24758},
-{290,32936}, {290,41113}, {290,49291}, {290,57469}, {291,112}, {291,8290}, {291,16468}, {291,24646},
-{291,32824}, {291,41001}, {291,49179}, {291,57357}, {292,0}, {292,8178}, {292,16356}, {292,24534},
-{292,32711}, {292,40889}, {292,49067}, {292,57245}, {292,65423}, {293,8066}, {293,16244}, {293,24422},
-{293,32599}, {293,40777}, {293,48955}, {293,57133}, {293,65311}, {294,7954}, {294,16132}, {294,24310},
-{294,32487}, {294,40665}, {294,48843}, {294,57021}, {294,65199}, {295,7842}, {295,16020}, {295,24198},
-{295,32375}, {295,40553}, {295,48731}, {295,56909}, {295,65087}, {296,7730}, {296,15908}, {296,24086},
-{296,32263}, {296,40441}, {296,48619}, {296,56797}, {296,64975}, {297,7618}, {297,15796}, {297,23973},
-{297,32151}, {297,40329}, {297,48507}, {297,56685}, {297,64863}, {298,7506}, {298,15684}, {298,23861},
-{298,32039}, {298,40217}, {298,48395}, {298,56573}, {298,64751}, {299,7394}, {299,15572}, {299,23749},
-{299,31927}, {299,40105}, {299,48283}, {299,56461}, {299,64639}, {300,7282}, {300,15460}, {300,23637},
-{300,31815}, {300,39993}, {300,48171}, {300,56349}, {300,64527}, {301,7170}, {301,15348}, {301,23525},
-{301,31703}, {301,39881}, {301,48059}, {301,56237}, {301,64415}, {302,7058}, {302,15235}, {302,23413},
-{302,31591}, {302,39769}, {302,47947}, {302,56125}, {302,64303}, {303,6946}, {303,15123}, {303,23301},
-{303,31479}, {303,39657}, {303,47835}, {303,56013}, {303,64191}, {304,6834}, {304,15011}, {304,23189},
-{304,31367}, {304,39545}, {304,47723}, {304,55901}, {304,64079}, {305,6722}, {305,14899}, {305,23077},
-{305,31255}, {305,39433}, {305,47611}, {305,55789}, {305,63967}, {306,6610}, {306,14787}, {306,22965},
-{306,31143}, {306,39321}, {306,47499}, {306,55677}, {306,63855}, {307,6497}, {307,14675}, {307,22853},
-{307,31031}, {307,39209}, {307,47387}, {307,55565}, {307,63743}, {308,6385}, {308,14563}, {308,22741},
-{308,30919}, {308,39097}, {308,47275}, {308,55453}, {308,63631}, {309,6273}, {309,14451}, {309,22629},
-{309,30807}, {309,38985}, {309,47163}, {309,55341}, {309,63519}, {310,6161}, {310,14339}, {310,22517},
-{310,30695}, {310,38873}, {310,47051}, {310,55229}, {310,63407}, {311,6049}, {311,14227}, {311,22405},
-{311,30583}, {311,38761}, {311,46939}, {311,55117}, {311,63294}, {312,5937}, {312,14115}, {312,22293},
-{312,30471}, {312,38649}, {312,46827}, {312,55005}, {312,63182}, {313,5825}, {313,14003}, {313,22181},
-{313,30359}, {313,38537}, {313,46715}, {313,54893}, {313,63070}, {314,5713}, {314,13891}, {314,22069},
-{314,30247}, {314,38425}, {314,46603}, {314,54781}, {314,62958}, {315,5601}, {315,13779}, {315,21957},
-{315,30135}, {315,38313}, {315,46491}, {315,54669}, {315,62846}, {316,5489}, {316,13667}, {316,21845},
-{316,30023}, {316,38201}, {316,46379}, {316,54556}, {316,62734}, {317,5377}, {317,13555}, {317,21733},
-{317,29911}, {317,38089}, {317,46267}, {317,54444}, {317,62622}, {318,5265}, {318,13443}, {318,21621},
-{318,29799}, {318,37977}, {318,46155}, {318,54332}, {318,62510}, {319,5153}, {319,13331}, {319,21509},
-{319,29687}, {319,37865}, {319,46043}, {319,54220}, {319,62398}, {320,5041}, {320,13219}, {320,21397},
-{320,29575}, {320,37753}, {320,45931}, {320,54108}, {320,62286}, {321,4929}, {321,13107}, {321,21285},
-{321,29463}, {321,37641}, {321,45818}, {321,53996}, {321,62174}, {322,4817}, {322,12995}, {322,21173},
-{322,29351}, {322,37529}, {322,45706}, {322,53884}, {322,62062}, {323,4705}, {323,12883}, {323,21061},
-{323,29239}, {323,37417}, {323,45594}, {323,53772}, {323,61950}, {324,4593}, {324,12771}, {324,20949},
-{324,29127}, {324,37305}, {324,45482}, {324,53660}, {324,61838}, {325,4481}, {325,12659}, {325,20837},
-{325,29015}, {325,37193}, {325,45370}, {325,53548}, {325,61726}, {326,4369}, {326,12547}, {326,20725},
-{326,28903}, {326,37080}, {326,45258}, {326,53436}, {326,61614}, {327,4257}, {327,12435}, {327,20613},
-{327,28791}, {327,36968}, {327,45146}, {327,53324}, {327,61502}, {328,4145}, {328,12323}, {328,20501},
-{328,28679}, {328,36856}, {328,45034}, {328,53212}, {328,61390}, {329,4033}, {329,12211}, {329,20389},
-{329,28567}, {329,36744}, {329,44922}, {329,53100}, {329,61278}, {330,3921}, {330,12099}, {330,20277},
-{330,28455}, {330,36632}, {330,44810}, {330,52988}, {330,61166}, {331,3809}, {331,11987}, {331,20165},
-{331,28342}, {331,36520}, {331,44698}, {331,52876}, {331,61054}, {332,3697}, {332,11875}, {332,20053},
-{332,28230}, {332,36408}, {332,44586}, {332,52764}, {332,60942}, {333,3585}, {333,11763}, {333,19941},
-{333,28118}, {333,36296}, {333,44474}, {333,52652}, {333,60830}, {334,3473}, {334,11651}, {334,19829},
-{334,28006}, {334,36184}, {334,44362}, {334,52540}, {334,60718}, {335,3361}, {335,11539}, {335,19717},
-{335,27894}, {335,36072}, {335,44250}, {335,52428}, {335,60606}, {336,3249}, {336,11427}, {336,19604},
-{336,27782}, {336,35960}, {336,44138}, {336,52316}, {336,60494}, {337,3137}, {337,11315}, {337,19492},
-{337,27670}, {337,35848}, {337,44026}, {337,52204}, {337,60382}, {338,3025}, {338,11203}, {338,19380},
-{338,27558}, {338,35736}, {338,43914}, {338,52092}, {338,60270}, {339,2913}, {339,11091}, {339,19268},
-{339,27446}, {339,35624}, {339,43802}, {339,51980}, {339,60158}, {340,2801}, {340,10979}, {340,19156},
-{340,27334}, {340,35512}, {340,43690}, {340,51868}, {340,60046}, {341,2689}, {341,10866}, {341,19044},
-{341,27222}, {341,35400}, {341,43578}, {341,51756}, {341,59934}, {342,2577}, {342,10754}, {342,18932},
-{342,27110}, {342,35288}, {342,43466}, {342,51644}, {342,59822}, {343,2465}, {343,10642}, {343,18820},
-{343,26998}, {343,35176}, {343,43354}, {343,51532}, {343,59710}, {344,2353}, {344,10530}, {344,18708},
-{344,26886}, {344,35064}, {344,43242}, {344,51420}, {344,59598}, {345,2241}, {345,10418}, {345,18596},
-{345,26774}, {345,34952}, {345,43130}, {345,51308}, {345,59486}, {346,2128}, {346,10306}, {346,18484},
-{346,26662}, {346,34840}, {346,43018}, {346,51196}, {346,59374}, {347,2016}, {347,10194}, {347,18372},
-{347,26550}, {347,34728}, {347,42906}, {347,51084}, {347,59262}, {348,1904}, {348,10082}, {348,18260},
-{348,26438}, {348,34616}, {348,42794}, {348,50972}, {348,59150}, {349,1792}, {349,9970}, {349,18148},
-{349,26326}, {349,34504}, {349,42682}, {349,50860}, {349,59038}, {350,1680}, {350,9858}, {350,18036},
-{350,26214}, {350,34392}, {350,42570}, {350,50748}, {350,58925}, {351,1568}, {351,9746}, {351,17924},
-{351,26102}, {351,34280}, {351,42458}, {351,50636}, {351,58813}, {352,1456}, {352,9634}, {352,17812},
-{352,25990}, {352,34168}, {352,42346}, {352,50524}, {352,58701}, {353,1344}, {353,9522}, {353,17700},
-{353,25878}, {353,34056}, {353,42234}, {353,50412}, {353,58589}, {354,1232}, {354,9410}, {354,17588},
-{354,25766}, {354,33944}, {354,42122}, {354,50300}, {354,58477}, {355,1120}, {355,9298}, {355,17476},
-{355,25654}, {355,33832}, {355,42010}, {355,50187}, {355,58365}, {356,1008}, {356,9186}, {356,17364},
-{356,25542}, {356,33720}, {356,41898}, {356,50075}, {356,58253}, {357,896}, {357,9074}, {357,17252},
-{357,25430}, {357,33608}, {357,41786}, {357,49963}, {357,58141}, {358,784}, {358,8962}, {358,17140},
-{358,25318}, {358,33496}, {358,41674}, {358,49851}, {358,58029}, {359,672}, {359,8850}, {359,17028},
-{359,25206}, {359,33384}, {359,41562}, {359,49739}, {359,57917}, {360,560}, {360,8738}, {360,16916},
-{360,25094}, {360,33272}, {360,41449}, {360,49627}, {360,57805}, {361,448}, {361,8626}, {361,16804},
-{361,24982}, {361,33160}, {361,41337}, {361,49515}, {361,57693}, {362,336}, {362,8514}, {362,16692},
-{362,24870}, {362,33048}, {362,41225}, {362,49403}, {362,57581}, {363,224}, {363,8402}, {363,16580},
-{363,24758}, {363,32936}, {363,41113}, {363,49291}, {363,57469}, {364,112}, {364,8290}, {364,16468},
-{364,24646}, {364,32824}, {364,41001}, {364,49179}, {364,57357}, {365,0}, {365,8178}, {365,16356},
-{365,24534}, {365,32711}, {365,40889}, {365,49067}, {365,57245}, {365,65423}, {366,8066}, {366,16244},
-{366,24422}, {366,32599}, {366,40777}, {366,48955}, {366,57133}, {366,65311}, {367,7954}, {367,16132},
-{367,24310}, {367,32487}, {367,40665}, {367,48843}, {367,57021}, {367,65199}, {368,7842}, {368,16020},
-{368,24198}, {368,32375}, {368,40553}, {368,48731}, {368,56909}, {368,65087}, {369,7730}, {369,15908},
-{369,24086}, {369,32263}, {369,40441}, {369,48619}, {369,56797}, {369,64975}, {370,7618}, {370,15796},
-{370,23973}, {370,32151}, {370,40329}, {370,48507}, {370,56685}, {370,64863}, {371,7506}, {371,15684},
-{371,23861}, {371,32039}, {371,40217}, {371,48395}, {371,56573}, {371,64751}, {372,7394}, {372,15572},
-{372,23749}, {372,31927}, {372,40105}, {372,48283}, {372,56461}, {372,64639}, {373,7282}, {373,15460},
-{373,23637}, {373,31815}, {373,39993}, {373,48171}, {373,56349}, {373,64527}, {374,7170}, {374,15348},
-{374,23525}, {374,31703}, {374,39881}, {374,48059}, {374,56237}, {374,64415}, {375,7058}, {375,15235},
-{375,23413}, {375,31591}, {375,39769}, {375,47947}, {375,56125}, {375,64303}, {376,6946}, {376,15123},
-{376,23301}, {376,31479}, {376,39657}, {376,47835}, {376,56013}, {376,64191}, {377,6834}, {377,15011},
-{377,23189}, {377,31367}, {377,39545}, {377,47723}, {377,55901}, {377,64079}, {378,6722}, {378,14899},
-{378,23077}, {378,31255}, {378,39433}, {378,47611}, {378,55789}, {378,63967}, {379,6610}, {379,14787},
-{379,22965}, {379,31143}, {379,39321}, {379,47499}, {379,55677}, {379,63855}, {380,6497}, {380,14675},
-{380,22853}, {380,31031}, {380,39209}, {380,47387}, {380,55565}, {380,63743}, {381,6385}, {381,14563},
-{381,22741}, {381,30919}, {381,39097}, {381,47275}, {381,55453}, {381,63631}, {382,6273}, {382,14451},
-{382,22629}, {382,30807}, {382,38985}, {382,47163}, {382,55341}, {382,63519}, {383,6161}, {383,14339},
-{383,22517}, {383,30695}, {383,38873}, {383,47051}, {383,55229}, {383,63407}, {384,6049}, {384,14227},
-{384,22405}, {384,30583}, {384,38761}, {384,46939}, {384,55117}, {384,63294}, {385,5937}, {385,14115},
-{385,22293}, {385,30471}, {385,38649}, {385,46827}, {385,55005}, {385,63182}, {386,5825}, {386,14003},
-{386,22181}, {386,30359}, {386,38537}, {386,46715}, {386,54893}, {386,63070}, {387,5713}, {387,13891},
-{387,22069}, {387,30247}, {387,38425}, {387,46603}, {387,54781}, {387,62958}, {388,5601}, {388,13779},
-{388,21957}, {388,30135}, {388,38313}, {388,46491}, {388,54669}, {388,62846}, {389,5489}, {389,13667},
-{389,21845}, {389,30023}, {389,38201}, {389,46379}, {389,54556}, {389,62734}, {390,5377}, {390,13555},
-{390,21733}, {390,29911}, {390,38089}, {390,46267}, {390,54444}, {390,62622}, {391,5265}, {391,13443},
-{391,21621}, {391,29799}, {391,37977}, {391,46155}, {391,54332}, {391,62510}, {392,5153}, {392,13331},
-{392,21509}, {392,29687}, {392,37865}, {392,46043}, {392,54220}, {392,62398}, {393,5041}, {393,13219},
-{393,21397}, {393,29575}, {393,37753}, {393,45931}, {393,54108}, {393,62286}, {394,4929}, {394,13107},
-{394,21285}, {394,29463}, {394,37641}, {394,45818}, {394,53996}, {394,62174}, {395,4817}, {395,12995},
-{395,21173}, {395,29351}, {395,37529}, {395,45706}, {395,53884}, {395,62062}, {396,4705}, {396,12883},
-{396,21061}, {396,29239}, {396,37417}, {396,45594}, {396,53772}, {396,61950}, {397,4593}, {397,12771},
-{397,20949}, {397,29127}, {397,37305}, {397,45482}, {397,53660}, {397,61838}, {398,4481}, {398,12659},
-{398,20837}, {398,29015}, {398,37193}, {398,45370}, {398,53548}, {398,61726}, {399,4369}, {399,12547},
-{399,20725}, {399,28903}, {399,37080}, {399,45258}, {399,53436}, {399,61614}, {400,4257}, {400,12435},
-{400,20613}, {400,28791}, {400,36968}, {400,45146}, {400,53324}, {400,61502}, {401,4145}, {401,12323},
-{401,20501}, {401,28679}, {401,36856}, {401,45034}, {401,53212}, {401,61390}, {402,4033}, {402,12211},
-{402,20389}, {402,28567}, {402,36744}, {402,44922}, {402,53100}, {402,61278}, {403,3921}, {403,12099},
-{403,20277}, {403,28455}, {403,36632}, {403,44810}, {403,52988}, {403,61166}, {404,3809}, {404,11987},
-{404,20165}, {404,28342}, {404,36520}, {404,44698}, {404,52876}, {404,61054}, {405,3697}, {405,11875},
-{405,20053}, {405,28230}, {405,36408}, {405,44586}, {405,52764}, {405,60942}, {406,3585}, {406,11763},
-{406,19941}, {406,28118}, {406,36296}, {406,44474}, {406,52652}, {406,60830}, {407,3473}, {407,11651},
-{407,19829}, {407,28006}, {407,36184}, {407,44362}, {407,52540}, {407,60718}, {408,3361}, {408,11539},
-{408,19717}, {408,27894}, {408,36072}, {408,44250}, {408,52428}, {408,60606}, {409,3249}, {409,11427},
-{409,19604}, {409,27782}, {409,35960}, {409,44138}, {409,52316}, {409,60494}, {410,3137}, {410,11315},
-{410,19492}, {410,27670}, {410,35848}, {410,44026}, {410,52204}, {410,60382}, {411,3025}, {411,11203},
-{411,19380}, {411,27558}, {411,35736}, {411,43914}, {411,52092}, {411,60270}, {412,2913}, {412,11091},
-{412,19268}, {412,27446}, {412,35624}, {412,43802}, {412,51980}, {412,60158}, {413,2801}, {413,10979},
-{413,19156}, {413,27334}, {413,35512}, {413,43690}, {413,51868}, {413,60046}, {414,2689}, {414,10866},
-{414,19044}, {414,27222}, {414,35400}, {414,43578}, {414,51756}, {414,59934}, {415,2577}, {415,10754},
-{415,18932}, {415,27110}, {415,35288}, {415,43466}, {415,51644}, {415,59822}, {416,2465}, {416,10642},
-{416,18820}, {416,26998}, {416,35176}, {416,43354}, {416,51532}, {416,59710}, {417,2353}, {417,10530},
-{417,18708}, {417,26886}, {417,35064}, {417,43242}, {417,51420}, {417,59598}, {418,2241}, {418,10418},
-{418,18596}, {418,26774}, {418,34952}, {418,43130}, {418,51308}, {418,59486}, {419,2128}, {419,10306},
-{419,18484}, {419,26662}, {419,34840}, {419,43018}, {419,51196}, {419,59374}, {420,2016}, {420,10194},
-{420,18372}, {420,26550}, {420,34728}, {420,42906}, {420,51084}, {420,59262}, {421,1904}, {421,10082},
-{421,18260}, {421,26438}, {421,34616}, {421,42794}, {421,50972}, {421,59150}, {422,1792}, {422,9970},
-{422,18148}, {422,26326}, {422,34504}, {422,42682}, {422,50860}, {422,59038}, {423,1680}, {423,9858},
-{423,18036}, {423,26214}, {423,34392}, {423,42570}, {423,50748}, {423,58925}, {424,1568}, {424,9746},
-{424,17924}, {424,26102}, {424,34280}, {424,42458}, {424,50636}, {424,58813}, {425,1456}, {425,9634},
-{425,17812}, {425,25990}, {425,34168}, {425,42346}, {425,50524}, {425,58701}, {426,1344}, {426,9522},
-{426,17700}, {426,25878}, {426,34056}, {426,42234}, {426,50412}, {426,58589}, {427,1232}, {427,9410},
-{427,17588}, {427,25766}, {427,33944}, {427,42122}, {427,50300}, {427,58477}, {428,1120}, {428,9298},
-{428,17476}, {428,25654}, {428,33832}, {428,42010}, {428,50187}, {428,58365}, {429,1008}, {429,9186},
-{429,17364}, {429,25542}, {429,33720}, {429,41898}, {429,50075}, {429,58253}, {430,896}, {430,9074},
-{430,17252}, {430,25430}, {430,33608}, {430,41786}, {430,49963}, {430,58141}, {431,784}, {431,8962},
-{431,17140}, {431,25318}, {431,33496}, {431,41674}, {431,49851}, {431,58029}, {432,672}, {432,8850},
-{432,17028}, {432,25206}, {432,33384}, {432,41562}, {432,49739}, {432,57917}, {433,560}, {433,8738},
-{433,16916}, {433,25094}, {433,33272}, {433,41449}, {433,49627}, {433,57805}, {434,448}, {434,8626},
-{434,16804}, {434,24982}, {434,33160}, {434,41337}, {434,49515}, {434,57693}, {435,336}, {435,8514},
-{435,16692}, {435,24870}, {435,33048}, {435,41225}, {435,49403}, {435,57581}, {436,224}, {436,8402},
-{436,16580}, {436,24758}, {436,32936}, {436,41113}, {436,49291}, {436,57469}, {437,112}, {437,8290},
-{437,16468}, {437,24646}, {437,32824}, {437,41001}, {437,49179}, {437,57357}, {438,0}, {438,8178},
-{438,16356}, {438,24534}, {438,32711}, {438,40889}, {438,49067}, {438,57245}, {438,65423}, {439,8066},
-{439,16244}, {439,24422}, {439,32599}, {439,40777}, {439,48955}, {439,57133}, {439,65311}, {440,7954},
-{440,16132}, {440,24310}, {440,32487}, {440,40665}, {440,48843}, {440,57021}, {440,65199}, {441,7842},
-{441,16020}, {441,24198}, {441,32375}, {441,40553}, {441,48731}, {441,56909}, {441,65087}, {442,7730},
-{442,15908}, {442,24086}, {442,32263}, {442,40441}, {442,48619}, {442,56797}, {442,64975}, {443,7618},
-{443,15796}, {443,23973}, {443,32151}, {443,40329}, {443,48507}, {443,56685}, {443,64863}, {444,7506},
-{444,15684}, {444,23861}, {444,32039}, {444,40217}, {444,48395}, {444,56573}, {444,64751}, {445,7394},
-{445,15572}, {445,23749}, {445,31927}, {445,40105}, {445,48283}, {445,56461}, {445,64639}, {446,7282},
-{446,15460}, {446,23637}, {446,31815}, {446,39993}, {446,48171}, {446,56349}, {446,64527}, {447,7170},
-{447,15348}, {447,23525}, {447,31703}, {447,39881}, {447,48059}, {447,56237}, {447,64415}, {448,7058},
-{448,15235}, {448,23413}, {448,31591}, {448,39769}, {448,47947}, {448,56125}, {448,64303}, {449,6946},
-{449,15123}, {449,23301}, {449,31479}, {449,39657}, {449,47835}, {449,56013}, {449,64191}, {450,6834},
-{450,15011}, {450,23189}, {450,31367}, {450,39545}, {450,47723}, {450,55901}, {450,64079}, {451,6722},
-{451,14899}, {451,23077}, {451,31255}, {451,39433}, {451,47611}, {451,55789}, {451,63967}, {452,6610},
-{452,14787}, {452,22965}, {452,31143}, {452,39321}, {452,47499}, {452,55677}, {452,63855}, {453,6497},
-{453,14675}, {453,22853}, {453,31031}, {453,39209}, {453,47387}, {453,55565}, {453,63743}, {454,6385},
-{454,14563}, {454,22741}, {454,30919}, {454,39097}, {454,47275}, {454,55453}, {454,63631}, {455,6273},
-{455,14451}, {455,22629}, {455,30807}, {455,38985}, {455,47163}, {455,55341}, {455,63519}, {456,6161},
-{456,14339}, {456,22517}, {456,30695}, {456,38873}, {456,47051}, {456,55229}, {456,63407}, {457,6049},
-{457,14227}, {457,22405}, {457,30583}, {457,38761}, {457,46939}, {457,55117}, {457,63294}, {458,5937},
-{458,14115}, {458,22293}, {458,30471}, {458,38649}, {458,46827}, {458,55005}, {458,63182}, {459,5825},
-{459,14003}, {459,22181}, {459,30359}, {459,38537}, {459,46715}, {459,54893}, {459,63070}, {460,5713},
-{460,13891}, {460,22069}, {460,30247}, {460,38425}, {460,46603}, {460,54781}, {460,62958}, {461,5601},
-{461,13779}, {461,21957}, {461,30135}, {461,38313}, {461,46491}, {461,54669}, {461,62846}, {462,5489},
-{462,13667}, {462,21845}, {462,30023}, {462,38201}, {462,46379}, {462,54556}, {462,62734}, {463,5377},
-{463,13555}, {463,21733}, {463,29911}, {463,38089}, {463,46267}, {463,54444}, {463,62622}, {464,5265},
-{464,13443}, {464,21621}, {464,29799}, {464,37977}, {464,46155}, {464,54332}, {464,62510}, {465,5153},
-{465,13331}, {465,21509}, {465,29687}, {465,37865}, {465,46043}, {465,54220}, {465,62398}, {466,5041},
-{466,13219}, {466,21397}, {466,29575}, {466,37753}, {466,45931}, {466,54108}, {466,62286}, {467,4929},
-{467,13107}, {467,21285}, {467,29463}, {467,37641}, {467,45818}, {467,53996}, {467,62174}, {468,4817},
-{468,12995}, {468,21173}, {468,29351}, {468,37529}, {468,45706}, {468,53884}, {468,62062}, {469,4705},
-{469,12883}, {469,21061}, {469,29239}, {469,37417}, {469,45594}, {469,53772}, {469,61950}, {470,4593},
-{470,12771}, {470,20949}, {470,29127}, {470,37305}, {470,45482}, {470,53660}, {470,61838}, {471,4481},
-{471,12659}, {471,20837}, {471,29015}, {471,37193}, {471,45370}, {471,53548}, {471,61726}, {472,4369},
-{472,12547}, {472,20725}, {472,28903}, {472,37080}, {472,45258}, {472,53436}, {472,61614}, {473,4257},
-{473,12435}, {473,20613}, {473,28791}, {473,36968}, {473,45146}, {473,53324}, {473,61502}, {474,4145},
-{474,12323}, {474,20501}, {474,28679}, {474,36856}, {474,45034}, {474,53212}, {474,61390}, {475,4033},
-{475,12211}, {475,20389}, {475,28567}, {475,36744}, {475,44922}, {475,53100}, {475,61278}, {476,3921},
-{476,12099}, {476,20277}, {476,28455}, {476,36632}, {476,44810}, {476,52988}, {476,61166}, {477,3809},
-{477,11987}, {477,20165}, {477,28342}, {477,36520}, {477,44698}, {477,52876}, {477,61054}, {478,3697},
-{478,11875}, {478,20053}, {478,28230}, {478,36408}, {478,44586}, {478,52764}, {478,60942}, {479,3585},
-{479,11763}, {479,19941}, {479,28118}, {479,36296}, {479,44474}, {479,52652}, {479,60830}, {480,3473},
-{480,11651}, {480,19829}, {480,28006}, {480,36184}, {480,44362}, {480,52540}, {480,60718}, {481,3361},
-{481,11539}, {481,19717}, {481,27894}, {481,36072}, {481,44250}, {481,52428}, {481,60606}, {482,3249},
-{482,11427}, {482,19604}, {482,27782}, {482,35960}, {482,44138}, {482,52316}, {482,60494}, {483,3137},
-{483,11315}, {483,19492}, {483,27670}, {483,35848}, {483,44026}, {483,52204}, {483,60382}, {484,3025},
-{484,11203}, {484,19380}, {484,27558}, {484,35736}, {484,43914}, {484,52092}, {484,60270}, {485,2913},
-{485,11091}, {485,19268}, {485,27446}, {485,35624}, {485,43802}, {485,51980}, {485,60158}, {486,2801},
-{486,10979}, {486,19156}, {486,27334}, {486,35512}, {486,43690}, {486,51868}, {486,60046}, {487,2689},
-{487,10866}, {487,19044}, {487,27222}, {487,35400}, {487,43578}, {487,51756}, {487,59934}, {488,2577},
-{488,10754}, {488,18932}, {488,27110}, {488,35288}, {488,43466}, {488,51644}, {488,59822}, {489,2465},
-{489,10642}, {489,18820}, {489,26998}, {489,35176}, {489,43354}, {489,51532}, {489,59710}, {490,2353},
-{490,10530}, {490,18708}, {490,26886}, {490,35064}, {490,43242}, {490,51420}, {490,59598}, {491,2241},
-{491,10418}, {491,18596}, {491,26774}, {491,34952}, {491,43130}, {491,51308}, {491,59486}, {492,2128},
-{492,10306}, {492,18484}, {492,26662}, {492,34840}, {492,43018}, {492,51196}, {492,59374}, {493,2016},
-{493,10194}, {493,18372}, {493,26550}, {493,34728}, {493,42906}, {493,51084}, {493,59262}, {494,1904},
-{494,10082}, {494,18260}, {494,26438}, {494,34616}, {494,42794}, {494,50972}, {494,59150}, {495,1792},
-{495,9970}, {495,18148}, {495,26326}, {495,34504}, {495,42682}, {495,50860}, {495,59038}, {496,1680},
-{496,9858}, {496,18036}, {496,26214}, {496,34392}, {496,42570}, {496,50748}, {496,58925}, {497,1568},
-{497,9746}, {497,17924}, {497,26102}, {497,34280}, {497,42458}, {497,50636}, {497,58813}, {498,1456},
-{498,9634}, {498,17812}, {498,25990}, {498,34168}, {498,42346}, {498,50524}, {498,58701}, {499,1344},
-{499,9522}, {499,17700}, {499,25878}, {499,34056}, {499,42234}, {499,50412}, {499,58589}, {500,1232},
-{500,9410}, {500,17588}, {500,25766}, {500,33944}, {500,42122}, {500,50300}, {500,58477}, {501,1120},
-{501,9298}, {501,17476}, {501,25654}, {501,33832}, {501,42010}, {501,50187}, {501,58365}, {502,1008},
-{502,9186}, {502,17364}, {502,25542}, {502,33720}, {502,41898}, {502,50075}, {502,58253}, {503,896},
-{503,9074}, {503,17252}, {503,25430}, {503,33608}, {503,41786}, {503,49963}, {503,58141}, {504,784},
-{504,8962}, {504,17140}, {504,25318}, {504,33496}, {504,41674}, {504,49851}, {504,58029}, {505,672},
-{505,8850}, {505,17028}, {505,25206}, {505,33384}, {505,41562}, {505,49739}, {505,57917}, {506,560},
-{506,8738}, {506,16916}, {506,25094}, {506,33272}, {506,41449}, {506,49627}, {506,57805}, {507,448},
-{507,8626}, {507,16804}, {507,24982}, {507,33160}, {507,41337}, {507,49515}, {507,57693}, {508,336},
-{508,8514}, {508,16692}, {508,24870}, {508,33048}, {508,41225}, {508,49403}, {508,57581}, {509,224},
-{509,8402}, {509,16580}, {509,24758}, {509,32936}, {509,41113}, {509,49291}, {509,57469}, {510,112},
-{510,8290}, {510,16468}, {510,24646}, {510,32824}, {510,41001}, {510,49179}, {510,57357}, {510,65535}
-};
\ No newline at end of file
+
+namespace DspTables {
+
+constexpr std::array<KnobIdxFrac, 4096> makeSvfKnobMap512()
+{
+    std::array<KnobIdxFrac, 4096> t{};
+    for (uint32_t k = 0; k < 4096; ++k)
+    {
+        const uint32_t n = k * (F_LUT_SIZE - 1);
+        uint32_t idx = n / 4095;
+        uint32_t frac = ((n % 4095) * 65535u * 2u + 4095u) / (2u * 4095u); // rounded
+        if (idx >= F_LUT_SIZE - 1) { idx = F_LUT_SIZE - 2; frac = 65535; }
+        t[k] = KnobIdxFrac{ static_cast<uint16_t>(idx), static_cast<uint16_t>(frac) };
+    }
+    return t;
+}
+
+} // namespace DspTables
+
+DSP_TABLE_KNOBMAP inline constexpr std::array<KnobIdxFrac, 4096> KnobMap_512 = DspTables::makeSvfKnobMap512();
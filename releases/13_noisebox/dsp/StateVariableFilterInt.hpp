@@ -1,31 +1,43 @@
 #pragma once
 #include <cstdint>
 #include <cmath>
-#include "SVF_LUT_512.h"   // provides: F_LUT_512[], KnobMap_512[], q_ch_q15_Q{3,6,9,12}, F_LUT_SIZE==512
+#include "SVF_LUT_512.h"   // provides: SvfFLut<>[], KnobMap_512[], QCH_LUT[], q_ch_q15_Q{3,6,9,12}, F_LUT_SIZE==512
 
 // ================================================================
 // Integer (Q15) State Variable Filter (Chamberlin form) using prebuilt LUTs
 // - Audio-rate path is integer-only (Q15).
-// - Cutoff uses F_LUT_512[] and KnobMap_512[] from SVF_LUT_512.h
-// - Fixed resonances Q in {3,6,9,12} via q_ch = 1/Q in Q15 (constants in LUT header)
-// - LUT was generated for FS=48k, FMIN=20 Hz, FMAX=8 kHz (must match your LUT file).
+// - Cutoff uses SvfFLut<FS, FMIN, FMAX>[] and KnobMap_512[] from SVF_LUT_512.h
+// - Fixed resonances Q in {3,6,9,12} via q_ch = 1/Q in Q15 (constants in LUT header),
+//   or continuous Q (0.7..16) from QCH_LUT[]
+// - The f LUT is generated for the template's sample rate FS and cutoff range FMIN..FMAX Hz;
+//   StateVariableFilterIntLUT is the 48 kHz, 20 Hz..8 kHz filter. Instantiate e.g. FS=96000 for
+//   a card run at 96 kHz, or a filter run 2x oversampled at 48 kHz.
+// - Cutoff can glide linearly to a new f over n samples (rampCutoffTo), so callers updating it at
+//   control rate get a smooth sweep without computing f per sample.
+// - processMulti() returns LP/BP/HP from one filter for algos needing more than one mode.
 // ================================================================
-class StateVariableFilterIntLUT {
+template <uint32_t FS = 48000, uint32_t FMIN = 20, uint32_t FMAX = 8000>
+class BasicStateVariableFilterIntLUT {
 public:
+    static constexpr uint32_t kSampleRate = FS;
+
     enum class Mode { Lowpass, Bandpass, Highpass, Notch };
     enum class Resonance { Q3, Q6, Q9, Q12 };
 
-    StateVariableFilterIntLUT() = default;
+    // All outputs of one step, 12-bit
+    struct Outputs { int16_t low, band, high; };
+
+    BasicStateVariableFilterIntLUT() = default;
 
     // One-time init (no LUT building needed anymore)
     void begin() {
         setMode(Mode::Lowpass);
         setResonance(Resonance::Q6);
-        setSampleRate(48000.0f); // informational only
+        setSampleRate(float(FS)); // informational only
         reset();
     }
 
-    void setSampleRate(float fs) { sampleRate_ = (fs > 0.0f) ? fs : 48000.0f; }
+    void setSampleRate(float fs) { sampleRate_ = (fs > 0.0f) ? fs : float(FS); }
     void setMode(Mode m)         { mode_ = m; }
 
     void setResonance(Resonance r) {
@@ -38,33 +50,82 @@ public:
         }
     }
 
+    // Control-rate: continuous resonance, r in Q16 (0 -> Q 0.7, 65536 -> Q 16, log-spaced)
+    inline void setResonanceNormQ16(int32_t r_q16) {
+        if (r_q16 < 0) r_q16 = 0;
+        if (r_q16 > 65536) r_q16 = 65536;
+        const uint32_t pos = uint32_t(r_q16) * uint32_t(Q_LUT_SIZE - 2); // Q16
+        const uint32_t idx = pos >> 16;
+        const uint32_t frac = pos & 0xFFFFu;
+        const int32_t a = QCH_LUT[idx];
+        const int32_t b = QCH_LUT[idx + 1];
+        q_ch_q15_ = a + int32_t((int64_t(b - a) * int64_t(frac)) >> 16);
+    }
+
     // Control-rate: integer-only knob mapping (0..4095)
     inline void setCutoffFromKnob(uint16_t knob012) {
-        f_q15_ = f_from_knob_q15_(knob012);
+        setF_(f_from_knob_q15_(knob012));
+    }
+
+    // Control-rate: cutoff position in the LUT's log domain, Q16 (0 -> FMIN, 65536 -> FMAX)
+    inline void setCutoffNormQ16(int32_t norm_q16) {
+        setF_(fFromNormQ16(norm_q16));
+    }
+
+    // Glide f linearly from its current value to f_target_q15 over the next n processed samples
+    // (process/processMulti only; processWithFMod ignores it). n <= 1 jumps straight there.
+    inline void rampCutoffTo(uint16_t f_target_q15, int n) {
+        const uint32_t target = uint32_t(clampF_(f_target_q15)) << kRampBits;
+        if (n <= 1) { f_acc_ = target; fRampLeft_ = 0; return; }
+        fStep_ = (int32_t(target) - int32_t(f_acc_)) / n;
+        fTarget_ = target;
+        fRampLeft_ = n;
+    }
+
+    // f coefficient (Q15) for a cutoff position in the LUT's log domain, Q16 (clamped to 0..65536),
+    // linearly interpolated between the 512 entries
+    static inline uint16_t fFromNormQ16(int32_t norm_q16) {
+        if (norm_q16 < 0) norm_q16 = 0;
+        if (norm_q16 > 65536) norm_q16 = 65536;
+        const uint32_t pos = uint32_t(norm_q16) * uint32_t(F_LUT_SIZE - 1); // Q16
+        uint32_t idx = pos >> 16;
+        uint32_t frac = pos & 0xFFFFu;
+        if (idx >= uint32_t(F_LUT_SIZE - 1)) { idx = F_LUT_SIZE - 2; frac = 65535u; }
+        return lerp16_u16_(SvfFLut<FS, FMIN, FMAX>[idx], SvfFLut<FS, FMIN, FMAX>[idx + 1], uint16_t(frac));
     }
 
     // Control-rate: Hz mapping via the LUT (float here is fine; not in hot path)
-    // NOTE: Assumes LUT was built for FMIN=20, FMAX=8000, F_LUT_SIZE=512.
     void setCutoffHz(float fc) {
-        if (fc < 20.0f)   fc = 20.0f;
-        if (fc > 8000.0f) fc = 8000.0f;
-        const float logSpan = std::log(8000.0f / 20.0f);
-        const float pos = (std::log(fc / 20.0f) / logSpan) * float(F_LUT_SIZE - 1);
+        if (fc < float(FMIN)) fc = float(FMIN);
+        if (fc > float(FMAX)) fc = float(FMAX);
+        const float logSpan = std::log(float(FMAX) / float(FMIN));
+        const float pos = (std::log(fc / float(FMIN)) / logSpan) * float(F_LUT_SIZE - 1);
         int idx = int(pos);
         float fracf = pos - float(idx);
         if (idx < 0) { idx = 0; fracf = 0.0f; }
         if (idx >= F_LUT_SIZE - 1) { idx = F_LUT_SIZE - 2; fracf = 1.0f; }
-        const uint16_t a = F_LUT_512[idx];
-        const uint16_t b = F_LUT_512[idx + 1];
+        const uint16_t a = SvfFLut<FS, FMIN, FMAX>[idx];
+        const uint16_t b = SvfFLut<FS, FMIN, FMAX>[idx + 1];
         const uint16_t frac = (uint16_t)std::lrint(fracf * 65535.0f);
-        f_q15_ = lerp16_u16_(a, b, frac);
+        setF_(lerp16_u16_(a, b, frac));
     }
 
     void reset() { low_q15_ = 0; band_q15_ = 0; }
 
     // ----- Audio-rate: process one 12-bit sample (−2048..+2047)
     inline int16_t process(int16_t x12) {
-        return processWithFMod(x12, f_q15_);
+        return processWithFMod(x12, nextF_());
+    }
+
+    // Audio-rate: one step, all three outputs (cutoff and ramp as process())
+    inline Outputs processMulti(int16_t x12) {
+        int32_t high_q15 = step_(x12, nextF_());
+        return Outputs{ to12_(low_q15_), to12_(band_q15_), to12_(high_q15) };
+    }
+
+    // Audio-rate: n samples in[] -> out[] (in place is fine)
+    inline void processBlock(const int16_t* in, int16_t* out, int n) {
+        for (int j = 0; j < n; ++j) out[j] = process(in[j]);
     }
 
     // Audio-rate: process with *knob* cutoff modulation (0..4095), integer-only
@@ -75,25 +136,7 @@ public:
 
     // Audio-rate: process with explicit f coefficient (Q15 0..~65534)
     inline int16_t processWithFMod(int16_t x12, uint16_t f_mod_q15) {
-        // Convert input to Q15
-        int32_t x = int32_t(x12) << 4; // −2048..+2047 -> ~−32768..+32752
-
-        // Clamp f
-        uint32_t f = f_mod_q15;
-        if (f > 65534u) f = 65534u;
-
-        // Chamberlin SVF (Q15)
-        // low += f * band
-        int32_t f_band = int32_t( (int64_t(f) * int64_t(band_q15_)) >> 15 );
-        low_q15_ = sat_q15_(low_q15_ + f_band);
-
-        // high = x - low - q * band
-        int32_t q_band = int32_t( (int64_t(q_ch_q15_) * int64_t(band_q15_)) >> 15 );
-        int32_t high_q15 = sat_q15_(x - low_q15_ - q_band);
-
-        // band += f * high
-        int32_t f_high = int32_t( (int64_t(f) * int64_t(high_q15)) >> 15 );
-        band_q15_ = sat_q15_(band_q15_ + f_high);
+        int32_t high_q15 = step_(x12, clampF_(f_mod_q15));
 
         int32_t out_q15 = 0;
         switch (mode_) {
@@ -103,11 +146,7 @@ public:
             case Mode::Notch:    out_q15 = sat_q15_(high_q15 + low_q15_); break;
         }
 
-        // Back to 12-bit
-        int32_t y12 = out_q15 >> 4;
-        if (y12 < -2048) y12 = -2048;
-        if (y12 >  2047) y12 =  2047;
-        return (int16_t)y12;
+        return to12_(out_q15);
     }
 
     // Dual-input mix (Teensy-style) then filter
@@ -125,13 +164,55 @@ private:
     // State & params
     Mode     mode_       = Mode::Lowpass;
     Resonance resonance_ = Resonance::Q6;
-    float    sampleRate_ = 48000.0f; // informational
+    float    sampleRate_ = float(FS); // informational
     int32_t  q_ch_q15_   = q_ch_q15_Q6;
-    uint16_t f_q15_      = 0;        // current f
+    static constexpr int kRampBits = 15;
+    uint32_t f_acc_      = 0;        // current f, Q15 << kRampBits
+    uint32_t fTarget_    = 0;        // ramp end point, same format
+    int32_t  fStep_      = 0;
+    int      fRampLeft_  = 0;        // samples left in the cutoff ramp
     int32_t  low_q15_    = 0;
     int32_t  band_q15_   = 0;
 
     // Helpers
+    static inline uint16_t clampF_(uint16_t f) { return (f > 65534u) ? uint16_t(65534u) : f; }
+
+    inline void setF_(uint16_t f) { f_acc_ = uint32_t(clampF_(f)) << kRampBits; fRampLeft_ = 0; }
+
+    // f for this sample, advancing the cutoff ramp (lands exactly on its target)
+    inline uint16_t nextF_() {
+        if (fRampLeft_ > 0) {
+            f_acc_ = (--fRampLeft_ == 0) ? fTarget_ : f_acc_ + uint32_t(fStep_);
+        }
+        return uint16_t(f_acc_ >> kRampBits);
+    }
+
+    // Chamberlin SVF (Q15) step with f already clamped; updates low/band, returns high
+    inline int32_t step_(int16_t x12, uint32_t f) {
+        // Convert input to Q15
+        int32_t x = int32_t(x12) << 4; // −2048..+2047 -> ~−32768..+32752
+
+        // low += f * band
+        int32_t f_band = int32_t( (int64_t(f) * int64_t(band_q15_)) >> 15 );
+        low_q15_ = sat_q15_(low_q15_ + f_band);
+
+        // high = x - low - q * band
+        int32_t q_band = int32_t( (int64_t(q_ch_q15_) * int64_t(band_q15_)) >> 15 );
+        int32_t high_q15 = sat_q15_(x - low_q15_ - q_band);
+
+        // band += f * high
+        int32_t f_high = int32_t( (int64_t(f) * int64_t(high_q15)) >> 15 );
+        band_q15_ = sat_q15_(band_q15_ + f_high);
+        return high_q15;
+    }
+
+    // Q15 -> 12-bit, saturating
+    static inline int16_t to12_(int32_t v_q15) {
+        int32_t y12 = v_q15 >> 4;
+        if (y12 < -2048) y12 = -2048;
+        if (y12 >  2047) y12 =  2047;
+        return (int16_t)y12;
+    }
     static inline int32_t sat_q15_(int32_t v) {
         if (v < -32768) return -32768;
         if (v >  32767) return  32767;
@@ -143,8 +224,10 @@ private:
     }
     static inline uint16_t f_from_knob_q15_(uint16_t knob012) {
         const ::KnobIdxFrac m = KnobMap_512[knob012 & 0x0FFF];
-        const uint16_t a = F_LUT_512[m.idx];
-        const uint16_t b = F_LUT_512[m.idx + 1];
+        const uint16_t a = SvfFLut<FS, FMIN, FMAX>[m.idx];
+        const uint16_t b = SvfFLut<FS, FMIN, FMAX>[m.idx + 1];
         return lerp16_u16_(a, b, m.frac);
     }
 };
+
+using StateVariableFilterIntLUT = BasicStateVariableFilterIntLUT<>;
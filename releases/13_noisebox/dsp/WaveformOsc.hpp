@@ -1,14 +1,17 @@
 // Reusable waveform oscillator for ComputerCard (48 kHz)
-// Shapes: Sine (LUT + linear interpolation), Triangle, Saw, Square (with pulse width)
+// Shapes: Sine (LUT + linear interpolation), Triangle, Saw, Square (with pulse width),
+// SawBlep / SquareBlep (same as Saw / Square, band-limited with polyBLEP; use these for high pitches)
 
 #pragma once
 
 #include <cstdint>
 #include <cmath>
+#include "DspTables.hpp"
+#include "PolyBlep.hpp"
 
 class WaveformOscillator {
 public:
-    enum class Shape { Sine, Triangle, Saw, Square, SampleHold, Arbitrary };
+    enum class Shape { Sine, Triangle, Saw, Square, SampleHold, Arbitrary, SawBlep, SquareBlep };
 
     WaveformOscillator()
     {
@@ -17,7 +20,6 @@ public:
         setAmplitudeQ12(4095);
         setPulseWidthQ15(16384); // 0.5 duty
         setFrequencyHz(1.0f);
-        initSineLUT();
     }
 
     void setSampleRate(float fs_hz)
@@ -55,6 +57,10 @@ public:
         basePhaseInc = static_cast<uint32_t>(hz * hzToPhase);
     }
 
+    // Set the frequency directly as a phase increment per sample (2^32 = one cycle), see ControlMaps.hpp
+    void setPhaseIncrement(uint32_t inc) { basePhaseInc = inc; }
+    uint32_t phaseIncrement() const { return basePhaseInc; }
+
     void resetPhase(uint32_t phase = 0) { phaseAcc = phase; }
 
     // Optional FM in 16.16 fixed (Hz). Pass 0 for none.
@@ -118,6 +124,24 @@ public:
             s12 = high ? 1024 : -1024; // 50% amplitude square; amplitude scales below
             break;
         }
+        case Shape::SawBlep:
+        {
+            // Naive saw minus the residual of its 2-unit (4096) downward jump at phase 0
+            s12 = static_cast<int32_t>(phaseAcc >> 20) - 2048;
+            s12 -= dsp::polyBlepQ15(phaseAcc, inc) >> 4;
+            if (s12 < -2048) s12 = -2048;
+            if (s12 > 2047) s12 = 2047;
+            break;
+        }
+        case Shape::SquareBlep:
+        {
+            // Naive square (+/-1024) plus residuals of the rising edge at 0 and the falling edge at pw
+            uint16_t ph_q15 = static_cast<uint16_t>(phaseAcc >> 17);
+            s12 = (ph_q15 < pulseWidthQ15) ? 1024 : -1024;
+            s12 += dsp::polyBlepQ15(phaseAcc, inc) >> 5;
+            s12 -= dsp::polyBlepQ15(phaseAcc - (static_cast<uint32_t>(pulseWidthQ15) << 17), inc) >> 5;
+            break;
+        }
         case Shape::SampleHold:
         {
             // Sample and hold - update held value on zero crossing (rising edge of phase)
@@ -187,26 +211,9 @@ public:
     }
 
 private:
-    // ---- Sine LUT ----
-    static constexpr unsigned tableSize = 512;
-    static inline int16_t sineLUT[tableSize];
-    static inline bool sineInited = false;
-
-    static inline void initSineLUT()
-    {
-        if (sineInited) return;
-        for (unsigned i = 0; i < tableSize; ++i)
-        {
-            // Scale to 12-bit range
-            float angle = (2.0f * 3.14159265358979323846f * static_cast<float>(i)) / static_cast<float>(tableSize);
-            float sv = std::sinf(angle); // -1..1
-            int32_t v = static_cast<int32_t>(sv * 2047.0f);
-            if (v < -2048) v = -2048;
-            if (v > 2047) v = 2047;
-            sineLUT[i] = static_cast<int16_t>(v);
-        }
-        sineInited = true;
-    }
+    // ---- Sine LUT (shared, compile-time generated) ----
+    static constexpr unsigned tableSize = DspTables::kSine512Size;
+    static constexpr const int16_t* sineLUT = DspTables::sine512.data();
 
     float sampleRate = 48000.0f;
     float hzToPhase = static_cast<float>(4294967296.0 / 48000.0); // 2^32 / fs
@@ -0,0 +1,148 @@
+// Bank of N waveform oscillators of one shape, stored as structure-of-arrays (48 kHz)
+// Output of each voice matches WaveformOscillator::nextSample() for the same shape and settings,
+// but the shape is fixed at compile time and all voices are rendered in one loop.
+// Shapes: Sine, Triangle, Saw, Square (with per-voice pulse width), SawBlep, SquareBlep
+
+#pragma once
+
+#include <cstdint>
+#include "WaveformOsc.hpp"
+
+template <int N, WaveformOscillator::Shape S>
+class WaveformOscBank {
+    static_assert(N > 0, "WaveformOscBank needs at least one voice");
+    static_assert(S == WaveformOscillator::Shape::Sine || S == WaveformOscillator::Shape::Triangle ||
+                  S == WaveformOscillator::Shape::Saw || S == WaveformOscillator::Shape::Square ||
+                  S == WaveformOscillator::Shape::SawBlep || S == WaveformOscillator::Shape::SquareBlep,
+                  "WaveformOscBank supports Sine, Triangle, Saw, Square, SawBlep and SquareBlep");
+public:
+    static constexpr int numVoices = N;
+
+    WaveformOscBank()
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            phaseAcc[i] = 0;
+            phaseInc[i] = 0;
+            amplitudeQ12[i] = 4095;
+            pulseWidthQ15[i] = 16384; // 0.5 duty
+        }
+        setFrequencyHz(1.0f);
+    }
+
+    // Same conversion as WaveformOscillator::setFrequencyHz at 48 kHz
+    void setFrequencyHz(int i, float hz)
+    {
+        if (hz < 0.0f) hz = 0.0f;
+        phaseInc[i] = static_cast<uint32_t>(hz * hzToPhase);
+    }
+    void setFrequencyHz(float hz) { for (int i = 0; i < N; ++i) setFrequencyHz(i, hz); }
+
+    // Phase increment per sample, 2^32 = one cycle
+    void setPhaseIncrement(int i, uint32_t inc) { phaseInc[i] = inc; }
+
+    void setAmplitudeQ12(int i, uint16_t a_q12) { amplitudeQ12[i] = (a_q12 > 4095) ? 4095 : a_q12; }
+    void setAmplitudeQ12(uint16_t a_q12) { for (int i = 0; i < N; ++i) setAmplitudeQ12(i, a_q12); }
+
+    // 0..32767 => 0..~1.0 duty (Square and SquareBlep only)
+    void setPulseWidthQ15(int i, uint16_t pw_q15) { pulseWidthQ15[i] = pw_q15; }
+    void setPulseWidthQ15(uint16_t pw_q15) { for (int i = 0; i < N; ++i) pulseWidthQ15[i] = pw_q15; }
+
+    void resetPhase(uint32_t phase = 0) { for (int i = 0; i < N; ++i) phaseAcc[i] = phase; }
+
+    // Advance all voices by one sample, writing each voice's output (-2048..2047) to out[]
+    inline void nextVoices(int16_t out[N])
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            phaseAcc[i] += phaseInc[i];
+            out[i] = applyAmplitude(i, shape(i));
+        }
+    }
+
+    // Advance all voices by one sample, returning the sum of their outputs
+    inline int32_t nextMix()
+    {
+        int32_t mix = 0;
+        for (int i = 0; i < N; ++i)
+        {
+            phaseAcc[i] += phaseInc[i];
+            mix += applyAmplitude(i, shape(i));
+        }
+        return mix;
+    }
+
+    // Render n samples of the sum of all voices into out[]
+    inline void renderMix(int32_t* out, int n)
+    {
+        for (int j = 0; j < n; ++j) out[j] = nextMix();
+    }
+
+private:
+    // Shape of voice i at its current phase, -2048..2047 (Square is +/-1024), before amplitude
+    // (the Blep shapes match WaveformOscillator's SawBlep/SquareBlep)
+    inline int32_t shape(int i) const
+    {
+        const uint32_t ph = phaseAcc[i];
+        if (S == WaveformOscillator::Shape::Sine)
+        {
+            // 512-point LUT with linear interpolation, as WaveformOscillator
+            constexpr unsigned fracBits = 23;
+            uint32_t index = ph >> fracBits;
+            uint32_t r16 = (ph & ((1u << fracBits) - 1)) >> (fracBits - 16);
+            int32_t s1 = DspTables::sine512[index];
+            int32_t s2 = DspTables::sine512[(index + 1) & (DspTables::kSine512Size - 1)];
+            int32_t v = static_cast<int32_t>(((int64_t)s2 * r16 + (int64_t)s1 * (65536 - r16)) >> 16);
+            if (v < -2048) v = -2048;
+            if (v > 2047) v = 2047;
+            return v;
+        }
+        else if (S == WaveformOscillator::Shape::Saw)
+        {
+            return static_cast<int32_t>(ph >> 20) - 2048;
+        }
+        else if (S == WaveformOscillator::Shape::SawBlep)
+        {
+            int32_t v = static_cast<int32_t>(ph >> 20) - 2048;
+            v -= dsp::polyBlepQ15(ph, phaseInc[i]) >> 4;
+            if (v < -2048) v = -2048;
+            if (v > 2047) v = 2047;
+            return v;
+        }
+        else if (S == WaveformOscillator::Shape::SquareBlep)
+        {
+            uint16_t ph_q15 = static_cast<uint16_t>(ph >> 17);
+            int32_t v = (ph_q15 < pulseWidthQ15[i]) ? 1024 : -1024;
+            v += dsp::polyBlepQ15(ph, phaseInc[i]) >> 5;
+            v -= dsp::polyBlepQ15(ph - (static_cast<uint32_t>(pulseWidthQ15[i]) << 17), phaseInc[i]) >> 5;
+            return v;
+        }
+        else if (S == WaveformOscillator::Shape::Triangle)
+        {
+            int32_t r = static_cast<int32_t>(ph >> 20) & 0x0FFF;
+            int32_t tri = (r < 2048) ? r : (4095 - r);
+            return (tri << 1) - 2048;
+        }
+        else
+        {
+            uint16_t ph_q15 = static_cast<uint16_t>(ph >> 17);
+            return (ph_q15 < pulseWidthQ15[i]) ? 1024 : -1024;
+        }
+    }
+
+    inline int16_t applyAmplitude(int i, int32_t s12) const
+    {
+        if (amplitudeQ12[i] == 4095) return static_cast<int16_t>(s12);
+        int32_t y = (s12 * static_cast<int32_t>(amplitudeQ12[i])) >> 12;
+        if (y < -2048) y = -2048;
+        if (y > 2047) y = 2047;
+        return static_cast<int16_t>(y);
+    }
+
+    static constexpr float hzToPhase = static_cast<float>(4294967296.0 / 48000.0); // 2^32 / fs
+
+    uint32_t phaseAcc[N];
+    uint32_t phaseInc[N];
+    uint16_t amplitudeQ12[N];
+    uint16_t pulseWidthQ15[N];
+};
@@ -2,24 +2,146 @@
 // Based on Teensy AudioEffectWaveshaper by Damien Clarke
 // Adapted for integer-only processing
 // Input/output: 16-bit signed (-32768..32767)
+//
+// Tables are int16, length a power of two + 1. They can be built at compile time with the
+// WaveshaperTables generators below and used in place with setTable (no copy, no float), or
+// copied in at runtime with shape(). setTables takes a list of tables of the same length and
+// morphs between adjacent ones: setMorph is meant to be called once per block, and process then
+// interpolates between two tables (or just looks up one, when the morph lands on a table).
 
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include "DspTables.hpp"
+
+// ---- compile-time table generators ----
+namespace WaveshaperTables {
+
+constexpr int kDefaultLength = 257;
+
+// Table of f(x) for x from -1 to 1, clamped to [-1, 1] and scaled to int16
+template <int N = kDefaultLength, typename F>
+constexpr std::array<int16_t, N> make(F f)
+{
+    static_assert(N >= 2 && (((N - 1) & (N - 2)) == 0), "table length must be a power of two + 1");
+    std::array<int16_t, N> t{};
+    for (int i = 0; i < N; ++i)
+    {
+        double y = f(2.0 * static_cast<double>(i) / static_cast<double>(N - 1) - 1.0);
+        if (y > 1.0) y = 1.0;
+        if (y < -1.0) y = -1.0;
+        t[i] = static_cast<int16_t>(DspTables::roundToInt(32767.0 * y));
+    }
+    return t;
+}
+
+constexpr double tanh(double x)
+{
+    const double e = DspTables::exp(2.0 * x);
+    return (e - 1.0) / (e + 1.0);
+}
+
+// Soft saturation, tanh(drive * x), normalised to reach +-1 at the ends
+template <int N = kDefaultLength>
+constexpr std::array<int16_t, N> makeTanh(double drive)
+{
+    return make<N>([drive](double x) { return tanh(drive * x) / tanh(drive); });
+}
+
+// Sine wavefolder, sin(gain * x * pi / 2): folds over (gain - 1) times at each end
+template <int N = kDefaultLength>
+constexpr std::array<int16_t, N> makeFold(double gain)
+{
+    return make<N>([gain](double x) { return DspTables::sin(gain * x * DspTables::kPi * 0.5); });
+}
+
+// Chebyshev polynomial T_n(x): turns a full-scale sine into its nth harmonic
+template <int N = kDefaultLength>
+constexpr std::array<int16_t, N> makeChebyshev(int n)
+{
+    return make<N>([n](double x) {
+        double t0 = 1.0, t1 = x;
+        if (n == 0) return t0;
+        for (int k = 1; k < n; ++k)
+        {
+            const double t2 = 2.0 * x * t1 - t0;
+            t0 = t1;
+            t1 = t2;
+        }
+        return t1;
+    });
+}
+
+// Hard clip at +-threshold
+template <int N = kDefaultLength>
+constexpr std::array<int16_t, N> makeHardClip(double threshold)
+{
+    return make<N>([threshold](double x) { return x > threshold ? threshold : (x < -threshold ? -threshold : x); });
+}
+
+// Straight line, for morphing from a clean signal
+template <int N = kDefaultLength>
+constexpr std::array<int16_t, N> makeLinear()
+{
+    return make<N>([](double x) { return x; });
+}
+
+} // namespace WaveshaperTables
 
 class Waveshaper {
 private:
-    int16_t* waveshape = nullptr;
+    static constexpr int kMaxTables = 8;
+
+    int16_t* owned = nullptr;                     // table copied in by shape()
+    const int16_t* tables[kMaxTables] = {nullptr};
+    int numTables = 0;
     int length = 0;
     int lerpshift = 16;
 
+    // Current morph: tables[morphIndex] and tables[morphIndex + 1], mixed by morphFrac (Q16)
+    const int16_t* tableA = nullptr;
+    const int16_t* tableB = nullptr;
+    int32_t morphFrac = 0;
+
+    static bool validLength(int length_in)
+    {
+        if (length_in < 2 || length_in > 32769) return false;
+        // Check if length-1 is a power of two
+        int test = length_in - 1;
+        return (test & (test - 1)) == 0;
+    }
+
+    void setLength(int length_in)
+    {
+        // Calculate lerpshift for interpolation
+        // This determines how many bits to shift to map uint16_t input range
+        // to waveshape table indices
+        length = length_in;
+        int index = length - 1;
+        lerpshift = 16;
+        while (index >>= 1) {
+            --lerpshift;
+        }
+    }
+
+    // Single table lookup with linear interpolation
+    inline int32_t lookup(const int16_t* table, uint16_t x) const {
+        // Based on http://coranac.com/tonc/text/fixed.htm
+        uint16_t xa = x >> lerpshift;           // table index (integer part)
+        int16_t ya = table[xa];                 // value at current index
+        int16_t yb = table[xa + 1];             // value at next index
+
+        // frac = x - (xa << lerpshift) = fractional part of index
+        uint16_t frac = x - (xa << lerpshift);
+        return ya + (((int32_t)(yb - ya) * frac) >> lerpshift);
+    }
+
 public:
     Waveshaper() = default;
-    
+
     ~Waveshaper() {
-        if (waveshape) {
-            delete[] waveshape;
-        }
+        delete[] owned;
     }
 
     // Disable copy constructor and assignment operator
@@ -30,116 +152,127 @@ public:
     // length must be a power of two + 1 (e.g., 33, 65, 129, 257, 513, 1025, etc.)
     // waveshape values should be in range [-1.0, 1.0]
     bool shape(const float* waveshape_in, int length_in) {
-        // Validate input parameters
-        if (!waveshape_in || length_in < 2 || length_in > 32769) {
+        if (!waveshape_in || !validLength(length_in)) {
             return false;
         }
-        
-        // Check if length-1 is a power of two
-        int test = length_in - 1;
-        if ((test & (test - 1)) != 0) {
-            return false;
-        }
-
-        // Clean up existing table
-        if (waveshape) {
-            delete[] waveshape;
-        }
 
-        // Allocate and populate new table
-        length = length_in;
-        waveshape = new int16_t[length];
-        
-        for (int i = 0; i < length; i++) {
+        int16_t* t = new int16_t[length_in];
+        for (int i = 0; i < length_in; i++) {
             // Clamp input to [-1.0, 1.0] range and convert to int16_t
             float val = waveshape_in[i];
             if (val > 1.0f) val = 1.0f;
             if (val < -1.0f) val = -1.0f;
-            waveshape[i] = static_cast<int16_t>(32767.0f * val);
+            t[i] = static_cast<int16_t>(32767.0f * val);
         }
-
-        // Calculate lerpshift for interpolation
-        // This determines how many bits to shift to map uint16_t input range
-        // to waveshape table indices
-        int index = length - 1;
-        lerpshift = 16;
-        while (index >>= 1) {
-            --lerpshift;
-        }
-
+        adopt(t, length_in);
         return true;
     }
 
-    // Set the waveshape table from int16_t array (direct copy)
+    // Set the waveshape table from int16_t array (copied)
     // length must be a power of two + 1
     // waveshape values should be in range [-32767, 32767]
     bool shape(const int16_t* waveshape_in, int length_in) {
-        // Validate input parameters
-        if (!waveshape_in || length_in < 2 || length_in > 32769) {
-            return false;
-        }
-        
-        // Check if length-1 is a power of two
-        int test = length_in - 1;
-        if ((test & (test - 1)) != 0) {
+        if (!waveshape_in || !validLength(length_in)) {
             return false;
         }
 
-        // Clean up existing table
-        if (waveshape) {
-            delete[] waveshape;
+        int16_t* t = new int16_t[length_in];
+        for (int i = 0; i < length_in; i++) {
+            t[i] = waveshape_in[i];
         }
+        adopt(t, length_in);
+        return true;
+    }
 
-        // Allocate and copy new table
-        length = length_in;
-        waveshape = new int16_t[length];
-        
-        for (int i = 0; i < length; i++) {
-            waveshape[i] = waveshape_in[i];
-        }
+    // Use a table in place, without copying, e.g. one built at compile time:
+    //   static constexpr auto soft = WaveshaperTables::makeTanh(2.0);
+    //   ws.setTable(soft.data(), soft.size());
+    // The table must outlive the Waveshaper (or the next setTable/setTables/shape call)
+    bool setTable(const int16_t* table, int length_in) {
+        return setTables(&table, 1, length_in);
+    }
 
-        // Calculate lerpshift for interpolation
-        int index = length - 1;
-        lerpshift = 16;
-        while (index >>= 1) {
-            --lerpshift;
+    // Use count (up to 8) tables of the same length in place, for setMorph
+    bool setTables(const int16_t* const* tables_in, int count, int length_in) {
+        if (!tables_in || count < 1 || count > kMaxTables || !validLength(length_in)) {
+            return false;
         }
-
+        for (int i = 0; i < count; i++) {
+            if (!tables_in[i]) return false;
+        }
+        delete[] owned;
+        owned = nullptr;
+        for (int i = 0; i < count; i++) {
+            tables[i] = tables_in[i];
+        }
+        numTables = count;
+        setLength(length_in);
+        setMorph(0);
         return true;
     }
 
+    // Choose the mix of tables, 0 (first table) to 65536 (last table), with adjacent tables
+    // interpolated in between. Cheap enough to call once per block
+    void setMorph(uint32_t morph_q16) {
+        if (!numTables) return;
+        if (morph_q16 > 65536) morph_q16 = 65536;
+        // Position along the list of tables, Q16
+        uint32_t pos = morph_q16 * static_cast<uint32_t>(numTables - 1);
+        int index = static_cast<int>(pos >> 16);
+        morphFrac = static_cast<int32_t>(pos & 0xFFFF);
+        if (index >= numTables - 1) {
+            index = numTables - 1;
+            morphFrac = 0;
+        }
+        tableA = tables[index];
+        tableB = morphFrac ? tables[index + 1] : nullptr;
+    }
+
     // Process a single sample with waveshaping
     // Input: 16-bit signed sample (-32768..32767)
     // Output: 16-bit signed shaped sample
     inline int16_t process(int16_t input) {
-        if (!waveshape) {
+        if (!tableA) {
             return input; // passthrough if no waveshape loaded
         }
 
         // Convert int16_t input to uint16_t range (0..65535)
         uint16_t x = static_cast<uint16_t>(input + 32768);
-        
-        // Linear interpolation (lerp) of waveshape table
-        // Based on http://coranac.com/tonc/text/fixed.htm
-        uint16_t xa = x >> lerpshift;           // table index (integer part)
-        int16_t ya = waveshape[xa];             // value at current index
-        int16_t yb = waveshape[xa + 1];         // value at next index
-        
-        // Linear interpolation between ya and yb
-        // frac = x - (xa << lerpshift) = fractional part of index
-        uint16_t frac = x - (xa << lerpshift);
-        int32_t result = ya + (((int32_t)(yb - ya) * frac) >> lerpshift);
-        
+        int32_t result = lookup(tableA, x);
+        if (tableB) {
+            // Between two tables: mix by the morph fraction (Q16, split to stay in 32 bits)
+            int32_t d = lookup(tableB, x) - result;
+            result += (d * (morphFrac >> 1)) >> 15;
+        }
         return static_cast<int16_t>(result);
     }
 
+    // Shape n samples in place, with the morph set once for the block
+    inline void processBlock(int16_t* buf, int n, uint32_t morph_q16) {
+        setMorph(morph_q16);
+        for (int i = 0; i < n; i++) {
+            buf[i] = process(buf[i]);
+        }
+    }
+
     // Check if waveshape is loaded
     bool isReady() const {
-        return waveshape != nullptr;
+        return tableA != nullptr;
     }
 
     // Get current table length
     int getLength() const {
         return length;
     }
+
+private:
+    // Take ownership of a table built by shape()
+    void adopt(int16_t* t, int length_in) {
+        delete[] owned;
+        owned = t;
+        tables[0] = owned;
+        numTables = 1;
+        setLength(length_in);
+        setMorph(0);
+    }
 };
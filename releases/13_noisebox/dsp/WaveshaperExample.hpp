@@ -105,4 +105,15 @@ public:
         delete[] curve;
         return success;
     }
+
+    // Morph from clean, through tanh saturation, to a wavefolder, with tables built at
+    // compile time and used in place (no allocation or float at startup). Sweep with
+    // ws.setMorph(0..65536) or ws.processBlock once per block.
+    static bool createMorphingDrive(Waveshaper& ws) {
+        static constexpr auto linear = WaveshaperTables::makeLinear();
+        static constexpr auto soft = WaveshaperTables::makeTanh(3.0);
+        static constexpr auto fold = WaveshaperTables::makeFold(3.0);
+        static const int16_t* const tables[] = {linear.data(), soft.data(), fold.data()};
+        return ws.setTables(tables, 3, WaveshaperTables::kDefaultLength);
+    }
 };
@@ -1,19 +1,21 @@
+// Algorithms render a block of frames per call (see ProcessBlock). Set to 1 for per-sample processing.
+#ifndef COMPUTERCARD_BLOCK_SIZE
+#define COMPUTERCARD_BLOCK_SIZE 32
+#endif
+
+// Stereo: Audio Out 2 plays a second, independently offset voice, rendered on core1.
+// Set to 0 for the same voice on both outputs (as without a second core).
+#ifndef NOISEBOX_STEREO
+#define NOISEBOX_STEREO 1
+#endif
+
 #include "ComputerCard.h"
-#include "algos/ResoNoise.hpp"
-#include "algos/RadioOhNo.hpp"
-#include "algos/CrossModRingSquare.hpp"
-#include "algos/CrossModRingSine.hpp"
-#include "algos/ClusterSaw.hpp"
-#include "algos/Atari.hpp"
-#include "algos/Basurilla.hpp"
-#include "algos/ArrayOnTheRocks.hpp"
-#include "algos/RwalkModWave.hpp"
-#include "algos/PwCluster.hpp"
-#include "algos/ExistencelsPain.hpp"
-#include "algos/BasuraTotal.hpp"
-#include "algos/S_H.hpp"
-#include "algos/SatanWorkout.hpp"
-#include "algos/WhoKnows.hpp"
+#include "NoiseVoice.hpp"
+#include "dsp_postfx.h"
+
+#if NOISEBOX_STEREO && defined(COMPUTERCARD_HAS_MULTICORE)
+#define NOISEBOX_VOICE2 1
+#endif
 
 // Noise synthesis algorithms with CV control.
 // - Main knob: algorithm selection (7 algorithms: ResoNoise, RadioOhNo, 
@@ -25,27 +27,122 @@ class NoiseDemo : public ComputerCard
 {
 public:
     NoiseDemo()
-        : sampleHoldCounter(0), sampleHoldPeriod(8), heldSample(0), bitReductionShift(6)
-        , cv2_current_q16(0)
-        , cv2_target_q16(0)
-        , cv2_step_q16(0)
-        , cv2_slew_samples_left(0)
-        , last_cv1_value(0)
-        , have_prev_cv1(false)
-        , samples_since_last_pulse(0)
+        : last_cv1_value(0)
         , kMain_offset(0)
         , kX_offset(0)
         , kY_offset(0)
+        , kMain2_offset(0)
+        , kX2_offset(VOICE2_DETUNE)
+        , kY2_offset(0)
         , switch_down_samples(0)
         , hold_reset_applied(false)
         , prev_switch_state(Switch::Middle)
         , rng_state(0xA5F1523Du)
     {
+        // Bitcrusher: 48k/8 = 6kHz, and 12-6 = 6-bit
+        crusher1.SetHold(8);
+        crusher1.SetBits(6);
+        crusher2.SetHold(8);
+        crusher2.SetBits(6);
+
         // Freeverb removed from main.
-        // Warm up all algos so internal states (e.g., reverbs/filters) settle.
-        warmupAllAlgos(1024); // ~125 ms at 48 kHz
+        // Algorithms are warmed on demand (on core1) when first selected, rather than all at boot.
+#ifdef COMPUTERCARD_HAS_MULTICORE
+        RunOnCore1(&NoiseDemo::Core1Loop);
+#endif
     }
     virtual void ProcessSample()
+    {
+        const Controls c = readControls(1, AudioIn1());
+
+        // Crossfades to a newly selected algorithm once core1 has warmed it up
+        int16_t s = voice1.next(c.algo, c.kX, c.kY);
+
+        const int32_t vca = vcaGain(AudioIn2());
+        const bool crush = crushEnabled();
+        s = applyVca(s, vca);
+        if (crush) s = crusher1.Process(s);
+        s = processOutput(s, 1);
+        AudioOut1(s);
+#ifdef NOISEBOX_VOICE2
+        // Second voice from core1, through the same VCA and crusher settings
+        publishVoice2Controls(c);
+        int16_t s2;
+        readVoice2(&s2, 1);
+        s2 = applyVca(s2, vca);
+        if (crush) s2 = crusher2.Process(s2);
+        AudioOut2(s2);
+#else
+        AudioOut2(s);
+#endif
+
+        updateLeds();
+    }
+
+    // Block mode: controls are read and algorithm parameters decoded once per block
+    virtual void ProcessBlock(const Frame *in, Frame *out, int n)
+    {
+        const Controls c = readControls(n, in[0].audio[0]);
+
+        int16_t buf[blockSize];
+        voice1.render(c.algo, buf, n, c.kX, c.kY);
+#ifdef NOISEBOX_VOICE2
+        int16_t buf2[blockSize];
+        publishVoice2Controls(c);
+        readVoice2(buf2, n);
+#endif
+
+        for (int j = 0; j < n; ++j)
+        {
+            const int32_t vca = vcaGain(in[j].audio[1]);
+            buf[j] = applyVca(buf[j], vca);
+#ifdef NOISEBOX_VOICE2
+            buf2[j] = applyVca(buf2[j], vca);
+#endif
+        }
+        if (crushEnabled())
+        {
+            crusher1.ProcessBlock(buf, n);
+#ifdef NOISEBOX_VOICE2
+            crusher2.ProcessBlock(buf2, n);
+#endif
+        }
+
+        for (int j = 0; j < n; ++j)
+        {
+            // Pulse edges are only reported on the first frame of a block
+            int16_t s = processOutput(buf[j], j == 0 ? n : 0);
+            out[j].audio[0] = s;
+#ifdef NOISEBOX_VOICE2
+            out[j].audio[1] = buf2[j];
+#else
+            out[j].audio[1] = s;
+#endif
+        }
+
+        updateLeds();
+    }
+
+private:
+    // Hold reset after 2.5 seconds at 48kHz
+    static constexpr uint32_t HOLD_RESET_SAMPLES = 120000; // 2.5s * 48k
+    // Minimal guard to avoid zero-length ramps
+    static constexpr uint32_t MIN_PERIOD_SAMPLES = 1;
+
+    // Offset of voice 2's X control from voice 1's while the randomized offsets are reset, so the
+    // two voices start as slightly detuned copies rather than identical ones
+    static constexpr int32_t VOICE2_DETUNE = 24;
+
+    struct Controls
+    {
+        uint16_t kX, kY;   // X/Y parameters for the selected algorithm, 0..4095
+        int algo;          // selected algorithm
+        uint16_t kX2, kY2; // the same for voice 2 (Audio Out 2)
+        int algo2;
+    };
+
+    // Read knobs, CV and the Z switch; frames = samples since the last call
+    inline Controls readControls(int frames, int16_t audioIn1)
     {
         // Read controls
         int32_t main_knob_value_0_to_4095 = KnobVal(Knob::Main);
@@ -64,6 +161,10 @@ public:
                 kMain_offset = static_cast<int32_t>(nextRand4096());
                 kX_offset    = static_cast<int32_t>(nextRand4096());
                 kY_offset    = static_cast<int32_t>(nextRand4096());
+                // Voice 2 gets its own draw, so it lands on an independent algorithm and settings
+                kMain2_offset = static_cast<int32_t>(nextRand4096());
+                kX2_offset    = static_cast<int32_t>(nextRand4096());
+                kY2_offset    = static_cast<int32_t>(nextRand4096());
                 switch_down_samples = 0;
                 hold_reset_applied = false;
             }
@@ -72,11 +173,15 @@ public:
                 // Held: count samples and reset if held long enough
                 if (!hold_reset_applied)
                 {
-                    if (++switch_down_samples >= HOLD_RESET_SAMPLES)
+                    switch_down_samples += static_cast<uint32_t>(frames);
+                    if (switch_down_samples >= HOLD_RESET_SAMPLES)
                     {
                         kMain_offset = 0;
                         kX_offset = 0;
                         kY_offset = 0;
+                        kMain2_offset = 0;
+                        kX2_offset = VOICE2_DETUNE;
+                        kY2_offset = 0;
                         hold_reset_applied = true;
                     }
                 }
@@ -91,230 +196,188 @@ public:
         
         // Sum CV with X/Y knobs and per-session offsets; wrap to 0..4095 (modulo)
         auto wrap4096 = [](int32_t v){ v %= 4096; if (v < 0) v += 4096; return static_cast<uint16_t>(v); };
-        uint16_t kX = wrap4096(static_cast<int32_t>(cv1_raw) + KnobVal(Knob::X) + kX_offset);
-        uint16_t kY = wrap4096(static_cast<int32_t>(cv2_raw) + KnobVal(Knob::Y) + kY_offset);
+        const int32_t kX_in = static_cast<int32_t>(cv1_raw) + KnobVal(Knob::X);
+        const int32_t kY_in = static_cast<int32_t>(cv2_raw) + KnobVal(Knob::Y);
+        Controls c;
+        c.kX = wrap4096(kX_in + kX_offset);
+        c.kY = wrap4096(kY_in + kY_offset);
+        c.kX2 = wrap4096(kX_in + kX2_offset);
+        c.kY2 = wrap4096(kY_in + kY2_offset);
 
         // Also allow CV offset of Main knob, with wrap-around (0..4095)
         // Positive CV beyond max wraps back around
-        int32_t kMain_wrapped = (main_knob_value_0_to_4095 + static_cast<int32_t>(AudioIn1()) + kMain_offset) % 4096;
-        if (kMain_wrapped < 0) kMain_wrapped += 4096;
+        const int32_t kMain_in = main_knob_value_0_to_4095 + static_cast<int32_t>(audioIn1);
+        c.algo = selectAlgo(kMain_in + kMain_offset);
+        c.algo2 = selectAlgo(kMain_in + kMain2_offset);
+        return c;
+    }
 
-        // Dynamically select algorithm based on number of algos and knob position
-        // Order: ResoNoise, RadioOhNo, CrossModRingSquare, CrossModRingSine, ClusterSaw, Basurilla, PwCluster, ArrayOnTheRocks, RwalkModWave, Atari, ExistencelsPain, BasuraTotal
+    // Dynamically select algorithm based on number of algos and (wrapped) knob position
+    // Order: ResoNoise, RadioOhNo, CrossModRingSquare, CrossModRingSine, ClusterSaw, Basurilla, PwCluster, ArrayOnTheRocks, Atari, SatanWorkout, S_H, BasuraTotal, ExistencelsPain
+    static inline int selectAlgo(int32_t kMain)
+    {
+        int32_t kMain_wrapped = kMain % 4096;
+        if (kMain_wrapped < 0) kMain_wrapped += 4096;
 
-        // List of algorithm lambdas for dynamic dispatch
-        constexpr int num_algos = 13;
-        int16_t s = 0;
         int algo_index = (kMain_wrapped * num_algos) / 4096;
         if (algo_index < 0) algo_index = 0;
         if (algo_index >= num_algos) algo_index = num_algos - 1;
+        return algo_index;
+    }
 
-        switch (algo_index)
-        {
-            case 0:
-                s = reso.nextSample(kX, kY);
-                break;
-            case 1:
-                s = radio.nextSample(kX, kY);
-                break;
-            case 2:
-                s = static_cast<int16_t>(xmodring.process(kX, kY));
-                break;
-            case 3:
-                s = static_cast<int16_t>(xmodringsine.process(kX, kY));
-                break;
-            case 4:
-                s = static_cast<int16_t>(clustersaw.process(kX, kY));
-                break;
-            case 5:
-                s = static_cast<int16_t>(basurilla.process(kX, kY));
-                break;
-            case 6:
-                s = static_cast<int16_t>(pwcluster.process(kX, kY));
-                break;
-            case 7:
-                s = static_cast<int16_t>(arrayrocks.process(kX, kY));
-                break;
-            case 8:
-                s = static_cast<int16_t>(atari.process(kX, kY));
-                break;
-            case 9:
-                s = static_cast<int16_t>(satanworkout.process(kX, kY));
-                break;
-            case 10:
-                s = samplehold.nextSample(kX, kY);  
-                break;
-            case 11:
-                s = static_cast<int16_t>(basuratotal.process(kX, kY));
-                break;
-            default:
-                s = static_cast<int16_t>(existencels.process(kX, kY));
-                break;
-        }
-
-        int32_t vca_0_to_4095 = Connected(Input::Audio2) ? (AudioIn2() + 2048) : 4095;
+    // VCA gain 0..4095 from Audio In 2 (fully open when unplugged)
+    inline int32_t vcaGain(int16_t audioIn2)
+    {
+        int32_t vca_0_to_4095 = Connected(Input::Audio2) ? (audioIn2 + 2048) : 4095;
         if (vca_0_to_4095 < 0) vca_0_to_4095 = 0;
         if (vca_0_to_4095 > 4095) vca_0_to_4095 = 4095;
-        s = static_cast<int16_t>((static_cast<int32_t>(s) * vca_0_to_4095) >> 12);
+        return vca_0_to_4095;
+    }
 
-        // Engage bit/sample rate reducer when the Z switch is Up, or when PulseIn2 gate is high
-        LedOn(1, PulseIn2());
-        if (SwitchVal() == Switch::Up || PulseIn2())
-        {
-            // Sample rate reduction via sample-and-hold
-            if (sampleHoldCounter == 0)
-            {
-                heldSample = s;
-            }
-            s = heldSample;
-            sampleHoldCounter++;
-            if (sampleHoldCounter >= sampleHoldPeriod) sampleHoldCounter = 0;
-
-            int32_t su = static_cast<int32_t>(s) + 2048; // map to 0..4095
-            if (su < 0) su = 0; else if (su > 4095) su = 4095;
-            su = (su >> bitReductionShift) << bitReductionShift;
-            s = static_cast<int16_t>(su - 2048);
-        }
+    // Engage bit/sample rate reducer when the Z switch is Up, or when PulseIn2 gate is high
+    inline bool crushEnabled() { return SwitchVal() == Switch::Up || PulseIn2(); }
+
+    // VCA for one output sample
+    static inline int16_t applyVca(int16_t s, int32_t vca_0_to_4095)
+    {
+        return static_cast<int16_t>((static_cast<int32_t>(s) * vca_0_to_4095) >> 12);
+    }
 
-        // Advance pulse sample counter each sample
-        samples_since_last_pulse++;
+    // Pulse-clocked CV sample & hold and pulse outs for one (Audio Out 1) output sample.
+    // blockStart: n on the first sample of a block of n (when PulseIn1 edges are checked and the
+    // CV2 ramp is worked out for the block), else 0
+    inline int16_t processOutput(int16_t s, int blockStart)
+    {
+        // Advance pulse clock each sample
+        pulseClock.Tick();
 
         // On a rising edge at PulseIn1, sample-and-hold current audio sample 's' to CV Out 1
-        if (PulseIn1RisingEdge())
+        if (blockStart && PulseIn1RisingEdge())
         {
             // Output CV1 immediately with the sampled value
             CVOut1(s);
             PulseOut1(s > 0);
-            
-            // Measure period naively from last pulse
-            uint32_t measured = samples_since_last_pulse;
-            samples_since_last_pulse = 0;
-            if (measured == 0) measured = 1; // avoid divide-by-zero
-            uint32_t period_for_slew = measured;
-
-            // Set up the slew between the last and current CVOut1 values (last pulse -> this pulse)
-            int16_t start_val = have_prev_cv1 ? last_cv1_value : s;
-            int32_t target_val_q16 = static_cast<int32_t>(s) << 16;
-            // If it's the first pulse, initialise CV2 to the same as CV1 and do not slew
-            if (!have_prev_cv1)
+
+            // CV2 slews from the previous CV1 value to this one over one (jitter-smoothed) clock
+            // period; on the first pulse it just jumps to the same value as CV1
+            pulseClock.Clock();
+            if (pulseClock.Valid())
             {
-                cv2_current_q16 = target_val_q16;
-                cv2_target_q16 = target_val_q16;
-                cv2_step_q16 = 0;
-                cv2_slew_samples_left = 0;
-                have_prev_cv1 = true;
+                cv2Ramp.Reset(last_cv1_value);
+                cv2Ramp.SetTarget(s, pulseClock.SmoothedPeriod());
             }
             else
             {
-                // Start new ramp at the previous CV1 value
-                cv2_current_q16 = static_cast<int32_t>(start_val) << 16;
-                cv2_target_q16 = target_val_q16;
-                cv2_slew_samples_left = period_for_slew;
-                if (cv2_slew_samples_left == 0)
-                {
-                    cv2_step_q16 = 0;
-                }
-                else
-                {
-                    cv2_step_q16 = (cv2_target_q16 - cv2_current_q16) / static_cast<int32_t>(cv2_slew_samples_left);
-                }
+                cv2Ramp.Reset(s);
             }
 
             // Update last CV1 value for next interval
             last_cv1_value = s;
         }
+        if (blockStart) cv2Ramp.Block(static_cast<uint32_t>(blockStart));
 
         // Progress CV2 slew each sample and output
-        if (cv2_slew_samples_left > 0)
-        {
-            cv2_current_q16 += cv2_step_q16;
-            cv2_slew_samples_left--;
-            if (cv2_slew_samples_left == 0)
-            {
-                cv2_current_q16 = cv2_target_q16;
-            }
-        }
-        int16_t cv2_out_i16 = static_cast<int16_t>(cv2_current_q16 >> 16);
-        CVOut2(cv2_out_i16);
+        CVOut2(static_cast<int16_t>(cv2Ramp.Next()));
 
         // Drive pulse outs from current audio polarity
         PulseOut2(s > 0);
+        return s;
+    }
 
-        AudioOut1(s);
-        AudioOut2(s);
-
+    inline void updateLeds()
+    {
         // Minimal visual feedback
         for (int i = 0; i < 6; ++i) LedOff(i);
         LedOn(0, true);
+        LedOn(1, PulseIn2());
+    }
 
+    static constexpr int num_algos = NoiseVoice::num_algos;
+
+    // Voice 1 plays on Audio Out 1 (and the CV/pulse outs), rendered on core0
+    NoiseVoice voice1;
+
+#ifdef NOISEBOX_VOICE2
+    // Voice 2 is owned by core1, which renders it ahead into voice2Fifo for Audio Out 2
+    static constexpr int VOICE2_BLOCK = 32;
+    struct Voice2Block
+    {
+        int16_t s[VOICE2_BLOCK];
+    };
+    NoiseVoice voice2;
+    ComputerCard::Ring<Voice2Block, 4> voice2Fifo; // core1 -> core0, ~2.7 ms at most
+    uint32_t voice2Controls = 0;                   // core0 -> core1: kX2 | kY2 << 12 | algo2 << 24
+    Voice2Block voice2Current;                     // core0: block being played
+    int voice2Pos = VOICE2_BLOCK;                  // core0: next sample in voice2Current
+
+    // Core0: hand voice 2's controls to core1 (picked up by the next block it renders)
+    inline void publishVoice2Controls(const Controls& c)
+    {
+        const uint32_t packed = static_cast<uint32_t>(c.kX2) | (static_cast<uint32_t>(c.kY2) << 12)
+                              | (static_cast<uint32_t>(c.algo2) << 24);
+        __atomic_store_n(&voice2Controls, packed, __ATOMIC_RELAXED);
     }
 
-private:
-    // Hold reset after 2.5 seconds at 48kHz
-    static constexpr uint32_t HOLD_RESET_SAMPLES = 120000; // 2.5s * 48k
-    // Minimal guard to avoid zero-length ramps
-    static constexpr uint32_t MIN_PERIOD_SAMPLES = 1;
+    // Core0: next n samples of voice 2; silence if core1 has fallen behind
+    inline void readVoice2(int16_t* out, int n)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            if (voice2Pos == VOICE2_BLOCK)
+            {
+                if (!voice2Fifo.Pop(voice2Current))
+                {
+                    for (; j < n; ++j) out[j] = 0;
+                    return;
+                }
+                voice2Pos = 0;
+            }
+            out[j] = voice2Current.s[voice2Pos++];
+        }
+    }
+#endif
 
-    // Run each algorithm for a number of samples to allow internal DSP to settle
-    inline void warmupAllAlgos(int samplesPerAlgo)
+#ifdef COMPUTERCARD_HAS_MULTICORE
+    // Core1, forever: keep voice 2's FIFO topped up, and warm algorithms up (for either voice) a chunk
+    // at a time in between, so a warm-up never holds voice 2 up for long
+    void Core1Loop()
     {
-        if (samplesPerAlgo <= 0) return;
-        const uint16_t x_q12 = 2048;
-        const uint16_t y_q12 = 2048;
-
-        // Helpers to avoid code repetition
-        auto clamp4095 = [](int v){ if(v<0) return 0; if(v>4095) return 4095; return v; };
-        const int kx = clamp4095(2048);
-        const int ky = clamp4095(2048);
-
-        for (int i = 0; i < samplesPerAlgo; ++i) reso.nextSample(x_q12, y_q12);
-        for (int i = 0; i < samplesPerAlgo; ++i) radio.nextSample(x_q12, y_q12);
-        for (int i = 0; i < samplesPerAlgo; ++i) (void)xmodring.process(kx, ky);
-        for (int i = 0; i < samplesPerAlgo; ++i) (void)xmodringsine.process(kx, ky);
-        for (int i = 0; i < samplesPerAlgo; ++i) (void)clustersaw.process(kx, ky);
-        for (int i = 0; i < samplesPerAlgo; ++i) (void)basurilla.process(kx, ky);
-        for (int i = 0; i < samplesPerAlgo; ++i) (void)pwcluster.process(kx, ky);
-        for (int i = 0; i < samplesPerAlgo; ++i) (void)arrayrocks.process(kx, ky);
-        for (int i = 0; i < samplesPerAlgo; ++i) (void)atari.process(kx, ky);
-        for (int i = 0; i < samplesPerAlgo; ++i) (void)basuratotal.process(kx, ky);
-        for (int i = 0; i < samplesPerAlgo; ++i) (void)samplehold.nextSample(x_q12, y_q12);
-        for (int i = 0; i < samplesPerAlgo; ++i) (void)satanworkout.process(kx, ky);
-        for (int i = 0; i < samplesPerAlgo; ++i) (void)existencels.process(kx, ky);
+        while (true)
+        {
+#ifdef NOISEBOX_VOICE2
+            if (!voice2Fifo.Full())
+            {
+                const uint32_t packed = __atomic_load_n(&voice2Controls, __ATOMIC_RELAXED);
+                Voice2Block b;
+                voice2.render(static_cast<int>(packed >> 24), b.s, VOICE2_BLOCK,
+                              static_cast<uint16_t>(packed & 0x0FFF), static_cast<uint16_t>((packed >> 12) & 0x0FFF));
+                voice2Fifo.Push(b);
+                continue;
+            }
+            if (voice1.serviceWarmup()) continue;
+            if (!voice2.serviceWarmup()) tight_loop_contents();
+#else
+            if (!voice1.serviceWarmup()) tight_loop_contents();
+#endif
+        }
     }
+#endif
+
+    // Bit/sample rate reducers, one per audio output
+    fxp::PostFX crusher1, crusher2;
 
-    ResoNoiseAlgo reso;
-    RadioOhNoAlgo radio;
-    CrossModRingSquare xmodring;
-    CrossModRingSine xmodringsine;
-    ClusterSaw clustersaw;
-    Basurilla basurilla;
-    PwCluster pwcluster;
-    ArrayOnTheRocks arrayrocks;
-    Atari atari;
-    ExistencelsPain existencels;
-    BasuraTotalAlgo basuratotal;
-    SampleHoldReverbAlgo samplehold;
-    SatanWorkoutAlgo satanworkout;
-
-    // Crusher state
-    int sampleHoldCounter;
-    int sampleHoldPeriod;      // e.g., 8 -> 48k/8 = 6kHz effective
-    int16_t heldSample;
-    uint8_t bitReductionShift; // 4 -> 12-4 = 8-bit effective
-
-    // CV2 slew state
-    int32_t cv2_current_q16;
-    int32_t cv2_target_q16;
-    int32_t cv2_step_q16;
-    uint32_t cv2_slew_samples_left;
+    // CV2 slew state: a linear ramp over one clock period, worked out per block
+    Ramp cv2Ramp;
+    ClockTracker pulseClock;
     int16_t last_cv1_value;
-    bool have_prev_cv1;
-    uint32_t samples_since_last_pulse;
     
     // Randomized knob offsets (0..4095)
     int32_t kMain_offset;
     int32_t kX_offset;
     int32_t kY_offset;
+    int32_t kMain2_offset; // voice 2
+    int32_t kX2_offset;
+    int32_t kY2_offset;
     
     // Switch hold detection
     uint32_t switch_down_samples;
@@ -336,7 +399,7 @@ int main()
 { 
 	set_sys_clock_khz(225000, true);
     NoiseDemo demo;
-    // Enable jack-detection (normalisation probe) so Connected/Disconnected works
-    demo.EnableNormalisationProbe();
+    // Enable jack-detection (normalisation probe) so Connected/Disconnected works, checking jacks every 100ms
+    demo.EnableNormalisationProbe(ComputerCard::ProbeBursts);
     demo.Run();
 }
@@ -16,8 +16,11 @@ See examples/ directory
 #ifndef COMPUTERCARD_H
 #define COMPUTERCARD_H
 
+#include "hardware/flash.h"
 #include "hardware/gpio.h"
 #include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include <cstring>
 
 #define PULSE_1_RAW_OUT 8
 #define PULSE_2_RAW_OUT 9
@@ -61,6 +64,163 @@ public:
 	/// Use before Run() to enable Connected/Disconnected detection
 	void EnableNormalisationProbe() {useNormProbe = true;}
 
+	/** \brief Large fixed-size slots in flash, saved in the background
+
+		For large blocks of data, such as recorded loops: NumSlots slots of up to SlotBytes
+		each, in whole sectors below the top reserveSectors of flash. Save starts saving a
+		buffer in RAM to a slot, and Service, called regularly from the core that is not
+		running the audio, does the writing, erasing one sector or programming one page
+		per call. Each page is only copied from the
+		buffer as it is programmed, so no second copy of the buffer is needed, and the
+		buffer may carry on changing during the save (the slot then holds each page as it
+		was when programmed). The slot's header, with a sequence number and a tag word for
+		the caller's own use, is programmed last, so a save interrupted by a reset or power
+		loss leaves the slot empty rather than half-written.
+
+		Data points to a slot's contents in flash, to be read directly (e.g. to play a slot
+		back at once, while it is copied to RAM), except while Busy. As flash cannot be
+		read while it is written, the audio core must be running entirely from SRAM
+		(the copy_to_ram binary type) while saving.
+	*/
+	template <unsigned SlotBytes, unsigned NumSlots>
+	class FlashSlots
+	{
+		static constexpr unsigned SectorBytes = FLASH_SECTOR_SIZE;
+		static constexpr unsigned PageBytes = FLASH_PAGE_SIZE;
+		static_assert(SlotBytes > 0 && NumSlots > 0, "FlashSlots needs at least one slot");
+	public:
+		/// Sectors taken by each slot: a header page, then the data
+		static constexpr unsigned SlotSectors = (PageBytes + SlotBytes + SectorBytes - 1) / SectorBytes;
+
+		FlashSlots(unsigned reserveSectors = 0)
+			: base(PICO_FLASH_SIZE_BYTES - (reserveSectors + NumSlots * SlotSectors) * SectorBytes) {}
+
+		/// Number of bytes saved in slot, or 0 if it is empty
+		unsigned Size(unsigned slot) const {return Valid(slot) ? SlotHeader(slot)->size : 0;}
+		/// Tag word given to Save for slot
+		uint32_t Tag(unsigned slot) const {return Valid(slot) ? SlotHeader(slot)->tag : 0;}
+		/// Contents of slot, in flash. Not to be read while Busy
+		const uint8_t *Data(unsigned slot) const {return FlashPtr(slot * SlotSectors * SectorBytes + PageBytes);}
+
+		/// The most recently saved slot, or -1 if all are empty
+		int Newest() const
+		{
+			int newest = -1;
+			for (unsigned s=0; s<NumSlots; s++)
+			{
+				if (Valid(s) && (newest < 0 || int32_t(SlotHeader(s)->seq - SlotHeader(newest)->seq) > 0)) newest = s;
+			}
+			return newest;
+		}
+
+		/** \brief Start saving size bytes (at most SlotBytes) of data to slot
+
+			Returns false, doing nothing, if a save is already in progress.
+			data must stay valid until Busy returns false.
+		*/
+		bool Save(unsigned slot, const void *data, unsigned size, uint32_t tag = 0)
+		{
+			if (slot >= NumSlots || size == 0 || size > SlotBytes || Busy()) return false;
+			saveSlot = slot;
+			saveData = static_cast<const uint8_t *>(data);
+			saveSize = size;
+			saveTag = tag;
+			step = 0;
+			__atomic_store_n(&busy, true, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		/// True from Save until the slot has been written
+		bool Busy() const {return __atomic_load_n(&busy, __ATOMIC_ACQUIRE);}
+
+		/** \brief Do the next step of a save in progress: erase a sector, or program a page
+
+			Call regularly from the core not running the audio. Sectors are erased first,
+			starting with the one holding the header, then the data pages are programmed
+			in order, then the header. Returns true if flash was modified.
+		*/
+		bool Service()
+		{
+			if (!Busy()) return false;
+
+			uint32_t slotOffset = saveSlot * SlotSectors * SectorBytes;
+			unsigned sectors = (PageBytes + saveSize + SectorBytes - 1) / SectorBytes;
+			unsigned pages = (saveSize + PageBytes - 1) / PageBytes;
+			if (step < sectors)
+			{
+				Erase(slotOffset + step * SectorBytes);
+			}
+			else if (step < sectors + pages)
+			{
+				unsigned offset = (step - sectors) * PageBytes;
+				unsigned n = saveSize - offset < PageBytes ? saveSize - offset : PageBytes;
+				memcpy(page, saveData + offset, n);
+				memset(page + n, 0xFF, PageBytes - n);
+				Program(slotOffset + PageBytes + offset, page);
+			}
+			else
+			{
+				int newest = Newest();
+				Header *h = reinterpret_cast<Header *>(page);
+				h->magic = Magic;
+				h->seq = newest < 0 ? 1 : SlotHeader(newest)->seq + 1;
+				h->size = saveSize;
+				h->tag = saveTag;
+				h->check = Check(h);
+				memset(page + sizeof(Header), 0xFF, PageBytes - sizeof(Header));
+				Program(slotOffset, page);
+				__atomic_store_n(&busy, false, __ATOMIC_RELEASE);
+			}
+			step++;
+			return true;
+		}
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t seq;   // one more than the newest slot's, at each save
+			uint32_t size;  // of data following the header page
+			uint32_t tag;
+			uint32_t check; // of seq, size and tag
+		};
+		static constexpr uint32_t Magic = 0x4343534C; // "CCSL"
+
+		static uint32_t Check(const Header *h) {return ~(h->seq ^ (h->size * 0x9E3779B1) ^ (h->tag * 0x85EBCA77));}
+
+		const Header *SlotHeader(unsigned slot) const {return reinterpret_cast<const Header *>(FlashPtr(slot * SlotSectors * SectorBytes));}
+
+		bool Valid(unsigned slot) const
+		{
+			if (slot >= NumSlots) return false;
+			const Header *h = SlotHeader(slot);
+			return h->magic == Magic && h->size > 0 && h->size <= SlotBytes && h->check == Check(h);
+		}
+
+		const uint8_t *FlashPtr(uint32_t offset) const {return reinterpret_cast<const uint8_t *>(XIP_BASE + base + offset);}
+
+		void Erase(uint32_t offset)
+		{
+			uint32_t ints = save_and_disable_interrupts();
+			flash_range_erase(base + offset, SectorBytes);
+			restore_interrupts(ints);
+		}
+
+		void Program(uint32_t offset, const uint8_t *data)
+		{
+			uint32_t ints = save_and_disable_interrupts();
+			flash_range_program(base + offset, data, PageBytes);
+			restore_interrupts(ints);
+		}
+
+		uint32_t base;
+		alignas(4) uint8_t page[PageBytes];
+		const uint8_t *saveData = nullptr;
+		unsigned saveSlot = 0, saveSize = 0, step = 0;
+		uint32_t saveTag = 0;
+		bool busy = false;
+	};
+
 protected:
 	/// Callback, called once per sample at 48kHz
 	virtual void ProcessSample() = 0;
@@ -1,20 +1,216 @@
 
 #include "ComputerCard.h"
+#include "pico/multicore.h"
+#include "exp2.h"
+
+// Loop memory for CV, delta-encoded
+//
+// Samples are stored in blocks of 16: the first as a 16-bit value, and each
+// of the rest as an 8-bit difference from the one before, so a block takes 17
+// bytes rather than 32. Differences are limited to +/-127, with the error
+// carried into the next one, so a jump in the CV is slewed over a few samples
+// and the next block starts out exact again. A sample is read by adding up
+// the differences before it in its block.
+//
+// Blocks are encoded whole, so samples written are collected by a writer
+// (one per record head) and the block encoded, keeping any samples that were
+// not written, when that writer moves on to another block. Until then, reads
+// of those samples come from the writer.
+//
+// A loop saved to flash is loaded lazily: blocks are read from the saved copy
+// in flash until the second core has copied them in with LoadBlocks.
+template <unsigned nBlocks>
+class DeltaStore
+{
+public:
+	constexpr static unsigned blockSize = 16;
+	constexpr static unsigned size = nBlocks * blockSize;
+	constexpr static unsigned nWriters = 2;
+
+	// The blocks, as saved to flash
+	struct Encoded
+	{
+		int16_t base[nBlocks];
+		int8_t delta[nBlocks][blockSize-1];
+	};
+
+	DeltaStore()
+	{
+		for (unsigned b=0; b<nBlocks; b++)
+		{
+			enc.base[b] = 0;
+			for (unsigned j=0; j<blockSize-1; j++)
+			{
+				enc.delta[b][j] = 0;
+			}
+		}
+		for (unsigned w=0; w<nWriters; w++)
+		{
+			writers[w].block = 0;
+			writers[w].mask = 0;
+		}
+		image = nullptr;
+		loadedBlocks = nBlocks;
+	}
+
+	void Write(unsigned writer, unsigned ind, int16_t value)
+	{
+		Writer &w = writers[writer];
+		unsigned block = ind / blockSize;
+		if (block != w.block)
+		{
+			Flush(w);
+			w.block = block;
+		}
+		w.values[ind % blockSize] = value;
+		w.mask |= 1 << (ind % blockSize);
+	}
+
+	int16_t Read(unsigned ind)
+	{
+		unsigned block = ind / blockSize, k = ind % blockSize;
+		for (unsigned w=0; w<nWriters; w++)
+		{
+			if (writers[w].block == block && (writers[w].mask & (1 << k)))
+			{
+				return writers[w].values[k];
+			}
+		}
+		return Decode(block, k);
+	}
+
+	// Encode any samples still held by the writers, and return the blocks, e.g. to save them
+	const Encoded &Data()
+	{
+		for (unsigned w=0; w<nWriters; w++)
+		{
+			Flush(writers[w]);
+		}
+		return enc;
+	}
+
+	// Start loading saved blocks from saved, discarding anything not yet encoded.
+	// Nothing may be written until Loading returns false
+	void BeginLoad(const Encoded *saved)
+	{
+		for (unsigned w=0; w<nWriters; w++)
+		{
+			writers[w].mask = 0;
+		}
+		image = saved;
+		__atomic_store_n(&loadedBlocks, 0, __ATOMIC_RELEASE);
+	}
+
+	// Copy up to n more blocks in from the saved copy (from the second core)
+	void LoadBlocks(unsigned n)
+	{
+		unsigned loaded = __atomic_load_n(&loadedBlocks, __ATOMIC_ACQUIRE);
+		if (loaded + n > nBlocks) n = nBlocks - loaded;
+		for (unsigned b=loaded; b<loaded+n; b++)
+		{
+			enc.base[b] = image->base[b];
+			for (unsigned j=0; j<blockSize-1; j++)
+			{
+				enc.delta[b][j] = image->delta[b][j];
+			}
+		}
+		__atomic_store_n(&loadedBlocks, loaded + n, __ATOMIC_RELEASE);
+	}
+
+	bool Loading() const {return __atomic_load_n(&loadedBlocks, __ATOMIC_ACQUIRE) < nBlocks;}
+
+private:
+	struct Writer
+	{
+		unsigned block;
+		uint16_t mask; // Which of values[] have been written
+		int16_t values[blockSize];
+	};
+
+	int16_t Decode(unsigned block, unsigned k)
+	{
+		const Encoded &e = block < __atomic_load_n(&loadedBlocks, __ATOMIC_ACQUIRE) ? enc : *image;
+		int32_t value = e.base[block];
+		for (unsigned j=0; j<k; j++)
+		{
+			value += e.delta[block][j];
+		}
+		return value;
+	}
+
+	void Flush(Writer &w)
+	{
+		if (!w.mask) return;
+
+		// Fill in the samples that weren't written from the block as it was
+		for (unsigned k=0; k<blockSize; k++)
+		{
+			if (!(w.mask & (1 << k)))
+			{
+				w.values[k] = Decode(w.block, k);
+			}
+		}
+
+		int32_t value = w.values[0];
+		enc.base[w.block] = value;
+		for (unsigned k=1; k<blockSize; k++)
+		{
+			int32_t d = w.values[k] - value;
+			if (d > 127) d = 127;
+			if (d < -127) d = -127;
+			enc.delta[w.block][k-1] = d;
+			value += d;
+		}
+		w.mask = 0;
+	}
+
+	Encoded enc;
+	Writer writers[nWriters];
+	const Encoded *image;  // Saved copy being loaded
+	unsigned loadedBlocks; // Blocks below this are in enc
+};
 
 class CVMod : public ComputerCard
 {
-	// Buffer for recording
-	constexpr static unsigned maxLoopSize = 96000;
-	int16_t buffer[maxLoopSize];
-
-	// Lookup table for powers of two
-	uint32_t pow2_128[128];
+	// Buffer for recording, 180704 samples in the 192kB that 96000 int16_t used to take
+	typedef DeltaStore<11294> LoopBuffer;
+	LoopBuffer buffer;
+
+	// Saved loops, in flash
+	constexpr static unsigned nSlots = 4;
+	FlashSlots<sizeof(LoopBuffer::Encoded), nSlots> slots;
+	unsigned currentSlot;
+	int loadSlot;          // Slot chosen, to be loaded once flash is free, or -1
+	int saveSlot;          // Slot for the second core to save to, or -1
+	const void *saveData;
+	uint32_t saveTag;
+
+	// Loop held: playing, but not recording, at its loop length when held
+	bool recordHold, holdTrigger;
+
+	// Switch held down for slotSelectTime to choose a slot with the main knob
+	constexpr static unsigned slotSelectTime = 12000; // 1s
+	unsigned switchDownTime;
+	bool slotSelect;
+	int32_t lastSpeedKnob;
+
+	// Loops longer than the buffer are recorded at 12kHz / 2^recordShift
+	constexpr static unsigned maxLoopSize = 768000; // 64s
+	constexpr static unsigned maxRecordShift = 3;
+	unsigned recordShift;
+	int32_t recordFilter1, recordFilter2; // Anti-aliasing lowpass, <<8
 
 	
-	// Recording loop
+	// Recording loop, in 12kHz samples, and in buffer samples
 	uint32_t loopSize, loopIndex;
-
-	uint32_t playbackPhase[4];
+	uint32_t bufferLoopSize;
+
+	// Playback heads, each a phase through the loop. Their increments, which need
+	// Pow2 and a 64-bit multiply, are worked out once every headBlock ticks
+	constexpr static unsigned nHeads = 4;
+	constexpr static unsigned headBlock = 8;
+	uint32_t playbackPhase[nHeads], playbackIncrement[nHeads];
+	unsigned headBlockCount;
 	uint32_t recordPhase;
 
 	int32_t timeKnob;
@@ -29,40 +225,13 @@ class CVMod : public ComputerCard
 
 	uint32_t lastExtraRecordingIndex;
 	
-	// Return integer part of 2^(in/4096) (approximate)
-	// 7-bit lookup table (128 entries), 5-bit (32-step) linear interpolation between steps
-	uint32_t Pow2(uint32_t in)
-	{
-		uint32_t oct = in >> 12; // floor(in/4096)
-
-		// Table index and value of lookup
-		uint32_t ind1 = (in & 0xFE0) >> 5;  // 0xFE0 = 111111100000
-		uint32_t val1 = pow2_128[ind1];
-
-		// Next lookup
-		uint32_t ind2 = (ind1 + 1) & 0x7F; //
-		uint32_t val2 = pow2_128[ind2];
-		if (ind2 == 0) val2 <<= 1; // interpolating between end of one octave and the start of another
-
-		// Linearly interpolate with 32 steps
-		uint32_t subsample = in & 0x1F;
-		uint32_t val = val1*(32-subsample) + val2*subsample;
-
-		val >>= 31 - oct;
-
-		return val;
-	}
-
 	int32_t PhaseAdvance(int32_t i, int32_t speedKnob, uint32_t loopIncrement)
 	{
 		// loopIncrement = 2^32 / loopSize is at most 22.5 bits
-		// loopIncrement = 2^32 / 96000 at minimum
-		// Pow2 is at most 10+(1900*3*2)/4096 = 12.78 bits
-		// loopIncrement * 2^(speedKnob*(2*i-3)*k)
-		// loopIncrement * (2^(10 + speedKnob*(2*i-3)*2)) >> 10
-		// ((loopIncrement>>5) * (2^(10 + speedKnob*(2*i-3)*2)) >> 5
+		// loopIncrement = 2^32 / 768000 at minimum, too few bits to drop any before multiplying, so in 64 bits
+		// loopIncrement * 2^(speedKnob*(2*i-3)*2/4096), up to 2^2.78 times faster
 
-		return ((loopIncrement>>5) * Pow2(10*4096 + speedKnob*2*(2*i-3))) >> 5;
+		return exp2_increment(loopIncrement, speedKnob*2*(2*i-3));
 	}
 
 	// No more than 5 functions!
@@ -98,52 +267,143 @@ class CVMod : public ComputerCard
 		}
 	}
 	
-	// High 24 bits of position are sample index
+	// High 24 bits of position are buffer sample index
 	// Low 8 bits are sub-sample (8-bit linear interpolation)
 	int32_t ReadBuffer(uint32_t position)
 	{
 		int32_t r = position & 0xFF;
 		position >>= 8;
 		uint32_t position2 = position+1;
-		if (position2 >= loopSize)
+		if (position2 >= bufferLoopSize)
 		{
-			position2 -= loopSize;
+			position2 -= bufferLoopSize;
 		}
 
-		return (buffer[position]*(256 - r) + buffer[position2]*r) >> 8;
+		return (buffer.Read(position)*(256 - r) + buffer.Read(position2)*r) >> 8;
+	}
+
+	// Read every head: its phase, offset by phaseKnob, shaped by the function and
+	// scaled to a buffer position, (phase * loopSize) >> 24 >> recordShift. That is
+	// worked out in three 32-bit multiplies, of 12, 12 and 8 bits of the phase, as
+	// 64-bit ones are slow on the M0+, and is out by at most 2/256 of a sample
+	void ReadHeads(int32_t phaseKnob, int32_t out[nHeads])
+	{
+		static_assert(maxLoopSize < (1u << 20), "ReadHeads: 12-bit phase times loopSize must fit in 32 bits");
+		for (unsigned i=0; i<nHeads; i++)
+		{
+			uint32_t finalPhase = PhaseFunc((FuncType) function, playbackPhase[i] - phaseKnob*i*262144);
+			uint32_t pos = (((finalPhase >> 20) * loopSize) >> 4)
+				+ ((((finalPhase >> 8) & 0xFFF) * loopSize) >> 16)
+				+ (((finalPhase & 0xFF) * loopSize) >> 24);
+			pos >>= recordShift;
+			out[i] = ReadBuffer(pos);
+		}
 	}
 	
-	
-public:
-	CVMod()
+	// Flash can be read by this core only when the second core is neither about to write to it nor writing
+	bool FlashFree()
+	{
+		return __atomic_load_n(&saveSlot, __ATOMIC_ACQUIRE) < 0 && !slots.Busy();
+	}
+
+	// Play the loop saved in slot at once, from flash, while the second core copies it in
+	void StartLoad(unsigned slot)
 	{
+		uint32_t tag = slots.Tag(slot);
+		uint32_t savedLoopSize = tag & 0xFFFFFF, savedShift = tag >> 24;
+		if (savedLoopSize == 0 || savedLoopSize >= maxLoopSize || savedShift > maxRecordShift) return;
+
+		buffer.BeginLoad(reinterpret_cast<const LoopBuffer::Encoded *>(slots.Data(slot)));
+		loopSize = savedLoopSize;
+		recordShift = savedShift;
+		if (loopIndex >= loopSize) loopIndex = 0;
+		lastExtraRecordingIndex = 0;
+		recordHold = true;
+	}
 
-		for (unsigned i=0; i<maxLoopSize; i++)
+	// Released the switch with slot chosen: save to it if it's the current slot, otherwise move to it
+	void SelectSlot(unsigned slot)
+	{
+		if (slot == currentSlot)
 		{
-			buffer[i] = 0;
+			if (FlashFree())
+			{
+				saveData = &buffer.Data();
+				saveTag = loopSize | (recordShift << 24);
+				__atomic_store_n(&saveSlot, slot, __ATOMIC_RELEASE);
+			}
 		}
-		sampleCount = 0;
-
-		float f = 67108864; // 2^26
-		for (int i=0; i<128; i++)
+		else
 		{
-			pow2_128[i] = f;
-			f *= 1.005429901112803f; // 2^(1/128)
+			currentSlot = slot;
+			loadSlot = slot;
 		}
+	}
+	
+public:
+	CVMod()
+	{
+		sampleCount = 0;
+		recordShift = 0;
+		recordFilter1 = 0;
+		recordFilter2 = 0;
 
 		pulseFlashCounter = 0;
 		timeKnob = 0;
 		
 		recordPhase = 0;
-		for (int i=0; i<4; i++)
+		for (unsigned i=0; i<nHeads; i++)
 		{
 			playbackPhase[i] = 0;
+			playbackIncrement[i] = 0;
 		}
+		headBlockCount = 0;
 
 		resetTrigger = false;
 		nextFunctionTrigger = false;
 		function = 0;
 		lastExtraRecordingIndex = 0;
+
+		loopSize = 1;
+		loopIndex = 0;
+		currentSlot = 0;
+		loadSlot = -1;
+		saveSlot = -1;
+		saveData = nullptr;
+		saveTag = 0;
+		recordHold = false;
+		holdTrigger = false;
+		switchDownTime = 0;
+		slotSelect = false;
+		lastSpeedKnob = 0;
+
+		// Start with the most recently saved loop, held
+		int newest = slots.Newest();
+		if (newest >= 0)
+		{
+			currentSlot = newest;
+			StartLoad(newest);
+		}
+	}
+
+	// Code for second RP2040 core, blocking: copies loaded loops in, and saves loops to flash
+	void StorageLoop()
+	{
+		while (1)
+		{
+			if (buffer.Loading())
+			{
+				buffer.LoadBlocks(64);
+				continue;
+			}
+
+			int slot = __atomic_load_n(&saveSlot, __ATOMIC_ACQUIRE);
+			if (slot >= 0 && slots.Save(slot, saveData, sizeof(LoopBuffer::Encoded), saveTag))
+			{
+				__atomic_store_n(&saveSlot, -1, __ATOMIC_RELEASE);
+			}
+			slots.Service();
+		}
 	}
 	
 	virtual void ProcessSample()
@@ -155,6 +415,9 @@ public:
 		{
 			nextFunctionTrigger = true;
 		}
+
+		if (PulseIn2RisingEdge())
+			holdTrigger = true;
 		
 		// Only process samples at 12kHz - discard three out of four samples
 		sampleCount++;
@@ -200,6 +463,10 @@ public:
 		if (speedKnob > 1900) speedKnob = 1900;
 		if (speedKnob < -1900) speedKnob = -1900;
 
+		// Main knob chooses the slot while the switch is held down, so speed stays where it was
+		if (slotSelect) speedKnob = lastSpeedKnob;
+		lastSpeedKnob = speedKnob;
+
 		LedOn(1, speedKnob == 0);
 		
 
@@ -209,12 +476,60 @@ public:
 			if (function >= nFuncTypes) function = 0;
 			nextFunctionTrigger = 0;
 		}
+
+
+		////////////////////////////////////////
+		// Loop slots and hold
+
+		unsigned chosenSlot = (KnobVal(Main) * nSlots) >> 12;
+		if (SwitchVal() == Down)
+		{
+			if (switchDownTime < slotSelectTime) switchDownTime++;
+			else slotSelect = true;
+		}
+		else
+		{
+			if (slotSelect) SelectSlot(chosenSlot);
+			switchDownTime = 0;
+			slotSelect = false;
+		}
+
+		if (holdTrigger)
+		{
+			recordHold = !recordHold;
+			holdTrigger = false;
+		}
+
+		// A chosen slot is loaded (if it has been saved) once the flash isn't being written
+		if (loadSlot >= 0 && !buffer.Loading() && FlashFree())
+		{
+			if (slots.Size(loadSlot)) StartLoad(loadSlot);
+			loadSlot = -1;
+		}
+
+		bool recording = !recordHold && loadSlot < 0 && !buffer.Loading();
 		
 		
-		// Maximum loop size should be (less than) 96000 = 8s
-		// Minimum loop size should be ~ 62.5ms
-		loopSize = Pow2(39125 + timeKnob*7);
-		if (loopSize >= maxLoopSize) loopSize = maxLoopSize-1;
+		// Loop held: keep its length and record rate
+		if (!recordHold)
+		{
+			// Maximum loop size should be (less than) 768000 = 64s
+			// Minimum loop size should be ~ 62.5ms
+			loopSize = exp2_q12(39125 + timeKnob*10);
+			if (loopSize >= maxLoopSize) loopSize = maxLoopSize-1;
+
+			// Lowest record rate that fits the loop into the buffer, going back up
+			// only with some room to spare, so CV on the loop time doesn't flip between rates
+			while (recordShift < maxRecordShift && (loopSize >> recordShift) >= buffer.size - 1)
+			{
+				recordShift++;
+			}
+			if (recordShift > 0 && (loopSize >> (recordShift - 1)) < buffer.size - buffer.size/8)
+			{
+				recordShift--;
+			}
+		}
+		bufferLoopSize = (loopSize + (1 << recordShift) - 1) >> recordShift;
 		
 		loopIndex++;
 		if (loopIndex >= loopSize)
@@ -242,13 +557,23 @@ public:
 			recordedValue = (recordPhase>>20) - 2048; 
 		}
 		
-		buffer[loopIndex] = recordedValue;
+		// Two one-pole lowpasses, each at ~1/6 of the record rate, against aliasing at the lower rates
+		recordFilter1 += ((recordedValue << 8) - recordFilter1) >> recordShift;
+		recordFilter2 += (recordFilter1 - recordFilter2) >> recordShift;
+		recordedValue = recordFilter2 >> 8;
+
+		// The buffer sample at a lower record rate is written each time, keeping the last
+		uint32_t bufferIndex = loopIndex >> recordShift;
+		if (recording)
+		{
+			buffer.Write(0, bufferIndex, recordedValue);
+		}
 
 		//	if (loopIndex+loopSize < maxLoopSize)
 		//	buffer[loopIndex+loopSize] = recordedValue;
 
-		uint32_t extraRecordingIndex = loopIndex + loopSize;
-		if (extraRecordingIndex < maxLoopSize)
+		uint32_t extraRecordingIndex = bufferIndex + bufferLoopSize;
+		if (recording && extraRecordingIndex < buffer.size)
 		{
 			if (extraRecordingIndex > lastExtraRecordingIndex)
 			{
@@ -260,12 +585,12 @@ public:
 				
 			    for (uint32_t i = lastExtraRecordingIndex; i<loopEnd; i++)
 				{
-					buffer[i] = recordedValue;
+					buffer.Write(1, i, recordedValue);
 				}
 			}
 			else
 			{
-			   	buffer[extraRecordingIndex] = recordedValue;
+			   	buffer.Write(1, extraRecordingIndex, recordedValue);
 			}
 
 			lastExtraRecordingIndex = extraRecordingIndex;
@@ -274,14 +599,24 @@ public:
 		////////////////////////////////////////
 		// Now, the movement of the output playback heads
 
-		for (int i=0; i<4; i++)
+		if (headBlockCount == 0)
+		{
+			for (unsigned i=0; i<nHeads; i++)
+			{
+				playbackIncrement[i] = PhaseAdvance(i, speedKnob, loopIncrement);
+			}
+			headBlockCount = headBlock;
+		}
+		headBlockCount--;
+
+		for (unsigned i=0; i<nHeads; i++)
 		{
-			playbackPhase[i] += PhaseAdvance(i, speedKnob, loopIncrement);
+			playbackPhase[i] += playbackIncrement[i];
 		}
 
 		if (resetTrigger)
 		{
-			for (int i=0; i<4; i++)
+			for (unsigned i=0; i<nHeads; i++)
 			{
 				playbackPhase[i] = recordPhase;
 			}
@@ -289,22 +624,17 @@ public:
 		}
 		
 
-		// Get final position of output playback heads and convert into buffer positions
-		uint32_t pos[4];
-		for (int i=0; i<4; i++)
-		{
-			uint32_t finalPhase = PhaseFunc((FuncType) function, playbackPhase[i] - phaseKnob*i*262144);
-			pos[i] = (uint64_t(finalPhase) * loopSize) >> 24;
-		}
+		int32_t heads[nHeads];
+		ReadHeads(phaseKnob, heads);
 		
 		//uint32_t readPhase = recordPhase - phaseKnob*524288;
 		//uint32_t readBufferPos = (uint64_t(readPhase) * loopSize) >> 24;
 
 
-		AudioOut1(ReadBuffer(pos[0]));
-		AudioOut2(ReadBuffer(pos[1]));
-		CVOut1(ReadBuffer(pos[2]));
-		CVOut2(ReadBuffer(pos[3]));
+		AudioOut1(heads[0]);
+		AudioOut2(heads[1]);
+		CVOut1(heads[2]);
+		CVOut2(heads[3]);
 
 //		AudioOut1(recordedValue);
 //		AudioOut2(ReadBuffer(readBufferPos));
@@ -330,15 +660,38 @@ public:
 		LedOn(0, funcLeds[function]&1);
 		LedOn(2, funcLeds[function]&2);
 		LedOn(4, funcLeds[function]&4);
+
+		// LED 3 lit while the loop is held, flashing while a loop is being saved
+		bool saving = __atomic_load_n(&saveSlot, __ATOMIC_ACQUIRE) >= 0 || slots.Busy();
+		if (saving) LedOn(3, (loopIndex >> 10) & 1);
+		else LedOn(3, recordHold);
+
+		// While choosing a slot, LEDs 0-3 show which
+		if (slotSelect)
+		{
+			for (unsigned i=0; i<6; i++)
+			{
+				LedOn(i, i == chosenSlot);
+			}
+		}
 	}
 };
 
 
+static CVMod *cvmod;
+
+static void core1()
+{
+	cvmod->StorageLoop();
+}
+
 int main()
 {
 	set_sys_clock_khz(192000, true);
 	
-	CVMod cvm;
+	static CVMod cvm;
+	cvmod = &cvm;
+	multicore_launch_core1(core1);
 	cvm.EnableNormalisationProbe();
 	cvm.Run();
 }
@@ -2,18 +2,52 @@
 #define CLOCK_H
 
 ////////////////////////////////////////
-// Free-running clock, incremented 48kHz
+// Free-running clock, 48kHz sample time
+//
+// Conceptually a 32-bit counter incremented by <increment> every sample, with an edge
+// each time bit 31 changes. Rather than accumulating every sample, the counter is only
+// brought up to date at an edge or when the tempo changes, and the sample time of the
+// next edge is computed once (one hardware divide) and compared against.
 
 
 typedef struct
 {
 	uint32_t count, increment;
+	uint32_t time;              // sample time at which count was last brought up to date
+	uint32_t nextEdge;          // sample time of the next edge
+	volatile uint32_t target;   // increment requested by clock_set_freq_*, picked up by clock_retune
 } clock;
 
+// Bring count up to date at sample time <now>
+void __not_in_flash_func(clock_sync)(clock *c, uint32_t now)
+{
+	c->count += c->increment * (now - c->time);
+	c->time = now;
+}
+
+// Compute the sample time of the next edge, from an up-to-date count
+void __not_in_flash_func(clock_schedule)(clock *c, uint32_t now)
+{
+	if (c->increment == 0)
+	{
+		// Stopped: push the edge as far away as the wrapping comparison allows.
+		// Any tempo change reschedules it.
+		c->nextEdge = now + 0x7FFFFFFF;
+		return;
+	}
+
+	// Samples until bit 31 next changes, rounded up
+	uint32_t distance = 0x80000000 - (c->count & 0x7FFFFFFF);
+	c->nextEdge = now + (distance + c->increment - 1) / c->increment;
+}
+
 void clock_init(clock *c)
 {
 	c->count = 0;
 	c->increment = 0;
+	c->target = 0;
+	c->time = 0;
+	clock_schedule(c, 0);
 }
 
 
@@ -23,32 +57,47 @@ uint32_t __not_in_flash_func(clock_get_incr_from_hz)(clock *c, float f)
 	return (uint32_t)(89478.48533f * f);
 }
 
+// The clock_set_freq_* functions may be called from the other core;
+// the new tempo takes effect at the next clock_retune or edge
+
 void __not_in_flash_func(clock_set_freq_hz)(clock *c, float f)
 {
-	// tick called at 48kHz
+	// 48kHz sample time
 	// wraps at 2^32 = 4,294,967,296
 	// increment is linear in Hz, with 89478.485333 per Hz
-	c->increment = (uint32_t)(89478.48533f * f);
+	c->target = (uint32_t)(89478.48533f * f);
 }
 
 void __not_in_flash_func(clock_set_freq_incr)(clock *c, uint32_t incr)
 {
-	// tick called at 48kHz
+	// 48kHz sample time
 	// wraps at 2^32 = 4,294,967,296
 	// increment is linear in Hz, with 89478.485333 per Hz
-	c->increment = incr;
+	c->target = incr;
+}
+
+// Pick up a tempo change, if there has been one, keeping the clock's phase
+// Call from the audio core at block rate
+void __not_in_flash_func(clock_retune)(clock *c, uint32_t now)
+{
+	uint32_t target = c->target;
+	if (target == c->increment) return;
+
+	clock_sync(c, now);
+	c->increment = target;
+	clock_schedule(c, now);
 }
 
-// Call at 48kHz
-// Returns true on both rising and falling edges
-bool __not_in_flash_func(clock_tick)(clock *c)
+// Call from the audio core, with the current (48kHz) sample time
+// Returns true, for both rising and falling edges, on the sample where an edge falls
+bool __not_in_flash_func(clock_tick)(clock *c, uint32_t now)
 {
-	uint32_t nextCount = c->count + c->increment;
+	if ((int32_t)(now - c->nextEdge) < 0) return false;
 
-	// Internal clock pulse, both rising and falling edges
-	bool edge = (c->count ^ nextCount) & 0x80000000;
-	c->count = nextCount;
-	return edge;
+	clock_sync(c, now);
+	c->increment = c->target;
+	clock_schedule(c, now);
+	return true;
 }
 
 bool __not_in_flash_func(clock_state)(clock *c)
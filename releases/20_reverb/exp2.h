@@ -0,0 +1,65 @@
+#ifndef EXP2_H
+#define EXP2_H
+
+#include <stdint.h>
+
+// Integer 2^x, for exponential knob, CV and pitch mappings, in C or C++.
+// Shared by 07_bumpers, 14_cvmod and 20_reverb: keep the copies the same.
+//
+// Exponents are in 1/4096ths of an octave. The whole octaves are a shift, and the
+// fraction 2^(f/4096) is interpolated (32 steps) from exp2_table, 2^(i/128) for
+// i = 0 to 128 in Q26, which is constant data: there is no table to build at startup.
+// The last entry is the next octave's first, so the interpolation never wraps.
+// Generated by round(2^26 * 2^(i/128)).
+
+static const uint32_t exp2_table[129] = {
+	67108864, 67473258, 67839632, 68207994, 68578357, 68950730, 69325126, 69701555,
+	70080027, 70460555, 70843149, 71227820, 71614580, 72003440, 72394412, 72787506,
+	73182735, 73580110, 73979643, 74381345, 74785228, 75191305, 75599586, 76010084,
+	76422812, 76837780, 77255001, 77674488, 78096253, 78520308, 78946666, 79375338,
+	79806339, 80239679, 80675373, 81113432, 81553870, 81996699, 82441933, 82889585,
+	83339667, 83792193, 84247176, 84704630, 85164568, 85627003, 86091949, 86559420,
+	87029429, 87501990, 87977118, 88454825, 88935126, 89418035, 89903566, 90391733,
+	90882551, 91376035, 91872197, 92371054, 92872620, 93376909, 93883937, 94393717,
+	94906266, 95421597, 95939727, 96460670, 96984442, 97511058, 98040534, 98572884,
+	99108125, 99646272, 100187342, 100731349, 101278310, 101828242, 102381159, 102937078,
+	103496017, 104057990, 104623014, 105191107, 105762284, 106336563, 106913960, 107494492,
+	108078177, 108665030, 109255071, 109848315, 110444781, 111044485, 111647445, 112253680,
+	112863206, 113476042, 114092206, 114711715, 115334589, 115960844, 116590500, 117223575,
+	117860087, 118500056, 119143500, 119790437, 120440887, 121094869, 121752403, 122413506,
+	123078199, 123746502, 124418433, 125094013, 125773261, 126456197, 127142842, 127833215,
+	128527337, 129225227, 129926908, 130632398, 131341719, 132054891, 132771936, 133492875,
+	134217728,
+};
+
+// 2^((in & 0xFFF)/4096) in Q31, from 2^31 up to 2^32
+static inline uint32_t exp2_fraction(uint32_t in)
+{
+	uint32_t i = (in >> 5) & 0x7F;
+	uint32_t s = in & 0x1F;
+	return exp2_table[i] * (32 - s) + exp2_table[i + 1] * s;
+}
+
+// Integer part of 2^(in/4096), for in up to 32 octaves (131071)
+static inline uint32_t exp2_q12(uint32_t in)
+{
+	return exp2_fraction(in) >> (31 - (in >> 12));
+}
+
+// Phase increment for a pitch (1/4096ths of an octave, either sign, within 32 octaves)
+// above the pitch whose increment is base, i.e. base * 2^(pitch/4096), rounded down.
+// The result must fit in 32 bits
+static inline uint32_t exp2_increment(uint32_t base, int32_t pitch)
+{
+	int32_t oct = pitch >> 12; // rounds down, for negative pitches too
+	return (uint32_t)(((uint64_t)base * exp2_fraction((uint32_t)pitch)) >> (31 - oct));
+}
+
+// Timer period, in any units, for a pitch above the pitch whose period is base,
+// i.e. base * 2^(-pitch/4096)
+static inline uint32_t exp2_period(uint32_t base, int32_t pitch)
+{
+	return exp2_increment(base, -pitch);
+}
+
+#endif
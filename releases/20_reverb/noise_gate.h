@@ -1,24 +1,70 @@
 #ifndef NOISE_GATE_H
 #define NOISE_GATE_H
 
+// The gate's decisions are made once per NOISE_GATE_BLOCK samples, from the block's peak level;
+// when it opens or closes, its gain ramps over NOISE_GATE_RAMP samples
+#define NOISE_GATE_BLOCK 16
+#define NOISE_GATE_RAMP 64
+#define NOISE_GATE_UNITY 256
+
 typedef struct
 {
 	uint32_t count;
 	int32_t lpf_value;
+	int32_t peak;     // largest highpassed level so far this block, in ADC units
+	int32_t level;    // peak of the last complete block
+	uint32_t n;       // samples so far this block
+	int32_t gain;     // 0 (closed) to NOISE_GATE_UNITY (open)
+	int32_t target;   // what gain is ramping to
 } noise_gate;
 
 void noise_gate_init(noise_gate *ng)
 {
 	ng->count = 0;
 	ng->lpf_value = 0;
+	ng->peak = 0;
+	ng->level = 0;
+	ng->n = 0;
+	ng->gain = NOISE_GATE_UNITY;
+	ng->target = NOISE_GATE_UNITY;
+}
+
+// Peak input level (highpassed, in ADC units) over the last block, as an envelope follower,
+// e.g. for meters or ducking
+static inline int32_t noise_gate_level(const noise_gate *ng)
+{
+	return ng->level;
+}
+
+// Once per block: update the gate from the block's peak.
+//  If input < threshold for long enough, then turn off input
+//  If input > thresholdh, turn input back on
+// A block peaking between the two thresholds leaves the count as it is
+void __not_in_flash_func(noise_gate_block)(noise_gate *ng)
+{
+	int32_t threshold = 9;
+	int32_t thresholdh = 17;
+	uint32_t countMax = 5000;
+
+	if (ng->peak < threshold)
+	{
+		ng->count += NOISE_GATE_BLOCK;
+	}
+	if (ng->peak > thresholdh)
+	{
+		ng->count = 0;
+	}
+	ng->target = (ng->count > countMax) ? 0 : NOISE_GATE_UNITY;
+
+	ng->level = ng->peak;
+	ng->peak = 0;
+	ng->n = 0;
 }
 
 int32_t __not_in_flash_func(noise_gate_tick)(noise_gate *ng, int32_t in)
 {
 
 	// Noise gate.
-	//  If input < threshold for long enough, then turn off input
-	//  If input > thresholdh, turn input back on
 
 	// ADC is 12-bit, 4096 values, from -2048 to 2047
 	// Here, "in" is set to (left+right)<<2, giving "in" of ±16384
@@ -27,31 +73,27 @@ int32_t __not_in_flash_func(noise_gate_tick)(noise_gate *ng, int32_t in)
 
 	// Output returns 11Hz highpassed version of input, to avoid 'thumps' when
 	// the gate switches on and off.
-	int32_t threshold = 9;
-	int32_t thresholdh = 17;
-	uint32_t countMax = 5000;
-
 
 	// 11hz HPF to remove DC offset
 	in <<= 6;
 	ng->lpf_value += ((in - ng->lpf_value) * 100) >> 16;
 	int32_t hpf = in - ng->lpf_value;
 
-	// debug("%d %d %d\n",in, hpf>>6, ng->lpf_value>>6);
-
 	int32_t ahpf = hpf >> 9; // bring back down by 2^9, to same magnitude as ADC left/right
 	if (ahpf < 0) ahpf = -ahpf;
+	if (ahpf > ng->peak) ng->peak = ahpf;
 
-	if (ahpf < threshold)
-	{
-		ng->count++;
-	}
-	if (ahpf > thresholdh)
+	if (++ng->n == NOISE_GATE_BLOCK)
+		noise_gate_block(ng);
+
+	// Only while opening or closing is there a gain to apply
+	if (ng->gain != ng->target)
 	{
-		ng->count = 0;
+		ng->gain += (ng->gain < ng->target) ? NOISE_GATE_UNITY / NOISE_GATE_RAMP : -NOISE_GATE_UNITY / NOISE_GATE_RAMP;
+		return ((hpf >> 6) * ng->gain) >> 8;
 	}
 
-	if (ng->count > countMax)
+	if (ng->gain == 0)
 		return 0; // return zero if signal should be silenced
 	else
 		return hpf >> 6; // return highpassed signal otherwise
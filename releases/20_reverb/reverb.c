@@ -7,7 +7,14 @@ Interrupt service routine buffer_full() called at 48kHz by ADC DMA (ADC runs at
 ADC samples both audio channels, along with knobs and CV in, and sends outputs to DAC (via DMA)
 at 48kHz.
 
-Reverb DSP is run within the buffer_full() ISR.  DSP runs in around 12us, out of 20.8us per sample.
+Controls and input/output processing are run within the buffer_full() ISR; the reverb itself runs
+in blocks in the audio core's main loop, fed through a ring buffer by the ISR.
+
+With STEREO_INPUT defined, the left and right inputs feed the reverb separately (reverb_process_block_stereo);
+otherwise they are mixed to mono.
+
+REVERB_ALGORITHM selects the reverb: the Dattorro plate (REVERB_PLATE), a small room (REVERB_ROOM),
+a shimmer plate (REVERB_SHIMMER) or a multi-tap echo (REVERB_ECHO); see reverb_dsp.h.
 
 The function of knobs, CV and Pulse input/output are controlled by MIDI SysEx commands.
 */
@@ -15,6 +22,14 @@ The function of knobs, CV and Pulse input/output are controlled by MIDI SysEx co
 #define ENABLE_MIDI
 // #define ENABLE_UART_DEBUGGING
 // #define ENABLE_GPIO_DEBUGGING
+// #define STEREO_INPUT
+#define REVERB_ALGORITHM REVERB_PLATE
+
+#ifdef STEREO_INPUT
+#define NUM_INPUTS 2
+#else
+#define NUM_INPUTS 1
+#endif
 
 #ifdef ENABLE_MIDI
 #include "bsp/board.h"
@@ -54,11 +69,13 @@ The function of knobs, CV and Pulse input/output are controlled by MIDI SysEx co
 #include "pico/time.h"
 #include "sysex_sentences.h"
 #include "reverb_dsp.h"
+#include "exp2.h"
 #include <float.h>
 #include <math.h>
 #include <string.h>
 
 #include "usb_midi_host.h"
+#include "usb_midi_packet.h"
 
 // Variables for passing debug info from audio thread to usb thread
 volatile uint32_t pf1 = 0, pf2 = 0, pfflag = 0;
@@ -82,7 +99,6 @@ uint32_t configFlashAddr = (PICO_FLASH_SIZE_BYTES - 4096) - (PICO_FLASH_SIZE_BYT
 
 uint8_t config[CONFIG_LENGTH];
 uint8_t configBuffer[CONFIG_LENGTH]; // config that is filled out packet-by-packet when receiving data
-uint8_t packet[CONFIG_LENGTH + 10];
 
 // The default configuration, can be reset without USB connection by holding down momentary switch while powering on/resetting.
 //                          v     v     v     v        v           v           v           v           v              v              v        v  v      v        v     v
@@ -93,10 +109,7 @@ clock clk[2];
 divider pulseout1_divider, pulseout2_divider, cvout1_divider, cvout2_divider, tm_divider, bg_divider;
 turing_machine tm;
 bernoulli_gate bg;
-noise_gate ng;
-
-// lookup for powers of two
-uint32_t pow2_128[128];
+noise_gate ng[NUM_INPUTS];
 
 volatile int32_t knobs[4] = { 0, 0, 0, 0 }; // 0-4095
 volatile bool pulse[2] = { 0, 0 };
@@ -107,14 +120,6 @@ volatile int16_t adcInL = 0x800, adcInR = 0x800;
 
 volatile uint8_t mxPos = 0; // external multiplexer value
 
-// The ADC (/DMA) run mode, used to stop DMA in a known state before writing to flash
-#define RUN_ADC_MODE_RUNNING 0
-#define RUN_ADC_MODE_REQUEST_ADC_STOP 1
-#define RUN_ADC_MODE_ADC_STOPPED 2
-#define RUN_ADC_MODE_REQUEST_ADC_RESTART 3
-volatile uint8_t runADCMode = RUN_ADC_MODE_RUNNING;
-
-
 // Buffers that DMA reads into / out of
 uint16_t ADC_Buffer[2][8];
 uint16_t SPI_Buffer[2][2];
@@ -126,6 +131,7 @@ unsigned allLedFlashTimer = 0;
 volatile uint8_t midiDeviceConnected=0;
 int32_t midiDeviceOutputCable=0;
 uint8_t midiDeviceAddress=0;
+bool isHost = false; // USB host (rather than device) mode
 
 
 uint8_t dmaPhase = 0;
@@ -228,16 +234,6 @@ void __not_in_flash_func(buffer_full)()
 
 	mux_state = next_mux_state;
 
-	// Indicate to usb core that we've finished running this sample.
-	if (runADCMode == RUN_ADC_MODE_REQUEST_ADC_STOP)
-	{
-		adc_run(false);
-		adc_set_round_robin(0);
-		adc_select_input(0);
-
-		runADCMode = RUN_ADC_MODE_ADC_STOPPED;
-	}
-
 	norm_probe_count = (norm_probe_count + 1) & 0x1F;
 	debug_pin(DEBUG_2, false);
 }
@@ -350,51 +346,6 @@ int32_t __not_in_flash_func(continuous_source_from_config)(int offset)
 	}
 	return ret;
 }
-/*
-// Returns tempo in Hz from a "TempoSource" dropdown
-float __not_in_flash_func(tempo_source_from_config)(int offset)
-{
-	if (config[offset] == OPT_A_CONSTANT)
-	{
-		int val = 100 * config[offset + 1]
-		          + 10 * config[offset + 2]
-		          + config[offset + 3];
-		float fval = val;
-		return (config[offset + 4] == OPT_HZ) ? fval : fval * 0.0166666666f;
-	}
-	else
-	{
-		// tempo from knob or CV: use exponential mapping
-		int32_t int_clock_tempo = continuous_source_from_config(offset);
-		return expf(1.9531e-3f * int_clock_tempo - 3.0f);
-	}
-}
-*/
-
-
-// Return integer part of 2^(in/4096) (approximate)
-// 7-bit lookup table (128 entries), 5-bit (32-step) linear interpolation between steps
-uint32_t __not_in_flash_func(Pow2)(uint32_t in)
-{
-	uint32_t oct = in >> 12; // floor(in/4096)
-
-	// Table index and value of lookup
-	uint32_t ind1 = (in & 0xFE0) >> 5; // 0xFE0 = 111111100000
-	uint32_t val1 = pow2_128[ind1];
-
-	// Next lookup
-	uint32_t ind2 = (ind1 + 1) & 0x7F; //
-	uint32_t val2 = pow2_128[ind2];
-	if (ind2 == 0) val2 <<= 1; // interpolating between end of one octave and the start of another
-
-	// Linearly interpolate with 32 steps
-	uint32_t subsample = in & 0x1F;
-	uint32_t val = val1 * (32 - subsample) + val2 * subsample;
-
-	val >>= 31 - oct;
-
-	return val;
-}
 
 // Returns tempo as increment of a 32-bit wrapping counter, from a "TempoSource" dropdown
 uint32_t __not_in_flash_func(tempo_source_from_config_incr)(int offset)
@@ -418,7 +369,7 @@ uint32_t __not_in_flash_func(tempo_source_from_config_incr)(int offset)
 		// That corresponds to an increment of 4454.87 to 13252516.1
 		// That's a range of about 2^11.5
 		int32_t int_clock_tempo = continuous_source_from_config(offset);
-		return Pow2(48621 + 12*int_clock_tempo);
+		return exp2_q12(48621 + 12*int_clock_tempo);
 	}
 }
 
@@ -483,6 +434,7 @@ void __not_in_flash_func(bg_div_step)(bool risingEdge)
 
 // declarations of application-level handling functions
 void handle_midi_message(uint8_t *packet);
+void queue_midi_message(const uint8_t *packet, uint32_t length);
 void post_config_processing();
 void post_flash_processing();
 
@@ -512,45 +464,10 @@ void set_config_from_flash()
 	post_config_processing();
 }
 
-int set_config_from_sysex(uint8_t *packet)
-{
-	//	debug("set_config_from_sysex %d %d\n", packet[SYSEX_INDEX_LENGTH_ALL_DATA], CONFIG_LENGTH);
-	if (packet[SYSEX_INDEX_LENGTH_ALL_DATA] != CONFIG_LENGTH)
-		return -1; // error
-
-	uint32_t payloadLength = packet[SYSEX_INDEX_LENGTH];
-	uint32_t offset = packet[SYSEX_INDEX_PACKET_START_BYTE];
-	bool lastPacket = packet[SYSEX_INDEX_PACKET_INDEX] == packet[SYSEX_INDEX_NUM_PACKETS] - 1;
-
-	if (offset + payloadLength > CONFIG_LENGTH)
-	{
-		return -1; // error, woudn't fit into config
-	}
-
-	// copy sysex payload to appropriate place in RAM config buffer
-	memcpy(&(configBuffer[offset]), &(packet[SYSEX_READ_CONFIG_HEADER_LEN]), payloadLength);
-
-	if (lastPacket)
-	{
-		// Copy data from temporary buffer into real config
-		memcpy(config, configBuffer, CONFIG_LENGTH);
-		
-		// run any application-specific processing
-		post_config_processing();
-	}
-	return 0; // success
-}
-
+// The firmware runs from RAM (copy_to_ram binary), so the audio core carries on
+// while flash is being written, and there's no need to stop it
 void save_config_to_flash()
 {
-	runADCMode = RUN_ADC_MODE_REQUEST_ADC_STOP;
-
-	// wait for audio core to detect runADCMode flag and stop
-	while (runADCMode != RUN_ADC_MODE_ADC_STOPPED) {}
-
-	// shut down the other core
-	multicore_lockout_start_blocking();
-
 	// erase page of flash
 	uint32_t ints = save_and_disable_interrupts();
 	flash_range_erase(configFlashAddr, 4096);
@@ -562,123 +479,230 @@ void save_config_to_flash()
 	restore_interrupts(ints);
 
 	post_flash_processing();
+}
 
-	// Request ADC restart once other core starts up again
-	runADCMode = RUN_ADC_MODE_REQUEST_ADC_RESTART;
 
-	// restore other core
-	multicore_lockout_end_blocking();
+#ifdef ENABLE_MIDI
+// SysEx messages are parsed one byte at a time, as each USB-MIDI packet arrives, rather than
+// being collected and parsed whole: config payloads go straight into configBuffer, and the
+// header is kept only as far as it needs to be checked.
+typedef struct
+{
+	uint8_t header[SYSEX_READ_CONFIG_HEADER_LEN];
+	uint32_t index; // bytes received of the current message, 0 if not in one
+	bool valid;     // message is for this card, and (so far) well-formed
+} sysex_parser;
+sysex_parser sysexIn = { { 0 }, 0, false };
+
+// Responses are sent as a series of SysEx messages, each written SYSEX_RESPONSE_CHUNK bytes
+// per pass of the USB loop, so that a config dump never holds up the loop for long
+#define SYSEX_RESPONSE_PAYLOAD 32 // config bytes per response message
+#define SYSEX_RESPONSE_CHUNK 24   // bytes written per call of sysex_response_task
+typedef struct
+{
+	uint8_t message[SYSEX_READ_CONFIG_HEADER_LEN + SYSEX_RESPONSE_PAYLOAD + 1];
+	uint32_t length, sent; // of message, and bytes of it sent so far
+	uint8_t command;       // command being responded to, 0 if none
+	int messageIndex, numMessages;
+} sysex_responder;
+sysex_responder sysexOut = { { 0 }, 0, 0, 0, 0, 0 };
+
+bool sysex_is_config_write(uint8_t command)
+{
+	return command == SYSEX_COMMAND_PREVIEW || command == SYSEX_COMMAND_WRITE_FLASH;
 }
 
+// Start sending a response, if one is not already being sent
+void sysex_start_response(uint8_t command)
+{
+	if (sysexOut.command != 0)
+		return;
+	sysexOut.command = command;
+	sysexOut.messageIndex = 0;
+	sysexOut.numMessages = (command == SYSEX_COMMAND_READ) ? (CONFIG_LENGTH + SYSEX_RESPONSE_PAYLOAD - 1) / SYSEX_RESPONSE_PAYLOAD : 1;
+	sysexOut.length = sysexOut.sent = 0;
+}
 
-#ifdef ENABLE_MIDI
-void process_sys_ex_command(uint8_t *packet)
+// A whole message has been received
+void sysex_end()
 {
-	if (packet[SYSEX_INDEX_MANUFACTURER] != SYSEX_MANUFACTURER_DEV)
+	uint8_t *h = sysexIn.header;
+	if (sysexIn.index <= SYSEX_INDEX_COMMAND)
 		return;
 
-	switch (packet[SYSEX_INDEX_COMMAND])
+	if (sysex_is_config_write(h[SYSEX_INDEX_COMMAND]))
 	{
-	case SYSEX_COMMAND_PREVIEW: // preview: save config from sysex to ram, but not to flash
-		set_config_from_sysex(packet);
-		break;
+		// All of the payload must have arrived, and been stored by sysex_byte
+		if (sysexIn.index != SYSEX_READ_CONFIG_HEADER_LEN + (uint32_t)h[SYSEX_INDEX_LENGTH])
+			return;
+		if (h[SYSEX_INDEX_PACKET_INDEX] == h[SYSEX_INDEX_NUM_PACKETS] - 1)
+		{
+			// Last packet: copy data from temporary buffer into real config
+			memcpy(config, configBuffer, CONFIG_LENGTH);
 
-	case SYSEX_COMMAND_WRITE_FLASH:
+			// run any application-specific processing
+			post_config_processing();
 
-		// If successful in setting RAM config from sysex...
-		if (!set_config_from_sysex(packet))
-		{
-			// save RAM config to flash
-			save_config_to_flash();
+			if (h[SYSEX_INDEX_COMMAND] == SYSEX_COMMAND_WRITE_FLASH)
+				save_config_to_flash();
 		}
-		break;
-
-	case SYSEX_COMMAND_READ:
+	}
+	else if (h[SYSEX_INDEX_COMMAND] == SYSEX_COMMAND_READ || h[SYSEX_INDEX_COMMAND] == SYSEX_COMMAND_READ_CARD_RELEASE)
+	{
 		debugp("Received card config request\n");
-		packet[0] = 0xF0; // start sysex
-		packet[SYSEX_INDEX_MANUFACTURER] = SYSEX_MANUFACTURER_DEV;
-		packet[SYSEX_INDEX_COMMAND] = SYSEX_COMMAND_READ; // indicate what command this is in response to
+		sysex_start_response(h[SYSEX_INDEX_COMMAND]);
+	}
+}
 
-		{
-			int max_payload_size = 32;
-			int num_packets = (CONFIG_LENGTH + max_payload_size - 1) / max_payload_size;
-			int bytes_to_send = CONFIG_LENGTH;
-			int bytes_this_packet, start_byte;
-			for (int p = 0; p < num_packets; p++)
-			{
-				if (bytes_to_send > max_payload_size)
-				{
-					bytes_this_packet = max_payload_size;
-				}
-				else
-				{
-					bytes_this_packet = bytes_to_send;
-				}
-
-				start_byte = p * max_payload_size;
-
-				packet[SYSEX_INDEX_LENGTH] = bytes_this_packet;
-				packet[SYSEX_INDEX_NUM_PACKETS] = num_packets;
-				packet[SYSEX_INDEX_PACKET_INDEX] = p;
-				packet[SYSEX_INDEX_PACKET_START_BYTE] = start_byte;
-				packet[SYSEX_INDEX_LENGTH_ALL_DATA] = CONFIG_LENGTH;
-
-				memcpy(&(packet[SYSEX_READ_CONFIG_HEADER_LEN]), &(config[start_byte]), bytes_this_packet); // copy config into sysex packet
-				packet[bytes_this_packet + SYSEX_READ_CONFIG_HEADER_LEN] = 0xF7; // end sysex
-			
-				int rv2 = tud_midi_stream_write(0, packet, bytes_this_packet + SYSEX_READ_CONFIG_HEADER_LEN + 1);
-			
-				bytes_to_send -= bytes_this_packet;
-			}
-		}
-		break;
+// Handle the next byte of a SysEx message
+void sysex_byte(uint8_t b)
+{
+	if (b == 0xF0) // start of a message, even if the last one never ended
+	{
+		sysexIn.index = 1;
+		sysexIn.valid = true;
+		return;
+	}
+	if (sysexIn.index == 0 || b >= 0xF8) // not in a message, or real-time byte within one
+		return;
+	if (b & 0x80) // end of message, or one cut short by another status byte
+	{
+		if (b == 0xF7 && sysexIn.valid)
+			sysex_end();
+		sysexIn.index = 0;
+		return;
+	}
+	if (!sysexIn.valid)
+		return;
 
-	case SYSEX_COMMAND_READ_CARD_RELEASE:
-		packet[0] = 0xF0; // start sysex
-		packet[SYSEX_INDEX_MANUFACTURER] = SYSEX_MANUFACTURER_DEV;
-		packet[SYSEX_INDEX_COMMAND] = SYSEX_COMMAND_READ_CARD_RELEASE; // indicate what command this is in response to
-		packet[SYSEX_INDEX_LENGTH] = 4; // 4-byte response of card ID number, and major and minor versions
-		packet[4] = CARD_ID_LOW;
-		packet[5] = CARD_ID_HIGH;
-		packet[6] = CARD_VER_MAJOR;
-		packet[7] = CARD_VER_MINOR;
-		packet[8] = 0xF7; // end sysex
-		int rv3 = tud_midi_stream_write(0, packet, 9);
-		break;
+	uint8_t *h = sysexIn.header;
+	uint32_t i = sysexIn.index++;
+	if (i < SYSEX_READ_CONFIG_HEADER_LEN)
+	{
+		h[i] = b;
+		if (i == SYSEX_INDEX_MANUFACTURER && b != SYSEX_MANUFACTURER_DEV)
+			sysexIn.valid = false;
+		// Config writes: check that the payload will fit, once the header is complete
+		if (i == SYSEX_INDEX_LENGTH_ALL_DATA && sysex_is_config_write(h[SYSEX_INDEX_COMMAND])
+			&& (b != CONFIG_LENGTH || h[SYSEX_INDEX_PACKET_START_BYTE] + h[SYSEX_INDEX_LENGTH] > CONFIG_LENGTH))
+			sysexIn.valid = false;
+	}
+	else if (sysex_is_config_write(h[SYSEX_INDEX_COMMAND]))
+	{
+		// Payload byte: store it in the config buffer straight away
+		uint32_t n = i - SYSEX_READ_CONFIG_HEADER_LEN;
+		if (n < h[SYSEX_INDEX_LENGTH])
+			configBuffer[h[SYSEX_INDEX_PACKET_START_BYTE] + n] = b;
+		else
+			sysexIn.valid = false; // longer than its header says
+	}
+}
 
-	default:
-		break;
+// Handle the SysEx bytes in a USB-MIDI packet
+void sysex_packet(const uint8_t *p)
+{
+	uint8_t n = usb_midi_packet_sysex_bytes(p);
+	for (uint8_t i = 1; i <= n; i++)
+		sysex_byte(p[i]);
+}
+
+// Handle a USB-MIDI packet, received in device or host mode
+void handle_usb_midi_packet(const uint8_t *p)
+{
+	uint8_t length = usb_midi_packet_length(p);
+	if (length > 0)
+	{
+		// queue for the application midi message handler, on the audio core
+		queue_midi_message(p + 1, length);
+	}
+	else
+	{
+		sysex_packet(p);
 	}
 }
 
-void midi_device_task()
+// Fill sysexOut.message with the next response message
+void sysex_build_response()
 {
-	// Read incoming packet if availabie
-	while (tud_midi_available())
+	uint8_t *m = sysexOut.message;
+	m[0] = 0xF0; // start sysex
+	m[SYSEX_INDEX_MANUFACTURER] = SYSEX_MANUFACTURER_DEV;
+	m[SYSEX_INDEX_COMMAND] = sysexOut.command; // indicate what command this is in response to
+
+	if (sysexOut.command == SYSEX_COMMAND_READ)
 	{
-		uint32_t bytesToProcess = tud_midi_stream_read(packet, sizeof(packet));
+		int start_byte = sysexOut.messageIndex * SYSEX_RESPONSE_PAYLOAD;
+		int bytes_this_packet = CONFIG_LENGTH - start_byte;
+		if (bytes_this_packet > SYSEX_RESPONSE_PAYLOAD)
+			bytes_this_packet = SYSEX_RESPONSE_PAYLOAD;
+
+		m[SYSEX_INDEX_LENGTH] = bytes_this_packet;
+		m[SYSEX_INDEX_NUM_PACKETS] = sysexOut.numMessages;
+		m[SYSEX_INDEX_PACKET_INDEX] = sysexOut.messageIndex;
+		m[SYSEX_INDEX_PACKET_START_BYTE] = start_byte;
+		m[SYSEX_INDEX_LENGTH_ALL_DATA] = CONFIG_LENGTH;
+		memcpy(&(m[SYSEX_READ_CONFIG_HEADER_LEN]), &(config[start_byte]), bytes_this_packet); // copy config into sysex packet
+		m[bytes_this_packet + SYSEX_READ_CONFIG_HEADER_LEN] = 0xF7; // end sysex
+		sysexOut.length = bytes_this_packet + SYSEX_READ_CONFIG_HEADER_LEN + 1;
+	}
+	else // SYSEX_COMMAND_READ_CARD_RELEASE
+	{
+		m[SYSEX_INDEX_LENGTH] = 4; // 4-byte response of card ID number, and major and minor versions
+		m[4] = CARD_ID_LOW;
+		m[5] = CARD_ID_HIGH;
+		m[6] = CARD_VER_MAJOR;
+		m[7] = CARD_VER_MINOR;
+		m[8] = 0xF7; // end sysex
+		sysexOut.length = 9;
+	}
+	sysexOut.sent = 0;
+}
 
-		uint8_t *bufferPtr = packet;
-		
-		while (bytesToProcess > 0)
-		{
-			if (packet[0] == 0xF0) // If SysEx, handle with standard routine
-			{
-				process_sys_ex_command(bufferPtr);
-			}
-			else // else pass on to application midi message handler
-			{
-				handle_midi_message(bufferPtr);
-			}
+// Called once per USB loop: send the next piece of any response, to the USB host or device
+void sysex_response_task(bool host)
+{
+	if (sysexOut.command == 0)
+		return;
 
-			// Move pointer to next midi message in buffer, if it exists
-			// by scanning until we see a MIDI command byte (most significant bit set)
-			do 
-			{
-				bufferPtr++;
-				bytesToProcess--;
-			} while (bytesToProcess > 0 && (!(*bufferPtr & 0x80)));			
+	if (sysexOut.length == 0)
+		sysex_build_response();
+
+	uint32_t n = sysexOut.length - sysexOut.sent;
+	if (n > SYSEX_RESPONSE_CHUNK)
+		n = SYSEX_RESPONSE_CHUNK;
+
+	uint32_t written;
+	if (host)
+	{
+		if (!midiDeviceConnected || midiDeviceOutputCable < 0)
+		{
+			sysexOut.command = 0; // nowhere to send it
+			return;
 		}
+		written = tuh_midi_stream_write(midiDeviceAddress, midiDeviceOutputCable, &sysexOut.message[sysexOut.sent], n);
+		tuh_midi_stream_flush(midiDeviceAddress);
+	}
+	else
+	{
+		written = tud_midi_stream_write(0, &sysexOut.message[sysexOut.sent], n);
+	}
+
+	sysexOut.sent += written;
+	if (sysexOut.sent == sysexOut.length)
+	{
+		sysexOut.length = 0;
+		if (++sysexOut.messageIndex == sysexOut.numMessages)
+			sysexOut.command = 0;
+	}
+}
+
+void midi_device_task()
+{
+	// Read incoming packets if available
+	uint8_t p[4];
+	while (tud_midi_packet_read(p))
+	{
+		handle_usb_midi_packet(p);
 	}
 }
 
@@ -711,46 +735,15 @@ void tuh_midi_umount_cb(uint8_t dev_addr, uint8_t instance)
 	}
 }
 
-// Handle host-mode incoming midi message
-void tuh_midi_rx_cb(uint8_t dev_addr, uint32_t num_packets)
+// Handle host-mode incoming midi messages, parsed in place from the USB endpoint buffer
+void tuh_midi_rx_packets_cb(uint8_t dev_addr, uint8_t const *packets, uint32_t num_packets)
 {
 	if (midiDeviceAddress != dev_addr)
 		return;
 
-	if (num_packets == 0)
-		return;
-	
-	uint8_t cable_num;
-	static uint8_t buffer[512];
-	while (1)
+	for (uint32_t i = 0; i < num_packets; i++, packets += 4)
 	{
-		int32_t bytesToProcess = tuh_midi_stream_read(dev_addr, &cable_num, buffer, sizeof(buffer));
-		uint8_t *bptr = buffer;
-
-		if (bytesToProcess == 0)
-		{
-			break;
-		}
-		
-		while (bytesToProcess > 0)
-		{
-			if (bptr[0] == 0xF0)
-			{
-				process_sys_ex_command(bptr);
-			}
-			else
-			{
-				handle_midi_message(bptr);
-			}
-
-			// move pointer along until we reach an other MIDI command byte
-			do 
-			{
-				bptr++;
-				bytesToProcess--;
-			} while (bytesToProcess > 0 && (!(*bptr & 0x80)));			
-		}
-
+		handle_usb_midi_packet(packets);
 	}
 }
 
@@ -883,11 +876,75 @@ void handle_midi_message(uint8_t *packet)
 
 reverb *dv = 0;
 
+// The reverb tank runs on the audio core, outside the per-sample ISR, in blocks of REVERB_BLOCK_SIZE
+// samples: process_sample writes each input sample into revIn, and takes the reverb output from
+// REVERB_LATENCY samples earlier out of revOutL/R. The audio core's main loop processes each block
+// as soon as process_sample has filled it, with one block period to do so before it is needed.
+#define REVERB_BLOCK_SIZE REVERB_MOD_BLOCK
+#define REVERB_RING_SIZE (4 * REVERB_BLOCK_SIZE)
+#define REVERB_LATENCY (2 * REVERB_BLOCK_SIZE)
+int32_t revIn[NUM_INPUTS][REVERB_RING_SIZE], revOutL[REVERB_RING_SIZE], revOutR[REVERB_RING_SIZE];
+volatile uint32_t revWritten = 0; // samples written into revIn
+
+// Reverb parameters, set by process_sample and applied to the tank once per block
+volatile int32_t revTilt = 62259, revSize = 49152, revFreezeMult = 256;
+
+// Set by the USB core; the reset itself is done by the audio core, between blocks
+volatile bool revResetRequest = false;
+
+
+#ifdef ENABLE_MIDI
+// MIDI messages (other than SysEx) are passed from the USB core to process_sample through a
+// lock-free single-producer, single-consumer FIFO. Each is stamped on arrival with the sample
+// counter (revWritten) and handled MIDI_LATENCY samples later, so that notes and CCs keep their
+// relative timing however irregularly the USB loop runs, rather than landing whenever it happens
+// to get round to them.
+#define MIDI_QUEUE_SIZE 64 // power of two
+#define MIDI_LATENCY 48    // samples; at least the USB loop jitter (1ms)
+typedef struct
+{
+	uint32_t sample; // sample at which to handle the message
+	uint8_t data[3];
+} midi_event;
+midi_event midiQueue[MIDI_QUEUE_SIZE];
+uint32_t midiQueueHead = 0, midiQueueTail = 0; // written by the USB core / audio core respectively
+
+// USB core: queue the message at packet, up to the next status byte (at most length bytes)
+void queue_midi_message(const uint8_t *packet, uint32_t length)
+{
+	uint32_t h = midiQueueHead;
+	if (h - __atomic_load_n(&midiQueueTail, __ATOMIC_ACQUIRE) == MIDI_QUEUE_SIZE)
+		return; // full: drop the message
+
+	midi_event *e = &midiQueue[h & (MIDI_QUEUE_SIZE - 1)];
+	e->sample = revWritten + MIDI_LATENCY;
+	e->data[0] = packet[0];
+	for (uint32_t i = 1; i < 3; i++)
+		e->data[i] = (i < length && !(packet[i] & 0x80)) ? packet[i] : 0;
+	__atomic_store_n(&midiQueueHead, h + 1, __ATOMIC_RELEASE);
+}
+
+// Audio core, once per sample: handle queued messages that are due by sample n
+void __not_in_flash_func(handle_due_midi_messages)(uint32_t n)
+{
+	uint32_t t = midiQueueTail;
+	while (__atomic_load_n(&midiQueueHead, __ATOMIC_ACQUIRE) != t)
+	{
+		midi_event *e = &midiQueue[t & (MIDI_QUEUE_SIZE - 1)];
+		if ((int32_t)(n - e->sample) < 0)
+			break;
+		handle_midi_message(e->data);
+		t++;
+		__atomic_store_n(&midiQueueTail, t, __ATOMIC_RELEASE);
+	}
+}
+#endif
+
 
 // After saving to flash, reset reverb buffers (occasionally had reverb overflow)
 void post_flash_processing()
 {
-	reverb_reset(dv);
+	revResetRequest = true;
 
 	n_notes_on_pulse1 = 0;
 	n_notes_on_pulse2 = 0;
@@ -920,21 +977,12 @@ void usb_worker()
 	set_config_from_flash();
 
 
-	// Precalculate exponential lookup table, used only by this core.
-	float f = 67108864; // 2^26
-	for (int i = 0; i < 128; i++)
-	{
-		pow2_128[i] = (uint32_t)f;
-		f *= 1.005429901112803f; // 2^(1/128)
-	}
-
 		
 	sleep_us(100000); // wait 0.1s
 #ifdef ENABLE_MIDI
 
 	// work out MIDI host status
 	uint8_t boardid = GetBoardID();
-	bool isHost;
 	if (boardid == BOARD_PROTO_1 || boardid == BOARD_PROTO_2_0)
 	{
 		// USB host mode not supported on 2024 boards
@@ -998,13 +1046,11 @@ void usb_worker()
 			tud_task();
 			midi_device_task();
 		}
+		sysex_response_task(isHost);
 #endif
 
-		// Do this processing in the second core, as it's a relatively expensive calculation
-		// though should be quicker now it is not floating point
-//		clock_set_freq_hz(&clk[0], tempo_source_from_config(SEN_CLKA_TEMPO));
-//		clock_set_freq_hz(&clk[1], tempo_source_from_config(SEN_CLKB_TEMPO));
-
+		// Do this processing in the second core, as it's a relatively expensive calculation.
+		// The audio core picks up the new tempo at block rate (clock_retune)
 		clock_set_freq_incr(&clk[0], tempo_source_from_config_incr(SEN_CLKA_TEMPO));
 		clock_set_freq_incr(&clk[1], tempo_source_from_config_incr(SEN_CLKB_TEMPO));
 		
@@ -1028,10 +1074,6 @@ void usb_worker()
 // Main audio core function
 void __not_in_flash_func(audio_worker)()
 {
-	// Audio worker must be able to stop when USB worker wants to write to flash
-	multicore_lockout_victim_init();
-
-
 	adc_select_input(0);
 	adc_set_round_robin(0b0001111U);
 
@@ -1085,27 +1127,39 @@ void __not_in_flash_func(audio_worker)()
 
 
 	// Sample processing loop
-	noise_gate_init(&ng);
+	for (int c = 0; c < NUM_INPUTS; c++)
+		noise_gate_init(&ng[c]);
 
 
 	adc_run(true);
 
+	// Run the reverb tank, a block at a time, whenever the ISR isn't running
+	uint32_t revDone = 0; // samples processed
 	while (1)
 	{
-		// If ready to restart
-		if (runADCMode == RUN_ADC_MODE_REQUEST_ADC_RESTART)
-		{
-			runADCMode = RUN_ADC_MODE_RUNNING;
+		uint32_t written = revWritten;
+		if (written - revDone < REVERB_BLOCK_SIZE)
+			continue;
 
-			dma_hw->ints0 = 1u << adc_dma; // reset adc interrupt flag
-			dma_channel_set_write_addr(adc_dma, ADC_Buffer[dmaPhase], true); // start writing into new buffer
-			dma_channel_set_read_addr(spi_dma, SPI_Buffer[dmaPhase], true); // start reading from new buffer
+		// If we've fallen more than a ring behind (shouldn't happen), skip to the latest full block
+		if (written - revDone > REVERB_RING_SIZE - REVERB_BLOCK_SIZE)
+			revDone = (written & ~(REVERB_BLOCK_SIZE - 1)) - REVERB_BLOCK_SIZE;
 
-			adc_set_round_robin(0);
-			adc_select_input(0);
-			adc_set_round_robin(0b0001111U);
-			adc_run(true);
+		if (revResetRequest)
+		{
+			reverb_reset(dv);
+			revResetRequest = false;
 		}
+		reverb_set_tilt(dv, revTilt);
+		reverb_set_freeze_size(dv, revSize, revFreezeMult);
+
+		int i = revDone % REVERB_RING_SIZE;
+#ifdef STEREO_INPUT
+		reverb_process_block_stereo(dv, &revIn[0][i], &revIn[1][i], &revOutL[i], &revOutR[i], REVERB_BLOCK_SIZE);
+#else
+		reverb_process_block(dv, &revIn[0][i], &revOutL[i], &revOutR[i], REVERB_BLOCK_SIZE);
+#endif
+		revDone += REVERB_BLOCK_SIZE;
 	}
 }
 
@@ -1123,7 +1177,7 @@ const int startupSampleDelay = 20000;
 void __not_in_flash_func(process_sample)()
 {
 	//	gpio_put(DEBUG_2, true);
-	static int32_t mix1, mix2, mixf1, mixf2;
+	static int32_t mix1[NUM_INPUTS], mix2[NUM_INPUTS], mixf1[NUM_INPUTS], mixf2[NUM_INPUTS];
 
 	static int32_t frame = 0;
 	static uint32_t cv1Noise = 0, cv2Noise = 0;
@@ -1165,11 +1219,12 @@ void __not_in_flash_func(process_sample)()
 
 	// Tone
 	knob = continuous_source_from_config(SEN_REV_TONE);
-	reverb_set_tilt(dv, clamp(knob, 0, 4095) * 16);
+	revTilt = clamp(knob, 0, 4095) * 16;
 
 	int32_t fm_mult = freeze_mute(frozenReverb);
 
-	reverb_set_freeze_size(dv, knobx, fm_mult);
+	revSize = knobx;
+	revFreezeMult = fm_mult;
 
 
 	////////////////////////////////////////
@@ -1192,28 +1247,45 @@ void __not_in_flash_func(process_sample)()
 		}
 	}
 
-	int32_t mix = (adcInL - adcInR) << 2; // mix is limited by ±16384
+#ifdef STEREO_INPUT
+	int32_t mix[2] = { adcInL << 3, -adcInR << 3 }; // each limited by ±16384
+#else
+	int32_t mix[1] = { (adcInL - adcInR) << 2 }; // mix is limited by ±16384
+#endif
 
-	// 12kHz notch filter, to remove interference from mux lines
-	int32_t ooa0 = 16302, a2oa0 = 16221; // Q = 100, very narrow notch
-	int32_t mixf = (ooa0 * (mix + mix2) - a2oa0 * mixf2) >> 14;
-	mix2 = mix1;
-	mix1 = mix;
-	mixf2 = mixf1;
-	mixf1 = mixf;
+	uint32_t n = revWritten;
 
-	// If switch is in middle position, apply noise gate to mixed ADC input
-	int32_t gated_mono_in = (knobs[KNOB_SWITCH] < 3000) ? noise_gate_tick(&ng, mixf) : mixf;
+#ifdef ENABLE_MIDI
+	handle_due_midi_messages(n);
+#endif
+
+	int32_t dry[NUM_INPUTS];
+	for (int c = 0; c < NUM_INPUTS; c++)
+	{
+		// 12kHz notch filter, to remove interference from mux lines
+		int32_t ooa0 = 16302, a2oa0 = 16221; // Q = 100, very narrow notch
+		int32_t mixf = (ooa0 * (mix[c] + mix2[c]) - a2oa0 * mixf2[c]) >> 14;
+		mix2[c] = mix1[c];
+		mix1[c] = mix[c];
+		mixf2[c] = mixf1[c];
+		mixf1[c] = mixf;
+
+		// If switch is in middle position, apply noise gate to mixed ADC input
+		int32_t gated_in = (knobs[KNOB_SWITCH] < 3000) ? noise_gate_tick(&ng[c], mixf) : mixf;
 
-	// If reverb frozen, mute input signal, with fade in/out
-	gated_mono_in = (fm_mult * gated_mono_in) >> 8;
+		// If reverb frozen, mute input signal, with fade in/out
+		gated_in = (fm_mult * gated_in) >> 8;
 
-	// Run the reverb algorithm
-	reverb_process(dv, gated_mono_in);
-	int32_t left = reverb_get_left(dv);
-	int32_t right = reverb_get_right(dv);
+		// Pass input to the reverb, which runs in the audio core's main loop
+		revIn[c][n % REVERB_RING_SIZE] = gated_in;
 
-	int32_t dry = gated_mono_in << 1; // +- 32768
+		dry[c] = gated_in << 1; // +- 32768
+	}
+
+	// Get reverb output
+	int32_t left = revOutL[(n - REVERB_LATENCY) % REVERB_RING_SIZE];
+	int32_t right = revOutR[(n - REVERB_LATENCY) % REVERB_RING_SIZE];
+	revWritten = n + 1;
 
 	// Get absolute values of wet output, for VU meter
 	int32_t aleft = left;
@@ -1221,8 +1293,8 @@ void __not_in_flash_func(process_sample)()
 
 	// Crossfade wet and dry signals
 	// ( (0 to 4096)  * (-32768 to 32768) )/2^16 = -2048 to 2048
-	left = (drywet * left + (4096 - drywet) * dry) >> 16;
-	right = (drywet * right + (4096 - drywet) * dry) >> 16;
+	left = (drywet * left + (4096 - drywet) * dry[0]) >> 16;
+	right = (drywet * right + (4096 - drywet) * dry[NUM_INPUTS - 1]) >> 16;
 
 	// generate values for DAC, with final stage of clipping
 	dacOutL = clamp(left, -2047, 2047);
@@ -1365,9 +1437,20 @@ void __not_in_flash_func(process_sample)()
 
 	////////////////////////////////////////
 	// Actions driven by the two internal clocks
+	// Clocks only run once out of the startup state, so have their own sample time
+	static uint32_t clockTime = 0;
+	clockTime++;
+
+	// Pick up tempo changes from the other core every 32 samples (0.67ms)
+	if ((clockTime & 0x1F) == 0)
+	{
+		clock_retune(&clk[0], clockTime);
+		clock_retune(&clk[1], clockTime);
+	}
+
 	for (int clk_index = 0; clk_index < 2; clk_index++)
 	{
-		if (clock_tick(&clk[clk_index])) // true for both rising and falling edges
+		if (clock_tick(&clk[clk_index], clockTime)) // true for both rising and falling edges
 		{
 			bool risingEdge = clock_state(&clk[clk_index]);
 			int clockOpt = OPT_INTERNAL_CLOCK_A + clk_index;
@@ -1498,6 +1581,8 @@ int main()
 	ReadEEPROM();
 
 	dv = reverb_create();
+	reverb_set_algorithm(dv, REVERB_ALGORITHM);
+	debug("Reverb tank: %u of %u bytes\n", (unsigned)reverb_memory_used(dv), (unsigned)(REVERB_SLAB_SIZE * sizeof(int16_t)));
 
 	turing_machine_init(&tm);
 	bernoulli_gate_init(&bg);
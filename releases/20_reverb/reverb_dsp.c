@@ -14,6 +14,13 @@
   to ASR instruction, which divides negative numbers by two, rounding towards
   negative infinity.
   In the allpass filter, (a*(b>>4))>>12 is used, to give more audio headroom without wrapping
+
+  Delay memory is int16 (samples are kept within about ±16383, and saturated to 16 bits when
+  stored), in one slab shared by all the buffers; see reverb_dsp.h.
+
+  Besides the Dattorro plate, reverb_set_algorithm can re-partition the part of the slab after
+  the input stages for a small room (four-line feedback delay network), a shimmer plate (the
+  plate, with an octave-up pitch shifter in its cross feedback) or a multi-tap echo.
 */
 
 #include "reverb_dsp.h"
@@ -34,72 +41,62 @@ int32_t __not_in_flash_func(clamp)(int32_t x, int32_t min, int32_t max)
 	return x;
 }
 
-// Set delay amount 
+// Saturate to 16 bits, for storing in delay memory
+static inline int32_t __not_in_flash_func(sat16)(int32_t x)
+{
+	if ((uint32_t)(x + 32768) > 65535u)
+		return (x < 0) ? -32768 : 32767;
+	return x;
+}
+
+// Set delay amount (at most length - 1)
 void __not_in_flash_func(buffer_setDelay)(buffer *db, uint16_t tap, uint16_t delay)
 {
-	db->readOffset[tap] = db->mask + 1 - delay;
+	if (delay >= db->length)
+		delay = db->length - 1;
+	db->readOffset[tap] = db->writeOffset - delay;
 }
 
 ////////////////////////////////////////
 // Delay functions
-void buffer_init(buffer *db, uint16_t delay)
-{
-	memset(db, 0, sizeof(delay));
 
-	// Calculate number of bits
-	int16_t x = delay;
-	uint16_t numBits = 0;
-	while (x)
-	{
-		numBits++;
-		x >>= 1;
-	}
-
-	// Buffer size is always 2^n, to avoid
-	uint16_t bufferSize = 1 << numBits;
+// Carve a buffer holding delays up to 'delay' + 'excursion' samples from the reverb's slab.
+// Buffers are laid out downwards from offset 0: a sample written by this buffer survives until the
+// next buffer's region (length samples below) reaches it. Returns 0 if the slab is full.
+int buffer_init(reverb *v, buffer *db, uint16_t delay, uint16_t excursion)
+{
+	memset(db, 0, sizeof(buffer));
 
-	// Allocate buffer
-	db->buffer = malloc(bufferSize * sizeof(int32_t));
-	if (!db->buffer)
-		return;
+	uint32_t length = (uint32_t)delay + excursion + 1;
+	if (v->slabUsed + length > REVERB_SLAB_SIZE)
+		return 0;
 
-	// Clear buffer
-	memset(db->buffer, 0, bufferSize * sizeof(int32_t));
+	db->buffer = v->slab;
+	db->writeOffset = (uint16_t)(0u - v->slabUsed);
+	db->length = (uint16_t)length;
+	v->slabUsed += (uint16_t)length;
 
-	// Create bitmask for fast wrapping of the circular buffer
-	db->mask = bufferSize - 1;
 	buffer_setDelay(db, TAP_MAIN, delay);
-}
-
-void buffer_clear(buffer *db)
-{
-	uint16_t size = db->mask + 1;
-	memset(db->buffer, 0, size * sizeof(int32_t));
-}
-
-void buffer_delete(buffer *db)
-{
-	free(db->buffer);
-	db->buffer = 0;
+	return 1;
 }
 
 // Write input value into buffer, read delayed output 
 int32_t __not_in_flash_func(delay_process)(buffer *db, uint16_t t, int32_t in)
 {
-	db->buffer[t & db->mask] = in;
-	return db->buffer[(t + db->readOffset[TAP_MAIN]) & db->mask];
+	db->buffer[(t + db->writeOffset) & REVERB_SLAB_MASK] = sat16(in);
+	return db->buffer[(t + db->readOffset[TAP_MAIN]) & REVERB_SLAB_MASK];
 }
 
 // Write value into delay buffer 
 void __not_in_flash_func(buffer_write)(buffer *db, uint16_t t, int32_t in)
 {
-	db->buffer[t & db->mask] = in;
+	db->buffer[(t + db->writeOffset) & REVERB_SLAB_MASK] = sat16(in);
 }
 
 // Read delayed output value 
 int32_t __not_in_flash_func(buffer_read)(buffer *db, uint16_t tapId, uint16_t t)
 {
-	return db->buffer[(t + db->readOffset[tapId]) & db->mask];
+	return db->buffer[(t + db->readOffset[tapId]) & REVERB_SLAB_MASK];
 }
 
 
@@ -120,6 +117,33 @@ int32_t __not_in_flash_func(allpass_process)(buffer *db, uint16_t t, int32_t gai
 	return delayed + ((in * gain) >> 12);
 }
 
+/*
+Read TAP_MAIN delayed by a further 0.5 to 1.5 samples, with first-order allpass interpolation:
+  y[n] = x[n-1] + eta * (x[n] - y[n-1]),   eta = (1 - frac) / (1 + frac)
+Unlike linear interpolation this doesn't lowpass the signal, which in the reverb's feedback loop
+would shorten the tail. 'eta' is Q15, '*y' holds the interpolator's previous output.
+*/
+static inline int32_t __not_in_flash_func(buffer_read_frac)(buffer *db, uint16_t t, int32_t eta, int32_t *y)
+{
+	uint16_t i = t + db->readOffset[TAP_MAIN];
+	int32_t a = db->buffer[i & REVERB_SLAB_MASK];
+	int32_t b = db->buffer[(uint16_t)(i - 1) & REVERB_SLAB_MASK];
+	*y = b + ((eta * (a - *y)) >> 15);
+	return *y;
+}
+
+// Allpass filter with fractional delay, see buffer_read_frac
+int32_t __not_in_flash_func(allpass_process_frac)(buffer *db, uint16_t t, int32_t gain, int32_t eta, int32_t *y, int32_t in)
+{
+	gain >>= 4;
+
+	int32_t delayed = buffer_read_frac(db, t, eta, y);
+	in += ((delayed * -gain) >> 12);
+
+	buffer_write(db, t, in);
+	return delayed + ((in * gain) >> 12);
+}
+
 
 /*
 Single-pole IIR lowpass
@@ -143,6 +167,17 @@ int32_t __not_in_flash_func(highpass_process)(int32_t *out, int32_t b, int32_t i
 }
 
 
+// Echo taps for a size (0 to 65535): the longest, and feedback, from about 20ms to 460ms, with
+// TAP_OUT1..3 at a quarter, half and three quarters of it
+static void __not_in_flash_func(echo_set_time)(reverb *v, int32_t size)
+{
+	int32_t d = 1024 + ((clamp(size, 0, 65535) * (REVERB_ECHO_MAX_DELAY - 1024)) >> 16);
+	buffer_setDelay(&v->echo, TAP_MAIN, d);
+	buffer_setDelay(&v->echo, TAP_OUT1, d >> 2);
+	buffer_setDelay(&v->echo, TAP_OUT2, d >> 1);
+	buffer_setDelay(&v->echo, TAP_OUT3, (3 * d) >> 2);
+}
+
 // Set decay amount and calculate related decay diffusion 2 amount. Value is  65536 * float value 
 void __not_in_flash_func(reverb_set_size)(reverb *v, int32_t size)
 {
@@ -153,6 +188,10 @@ void __not_in_flash_func(reverb_set_size)(reverb *v, int32_t size)
 
 	// set pre-delay amount. This is the line that causes pitch shift when knob x is altered
 	buffer_setDelay(&v->preDelay, TAP_MAIN, size >> 4);
+	buffer_setDelay(&v->preDelayR, TAP_MAIN, size >> 4);
+
+	if (v->algorithm == REVERB_ECHO)
+		echo_set_time(v, size);
 }
 
 // Set decay amount and calculate related decay diffusion 2 amount. Value is  65536 * float value 
@@ -164,8 +203,15 @@ void __not_in_flash_func(reverb_set_freeze_size)(reverb *v, int32_t size, int32_
 	v->decayAmount = (65536 * (256 - mult) + value * mult) >> 8;
 	v->decayDiffusion2Amount = clamp(value + 9830, 16384, 32768);
 
+	// Fully frozen: the input is muted, so the block path can stop running the input stages
+	v->frozen = (mult == 0);
+
 	// set pre-delay amount. This is the line that causes pitch shift when knob x is altered
 	buffer_setDelay(&v->preDelay, TAP_MAIN, size >> 4);
+	buffer_setDelay(&v->preDelayR, TAP_MAIN, size >> 4);
+
+	if (v->algorithm == REVERB_ECHO)
+		echo_set_time(v, size);
 }
 
 
@@ -183,58 +229,187 @@ void __not_in_flash_func(reverb_set_tilt)(struct sreverb *v, int32_t value)
 	v->preFilterHPF = value >> 1;
 }
 
-// Initialise reverb instance
-void initialise(reverb *v)
+// Set how much of each stereo input channel goes into the opposite half of the tank,
+// from 0 (none) to 0.5 (mono). Value is 65536 * float value
+void reverb_set_stereo_cross(struct sreverb *v, int32_t value)
 {
-	memset(v, 0, sizeof(reverb));
+	v->stereoCross = clamp(value, 0, 32768) >> 1;
+}
+
+// Set decay diffuser modulation: rate as phase increment per sample (see REVERB_MOD_RATE_HZ),
+// depth in samples, Q16. Depth 0 turns modulation off.
+void reverb_set_modulation(struct sreverb *v, uint32_t rate, int32_t depth)
+{
+	v->modRate = rate;
+	v->modDepth = clamp(depth, 0, REVERB_MOD_MAX_DEPTH << 16);
+}
 
-	buffer_init(&v->preDelay, 4100);
+// Recalculate the decay diffuser lengths, every REVERB_MOD_BLOCK samples.
+// Triangle LFO, the two halves of the tank a quarter cycle apart; each diffuser is lengthened
+// by 0 to modDepth samples, split into whole samples (TAP_MAIN) and a fraction of 0.5 to 1.5
+// samples for the allpass interpolator.
+static void __not_in_flash_func(update_modulation)(reverb *v)
+{
+	v->modPhase += v->modRate * REVERB_MOD_BLOCK;
+
+	for (int i = 0; i < 2; i++)
+	{
+		uint32_t phase = v->modPhase + (i ? 0x40000000u : 0);
+		uint32_t tri = ((phase & 0x80000000u) ? ~phase : phase) >> 15; // Q16, 0 to 65535
+		uint32_t d = (uint32_t)(((uint64_t)v->modDepth * tri) >> 16);  // samples, Q16
+
+		int32_t whole = ((int32_t)d - 32768) >> 16; // -1 to modDepth - 1
+		int32_t frac = (int32_t)d - (whole << 16);    // Q16, 0.5 to 1.5
+
+		buffer *db = &v->decayDiffusion1[i];
+		db->readOffset[TAP_MAIN] = db->readOffset[TAP_OUT1] - (uint16_t)whole;
+		v->modEta[i] = ((65536 - frac) << 15) / (65536 + frac);
+	}
+}
 
-	buffer_init(&v->inDiffusion[0], 142);
-	buffer_init(&v->inDiffusion[1], 107);
-	buffer_init(&v->inDiffusion[2], 379);
-	buffer_init(&v->inDiffusion[3], 277);
+// Modulation excursion of the decay diffusers, in samples: the maximum depth, plus one for interpolation
+#define DECAY_DIFFUSION1_EXCURSION (REVERB_MOD_MAX_DEPTH + 1)
 
-	buffer_init(&v->decayDiffusion1[0], 672); // + EXCURSION
+////////////////////////////////////////
+// Algorithms
+//
+// Each lays out its buffers in the slab after the input stages (from inputSlabUsed), returning 0
+// if they don't fit.
+
+// Dattorro plate: two halves of a tank, each decay diffuser, delay, damping, decay diffuser, delay,
+// feeding the other
+static int layout_plate(reverb *v)
+{
+	int ok = 1;
+
+	ok &= buffer_init(v, &v->decayDiffusion1[0], 672, DECAY_DIFFUSION1_EXCURSION);
 	v->decayDiffusion1[0].readOffset[TAP_OUT1] = v->decayDiffusion1[0].readOffset[TAP_MAIN];
 
-	buffer_init(&v->preDampingDelay[0], 4453);
+	ok &= buffer_init(v, &v->preDampingDelay[0], 4453, 0);
 	buffer_setDelay(&v->preDampingDelay[0], TAP_OUT1, 353);
 	buffer_setDelay(&v->preDampingDelay[0], TAP_OUT2, 3627);
 	buffer_setDelay(&v->preDampingDelay[0], TAP_OUT3, 1990);
 
-	buffer_init(&v->decayDiffusion2[0], 1800);
+	ok &= buffer_init(v, &v->decayDiffusion2[0], 1800, 0);
 	buffer_setDelay(&v->decayDiffusion2[0], TAP_OUT1, 187);
 	buffer_setDelay(&v->decayDiffusion2[0], TAP_OUT2, 1228);
 
-	buffer_init(&v->postDampingDelay[0], 3720);
+	ok &= buffer_init(v, &v->postDampingDelay[0], 3720, 0);
 	buffer_setDelay(&v->postDampingDelay[0], TAP_OUT1, 1066);
 	buffer_setDelay(&v->postDampingDelay[0], TAP_OUT2, 2673);
 
-	buffer_init(&v->decayDiffusion1[1], 908); // + EXCURSION
+	ok &= buffer_init(v, &v->decayDiffusion1[1], 908, DECAY_DIFFUSION1_EXCURSION);
 	v->decayDiffusion1[1].readOffset[TAP_OUT1] = v->decayDiffusion1[1].readOffset[TAP_MAIN];
 
-	buffer_init(&v->preDampingDelay[1], 4217);
+	ok &= buffer_init(v, &v->preDampingDelay[1], 4217, 0);
 	buffer_setDelay(&v->preDampingDelay[1], TAP_OUT1, 266);
 	buffer_setDelay(&v->preDampingDelay[1], TAP_OUT2, 2974);
 	buffer_setDelay(&v->preDampingDelay[1], TAP_OUT3, 2111);
 
-	buffer_init(&v->decayDiffusion2[1], 2656);
+	ok &= buffer_init(v, &v->decayDiffusion2[1], 2656, 0);
 	buffer_setDelay(&v->decayDiffusion2[1], TAP_OUT1, 335);
 	buffer_setDelay(&v->decayDiffusion2[1], TAP_OUT2, 1913);
 
-	buffer_init(&v->postDampingDelay[1], 3163);
+	ok &= buffer_init(v, &v->postDampingDelay[1], 3163, 0);
 	buffer_setDelay(&v->postDampingDelay[1], TAP_OUT1, 121);
 	buffer_setDelay(&v->postDampingDelay[1], TAP_OUT2, 1996);
 
+	// Output taps, for gather_output_taps: right is left with the tank's halves swapped
+	const buffer *tapBuffers[2][REVERB_OUT_TAPS] = {
+		{ &v->preDampingDelay[1], &v->preDampingDelay[1], &v->decayDiffusion2[1], &v->postDampingDelay[1],
+		  &v->preDampingDelay[0], &v->decayDiffusion2[0], &v->postDampingDelay[0] },
+		{ &v->preDampingDelay[0], &v->preDampingDelay[0], &v->decayDiffusion2[0], &v->postDampingDelay[0],
+		  &v->preDampingDelay[1], &v->decayDiffusion2[1], &v->postDampingDelay[1] } };
+	const uint8_t tapIds[REVERB_OUT_TAPS] = { TAP_OUT1, TAP_OUT2, TAP_OUT2, TAP_OUT2, TAP_OUT3, TAP_OUT1, TAP_OUT1 };
+	for (int c = 0; c < 2; c++)
+		for (int k = 0; k < REVERB_OUT_TAPS; k++)
+			v->outTap[c][k] = tapBuffers[c][k]->readOffset[tapIds[k]];
+	return ok;
+}
+
+// Small room: four delays, mixed by a Hadamard matrix
+static int layout_room(reverb *v)
+{
+	static const uint16_t lengths[4] = { 1171, 1543, 1879, 2293 }; // about 24 to 48ms, coprime
+
+	int ok = 1;
+	for (int i = 0; i < 4; i++)
+		ok &= buffer_init(v, &v->room[i], lengths[i], 0);
+	return ok;
+}
+
+// Shimmer: the plate, with REVERB_SHIMMER_GRAIN samples for the pitch shifter
+static int layout_shimmer(reverb *v)
+{
+	int ok = layout_plate(v);
+	ok &= buffer_init(v, &v->shimmer, REVERB_SHIMMER_GRAIN, 0);
+	return ok;
+}
+
+// Echo: one delay of up to REVERB_ECHO_MAX_DELAY samples, with four taps
+static int layout_echo(reverb *v)
+{
+	int ok = buffer_init(v, &v->echo, REVERB_ECHO_MAX_DELAY, 0);
+	echo_set_time(v, 49152);
+	return ok;
+}
+
+static int (*const layouts[REVERB_NUM_ALGORITHMS])(reverb *v) = { layout_plate, layout_room, layout_shimmer, layout_echo };
+
+// Cycles per sample of reverb_process_block(_stereo) for each algorithm, see reverb_dsp.h
+const uint16_t reverb_cycle_budget[REVERB_NUM_ALGORITHMS] = { REVERB_BUDGET_PLATE, REVERB_BUDGET_ROOM, REVERB_BUDGET_SHIMMER, REVERB_BUDGET_ECHO };
+
+// Re-partition the slab for an algorithm, and silence the reverb. Returns 0, leaving the plate, if
+// the algorithm is unknown or its buffers don't fit
+int reverb_set_algorithm(reverb *v, int algorithm)
+{
+	int ok = (algorithm >= 0 && algorithm < REVERB_NUM_ALGORITHMS);
+
+	v->slabUsed = v->inputSlabUsed;
+	if (ok)
+		ok = layouts[algorithm](v);
+	if (!ok)
+	{
+		algorithm = REVERB_PLATE;
+		v->slabUsed = v->inputSlabUsed;
+		layout_plate(v);
+	}
+	v->algorithm = algorithm;
+	reverb_reset(v);
+	return ok;
+}
+
+// Initialise reverb instance; returns 0 if the buffers don't fit in the slab
+int initialise(reverb *v)
+{
+	memset(v, 0, sizeof(reverb));
+
+	int ok = 1;
+
+	ok &= buffer_init(v, &v->preDelay, 4100, 0);
+	ok &= buffer_init(v, &v->preDelayR, 4100, 0);
+
+	ok &= buffer_init(v, &v->inDiffusion[0], 142, 0);
+	ok &= buffer_init(v, &v->inDiffusion[1], 107, 0);
+	ok &= buffer_init(v, &v->inDiffusion[2], 379, 0);
+	ok &= buffer_init(v, &v->inDiffusion[3], 277, 0);
+
+	// Right input diffusers (stereo input only), slightly different lengths to decorrelate
+	ok &= buffer_init(v, &v->inDiffusionR[0], 151, 0);
+	ok &= buffer_init(v, &v->inDiffusionR[1], 113, 0);
+	ok &= buffer_init(v, &v->inDiffusionR[2], 397, 0);
+	ok &= buffer_init(v, &v->inDiffusionR[3], 293, 0);
+	v->inputSlabUsed = v->slabUsed;
+
+	ok &= reverb_set_algorithm(v, REVERB_PLATE);
+
 	// Default settings
-	v->modulate = 0x7ff;
-	v->modulatedist = 16;
+	reverb_set_modulation(v, REVERB_MOD_RATE_HZ(0.732), 16 << 16);
 
 	v->lpf = 1;
-	v->tapModVal = 0;
-	v->tapDir = -1;
 	buffer_setDelay(&v->preDelay, TAP_MAIN, 400);
+	buffer_setDelay(&v->preDelayR, TAP_MAIN, 400);
+	reverb_set_stereo_cross(v, 16384);
 	v->preFilterHPF = 49152;
 	v->preFilterLPF = 49152;
 	v->inputDiffusion1Amount = 49152;
@@ -242,39 +417,37 @@ void initialise(reverb *v)
 	v->decayDiffusion1Amount = 45875;
 	reverb_set_size(v, 49152);
 	reverb_set_tilt(v, 62259);
+	return ok;
 }
 
-// Get pointer to initialised reverb instance
+// The one reverb instance, slab included, in static memory rather than the heap,
+// so that the linker checks it fits in SRAM
+static reverb instance;
+static int instanceInUse = 0;
+
+// Get pointer to initialised reverb instance, or NULL if it is already in use
 reverb *reverb_create(void)
 {
-	reverb *v = malloc(sizeof(reverb));
-	if (!v)
+	if (instanceInUse)
 		return NULL;
 
-	initialise(v);
-	return v;
+	if (!initialise(&instance))
+		return NULL;
+	instanceInUse = 1;
+	return &instance;
 }
 
-// Free resources and delete reverb instance
+// Release the reverb instance
 void reverb_delete(reverb *v)
 {
-	// Free delay buffers
-	buffer_delete(&v->preDelay);
-
-	for (int i = 0; i < 4; i++)
-	{
-		buffer_delete(&v->inDiffusion[i]);
-	}
-
-	for (int i = 0; i < 2; i++)
-	{
-		buffer_delete(&v->decayDiffusion1[i]);
-		buffer_delete(&v->preDampingDelay[i]);
-		buffer_delete(&v->decayDiffusion2[i]);
-		buffer_delete(&v->postDampingDelay[i]);
-	}
+	if (v == &instance)
+		instanceInUse = 0;
+}
 
-	free(v);
+// Bytes of delay memory used by the tank
+uint32_t reverb_memory_used(reverb *v)
+{
+	return v->slabUsed * sizeof(int16_t);
 }
 
 // Resets buffers to zero 
@@ -282,31 +455,26 @@ void __not_in_flash_func(reverb_reset)(reverb *v)
 {
 	if (!v) return;
 
-	// Free delay buffers
-	buffer_clear(&v->preDelay);
-
-	for (int i = 0; i < 4; i++)
-	{
-		buffer_clear(&v->inDiffusion[i]);
-	}
-
-	for (int i = 0; i < 2; i++)
-	{
-		buffer_clear(&v->decayDiffusion1[i]);
-		buffer_clear(&v->preDampingDelay[i]);
-		buffer_clear(&v->decayDiffusion2[i]);
-		buffer_clear(&v->postDampingDelay[i]);
-	}
+	// Clear delay buffers
+	memset(v->slab, 0, sizeof(v->slab));
 
 	v->preFilterH[0] = 0;
 	v->preFilterL[0] = 0;
 	v->preFilterH[1] = 0;
 	v->preFilterL[1] = 0;
 	v->acCouplingHPF = 0;
+	v->acCouplingHPFR = 0;
 	v->dampingH[0] = 0;
 	v->dampingH[1] = 0;
 	v->dampingL[0] = 0;
 	v->dampingL[1] = 0;
+	v->modState[0] = 0;
+	v->modState[1] = 0;
+	v->frozenFor = 0;
+	for (int i = 0; i < 4; i++)
+		v->roomDampingH[i] = v->roomDampingL[i] = 0;
+	v->shimmerPhase = 0;
+	v->tailHPF[0] = v->tailHPF[1] = 0;
 }
 
 
@@ -315,26 +483,11 @@ void __not_in_flash_func(reverb_process)(reverb *v, int32_t in)
 {
 	int32_t x, x1, x2, x3;
 
-	// Every 2048 samples (23.4Hz at 48kHz sample rate), alter allpass length by 1 sample
-	// Triangle wave modulation, reducing and increasing length by 16 samples
-
 	in = clamp(in, -16384, 16383);
 
-	if (v->modulate && (v->t & v->modulate) == 0)
-	{
-		v->decayDiffusion1[0].readOffset[TAP_MAIN] = v->decayDiffusion1[0].readOffset[TAP_OUT1] + v->tapModVal;
-		v->decayDiffusion1[1].readOffset[TAP_MAIN] = v->decayDiffusion1[1].readOffset[TAP_OUT1] + v->tapModVal;
-
-		v->tapModVal += v->tapDir;
-		if (v->tapModVal <= -v->modulatedist)
-		{
-			v->tapDir = 1;
-		}
-		if (v->tapModVal >= 0)
-		{
-			v->tapDir = -1;
-		}
-	}
+	// Smoothly modulate the decay diffusers' lengths, by up to modDepth samples
+	if ((v->t & (REVERB_MOD_BLOCK - 1)) == 0)
+		update_modulation(v);
 
 	x = delay_process(&v->preDelay, v->t, in); // pre-delay
 
@@ -368,7 +521,7 @@ void __not_in_flash_func(reverb_process)(reverb *v, int32_t in)
 		x1 = clamp(x1, -16383, 16383);
 
 		// Process single half of the tank
-		x1 = allpass_process(&v->decayDiffusion1[i], v->t, -v->decayDiffusion1Amount, x1);
+		x1 = allpass_process_frac(&v->decayDiffusion1[i], v->t, -v->decayDiffusion1Amount, v->modEta[i], &v->modState[i], x1);
 		//		x1 = clamp(x1, -16383, 16383);
 
 		x1 = delay_process(&v->preDampingDelay[i], v->t, x1);
@@ -394,30 +547,458 @@ void __not_in_flash_func(reverb_process)(reverb *v, int32_t in)
 	v->t++;
 }
 
+// Sum of one channel's output taps (v->outTap[c]) at sample i: + + - + - - +
+static inline int32_t __not_in_flash_func(tap_sum)(const int16_t *b, const uint16_t *o, uint16_t i)
+{
+	return b[(i + o[0]) & REVERB_SLAB_MASK] + b[(i + o[1]) & REVERB_SLAB_MASK] - b[(i + o[2]) & REVERB_SLAB_MASK]
+		+ b[(i + o[3]) & REVERB_SLAB_MASK] - b[(i + o[4]) & REVERB_SLAB_MASK] - b[(i + o[5]) & REVERB_SLAB_MASK]
+		+ b[(i + o[6]) & REVERB_SLAB_MASK];
+}
+
+// Both channels' output taps for n samples from t, in one pass: each sample's fourteen reads share its
+// index, and each output is stored once, rather than read, added to and stored again for every tap
+static inline void __not_in_flash_func(gather_output_taps)(reverb *v, uint16_t t, int32_t *outL, int32_t *outR, int n)
+{
+	const int16_t *b = v->slab;
+	for (int j = 0; j < n; j++)
+	{
+		outL[j] = tap_sum(b, v->outTap[0], t + j);
+		outR[j] = tap_sum(b, v->outTap[1], t + j);
+	}
+}
+
 // Get left channel reverb
 int32_t __not_in_flash_func(reverb_get_left)(reverb *v)
 {
-	int32_t a;
-	a = buffer_read(&v->preDampingDelay[1], TAP_OUT1, v->t);
-	a += buffer_read(&v->preDampingDelay[1], TAP_OUT2, v->t);
-	a -= buffer_read(&v->decayDiffusion2[1], TAP_OUT2, v->t);
-	a += buffer_read(&v->postDampingDelay[1], TAP_OUT2, v->t);
-	a -= buffer_read(&v->preDampingDelay[0], TAP_OUT3, v->t);
-	a -= buffer_read(&v->decayDiffusion2[0], TAP_OUT1, v->t);
-	a += buffer_read(&v->postDampingDelay[0], TAP_OUT1, v->t);
-	return a;
+	return tap_sum(v->slab, v->outTap[0], v->t);
 }
 
 // Get right channel reverb
 int32_t __not_in_flash_func(reverb_get_right)(reverb *v)
 {
-	int32_t a;
-	a = buffer_read(&v->preDampingDelay[0], TAP_OUT1, v->t);
-	a += buffer_read(&v->preDampingDelay[0], TAP_OUT2, v->t);
-	a -= buffer_read(&v->decayDiffusion2[0], TAP_OUT2, v->t);
-	a += buffer_read(&v->postDampingDelay[0], TAP_OUT2, v->t);
-	a -= buffer_read(&v->preDampingDelay[1], TAP_OUT3, v->t);
-	a -= buffer_read(&v->decayDiffusion2[1], TAP_OUT1, v->t);
-	a += buffer_read(&v->postDampingDelay[1], TAP_OUT1, v->t);
-	return a;
+	return tap_sum(v->slab, v->outTap[1], v->t);
+}
+
+// Get both channels of reverb
+void __not_in_flash_func(reverb_get_outputs)(reverb *v, int32_t *left, int32_t *right)
+{
+	gather_output_taps(v, v->t, left, right, 1);
+}
+
+
+////////////////////////////////////////
+// Block processing
+//
+// reverb_process_block gives the same output as reverb_process followed by reverb_get_left/right
+// for each sample, but runs each stage of the reverb over a chunk of samples at a time, so buffer
+// offsets, coefficients and filter states are loaded once per chunk rather than once per sample.
+// This works because no stage reads anything written less than a chunk earlier: the shortest delay
+// (inDiffusion[1], 107 samples) is longer than a chunk, and the cross feedback between the tank
+// halves is read before either half is written.
+// Chunks are at most REVERB_MOD_BLOCK samples, aligned with the modulation updates.
+
+// Read a tap for n samples
+static void __not_in_flash_func(buffer_read_block)(buffer *db, uint16_t tapId, uint16_t t, int32_t *out, int n)
+{
+	const int16_t *b = db->buffer;
+	uint16_t r = t + db->readOffset[tapId];
+	for (int j = 0; j < n; j++)
+		out[j] = b[(r + j) & REVERB_SLAB_MASK];
+}
+
+// Add (sign > 0) or subtract a tap into out[], for n samples
+static void __not_in_flash_func(buffer_tap_block)(buffer *db, uint16_t tapId, uint16_t t, int32_t *out, int n, int sign)
+{
+	const int16_t *b = db->buffer;
+	uint16_t r = t + db->readOffset[tapId];
+	if (sign > 0)
+		for (int j = 0; j < n; j++)
+			out[j] += b[(r + j) & REVERB_SLAB_MASK];
+	else
+		for (int j = 0; j < n; j++)
+			out[j] -= b[(r + j) & REVERB_SLAB_MASK];
+}
+
+// Write n samples into delay buffer
+static void __not_in_flash_func(buffer_write_block)(buffer *db, uint16_t t, const int32_t *x, int n)
+{
+	int16_t *b = db->buffer;
+	uint16_t w = t + db->writeOffset;
+	for (int j = 0; j < n; j++)
+		b[(w + j) & REVERB_SLAB_MASK] = sat16(x[j]);
+}
+
+// Delay n samples in place, as delay_process
+static void __not_in_flash_func(delay_process_block)(buffer *db, uint16_t t, int32_t *x, int n)
+{
+	int16_t *b = db->buffer;
+	uint16_t w = t + db->writeOffset, r = t + db->readOffset[TAP_MAIN];
+	for (int j = 0; j < n; j++)
+	{
+		b[(w + j) & REVERB_SLAB_MASK] = sat16(x[j]);
+		x[j] = b[(r + j) & REVERB_SLAB_MASK];
+	}
+}
+
+// Allpass filter n samples in place, as allpass_process
+static void __not_in_flash_func(allpass_process_block)(buffer *db, uint16_t t, int32_t gain, int32_t *x, int n)
+{
+	int16_t *b = db->buffer;
+	uint16_t w = t + db->writeOffset, r = t + db->readOffset[TAP_MAIN];
+	gain >>= 4;
+	for (int j = 0; j < n; j++)
+	{
+		int32_t delayed = b[(r + j) & REVERB_SLAB_MASK];
+		int32_t in = x[j] + ((delayed * -gain) >> 12);
+		b[(w + j) & REVERB_SLAB_MASK] = sat16(in);
+		x[j] = delayed + ((in * gain) >> 12);
+	}
+}
+
+// Fractional delay allpass filter n samples in place, as allpass_process_frac
+static void __not_in_flash_func(allpass_process_frac_block)(buffer *db, uint16_t t, int32_t gain, int32_t eta, int32_t *y, int32_t *x, int n)
+{
+	int16_t *b = db->buffer;
+	uint16_t w = t + db->writeOffset, r = t + db->readOffset[TAP_MAIN];
+	int32_t yi = *y;
+	gain >>= 4;
+	for (int j = 0; j < n; j++)
+	{
+		int32_t a = b[(r + j) & REVERB_SLAB_MASK];
+		int32_t c = b[(r + j - 1) & REVERB_SLAB_MASK];
+		yi = c + ((eta * (a - yi)) >> 15);
+		int32_t in = x[j] + ((yi * -gain) >> 12);
+		b[(w + j) & REVERB_SLAB_MASK] = sat16(in);
+		x[j] = yi + ((in * gain) >> 12);
+	}
+	*y = yi;
+}
+
+// Single-pole lowpass and highpass of x[] (as lowpass_process, highpass_process), both states updated,
+// keeping the lowpass (lpf) or highpass output, clamped
+static void __not_in_flash_func(tilt_filter_block)(int32_t *lpState, int32_t lpB, int32_t *hpState, int32_t hpB, uint8_t lpf, const int32_t *x, int32_t *out, int n)
+{
+	int32_t lp = *lpState, hp = *hpState;
+	if (lpf)
+		for (int j = 0; j < n; j++)
+		{
+			lp += (((x[j] - lp) * lpB) >> 16);
+			hp += (((x[j] - hp) * hpB) >> 16);
+			out[j] = clamp(lp, -16383, 16383);
+		}
+	else
+		for (int j = 0; j < n; j++)
+		{
+			lp += (((x[j] - lp) * lpB) >> 16);
+			hp += (((x[j] - hp) * hpB) >> 16);
+			out[j] = clamp(x[j] - hp, -16383, 16383);
+		}
+	*lpState = lp;
+	*hpState = hp;
+}
+
+// Pre-delay, pre-filter and input diffusion of one input channel (0 = mono/left, 1 = right),
+// over n samples from in[] to x[]. The echo has the pre-filter only, so as not to smear its repeats
+static void __not_in_flash_func(input_chain_block)(reverb *v, int ch, uint16_t t, const int32_t *in, int32_t *x, int n)
+{
+	buffer *diffusion = ch ? v->inDiffusionR : v->inDiffusion;
+
+	for (int j = 0; j < n; j++)
+		x[j] = clamp(in[j], -16384, 16383);
+
+	if (v->algorithm == REVERB_ECHO)
+	{
+		tilt_filter_block(&v->preFilterL[ch], v->preFilterLPF, &v->preFilterH[ch], v->preFilterHPF, v->lpf, x, x, n);
+		return;
+	}
+
+	delay_process_block(ch ? &v->preDelayR : &v->preDelay, t, x, n); // pre-delay
+	tilt_filter_block(&v->preFilterL[ch], v->preFilterLPF, &v->preFilterH[ch], v->preFilterHPF, v->lpf, x, x, n); // pre-filter
+
+	// Input diffusion
+	allpass_process_block(&diffusion[0], t, v->inputDiffusion1Amount, x, n);
+	allpass_process_block(&diffusion[1], t, v->inputDiffusion1Amount, x, n);
+	allpass_process_block(&diffusion[2], t, v->inputDiffusion2Amount, x, n);
+	allpass_process_block(&diffusion[3], t, v->inputDiffusion2Amount, x, n);
+}
+
+// ~23Hz HPF, to cancel any input DC offset, as highpass_process
+static void __not_in_flash_func(dc_block_block)(int32_t *state, const int32_t *x, int32_t *out, int n)
+{
+	int32_t hp = *state;
+	for (int j = 0; j < n; j++)
+	{
+		hp += (((x[j] - hp) * 200) >> 16);
+		out[j] = x[j] - hp;
+	}
+	*state = hp;
+}
+
+// Octave-up pitch shift of x[], mixed in by REVERB_SHIMMER_MIX: two read heads, half a grain apart, move
+// through the last REVERB_SHIMMER_GRAIN samples at twice speed (their delay shrinking by one sample per
+// sample), each faded in and out with a triangular window as it wraps
+static void __not_in_flash_func(shimmer_block)(reverb *v, int32_t *x, int n)
+{
+	const uint16_t grain = REVERB_SHIMMER_GRAIN, half = REVERB_SHIMMER_GRAIN / 2;
+	int16_t *b = v->shimmer.buffer;
+	uint16_t w = v->t + v->shimmer.writeOffset;
+	uint16_t d = v->shimmerPhase;
+
+	for (int j = 0; j < n; j++)
+	{
+		b[(w + j) & REVERB_SLAB_MASK] = sat16(x[j]);
+
+		uint16_t d2 = (d + half) & (grain - 1);
+		int32_t g = half - (d > half ? d - half : half - d); // 0 at the ends of the grain, half in the middle
+		int32_t shifted = (b[(uint16_t)(w + j - d) & REVERB_SLAB_MASK] * g
+			+ b[(uint16_t)(w + j - d2) & REVERB_SLAB_MASK] * (half - g)) / half;
+
+		x[j] += ((shifted - x[j]) * REVERB_SHIMMER_MIX) >> 15;
+		d = (d - 1) & (grain - 1);
+	}
+	v->shimmerPhase = d;
+}
+
+// Run both halves of the tank over n samples, from inputs x[0], x[1] (overwritten), then sum the
+// output taps into outL, outR and advance t
+static void __not_in_flash_func(tank_block)(reverb *v, int32_t x[2][REVERB_MOD_BLOCK], int32_t *outL, int32_t *outR, int n)
+{
+	int32_t f[REVERB_MOD_BLOCK];
+	int32_t fb[2][REVERB_MOD_BLOCK];
+	uint16_t t = v->t;
+
+	// Cross feedback for both halves of the tank, before either is written
+	buffer_read_block(&v->postDampingDelay[1], TAP_MAIN, t, fb[0], n);
+	buffer_read_block(&v->postDampingDelay[0], TAP_MAIN, t, fb[1], n);
+	if (v->algorithm == REVERB_SHIMMER)
+		shimmer_block(v, fb[0], n);
+
+	const int32_t decayAmount = v->decayAmount;
+	for (int i = 0; i < 2; i++)
+	{
+		int32_t *x1 = x[i];
+
+		// Add cross feedback
+		for (int j = 0; j < n; j++)
+			x1[j] = clamp(x1[j] + ((fb[i][j] * decayAmount) >> 16), -16383, 16383);
+
+		// Process single half of the tank
+		allpass_process_frac_block(&v->decayDiffusion1[i], t, -v->decayDiffusion1Amount, v->modEta[i], &v->modState[i], x1, n);
+		delay_process_block(&v->preDampingDelay[i], t, x1, n);
+
+		// Damping shelf, then attenuate
+		tilt_filter_block(&v->dampingL[i], v->dampingLPF, &v->dampingH[i], v->dampingHPF, v->lpf, x1, f, n);
+		for (int j = 0; j < n; j++)
+			x1[j] = (clamp((7 * x1[j] + f[j]) >> 3, -16383, 16383) * decayAmount) >> 16;
+
+		allpass_process_block(&v->decayDiffusion2[i], t, v->decayDiffusion2Amount, x1, n);
+		buffer_write_block(&v->postDampingDelay[i], t, x1, n);
+	}
+
+	// Output taps, as reverb_get_left/right after each sample
+	gather_output_taps(v, t + 1, outL, outR, n);
+
+	v->t = t + n;
+}
+
+// Run the room's four delays over n samples, fed by x[0] (the first two) and x[1] (the other two),
+// then sum them into outL, outR and advance t. Each delay's output is damped as in the plate, but an
+// eighth as much, for its eight times as many trips round the loop; the four are then mixed by a 4x4
+// Hadamard matrix (over 2, so lossless) and the decay applied. The decay is four times as far from 1
+// as the plate's, for a shorter tail to go with the shorter delays
+static void __not_in_flash_func(room_block)(reverb *v, int32_t x[2][REVERB_MOD_BLOCK], int32_t *outL, int32_t *outR, int n)
+{
+	int32_t d[4][REVERB_MOD_BLOCK];
+	uint16_t t = v->t;
+
+	const int32_t decay = clamp(65536 - 4 * (65536 - v->decayAmount), 0, 65536);
+	for (int i = 0; i < 4; i++)
+	{
+		buffer_read_block(&v->room[i], TAP_MAIN, t, d[i], n);
+
+		int32_t f[REVERB_MOD_BLOCK];
+		tilt_filter_block(&v->roomDampingL[i], v->dampingLPF, &v->roomDampingH[i], v->dampingHPF, v->lpf, d[i], f, n);
+		for (int j = 0; j < n; j++)
+			d[i][j] = (63 * d[i][j] + f[j]) >> 6;
+	}
+
+	for (int j = 0; j < n; j++)
+	{
+		int32_t a = d[0][j], b = d[1][j], c = d[2][j], e = d[3][j];
+		outL[j] = a + c;
+		outR[j] = b + e;
+
+		int32_t s0 = a + b, s1 = a - b, s2 = c + e, s3 = c - e;
+		d[0][j] = ((((s0 + s2) >> 1) * decay) >> 16) + x[0][j];
+		d[1][j] = ((((s1 + s3) >> 1) * decay) >> 16) + x[0][j];
+		d[2][j] = ((((s0 - s2) >> 1) * decay) >> 16) + x[1][j];
+		d[3][j] = ((((s1 - s3) >> 1) * decay) >> 16) + x[1][j];
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < n; j++)
+			d[i][j] = clamp(d[i][j], -16383, 16383);
+		buffer_write_block(&v->room[i], t, d[i], n);
+	}
+
+	v->t = t + n;
+}
+
+// Run the echo over n samples, fed by the mix of x[0] and x[1], with repeats at each quarter of
+// its length, alternating left and right; the longest tap is damped, and fed back by the decay
+static void __not_in_flash_func(echo_block)(reverb *v, int32_t x[2][REVERB_MOD_BLOCK], int32_t *outL, int32_t *outR, int n)
+{
+	int32_t fb[REVERB_MOD_BLOCK], f[REVERB_MOD_BLOCK];
+	uint16_t t = v->t;
+
+	buffer_read_block(&v->echo, TAP_MAIN, t, fb, n);
+	for (int j = 0; j < n; j++)
+		outL[j] = outR[j] = 0;
+	buffer_tap_block(&v->echo, TAP_OUT1, t, outL, n, 1);
+	buffer_tap_block(&v->echo, TAP_OUT3, t, outL, n, 1);
+	buffer_tap_block(&v->echo, TAP_OUT2, t, outR, n, 1);
+	for (int j = 0; j < n; j++)
+		outR[j] += fb[j];
+
+	tilt_filter_block(&v->dampingL[0], v->dampingLPF, &v->dampingH[0], v->dampingHPF, v->lpf, fb, f, n);
+	const int32_t decayAmount = v->decayAmount;
+	for (int j = 0; j < n; j++)
+	{
+		int32_t damped = (fb[j] + f[j]) >> 1;
+		fb[j] = clamp(((x[0][j] + x[1][j]) >> 1) + ((damped * decayAmount) >> 16), -16383, 16383);
+	}
+	buffer_write_block(&v->echo, t, fb, n);
+
+	v->t = t + n;
+}
+
+// ~15Hz HPF in place, with its state in Q16 so that, unlike dc_block_block, it leaves no DC of its own
+// (up to ~300 there, from the input filters' rounding, which the plate rejects but the room and echo,
+// with their lower loop losses at DC, would build up)
+static void __not_in_flash_func(dc_block_fine_block)(int32_t *state, int32_t *x, int n)
+{
+	int32_t hp = *state;
+	for (int j = 0; j < n; j++)
+	{
+		hp += ((x[j] << 16) - hp) >> 9;
+		x[j] -= hp >> 16;
+	}
+	*state = hp;
+}
+
+// The selected algorithm's part of the reverb, after the input stages
+static inline void __not_in_flash_func(tail_block)(reverb *v, int32_t x[2][REVERB_MOD_BLOCK], int32_t *outL, int32_t *outR, int n)
+{
+	if (v->algorithm == REVERB_PLATE || v->algorithm == REVERB_SHIMMER)
+	{
+		tank_block(v, x, outL, outR, n);
+		return;
+	}
+
+	dc_block_fine_block(&v->tailHPF[0], x[0], n);
+	dc_block_fine_block(&v->tailHPF[1], x[1], n);
+	if (v->algorithm == REVERB_ROOM)
+		room_block(v, x, outL, outR, n);
+	else
+		echo_block(v, x, outL, outR, n);
+}
+
+// Silence the input stages: the pre-delays, input diffusers (the first inputSlabUsed samples of the
+// slab, counting back from t) and their filters, as if they had only ever been fed silence. While they
+// aren't run, the slab moves on under them, and their regions fill with the tank's old samples
+static void __not_in_flash_func(input_chain_clear)(reverb *v)
+{
+	for (uint32_t k = 0; k < v->inputSlabUsed; k++)
+		v->slab[(uint16_t)(v->t - k) & REVERB_SLAB_MASK] = 0;
+
+	v->preFilterH[0] = v->preFilterH[1] = 0;
+	v->preFilterL[0] = v->preFilterL[1] = 0;
+	v->acCouplingHPF = v->acCouplingHPFR = 0;
+}
+
+// Process one chunk of n <= REVERB_MOD_BLOCK samples, not crossing a modulation update.
+// inR is NULL for mono input.
+static void __not_in_flash_func(reverb_process_chunk)(reverb *v, const int32_t *in, const int32_t *inR, int32_t *outL, int32_t *outR, int n)
+{
+	int32_t x[REVERB_MOD_BLOCK];
+	int32_t half[2][REVERB_MOD_BLOCK];
+	uint16_t t = v->t;
+
+	if ((t & (REVERB_MOD_BLOCK - 1)) == 0)
+		update_modulation(v);
+
+	if (v->frozenFor >= v->inputSlabUsed)
+	{
+		if (v->frozen)
+		{
+			// Frozen, with the input stages flushed: only the tank runs, fed silence
+			for (int j = 0; j < n; j++)
+				half[0][j] = half[1][j] = 0;
+			tail_block(v, half, outL, outR, n);
+			return;
+		}
+		input_chain_clear(v);
+		v->frozenFor = 0;
+	}
+
+	if (!inR)
+	{
+		// Mono: both halves of the tank are fed the same signal, DC blocked for the first half only
+		input_chain_block(v, 0, t, in, x, n);
+		dc_block_block(&v->acCouplingHPF, x, half[0], n);
+		for (int j = 0; j < n; j++)
+			half[1][j] = x[j];
+	}
+	else
+	{
+		// Stereo: each half is fed its own channel, mixed with stereoCross of the other one
+		input_chain_block(v, 0, t, in, x, n);
+		dc_block_block(&v->acCouplingHPF, x, half[0], n);
+		input_chain_block(v, 1, t, inR, x, n);
+		dc_block_block(&v->acCouplingHPFR, x, half[1], n);
+
+		const int32_t c = v->stereoCross, d = 32768 - c;
+		for (int j = 0; j < n; j++)
+		{
+			int32_t l = half[0][j], r = half[1][j];
+			half[0][j] = (l * d + r * c) >> 15;
+			half[1][j] = (r * d + l * c) >> 15;
+		}
+	}
+
+	// Frozen for as long as the input stages take to flush? Then the next chunk skips them
+	v->frozenFor = v->frozen ? v->frozenFor + n : 0;
+
+	tail_block(v, half, outL, outR, n);
+}
+
+// Process n samples of mono, or stereo (inR not NULL) audio, giving n samples of left and right reverb
+static void __not_in_flash_func(reverb_process_blocks)(reverb *v, const int32_t *in, const int32_t *inR, int32_t *outL, int32_t *outR, int n)
+{
+	while (n > 0)
+	{
+		int m = REVERB_MOD_BLOCK - (v->t & (REVERB_MOD_BLOCK - 1));
+		if (m > n)
+			m = n;
+		reverb_process_chunk(v, in, inR, outL, outR, m);
+		in += m;
+		if (inR)
+			inR += m;
+		outL += m;
+		outR += m;
+		n -= m;
+	}
+}
+
+// Process n samples of mono audio, giving n samples of left and right reverb
+void __not_in_flash_func(reverb_process_block)(reverb *v, const int32_t *in, int32_t *outL, int32_t *outR, int n)
+{
+	reverb_process_blocks(v, in, NULL, outL, outR, n);
+}
+
+// Process n samples of stereo audio, giving n samples of left and right reverb
+void __not_in_flash_func(reverb_process_block_stereo)(reverb *v, const int32_t *inL, const int32_t *inR, int32_t *outL, int32_t *outR, int n)
+{
+	reverb_process_blocks(v, inL, inR, outL, outR, n);
 }
@@ -8,31 +8,75 @@ struct sreverb;
 
 int32_t __not_in_flash_func(clamp)(int32_t x, int32_t min, int32_t max);
 
-// Get pointer to initialized reverb struct 
+// Get pointer to initialized reverb struct (the one instance, in static memory), or NULL if in use
 struct sreverb *reverb_create(void);
 
 // Silence reverb by zeroing state 
 void reverb_reset(struct sreverb *v);
 
-// Free resources and delete reverb instance 
+// Release the reverb instance, for reverb_create to return again
 void reverb_delete(struct sreverb *v);
 
+// Reverb algorithms, all sharing the input stages and the one slab of delay memory
+enum
+{
+	REVERB_PLATE = 0, // Dattorro plate, the default
+	REVERB_ROOM,      // small room, a four-line feedback delay network
+	REVERB_SHIMMER,   // the plate, with an octave-up pitch shifter in its feedback
+	REVERB_ECHO,      // multi-tap echo, with no pre-delay or input diffusion
+	REVERB_NUM_ALGORITHMS
+};
+
+// Switch algorithm, re-partitioning the slab (no allocation) and silencing the reverb; settings are kept.
+// Returns 0, and selects the plate, if the algorithm is unknown
+int reverb_set_algorithm(struct sreverb *v, int algorithm);
+
+// Cycles per sample that reverb_process_block(_stereo) must stay within for each algorithm, on an
+// RP2040 from SRAM (of 4166 at the card's 200MHz); the kernel_benchmark example in
+// Demonstrations+HelloWorlds/PicoSDK/ComputerCard measures them against these
+#define REVERB_BUDGET_PLATE 600
+#define REVERB_BUDGET_ROOM 350
+#define REVERB_BUDGET_SHIMMER 700
+#define REVERB_BUDGET_ECHO 150
+extern const uint16_t reverb_cycle_budget[REVERB_NUM_ALGORITHMS];
+
 // Set reverb parameters 
 void __not_in_flash_func(reverb_setPreDelay)(struct sreverb *v, int16_t value);
 void __not_in_flash_func(reverb_setDecayDiffusion)(struct sreverb *v, int32_t value);
 void __not_in_flash_func(reverb_set_size)(struct sreverb *v, int32_t size);
+// mult is 256 for the decay set by size, down to 0 for frozen (infinite decay). While it is 0 the caller
+// must mute the input: once the input stages have flushed (~0.1s), reverb_process_block(_stereo)
+// skips them and runs only the tank
 void __not_in_flash_func(reverb_set_freeze_size)(struct sreverb *v, int32_t size, int32_t mult);
 void __not_in_flash_func(reverb_set_tilt)(struct sreverb *v, int32_t value);
+// Set decay diffuser modulation rate (phase increment per sample) and depth (samples, Q16)
+void reverb_set_modulation(struct sreverb *v, uint32_t rate, int32_t depth);
+// Set how much of each stereo input goes into the opposite half of the tank, 0 to 32768 (0.5, mono)
+void reverb_set_stereo_cross(struct sreverb *v, int32_t value);
 
-// Send mono input into reverbation tank 
+// Send mono input into reverbation tank (the plate only, as are reverb_get_left/right)
 void __not_in_flash_func(reverb_process)(struct sreverb *v, int32_t in);
 
+// Send n samples of mono input into reverbation tank, writing n samples of left and right output;
+// the same as reverb_process then reverb_get_left/right for each sample, but faster
+void __not_in_flash_func(reverb_process_block)(struct sreverb *v, const int32_t *in, int32_t *outL, int32_t *outR, int n);
+
+// As reverb_process_block, with stereo input: left and right have their own pre-delay, pre-filter and
+// input diffusers, and each feeds one half of the tank, mixed with some of the other (reverb_set_stereo_cross)
+void __not_in_flash_func(reverb_process_block_stereo)(struct sreverb *v, const int32_t *inL, const int32_t *inR, int32_t *outL, int32_t *outR, int n);
+
 // Get reverbated signal for left channel 
 int32_t __not_in_flash_func(reverb_get_left)(struct sreverb *v);
 
 // Get reverbated signal for right channel 
 int32_t __not_in_flash_func(reverb_get_right)(struct sreverb *v);
 
+// Get both channels at once, sharing their tap reads' index calculation
+void __not_in_flash_func(reverb_get_outputs)(struct sreverb *v, int32_t *left, int32_t *right);
+
+// Bytes of delay memory used by the tank (out of REVERB_SLAB_SIZE * 2 reserved)
+uint32_t reverb_memory_used(struct sreverb *v);
+
 enum
 {
 	TAP_MAIN = 0,
@@ -42,11 +86,37 @@ enum
 	MAX_TAPS
 };
 
+// All delays and allpass filters share one circular slab of int16 samples, indexed by the common
+// sample counter t. Each buffer owns a region of exactly its length at a fixed offset, and since every
+// buffer advances by one sample per sample, the regions never overlap: reads and writes are just
+// (t + offset) & REVERB_SLAB_MASK, as with separate power-of-two buffers, without their rounding up.
+#define REVERB_SLAB_BITS 15
+#define REVERB_SLAB_SIZE (1 << REVERB_SLAB_BITS) // samples
+#define REVERB_SLAB_MASK (REVERB_SLAB_SIZE - 1)
+
+// Decay diffuser modulation: the lengths are recalculated every REVERB_MOD_BLOCK samples,
+// with sub-sample (interpolated) resolution, by up to REVERB_MOD_MAX_DEPTH samples
+#define REVERB_MOD_BLOCK 16
+#define REVERB_MOD_MAX_DEPTH 32
+#define REVERB_MOD_RATE_HZ(hz) ((uint32_t)((hz) * 4294967296.0 / 48000.0)) // for constants only
+
+// Shimmer pitch shifter grain, in samples (a power of two), and how much of the plate's cross feedback
+// it replaces, Q15
+#define REVERB_SHIMMER_GRAIN 1024
+#define REVERB_SHIMMER_MIX 16384
+
+// Longest echo, in samples: what's left of the slab after the input stages
+#define REVERB_ECHO_MAX_DELAY 22528
+
+// Output taps summed for each channel of the plate
+#define REVERB_OUT_TAPS 7
+
 // buffer, for delays and allpass filters
 typedef struct sbuffer
 {
-	int32_t *buffer;
-	uint16_t mask; // Mask for fast array index wrapping in read / write
+	int16_t *buffer; // the reverb's slab
+	uint16_t writeOffset; // start of this buffer's region in the slab
+	uint16_t length; // region length in samples: longest delay + 1
 	uint16_t readOffset[MAX_TAPS]; // read offsets
 } buffer;
 
@@ -54,12 +124,15 @@ typedef struct sbuffer
 typedef struct sreverb
 {
 	buffer preDelay;
+	buffer preDelayR; // stereo input only
 	int32_t preFilterH[2];
 	int32_t preFilterL[2];
 	int32_t acCouplingHPF;
+	int32_t acCouplingHPFR;
 
 	// input diffusors
 	buffer inDiffusion[4]; // APF
+	buffer inDiffusionR[4]; // APF, right input (stereo input only)
 
 	// Reverbation tank left / right halves
 	buffer decayDiffusion1[2]; // APF
@@ -68,6 +141,17 @@ typedef struct sreverb
 	int32_t dampingL[2]; // LPF
 	buffer decayDiffusion2[2]; // APF
 	buffer postDampingDelay[2]; // Delay
+	uint16_t outTap[2][REVERB_OUT_TAPS]; // slab offsets of the left and right output taps
+
+	// Other algorithms' buffers, laid out by reverb_set_algorithm in place of the tank's
+	buffer room[4]; // Delay
+	int32_t roomDampingH[4]; // HPF
+	int32_t roomDampingL[4]; // LPF
+	buffer shimmer; // pitch shifter, plus the tank
+	uint16_t shimmerPhase; // delay of the shimmer's first read head
+	buffer echo; // Delay, with a tap each quarter
+	int32_t tailHPF[2]; // room and echo input DC blockers, Q16
+	uint8_t algorithm; // REVERB_PLATE etc.
 
 	// -- Reverb settings --
 	int32_t preFilterLPF;
@@ -83,12 +167,22 @@ typedef struct sreverb
 	int32_t decayDiffusion2Amount; // Automatically set in reverb_setDecay
 
 	uint8_t lpf; // boolean
-	uint16_t modulate; // mask
-	int modulatedist;
+	uint8_t frozen; // boolean, set by reverb_set_freeze_size with mult 0
+	uint16_t frozenFor; // samples processed while frozen; the input stages are skipped from inputSlabUsed
+	uint16_t inputSlabUsed; // slab samples used by the pre-delays and input diffusers
+	int32_t stereoCross; // Q15, 0 to 16384
+	uint32_t modRate;  // LFO phase increment per sample
+	int32_t modDepth;  // samples, Q16
+	uint32_t modPhase; // LFO phase, 2^32 = one cycle
+	int32_t modEta[2];   // decay diffusers' allpass interpolator coefficients, Q15
+	int32_t modState[2]; // and their previous outputs
 
-	int32_t tapModVal, tapDir;
 	// Cycle count
 	uint16_t t;
+
+	// Delay memory, carved into buffers by reverb_create
+	uint16_t slabUsed; // samples allocated so far
+	int16_t slab[REVERB_SLAB_SIZE];
 } reverb;
 
 #endif
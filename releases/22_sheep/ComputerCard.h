@@ -9,7 +9,8 @@ System Computer.
 
 It aims to present a very simple C++ interface for card programmers 
 to use the jacks, knobs, switch and LEDs, for programs running at
-a fixed 24kHz audio sample rate.
+a fixed 24kHz audio sample rate (or 48kHz, if COMPUTERCARD_SAMPLE_RATE
+is defined as 48000 by the build).
 
 See examples/ directory
 */
@@ -21,6 +22,11 @@ See examples/ directory
 #include "hardware/gpio.h"
 #include "hardware/pwm.h"
 
+// Audio sample rate, 24000 or 48000
+#ifndef COMPUTERCARD_SAMPLE_RATE
+#define COMPUTERCARD_SAMPLE_RATE 24000
+#endif
+
 #define PULSE_1_RAW_OUT 8
 #define PULSE_2_RAW_OUT 9
 
@@ -63,8 +69,13 @@ public:
 	/// Use before Run() to enable Connected/Disconnected detection
 	void EnableNormalisationProbe() {useNormProbe = true;}
 
+	/// Use before Run() to remove the mux's switching pattern from the audio inputs:
+	/// their average at each of the four mux states, relative to the average of all four,
+	/// is tracked (with a time constant of 2^shift mux cycles) and subtracted
+	void EnableMuxCorrection(int shift = 8) {muxCorrectionShift = shift; useMuxCorrection = true;}
+
 protected:
-	/// Callback, called once per sample at 24kHz
+	/// Callback, called once per sample at COMPUTERCARD_SAMPLE_RATE (24kHz by default)
 	virtual void ProcessSample() = 0;
 
 
@@ -290,6 +301,12 @@ private:
 	volatile bool connected[6] = {0,0,0,0,0,0};
 	bool useNormProbe;
 
+	// Audio input average at each mux state (Q12), and their sum, for R and L
+	bool useMuxCorrection;
+	int muxCorrectionShift;
+	int32_t muxOffset[2][4];
+	int32_t muxOffsetSum[2];
+
 	Switch switchVal, lastSwitchVal;
 	
 	volatile uint8_t runADCMode;
@@ -417,7 +434,8 @@ void __not_in_flash_func(ComputerCard::AudioWorker)()
 	// ADC clock runs at 48MHz
 	// 48MHz ÷ (249+1) = 192kHz ADC sample rate
 	//                 = 8×24kHz audio sample rate
-	adc_set_clkdiv(249);
+	// (or ÷ (124+1) = 8×48kHz)
+	adc_set_clkdiv(48000000 / (8 * COMPUTERCARD_SAMPLE_RATE) - 1);
 
 	// claim and setup DMAs for reading to ADC, and writing to SPI DAC
 	adc_dma = dma_claim_unused_channel(true);
@@ -539,6 +557,21 @@ void __not_in_flash_func(ComputerCard::BufferFull)()
 
 	adcInL = -(((ADC_Buffer[cpuPhase][1] + ADC_Buffer[cpuPhase][5]) - 0x1000) >> 1);
 
+	// Subtract the mux's share of this frame, for the mux state it was sampled in
+	if (useMuxCorrection)
+	{
+		for (int ch=0; ch<2; ch++)
+		{
+			int32_t x = ch ? adcInL : adcInR;
+			int32_t d = ((x << 12) - muxOffset[ch][mux_state]) >> muxCorrectionShift;
+			muxOffset[ch][mux_state] += d;
+			muxOffsetSum[ch] += d;
+			x -= (muxOffset[ch][mux_state] - (muxOffsetSum[ch] >> 2)) >> 12;
+			if (ch) adcInL = x;
+			else adcInR = x;
+		}
+	}
+
 	// Set pulse inputs
 	last_pulse[0] = pulse[0];
 	last_pulse[1] = pulse[1];
@@ -687,6 +720,10 @@ ComputerCard::ComputerCard()
 
 
 	useNormProbe = false;
+	useMuxCorrection = false;
+	muxCorrectionShift = 8;
+	for (int i=0; i<4; i++) muxOffset[0][i] = muxOffset[1][i] = 0;
+	muxOffsetSum[0] = muxOffsetSum[1] = 0;
 	for (int i=0; i<6; i++)
 	{
 		connected[i] = false;
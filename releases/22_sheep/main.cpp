@@ -1,6 +1,19 @@
 #include "ComputerCard.h"
+#include "hardware/interp.h"
 #include <cmath>
 
+#ifdef PSRAM_MODE
+	#include "psram.h"
+	#include <cstring>
+#endif
+
+#ifdef DUAL_CORE
+	#include "pico/multicore.h"
+	#define NUM_GRAIN_POOLS 2 // core0 and core1 each render a pool of MAX_GRAINS
+#else
+	#define NUM_GRAIN_POOLS 1
+#endif
+
 #ifndef M_PI
 	#define M_PI 3.14159265358979323846
 #endif
@@ -10,13 +23,21 @@
  * by Dune Desormeaux (github.com/dessertplanet)
  * Thank you to Émilie Gillet for Clouds which was a huge inspiration here!
  * Sheep features:
- * - 2 UF2's to choose from based on fidelity + buffer length:
+ * - 3 UF2's to choose from based on fidelity + buffer length:
  * - Lofi: 5.2-second stereo circular buffer for audio capture (125k 8-bit samples at 24kHz)
  * - Hifi: 2.6-second stereo circular buffer for audio capture (62.5k 12-bit samples at 24kHz)
- * - Up to 14 simultaneous grains
+ * - Mulaw: 5.2-second stereo circular buffer for audio capture (125k 8-bit mu-law samples at 24kHz,
+ *   close to 12-bit quality at the memory cost of Lofi)
+ * - A fourth, PSRAM build for RP2350 boards with external PSRAM (SHEEP_PSRAM in CMake):
+ *   10.7-second stereo circular buffer (512k 16-bit samples at the full 48kHz)
+ * - Up to 32 simultaneous grains, or 64 in the dual-core build (half rendered on each core)
  * - Linear grain sizes from micro (32 samples = ~0.001 seconds) to macro (24000 samples = 1 second)
  * - Bidirectional playback (-2x to +2x speed)
  * - Loop/glitch mode for captured segment looping
+ * - Unclocked, each grain starts the next at its Y knob threshold, or with SHEEP_STOCHASTIC_ONSETS,
+ *   grains start at random (Poisson) times at the same average density
+ * - With SHEEP_GRAIN_PAN, each grain is panned at random across the stereo field, up to as far
+ *   as the X knob spreads grain positions
  *
  * Controls:
  * - Main Knob: Grain playback speed/direction (-2x to +2x, center=pause) OR pitch attenuverter when CV2 connected
@@ -42,40 +63,69 @@
  */
 
 // Audio format configuration - controlled by build system
-#ifdef LOFI_MODE
+#ifdef PSRAM_MODE
+	#define BUFF_LENGTH_SAMPLES 512000 // 512,000 samples = 10.7 seconds at 48kHz (16-bit audio, in PSRAM)
+#elif defined(LOFI_MODE)
 	#define BUFF_LENGTH_SAMPLES 125000 // 125,000 samples = 5.2 seconds at 24kHz (8-bit audio)
+#elif defined(MULAW_MODE)
+	#define BUFF_LENGTH_SAMPLES 125000 // 125,000 samples = 5.2 seconds at 24kHz (8-bit mu-law audio)
 #else
 	#define BUFF_LENGTH_SAMPLES 62500  // 62,500 samples = 2.6 seconds at 24kHz (12-bit audio)
 #endif
 
+#ifndef SHEEP_STOCHASTIC_ONSETS
+	#define SHEEP_STOCHASTIC_ONSETS 0 // 1: unclocked grains start at random (Poisson) times, see scheduleOnset
+#endif
+
+#ifndef SHEEP_GRAIN_PAN
+	#define SHEEP_GRAIN_PAN 0 // 1: each grain is panned at random, as widely as the X knob spreads positions
+#endif
+
+// Grain window shape - controlled by build system: 0 = Hann, 1 = Tukey, 2 = trapezoid
+#ifndef SHEEP_WINDOW_SHAPE
+	#define SHEEP_WINDOW_SHAPE 0
+#endif
+
 // Always use full 12-bit audio range for processing (±2048) to maintain consistent volume
 // The pack/unpack functions handle the storage bit depth conversion
 #define AUDIO_RANGE 2048
 
-#define MAX_GRAIN_SIZE 24000	   // 24,000 samples (1.0 seconds at 24kHz) - maximum grain size
-#define MIN_GRAIN_SIZE 32		   // 32 samples (1.33ms at 24kHz) - minimum grain size
+// Times in samples are given at 24kHz, and scaled by RATE_SCALE for the 48kHz PSRAM build
+#define RATE_SCALE (COMPUTERCARD_SAMPLE_RATE / 24000)
+
+#define MAX_GRAIN_SIZE (24000 * RATE_SCALE) // 24,000 samples (1.0 seconds at 24kHz) - maximum grain size
+#define MIN_GRAIN_SIZE (32 * RATE_SCALE)	// 32 samples (1.33ms at 24kHz) - minimum grain size
 
 class Sheep : public ComputerCard
 {
 private:
-	// 256-entry Hann window lookup table (Q12 format) - calculated at startup
-	static constexpr int HANN_TABLE_SIZE = 256;
-	int32_t hannWindowTable_[HANN_TABLE_SIZE];
+	// Grain window lookup tables (Q12 format), shared by all grains - calculated at startup
+	// A grain's window phase runs over the full 32 bits: the top 8 bits index the table and the
+	// next 8 interpolate, and the guard point at WINDOW_TABLE_SIZE saves a bounds check.
+	enum WindowShape
+	{
+		WINDOW_HANN,	  // Raised cosine
+		WINDOW_TUKEY,	  // Raised cosine fades over the first and last quarter, flat between
+		WINDOW_TRAPEZOID, // Linear fades over the first and last quarter, flat between
+		NUM_WINDOW_SHAPES
+	};
+	static constexpr int WINDOW_TABLE_SIZE = 256;
+	int32_t windowTables_[NUM_WINDOW_SHAPES][WINDOW_TABLE_SIZE + 1];
+	WindowShape windowShape_; // Window given to new grains
 	
 	// Timing constants
-	static const int32_t SAFETY_MARGIN_SAMPLES = 120;	 // 5ms safety margin
-	static const int32_t GRAIN_END_PULSE_DURATION = 100; // 4.2ms pulse duration
+	static const int32_t SAFETY_MARGIN_SAMPLES = 120 * RATE_SCALE;	   // 5ms safety margin
+	static const int32_t GRAIN_END_PULSE_DURATION = 100 * RATE_SCALE; // 4.2ms pulse duration
 	static const int32_t VIRTUAL_DETENT_THRESHOLD = 12;
 
 	// Safety limits
-	static const int32_t MAX_FRACTIONAL_ITERATIONS = 4;
-	static const int32_t MAX_SAFE_GRAIN_SPEED = 8192;
+	static const int32_t MAX_SAFE_GRAIN_SPEED = 8192; // under one buffer wrap per sample, so positions wrap with one compare
 
 	// Speed hysteresis to prevent scratchiness from knob noise
 	static const int32_t SPEED_HYSTERESIS_THRESHOLD = 32;
 
 	// Grain system constants
-	static const int MAX_GRAINS = 14;							  // Maximum number of simultaneous grains
+	static const int MAX_GRAINS = 32;							  // Maximum number of simultaneous grains per core
 	static const int32_t GRAIN_COMPLETION_THRESHOLD_PERCENT = 90; // used for pulse 1 output when clocked
 
 public:
@@ -83,22 +133,20 @@ public:
 	{
 		for (int i = 0; i < BUFF_LENGTH_SAMPLES; i++)
 		{
-			buffer_[i] = 0;
+			buffer_[i] = packStereo(0, 0); // a zero word is full scale in the mu-law and 12-bit formats, not silence
 		}
 
 		stretchRatio_ = 4096;
 		grainPlaybackSpeed_ = 4096;
 		previousGrainPlaybackSpeed_ = 4096; // Initialize to 1x speed for hysteresis
-		previousLoopingControlValue_ = 4096; // Initialize to 1x speed for looping hysteresis
-		grainSize_ = 1024;
-		maxActiveGrains_ = MAX_GRAINS; // Maximum number of active grains
-		cachedActiveGrainCount_ = 0;   // Initialize grain count cache
+		grainSize_ = 1024 * RATE_SCALE;
+		maxActiveGrains_ = MAX_GRAINS * NUM_GRAIN_POOLS; // Maximum number of active grains
 		loopMode_ = false;
 
 		pulseOut1Counter_ = 0;
 		pulseOut2Counter_ = 0;
 		stochasticClockCounter_ = 0;
-		stochasticClockPeriod_ = 2400;
+		stochasticClockPeriod_ = 2400 * RATE_SCALE;
 
 		cvOut1NoiseValue_ = 0;
 		cvOut2PhaseValue_ = 0;
@@ -110,64 +158,134 @@ public:
 
 		// Initialize grain timing variables
 		globalSampleCounter_ = 0;
-		minGrainDistance_ = 0;
-		lastGrainTriggerTime_ = 0;
-
-		// Initialize 12kHz notch filter state variables
-		mix1L_ = mix2L_ = mixf1L_ = mixf2L_ = 0;
-		mix1R_ = mix2R_ = mixf1R_ = mixf2R_ = 0;
-
+		nextOnset_ = 0;
+		onsetPending_ = false;
 
-		for (int i = 0; i < MAX_GRAINS; i++)
+		for (int p = 0; p < NUM_GRAIN_POOLS; p++)
 		{
-			grains_[i].active = false;
-			grains_[i].readPos = 0;
-			grains_[i].readFrac = 0;
-			grains_[i].sampleCount = 0;
-			grains_[i].startPos = 0;
-			grains_[i].loopSize = 0;
-			grains_[i].looping = false;
-			grains_[i].pulse90Triggered = false;
-			grains_[i].grainSpeed = 4096; // Initialize to 1x speed (Q12 format)
-			grains_[i].baselineControlValue = 4096; // Initialize baseline control value
+			GrainPool &pool = pools_[p];
+			pool.numActive = 0;
+			pool.previousLoopingControlValue = 4096; // Initialize to 1x speed for looping hysteresis
+			pool.loopMode = false;
+			for (int i = 0; i < MAX_GRAINS; i++)
+			{
+				pool.order[i] = i; // All slots free
+				pool.pos[i] = 0;
+				pool.speed[i] = 4096; // Initialize to 1x speed (Q12 format)
+				pool.count[i] = 0;
+				pool.window[i] = 0;
+				pool.windowInc[i] = 0;
+				pool.windowTable[i] = windowTables_[WINDOW_HANN];
+				pool.params[i].startPos = 0;
+				pool.params[i].grainSize = MIN_GRAIN_SIZE;
+				pool.params[i].completionCount = MIN_GRAIN_SIZE;
+				pool.params[i].baselineControlValue = 4096; // Initialize baseline control value
+				pool.params[i].looping = false;
+				pool.params[i].pulse90Triggered = false;
+				pool.panGain[0][i] = 4096;
+				pool.panGain[1][i] = 4096;
+				selectKernels(pool, i);
+#ifdef PSRAM_MODE
+				pool.cache[i].tag[0] = -1;
+				pool.cache[i].tag[1] = -1;
+#endif
+			}
 		}
+		loopBaseline_ = 4096;
+
+#ifdef MULAW_MODE
+		initMulaw();
+#endif
 
-		// Calculate Hann window lookup table at startup
-		// Formula: 0.5 * (1 - cos(2 * pi * n / (N-1))) * 4096 (Q12 format)
+		// Calculate window lookup tables at startup
 		// Using M_PI for maximum accuracy to eliminate grain boundary artifacts
-		for (int i = 0; i < HANN_TABLE_SIZE; i++)
+		for (int i = 0; i <= WINDOW_TABLE_SIZE; i++)
 		{
 			// Calculate normalized position (0.0 to 1.0)
-			double pos = (double)i / (HANN_TABLE_SIZE - 1);
+			double pos = (double)i / WINDOW_TABLE_SIZE;
 
-			// Calculate 2*pi*pos angle
-			double angle = 2.0 * M_PI * pos;
+			// Distance into the fade-in or fade-out for Tukey and trapezoid, 0 to 1 over a quarter
+			double edge = ((pos < 0.5) ? pos : 1.0 - pos) * 4.0;
+			if (edge > 1.0)
+				edge = 1.0;
 
-			// Calculate cosine using standard library for maximum accuracy
-			double cos_val = cos(angle);
+			// Apply window formulas: Hann 0.5 * (1 - cos(2*pi*pos)); Tukey is a Hann fade over each edge
+			double shapes[NUM_WINDOW_SHAPES];
+			shapes[WINDOW_HANN] = 0.5 * (1.0 - cos(2.0 * M_PI * pos));
+			shapes[WINDOW_TUKEY] = 0.5 * (1.0 - cos(M_PI * edge));
+			shapes[WINDOW_TRAPEZOID] = edge;
 
-			// Apply Hann window formula: 0.5 * (1 - cos(2*pi*n/(N-1)))
-			double hann_double = 0.5 * (1.0 - cos_val);
+			for (int shape = 0; shape < NUM_WINDOW_SHAPES; shape++)
+			{
+				// Convert to Q12 format (multiply by 4096)
+				int32_t val = (int32_t)(shapes[shape] * 4096.0 + 0.5); // +0.5 for rounding
 
-			// Convert to Q12 format (multiply by 4096)
-			int32_t hann_val = (int32_t)(hann_double * 4096.0 + 0.5); // +0.5 for rounding
+				// Ensure perfect fade-in/fade-out at boundaries to eliminate clicks
+				if (i == 0 || i == WINDOW_TABLE_SIZE)
+				{
+					val = 0; // Force zero at start and end
+				}
 
-			// Ensure perfect fade-in/fade-out at boundaries to eliminate clicks
-			if (i == 0 || i == HANN_TABLE_SIZE - 1)
-			{
-				hann_val = 0; // Force zero at start and end
-			}
+				// Clamp to valid range
+				if (val < 0)
+					val = 0;
+				if (val > 4096)
+					val = 4096;
 
-			// Clamp to valid range
-			if (hann_val < 0)
-				hann_val = 0;
-			if (hann_val > 4096)
-				hann_val = 4096;
+				windowTables_[shape][i] = val;
+			}
+		}
+		windowShape_ = (WindowShape)SHEEP_WINDOW_SHAPE;
 
-			hannWindowTable_[i] = hann_val;
+#if SHEEP_STOCHASTIC_ONSETS
+		// -ln(u) for u evenly spread over (0, 1): a random entry is an exponentially distributed
+		// interval with a mean of one
+		for (int i = 0; i < ONSET_TABLE_SIZE; i++)
+		{
+			onsetTable_[i] = (uint16_t)(-log((i + 0.5) / ONSET_TABLE_SIZE) * 4096.0 + 0.5);
 		}
+#endif
+
+		// Window lookups use this core's interpolators
+		configureWindowInterp();
+
+#ifdef DUAL_CORE
+		// Start rendering the second grain pool. ThisPtr() is only set by Run(), so core1
+		// finds the card through its own pointer
+		core1Card_ = this;
+		multicore_launch_core1(core1);
+#endif
+	}
+
+#ifdef DUAL_CORE
+	// Boilerplate to call member function as second core
+	static void core1()
+	{
+		core1Card_->Core1GrainLoop();
+	}
+	static Sheep *core1Card_;
+
+	// Code for second RP2040 core, blocking: render each block of pool 1 as it is requested
+	void __not_in_flash_func(Core1GrainLoop)()
+	{
+		// Each core has its own interpolators
+		configureWindowInterp();
 
+		while (1)
+		{
+			uint32_t block = core1Requested_;
+			if (block == core1Rendered_)
+			{
+				tight_loop_contents();
+				continue;
+			}
+			__dmb(); // Read the request only after seeing its block number
+			renderCore1Block(block);
+			__dmb(); // Finish the block before publishing it
+			core1Rendered_ = block;
+		}
 	}
+#endif
 
 	virtual void ProcessSample()
 	{
@@ -179,30 +297,12 @@ public:
 		// Record audio when not in freeze mode (freeze mode stops recording but allows playback)
 		if (switchPos != Switch::Up)
 		{
-			// Clip inputs to prevent overflow
+			// Clip inputs to prevent overflow. Mux interference has already been removed from
+			// them (EnableMuxCorrection), so they need no notch filter
 			int16_t leftIn = clipAudio(AudioIn1());
 			int16_t rightIn = clipAudio(AudioIn2());
 
-			// Apply 12kHz notch filter to remove mux interference
-			int32_t ooa0 = 16302, a2oa0 = 16221; // Q = 100, very narrow notch
-			
-			// Filter left channel
-			int32_t leftFiltered = (ooa0 * (leftIn + mix2L_) - a2oa0 * mixf2L_) >> 14;
-			mix2L_ = mix1L_;
-			mix1L_ = leftIn;
-			mixf2L_ = mixf1L_;
-			mixf1L_ = leftFiltered;
-			
-			// Filter right channel
-			int32_t rightFiltered = (ooa0 * (rightIn + mix2R_) - a2oa0 * mixf2R_) >> 14;
-			mix2R_ = mix1R_;
-			mix1R_ = rightIn;
-			mixf2R_ = mixf1R_;
-			mixf1R_ = rightFiltered;
-
-			// Clip filtered outputs and pack into buffer
-			leftIn = clipAudio(leftFiltered);
-			rightIn = clipAudio(rightFiltered);
+			// Pack into buffer
 			auto stereoSample = packStereo(leftIn, rightIn);
 			buffer_[writeHead_] = stereoSample;
 		}
@@ -214,6 +314,16 @@ public:
 			writeHead_ = 0;
 		}
 
+#ifdef DUAL_CORE
+		syncCore1();
+#endif
+#ifdef PSRAM_MODE
+		if ((globalSampleCounter_ & (CACHE_BLOCK - 1)) == 0)
+		{
+			prefetchPool(pools_[0], writeHead_);
+		}
+#endif
+
 		// X knob controls delay time/spread or becomes attenuverter when CV1 connected
 		int32_t xControlValue = cachedXKnob_;
 
@@ -222,24 +332,21 @@ public:
 			if (xControlValue <= 2047)
 			{
 				// Left half: delay time control only
-				delayDistance_ = 1200 + ((xControlValue * (80000 - 1200)) / 2047);
-				minGrainDistance_ = 0; // Rate limiting permanently removed
+				delayDistance_ = (1200 + ((xControlValue * (80000 - 1200)) / 2047)) * RATE_SCALE;
 				spreadAmount_ = 0;
 			}
 			else
 			{
 				// Right half: spread control with fixed delay - use longer default delay
-				delayDistance_ = 20000;
+				delayDistance_ = 20000 * RATE_SCALE;
 				spreadAmount_ = ((xControlValue - 2048) * 4095) / 2047;
-				minGrainDistance_ = 0; // No minimum distance when using spread control
 			}
 		}
 		else
 		{
 			// CV1 connected: X knob becomes attenuverter
-			delayDistance_ = 20000;
+			delayDistance_ = 20000 * RATE_SCALE;
 			spreadAmount_ = 0;
-			minGrainDistance_ = 0; // No minimum distance when CV1 is connected
 		}
 
 		bool shouldTriggerGrain = PulseIn1RisingEdge();
@@ -255,8 +362,8 @@ public:
 				}
 			}
 
-			int16_t outL = generateStretchedSample(0);
-			int16_t outR = generateStretchedSample(1);
+			int16_t outL, outR;
+			generateStretchedSamples(outL, outR);
 
 			// Clip outputs to prevent overflow and ensure clean audio
 			outL = clipAudio(outL);
@@ -285,8 +392,8 @@ public:
 				}
 			}
 
-			int16_t outL = generateStretchedSample(0);
-			int16_t outR = generateStretchedSample(1);
+			int16_t outL, outR;
+			generateStretchedSamples(outL, outR);
 
 			// Clip outputs to prevent overflow and ensure clean audio
 			outL = clipAudio(outL);
@@ -306,8 +413,8 @@ public:
 				enterLoopMode();
 			}
 
-			int16_t outL = generateStretchedSample(0);
-			int16_t outR = generateStretchedSample(1);
+			int16_t outL, outR;
+			generateStretchedSamples(outL, outR);
 
 			// Clip outputs to prevent overflow and ensure clean audio
 			outL = clipAudio(outL);
@@ -323,39 +430,25 @@ public:
 
 		updateGrains();
 
-		// Auto-trigger initial grain in unclocked mode if no grains are active
-		// This ensures the self-triggering chain gets started
+		// Unclocked: start grains at their scheduled onsets, or start the chain if no grains are active
 		if (!Connected(Input::Pulse1))
 		{
-			// Count active grains
-			int32_t activeCount = 0;
-			for (int i = 0; i < MAX_GRAINS; i++)
+			if (onsetPending_)
 			{
-				if (grains_[i].active)
+				if ((int32_t)((uint32_t)globalSampleCounter_ - (uint32_t)nextOnset_) >= 0)
 				{
-					activeCount++;
+					unclockedOnset();
 				}
 			}
-
-			// If no grains are active in unclocked mode, trigger one to start the chain
-			// But respect Pulse 2 gate if it's connected
-			if (activeCount == 0)
+			else if (totalActiveGrains() == 0)
 			{
-				if (Connected(Input::Pulse2))
-				{
-					// Pulse 2 is connected: only auto-trigger if Pulse 2 is high
-					if (PulseIn2())
-					{
-						triggerNewGrain();
-					}
-				}
-				else
-				{
-					// No pulse inputs connected: always auto-trigger
-					triggerNewGrain();
-				}
+				unclockedOnset();
 			}
 		}
+		else
+		{
+			onsetPending_ = false;
+		}
 
 		updateCVOutputs();
 		updatePulseOutputs();
@@ -366,6 +459,7 @@ public:
 		{
 			updateCounter_ = 0;
 			updateCachedKnobValues();
+			updateStochasticClockPeriod();
 			updatePlaybackSpeed();
 			updateGrainParameters();
 			updateLEDFeedback();
@@ -373,47 +467,182 @@ public:
 	}
 
 private:
-#ifdef LOFI_MODE
-	uint16_t buffer_[BUFF_LENGTH_SAMPLES];  // 16-bit storage for two 8-bit samples
+#ifdef PSRAM_MODE
+	typedef uint32_t Frame; // 32-bit storage for two 16-bit samples
+	Frame *const buffer_ = (Frame *)SHEEP_PSRAM_BASE; // In PSRAM, set up by psramInit before the card is constructed
+#elif defined(LOFI_MODE) || defined(MULAW_MODE)
+	typedef uint16_t Frame; // 16-bit storage for two 8-bit samples
+	Frame buffer_[BUFF_LENGTH_SAMPLES];
 #else
-	uint32_t buffer_[BUFF_LENGTH_SAMPLES];  // 32-bit storage for two 12-bit samples
+	typedef uint32_t Frame; // 32-bit storage for two 12-bit samples
+	Frame buffer_[BUFF_LENGTH_SAMPLES];
 #endif
 	int32_t writeHead_ = 0;
-	int32_t delayDistance_ = 8000;
+	int32_t delayDistance_ = 8000 * RATE_SCALE;
 	int32_t spreadAmount_ = 0;
 
-	// Minimum grain distance control (left side of X knob)
-	int32_t minGrainDistance_ = 0;	   // Minimum samples between grain triggers (0 = no minimum)
-	int32_t lastGrainTriggerTime_ = 0; // Sample counter when last grain was triggered
+	// Unclocked grain onsets, see scheduleOnset
+	int32_t nextOnset_;	 // globalSampleCounter_ value at which the next grain starts
+	bool onsetPending_;
+#if SHEEP_STOCHASTIC_ONSETS
+	static constexpr int ONSET_TABLE_SIZE = 256;
+	uint16_t onsetTable_[ONSET_TABLE_SIZE]; // Exponentially distributed onset intervals, mean 1, Q12
+#endif
 
 	// Grain system
-	struct Grain
-	{
-		int32_t readPos;
-		int32_t readFrac;
-		int32_t sampleCount;
-		int32_t startPos;
-		int32_t loopSize;
-		bool active;
+	// Grains live in pools, each rendered by one core (pool 0 in ProcessSample, pool 1 on core1 in
+	// the dual-core build). Playback state touched by every active grain every sample is kept in
+	// parallel arrays, indexed by grain slot; parameters only needed at trigger, loop and completion
+	// time are in GrainParams. order lists the slots with the active ones first:
+	// order[0 .. numActive-1] are playing and the rest are free, so free slots are never visited.
+	static const int32_t BUFF_LENGTH_FIXED = (int32_t)BUFF_LENGTH_SAMPLES << 12; // buffer length in 20.12
+	static_assert((int64_t)BUFF_LENGTH_SAMPLES * 4096 + MAX_SAFE_GRAIN_SPEED <= INT32_MAX, "20.12 positions must fit in int32_t");
+
+#ifdef PSRAM_MODE
+	// PSRAM reads are slow one at a time but fast in bursts, and grains read the buffer sequentially,
+	// so each grain reads through a cache of two lines in SRAM: the line it is playing and the next
+	// one in its direction of travel. prefetchPool tops these up for every active grain once per
+	// CACHE_BLOCK samples; a grain moves at most one line in that time, so only misses after a
+	// jump (a new grain, a loop restarting) or straddling the next line go to PSRAM directly.
+	// Line l is kept in slot l & 1, so a line and its neighbour always have a slot each.
+	static const int CACHE_LINE_SHIFT = 5;
+	static const int CACHE_LINE_FRAMES = 1 << CACHE_LINE_SHIFT; // 128 bytes
+	static const int CACHE_BLOCK = 16;							// CACHE_BLOCK * max speed (2x) <= CACHE_LINE_FRAMES
+	static const int32_t NUM_CACHE_LINES = BUFF_LENGTH_SAMPLES >> CACHE_LINE_SHIFT;
+	static_assert(BUFF_LENGTH_SAMPLES % (2 * CACHE_LINE_FRAMES) == 0, "the buffer must be an even number of cache lines");
+
+	struct GrainCache
+	{
+		int32_t tag[2]; // Buffer line in each slot, -1 = empty
+		Frame lines[2][CACHE_LINE_FRAMES];
+	};
+#endif
+
+	struct GrainPool;
+	struct GrainContext;
+
+	// Running sums of a pool's grains for one sample
+	struct GrainMix
+	{
+		int32_t left;
+		int32_t right;
+		int32_t weight;
+	};
+
+	// Each grain plays through a pair of kernels chosen by selectKernels when it starts or changes mode,
+	// so the grain loops call straight through them rather than testing every grain's mode each sample:
+	// a read kernel adds its weighted output to the mix, and an advance kernel moves it on by one sample
+	// and reports what happened
+	enum GrainEvent
+	{
+		GRAIN_COMPLETED = 1, // Reached its completion threshold (Pulse 1 out)
+		GRAIN_FINISHED = 2	 // Played to its end; deactivate it
+	};
+	enum GrainDirection
+	{
+		GRAIN_FORWARD,
+		GRAIN_REVERSE
+	};
+	typedef void (*GrainRead)(Sheep &sheep, const GrainPool &pool, int i, int32_t totalActive, GrainMix &mix);
+	typedef int (*GrainAdvance)(Sheep &sheep, GrainPool &pool, int i, const GrainContext &ctx);
+
+	struct GrainParams
+	{
+		int32_t startPos;			  // Loop start, 20.12
+		int32_t grainSize;			  // Snapshotted at trigger
+		int32_t completionCount;	  // Samples to the completion threshold (Pulse 1 out), snapshotted at trigger
+		int32_t baselineControlValue; // Control value when grain enters loop mode
 		bool looping;
 		bool pulse90Triggered;
-		// Per-grain parameters (snapshotted at trigger)
-		int32_t delayDistance;
-		int32_t spreadAmount;
+	};
+
+	struct GrainPool
+	{
+		int32_t pos[MAX_GRAINS];		 // Read position in samples, 20.12 fixed point
+		int32_t speed[MAX_GRAINS];		 // Speed for this grain's lifecycle, Q12 (snapshotted at trigger)
+		int32_t count[MAX_GRAINS];		 // Samples played, for looping and completion
+		uint32_t window[MAX_GRAINS];	 // Window phase, 2^32 = whole grain
+		uint32_t windowInc[MAX_GRAINS];	 // Window phase increment per sample played
+		const int32_t *windowTable[MAX_GRAINS];
+		int16_t panGain[2][MAX_GRAINS];	 // Left and right gains, Q12 (4096 = centre)
+		GrainRead read[MAX_GRAINS];		 // Kernels for the grain's mode, see selectKernels
+		GrainAdvance advance[MAX_GRAINS];
+		GrainParams params[MAX_GRAINS];
+		uint8_t order[MAX_GRAINS];
+#ifdef PSRAM_MODE
+		GrainCache cache[MAX_GRAINS]; // Touched only by the core rendering this pool
+#endif
+		int32_t numActive;
+		int32_t previousLoopingControlValue; // Track last applied control value for looping hysteresis
+		bool loopMode;						 // Loop mode as last applied to this pool's grains
+	};
+	GrainPool pools_[NUM_GRAIN_POOLS];
+
+	// A grain to start, worked out by triggerNewGrain on core0
+	struct GrainTrigger
+	{
+		int32_t pos; // 20.12
 		int32_t grainSize;
-		int32_t grainSpeed; // Store speed for this grain's lifecycle
-		int32_t baselineControlValue; // Control value when grain enters loop mode
+		int32_t completionCount;
+		int32_t speed;
+		int32_t pan; // -4096 (left) to 4096 (right), 0 = centre
+		const int32_t *windowTable;
+	};
+
+	// Values shared by all of a pool's grains for one sample, worked out once
+	struct GrainContext
+	{
+		int32_t writeHead;
+		int32_t otherActive;		 // Active grains in the other pool (windowing is only used with 2+ grains)
+		int32_t loopingControlValue; // currentPitchControlValue(), for looping grains
+		bool bufferIsFrozen;
+		bool cv2Connected;
+	};
+
+#ifdef DUAL_CORE
+	// Core1 renders pool 1 a block ahead: while core0 plays block b, core1 renders block b+1 into the
+	// other half of core1Out_, and core0 adds each sample's partial mix to its own before normalising.
+	// The circular buffer is shared read-only; everything else core1 needs (writeHead_, loop mode,
+	// new grains) is handed over at a block boundary, only while core1 is idle.
+	static const int CORE1_BLOCK = 16;		 // 0.67ms at 24kHz; well inside SAFETY_MARGIN_SAMPLES
+	static const uint32_t TRIGGER_FIFO = 16; // power of two
+
+	struct Core1Sample
+	{
+		int32_t mixL, mixR, weight; // Partial sums, as in generateStretchedSamples
+		int32_t completions;		// Grains reaching their completion threshold on this sample
 	};
-	Grain grains_[MAX_GRAINS];
+	Core1Sample core1Out_[2][CORE1_BLOCK];
+
+	// New grains for core1, core0 -> core1
+	GrainTrigger core1Triggers_[TRIGGER_FIFO];
+	volatile uint32_t core1TriggerWrite_ = 0;
+	volatile uint32_t core1TriggerRead_ = 0;
+
+	// Block request, written by core0 only while core1 is idle
+	GrainContext core1Context_;		   // For the first sample of the block; writeHead then advances by one per sample
+	uint32_t core1TriggerEnd_ = 0;	   // Triggers pushed before the request
+	bool core1LoopMode_ = false;
+	int32_t core1LoopBaseline_ = 4096;
+	volatile uint32_t core1Requested_ = 0; // Block number core1 is asked to render
+
+	// Written by core1
+	volatile uint32_t core1Rendered_ = 0; // Last block number rendered
+	volatile int32_t core1Active_ = 0;	  // Active grains in pool 1
+
+	// Core0 block position
+	uint32_t blockNumber_ = 0;
+	int32_t blockSample_ = CORE1_BLOCK - 1;
+	bool core1BlockValid_ = false; // core1 rendered the block core0 is playing
+#endif
 
 	int32_t stretchRatio_;
 	int32_t grainPlaybackSpeed_;
 	int32_t previousGrainPlaybackSpeed_; // Track last applied speed for hysteresis
-	int32_t previousLoopingControlValue_; // Track last applied control value for looping hysteresis
 	int32_t grainSize_;
 	int32_t maxActiveGrains_;
-	int32_t cachedActiveGrainCount_; // Cache grain count to avoid repeated counting in calculateGrainWeight()
 	bool loopMode_;
+	int32_t loopBaseline_; // Control value when loop mode was entered
 
 	// Pulse and CV output state
 	int32_t pulseOut1Counter_;
@@ -429,7 +658,7 @@ private:
 	int16_t lastOutputR_;
 
 	// Control update throttling
-	static const int32_t UPDATE_RATE_DIVIDER = 24;
+	static const int32_t UPDATE_RATE_DIVIDER = 24 * RATE_SCALE;
 	int32_t updateCounter_;
 
 	// Global sample counter for timing
@@ -440,79 +669,116 @@ private:
 	int32_t cachedXKnob_;
 	int32_t cachedYKnob_;
 
-	// 12kHz notch filter state variables (to remove mux interference)
-	int32_t mix1L_, mix2L_, mixf1L_, mixf2L_;  // Left channel
-	int32_t mix1R_, mix2R_, mixf1R_, mixf2R_;  // Right channel
-
+	// Buffer frame as read by grain i of pool
+	Frame __not_in_flash_func(grainFrame)(const GrainPool &pool, int i, int32_t frame)
+	{
+#ifdef PSRAM_MODE
+		const GrainCache &cache = pool.cache[i];
+		int32_t line = frame >> CACHE_LINE_SHIFT;
+		if (cache.tag[line & 1] == line)
+			return cache.lines[line & 1][frame & (CACHE_LINE_FRAMES - 1)];
+#else
+		(void)pool; // Grains read the buffer directly
+		(void)i;
+#endif
+		return buffer_[frame];
+	}
 
-	// Interpolated sample reading with wraparound
-	int16_t __not_in_flash_func(getInterpolatedSample)(int32_t bufferPos, int32_t frac, int channel)
+	// Interpolated stereo sample at grain i's read position (always within the buffer)
+	void __not_in_flash_func(getInterpolatedStereo)(const GrainPool &pool, int i, int32_t &left, int32_t &right)
 	{
-		// Ensure buffer position is within bounds
-		int32_t pos1 = bufferPos;
-		while (pos1 >= BUFF_LENGTH_SAMPLES)
-			pos1 -= BUFF_LENGTH_SAMPLES;
-		while (pos1 < 0)
-			pos1 += BUFF_LENGTH_SAMPLES;
+		int32_t pos = pool.pos[i];
+		int32_t pos1 = pos >> 12;
+		int32_t frac = pos & 0xFFF;
 
 		int32_t pos2 = pos1 + 1;
 		if (pos2 >= BUFF_LENGTH_SAMPLES)
 			pos2 = 0;
 
-		// Redundant safety check removed for performance
-		// pos1 and pos2 are guaranteed to be in bounds after wraparound logic above
-
-		int16_t sample1 = unpackStereo(buffer_[pos1], channel);
-		int16_t sample2 = unpackStereo(buffer_[pos2], channel);
-
-		// Removed fractional part clamping for performance
-		// Assumes frac is always in valid range from caller
+		interpolateStereo(grainFrame(pool, i, pos1), grainFrame(pool, i, pos2), frac, left, right);
+	}
 
-		// Linear interpolation in Q12
-		int32_t diff = sample2 - sample1;
-		int32_t interpolated = sample1 + ((diff * frac) >> 12);
+#ifdef PSRAM_MODE
+	// Copy a line of the buffer into grain i's cache, in one burst, unless it is already there
+	void __not_in_flash_func(fetchLine)(GrainPool &pool, int i, int32_t line)
+	{
+		GrainCache &cache = pool.cache[i];
+		if (cache.tag[line & 1] == line)
+			return;
+		memcpy(cache.lines[line & 1], &buffer_[line << CACHE_LINE_SHIFT], sizeof(cache.lines[0]));
+		cache.tag[line & 1] = line;
+	}
 
-		// Clamp result
-		if (interpolated > (AUDIO_RANGE - 1))
-			interpolated = (AUDIO_RANGE - 1);
-		if (interpolated < -AUDIO_RANGE)
-			interpolated = -AUDIO_RANGE;
+	// Make sure grain i has the line it is playing and the next one in its direction of travel
+	void __not_in_flash_func(prefetchGrain)(GrainPool &pool, int i)
+	{
+		int32_t line = pool.pos[i] >> (12 + CACHE_LINE_SHIFT);
+		int32_t next = (pool.speed[i] < 0) ? line - 1 : line + 1;
+		if (next < 0)
+			next += NUM_CACHE_LINES;
+		else if (next >= NUM_CACHE_LINES)
+			next -= NUM_CACHE_LINES;
+		fetchLine(pool, i, line);
+		fetchLine(pool, i, next);
+	}
 
-		return (int16_t)interpolated;
+	// Once per CACHE_BLOCK samples, before the pool is rendered: drop cached copies of the lines
+	// recorded into during the block (so loops over fresh audio hear it, as they do from SRAM), then prefetch
+	void __not_in_flash_func(prefetchPool)(GrainPool &pool, int32_t writeHead)
+	{
+		int32_t writeLine = writeHead >> CACHE_LINE_SHIFT;
+		int32_t nextWriteLine = (writeLine + 1 < NUM_CACHE_LINES) ? writeLine + 1 : 0;
+		for (int k = 0; k < pool.numActive; k++)
+		{
+			int i = pool.order[k];
+			GrainCache &cache = pool.cache[i];
+			if (cache.tag[writeLine & 1] == writeLine)
+				cache.tag[writeLine & 1] = -1;
+			if (cache.tag[nextWriteLine & 1] == nextWriteLine)
+				cache.tag[nextWriteLine & 1] = -1;
+			prefetchGrain(pool, i);
+		}
 	}
+#endif
 
-	// Calculate looping grain speed with scaled offset from original speed
-	int32_t __not_in_flash_func(calculateLoopingGrainSpeed)(int32_t originalSpeed, int32_t baselineControlValue)
+	// Wrap a 20.12 position, at most one buffer length outside the buffer, back into it
+	int32_t __not_in_flash_func(wrapPosition)(int32_t pos)
 	{
-		int32_t currentControlValue;
+		if (pos >= BUFF_LENGTH_FIXED)
+			pos -= BUFF_LENGTH_FIXED;
+		else if (pos < 0)
+			pos += BUFF_LENGTH_FIXED;
+		return pos;
+	}
 
+	// Pitch control value from the Main knob, or from CV2 with the Main knob as attenuverter
+	// (no hysteresis; used as the looping grain speed reference)
+	int32_t __not_in_flash_func(currentPitchControlValue)()
+	{
 		if (Connected(Input::CV2))
 		{
 			// CV2 controls pitch, Main knob is attenuverter (use center detent only)
-			// No hysteresis for CV2 - apply immediately for responsive CV control
 			int32_t cv2Val = CVIn2();
 			int32_t mainKnobVal = virtualDetentedKnob(cachedMainKnob_);
-			currentControlValue = applyPitchAttenuverter(cv2Val, mainKnobVal);
+			return applyPitchAttenuverter(cv2Val, mainKnobVal);
 		}
-		else
-		{
-			// Main knob controls pitch directly (use multiple detents for musical speeds)
-			int32_t mainKnobVal = pitchDetentedKnob(cachedMainKnob_);
 
-			// Calculate new speed after detent processing
-			if (mainKnobVal <= 2048)
-			{
-				currentControlValue = -8192 + ((mainKnobVal * 8192) >> 11);
-			}
-			else
-			{
-				int32_t rightKnob = mainKnobVal - 2048;
-				currentControlValue = (rightKnob * 8192) >> 11;
-			}
+		// Main knob controls pitch directly (use multiple detents for musical speeds)
+		int32_t mainKnobVal = pitchDetentedKnob(cachedMainKnob_);
+		if (mainKnobVal <= 2048)
+		{
+			return -8192 + ((mainKnobVal * 8192) >> 11);
 		}
+		int32_t rightKnob = mainKnobVal - 2048;
+		return (rightKnob * 8192) >> 11;
+	}
 
+	// Calculate looping grain speed with scaled offset from original speed
+	// The current control value comes from the context, computed once per sample for all looping grains
+	int32_t __not_in_flash_func(calculateLoopingGrainSpeed)(GrainPool &pool, int32_t originalSpeed, int32_t baselineControlValue, const GrainContext &ctx)
+	{
 		// Calculate offset from baseline (not center) - this prevents immediate jumps when entering loop mode
-		int32_t offset = currentControlValue - baselineControlValue;
+		int32_t offset = ctx.loopingControlValue - baselineControlValue;
 
 		// Apply scaled offset: finalSpeed = originalSpeed + (originalSpeed * offset / 4096)
 		// This gives ±100% speed variation around the original grain speed
@@ -521,17 +787,17 @@ private:
 		int32_t finalSpeed = originalSpeed + scaledOffset;
 
 		// Apply hysteresis to the final calculated speed (not CV2 mode for responsive CV control)
-		if (!Connected(Input::CV2))
+		if (!ctx.cv2Connected)
 		{
-			if (cabs(finalSpeed - previousLoopingControlValue_) <= SPEED_HYSTERESIS_THRESHOLD)
+			if (cabs(finalSpeed - pool.previousLoopingControlValue) <= SPEED_HYSTERESIS_THRESHOLD)
 			{
 				// Change is too small - keep previous final speed to prevent noise-induced changes
-				finalSpeed = previousLoopingControlValue_;
+				finalSpeed = pool.previousLoopingControlValue;
 			}
 			else
 			{
 				// Update the looping control tracking variable with the new final speed
-				previousLoopingControlValue_ = finalSpeed;
+				pool.previousLoopingControlValue = finalSpeed;
 			}
 		}
 
@@ -794,506 +1060,676 @@ private:
 
 	void __not_in_flash_func(triggerNewGrain)()
 	{
-		// Count currently active grains to respect dynamic limit
-		int32_t activeCount = 0;
-		for (int i = 0; i < MAX_GRAINS; i++)
+		// Don't trigger new grain if we're at the current limit; otherwise pick the less busy pool
+		int32_t active0 = pools_[0].numActive;
+#ifdef DUAL_CORE
+		// Grains still on their way to core1 count as active (read the FIFO before core1Active_,
+		// so a grain being moved from one to the other is counted twice rather than not at all)
+		uint32_t pending = core1TriggerWrite_ - core1TriggerRead_;
+		int32_t active1 = core1Active_ + (int32_t)pending;
+		bool toCore1 = pending < TRIGGER_FIFO && active1 < MAX_GRAINS && (active1 < active0 || active0 >= MAX_GRAINS);
+		if (!toCore1 && active0 >= MAX_GRAINS)
 		{
-			if (grains_[i].active)
-			{
-				activeCount++;
-			}
+			return;
 		}
-
-		// Don't trigger new grain if we're at the current limit
-		if (activeCount >= maxActiveGrains_)
+#else
+		if (active0 >= maxActiveGrains_)
 		{
 			return;
 		}
+#endif
+
+		// Snapshot grain size, completion threshold and speed for this grain
+		GrainTrigger trigger;
+		trigger.grainSize = grainSize_;
+		trigger.completionCount = completionSamples();
+		trigger.speed = grainPlaybackSpeed_; // Snapshot current speed for grain's lifecycle
+		trigger.windowTable = windowTables_[windowShape_];
+#if SHEEP_GRAIN_PAN
+		// Random pan, as wide as the position spread
+		trigger.pan = (((int32_t)(rnd12() & 0xFFF) - 2048) * spreadAmount_) >> 11;
+#else
+		trigger.pan = 0;
+#endif
 
-		// Find an inactive grain slot
-		for (int i = 0; i < MAX_GRAINS; i++)
+		// The next unclocked grain is timed from this one
+		if (!loopMode_)
 		{
-			if (!grains_[i].active)
-			{
-				grains_[i].active = true;
-				cachedActiveGrainCount_++; // Update cached count when grain is activated
+			scheduleOnset(trigger.completionCount);
+		}
 
-				// Update last grain trigger time for minimum distance tracking
-				lastGrainTriggerTime_ = globalSampleCounter_;
+		// Generate new noise value for CV Out 1 when grain is triggered
+		cvOut1NoiseValue_ = (int16_t)((rnd12() & 0xFFF) - 2048); // -2048 to +2047
+
+		// Calculate base playback position using write head for consistent delay timing
+		int32_t basePlaybackPos = writeHead_ - delayDistance_;
+		if (basePlaybackPos < 0)
+			basePlaybackPos += BUFF_LENGTH_SAMPLES;
+
+		// Handle CV1 position control vs normal spread control
+		int32_t playbackPos;
+		if (Connected(Input::CV1))
+		{
+			// CV1 connected: CV1 controls grain position with X knob as attenuverter
+			// Read CV1 input only when grain is triggered
+			int32_t cv1Val = CVIn1();		 // -2048 to +2047 (±5V)
+			int32_t xKnobVal = cachedXKnob_; // 0 to 4095 (X knob as attenuverter)
+
+			// Convert CV1 to position control value with wrapping
+			// 0-5V (cv1Val 0 to +2047) uses full range 0-4095
+			// Negative values wrap around from the end
+			int32_t rawPositionValue;
+			if (cv1Val >= 0)
+			{
+				// Positive CV: scale 0-2047 to 0-4095 (double the resolution for 0-5V)
+				rawPositionValue = (cv1Val * 4095) / 2047;
+			}
+			else
+			{
+				// Negative CV: wrap from end of range
+				// -2048 to -1 maps to 4095 down to 2048 (wrapping from end)
+				rawPositionValue = 4095 + ((cv1Val * 2048) / 2048); // cv1Val is negative, so this subtracts
+			}
 
-				// Snapshot delay, spread, grain size, and speed for this grain
-				grains_[i].delayDistance = delayDistance_;
-				grains_[i].spreadAmount = spreadAmount_;
-				grains_[i].grainSize = grainSize_;
-				grains_[i].grainSpeed = grainPlaybackSpeed_; // Snapshot current speed for grain's lifecycle
+			// Clamp to valid range
+			if (rawPositionValue < 0)
+				rawPositionValue = 0;
+			if (rawPositionValue > 4095)
+				rawPositionValue = 4095;
+
+			// Apply X knob as proper attenuverter
+			// X knob at 0 = full inversion (-1x)
+			// X knob at 2048 = no effect (0x = no effect), 4095 = full positive (+1x)
+			int32_t positionControlValue;
+
+			// Map X knob to gain factor: 0 -> -1x, 2048 -> 0x, 4095 -> +1x
+			int32_t gainFactor;
+			if (xKnobVal <= 2048)
+			{
+				// Left half: -1x to 0x
+				gainFactor = -4096 + ((xKnobVal * 4096) / 2048); // -4096 to 0
+			}
+			else
+			{
+				// Right half: 0x to +1x
+				gainFactor = ((xKnobVal - 2048) * 4096) / 2047; // 0 to +4096
+			}
 
-				// Reset pulse trigger flag for this grain
-				grains_[i].pulse90Triggered = false;
+			// Apply attenuverter: center position (2048) + (CV offset * gain)
+			int32_t cvOffset = rawPositionValue - 2048;			   // -2048 to +2047
+			int32_t scaledOffset = (cvOffset * gainFactor) / 4096; // Apply gain
+			positionControlValue = 2048 + scaledOffset;			   // Add back to center
 
-				// Generate new noise value for CV Out 1 when grain is triggered
-				cvOut1NoiseValue_ = (int16_t)((rnd12() & 0xFFF) - 2048); // -2048 to +2047
+			// Final clamp
+			if (positionControlValue < 0)
+				positionControlValue = 0;
+			if (positionControlValue > 4095)
+				positionControlValue = 4095;
 
-				// Calculate base playback position using write head for consistent delay timing
-				int32_t basePlaybackPos = writeHead_ - grains_[i].delayDistance;
-				if (basePlaybackPos < 0)
-					basePlaybackPos += BUFF_LENGTH_SAMPLES;
+			// Check if buffer is frozen (switch up)
+			bool bufferIsFrozen = (SwitchVal() == Switch::Up);
 
-				// Handle CV1 position control vs normal spread control
-				int32_t playbackPos;
-				if (Connected(Input::CV1))
-				{
-					// CV1 connected: CV1 controls grain position with X knob as attenuverter
-					// Read CV1 input only when grain is triggered
-					int32_t cv1Val = CVIn1();		 // -2048 to +2047 (±5V)
-					int32_t xKnobVal = cachedXKnob_; // 0 to 4095 (X knob as attenuverter)
-
-					// Convert CV1 to position control value with wrapping
-					// 0-5V (cv1Val 0 to +2047) uses full range 0-4095
-					// Negative values wrap around from the end
-					int32_t rawPositionValue;
-					if (cv1Val >= 0)
-					{
-						// Positive CV: scale 0-2047 to 0-4095 (double the resolution for 0-5V)
-						rawPositionValue = (cv1Val * 4095) / 2047;
-					}
-					else
-					{
-						// Negative CV: wrap from end of range
-						// -2048 to -1 maps to 4095 down to 2048 (wrapping from end)
-						rawPositionValue = 4095 + ((cv1Val * 2048) / 2048); // cv1Val is negative, so this subtracts
-					}
-
-					// Clamp to valid range
-					if (rawPositionValue < 0)
-						rawPositionValue = 0;
-					if (rawPositionValue > 4095)
-						rawPositionValue = 4095;
-
-					// Apply X knob as proper attenuverter
-					// X knob at 0 = full inversion (-1x)
-					// X knob at 2048 = no effect (0x = no effect), 4095 = full positive (+1x)
-					int32_t positionControlValue;
-
-					// Map X knob to gain factor: 0 -> -1x, 2048 -> 0x, 4095 -> +1x
-					int32_t gainFactor;
-					if (xKnobVal <= 2048)
-					{
-						// Left half: -1x to 0x
-						gainFactor = -4096 + ((xKnobVal * 4096) / 2048); // -4096 to 0
-					}
-					else
-					{
-						// Right half: 0x to +1x
-						gainFactor = ((xKnobVal - 2048) * 4096) / 2047; // 0 to +4096
-					}
-
-					// Apply attenuverter: center position (2048) + (CV offset * gain)
-					int32_t cvOffset = rawPositionValue - 2048;			   // -2048 to +2047
-					int32_t scaledOffset = (cvOffset * gainFactor) / 4096; // Apply gain
-					positionControlValue = 2048 + scaledOffset;			   // Add back to center
-
-					// Final clamp
-					if (positionControlValue < 0)
-						positionControlValue = 0;
-					if (positionControlValue > 4095)
-						positionControlValue = 4095;
-
-					// Check if buffer is frozen (switch up)
-					bool bufferIsFrozen = (SwitchVal() == Switch::Up);
-
-					if (bufferIsFrozen)
-					{
-						// Freeze mode: CV1 scrubs the entire buffer (0-4095 maps to full buffer range)
-						// 0 = beginning of buffer, 4095 = end of buffer
-						playbackPos = (positionControlValue * (BUFF_LENGTH_SAMPLES - 1)) / 4095;
-					}
-					else
-					{
-						// Normal mode: CV1 directly controls buffer position
-						// 0 = beginning of buffer, 4095 = end of buffer (no randomization/spread)
-						playbackPos = (positionControlValue * (BUFF_LENGTH_SAMPLES - 1)) / 4095;
-					}
-
-					// Ensure position is within buffer bounds
-					if (playbackPos >= BUFF_LENGTH_SAMPLES)
-						playbackPos = BUFF_LENGTH_SAMPLES - 1;
-					if (playbackPos < 0)
-						playbackPos = 0;
-				}
-				else
-				{
-					// CV1 disconnected: Use normal spread control (original behavior)
-					if (grains_[i].spreadAmount == 0)
-					{
-						playbackPos = basePlaybackPos;
-					}
-					else
-					{
-						int32_t randomValue = rnd12() & 0xFFF;	   // 0 to 4095
-						int32_t randomOffset = randomValue - 2047; // -2047 to +2048, centered better
-						const int32_t maxSafeOffset = BUFF_LENGTH_SAMPLES >> 3;
-						int64_t temp64 = (int64_t)randomOffset * maxSafeOffset;
-						temp64 >>= 11;
-						if (temp64 > maxSafeOffset)
-							temp64 = maxSafeOffset;
-						if (temp64 < -maxSafeOffset)
-							temp64 = -maxSafeOffset;
-						temp64 = (temp64 * grains_[i].spreadAmount) >> 12;
-						if (temp64 > maxSafeOffset)
-							temp64 = maxSafeOffset;
-						if (temp64 < -maxSafeOffset)
-							temp64 = -maxSafeOffset;
-						randomOffset = (int32_t)temp64;
-						playbackPos = basePlaybackPos + randomOffset;
-					}
-				}
-				while (playbackPos >= BUFF_LENGTH_SAMPLES)
-					playbackPos -= BUFF_LENGTH_SAMPLES;
-				while (playbackPos < 0)
-					playbackPos += BUFF_LENGTH_SAMPLES;
-
-				// Apply write head safety check ONLY when buffer is recording (not frozen)
-				// In freeze mode, grains can access the entire buffer safely
-				// Also skip safety check when CV1 is connected since position is explicitly controlled
-				bool bufferIsFrozen = (SwitchVal() == Switch::Up);
-				bool cv1Connected = Connected(Input::CV1);
-				if (!bufferIsFrozen && !cv1Connected)
-				{
-					const int32_t safetyMargin = SAFETY_MARGIN_SAMPLES;
-					int32_t maxSafePos = writeHead_ - safetyMargin;
-					if (maxSafePos < 0)
-						maxSafePos += BUFF_LENGTH_SAMPLES;
-					int32_t distanceFromWrite = writeHead_ - playbackPos;
-					if (distanceFromWrite < 0)
-						distanceFromWrite += BUFF_LENGTH_SAMPLES;
-					if (distanceFromWrite < safetyMargin)
-					{
-						playbackPos = maxSafePos;
-					}
-				}
+			if (bufferIsFrozen)
+			{
+				// Freeze mode: CV1 scrubs the entire buffer (0-4095 maps to full buffer range)
+				// 0 = beginning of buffer, 4095 = end of buffer
+				playbackPos = (positionControlValue * (BUFF_LENGTH_SAMPLES - 1)) / 4095;
+			}
+			else
+			{
+				// Normal mode: CV1 directly controls buffer position
+				// 0 = beginning of buffer, 4095 = end of buffer (no randomization/spread)
+				playbackPos = (positionControlValue * (BUFF_LENGTH_SAMPLES - 1)) / 4095;
+			}
 
-				grains_[i].readPos = playbackPos;
-				grains_[i].readFrac = 0;
-				grains_[i].startPos = grains_[i].readPos;
-				grains_[i].sampleCount = 0;
-				grains_[i].loopSize = grains_[i].grainSize;
-				break;
+			// Ensure position is within buffer bounds
+			if (playbackPos >= BUFF_LENGTH_SAMPLES)
+				playbackPos = BUFF_LENGTH_SAMPLES - 1;
+			if (playbackPos < 0)
+				playbackPos = 0;
+		}
+		else
+		{
+			// CV1 disconnected: Use normal spread control (original behavior)
+			if (spreadAmount_ == 0)
+			{
+				playbackPos = basePlaybackPos;
 			}
+			else
+			{
+				int32_t randomValue = rnd12() & 0xFFF;	   // 0 to 4095
+				int32_t randomOffset = randomValue - 2047; // -2047 to +2048, centered better
+				const int32_t maxSafeOffset = BUFF_LENGTH_SAMPLES >> 3;
+				int64_t temp64 = (int64_t)randomOffset * maxSafeOffset;
+				temp64 >>= 11;
+				if (temp64 > maxSafeOffset)
+					temp64 = maxSafeOffset;
+				if (temp64 < -maxSafeOffset)
+					temp64 = -maxSafeOffset;
+				temp64 = (temp64 * spreadAmount_) >> 12;
+				if (temp64 > maxSafeOffset)
+					temp64 = maxSafeOffset;
+				if (temp64 < -maxSafeOffset)
+					temp64 = -maxSafeOffset;
+				randomOffset = (int32_t)temp64;
+				playbackPos = basePlaybackPos + randomOffset;
+			}
+		}
+		while (playbackPos >= BUFF_LENGTH_SAMPLES)
+			playbackPos -= BUFF_LENGTH_SAMPLES;
+		while (playbackPos < 0)
+			playbackPos += BUFF_LENGTH_SAMPLES;
+
+		// Apply write head safety check ONLY when buffer is recording (not frozen)
+		// In freeze mode, grains can access the entire buffer safely
+		// Also skip safety check when CV1 is connected since position is explicitly controlled
+		bool bufferIsFrozen = (SwitchVal() == Switch::Up);
+		bool cv1Connected = Connected(Input::CV1);
+		if (!bufferIsFrozen && !cv1Connected)
+		{
+			const int32_t safetyMargin = SAFETY_MARGIN_SAMPLES;
+			int32_t maxSafePos = writeHead_ - safetyMargin;
+			if (maxSafePos < 0)
+				maxSafePos += BUFF_LENGTH_SAMPLES;
+			int32_t distanceFromWrite = writeHead_ - playbackPos;
+			if (distanceFromWrite < 0)
+				distanceFromWrite += BUFF_LENGTH_SAMPLES;
+			if (distanceFromWrite < safetyMargin)
+			{
+				playbackPos = maxSafePos;
+			}
+		}
+
+		trigger.pos = playbackPos << 12;
+
+#ifdef DUAL_CORE
+		if (toCore1)
+		{
+			// Picked up by core1 at the next block request
+			core1Triggers_[core1TriggerWrite_ & (TRIGGER_FIFO - 1)] = trigger;
+			__dmb();
+			core1TriggerWrite_ = core1TriggerWrite_ + 1;
+			return;
 		}
+#endif
+		startGrain(pools_[0], trigger);
 	}
 
-	int32_t __not_in_flash_func(calculateGrainWeight)(int grainIndex)
+	// Start a grain in a free slot of pool; called by the core that renders the pool
+	void __not_in_flash_func(startGrain)(GrainPool &pool, const GrainTrigger &trigger)
 	{
-		Grain &grain = grains_[grainIndex];
-
-		// In loop/glitch mode, bypass windowing for harsh discontinuities
-		if (grain.looping)
+		if (pool.numActive >= MAX_GRAINS)
 		{
-			return 4096; // Full weight - no windowing for glitch effects
+			return;
 		}
 
-		// Safety check to prevent division by zero
-		if (grain.grainSize <= 0)
+		// Take the first free grain slot
+		int i = pool.order[pool.numActive++];
+		GrainParams &grain = pool.params[i];
+
+		grain.grainSize = trigger.grainSize;
+		grain.completionCount = trigger.completionCount;
+		grain.looping = false;
+		grain.pulse90Triggered = false; // Reset pulse trigger flag for this grain
+		grain.startPos = trigger.pos;
+
+		pool.pos[i] = trigger.pos;
+		pool.speed[i] = trigger.speed;
+		pool.count[i] = 0;
+
+		// Window phase runs from 0 to just under 2^32 over the grain's length
+		pool.window[i] = 0;
+		pool.windowInc[i] = 0xFFFFFFFFu / (uint32_t)grain.grainSize;
+		pool.windowTable[i] = trigger.windowTable;
+
+		// Balance: panning towards one side turns the other down
+		pool.panGain[0][i] = (trigger.pan > 0) ? 4096 - trigger.pan : 4096;
+		pool.panGain[1][i] = (trigger.pan < 0) ? 4096 + trigger.pan : 4096;
+		selectKernels(pool, i);
+
+#ifdef PSRAM_MODE
+		// The slot's cache holds wherever its last grain was playing
+		pool.cache[i].tag[0] = -1;
+		pool.cache[i].tag[1] = -1;
+		prefetchGrain(pool, i);
+#endif
+	}
+
+	// Choose grain i's kernels for its mode: loop or play once (forward or in reverse by its speed), and
+	// panned or not. Panning is only compiled in with SHEEP_GRAIN_PAN
+	void __not_in_flash_func(selectKernels)(GrainPool &pool, int i)
+	{
+		bool panned = SHEEP_GRAIN_PAN && (pool.panGain[0][i] != 4096 || pool.panGain[1][i] != 4096);
+		if (pool.params[i].looping)
+		{
+			pool.read[i] = panned ? &readGrain<true, true> : &readGrain<true, false>;
+			pool.advance[i] = &advanceLoopingGrain;
+		}
+		else
 		{
-			return 4096; // Full weight if grain size is invalid
+			pool.read[i] = panned ? &readGrain<false, true> : &readGrain<false, false>;
+			pool.advance[i] = (pool.speed[i] < 0) ? &advanceGrain<GRAIN_REVERSE> : &advanceGrain<GRAIN_FORWARD>;
 		}
+	}
+
+	// Read kernel: add grain i's interpolated output, weighted by its window, to the mix
+	template <bool Looping, bool Panned>
+	static void __not_in_flash_func(readGrain)(Sheep &sheep, const GrainPool &pool, int i, int32_t totalActive, GrainMix &mix)
+	{
+		int32_t left, right;
+		sheep.getInterpolatedStereo(pool, i, left, right);
+
+		// Looping (glitch) grains bypass windowing for harsh discontinuities, and a lone grain plays
+		// at full weight for maximum clarity; overlapping grains are windowed
+		int32_t weight = (Looping || totalActive <= 1) ? 4096 : sheep.windowWeight(pool.windowTable[i], pool.window[i]);
 
-		// Count active grains to determine if windowing is needed
-		// Use cached count for performance - updated only when grains are created/destroyed
-		// Only apply windowing when multiple grains are active (overlapping)
-		if (cachedActiveGrainCount_ <= 1)
+		if (Panned)
 		{
-			return 4096; // Single grain - full weight for maximum clarity
+			left = (left * pool.panGain[0][i]) >> 12;
+			right = (right * pool.panGain[1][i]) >> 12;
 		}
 
-		// Normal windowing for overlapping grains
-		// Position in grain: 0 to grainSize-1, normalized to 0-4095 (Q12)
-		int32_t posQ12 = (grain.sampleCount << 12) / grain.grainSize; // Q12 normalized position (0-4095)
-		if (posQ12 < 0)
-			posQ12 = 0;
-		if (posQ12 > 4095)
-			posQ12 = 4095;
+		mix.left += (left * weight) >> 12; // Q12 format
+		mix.right += (right * weight) >> 12;
+		mix.weight += weight;
+	}
+
+	// Advance kernel for a grain playing once: it wraps only at the end of the buffer it is heading for
+	template <GrainDirection Direction>
+	static int __not_in_flash_func(advanceGrain)(Sheep &sheep, GrainPool &pool, int i, const GrainContext &ctx)
+	{
+		(void)sheep;
+		GrainParams &grain = pool.params[i];
+		int events = 0;
 
-		// Map Q12 position to table lookup with proper interpolation
-		// Scale posQ12 to table range: 0-4095 -> 0-(HANN_TABLE_SIZE-1) in Q12
-		int32_t tablePos = (posQ12 * (HANN_TABLE_SIZE - 1)) >> 12;	  // Integer table index
-		int32_t tableFrac = (posQ12 * (HANN_TABLE_SIZE - 1)) & 0xFFF; // Q12 fractional part
+		pool.count[i]++;
+		pool.window[i] += pool.windowInc[i];
 
-		// Clamp table index to valid range
-		if (tablePos >= HANN_TABLE_SIZE - 1)
+		int32_t pos = pool.pos[i] + pool.speed[i];
+		if (Direction == GRAIN_FORWARD)
 		{
-			tablePos = HANN_TABLE_SIZE - 1;
-			tableFrac = 0;
+			if (pos >= BUFF_LENGTH_FIXED)
+				pos -= BUFF_LENGTH_FIXED;
 		}
+		else if (pos < 0)
+		{
+			pos += BUFF_LENGTH_FIXED;
+		}
+
+		// WRITE HEAD BOUNDARY CHECK: Prevent grains from reading past write head
+		// Only apply this check when buffer is recording (not frozen)
+		if (!ctx.bufferIsFrozen)
+		{
+			// Calculate distance from grain to write head (accounting for circular buffer)
+			int32_t distanceToWrite = ctx.writeHead - (pos >> 12);
+			if (distanceToWrite < 0)
+				distanceToWrite += BUFF_LENGTH_SAMPLES;
 
-		// Linear interpolation between table entries
-		int32_t w0 = hannWindowTable_[tablePos];
-		int32_t w1 = (tablePos < HANN_TABLE_SIZE - 1) ? hannWindowTable_[tablePos + 1] : hannWindowTable_[tablePos];
-		int32_t weight = w0 + (((w1 - w0) * tableFrac) >> 12);
+			// If grain is too close to write head, clamp it to safe position
+			if (distanceToWrite < SAFETY_MARGIN_SAMPLES)
+			{
+				int32_t maxSafePos = ctx.writeHead - SAFETY_MARGIN_SAMPLES;
+				if (maxSafePos < 0)
+					maxSafePos += BUFF_LENGTH_SAMPLES;
+				pos = maxSafePos << 12; // Fractional part reset when clamped
+			}
+		}
+		pool.pos[i] = pos;
+
+		// Check if grain has reached completion threshold
+		if (!grain.pulse90Triggered && pool.count[i] >= grain.completionCount)
+		{
+			grain.pulse90Triggered = true; // Mark as triggered for this grain
+			events |= GRAIN_COMPLETED;
+		}
 
-		// Ensure weight is never negative (should not happen with proper Hann window)
-		if (weight < 0)
-			weight = 0;
+		if (pool.count[i] >= grain.grainSize)
+			events |= GRAIN_FINISHED;
 
-		return weight;
+		return events;
 	}
 
-	int16_t __not_in_flash_func(generateStretchedSample)(int channel)
+	// Advance kernel for a looping grain: in loop mode, grains loop within their original captured segment,
+	// advancing through it and looping back to the start when finished (repeating stutters of the segment).
+	// They never deactivate automatically
+	static int __not_in_flash_func(advanceLoopingGrain)(Sheep &sheep, GrainPool &pool, int i, const GrainContext &ctx)
 	{
-		int32_t mixedSample = 0;
-		int32_t totalWeight = 0;
+		GrainParams &grain = pool.params[i];
+
+		int32_t grainSpeed = sheep.calculateLoopingGrainSpeed(pool, pool.speed[i], grain.baselineControlValue, ctx); // Use original speed with scaled offset from baseline
 
-		// Mix all active grains
-		for (int i = 0; i < maxActiveGrains_; i++)
+		if (grainSpeed != 0)
 		{
-			if (grains_[i].active)
-			{
-				// Get interpolated sample from buffer with wraparound
-				int16_t grainSample = getInterpolatedSample(grains_[i].readPos, grains_[i].readFrac, channel);
-				int32_t weight = calculateGrainWeight(i);
+			pool.count[i]++;
+			pool.window[i] += pool.windowInc[i];
 
-				mixedSample += (grainSample * weight) >> 12; // Q12 format
-				totalWeight += weight;
+			// Advance read position, in both directions (the speed can change sign while looping)
+			pool.pos[i] = sheep.wrapPosition(pool.pos[i] + grainSpeed);
+
+			// Loop back to start when grain reaches its end
+			// This creates the stuttering loop effect
+			if (pool.count[i] >= grain.grainSize)
+			{
+				// Reset to beginning of grain segment for looping
+				pool.pos[i] = grain.startPos;
+				pool.count[i] = 0;
+				pool.window[i] = 0;
+				grain.pulse90Triggered = false; // Reset pulse trigger for next loop iteration
+#ifdef PSRAM_MODE
+				sheep.prefetchGrain(pool, i);
+#endif
 			}
 		}
 
+		return 0;
+	}
+
+	// Set up this core's interpolators for windowWeight:
+	// INTERP1 lane 0 turns a window phase into the address of its table entry (top 8 bits, int32_t entries),
+	// and INTERP0 in blend mode interpolates between that entry and the next with the following 8 bits
+	void configureWindowInterp()
+	{
+		interp_config addr = interp_default_config();
+		interp_config_set_shift(&addr, 32 - 8 - 2);
+		interp_config_set_mask(&addr, 2, 9);
+		interp_set_config(interp1, 0, &addr);
+
+		interp_config blend = interp_default_config();
+		interp_config_set_blend(&blend, true);
+		interp_set_config(interp0, 0, &blend);
+		blend = interp_default_config();
+		interp_config_set_signed(&blend, true);
+		interp_config_set_shift(&blend, 32 - 16);
+		interp_config_set_mask(&blend, 0, 7);
+		interp_set_config(interp0, 1, &blend);
+	}
+
+	// Window table value at a 32-bit phase, linearly interpolated
+	int32_t __not_in_flash_func(windowWeight)(const int32_t *table, uint32_t phase)
+	{
+		interp1->base[0] = (uintptr_t)table;
+		interp1->accum[0] = phase;
+		const int32_t *w = (const int32_t *)(uintptr_t)interp1->peek[0];
+		interp0->base[0] = w[0];
+		interp0->base[1] = w[1]; // guard point makes w[1] valid at the last entry
+		interp0->accum[1] = phase;
+		return (int32_t)interp0->peek[1];
+	}
+
+	// Weighted sum of all of a pool's active grains, reading both channels of each in one pass
+	void __not_in_flash_func(mixGrains)(const GrainPool &pool, int32_t otherActive, int32_t &mixedL, int32_t &mixedR, int32_t &totalWeight)
+	{
+		int32_t totalActive = pool.numActive + otherActive;
+		GrainMix mix = {mixedL, mixedR, totalWeight};
+		for (int k = 0; k < pool.numActive; k++)
+		{
+			int i = pool.order[k];
+			pool.read[i](*this, pool, i, totalActive, mix);
+		}
+		mixedL = mix.left;
+		mixedR = mix.right;
+		totalWeight = mix.weight;
+	}
+
+	void __not_in_flash_func(generateStretchedSamples)(int16_t &outL, int16_t &outR)
+	{
+		int32_t mixedL = 0, mixedR = 0;
+		int32_t totalWeight = 0;
+
+#ifdef DUAL_CORE
+		mixGrains(pools_[0], core1Active_, mixedL, mixedR, totalWeight);
+
+		// Add core1's share, rendered during the previous block
+		if (core1BlockValid_)
+		{
+			const Core1Sample &c1 = core1Out_[blockNumber_ & 1][blockSample_];
+			mixedL += c1.mixL;
+			mixedR += c1.mixR;
+			totalWeight += c1.weight;
+		}
+#else
+		mixGrains(pools_[0], 0, mixedL, mixedR, totalWeight);
+#endif
+
 		// Handle output normalization with division by zero protection
 		if (totalWeight > 0)
 		{
 			// Always normalize by total weight for consistent granular processing
-			int32_t result = (mixedSample << 12) / totalWeight;
-
-			// Clamp to prevent overflow
-			if (result > 2047)
-				result = 2047;
-			if (result < -2048)
-				result = -2048;
-
-			return (int16_t)result;
+			outL = clipAudio((mixedL << 12) / totalWeight);
+			outR = clipAudio((mixedR << 12) / totalWeight);
 		}
 		else
 		{
 			// No active grains or zero total weight - return silence
-			return 0;
+			outL = 0;
+			outR = 0;
+		}
+	}
+
+	// Active grains in all pools, counting those still on their way to core1
+	int32_t __not_in_flash_func(totalActiveGrains)()
+	{
+#ifdef DUAL_CORE
+		return pools_[0].numActive + core1Active_ + (int32_t)(core1TriggerWrite_ - core1TriggerRead_);
+#else
+		return pools_[0].numActive;
+#endif
+	}
+
+	// Stop the grain at position k of the pool's active list; the last active grain takes its place
+	void __not_in_flash_func(deactivateGrain)(GrainPool &pool, int k)
+	{
+		uint8_t slot = pool.order[k];
+		pool.order[k] = pool.order[--pool.numActive];
+		pool.order[pool.numActive] = slot;
+	}
+
+	// Advance all of a pool's active grains by one sample
+	// Returns the number of grains that reached their completion threshold (see grainCompleted)
+	int32_t __not_in_flash_func(updatePool)(GrainPool &pool, const GrainContext &ctx)
+	{
+		int32_t completions = 0;
+
+		// Walk the list backwards, so that a grain removed from it (replaced by the last one, already
+		// updated) doesn't change which grains are still to be visited
+		for (int k = pool.numActive - 1; k >= 0; k--)
+		{
+			int i = pool.order[k];
+			int events = pool.advance[i](*this, pool, i, ctx);
+
+			if (events & GRAIN_COMPLETED)
+				completions++;
+
+			// Deactivate grain if it's finished
+			if (events & GRAIN_FINISHED)
+				deactivateGrain(pool, k);
 		}
+
+		return completions;
+	}
+
+	// A grain reached its completion threshold: trigger Pulse 1
+	// (when unclocked, the next grain was already scheduled for this sample, see scheduleOnset)
+	void __not_in_flash_func(grainCompleted)()
+	{
+		// Trigger pulse output only if counter is ready (maintains 100-sample pulse width)
+		if (pulseOut1Counter_ <= 0)
+		{
+			pulseOut1Counter_ = GRAIN_END_PULSE_DURATION; // 100 samples
+		}
+	}
+
+	// Samples from a grain's start to its completion threshold, for a grain starting now
+	int32_t __not_in_flash_func(completionSamples)()
+	{
+		// Clocked mode: fixed 90% threshold for pulse output timing
+		// Unclocked mode: Y knob-controlled threshold for overlap behavior
+		int32_t thresholdPercent = Connected(Input::Pulse1) ? GRAIN_COMPLETION_THRESHOLD_PERCENT : calculateUnclockTriggerThreshold();
+		return (grainSize_ * thresholdPercent) / 100;
+	}
+
+	// Unclocked grains trigger each other: every grain schedules the start of the next, once, when
+	// it is triggered, so that finding the next onset costs one compare per sample. The next grain
+	// starts when this one reaches its completion threshold (interval samples), or with
+	// SHEEP_STOCHASTIC_ONSETS, after a random interval drawn from an exponential distribution with
+	// that mean, for Poisson-distributed onsets at the same average density
+	void __not_in_flash_func(scheduleOnset)(int32_t interval)
+	{
+#if SHEEP_STOCHASTIC_ONSETS
+		interval = (interval * onsetTable_[rnd12() >> 4]) >> 12;
+#endif
+		if (interval < 1)
+			interval = 1;
+		nextOnset_ = (int32_t)((uint32_t)globalSampleCounter_ + (uint32_t)interval);
+		onsetPending_ = true;
+	}
+
+	// An unclocked onset is due: start a grain, if Pulse 2 (when connected) is high
+	void __not_in_flash_func(unclockedOnset)()
+	{
+		onsetPending_ = false;
+		if (!Connected(Input::Pulse2) || PulseIn2())
+		{
+			triggerNewGrain(); // Schedules the following onset
+		}
+#if SHEEP_STOCHASTIC_ONSETS
+		// A skipped onset (gated, or no free grain) doesn't stop the stream of onsets
+		if (!onsetPending_ && !loopMode_)
+		{
+			scheduleOnset(completionSamples());
+		}
+#endif
+	}
+
+	// Values shared by every grain for one sample, as seen from core0 at write head position writeHead
+	GrainContext __not_in_flash_func(makeGrainContext)(int32_t writeHead, int32_t otherActive)
+	{
+		GrainContext ctx;
+		ctx.writeHead = writeHead;
+		ctx.otherActive = otherActive;
+
+		ctx.loopingControlValue = loopMode_ ? currentPitchControlValue() : 0;
+		ctx.bufferIsFrozen = (SwitchVal() == Switch::Up);
+		ctx.cv2Connected = Connected(Input::CV2);
+		return ctx;
 	}
 
 	void __not_in_flash_func(updateGrains)()
 	{
-		// Update all active grains
-		for (int i = 0; i < MAX_GRAINS; i++)
+#ifdef DUAL_CORE
+		GrainContext ctx = makeGrainContext(writeHead_, core1Active_);
+#else
+		GrainContext ctx = makeGrainContext(writeHead_, 0);
+#endif
+		// Completions are handled after the pool has been updated, so auto-triggered grains
+		// are first advanced on the next sample
+		int32_t completions = updatePool(pools_[0], ctx);
+
+#ifdef DUAL_CORE
+		if (core1BlockValid_)
 		{
-			if (grains_[i].active)
-			{
-				// Get grain playback speed from this grain's stored speed
-				int32_t grainSpeed = grains_[i].grainSpeed;
+			completions += core1Out_[blockNumber_ & 1][blockSample_].completions;
+		}
+#endif
 
-				// Handle looping grains differently
-				if (grains_[i].looping)
-				{
-					// In loop mode, grains loop within their original captured segment
-					// They advance through their grain but loop back to the start when finished
-					// This creates repeating stutters of the captured audio segment
-
-					grainSpeed = calculateLoopingGrainSpeed(grains_[i].grainSpeed, grains_[i].baselineControlValue); // Use original speed with scaled offset from baseline
-
-					if (grainSpeed != 0)
-					{
-						// Increment sample count for windowing calculation
-						grains_[i].sampleCount++;
-
-						// Advance read position with fractional tracking
-						grains_[i].readFrac += grainSpeed;
-
-						// Handle integer overflow from fractional part
-						while (grains_[i].readFrac >= 4096)
-						{ // >= 1.0 in Q12
-							grains_[i].readPos++;
-							grains_[i].readFrac -= 4096;
-						}
-
-						// Handle negative speeds (reverse looping)
-						while (grains_[i].readFrac < 0)
-						{
-							grains_[i].readPos--;
-							grains_[i].readFrac += 4096;
-						}
-						// Loop back to start when grain reaches its end
-						// This creates the stuttering loop effect
-						if (grains_[i].sampleCount >= grains_[i].grainSize)
-						{
-							// Reset to beginning of grain segment for looping
-							grains_[i].readPos = grains_[i].startPos;
-							grains_[i].readFrac = 0;
-							grains_[i].sampleCount = 0;
-							grains_[i].pulse90Triggered = false; // Reset pulse trigger for next loop iteration
-						}
-
-						// Handle buffer wraparound for readPos - more efficient than while loops
-						if (grains_[i].readPos >= BUFF_LENGTH_SAMPLES)
-						{
-							grains_[i].readPos %= BUFF_LENGTH_SAMPLES;
-						}
-						if (grains_[i].readPos < 0)
-						{
-							grains_[i].readPos = ((grains_[i].readPos % BUFF_LENGTH_SAMPLES) + BUFF_LENGTH_SAMPLES) % BUFF_LENGTH_SAMPLES;
-						}
-					}
-
-					// Looping grains never deactivate automatically
-				}
-				else
-				{
-					// Normal grain behavior
-					grains_[i].sampleCount++;
-
-					// Store original position for boundary checking
-					int32_t originalPos = grains_[i].readPos;
-					int32_t originalFrac = grains_[i].readFrac;
-
-					// Advance read position with fractional tracking
-					grains_[i].readFrac += grainSpeed;
-
-					// CRASH PROTECTION: Bounded iteration limits to prevent runaway loops
-					int32_t iterationCount = 0;
-
-					// Handle integer overflow from fractional part with bounded iterations
-					while (grains_[i].readFrac >= 4096 && iterationCount < MAX_FRACTIONAL_ITERATIONS)
-					{
-						grains_[i].readPos++;
-						grains_[i].readFrac -= 4096;
-						iterationCount++;
-
-						// Handle buffer wraparound
-						if (grains_[i].readPos >= BUFF_LENGTH_SAMPLES)
-						{
-							grains_[i].readPos -= BUFF_LENGTH_SAMPLES;
-						}
-					}
-
-					// If we hit the iteration limit, clamp the fractional part
-					if (grains_[i].readFrac >= 4096)
-					{
-						grains_[i].readFrac = 4095; // Clamp to just under 1.0
-					}
-
-					// Reset iteration counter for negative speed handling
-					iterationCount = 0;
-
-					// Handle negative speeds (reverse playback) with bounded iterations
-					while (grains_[i].readFrac < 0 && iterationCount < MAX_FRACTIONAL_ITERATIONS)
-					{
-						grains_[i].readPos--;
-						grains_[i].readFrac += 4096;
-						iterationCount++;
-
-						// Handle buffer wraparound
-						if (grains_[i].readPos < 0)
-						{
-							grains_[i].readPos += BUFF_LENGTH_SAMPLES;
-						}
-					}
-
-					// If we hit the iteration limit, clamp the fractional part
-					if (grains_[i].readFrac < 0)
-					{
-						grains_[i].readFrac = 0; // Clamp to 0
-					}
-
-					// WRITE HEAD BOUNDARY CHECK: Prevent grains from reading past write head
-					// Only apply this check when buffer is recording (not frozen)
-					bool bufferIsFrozen = (SwitchVal() == Switch::Up);
-					if (!bufferIsFrozen)
-					{
-						const int32_t safetyMargin = SAFETY_MARGIN_SAMPLES;
-						int32_t maxSafePos = writeHead_ - safetyMargin;
-						if (maxSafePos < 0)
-							maxSafePos += BUFF_LENGTH_SAMPLES;
-
-						// Calculate distance from grain to write head (accounting for circular buffer)
-						int32_t distanceToWrite = writeHead_ - grains_[i].readPos;
-						if (distanceToWrite < 0)
-							distanceToWrite += BUFF_LENGTH_SAMPLES;
-
-						// If grain is too close to write head, clamp it to safe position
-						if (distanceToWrite < safetyMargin)
-						{
-							grains_[i].readPos = maxSafePos;
-							grains_[i].readFrac = 0; // Reset fractional part when clamped
-						}
-					}
-
-					// Check if grain has reached completion threshold and trigger Pulse 1
-					if (grains_[i].grainSize > 0 && !grains_[i].pulse90Triggered)
-					{
-						// Use different thresholds for clocked vs unclocked modes
-						int32_t thresholdPercent;
-						if (Connected(Input::Pulse1))
-						{
-							// Clocked mode: use fixed 90% threshold for pulse output timing
-							thresholdPercent = GRAIN_COMPLETION_THRESHOLD_PERCENT;
-						}
-						else
-						{
-							// Unclocked mode: use Y knob-controlled threshold for overlap behavior
-							thresholdPercent = calculateUnclockTriggerThreshold();
-						}
-
-						int32_t thresholdSamples = (grains_[i].grainSize * thresholdPercent) / 100;
-						if (grains_[i].sampleCount >= thresholdSamples)
-						{
-							grains_[i].pulse90Triggered = true; // Mark as triggered for this grain
-							
-							// Trigger pulse output only if counter is ready (maintains 100-sample pulse width)
-							if (pulseOut1Counter_ <= 0)
-							{
-								pulseOut1Counter_ = GRAIN_END_PULSE_DURATION; // 100 samples
-							}
-							
-							// Auto-trigger new grain regardless of pulse counter state (allows faster triggering)
-							if (!Connected(Input::Pulse1))
-							{
-								if (Connected(Input::Pulse2))
-								{
-									// PulseIn2 is plugged in: only fire if high
-									if (PulseIn2())
-									{
-										triggerNewGrain();
-									}
-								}
-								else
-								{
-									// Neither pulse input is plugged in: always fire with Y knob-controlled timing
-									triggerNewGrain();
-								}
-							}
-						}
-					}
-
-					// Deactivate grain if it's finished
-					if (grains_[i].sampleCount >= grains_[i].grainSize)
-					{
-						grains_[i].active = false;
-						cachedActiveGrainCount_--; // Update cached count when grain is deactivated
-					}
-				}
-			}
+		for (; completions > 0; completions--)
+		{
+			grainCompleted();
 		}
 	}
 
-	// Update pulse outputs
-	void __not_in_flash_func(updatePulseOutputs)()
+#ifdef DUAL_CORE
+	// Core0, once per sample before any grain processing: step through the block, and at the start
+	// of each block ask core1 for the next one (if it has finished the last)
+	void __not_in_flash_func(syncCore1)()
+	{
+		if (++blockSample_ < CORE1_BLOCK)
+		{
+			return;
+		}
+		blockSample_ = 0;
+		blockNumber_++;
+
+		uint32_t rendered = core1Rendered_;
+		core1BlockValid_ = (rendered == blockNumber_);
+
+		// If core1 overran, leave it to finish; its grains are silent until it catches up
+		if (rendered != core1Requested_)
+		{
+			return;
+		}
+
+		// Next block starts CORE1_BLOCK samples from now
+		int32_t writeHead = writeHead_ + CORE1_BLOCK;
+		if (writeHead >= BUFF_LENGTH_SAMPLES)
+			writeHead -= BUFF_LENGTH_SAMPLES;
+		core1Context_ = makeGrainContext(writeHead, pools_[0].numActive);
+		core1TriggerEnd_ = core1TriggerWrite_;
+		core1LoopMode_ = loopMode_;
+		core1LoopBaseline_ = loopBaseline_;
+
+		__dmb(); // Publish the request only once it is complete
+		core1Requested_ = blockNumber_ + 1;
+	}
+
+	// Core1: render one block of pool 1 into core1Out_
+	void __not_in_flash_func(renderCore1Block)(uint32_t block)
+	{
+		GrainPool &pool = pools_[1];
+
+		// Start grains triggered before the request, so that a loop mode change in the
+		// same request applies to them
+		uint32_t end = core1TriggerEnd_;
+		while (core1TriggerRead_ != end)
+		{
+			startGrain(pool, core1Triggers_[core1TriggerRead_ & (TRIGGER_FIFO - 1)]);
+			core1Active_ = pool.numActive;
+			core1TriggerRead_ = core1TriggerRead_ + 1;
+		}
+
+		if (core1LoopMode_ != pool.loopMode)
+		{
+			setLooping(pool, core1LoopMode_, core1LoopBaseline_);
+		}
+
+		GrainContext ctx = core1Context_;
+		Core1Sample *out = core1Out_[block & 1];
+#ifdef PSRAM_MODE
+		static_assert(CORE1_BLOCK <= CACHE_BLOCK, "core1 blocks must not outrun the grain caches");
+		prefetchPool(pool, ctx.writeHead);
+#endif
+		for (int j = 0; j < CORE1_BLOCK; j++)
+		{
+			out[j].mixL = 0;
+			out[j].mixR = 0;
+			out[j].weight = 0;
+			mixGrains(pool, ctx.otherActive, out[j].mixL, out[j].mixR, out[j].weight);
+			out[j].completions = updatePool(pool, ctx);
+
+			if (++ctx.writeHead >= BUFF_LENGTH_SAMPLES)
+				ctx.writeHead = 0;
+		}
+
+		core1Active_ = pool.numActive;
+	}
+#endif
+
+	// Update stochastic clock period based on grain size, when the knobs are read
+	void __not_in_flash_func(updateStochasticClockPeriod)()
 	{
-		// Update stochastic clock period based on grain size
 		// Wider range than grain size: 240 samples (10ms) to 4800 samples (200ms) at 24kHz
 		// Direct relationship: smaller grains = faster clock (shorter period), larger grains = slower clock (longer period)
 		int32_t normalizedY = cachedYKnob_; // 0 to 4095
-		int32_t maxPeriod = 4800;			// 200ms at 24kHz
-		int32_t minPeriod = 240;			// 10ms at 24kHz
+		int32_t maxPeriod = 4800 * RATE_SCALE; // 200ms
+		int32_t minPeriod = 240 * RATE_SCALE;  // 10ms
 		// Inverse mapping: higher Y knob = shorter period
 		stochasticClockPeriod_ = maxPeriod - ((normalizedY * (maxPeriod - minPeriod)) / 4095);
 		// Removed conservative clamping for performance - calculation should always be in range
+	}
 
+	// Update pulse outputs
+	void __not_in_flash_func(updatePulseOutputs)()
+	{
 		// Update stochastic clock counter
 		stochasticClockCounter_++;
 
@@ -1342,58 +1778,19 @@ private:
 		loopMode_ = true;
 
 		// Calculate current control value to use as baseline for all grains entering loop mode
-		int32_t currentControlValue;
-		if (Connected(Input::CV2))
-		{
-			int32_t cv2Val = CVIn2();
-			int32_t mainKnobVal = virtualDetentedKnob(cachedMainKnob_);
-			currentControlValue = applyPitchAttenuverter(cv2Val, mainKnobVal);
-		}
-		else
-		{
-			int32_t mainKnobVal = pitchDetentedKnob(cachedMainKnob_);
-			if (mainKnobVal <= 2048)
-			{
-				currentControlValue = -8192 + ((mainKnobVal * 8192) >> 11);
-			}
-			else
-			{
-				int32_t rightKnob = mainKnobVal - 2048;
-				currentControlValue = (rightKnob * 8192) >> 11;
-			}
-		}
-
-		// Check if any grains are currently active
-		bool hasActiveGrains = false;
-		for (int i = 0; i < MAX_GRAINS; i++)
-		{
-			if (grains_[i].active)
-			{
-				hasActiveGrains = true;
-				grains_[i].looping = true;
-				grains_[i].baselineControlValue = currentControlValue; // Capture baseline when entering loop mode
-				// Use the grain's stored loop size (set when grain was created)
-				// This prevents race condition where grainSize_ changes after grain creation
-				// Keep current sampleCount for smooth transition to loop mode
-			}
-		}
+		loopBaseline_ = currentPitchControlValue();
 
 		// If no grains are active, trigger one grain to ensure we have something to loop
-		if (!hasActiveGrains)
+		if (totalActiveGrains() == 0)
 		{
 			triggerNewGrain();
-			// Now convert the newly triggered grain to looping mode
-			for (int i = 0; i < MAX_GRAINS; i++)
-			{
-				if (grains_[i].active && !grains_[i].looping)
-				{
-					grains_[i].looping = true;
-					grains_[i].baselineControlValue = currentControlValue; // Capture baseline for new grain
-					// Keep initial sampleCount for proper windowing
-					break; // Only need to convert the first one we find
-				}
-			}
 		}
+
+		// Looping grains don't complete, so no new grains are started until loop mode ends
+		onsetPending_ = false;
+
+		// Core1 applies loop mode to its own pool at the next block request
+		setLooping(pools_[0], true, loopBaseline_);
 	}
 
 	void __not_in_flash_func(exitLoopMode)()
@@ -1401,14 +1798,30 @@ private:
 		loopMode_ = false;
 
 		// Convert all looping grains back to normal mode
-		for (int i = 0; i < MAX_GRAINS; i++)
+		setLooping(pools_[0], false, 0);
+
+		// Start the unclocked chain of grains again straight away
+		nextOnset_ = globalSampleCounter_;
+		onsetPending_ = true;
+	}
+
+	// Enter or leave loop mode for all of a pool's active grains
+	void __not_in_flash_func(setLooping)(GrainPool &pool, bool looping, int32_t baselineControlValue)
+	{
+		pool.loopMode = looping;
+		for (int k = 0; k < pool.numActive; k++)
 		{
-			if (grains_[i].active && grains_[i].looping)
+			int i = pool.order[k];
+			GrainParams &grain = pool.params[i];
+			grain.looping = looping;
+			if (looping)
 			{
-				grains_[i].looping = false;
-				grains_[i].loopSize = 0;
-				// Keep current sample count for smooth transition from loop mode
+				grain.baselineControlValue = baselineControlValue; // Capture baseline when entering loop mode
+				// Use the grain's stored size (set when grain was created)
+				// This prevents race condition where grainSize_ changes after grain creation
 			}
+			// Keep current sample count for smooth transition into and out of loop mode
+			selectKernels(pool, i);
 		}
 	}
 
@@ -1456,7 +1869,84 @@ private:
 		return lcg_seed >> 20;
 	}
 
-#ifdef LOFI_MODE
+#if defined(PSRAM_MODE)
+	// 16-bit audio functions for PSRAM mode - pack into 32-bit storage
+	// Samples are kept whole, with room to spare above the 12-bit processing range
+	uint32_t __not_in_flash_func(packStereo)(int16_t left, int16_t right)
+	{
+		return ((uint32_t)(uint16_t)left << 16) | (uint16_t)right;
+	}
+
+	// Linear interpolation (Q12 frac) of both channels between two frames. Samples only span
+	// 12 bits, so with the sign bits flipped (offset binary), the two channels' differences
+	// plus 4096 are taken in one subtraction, without either borrowing from the other
+	void __not_in_flash_func(interpolateStereo)(uint32_t frame1, uint32_t frame2, int32_t frac, int32_t &left, int32_t &right)
+	{
+		frame1 ^= 0x80008000u;
+		frame2 ^= 0x80008000u;
+		uint32_t diff = frame2 + 0x10001000u - frame1;
+		int32_t bias = 32768 + frac; // the offset, and the differences' 4096 after scaling by frac
+		left = (int32_t)(frame1 >> 16) + (((int32_t)(diff >> 16) * frac) >> 12) - bias;
+		right = (int32_t)(frame1 & 0xFFFF) + (((int32_t)(diff & 0xFFFF) * frac) >> 12) - bias;
+	}
+#elif defined(MULAW_MODE)
+	// 8-bit mu-law (G.711) audio functions for Mulaw mode - pack into 16-bit storage
+	// Companding keeps roughly 12-bit resolution for quiet signals, so grains read back long
+	// quiet tails and reverbs much more cleanly than Lofi's linear 8 bits. Every sample is still
+	// stored on its own, so grains can start anywhere and play in either direction.
+	int16_t mulawDecode_[256]; // 8-bit code -> 12-bit signed sample, calculated at startup
+
+	void initMulaw()
+	{
+		for (int code = 0; code < 256; code++)
+		{
+			int32_t u = ~code & 0xFF;
+			int32_t exponent = (u >> 4) & 0x07;
+			int32_t mantissa = u & 0x0F;
+			int32_t magnitude = (((mantissa << 3) + 0x84) << exponent) - 0x84; // 16-bit scale
+			int32_t value = (u & 0x80) ? -magnitude : magnitude;
+			mulawDecode_[code] = (int16_t)(value >> 4); // 16-bit -> 12-bit, rounding down
+		}
+	}
+
+	// 12-bit signed sample -> 8-bit mu-law code
+	uint8_t __not_in_flash_func(mulawEncode)(int16_t sample)
+	{
+		int32_t s = (int32_t)sample << 4; // 12-bit -> 16-bit scale
+		uint32_t sign = 0;
+		if (s < 0)
+		{
+			s = -s;
+			sign = 0x80;
+		}
+		if (s > 32635)
+			s = 32635;
+		s += 0x84; // bias, so the top set bit gives the segment directly
+
+		int32_t exponent = (31 - __builtin_clz((uint32_t)s)) - 7; // 0 to 7
+		int32_t mantissa = (s >> (exponent + 3)) & 0x0F;
+		return (uint8_t)~(sign | (exponent << 4) | mantissa);
+	}
+
+	uint16_t __not_in_flash_func(packStereo)(int16_t left, int16_t right)
+	{
+		return (mulawEncode(left) << 8) | mulawEncode(right);
+	}
+
+	int16_t __not_in_flash_func(unpackStereo)(uint16_t stereo, int8_t index)
+	{
+		return mulawDecode_[(index == 0) ? (stereo >> 8) : (stereo & 0xFF)];
+	}
+
+	// Linear interpolation (Q12 frac) of both channels between two frames, each decoded by table
+	void __not_in_flash_func(interpolateStereo)(uint16_t frame1, uint16_t frame2, int32_t frac, int32_t &left, int32_t &right)
+	{
+		int32_t left1 = unpackStereo(frame1, 0);
+		int32_t right1 = unpackStereo(frame1, 1);
+		left = left1 + (((unpackStereo(frame2, 0) - left1) * frac) >> 12);
+		right = right1 + (((unpackStereo(frame2, 1) - right1) * frac) >> 12);
+	}
+#elif defined(LOFI_MODE)
 	// 8-bit conversion helper functions
 
 // 8-bit audio functions for LoFi mode - pack into 16-bit storage
@@ -1468,41 +1958,39 @@ uint16_t packStereo(int16_t left, int16_t right)
 	return (static_cast<uint8_t>(left8) << 8) | static_cast<uint8_t>(right8);
 }
 
-int16_t unpackStereo(uint16_t stereo, int8_t index)
+// Linear interpolation of both channels between two frames, with one multiply: the 8-bit
+// samples are spread 16 bits apart as offset binary, so each channel's difference plus 256
+// (1 to 511) times frac rounded to 0-128 stays within its 16 bits. frac's resolution of 1/128
+// is finer than the 8-bit samples' own, and results are within one 8-bit step of Q12's.
+void __not_in_flash_func(interpolateStereo)(uint16_t frame1, uint16_t frame2, int32_t frac, int32_t &left, int32_t &right)
 {
-	// unpack a 16 bit word into two signed 8 bit values and convert to signed 12 bit values (returning one of them based on index)
-	if (index == 0)
-	{
-		int8_t left8 = (stereo >> 8) & 0xFF;
-		return static_cast<int16_t>(left8) << 4;
-	}
-	else
-	{
-		int8_t right8 = stereo & 0xFF;
-		return static_cast<int16_t>(right8) << 4;
-	}
+	uint32_t a = ((frame1 & 0xFF) | ((uint32_t)(frame1 & 0xFF00) << 8)) ^ 0x00800080u;
+	uint32_t b = ((frame2 & 0xFF) | ((uint32_t)(frame2 & 0xFF00) << 8)) ^ 0x00800080u;
+	int32_t f = (frac + 16) >> 5;
+	uint32_t product = (b + 0x01000100u - a) * (uint32_t)f;
+	// Scaled to 12 bits: product >> 3 per channel, less the offset and the differences' 256 times f
+	int32_t bias = 2048 + (f << 5);
+	left = ((int32_t)(a >> 16) << 4) + (int32_t)(product >> 19) - bias;
+	right = ((int32_t)(a & 0xFFFF) << 4) + (int32_t)((product & 0xFFFF) >> 3) - bias;
 }
 #else
 	// 12-bit audio functions for HiFi mode - pack into 32-bit storage
 	uint32_t packStereo(int16_t left, int16_t right)
 	{
-		// Pack two 12-bit signed values into lower 24 bits of uint32_t
-		uint32_t leftBits = (left + 2048) & 0xFFF;   // Convert to 12-bit unsigned
-		uint32_t rightBits = (right + 2048) & 0xFFF; // Convert to 12-bit unsigned
-		return (leftBits << 12) | rightBits;
+		// Two 12-bit unsigned (offset binary) values, 16 bits apart: left in bits 16-27, right in bits 0-11.
+		// Inputs are already clipped to 12 bits, so need no masking
+		return ((uint32_t)(left + 2048) << 16) | (uint32_t)(right + 2048);
 	}
 
-	int16_t unpackStereo(uint32_t stereo, int8_t index)
+	// Linear interpolation (Q12 frac) of both channels between two frames. The four spare bits
+	// above each channel let the two channels' differences plus 4096 (1 to 8191) be taken in one
+	// subtraction, without either borrowing from the other
+	void __not_in_flash_func(interpolateStereo)(uint32_t frame1, uint32_t frame2, int32_t frac, int32_t &left, int32_t &right)
 	{
-		if (index == 0) {
-			// Left channel: upper 12 bits
-			uint32_t leftBits = (stereo >> 12) & 0xFFF;
-			return (int16_t)(leftBits - 2048);  // Convert back to signed
-		} else {
-			// Right channel: lower 12 bits
-			uint32_t rightBits = stereo & 0xFFF;
-			return (int16_t)(rightBits - 2048);  // Convert back to signed
-		}
+		uint32_t diff = frame2 + 0x10001000u - frame1;
+		int32_t bias = 2048 + frac; // the offset, and the differences' 4096 after scaling by frac
+		left = (int32_t)(frame1 >> 16) + (((int32_t)(diff >> 16) * frac) >> 12) - bias;
+		right = (int32_t)(frame1 & 0xFFFF) + (((int32_t)(diff & 0xFFFF) * frac) >> 12) - bias;
 	}
 #endif
 
@@ -1529,10 +2017,23 @@ int16_t unpackStereo(uint16_t stereo, int8_t index)
 		cachedYKnob_ = KnobVal(Y);
 	}
 };
+#ifdef DUAL_CORE
+Sheep *Sheep::core1Card_;
+#endif
+
 int main()
 {
 	set_sys_clock_khz(200000, true);
+#ifdef PSRAM_MODE
+	// The circular buffer is in PSRAM; without it there is nothing to record into
+	if (!psramInit())
+	{
+		while (true)
+			tight_loop_contents();
+	}
+#endif
 	Sheep card;
 	card.EnableNormalisationProbe();
+	card.EnableMuxCorrection();
 	card.Run();
 }
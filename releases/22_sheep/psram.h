@@ -0,0 +1,127 @@
+/*
+ * PSRAM setup for the Sheep PSRAM build (RP2350 only)
+ *
+ * Brings up an APS6404-style QSPI PSRAM on the second chip select of the RP2350's QMI, in QPI mode,
+ * and makes it writable through XIP, so that it appears as ordinary (XIP-cached) memory at
+ * SHEEP_PSRAM_BASE. Must be called after the system clock has been set, since the PSRAM timing
+ * is worked out from it.
+ */
+
+#ifndef SHEEP_PSRAM_H
+#define SHEEP_PSRAM_H
+
+#include "hardware/address_mapped.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/structs/qmi.h"
+#include "hardware/structs/xip_ctrl.h"
+#include "hardware/sync.h"
+
+// Board-specific chip select for the PSRAM - controlled by build system
+#ifndef SHEEP_PSRAM_CS_PIN
+	#define SHEEP_PSRAM_CS_PIN 47
+#endif
+
+// Cached XIP window of QMI chip select 1
+#define SHEEP_PSRAM_BASE (XIP_BASE + 0x01000000)
+
+// Direct mode transfer of one byte on chip select 1, returning the byte read at the same time
+static inline uint8_t __not_in_flash_func(psramDirectTransfer)(uint32_t tx)
+{
+	qmi_hw->direct_tx = tx;
+	while ((qmi_hw->direct_csr & QMI_DIRECT_CSR_TXEMPTY_BITS) == 0)
+		;
+	while (qmi_hw->direct_csr & QMI_DIRECT_CSR_BUSY_BITS)
+		;
+	return (uint8_t)qmi_hw->direct_rx;
+}
+
+// Detect and set up the PSRAM; returns false if there is none.
+// Runs from RAM with interrupts off: while QMI direct mode is enabled, XIP accesses to flash stall
+static bool __no_inline_not_in_flash_func(psramInit)()
+{
+	gpio_set_function(SHEEP_PSRAM_CS_PIN, GPIO_FUNC_XIP_CS1);
+
+	uint32_t irq = save_and_disable_interrupts();
+
+	// Direct mode at a slow clock for the setup commands
+	qmi_hw->direct_csr = 30 << QMI_DIRECT_CSR_CLKDIV_LSB | QMI_DIRECT_CSR_EN_BITS;
+	while (qmi_hw->direct_csr & QMI_DIRECT_CSR_BUSY_BITS)
+		;
+
+	// Leave QPI mode, in case this isn't the first time since power-up
+	qmi_hw->direct_csr |= QMI_DIRECT_CSR_ASSERT_CS1N_BITS;
+	psramDirectTransfer(QMI_DIRECT_TX_OE_BITS | QMI_DIRECT_TX_IWIDTH_VALUE_Q << QMI_DIRECT_TX_IWIDTH_LSB | 0xF5);
+	qmi_hw->direct_csr &= ~QMI_DIRECT_CSR_ASSERT_CS1N_BITS;
+
+	// Read ID: command, three address bytes, then manufacturer ID and known-good-die byte
+	qmi_hw->direct_csr |= QMI_DIRECT_CSR_ASSERT_CS1N_BITS;
+	uint8_t kgd = 0;
+	for (int i = 0; i < 6; i++)
+	{
+		uint8_t rx = psramDirectTransfer((i == 0) ? 0x9F : 0xFF);
+		if (i == 5)
+			kgd = rx;
+	}
+	qmi_hw->direct_csr &= ~QMI_DIRECT_CSR_ASSERT_CS1N_BITS;
+
+	if (kgd != 0x5D)
+	{
+		qmi_hw->direct_csr = 0;
+		restore_interrupts(irq);
+		return false;
+	}
+
+	// Reset enable, reset, enter QPI mode
+	const uint8_t setup[3] = {0x66, 0x99, 0x35};
+	for (int i = 0; i < 3; i++)
+	{
+		qmi_hw->direct_csr |= QMI_DIRECT_CSR_ASSERT_CS1N_BITS;
+		psramDirectTransfer(setup[i]);
+		qmi_hw->direct_csr &= ~QMI_DIRECT_CSR_ASSERT_CS1N_BITS;
+		for (int j = 0; j < 20; j++)
+			__asm volatile("nop"); // Chip select high time between commands
+	}
+
+	// Timing: at most 133MHz (so 100MHz from a 200MHz system clock), chip select held for at most
+	// 8us (the PSRAM's refresh limit, in units of 64 system clocks) and released for at least 18ns
+	const uint32_t maxFreq = 133000000;
+	const uint32_t sysHz = clock_get_hz(clk_sys);
+	uint32_t divisor = (sysHz + maxFreq - 1) / maxFreq;
+	if (divisor == 1 && sysHz > 100000000)
+		divisor = 2;
+	uint32_t rxDelay = divisor;
+	if (sysHz / divisor > 100000000)
+		rxDelay++;
+	const uint32_t periodFs = (uint32_t)(1000000000000000ull / sysHz);
+	const uint32_t maxSelect = (125 * 1000000) / periodFs; // 125 = 8000ns / 64
+	const uint32_t minDeselect = (18 * 1000000 + (periodFs - 1)) / periodFs - (divisor + 1) / 2;
+
+	qmi_hw->m[1].timing = 1 << QMI_M1_TIMING_COOLDOWN_LSB |
+						  QMI_M1_TIMING_PAGEBREAK_VALUE_1024 << QMI_M1_TIMING_PAGEBREAK_LSB |
+						  maxSelect << QMI_M1_TIMING_MAX_SELECT_LSB |
+						  minDeselect << QMI_M1_TIMING_MIN_DESELECT_LSB |
+						  rxDelay << QMI_M1_TIMING_RXDELAY_LSB |
+						  divisor << QMI_M1_TIMING_CLKDIV_LSB;
+
+	// Quad read (0xEB, 6 wait cycles) and quad write (0x38), all phases four bits wide
+	const uint32_t quad = QMI_M1_RFMT_PREFIX_WIDTH_VALUE_Q << QMI_M1_RFMT_PREFIX_WIDTH_LSB |
+						  QMI_M1_RFMT_ADDR_WIDTH_VALUE_Q << QMI_M1_RFMT_ADDR_WIDTH_LSB |
+						  QMI_M1_RFMT_SUFFIX_WIDTH_VALUE_Q << QMI_M1_RFMT_SUFFIX_WIDTH_LSB |
+						  QMI_M1_RFMT_DUMMY_WIDTH_VALUE_Q << QMI_M1_RFMT_DUMMY_WIDTH_LSB |
+						  QMI_M1_RFMT_DATA_WIDTH_VALUE_Q << QMI_M1_RFMT_DATA_WIDTH_LSB |
+						  QMI_M1_RFMT_PREFIX_LEN_VALUE_8 << QMI_M1_RFMT_PREFIX_LEN_LSB;
+	qmi_hw->m[1].rfmt = quad | 6 << QMI_M1_RFMT_DUMMY_LEN_LSB;
+	qmi_hw->m[1].rcmd = 0xEB;
+	qmi_hw->m[1].wfmt = quad;
+	qmi_hw->m[1].wcmd = 0x38;
+
+	// Back to XIP, now with writes allowed on chip select 1
+	qmi_hw->direct_csr = 0;
+	hw_set_bits(&xip_ctrl_hw->ctrl, XIP_CTRL_WRITABLE_M1_BITS);
+
+	restore_interrupts(irq);
+	return true;
+}
+
+#endif
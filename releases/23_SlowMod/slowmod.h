@@ -24,9 +24,15 @@ uint32_t __not_in_flash_func(rnd)() {
   return lcg_seed;
 }
 
+// Shared by all six LFOs
+static constexpr int npts = 8192;
+static int32_t sinevals[npts];
+
 class SlowMod : public ComputerCard {
-  static constexpr int npts = 8192;
-  int32_t sinevals[npts];
+  // Frequencies, cross modulation, the four slower LFOs and the LEDs are
+  // updated once every control_period samples
+  static constexpr int control_shift = 5;
+  static constexpr int control_period = 1 << control_shift;
 
   bool led_show_phase = true;
   bool switch_is_down = false;
@@ -56,6 +62,17 @@ class SlowMod : public ComputerCard {
   uint32_t phase1, phase2, phase3, phase4, phase5, phase6;
   int32_t val1, val2, val3, val4, val5, val6;
 
+  // Audio LFOs (1, 2): phase increments ramp linearly to the new target over each control period
+  uint32_t inc1 = 0, inc2 = 0;
+  int32_t inc1_step = 0, inc2_step = 0;
+  uint32_t inc1_target = 0, inc2_target = 0;
+
+  // CV outputs: interpolated from the value at the start to that at the end of each control period
+  int32_t cv1_val = 0, cv2_val = 0;
+  int32_t cv1_step = 0, cv2_step = 0;
+
+  int control_count = 0;
+
 public:
   SlowMod() {
     for (int i = 0; i < npts; i++) {
@@ -83,9 +100,6 @@ public:
     uint32_t truncated_cv_val = (cv_val - error) & 0xFFFFFF00;
     error += truncated_cv_val - cv_val;
     int16_t val = int32_t(truncated_cv_val >> 8) - 2048;
-    if (led_show_phase) {
-      LedBrightness(0, 4095 - (int32_t(truncated_cv_val >> 8) * int32_t(truncated_cv_val >> 8)) / 4096);
-    }
     if (Connected(Input::Audio1)) {
       AudioOut1((val * AudioIn1()) >> 12);
     } else {
@@ -98,9 +112,6 @@ public:
     uint32_t truncated_cv_val = (cv_val - error) & 0xFFFFFF00;
     error += truncated_cv_val - cv_val;
     int16_t val = int32_t(truncated_cv_val >> 8) - 2048;
-    if (led_show_phase) {
-      LedBrightness(1, 4095 - (int32_t(truncated_cv_val >> 8) * int32_t(truncated_cv_val >> 8)) / 4096);
-    }
     if (Connected(Input::Audio2)) {
       AudioOut2((val * AudioIn2()) >> 12);
     } else {
@@ -113,9 +124,6 @@ public:
     uint32_t truncated_cv_val = (cv_val - error) & 0xFFFFFF00;
     error += truncated_cv_val - cv_val;
     int16_t val = 2048 - int32_t(truncated_cv_val >> 8);
-    if (led_show_phase) {
-      LedBrightness(2, 4095 - (int32_t(truncated_cv_val >> 8) * int32_t(truncated_cv_val >> 8)) / 4096);
-    }
     if (Connected(Input::CV1)) {
       CVOut1((val * CVIn1()) >> 12);
     } else {
@@ -128,17 +136,20 @@ public:
     uint32_t truncated_cv_val = (cv_val - error) & 0xFFFFFF00;
     error += truncated_cv_val - cv_val;
     int16_t val = 2048 - int32_t(truncated_cv_val >> 8);
-    if (led_show_phase) {
-      LedBrightness(3, 4095 - (int32_t(truncated_cv_val >> 8) * int32_t(truncated_cv_val >> 8)) / 4096);
-    }
     if (Connected(Input::CV2)) {
       CVOut2((val * CVIn2()) >> 12);
     } else {
       CVOut2(val);
     }
   }
-  virtual void __not_in_flash_func(ProcessSample)() {
-    // uint64_t start = rp2040.getCycleCount64(); // Arduino only
+  // Brightness for an LED showing a 2^19 * sin value
+  static int32_t ledVal(int32_t v) {
+    int32_t u = (v + 524288) >> 8;
+    return 4095 - (u * u) / 4096;
+  }
+
+  // Once per control period: controls, cross modulated frequencies and the slower LFOs
+  void __not_in_flash_func(ProcessControl)() {
     bool pause = false;
 
     if (SwitchVal() == Switch::Up || PulseIn1()) {
@@ -154,10 +165,6 @@ public:
       switch_is_down = false;
     }
 
-    if (PulseIn2RisingEdge()) {
-      rndPhase();
-    }
-
     // modValX is a unipolar version of valX scaled by modDepth. The result is 0-4095.
     int32_t modDepth = KnobVal(Knob::X);
     uint32_t modVal1 = (modDepth * (2047 - (val1 >> 8))) >> 12;
@@ -167,33 +174,76 @@ public:
     uint32_t modVal5 = (modDepth * (2047 - (val5 >> 8))) >> 12;
     uint32_t modVal6 = (modDepth * (2047 - (val6 >> 8))) >> 12;
 
-    if (!pause) {
+    // Finish the previous ramps exactly
+    inc1 = inc1_target;
+    inc2 = inc2_target;
+
+    if (pause) {
+      inc1 = inc2 = inc1_target = inc2_target = 0;
+    } else {
       // Calculate frequencies for audio, CV and mod LFO. Cross modulate frequency by one or more
-      uint32_t hz1 = (KnobToHzQ12(KnobVal(Knob::Main)) * ((2 << 12) + ((50 * modVal5 * modVal5) >> 12) + 2 * modVal2)) >> 12;
-      phase1 += phaseStep(hz1);
-      uint32_t hz2 = (KnobToHzQ12(KnobVal(Knob::Main)) * ((1 << 12) + 3 * modVal6 + 2 * modVal1)) >> 12;
-      phase2 += phaseStep(hz2);
-      uint32_t hz3 = (KnobToHzQ12(KnobVal(Knob::Main)) * ((1 << 12) + modVal5 + modVal6 + modVal4)) >> 12;
-      phase3 += phaseStep(hz3);
-      uint32_t hz4 = ((KnobToHzQ12(KnobVal(Knob::Main)) >> 1) * ((1 << 12) + 2 * modVal6 + modVal3)) >> 12;
-      phase4 += phaseStep(hz4);
-      uint32_t hz5 = ((KnobToHzQ12(KnobVal(Knob::Main)) >> 2) * ((1 << 12) + (modVal6 >> 2))) >> 12;
-      phase5 += phaseStep(hz5);
-      uint32_t hz6 = ((KnobToHzQ12(KnobVal(Knob::Main)) >> 3) * ((1 << 12) + (modVal5 >> 2))) >> 12;
-      phase6 += phaseStep(hz6);
+      int32_t hz = KnobToHzQ12(KnobVal(Knob::Main));
+      uint32_t hz1 = (hz * ((2 << 12) + ((50 * modVal5 * modVal5) >> 12) + 2 * modVal2)) >> 12;
+      inc1_target = phaseStep(hz1);
+      uint32_t hz2 = (hz * ((1 << 12) + 3 * modVal6 + 2 * modVal1)) >> 12;
+      inc2_target = phaseStep(hz2);
+      uint32_t hz3 = (hz * ((1 << 12) + modVal5 + modVal6 + modVal4)) >> 12;
+      phase3 += phaseStep(hz3) << control_shift;
+      uint32_t hz4 = ((hz >> 1) * ((1 << 12) + 2 * modVal6 + modVal3)) >> 12;
+      phase4 += phaseStep(hz4) << control_shift;
+      uint32_t hz5 = ((hz >> 2) * ((1 << 12) + (modVal6 >> 2))) >> 12;
+      phase5 += phaseStep(hz5) << control_shift;
+      uint32_t hz6 = ((hz >> 3) * ((1 << 12) + (modVal5 >> 2))) >> 12;
+      phase6 += phaseStep(hz6) << control_shift;
     }
+    inc1_step = (int32_t(inc1_target) - int32_t(inc1)) >> control_shift;
+    inc2_step = (int32_t(inc2_target) - int32_t(inc2)) >> control_shift;
 
-    val1 = sinval(phase1);
-    val2 = sinval(phase2);
+    // The slower LFOs, at the end of this control period
     val3 = sinval(phase3);
     val4 = sinval(phase4);
     val5 = sinval(phase5);
     val6 = sinval(phase6);
 
+    int32_t cv1_target = crossfade(val3, -val4, KnobVal(Knob::Y));
+    int32_t cv2_target = crossfade(val4, -val3, KnobVal(Knob::Y));
+    cv1_step = (cv1_target - cv1_val) >> control_shift;
+    cv2_step = (cv2_target - cv2_val) >> control_shift;
+
+    if (led_show_phase) {
+      LedBrightness(0, ledVal(crossfade(val1, -val2, KnobVal(Knob::Y))));
+      LedBrightness(1, ledVal(crossfade(val2, -val1, KnobVal(Knob::Y))));
+      LedBrightness(2, ledVal(cv1_val));
+      LedBrightness(3, ledVal(cv2_val));
+    }
+  }
+
+  virtual void __not_in_flash_func(ProcessSample)() {
+    // uint64_t start = rp2040.getCycleCount64(); // Arduino only
+    if (control_count == 0) {
+      ProcessControl();
+    }
+    control_count = (control_count + 1) & (control_period - 1);
+
+    if (PulseIn2RisingEdge()) {
+      rndPhase();
+    }
+
+    // Audio rate LFOs every sample
+    phase1 += inc1;
+    phase2 += inc2;
+    inc1 += inc1_step;
+    inc2 += inc2_step;
+    val1 = sinval(phase1);
+    val2 = sinval(phase2);
+
+    cv1_val += cv1_step;
+    cv2_val += cv2_step;
+
     SetAudio1(crossfade(val1, -val2, KnobVal(Knob::Y)));
     SetAudio2(crossfade(val2, -val1, KnobVal(Knob::Y)));
-    SetCV1(crossfade(val3, -val4, KnobVal(Knob::Y)));
-    SetCV2(crossfade(val4, -val3, KnobVal(Knob::Y)));
+    SetCV1(cv1_val);
+    SetCV2(cv2_val);
 
     bool pulse1 = (((val1 >> 8) & 0x0100) > ((val2 >> 8) & 0x0100));
     bool pulse2 = (((val3 >> 8) & 0x0100) > ((val4 >> 8) & 0x0100));
@@ -0,0 +1,230 @@
+/*
+	Eighties Bass, ComputerCard version
+	Based on the Mozzi sketch by @todbot / Tod Kurt, 2024
+
+	A bank of detuned band-limited saws, plus one an octave down, with mixable
+	white noise, into a resonant multimode filter.
+
+	Main knob:  filter cutoff
+	Knob X:     pitch offset, in semitones
+	Knob Y:     filter resonance
+	Switch:     tap down to change filter mode (LPF, BPF, HPF)
+	CV 1 in:    V/oct pitch (0V = middle C)
+	CV 2 in:    added to main knob cutoff
+	Audio 1 in: detune amount, as a CV (unpatched gives the default detune)
+	Audio 2 in: noise mix, as a CV
+	Audio out:  synth voice, on both outputs
+	CV 1 out:   pitch of the centre oscillator, calibrated V/oct
+	CV 2 out:   filter cutoff
+	LEDs 2/4/6: filter mode
+
+	Runs with COMPUTERCARD_BLOCK_SIZE=16: controls are read once per block
+	(3kHz), and the filter coefficients ramped across each block, so that
+	cutoff sweeps are smooth. Oscillators and filter are only retuned when
+	the controls they depend on move. All oscillator and filter arithmetic
+	is integer.
+*/
+
+#include "ComputerCard.h"
+
+class EightiesBass : public ComputerCard
+{
+public:
+	static constexpr int numSaws = 7;              // detuned saws, around the played pitch
+	static constexpr int numVoices = numSaws + 1;  // plus one saw an octave down
+
+	EightiesBass()
+	{
+		EnableNormalisationProbe();
+		EnableAdaptiveSmoothing();
+		for (int v=0; v<numVoices; v++) phase[v] = Rand();
+		LedOn(1);
+	}
+
+	virtual void ProcessBlock(const Frame *in, Frame *out, int n)
+	{
+		Control(in[0]);
+
+		int32_t fStep = (fTarget - f) / n;
+		int32_t fbStep = (fbTarget - fb) / n;
+		for (int i=0; i<n; i++)
+		{
+			int32_t saws = 0;
+			for (int v=0; v<numVoices; v++)
+			{
+				phase[v] += inc[v];
+				saws += Saw(phase[v], inc[v], rcp[v]);
+			}
+
+			// Mix to 13 bits, as the Mozzi version
+			int32_t noise = int32_t(Rand()) >> 20;
+			int32_t x = ((saws >> 6) * (4096 - noiseAmt) + noise * noiseAmt) >> 12;
+
+			// Kellett resonant filter, with 8 extra bits of precision in the state
+			f += fStep;
+			fb += fbStep;
+			int32_t x8 = x << 8;
+			buf0 += int32_t((int64_t(f) * (x8 - buf0 + int32_t((int64_t(fb) * (buf0 - buf1)) >> 16))) >> 16);
+			buf1 += int32_t((int64_t(f) * (buf0 - buf1)) >> 16);
+
+			int32_t y;
+			if (mode == 0) y = buf1;
+			else if (mode == 1) y = buf0 - buf1;
+			else y = x8 - buf0;
+			y >>= 9; // 13-bit signal to 12-bit output, leaving room for resonance
+			if (y > 2047) y = 2047;
+			if (y < -2048) y = -2048;
+			out[i].audio[0] = y;
+			out[i].audio[1] = y;
+		}
+	}
+
+private:
+	void Control(const Frame &in)
+	{
+		if (SwitchChanged() && SwitchVal() == Switch::Down)
+		{
+			LedOff(1 + 2 * mode);
+			mode = (mode + 1) % 3;
+			LedOn(1 + 2 * mode);
+		}
+
+		// Audio inputs are used as CVs, so are smoothed as the knobs and CV inputs are
+		bool detuneMoved = detuneIn.Update(in.audio[0], 3);
+		noiseIn.Update(in.audio[1], 3);
+		uint32_t changed = ControlsChanged() | firstBlock;
+		firstBlock = 0;
+
+		if (detuneMoved || (changed & (ChangedX | ChangedCV1)))
+		{
+			// Pitch, in cents above MIDI note 0. CV in is about 1/2048 of 6V per unit
+			int32_t semitones = ((KnobVal(Knob::X) * 127) >> 12) - 63;
+			int32_t cents = 6000 + ((CVIn1() * 225) >> 6) + semitones * 100;
+			if (cents < 0) cents = 0;
+			if (cents > 12700) cents = 12700;
+			CVOutMIDINoteCents(0, cents / 100, cents % 100);
+
+			// Detune, in 1/256ths of a Hz, from 0.02Hz to 10Hz over -5V to 5V
+			int32_t a1 = detuneIn.Value();
+			int32_t detune = 256;
+			if (!Disconnected(Input::Audio1) && (a1 < -50 || a1 > 50))
+			{
+				detune = 1282 + ((a1 * 766) >> 10);
+				if (detune < 5) detune = 5;
+				if (detune > 2560) detune = 2560;
+			}
+
+			// Saws spread either side of the played pitch by a fixed random fraction of the detune,
+			// in Hz (so, as in the Mozzi version, low notes beat as fast as high ones)
+			static constexpr int32_t spread[numSaws] = {-637, -312, -236, 0, 182, 451, 438};
+			int32_t base = NoteIncrement(cents);
+			for (int v=0; v<numSaws; v++)
+			{
+				int32_t i = base + ((detune * spread[v] * 350) >> 8);
+				SetVoice(v, i);
+			}
+			SetVoice(numSaws, base >> 1);
+		}
+
+		// Noise mix, 0 to 0.7 (in 1/4096ths) for 0 to +-5V
+		int32_t a2 = noiseIn.Value();
+		if (a2 < 0) a2 = -a2;
+		noiseAmt = (a2 * 430) >> 8;
+		if (noiseAmt > 2867) noiseAmt = 2867;
+
+		if (changed & (ChangedMain | ChangedY | ChangedCV2))
+		{
+			// Cutoff in 1/256ths of the Mozzi sketch's 0-255 range, which spans 0-8192Hz
+			int32_t cutoff = 256 + ((KnobVal(Knob::Main) * 38144) >> 12) + ((CVIn2() * 25) >> 1);
+			if (cutoff < 0) cutoff = 0;
+			if (cutoff > 65280) cutoff = 65280;
+			CVOut2((cutoff >> 4) - 2048);
+
+			// Same cutoff frequency at 48kHz as at Mozzi's 32768Hz, and same feedback approximation
+			int32_t q = (KnobVal(Knob::Y) * 4080) >> 8;
+			fTarget = (cutoff * 44739) >> 16;
+			fbTarget = q + ((q * (65536 - fTarget)) >> 16);
+		}
+	}
+
+	void SetVoice(int v, int32_t i)
+	{
+		if (i < 65536) i = 65536;
+		inc[v] = i;
+		rcp[v] = uint32_t((uint64_t(1) << 47) / uint32_t(i));
+	}
+
+	// Saw from -32768 to 32767, with a polynomial band-limited step (PolyBLEP) at the wrap.
+	// rcp is 2^47/inc, so that (distance from the wrap * rcp) >> 32 is that distance in samples, as Q15
+	static int32_t __not_in_flash_func(Saw)(uint32_t p, uint32_t inc, uint32_t rcp)
+	{
+		int32_t s = int32_t(p ^ 0x80000000u) >> 16;
+		if (p < inc)
+		{
+			int32_t x = int32_t((uint64_t(p) * rcp) >> 32);
+			s -= 2 * x - ((x * x) >> 15) - 32768;
+		}
+		else if (p > 0u - inc)
+		{
+			int32_t x = int32_t((uint64_t(0u - p) * rcp) >> 32);
+			s -= ((x * x) >> 15) - 2 * x + 32768;
+		}
+		return s;
+	}
+
+	// Phase increment at 48kHz for a pitch in cents above MIDI note 0
+	static int32_t NoteIncrement(int32_t cents)
+	{
+		// cents/1200 octaves, as 16.16 fixed point
+		int32_t oct16 = int32_t((int64_t(cents) * 3579139) >> 16);
+		int32_t oct = oct16 >> 16;
+		uint32_t fr = oct16 & 0xFFFF;
+		uint32_t t0 = octaveTable[fr >> 10], t1 = octaveTable[(fr >> 10) + 1];
+		uint32_t ratio = t0 + uint32_t((uint64_t(t1 - t0) * (fr & 0x3FF)) >> 10);
+		return int32_t(((uint64_t(note0Increment) * ratio) >> 30) << oct);
+	}
+
+	uint32_t Rand()
+	{
+		rng ^= rng << 13;
+		rng ^= rng >> 17;
+		rng ^= rng << 5;
+		return rng;
+	}
+
+	// 8.176Hz (MIDI note 0) at 48kHz
+	static constexpr uint32_t note0Increment = 731558;
+
+	// 2^(i/64) * 2^30, for fractions of an octave
+	static constexpr uint32_t octaveTable[65] = {
+		1073741824, 1085434106, 1097253708, 1109202018, 1121280436, 1133490379, 1145833280, 1158310587,
+		1170923762, 1183674286, 1196563654, 1209593378, 1222764986, 1236080024, 1249540052, 1263146652,
+		1276901417, 1290805962, 1304861917, 1319070932, 1333434672, 1347954824, 1362633090, 1377471191,
+		1392470869, 1407633882, 1422962010, 1438457051, 1454120821, 1469955159, 1485961921, 1502142985,
+		1518500250, 1535035634, 1551751076, 1568648537, 1585730000, 1602997467, 1620452965, 1638098541,
+		1655936265, 1673968228, 1692196547, 1710623359, 1729250827, 1748081133, 1767116489, 1786359126,
+		1805811301, 1825475297, 1845353420, 1865448001, 1885761398, 1906295993, 1927054196, 1948038440,
+		1969251188, 1990694927, 2012372174, 2034285470, 2056437387, 2078830522, 2101467502, 2124350982,
+		2147483648
+	};
+
+	// Oscillator bank
+	uint32_t phase[numVoices] = {}, inc[numVoices] = {}, rcp[numVoices] = {};
+
+	// Filter coefficients (16.16), their targets for the end of the block, and state
+	int32_t f = 0, fb = 0, fTarget = 0, fbTarget = 0;
+	int32_t buf0 = 0, buf1 = 0;
+
+	AdaptiveSmoother detuneIn, noiseIn;
+	int32_t noiseAmt = 0;
+	uint32_t firstBlock = ~0u; // update everything on the first block
+	int mode = 0; // 0 = LPF, 1 = BPF, 2 = HPF
+	uint32_t rng = 0x12345678;
+};
+
+
+int main()
+{
+	EightiesBass eb;
+	eb.Run();
+}
@@ -13,6 +13,8 @@ public:
 	constexpr static int8_t circle_of_fifths[13] = {-6, 1, -4, 3, -2, 5, 0, -5, 2, -3, 4, -1, 6};
 
 	int8_t all_keys[13][12];
+	QuantScale keyScales[13];
+	Quantiser quant;
 
 	uint32_t sampleCounter;
 	uint32_t quarterNoteMs;
@@ -73,6 +75,7 @@ public:
 			{
 				all_keys[i][j] = scale[j];
 			}
+			keyScales[i].set(all_keys[i], -1); // -1 octave to get the correct octave
 		}
 
 		looping = SwitchVal() == Switch::Middle;
@@ -238,7 +241,7 @@ public:
 		}
 
 		clip(quant_input);
-		quantisedNote = quantSample(quant_input, all_keys[key_index]);
+		quantisedNote = quant.process(quant_input, keyScales[key_index]);
 		quantizedAmbigThird = calculateAmbigThird(quantisedNote, key_index);
 		CVOut1MIDINote(quantisedNote);
 		CVOut2MIDINote(quantizedAmbigThird);
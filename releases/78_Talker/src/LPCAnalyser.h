@@ -0,0 +1,161 @@
+/*
+	Live LPC analysis of audio into TMS5220 frames, fixed point, for TalkiePCM
+
+	Push, from ProcessSample, averages every six 48kHz input samples into a ring of
+	8kHz samples, the speech engine's rate. Analyse, meant for core 1, takes the latest
+	25ms frame (200 samples) once a new one is complete: pre-emphasis, a Hamming window,
+	autocorrelation to lag 10, and Levinson-Durbin recursion for the ten reflection
+	coefficients, each then quantised to the nearest entry of the chip's K tables. The
+	frame's level sets its energy index, and its first reflection coefficient whether it
+	is voiced (a low, vowel-like spectrum) or unvoiced (a flat or high one, as in 's').
+	The pitch of a voiced frame is left to the caller: TalkieFrame::pitch is 1 for voiced
+	frames, to be replaced by the index of the pitch wanted.
+
+	Each analysis is about 2500 multiply-adds, a fraction of a millisecond on core 1.
+	Push and Analyse may run on different cores.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "TalkiePCM.h"
+
+class LPCAnalyser
+{
+public:
+	static constexpr int frameSize = 200;  // 25ms at 8kHz
+	static constexpr int order = 10;
+	static constexpr int decimation = 6;   // 48kHz to 8kHz
+
+	LPCAnalyser()
+	{
+		for (int i=0; i<frameSize; i++)
+		{
+			window[i] = int16_t(std::lround(32767.0 * (0.54 - 0.46 * std::cos(6.283185307179586 * i / (frameSize - 1)))));
+		}
+		for (int i=0; i<ringSize; i++) ring[i] = 0;
+		written = analysed = 0;
+		acc = 0;
+		phase = 0;
+		voicedThreshold = -8192;
+	}
+
+	/// Frames whose first reflection coefficient is below this (Q15, default -0.25) are voiced
+	void SetVoicedThreshold(int32_t kQ15) {voicedThreshold = kQ15;}
+
+	/// Core 0, every 48kHz sample: audio in ComputerCard's 12-bit range
+	void Push(int16_t x)
+	{
+		acc += x;
+		if (++phase == decimation)
+		{
+			// Sum of six samples, divided by six
+			ring[written & (ringSize - 1)] = int16_t((acc * 21845) >> 17);
+			written = written + 1;
+			acc = 0;
+			phase = 0;
+		}
+	}
+
+	/// Core 1: analyse the latest frame into f, if a new one has been pushed since the last call
+	bool Analyse(TalkieFrame &f)
+	{
+		uint32_t end = written;
+		if (end - analysed < uint32_t(frameSize)) return false;
+		analysed = end;
+
+		// Pre-emphasis (1 - 0.9375 z^-1) and window, with the level of the frame as pushed
+		int16_t x[frameSize];
+		int32_t sumSquares = 0;
+		int32_t last = ring[(end - frameSize - 1) & (ringSize - 1)];
+		for (int i=0; i<frameSize; i++)
+		{
+			int32_t s = ring[(end - frameSize + i) & (ringSize - 1)];
+			sumSquares += (s * s) >> 4;
+			int32_t e = s - ((last * 15) >> 4);
+			last = s;
+			x[i] = int16_t((e * window[i]) >> 15);
+		}
+
+		// Energy, from the RMS level; below the lowest step, a silent frame
+		int32_t rms = ISqrt(uint32_t(sumSquares / frameSize) << 4);
+		f.energy = TalkiePCM::nearestEnergy(rms >> 1);
+		if (f.energy == 0) return true;
+
+		// Autocorrelation; pre-emphasised 12-bit samples are up to 13 bits, so 200 products fit in 32 bits
+		int64_t r[order + 1];
+		for (int lag=0; lag<=order; lag++)
+		{
+			int32_t sum = 0;
+			for (int i=lag; i<frameSize; i++) sum += (int32_t(x[i]) * x[i - lag]) >> 2;
+			r[lag] = sum;
+		}
+		if (r[0] <= 0)
+		{
+			f.energy = 0;
+			return true;
+		}
+		r[0] += r[0] >> 10; // -30dB white noise floor, keeping the recursion well conditioned
+
+		int16_t k[order];
+		LevinsonDurbin(r, k);
+
+		f.pitch = k[0] < voicedThreshold ? 1 : 0;
+		for (int i=0; i<order; i++) f.k[i] = TalkiePCM::nearestK(i, k[i]);
+		return true;
+	}
+
+private:
+	static constexpr int ringSize = 512;
+
+	int16_t window[frameSize];             // Hamming, Q15
+	int16_t ring[ringSize];                // 8kHz samples
+	volatile uint32_t written;             // core 0: samples pushed, ever
+	uint32_t analysed;                     // core 1: written, at the last analysis
+	int32_t acc;
+	int phase;
+	int32_t voicedThreshold;
+
+	// Reflection coefficients (Q15) from autocorrelation r: r is normalised to Q30, and the
+	// predictor held in Q24, so the products of the two fit in 64 bits
+	static void LevinsonDurbin(const int64_t *r, int16_t *k)
+	{
+		int64_t rn[order + 1];
+		for (int i=0; i<=order; i++) rn[i] = (r[i] << 30) / r[0];
+
+		int64_t a[order + 1] = {0}, prev[order + 1];
+		int64_t err = int64_t(1) << 30;
+		for (int i=1; i<=order; i++)
+		{
+			int64_t sum = rn[i];
+			for (int j=1; j<i; j++) sum += (a[j] * rn[i - j]) >> 24;
+			int64_t ki = err > 0 ? -(sum << 15) / err : 0;
+			if (ki > 32440) ki = 32440;
+			if (ki < -32440) ki = -32440;
+			k[i - 1] = int16_t(ki);
+
+			for (int j=1; j<i; j++) prev[j] = a[j];
+			for (int j=1; j<i; j++) a[j] = prev[j] + ((ki * prev[i - j]) >> 15);
+			a[i] = ki << 9;
+			err = (err * ((int64_t(1) << 30) - ki * ki)) >> 30;
+		}
+	}
+
+	static int32_t ISqrt(uint32_t v)
+	{
+		uint32_t r = 0, bit = 1u << 30;
+		while (bit > v) bit >>= 2;
+		while (bit)
+		{
+			if (v >= r + bit)
+			{
+				v -= r + bit;
+				r = (r >> 1) + bit;
+			}
+			else r >>= 1;
+			bit >>= 2;
+		}
+		return int32_t(r);
+	}
+};
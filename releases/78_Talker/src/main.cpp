@@ -1,33 +1,92 @@
 #include "ComputerCard.h"
 #include "TalkiePCM.h"
+#include "LPCAnalyser.h"
 
 #include <cstdlib> // for abs
 
-class TalkiePCMCard : public ComputerCard
+// Number of voices. Voices after the first are rendered on core1 as a choir,
+// each at its own pitch and speed, and mixed into Audio out 1.
+#ifndef TALKER_VOICES
+#define TALKER_VOICES 3
+#endif
+
+#if TALKER_VOICES > 1 && defined(COMPUTERCARD_HAS_MULTICORE)
+#define TALKER_CHOIR 1
+#endif
+
+// Live vocoder (switch middle, audio in 1 patched): audio in 1 is analysed on core1
+#ifdef COMPUTERCARD_HAS_MULTICORE
+#define TALKER_LIVE 1
+#endif
+
+class TalkiePCMCard : public ComputerCardT<TalkiePCMCard>
 {
 public:
 	TalkiePCMCard()
 	{
 		sampleRamp = 0;
 		sample = 0;
-		voice.sayNumber(RandomDigit());
+		preFilterOutput = 0;
+		pulseTimer = 0;
+		live = false;
+		voice.prefetch(digitWords[RandomDigit(seed)]);
+		SayNext(voice, seed);
+#ifdef TALKER_CHOIR
+		triggers = 0;
+		choirPos = choirBlockSize;
+		RunOnCore1(&TalkiePCMCard::ChoirLoop);
+#elif defined(TALKER_LIVE)
+		RunOnCore1(&TalkiePCMCard::AnalysisLoop);
+#endif
 	}
 
-	int16_t cvenergy, cvpitch;
-	int32_t cvenergy2, cvpitch2;
+	int16_t cvenergy = 0, cvpitch = 0;
+	int32_t cvenergy2 = 0, cvpitch2 = 0;
 	
 	virtual void ProcessSample()
 	{
 		Switch s = SwitchVal();
+		voice.prefetchStep();
 		
 		// Filter speed (pitch) set by CV 1 with knob X as attenuverter, added to main knob
 		int incr = KnobVal(Knob::Main) + (CVIn1() * (KnobVal(Knob::X)-2048) >> 11);
 		if (incr<0) incr = 0;
-		sampleRamp += incr;
+		int pitch = incr;
 
 		// Frame speed (speaking speed) set by Knob Y + CV 2
 		int frameIncr = (KnobVal(Knob::Y)>>3) + (CVIn2()>>3);
 		if (frameIncr<0) frameIncr = 0;
+
+#ifdef TALKER_LIVE
+		// Live vocoder: switch middle with audio in 1 patched
+		bool nowLive = s == Switch::Middle && Connected(Input::Audio1);
+		if (nowLive != live)
+		{
+			live = nowLive;
+			voice.setLive(live);
+		}
+		if (live)
+		{
+			analyser.Push(AudioIn1());
+			analyser.SetVoicedThreshold(-KnobVal(Knob::Y) * 8);
+
+			// Voiced frames at the pitch set by the main knob and CV 1
+			TalkieFrame f;
+			while (liveFrames.Pop(f))
+			{
+				if (f.pitch) f.pitch = TalkiePCM::nearestPeriod(LivePeriod(pitch) >> 4);
+				voice.setLiveFrame(f);
+			}
+
+			// The engine runs at its own 8kHz, keeping the input's formants, and frames at 25ms
+			incr = liveIncr;
+			frameIncr = liveFrameIncr;
+		}
+#endif
+		sampleRamp += incr;
+#ifdef TALKER_CHOIR
+		choirControls.Push({incr, frameIncr, triggers, s == Switch::Up, live, pitch});
+#endif
 		bool finished = voice.calculateNextFrame(frameIncr,cvenergy, cvpitch);
 
 		cvenergy2 = (15*int32_t(cvenergy2) + (cvenergy<<3))>>4;
@@ -38,12 +97,16 @@ public:
 		//     or switch pulled down,
 		//     or rising edge on pulse 1,
 		//  then say a new digit
-		if ((finished && s == Switch::Up)
-			|| (s == Switch::Down && lasts != Switch::Down)
-			|| PulseIn1RisingEdge())
+		if (!live &&
+			((finished && s == Switch::Up)
+			 || (s == Switch::Down && lasts != Switch::Down)
+			 || PulseIn1RisingEdge()))
 		{
-			// Say the new digit
-			voice.sayNumber(RandomDigit());
+			// Say the new digit, already copied to SRAM
+			SayNext(voice, seed);
+#ifdef TALKER_CHOIR
+			triggers++;
+#endif
 			
 			// Start a new pulse on Pulse out 1 and LED 1
 			pulseTimer=100; // 100 is ~2ms, enough to trigger Slopes
@@ -62,38 +125,204 @@ public:
 			}
 		}
 		
-		int16_t preFilterOutput;
 		if (sampleRamp>8192) // Each new sample
 		{
 			sampleRamp-=8192;
 
 			// Calculate new sample
-			sample = voice.calculateNextSample(Connected(Input::Audio1), AudioIn1(), preFilterOutput);
+			// Audio in 2 replaces the pitched exciter in live mode, audio in 1 otherwise
+			sample = live ? voice.calculateNextSample(Connected(Input::Audio2), AudioIn2(), preFilterOutput)
+			              : voice.calculateNextSample(Connected(Input::Audio1), AudioIn1(), preFilterOutput);
 			
 			// Light LED 0 according to signal
 			LedBrightness(0, abs(sample)<<1);
 		}
 
 		// Play the last sample through audio out, no fancy interpolation
+#ifdef TALKER_CHOIR
+		AudioOut1((sample + ChoirSample()) / TALKER_VOICES >> 4);
+#else
 		AudioOut1(sample>>4);
+#endif
 		AudioOut2(preFilterOutput<<4);
 		lasts = s;
 	}
 	
 private:
-	int RandomDigit()
+	static int RandomDigit(uint32_t &lcg_seed)
 	{
 		// Random number up to 2^32-1 divided down to get digits 0-9
-		static uint32_t lcg_seed = 1;
 		lcg_seed = 1664525 * lcg_seed + 1013904223;
 		return lcg_seed/429496730;
 	}
+	uint32_t seed = 1;
+
+	static constexpr TalkieWord digitWords[10] = {
+		TALKIE_WORD(sp2_ZERO), TALKIE_WORD(sp2_ONE), TALKIE_WORD(sp2_TWO), TALKIE_WORD(sp2_THREE),
+		TALKIE_WORD(sp2_FOUR), TALKIE_WORD(sp2_FIVE), TALKIE_WORD(sp2_SIX), TALKIE_WORD(sp2_SEVEN),
+		TALKIE_WORD(sp2_EIGHT), TALKIE_WORD(sp2_NINE)};
+
+#ifdef TALKER_LIVE
+	// Live mode: the engine's sample and frame rates, 8kHz and 25ms at 48kHz
+	static constexpr int liveIncr = 1365;
+	static constexpr int liveFrameIncr = 83;
+
+	LPCAnalyser analyser;
+	Ring<TalkieFrame, 4> liveFrames;      // core1 -> core0
+
+	// Live mode: pitch period in 1/16ths of an 8kHz sample, from 50Hz up three octaves over
+	// the pitch control (0 to 4095), with 2^-f approximated by a quadratic
+	static int32_t LivePeriod(int pitch)
+	{
+		if (pitch > 3 * 1365) pitch = 3 * 1365;
+		int octave = pitch / 1365;
+		int32_t f = (pitch - octave * 1365) * 3; // Q12
+		int32_t y = 4096 - ((2689 * f) >> 12) + ((641 * ((f * f) >> 12)) >> 12);
+		return (((160 * 16) >> octave) * y) >> 12;
+	}
+#endif
+#ifndef TALKER_CHOIR
+#ifdef TALKER_LIVE
+	// Code for second RP2040 core, blocking: analysis for the live vocoder
+	void AnalysisLoop()
+	{
+		while (1)
+		{
+			TalkieFrame f;
+			if (analyser.Analyse(f)) liveFrames.Push(f);
+		}
+	}
+#endif
+#endif
+
+	// Say the word prefetched for a voice, and prefetch another
+	static void SayNext(TalkiePCM &voice, uint32_t &lcg_seed)
+	{
+		voice.sayPrefetched();
+		voice.prefetch(digitWords[RandomDigit(lcg_seed)]);
+	}
+
+#ifdef TALKER_CHOIR
+	// The choir is owned by core1, which renders it ahead, mixed, into choirFifo
+	static constexpr int choirBlockSize = 32;
+	static constexpr int choirSize = TALKER_VOICES - 1;
+	struct ChoirBlock
+	{
+		int32_t s[choirBlockSize];
+	};
+	// Core0 -> core1: speed controls, a count of words triggered by the switch or Pulse in 1,
+	// and in live mode, the pitch control
+	struct ChoirControls
+	{
+		int incr, frameIncr;
+		uint32_t triggers;
+		bool continuous, live;
+		int pitch;
+	};
+	// Choir voices' pitch and speaking speed, relative to the first voice (4096 = same)
+	static constexpr int32_t choirPitch[3] = {5120, 6144, 3072};
+	static constexpr int32_t choirSpeed[3] = {3891, 4301, 3482};
+	static_assert(choirSize <= 3, "TALKER_VOICES is at most 4");
+
+	Ring<ChoirBlock, 4> choirFifo;        // core1 -> core0, ~2.7ms at most
+	Ring<ChoirControls, 4> choirControls; // core0 -> core1
+	ChoirBlock choirCurrent;              // core0: block being played
+	int choirPos;                         // core0: next sample in choirCurrent
+	uint32_t triggers;                    // core0
+
+	// Core0: next sample of the choir, or silence if core1 has fallen behind
+	int32_t ChoirSample()
+	{
+		if (choirPos == choirBlockSize)
+		{
+			if (!choirFifo.Pop(choirCurrent)) return 0;
+			choirPos = 0;
+		}
+		return choirCurrent.s[choirPos++];
+	}
+
+	// Code for second RP2040 core, blocking
+	void ChoirLoop()
+	{
+		struct Singer
+		{
+			TalkiePCM voice;
+			int sampleRamp = 0;
+			int16_t sample = 0;
+		};
+		static Singer singers[choirSize];
+		uint32_t choirSeed = 12345, lastTriggers = 0;
+		for (int k=0; k<choirSize; k++) singers[k].voice.prefetch(digitWords[RandomDigit(choirSeed)]);
+		ChoirControls c = {0, 0, 0, false, false, 0};
+		bool live = false;
+
+		while (1)
+		{
+			ChoirControls in;
+			while (choirControls.Pop(in)) c = in;
+
+			// Live mode: the choir sings the frames analysed here, in harmony with the first voice
+			if (c.live != live)
+			{
+				live = c.live;
+				for (int k=0; k<choirSize; k++) singers[k].voice.setLive(live);
+			}
+			TalkieFrame frame;
+			if (analyser.Analyse(frame))
+			{
+				liveFrames.Push(frame);
+				for (int k=0; k<choirSize; k++)
+				{
+					TalkieFrame f = frame;
+					if (f.pitch) f.pitch = TalkiePCM::nearestPeriod((LivePeriod(c.pitch) << 8) / choirPitch[k]);
+					singers[k].voice.setLiveFrame(f);
+				}
+			}
+
+			if (choirFifo.Full()) continue;
+
+			// Everyone starts a new word together when triggered
+			bool trigger = c.triggers != lastTriggers;
+			lastTriggers = c.triggers;
+
+			ChoirBlock b;
+			for (int i=0; i<choirBlockSize; i++) b.s[i] = 0;
+			for (int k=0; k<choirSize; k++)
+			{
+				Singer &v = singers[k];
+				if (trigger) SayNext(v.voice, choirSeed);
+				int incr = live ? c.incr : (c.incr * choirPitch[k]) >> 12;
+				int frameIncr = live ? c.frameIncr : (c.frameIncr * choirSpeed[k]) >> 12;
+
+				for (int i=0; i<choirBlockSize; i++)
+				{
+					v.voice.prefetchStep();
+					v.sampleRamp += incr;
+					int16_t energy, pitch, preFilterOutput;
+					// In continuous mode, each starts its next word when it finishes the last
+					if (v.voice.calculateNextFrame(frameIncr, energy, pitch) && c.continuous)
+					{
+						SayNext(v.voice, choirSeed);
+					}
+					if (v.sampleRamp > 8192)
+					{
+						v.sampleRamp -= 8192;
+						v.sample = v.voice.calculateNextSample(false, 0, preFilterOutput);
+					}
+					b.s[i] += v.sample;
+				}
+			}
+			choirFifo.Push(b);
+		}
+	}
+#endif
 	
 	TalkiePCM voice;
 	int sampleRamp;
-	int16_t sample;
+	int16_t sample, preFilterOutput;
 	int pulseTimer;
 	Switch lasts;
+	bool live;                            // core0: live vocoder mode
 };
 
 